@@ -0,0 +1,351 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "analysis_reporter.hpp"
+
+#include "../domain/graph.hpp"
+#include "../domain/graph_snapshot.hpp"
+#include "../domain/image_manager.hpp"
+#include "../domain/mind_map_data.hpp"
+#include "../infra/io/alz_stream_reader.hpp"
+#include "../infra/io/alzb_file_io_worker.hpp"
+#include "../infra/io/compressed_device.hpp"
+#include "../infra/io/file_exception.hpp"
+#include "../view/scene_items/edge.hpp"
+#include "../view/scene_items/node.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImageReader>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QObject>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+using juzzlin::L;
+
+static const auto TAG = "AnalysisReporter";
+
+namespace {
+
+const std::array<const char *, std::tuple_size<AnalysisReporter::DegreeHistogram>::value> degreeBucketNames = {
+    "0", "1", "2", "3-4", "5-8", "9-16", "17-32", "33+"
+};
+
+std::chrono::microseconds elapsed(const QElapsedTimer & timer)
+{
+    return std::chrono::microseconds { timer.nsecsElapsed() / 1000 };
+}
+
+QString milliseconds(std::chrono::microseconds time)
+{
+    return QString { "%1 ms" }.arg(static_cast<double>(time.count()) / 1000, 0, 'f', 1);
+}
+
+QString dataSize(qint64 bytes)
+{
+    const std::array<const char *, 4> units = { "KiB", "MiB", "GiB", "TiB" };
+    if (bytes < 1024) {
+        return QString { "%1 B" }.arg(bytes);
+    }
+    auto size = static_cast<double>(bytes) / 1024;
+    size_t unit = 0;
+    while (size >= 1024 && unit + 1 < units.size()) {
+        size /= 1024;
+        unit++;
+    }
+    return QString { "%1 %2" }.arg(size, 0, 'f', 1).arg(units.at(unit));
+}
+
+QJsonValue jsonSize(size_t value)
+{
+    return QJsonValue { static_cast<qint64>(value) };
+}
+
+QJsonValue jsonMilliseconds(std::chrono::microseconds time)
+{
+    return QJsonValue { static_cast<double>(time.count()) / 1000 };
+}
+
+void analyzeGraph(const GraphSnapshot & snapshot, AnalysisReporter::Analysis & analysis)
+{
+    analysis.nodeCount = snapshot.nodes().size();
+    analysis.edgeCount = snapshot.edges().size();
+    analysis.graphDataSize = snapshot.estimatedSize();
+
+    // The indices of older files may have gaps, so the degrees are counted by the positions of the nodes
+    std::unordered_map<int, size_t> positions;
+    positions.reserve(analysis.nodeCount);
+    for (auto && node : snapshot.nodes()) {
+        positions.emplace(node.index, positions.size());
+        if (!node.text.isEmpty()) {
+            analysis.nodeTextSize += node.text.utf8().size();
+            analysis.nodesWithText++;
+        }
+    }
+
+    std::vector<size_t> outDegrees(analysis.nodeCount);
+    std::vector<size_t> inDegrees(analysis.nodeCount);
+    for (auto && edge : snapshot.edges()) {
+        outDegrees.at(positions.at(edge.sourceIndex))++;
+        inDegrees.at(positions.at(edge.targetIndex))++;
+        if (!edge.model.text.isEmpty()) {
+            analysis.edgeTextSize += edge.model.text.utf8().size();
+            analysis.edgesWithText++;
+        }
+    }
+
+    if (!analysis.nodeCount) {
+        return;
+    }
+
+    std::vector<size_t> degrees(analysis.nodeCount);
+    for (size_t i = 0; i < analysis.nodeCount; i++) {
+        degrees.at(i) = outDegrees.at(i) + inDegrees.at(i);
+        analysis.degreeHistogram.at(AnalysisReporter::degreeBucket(degrees.at(i)))++;
+    }
+
+    analysis.maxOutDegree = *std::max_element(outDegrees.begin(), outDegrees.end());
+    analysis.maxInDegree = *std::max_element(inDegrees.begin(), inDegrees.end());
+    analysis.maxDegree = *std::max_element(degrees.begin(), degrees.end());
+    // Each edge adds to the degrees of both of its nodes
+    analysis.meanDegree = 2.0 * static_cast<double>(analysis.edgeCount) / static_cast<double>(analysis.nodeCount);
+    const auto median = degrees.begin() + static_cast<std::ptrdiff_t>(degrees.size() / 2);
+    std::nth_element(degrees.begin(), median, degrees.end());
+    analysis.medianDegree = *median;
+}
+
+void analyzeImages(const ImageManager & imageManager, AnalysisReporter::Analysis & analysis)
+{
+    for (auto && image : imageManager.images()) {
+        analysis.imageCount++;
+        const auto data = image.data();
+        analysis.encodedImageSize += static_cast<size_t>(data.size());
+
+        // Only the headers of the images are read for their sizes, the pixels are not decoded
+        QBuffer buffer;
+        buffer.setData(data);
+        QImageReader reader { &buffer };
+        if (const auto size = reader.size(); size.isValid()) {
+            analysis.decodedImageSize += static_cast<size_t>(size.width()) * static_cast<size_t>(size.height()) * 4;
+        } else {
+            L(TAG).warning() << "Cannot read the size of image " << image.id() << " in " << analysis.filePath.toStdString();
+        }
+    }
+}
+
+} // namespace
+
+AnalysisReporter::AnalysisReporter(const Options & options)
+  : m_options(options)
+{
+}
+
+bool AnalysisReporter::isRequested(int argc, char ** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--analyze") || !std::strcmp(argv[i], "--analyze-json")) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t AnalysisReporter::degreeBucket(size_t degree)
+{
+    // 0, 1 and 2 have buckets of their own, then each bucket is twice as wide as the previous one
+    size_t bucket = 0;
+    for (size_t limit = 1; limit < degree; limit *= 2) {
+        bucket++;
+    }
+    return std::min(degree ? bucket + 1 : 0, degreeBucketNames.size() - 1);
+}
+
+AnalysisReporter::Analysis AnalysisReporter::analyze(QString filePath)
+{
+    Analysis analysis;
+    analysis.filePath = filePath;
+
+    const bool isAlzb = IO::AlzbFileIOWorker::isAlzbFile(filePath);
+    analysis.format = isAlzb ? "ALZB" : "ALZ";
+
+    QElapsedTimer timer;
+    timer.start();
+    {
+        QFile file { filePath };
+        if (!file.open(QIODevice::ReadOnly)) {
+            throw IO::FileException(QObject::tr("Cannot open file: '") + filePath + "'");
+        }
+        analysis.isCompressed = !isAlzb && IO::CompressedDevice::isCompressed(file);
+        // Read in chunks so that a huge file isn't kept in memory twice
+        const qint64 chunkSize = 1024 * 1024;
+        while (!file.atEnd()) {
+            const auto chunk = file.read(chunkSize);
+            if (chunk.isEmpty()) {
+                throw IO::FileException(QObject::tr("Cannot read file: '") + filePath + "'");
+            }
+            analysis.fileSize += chunk.size();
+        }
+    }
+    analysis.readTime = elapsed(timer);
+
+    timer.restart();
+    const auto mindMapData = isAlzb ? IO::AlzbFileIOWorker {}.fromFile(filePath) : IO::AlzStreamReader::readFromFile(filePath);
+    analysis.parseTime = elapsed(timer);
+
+    analysis.sections = isAlzb ? IO::AlzbFileIOWorker::readSections(filePath) : IO::AlzStreamReader::readSections(filePath);
+
+    analyzeGraph(mindMapData->graphSnapshot(), analysis);
+
+    analyzeImages(mindMapData->imageManager(), analysis);
+
+    timer.restart();
+    auto && graph = mindMapData->graph();
+    analysis.sceneItemTime = elapsed(timer);
+
+    for (auto && node : graph.nodes()) {
+        analysis.sceneItemCount += 1 + static_cast<size_t>(node->childItems().size());
+    }
+    for (auto && edge : graph.edges()) {
+        analysis.sceneItemCount += 1 + static_cast<size_t>(edge->childItems().size());
+    }
+
+    return analysis;
+}
+
+QStringList AnalysisReporter::report(const Analysis & analysis)
+{
+    QStringList lines;
+    lines << QString { "%1: %2%3, %4" }.arg(analysis.filePath, analysis.format, analysis.isCompressed ? ", compressed" : "", dataSize(analysis.fileSize));
+    lines << QString { "  Nodes: %1, edges: %2" }.arg(analysis.nodeCount).arg(analysis.edgeCount);
+    lines << QString { "  Degree: mean %1, median %2, max %3 (out %4, in %5)" }
+               .arg(analysis.meanDegree, 0, 'f', 2)
+               .arg(analysis.medianDegree)
+               .arg(analysis.maxDegree)
+               .arg(analysis.maxOutDegree)
+               .arg(analysis.maxInDegree);
+
+    QStringList buckets;
+    for (size_t bucket = 0; bucket < analysis.degreeHistogram.size(); bucket++) {
+        buckets << QString { "%1: %2" }.arg(degreeBucketNames.at(bucket)).arg(analysis.degreeHistogram.at(bucket));
+    }
+    lines << "  Nodes by degree: " + buckets.join(", ");
+
+    lines << QString { "  Text: %1 in %2 nodes, %3 in %4 edges" }
+               .arg(dataSize(static_cast<qint64>(analysis.nodeTextSize)))
+               .arg(analysis.nodesWithText)
+               .arg(dataSize(static_cast<qint64>(analysis.edgeTextSize)))
+               .arg(analysis.edgesWithText);
+    lines << QString { "  Images: %1, %2 encoded, %3 decoded" }
+               .arg(analysis.imageCount)
+               .arg(dataSize(static_cast<qint64>(analysis.encodedImageSize)))
+               .arg(dataSize(static_cast<qint64>(analysis.decodedImageSize)));
+    lines << QString { "  Graph data: %1, scene items: %2" }.arg(dataSize(static_cast<qint64>(analysis.graphDataSize))).arg(analysis.sceneItemCount);
+
+    QStringList sections;
+    for (auto && section : analysis.sections) {
+        auto text = section.name + " " + dataSize(section.size);
+        if (section.count != 1) {
+            text += QString { " (%1)" }.arg(section.count);
+        }
+        sections << text;
+    }
+    lines << "  Sections: " + sections.join(", ");
+
+    lines << QString { "  Timings: read %1, parse %2, scene items %3" }.arg(milliseconds(analysis.readTime), milliseconds(analysis.parseTime), milliseconds(analysis.sceneItemTime));
+
+    return lines;
+}
+
+QString AnalysisReporter::reportJson(const Analysis & analysis)
+{
+    QJsonArray histogram;
+    for (size_t bucket = 0; bucket < analysis.degreeHistogram.size(); bucket++) {
+        histogram.append(QJsonObject { { "degree", degreeBucketNames.at(bucket) }, { "nodes", jsonSize(analysis.degreeHistogram.at(bucket)) } });
+    }
+
+    QJsonArray sections;
+    for (auto && section : analysis.sections) {
+        sections.append(QJsonObject { { "name", section.name }, { "size", section.size }, { "count", jsonSize(section.count) } });
+    }
+
+    const QJsonObject object {
+        { "file", analysis.filePath },
+        { "format", analysis.format },
+        { "compressed", analysis.isCompressed },
+        { "fileSize", analysis.fileSize },
+        { "nodes", jsonSize(analysis.nodeCount) },
+        { "edges", jsonSize(analysis.edgeCount) },
+        { "degree", QJsonObject {
+                      { "mean", analysis.meanDegree },
+                      { "median", jsonSize(analysis.medianDegree) },
+                      { "max", jsonSize(analysis.maxDegree) },
+                      { "maxOut", jsonSize(analysis.maxOutDegree) },
+                      { "maxIn", jsonSize(analysis.maxInDegree) },
+                      { "histogram", histogram } } },
+        { "text", QJsonObject {
+                    { "nodeBytes", jsonSize(analysis.nodeTextSize) },
+                    { "nodesWithText", jsonSize(analysis.nodesWithText) },
+                    { "edgeBytes", jsonSize(analysis.edgeTextSize) },
+                    { "edgesWithText", jsonSize(analysis.edgesWithText) } } },
+        { "images", QJsonObject {
+                      { "count", jsonSize(analysis.imageCount) },
+                      { "encodedSize", jsonSize(analysis.encodedImageSize) },
+                      { "decodedSize", jsonSize(analysis.decodedImageSize) } } },
+        { "graphDataSize", jsonSize(analysis.graphDataSize) },
+        { "sceneItems", jsonSize(analysis.sceneItemCount) },
+        { "sections", sections },
+        { "timings", QJsonObject {
+                       { "readMs", jsonMilliseconds(analysis.readTime) },
+                       { "parseMs", jsonMilliseconds(analysis.parseTime) },
+                       { "sceneItemsMs", jsonMilliseconds(analysis.sceneItemTime) } } }
+    };
+
+    return QString::fromUtf8(QJsonDocument { object }.toJson(QJsonDocument::Compact));
+}
+
+int AnalysisReporter::run()
+{
+    if (m_options.inputFiles.isEmpty()) {
+        L(TAG).error() << "No mind map files given";
+        return EXIT_FAILURE;
+    }
+
+    bool allAnalyzed = true;
+    for (auto && inputFile : m_options.inputFiles) {
+        try {
+            const auto analysis = analyze(inputFile);
+            const auto lines = m_options.json ? QStringList { reportJson(analysis) } : report(analysis);
+            for (auto && line : lines) {
+                std::cout << line.toStdString() << std::endl;
+            }
+        } catch (const std::exception & e) {
+            L(TAG).error() << "Failed to analyze " << inputFile.toStdString() << ": " << e.what();
+            allAnalyzed = false;
+        }
+    }
+
+    return allAnalyzed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
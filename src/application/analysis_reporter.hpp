@@ -0,0 +1,134 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ANALYSIS_REPORTER_HPP
+#define ANALYSIS_REPORTER_HPP
+
+#include "../infra/io/file_section.hpp"
+
+#include <QString>
+#include <QStringList>
+
+#include <array>
+#include <chrono>
+
+//! Analyzes mind map files from the command line without showing any windows, e.g. to know what a generated
+//! mind map is going to cost before opening it. The files are read by the same streaming readers as when opened
+//! and the scene items are created like in the editor, so the counts and the timings are those of a real load.
+class AnalysisReporter
+{
+public:
+    struct Options
+    {
+        bool enabled = false;
+
+        //! Prints a JSON object per file on its own line instead of text.
+        bool json = false;
+
+        QStringList inputFiles;
+    };
+
+    //! Node counts by degree: 0, 1, 2, 3-4, 5-8, 9-16, 17-32 and 33 or more edges.
+    using DegreeHistogram = std::array<size_t, 8>;
+
+    struct Analysis
+    {
+        QString filePath;
+
+        //! "ALZ" or "ALZB".
+        QString format;
+
+        bool isCompressed = false;
+
+        qint64 fileSize = 0;
+
+        size_t nodeCount = 0;
+
+        size_t edgeCount = 0;
+
+        DegreeHistogram degreeHistogram {};
+
+        double meanDegree = 0;
+
+        size_t medianDegree = 0;
+
+        size_t maxDegree = 0;
+
+        size_t maxOutDegree = 0;
+
+        size_t maxInDegree = 0;
+
+        //! UTF-8 bytes of the node texts.
+        size_t nodeTextSize = 0;
+
+        size_t nodesWithText = 0;
+
+        //! UTF-8 bytes of the edge texts.
+        size_t edgeTextSize = 0;
+
+        size_t edgesWithText = 0;
+
+        size_t imageCount = 0;
+
+        size_t encodedImageSize = 0;
+
+        //! Bytes of the images decoded to 32-bit pixels, vector images at their default size.
+        size_t decodedImageSize = 0;
+
+        //! Estimated memory of the plain data of the graph, see GraphSnapshot::estimatedSize().
+        size_t graphDataSize = 0;
+
+        //! The nodes, the edges and their child items, e.g. the texts and the labels, for the whole graph.
+        size_t sceneItemCount = 0;
+
+        IO::FileSections sections;
+
+        //! Reading the bytes of the file.
+        std::chrono::microseconds readTime {};
+
+        //! Parsing the file into plain data, with the bytes coming from the file system cache after the read.
+        std::chrono::microseconds parseTime {};
+
+        //! Creating the scene items from the plain data.
+        std::chrono::microseconds sceneItemTime {};
+    };
+
+    explicit AnalysisReporter(const Options & options);
+
+    //! \return true if the given command line requests an analysis. Used to select the
+    //! platform plugin before QApplication is instantiated.
+    static bool isRequested(int argc, char ** argv);
+
+    //! \return The index of the DegreeHistogram bucket of the given degree.
+    static size_t degreeBucket(size_t degree);
+
+    //! Reads and analyzes the given ALZ- or ALZB-file.
+    //! \throws FileException if the file cannot be opened or parsed.
+    static Analysis analyze(QString filePath);
+
+    //! \return The lines that describe the given analysis for people.
+    static QStringList report(const Analysis & analysis);
+
+    //! \return The given analysis as a single line of JSON.
+    static QString reportJson(const Analysis & analysis);
+
+    //! \return EXIT_SUCCESS if all files could be analyzed, EXIT_FAILURE otherwise.
+    int run();
+
+private:
+    Options m_options;
+};
+
+#endif // ANALYSIS_REPORTER_HPP
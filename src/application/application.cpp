@@ -22,14 +22,22 @@
 #include "../application/service_container.hpp"
 #include "../application/settings_proxy.hpp"
 #include "../application/state_machine.hpp"
+#include "../application/task_chain.hpp"
+#include "../application/task_pool.hpp"
 #include "../common/constants.hpp"
+#include "../common/profiler.hpp"
+#include "../common/trace_recorder.hpp"
+#include "../domain/image.hpp"
 #include "../domain/layout_optimizer.hpp"
+#include "../infra/io/url_reader.hpp"
 #include "../infra/settings.hpp"
 #include "../infra/version_checker.hpp"
+#include "../view/dialogs/export/pdf_export_dialog.hpp"
 #include "../view/dialogs/export/png_export_dialog.hpp"
 #include "../view/dialogs/export/svg_export_dialog.hpp"
 #include "../view/dialogs/layout_optimization_dialog.hpp"
 #include "../view/dialogs/scene_color_dialog.hpp"
+#include "../view/dialogs/workspace_search_dialog.hpp"
 #include "../view/editor_view.hpp"
 #include "../view/main_window.hpp"
 #include "../view/node_action.hpp"
@@ -38,12 +46,18 @@
 #include "simple_logger.hpp"
 
 #include <QFileDialog>
+#include <QImageReader>
+#include <QInputDialog>
 #include <QLocale>
 #include <QMessageBox>
 #include <QObject>
 #include <QProgressDialog>
 #include <QStandardPaths>
 
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
 using juzzlin::Argengine;
 using juzzlin::L;
 
@@ -53,21 +67,60 @@ Application::Application(int & argc, char ** argv)
   : m_application(argc, argv)
   , m_serviceContainer(std::make_unique<SC>())
   , m_stateMachine(new StateMachine { this }) // Parented to this
-  , m_versionChecker(new VersionChecker { this }) // Parented to this
 {
     parseArgs(argc, argv);
 
     initializeTranslations();
 
+    logStartupPhase("Translations");
+
+    if (m_batchExportOptions.enabled() || m_diffOptions.enabled || m_analysisOptions.enabled) {
+        // Headless mode for scripts: the files are exported, compared or analyzed by run() without any windows
+        return;
+    }
+
     // Instantiate components here because the possible language given
     // in the command line must have been loaded before this
     instantiateAndConnectComponents();
 
+    logStartupPhase("Components");
+
+    if (m_isMemoryUsageLoggingEnabled) {
+        const auto memoryUsageLogTimer = new QTimer(this);
+        connect(memoryUsageLogTimer, &QTimer::timeout, this, &Application::logMemoryUsage);
+        memoryUsageLogTimer->start(Constants::Application::memoryUsageLogInterval());
+    }
+
     initializeAndShowMainWindow();
 
+    logStartupPhase("Main window");
+
     openGivenMindMapOrAutoloadRecentMindMap();
 
-    checkForNewReleases();
+    // After the given mind map has been opened, so that it's the shared one
+    QTimer::singleShot(0, this, &Application::startSession);
+
+    // The first events, including the first paint, have been processed when this fires
+    QTimer::singleShot(0, this, [this] {
+        logStartupPhase("Interactive");
+        QTimer::singleShot(Constants::Application::versionCheckDelay(), this, &Application::checkForNewReleases);
+    });
+}
+
+void Application::logStartupPhase(const char * phase) const
+{
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_startupTime);
+    L(TAG).info() << "Startup: " << phase << " ready at " << elapsed.count() << " ms";
+}
+
+void Application::logMemoryUsage() const
+{
+    const auto report = m_serviceContainer->applicationService()->memoryReport();
+    for (auto && entry : report.entries) {
+        L(TAG).debug() << "Memory: " << entry.first.toStdString() << ": " << entry.second.itemCount << " items, " << entry.second.bytes << " bytes";
+    }
+    L(TAG).debug() << "Memory: total " << report.totalBytes() << " bytes";
+    L(TAG).debug() << "Memory: " << report.reclaimed.itemCount << " cache trims gave back " << report.reclaimed.bytes << " bytes";
 }
 
 void Application::connectComponents()
@@ -124,6 +177,8 @@ void Application::openGivenMindMapOrAutoloadRecentMindMap()
 
 void Application::checkForNewReleases()
 {
+    // Instantiating the network stack is slow, so it's kept off the startup path
+    m_versionChecker = new VersionChecker { this }; // Parented to this
     connect(m_versionChecker, &VersionChecker::newVersionFound, this, [this](Version version, QString downloadUrl) {
         m_serviceContainer->applicationService()->showStatusText(QString { tr("A new version %1 available at <a href='%2'>%2</a>") }.arg(version.toString(), downloadUrl));
     });
@@ -131,10 +186,40 @@ void Application::checkForNewReleases()
 }
 
 QString Application::getFileDialogFileText() const
+{
+    return tr("Heimer Files") + " (*" + Constants::Application::fileExtension() + " *" + Constants::Application::binaryFileExtension() + ")";
+}
+
+QString Application::getSaveFileDialogFileText() const
+{
+    return getXmlFileDialogFileText() + ";;" + getCompressedFileDialogFileText() + ";;" + getBinaryFileDialogFileText();
+}
+
+QString Application::getCompressedFileDialogFileText() const
+{
+    return tr("Heimer Compressed Files") + " (*" + Constants::Application::fileExtension() + ")";
+}
+
+QString Application::getXmlFileDialogFileText() const
 {
     return tr("Heimer Files") + " (*" + Constants::Application::fileExtension() + ")";
 }
 
+QString Application::getBinaryFileDialogFileText() const
+{
+    return tr("Heimer Binary Files") + " (*" + Constants::Application::binaryFileExtension() + ")";
+}
+
+QString Application::getOpenFileDialogFileText() const
+{
+    return getFileDialogFileText() + ";;" + getOutlineFileDialogFileText();
+}
+
+QString Application::getOutlineFileDialogFileText() const
+{
+    return tr("Outlines") + " (*.opml *.mm *.md *.markdown)";
+}
+
 void Application::initializeTranslations()
 {
     m_serviceContainer->languageService()->initializeTranslations(m_application);
@@ -154,14 +239,16 @@ void Application::parseArgs(int argc, char ** argv)
     Argengine ae(argc, argv);
 
     ae.addOption(
-      { "-d", "--debug" }, [] {
+      { "-d", "--debug" }, [this] {
           L::setLoggingLevel(L::Level::Debug);
+          m_isMemoryUsageLoggingEnabled = true;
       },
       false, "Show debug logging.");
 
     ae.addOption(
-      { "-t", "--trace" }, [] {
+      { "-t", "--trace" }, [this] {
           L::setLoggingLevel(L::Level::Trace);
+          m_isMemoryUsageLoggingEnabled = true;
       },
       false, "Show trace logging.");
 
@@ -175,17 +262,145 @@ void Application::parseArgs(int argc, char ** argv)
       },
       false, "Force language: " + buildAvailableLanguagesHelpString());
 
+    ae.addOption(
+      { "--export-png" }, [this] {
+          m_batchExportOptions.exportPng = true;
+      },
+      false, "Export the given mind map files to PNG images next to them and exit without opening a window.");
+
+    ae.addOption(
+      { "--export-svg" }, [this] {
+          m_batchExportOptions.exportSvg = true;
+      },
+      false, "Export the given mind map files to SVG images next to them and exit without opening a window.");
+
+    ae.addOption(
+      { "--export-json" }, [this] {
+          m_batchExportOptions.exportJsonLines = true;
+      },
+      false, "Export the nodes, edges and style of the given mind map files to JSON Lines files next to them and exit without opening a window.");
+
+    ae.addOption(
+      { "--export-outline" }, [this] {
+          m_batchExportOptions.exportOutline = true;
+      },
+      false, "Export the given mind map files to indented outline text files next to them and exit without opening a window.");
+
+    ae.addOption(
+      { "--script" }, [this](std::string value) {
+          m_batchExportOptions.scriptFile = value.c_str();
+      },
+      false, "Run the given JavaScript file against the given mind map files and exit without opening a window. The mind maps are saved back unless they are exported.", "FILE");
+
+    ae.addOption(
+      { "--size" }, [this](std::string value) {
+          m_batchExportOptions.imageSize = value.c_str();
+      },
+      false, "Size of the exported PNG images as W or WxH. Defaults to the size of the mind map.", "SIZE");
+
+    ae.addOption(
+      { "--optimize-layout" }, [this] {
+          m_batchExportOptions.optimizeLayout = true;
+      },
+      false, "Optimize the layouts of the mind maps before exporting them.");
+
+    ae.addOption(
+      { "--layout-time-budget" }, [this](std::string value) {
+          m_batchExportOptions.layoutTimeBudget = std::chrono::seconds { QString(value.c_str()).toUInt() };
+      },
+      false, "Stop optimizing the layout of each mind map after SECONDS and keep the best layout found. Used with --optimize-layout.", "SECONDS");
+
+    ae.addOption(
+      { "--diff" }, [this] {
+          m_diffOptions.enabled = true;
+      },
+      false, "Print the differences between the two given mind map files and exit without opening a window. Exits with 0 if there are no differences, 1 if there are and 2 on errors.");
+
+    ae.addOption(
+      { "--info" }, [this] {
+          m_infoOptions.enabled = true;
+      },
+      false, "Print the version, the node and edge counts and the bounds of the given mind map files from their headers and exit without opening a window.");
+
+    ae.addOption(
+      { "--analyze" }, [this] {
+          m_analysisOptions.enabled = true;
+      },
+      false, "Load the given mind map files without opening a window and print their node and edge counts, degree distribution, text and image volumes, scene item counts, file section sizes and load timings.");
+
+    ae.addOption(
+      { "--analyze-json" }, [this] {
+          m_analysisOptions.enabled = true;
+          m_analysisOptions.json = true;
+      },
+      false, "Like --analyze, but print the analysis of each file as a JSON object on its own line.");
+
+    ae.addOption(
+      { "--profile" }, [](std::string value) {
+          Profiler::setEnabled(true);
+          Profiler::setReportFile(value);
+      },
+      false, "Show paint times on the editor view and write a profiling report to FILE on exit.", "FILE");
+
+    ae.addOption(
+      { "--trace-events" }, [](std::string value) {
+          TraceRecorder::setOutputFile(value);
+      },
+      false, "Record the timelines of opening, saving, layout optimization, exports and painting and write them to FILE in the Chrome trace format on exit.", "FILE");
+
+    ae.addOption(
+      { "--host-session" }, [this](std::string value) {
+          m_sessionOptions.hostPort = static_cast<quint16>(QString(value.c_str()).toUInt());
+      },
+      false, "Share the edits of the mind map with the instances that join on PORT. Only the instances of this computer can join unless --session-address is given.", "PORT");
+    ae.addOption(
+      { "--join-session" }, [this](std::string value) {
+          m_sessionOptions.joinAddress = value.c_str();
+      },
+      false, "Join the session hosted on HOST:PORT. The mind map of the host is opened as unsaved.", "HOST:PORT");
+    ae.addOption(
+      { "--session-address" }, [this](std::string value) {
+          m_sessionOptions.hostAddress = value.c_str();
+      },
+      false, "Listen on ADDRESS when hosting a session, e.g. 0.0.0.0 for all the networks of this computer.", "ADDRESS");
+    ae.addOption(
+      { "--session-secret" }, [this](std::string value) {
+          m_sessionOptions.secret = value.c_str();
+      },
+      false, "The secret that the joining instances must know. The host generates one and shows it if not given.", "SECRET");
     ae.setPositionalArgumentCallback([=](Argengine::ArgumentVector args) {
         m_mindMapFile = args.at(0).c_str();
+        for (auto && arg : args) {
+            m_batchExportOptions.inputFiles << arg.c_str();
+            m_diffOptions.inputFiles << arg.c_str();
+            m_infoOptions.inputFiles << arg.c_str();
+            m_analysisOptions.inputFiles << arg.c_str();
+        }
     });
 
-    ae.setHelpText(std::string("\nUsage: ") + argv[0] + " [OPTIONS] [MIND_MAP_FILE]");
+    ae.setHelpText(std::string("\nUsage: ") + argv[0] + " [OPTIONS] [MIND_MAP_FILE...]");
 
     ae.parse();
 }
 
 int Application::run()
 {
+    if (m_batchExportOptions.enabled()) {
+        return BatchExporter { m_batchExportOptions }.run();
+    }
+
+    if (m_diffOptions.enabled) {
+        return DiffReporter { m_diffOptions }.run();
+    }
+
+    if (m_infoOptions.enabled) {
+        return InfoReporter { m_infoOptions }.run();
+    }
+
+    if (m_analysisOptions.enabled) {
+        return AnalysisReporter { m_analysisOptions }.run();
+    }
+
     return m_application.exec();
 }
 
@@ -196,8 +411,13 @@ void Application::runState(StateMachine::State state)
         m_mainWindow->saveWindowSize();
         m_mainWindow->close();
         break;
+    case StateMachine::State::CloseTab:
+        m_serviceContainer->applicationService()->closeTab();
+        emit actionTriggered(StateMachine::Action::TabClosed);
+        break;
     case StateMachine::State::Exit:
         m_mainWindow->saveWindowSize();
+        m_serviceContainer->applicationService()->prepareForExit();
         QApplication::exit(EXIT_SUCCESS);
         break;
     default:
@@ -207,18 +427,34 @@ void Application::runState(StateMachine::State state)
     case StateMachine::State::InitializeNewMindMap:
         m_serviceContainer->applicationService()->initializeNewMindMap();
         break;
+    case StateMachine::State::InitializeNewTab:
+        if (m_serviceContainer->applicationService()->addTab()) {
+            m_serviceContainer->applicationService()->initializeNewMindMap();
+        } else {
+            emit actionTriggered(StateMachine::Action::OpeningMindMapCanceled);
+        }
+        break;
     case StateMachine::State::OpenRecent:
         doOpenMindMap(SC::instance().recentFilesManager()->selectedFile());
         break;
     case StateMachine::State::OpenDrop:
         doOpenMindMap(m_editorView->dropFile());
         break;
+    case StateMachine::State::OpenWorkspaceSearchHit:
+        doOpenMindMap(m_workspaceSearchHit.filePath, m_workspaceSearchHit.text);
+        break;
     case StateMachine::State::Save:
         saveMindMap();
         break;
     case StateMachine::State::ShowBackgroundColorDialog:
         showBackgroundColorDialog();
         break;
+    case StateMachine::State::ShowCompareDialog:
+        showCompareDialog();
+        break;
+    case StateMachine::State::ShowRunScriptDialog:
+        showRunScriptDialog();
+        break;
     case StateMachine::State::ShowEdgeColorDialog:
         showEdgeColorDialog();
         break;
@@ -234,6 +470,9 @@ void Application::runState(StateMachine::State state)
     case StateMachine::State::ShowImageFileDialog:
         showImageFileDialog();
         break;
+    case StateMachine::State::ShowPdfExportDialog:
+        showPdfExportDialog();
+        break;
     case StateMachine::State::ShowPngExportDialog:
         showPngExportDialog();
         break;
@@ -262,6 +501,15 @@ void Application::runState(StateMachine::State state)
     case StateMachine::State::ShowOpenDialog:
         openMindMap();
         break;
+    case StateMachine::State::ShowOpenInNewTabDialog:
+        openMindMapInNewTab();
+        break;
+    case StateMachine::State::ShowOpenUrlDialog:
+        showOpenUrlDialog();
+        break;
+    case StateMachine::State::ShowWorkspaceSearchDialog:
+        showWorkspaceSearchDialog();
+        break;
     }
 }
 
@@ -270,6 +518,20 @@ void Application::updateProgress()
     SC::instance().progressManager()->updateProgress();
 }
 
+void Application::startSession()
+{
+    if (m_sessionOptions.hostPort) {
+        m_serviceContainer->applicationService()->hostSession(m_sessionOptions.hostPort, m_sessionOptions.secret, m_sessionOptions.hostAddress);
+    } else if (!m_sessionOptions.joinAddress.isEmpty()) {
+        const auto separator = m_sessionOptions.joinAddress.lastIndexOf(':');
+        if (const auto port = m_sessionOptions.joinAddress.mid(separator + 1).toUInt(); separator > 0 && port && port <= 65535) {
+            m_serviceContainer->applicationService()->joinSession(m_sessionOptions.joinAddress.left(separator), static_cast<quint16>(port), m_sessionOptions.secret);
+        } else {
+            L(TAG).error() << "Invalid session address: '" << m_sessionOptions.joinAddress.toStdString() << "'";
+        }
+    }
+}
+
 void Application::openArgMindMap()
 {
     doOpenMindMap(m_mindMapFile);
@@ -280,33 +542,133 @@ void Application::openMindMap()
     L(TAG).debug() << "Open file";
 
     const auto path = Settings::Custom::loadRecentPath();
-    if (const auto fileName = QFileDialog::getOpenFileName(m_mainWindow.get(), tr("Open File"), path, getFileDialogFileText()); !fileName.isEmpty()) {
+    if (const auto fileName = QFileDialog::getOpenFileName(m_mainWindow.get(), tr("Open File"), path, getOpenFileDialogFileText()); !fileName.isEmpty()) {
         doOpenMindMap(fileName);
     } else {
         emit actionTriggered(StateMachine::Action::OpeningMindMapCanceled);
     }
 }
 
-void Application::doOpenMindMap(QString fileName)
+void Application::openMindMapInNewTab()
 {
-    L(TAG).debug() << "Opening '" << fileName.toStdString();
-    m_mainWindow->showSpinnerDialog(true, tr("Opening '%1'..").arg(fileName));
-    updateProgress();
-    if (m_serviceContainer->applicationService()->openMindMap(fileName)) {
-        m_mainWindow->disableUndoAndRedo();
-        updateProgress();
-        m_mainWindow->setSaveActionStatesOnOpenedMindMap();
-        updateProgress();
-        Settings::Custom::saveRecentPath(fileName);
-        updateProgress();
-        m_mainWindow->showSpinnerDialog(false);
-        updateProgress();
+    L(TAG).debug() << "Open file in new tab";
+
+    const auto path = Settings::Custom::loadRecentPath();
+    if (const auto fileName = QFileDialog::getOpenFileName(m_mainWindow.get(), tr("Open File in New Tab"), path, getOpenFileDialogFileText()); fileName.isEmpty()) {
+        emit actionTriggered(StateMachine::Action::OpeningMindMapCanceled);
+    } else if (m_serviceContainer->applicationService()->activateTabOfFile(fileName)) {
         emit actionTriggered(StateMachine::Action::MindMapOpened);
+    } else if (m_serviceContainer->applicationService()->addTab()) {
+        doOpenMindMap(fileName);
     } else {
-        m_mainWindow->showSpinnerDialog(false);
-        updateProgress();
-        emit actionTriggered(StateMachine::Action::OpeningMindMapFailed);
+        emit actionTriggered(StateMachine::Action::OpeningMindMapCanceled);
+    }
+}
+
+void Application::showCompareDialog()
+{
+    const auto path = Settings::Custom::loadRecentPath();
+    if (const auto fileName = QFileDialog::getOpenFileName(m_mainWindow.get(), tr("Compare With File"), path, getOpenFileDialogFileText()); !fileName.isEmpty()) {
+        m_serviceContainer->applicationService()->compareWithFile(fileName);
     }
+    emit actionTriggered(StateMachine::Action::MindMapCompared);
+}
+
+void Application::showRunScriptDialog()
+{
+    const auto path = Settings::Custom::loadRecentPath();
+    if (const auto fileName = QFileDialog::getOpenFileName(m_mainWindow.get(), tr("Run Script"), path, tr("JavaScript files (*.js)")); !fileName.isEmpty()) {
+        m_serviceContainer->applicationService()->runScript(fileName);
+    }
+    emit actionTriggered(StateMachine::Action::ScriptRun);
+}
+
+void Application::showOpenUrlDialog()
+{
+    bool ok = false;
+    if (const auto url = QInputDialog::getText(m_mainWindow.get(), tr("Open URL"), tr("URL:"), QLineEdit::Normal, "https://", &ok).trimmed(); ok && IO::UrlReader::isUrl(url)) {
+        doOpenMindMap(url);
+    } else {
+        if (ok) {
+            showMessageBox(tr("Only HTTP and HTTPS URLs can be opened."));
+        }
+        emit actionTriggered(StateMachine::Action::OpeningMindMapCanceled);
+    }
+}
+
+void Application::doOpenMindMap(QString fileName, QString searchText)
+{
+    if (IO::UrlReader::isUrl(fileName)) {
+        doOpenUrl(fileName);
+        return;
+    }
+
+    L(TAG).debug() << "Opening '" << fileName.toStdString();
+    m_mainWindow->showSpinnerDialog(true, tr("Opening '%1'..").arg(fileName));
+
+    // The spinner gets painted before the steps, as the event loop runs in between
+    const auto isOpened = std::make_shared<bool>(false);
+    TaskChain::create(*m_serviceContainer->taskPool())
+      ->onGuiThread([this, fileName, isOpened] {
+          *isOpened = m_serviceContainer->applicationService()->openMindMap(fileName);
+      })
+      .onGuiThread([this, fileName, searchText, isOpened] {
+          if (*isOpened) {
+              m_mainWindow->disableUndoAndRedo();
+              // The undo history may have been kept from a previous session
+              m_mainWindow->enableUndo(m_serviceContainer->applicationService()->isUndoable());
+              m_mainWindow->setHistory(m_serviceContainer->applicationService()->historyPosition(), m_serviceContainer->applicationService()->historyLength());
+              m_mainWindow->setSaveActionStatesOnOpenedMindMap();
+              Settings::Custom::saveRecentPath(fileName);
+              if (!searchText.isEmpty()) {
+                  m_mainWindow->setSearchText(searchText);
+              }
+          }
+      })
+      .start([this, isOpened](TaskChain::Result result, QString) {
+          m_mainWindow->showSpinnerDialog(false);
+          emit actionTriggered(*isOpened && result == TaskChain::Result::Finished ? StateMachine::Action::MindMapOpened : StateMachine::Action::OpeningMindMapFailed);
+      });
+}
+
+void Application::doOpenUrl(QString url)
+{
+    L(TAG).debug() << "Opening URL '" << url.toStdString();
+    m_mainWindow->showSpinnerDialog(true, tr("Downloading '%1'.. Press Esc to cancel.").arg(url));
+
+    // Deleted via the event loop, because the last reference may be dropped on a background thread
+    const auto reader = std::shared_ptr<IO::UrlReader>(new IO::UrlReader { QUrl { url } }, [](IO::UrlReader * reader) {
+        reader->deleteLater();
+    });
+    m_urlReader = reader;
+    connect(m_mainWindow.get(), &MainWindow::spinnerDialogRejected, reader.get(), [reader = reader.get()] {
+        reader->cancel(tr("Cancelled"));
+    });
+    const auto mindMapData = std::make_shared<MindMapDataU>();
+    const auto isOpened = std::make_shared<bool>(false);
+    TaskChain::create(*m_serviceContainer->taskPool())
+      ->onGuiThread([reader] {
+          reader->start();
+      })
+      .inBackground([reader, mindMapData] {
+          // The GUI thread keeps receiving the data while this parses it
+          *mindMapData = reader->read();
+      })
+      .onGuiThread([this, url, mindMapData, isOpened] {
+          *isOpened = m_serviceContainer->applicationService()->openMindMap(std::move(*mindMapData), url);
+          if (*isOpened) {
+              m_mainWindow->disableUndoAndRedo();
+              m_mainWindow->setSaveActionStatesOnOpenedMindMap();
+          }
+      })
+      .start([this, isOpened](TaskChain::Result result, QString error) {
+          m_mainWindow->showSpinnerDialog(false);
+          if (result == TaskChain::Result::Failed) {
+              L(TAG).error() << error.toStdString();
+              m_mainWindow->showErrorDialog(error);
+          }
+          emit actionTriggered(*isOpened && result == TaskChain::Result::Finished ? StateMachine::Action::MindMapOpened : StateMachine::Action::OpeningMindMapFailed);
+      });
 }
 
 void Application::saveMindMap()
@@ -329,22 +691,25 @@ void Application::saveMindMapAs()
 {
     L(TAG).debug() << "Save as..";
 
+    QString selectedFilter;
     QString fileName = QFileDialog::getSaveFileName(
       m_mainWindow.get(),
       tr("Save File As"),
       Settings::Custom::loadRecentPath(),
-      getFileDialogFileText());
+      getSaveFileDialogFileText(),
+      &selectedFilter);
 
     if (fileName.isEmpty()) {
         emit actionTriggered(StateMachine::Action::MindMapSaveAsCanceled);
         return;
     }
 
-    if (!fileName.endsWith(Constants::Application::fileExtension())) {
-        fileName += Constants::Application::fileExtension();
+    const auto extension = selectedFilter == getBinaryFileDialogFileText() ? Constants::Application::binaryFileExtension() : Constants::Application::fileExtension();
+    if (!fileName.endsWith(Constants::Application::fileExtension()) && !fileName.endsWith(Constants::Application::binaryFileExtension())) {
+        fileName += extension;
     }
 
-    if (m_serviceContainer->applicationService()->saveMindMapAs(fileName)) {
+    if (m_serviceContainer->applicationService()->saveMindMapAs(fileName, selectedFilter == getCompressedFileDialogFileText())) {
         const auto msg = QString(tr("File '")) + fileName + tr("' saved.");
         L(TAG).debug() << msg.toStdString();
         m_mainWindow->enableSave(false);
@@ -397,30 +762,72 @@ void Application::showTextColorDialog()
     emit actionTriggered(StateMachine::Action::TextColorChanged);
 }
 
+void Application::showWorkspaceSearchDialog()
+{
+    Dialogs::WorkspaceSearchDialog workspaceSearchDialog { *m_serviceContainer->workspaceIndex(), m_mainWindow.get() };
+    if (workspaceSearchDialog.exec() == QDialog::Accepted && !workspaceSearchDialog.selectedHit().filePath.isEmpty()) {
+        m_workspaceSearchHit = workspaceSearchDialog.selectedHit();
+        emit actionTriggered(StateMachine::Action::WorkspaceSearchHitSelected);
+    } else {
+        emit actionTriggered(StateMachine::Action::WorkspaceSearchClosed);
+    }
+}
+
 void Application::showImageFileDialog()
 {
     const auto path = Settings::Custom::loadRecentImagePath();
-    const auto extensions = "(*.jpg *.jpeg *.JPG *.JPEG *.png *.PNG)";
+    const auto extensions = "(*.jpg *.jpeg *.JPG *.JPEG *.png *.PNG *.svg *.SVG *.svgz)";
     const auto fileName = QFileDialog::getOpenFileName(
       m_mainWindow.get(), tr("Open an image"), path, tr("Image Files") + " " + extensions);
 
-    if (QImage image; image.load(fileName)) {
-        m_serviceContainer->applicationService()->performNodeAction({ NodeAction::Type::AttachImage, image, fileName });
+    // Only the header is checked here, the actual decoding happens in the background
+    if (!fileName.isEmpty() && (QImageReader(fileName).canRead() || Image::isVectorFileName(fileName))) {
+        m_serviceContainer->applicationService()->performNodeAction({ NodeAction::Type::AttachImage, fileName });
         Settings::Custom::saveRecentImagePath(fileName);
     } else if (fileName != "") {
         QMessageBox::critical(m_mainWindow.get(), tr("Load image"), tr("Failed to load image '") + fileName + "'");
     }
 }
 
+std::vector<ExportParams::Region> Application::availableExportRegions() const
+{
+    std::vector<ExportParams::Region> regions { ExportParams::Region::MindMap, ExportParams::Region::View };
+    if (!m_serviceContainer->applicationService()->selectedNodes().empty()) {
+        regions.push_back(ExportParams::Region::SelectedNodes);
+    }
+    return regions;
+}
+
+void Application::showPdfExportDialog()
+{
+    Dialogs::Export::PdfExportDialog pdfExportDialog { *m_mainWindow };
+
+    connect(&pdfExportDialog, &Dialogs::Export::PdfExportDialog::pdfExportRequested, m_serviceContainer->applicationService().get(), &ApplicationService::exportToPdf);
+    connect(m_serviceContainer->applicationService().get(), &ApplicationService::pdfExportFinished, &pdfExportDialog, &Dialogs::Export::PdfExportDialog::finishExport);
+    connect(m_serviceContainer->applicationService().get(), &ApplicationService::pdfExportProgressed, &pdfExportDialog, &Dialogs::Export::PdfExportDialog::setProgress);
+
+    pdfExportDialog.setCurrentMindMapFileName(m_serviceContainer->applicationService()->fileName());
+    for (auto && region : availableExportRegions()) {
+        pdfExportDialog.addRegion(region, m_serviceContainer->applicationService()->calculateExportRegionRectangle(region).size());
+    }
+    pdfExportDialog.exec();
+
+    // Doesn't matter if canceled or not
+    emit actionTriggered(StateMachine::Action::PdfExported);
+}
+
 void Application::showPngExportDialog()
 {
     Dialogs::Export::PngExportDialog pngExportDialog { *m_mainWindow };
 
     connect(&pngExportDialog, &Dialogs::Export::PngExportDialog::pngExportRequested, m_serviceContainer->applicationService().get(), &ApplicationService::exportToPng);
     connect(m_serviceContainer->applicationService().get(), &ApplicationService::pngExportFinished, &pngExportDialog, &Dialogs::Export::PngExportDialog::finishExport);
+    connect(m_serviceContainer->applicationService().get(), &ApplicationService::pngExportProgressed, &pngExportDialog, &Dialogs::Export::PngExportDialog::setProgress);
 
     pngExportDialog.setCurrentMindMapFileName(m_serviceContainer->applicationService()->fileName());
-    pngExportDialog.setDefaultImageSize(m_serviceContainer->applicationService()->calculateExportImageSize());
+    for (auto && region : availableExportRegions()) {
+        pngExportDialog.addRegion(region, m_serviceContainer->applicationService()->calculateExportImageSize(region));
+    }
     pngExportDialog.exec();
 
     // Doesn't matter if canceled or not
@@ -435,6 +842,9 @@ void Application::showSvgExportDialog()
     connect(m_serviceContainer->applicationService().get(), &ApplicationService::svgExportFinished, &svgExportDialog, &Dialogs::Export::SvgExportDialog::finishExport);
 
     svgExportDialog.setCurrentMindMapFileName(m_serviceContainer->applicationService()->fileName());
+    for (auto && region : availableExportRegions()) {
+        svgExportDialog.addRegion(region);
+    }
     svgExportDialog.exec();
 
     // Doesn't matter if canceled or not
@@ -444,6 +854,17 @@ void Application::showSvgExportDialog()
 void Application::showLayoutOptimizationDialog()
 {
     LayoutOptimizer layoutOptimizer { m_serviceContainer->applicationService()->mindMapData(), m_editorView->grid() };
+    // Use the idle cores for parallel tempering
+    layoutOptimizer.setReplicaCount(std::min<size_t>(m_serviceContainer->taskPool()->threadCount(), Constants::LayoutOptimizer::maxReplicaCount()));
+    layoutOptimizer.setMultilevelThreshold(Constants::LayoutOptimizer::multilevelNodeCount());
+    layoutOptimizer.setInitialPlacement(LayoutOptimizer::InitialPlacement::Locality);
+    layoutOptimizer.setUseLayoutCache(true);
+    // Re-optimize only around the selection, if any, and keep the rest of the mind map as it is
+    std::vector<int> selectedNodeIndices;
+    for (auto && node : m_serviceContainer->applicationService()->selectedNodes()) {
+        selectedNodeIndices.push_back(node->index());
+    }
+    layoutOptimizer.setSubgraph(selectedNodeIndices, Constants::LayoutOptimizer::subgraphHopCount());
     Dialogs::LayoutOptimizationDialog dialog { *m_mainWindow, *m_serviceContainer->applicationService()->mindMapData(), layoutOptimizer, *m_editorView };
     connect(&dialog, &Dialogs::LayoutOptimizationDialog::undoPointRequested, m_serviceContainer->applicationService().get(), &ApplicationService::saveUndoPoint);
 
@@ -471,4 +892,15 @@ int Application::showNotSavedDialog()
     return msgBox.exec();
 }
 
-Application::~Application() = default;
+Application::~Application()
+{
+    // The background read of a download would otherwise keep waiting for data while the task pool is waited for
+    if (const auto reader = m_urlReader.lock()) {
+        reader->cancel(tr("Heimer is closing"));
+    }
+
+    Profiler::writeReport();
+    TraceRecorder::writeTrace();
+
+    Settings::Generic::flush();
+}
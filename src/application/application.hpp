@@ -17,19 +17,31 @@
 #define APPLICATION_HPP
 
 #include "../common/types.hpp"
+#include "../infra/export_params.hpp"
+#include "analysis_reporter.hpp"
+#include "batch_exporter.hpp"
+#include "diff_reporter.hpp"
+#include "info_reporter.hpp"
 #include "state_machine.hpp"
+#include "workspace_index.hpp"
 
 #include <QApplication>
 #include <QColor>
 #include <QObject>
 
+#include <chrono>
 #include <memory>
+#include <vector>
 
 class EditorView;
 class ImageManager;
 class MainWindow;
 class VersionChecker;
 
+namespace IO {
+class UrlReader;
+}
+
 class Application : public QObject
 {
     Q_OBJECT
@@ -54,16 +66,34 @@ signals:
 private:
     QStringList userLanguageOrAvailableSystemUiLanguages() const;
 
+    std::vector<ExportParams::Region> availableExportRegions() const;
+
     std::string buildAvailableLanguagesHelpString() const;
 
     void checkForNewReleases();
 
     void connectComponents();
 
-    void doOpenMindMap(QString fileName);
+    //! \param searchText Searched for once the mind map is open, e.g. to zoom to a workspace search hit.
+    void doOpenMindMap(QString fileName, QString searchText = {});
+
+    //! Downloads and parses the mind map in the background, so that the transfer and the parsing overlap.
+    void doOpenUrl(QString url);
 
     QString getFileDialogFileText() const;
 
+    QString getSaveFileDialogFileText() const;
+
+    QString getXmlFileDialogFileText() const;
+
+    QString getCompressedFileDialogFileText() const;
+
+    QString getBinaryFileDialogFileText() const;
+
+    QString getOpenFileDialogFileText() const;
+
+    QString getOutlineFileDialogFileText() const;
+
     void initializeTranslations();
 
     void instantiateComponents();
@@ -76,12 +106,18 @@ private:
 
     void openMindMap();
 
+    //! Shows a file dialog and opens the selected file in a new tab, or activates the tab where it's already open.
+    void openMindMapInNewTab();
+
     void saveMindMap();
 
     void saveMindMapAs();
 
     void showBackgroundColorDialog();
 
+    //! Shows a file dialog and marks the changes from the selected file to the mind map.
+    void showCompareDialog();
+
     void showEdgeColorDialog();
 
     void showGridColorDialog();
@@ -92,22 +128,43 @@ private:
 
     void showNodeColorDialog();
 
+    void showOpenUrlDialog();
+
+    void showPdfExportDialog();
+
     void showPngExportDialog();
 
+    //! Shows a file dialog and runs the selected JavaScript file against the mind map.
+    void showRunScriptDialog();
+
     void showSvgExportDialog();
 
     void showTextColorDialog();
 
+    void showWorkspaceSearchDialog();
+
+    //! Hosts or joins a collaboration session if requested on the command line.
+    void startSession();
+
     void showMessageBox(QString message);
 
     void initializeAndShowMainWindow();
 
+    //! Logs the time elapsed since the application was instantiated.
+    void logStartupPhase(const char * phase) const;
+
+    //! Logs the estimated memory usage per subsystem, see ApplicationService::memoryReport().
+    void logMemoryUsage() const;
+
     int showNotSavedDialog();
 
     void parseArgs(int argc, char ** argv);
 
     void updateProgress();
 
+    // Declared first so that it's initialized before QApplication
+    const std::chrono::steady_clock::time_point m_startupTime = std::chrono::steady_clock::now();
+
     QApplication m_application;
 
     MainWindowS m_mainWindow;
@@ -118,9 +175,43 @@ private:
 
     QString m_mindMapFile;
 
+    WorkspaceIndex::Hit m_workspaceSearchHit;
+
+    AnalysisReporter::Options m_analysisOptions;
+
+    BatchExporter::Options m_batchExportOptions;
+
+    DiffReporter::Options m_diffOptions;
+
+    InfoReporter::Options m_infoOptions;
+
+    struct SessionOptions
+    {
+        //! 0 if not hosting.
+        quint16 hostPort = 0;
+
+        //! HOST:PORT, empty if not joining.
+        QString joinAddress;
+
+        //! Generated by the host if empty.
+        QString secret;
+
+        //! The address that the host listens on, the loopback address if empty.
+        QString hostAddress;
+    };
+
+    SessionOptions m_sessionOptions;
+
     EditorView * m_editorView = nullptr;
 
-    VersionChecker * m_versionChecker;
+    //! Set by the debug and trace logging options.
+    bool m_isMemoryUsageLoggingEnabled = false;
+
+    //! Created only when the check is actually run, see checkForNewReleases().
+    VersionChecker * m_versionChecker = nullptr;
+
+    //! The download in progress, if any, so that it can be cancelled, see doOpenUrl().
+    std::weak_ptr<IO::UrlReader> m_urlReader;
 };
 
 #endif // APPLICATION_HPP
@@ -15,38 +15,65 @@
 
 #include "application_service.hpp"
 
+#include "../application/collaboration_session.hpp"
 #include "../application/editor_service.hpp"
+#include "../application/gui_job_scheduler.hpp"
+#include "../application/pdf_export_job.hpp"
+#include "../application/performance_profile.hpp"
+#include "../application/png_export_job.hpp"
 #include "../application/progress_manager.hpp"
+#include "../application/script_runner.hpp"
 #include "../application/service_container.hpp"
 #include "../application/settings_proxy.hpp"
+#include "../application/settings_snapshot.hpp"
+#include "../common/constants.hpp"
+#include "../common/profiler.hpp"
+#include "../common/trace_recorder.hpp"
 #include "../domain/graph.hpp"
+#include "../domain/image_decoder.hpp"
 #include "../domain/image_manager.hpp"
+#include "../domain/incremental_layout.hpp"
+#include "../domain/mind_map_diff.hpp"
 #include "../infra/export_params.hpp"
+#include "../infra/io/edit_operation.hpp"
 #include "../infra/io/file_exception.hpp"
+#include "../infra/memory_pressure_monitor.hpp"
 #include "../infra/settings.hpp"
 #include "../view/edge_action.hpp"
 #include "../view/editor_scene.hpp"
 #include "../view/editor_view.hpp"
+#include "../view/export_snapshot.hpp"
+#include "../view/layout_transition.hpp"
 #include "../view/magic_zoom.hpp"
 #include "../view/main_window.hpp"
 #include "../view/mouse_action.hpp"
 #include "../view/node_action.hpp"
+#include "../view/scene_items/edge_dot_animator.hpp"
+#include "../view/scene_items/level_of_detail.hpp"
 #include "../view/scene_items/node_handle.hpp"
+#include "../view/scene_items/selection_update_batch.hpp"
+#include "../view/scene_items/text_size_cache.hpp"
 #include "../view/shadow_effect_params.hpp"
+#include "../view/svg_writer.hpp"
 
 #include "simple_logger.hpp"
 
 #include <QApplication>
 #include <QClipboard>
+#include <QFile>
 #include <QFileInfo>
 #include <QGraphicsItem>
 #include <QGraphicsScene>
 #include <QImage>
 #include <QMimeData>
+#include <QPixmapCache>
 #include <QSizePolicy>
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <unordered_map>
+#include <utility>
 
 using juzzlin::L;
 
@@ -54,14 +81,46 @@ static const auto TAG = "ApplicationService";
 
 ApplicationService::ApplicationService(MainWindowS mainWindow)
   : m_editorService(std::make_unique<EditorService>())
+  , m_layoutTransition(std::make_unique<LayoutTransition>(Constants::View::layoutTransitionDuration(), Constants::View::layoutTransitionTickInterval()))
   , m_mainWindow(mainWindow)
-{
+  , m_settingsProxy(SC::instance().settingsProxy())
+  , m_guiJobScheduler(SC::instance().guiJobScheduler())
+  , m_cacheRegistry(SC::instance().cacheRegistry())
+  , m_memoryPressureMonitor(std::make_unique<MemoryPressureMonitor>(Constants::Cache::memoryPressurePollInterval(), Constants::Cache::lowMemoryRatio()))
+{
+    m_styleChangeTimer.setSingleShot(true);
+    m_styleChangeTimer.setInterval(Constants::View::styleChangeInterval());
+    connect(&m_styleChangeTimer, &QTimer::timeout, this, &ApplicationService::applyPendingStyleChange);
+
+    m_fileChangeTimer.setSingleShot(true);
+    m_fileChangeTimer.setInterval(Constants::Application::fileChangeDebounceDelay());
+    connect(&m_fileChangeTimer, &QTimer::timeout, this, &ApplicationService::reloadMindMap);
+    connect(&m_fileWatcher, &QFileSystemWatcher::fileChanged, &m_fileChangeTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+
+    m_backgroundTrimTimer.setSingleShot(true);
+    m_backgroundTrimTimer.setInterval(Constants::Cache::backgroundTrimDelay());
+    connect(&m_backgroundTrimTimer, &QTimer::timeout, this, [this] {
+        m_cacheRegistry->trim(CacheRegistry::TrimReason::Background);
+    });
+    connect(qApp, &QGuiApplication::applicationStateChanged, this, &ApplicationService::updateBackgroundState);
+    connect(m_mainWindow.get(), &MainWindow::minimizedChanged, this, [this](bool minimized) {
+        m_isMinimized = minimized;
+        updateBackgroundState();
+    });
+    connect(m_memoryPressureMonitor.get(), &MemoryPressureMonitor::memoryLow, this, [this] {
+        m_cacheRegistry->trim(CacheRegistry::TrimReason::MemoryPressure);
+    });
+    registerCaches();
+
     connect(m_mainWindow.get(), &MainWindow::arrowSizeChanged, this, &ApplicationService::setArrowSize);
     connect(m_mainWindow.get(), &MainWindow::autosaveEnabled, this, &ApplicationService::enableAutosave);
     connect(m_mainWindow.get(), &MainWindow::cornerRadiusChanged, this, &ApplicationService::setCornerRadius);
     connect(m_mainWindow.get(), &MainWindow::edgeWidthChanged, this, &ApplicationService::setEdgeWidth);
     connect(m_mainWindow.get(), &MainWindow::fontChanged, this, &ApplicationService::changeFont);
     connect(m_mainWindow.get(), &MainWindow::gridSizeChanged, this, &ApplicationService::setGridSize);
+    connect(m_mainWindow.get(), &MainWindow::hardwareAccelerationChanged, this, &ApplicationService::setHardwareAccelerationEnabled);
+    connect(m_mainWindow.get(), &MainWindow::historyPositionChanged, this, &ApplicationService::jumpToHistoryPosition);
+    connect(m_mainWindow.get(), &MainWindow::performanceProfileChanged, this, &ApplicationService::setPerformanceProfile);
     connect(m_mainWindow.get(), &MainWindow::searchTextChanged, this, &ApplicationService::setSearchText);
     connect(m_mainWindow.get(), &MainWindow::shadowEffectChanged, this, &ApplicationService::setShadowEffect);
     connect(m_mainWindow.get(), &MainWindow::textSizeChanged, this, &ApplicationService::setTextSize);
@@ -69,13 +128,179 @@ ApplicationService::ApplicationService(MainWindowS mainWindow)
     connect(m_mainWindow.get(), &MainWindow::zoomOutRequested, this, &ApplicationService::zoomOut);
     connect(m_mainWindow.get(), &MainWindow::zoomToFitRequested, this, &ApplicationService::zoomToFit);
 
+    connect(m_mainWindow.get(), &MainWindow::tabActivated, this, &ApplicationService::activateTab);
+
     connect(this, &ApplicationService::currentSearchTextRequested, m_mainWindow.get(), &MainWindow::requestCurrentSearchText);
 
+    m_tabs.push_back({ m_editorService, {} });
+
+    connectEditorService();
+}
+
+void ApplicationService::connectEditorService()
+{
     connect(m_editorService.get(), &EditorService::isModifiedChanged, m_mainWindow.get(), [=](bool isModified) {
         m_mainWindow->enableSave(isModified || canBeSaved());
+        updateTabs();
     });
     connect(m_editorService.get(), &EditorService::redoEnabled, this, &ApplicationService::enableRedo);
     connect(m_editorService.get(), &EditorService::undoEnabled, this, &ApplicationService::enableUndo);
+    connect(m_editorService.get(), &EditorService::historyChanged, m_mainWindow.get(), &MainWindow::setHistory);
+    connect(m_editorService.get(), &EditorService::mindMapDataReplaced, this, [this] {
+        if (m_collaborationSession) {
+            m_collaborationSession->setMindMapData(m_editorService->mindMapData());
+        }
+    });
+    connect(m_editorService.get(), &EditorService::autosaveFailed, m_mainWindow.get(), [this](QString fileName) {
+        m_mainWindow->showErrorDialog(tr("Autosave to '%1' failed. The changes are not saved yet.").arg(fileName));
+    });
+}
+
+bool ApplicationService::activateModifiedTab()
+{
+    for (size_t i = 0; i < m_tabs.size(); i++) {
+        if (m_tabs.at(i).editorService->isModified()) {
+            activateTab(static_cast<int>(i));
+            return i == m_activeTab;
+        }
+    }
+    return false;
+}
+
+bool ApplicationService::activateTabOfFile(QString fileName)
+{
+    const auto filePath = QFileInfo { fileName }.absoluteFilePath();
+    for (size_t i = 0; i < m_tabs.size(); i++) {
+        if (const auto tabFileName = m_tabs.at(i).editorService->fileName(); !tabFileName.isEmpty() && QFileInfo { tabFileName }.absoluteFilePath() == filePath) {
+            activateTab(static_cast<int>(i));
+            return i == m_activeTab;
+        }
+    }
+    return false;
+}
+
+void ApplicationService::activateTab(int index)
+{
+    if (index < 0 || static_cast<size_t>(index) >= m_tabs.size() || static_cast<size_t>(index) == m_activeTab) {
+        return;
+    }
+
+    if (m_collaborationSession && m_collaborationSession->isActive()) {
+        // The session shares the mind map of the active tab
+        showStatusText(tr("Tabs can't be changed during a collaboration session"));
+        updateTabs();
+        return;
+    }
+
+    L(TAG).info() << "Activating tab " << index;
+
+    deactivateTab();
+
+    showTab(static_cast<size_t>(index));
+}
+
+bool ApplicationService::addTab()
+{
+    if (m_collaborationSession && m_collaborationSession->isActive()) {
+        showStatusText(tr("Tabs can't be changed during a collaboration session"));
+        return false;
+    }
+
+    L(TAG).info() << "Adding tab " << m_tabs.size();
+
+    deactivateTab();
+
+    m_tabs.push_back({ std::make_shared<EditorService>(), {} });
+    m_activeTab = m_tabs.size() - 1;
+    m_editorService = m_tabs.back().editorService;
+
+    connectEditorService();
+
+    applyPerformancePolicy();
+
+    updateTabs();
+
+    return true;
+}
+
+void ApplicationService::closeTab()
+{
+    if (m_tabs.size() < 2) {
+        return;
+    }
+
+    L(TAG).info() << "Closing tab " << m_activeTab;
+
+    deactivateTab();
+
+    const auto closedTab = m_activeTab;
+    m_tabs.erase(m_tabs.begin() + static_cast<std::ptrdiff_t>(closedTab));
+
+    showTab(std::min(closedTab, m_tabs.size() - 1));
+}
+
+void ApplicationService::deactivateTab()
+{
+    m_layoutTransition->finish();
+
+    stopProgressiveLoad();
+
+    clearComparison();
+
+    m_fileChangeTimer.stop();
+
+    if (m_styleChangeTimer.isActive()) {
+        m_styleChangeTimer.stop();
+        applyPendingStyleChange();
+    }
+
+    saveViewport();
+
+    m_tabs.at(m_activeTab).viewport = currentViewport();
+
+    m_editorService->disconnect(this);
+    m_editorService->disconnect(m_mainWindow.get());
+    m_editorService->releaseSceneItems();
+}
+
+void ApplicationService::showTab(size_t index)
+{
+    m_activeTab = index;
+    m_editorService = m_tabs.at(index).editorService;
+
+    connectEditorService();
+
+    applyPerformancePolicy();
+
+    showMindMap(std::exchange(m_tabs.at(index).viewport, std::nullopt));
+
+    watchFile();
+
+    m_mainWindow->enableUndo(isUndoable());
+    m_mainWindow->enableRedo(isRedoable());
+    m_mainWindow->setHistory(historyPosition(), historyLength());
+    m_mainWindow->enableSave(isModified() || canBeSaved());
+
+    updateTabs();
+}
+
+size_t ApplicationService::tabCount() const
+{
+    return m_tabs.size();
+}
+
+void ApplicationService::updateTabs()
+{
+    QStringList titles;
+    for (auto && tab : m_tabs) {
+        const auto fileName = tab.editorService->fileName();
+        auto title = fileName.isEmpty() ? tr("New File") : QFileInfo { fileName }.fileName();
+        if (tab.editorService->isModified()) {
+            title += "*";
+        }
+        titles << title;
+    }
+    m_mainWindow->setTabs(titles, static_cast<int>(m_activeTab));
 }
 
 void ApplicationService::setPropertiesOfAddedEdge(EdgeR edge)
@@ -106,8 +331,8 @@ void ApplicationService::addExistingEdgesToScene()
 {
     L(TAG).debug() << "Adding existing edges to scene";
 
-    for (auto && edge : m_editorService->mindMapData()->graph().getEdges()) {
-        if (!isEdgeAddedToEditorScene(*edge)) {
+    for (auto && edge : m_editorService->mindMapData()->graph().edges()) {
+        if (!isEdgeAddedToEditorScene(*edge) && isMaterialized(*edge)) {
             addItemToEditorScene(*edge, false);
             setPropertiesOfAddedEdge(*edge);
             linkAddedEdgeToExistingNodes(*edge);
@@ -130,13 +355,13 @@ bool ApplicationService::isNodeAddedToEditorScene(NodeR node) const
     return node.scene() == m_editorScene.get();
 }
 
-void ApplicationService::addExistingNodesToScene()
+void ApplicationService::addExistingNodesToScene(bool adjustSceneRect)
 {
     L(TAG).debug() << "Adding existing nodes to scene";
 
-    for (auto && node : m_editorService->mindMapData()->graph().getNodes()) {
-        if (!isNodeAddedToEditorScene(*node)) {
-            addItemToEditorScene(*node);
+    for (auto && node : m_editorService->mindMapData()->graph().nodes()) {
+        if (!isNodeAddedToEditorScene(*node) && isMaterialized(*node)) {
+            addItemToEditorScene(*node, adjustSceneRect);
             setPropertiesOfAddedNode(*node);
             L(TAG).trace() << "Added existing node id=" << node->index() << " to scene";
         }
@@ -176,9 +401,44 @@ void ApplicationService::setMindMapProperties()
     m_mainWindow->enableWidgetSignals(true);
 }
 
+size_t ApplicationService::countItemsNotInEditorScene() const
+{
+    size_t count = 0;
+    const auto & graph = m_editorService->mindMapData()->graph();
+    for (auto && node : graph.nodes()) {
+        count += !isNodeAddedToEditorScene(*node);
+    }
+    for (auto && edge : graph.edges()) {
+        count += !isEdgeAddedToEditorScene(*edge);
+    }
+    return count;
+}
+
 void ApplicationService::addExistingGraphToScene(bool zoomToFitAfterNodesLoaded)
 {
-    addExistingNodesToScene();
+    const TraceRecorder::ScopedSpan span { "ApplicationService::addExistingGraphToScene" };
+
+    stopProgressiveLoad();
+
+    updateVirtualizationEnabled();
+
+    // Removes the folded subtrees that are already in the scene, e.g. after undo
+    if (updateHiddenNodes()) {
+        materializeItems();
+    }
+
+    // E.g. when opening a mind map, insert everything without updating the scene index and rect per item
+    const bool isBulkInsert = countItemsNotInEditorScene() >= Constants::View::bulkInsertThreshold();
+    if (isBulkInsert) {
+        L(TAG).debug() << "Bulk inserting items to scene";
+        m_editorScene->beginBulkInsert();
+    }
+
+    addExistingNodesToScene(!isBulkInsert);
+
+    if (isBulkInsert) {
+        m_editorScene->endBulkInsert();
+    }
 
     if (zoomToFitAfterNodesLoaded) {
         zoomToFit();
@@ -186,27 +446,372 @@ void ApplicationService::addExistingGraphToScene(bool zoomToFitAfterNodesLoaded)
 
     updateProgress();
 
+    if (isBulkInsert) {
+        m_editorScene->beginBulkInsert();
+    }
+
     addExistingEdgesToScene();
 
+    if (isBulkInsert) {
+        m_editorScene->endBulkInsert();
+    }
+
     updateProgress();
 
+    updateEdgeAnimationsEnabled();
+
     setMindMapProperties();
 }
 
+void ApplicationService::beginProgressiveLoad(QRectF priorityRect, bool zoomToFitAfterLoaded)
+{
+    const auto & graph = m_editorService->mindMapData()->graph();
+    L(TAG).debug() << "Progressively adding " << graph.nodeCount() << " nodes and " << graph.edgeCount() << " edges to scene";
+
+    // The scene index is rebuilt once when everything has been added
+    m_editorScene->beginBulkInsert();
+    m_isProgressiveLoadActive = true;
+    m_isZoomToFitAfterProgressiveLoadPending = zoomToFitAfterLoaded;
+    m_progressiveLoadPosition = 0;
+
+    m_progressiveLoadPriorityNodes.clear();
+    if (!priorityRect.isNull()) {
+        for (auto && node : graph.nodes()) {
+            if (priorityRect.contains(node->location())) {
+                m_progressiveLoadPriorityNodes.push_back(node->index());
+            }
+        }
+        L(TAG).debug() << "Adding " << m_progressiveLoadPriorityNodes.size() << " nodes in the priority rect first";
+    }
+
+    updateEdgeAnimationsEnabled();
+
+    updateVirtualizationEnabled();
+
+    updateHiddenNodes();
+
+    setMindMapProperties();
+
+    addNextProgressiveLoadChunk();
+
+    // The rest of the chunks are added in time slices between the input events and repaints
+    if (m_isProgressiveLoadActive) {
+        m_progressiveLoadJob = m_guiJobScheduler->schedule([this] {
+            addNextProgressiveLoadChunk();
+            return !m_isProgressiveLoadActive;
+        });
+    }
+}
+
+void ApplicationService::addNextProgressiveLoadChunk()
+{
+    // The graph is read again for each chunk, because it may have been edited in between
+    const auto & graph = m_editorService->mindMapData()->graph();
+    const auto & nodes = graph.nodes();
+    const auto priorityCount = m_progressiveLoadPriorityNodes.size();
+    const auto endPosition = 2 * priorityCount + 2 * nodes.size();
+    size_t addedCount = 0;
+
+    const auto addNode = [&](NodeR node) {
+        if (!isNodeAddedToEditorScene(node) && isMaterialized(node)) {
+            addItemToEditorScene(node, false);
+            setPropertiesOfAddedNode(node);
+            addedCount++;
+        }
+    };
+
+    const auto addEdgesFromNode = [&](int index, bool onlyToAddedNodes) {
+        for (auto && edge : graph.edgesFromNode(index)) {
+            if (!isEdgeAddedToEditorScene(*edge) && isMaterialized(*edge) && (!onlyToAddedNodes || isNodeAddedToEditorScene(edge->targetNode()))) {
+                addItemToEditorScene(*edge, false);
+                setPropertiesOfAddedEdge(*edge);
+                linkAddedEdgeToExistingNodes(*edge);
+                addedCount++;
+            }
+        }
+    };
+
+    while (addedCount < Constants::View::progressiveLoadChunkSize() && m_progressiveLoadPosition < endPosition) {
+        if (const auto position = m_progressiveLoadPosition++; position < 2 * priorityCount) {
+            // The priority nodes may have been deleted in between
+            if (const auto index = m_progressiveLoadPriorityNodes.at(position % priorityCount); graph.hasNode(index)) {
+                if (position < priorityCount) {
+                    addNode(*graph.getNode(index));
+                } else {
+                    addEdgesFromNode(index, true);
+                }
+            }
+        } else if (const auto slot = position - 2 * priorityCount; slot < nodes.size()) {
+            addNode(*nodes.at(slot));
+        } else {
+            addEdgesFromNode(nodes.at(slot - nodes.size())->index(), false);
+        }
+    }
+
+    if (m_progressiveLoadPosition >= endPosition) {
+        L(TAG).debug() << "Progressive load finished";
+        m_progressiveLoadPriorityNodes.clear();
+        // Picks up anything that was skipped because of edits during the load
+        addExistingGraphToScene(m_isZoomToFitAfterProgressiveLoadPending);
+    } else {
+        m_editorScene->adjustSceneRect();
+    }
+}
+
+void ApplicationService::stopProgressiveLoad()
+{
+    m_isZoomToFitAfterProgressiveLoadPending = false;
+    if (m_isProgressiveLoadActive) {
+        m_isProgressiveLoadActive = false;
+        m_guiJobScheduler->cancel(m_progressiveLoadJob);
+        if (m_editorScene) {
+            m_editorScene->endBulkInsert();
+        }
+    }
+}
+
+void ApplicationService::addNewItemsToScene(const std::vector<NodeS> & nodes, const std::vector<EdgeS> & edges)
+{
+    const bool isBulkInsert = nodes.size() + edges.size() >= Constants::View::bulkInsertThreshold();
+    if (isBulkInsert) {
+        L(TAG).debug() << "Bulk inserting " << nodes.size() << " nodes and " << edges.size() << " edges to scene";
+        m_editorScene->beginBulkInsert();
+    }
+
+    for (auto && node : nodes) {
+        addItemToEditorScene(*node, false);
+        setPropertiesOfAddedNode(*node);
+    }
+
+    for (auto && edge : edges) {
+        addItemToEditorScene(*edge, false);
+        setPropertiesOfAddedEdge(*edge);
+        linkAddedEdgeToExistingNodes(*edge);
+    }
+
+    if (isBulkInsert) {
+        m_editorScene->endBulkInsert();
+    } else {
+        adjustEditorSceneRect();
+    }
+
+    updateEdgeAnimationsEnabled();
+}
+
+void ApplicationService::adjustEditorSceneRect()
+{
+    if (m_editorService->isInTransaction()) {
+        m_isSceneRectAdjustmentPending = true;
+    } else {
+        m_editorScene->adjustSceneRect();
+    }
+}
+
+void ApplicationService::updateEdgeAnimationsEnabled()
+{
+    updatePerformanceTier();
+
+    if (const bool enabled = m_performanceProfile.policy().edgeAnimations; SceneItems::EdgeDotAnimator::enabled() != enabled) {
+        L(TAG).info() << "Edge animations " << (enabled ? "enabled" : "disabled");
+        SceneItems::EdgeDotAnimator::setEnabled(enabled);
+    }
+}
+
+bool ApplicationService::updateVirtualizationEnabled()
+{
+    updatePerformanceTier();
+
+    if (const bool enabled = m_performanceProfile.policy().virtualization; m_isVirtualizationEnabled != enabled) {
+        L(TAG).info() << "Virtualization " << (enabled ? "enabled" : "disabled");
+        m_isVirtualizationEnabled = enabled;
+        // Everything belongs to the scene until the view reports its rect
+        m_materializedRect = {};
+        return true;
+    }
+
+    return false;
+}
+
+void ApplicationService::updatePerformanceTier()
+{
+    const auto & graph = m_editorService->mindMapData()->graph();
+    if (const auto itemCount = graph.nodeCount() + graph.edgeCount(); m_performanceProfile.setItemCount(itemCount)) {
+        L(TAG).info() << "Performance tier " << PerformanceProfile::tierName(m_performanceProfile.tier()) << " for " << itemCount << " items";
+        applyPerformancePolicy();
+    }
+}
+
+void ApplicationService::applyPerformancePolicy()
+{
+    const auto policy = m_performanceProfile.policy();
+
+    LevelOfDetail::setThresholds(policy.reducedLevelOfDetail, policy.minimalLevelOfDetail);
+
+    m_editorService->setUndoMemoryBudget(static_cast<size_t>(std::max(0, m_settingsProxy->undoMemoryBudgetMiB())) * 1024 * 1024 * policy.undoMemoryBudgetFactor);
+
+    if (m_editorView) {
+        m_editorView->setShadowsEnabled(policy.shadows);
+        m_editorView->setHardwareAccelerationEnabled(m_settingsProxy->hardwareAcceleration() || policy.hardwareAcceleration);
+        m_editorView->viewport()->update();
+    }
+}
+
+void ApplicationService::applyPerformanceTier()
+{
+    L(TAG).info() << "Performance tier " << PerformanceProfile::tierName(m_performanceProfile.tier());
+
+    applyPerformancePolicy();
+
+    if (!m_editorService->mindMapData() || !m_editorScene) {
+        return;
+    }
+
+    updateEdgeAnimationsEnabled();
+
+    // A progressive load materializes the items when it's finished
+    if (updateVirtualizationEnabled() && !m_isProgressiveLoadActive) {
+        if (m_isVirtualizationEnabled) {
+            updateVirtualization(m_editorView->mapToScene(m_editorView->viewport()->rect()).boundingRect());
+        } else {
+            materializeItems();
+        }
+    }
+}
+
+bool ApplicationService::isMaterialized(NodeR node) const
+{
+    if (m_hiddenNodeIndices.count(node.index())) {
+        return false;
+    }
+
+    // Selected nodes stay so that e.g. dragging the selection keeps working
+    return !m_isVirtualizationEnabled || m_materializedRect.isNull() || node.selected() || node.sceneBoundingRect().intersects(m_materializedRect);
+}
+
+bool ApplicationService::isMaterialized(EdgeR edge) const
+{
+    if (m_hiddenNodeIndices.count(edge.sourceNode().index()) || m_hiddenNodeIndices.count(edge.targetNode().index())) {
+        return false;
+    }
+
+    // A long edge can cross the viewport even if both of its nodes are far away
+    return !m_isVirtualizationEnabled || m_materializedRect.isNull() || edge.selected() || isMaterialized(edge.sourceNode()) || isMaterialized(edge.targetNode())
+      || QRectF { edge.sourceNode().location(), edge.targetNode().location() }.normalized().intersects(m_materializedRect);
+}
+
+void ApplicationService::materializeItems()
+{
+    const auto & graph = m_editorService->mindMapData()->graph();
+    std::vector<NodeP> addedNodes;
+    std::vector<NodeP> removedNodes;
+    for (auto && node : graph.nodes()) {
+        if (const bool inScene = isNodeAddedToEditorScene(*node); inScene != isMaterialized(*node)) {
+            (inScene ? removedNodes : addedNodes).push_back(node.get());
+        }
+    }
+
+    std::vector<EdgeP> addedEdges;
+    std::vector<EdgeP> removedEdges;
+    for (auto && edge : graph.edges()) {
+        if (const bool inScene = isEdgeAddedToEditorScene(*edge); inScene != isMaterialized(*edge)) {
+            (inScene ? removedEdges : addedEdges).push_back(edge.get());
+        }
+    }
+
+    const auto changeCount = addedNodes.size() + removedNodes.size() + addedEdges.size() + removedEdges.size();
+    if (!changeCount) {
+        return;
+    }
+
+    L(TAG).debug() << "Virtualization: adding " << addedNodes.size() << " nodes and " << addedEdges.size() << " edges, removing " //
+                   << removedNodes.size() << " nodes and " << removedEdges.size() << " edges";
+
+    const bool isBulkInsert = changeCount >= Constants::View::bulkInsertThreshold();
+    if (isBulkInsert) {
+        m_editorScene->beginBulkInsert();
+    }
+
+    // The removed edges are unlinked so that moving their nodes doesn't update them and re-adding doesn't link them twice
+    for (auto && edge : removedEdges) {
+        edge->sourceNode().removeGraphicsEdge(*edge);
+        edge->targetNode().removeGraphicsEdge(*edge);
+        edge->removeFromScene();
+    }
+
+    for (auto && node : removedNodes) {
+        node->removeFromScene();
+    }
+
+    for (auto && node : addedNodes) {
+        addItemToEditorScene(*node, false);
+        setPropertiesOfAddedNode(*node);
+        node->show();
+    }
+
+    for (auto && edge : addedEdges) {
+        addItemToEditorScene(*edge, false);
+        setPropertiesOfAddedEdge(*edge);
+        linkAddedEdgeToExistingNodes(*edge);
+        edge->show();
+    }
+
+    if (isBulkInsert) {
+        m_editorScene->endBulkInsert();
+    } else {
+        m_editorScene->adjustSceneRect();
+    }
+}
+
+bool ApplicationService::updateHiddenNodes()
+{
+    const auto & graph = m_editorService->mindMapData()->graph();
+    std::unordered_set<int> hiddenNodeIndices;
+    for (auto && node : graph.nodes()) {
+        if (node->collapsed()) {
+            const auto descendantIndices = graph.descendantIndices(node->index());
+            node->setHiddenDescendantCount(descendantIndices.size());
+            hiddenNodeIndices.insert(descendantIndices.begin(), descendantIndices.end());
+        }
+    }
+
+    if (hiddenNodeIndices == m_hiddenNodeIndices) {
+        return false;
+    }
+
+    L(TAG).debug() << "Hiding " << hiddenNodeIndices.size() << " nodes of collapsed branches";
+    m_hiddenNodeIndices = std::move(hiddenNodeIndices);
+    return true;
+}
+
 void ApplicationService::addEdge(NodeR node1, NodeR node2)
 {
     // Add edge from node1 to node2
-    connectEdgeToUndoMechanism(m_editorService->addEdge(std::make_shared<SceneItems::Edge>(&node1, &node2)));
+    m_editorService->addEdge(std::make_shared<SceneItems::Edge>(&node1, &node2));
     L(TAG).debug() << "Created a new edge " << node1.index() << " -> " << node2.index();
 
     addExistingGraphToScene();
 }
 
+std::vector<EdgeS> ApplicationService::addEdges(const GraphSnapshot::EdgeDataVector & edges)
+{
+    const auto newEdges = m_editorService->addEdges(edges);
+    addNewItemsToScene({}, newEdges);
+    return newEdges;
+}
+
+std::vector<NodeS> ApplicationService::addNodes(const GraphSnapshot::NodeDataVector & models)
+{
+    const auto nodes = m_editorService->addNodes(models);
+    addNewItemsToScene(nodes, {});
+    return nodes;
+}
+
 void ApplicationService::addItemToEditorScene(QGraphicsItem & item, bool adjustSceneRect)
 {
     m_editorScene->addItem(&item);
+    m_editorScene->includeInNodeBounds(item);
     if (adjustSceneRect) {
-        this->adjustSceneRect();
+        adjustEditorSceneRect();
     }
 }
 
@@ -223,9 +828,76 @@ void ApplicationService::addNodeToSelectionGroup(NodeR node, bool isImplicit)
 
 void ApplicationService::adjustSceneRect()
 {
+    if (m_editorService->isInTransaction()) {
+        m_isNodeBoundsInvalidationPending = true;
+        m_isSceneRectAdjustmentPending = true;
+        return;
+    }
+
+    // Nodes may have been moved arbitrarily, so the cached bounds can't be trusted
+    m_editorScene->invalidateNodeBounds();
     m_editorScene->adjustSceneRect();
 }
 
+void ApplicationService::applyLayout(const std::function<void()> & changeLayout)
+{
+    m_layoutTransition->finish();
+
+    const auto nodes = m_editorService->mindMapData()->graph().getNodes();
+    std::vector<QPointF> startLocations;
+    startLocations.reserve(nodes.size());
+    for (auto && node : nodes) {
+        startLocations.push_back(node->location());
+    }
+
+    changeLayout();
+
+    m_layoutTransition->start(*m_editorScene, nodes, startLocations);
+}
+
+void ApplicationService::beginTransaction()
+{
+    m_layoutTransition->finish();
+
+    m_editorService->beginTransaction();
+}
+
+void ApplicationService::commitTransaction()
+{
+    if (!m_editorService->commitTransaction()) {
+        return;
+    }
+
+    if (std::exchange(m_isNodeBoundsInvalidationPending, false)) {
+        m_editorScene->invalidateNodeBounds();
+    }
+
+    if (std::exchange(m_isSceneRectAdjustmentPending, false)) {
+        m_editorScene->adjustSceneRect();
+    }
+
+    if (std::exchange(m_isNodeConnectionActionsUpdatePending, false)) {
+        updateNodeConnectionActions();
+    }
+}
+
+void ApplicationService::clearComparison()
+{
+    for (auto && weakEdge : m_markedEdges) {
+        if (const auto edge = weakEdge.lock()) {
+            edge->setMarkColor({});
+        }
+    }
+    m_markedEdges.clear();
+
+    for (auto && weakNode : m_markedNodes) {
+        if (const auto node = weakNode.lock()) {
+            node->setMarkColor({});
+        }
+    }
+    m_markedNodes.clear();
+}
+
 void ApplicationService::clearEdgeSelectionGroup(bool implicitOnly)
 {
     m_editorService->clearEdgeSelectionGroup(implicitOnly);
@@ -242,55 +914,100 @@ bool ApplicationService::canBeSaved() const
     return !m_editorService->fileName().isEmpty();
 }
 
-void ApplicationService::connectEdgeToUndoMechanism(EdgeS edge)
+void ApplicationService::createEditorScene()
 {
-    connect(edge.get(), &SceneItems::Edge::undoPointRequested, this, &ApplicationService::saveUndoPoint, Qt::UniqueConnection);
-}
+    m_layoutTransition->finish();
 
-void ApplicationService::connectNodeToUndoMechanism(NodeS node)
-{
-    connect(node.get(), &SceneItems::Node::undoPointRequested, this, &ApplicationService::saveUndoPoint, Qt::UniqueConnection);
-}
+    m_editorScene = std::make_unique<EditorScene>();
 
-void ApplicationService::connectNodeToImageManager(NodeS node)
-{
-    connect(node.get(), &SceneItems::Node::imageRequested, &m_editorService->mindMapData()->imageManager(), &ImageManager::handleImageRequest, Qt::UniqueConnection);
-    node->setImageRef(node->imageRef()); // This effectively results in a fetch from ImageManager
+    // One handler each for all the items instead of connecting every node and edge on each load and undo
+    m_editorScene->setUndoPointHandler([this](const QGraphicsItem & item) {
+        m_editorService->saveCoalescedUndoPoint(EditorService::UndoCoalescing::EditText, &item);
+    });
+    m_editorScene->setTextEditHandler([this] {
+        m_editorService->notifyModification();
+    });
+    m_editorScene->setImageHandler([this](size_t imageRef, NodeR node) {
+        m_editorService->mindMapData()->imageManager().handleImageRequest(imageRef, node);
+    });
 }
 
-size_t ApplicationService::copyStackSize() const
+bool ApplicationService::compareWithFile(QString fileName)
 {
-    return m_editorService->copyStackSize();
-}
+    L(TAG).info() << "Comparing with '" << fileName.toStdString() << "'";
 
-void ApplicationService::connectGraphToUndoMechanism()
-{
-    for (auto && node : m_editorService->mindMapData()->graph().getNodes()) {
-        connectNodeToUndoMechanism(node);
-    }
+    try {
+        const auto diff = m_editorService->diffWithFile(fileName);
+
+        clearComparison();
+
+        const auto markColor = [](MindMapDiff::Change change) -> QColor {
+            switch (change) {
+            case MindMapDiff::Change::Added:
+                return Constants::View::diffAddedColor();
+            case MindMapDiff::Change::Moved:
+                return Constants::View::diffMovedColor();
+            case MindMapDiff::Change::Edited:
+                return Constants::View::diffEditedColor();
+            case MindMapDiff::Change::Removed:
+                break;
+            }
+            return {};
+        };
+
+        auto && graph = m_editorService->mindMapData()->graph();
+        for (auto && nodeChange : diff.nodeChanges()) {
+            if (nodeChange.change != MindMapDiff::Change::Removed) {
+                const auto node = graph.getNode(nodeChange.newIndex);
+                node->setMarkColor(markColor(nodeChange.change));
+                m_markedNodes.push_back(node);
+            }
+        }
+        for (auto && edgeChange : diff.edgeChanges()) {
+            if (edgeChange.change != MindMapDiff::Change::Removed) {
+                if (const auto edge = graph.getEdge(edgeChange.sourceIndex, edgeChange.targetIndex)) {
+                    edge->setMarkColor(markColor(edgeChange.change));
+                    m_markedEdges.push_back(edge);
+                }
+            }
+        }
 
-    for (auto && edge : m_editorService->mindMapData()->graph().getEdges()) {
-        connectEdgeToUndoMechanism(edge);
+        using Change = MindMapDiff::Change;
+        if (diff.isEmpty()) {
+            showStatusText(tr("No differences"));
+        } else {
+            showStatusText(tr("Nodes: %1 added, %2 removed, %3 moved, %4 edited. Edges: %5 added, %6 removed, %7 edited.")
+                             .arg(diff.nodeCount(Change::Added))
+                             .arg(diff.nodeCount(Change::Removed))
+                             .arg(diff.nodeCount(Change::Moved))
+                             .arg(diff.nodeCount(Change::Edited))
+                             .arg(diff.edgeCount(Change::Added))
+                             .arg(diff.edgeCount(Change::Removed))
+                             .arg(diff.edgeCount(Change::Edited)));
+        }
+    } catch (const IO::FileException & e) {
+        m_mainWindow->showErrorDialog(e.message());
+        return false;
     }
+
+    return true;
 }
 
-void ApplicationService::connectGraphToImageManager()
+size_t ApplicationService::copyStackSize() const
 {
-    for (auto && node : m_editorService->mindMapData()->graph().getNodes()) {
-        connectNodeToImageManager(node);
-    }
+    return m_editorService->copyStackSize();
 }
 
 void ApplicationService::connectSelectedNodes()
 {
     L(TAG).debug() << "Connecting selected nodes: " << m_editorService->nodeSelectionGroupSize();
     if (areSelectedNodesConnectable()) {
+        beginTransaction();
         saveUndoPoint();
-        for (auto && edge : m_editorService->connectSelectedNodes()) {
-            connectEdgeToUndoMechanism(edge);
-        }
+        m_editorService->connectSelectedNodes();
         addExistingGraphToScene();
         updateNodeConnectionActions();
+        commitTransaction();
     }
 }
 
@@ -298,9 +1015,11 @@ void ApplicationService::disconnectSelectedNodes()
 {
     L(TAG).debug() << "Disconnecting selected nodes: " << m_editorService->nodeSelectionGroupSize();
     if (areSelectedNodesDisconnectable()) {
+        beginTransaction();
         saveUndoPoint();
         m_editorService->disconnectSelectedNodes();
         updateNodeConnectionActions();
+        commitTransaction();
     }
 }
 
@@ -314,12 +1033,12 @@ NodeS ApplicationService::createAndAddNode(int sourceNodeIndex, QPointF pos)
 {
     const auto node0 = getNodeByIndex(sourceNodeIndex);
     const auto node1 = m_mainWindow->copyOnDragEnabled() ? m_editorService->copyNodeAt(*node0, pos) : m_editorService->addNodeAt(pos);
-    connectNodeToUndoMechanism(node1);
-    connectNodeToImageManager(node1);
-    L(TAG).debug() << "Created a new node at (" << pos.x() << "," << pos.y() << ")";
+    // Dropped on top of other nodes, the new node is moved next to them instead of re-optimizing the layout
+    node1->setLocation(pos + findFreeOffset(node1->placementBoundingRect().translated(pos), node0->location(), node1->index()));
+    L(TAG).debug() << "Created a new node at (" << node1->location().x() << "," << node1->location().y() << ")";
 
     // Add edge from the parent node.
-    connectEdgeToUndoMechanism(m_editorService->addEdge(std::make_shared<SceneItems::Edge>(node0.get(), node1.get())));
+    m_editorService->addEdge(std::make_shared<SceneItems::Edge>(node0.get(), node1.get()));
     L(TAG).debug() << "Created a new edge " << node0->index() << " -> " << node1->index();
 
     addExistingGraphToScene();
@@ -333,8 +1052,6 @@ NodeS ApplicationService::createAndAddNode(int sourceNodeIndex, QPointF pos)
 NodeS ApplicationService::createAndAddNode(QPointF pos)
 {
     const auto node1 = m_editorService->addNodeAt(m_editorView->grid().snapToGrid(pos));
-    connectNodeToUndoMechanism(node1);
-    connectNodeToImageManager(node1);
     L(TAG).debug() << "Created a new node at (" << pos.x() << "," << pos.y() << ")";
 
     addExistingGraphToScene();
@@ -346,13 +1063,70 @@ NodeS ApplicationService::createAndAddNode(QPointF pos)
     return node1;
 }
 
-NodeS ApplicationService::pasteNodeAt(NodeR source, QPointF pos)
+QPointF ApplicationService::findFreeOffset(const QRectF & rect, std::optional<QPointF> parentLocation, int ignoredNodeIndex) const
+{
+    const IncrementalLayout incrementalLayout { m_editorService->mindMapData()->graph().nodeSpatialIndex(), static_cast<double>(m_editorView->grid().size()), Constants::Node::placementSpacing() };
+    return incrementalLayout.findFreeOffset(rect, parentLocation, ignoredNodeIndex);
+}
+
+std::vector<NodeP> ApplicationService::visibleNodesInRect(const QRectF & rect, bool contained) const
+{
+    auto && graph = m_editorService->mindMapData()->graph();
+    auto && nodeSpatialIndex = graph.nodeSpatialIndex();
+    std::vector<NodeP> nodes;
+    for (auto && index : nodeSpatialIndex.keysInRect(rect)) {
+        if (!m_hiddenNodeIndices.count(index) && (!contained || rect.contains(nodeSpatialIndex.rect(index)))) {
+            nodes.push_back(graph.getNode(index).get());
+        }
+    }
+    return nodes;
+}
+
+std::optional<size_t> ApplicationService::addImageFromFile(QString fileName)
 {
-    const auto copiedNode = m_editorService->copyNodeAt(source, pos);
-    connectNodeToUndoMechanism(copiedNode);
-    connectNodeToImageManager(copiedNode);
-    L(TAG).debug() << "Pasted node at (" << pos.x() << "," << pos.y() << ")";
-    return copiedNode;
+    // Keep the original file contents so that saving doesn't need to re-encode the image
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        L(TAG).error() << "Cannot read image file '" << fileName.toStdString() << "'";
+        return {};
+    }
+
+    // Decoding and downscaling run on the thread pool, the nodes show a placeholder until they are done
+    return m_editorService->mindMapData()->imageManager().addImage(Image::fromEncodedData(file.readAll(), fileName.toStdString()));
+}
+
+void ApplicationService::attachDroppedImages(const QStringList & fileNames, QPointF pos)
+{
+    const auto nodesAtPos = m_editorScene->nodesInRect({ pos, QSizeF { 1, 1 } });
+    std::vector<size_t> ids;
+    for (auto && fileName : fileNames) {
+        if (const auto id = addImageFromFile(fileName); id.has_value()) {
+            ids.push_back(*id);
+        }
+    }
+
+    if (ids.empty()) {
+        return;
+    }
+
+    beginTransaction();
+    saveUndoPoint();
+
+    auto idIter = ids.begin();
+    if (!nodesAtPos.empty()) {
+        nodesAtPos.front()->setImageRef(*idIter++);
+    }
+
+    // Place the new nodes side by side starting from the drop position
+    auto nodePos = m_editorView->grid().snapToGrid(pos);
+    for (; idIter != ids.end(); idIter++) {
+        const auto node = m_editorService->addNodeAt(nodePos);
+        node->setImageRef(*idIter);
+        nodePos.rx() += node->size().width() + Constants::Node::minWidth() / 2;
+    }
+
+    addExistingGraphToScene();
+    commitTransaction();
 }
 
 MouseAction & ApplicationService::mouseAction()
@@ -382,52 +1156,70 @@ void ApplicationService::enableRedo(bool enable)
     m_mainWindow->enableRedo(enable);
 }
 
-ApplicationService::GridLineVector ApplicationService::addGridForExport()
+std::shared_ptr<ExportSnapshot> ApplicationService::createExportSnapshot(ExportParams::Region region)
 {
-    GridLineVector addedLineItems;
-    if (Settings::Custom::loadGridVisibleState()) {
-        const auto gridLines = m_editorView->grid().calculateLines(m_editorScene->sceneRect());
-        const auto gridColor = SC::instance().applicationService()->mindMapData()->gridColor();
-        for (auto && gridLine : gridLines) {
-            addedLineItems.push_back(m_editorScene->addLine(gridLine, gridColor));
-        }
+    const auto grid = Settings::Custom::loadGridVisibleState() ? &m_editorView->grid() : nullptr;
+    const auto rect = calculateExportRegionRectangle(region);
+    const auto gridSize = grid ? grid->size() : -1;
+
+    auto && cache = m_exportSnapshotCache;
+    if (cache.snapshot && cache.modificationCount == m_editorService->modificationCount() && cache.region == region && cache.rect == rect && cache.gridSize == gridSize) {
+        L(TAG).debug() << "Reusing the export snapshot";
+        return cache.snapshot;
+    }
+
+    // Release the stale copy before making a new one
+    cache.snapshot.reset();
+    if (region == ExportParams::Region::MindMap) {
+        cache.snapshot = std::make_shared<ExportSnapshot>(*m_editorService->mindMapData(), grid);
+    } else {
+        // Copy only the items in the region so that the export time scales with the region instead of the mind map
+        cache.snapshot = std::make_shared<ExportSnapshot>(*m_editorService->mindMapData(), m_editorScene->graphSnapshotInRect(rect), rect, grid);
     }
-    return addedLineItems;
+    cache.modificationCount = m_editorService->modificationCount();
+    cache.region = region;
+    cache.rect = rect;
+    cache.gridSize = gridSize;
+
+    return cache.snapshot;
 }
 
-void ApplicationService::removeLineItems(const GridLineVector & lines)
+void ApplicationService::exportToPdf(const ExportParams & exportParams)
 {
-    for (auto && line : lines) {
-        m_editorScene->removeItem(line);
-    }
+    L(TAG).info() << "Exporting a PDF at scale " << exportParams.pageScale << " to " << exportParams.fileName.toStdString();
+
+    m_pdfExportJob = std::make_unique<PdfExportJob>(createExportSnapshot(exportParams.region), exportParams);
+    connect(m_pdfExportJob.get(), &PdfExportJob::progressed, this, &ApplicationService::pdfExportProgressed);
+    connect(m_pdfExportJob.get(), &PdfExportJob::finished, this, [this](bool success) {
+        L(TAG).info() << "PDF export " << (success ? "finished" : "failed");
+        m_pdfExportJob.release()->deleteLater();
+        emit pdfExportFinished(success);
+    });
+    m_pdfExportJob->start();
 }
 
 void ApplicationService::exportToPng(const ExportParams & exportParams)
 {
-    m_editorView->saveZoom();
-    zoomForExport();
-
     L(TAG).info() << "Exporting a PNG image of size (" << exportParams.imageSize.width() << "x" << exportParams.imageSize.height() << ") to " << exportParams.fileName.toStdString();
-    const auto lines = addGridForExport();
-    const auto image = m_editorScene->toImage(exportParams.imageSize, m_editorService->backgroundColor(), exportParams.transparentBackground);
-    m_editorView->restoreZoom();
-    removeLineItems(lines);
 
-    emit pngExportFinished(image.save(exportParams.fileName));
+    // Exporting a copy lets the editor stay responsive and untouched while the image is rendered
+    m_pngExportJob = std::make_unique<PngExportJob>(createExportSnapshot(exportParams.region), exportParams);
+    connect(m_pngExportJob.get(), &PngExportJob::progressed, this, &ApplicationService::pngExportProgressed);
+    connect(m_pngExportJob.get(), &PngExportJob::finished, this, [this](bool success) {
+        L(TAG).info() << "PNG export " << (success ? "finished" : "failed");
+        m_pngExportJob.release()->deleteLater();
+        emit pngExportFinished(success);
+    });
+    m_pngExportJob->start();
 }
 
 void ApplicationService::exportToSvg(const ExportParams & exportParams)
 {
-    m_editorView->saveZoom();
-    zoomForExport();
-
     L(TAG).info() << "Exporting an SVG image to " << exportParams.fileName.toStdString();
-    const auto lines = addGridForExport();
-    m_editorScene->toSvg(exportParams.fileName, QFileInfo { exportParams.fileName }.fileName());
-    m_editorView->restoreZoom();
-    removeLineItems(lines);
+    const auto snapshot = createExportSnapshot(exportParams.region);
+    const bool success = SvgWriter { snapshot->mindMapData(), SC::instance().settingsProxy()->shadowEffect() }.write(exportParams.fileName, QFileInfo { exportParams.fileName }.fileName(), snapshot->scene().sceneRect(), snapshot->gridLines());
 
-    emit svgExportFinished(true);
+    emit svgExportFinished(success);
 }
 
 QString ApplicationService::fileName() const
@@ -449,19 +1241,24 @@ void ApplicationService::initializeNewMindMap()
 {
     L(TAG).debug() << "Initializing a new mind map";
 
-    m_editorScene = std::make_unique<EditorScene>();
+    stopProgressiveLoad();
+    clearComparison();
+    saveViewport();
+    createEditorScene();
     m_editorService->initializeNewMindMap();
 
     initializeView();
 
-    const auto node = m_editorService->addNodeAt(QPointF(0, 0));
-    connectNodeToUndoMechanism(node);
-    connectNodeToImageManager(node);
+    m_editorService->addNodeAt(QPointF(0, 0));
 
     addExistingGraphToScene();
 
     QTimer::singleShot(0, this, &ApplicationService::zoomToFit);
 
+    watchFile();
+
+    updateTabs();
+
     m_mainWindow->initializeNewMindMap();
 }
 
@@ -482,8 +1279,10 @@ void ApplicationService::initiateNodeDrag(NodeR node)
 {
     L(TAG).debug() << "Initiating node drag";
 
-    saveUndoPoint();
+    // Consecutive drags of the same selection, or of the same node without a selection, make one undo point
+    m_editorService->saveCoalescedUndoPoint(EditorService::UndoCoalescing::MoveSelection, isInSelectionGroup(node) ? nullptr : &node);
     node.setZValue(node.zValue() + 1);
+    m_editorService->beginSelectionGroupMove();
     mouseAction().setSourceNode(&node, MouseAction::Action::MoveNode);
     mouseAction().setSourcePos(mouseAction().mappedPos());
     mouseAction().setSourcePosOnNode(mouseAction().mappedPos() - node.pos());
@@ -501,8 +1300,9 @@ void ApplicationService::initializeView()
     m_editorView->resetDummyDragItems();
 
     m_editorView->setBackgroundBrush(QBrush(m_editorService->backgroundColor()));
+    m_editorView->setMindMapData(m_editorService->mindMapData());
 
-    m_mainWindow->setCentralWidget(m_editorView);
+    m_mainWindow->setEditorView(*m_editorView);
     m_mainWindow->setContentsMargins(0, 0, 0, 0);
 }
 
@@ -527,13 +1327,18 @@ bool ApplicationService::areSelectedNodesDisconnectable() const
 bool ApplicationService::isLeafNode(NodeR node)
 {
     auto && graph = m_editorService->mindMapData()->graph();
-    return graph.getEdgesFromNode(graph.getNode(node.index())).size() + graph.getEdgesToNode(graph.getNode(node.index())).size() <= 1;
+    return graph.degree(node.index()) <= 1;
+}
+
+bool ApplicationService::isComparing() const
+{
+    return !m_markedNodes.empty() || !m_markedEdges.empty();
 }
 
 bool ApplicationService::isInBetween(NodeR node)
 {
     auto && graph = m_editorService->mindMapData()->graph();
-    return graph.getEdgesFromNode(graph.getNode(node.index())).size() + graph.getEdgesToNode(graph.getNode(node.index())).size() == 2;
+    return graph.degree(node.index()) == 2;
 }
 
 bool ApplicationService::isInSelectionGroup(NodeR node)
@@ -546,6 +1351,16 @@ bool ApplicationService::isRedoable() const
     return m_editorService->isRedoable();
 }
 
+size_t ApplicationService::historyPosition() const
+{
+    return m_editorService->historyPosition();
+}
+
+size_t ApplicationService::historyLength() const
+{
+    return m_editorService->historyLength();
+}
+
 bool ApplicationService::isModified() const
 {
     return m_editorService->isModified();
@@ -556,19 +1371,87 @@ bool ApplicationService::isUndoable() const
     return m_editorService->isUndoable();
 }
 
-void ApplicationService::mirror(bool vertically)
+void ApplicationService::mirror(bool vertically)
+{
+    applyLayout([=] {
+        m_editorService->mirror(vertically);
+    });
+}
+
+void ApplicationService::moveSelectionGroup(NodeR reference, QPointF location)
+{
+    m_editorService->moveSelectionGroup(reference, location);
+}
+
+MemoryReport ApplicationService::memoryReport() const
+{
+    auto report = m_editorService->memoryReport();
+    if (m_editorScene) {
+        report.entries.push_back({ tr("Scene items"), m_editorScene->memoryUsage() });
+    }
+    const auto cacheReport = m_cacheRegistry->memoryReport();
+    report.entries.insert(report.entries.end(), cacheReport.entries.begin(), cacheReport.entries.end());
+    report.reclaimed = cacheReport.reclaimed;
+    return report;
+}
+
+MindMapDataS ApplicationService::mindMapData() const
+{
+    return m_editorService->mindMapData();
+}
+
+bool ApplicationService::navigateAlongEdge(Graph::TraversalDirection direction)
 {
-    m_editorService->mirror(vertically);
+    const auto selectedNode = m_editorService->selectedNode();
+    if (!selectedNode.has_value()) {
+        return false;
+    }
+
+    const auto & graph = m_editorService->mindMapData()->graph();
+    const auto index = (*selectedNode)->index();
+    const bool toChild = direction == Graph::TraversalDirection::Descendants;
+    for (auto && edge : toChild ? graph.edgesFromNode(index) : graph.edgesToNode(index)) {
+        if (const auto node = toChild ? &edge->targetNode() : &edge->sourceNode(); !m_hiddenNodeIndices.count(node->index())) {
+            navigateToNode(*node);
+            return true;
+        }
+    }
+
+    return false;
 }
 
-void ApplicationService::moveSelectionGroup(NodeR reference, QPointF location)
+bool ApplicationService::navigateToNearestNode(QPointF direction)
 {
-    m_editorService->moveSelectionGroup(reference, location);
+    const auto selectedNode = m_editorService->selectedNode();
+    if (!selectedNode.has_value()) {
+        return false;
+    }
+
+    // The spatial index only visits the nodes around the selected node instead of all the nodes of the map
+    const auto & graph = m_editorService->mindMapData()->graph();
+    const auto index = (*selectedNode)->index();
+    const auto nearestIndex = graph.nodeSpatialIndex().nearestInDirection(graph.nodeSpatialIndex().rect(index).center(), direction, [this, index](int key) {
+        return key != index && !m_hiddenNodeIndices.count(key);
+    });
+    if (nearestIndex == -1) {
+        return false;
+    }
+
+    navigateToNode(*graph.getNode(nearestIndex));
+    return true;
 }
 
-MindMapDataS ApplicationService::mindMapData() const
+void ApplicationService::navigateToNode(NodeR node)
 {
-    return m_editorService->mindMapData();
+    {
+        const SceneItems::SelectionUpdateBatch selectionUpdateBatch;
+        m_editorService->clearNodeSelectionGroup();
+        m_editorService->addNodeToSelectionGroup(node);
+    }
+
+    updateNodeConnectionActions();
+
+    m_editorView->ensureVisible(node.sceneBoundingRect());
 }
 
 size_t ApplicationService::nodeCount() const
@@ -589,6 +1472,8 @@ QSizeF ApplicationService::normalizedSizeInView(const QRectF & rectInScene) cons
 
 void ApplicationService::paste()
 {
+    beginTransaction();
+
     // Create a new node from OS clipboard if text has been copied
 
     if (!QApplication::clipboard()->text().isEmpty()) {
@@ -607,30 +1492,74 @@ void ApplicationService::paste()
         node->setImageRef(id);
         m_editorService->clearCopyStack();
     } else { // Paste copied nodes
+        if (const auto mimeData = QApplication::clipboard()->mimeData(); mimeData && mimeData->hasFormat(Constants::Application::clipboardMimeType()) && !QApplication::clipboard()->ownsClipboard()) {
+            // Copied in another window or instance
+            m_editorService->deserializeCopiedData(mimeData->data(Constants::Application::clipboardMimeType()));
+        }
         if (m_editorService->copyStackSize()) {
             saveUndoPoint();
-            std::map<int, NodeS> nodeMapping;
-            juzzlin::L(TAG).debug() << "Pasting nodes";
-            for (auto && copiedNode : m_editorService->copiedData().nodes) {
-                const auto pastedNode = pasteNodeAt(*copiedNode, m_editorView->grid().snapToGrid(mouseAction().mappedPos() - m_editorService->copiedData().copyReferencePoint + copiedNode->pos()));
-                nodeMapping[copiedNode->index()] = pastedNode;
+            const auto imageMapping = m_editorService->addCopiedImages();
+            const auto & copiedData = m_editorService->copiedData();
+            juzzlin::L(TAG).debug() << "Pasting " << copiedData.nodes.size() << " nodes and " << copiedData.edges.size() << " edges";
+            auto models = copiedData.nodes;
+            for (auto && model : models) {
+                if (const auto imageIter = imageMapping.find(model.imageRef); imageIter != imageMapping.end()) {
+                    model.imageRef = imageIter->second;
+                }
+                model.location = m_editorView->grid().snapToGrid(mouseAction().mappedPos() - copiedData.copyReferencePoint + model.location);
+            }
+            // The pasted branch keeps its own layout and is moved as a whole to free space near the mouse
+            QRectF pastedRect;
+            for (auto && model : models) {
+                const auto size = model.size.isEmpty() ? QSizeF { static_cast<double>(Constants::Node::minWidth()), static_cast<double>(Constants::Node::minHeight()) } : model.size;
+                pastedRect |= QRectF { model.location - QPointF { size.width() / 2, size.height() / 2 }, size };
+            }
+            if (const auto offset = findFreeOffset(pastedRect); !offset.isNull()) {
+                for (auto && model : models) {
+                    model.location += offset;
+                }
+            }
+            // The pasted nodes get new indices, so the edges are mapped to them
+            const auto pastedNodes = addNodes(models);
+            std::unordered_map<int, int> indexMapping;
+            for (size_t i = 0; i < pastedNodes.size(); i++) {
+                indexMapping[copiedData.nodes.at(i).index] = pastedNodes.at(i)->index();
             }
-            juzzlin::L(TAG).debug() << "Pasting edges";
-            for (auto && copiedEdge : m_editorService->copiedData().edges) {
-                const auto pastedEdge = std::make_shared<SceneItems::Edge>(*copiedEdge.edge);
-                pastedEdge->setSourceNode(*nodeMapping[copiedEdge.sourceNodeIndex]);
-                pastedEdge->setTargetNode(*nodeMapping[copiedEdge.targetNodeIndex]);
-                connectEdgeToUndoMechanism(m_editorService->addEdge(pastedEdge));
+            auto edges = copiedData.edges;
+            for (auto && edgeData : edges) {
+                edgeData.sourceIndex = indexMapping.at(edgeData.sourceIndex);
+                edgeData.targetIndex = indexMapping.at(edgeData.targetIndex);
             }
-            addExistingGraphToScene();
+            addEdges(edges);
         }
     }
+
+    commitTransaction();
+}
+
+void ApplicationService::prepareForExit()
+{
+    L(TAG).debug() << "Preparing for exit";
+
+    m_layoutTransition->finish();
+
+    stopProgressiveLoad();
+
+    saveViewport();
+
+    m_isExiting = true;
+
+    for (auto && tab : m_tabs) {
+        tab.editorService->prepareForExit();
+    }
 }
 
 void ApplicationService::performEdgeAction(const EdgeAction & action)
 {
     juzzlin::L(TAG).debug() << "Handling EdgeAction: " << static_cast<int>(action.type());
 
+    beginTransaction();
+
     switch (action.type()) {
     case EdgeAction::Type::None:
         break;
@@ -639,21 +1568,24 @@ void ApplicationService::performEdgeAction(const EdgeAction & action)
         m_editorService->deleteSelectedEdges();
         break;
     }
+
+    commitTransaction();
 }
 
 void ApplicationService::performNodeAction(const NodeAction & action)
 {
     juzzlin::L(TAG).debug() << "Handling NodeAction: " << static_cast<int>(action.type());
 
+    // E.g. deleting or recoloring all the selected nodes is a single edit
+    beginTransaction();
+
     switch (action.type()) {
     case NodeAction::Type::None:
         break;
     case NodeAction::Type::AttachImage: {
-        const Image image { action.image(), action.fileName().toStdString() };
-        const auto id = m_editorService->mindMapData()->imageManager().addImage(image);
-        if (m_editorService->nodeSelectionGroupSize()) {
+        if (const auto id = addImageFromFile(action.fileName()); id.has_value() && m_editorService->nodeSelectionGroupSize()) {
             saveUndoPoint();
-            m_editorService->setImageRefForSelectedNodes(id);
+            m_editorService->setImageRefForSelectedNodes(*id);
         }
     } break;
     case NodeAction::Type::ConnectSelected:
@@ -662,6 +1594,12 @@ void ApplicationService::performNodeAction(const NodeAction & action)
     case NodeAction::Type::Copy:
         QApplication::clipboard()->clear();
         m_editorService->copySelectedNodes();
+        if (m_editorService->copyStackSize()) {
+            // Make the copied nodes available to other windows and instances, too
+            const auto mimeData = new QMimeData;
+            mimeData->setData(Constants::Application::clipboardMimeType(), m_editorService->serializedCopiedData());
+            QApplication::clipboard()->setMimeData(mimeData);
+        }
         break;
     case NodeAction::Type::Delete:
         if (mouseAction().action() == MouseAction::Action::CreateOrConnectNode) {
@@ -701,6 +1639,12 @@ void ApplicationService::performNodeAction(const NodeAction & action)
             m_editorService->clearNodeSelectionGroup();
         }
         break;
+    case NodeAction::Type::SelectAncestors:
+        m_editorService->selectReachableFromSelectedNodes(Graph::TraversalDirection::Ancestors, m_hiddenNodeIndices);
+        break;
+    case NodeAction::Type::SelectBranch:
+        m_editorService->selectReachableFromSelectedNodes(Graph::TraversalDirection::Descendants, m_hiddenNodeIndices);
+        break;
     case NodeAction::Type::SetTextColor:
         saveUndoPoint();
         m_editorService->setTextColorForSelectedNodes(action.color());
@@ -708,28 +1652,55 @@ void ApplicationService::performNodeAction(const NodeAction & action)
             m_editorService->clearNodeSelectionGroup();
         }
         break;
+    case NodeAction::Type::ToggleCollapsed:
+        saveUndoPoint();
+        m_editorService->toggleCollapsedForSelectedNodes();
+        // Selected nodes would otherwise stay in the scene even if they end up in a folded branch
+        m_editorService->clearNodeSelectionGroup();
+        if (updateHiddenNodes()) {
+            materializeItems();
+        }
+        break;
     }
+
+    commitTransaction();
 }
 
 bool ApplicationService::openMindMap(QString fileName)
+{
+    juzzlin::L(TAG).info() << "Loading '" << fileName.toStdString() << "'";
+    return doOpenMindMap([this, fileName] {
+        m_editorService->loadMindMapData(fileName);
+    });
+}
+
+bool ApplicationService::openMindMap(MindMapDataU mindMapData, QString url)
+{
+    juzzlin::L(TAG).info() << "Loading downloaded '" << url.toStdString() << "'";
+    // The function is called only once, but std::function needs a copyable target
+    const auto data = std::make_shared<MindMapDataU>(std::move(mindMapData));
+    return doOpenMindMap([this, data, url] {
+        m_editorService->loadMindMapData(std::move(*data), url);
+    });
+}
+
+bool ApplicationService::doOpenMindMap(const std::function<void()> & loadMindMapData)
 {
     try {
-        juzzlin::L(TAG).info() << "Loading '" << fileName.toStdString() << "'";
         SC::instance().progressManager()->setEnabled(true);
-        m_editorService->loadMindMapData(fileName);
-        updateProgress();
-        m_editorScene = std::make_unique<EditorScene>();
-        updateProgress();
-        initializeView();
-        updateProgress();
-        addExistingGraphToScene(true);
-        updateProgress();
-        connectGraphToUndoMechanism();
-        updateProgress();
-        connectGraphToImageManager();
-        updateProgress();
-        zoomToFit();
+        stopProgressiveLoad();
+        clearComparison();
+        saveViewport();
+        loadMindMapData();
         updateProgress();
+        // A reopened file continues where it was left
+        std::optional<Settings::Custom::Viewport> viewport;
+        if (const auto fileName = m_editorService->fileName(); !fileName.isEmpty()) {
+            viewport = Settings::Custom::loadViewport(QFileInfo { fileName }.absoluteFilePath());
+        }
+        showMindMap(viewport);
+        watchFile();
+        updateTabs();
     } catch (const IO::FileException & e) {
         // Initialize a new mind map to avoid an undefined state.
         initializeNewMindMap();
@@ -747,14 +1718,91 @@ bool ApplicationService::openMindMap(QString fileName)
     return true;
 }
 
+void ApplicationService::showMindMap(std::optional<Settings::Custom::Viewport> viewport)
+{
+    createEditorScene();
+    updateProgress();
+    initializeView();
+    updateProgress();
+    // The items around the viewport are added first
+    if (const auto & graph = m_editorService->mindMapData()->graph(); graph.nodeCount() + graph.edgeCount() >= Constants::View::progressiveLoadThreshold()) {
+        if (viewport) {
+            const auto & rect = viewport->sceneRect;
+            beginProgressiveLoad(rect.adjusted(-rect.width() / 2, -rect.height() / 2, rect.width() / 2, rect.height() / 2));
+        } else {
+            // The first chunk is zoomed to below, but the scene rect covers everything only at the end
+            beginProgressiveLoad({}, true);
+        }
+    } else {
+        addExistingGraphToScene(!viewport);
+    }
+    updateProgress();
+    if (viewport && hasNodes()) {
+        m_editorView->restoreViewport(viewport->sceneRect, viewport->scale);
+    } else {
+        zoomToFit();
+    }
+    updateProgress();
+}
+
+std::optional<Settings::Custom::Viewport> ApplicationService::currentViewport() const
+{
+    if (m_editorView && m_editorScene && hasNodes()) {
+        return Settings::Custom::Viewport { m_editorView->visibleSceneRect(), m_editorView->scale() };
+    }
+    return {};
+}
+
+void ApplicationService::saveViewport() const
+{
+    if (const auto fileName = m_editorService->fileName(); !fileName.isEmpty()) {
+        if (const auto viewport = currentViewport()) {
+            Settings::Custom::saveViewport(QFileInfo { fileName }.absoluteFilePath(), *viewport);
+        }
+    }
+}
+
 void ApplicationService::redo()
 {
     L(TAG).debug() << "Undo..";
 
+    m_layoutTransition->finish();
+
     m_editorView->resetDummyDragItems();
-    m_editorService->redo();
+    if (const auto result = m_editorService->redo(); result.isReplaced) {
+        setupMindMapAfterUndoOrRedo();
+    } else {
+        updateSceneAfterUndoOrRedo(result.addedNodes, result.addedEdges);
+    }
+}
 
-    setupMindMapAfterUndoOrRedo();
+void ApplicationService::reloadMindMap()
+{
+    watchFile();
+
+    try {
+        const auto result = m_editorService->reloadMindMapData();
+        switch (result.status) {
+        case EditorService::ReloadResult::Status::Unchanged:
+            break;
+        case EditorService::ReloadResult::Status::Conflict:
+            showStatusText(tr("The file has been changed by another program, but it has unsaved changes here"));
+            break;
+        case EditorService::ReloadResult::Status::Reloaded:
+            m_editorView->resetDummyDragItems();
+            if (result.undoResult.isReplaced) {
+                setupMindMapAfterUndoOrRedo();
+            } else {
+                updateSceneAfterUndoOrRedo(result.undoResult.addedNodes, result.undoResult.addedEdges);
+            }
+            updateNodeConnectionActions();
+            showStatusText(tr("Reloaded the file changed by another program"));
+            break;
+        }
+    } catch (const IO::FileException & e) {
+        // E.g. the other program is still writing the file, so the next change notification tries again
+        L(TAG).warning() << "Cannot reload: " << e.message().toStdString();
+    }
 }
 
 void ApplicationService::removeItem(QGraphicsItem & item)
@@ -762,6 +1810,129 @@ void ApplicationService::removeItem(QGraphicsItem & item)
     m_editorScene->removeItem(&item);
 }
 
+CollaborationSession & ApplicationService::collaborationSession()
+{
+    if (!m_collaborationSession) {
+        m_collaborationSession = std::make_unique<CollaborationSession>();
+        connect(m_collaborationSession.get(), &CollaborationSession::operationReceived, this, &ApplicationService::applyRemoteEdit);
+        connect(m_collaborationSession.get(), &CollaborationSession::peerCountChanged, this, [this](size_t peerCount) {
+            showStatusText(tr("Peers in the session: %1").arg(peerCount));
+        });
+        connect(m_collaborationSession.get(), &CollaborationSession::ended, this, [this](QString reason) {
+            m_mainWindow->showErrorDialog(tr("The session ended: %1").arg(reason));
+        });
+    }
+    return *m_collaborationSession;
+}
+
+bool ApplicationService::hostSession(quint16 port, QString secret, QString address)
+{
+    const QHostAddress hostAddress { address.isEmpty() ? QHostAddress { QHostAddress::LocalHost } : QHostAddress { address } };
+    if (hostAddress.isNull()) {
+        m_mainWindow->showErrorDialog(tr("Cannot host a session on '%1': not an IP address").arg(address));
+        return false;
+    }
+
+    collaborationSession().setMindMapData(m_editorService->mindMapData());
+    if (!m_collaborationSession->host(port, secret, hostAddress)) {
+        m_mainWindow->showErrorDialog(tr("Cannot host a session on port %1: %2").arg(port).arg(m_collaborationSession->errorString()));
+        return false;
+    }
+
+    if (secret.isEmpty()) {
+        L(TAG).info() << "The secret of the session is " << m_collaborationSession->secret().toStdString();
+    }
+    showStatusText(tr("Hosting a session on %1:%2 with the secret %3").arg(hostAddress.toString()).arg(m_collaborationSession->port()).arg(m_collaborationSession->secret()));
+    return true;
+}
+
+void ApplicationService::jumpToHistoryPosition(int position)
+{
+    L(TAG).debug() << "Jump in undo history..";
+
+    if (position < 0 || static_cast<size_t>(position) == historyPosition()) {
+        return;
+    }
+
+    m_layoutTransition->finish();
+
+    m_editorView->resetDummyDragItems();
+    if (const auto result = m_editorService->jumpToHistoryPosition(static_cast<size_t>(position)); result.isReplaced) {
+        setupMindMapAfterUndoOrRedo();
+    } else {
+        updateSceneAfterUndoOrRedo(result.addedNodes, result.addedEdges);
+    }
+}
+
+void ApplicationService::joinSession(QString hostName, quint16 port, QString secret)
+{
+    collaborationSession().setMindMapData(m_editorService->mindMapData());
+    m_collaborationSession->join(hostName, port, secret);
+    showStatusText(tr("Joining the session on %1:%2").arg(hostName).arg(port));
+}
+
+void ApplicationService::applyRemoteEdit(const IO::EditOperation & operation)
+{
+    if (operation.isReset) {
+        stopProgressiveLoad();
+        clearComparison();
+    }
+
+    // A remote edit may delete or replace the node that is being dragged here
+    const auto sourceNode = mouseAction().sourceNode();
+    const auto sourceIndex = sourceNode ? sourceNode->index() : -1;
+
+    const auto result = m_editorService->applyEditOperation(operation);
+    if (result.isReplaced) {
+        setupMindMapAfterUndoOrRedo();
+    } else {
+        updateSceneAfterUndoOrRedo(result.addedNodes, result.addedEdges);
+    }
+
+    if (sourceNode) {
+        const auto & graph = m_editorService->mindMapData()->graph();
+        if (result.isReplaced || !graph.hasNode(sourceIndex) || graph.getNode(sourceIndex).get() != sourceNode) {
+            mouseAction().clear();
+            m_editorView->resetDummyDragItems();
+            if (QApplication::overrideCursor()) {
+                QApplication::restoreOverrideCursor();
+            }
+        }
+    }
+}
+
+bool ApplicationService::runScript(QString fileName)
+{
+    QFile file { fileName };
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        m_mainWindow->showErrorDialog(tr("Cannot read '%1'!").arg(fileName));
+        return false;
+    }
+
+    auto result = ScriptRunner::run(*m_editorService->mindMapData(), QString::fromUtf8(file.readAll()), fileName);
+    if (!result.error.isEmpty()) {
+        m_mainWindow->showErrorDialog(result.errorLine ? tr("Script failed on line %1: %2").arg(result.errorLine).arg(result.error) : tr("Script failed: %1").arg(result.error));
+        return false;
+    }
+
+    if (!result.mindMapData) {
+        showStatusText(tr("The script didn't change anything"));
+        return true;
+    }
+
+    clearComparison();
+    m_editorView->resetDummyDragItems();
+    if (const auto undoResult = m_editorService->applyMindMapData(std::move(result.mindMapData)); undoResult.isReplaced) {
+        setupMindMapAfterUndoOrRedo();
+    } else {
+        updateSceneAfterUndoOrRedo(undoResult.addedNodes, undoResult.addedEdges);
+    }
+
+    showStatusText(tr("Script '%1' run").arg(QFileInfo { fileName }.fileName()));
+
+    return true;
+}
+
 void ApplicationService::toggleEdgeInSelectionGroup(EdgeR edge)
 {
     m_editorService->toggleEdgeInSelectionGroup(edge);
@@ -775,18 +1946,30 @@ void ApplicationService::toggleNodeInSelectionGroup(NodeR node, bool updateNodeC
     }
 }
 
-bool ApplicationService::saveMindMapAs(QString fileName)
+bool ApplicationService::saveMindMapAs(QString fileName, bool compress)
 {
-    return m_editorService->saveMindMapAs(fileName, true);
+    m_layoutTransition->finish();
+
+    m_editorService->setCompressionEnabled(compress);
+    const bool isSaved = m_editorService->saveMindMapAs(fileName, true);
+    watchFile();
+    updateTabs();
+    return isSaved;
 }
 
 bool ApplicationService::saveMindMap()
 {
-    return m_editorService->saveMindMap(true);
+    m_layoutTransition->finish();
+
+    const bool isSaved = m_editorService->saveMindMap(true);
+    watchFile();
+    return isSaved;
 }
 
 void ApplicationService::saveUndoPoint()
 {
+    m_layoutTransition->finish();
+
     m_editorService->saveUndoPoint();
 }
 
@@ -805,6 +1988,11 @@ std::optional<NodeP> ApplicationService::selectedNode() const
     return m_editorService->selectedNode();
 }
 
+std::vector<NodeP> ApplicationService::selectedNodes() const
+{
+    return m_editorService->selectedNodes();
+}
+
 size_t ApplicationService::edgeSelectionGroupSize() const
 {
     return m_editorService->edgeSelectionGroupSize();
@@ -817,12 +2005,46 @@ size_t ApplicationService::nodeSelectionGroupSize() const
 
 void ApplicationService::setArrowSize(double arrowSize)
 {
-    // Break loop with the spinbox
-    if (!qFuzzyCompare(m_editorService->mindMapData()->arrowSize(), arrowSize)) {
+    m_pendingStyleChange.arrowSize = arrowSize;
+    if (!m_styleChangeTimer.isActive()) {
+        m_styleChangeTimer.start();
+    }
+}
+
+void ApplicationService::applyPendingStyleChange()
+{
+    auto && change = m_pendingStyleChange;
+    const auto mindMapData = m_editorService->mindMapData();
+
+    // Break loop with the spin boxes, which also emit when the values of an opened mind map are set
+    const bool arrowSizeChanged = change.arrowSize && !qFuzzyCompare(mindMapData->arrowSize(), *change.arrowSize);
+    const bool cornerRadiusChanged = change.cornerRadius && mindMapData->cornerRadius() != *change.cornerRadius;
+    const bool edgeWidthChanged = change.edgeWidth && !qFuzzyCompare(mindMapData->edgeWidth(), *change.edgeWidth);
+    const bool textSizeChanged = change.textSize && mindMapData->textSize() != *change.textSize;
+    if (arrowSizeChanged || cornerRadiusChanged || edgeWidthChanged || textSizeChanged) {
         saveUndoPoint();
-        m_editorService->mindMapData()->setArrowSize(arrowSize);
-        m_editorView->setArrowSize(m_editorService->mindMapData()->arrowSize());
     }
+
+    if (arrowSizeChanged) {
+        mindMapData->setArrowSize(*change.arrowSize);
+        m_editorView->setArrowSize(mindMapData->arrowSize());
+    }
+
+    if (cornerRadiusChanged) {
+        mindMapData->setCornerRadius(*change.cornerRadius);
+        m_editorView->setCornerRadius(mindMapData->cornerRadius());
+    }
+
+    if (edgeWidthChanged) {
+        mindMapData->setEdgeWidth(*change.edgeWidth);
+        m_editorView->setEdgeWidth(mindMapData->edgeWidth());
+    }
+
+    if (textSizeChanged) {
+        mindMapData->setTextSize(*change.textSize);
+    }
+
+    change = {};
 }
 
 void ApplicationService::setBackgroundColor(QColor color)
@@ -836,11 +2058,9 @@ void ApplicationService::setBackgroundColor(QColor color)
 
 void ApplicationService::setCornerRadius(int value)
 {
-    // Break loop with the spinbox
-    if (m_editorService->mindMapData()->cornerRadius() != value) {
-        saveUndoPoint();
-        m_editorService->mindMapData()->setCornerRadius(value);
-        m_editorView->setCornerRadius(m_editorService->mindMapData()->cornerRadius());
+    m_pendingStyleChange.cornerRadius = value;
+    if (!m_styleChangeTimer.isActive()) {
+        m_styleChangeTimer.start();
     }
 }
 
@@ -855,11 +2075,9 @@ void ApplicationService::setEdgeColor(QColor color)
 
 void ApplicationService::setEdgeWidth(double value)
 {
-    // Break loop with the spinbox
-    if (!qFuzzyCompare(m_editorService->mindMapData()->edgeWidth(), value)) {
-        saveUndoPoint();
-        m_editorService->mindMapData()->setEdgeWidth(value);
-        m_editorView->setEdgeWidth(m_editorService->mindMapData()->edgeWidth());
+    m_pendingStyleChange.edgeWidth = value;
+    if (!m_styleChangeTimer.isActive()) {
+        m_styleChangeTimer.start();
     }
 }
 
@@ -877,35 +2095,32 @@ void ApplicationService::setEditorView(EditorView & editorView)
 {
     m_editorView = &editorView;
 
+    setPerformanceProfile();
+
     connect(m_editorView, &EditorView::newNodeRequested, this, [=](QPointF position) {
         saveUndoPoint();
         createAndAddNode(position);
     });
 }
 
+Qt::ItemSelectionMode ApplicationService::rectangleSelectionMode() const
+{
+    return m_settingsProxy->snapshot()->selectNodeGroupByIntersection ? Qt::IntersectsItemShape : Qt::ContainsItemShape;
+}
+
 size_t ApplicationService::setEdgeRectangleSelection(QRectF rect)
 {
-    size_t edgesInRectangle = 0;
-    for (auto && item : m_editorScene->items(rect, SC::instance().settingsProxy()->selectNodeGroupByIntersection() ? Qt::IntersectsItemShape : Qt::ContainsItemShape)) {
-        if (const auto edge = dynamic_cast<EdgeP>(item)) {
-            toggleEdgeInSelectionGroup(*edge);
-            edgesInRectangle++;
-        }
-    }
-    return edgesInRectangle;
+    const auto edges = m_editorScene->edgesInRect(rect, rectangleSelectionMode());
+    m_editorService->toggleEdgesInSelectionGroup(edges);
+    return edges.size();
 }
 
 size_t ApplicationService::setNodeRectangleSelection(QRectF rect)
 {
-    size_t nodesInRectangle = 0;
-    for (auto && item : m_editorScene->items(rect, SC::instance().settingsProxy()->selectNodeGroupByIntersection() ? Qt::IntersectsItemShape : Qt::ContainsItemShape)) {
-        if (const auto node = dynamic_cast<NodeP>(item)) {
-            toggleNodeInSelectionGroup(*node, false);
-            nodesInRectangle++;
-        }
-    }
+    const auto nodes = visibleNodesInRect(rect, rectangleSelectionMode() == Qt::ContainsItemShape);
+    m_editorService->toggleNodesInSelectionGroup(nodes);
     updateNodeConnectionActions();
-    return nodesInRectangle;
+    return nodes.size();
 }
 
 void ApplicationService::setSearchText(QString text)
@@ -913,6 +2128,9 @@ void ApplicationService::setSearchText(QString text)
     // Leave zoom setting as it is if user has cleared selected nodes and search field.
     // Otherwise zoom in to search results and select matching texts.
 
+    // Repaint the changed node and edge selections at once
+    const SceneItems::SelectionUpdateBatch selectionUpdateBatch;
+
     if (text.isEmpty() && !m_editorService->edgeSelectionGroupSize() && !m_editorService->nodeSelectionGroupSize()) {
         m_editorService->selectNodesByText("");
         m_editorService->selectEdgesByText("");
@@ -942,6 +2160,9 @@ void ApplicationService::setSearchText(QString text)
 void ApplicationService::setShadowEffect(const ShadowEffectParams & params)
 {
     m_editorService->mindMapData()->setShadowEffect(params);
+
+    // The shadows might have shrunk, so repaint everything
+    m_editorScene->update();
 }
 
 void ApplicationService::setGridSize(int size, bool autoSnap)
@@ -950,13 +2171,36 @@ void ApplicationService::setGridSize(int size, bool autoSnap)
     m_editorService->setGridSize(size, autoSnap);
 }
 
-void ApplicationService::setTextSize(int textSize)
+void ApplicationService::setHardwareAccelerationEnabled(bool enabled)
 {
-    // Break loop with the spinbox
+    m_editorView->setHardwareAccelerationEnabled(enabled || m_performanceProfile.policy().hardwareAcceleration);
+}
 
-    if (m_editorService->mindMapData()->textSize() != textSize) {
-        saveUndoPoint();
-        m_editorService->mindMapData()->setTextSize(textSize);
+void ApplicationService::setPerformanceProfile()
+{
+    m_performanceProfile.setMode(m_settingsProxy->performanceProfileMode());
+    m_performanceProfile.setItemCountThresholds(m_settingsProxy->balancedProfileItemCount(), m_settingsProxy->speedProfileItemCount());
+
+    // Only the automatic profile follows the paint times
+    if (m_performanceProfile.mode() == PerformanceProfile::Mode::Automatic) {
+        Profiler::setFrameObserver([this](double paintMilliseconds) {
+            if (m_performanceProfile.addFrameTime(paintMilliseconds)) {
+                // Not in the middle of the paint
+                QTimer::singleShot(0, this, &ApplicationService::applyPerformanceTier);
+            }
+        });
+    } else {
+        Profiler::setFrameObserver({});
+    }
+
+    applyPerformanceTier();
+}
+
+void ApplicationService::setTextSize(int textSize)
+{
+    m_pendingStyleChange.textSize = textSize;
+    if (!m_styleChangeTimer.isActive()) {
+        m_styleChangeTimer.start();
     }
 }
 
@@ -965,15 +2209,13 @@ void ApplicationService::setupMindMapAfterUndoOrRedo()
     const auto oldSceneRect = m_editorScene->sceneRect();
     const auto oldCenter = m_editorView->mapToScene(m_editorView->viewport()->rect()).boundingRect().center();
 
-    m_editorScene = std::make_unique<EditorScene>();
+    createEditorScene();
     m_editorView->setScene(m_editorScene.get());
     m_editorView->setBackgroundBrush(QBrush(m_editorService->backgroundColor()));
+    m_editorView->setMindMapData(m_editorService->mindMapData());
 
     addExistingGraphToScene();
 
-    connectGraphToUndoMechanism();
-    connectGraphToImageManager();
-
     m_editorScene->setSceneRect(oldSceneRect);
     m_editorView->centerOn(oldCenter);
 
@@ -987,6 +2229,11 @@ void ApplicationService::showStatusText(QString statusText)
 
 void ApplicationService::updateNodeConnectionActions()
 {
+    if (m_editorService->isInTransaction()) {
+        m_isNodeConnectionActionsUpdatePending = true;
+        return;
+    }
+
     m_mainWindow->enableConnectSelectedNodesAction(areSelectedNodesConnectable());
     m_mainWindow->enableDisconnectSelectedNodesAction(areSelectedNodesDisconnectable());
 }
@@ -996,14 +2243,29 @@ void ApplicationService::updateProgress()
     SC::instance().progressManager()->updateProgress();
 }
 
+void ApplicationService::updateSceneAfterUndoOrRedo(const std::vector<NodeS> & addedNodes, const std::vector<EdgeS> & addedEdges)
+{
+    addNewItemsToScene(addedNodes, addedEdges);
+
+    // E.g. undoing a collapse changes the hidden nodes, and the added items may be outside of the virtualized area
+    updateHiddenNodes();
+    materializeItems();
+
+    emit currentSearchTextRequested();
+}
+
 void ApplicationService::undo()
 {
     L(TAG).debug() << "Undo..";
 
-    m_editorView->resetDummyDragItems();
-    m_editorService->undo();
+    m_layoutTransition->finish();
 
-    setupMindMapAfterUndoOrRedo();
+    m_editorView->resetDummyDragItems();
+    if (const auto result = m_editorService->undo(); result.isReplaced) {
+        setupMindMapAfterUndoOrRedo();
+    } else {
+        updateSceneAfterUndoOrRedo(result.addedNodes, result.addedEdges);
+    }
 }
 
 void ApplicationService::unselectText()
@@ -1011,6 +2273,18 @@ void ApplicationService::unselectText()
     m_editorService->unselectText();
 }
 
+void ApplicationService::watchFile()
+{
+    if (const auto files = m_fileWatcher.files(); !files.isEmpty()) {
+        m_fileWatcher.removePaths(files);
+    }
+
+    // A new file gets watched once it has been written
+    if (const auto fileName = m_editorService->fileName(); !fileName.isEmpty() && QFile::exists(fileName)) {
+        m_fileWatcher.addPath(fileName);
+    }
+}
+
 void ApplicationService::zoomIn()
 {
     m_editorView->zoom(std::pow(Constants::View::zoomSensitivity(), 2));
@@ -1021,19 +2295,40 @@ void ApplicationService::zoomOut()
     m_editorView->zoom(1.0 / std::pow(Constants::View::zoomSensitivity(), 2));
 }
 
-QSize ApplicationService::calculateExportImageSize()
+QSize ApplicationService::calculateExportImageSize(ExportParams::Region region) const
+{
+    return m_editorView->mapFromScene(calculateExportRegionRectangle(region)).boundingRect().size();
+}
+
+QRectF ApplicationService::calculateExportRegionRectangle(ExportParams::Region region) const
 {
-    unselectSelectedNode();
-    clearSelectionGroups();
-    return m_editorView->mapFromScene(m_editorScene->calculateZoomToFitRectangle(true)).boundingRect().size();
+    switch (region) {
+    case ExportParams::Region::View:
+        return m_editorView->mapToScene(m_editorView->viewport()->rect()).boundingRect();
+    case ExportParams::Region::SelectedNodes:
+        return MagicZoom::calculateRectangleByNodes(m_editorService->selectedNodes(), true);
+    case ExportParams::Region::MindMap:
+        break;
+    }
+    return MagicZoom::calculateRectangleByNodePlacementStats(m_editorService->mindMapData()->graph().nodePlacementStats(), true);
 }
 
-void ApplicationService::zoomForExport()
+void ApplicationService::updateVirtualization(QRectF viewportRect)
 {
-    unselectSelectedNode();
-    clearSelectionGroups();
-    const auto zoomToFitRectangle = m_editorScene->calculateZoomToFitRectangle(true);
-    m_editorScene->setSceneRect(zoomToFitRectangle);
+    // A progressive load picks up the current rect when it's finished
+    if (!m_isVirtualizationEnabled || m_isProgressiveLoadActive) {
+        return;
+    }
+
+    // Items within one viewport on each side are kept so that small pans don't change the scene.
+    // The rect is also renewed after zooming in enough, so that zooming in drops the items that went far.
+    const double zoomInFactor = 6;
+    if (m_materializedRect.contains(viewportRect) && m_materializedRect.width() < viewportRect.width() * zoomInFactor) {
+        return;
+    }
+
+    m_materializedRect = viewportRect.adjusted(-viewportRect.width(), -viewportRect.height(), viewportRect.width(), viewportRect.height());
+    materializeItems();
 }
 
 void ApplicationService::zoomToFit()
@@ -1042,7 +2337,8 @@ void ApplicationService::zoomToFit()
         if (auto && selectedNodes = m_editorService->selectedNodes(); !selectedNodes.empty()) {
             m_editorView->zoomToFit(m_editorScene->calculateZoomToFitRectangleByNodes(selectedNodes));
         } else {
-            m_editorView->zoomToFit(m_editorScene->calculateZoomToFitRectangle());
+            // Based on the graph instead of the scene items, which may not all be in the scene yet
+            m_editorView->zoomToFit(MagicZoom::calculateRectangleByNodePlacementStats(m_editorService->mindMapData()->graph().nodePlacementStats()));
         }
     }
 }
@@ -1086,7 +2382,7 @@ void ApplicationService::unselectImplicitlySelectedNodes()
 
 void ApplicationService::unselectSelectedNode()
 {
-    for (auto && node : m_editorService->mindMapData()->graph().getNodes()) {
+    for (auto && node : m_editorService->mindMapData()->graph().nodes()) {
         node->setSelected(false);
     }
 }
@@ -1096,10 +2392,12 @@ NodeS ApplicationService::getBestOverlapNode(NodeCR source)
     NodeS bestNode;
     double bestScore = 0;
     const double minThreshold = 0.25;
-    for (auto && node : m_editorService->mindMapData()->graph().getNodes()) {
-        if (node->index() != source.index() && node->index() != mouseAction().sourceNode()->index() && !areDirectlyConnected(*node, *mouseAction().sourceNode())) {
+    // Only the nodes under the dragged node can overlap with it, so let the spatial index find them
+    auto && graph = m_editorService->mindMapData()->graph();
+    for (auto && node : visibleNodesInRect(source.boundingRect().translated(source.pos()))) {
+        if (node != &source && node->index() != source.index() && node->index() != mouseAction().sourceNode()->index() && !areDirectlyConnected(*node, *mouseAction().sourceNode())) {
             if (const auto score = calculateNodeOverlapScore(source, *node); score > minThreshold && score > bestScore) {
-                bestNode = node;
+                bestNode = graph.getNode(node->index());
                 bestScore = score;
             }
         }
@@ -1108,4 +2406,80 @@ NodeS ApplicationService::getBestOverlapNode(NodeCR source)
     return bestNode;
 }
 
-ApplicationService::~ApplicationService() = default;
+void ApplicationService::registerCaches()
+{
+    // The decoded images and the undo history are already in the report of the editor service
+    m_cacheIds.push_back(m_cacheRegistry->add({ tr("Decoded images"), Constants::Cache::backgroundImageBudget(), &ImageDecoder::trim, {} }));
+
+    m_cacheIds.push_back(m_cacheRegistry->add({ tr("Text sizes"), Constants::Cache::backgroundTextSizeBudget(), &SceneItems::TextSizeCache::trim, [] {
+                                                   return MemoryUsage { SceneItems::TextSizeCache::size(), SceneItems::TextSizeCache::bytes() };
+                                               } }));
+
+    // QPixmapCache drops its least recently used pixmaps when the limit is lowered, but it doesn't tell how much
+    m_cacheIds.push_back(m_cacheRegistry->add({ tr("Pixmaps"), Constants::Cache::backgroundPixmapBudget(), [](size_t bytes) {
+                                                   const auto limit = QPixmapCache::cacheLimit();
+                                                   QPixmapCache::setCacheLimit(static_cast<int>(std::min<size_t>(bytes / 1024, static_cast<size_t>(limit))));
+                                                   QPixmapCache::setCacheLimit(limit);
+                                                   return size_t { 0 };
+                                               },
+                                               {} }));
+
+    m_cacheIds.push_back(m_cacheRegistry->add({ tr("Export snapshot"), 0, [this](size_t bytes) {
+                                                   const auto usage = exportSnapshotMemoryUsage();
+                                                   if (usage.bytes <= bytes) {
+                                                       return size_t { 0 };
+                                                   }
+                                                   m_exportSnapshotCache.snapshot.reset();
+                                                   return usage.bytes;
+                                               },
+                                               [this] { return exportSnapshotMemoryUsage(); } }));
+
+    m_cacheIds.push_back(m_cacheRegistry->add({ tr("Undo keyframes"), Constants::Cache::backgroundUndoBudget(), [this](size_t bytes) {
+                                                   size_t reclaimed = 0;
+                                                   for (auto && tab : m_tabs) {
+                                                       reclaimed += tab.editorService->trimUndoHistory(bytes);
+                                                   }
+                                                   return reclaimed;
+                                               },
+                                               {} }));
+}
+
+MemoryUsage ApplicationService::exportSnapshotMemoryUsage() const
+{
+    if (!m_exportSnapshotCache.snapshot) {
+        return {};
+    }
+
+    auto usage = m_exportSnapshotCache.snapshot->mindMapData().graph().memoryUsage();
+    usage += m_exportSnapshotCache.snapshot->scene().memoryUsage();
+    return usage;
+}
+
+void ApplicationService::updateBackgroundState()
+{
+    if (m_isMinimized || QGuiApplication::applicationState() != Qt::ApplicationActive) {
+        if (!m_backgroundTrimTimer.isActive()) {
+            m_backgroundTrimTimer.start();
+        }
+    } else {
+        m_backgroundTrimTimer.stop();
+    }
+}
+
+ApplicationService::~ApplicationService()
+{
+    for (auto && id : m_cacheIds) {
+        m_cacheRegistry->remove(id);
+    }
+
+    // The observer refers to this service
+    Profiler::setFrameObserver({});
+
+    // The job refers to this service
+    m_guiJobScheduler->cancel(m_progressiveLoadJob);
+
+    if (m_isExiting) {
+        // Intentionally leaked, removing every item from a huge scene would take seconds
+        static_cast<void>(m_editorScene.release());
+    }
+}
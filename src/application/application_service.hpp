@@ -16,31 +16,53 @@
 #ifndef APPLICATION_SERVICE_HPP
 #define APPLICATION_SERVICE_HPP
 
+#include <functional>
 #include <optional>
+#include <unordered_set>
+#include <vector>
 
+#include <QFileSystemWatcher>
 #include <QFont>
 #include <QObject>
 #include <QPointF>
 #include <QString>
+#include <QStringList>
+#include <QTimer>
 
 #include "../common/types.hpp"
+#include "../domain/graph.hpp"
+#include "../domain/graph_snapshot.hpp"
 #include "../domain/mind_map_data.hpp"
+#include "../infra/export_params.hpp"
+#include "../infra/settings.hpp"
+#include "cache_registry.hpp"
+#include "memory_report.hpp"
+#include "performance_profile.hpp"
 #include "../view/scene_items/node.hpp"
 
+class CollaborationSession;
 class EdgeAction;
 class EditorScene;
 class EditorView;
-class ExportParams;
-class Graph;
+class ExportSnapshot;
+class LayoutTransition;
 class MainWindow;
+class MemoryPressureMonitor;
 class MouseAction;
 class NodeAction;
+class PdfExportJob;
+class PngExportJob;
 class QGraphicsItem;
 class ShadowEffectParams;
 
 namespace SceneItems {
 class NodeHandle;
-}
+struct NodeModel;
+} // namespace SceneItems
+
+namespace IO {
+struct EditOperation;
+} // namespace IO
 
 /*! Acts as a communication channel between MainWindow and editor components:
  *
@@ -56,16 +78,47 @@ public:
 
     ~ApplicationService() override;
 
+    //! Makes the first tab that has unsaved changes active, e.g. before quitting.
+    //! \returns false if there are no such tabs.
+    bool activateModifiedTab();
+
+    //! Makes the tab where the given file is open active.
+    //! \returns false if the file is not open in any tab.
+    bool activateTabOfFile(QString fileName);
+
     void addEdge(NodeR node1, NodeR node2);
 
+    //! Creates edges from plain data between existing nodes, connects them and adds them to the scene in bulk.
+    //! \returns The new edges in the given order.
+    std::vector<EdgeS> addEdges(const GraphSnapshot::EdgeDataVector & edges);
+
+    //! Creates nodes from plain data with new indices, connects them and adds them to the scene in bulk,
+    //! e.g. for importers, paste and automation. The scene rect is adjusted only once.
+    //! \returns The new nodes in the order of the models.
+    std::vector<NodeS> addNodes(const GraphSnapshot::NodeDataVector & models);
+
     void addItemToEditorScene(QGraphicsItem & item, bool adjustSceneRect = true);
 
+    //! Adds a tab for another mind map and makes it active. The mind map is then set up by e.g. initializeNewMindMap().
+    //! \returns false if tabs can't be changed at the moment.
+    bool addTab();
+
     void addEdgeToSelectionGroup(EdgeR edge, bool isImplicit = false);
 
     void addNodeToSelectionGroup(NodeR node, bool isImplicit = false);
 
     void adjustSceneRect();
 
+    //! Attaches the given image files dropped at the given scene position. The first image goes to the node
+    //! at that position, if any, and the rest get a new node each. The images are decoded in the background.
+    void attachDroppedImages(const QStringList & fileNames, QPointF pos);
+
+    //! Starts an edit that consists of several changes, see EditorService::beginTransaction(). In addition,
+    //! the scene rect adjustments and the updates of the node connection actions are deferred until the commit.
+    void beginTransaction();
+
+    void commitTransaction();
+
     bool areDirectlyConnected(NodeCR node1, NodeCR node2) const;
 
     bool areSelectedNodesConnectable() const;
@@ -76,15 +129,20 @@ public:
 
     void changeFont(const QFont & font);
 
+    //! Removes the marks of compareWithFile().
+    void clearComparison();
+
     void clearEdgeSelectionGroup(bool implicitOnly = false);
 
     void clearNodeSelectionGroup(bool implicitOnly = false);
 
-    void connectEdgeToUndoMechanism(EdgeS edge);
+    //! Closes the active tab without saving it and activates the next one. Does nothing to the last tab.
+    void closeTab();
 
-    void connectNodeToUndoMechanism(NodeS node);
-
-    void connectNodeToImageManager(NodeS node);
+    //! Compares the mind map with the given file, e.g. an earlier version of it, and marks the added, moved and
+    //! edited nodes and edges with a glow until clearComparison(). The removed items are only counted in the status text.
+    //! \returns false if the file can't be read, in which case an error dialog has been shown.
+    bool compareWithFile(QString fileName);
 
     size_t copyStackSize() const;
 
@@ -114,6 +172,9 @@ public:
 
     void initializeView();
 
+    //! \returns true if items are marked by compareWithFile().
+    bool isComparing() const;
+
     bool isInBetween(NodeR node);
 
     bool isInSelectionGroup(NodeR node);
@@ -124,31 +185,69 @@ public:
 
     bool isRedoable() const;
 
+    //! \returns The position of the current state in the undo history, see EditorService::historyPosition().
+    size_t historyPosition() const;
+
+    //! \returns The last position in the undo history, see EditorService::historyLength().
+    size_t historyLength() const;
+
     bool isModified() const;
 
+    //! \returns Estimated memory usage of the editor subsystems and the scene.
+    MemoryReport memoryReport() const;
+
     void moveSelectionGroup(NodeR reference, QPointF location);
 
+    //! Selects the first parent or child of the selected node, e.g. on an arrow key with Alt.
+    //! \returns true if the selection moved.
+    bool navigateAlongEdge(Graph::TraversalDirection direction);
+
+    //! Selects the visible node nearest to the selected node in the given direction, e.g. on an arrow key.
+    //! \returns true if the selection moved.
+    bool navigateToNearestNode(QPointF direction);
+
     size_t nodeCount() const;
 
     bool nodeHasImageAttached() const;
 
     QSizeF normalizedSizeInView(const QRectF & rectInScene) const;
 
-    NodeS pasteNodeAt(NodeR source, QPointF pos);
-
     MindMapDataS mindMapData() const;
 
     bool openMindMap(QString fileName);
 
+    //! Opens a mind map that has been read from the given URL. It's opened as unsaved.
+    bool openMindMap(MindMapDataU mindMapData, QString url);
+
     void performEdgeAction(const EdgeAction & action);
 
+    //! Marks that the process is exiting, so that the scene and the mind map are left to the process teardown
+    //! instead of being destroyed item by item, see EditorService::prepareForExit().
+    void prepareForExit();
+
     void performNodeAction(const NodeAction & action);
 
     void redo();
 
     void removeItem(QGraphicsItem & item);
 
-    bool saveMindMapAs(QString fileName);
+    //! Starts sharing the edits of the mind map with the instances that join on the given port, see CollaborationSession.
+    //! \param secret The secret that the joining instances must give. Generated and shown if empty.
+    //! \param address The address to listen on. Only the instances of this computer can join if empty.
+    bool hostSession(quint16 port, QString secret, QString address);
+
+    //! Joins the session hosted on the given address. The mind map is replaced by the shared one.
+    void joinSession(QString hostName, quint16 port, QString secret);
+
+    //! Undoes or redoes to the given position in the undo history at once, e.g. from the history slider.
+    void jumpToHistoryPosition(int position);
+
+    //! Runs the given JavaScript file against the mind map, see ScriptRunner. All its changes are applied
+    //! as a single undo point.
+    bool runScript(QString fileName);
+
+    //! \param compress Saves an XML mind map in the compressed container.
+    bool saveMindMapAs(QString fileName, bool compress = false);
 
     bool saveMindMap();
 
@@ -158,6 +257,8 @@ public:
 
     std::optional<NodeP> selectedNode() const;
 
+    std::vector<NodeP> selectedNodes() const;
+
     size_t edgeSelectionGroupSize() const;
 
     size_t nodeSelectionGroupSize() const;
@@ -166,6 +267,11 @@ public:
 
     void setGridSize(int size, bool autoSnap);
 
+    void setHardwareAccelerationEnabled(bool enabled);
+
+    //! Applies the performance profile settings, which are read from SettingsProxy.
+    void setPerformanceProfile();
+
     //! \returns number of edges in the current rectangle.
     size_t setEdgeRectangleSelection(QRectF rect);
 
@@ -174,6 +280,8 @@ public:
 
     void showStatusText(QString statusText);
 
+    size_t tabCount() const;
+
     void toggleEdgeInSelectionGroup(EdgeR edge);
 
     void toggleNodeInSelectionGroup(NodeR node, bool updateNodeConnectionActions = true);
@@ -190,16 +298,25 @@ public:
 
 public slots:
 
+    //! Makes the given tab active. Only the active tab has scene items, the others keep just the plain data of their mind maps.
+    void activateTab(int index);
+
     void enableAutosave(bool enable);
 
     void enableUndo(bool enable);
 
     void enableRedo(bool enable);
 
+    void exportToPdf(const ExportParams & exportParams);
+
     void exportToPng(const ExportParams & exportParams);
 
     void exportToSvg(const ExportParams & exportParams);
 
+    //! Applies a layout change, e.g. an optimized layout, and moves the nodes smoothly from their old locations
+    //! to the new ones. The undo point must have been saved before.
+    void applyLayout(const std::function<void()> & changeLayout);
+
     void mirror(bool vertically);
 
     void saveUndoPoint();
@@ -222,9 +339,15 @@ public slots:
 
     void setTextSize(int textSize);
 
-    QSize calculateExportImageSize();
+    //! \return Size of the given export region at the current zoom level.
+    QSize calculateExportImageSize(ExportParams::Region region = ExportParams::Region::MindMap) const;
+
+    //! \return The area of the given export region in scene coordinates.
+    QRectF calculateExportRegionRectangle(ExportParams::Region region) const;
 
-    void zoomForExport();
+    //! Keeps only the items near the given viewport rect in the scene when the mind map is large enough for
+    //! virtualization, so that the scene index scales with what's visible. Called by the view when it scrolls or zooms.
+    void updateVirtualization(QRectF viewportRect);
 
     void zoomToFit();
 
@@ -238,30 +361,135 @@ signals:
 
     void currentSearchTextRequested();
 
+    void pdfExportFinished(bool success);
+
+    void pdfExportProgressed(int percentage);
+
     void pngExportFinished(bool success);
 
+    void pngExportProgressed(int percentage);
+
     void svgExportFinished(bool success);
 
 private:
     void addExistingEdgesToScene();
 
-    void addExistingNodesToScene();
+    void addExistingNodesToScene(bool adjustSceneRect = true);
+
+    size_t countItemsNotInEditorScene() const;
 
     void addExistingGraphToScene(bool zoomToFitAfterNodesLoaded = false);
 
-    using GridLineVector = std::vector<QGraphicsLineItem *>;
-    GridLineVector addGridForExport();
+    //! \returns The offset that moves the given rect of new nodes to free space near its current location, see IncrementalLayout.
+    //! \param ignoredNodeIndex Index of the placed node if it has been added to the graph already.
+    QPointF findFreeOffset(const QRectF & rect, std::optional<QPointF> parentLocation = {}, int ignoredNodeIndex = -1) const;
 
-    double calculateNodeOverlapScore(NodeCR node1, NodeCR node2) const;
+    //! \returns The nodes whose placement rects intersect, or are contained by, the given rect, found through the
+    //! spatial index of the graph. The nodes of collapsed branches are skipped.
+    std::vector<NodeP> visibleNodesInRect(const QRectF & rect, bool contained = false) const;
 
-    void clearSelectionGroups();
+    //! Reads the given image file and adds it to the image manager without decoding it here.
+    //! \return The image id, or nothing if the file can't be read.
+    std::optional<size_t> addImageFromFile(QString fileName);
+
+    //! Adds the graph to the scene in chunks over several event loop iterations, so that a large
+    //! mind map becomes visible and usable right after opening. The first chunk is added immediately.
+    //! The nodes in the given priority rect and the edges between them are added before the rest.
+    //! \param zoomToFitAfterLoaded Zoom to fit again when the last chunk has been added and the scene rect covers everything.
+    void beginProgressiveLoad(QRectF priorityRect = {}, bool zoomToFitAfterLoaded = false);
+
+    //! Opens the mind map loaded by the given function and builds the scene for it.
+    bool doOpenMindMap(const std::function<void()> & loadMindMapData);
+
+    //! Saves the viewport of the current mind map file, so that the file is reopened where it was left.
+    void saveViewport() const;
+
+    //! \returns The visible part of the current mind map, if it has nodes.
+    std::optional<Settings::Custom::Viewport> currentViewport() const;
+
+    //! Builds the scene for the current mind map and shows the given viewport of it, or the whole mind map.
+    void showMindMap(std::optional<Settings::Custom::Viewport> viewport);
+
+    void connectEditorService();
+
+    //! Releases the scene items of the active tab and remembers its viewport.
+    void deactivateTab();
+
+    //! Makes the given tab active and builds its scene.
+    void showTab(size_t index);
+
+    //! Updates the titles of the tabs in the main window.
+    void updateTabs();
+
+    void addNextProgressiveLoadChunk();
+
+    //! Stops adding chunks. Items that are still missing from the scene are added by the next call
+    //! to addExistingGraphToScene(), which also calls this.
+    void stopProgressiveLoad();
+
+    //! Adds only the given new items to the scene and updates the scene rect once, e.g. after paste.
+    void addNewItemsToScene(const std::vector<NodeS> & nodes, const std::vector<EdgeS> & edges);
+
+    //! Adjusts the scene rect to the current node bounds now or at the commit of the current transaction.
+    void adjustEditorSceneRect();
+
+    //! Turns off edge dot animations for large mind maps as decided by the performance profile.
+    void updateEdgeAnimationsEnabled();
+
+    //! Turns on virtualization for large mind maps as decided by the performance profile, see updateVirtualization().
+    //! \returns true if virtualization was turned on or off.
+    bool updateVirtualizationEnabled();
+
+    //! Updates the item count of the performance profile and applies the policy of a new tier.
+    void updatePerformanceTier();
+
+    //! Applies the parts of the performance policy that don't change the scene: shadows, level of detail, viewport and undo budget.
+    void applyPerformancePolicy();
+
+    //! Applies the whole performance policy after the tier has changed without the mind map changing, e.g. because of slow frames.
+    void applyPerformanceTier();
+
+    //! \returns True if the node belongs to the scene, i.e. it isn't folded away and virtualization is off or the node is near the viewport.
+    bool isMaterialized(NodeR node) const;
+
+    //! \returns True if the edge belongs to the scene, i.e. virtualization is off or the edge is near the viewport.
+    bool isMaterialized(EdgeR edge) const;
+
+    //! Adds the items that are near the viewport and removes the ones that aren't. The removed items stay in the graph.
+    void materializeItems();
+
+    //! Makes the given node the only selected one and scrolls it into view.
+    void navigateToNode(NodeR node);
 
-    void connectGraphToUndoMechanism();
+    //! Applies the changes of the current file made by another program, unless the mind map has unsaved changes.
+    void reloadMindMap();
 
-    void connectGraphToImageManager();
+    //! Applies an edit made by another instance of the session.
+    void applyRemoteEdit(const IO::EditOperation & operation);
+
+    //! Creates the session on first use.
+    CollaborationSession & collaborationSession();
+
+    //! Watches the current file, if any, for changes by other programs. Needs to be called again after each change,
+    //! because programs that save by replacing the file end the watch.
+    void watchFile();
+
+    //! Collects the descendants of collapsed nodes, which are kept out of the scene.
+    //! \returns True if the set of hidden nodes changed.
+    bool updateHiddenNodes();
+
+    //! \returns A snapshot of the region, which is reused until the mind map, the region or the grid changes.
+    std::shared_ptr<ExportSnapshot> createExportSnapshot(ExportParams::Region region);
+
+    double calculateNodeOverlapScore(NodeCR node1, NodeCR node2) const;
+
+    void clearSelectionGroups();
 
     void connectSelectedNodes();
 
+    //! Creates the scene and routes the undo point and image requests of all its items to the editor.
+    void createEditorScene();
+
     void disconnectSelectedNodes();
 
     bool isEdgeAddedToEditorScene(EdgeR edge) const;
@@ -272,10 +500,26 @@ private:
 
     void paste();
 
-    void removeLineItems(const GridLineVector & lines);
+    Qt::ItemSelectionMode rectangleSelectionMode() const;
+
+
+    //! Registers the caches that are trimmed in the background and on memory pressure.
+    void registerCaches();
+
+    MemoryUsage exportSnapshotMemoryUsage() const;
 
+    //! Trims the caches after a delay while the window is minimized or the application is inactive.
+    void updateBackgroundState();
+
+    //! Applies the latest values of the style spin boxes at once, see setArrowSize() etc.
+    void applyPendingStyleChange();
+
+    //! Rebuilds the scene, because undo or redo replaced the mind map data as a whole.
     void setupMindMapAfterUndoOrRedo();
 
+    //! Adds the items created by undo or redo to the scene. The removed items are already out of the scene and the changed ones updated.
+    void updateSceneAfterUndoOrRedo(const std::vector<NodeS> & addedNodes, const std::vector<EdgeS> & addedEdges);
+
     void setMindMapProperties();
 
     void setMindMapPropertiesOnMainWindow();
@@ -290,13 +534,127 @@ private:
 
     void updateProgress();
 
+    //! The editor service of the active tab.
     EditorServiceS m_editorService;
 
+    //! A mind map open in a tab.
+    struct Tab
+    {
+        EditorServiceS editorService;
+
+        //! The remembered viewport of an inactive tab.
+        std::optional<Settings::Custom::Viewport> viewport;
+    };
+
+    std::vector<Tab> m_tabs;
+
+    size_t m_activeTab = 0;
+
     std::unique_ptr<EditorScene> m_editorScene;
 
+    //! Declared after the scene so that a running transition finishes before the scene is deleted.
+    std::unique_ptr<LayoutTransition> m_layoutTransition;
+
     EditorView * m_editorView = nullptr;
 
     MainWindowS m_mainWindow;
+
+    SettingsProxyS m_settingsProxy;
+
+    //! Exports of the same mind map e.g. at different sizes or formats reuse the snapshot instead of copying the mind map
+    //! and laying out its scene again.
+    struct ExportSnapshotCache
+    {
+        std::shared_ptr<ExportSnapshot> snapshot;
+
+        size_t modificationCount = 0;
+
+        ExportParams::Region region = ExportParams::Region::MindMap;
+
+        QRectF rect;
+
+        int gridSize = 0;
+    };
+
+    ExportSnapshotCache m_exportSnapshotCache;
+
+    std::unique_ptr<PdfExportJob> m_pdfExportJob;
+
+    std::unique_ptr<PngExportJob> m_pngExportJob;
+
+    std::unique_ptr<CollaborationSession> m_collaborationSession;
+
+    PerformanceProfile m_performanceProfile;
+
+    GuiJobSchedulerS m_guiJobScheduler;
+
+    //! Id of the job of the progressive load in the GUI job scheduler.
+    size_t m_progressiveLoadJob = 0;
+
+    //! Dragging a spin box changes the value many times per frame, so only the latest value is applied to the items.
+    struct PendingStyleChange
+    {
+        std::optional<double> arrowSize;
+
+        std::optional<int> cornerRadius;
+
+        std::optional<double> edgeWidth;
+
+        std::optional<int> textSize;
+    };
+
+    PendingStyleChange m_pendingStyleChange;
+
+    QTimer m_styleChangeTimer;
+
+    QFileSystemWatcher m_fileWatcher;
+
+    //! Editors may write a file in several steps, so the reload waits until the changes have settled.
+    QTimer m_fileChangeTimer;
+
+    CacheRegistryS m_cacheRegistry;
+
+    std::vector<CacheRegistry::Id> m_cacheIds;
+
+    std::unique_ptr<MemoryPressureMonitor> m_memoryPressureMonitor;
+
+    //! A short switch to another window doesn't trim the caches.
+    QTimer m_backgroundTrimTimer;
+
+    bool m_isMinimized = false;
+
+    bool m_isExiting = false;
+
+    bool m_isProgressiveLoadActive = false;
+
+    bool m_isZoomToFitAfterProgressiveLoadPending = false;
+
+    bool m_isVirtualizationEnabled = false;
+
+    //! Deferred by a transaction, see beginTransaction().
+    bool m_isSceneRectAdjustmentPending = false;
+
+    bool m_isNodeBoundsInvalidationPending = false;
+
+    bool m_isNodeConnectionActionsUpdatePending = false;
+
+    //! Items intersecting this rect are in the scene when virtualization is enabled. Null until the view reports its rect.
+    QRectF m_materializedRect;
+
+    // Items marked by compareWithFile()
+    std::vector<std::weak_ptr<SceneItems::Edge>> m_markedEdges;
+
+    std::vector<std::weak_ptr<SceneItems::Node>> m_markedNodes;
+
+    //! Indices of the descendants of collapsed nodes, see updateHiddenNodes().
+    std::unordered_set<int> m_hiddenNodeIndices;
+
+    //! Runs first over the priority nodes to add them and then again to add the edges between them,
+    //! and then the same way over all the node slots.
+    size_t m_progressiveLoadPosition = 0;
+
+    //! Indices of the nodes that the progressive load adds first, e.g. the ones in the restored viewport.
+    std::vector<int> m_progressiveLoadPriorityNodes;
 };
 
 #endif // APPLICATION_SERVICE_HPP
@@ -0,0 +1,149 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "autosave_scheduler.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QRunnable>
+
+static const auto TAG = "AutosaveScheduler";
+
+namespace {
+
+class SaveTask : public QRunnable
+{
+public:
+    SaveTask(AutosaveScheduler & scheduler, AutosaveScheduler::SaveFunction saveFunction, MindMapDataS mindMapData, QString fileName)
+      : m_scheduler(scheduler)
+      , m_saveFunction(saveFunction)
+      , m_mindMapData(mindMapData)
+      , m_fileName(fileName)
+    {
+    }
+
+    void run() override
+    {
+        const bool success = m_saveFunction(m_mindMapData, m_fileName);
+        // Release the data before notifying so that it isn't kept alive by the finished task
+        m_mindMapData.reset();
+        QMetaObject::invokeMethod(&m_scheduler, "handleSaveFinished", Qt::QueuedConnection, Q_ARG(bool, success), Q_ARG(QString, m_fileName));
+    }
+
+private:
+    AutosaveScheduler & m_scheduler;
+
+    AutosaveScheduler::SaveFunction m_saveFunction;
+
+    MindMapDataS m_mindMapData;
+
+    QString m_fileName;
+};
+
+} // namespace
+
+AutosaveScheduler::AutosaveScheduler(SaveFunction saveFunction, std::chrono::milliseconds debounceDelay)
+  : m_saveFunction(saveFunction)
+{
+    m_debounceTimer.setSingleShot(true);
+    m_debounceTimer.setInterval(static_cast<int>(debounceDelay.count()));
+    connect(&m_debounceTimer, &QTimer::timeout, this, &AutosaveScheduler::startSave);
+
+    // Saves must not overtake each other
+    m_threadPool.setMaxThreadCount(1);
+}
+
+AutosaveScheduler::~AutosaveScheduler()
+{
+    m_threadPool.waitForDone();
+}
+
+void AutosaveScheduler::schedule(SnapshotFunction snapshotFunction, QString fileName)
+{
+    if (m_pendingSnapshotFunction) {
+        m_coalescedCount++;
+    } else {
+        m_pendingSince = std::chrono::steady_clock::now();
+    }
+
+    m_pendingSnapshotFunction = snapshotFunction;
+    m_pendingFileName = fileName;
+
+    // While a save is running, the pending request is started when the running one finishes
+    if (!m_isRunning) {
+        m_debounceTimer.start();
+    }
+}
+
+void AutosaveScheduler::cancel()
+{
+    m_debounceTimer.stop();
+    m_pendingSnapshotFunction = {};
+    m_pendingFileName.clear();
+}
+
+void AutosaveScheduler::waitForDone()
+{
+    m_threadPool.waitForDone();
+}
+
+size_t AutosaveScheduler::queueDepth() const
+{
+    return (m_pendingSnapshotFunction ? 1 : 0) + (m_isRunning ? 1 : 0);
+}
+
+size_t AutosaveScheduler::coalescedCount() const
+{
+    return m_coalescedCount;
+}
+
+std::chrono::milliseconds AutosaveScheduler::lastLatency() const
+{
+    return m_lastLatency;
+}
+
+void AutosaveScheduler::startSave()
+{
+    if (!m_pendingSnapshotFunction || m_isRunning) {
+        return;
+    }
+
+    const auto snapshotFunction = std::move(m_pendingSnapshotFunction);
+    m_pendingSnapshotFunction = {};
+    const auto fileName = m_pendingFileName;
+    m_pendingFileName.clear();
+
+    if (const auto mindMapData = snapshotFunction(); mindMapData) {
+        m_isRunning = true;
+        m_runningSince = m_pendingSince;
+        m_threadPool.start(new SaveTask(*this, m_saveFunction, mindMapData, fileName));
+    }
+}
+
+void AutosaveScheduler::handleSaveFinished(bool success, QString fileName)
+{
+    m_isRunning = false;
+    m_lastLatency = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_runningSince);
+
+    juzzlin::L(TAG).debug() << "Autosave to '" << fileName.toStdString() << "' finished in " << m_lastLatency.count() //
+                            << " ms, success=" << success << ", coalesced=" << m_coalescedCount;
+
+    emit saveFinished(success, fileName);
+
+    // Requests that arrived during the save have already waited long enough
+    if (m_pendingSnapshotFunction && !m_debounceTimer.isActive()) {
+        startSave();
+    }
+}
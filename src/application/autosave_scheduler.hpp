@@ -0,0 +1,98 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef AUTOSAVE_SCHEDULER_HPP
+#define AUTOSAVE_SCHEDULER_HPP
+
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <chrono>
+#include <functional>
+
+#include "../common/types.hpp"
+
+//! Runs autosaves in the background so that at most one save is running and at most one is
+//! pending. A new request replaces the pending one and bursts of requests are debounced, so
+//! fast editing doesn't pile up full saves that each keep a reference to the mind map.
+class AutosaveScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    //! Performs a blocking save. Called on the background thread of the scheduler.
+    using SaveFunction = std::function<bool(MindMapDataS, QString)>;
+
+    //! Returns the data to save. Called on the thread of the scheduler when the save starts, so that
+    //! the edits made during the debounce delay are saved, too. May return nullptr to skip the save.
+    using SnapshotFunction = std::function<MindMapDataS()>;
+
+    explicit AutosaveScheduler(SaveFunction saveFunction, std::chrono::milliseconds debounceDelay);
+
+    ~AutosaveScheduler() override;
+
+    //! Requests a save of the data returned by the given function. Replaces the pending request, if any.
+    void schedule(SnapshotFunction snapshotFunction, QString fileName);
+
+    //! Drops the pending request, e.g. when a synchronous save supersedes it.
+    void cancel();
+
+    //! Waits until the running save, if any, has finished. saveFinished() is still delivered via the event loop.
+    void waitForDone();
+
+    //! \return Number of saves that are either pending or running.
+    size_t queueDepth() const;
+
+    //! \return Number of requests that were replaced by a newer one before being saved.
+    size_t coalescedCount() const;
+
+    //! \return Time from the first request of the latest finished save until the save finished.
+    std::chrono::milliseconds lastLatency() const;
+
+signals:
+
+    void saveFinished(bool success, QString fileName);
+
+private slots:
+
+    void handleSaveFinished(bool success, QString fileName);
+
+private:
+    void startSave();
+
+    SaveFunction m_saveFunction;
+
+    QTimer m_debounceTimer;
+
+    QThreadPool m_threadPool;
+
+    SnapshotFunction m_pendingSnapshotFunction;
+
+    QString m_pendingFileName;
+
+    std::chrono::steady_clock::time_point m_pendingSince;
+
+    std::chrono::steady_clock::time_point m_runningSince;
+
+    bool m_isRunning = false;
+
+    size_t m_coalescedCount = 0;
+
+    std::chrono::milliseconds m_lastLatency { 0 };
+};
+
+#endif // AUTOSAVE_SCHEDULER_HPP
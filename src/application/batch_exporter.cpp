@@ -0,0 +1,332 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "batch_exporter.hpp"
+
+#include "../common/constants.hpp"
+#include "../common/trace_recorder.hpp"
+#include "../domain/layout_optimizer.hpp"
+#include "../domain/mind_map_data.hpp"
+#include "../infra/export_params.hpp"
+#include "../infra/io/alz_file_io.hpp"
+#include "../infra/io/alzb_file_io.hpp"
+#include "../infra/io/outline_importer.hpp"
+#include "../infra/settings.hpp"
+#include "../view/export_snapshot.hpp"
+#include "../view/grid.hpp"
+#include "../view/svg_writer.hpp"
+#include "png_export_job.hpp"
+#include "script_runner.hpp"
+#include "service_container.hpp"
+#include "settings_proxy.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+using juzzlin::L;
+
+static const auto TAG = "BatchExporter";
+
+namespace {
+
+const auto pngFileExtension = ".png";
+
+const auto svgFileExtension = ".svg";
+
+const auto jsonLinesFileExtension = ".jsonl";
+
+const auto outlineFileExtension = ".txt";
+
+const auto mindMapFileExtension = ".alz";
+
+class OptimizationTask : public QRunnable
+{
+public:
+    OptimizationTask(LayoutOptimizer & layoutOptimizer, QString inputFile)
+      : m_layoutOptimizer(layoutOptimizer)
+      , m_inputFile(inputFile)
+    {
+    }
+
+    void run() override
+    {
+        const auto optimizationInfo = m_layoutOptimizer.optimize();
+        juzzlin::L(TAG).info() << "Optimized " << m_inputFile.toStdString() << ": cost " << optimizationInfo.initialCost << " => " << optimizationInfo.finalCost;
+    }
+
+private:
+    LayoutOptimizer & m_layoutOptimizer;
+
+    QString m_inputFile;
+};
+
+//! \return The input file name with the mind map extension replaced by the given one.
+QString outputFileName(QString inputFile, QString extension)
+{
+    const QFileInfo fileInfo { inputFile };
+    return fileInfo.dir().filePath(fileInfo.completeBaseName() + extension);
+}
+
+} // namespace
+
+BatchExporter::BatchExporter(const Options & options)
+  : m_options(options)
+  , m_grid(std::make_unique<Grid>())
+  , m_alzFileIO(std::make_unique<IO::AlzFileIO>())
+  , m_alzbFileIO(std::make_unique<IO::AlzbFileIO>())
+{
+    m_grid->setSize(Settings::Custom::loadGridSize());
+}
+
+BatchExporter::~BatchExporter() = default;
+
+bool BatchExporter::isRequested(int argc, char ** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        for (auto && option : { "--export-png", "--export-svg", "--export-json", "--export-outline", "--script" }) {
+            if (!std::strcmp(argv[i], option)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int BatchExporter::run()
+{
+    if (m_options.inputFiles.isEmpty()) {
+        L(TAG).error() << "No mind map files given to export";
+        return EXIT_FAILURE;
+    }
+
+    if (!imageSize({ 1, 1 }).isValid()) {
+        L(TAG).error() << "Invalid image size: '" << m_options.imageSize.toStdString() << "'";
+        return EXIT_FAILURE;
+    }
+
+    QString program;
+    if (!m_options.scriptFile.isEmpty()) {
+        QFile scriptFile { m_options.scriptFile };
+        if (!scriptFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            L(TAG).error() << "Cannot read script '" << m_options.scriptFile.toStdString() << "'";
+            return EXIT_FAILURE;
+        }
+        program = QString::fromUtf8(scriptFile.readAll());
+    }
+
+    // Only a batch of files is kept in memory at a time, but enough to keep all the cores busy while optimizing
+    const int batchSize = std::max(1, QThread::idealThreadCount());
+    int failureCount = 0;
+    for (int batchBegin = 0; batchBegin < m_options.inputFiles.size(); batchBegin += batchSize) {
+        const auto inputFiles = m_options.inputFiles.mid(batchBegin, batchSize);
+        std::vector<MindMapDataS> mindMaps;
+        for (auto && inputFile : inputFiles) {
+            auto mindMapData = load(inputFile);
+            if (mindMapData && !m_options.scriptFile.isEmpty()) {
+                mindMapData = runScript(mindMapData, inputFile, program);
+            }
+            mindMaps.push_back(mindMapData);
+        }
+
+        if (m_options.optimizeLayout) {
+            optimizeLayouts(mindMaps, inputFiles);
+        }
+
+        for (int i = 0; i < inputFiles.size(); i++) {
+            if (!mindMaps.at(static_cast<size_t>(i)) || !exportFile(mindMaps.at(static_cast<size_t>(i)), inputFiles.at(i))) {
+                failureCount++;
+            }
+        }
+    }
+
+    L(TAG).info() << "Exported " << m_options.inputFiles.size() - failureCount << "/" << m_options.inputFiles.size() << " files";
+
+    return failureCount ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+bool BatchExporter::exportFile(MindMapDataS mindMapData, QString inputFile)
+{
+    const TraceRecorder::ScopedSpan span { "BatchExporter::exportFile" };
+
+    if (!m_options.exportsFiles()) {
+        return save(mindMapData, inputFile);
+    }
+
+    bool success = true;
+    if (m_options.exportPng) {
+        success = exportPng(*mindMapData, outputFileName(inputFile, pngFileExtension)) && success;
+    }
+    if (m_options.exportSvg) {
+        success = exportSvg(*mindMapData, outputFileName(inputFile, svgFileExtension)) && success;
+    }
+    if (m_options.exportJsonLines) {
+        success = exportData(*mindMapData, outputFileName(inputFile, jsonLinesFileExtension), IO::GraphStreamWriter::Format::JsonLines) && success;
+    }
+    if (m_options.exportOutline) {
+        success = exportData(*mindMapData, outputFileName(inputFile, outlineFileExtension), IO::GraphStreamWriter::Format::Outline) && success;
+    }
+    return success;
+}
+
+bool BatchExporter::exportData(MindMapDataR mindMapData, QString fileName, IO::GraphStreamWriter::Format format)
+{
+    L(TAG).info() << "Exporting data to " << fileName.toStdString();
+    return IO::GraphStreamWriter::writeToFile(mindMapData, fileName, format);
+}
+
+bool BatchExporter::exportPng(MindMapDataR mindMapData, QString fileName)
+{
+    auto snapshot = std::make_unique<ExportSnapshot>(mindMapData, nullptr);
+    const auto size = imageSize(snapshot->scene().sceneRect().size());
+    L(TAG).info() << "Exporting a PNG image of size (" << size.width() << "x" << size.height() << ") to " << fileName.toStdString();
+
+    // The job renders a band per event loop iteration, so run a local loop until it's done
+    QEventLoop eventLoop;
+    bool success = false;
+    PngExportJob job { std::move(snapshot), { fileName, size, false } };
+    QObject::connect(&job, &PngExportJob::finished, &eventLoop, [&](bool finished) {
+        success = finished;
+        eventLoop.quit();
+    });
+    job.start();
+    eventLoop.exec();
+
+    if (!success) {
+        L(TAG).error() << "Failed to export " << fileName.toStdString();
+    }
+    return success;
+}
+
+bool BatchExporter::exportSvg(MindMapDataR mindMapData, QString fileName)
+{
+    L(TAG).info() << "Exporting an SVG image to " << fileName.toStdString();
+    ExportSnapshot snapshot { mindMapData, nullptr };
+    return SvgWriter { snapshot.mindMapData(), SC::instance().settingsProxy()->shadowEffect() }.write(fileName, QFileInfo { fileName }.fileName(), snapshot.scene().sceneRect());
+}
+
+MindMapDataS BatchExporter::load(QString inputFile) const
+{
+    L(TAG).info() << "Loading " << inputFile.toStdString();
+    try {
+        // The items of the graph are QObjects, so they are created on the GUI thread
+        if (IO::OutlineImporter::isOutlineFile(inputFile)) {
+            return IO::OutlineImporter::readFromFile(inputFile);
+        }
+        return IO::AlzbFileIO::isAlzbFile(inputFile) ? m_alzbFileIO->fromFile(inputFile) : m_alzFileIO->fromFile(inputFile);
+    } catch (const std::exception & e) {
+        L(TAG).error() << "Failed to load " << inputFile.toStdString() << ": " << e.what();
+        return {};
+    }
+}
+
+MindMapDataS BatchExporter::runScript(MindMapDataS mindMapData, QString inputFile, QString program) const
+{
+    L(TAG).info() << "Running " << m_options.scriptFile.toStdString() << " on " << inputFile.toStdString();
+    auto result = ScriptRunner::run(*mindMapData, program, m_options.scriptFile);
+    if (!result.error.isEmpty()) {
+        L(TAG).error() << "Script failed on " << inputFile.toStdString() << ": " << result.error.toStdString();
+        return {};
+    }
+
+    return result.mindMapData ? MindMapDataS { std::move(result.mindMapData) } : mindMapData;
+}
+
+bool BatchExporter::save(MindMapDataS mindMapData, QString inputFile) const
+{
+    // Outlines don't have the layout and the style, so they are saved as new mind maps
+    const auto fileName = IO::OutlineImporter::isOutlineFile(inputFile) ? outputFileName(inputFile, mindMapFileExtension) : inputFile;
+    L(TAG).info() << "Saving " << fileName.toStdString();
+    return IO::AlzbFileIO::isAlzbFile(fileName) ? m_alzbFileIO->toFile(mindMapData, fileName, false) : m_alzFileIO->toFile(mindMapData, fileName, false);
+}
+
+void BatchExporter::optimizeLayouts(const std::vector<MindMapDataS> & mindMaps, const QStringList & inputFiles) const
+{
+    // Split the cores between the mind maps of the batch
+    const auto replicaCount = std::clamp<size_t>(static_cast<size_t>(QThread::idealThreadCount()) / std::max<size_t>(1, mindMaps.size()), 1, Constants::LayoutOptimizer::maxReplicaCount());
+
+    std::vector<std::unique_ptr<LayoutOptimizer>> layoutOptimizers;
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(static_cast<int>(std::max<size_t>(1, mindMaps.size())));
+    for (size_t i = 0; i < mindMaps.size(); i++) {
+        if (!mindMaps.at(i)) {
+            layoutOptimizers.push_back({});
+            continue;
+        }
+        auto layoutOptimizer = std::make_unique<LayoutOptimizer>(mindMaps.at(i), *m_grid);
+        layoutOptimizer->setReplicaCount(replicaCount);
+        layoutOptimizer->setMultilevelThreshold(Constants::LayoutOptimizer::multilevelNodeCount());
+        layoutOptimizer->setInitialPlacement(LayoutOptimizer::InitialPlacement::Locality);
+        layoutOptimizer->setUseLayoutCache(true);
+        layoutOptimizer->setTimeBudget(m_options.layoutTimeBudget);
+        if (layoutOptimizer->initialize(mindMaps.at(i)->aspectRatio(), mindMaps.at(i)->minEdgeLength())) {
+            threadPool.start(new OptimizationTask(*layoutOptimizer, inputFiles.at(static_cast<int>(i))));
+            layoutOptimizers.push_back(std::move(layoutOptimizer));
+        } else {
+            layoutOptimizers.push_back({});
+        }
+    }
+
+    threadPool.waitForDone();
+
+    // Moving the nodes updates the scene items, so extract on the GUI thread
+    for (auto && layoutOptimizer : layoutOptimizers) {
+        if (layoutOptimizer) {
+            layoutOptimizer->extract();
+        }
+    }
+}
+
+QSize BatchExporter::imageSize(QSizeF sceneSize) const
+{
+    const auto defaultSize = sceneSize.toSize();
+    if (m_options.imageSize.isEmpty()) {
+        return defaultSize;
+    }
+
+    const auto values = m_options.imageSize.split('x');
+    if (values.size() > 2) {
+        return {};
+    }
+
+    bool widthOk = false;
+    const int width = values.at(0).toInt(&widthOk);
+    if (!widthOk || width <= 0) {
+        return {};
+    }
+
+    if (values.size() == 1) {
+        // Keep the aspect ratio of the mind map
+        return { width, std::max(1, static_cast<int>(width * sceneSize.height() / std::max(1.0, sceneSize.width()))) };
+    }
+
+    bool heightOk = false;
+    const int height = values.at(1).toInt(&heightOk);
+    if (!heightOk || height <= 0) {
+        return {};
+    }
+
+    return { width, height };
+}
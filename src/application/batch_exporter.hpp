@@ -0,0 +1,122 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef BATCH_EXPORTER_HPP
+#define BATCH_EXPORTER_HPP
+
+#include <QSize>
+#include <QSizeF>
+#include <QString>
+#include <QStringList>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "../common/types.hpp"
+#include "../infra/io/graph_stream_writer.hpp"
+
+class Grid;
+
+namespace IO {
+class AlzFileIO;
+class AlzbFileIO;
+} // namespace IO
+
+//! Converts mind map files to images or data files from the command line without showing any windows.
+//! The mind maps can be edited by a script before the export.
+//! The files are batched so that the layouts of a batch are optimized in parallel, while
+//! the scenes are rendered on the GUI thread one file at a time.
+class BatchExporter
+{
+public:
+    struct Options
+    {
+        bool enabled() const
+        {
+            return exportPng || exportSvg || exportJsonLines || exportOutline || !scriptFile.isEmpty();
+        }
+
+        bool exportsFiles() const
+        {
+            return exportPng || exportSvg || exportJsonLines || exportOutline;
+        }
+
+        QStringList inputFiles;
+
+        bool exportPng = false;
+
+        bool exportSvg = false;
+
+        bool exportJsonLines = false;
+
+        bool exportOutline = false;
+
+        //! JavaScript file run against each mind map before the layout optimization, see ScriptRunner.
+        //! Without any export options the changed mind maps are saved back to their files.
+        QString scriptFile;
+
+        //! "W" or "WxH". If only the width is given, the aspect ratio of the mind map is kept.
+        //! If empty, the size of the mind map in the scene is used.
+        QString imageSize;
+
+        bool optimizeLayout = false;
+
+        //! Wall-clock limit of the optimization of each mind map, 0 for no limit.
+        std::chrono::milliseconds layoutTimeBudget { 0 };
+    };
+
+    explicit BatchExporter(const Options & options);
+
+    ~BatchExporter();
+
+    //! \return true if the given command line requests a batch export. Used to select the
+    //! platform plugin before QApplication is instantiated.
+    static bool isRequested(int argc, char ** argv);
+
+    //! \return EXIT_SUCCESS if all files were exported.
+    int run();
+
+private:
+    bool exportData(MindMapDataR mindMapData, QString fileName, IO::GraphStreamWriter::Format format);
+
+    bool exportFile(MindMapDataS mindMapData, QString inputFile);
+
+    bool exportPng(MindMapDataR mindMapData, QString fileName);
+
+    bool exportSvg(MindMapDataR mindMapData, QString fileName);
+
+    MindMapDataS load(QString inputFile) const;
+
+    //! \return The changed mind map, the given mind map if the script didn't change it, or nullptr on failure.
+    MindMapDataS runScript(MindMapDataS mindMapData, QString inputFile, QString program) const;
+
+    bool save(MindMapDataS mindMapData, QString inputFile) const;
+
+    void optimizeLayouts(const std::vector<MindMapDataS> & mindMaps, const QStringList & inputFiles) const;
+
+    //! \return Image size for the given scene size, or an invalid size if the size option is malformed.
+    QSize imageSize(QSizeF sceneSize) const;
+
+    Options m_options;
+
+    std::unique_ptr<Grid> m_grid;
+
+    std::unique_ptr<IO::AlzFileIO> m_alzFileIO;
+
+    std::unique_ptr<IO::AlzbFileIO> m_alzbFileIO;
+};
+
+#endif // BATCH_EXPORTER_HPP
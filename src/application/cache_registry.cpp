@@ -0,0 +1,58 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "cache_registry.hpp"
+
+#include "simple_logger.hpp"
+
+static const auto TAG = "CacheRegistry";
+
+CacheRegistry::Id CacheRegistry::add(Cache cache)
+{
+    m_caches.emplace(m_nextId, std::move(cache));
+    return m_nextId++;
+}
+
+void CacheRegistry::remove(Id id)
+{
+    m_caches.erase(id);
+}
+
+size_t CacheRegistry::trim(TrimReason reason)
+{
+    size_t bytes = 0;
+    for (auto && [id, cache] : m_caches) {
+        const auto reclaimed = cache.trim(reason == TrimReason::MemoryPressure ? 0 : cache.backgroundBudget);
+        juzzlin::L(TAG).debug() << "Trimmed " << cache.name.toStdString() << ": " << reclaimed << " bytes";
+        bytes += reclaimed;
+    }
+
+    m_reclaimed += { 1, bytes };
+    juzzlin::L(TAG).info() << "Gave back " << bytes << " bytes " << (reason == TrimReason::MemoryPressure ? "on memory pressure" : "in the background");
+
+    return bytes;
+}
+
+MemoryReport CacheRegistry::memoryReport() const
+{
+    MemoryReport report;
+    for (auto && [id, cache] : m_caches) {
+        if (cache.memoryUsage) {
+            report.entries.push_back({ cache.name, cache.memoryUsage() });
+        }
+    }
+    report.reclaimed = m_reclaimed;
+    return report;
+}
@@ -0,0 +1,77 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef CACHE_REGISTRY_HPP
+#define CACHE_REGISTRY_HPP
+
+#include <QString>
+
+#include <functional>
+#include <map>
+
+#include "memory_report.hpp"
+
+//! Central list of the in-memory caches that can give memory back, e.g. the decoded images, the pixmaps and the
+//! text sizes. When the application has been in the background for a while the caches are trimmed to their
+//! background budgets, and when the system runs low on memory they are emptied. Each cache drops its least
+//! recently used entries first. Only used from the GUI thread.
+class CacheRegistry
+{
+public:
+    enum class TrimReason
+    {
+        Background,
+        MemoryPressure
+    };
+
+    struct Cache
+    {
+        QString name;
+
+        //! Bytes the cache may keep in the background.
+        size_t backgroundBudget = 0;
+
+        //! Drops the least recently used entries until at most the given bytes remain.
+        //! \returns The bytes given back, as far as they are known.
+        std::function<size_t(size_t bytes)> trim;
+
+        //! \returns The entries and the bytes of the cache for the memory report. Empty if they are already
+        //! reported elsewhere or not known.
+        std::function<MemoryUsage()> memoryUsage;
+    };
+
+    using Id = size_t;
+
+    Id add(Cache cache);
+
+    void remove(Id id);
+
+    //! Trims all caches, to their background budgets or completely on memory pressure.
+    //! \returns The bytes given back.
+    size_t trim(TrimReason reason);
+
+    //! \returns The usage of the caches that report it, and the trims so far as MemoryReport::reclaimed.
+    MemoryReport memoryReport() const;
+
+private:
+    std::map<Id, Cache> m_caches;
+
+    Id m_nextId = 0;
+
+    //! Trim count and the total bytes given back.
+    MemoryUsage m_reclaimed;
+};
+
+#endif // CACHE_REGISTRY_HPP
@@ -0,0 +1,582 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "collaboration_session.hpp"
+
+#include "../common/constants.hpp"
+#include "../common/trace_recorder.hpp"
+#include "../domain/graph.hpp"
+#include "../domain/image_manager.hpp"
+#include "../domain/mind_map_data.hpp"
+#include "../infra/io/edit_operation.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QDataStream>
+#include <QMessageAuthenticationCode>
+#include <QPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+#include <QRandomGenerator>
+#endif
+
+#include <algorithm>
+#include <random>
+#include <unordered_set>
+
+using juzzlin::L;
+
+static const auto TAG = "CollaborationSession";
+
+enum class CollaborationSession::FrameType : quint8
+{
+    Challenge,
+    Response,
+    Operation,
+    Echo
+};
+
+namespace {
+
+// The type and the payload size
+const int FRAME_HEADER_SIZE = sizeof(quint8) + sizeof(quint32);
+
+const int CHALLENGE_SIZE = 32;
+
+// A peer that hasn't answered the challenge may only send the response
+const int MAX_HANDSHAKE_FRAME_SIZE = 64;
+
+QByteArray randomBytes(int count)
+{
+    QByteArray bytes { count, Qt::Uninitialized };
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    QRandomGenerator::system()->fillRange(reinterpret_cast<quint32 *>(bytes.data()), count / static_cast<int>(sizeof(quint32)));
+#else
+    std::random_device device;
+    for (auto && byte : bytes) {
+        byte = static_cast<char>(device());
+    }
+#endif
+    return bytes;
+}
+
+QByteArray sign(const QByteArray & challenge, QString secret)
+{
+    return QMessageAuthenticationCode::hash(challenge, secret.toUtf8(), QCryptographicHash::Sha256);
+}
+
+//! Compares in constant time, so that the timing doesn't tell how much of a response was right.
+bool isEqual(const QByteArray & data, const QByteArray & other)
+{
+    if (data.size() != other.size()) {
+        return false;
+    }
+    char difference = 0;
+    for (int i = 0; i < data.size(); i++) {
+        difference |= data.at(i) ^ other.at(i);
+    }
+    return !difference;
+}
+
+} // namespace
+
+CollaborationSession::CollaborationSession()
+{
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(0);
+    connect(&m_flushTimer, &QTimer::timeout, this, &CollaborationSession::flush);
+}
+
+CollaborationSession::~CollaborationSession()
+{
+    stop();
+}
+
+bool CollaborationSession::host(quint16 port, QString secret, const QHostAddress & address)
+{
+    stop();
+
+    m_secret = secret.isEmpty() ? QString::fromLatin1(randomBytes(16).toHex()) : secret;
+    m_server = std::make_unique<QTcpServer>();
+    if (!m_server->listen(address, port)) {
+        m_errorString = m_server->errorString();
+        L(TAG).error() << "Cannot host a session on port " << port << ": " << m_errorString.toStdString();
+        m_server.reset();
+        return false;
+    }
+
+    connect(m_server.get(), &QTcpServer::newConnection, this, &CollaborationSession::acceptPeers);
+    m_isSynced = true;
+    m_flushTimer.start();
+
+    L(TAG).info() << "Hosting a session on " << address.toString().toStdString() << ":" << m_server->serverPort();
+
+    return true;
+}
+
+void CollaborationSession::join(QString hostName, quint16 port, QString secret)
+{
+    stop();
+
+    m_secret = secret;
+
+    L(TAG).info() << "Joining the session on " << hostName.toStdString() << ":" << port;
+
+    const auto socket = new QTcpSocket { this };
+    addPeer(*socket);
+    connect(socket, &QTcpSocket::connected, this, [this] {
+        emit peerCountChanged(m_peers.size());
+    });
+    socket->connectToHost(hostName, port);
+    m_isSynced = false;
+    m_flushTimer.start();
+}
+
+void CollaborationSession::stop()
+{
+    for (auto && peer : m_peers) {
+        peer->disconnect(this);
+        peer->abort();
+        peer->deleteLater();
+    }
+    m_peers.clear();
+    for (auto && challenge : m_challenges) {
+        challenge.first->disconnect(this);
+        challenge.first->abort();
+        challenge.first->deleteLater();
+    }
+    m_challenges.clear();
+    m_server.reset();
+    m_flushTimer.stop();
+    unsubscribe();
+    m_changedNodeIndices.clear();
+    m_changedEdges.clear();
+    m_isStyleChanged = false;
+    m_isResetPending = false;
+    m_isSynced = false;
+    m_pendingEchoes.clear();
+    m_knownImageIds.clear();
+}
+
+bool CollaborationSession::isActive() const
+{
+    return m_server || !m_peers.empty();
+}
+
+bool CollaborationSession::isHost() const
+{
+    return m_server != nullptr;
+}
+
+quint16 CollaborationSession::port() const
+{
+    return m_server ? m_server->serverPort() : 0;
+}
+
+size_t CollaborationSession::peerCount() const
+{
+    return m_peers.size();
+}
+
+QString CollaborationSession::errorString() const
+{
+    return m_errorString;
+}
+
+QString CollaborationSession::secret() const
+{
+    return m_secret;
+}
+
+void CollaborationSession::setMindMapData(MindMapDataS mindMapData)
+{
+    unsubscribe();
+    m_mindMapData = mindMapData;
+    m_changedNodeIndices.clear();
+    m_changedEdges.clear();
+    m_isStyleChanged = false;
+
+    // Subscribed on the next flush, as accessing the graph creates the scene items of a mind map just loaded
+    if (isActive()) {
+        m_isResetPending = !m_isReceiving;
+        m_flushTimer.start();
+    }
+}
+
+void CollaborationSession::acceptPeers()
+{
+    while (const auto socket = m_server->nextPendingConnection()) {
+        L(TAG).info() << "Peer connected from " << socket->peerAddress().toString().toStdString();
+        socket->setParent(this);
+        connectSocket(*socket);
+
+        // The peer gets nothing before it has proven that it knows the secret
+        const auto challenge = randomBytes(CHALLENGE_SIZE);
+        m_challenges[socket] = challenge;
+        send(*socket, FrameType::Challenge, challenge);
+
+        const QPointer<QTcpSocket> socketPointer { socket };
+        QTimer::singleShot(static_cast<int>(Constants::Application::sessionHandshakeTimeout().count()), socket, [this, socketPointer] {
+            if (socketPointer && m_challenges.count(socketPointer)) {
+                removePeer(*socketPointer, tr("The peer didn't answer the challenge in time"));
+            }
+        });
+    }
+}
+
+void CollaborationSession::addPeer(QTcpSocket & socket)
+{
+    m_peers.push_back(&socket);
+    connectSocket(socket);
+}
+
+void CollaborationSession::authenticate(QTcpSocket & socket, const QByteArray & response)
+{
+    const auto challenge = m_challenges.at(&socket);
+    m_challenges.erase(&socket);
+    if (!isEqual(response, sign(challenge, m_secret))) {
+        L(TAG).warning() << "Rejected a peer from " << socket.peerAddress().toString().toStdString() << " with a wrong secret";
+        socket.disconnect(this);
+        socket.abort();
+        socket.deleteLater();
+        return;
+    }
+
+    L(TAG).info() << "Peer joined from " << socket.peerAddress().toString().toStdString();
+    m_peers.push_back(&socket);
+    if (const auto mindMapData = m_mindMapData.lock()) {
+        const auto operation = IO::EditOperation::reset(*mindMapData);
+        for (auto && image : operation.images) {
+            m_knownImageIds.insert(image.id());
+        }
+        send(socket, FrameType::Operation, operation.encode());
+    }
+    emit peerCountChanged(m_peers.size());
+}
+
+void CollaborationSession::connectSocket(QTcpSocket & socket)
+{
+    // An edit should get through at once instead of waiting for more data to fill a packet
+    socket.setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+    // Bounds the memory that a peer can make us buffer to the largest frame, see receive()
+    socket.setReadBufferSize(FRAME_HEADER_SIZE + Constants::Application::sessionMaxFrameSize());
+
+    const auto socketPointer = &socket;
+    connect(&socket, &QTcpSocket::readyRead, this, [this, socketPointer] {
+        receive(*socketPointer);
+    });
+    connect(&socket, &QTcpSocket::disconnected, this, [this, socketPointer] {
+        removePeer(*socketPointer, tr("The connection was closed"));
+    });
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    connect(&socket, &QTcpSocket::errorOccurred, this, [this, socketPointer] {
+#else
+    connect(&socket, QOverload<QAbstractSocket::SocketError>::of(&QTcpSocket::error), this, [this, socketPointer] {
+#endif
+        removePeer(*socketPointer, socketPointer->errorString());
+    });
+}
+
+void CollaborationSession::apply(const IO::EditOperation & operation)
+{
+    const TraceRecorder::ScopedSpan span { "CollaborationSession::apply" };
+
+    for (auto && image : operation.images) {
+        m_knownImageIds.insert(image.id());
+    }
+
+    m_isReceiving = true;
+    emit operationReceived(operation);
+    m_isReceiving = false;
+}
+
+void CollaborationSession::flush()
+{
+    const auto mindMapData = m_mindMapData.lock();
+    if (!mindMapData || !isActive()) {
+        return;
+    }
+
+    auto && graph = mindMapData->graph();
+    if (!m_subscriptionId) {
+        m_subscriptionId = graph.changeNotifier().subscribe([this](const GraphChangeBatch & changes) {
+            handleChanges(changes);
+        });
+    }
+
+    if (!m_isSynced) {
+        m_changedNodeIndices.clear();
+        m_changedEdges.clear();
+        m_isStyleChanged = false;
+        m_isResetPending = false;
+        return;
+    }
+
+    IO::EditOperation operation;
+    if (m_isResetPending) {
+        operation = IO::EditOperation::reset(*mindMapData);
+        for (auto && image : operation.images) {
+            m_knownImageIds.insert(image.id());
+        }
+    } else {
+        if (m_changedNodeIndices.empty() && m_changedEdges.empty() && !m_isStyleChanged) {
+            return;
+        }
+
+        // A changed item is removed and added like in the deltas of undo, a deleted one only removed
+        for (auto && index : m_changedNodeIndices) {
+            SceneItems::NodeModel removedModel { QColor {}, QColor {} };
+            removedModel.index = index;
+            operation.delta.removedNodes.push_back(removedModel);
+            if (graph.hasNode(index)) {
+                const auto & model = graph.getNode(index)->model();
+                operation.delta.addedNodes.push_back(model);
+                if (model.imageRef && !m_knownImageIds.count(model.imageRef)) {
+                    if (const auto image = mindMapData->imageManager().getImage(model.imageRef)) {
+                        operation.images.push_back(*image);
+                        m_knownImageIds.insert(model.imageRef);
+                    }
+                }
+            }
+        }
+        for (auto && indices : m_changedEdges) {
+            operation.delta.removedEdges.push_back({ { false, SceneItems::EdgeModel::Style { SceneItems::EdgeModel::ArrowMode::Single } }, indices.first, indices.second });
+            if (const auto edge = graph.getEdge(indices.first, indices.second)) {
+                operation.delta.addedEdges.push_back({ edge->model(), indices.first, indices.second });
+            }
+        }
+        if (m_isStyleChanged) {
+            operation.styleData = mindMapData->styleData();
+        }
+    }
+
+    m_changedNodeIndices.clear();
+    m_changedEdges.clear();
+    m_isStyleChanged = false;
+    m_isResetPending = false;
+
+    const auto payload = operation.encode();
+    L(TAG).trace() << "Sending " << operation.delta.addedNodes.size() << " nodes and " << operation.delta.addedEdges.size() << " edges in " << payload.size() << " bytes";
+    for (auto && peer : m_peers) {
+        send(*peer, FrameType::Operation, payload);
+    }
+    if (!isHost()) {
+        m_pendingEchoes.push_back(false);
+    }
+}
+
+void CollaborationSession::handleChanges(const GraphChangeBatch & changes)
+{
+    if (m_isReceiving) {
+        return;
+    }
+
+    for (auto && change : changes) {
+        switch (change.type) {
+        case GraphChange::Type::NodeAdded:
+        case GraphChange::Type::NodeRemoved:
+        case GraphChange::Type::NodeMoved:
+        case GraphChange::Type::NodeRestyled:
+        case GraphChange::Type::NodeTexted:
+            m_changedNodeIndices.insert(change.nodeIndex);
+            break;
+        case GraphChange::Type::EdgeAdded:
+        case GraphChange::Type::EdgeRemoved:
+        case GraphChange::Type::EdgeRestyled:
+        case GraphChange::Type::EdgeTexted:
+            m_changedEdges.insert({ change.sourceIndex, change.targetIndex });
+            break;
+        case GraphChange::Type::StyleChanged:
+            m_isStyleChanged = true;
+            break;
+        }
+    }
+
+    if (!m_flushTimer.isActive()) {
+        m_flushTimer.start();
+    }
+}
+
+void CollaborationSession::handleFrame(QTcpSocket & socket, FrameType type, const QByteArray & payload)
+{
+    if (m_challenges.count(&socket)) {
+        if (type == FrameType::Response) {
+            authenticate(socket, payload);
+        } else {
+            removePeer(socket, tr("The peer didn't answer the challenge"));
+        }
+        return;
+    }
+
+    switch (type) {
+    case FrameType::Challenge:
+        if (!isHost() && payload.size() == CHALLENGE_SIZE) {
+            send(socket, FrameType::Response, sign(payload, m_secret));
+        }
+        break;
+    case FrameType::Response:
+        break;
+    case FrameType::Operation:
+    case FrameType::Echo:
+        handleOperation(socket, type == FrameType::Echo, payload);
+        break;
+    }
+}
+
+void CollaborationSession::handleOperation(QTcpSocket & socket, bool isEcho, const QByteArray & payload)
+{
+    const auto operation = IO::EditOperation::decode(payload);
+    if (!operation || !isValid(*operation)) {
+        L(TAG).warning() << "Ignoring an invalid operation of " << payload.size() << " bytes";
+        if (isHost()) {
+            removePeer(socket, tr("The peer sent an invalid edit"));
+        }
+        return;
+    }
+
+    if (isHost()) {
+        apply(*operation);
+        for (auto && peer : m_peers) {
+            send(*peer, peer == &socket ? FrameType::Echo : FrameType::Operation, payload);
+        }
+    } else if (isEcho) {
+        // Otherwise the operation is still the latest one on its items here
+        if (!m_pendingEchoes.empty()) {
+            const auto isOvertaken = m_pendingEchoes.front();
+            m_pendingEchoes.pop_front();
+            if (isOvertaken) {
+                apply(*operation);
+            }
+        }
+    } else {
+        m_isSynced = m_isSynced || operation->isReset;
+        std::fill(m_pendingEchoes.begin(), m_pendingEchoes.end(), true);
+        apply(*operation);
+    }
+}
+
+bool CollaborationSession::isValid(const IO::EditOperation & operation) const
+{
+    const auto mindMapData = m_mindMapData.lock();
+    if (!mindMapData) {
+        return false;
+    }
+
+    auto && graph = mindMapData->graph();
+    const auto & delta = operation.delta;
+    const auto nodeCount = (operation.isReset ? 0 : graph.nodeCount()) + delta.addedNodes.size();
+    std::unordered_set<int> addedIndices;
+    for (auto && node : delta.addedNodes) {
+        // The slots below the next index are already allocated, also those of the deleted nodes
+        const bool isAllocated = !operation.isReset && node.index < graph.nextNodeIndex();
+        if (node.index < 0 || (!isAllocated && !Graph::isValidNodeIndex(node.index, nodeCount))) {
+            return false;
+        }
+        addedIndices.insert(node.index);
+    }
+
+    std::unordered_set<int> removedIndices;
+    for (auto && node : delta.removedNodes) {
+        removedIndices.insert(node.index);
+    }
+
+    const auto exists = [&](int index) {
+        return addedIndices.count(index) || (!operation.isReset && !removedIndices.count(index) && graph.hasNode(index));
+    };
+    return std::all_of(delta.addedEdges.begin(), delta.addedEdges.end(), [&](auto && edge) {
+        return exists(edge.sourceIndex) && exists(edge.targetIndex);
+    });
+}
+
+void CollaborationSession::receive(QTcpSocket & socket)
+{
+    // The socket is deleted later if the session is stopped meanwhile
+    const QPointer<QTcpSocket> socketPointer { &socket };
+    while (socketPointer && (std::count(m_peers.begin(), m_peers.end(), &socket) || m_challenges.count(&socket)) && socket.bytesAvailable() >= FRAME_HEADER_SIZE) {
+        QDataStream header { socket.peek(FRAME_HEADER_SIZE) };
+        quint8 type = 0;
+        quint32 size = 0;
+        header >> type >> size;
+
+        // Checked before the payload is buffered, so that a peer can't make us allocate more
+        const auto maxSize = m_challenges.count(&socket) ? MAX_HANDSHAKE_FRAME_SIZE : Constants::Application::sessionMaxFrameSize();
+        if (type > static_cast<quint8>(FrameType::Echo) || size > static_cast<quint32>(maxSize)) {
+            L(TAG).warning() << "Invalid frame of type " << static_cast<int>(type) << " and " << size << " bytes";
+            removePeer(socket, tr("The peer sent invalid data"));
+            return;
+        }
+
+        if (socket.bytesAvailable() < FRAME_HEADER_SIZE + static_cast<qint64>(size)) {
+            return;
+        }
+
+        socket.read(FRAME_HEADER_SIZE);
+        handleFrame(socket, static_cast<FrameType>(type), socket.read(size));
+    }
+}
+
+void CollaborationSession::removePeer(QTcpSocket & socket, QString reason)
+{
+    if (m_challenges.erase(&socket)) {
+        L(TAG).info() << "Peer dropped before joining: " << reason.toStdString();
+        socket.disconnect(this);
+        socket.abort();
+        socket.deleteLater();
+        return;
+    }
+
+    const auto iter = std::find(m_peers.begin(), m_peers.end(), &socket);
+    if (iter == m_peers.end()) {
+        return;
+    }
+
+    L(TAG).info() << "Peer left: " << reason.toStdString();
+
+    m_peers.erase(iter);
+    socket.disconnect(this);
+    socket.abort();
+    socket.deleteLater();
+
+    if (isHost()) {
+        emit peerCountChanged(m_peers.size());
+    } else {
+        stop();
+        emit ended(reason);
+    }
+}
+
+void CollaborationSession::send(QTcpSocket & socket, FrameType type, const QByteArray & payload)
+{
+    if (payload.size() > Constants::Application::sessionMaxFrameSize()) {
+        L(TAG).error() << "Cannot send " << payload.size() << " bytes, the peers accept at most " << Constants::Application::sessionMaxFrameSize();
+        return;
+    }
+
+    QDataStream out { &socket };
+    out << static_cast<quint8>(type) << static_cast<quint32>(payload.size());
+    out.writeRawData(payload.constData(), payload.size());
+}
+
+void CollaborationSession::unsubscribe()
+{
+    if (m_subscriptionId) {
+        if (const auto mindMapData = m_mindMapData.lock()) {
+            mindMapData->graph().changeNotifier().unsubscribe(m_subscriptionId);
+        }
+        m_subscriptionId = 0;
+    }
+}
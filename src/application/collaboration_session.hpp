@@ -0,0 +1,177 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef COLLABORATION_SESSION_HPP
+#define COLLABORATION_SESSION_HPP
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../common/types.hpp"
+#include "../domain/graph_change_notifier.hpp"
+
+class QTcpServer;
+class QTcpSocket;
+
+namespace IO {
+struct EditOperation;
+}
+
+//! Shares the edits of a mind map with other instances over TCP. One instance hosts the session and the others
+//! join it. The local changes are collected from the change stream of the graph and sent as compact operations
+//! of only the changed items, so that an edit costs the same however large the mind map is.
+//!
+//! The host orders the operations: it applies the operations of the peers and relays them to all of them,
+//! including the sender. A peer applies its own operation again only if operations of others came in between,
+//! so that all the instances end up in the order of the host. Concurrent edits of the same item are resolved
+//! by the host's order, and nodes added concurrently with the same index replace each other.
+//!
+//! A peer gets the mind map only after it has answered a random challenge of the host with an HMAC keyed with
+//! the secret of the session, so that the secret itself is never sent. The frames and the inflated operations
+//! are limited in size, and operations that refer to invalid nodes are not applied.
+class CollaborationSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    CollaborationSession();
+
+    ~CollaborationSession() override;
+
+    //! Starts a session that other instances can join.
+    //! \param secret The secret that the peers must know. A random one is generated if empty, see secret().
+    //! \param address Only the instances of this computer can join by default.
+    //! \returns false if listening on the given port failed, see errorString().
+    bool host(quint16 port, QString secret = {}, const QHostAddress & address = QHostAddress::LocalHost);
+
+    //! Connects to a hosted session. The mind map gets replaced by the one of the host once connected.
+    void join(QString hostName, quint16 port, QString secret);
+
+    void stop();
+
+    bool isActive() const;
+
+    bool isHost() const;
+
+    //! \returns The port that the host listens to, e.g. one chosen by the system for port 0.
+    quint16 port() const;
+
+    size_t peerCount() const;
+
+    QString errorString() const;
+
+    QString secret() const;
+
+    //! Follows the changes of the given mind map. A new mind map is sent to the peers as a whole,
+    //! unless it came from them.
+    void setMindMapData(MindMapDataS mindMapData);
+
+signals:
+
+    //! Emitted for each edit of the peers. The edit must be applied before returning,
+    //! so that the changes that it causes are not sent back.
+    void operationReceived(const IO::EditOperation & operation);
+
+    void peerCountChanged(size_t peerCount);
+
+    //! Emitted when a joined session is lost.
+    void ended(QString reason);
+
+private:
+    enum class FrameType : quint8;
+
+    void acceptPeers();
+
+    void addPeer(QTcpSocket & socket);
+
+    void apply(const IO::EditOperation & operation);
+
+    //! Lets the peer join if it answered the challenge with the secret.
+    void authenticate(QTcpSocket & socket, const QByteArray & response);
+
+    void connectSocket(QTcpSocket & socket);
+
+    void flush();
+
+    void handleChanges(const GraphChangeBatch & changes);
+
+    void handleFrame(QTcpSocket & socket, FrameType type, const QByteArray & payload);
+
+    void handleOperation(QTcpSocket & socket, bool isEcho, const QByteArray & payload);
+
+    //! \returns true if the operation refers only to nodes that exist after it, with indices that the graph accepts.
+    bool isValid(const IO::EditOperation & operation) const;
+
+    void receive(QTcpSocket & socket);
+
+    //! Closes the connection, e.g. when the peer left or sent invalid data.
+    void removePeer(QTcpSocket & socket, QString reason);
+
+    void send(QTcpSocket & socket, FrameType type, const QByteArray & payload);
+
+    void unsubscribe();
+
+    std::unique_ptr<QTcpServer> m_server;
+
+    //! Only the host when joined.
+    std::vector<QTcpSocket *> m_peers;
+
+    //! The connections to the host that have not answered their challenge yet, with the challenge.
+    std::map<QTcpSocket *, QByteArray> m_challenges;
+
+    QString m_secret;
+
+    //! Not owned, so that the replaced mind maps can be torn down as usual.
+    std::weak_ptr<MindMapData> m_mindMapData;
+
+    GraphChangeNotifier::SubscriptionId m_subscriptionId = 0;
+
+    //! The changes of one event loop iteration, e.g. of a drag step, are sent in one operation.
+    QTimer m_flushTimer;
+
+    std::unordered_set<int> m_changedNodeIndices;
+
+    std::set<std::pair<int, int>> m_changedEdges;
+
+    bool m_isStyleChanged = false;
+
+    bool m_isResetPending = false;
+
+    //! A joined peer sends nothing before it has got the mind map of the host.
+    bool m_isSynced = false;
+
+    bool m_isReceiving = false;
+
+    //! For each own operation not yet relayed back by the host: whether operations of others came in between.
+    std::deque<bool> m_pendingEchoes;
+
+    std::unordered_set<size_t> m_knownImageIds;
+
+    QString m_errorString;
+};
+
+#endif // COLLABORATION_SESSION_HPP
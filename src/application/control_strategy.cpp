@@ -15,13 +15,14 @@
 
 #include "control_strategy.hpp"
 
-#include "service_container.hpp"
 #include "settings_proxy.hpp"
+#include "settings_snapshot.hpp"
 
 #include <QGuiApplication>
 #include <QMouseEvent>
 
-ControlStrategy::ControlStrategy()
+ControlStrategy::ControlStrategy(SettingsProxyS settingsProxy)
+  : m_settingsProxy(settingsProxy)
 {
 }
 
@@ -33,14 +34,14 @@ bool ControlStrategy::isModifierPressed() const
 
 bool ControlStrategy::backgroundDragInitiated(QMouseEvent & event) const
 {
-    const bool invertedControls = SC::instance().settingsProxy()->invertedControls();
+    const bool invertedControls = m_settingsProxy->snapshot()->invertedControls;
 
     return (invertedControls == isModifierPressed()) && event.button() == Qt::LeftButton;
 }
 
 bool ControlStrategy::rubberBandInitiated(QMouseEvent & event) const
 {
-    const bool invertedControls = SC::instance().settingsProxy()->invertedControls();
+    const bool invertedControls = m_settingsProxy->snapshot()->invertedControls;
 
     return ((!invertedControls ^ !isModifierPressed()) && (event.button() == Qt::LeftButton)) || event.button() == Qt::MiddleButton;
 }
@@ -16,13 +16,15 @@
 #ifndef CONTROL_STRATEGY_HPP
 #define CONTROL_STRATEGY_HPP
 
+#include "../common/types.hpp"
+
 class QMouseEvent;
 class QString;
 
 class ControlStrategy
 {
 public:
-    ControlStrategy();
+    explicit ControlStrategy(SettingsProxyS settingsProxy);
 
     virtual ~ControlStrategy();
 
@@ -43,6 +45,8 @@ public:
 private:
     bool isModifierPressed() const;
 
+    SettingsProxyS m_settingsProxy;
+
     bool m_invertedMode = false;
 };
 
@@ -0,0 +1,136 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "diff_reporter.hpp"
+
+#include "../domain/mind_map_data.hpp"
+#include "../domain/mind_map_diff.hpp"
+#include "../infra/io/alz_file_io.hpp"
+#include "../infra/io/alzb_file_io.hpp"
+
+#include "simple_logger.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using juzzlin::L;
+
+static const auto TAG = "DiffReporter";
+
+namespace {
+
+const int errorExitCode = 2;
+
+QString changeName(MindMapDiff::Change change)
+{
+    switch (change) {
+    case MindMapDiff::Change::Added:
+        return "Added";
+    case MindMapDiff::Change::Removed:
+        return "Removed";
+    case MindMapDiff::Change::Moved:
+        return "Moved";
+    case MindMapDiff::Change::Edited:
+        return "Edited";
+    }
+    return {};
+}
+
+QString quoted(QString text)
+{
+    return "\"" + text.replace('\n', ' ') + "\"";
+}
+
+} // namespace
+
+DiffReporter::DiffReporter(const Options & options)
+  : m_options(options)
+  , m_alzFileIO(std::make_unique<IO::AlzFileIO>())
+  , m_alzbFileIO(std::make_unique<IO::AlzbFileIO>())
+{
+}
+
+DiffReporter::~DiffReporter() = default;
+
+bool DiffReporter::isRequested(int argc, char ** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--diff")) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QStringList DiffReporter::report(const MindMapDiff & diff)
+{
+    QStringList lines;
+    for (auto && nodeChange : diff.nodeChanges()) {
+        auto line = changeName(nodeChange.change) + " node ";
+        if (nodeChange.change == MindMapDiff::Change::Removed) {
+            line += QString::number(nodeChange.oldIndex);
+        } else {
+            line += QString::number(nodeChange.newIndex);
+            if (nodeChange.oldIndex != -1 && nodeChange.oldIndex != nodeChange.newIndex) {
+                line += QString { " (was %1)" }.arg(nodeChange.oldIndex);
+            }
+        }
+        lines << line + " " + quoted(nodeChange.text);
+    }
+
+    for (auto && edgeChange : diff.edgeChanges()) {
+        lines << QString { "%1 edge %2 -> %3 %4" }.arg(changeName(edgeChange.change)).arg(edgeChange.sourceIndex).arg(edgeChange.targetIndex).arg(quoted(edgeChange.text));
+    }
+
+    using Change = MindMapDiff::Change;
+    lines << QString { "Nodes: %1 added, %2 removed, %3 moved, %4 edited. Edges: %5 added, %6 removed, %7 edited." }
+               .arg(diff.nodeCount(Change::Added))
+               .arg(diff.nodeCount(Change::Removed))
+               .arg(diff.nodeCount(Change::Moved))
+               .arg(diff.nodeCount(Change::Edited))
+               .arg(diff.edgeCount(Change::Added))
+               .arg(diff.edgeCount(Change::Removed))
+               .arg(diff.edgeCount(Change::Edited));
+
+    return lines;
+}
+
+int DiffReporter::run()
+{
+    if (m_options.inputFiles.size() != 2) {
+        L(TAG).error() << "Two mind map files are needed for a diff";
+        return errorExitCode;
+    }
+
+    std::vector<MindMapDataU> mindMaps;
+    for (auto && inputFile : m_options.inputFiles) {
+        try {
+            mindMaps.push_back(IO::AlzbFileIO::isAlzbFile(inputFile) ? m_alzbFileIO->fromFile(inputFile) : m_alzFileIO->fromFile(inputFile));
+        } catch (const std::exception & e) {
+            L(TAG).error() << "Failed to load " << inputFile.toStdString() << ": " << e.what();
+            return errorExitCode;
+        }
+    }
+
+    // Only the plain data of the graphs is compared, so no scene items get created
+    const MindMapDiff diff { mindMaps.at(0)->graphSnapshot(), mindMaps.at(1)->graphSnapshot() };
+    for (auto && line : report(diff)) {
+        std::cout << line.toStdString() << std::endl;
+    }
+
+    return diff.isEmpty() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
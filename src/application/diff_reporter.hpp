@@ -0,0 +1,66 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef DIFF_REPORTER_HPP
+#define DIFF_REPORTER_HPP
+
+#include <QString>
+#include <QStringList>
+
+#include <memory>
+
+class MindMapDiff;
+
+namespace IO {
+class AlzFileIO;
+class AlzbFileIO;
+} // namespace IO
+
+//! Compares two mind map files from the command line without showing any windows, e.g. to check generated
+//! mind maps in continuous integration. Prints a line per change and a summary like diff, see MindMapDiff.
+class DiffReporter
+{
+public:
+    struct Options
+    {
+        bool enabled = false;
+
+        //! The old and the new version.
+        QStringList inputFiles;
+    };
+
+    explicit DiffReporter(const Options & options);
+
+    ~DiffReporter();
+
+    //! \return true if the given command line requests a diff. Used to select the
+    //! platform plugin before QApplication is instantiated.
+    static bool isRequested(int argc, char ** argv);
+
+    //! \return The lines that describe the given diff, followed by the summary.
+    static QStringList report(const MindMapDiff & diff);
+
+    //! \return EXIT_SUCCESS if the files have no differences, EXIT_FAILURE if they have and 2 if they can't be compared.
+    int run();
+
+private:
+    Options m_options;
+
+    std::unique_ptr<IO::AlzFileIO> m_alzFileIO;
+
+    std::unique_ptr<IO::AlzbFileIO> m_alzbFileIO;
+};
+
+#endif // DIFF_REPORTER_HPP
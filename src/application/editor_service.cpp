@@ -15,41 +15,164 @@
 
 #include "editor_service.hpp"
 
+#include "../application/autosave_scheduler.hpp"
 #include "../application/recent_files_manager.hpp"
 #include "../application/service_container.hpp"
 #include "../application/settings_proxy.hpp"
+#include "../application/settings_snapshot.hpp"
+#include "../application/teardown_scheduler.hpp"
+#include "../application/thumbnail_cache.hpp"
 #include "../common/constants.hpp"
 #include "../common/test_mode.hpp"
 #include "../domain/graph.hpp"
+#include "../domain/graph_snapshot.hpp"
+#include "../domain/image_decoder.hpp"
+#include "../domain/image_manager.hpp"
 #include "../domain/mind_map_data.hpp"
+#include "../domain/mind_map_diff.hpp"
 #include "../domain/undo_stack.hpp"
 #include "../infra/io/alz_file_io.hpp"
+#include "../infra/io/alzb_file_io.hpp"
+#include "../infra/io/autosave_journal.hpp"
+#include "../infra/io/edit_operation.hpp"
+#include "../infra/io/file_exception.hpp"
+#include "../infra/io/outline_importer.hpp"
+#include "../infra/io/undo_journal.hpp"
 #include "../view/edge_selection_group.hpp"
 #include "../view/node_selection_group.hpp"
 #include "../view/scene_items/edge.hpp"
+#include "../view/scene_items/edge_update_batch.hpp"
 #include "../view/scene_items/node.hpp"
 
 #include "simple_logger.hpp"
 
 using juzzlin::L;
 
+#include <QFile>
+
 #include <algorithm>
 #include <cassert>
 #include <memory>
+#include <unordered_set>
+#include <utility>
 
 using std::make_shared;
 
 static const auto TAG = "EditorService";
 
+namespace {
+//! Removes the highlights that don't match anymore and highlights the current matches.
+//! Items that didn't match before and don't match now are not touched at all.
+template<typename ItemType>
+void updateTextHighlights(std::vector<std::weak_ptr<ItemType>> & highlighted, const std::vector<std::shared_ptr<ItemType>> & matches, const QString & text)
+{
+    std::unordered_set<const ItemType *> matching;
+    for (auto && item : matches) {
+        matching.insert(item.get());
+    }
+
+    for (auto && weakItem : highlighted) {
+        if (const auto item = weakItem.lock(); item && !matching.count(item.get())) {
+            item->highlightText("");
+        }
+    }
+
+    highlighted.clear();
+    for (auto && item : matches) {
+        item->highlightText(text);
+        highlighted.push_back(item);
+    }
+}
+
+//! Updates only the data that differs, because e.g. moving a node also updates its edges.
+//! The text goes before the size and the location, because setting it resizes the node.
+void updateNode(SceneItems::Node & node, const SceneItems::NodeModel & model)
+{
+    const auto current = node.model();
+    node.setText(model.text);
+    if (current.size != model.size) {
+        node.setSize(model.size);
+    }
+    if (current.location != model.location) {
+        node.setLocation(model.location);
+    }
+    if (current.color != model.color) {
+        node.setColor(model.color);
+    }
+    if (current.textColor != model.textColor) {
+        node.setTextColor(model.textColor);
+    }
+    if (current.collapsed != model.collapsed) {
+        node.setCollapsed(model.collapsed);
+    }
+    if (current.imageRef != model.imageRef) {
+        node.setImageRef(model.imageRef);
+    }
+    if (current.uuid != model.uuid) {
+        node.setUuid(model.uuid);
+    }
+}
+
+void updateEdge(SceneItems::Edge & edge, const SceneItems::EdgeModel & model)
+{
+    const auto current = edge.model();
+    if (current.text != model.text) {
+        edge.setText(model.text);
+    }
+    if (current.reversed != model.reversed) {
+        edge.setReversed(model.reversed);
+    }
+    if (current.style.arrowMode != model.style.arrowMode) {
+        edge.setArrowMode(model.style.arrowMode);
+    }
+    if (current.style.arrowSize != model.style.arrowSize) {
+        edge.setArrowSize(model.style.arrowSize);
+    }
+    if (current.style.dashedLine != model.style.dashedLine) {
+        edge.setDashedLine(model.style.dashedLine);
+    }
+    if (current.style.edgeWidth != model.style.edgeWidth) {
+        edge.setEdgeWidth(model.style.edgeWidth);
+    }
+}
+
+void removeDeletedEdge(SceneItems::Edge & edge)
+{
+    edge.sourceNode().removeGraphicsEdge(edge);
+    edge.targetNode().removeGraphicsEdge(edge);
+    edge.removeFromScene();
+}
+
+bool hasEqualContent(const MindMapData & mindMapData, const MindMapData & other)
+{
+    // Compared as saved, because the files have dense indices while the nodes in memory keep theirs until reloaded
+    return mindMapData.sharesStyleWith(other) && GraphSnapshot::diff(mindMapData.graphSnapshot().densified(), other.graphSnapshot().densified()).isEmpty();
+}
+} // namespace
+
 EditorService::EditorService()
   : m_alzFileIO(std::make_unique<IO::AlzFileIO>())
+  , m_alzbFileIO(std::make_unique<IO::AlzbFileIO>())
+  , m_autosaveJournal(std::make_unique<IO::AutosaveJournal>())
+  , m_autosaveScheduler(std::make_unique<AutosaveScheduler>(
+      [this](MindMapDataS mindMapData, QString fileName) {
+          return fileIOForSaving(fileName).toFile(mindMapData, fileName, false);
+      },
+      Constants::Application::autosaveDebounceDelay()))
   , m_copyContext(std::make_unique<CopyContext>())
   , m_edgeSelectionGroup(std::make_unique<EdgeSelectionGroup>())
   , m_nodeSelectionGroup(std::make_unique<NodeSelectionGroup>())
+  , m_teardownScheduler(std::make_unique<TeardownScheduler>(Constants::Application::teardownSliceDuration()))
   , m_undoStack(std::make_unique<UndoStack>())
 {
     m_undoTimer.setSingleShot(true);
     m_undoTimer.setInterval(Constants::View::tooQuickActionDelay());
+
+    m_undoStack->setMemoryBudget(static_cast<size_t>(std::max(0, SC::instance().settingsProxy()->undoMemoryBudgetMiB())) * 1024 * 1024);
+
+    ImageDecoder::setMemoryCap(static_cast<size_t>(std::max(0, SC::instance().settingsProxy()->imageMemoryCapMiB())) * 1024 * 1024);
+
+    connect(m_autosaveScheduler.get(), &AutosaveScheduler::saveFinished, this, &EditorService::handleAutosaveFinished);
 }
 
 void EditorService::addEdgeToSelectionGroup(EdgeR edge, bool isImplicit)
@@ -68,27 +191,116 @@ void EditorService::addNodeToSelectionGroup(NodeR node, bool isImplicit)
 
 void EditorService::requestAutosave(AutosaveContext context, bool async)
 {
-    const auto doRequestAutosave = [this](bool async) {
-        if (SC::instance().settingsProxy()->autosave() && !m_fileName.isEmpty()) {
+    if (m_transaction.depth && context == AutosaveContext::Modification) {
+        m_transaction.isAutosavePending = true;
+        return;
+    }
+
+    // The mind map is left in this state, to which the undo history in the journal leads, see openJournal()
+    if (context != AutosaveContext::Modification && m_mindMapData) {
+        m_undoStack->setJournalState(*m_mindMapData);
+    }
+
+    const bool autosave = SC::instance().settingsProxy()->snapshot()->autosave;
+    const auto doRequestAutosave = [this, autosave](bool async) {
+        if (autosave && !m_fileName.isEmpty()) {
             L(TAG).debug() << "Autosaving to '" << m_fileName.toStdString() << "'";
-            saveMindMapAs(m_fileName, async);
+            if (async) {
+                // Coalesced with other requests and saved in the background from a snapshot that edits don't touch.
+                // Autosave is requested before the modification is applied, so the snapshot is taken only when the save starts.
+                const auto takeSnapshot = [this, fileName = m_fileName, mindMapData = m_mindMapData] {
+                    auto snapshot = std::make_shared<MindMapData>(*mindMapData);
+                    // The save thread reads its own copy, see handleAutosaveFinished()
+                    m_runningAutosave = { mindMapData, std::make_shared<MindMapData>(*snapshot), m_modificationCount };
+                    return snapshot;
+                };
+                m_autosaveScheduler->schedule(takeSnapshot, m_fileName);
+            } else {
+                saveMindMapAs(m_fileName, async);
+            }
         }
     };
 
     switch (context) {
     case AutosaveContext::Modification:
+        if (autosave && !m_fileName.isEmpty() && autosaveToJournal(async)) {
+            break;
+        }
         doRequestAutosave(async);
         break;
     case AutosaveContext::InitializeNewMindMap:
     case AutosaveContext::OpenMindMap:
-    case AutosaveContext::QuitApplication:
+        // Compact the journal into the main file when leaving the mind map
         if (m_isTouched) {
             doRequestAutosave(async);
         }
         break;
+    case AutosaveContext::QuitApplication:
+        // A full save of a huge mind map would block the quit, so only the pending changes are appended to the journal,
+        // which is replayed on the next open and compacted by a later autosave. A pending full save must go first, though.
+        if (m_isTouched && !(autosave && !m_fileName.isEmpty() && !m_autosaveScheduler->queueDepth() && autosaveToJournal(async, false))) {
+            doRequestAutosave(async);
+        }
+        break;
     }
 }
 
+void EditorService::handleAutosaveFinished(bool success, QString fileName)
+{
+    const auto runningAutosave = std::move(m_runningAutosave);
+    m_runningAutosave = {};
+    if (!runningAutosave.snapshot) {
+        // Superseded by a save in the foreground
+        return;
+    }
+
+    const bool isCurrent = fileName == m_fileName && runningAutosave.mindMapData.lock() == m_mindMapData;
+    if (!success) {
+        L(TAG).error() << "Autosave to '" << fileName.toStdString() << "' failed";
+        if (isCurrent) {
+            setIsModified(true);
+        }
+        emit autosaveFailed(fileName);
+        return;
+    }
+
+    if (isCurrent) {
+        m_fileMindMapData = runningAutosave.snapshot;
+        m_autosaveJournal->reset(*runningAutosave.snapshot, true);
+        // The changes made during the save are saved by the next one
+        if (runningAutosave.modificationCount == m_modificationCount) {
+            setIsModified(false);
+        }
+    }
+}
+
+bool EditorService::autosaveToJournal(bool async, bool compactWhenDue)
+{
+    if (&fileIOForSaving(m_fileName) != m_alzFileIO.get() || (compactWhenDue && m_autosaveJournal->recordCount() >= Constants::Application::autosaveJournalCompactionInterval())) {
+        return false;
+    }
+
+    const auto appendRecord = [this, async, fileName = m_fileName, mindMapData = m_mindMapData] {
+        if (fileName != m_fileName || mindMapData != m_mindMapData) {
+            return;
+        }
+        if (const auto record = m_autosaveJournal->createRecord(*mindMapData); !record.isEmpty()) {
+            L(TAG).debug() << "Autosaving " << record.size() << " bytes to the journal of '" << fileName.toStdString() << "'";
+            m_alzFileIO->appendToJournal(fileName, record, async);
+        }
+    };
+
+    if (async) {
+        // Autosave is requested before the modification is applied, so create the record only afterwards
+        QTimer::singleShot(0, this, appendRecord);
+    } else {
+        appendRecord();
+    }
+
+    setIsModified(false);
+    return true;
+}
+
 QColor EditorService::backgroundColor() const
 {
     // Background color of "empty" editor is not the same as default color of new design
@@ -110,17 +322,86 @@ void EditorService::loadMindMapData(QString fileName)
     requestAutosave(AutosaveContext::OpenMindMap, false);
     clearSelectionGroups();
 
+    // Imported outlines are never written back in their own format, so they are saved as a new mind map
+    const bool isImported = IO::OutlineImporter::isOutlineFile(fileName);
+
     if (!TestMode::enabled()) {
-        setMindMapData(m_alzFileIO->fromFile(fileName));
+        if (isImported) {
+            setMindMapData(IO::OutlineImporter::readFromFile(fileName));
+        } else {
+            // Detect the format by content so that renamed files still open
+            setMindMapData(IO::AlzbFileIO::isAlzbFile(fileName) ? m_alzbFileIO->fromFile(fileName) : m_alzFileIO->fromFile(fileName));
+            // Keep saving in the same container as the file was opened from
+            m_alzFileIO->setCompressionEnabled(IO::AlzFileIO::isCompressedFile(fileName));
+        }
     } else {
         TestMode::logDisabledCode("setMindMapData");
     }
 
-    m_fileName = fileName;
-    setIsModified(false);
+    m_fileMindMapData = m_mindMapData && !isImported ? std::make_shared<MindMapData>(*m_mindMapData) : nullptr;
+
+    const bool isRecovered = !isImported && recoverFromJournal(fileName);
+    if (m_mindMapData) {
+        m_autosaveJournal->reset(*m_mindMapData);
+    }
+
+    m_fileName = isImported ? "" : fileName;
+    setIsModified(isImported || isRecovered);
     SC::instance().recentFilesManager()->addRecentFile(fileName);
 
     m_undoStack->clear();
+    if (!isImported && m_mindMapData && SC::instance().settingsProxy()->undoJournal()) {
+        m_undoStack->openJournal(IO::UndoJournal::journalPath(fileName), *m_mindMapData);
+    }
+}
+
+void EditorService::loadMindMapData(MindMapDataU mindMapData, QString url)
+{
+    requestAutosave(AutosaveContext::OpenMindMap, false);
+    clearSelectionGroups();
+
+    setMindMapData(std::move(mindMapData));
+    m_fileMindMapData = nullptr;
+    m_autosaveJournal->reset(*m_mindMapData);
+
+    m_fileName = "";
+    setIsModified(true);
+    SC::instance().recentFilesManager()->addRecentFile(url);
+
+    m_undoStack->clear();
+}
+
+MindMapDiff EditorService::diffWithFile(QString fileName) const
+{
+    assert(m_mindMapData);
+
+    MindMapDataU mindMapData;
+    if (IO::OutlineImporter::isOutlineFile(fileName)) {
+        mindMapData = IO::OutlineImporter::readFromFile(fileName);
+    } else {
+        mindMapData = IO::AlzbFileIO::isAlzbFile(fileName) ? m_alzbFileIO->fromFile(fileName) : m_alzFileIO->fromFile(fileName);
+    }
+
+    return { mindMapData->graphSnapshot(), m_mindMapData->graphSnapshot() };
+}
+
+bool EditorService::recoverFromJournal(QString fileName)
+{
+    const auto journalPath = IO::AutosaveJournal::journalPath(fileName);
+    if (!m_mindMapData || !QFile::exists(journalPath)) {
+        return false;
+    }
+
+    try {
+        if (IO::AutosaveJournal::replay(journalPath, *m_mindMapData)) {
+            L(TAG).info() << "Recovered autosaved changes from '" << journalPath.toStdString() << "'";
+            return true;
+        }
+    } catch (const IO::FileException & e) {
+        L(TAG).warning() << "Cannot recover from journal: " << e.message().toStdString();
+    }
+
+    return false;
 }
 
 bool EditorService::isModified() const
@@ -133,26 +414,136 @@ bool EditorService::isUndoable() const
     return m_undoStack->isUndoable();
 }
 
-void EditorService::undo()
+EditorService::UndoResult EditorService::applyUndoOrRedoPoint(MindMapDataU mindMapData)
 {
-    if (m_undoStack->isUndoable()) {
+    UndoResult result;
+
+    m_undoCoalescing.isActive = false;
+
+    // A changed style needs all the items to be restyled anyway
+    if (!m_mindMapData->sharesStyleWith(*mindMapData)) {
+        L(TAG).debug() << "Replacing the mind map data on undo or redo";
+        m_teardownScheduler->retire(std::exchange(m_mindMapData, std::move(mindMapData)));
+        emit mindMapDataReplaced();
+        result.isReplaced = true;
+        return result;
+    }
+
+    auto && graph = m_mindMapData->graph();
+    const GraphChangeNotifier::Batch changeBatch { graph.changeNotifier() };
+    const auto delta = GraphSnapshot::diff(m_mindMapData->graphSnapshot(), mindMapData->graphSnapshot());
+    L(TAG).debug() << "Removing " << delta.removedNodes.size() << " nodes and " << delta.removedEdges.size() << " edges, adding " //
+                   << delta.addedNodes.size() << " nodes and " << delta.addedEdges.size() << " edges on undo or redo";
+
+    // The images first so that the changed image refs of the nodes are found
+    m_mindMapData->takeAttributesFrom(*mindMapData);
+
+    return applyGraphDelta(delta);
+}
+
+EditorService::UndoResult EditorService::applyGraphDelta(const GraphSnapshot::Delta & delta)
+{
+    UndoResult result;
+
+    auto && graph = m_mindMapData->graph();
+
+    // The added indices may be as sparse as for all the added nodes, see Graph::isValidNodeIndex()
+    graph.reserveNodes(graph.nodeCount() + delta.addedNodes.size());
+
+    // Changed items are both in the removed and the added items of the delta, and they are updated in place
+    std::unordered_set<int> addedNodeIndices;
+    for (auto && model : delta.addedNodes) {
+        addedNodeIndices.insert(model.index);
+    }
+    std::unordered_set<int64_t> addedEdgeKeys;
+    for (auto && edgeData : delta.addedEdges) {
+        addedEdgeKeys.insert(Graph::buildKeyFromIndices(edgeData.sourceIndex, edgeData.targetIndex));
+    }
+
+    // The selection is kept on reload, so the deleted items must leave it
+    const auto deleteEdge = [this](EdgeR edge) {
+        if (m_edgeSelectionGroup->contains(edge)) {
+            m_edgeSelectionGroup->toggle(edge);
+        }
+        removeDeletedEdge(edge);
+    };
+
+    for (auto && edgeData : delta.removedEdges) {
+        if (!addedEdgeKeys.count(Graph::buildKeyFromIndices(edgeData.sourceIndex, edgeData.targetIndex))) {
+            if (const auto deletedEdge = graph.deleteEdge(edgeData.sourceIndex, edgeData.targetIndex)) {
+                deleteEdge(*deletedEdge);
+            }
+        }
+    }
+
+    for (auto && model : delta.removedNodes) {
+        if (!addedNodeIndices.count(model.index)) {
+            const auto deletionInfo = graph.deleteNode(model.index);
+            if (deletionInfo.first) {
+                for (auto && deletedEdge : deletionInfo.second) {
+                    deleteEdge(*deletedEdge);
+                }
+                if (m_nodeSelectionGroup->contains(*deletionInfo.first)) {
+                    m_nodeSelectionGroup->remove(*deletionInfo.first);
+                }
+                deletionInfo.first->removeFromScene();
+            }
+        }
+    }
+
+    // Moved nodes update their edges, so each edge is updated only once
+    const SceneItems::EdgeUpdateBatch edgeUpdateBatch;
+
+    // Existing items are updated also if the delta doesn't remove them, e.g. the deltas of other instances
+    for (auto && model : delta.addedNodes) {
+        if (graph.hasNode(model.index)) {
+            updateNode(*graph.getNode(model.index), model);
+        } else {
+            const auto node = make_shared<SceneItems::Node>(model);
+            graph.addNode(node);
+            result.addedNodes.push_back(node);
+        }
+    }
+
+    for (auto && edgeData : delta.addedEdges) {
+        if (const auto edge = graph.getEdge(edgeData.sourceIndex, edgeData.targetIndex)) {
+            updateEdge(*edge, edgeData.model);
+        } else if (graph.hasNode(edgeData.sourceIndex) && graph.hasNode(edgeData.targetIndex)) {
+            const auto newEdge = make_shared<SceneItems::Edge>(edgeData.model, graph.getNode(edgeData.sourceIndex).get(), graph.getNode(edgeData.targetIndex).get());
+            graph.addEdge(newEdge);
+            result.addedEdges.push_back(newEdge);
+        }
+    }
+
+    return result;
+}
+
+EditorService::UndoResult EditorService::undo(size_t steps)
+{
+    UndoResult result;
+    if (m_undoStack->isUndoable() && steps) {
+        notifyModification();
         clearSelectionGroups();
         m_dragAndDropNode = nullptr;
         saveRedoPoint();
-        m_mindMapData = m_undoStack->undo();
+        // Nothing is undone if the undo history turned out to be corrupted
+        if (auto mindMapData = m_undoStack->undo(std::min(steps, m_undoStack->undoCount()))) {
+            result = applyUndoOrRedoPoint(std::move(mindMapData));
+        }
         setIsModified(true);
         sendUndoAndRedoSignals();
         requestAutosave(AutosaveContext::Modification, true);
     }
+    return result;
 }
 
 void EditorService::unselectText()
 {
-    for (auto && edge : mindMapData()->graph().getEdges()) {
+    for (auto && edge : mindMapData()->graph().edges()) {
         edge->unselectText();
     }
 
-    for (auto && node : mindMapData()->graph().getNodes()) {
+    for (auto && node : mindMapData()->graph().nodes()) {
         node->unselectText();
     }
 }
@@ -162,17 +553,173 @@ bool EditorService::isRedoable() const
     return m_undoStack->isRedoable();
 }
 
-void EditorService::redo()
+size_t EditorService::historyPosition() const
+{
+    return m_undoStack->undoCount();
+}
+
+size_t EditorService::historyLength() const
+{
+    return m_undoStack->undoCount() + m_undoStack->redoCount();
+}
+
+EditorService::UndoResult EditorService::jumpToHistoryPosition(size_t position)
 {
-    if (m_undoStack->isRedoable()) {
+    const auto current = historyPosition();
+    return position < current ? undo(current - position) : redo(position - current);
+}
+
+EditorService::UndoResult EditorService::redo(size_t steps)
+{
+    UndoResult result;
+    if (m_undoStack->isRedoable() && steps) {
+        notifyModification();
         clearSelectionGroups();
         m_dragAndDropNode = nullptr;
         saveUndoPoint(true);
-        m_mindMapData = m_undoStack->redo();
+        if (auto mindMapData = m_undoStack->redo(std::min(steps, m_undoStack->redoCount()))) {
+            result = applyUndoOrRedoPoint(std::move(mindMapData));
+        }
         setIsModified(true);
         sendUndoAndRedoSignals();
         requestAutosave(AutosaveContext::Modification, true);
     }
+    return result;
+}
+
+EditorService::ReloadResult EditorService::reloadMindMapData()
+{
+    ReloadResult result;
+    if (!m_mindMapData || m_fileName.isEmpty()) {
+        return result;
+    }
+
+    // A pending autosave is going to overwrite the file anyway
+    if (m_autosaveScheduler->queueDepth()) {
+        return result;
+    }
+
+    auto mindMapData = IO::AlzbFileIO::isAlzbFile(m_fileName) ? m_alzbFileIO->fromFile(m_fileName) : m_alzFileIO->fromFile(m_fileName);
+    if (m_fileMindMapData && hasEqualContent(*mindMapData, *m_fileMindMapData)) {
+        return result;
+    }
+
+    const bool isStyleShared = m_mindMapData->sharesStyleWith(*mindMapData);
+    if (isStyleShared && hasEqualContent(*mindMapData, *m_mindMapData)) {
+        m_fileMindMapData = std::move(mindMapData);
+        return result;
+    }
+
+    // Autosave marks the mind map unmodified also when it has saved the changes only to the journal
+    const bool hasUnsavedChanges = m_isModified || QFile::exists(IO::AutosaveJournal::journalPath(m_fileName)) //
+      || !m_fileMindMapData || !hasEqualContent(*m_mindMapData, *m_fileMindMapData);
+    if (hasUnsavedChanges) {
+        L(TAG).info() << "Not reloading '" << m_fileName.toStdString() << "', because it has unsaved changes";
+        result.status = ReloadResult::Status::Conflict;
+        return result;
+    }
+
+    L(TAG).info() << "Reloading '" << m_fileName.toStdString() << "'";
+
+    notifyModification();
+    m_dragAndDropNode = nullptr;
+    if (!isStyleShared) {
+        // All the items get replaced
+        clearSelectionGroups();
+    }
+
+    // Unlike saveUndoPoint() this doesn't mark the mind map modified, because it matches the file after the reload
+    m_undoStack->pushUndoPoint(*m_mindMapData);
+    m_mindMapData->graph().advanceEpoch();
+    m_undoStack->clearRedoStack();
+
+    result.undoResult = applyUndoOrRedoPoint(std::move(mindMapData));
+    result.status = ReloadResult::Status::Reloaded;
+
+    m_fileMindMapData = std::make_shared<MindMapData>(*m_mindMapData);
+
+    m_autosaveJournal->reset(*m_mindMapData);
+    setIsModified(false);
+    sendUndoAndRedoSignals();
+
+    return result;
+}
+
+EditorService::UndoResult EditorService::applyMindMapData(MindMapDataU mindMapData)
+{
+    assert(m_mindMapData && mindMapData);
+
+    notifyModification();
+    clearSelectionGroups();
+    m_dragAndDropNode = nullptr;
+
+    // Always a separate undo point unlike saveUndoPoint(), which may skip it during rapid edits
+    m_undoStack->pushUndoPoint(*m_mindMapData);
+    m_mindMapData->graph().advanceEpoch();
+    m_undoStack->clearRedoStack();
+
+    auto result = applyUndoOrRedoPoint(std::move(mindMapData));
+
+    setIsModified(true);
+    sendUndoAndRedoSignals();
+    requestAutosave(AutosaveContext::Modification, true);
+
+    m_isTouched = true;
+
+    return result;
+}
+
+EditorService::UndoResult EditorService::applyEditOperation(const IO::EditOperation & operation)
+{
+    assert(m_mindMapData);
+
+    notifyModification();
+    m_dragAndDropNode = nullptr;
+    m_undoCoalescing.isActive = false;
+
+    UndoResult result;
+    if (operation.isReset) {
+        L(TAG).debug() << "Resetting to " << operation.delta.addedNodes.size() << " nodes and " << operation.delta.addedEdges.size() << " edges";
+        auto mindMapData = std::make_shared<MindMapData>();
+        mindMapData->applyStyleData(operation.styleData);
+        for (auto && image : operation.images) {
+            mindMapData->imageManager().setImage(image);
+        }
+        mindMapData->setGraphSnapshot({ operation.delta.addedNodes, operation.delta.addedEdges });
+        clearSelectionGroups();
+        setMindMapData(mindMapData);
+        m_autosaveJournal->reset(*m_mindMapData);
+        m_fileMindMapData.reset();
+        m_fileName = "";
+        result.isReplaced = true;
+    } else if (!operation.styleData.isEmpty() && operation.styleData != m_mindMapData->styleData()) {
+        // A changed style needs all the items to be restyled anyway
+        auto graphSnapshot = m_mindMapData->graphSnapshot();
+        graphSnapshot.apply(operation.delta);
+        auto mindMapData = std::make_shared<MindMapData>(*m_mindMapData, std::move(graphSnapshot));
+        for (auto && image : operation.images) {
+            mindMapData->imageManager().setImage(image);
+        }
+        mindMapData->applyStyleData(operation.styleData);
+        clearSelectionGroups();
+        m_teardownScheduler->retire(std::exchange(m_mindMapData, std::move(mindMapData)));
+        emit mindMapDataReplaced();
+        result.isReplaced = true;
+    } else {
+        // The images first so that the changed image refs of the nodes are found
+        for (auto && image : operation.images) {
+            m_mindMapData->imageManager().setImage(image);
+        }
+        const GraphChangeNotifier::Batch changeBatch { m_mindMapData->graph().changeNotifier() };
+        result = applyGraphDelta(operation.delta);
+    }
+
+    setIsModified(true);
+    requestAutosave(AutosaveContext::Modification, true);
+
+    m_isTouched = true;
+
+    return result;
 }
 
 void EditorService::removeImageRefsOfSelectedNodes()
@@ -192,6 +739,19 @@ bool EditorService::saveMindMap(bool async)
 
 void EditorService::saveUndoPoint(bool dontClearRedoStack)
 {
+    // An undo point is saved before each change, also when saving it is skipped below
+    notifyModification();
+
+    m_undoCoalescing.isActive = false;
+
+    // The first undo point of a transaction has the state before all of its changes
+    if (m_transaction.depth) {
+        if (m_transaction.isUndoPointSaved) {
+            return;
+        }
+        m_transaction.isUndoPointSaved = true;
+    }
+
     if (!TestMode::enabled()) {
         if (m_undoTimer.isActive()) {
             L(TAG).debug() << "Saving undo point skipped";
@@ -204,6 +764,7 @@ void EditorService::saveUndoPoint(bool dontClearRedoStack)
 
     assert(m_mindMapData);
     m_undoStack->pushUndoPoint(*m_mindMapData);
+    m_mindMapData->graph().advanceEpoch();
     if (!dontClearRedoStack) {
         m_undoStack->clearRedoStack();
     }
@@ -214,6 +775,31 @@ void EditorService::saveUndoPoint(bool dontClearRedoStack)
     m_isTouched = true;
 }
 
+void EditorService::saveCoalescedUndoPoint(UndoCoalescing operation, const void * target)
+{
+    const auto selectionRevision = operation == UndoCoalescing::MoveSelection ? m_nodeSelectionGroup->revision() : 0;
+    if (!m_transaction.depth && m_undoCoalescing.isActive && m_undoCoalescing.operation == operation && m_undoCoalescing.target == target
+        && m_undoCoalescing.selectionRevision == selectionRevision && m_undoCoalescing.pauseTimer.elapsed() < Constants::View::undoCoalescingPause().count()) {
+        // The previous undo point already has the state before the first of the merged changes
+        notifyModification();
+        setIsModified(true);
+        requestAutosave(AutosaveContext::Modification, true);
+        m_undoCoalescing.pauseTimer.restart();
+        m_isTouched = true;
+        return;
+    }
+
+    saveUndoPoint();
+
+    if (!m_transaction.depth) {
+        m_undoCoalescing.isActive = true;
+        m_undoCoalescing.operation = operation;
+        m_undoCoalescing.target = target;
+        m_undoCoalescing.selectionRevision = selectionRevision;
+        m_undoCoalescing.pauseTimer.start();
+    }
+}
+
 void EditorService::saveRedoPoint()
 {
     L(TAG).debug() << "Saving redo point";
@@ -228,16 +814,42 @@ bool EditorService::saveMindMapAs(QString fileName, bool async)
 {
     assert(m_mindMapData);
 
-    if (m_alzFileIO->toFile(m_mindMapData, fileName, async)) {
+    // This save supersedes any pending autosave, and the running one must not overwrite it afterwards
+    m_autosaveScheduler->cancel();
+    m_autosaveScheduler->waitForDone();
+    m_runningAutosave = {};
+
+    if (fileIOForSaving(fileName).toFile(m_mindMapData, fileName, async)) {
+        m_fileMindMapData = std::make_shared<MindMapData>(*m_mindMapData);
+        m_autosaveJournal->reset(*m_mindMapData, true);
         m_fileName = fileName;
         setIsModified(false);
+        // The undo history moves along to a new file, or starts to be kept once enabled
+        if (const auto journalPath = IO::UndoJournal::journalPath(fileName); SC::instance().settingsProxy()->undoJournal() && m_undoStack->journalPath() != journalPath) {
+            m_undoStack->saveJournal(journalPath);
+        }
         SC::instance().recentFilesManager()->addRecentFile(fileName);
+        SC::instance().thumbnailCache()->generate(fileName, *m_mindMapData);
+        SC::instance().thumbnailCache()->retain(SC::instance().recentFilesManager()->recentFiles());
         return true;
     }
 
     return false;
 }
 
+void EditorService::setCompressionEnabled(bool compressionEnabled)
+{
+    m_alzFileIO->setCompressionEnabled(compressionEnabled);
+}
+
+IO::FileIO & EditorService::fileIOForSaving(QString fileName) const
+{
+    if (fileName.endsWith(Constants::Application::binaryFileExtension())) {
+        return *m_alzbFileIO;
+    }
+    return *m_alzFileIO;
+}
+
 void EditorService::setColorForSelectedNodes(QColor color)
 {
     for (auto && node : m_nodeSelectionGroup->nodes()) {
@@ -277,35 +889,87 @@ void EditorService::setTextColorForSelectedNodes(QColor color)
     }
 }
 
+void EditorService::setUndoMemoryBudget(size_t bytes)
+{
+    m_undoStack->setMemoryBudget(bytes);
+}
+
+size_t EditorService::trimUndoHistory(size_t bytes)
+{
+    return m_undoStack->trim(bytes);
+}
+
+void EditorService::toggleCollapsedForSelectedNodes()
+{
+    for (auto && node : m_nodeSelectionGroup->nodes()) {
+        node->setCollapsed(!node->collapsed());
+    }
+}
+
 void EditorService::setMindMapData(MindMapDataS mindMapData)
 {
-    m_mindMapData = mindMapData;
+    notifyModification();
+
+    m_teardownScheduler->retire(std::exchange(m_mindMapData, mindMapData));
+    emit mindMapDataReplaced();
+
+    m_highlightedEdges.clear();
+    m_highlightedNodes.clear();
 
     setIsModified(false);
 
     m_undoStack->clear();
+    m_undoCoalescing.isActive = false;
 }
 
 void EditorService::selectEdgesByText(QString text)
 {
-    clearEdgeSelectionGroup();
-    for (auto && edge : m_mindMapData->graph().getEdges()) {
-        if (!text.isEmpty() && edge->containsText(text)) {
-            addEdgeToSelectionGroup(*edge);
-        }
-        edge->highlightText(text);
+    const auto matches = m_mindMapData->graph().searchEdgesByText(text);
+    std::vector<EdgeP> edges;
+    edges.reserve(matches.size());
+    for (auto && edge : matches) {
+        edges.push_back(edge.get());
     }
+
+    L(TAG).debug() << "Selecting " << edges.size() << " edges by text";
+
+    m_edgeSelectionGroup->set(edges);
+    updateTextHighlights(m_highlightedEdges, matches, text);
 }
 
 void EditorService::selectNodesByText(QString text)
 {
-    clearNodeSelectionGroup();
-    for (auto && node : m_mindMapData->graph().getNodes()) {
-        if (!text.isEmpty() && node->containsText(text)) {
-            addNodeToSelectionGroup(*node);
+    const auto matches = m_mindMapData->graph().searchNodesByText(text);
+    std::vector<NodeP> nodes;
+    nodes.reserve(matches.size());
+    for (auto && node : matches) {
+        nodes.push_back(node.get());
+    }
+
+    L(TAG).debug() << "Selecting " << nodes.size() << " nodes by text";
+
+    m_nodeSelectionGroup->set(nodes);
+    updateTextHighlights(m_highlightedNodes, matches, text);
+}
+
+void EditorService::selectReachableFromSelectedNodes(Graph::TraversalDirection direction, const std::unordered_set<int> & excludedIndices)
+{
+    std::vector<int> selectedIndices;
+    for (auto && node : m_nodeSelectionGroup->nodes()) {
+        selectedIndices.push_back(node->index());
+    }
+
+    const auto & graph = m_mindMapData->graph();
+    std::vector<NodeP> nodes;
+    for (auto && index : graph.traverse(selectedIndices, direction)) {
+        if (!excludedIndices.count(index)) {
+            nodes.push_back(graph.getNode(index).get());
         }
-        node->highlightText(text);
     }
+
+    L(TAG).debug() << "Selecting " << nodes.size() << " nodes of branches";
+
+    m_nodeSelectionGroup->set(nodes);
 }
 
 void EditorService::toggleEdgeInSelectionGroup(EdgeR edge)
@@ -315,6 +979,13 @@ void EditorService::toggleEdgeInSelectionGroup(EdgeR edge)
     m_edgeSelectionGroup->toggle(edge);
 }
 
+void EditorService::toggleEdgesInSelectionGroup(const std::vector<EdgeP> & edges)
+{
+    L(TAG).debug() << "Toggling " << edges.size() << " edges in selection group";
+
+    m_edgeSelectionGroup->toggle(edges);
+}
+
 void EditorService::toggleNodeInSelectionGroup(NodeR node)
 {
     L(TAG).debug() << "Toggling node " << node.index() << " in selection group";
@@ -322,6 +993,13 @@ void EditorService::toggleNodeInSelectionGroup(NodeR node)
     m_nodeSelectionGroup->toggle(node);
 }
 
+void EditorService::toggleNodesInSelectionGroup(const std::vector<NodeP> & nodes)
+{
+    L(TAG).debug() << "Toggling " << nodes.size() << " nodes in selection group";
+
+    m_nodeSelectionGroup->toggle(nodes);
+}
+
 EdgeS EditorService::addEdge(EdgeS edge)
 {
     assert(m_mindMapData);
@@ -330,6 +1008,53 @@ EdgeS EditorService::addEdge(EdgeS edge)
     return edge;
 }
 
+std::vector<EdgeS> EditorService::addEdges(const GraphSnapshot::EdgeDataVector & edges)
+{
+    assert(m_mindMapData);
+
+    auto && graph = m_mindMapData->graph();
+    std::vector<EdgeS> newEdges;
+    newEdges.reserve(edges.size());
+    for (auto && edgeData : edges) {
+        newEdges.push_back(make_shared<SceneItems::Edge>(edgeData.model, graph.getNode(edgeData.sourceIndex).get(), graph.getNode(edgeData.targetIndex).get()));
+    }
+    graph.addEdges(newEdges);
+    return newEdges;
+}
+
+void EditorService::beginTransaction()
+{
+    if (!m_transaction.depth++ && m_mindMapData) {
+        m_transaction.mindMapData = m_mindMapData;
+        m_transaction.mindMapData->graph().changeNotifier().beginBatch();
+    }
+}
+
+bool EditorService::commitTransaction()
+{
+    assert(m_transaction.depth > 0);
+    if (--m_transaction.depth) {
+        return false;
+    }
+
+    const auto transaction = std::exchange(m_transaction, {});
+    if (transaction.mindMapData) {
+        transaction.mindMapData->graph().changeNotifier().endBatch();
+    }
+    if (transaction.areUndoSignalsPending) {
+        sendUndoAndRedoSignals();
+    }
+    if (transaction.isAutosavePending) {
+        requestAutosave(AutosaveContext::Modification, true);
+    }
+    return true;
+}
+
+bool EditorService::isInTransaction() const
+{
+    return m_transaction.depth > 0;
+}
+
 void EditorService::deleteEdge(EdgeR edge)
 {
     assert(m_mindMapData);
@@ -395,6 +1120,19 @@ NodeS EditorService::addNodeAt(QPointF pos)
     return node;
 }
 
+std::vector<NodeS> EditorService::addNodes(const GraphSnapshot::NodeDataVector & models)
+{
+    assert(m_mindMapData);
+
+    std::vector<NodeS> nodes;
+    nodes.reserve(models.size());
+    for (auto && model : models) {
+        nodes.push_back(make_shared<SceneItems::Node>(model));
+    }
+    m_mindMapData->graph().addNodes(nodes);
+    return nodes;
+}
+
 void EditorService::clearSelectionGroups()
 {
     clearEdgeSelectionGroup();
@@ -426,33 +1164,9 @@ bool EditorService::areSelectedNodesConnectable() const
     return false;
 }
 
-EditorService::NodePairVector EditorService::getDisconnectableNodes() const
-{
-    NodePairVector nodes;
-    for (size_t i = 0; i < m_nodeSelectionGroup->nodes().size(); i++) {
-        for (size_t j = i + 1; j < m_nodeSelectionGroup->nodes().size(); j++) {
-            const auto c0 = m_nodeSelectionGroup->nodes().at(i);
-            const auto c1 = m_nodeSelectionGroup->nodes().at(j);
-            if (m_mindMapData->graph().areDirectlyConnected(c0->index(), c1->index())) {
-                nodes.push_back({ c0, c1 });
-            }
-        }
-    }
-    return nodes;
-}
-
 bool EditorService::areSelectedNodesDisconnectable() const
 {
-    for (size_t i = 0; i < m_nodeSelectionGroup->nodes().size(); i++) {
-        for (size_t j = i + 1; j < m_nodeSelectionGroup->nodes().size(); j++) {
-            const auto c0 = m_nodeSelectionGroup->nodes().at(i);
-            const auto c1 = m_nodeSelectionGroup->nodes().at(j);
-            if (m_mindMapData->graph().areDirectlyConnected(c0->index(), c1->index())) {
-                return true;
-            }
-        }
-    }
-    return false;
+    return !m_nodeSelectionGroup->isEmpty() && m_nodeSelectionGroup->internalEdgeCount(m_mindMapData->graph()) > 0;
 }
 
 std::vector<EdgeS> EditorService::connectSelectedNodes()
@@ -466,17 +1180,42 @@ std::vector<EdgeS> EditorService::connectSelectedNodes()
 
 void EditorService::disconnectSelectedNodes()
 {
-    for (auto && nodePair : getDisconnectableNodes()) {
-        deleteEdge(nodePair.first->index(), nodePair.second->index());
-        deleteEdge(nodePair.second->index(), nodePair.first->index());
+    assert(m_mindMapData);
+
+    // The deleted edges are only soft-deleted, so the collected pointers stay valid
+    for (auto && edge : m_nodeSelectionGroup->internalEdges(m_mindMapData->graph())) {
+        deleteEdge(*edge);
     }
 }
 
-CopyContext::CopiedData EditorService::copiedData() const
+const CopyContext::CopiedData & EditorService::copiedData() const
 {
     return m_copyContext->copiedData();
 }
 
+QByteArray EditorService::serializedCopiedData() const
+{
+    return m_copyContext->serialize();
+}
+
+bool EditorService::deserializeCopiedData(const QByteArray & data)
+{
+    return m_copyContext->deserialize(data);
+}
+
+std::unordered_map<size_t, size_t> EditorService::addCopiedImages()
+{
+    assert(m_mindMapData);
+
+    std::unordered_map<size_t, size_t> imageMapping;
+    auto && imageManager = m_mindMapData->imageManager();
+    for (auto && image : m_copyContext->copiedData().images) {
+        // Images that the mind map already has are reused
+        imageMapping[image.id()] = imageManager.addImage(image);
+    }
+    return imageMapping;
+}
+
 NodeS EditorService::copyNodeAt(NodeCR source, QPointF pos)
 {
     assert(m_mindMapData);
@@ -492,7 +1231,7 @@ void EditorService::copySelectedNodes()
 {
     if (m_nodeSelectionGroup->size()) {
         clearCopyStack();
-        m_copyContext->push(m_nodeSelectionGroup->nodes(), m_mindMapData->graph());
+        m_copyContext->push(m_nodeSelectionGroup->nodes(), m_mindMapData->graph(), m_mindMapData->imageManager());
         L(TAG).debug() << m_nodeSelectionGroup->size() << " nodes copied. Reference point calculated at (" << m_copyContext->copiedData().copyReferencePoint.x() << ", " << m_copyContext->copiedData().copyReferencePoint.y() << ")";
     }
 }
@@ -532,6 +1271,9 @@ void EditorService::initializeNewMindMap()
 {
     requestAutosave(AutosaveContext::InitializeNewMindMap, false);
     setMindMapData(std::make_shared<MindMapData>());
+    m_alzFileIO->setCompressionEnabled(false);
+    m_autosaveJournal->reset(*m_mindMapData);
+    m_fileMindMapData.reset();
     m_fileName = "";
 }
 
@@ -540,6 +1282,20 @@ bool EditorService::isInSelectionGroup(NodeR node)
     return m_nodeSelectionGroup->contains(node);
 }
 
+MemoryReport EditorService::memoryReport() const
+{
+    MemoryReport report;
+    if (m_mindMapData) {
+        report.entries.push_back({ tr("Graph"), m_mindMapData->graph().memoryUsage() });
+        report.entries.push_back({ tr("Deleted graph items"), m_mindMapData->graph().deletedMemoryUsage() });
+        report.entries.push_back({ tr("Images"), m_mindMapData->imageManager().memoryUsage() });
+    }
+    report.entries.push_back({ tr("Undo history"), m_undoStack->undoMemoryUsage() });
+    report.entries.push_back({ tr("Redo history"), m_undoStack->redoMemoryUsage() });
+    report.entries.push_back({ tr("Copy buffer"), m_copyContext->memoryUsage() });
+    return report;
+}
+
 MindMapDataS EditorService::mindMapData()
 {
     return m_mindMapData;
@@ -550,6 +1306,11 @@ void EditorService::mirror(bool vertically)
     m_mindMapData->mirror(vertically);
 }
 
+void EditorService::beginSelectionGroupMove()
+{
+    m_nodeSelectionGroup->beginMove();
+}
+
 void EditorService::moveSelectionGroup(NodeR reference, QPointF location)
 {
     m_nodeSelectionGroup->move(reference, location);
@@ -597,8 +1358,24 @@ size_t EditorService::nodeSelectionGroupSize() const
 
 void EditorService::sendUndoAndRedoSignals()
 {
+    if (m_transaction.depth) {
+        m_transaction.areUndoSignalsPending = true;
+        return;
+    }
+
     emit undoEnabled(m_undoStack->isUndoable());
     emit redoEnabled(m_undoStack->isRedoable());
+    emit historyChanged(historyPosition(), historyLength());
+}
+
+size_t EditorService::modificationCount() const
+{
+    return m_modificationCount;
+}
+
+void EditorService::notifyModification()
+{
+    m_modificationCount++;
 }
 
 void EditorService::setIsModified(bool isModified)
@@ -609,9 +1386,45 @@ void EditorService::setIsModified(bool isModified)
     }
 }
 
+void EditorService::prepareForExit()
+{
+    m_isExiting = true;
+}
+
+void EditorService::releaseSceneItems()
+{
+    L(TAG).debug() << "Releasing scene items";
+
+    clearSelectionGroups();
+
+    m_dragAndDropNode = nullptr;
+    m_undoCoalescing.isActive = false;
+    m_highlightedEdges.clear();
+    m_highlightedNodes.clear();
+
+    if (m_mindMapData) {
+        // The copy holds the graph as a snapshot
+        m_teardownScheduler->retire(std::exchange(m_mindMapData, std::make_shared<MindMapData>(*m_mindMapData)));
+    }
+}
+
 EditorService::~EditorService()
 {
     requestAutosave(AutosaveContext::QuitApplication, false);
 
+    if (m_isExiting) {
+        // Intentionally leaked, the memory is returned with the process. The undo journal is flushed per record,
+        // and the autosave scheduler and the file IO workers are still waited for as usual.
+        new MindMapDataS { std::move(m_mindMapData) };
+        new MindMapDataS { std::move(m_fileMindMapData) };
+        new MindMapDataS { std::move(m_transaction.mindMapData) };
+        static_cast<void>(m_autosaveJournal.release());
+        static_cast<void>(m_copyContext.release());
+        static_cast<void>(m_teardownScheduler.release());
+        static_cast<void>(m_undoStack.release());
+        L(TAG).debug() << "EditorService released for exit";
+        return;
+    }
+
     L(TAG).debug() << "EditorService deleted";
 }
@@ -18,9 +18,12 @@
 
 #include <memory>
 #include <optional>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include <QElapsedTimer>
 #include <QObject>
 #include <QPointF>
 #include <QString>
@@ -28,23 +31,34 @@
 
 #include "../common/types.hpp"
 #include "../domain/copy_context.hpp"
+#include "../domain/graph.hpp"
+#include "../domain/graph_snapshot.hpp"
+#include "../domain/mind_map_diff.hpp"
+#include "memory_report.hpp"
 #include "../view/grid.hpp"
 #include "../view/mouse_action.hpp"
 
+class AutosaveScheduler;
 class EdgeSelectionGroup;
 class MindMapTile;
 class NodeSelectionGroup;
 class QGraphicsLineItem;
+class TeardownScheduler;
 class UndoStack;
 
 namespace SceneItems {
 class Edge;
 class Node;
 class NodeBase;
+struct NodeModel;
 } // namespace SceneItems
 
 namespace IO {
 class AlzFileIO;
+class AlzbFileIO;
+class AutosaveJournal;
+struct EditOperation;
+class FileIO;
 } // namespace IO
 
 //! Service class related to editing the mind map data.
@@ -59,6 +73,10 @@ public:
 
     EdgeS addEdge(EdgeS edge);
 
+    //! Creates edges from plain data in one go. The source and target indices refer to nodes of the graph.
+    //! \return the new edge objects in the given order.
+    std::vector<EdgeS> addEdges(const GraphSnapshot::EdgeDataVector & edges);
+
     void addEdgeToSelectionGroup(EdgeR edge, bool isImplicit = false);
 
     void addNodeToSelectionGroup(NodeR node, bool isImplicit = false);
@@ -69,6 +87,17 @@ public:
     //! \return true if at least one selected node pair can be disconnected.
     bool areSelectedNodesDisconnectable() const;
 
+    //! Starts an edit that consists of several changes, e.g. deleting all the selected nodes. Until the outermost
+    //! transaction is committed, only the first undo point gets saved and the autosave and the undo signals are deferred.
+    //! Transactions can be nested.
+    void beginTransaction();
+
+    //! Ends the transaction started by beginTransaction() and runs the deferred work once.
+    //! \returns true if the outermost transaction was committed.
+    bool commitTransaction();
+
+    bool isInTransaction() const;
+
     void deleteEdge(EdgeR edge);
 
     void deleteEdge(int index0, int index1);
@@ -81,6 +110,11 @@ public:
 
     NodeS addNodeAt(QPointF pos);
 
+    //! Creates nodes from plain data in one go, e.g. for importers, paste and automation.
+    //! The nodes get new consecutive indices, so the indices of the models are ignored.
+    //! \return the new node objects in the order of the models.
+    std::vector<NodeS> addNodes(const GraphSnapshot::NodeDataVector & models);
+
     void clearCopyStack();
 
     void clearEdgeSelectionGroup(bool onlyImplicitEdges = false);
@@ -94,7 +128,16 @@ public:
     //! Disconnects (deletes edges) directly connected nodes in the group if possible.
     void disconnectSelectedNodes();
 
-    CopyContext::CopiedData copiedData() const;
+    const CopyContext::CopiedData & copiedData() const;
+
+    QByteArray serializedCopiedData() const;
+
+    //! Replaces the copy buffer with data copied in another window or instance.
+    bool deserializeCopiedData(const QByteArray & data);
+
+    //! Adds the images of the copied data that the mind map doesn't have yet.
+    //! \returns Mapping from the image ids of the copied data to the image ids of the mind map.
+    std::unordered_map<size_t, size_t> addCopiedImages();
 
     NodeS copyNodeAt(NodeCR source, QPointF pos);
 
@@ -118,19 +161,91 @@ public:
 
     bool isRedoable() const;
 
+    //! \returns The position of the current state in the undo history, i.e. the number of undo points.
+    size_t historyPosition() const;
+
+    //! \returns The number of undo and redo points, i.e. the last position in the undo history.
+    size_t historyLength() const;
+
     bool isModified() const;
 
+    //! \returns A count that changes on every change of the mind map, e.g. to know when a cached export is stale.
+    size_t modificationCount() const;
+
+    //! Counts a change that doesn't save an undo point, e.g. typing into a node.
+    void notifyModification();
+
     void loadMindMapData(QString fileName);
 
+    //! Loads a mind map that has been read from elsewhere than a local file, e.g. downloaded from the given URL.
+    //! It has no file to save to, so it's opened as a modified new mind map like an imported outline.
+    void loadMindMapData(MindMapDataU mindMapData, QString url);
+
+    //! \returns The changes from the mind map in the given file to the current one. Throws FileException if the file can't be read.
+    MindMapDiff diffWithFile(QString fileName) const;
+
+    //! \returns Estimated memory usage of the graph, images, undo history and copy buffer.
+    MemoryReport memoryReport() const;
+
     MindMapDataS mindMapData();
 
     void mirror(bool vertically);
 
+    //! Takes the relative positions of the selected nodes for the following moveSelectionGroup() calls.
+    void beginSelectionGroupMove();
+
     void moveSelectionGroup(NodeR reference, QPointF location);
 
     bool nodeHasImageAttached() const;
 
-    void redo();
+    //! Scene items that undo() or redo() added to the graph.
+    struct UndoResult
+    {
+        //! The mind map data was replaced as a whole, e.g. because the style changed, so the scene needs to be rebuilt.
+        bool isReplaced = false;
+
+        std::vector<NodeS> addedNodes;
+
+        std::vector<EdgeS> addedEdges;
+    };
+
+    //! \param steps The number of redo points to go forward at once, see UndoStack::redo(size_t).
+    UndoResult redo(size_t steps = 1);
+
+    //! Undoes or redoes as many steps as needed to reach the given position in the undo history at once,
+    //! so that the scene is updated only for the differences between the current state and the given one.
+    UndoResult jumpToHistoryPosition(size_t position);
+
+    struct ReloadResult
+    {
+        enum class Status
+        {
+            //! The file has the same contents as the mind map, e.g. after our own save.
+            Unchanged,
+
+            //! The file has changed, but it wasn't reloaded, because the mind map has unsaved changes.
+            Conflict,
+
+            Reloaded
+        };
+
+        Status status = Status::Unchanged;
+
+        UndoResult undoResult;
+    };
+
+    //! Reads the current file again, e.g. after another program has changed it, and applies only the differences
+    //! in place like undo does, so that the unchanged items and the selection of the remaining items are kept.
+    //! The reload can be undone. Throws FileException if the file can't be read.
+    ReloadResult reloadMindMapData();
+
+    //! Replaces the mind map with the given changed copy of it, e.g. from ScriptRunner, as a single undoable change.
+    //! Only the differences are applied in place like undo does, however many items changed.
+    UndoResult applyMindMapData(MindMapDataU mindMapData);
+
+    //! Applies an edit made by another instance, e.g. in a collaboration session. The edit doesn't add an undo point,
+    //! and only the changed items are touched unless the edit resets the mind map or changes the style.
+    UndoResult applyEditOperation(const IO::EditOperation & operation);
 
     void removeImageRefsOfSelectedNodes();
 
@@ -142,18 +257,44 @@ public:
         QuitApplication
     };
 
+    //! On quit only the changes since the last autosave are written, to the journal if the file has one.
     void requestAutosave(AutosaveContext context, bool async);
 
+    //! Marks that the process is exiting. The destructor then leaves the mind map, the undo history and the
+    //! retired mind maps to the process teardown, as freeing a huge graph item by item would only delay the exit.
+    void prepareForExit();
+
+    //! Keeps only the plain data of the mind map, e.g. when its tab becomes inactive. The scene items are
+    //! retired and get created again from the plain data when the graph is accessed.
+    void releaseSceneItems();
+
     bool saveMindMap(bool async);
 
     bool saveMindMapAs(QString fileName, bool async);
 
     void saveUndoPoint(bool dontClearRedoStack = false);
 
+    //! Operations whose consecutive undo points can be merged, see saveCoalescedUndoPoint().
+    enum class UndoCoalescing
+    {
+        EditText,
+        MoveSelection
+    };
+
+    //! Saves an undo point like saveUndoPoint(), unless the previous undo point was saved for the same operation
+    //! on the same target without a pause or other undo points in between. Then the changes just grow the delta
+    //! to the previous undo point, so that e.g. typing doesn't snapshot the whole mind map again. Moves are merged
+    //! only while the node selection stays the same.
+    //! \param target Identifies the target of the operation, e.g. the edited text item or the dragged node.
+    void saveCoalescedUndoPoint(UndoCoalescing operation, const void * target);
+
     void saveRedoPoint();
 
     void setColorForSelectedNodes(QColor color);
 
+    //! Enables compressing subsequent XML saves of the current mind map.
+    void setCompressionEnabled(bool compressionEnabled);
+
     void setGridSize(int size, bool autoSnap);
 
     void setMindMapData(MindMapDataS newMindMapData);
@@ -162,6 +303,16 @@ public:
 
     void setTextColorForSelectedNodes(QColor color);
 
+    //! \param bytes Memory budget of the undo history in bytes or 0 for "unlimited", see UndoStack::setMemoryBudget().
+    void setUndoMemoryBudget(size_t bytes);
+
+    //! Collapses the expanded and expands the collapsed nodes of the selection.
+    void toggleCollapsedForSelectedNodes();
+
+    //! Compresses the oldest undo keyframes until the history is within the given bytes, see UndoStack::trim().
+    //! \return The estimated bytes given back.
+    size_t trimUndoHistory(size_t bytes);
+
     std::optional<EdgeP> selectedEdge() const;
 
     std::vector<EdgeP> selectedEdges() const;
@@ -178,11 +329,21 @@ public:
 
     void selectNodesByText(QString text);
 
+    //! Extends the node selection with everything under or above the selected nodes, e.g. to move a whole branch.
+    //! \param excludedIndices Nodes that are not selected even if reached, e.g. the ones in collapsed branches.
+    void selectReachableFromSelectedNodes(Graph::TraversalDirection direction, const std::unordered_set<int> & excludedIndices);
+
     void toggleEdgeInSelectionGroup(EdgeR node);
 
+    void toggleEdgesInSelectionGroup(const std::vector<EdgeP> & edges);
+
     void toggleNodeInSelectionGroup(NodeR node);
 
-    void undo();
+    void toggleNodesInSelectionGroup(const std::vector<NodeP> & nodes);
+
+    //! \param steps The number of undo points to go back at once. Only the differences between the current state
+    //! and the reached undo point are applied to the scene, see UndoStack::undo(size_t).
+    UndoResult undo(size_t steps = 1);
 
     void unselectText();
 
@@ -194,17 +355,46 @@ signals:
 
     void redoEnabled(bool enable);
 
+    //! Emitted with the undo and redo signals, e.g. for a timeline of the undo history.
+    void historyChanged(size_t position, size_t length);
+
+    //! Emitted when the mind map data is replaced as a whole, e.g. on load or on undo of a style change.
+    void mindMapDataReplaced();
+
+    //! Emitted when a background autosave has failed. The mind map stays modified.
+    void autosaveFailed(QString fileName);
+
 private:
     EditorService(const EditorService & e) = delete;
     EditorService & operator=(const EditorService & e) = delete;
 
+    //! Autosaves only the changes to the journal of the current file. Falls back to a full save
+    //! when the file isn't journaled or when the journal is due for compaction.
+    //! \param compactWhenDue false appends also to a journal that is due for compaction, e.g. on quit.
+    bool autosaveToJournal(bool async, bool compactWhenDue = true);
+
+    //! Turns the current mind map into the given undo or redo point by only removing, adding and updating
+    //! the nodes and edges that differ, so that the other scene items can be kept as they are.
+    UndoResult applyUndoOrRedoPoint(MindMapDataU mindMapData);
+
+    //! Removes, adds and updates the nodes and edges of the given delta. Added items that exist are updated.
+    UndoResult applyGraphDelta(const GraphSnapshot::Delta & delta);
+
     void clearSelectionGroups();
 
+    //! Marks the mind map saved if nothing has changed since the snapshot of the finished autosave was taken.
+    void handleAutosaveFinished(bool success, QString fileName);
+
+    //! Replays the autosave journal of the given file on top of the loaded data, if there is one.
+    //! \return true if changes were recovered from the journal.
+    bool recoverFromJournal(QString fileName);
+
+    //! \return The binary FileIO for files with the binary extension, otherwise the XML FileIO.
+    IO::FileIO & fileIOForSaving(QString fileName) const;
+
     using NodePairVector = std::vector<std::pair<NodeP, NodeP>>;
     NodePairVector getConnectableNodes() const;
 
-    NodePairVector getDisconnectableNodes() const;
-
     void sendUndoAndRedoSignals();
 
     void setIsModified(bool isModified);
@@ -213,16 +403,47 @@ private:
 
     MindMapDataS m_mindMapData;
 
+    //! The mind map as it was last read from or written to the file, so that reloadMindMapData() can tell our own
+    //! saves and unsaved changes apart from the changes of other programs.
+    MindMapDataS m_fileMindMapData;
+
     std::unique_ptr<IO::AlzFileIO> m_alzFileIO;
 
+    std::unique_ptr<IO::AlzbFileIO> m_alzbFileIO;
+
+    std::unique_ptr<IO::AutosaveJournal> m_autosaveJournal;
+
+    // Declared after the file IOs so that it's destroyed, and its running save waited for, first
+    std::unique_ptr<AutosaveScheduler> m_autosaveScheduler;
+
+    //! The autosave whose snapshot has been taken, see requestAutosave().
+    struct RunningAutosave
+    {
+        std::weak_ptr<MindMapData> mindMapData;
+
+        MindMapDataS snapshot;
+
+        size_t modificationCount = 0;
+    };
+
+    RunningAutosave m_runningAutosave;
+
     std::unique_ptr<CopyContext> m_copyContext;
 
     std::unique_ptr<EdgeSelectionGroup> m_edgeSelectionGroup;
 
     std::unique_ptr<NodeSelectionGroup> m_nodeSelectionGroup;
 
+    //! Destroys the replaced mind maps in the background.
+    std::unique_ptr<TeardownScheduler> m_teardownScheduler;
+
     std::unique_ptr<UndoStack> m_undoStack;
 
+    // Items highlighted by the latest text search, so that the next search only needs to touch these and the new matches
+    std::vector<std::weak_ptr<SceneItems::Edge>> m_highlightedEdges;
+
+    std::vector<std::weak_ptr<SceneItems::Node>> m_highlightedNodes;
+
     NodeP m_dragAndDropNode = nullptr;
 
     QPointF m_dragAndDropSourcePos;
@@ -235,12 +456,47 @@ private:
 
     bool m_isModified = false;
 
+    size_t m_modificationCount = 0;
+
     bool m_isTouched = false;
 
+    bool m_isExiting = false;
+
     QString m_fileName;
 
     QTimer m_undoTimer;
 
+    struct Transaction
+    {
+        int depth = 0;
+
+        bool isUndoPointSaved = false;
+
+        bool isAutosavePending = false;
+
+        bool areUndoSignalsPending = false;
+
+        //! Batches the graph changes of the transaction and keeps the graph alive until they are delivered.
+        MindMapDataS mindMapData;
+    };
+
+    Transaction m_transaction;
+
+    struct UndoCoalescingState
+    {
+        bool isActive = false;
+
+        UndoCoalescing operation = UndoCoalescing::EditText;
+
+        const void * target = nullptr;
+
+        size_t selectionRevision = 0;
+
+        QElapsedTimer pauseTimer;
+    };
+
+    UndoCoalescingState m_undoCoalescing;
+
     Grid m_grid;
 };
 
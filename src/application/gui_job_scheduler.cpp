@@ -0,0 +1,107 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "gui_job_scheduler.hpp"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+
+GuiJobScheduler::GuiJobScheduler(std::chrono::milliseconds sliceDuration)
+  : m_sliceDuration(sliceDuration)
+{
+    // A zero interval timer fires whenever the event loop has nothing else to do
+    m_sliceTimer.setInterval(0);
+    connect(&m_sliceTimer, &QTimer::timeout, this, &GuiJobScheduler::runSlice);
+}
+
+GuiJobScheduler::JobId GuiJobScheduler::schedule(Step step)
+{
+    const auto id = m_nextId++;
+    m_jobs.push_back({ id, std::make_shared<Step>(std::move(step)) });
+    m_sliceTimer.start();
+    return id;
+}
+
+void GuiJobScheduler::cancel(JobId id)
+{
+    if (const auto iter = findJob(id); iter != m_jobs.end()) {
+        m_jobs.erase(iter);
+    }
+    if (m_jobs.empty()) {
+        m_sliceTimer.stop();
+    }
+}
+
+void GuiJobScheduler::finish(JobId id)
+{
+    while (runStep(id)) {
+    }
+}
+
+bool GuiJobScheduler::isScheduled(JobId id) const
+{
+    return findJob(id) != m_jobs.end();
+}
+
+size_t GuiJobScheduler::jobCount() const
+{
+    return m_jobs.size();
+}
+
+void GuiJobScheduler::runSlice()
+{
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    while (!m_jobs.empty() && elapsed.elapsed() < m_sliceDuration.count()) {
+        runStep(m_jobs.front().id);
+    }
+
+    if (m_jobs.empty()) {
+        m_sliceTimer.stop();
+    }
+}
+
+bool GuiJobScheduler::runStep(JobId id)
+{
+    const auto iter = findJob(id);
+    if (iter == m_jobs.end()) {
+        return false;
+    }
+
+    // The step may schedule and cancel jobs, so the iterator is not valid after it
+    const auto step = iter->step;
+    if ((*step)()) {
+        cancel(id);
+        return false;
+    }
+
+    return isScheduled(id);
+}
+
+std::deque<GuiJobScheduler::Job>::iterator GuiJobScheduler::findJob(JobId id)
+{
+    return std::find_if(m_jobs.begin(), m_jobs.end(), [id](auto && job) {
+        return job.id == id;
+    });
+}
+
+std::deque<GuiJobScheduler::Job>::const_iterator GuiJobScheduler::findJob(JobId id) const
+{
+    return std::find_if(m_jobs.begin(), m_jobs.end(), [id](auto && job) {
+        return job.id == id;
+    });
+}
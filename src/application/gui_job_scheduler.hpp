@@ -0,0 +1,88 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef GUI_JOB_SCHEDULER_HPP
+#define GUI_JOB_SCHEDULER_HPP
+
+#include <QObject>
+#include <QTimer>
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+
+//! Runs long jobs that must run on the GUI thread, e.g. adding items to the scene, in time-sliced chunks
+//! whenever the event loop is idle. The input events and repaints get handled between the slices, so the
+//! window stays responsive while the jobs progress. The jobs run one at a time in the order they were scheduled.
+class GuiJobScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    //! Does one chunk of work, which should take much less than a slice.
+    //! \return true when the job is done.
+    using Step = std::function<bool()>;
+
+    using JobId = size_t;
+
+    //! \param sliceDuration Time budget for running the jobs per event loop iteration.
+    explicit GuiJobScheduler(std::chrono::milliseconds sliceDuration);
+
+    //! Adds a job that runs after the jobs scheduled before it.
+    //! \return Id of the job, never 0.
+    JobId schedule(Step step);
+
+    //! Drops the job without running the rest of it. Can also be called from a step of the job itself.
+    void cancel(JobId id);
+
+    //! Runs the rest of the job synchronously, e.g. when its result is needed right away.
+    void finish(JobId id);
+
+    bool isScheduled(JobId id) const;
+
+    size_t jobCount() const;
+
+private slots:
+
+    void runSlice();
+
+private:
+    //! Runs one step of the given job and removes the job if it's done.
+    //! \return true if the job is still scheduled.
+    bool runStep(JobId id);
+
+    struct Job
+    {
+        JobId id = 0;
+
+        // Shared so that the step stays alive while it runs, even if it cancels its own job
+        std::shared_ptr<Step> step;
+    };
+
+    std::deque<Job>::iterator findJob(JobId id);
+
+    std::deque<Job>::const_iterator findJob(JobId id) const;
+
+    std::chrono::milliseconds m_sliceDuration;
+
+    QTimer m_sliceTimer;
+
+    std::deque<Job> m_jobs;
+
+    JobId m_nextId = 1;
+};
+
+#endif // GUI_JOB_SCHEDULER_HPP
@@ -0,0 +1,78 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "info_reporter.hpp"
+
+#include "../infra/io/mind_map_header.hpp"
+
+#include "simple_logger.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+using juzzlin::L;
+
+static const auto TAG = "InfoReporter";
+
+InfoReporter::InfoReporter(const Options & options)
+  : m_options(options)
+{
+}
+
+bool InfoReporter::isRequested(int argc, char ** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--info")) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QString InfoReporter::report(QString filePath, const IO::MindMapHeader & header)
+{
+    const auto thumbnail = header.thumbnailImage();
+    return QString { "%1: version %2, %3 nodes, %4 edges, bounds %5x%6 at (%7, %8), thumbnail %9x%10" }
+      .arg(filePath, header.applicationVersion)
+      .arg(header.nodeCount)
+      .arg(header.edgeCount)
+      .arg(header.bounds.width())
+      .arg(header.bounds.height())
+      .arg(header.bounds.x())
+      .arg(header.bounds.y())
+      .arg(thumbnail.width())
+      .arg(thumbnail.height());
+}
+
+int InfoReporter::run()
+{
+    if (m_options.inputFiles.isEmpty()) {
+        L(TAG).error() << "No mind map files given";
+        return EXIT_FAILURE;
+    }
+
+    bool allRead = true;
+    for (auto && inputFile : m_options.inputFiles) {
+        if (const auto header = IO::readHeader(inputFile); header) {
+            std::cout << report(inputFile, *header).toStdString() << std::endl;
+        } else {
+            L(TAG).error() << "No header in " << inputFile.toStdString() << ", it was saved with an older version or can't be read";
+            allRead = false;
+        }
+    }
+
+    return allRead ? EXIT_SUCCESS : EXIT_FAILURE;
+}
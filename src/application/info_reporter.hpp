@@ -0,0 +1,54 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INFO_REPORTER_HPP
+#define INFO_REPORTER_HPP
+
+#include <QString>
+#include <QStringList>
+
+namespace IO {
+struct MindMapHeader;
+} // namespace IO
+
+//! Prints a summary of mind map files from the command line without showing any windows. Only the headers
+//! at the start of the files are read, so even huge mind maps are summarized instantly, see IO::MindMapHeader.
+class InfoReporter
+{
+public:
+    struct Options
+    {
+        bool enabled = false;
+
+        QStringList inputFiles;
+    };
+
+    explicit InfoReporter(const Options & options);
+
+    //! \return true if the given command line requests the info. Used to select the
+    //! platform plugin before QApplication is instantiated.
+    static bool isRequested(int argc, char ** argv);
+
+    //! \return The line that describes the given header of the given file.
+    static QString report(QString filePath, const IO::MindMapHeader & header);
+
+    //! \return EXIT_SUCCESS if the headers of all files could be read, EXIT_FAILURE otherwise.
+    int run();
+
+private:
+    Options m_options;
+};
+
+#endif // INFO_REPORTER_HPP
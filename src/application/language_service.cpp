@@ -24,6 +24,7 @@
 #include <QCoreApplication>
 #include <QLibraryInfo>
 #include <QLocale>
+#include <QTimer>
 
 using juzzlin::Argengine;
 using juzzlin::L;
@@ -62,7 +63,7 @@ QString LanguageService::savedUserLanguage() const
     return SC::instance().settingsProxy()->userLanguage();
 }
 
-void LanguageService::installTranslatorForApplicationTranslations(QCoreApplication & application, QStringList languages)
+QString LanguageService::installTranslatorForApplicationTranslations(QCoreApplication & application, QStringList languages)
 {
     // See https://doc.qt.io/qt-5/qtranslator.html#load-1
 
@@ -70,13 +71,13 @@ void LanguageService::installTranslatorForApplicationTranslations(QCoreApplicati
         L(TAG).debug() << "Trying application translations for '" << language.toStdString() << "'";
         if (m_appTranslator.load(Constants::Application::translationsResourceBase() + language)) {
             application.installTranslator(&m_appTranslator);
-            setActiveLanguage(language);
             L(TAG).info() << "Loaded application translations for '" << language.toStdString() << "'";
-            break;
+            return language;
         } else {
             L(TAG).warning() << "Failed to load application translations for '" << language.toStdString() << "'";
         }
     }
+    return {};
 }
 
 void LanguageService::installTranslatorForBuiltInQtTranslations(QCoreApplication & application, QStringList languages)
@@ -116,9 +117,18 @@ void LanguageService::initializeTranslations(QCoreApplication & application)
 {
     const auto languageOptions = commandLineLanguageOrSavedLanguageOrAvailableSystemUiLanguages();
 
-    installTranslatorForBuiltInQtTranslations(application, languageOptions);
+    // Only the application translations are needed to build the main window. The built-in Qt
+    // translations are for standard dialogs etc. and installed once the event loop is running.
+    auto qtLanguageOptions = languageOptions;
+    if (const auto language = installTranslatorForApplicationTranslations(application, languageOptions); !language.isEmpty()) {
+        m_activeLanguage = language;
+        SC::instance().settingsProxy()->setUserLanguage(m_activeLanguage);
+        qtLanguageOptions = QStringList { m_activeLanguage };
+    }
 
-    installTranslatorForApplicationTranslations(application, languageOptions);
+    QTimer::singleShot(0, this, [this, &application, qtLanguageOptions] {
+        installTranslatorForBuiltInQtTranslations(application, qtLanguageOptions);
+    });
 }
 
 QStringList LanguageService::selectableLanguages() const
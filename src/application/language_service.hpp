@@ -51,7 +51,8 @@ signals:
 private:
     QStringList commandLineLanguageOrSavedLanguageOrAvailableSystemUiLanguages() const;
 
-    void installTranslatorForApplicationTranslations(QCoreApplication & application, QStringList languages);
+    //! \returns The language that was loaded or an empty string.
+    QString installTranslatorForApplicationTranslations(QCoreApplication & application, QStringList languages);
 
     void installTranslatorForBuiltInQtTranslations(QCoreApplication & application, QStringList languages);
 
@@ -0,0 +1,45 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MEMORY_REPORT_HPP
+#define MEMORY_REPORT_HPP
+
+#include <QString>
+
+#include <utility>
+#include <vector>
+
+#include "../domain/memory_usage.hpp"
+
+//! Estimated memory usage per subsystem, see ApplicationService::memoryReport().
+struct MemoryReport
+{
+    using Entry = std::pair<QString, MemoryUsage>;
+    std::vector<Entry> entries;
+
+    //! Count of the cache trims so far and the bytes they gave back, see CacheRegistry. Not part of the total.
+    MemoryUsage reclaimed;
+
+    size_t totalBytes() const
+    {
+        size_t bytes = 0;
+        for (auto && entry : entries) {
+            bytes += entry.second.bytes;
+        }
+        return bytes;
+    }
+};
+
+#endif // MEMORY_REPORT_HPP
@@ -0,0 +1,106 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "pdf_export_job.hpp"
+
+#include "../common/constants.hpp"
+#include "../common/trace_recorder.hpp"
+#include "../view/export_snapshot.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QFileInfo>
+#include <QPainter>
+#include <QPdfWriter>
+#include <QTimer>
+
+static const auto TAG = "PdfExportJob";
+
+PdfExportJob::PdfExportJob(std::shared_ptr<ExportSnapshot> snapshot, const ExportParams & exportParams)
+  : m_snapshot(std::move(snapshot))
+  , m_exportParams(exportParams)
+  , m_sceneRect(m_snapshot->scene().sceneRect())
+  , m_pageGrid(exportParams.pageGrid(m_sceneRect.size()))
+{
+}
+
+PdfExportJob::~PdfExportJob() = default;
+
+void PdfExportJob::start()
+{
+    juzzlin::L(TAG).info() << "Exporting " << m_pageGrid.width() * m_pageGrid.height() << " pages (" << m_pageGrid.width() << "x" << m_pageGrid.height() << ")";
+
+    m_writer = std::make_unique<QPdfWriter>(m_exportParams.fileName);
+    m_writer->setCreator(Constants::Application::applicationName());
+    m_writer->setTitle(QFileInfo { m_exportParams.fileName }.completeBaseName());
+    m_writer->setResolution(ExportParams::pdfResolution);
+    m_writer->setPageLayout(m_exportParams.pageLayout);
+
+    m_painter = std::make_unique<QPainter>();
+    if (!m_painter->begin(m_writer.get())) {
+        juzzlin::L(TAG).error() << "Cannot open " << m_exportParams.fileName.toStdString();
+        finish(false);
+        return;
+    }
+    m_painter->setRenderHint(QPainter::Antialiasing);
+    m_painter->setRenderHint(QPainter::TextAntialiasing);
+
+    QTimer::singleShot(0, this, &PdfExportJob::renderNextPage);
+}
+
+void PdfExportJob::finish(bool success)
+{
+    // Ending the painter writes the rest of the file
+    const bool finished = !m_painter || !m_painter->isActive() || m_painter->end();
+    m_painter.reset();
+    m_writer.reset();
+    m_snapshot.reset();
+    emit this->finished(success && finished);
+}
+
+QRectF PdfExportJob::pageSource(int page) const
+{
+    const auto pageSize = m_exportParams.pageSceneSize();
+    const auto column = page % m_pageGrid.width();
+    const auto row = page / m_pageGrid.width();
+    return QRectF { m_sceneRect.topLeft() + QPointF { column * pageSize.width(), row * pageSize.height() }, pageSize }.intersected(m_sceneRect);
+}
+
+void PdfExportJob::renderNextPage()
+{
+    const TraceRecorder::ScopedSpan span { "PdfExportJob::renderNextPage" };
+
+    if (m_page > 0 && !m_writer->newPage()) {
+        finish(false);
+        return;
+    }
+
+    // The last column and row only cover the rest of the scene
+    const auto source = pageSource(m_page);
+    const QRectF target { 0, 0, source.width() * m_exportParams.pageScale, source.height() * m_exportParams.pageScale };
+    m_painter->fillRect(target, m_snapshot->backgroundColor());
+    m_snapshot->scene().render(m_painter.get(), target, source, Qt::IgnoreAspectRatio);
+
+    const auto pageCount = m_pageGrid.width() * m_pageGrid.height();
+    m_page++;
+    emit progressed(m_page * 100 / pageCount);
+
+    if (m_page < pageCount) {
+        // Let the editor process events between the pages
+        QTimer::singleShot(0, this, &PdfExportJob::renderNextPage);
+    } else {
+        finish(true);
+    }
+}
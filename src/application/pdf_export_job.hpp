@@ -0,0 +1,75 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PDF_EXPORT_JOB_HPP
+#define PDF_EXPORT_JOB_HPP
+
+#include <QObject>
+#include <QRectF>
+#include <QSize>
+
+#include <memory>
+
+#include "../infra/export_params.hpp"
+
+class ExportSnapshot;
+class QPainter;
+class QPdfWriter;
+
+//! Exports a snapshot of the mind map to a vector PDF that is split into pages at the given scale.
+//! One page is rendered per event loop iteration and written out before the next one, so the memory
+//! use doesn't depend on the number of pages. Rendering a page only visits the items that intersect it.
+class PdfExportJob : public QObject
+{
+    Q_OBJECT
+
+public:
+    //! \param snapshot May be shared with other exports, e.g. when it's cached until the mind map changes.
+    PdfExportJob(std::shared_ptr<ExportSnapshot> snapshot, const ExportParams & exportParams);
+
+    ~PdfExportJob() override;
+
+    void start();
+
+signals:
+
+    void progressed(int percentage);
+
+    void finished(bool success);
+
+private:
+    void finish(bool success);
+
+    void renderNextPage();
+
+    //! \return The part of the scene on the given page.
+    QRectF pageSource(int page) const;
+
+    std::shared_ptr<ExportSnapshot> m_snapshot;
+
+    ExportParams m_exportParams;
+
+    std::unique_ptr<QPdfWriter> m_writer;
+
+    std::unique_ptr<QPainter> m_painter;
+
+    QRectF m_sceneRect;
+
+    QSize m_pageGrid;
+
+    int m_page = 0;
+};
+
+#endif // PDF_EXPORT_JOB_HPP
@@ -0,0 +1,170 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "performance_profile.hpp"
+
+#include "../common/constants.hpp"
+
+#include <algorithm>
+
+PerformanceProfile::PerformanceProfile()
+  : m_balancedItemCount { Constants::Settings::defaultBalancedProfileItemCount() }
+  , m_speedItemCount { Constants::Settings::defaultSpeedProfileItemCount() }
+{
+}
+
+PerformanceProfile::Mode PerformanceProfile::mode() const
+{
+    return m_mode;
+}
+
+bool PerformanceProfile::setMode(Mode mode)
+{
+    m_mode = mode;
+    m_frameTimeRaise = 0;
+    return updateTier();
+}
+
+bool PerformanceProfile::setItemCountThresholds(size_t balancedItemCount, size_t speedItemCount)
+{
+    m_balancedItemCount = balancedItemCount;
+    m_speedItemCount = std::max(balancedItemCount, speedItemCount);
+    return updateTier();
+}
+
+bool PerformanceProfile::setItemCount(size_t itemCount)
+{
+    m_itemCount = itemCount;
+    return updateTier();
+}
+
+bool PerformanceProfile::addFrameTime(double paintMilliseconds)
+{
+    if (m_mode != Mode::Automatic) {
+        return false;
+    }
+
+    // Smoothed so that single slow frames, e.g. when a large part of the scene is exposed at once, don't change the tier
+    const double smoothing = 1.0 / 8;
+    m_averageFrameMilliseconds = m_settledFrames ? m_averageFrameMilliseconds + (paintMilliseconds - m_averageFrameMilliseconds) * smoothing : paintMilliseconds;
+    if (++m_settledFrames < Constants::View::performanceProfileSettleFrames()) {
+        return false;
+    }
+
+    // The gap between the limits keeps the tier from flipping when the frames of the higher tier are just fast enough
+    if (m_averageFrameMilliseconds > Constants::View::slowFrameMilliseconds() && m_tier != Tier::Speed) {
+        m_frameTimeRaise++;
+        return updateTier();
+    }
+
+    if (m_averageFrameMilliseconds < Constants::View::fastFrameMilliseconds() && m_frameTimeRaise) {
+        m_frameTimeRaise--;
+        return updateTier();
+    }
+
+    return false;
+}
+
+PerformanceProfile::Tier PerformanceProfile::tier() const
+{
+    return m_tier;
+}
+
+PerformanceProfile::Policy PerformanceProfile::policy() const
+{
+    return policy(m_tier);
+}
+
+PerformanceProfile::Policy PerformanceProfile::policy(Tier tier)
+{
+    Policy policy;
+    switch (tier) {
+    case Tier::Quality:
+        policy.reducedLevelOfDetail = Constants::View::reducedLevelOfDetail();
+        policy.minimalLevelOfDetail = Constants::View::minimalLevelOfDetail();
+        break;
+    case Tier::Balanced:
+        policy.edgeAnimations = false;
+        policy.reducedLevelOfDetail = 0.5;
+        policy.minimalLevelOfDetail = 0.2;
+        break;
+    case Tier::Speed:
+        policy.shadows = false;
+        policy.edgeAnimations = false;
+        policy.virtualization = true;
+        policy.hardwareAcceleration = true;
+        policy.reducedLevelOfDetail = 0.7;
+        policy.minimalLevelOfDetail = 0.3;
+        policy.undoMemoryBudgetFactor = 2;
+        break;
+    }
+    return policy;
+}
+
+const char * PerformanceProfile::tierName(Tier tier)
+{
+    switch (tier) {
+    case Tier::Quality:
+        return "quality";
+    case Tier::Balanced:
+        return "balanced";
+    case Tier::Speed:
+        return "speed";
+    }
+    return "";
+}
+
+PerformanceProfile::Tier PerformanceProfile::itemCountTier() const
+{
+    // A tier is left downwards only clearly below its threshold, so that editing around a threshold doesn't flip the tier
+    const auto lowered = [](size_t threshold) {
+        return threshold - threshold / 10;
+    };
+    if (m_itemCount >= (m_itemCountTier == Tier::Speed ? lowered(m_speedItemCount) : m_speedItemCount)) {
+        return Tier::Speed;
+    }
+    if (m_itemCount >= (m_itemCountTier != Tier::Quality ? lowered(m_balancedItemCount) : m_balancedItemCount)) {
+        return Tier::Balanced;
+    }
+    return Tier::Quality;
+}
+
+bool PerformanceProfile::updateTier()
+{
+    auto tier = m_tier;
+    switch (m_mode) {
+    case Mode::Automatic:
+        m_itemCountTier = itemCountTier();
+        tier = static_cast<Tier>(std::min(static_cast<size_t>(m_itemCountTier) + m_frameTimeRaise, static_cast<size_t>(Tier::Speed)));
+        break;
+    case Mode::Quality:
+        tier = Tier::Quality;
+        break;
+    case Mode::Balanced:
+        tier = Tier::Balanced;
+        break;
+    case Mode::Speed:
+        tier = Tier::Speed;
+        break;
+    }
+
+    if (tier == m_tier) {
+        return false;
+    }
+
+    m_tier = tier;
+    m_settledFrames = 0;
+    return true;
+}
@@ -0,0 +1,115 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PERFORMANCE_PROFILE_HPP
+#define PERFORMANCE_PROFILE_HPP
+
+#include <cstddef>
+
+//! Picks the rendering and memory tradeoffs of the editor in one place. In automatic mode the tier follows
+//! the number of nodes and edges and is raised further if the measured paint times stay too long.
+class PerformanceProfile
+{
+public:
+    enum class Tier
+    {
+        Quality,
+        Balanced,
+        Speed
+    };
+
+    enum class Mode
+    {
+        Automatic,
+        Quality,
+        Balanced,
+        Speed
+    };
+
+    //! What a tier switches on and off.
+    struct Policy
+    {
+        bool shadows = true;
+
+        bool edgeAnimations = true;
+
+        //! Only the items near the viewport are kept in the scene.
+        bool virtualization = false;
+
+        //! The editor view renders via OpenGL even if it's not enabled in the settings.
+        bool hardwareAcceleration = false;
+
+        //! See LevelOfDetail::setThresholds().
+        double reducedLevelOfDetail = 0;
+
+        double minimalLevelOfDetail = 0;
+
+        //! Multiplier of the undo memory budget, so that fewer keyframes of large graphs get compressed while editing.
+        size_t undoMemoryBudgetFactor = 1;
+    };
+
+    PerformanceProfile();
+
+    Mode mode() const;
+
+    //! \returns true if the tier changed.
+    bool setMode(Mode mode);
+
+    //! Sets the numbers of nodes and edges from which the Balanced and the Speed tiers are used in automatic mode.
+    //! \returns true if the tier changed.
+    bool setItemCountThresholds(size_t balancedItemCount, size_t speedItemCount);
+
+    //! \returns true if the tier changed.
+    bool setItemCount(size_t itemCount);
+
+    //! Feeds the paint time of a frame. Only used in automatic mode.
+    //! \returns true if the tier changed.
+    bool addFrameTime(double paintMilliseconds);
+
+    Tier tier() const;
+
+    Policy policy() const;
+
+    static Policy policy(Tier tier);
+
+    static const char * tierName(Tier tier);
+
+private:
+    Tier itemCountTier() const;
+
+    bool updateTier();
+
+    Mode m_mode = Mode::Automatic;
+
+    size_t m_balancedItemCount;
+
+    size_t m_speedItemCount;
+
+    size_t m_itemCount = 0;
+
+    Tier m_itemCountTier = Tier::Quality;
+
+    //! Tiers added to the item count tier because of slow frames.
+    size_t m_frameTimeRaise = 0;
+
+    double m_averageFrameMilliseconds = 0;
+
+    //! Frames since the tier last changed. The frame times are judged only after the new tier has settled.
+    size_t m_settledFrames = 0;
+
+    Tier m_tier = Tier::Quality;
+};
+
+#endif // PERFORMANCE_PROFILE_HPP
@@ -0,0 +1,93 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "png_export_job.hpp"
+
+#include "../common/constants.hpp"
+#include "../common/trace_recorder.hpp"
+#include "../infra/io/buffered_image_writer.hpp"
+#include "../infra/io/png_stream_writer.hpp"
+#include "../view/export_snapshot.hpp"
+
+#include <QTimer>
+
+#include <algorithm>
+
+namespace {
+
+std::unique_ptr<IO::ImageStreamWriter> createWriter(const ExportParams & exportParams)
+{
+    switch (exportParams.imageFormat) {
+    case ExportParams::ImageFormat::Jpeg:
+        return std::make_unique<IO::BufferedImageWriter>(exportParams.fileName, exportParams.imageSize, "jpg", exportParams.quality);
+    case ExportParams::ImageFormat::WebP:
+        return std::make_unique<IO::BufferedImageWriter>(exportParams.fileName, exportParams.imageSize, "webp", exportParams.quality);
+    case ExportParams::ImageFormat::Png:
+        break;
+    }
+    return std::make_unique<IO::PngStreamWriter>(exportParams.fileName, exportParams.imageSize, exportParams.transparentBackground, exportParams.compressionLevel);
+}
+
+} // namespace
+
+PngExportJob::PngExportJob(std::shared_ptr<ExportSnapshot> snapshot, const ExportParams & exportParams)
+  : m_snapshot(std::move(snapshot))
+  , m_exportParams(exportParams)
+  , m_writer(createWriter(exportParams))
+  , m_bandHeight(std::max(1, static_cast<int>(Constants::View::pngExportBandBytes() / (static_cast<size_t>(exportParams.imageSize.width()) * 4))))
+{
+}
+
+PngExportJob::~PngExportJob() = default;
+
+void PngExportJob::start()
+{
+    if (!m_writer->open()) {
+        finish(false);
+        return;
+    }
+
+    QTimer::singleShot(0, this, &PngExportJob::renderNextBand);
+}
+
+void PngExportJob::finish(bool success)
+{
+    // Also waits for the bands that are still being compressed
+    const bool finished = m_writer->finish();
+    m_snapshot.reset();
+    emit this->finished(success && finished);
+}
+
+void PngExportJob::renderNextBand()
+{
+    const TraceRecorder::ScopedSpan span { "PngExportJob::renderNextBand" };
+
+    const auto size = m_exportParams.imageSize;
+    const auto band = m_snapshot->scene().toImageBand(size, m_snapshot->backgroundColor(), m_exportParams.transparentBackground, m_bandTop, m_bandHeight);
+    if (!m_writer->writeBand(band)) {
+        finish(false);
+        return;
+    }
+
+    m_bandTop += band.height();
+    emit progressed(m_bandTop * 100 / size.height());
+
+    if (m_bandTop < size.height()) {
+        // Let the editor process events between the bands
+        QTimer::singleShot(0, this, &PngExportJob::renderNextBand);
+    } else {
+        finish(true);
+    }
+}
@@ -0,0 +1,68 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PNG_EXPORT_JOB_HPP
+#define PNG_EXPORT_JOB_HPP
+
+#include <QObject>
+
+#include <memory>
+
+#include "../infra/export_params.hpp"
+
+class ExportSnapshot;
+
+namespace IO {
+class ImageStreamWriter;
+}
+
+//! Exports a snapshot of the mind map to an image file without blocking the editor. One band of the
+//! image is rendered per event loop iteration. A PNG is streamed so that the finished bands are compressed
+//! on worker threads while the next ones are rendered, other formats are encoded once all bands are rendered.
+class PngExportJob : public QObject
+{
+    Q_OBJECT
+
+public:
+    //! \param snapshot May be shared with other exports, e.g. when it's cached until the mind map changes.
+    PngExportJob(std::shared_ptr<ExportSnapshot> snapshot, const ExportParams & exportParams);
+
+    ~PngExportJob() override;
+
+    void start();
+
+signals:
+
+    void progressed(int percentage);
+
+    void finished(bool success);
+
+private:
+    void finish(bool success);
+
+    void renderNextBand();
+
+    std::shared_ptr<ExportSnapshot> m_snapshot;
+
+    ExportParams m_exportParams;
+
+    std::unique_ptr<IO::ImageStreamWriter> m_writer;
+
+    int m_bandTop = 0;
+
+    int m_bandHeight = 1;
+};
+
+#endif // PNG_EXPORT_JOB_HPP
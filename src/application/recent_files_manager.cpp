@@ -15,6 +15,7 @@
 
 #include "recent_files_manager.hpp"
 
+#include "../infra/io/url_reader.hpp"
 #include "../infra/settings.hpp"
 
 #include "contrib/SimpleLogger/src/simple_logger.hpp"
@@ -31,9 +32,10 @@ RecentFilesManager::RecentFilesManager()
 
 void RecentFilesManager::addRecentFile(QString filePath)
 {
-    const QFileInfo fi(filePath);
-
-    filePath = fi.absoluteFilePath();
+    // URLs are reopened as they are
+    if (!IO::UrlReader::isUrl(filePath)) {
+        filePath = QFileInfo { filePath }.absoluteFilePath();
+    }
 
     m_recentFiles.removeAll(filePath);
     m_recentFiles.push_front(filePath);
@@ -0,0 +1,564 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "script_api.hpp"
+
+#include "../common/constants.hpp"
+#include "service_container.hpp"
+#include "settings_proxy.hpp"
+#include "../domain/graph.hpp"
+#include "../domain/mind_map_data.hpp"
+#include "../domain/tree_layout.hpp"
+
+#include <QJSEngine>
+#include <QRectF>
+#include <QUuid>
+#include <QtGlobal>
+
+#include <algorithm>
+
+namespace {
+
+const auto ARROW_MODE_DOUBLE = "double";
+const auto ARROW_MODE_HIDDEN = "hidden";
+const auto ARROW_MODE_SINGLE = "single";
+
+QString arrowModeToString(SceneItems::EdgeModel::ArrowMode arrowMode)
+{
+    switch (arrowMode) {
+    case SceneItems::EdgeModel::ArrowMode::Double:
+        return ARROW_MODE_DOUBLE;
+    case SceneItems::EdgeModel::ArrowMode::Hidden:
+        return ARROW_MODE_HIDDEN;
+    case SceneItems::EdgeModel::ArrowMode::Single:
+        break;
+    }
+    return ARROW_MODE_SINGLE;
+}
+
+QVariantMap edgeToVariant(const GraphSnapshot::EdgeData & edge)
+{
+    return {
+        { "source", edge.sourceIndex },
+        { "target", edge.targetIndex },
+        { "text", edge.model.text.toString() },
+        { "arrowMode", arrowModeToString(edge.model.style.arrowMode) },
+        { "dashed", edge.model.style.dashedLine },
+        { "reversed", edge.model.reversed }
+    };
+}
+
+QVariantMap nodeToVariant(const SceneItems::NodeModel & node)
+{
+    return {
+        { "index", node.index },
+        { "x", node.location.x() },
+        { "y", node.location.y() },
+        { "width", node.size.width() },
+        { "height", node.size.height() },
+        { "text", node.text.toString() },
+        { "color", node.color.name() },
+        { "textColor", node.textColor.name() },
+        { "collapsed", node.collapsed },
+        { "uuid", node.uuid.isNull() ? QString {} : node.uuid.toString() }
+    };
+}
+
+} // namespace
+
+ScriptApi::ScriptApi(const MindMapData & mindMapData, QObject * parent)
+  : QObject(parent)
+  , m_mindMapData(std::make_unique<MindMapData>(mindMapData, GraphSnapshot {}))
+  , m_defaultNode(SC::instance().settingsProxy()->nodeColor(), SC::instance().settingsProxy()->nodeTextColor())
+  , m_defaultArrowMode(SC::instance().settingsProxy()->edgeArrowMode())
+{
+    m_defaultNode.size = { static_cast<double>(Constants::Node::minWidth()), static_cast<double>(Constants::Node::minHeight()) };
+
+    const auto snapshot = mindMapData.graphSnapshot();
+    m_nodes = snapshot.nodes();
+    m_edges = snapshot.edges();
+
+    m_nextNodeIndex = mindMapData.graph().nextNodeIndex();
+    for (size_t slot = 0; slot < m_nodes.size(); slot++) {
+        m_nodeSlots[m_nodes.at(slot).index] = slot;
+        m_nextNodeIndex = std::max(m_nextNodeIndex, m_nodes.at(slot).index + 1);
+    }
+
+    for (size_t slot = 0; slot < m_edges.size(); slot++) {
+        m_edgeSlots[Graph::buildKeyFromIndices(m_edges.at(slot).sourceIndex, m_edges.at(slot).targetIndex)] = slot;
+    }
+}
+
+QString ScriptApi::error() const
+{
+    return m_error;
+}
+
+bool ScriptApi::isModified() const
+{
+    return m_isModified;
+}
+
+MindMapDataU ScriptApi::takeMindMapData()
+{
+    if (!m_isModified || !m_mindMapData) {
+        return {};
+    }
+
+    removeDanglingEdges();
+    m_mindMapData->setGraphSnapshot({ std::move(m_nodes), std::move(m_edges) });
+    m_nodes.clear();
+    m_nodeSlots.clear();
+    m_edges.clear();
+    m_edgeSlots.clear();
+    m_isModified = false;
+
+    return std::move(m_mindMapData);
+}
+
+int ScriptApi::nodeCount() const
+{
+    return static_cast<int>(m_nodes.size());
+}
+
+int ScriptApi::edgeCount()
+{
+    removeDanglingEdges();
+    return static_cast<int>(m_edges.size());
+}
+
+QVariantList ScriptApi::nodes() const
+{
+    QVariantList indices;
+    indices.reserve(static_cast<int>(m_nodes.size()));
+    for (auto && node : m_nodes) {
+        indices.push_back(node.index);
+    }
+    return indices;
+}
+
+QVariant ScriptApi::node(int index) const
+{
+    if (const auto iter = m_nodeSlots.find(index); iter != m_nodeSlots.end()) {
+        return nodeToVariant(m_nodes.at(iter->second));
+    }
+    return {};
+}
+
+QVariantList ScriptApi::findNodes(QString text) const
+{
+    QVariantList indices;
+    for (auto && node : m_nodes) {
+        if (node.text.contains(text, Qt::CaseInsensitive)) {
+            indices.push_back(node.index);
+        }
+    }
+    return indices;
+}
+
+QVariantList ScriptApi::edges()
+{
+    removeDanglingEdges();
+
+    QVariantList edges;
+    edges.reserve(static_cast<int>(m_edges.size()));
+    for (auto && edge : m_edges) {
+        edges.push_back(edgeToVariant(edge));
+    }
+    return edges;
+}
+
+int ScriptApi::addNode(QVariantMap properties)
+{
+    if (!m_error.isEmpty()) {
+        return -1;
+    }
+
+    auto node = m_defaultNode;
+    node.index = m_nextNodeIndex;
+    if (!applyNodeProperties(node, properties)) {
+        return -1;
+    }
+
+    m_nextNodeIndex++;
+    m_nodeSlots[node.index] = m_nodes.size();
+    m_nodes.push_back(node);
+    m_isModified = true;
+
+    return node.index;
+}
+
+QVariantList ScriptApi::addNodes(QVariantList nodes)
+{
+    m_nodes.reserve(m_nodes.size() + static_cast<size_t>(nodes.size()));
+    m_nodeSlots.reserve(m_nodeSlots.size() + static_cast<size_t>(nodes.size()));
+
+    QVariantList indices;
+    indices.reserve(nodes.size());
+    for (auto && node : nodes) {
+        const auto index = addNode(node.toMap());
+        if (index < 0) {
+            break;
+        }
+        indices.push_back(index);
+    }
+    return indices;
+}
+
+bool ScriptApi::setNode(int index, QVariantMap properties)
+{
+    if (!m_error.isEmpty()) {
+        return false;
+    }
+
+    const auto iter = m_nodeSlots.find(index);
+    if (iter == m_nodeSlots.end()) {
+        return fail(QString { "setNode(): No node with index %1" }.arg(index));
+    }
+
+    auto node = m_nodes.at(iter->second);
+    if (!applyNodeProperties(node, properties)) {
+        return false;
+    }
+
+    m_nodes.at(iter->second) = node;
+    m_isModified = true;
+
+    return true;
+}
+
+bool ScriptApi::deleteNode(int index)
+{
+    if (!m_error.isEmpty()) {
+        return false;
+    }
+
+    const auto iter = m_nodeSlots.find(index);
+    if (iter == m_nodeSlots.end()) {
+        return fail(QString { "deleteNode(): No node with index %1" }.arg(index));
+    }
+
+    // Move the last node to the freed slot
+    const auto slot = iter->second;
+    m_nodeSlots.erase(iter);
+    if (slot + 1 < m_nodes.size()) {
+        m_nodes.at(slot) = m_nodes.back();
+        m_nodeSlots[m_nodes.at(slot).index] = slot;
+    }
+    m_nodes.pop_back();
+
+    m_hasDanglingEdges = true;
+    m_isModified = true;
+
+    return true;
+}
+
+bool ScriptApi::addEdge(int source, int target, QVariantMap properties)
+{
+    if (!m_error.isEmpty()) {
+        return false;
+    }
+
+    if (!m_nodeSlots.count(source) || !m_nodeSlots.count(target)) {
+        return fail(QString { "addEdge(): No node with index %1" }.arg(m_nodeSlots.count(source) ? target : source));
+    }
+
+    if (source == target) {
+        return fail(QString { "addEdge(): Can't connect node %1 to itself" }.arg(source));
+    }
+
+    removeDanglingEdges();
+
+    const auto key = Graph::buildKeyFromIndices(source, target);
+    if (m_edgeSlots.count(key)) {
+        return fail(QString { "addEdge(): Nodes %1 and %2 are already connected" }.arg(source).arg(target));
+    }
+
+    GraphSnapshot::EdgeData edge { SceneItems::EdgeModel { false, { m_defaultArrowMode } }, source, target };
+    edge.model.style.arrowSize = m_mindMapData->arrowSize();
+    edge.model.style.edgeWidth = m_mindMapData->edgeWidth();
+    if (!applyEdgeProperties(edge.model, properties)) {
+        return false;
+    }
+
+    m_edgeSlots[key] = m_edges.size();
+    m_edges.push_back(edge);
+    m_isModified = true;
+
+    return true;
+}
+
+bool ScriptApi::addEdges(QVariantList edges)
+{
+    m_edges.reserve(m_edges.size() + static_cast<size_t>(edges.size()));
+    m_edgeSlots.reserve(m_edgeSlots.size() + static_cast<size_t>(edges.size()));
+
+    for (auto && edge : edges) {
+        const auto properties = edge.toMap();
+        if (!properties.contains("source") || !properties.contains("target")) {
+            return fail("addEdges(): Each edge needs a source and a target");
+        }
+        if (!addEdge(properties.value("source").toInt(), properties.value("target").toInt(), properties)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ScriptApi::setEdge(int source, int target, QVariantMap properties)
+{
+    if (!m_error.isEmpty()) {
+        return false;
+    }
+
+    removeDanglingEdges();
+
+    const auto iter = m_edgeSlots.find(Graph::buildKeyFromIndices(source, target));
+    if (iter == m_edgeSlots.end()) {
+        return fail(QString { "setEdge(): Nodes %1 and %2 are not connected" }.arg(source).arg(target));
+    }
+
+    auto model = m_edges.at(iter->second).model;
+    if (!applyEdgeProperties(model, properties)) {
+        return false;
+    }
+
+    m_edges.at(iter->second).model = model;
+    m_isModified = true;
+
+    return true;
+}
+
+bool ScriptApi::deleteEdge(int source, int target)
+{
+    if (!m_error.isEmpty()) {
+        return false;
+    }
+
+    removeDanglingEdges();
+
+    const auto iter = m_edgeSlots.find(Graph::buildKeyFromIndices(source, target));
+    if (iter == m_edgeSlots.end()) {
+        return fail(QString { "deleteEdge(): Nodes %1 and %2 are not connected" }.arg(source).arg(target));
+    }
+
+    const auto slot = iter->second;
+    m_edgeSlots.erase(iter);
+    if (slot + 1 < m_edges.size()) {
+        m_edges.at(slot) = m_edges.back();
+        m_edgeSlots[Graph::buildKeyFromIndices(m_edges.at(slot).sourceIndex, m_edges.at(slot).targetIndex)] = slot;
+    }
+    m_edges.pop_back();
+
+    m_isModified = true;
+
+    return true;
+}
+
+bool ScriptApi::setStyle(QVariantMap properties)
+{
+    if (!m_error.isEmpty()) {
+        return false;
+    }
+
+    // Validate all before changing anything
+    QColor backgroundColor = m_mindMapData->backgroundColor();
+    QColor edgeColor = m_mindMapData->edgeColor();
+    QColor gridColor = m_mindMapData->gridColor();
+    if ((properties.contains("backgroundColor") && !toColor(properties.value("backgroundColor"), backgroundColor))
+        || (properties.contains("edgeColor") && !toColor(properties.value("edgeColor"), edgeColor))
+        || (properties.contains("gridColor") && !toColor(properties.value("gridColor"), gridColor))) {
+        return false;
+    }
+
+    m_mindMapData->setBackgroundColor(backgroundColor);
+    m_mindMapData->setEdgeColor(edgeColor);
+    m_mindMapData->setGridColor(gridColor);
+
+    if (properties.contains("arrowSize")) {
+        m_mindMapData->setArrowSize(properties.value("arrowSize").toDouble());
+    }
+    if (properties.contains("edgeWidth")) {
+        m_mindMapData->setEdgeWidth(properties.value("edgeWidth").toDouble());
+    }
+    if (properties.contains("textSize")) {
+        m_mindMapData->setTextSize(properties.value("textSize").toInt());
+    }
+    if (properties.contains("cornerRadius")) {
+        m_mindMapData->setCornerRadius(properties.value("cornerRadius").toInt());
+    }
+
+    // The edges follow the global style like in the editor
+    for (auto && edge : m_edges) {
+        edge.model.style.arrowSize = m_mindMapData->arrowSize();
+        edge.model.style.edgeWidth = m_mindMapData->edgeWidth();
+    }
+
+    m_isModified = true;
+
+    return true;
+}
+
+void ScriptApi::layoutTree(bool radial)
+{
+    if (!m_error.isEmpty() || m_nodes.empty()) {
+        return;
+    }
+
+    removeDanglingEdges();
+
+    std::vector<QPointF> positions;
+    positions.reserve(m_nodes.size());
+    std::vector<QSizeF> sizes;
+    sizes.reserve(m_nodes.size());
+    QRectF bounds;
+    for (auto && node : m_nodes) {
+        positions.push_back(node.location);
+        const QSizeF size { std::max(node.size.width(), static_cast<double>(Constants::Node::minWidth())),
+                            std::max(node.size.height(), static_cast<double>(Constants::Node::minHeight())) };
+        sizes.push_back(size);
+        bounds |= QRectF { node.location - QPointF { size.width() / 2, size.height() / 2 }, size };
+    }
+
+    TreeLayout::EdgeVector edges;
+    edges.reserve(m_edges.size());
+    for (auto && edge : m_edges) {
+        edges.push_back({ m_nodeSlots.at(edge.sourceIndex), m_nodeSlots.at(edge.targetIndex) });
+    }
+
+    TreeLayout layout { std::move(positions), std::move(sizes), edges,
+                        { radial ? TreeLayout::Style::Radial : TreeLayout::Style::LeftRight, m_mindMapData->minEdgeLength(), bounds.center() } };
+    layout.run();
+
+    for (size_t slot = 0; slot < m_nodes.size(); slot++) {
+        m_nodes.at(slot).location = layout.positions().at(slot);
+    }
+
+    m_isModified = true;
+}
+
+bool ScriptApi::applyEdgeProperties(SceneItems::EdgeModel & model, const QVariantMap & properties)
+{
+    if (properties.contains("arrowMode")) {
+        const auto arrowMode = properties.value("arrowMode").toString().toLower();
+        if (arrowMode == ARROW_MODE_SINGLE) {
+            model.style.arrowMode = SceneItems::EdgeModel::ArrowMode::Single;
+        } else if (arrowMode == ARROW_MODE_DOUBLE) {
+            model.style.arrowMode = SceneItems::EdgeModel::ArrowMode::Double;
+        } else if (arrowMode == ARROW_MODE_HIDDEN) {
+            model.style.arrowMode = SceneItems::EdgeModel::ArrowMode::Hidden;
+        } else {
+            return fail(QString { "Invalid arrow mode: '%1'" }.arg(arrowMode));
+        }
+    }
+
+    if (properties.contains("dashed")) {
+        model.style.dashedLine = properties.value("dashed").toBool();
+    }
+
+    if (properties.contains("reversed")) {
+        model.reversed = properties.value("reversed").toBool();
+    }
+
+    if (properties.contains("text")) {
+        model.text = properties.value("text").toString();
+    }
+
+    return true;
+}
+
+bool ScriptApi::applyNodeProperties(SceneItems::NodeModel & node, const QVariantMap & properties)
+{
+    if ((properties.contains("color") && !toColor(properties.value("color"), node.color))
+        || (properties.contains("textColor") && !toColor(properties.value("textColor"), node.textColor))) {
+        return false;
+    }
+
+    if (properties.contains("x")) {
+        node.location.setX(properties.value("x").toDouble());
+    }
+
+    if (properties.contains("y")) {
+        node.location.setY(properties.value("y").toDouble());
+    }
+
+    if (properties.contains("text")) {
+        node.text = properties.value("text").toString();
+    }
+
+    if (properties.contains("collapsed")) {
+        node.collapsed = properties.value("collapsed").toBool();
+    }
+
+    if (properties.contains("uuid")) {
+        // An empty string clears the UUID
+        const auto uuidString = properties.value("uuid").toString();
+        const QUuid uuid { uuidString };
+        if (uuid.isNull() && !uuidString.isEmpty()) {
+            return fail(QString { "Invalid UUID: '%1'" }.arg(uuidString));
+        }
+        node.uuid = uuid;
+    }
+
+    return true;
+}
+
+bool ScriptApi::fail(QString message)
+{
+    if (m_error.isEmpty()) {
+        m_error = message;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+        if (const auto engine = qjsEngine(this)) {
+            engine->throwError(message);
+        }
+#endif
+    }
+
+    return false;
+}
+
+void ScriptApi::removeDanglingEdges()
+{
+    if (!m_hasDanglingEdges) {
+        return;
+    }
+
+    m_edges.erase(std::remove_if(m_edges.begin(), m_edges.end(), [this](auto && edge) {
+                      return !m_nodeSlots.count(edge.sourceIndex) || !m_nodeSlots.count(edge.targetIndex);
+                  }),
+                  m_edges.end());
+
+    m_edgeSlots.clear();
+    for (size_t slot = 0; slot < m_edges.size(); slot++) {
+        m_edgeSlots[Graph::buildKeyFromIndices(m_edges.at(slot).sourceIndex, m_edges.at(slot).targetIndex)] = slot;
+    }
+
+    m_hasDanglingEdges = false;
+}
+
+bool ScriptApi::toColor(const QVariant & value, QColor & color)
+{
+    const QColor parsedColor { value.toString() };
+    if (!parsedColor.isValid()) {
+        return fail(QString { "Invalid color: '%1'" }.arg(value.toString()));
+    }
+
+    color = parsedColor;
+
+    return true;
+}
+
+ScriptApi::~ScriptApi() = default;
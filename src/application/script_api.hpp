@@ -0,0 +1,140 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SCRIPT_API_HPP
+#define SCRIPT_API_HPP
+
+#include <QObject>
+#include <QString>
+#include <QVariantList>
+#include <QVariantMap>
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "../common/types.hpp"
+#include "../domain/graph_snapshot.hpp"
+
+//! The mind map as seen by scripts, see ScriptRunner. The calls edit a plain-data copy of the graph without
+//! touching any scene items, so that creating, connecting, styling and laying out thousands of items costs
+//! about as much as filling a few vectors. The copy is applied to the real mind map only once the script has
+//! finished. Nodes are referred to by their indices, which stay valid for the whole script.
+class ScriptApi : public QObject
+{
+    Q_OBJECT
+
+public:
+    //! Takes a plain-data copy of the given mind map to edit.
+    explicit ScriptApi(const MindMapData & mindMapData, QObject * parent = nullptr);
+
+    ~ScriptApi() override;
+
+    //! \return The first failed call, e.g. with an invalid node index. Once failed, the other changes do nothing.
+    QString error() const;
+
+    bool isModified() const;
+
+    //! \return The edited copy of the mind map.
+    MindMapDataU takeMindMapData();
+
+    Q_INVOKABLE int nodeCount() const;
+
+    Q_INVOKABLE int edgeCount();
+
+    //! \return The indices of all nodes.
+    Q_INVOKABLE QVariantList nodes() const;
+
+    //! \return Object with index, x, y, width, height, text, color, textColor and collapsed, or undefined if there's no such node.
+    Q_INVOKABLE QVariant node(int index) const;
+
+    //! \return The indices of the nodes whose text contains the given text case-insensitively.
+    Q_INVOKABLE QVariantList findNodes(QString text) const;
+
+    //! \return Objects with source, target, text, arrowMode, dashed and reversed.
+    Q_INVOKABLE QVariantList edges();
+
+    //! \param properties Any of x, y, text, color, textColor and collapsed. Colors are given like "#ff0000" or "red".
+    //! \return The index of the new node, or -1 on failure.
+    Q_INVOKABLE int addNode(QVariantMap properties = {});
+
+    //! Adds a node for each object of the given array like addNode() does.
+    //! \return The indices of the new nodes.
+    Q_INVOKABLE QVariantList addNodes(QVariantList nodes);
+
+    //! Changes the given properties of the node, see addNode().
+    Q_INVOKABLE bool setNode(int index, QVariantMap properties);
+
+    //! Deletes the node together with its edges.
+    Q_INVOKABLE bool deleteNode(int index);
+
+    //! \param properties Any of text, arrowMode ("single", "double" or "hidden"), dashed and reversed.
+    Q_INVOKABLE bool addEdge(int source, int target, QVariantMap properties = {});
+
+    //! Adds an edge for each object of the given array. The objects have source and target in addition to the
+    //! properties of addEdge().
+    Q_INVOKABLE bool addEdges(QVariantList edges);
+
+    //! Changes the given properties of the edge, see addEdge().
+    Q_INVOKABLE bool setEdge(int source, int target, QVariantMap properties);
+
+    Q_INVOKABLE bool deleteEdge(int source, int target);
+
+    //! \param properties Any of backgroundColor, edgeColor, gridColor, arrowSize, edgeWidth, textSize and cornerRadius.
+    Q_INVOKABLE bool setStyle(QVariantMap properties);
+
+    //! Lays out each tree of the graph as a tidy tree around its current center, see TreeLayout.
+    //! \param radial Grows the branches around the roots on rings instead of to the sides.
+    Q_INVOKABLE void layoutTree(bool radial = false);
+
+private:
+    bool applyEdgeProperties(SceneItems::EdgeModel & model, const QVariantMap & properties);
+
+    bool applyNodeProperties(SceneItems::NodeModel & node, const QVariantMap & properties);
+
+    bool fail(QString message);
+
+    //! Drops the edges of the deleted nodes. Deleting a node doesn't search its edges, so that cleaning up many
+    //! nodes doesn't scan the edges again for each node.
+    void removeDanglingEdges();
+
+    bool toColor(const QVariant & value, QColor & color);
+
+    MindMapDataU m_mindMapData;
+
+    //! New nodes and edges get the colors and the arrow mode of the settings like in the editor.
+    SceneItems::NodeModel m_defaultNode;
+
+    SceneItems::EdgeModel::ArrowMode m_defaultArrowMode;
+
+    GraphSnapshot::NodeDataVector m_nodes;
+
+    //! Node index => position in m_nodes
+    std::unordered_map<int, size_t> m_nodeSlots;
+
+    GraphSnapshot::EdgeDataVector m_edges;
+
+    //! Edge key => position in m_edges
+    std::unordered_map<int64_t, size_t> m_edgeSlots;
+
+    bool m_hasDanglingEdges = false;
+
+    int m_nextNodeIndex = 0;
+
+    bool m_isModified = false;
+
+    QString m_error;
+};
+
+#endif // SCRIPT_API_HPP
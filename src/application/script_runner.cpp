@@ -0,0 +1,59 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "script_runner.hpp"
+
+#include "../domain/mind_map_data.hpp"
+#include "script_api.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QJSEngine>
+#include <QJSValue>
+
+namespace ScriptRunner {
+
+static const auto TAG = "ScriptRunner";
+
+Result run(const MindMapData & mindMapData, QString program, QString fileName)
+{
+    QJSEngine engine;
+    engine.installExtensions(QJSEngine::ConsoleExtension);
+
+    // Parented to the engine so that the engine doesn't take the ownership of the API
+    const auto api = new ScriptApi { mindMapData, &engine };
+    engine.globalObject().setProperty("map", engine.newQObject(api));
+
+    juzzlin::L(TAG).info() << "Running script '" << fileName.toStdString() << "'";
+
+    Result result;
+    if (const auto value = engine.evaluate(program, fileName); value.isError()) {
+        result.error = value.toString();
+        result.errorLine = value.property("lineNumber").toInt();
+    } else if (!api->error().isEmpty()) {
+        result.error = api->error();
+    }
+
+    if (!result.error.isEmpty()) {
+        juzzlin::L(TAG).error() << "Script failed on line " << result.errorLine << ": " << result.error.toStdString();
+        return result;
+    }
+
+    result.mindMapData = api->takeMindMapData();
+
+    return result;
+}
+
+} // namespace ScriptRunner
@@ -0,0 +1,46 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SCRIPT_RUNNER_HPP
+#define SCRIPT_RUNNER_HPP
+
+#include <QString>
+
+#include "../common/types.hpp"
+
+//! Runs JavaScript programs against a mind map. The program sees the mind map as the global object "map", see
+//! ScriptApi for the available calls, and console.log() writes to the log. All the changes of a program end up
+//! in a single new MindMapData, so applying them costs one undo point and one scene update however many items
+//! the program touches.
+namespace ScriptRunner {
+
+struct Result
+{
+    //! The changed mind map, or nullptr if the program failed or didn't change anything.
+    MindMapDataU mindMapData;
+
+    //! Empty on success.
+    QString error;
+
+    //! Line of the error in the program if known, otherwise 0.
+    int errorLine = 0;
+};
+
+//! \param fileName Shown in the error messages.
+Result run(const MindMapData & mindMapData, QString program, QString fileName = {});
+
+} // namespace ScriptRunner
+
+#endif // SCRIPT_RUNNER_HPP
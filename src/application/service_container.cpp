@@ -15,12 +15,18 @@
 
 #include "service_container.hpp"
 
+#include "../common/constants.hpp"
 #include "application_service.hpp"
+#include "cache_registry.hpp"
 #include "control_strategy.hpp"
+#include "gui_job_scheduler.hpp"
 #include "language_service.hpp"
 #include "progress_manager.hpp"
 #include "recent_files_manager.hpp"
 #include "settings_proxy.hpp"
+#include "task_pool.hpp"
+#include "thumbnail_cache.hpp"
+#include "workspace_index.hpp"
 
 #include "simple_logger.hpp"
 
@@ -32,10 +38,12 @@ ServiceContainer * ServiceContainer::m_instance = nullptr;
 
 ServiceContainer::ServiceContainer()
   : m_settingsProxy(std::make_unique<SettingsProxy>())
-  , m_controlStrategy(std::make_unique<ControlStrategy>())
+  , m_cacheRegistry(std::make_shared<CacheRegistry>())
+  , m_controlStrategy(std::make_unique<ControlStrategy>(m_settingsProxy))
   , m_languageService(std::make_unique<LanguageService>())
   , m_progressManager(std::make_unique<ProgressManager>())
   , m_recentFilesManager(std::make_unique<RecentFilesManager>())
+  , m_taskPool(std::make_shared<TaskPool>())
 {
     if (!ServiceContainer::m_instance) {
         ServiceContainer::m_instance = this;
@@ -64,6 +72,14 @@ ControlStrategyS ServiceContainer::controlStrategy()
     return m_controlStrategy;
 }
 
+GuiJobSchedulerS ServiceContainer::guiJobScheduler()
+{
+    if (!m_guiJobScheduler) {
+        m_guiJobScheduler = std::make_shared<GuiJobScheduler>(Constants::Application::guiJobSliceDuration());
+    }
+    return m_guiJobScheduler;
+}
+
 LanguageServiceS ServiceContainer::languageService()
 {
     return m_languageService;
@@ -79,11 +95,37 @@ RecentFilesManagerS ServiceContainer::recentFilesManager() const
     return m_recentFilesManager;
 }
 
+CacheRegistryS ServiceContainer::cacheRegistry() const
+{
+    return m_cacheRegistry;
+}
+
 SettingsProxyS ServiceContainer::settingsProxy()
 {
     return m_settingsProxy;
 }
 
+TaskPoolS ServiceContainer::taskPool() const
+{
+    return m_taskPool;
+}
+
+ThumbnailCacheS ServiceContainer::thumbnailCache()
+{
+    if (!m_thumbnailCache) {
+        m_thumbnailCache = std::make_shared<ThumbnailCache>();
+    }
+    return m_thumbnailCache;
+}
+
+WorkspaceIndexS ServiceContainer::workspaceIndex()
+{
+    if (!m_workspaceIndex) {
+        m_workspaceIndex = std::make_shared<WorkspaceIndex>();
+    }
+    return m_workspaceIndex;
+}
+
 ServiceContainer & SC::instance()
 {
     if (!ServiceContainer::m_instance) {
@@ -99,6 +141,9 @@ void ServiceContainer::setMainWindow(MainWindowS mainWindow)
 
 ServiceContainer::~ServiceContainer()
 {
+    // The background tasks may still use the other services
+    m_taskPool->waitForDone();
+
     m_applicationService.reset();
 
     ServiceContainer::m_instance = nullptr;
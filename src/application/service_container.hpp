@@ -19,13 +19,18 @@
 #include "../common/types.hpp"
 
 class ApplicationService;
+class CacheRegistry;
 class EditorService;
 class ControlStrategy;
+class GuiJobScheduler;
 class LanguageService;
 class RecentFilesManager;
 
 class ProgressManager;
 class SettingsProxy;
+class TaskPool;
+class ThumbnailCache;
+class WorkspaceIndex;
 
 //! A poor man's single instance DI.
 class ServiceContainer
@@ -39,8 +44,14 @@ public:
 
     ApplicationServiceS applicationService();
 
+    //! The caches that give memory back in the background and on memory pressure.
+    CacheRegistryS cacheRegistry() const;
+
     ControlStrategyS controlStrategy();
 
+    //! Time-sliced jobs of the GUI thread. Created on first use.
+    GuiJobSchedulerS guiJobScheduler();
+
     LanguageServiceS languageService();
 
     ProgressManagerS progressManager() const;
@@ -49,6 +60,15 @@ public:
 
     SettingsProxyS settingsProxy();
 
+    //! Shared worker threads for all the background work. Can be used from any thread.
+    TaskPoolS taskPool() const;
+
+    //! Created on first use so that e.g. unit tests don't touch the cache directory.
+    ThumbnailCacheS thumbnailCache();
+
+    //! Created on first use, i.e. when searching the workspace.
+    WorkspaceIndexS workspaceIndex();
+
     void setMainWindow(MainWindowS mainWindow);
 
 private:
@@ -60,14 +80,24 @@ private:
 
     ApplicationServiceS m_applicationService;
 
+    CacheRegistryS m_cacheRegistry;
+
     ControlStrategyS m_controlStrategy;
 
+    GuiJobSchedulerS m_guiJobScheduler;
+
     LanguageServiceS m_languageService;
 
     ProgressManagerS m_progressManager;
 
     RecentFilesManagerS m_recentFilesManager;
 
+    TaskPoolS m_taskPool;
+
+    ThumbnailCacheS m_thumbnailCache;
+
+    WorkspaceIndexS m_workspaceIndex;
+
     MainWindowS m_mainWindow;
 
     static ServiceContainer * m_instance;
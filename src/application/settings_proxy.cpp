@@ -15,6 +15,7 @@
 
 #include "settings_proxy.hpp"
 #include "../infra/settings.hpp"
+#include "settings_snapshot.hpp"
 
 SettingsProxy::SettingsProxy()
   : m_autoload { Settings::Custom::loadAutoload() }
@@ -31,8 +32,14 @@ SettingsProxy::SettingsProxy()
   , m_reversedEdgeDirection { Settings::Custom::loadReversedEdgeDirection(false) }
   , m_raiseNodeOnMouseHover { Settings::Generic::getBoolean(m_editingSettingGroup, m_raiseNodeOnMouseHoverKey, true) }
   , m_selectNodeGroupByIntersection { Settings::Custom::loadSelectNodeGroupByIntersection() }
+  , m_imageMemoryCapMiB { static_cast<int>(Settings::Generic::getNumber(m_editingSettingGroup, m_imageMemoryCapSettingKey, Constants::Settings::defaultImageMemoryCapMiB())) }
   , m_textSize { static_cast<int>(Settings::Generic::getNumber(m_defaultsSettingGroup, m_textSizeSettingKey, Constants::MindMap::defaultTextSize())) }
+  , m_undoJournal { Settings::Generic::getBoolean(m_editingSettingGroup, m_undoJournalSettingKey, false) }
+  , m_undoMemoryBudgetMiB { static_cast<int>(Settings::Generic::getNumber(m_editingSettingGroup, m_undoMemoryBudgetSettingKey, Constants::Settings::defaultUndoMemoryBudgetMiB())) }
   , m_font { Settings::Generic::getFont(m_defaultsSettingGroup, m_fontSettingKey, {}) }
+  , m_performanceProfileMode { static_cast<PerformanceProfile::Mode>(Settings::Generic::getNumber(m_performanceSettingGroup, m_performanceProfileModeSettingKey, static_cast<int>(PerformanceProfile::Mode::Automatic))) }
+  , m_balancedProfileItemCount { static_cast<size_t>(Settings::Generic::getNumber(m_performanceSettingGroup, m_balancedProfileItemCountSettingKey, static_cast<int>(Constants::Settings::defaultBalancedProfileItemCount()))) }
+  , m_speedProfileItemCount { static_cast<size_t>(Settings::Generic::getNumber(m_performanceSettingGroup, m_speedProfileItemCountSettingKey, static_cast<int>(Constants::Settings::defaultSpeedProfileItemCount()))) }
   , m_shadowEffectParams {
       static_cast<int>(Settings::Generic::getNumber(m_effectsSettingGroup, m_shadowEffectOffsetSettingKey, Constants::Settings::defaultShadowEffectOffset())),
       static_cast<int>(Settings::Generic::getNumber(m_effectsSettingGroup, m_shadowEffectNormalBlurRadiusSettingKey, Constants::Settings::defaultShadowEffectBlurRadius())),
@@ -40,9 +47,12 @@ SettingsProxy::SettingsProxy()
       Settings::Generic::getColor(m_effectsSettingGroup, m_shadowEffectShadowColorSettingKey, Constants::Settings::defaultShadowEffectShadowColor()),
       Settings::Generic::getColor(m_effectsSettingGroup, m_shadowEffectSelectedItemShadowColorSettingKey, Constants::Settings::defaultShadowEffectSelectedItemShadowColor())
   }
-  , m_optimizeShadowEffects { Settings::Generic::getBoolean(m_effectsSettingGroup, m_optimizeShadowEffectsSettingKey, true) }
+  , m_hardwareAcceleration { Settings::Generic::getBoolean(m_effectsSettingGroup, m_hardwareAccelerationSettingKey, false) }
+  , m_batchedRendering { Settings::Generic::getBoolean(m_effectsSettingGroup, m_batchedRenderingSettingKey, false) }
+  , m_edgeBundling { Settings::Generic::getBoolean(m_effectsSettingGroup, m_edgeBundlingSettingKey, false) }
   , m_userLanguage { Settings::Generic::getString(m_defaultsSettingGroup, m_userLanguageSettingKey, {}) }
 {
+    publishSnapshot();
 }
 
 bool SettingsProxy::autoload() const
@@ -68,6 +78,7 @@ void SettingsProxy::setAutosave(bool autosave)
     if (m_autosave != autosave) {
         m_autosave = autosave;
         Settings::Custom::saveAutosave(autosave);
+        publishSnapshot();
     }
 }
 
@@ -185,6 +196,7 @@ void SettingsProxy::setInvertedControls(bool invertedControls)
     if (m_invertedControls != invertedControls) {
         m_invertedControls = invertedControls;
         Settings::Generic::setBoolean(m_editingSettingGroup, m_invertedControlsSettingKey, invertedControls);
+        publishSnapshot();
     }
 }
 
@@ -250,6 +262,7 @@ void SettingsProxy::setRaiseNodeOnMouseHover(bool raiseNodeOnMouseHover)
     if (m_raiseNodeOnMouseHover != raiseNodeOnMouseHover) {
         m_raiseNodeOnMouseHover = raiseNodeOnMouseHover;
         Settings::Generic::setBoolean(m_editingSettingGroup, m_raiseNodeOnMouseHoverKey, raiseNodeOnMouseHover);
+        publishSnapshot();
     }
 }
 
@@ -263,6 +276,7 @@ void SettingsProxy::setSelectNodeGroupByIntersection(bool selectNodeGroupByInter
     if (m_selectNodeGroupByIntersection != selectNodeGroupByIntersection) {
         m_selectNodeGroupByIntersection = selectNodeGroupByIntersection;
         Settings::Custom::saveSelectNodeGroupByIntersection(selectNodeGroupByIntersection);
+        publishSnapshot();
     }
 }
 
@@ -280,20 +294,142 @@ void SettingsProxy::setShadowEffect(const ShadowEffectParams & params)
         Settings::Generic::setNumber(m_effectsSettingGroup, m_shadowEffectSelectedItemBlurRadiusSettingKey, params.selectedItemBlurRadius());
         Settings::Generic::setColor(m_effectsSettingGroup, m_shadowEffectShadowColorSettingKey, params.shadowColor());
         Settings::Generic::setColor(m_effectsSettingGroup, m_shadowEffectSelectedItemShadowColorSettingKey, params.selectedItemShadowColor());
+        publishSnapshot();
     }
 }
 
-bool SettingsProxy::optimizeShadowEffects() const
+bool SettingsProxy::hardwareAcceleration() const
 {
-    return m_optimizeShadowEffects;
+    return m_hardwareAcceleration;
 }
 
-void SettingsProxy::setOptimizeShadowEffects(bool optimizeShadowEffects)
+void SettingsProxy::setHardwareAcceleration(bool hardwareAcceleration)
 {
-    if (m_optimizeShadowEffects != optimizeShadowEffects) {
-        m_optimizeShadowEffects = optimizeShadowEffects;
-        Settings::Generic::setBoolean(m_effectsSettingGroup, m_optimizeShadowEffectsSettingKey, optimizeShadowEffects);
+    if (m_hardwareAcceleration != hardwareAcceleration) {
+        m_hardwareAcceleration = hardwareAcceleration;
+        Settings::Generic::setBoolean(m_effectsSettingGroup, m_hardwareAccelerationSettingKey, hardwareAcceleration);
     }
 }
 
+bool SettingsProxy::batchedRendering() const
+{
+    return m_batchedRendering;
+}
+
+void SettingsProxy::setBatchedRendering(bool batchedRendering)
+{
+    if (m_batchedRendering != batchedRendering) {
+        m_batchedRendering = batchedRendering;
+        Settings::Generic::setBoolean(m_effectsSettingGroup, m_batchedRenderingSettingKey, batchedRendering);
+    }
+}
+
+bool SettingsProxy::edgeBundling() const
+{
+    return m_edgeBundling;
+}
+
+void SettingsProxy::setEdgeBundling(bool edgeBundling)
+{
+    if (m_edgeBundling != edgeBundling) {
+        m_edgeBundling = edgeBundling;
+        Settings::Generic::setBoolean(m_effectsSettingGroup, m_edgeBundlingSettingKey, edgeBundling);
+    }
+}
+
+int SettingsProxy::imageMemoryCapMiB() const
+{
+    return m_imageMemoryCapMiB;
+}
+
+void SettingsProxy::setImageMemoryCapMiB(int imageMemoryCapMiB)
+{
+    if (m_imageMemoryCapMiB != imageMemoryCapMiB) {
+        m_imageMemoryCapMiB = imageMemoryCapMiB;
+        Settings::Generic::setNumber(m_editingSettingGroup, m_imageMemoryCapSettingKey, imageMemoryCapMiB);
+    }
+}
+
+bool SettingsProxy::undoJournal() const
+{
+    return m_undoJournal;
+}
+
+void SettingsProxy::setUndoJournal(bool undoJournal)
+{
+    if (m_undoJournal != undoJournal) {
+        m_undoJournal = undoJournal;
+        Settings::Generic::setBoolean(m_editingSettingGroup, m_undoJournalSettingKey, undoJournal);
+    }
+}
+
+int SettingsProxy::undoMemoryBudgetMiB() const
+{
+    return m_undoMemoryBudgetMiB;
+}
+
+void SettingsProxy::setUndoMemoryBudgetMiB(int undoMemoryBudgetMiB)
+{
+    if (m_undoMemoryBudgetMiB != undoMemoryBudgetMiB) {
+        m_undoMemoryBudgetMiB = undoMemoryBudgetMiB;
+        Settings::Generic::setNumber(m_editingSettingGroup, m_undoMemoryBudgetSettingKey, undoMemoryBudgetMiB);
+    }
+}
+
+PerformanceProfile::Mode SettingsProxy::performanceProfileMode() const
+{
+    return m_performanceProfileMode;
+}
+
+void SettingsProxy::setPerformanceProfileMode(PerformanceProfile::Mode mode)
+{
+    if (m_performanceProfileMode != mode) {
+        m_performanceProfileMode = mode;
+        Settings::Generic::setNumber(m_performanceSettingGroup, m_performanceProfileModeSettingKey, static_cast<int>(mode));
+    }
+}
+
+size_t SettingsProxy::balancedProfileItemCount() const
+{
+    return m_balancedProfileItemCount;
+}
+
+void SettingsProxy::setBalancedProfileItemCount(size_t itemCount)
+{
+    if (m_balancedProfileItemCount != itemCount) {
+        m_balancedProfileItemCount = itemCount;
+        Settings::Generic::setNumber(m_performanceSettingGroup, m_balancedProfileItemCountSettingKey, static_cast<int>(itemCount));
+    }
+}
+
+size_t SettingsProxy::speedProfileItemCount() const
+{
+    return m_speedProfileItemCount;
+}
+
+void SettingsProxy::setSpeedProfileItemCount(size_t itemCount)
+{
+    if (m_speedProfileItemCount != itemCount) {
+        m_speedProfileItemCount = itemCount;
+        Settings::Generic::setNumber(m_performanceSettingGroup, m_speedProfileItemCountSettingKey, static_cast<int>(itemCount));
+    }
+}
+
+const SettingsSnapshotS & SettingsProxy::snapshot() const
+{
+    return m_snapshot;
+}
+
+void SettingsProxy::publishSnapshot()
+{
+    auto snapshot = std::make_shared<SettingsSnapshot>();
+    snapshot->version = m_snapshot ? m_snapshot->version + 1 : 0;
+    snapshot->autosave = m_autosave;
+    snapshot->invertedControls = m_invertedControls;
+    snapshot->raiseNodeOnMouseHover = m_raiseNodeOnMouseHover;
+    snapshot->selectNodeGroupByIntersection = m_selectNodeGroupByIntersection;
+    snapshot->shadowEffect = m_shadowEffectParams;
+    m_snapshot = snapshot;
+}
+
 SettingsProxy::~SettingsProxy() = default;
@@ -16,7 +16,9 @@
 #ifndef SETTINGS_PROXY_HPP
 #define SETTINGS_PROXY_HPP
 
+#include "../common/types.hpp"
 #include "../view/scene_items/edge_model.hpp"
+#include "performance_profile.hpp"
 #include "../view/shadow_effect_params.hpp"
 
 #include <QFont>
@@ -28,7 +30,8 @@
 //! The current policy for new settings is to use the Settings::Generic API and hide it behind SettingsProxy to
 //! expose a clean API without visible setting keys or low-level functions.
 //!
-//! SettingsProxy can be accessed via ServiceContainer throughout the application.
+//! SettingsProxy can be accessed via ServiceContainer throughout the application. Hot paths should read
+//! snapshot() instead of the individual getters.
 class SettingsProxy
 {
 public:
@@ -96,23 +99,68 @@ public:
 
     void setShadowEffect(const ShadowEffectParams & params);
 
-    bool optimizeShadowEffects() const;
+    //! \returns true if the editor view should render via OpenGL.
+    bool hardwareAcceleration() const;
 
-    void setOptimizeShadowEffects(bool optimizeShadowEffects);
+    void setHardwareAcceleration(bool hardwareAcceleration);
+
+    //! \returns true if very large mind maps should be drawn in batches when zoomed far out, see BatchedGraphRenderer.
+    bool batchedRendering() const;
+
+    void setBatchedRendering(bool batchedRendering);
+
+    //! \returns true if the edges of nodes with many outgoing edges should be drawn as bundles, see EdgeBundler.
+    bool edgeBundling() const;
+
+    void setEdgeBundling(bool edgeBundling);
 
     int textSize() const;
 
     void setTextSize(int textSize);
 
+    //! \returns Memory cap of the encoded and decoded images in MiB or 0 for "unlimited".
+    int imageMemoryCapMiB() const;
+
+    void setImageMemoryCapMiB(int imageMemoryCapMiB);
+
+    //! \returns true if the undo history is kept in a journal next to the mind map between sessions.
+    bool undoJournal() const;
+
+    void setUndoJournal(bool undoJournal);
+
+    //! \returns Memory budget of the undo history in MiB or 0 for "unlimited".
+    int undoMemoryBudgetMiB() const;
+
+    void setUndoMemoryBudgetMiB(int undoMemoryBudgetMiB);
+
     QFont font() const;
 
     void setFont(const QFont & font);
 
+    PerformanceProfile::Mode performanceProfileMode() const;
+
+    void setPerformanceProfileMode(PerformanceProfile::Mode mode);
+
+    //! \returns Number of nodes and edges from which the automatic performance profile uses the balanced tier.
+    size_t balancedProfileItemCount() const;
+
+    void setBalancedProfileItemCount(size_t itemCount);
+
+    //! \returns Number of nodes and edges from which the automatic performance profile uses the speed tier.
+    size_t speedProfileItemCount() const;
+
+    void setSpeedProfileItemCount(size_t itemCount);
+
     QString userLanguage() const;
 
     void setUserLanguage(const QString & language);
 
+    //! \returns The current snapshot of the frequently read settings. Replaced, not modified, on change.
+    const SettingsSnapshotS & snapshot() const;
+
 private:
+    void publishSnapshot();
+
     SettingsProxy(const SettingsProxy & other) = delete;
 
     SettingsProxy & operator=(const SettingsProxy & other) = delete;
@@ -151,7 +199,11 @@ private:
 
     const QString m_userLanguageSettingKey = "userLanguage";
 
-    const QString m_optimizeShadowEffectsSettingKey = "optimizeShadowEffects";
+    const QString m_hardwareAccelerationSettingKey = "hardwareAcceleration";
+
+    const QString m_batchedRenderingSettingKey = "batchedRendering";
+
+    const QString m_edgeBundlingSettingKey = "edgeBundling";
 
     const QString m_editingSettingGroup = "Editing";
 
@@ -159,6 +211,20 @@ private:
 
     const QString m_raiseNodeOnMouseHoverKey = "raiseNodeOnMouseHoverKey";
 
+    const QString m_undoJournalSettingKey = "undoJournal";
+
+    const QString m_undoMemoryBudgetSettingKey = "undoMemoryBudgetMiB";
+
+    const QString m_imageMemoryCapSettingKey = "imageMemoryCapMiB";
+
+    const QString m_performanceSettingGroup = "Performance";
+
+    const QString m_performanceProfileModeSettingKey = "profileMode";
+
+    const QString m_balancedProfileItemCountSettingKey = "balancedProfileItemCount";
+
+    const QString m_speedProfileItemCountSettingKey = "speedProfileItemCount";
+
     bool m_autoload = false;
 
     bool m_autosave = false;
@@ -187,15 +253,33 @@ private:
 
     bool m_selectNodeGroupByIntersection = false;
 
+    int m_imageMemoryCapMiB;
+
     int m_textSize;
 
+    bool m_undoJournal = false;
+
+    int m_undoMemoryBudgetMiB;
+
     QFont m_font;
 
+    PerformanceProfile::Mode m_performanceProfileMode;
+
+    size_t m_balancedProfileItemCount;
+
+    size_t m_speedProfileItemCount;
+
     ShadowEffectParams m_shadowEffectParams;
 
-    bool m_optimizeShadowEffects = true;
+    bool m_hardwareAcceleration = false;
+
+    bool m_batchedRendering = false;
+
+    bool m_edgeBundling = false;
 
     QString m_userLanguage;
+
+    SettingsSnapshotS m_snapshot;
 };
 
 #endif // SETTINGS_PROXY_HPP
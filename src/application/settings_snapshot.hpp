@@ -0,0 +1,41 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SETTINGS_SNAPSHOT_HPP
+#define SETTINGS_SNAPSHOT_HPP
+
+#include "../view/shadow_effect_params.hpp"
+
+#include <cstdint>
+
+//! Immutable copy of the settings that are read on hot paths, e.g. per mouse event or per item.
+//! SettingsProxy publishes a new snapshot with an incremented version whenever one of these settings
+//! changes, so consumers can read plain fields and detect changes by comparing versions.
+struct SettingsSnapshot
+{
+    uint64_t version = 0;
+
+    bool autosave = false;
+
+    bool invertedControls = false;
+
+    bool raiseNodeOnMouseHover = true;
+
+    bool selectNodeGroupByIntersection = false;
+
+    ShadowEffectParams shadowEffect;
+};
+
+#endif // SETTINGS_SNAPSHOT_HPP
@@ -49,6 +49,10 @@ void StateMachine::calculateState(StateMachine::Action action)
         m_state = State::ShowNodeColorDialog;
         break;
 
+    case Action::PdfExportSelected:
+        m_state = State::ShowPdfExportDialog;
+        break;
+
     case Action::PngExportSelected:
         m_state = State::ShowPngExportDialog;
         break;
@@ -66,6 +70,28 @@ void StateMachine::calculateState(StateMachine::Action action)
         }
         break;
 
+    case Action::NewTabSelected:
+        m_state = State::InitializeNewTab;
+        break;
+
+    case Action::OpenInNewTabSelected:
+        m_state = State::ShowOpenInNewTabDialog;
+        break;
+
+    case Action::CloseTabSelected:
+        if (SC::instance().applicationService()->tabCount() < 2) {
+            // The last tab gets a new mind map like on New
+            m_quitType = QuitType::New;
+        } else {
+            m_quitType = QuitType::CloseTab;
+        }
+        if (SC::instance().applicationService()->isModified()) {
+            m_state = State::ShowNotSavedDialog;
+        } else {
+            m_state = m_quitType == QuitType::New ? State::InitializeNewMindMap : State::CloseTab;
+        }
+        break;
+
     case Action::MainWindowInitialized:
         m_state = State::InitializeNewMindMap;
         break;
@@ -75,7 +101,11 @@ void StateMachine::calculateState(StateMachine::Action action)
     case Action::MindMapSavedAs:
         switch (m_quitType) {
         case QuitType::Close:
-            m_state = State::Exit;
+            // The rest of the tabs are checked for unsaved changes once this one is closed
+            m_state = SC::instance().applicationService()->tabCount() > 1 ? State::CloseTab : State::Exit;
+            break;
+        case QuitType::CloseTab:
+            m_state = State::CloseTab;
             break;
         case QuitType::New:
             m_state = State::InitializeNewMindMap;
@@ -83,12 +113,18 @@ void StateMachine::calculateState(StateMachine::Action action)
         case QuitType::Open:
             m_state = State::ShowOpenDialog;
             break;
+        case QuitType::OpenUrl:
+            m_state = State::ShowOpenUrlDialog;
+            break;
         case QuitType::OpenRecent:
             m_state = State::OpenRecent;
             break;
         case QuitType::OpenDrop:
             m_state = State::OpenDrop;
             break;
+        case QuitType::OpenWorkspaceSearchHit:
+            m_state = State::OpenWorkspaceSearchHit;
+            break;
         default:
             m_state = State::Edit;
             break;
@@ -100,6 +136,7 @@ void StateMachine::calculateState(StateMachine::Action action)
     case Action::GridColorChanged:
     case Action::ImageLoadFailed:
     case Action::LayoutOptimized:
+    case Action::MindMapCompared:
     case Action::MindMapOpened:
     case Action::MindMapSaveFailed:
     case Action::MindMapSaveAsCanceled:
@@ -109,9 +146,12 @@ void StateMachine::calculateState(StateMachine::Action action)
     case Action::NotSavedDialogCanceled:
     case Action::OpeningMindMapCanceled:
     case Action::OpeningMindMapFailed:
+    case Action::PdfExported:
     case Action::PngExported:
+    case Action::ScriptRun:
     case Action::SvgExported:
     case Action::TextColorChanged:
+    case Action::WorkspaceSearchClosed:
         m_quitType = QuitType::None;
         m_state = State::Edit;
         break;
@@ -125,9 +165,26 @@ void StateMachine::calculateState(StateMachine::Action action)
         }
         break;
 
+    case Action::OpenUrlSelected:
+        m_quitType = QuitType::OpenUrl;
+        if (SC::instance().applicationService()->isModified()) {
+            m_state = State::ShowNotSavedDialog;
+        } else {
+            m_state = State::ShowOpenUrlDialog;
+        }
+        break;
+
+    case Action::TabClosed:
+        if (m_quitType != QuitType::Close) {
+            m_quitType = QuitType::None;
+            m_state = State::Edit;
+            break;
+        }
+        [[fallthrough]];
+
     case Action::QuitSelected:
         m_quitType = QuitType::Close;
-        if (SC::instance().applicationService()->isModified()) {
+        if (SC::instance().applicationService()->isModified() || SC::instance().applicationService()->activateModifiedTab()) {
             m_state = State::ShowNotSavedDialog;
         } else {
             m_state = State::Exit;
@@ -147,6 +204,14 @@ void StateMachine::calculateState(StateMachine::Action action)
         m_state = State::ShowSaveAsDialog;
         break;
 
+    case Action::CompareSelected:
+        m_state = State::ShowCompareDialog;
+        break;
+
+    case Action::RunScriptSelected:
+        m_state = State::ShowRunScriptDialog;
+        break;
+
     case Action::SvgExportSelected:
         m_state = State::ShowSvgExportDialog;
         break;
@@ -169,6 +234,19 @@ void StateMachine::calculateState(StateMachine::Action action)
         }
         break;
 
+    case Action::WorkspaceSearchHitSelected:
+        m_quitType = QuitType::OpenWorkspaceSearchHit;
+        if (SC::instance().applicationService()->isModified()) {
+            m_state = State::ShowNotSavedDialog;
+        } else {
+            m_state = State::OpenWorkspaceSearchHit;
+        }
+        break;
+
+    case Action::WorkspaceSearchSelected:
+        m_state = State::ShowWorkspaceSearchDialog;
+        break;
+
     case Action::LayoutOptimizationRequested:
         m_state = State::ShowLayoutOptimizationDialog;
         break;
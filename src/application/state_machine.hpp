@@ -32,14 +32,18 @@ public:
 
     enum class State
     {
+        CloseTab,
         Edit,
         Exit,
         Init,
         InitializeNewMindMap,
+        InitializeNewTab,
         OpenDrop,
         OpenRecent,
+        OpenWorkspaceSearchHit,
         Save,
         ShowBackgroundColorDialog,
+        ShowCompareDialog,
         ShowEdgeColorDialog,
         ShowGridColorDialog,
         ShowImageFileDialog,
@@ -47,10 +51,15 @@ public:
         ShowNodeColorDialog,
         ShowNotSavedDialog,
         ShowOpenDialog,
+        ShowOpenInNewTabDialog,
+        ShowOpenUrlDialog,
+        ShowPdfExportDialog,
         ShowPngExportDialog,
+        ShowRunScriptDialog,
         ShowSaveAsDialog,
         ShowSvgExportDialog,
         ShowTextColorDialog,
+        ShowWorkspaceSearchDialog,
         TryCloseWindow
     };
 
@@ -58,6 +67,8 @@ public:
     {
         BackgroundColorChangeRequested,
         BackgroundColorChanged,
+        CloseTabSelected,
+        CompareSelected,
         DropFileSelected,
         EdgeColorChangeRequested,
         EdgeColorChanged,
@@ -68,6 +79,7 @@ public:
         LayoutOptimizationRequested,
         LayoutOptimized,
         MainWindowInitialized,
+        MindMapCompared,
         MindMapOpened,
         MindMapSaveAsCanceled,
         MindMapSaveAsFailed,
@@ -76,26 +88,37 @@ public:
         MindMapSavedAs,
         NewMindMapInitialized,
         NewSelected,
+        NewTabSelected,
         NodeColorChangeRequested,
         NodeColorChanged,
         NotSavedDialogAccepted,
         NotSavedDialogCanceled,
         NotSavedDialogDiscarded,
+        OpenInNewTabSelected,
         OpenSelected,
+        OpenUrlSelected,
         OpeningMindMapCanceled,
         OpeningMindMapFailed,
+        PdfExportSelected,
+        PdfExported,
         PngExportSelected,
         PngExported,
         QuitSelected,
         RecentFileSelected,
         RedoSelected,
+        RunScriptSelected,
         SaveAsSelected,
         SaveSelected,
+        ScriptRun,
         SvgExportSelected,
         SvgExported,
+        TabClosed,
         TextColorChangeRequested,
         TextColorChanged,
-        UndoSelected
+        UndoSelected,
+        WorkspaceSearchClosed,
+        WorkspaceSearchHitSelected,
+        WorkspaceSearchSelected
     };
 
     enum class QuitType
@@ -103,9 +126,12 @@ public:
         None,
         New,
         Open,
+        OpenUrl,
         OpenRecent,
         OpenDrop,
-        Close
+        OpenWorkspaceSearchHit,
+        Close,
+        CloseTab
     };
 
     StateMachine();
@@ -0,0 +1,126 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "task_chain.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QTimer>
+
+#include <exception>
+#include <stdexcept>
+
+static const auto TAG = "TaskChain";
+
+TaskChain::TaskChain(TaskPool & taskPool)
+  : m_taskPool(taskPool)
+{
+}
+
+std::shared_ptr<TaskChain> TaskChain::create(TaskPool & taskPool)
+{
+    // The constructor is private, so std::make_shared can't be used
+    return std::shared_ptr<TaskChain>(new TaskChain(taskPool));
+}
+
+TaskChain & TaskChain::inBackground(Step step, TaskPool::Priority priority)
+{
+    m_steps.push_back({ std::move(step), true, priority });
+    return *this;
+}
+
+TaskChain & TaskChain::onGuiThread(Step step)
+{
+    m_steps.push_back({ std::move(step), false, TaskPool::Priority::Normal });
+    return *this;
+}
+
+void TaskChain::start(Completion completion)
+{
+    m_completion = std::move(completion);
+    scheduleNextStep();
+}
+
+void TaskChain::cancel()
+{
+    m_isCancelled = true;
+}
+
+bool TaskChain::isCancelled() const
+{
+    return m_isCancelled;
+}
+
+void TaskChain::finish(Result result)
+{
+    if (result == Result::Failed) {
+        juzzlin::L(TAG).error() << "Step " << m_nextStep << "/" << m_steps.size() << " failed: " << m_error.toStdString();
+    }
+
+    m_steps.clear();
+    if (const auto completion = std::move(m_completion); completion) {
+        completion(result, m_error);
+    }
+}
+
+void TaskChain::runStep(const Step & step)
+{
+    try {
+        step();
+    } catch (const std::exception & e) {
+        m_isFailed = true;
+        m_error = e.what();
+    } catch (...) {
+        m_isFailed = true;
+        m_error = "Unknown error";
+    }
+}
+
+void TaskChain::scheduleNextStep()
+{
+    // Called on the GUI thread only, also for the continuations of the background steps
+    if (m_isFailed) {
+        finish(Result::Failed);
+        return;
+    }
+
+    if (m_isCancelled) {
+        finish(Result::Cancelled);
+        return;
+    }
+
+    if (m_nextStep >= m_steps.size()) {
+        finish(Result::Finished);
+        return;
+    }
+
+    const auto self = shared_from_this();
+    auto && entry = m_steps.at(m_nextStep++);
+    if (entry.isBackground) {
+        // The continuation doesn't get cancelled, so that the completion is always called after the running step
+        m_taskPool.start(
+          [self, step = entry.step](auto &&) {
+              self->runStep(step);
+          },
+          entry.priority, [self] {
+              self->scheduleNextStep();
+          });
+    } else {
+        QTimer::singleShot(0, [self, step = entry.step] {
+            self->runStep(step);
+            self->scheduleNextStep();
+        });
+    }
+}
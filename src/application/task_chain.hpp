@@ -0,0 +1,104 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TASK_CHAIN_HPP
+#define TASK_CHAIN_HPP
+
+#include <QString>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "task_pool.hpp"
+
+//! A sequence of steps that alternate between the shared task pool and the GUI thread without blocking the
+//! event loop, e.g. open a file, then build the scene, then zoom to fit. This is the C++17 counterpart of
+//! awaiting coroutine tasks: a step is the code between two suspension points.
+//!
+//! Each step starts when the previous one has finished, and the GUI thread gets back to the event loop in
+//! between, so there's no need to re-enter it via QApplication::processEvents(). The steps share their state
+//! via captures. The chain keeps itself alive until it has ended.
+class TaskChain : public std::enable_shared_from_this<TaskChain>
+{
+public:
+    enum class Result
+    {
+        Finished,
+        Cancelled,
+        Failed
+    };
+
+    using Step = std::function<void()>;
+
+    //! Called on the GUI thread when the chain has ended.
+    //! \param error The message of the exception that ended the chain if the result is Failed.
+    using Completion = std::function<void(Result result, QString error)>;
+
+    static std::shared_ptr<TaskChain> create(TaskPool & taskPool);
+
+    //! Adds a step that runs on the given task pool.
+    TaskChain & inBackground(Step step, TaskPool::Priority priority = TaskPool::Priority::Normal);
+
+    //! Adds a step that runs on the GUI thread on a later event loop iteration.
+    TaskChain & onGuiThread(Step step);
+
+    //! Starts the chain from the GUI thread and returns immediately. An exception thrown by a step, or a
+    //! cancellation, skips the remaining steps.
+    void start(Completion completion = {});
+
+    //! Requests the chain to stop. The running step is finished, but no further steps are started.
+    //! Can be called from any thread, e.g. by a step.
+    void cancel();
+
+    //! Can be called by long background steps to stop early.
+    bool isCancelled() const;
+
+private:
+    explicit TaskChain(TaskPool & taskPool);
+
+    void finish(Result result);
+
+    //! Runs the given step and records an exception thrown by it.
+    void runStep(const Step & step);
+
+    void scheduleNextStep();
+
+    struct Entry
+    {
+        Step step;
+
+        bool isBackground = false;
+
+        TaskPool::Priority priority = TaskPool::Priority::Normal;
+    };
+
+    TaskPool & m_taskPool;
+
+    std::vector<Entry> m_steps;
+
+    size_t m_nextStep = 0;
+
+    Completion m_completion;
+
+    std::atomic<bool> m_isCancelled { false };
+
+    bool m_isFailed = false;
+
+    QString m_error;
+};
+
+#endif // TASK_CHAIN_HPP
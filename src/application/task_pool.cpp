@@ -0,0 +1,283 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "task_pool.hpp"
+
+#include <QRunnable>
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+
+struct TaskPool::Handle::State
+{
+    std::atomic<bool> isCancelled { false };
+
+    mutable std::mutex mutex;
+
+    mutable std::condition_variable finishedCondition;
+
+    bool isFinished = false;
+};
+
+namespace {
+
+class FunctionTask : public QRunnable
+{
+public:
+    explicit FunctionTask(std::function<void()> function)
+      : m_function(std::move(function))
+    {
+    }
+
+    void run() override
+    {
+        m_function();
+    }
+
+private:
+    std::function<void()> m_function;
+};
+
+//! Common state of the chunks started by one TaskPool::run() call.
+class ChunkGroup
+{
+public:
+    explicit ChunkGroup(size_t count)
+      : m_remaining(count)
+    {
+    }
+
+    //! Runs the given chunk and keeps the first exception so that it can be rethrown on the calling thread.
+    void runChunk(const std::function<void(size_t)> & function, size_t index)
+    {
+        try {
+            function(index);
+        } catch (...) {
+            const std::lock_guard<std::mutex> lock { m_mutex };
+            if (!m_exception) {
+                m_exception = std::current_exception();
+            }
+        }
+
+        const std::lock_guard<std::mutex> lock { m_mutex };
+        if (!--m_remaining) {
+            m_finishedCondition.notify_all();
+        }
+    }
+
+    void waitAndRethrow()
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+        m_finishedCondition.wait(lock, [this] {
+            return !m_remaining;
+        });
+        if (m_exception) {
+            std::rethrow_exception(m_exception);
+        }
+    }
+
+private:
+    std::mutex m_mutex;
+
+    std::condition_variable m_finishedCondition;
+
+    size_t m_remaining;
+
+    std::exception_ptr m_exception;
+};
+
+class ChunkTask : public QRunnable
+{
+public:
+    ChunkTask(ChunkGroup & group, const std::function<void(size_t)> & function, size_t index)
+      : m_group(group)
+      , m_function(function)
+      , m_index(index)
+    {
+        // Owned by TaskPool::run(), which may also take the chunk back from the queue
+        setAutoDelete(false);
+    }
+
+    void run() override
+    {
+        m_group.runChunk(m_function, m_index);
+    }
+
+private:
+    ChunkGroup & m_group;
+
+    const std::function<void(size_t)> & m_function;
+
+    size_t m_index;
+};
+
+} // namespace
+
+void TaskPool::Handle::cancel()
+{
+    if (m_state) {
+        m_state->isCancelled = true;
+    }
+}
+
+bool TaskPool::Handle::isCancelled() const
+{
+    return m_state && m_state->isCancelled;
+}
+
+bool TaskPool::Handle::isFinished() const
+{
+    if (!m_state) {
+        return false;
+    }
+
+    const std::lock_guard<std::mutex> lock { m_state->mutex };
+    return m_state->isFinished;
+}
+
+void TaskPool::Handle::wait() const
+{
+    if (!m_state) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock { m_state->mutex };
+    m_state->finishedCondition.wait(lock, [this] {
+        return m_state->isFinished;
+    });
+}
+
+TaskPool::TaskPool()
+{
+    m_threadPool.setMaxThreadCount(std::max(1, QThread::idealThreadCount()));
+}
+
+TaskPool::~TaskPool()
+{
+    m_threadPool.waitForDone();
+}
+
+TaskPool::Handle TaskPool::start(Task task, Priority priority, Continuation continuation)
+{
+    Handle handle;
+    handle.m_state = std::make_shared<Handle::State>();
+
+    m_threadPool.start(new FunctionTask([this, handle, task = std::move(task), continuation = std::move(continuation)] {
+                           if (!handle.isCancelled()) {
+                               task(handle);
+                           }
+
+                           {
+                               const std::lock_guard<std::mutex> lock { handle.m_state->mutex };
+                               handle.m_state->isFinished = true;
+                           }
+                           handle.m_state->finishedCondition.notify_all();
+
+                           if (continuation && !handle.isCancelled()) {
+                               queueContinuation(handle, continuation);
+                           }
+                       }),
+                       static_cast<int>(priority));
+
+    return handle;
+}
+
+void TaskPool::run(size_t count, const std::function<void(size_t)> & function)
+{
+    if (count <= 1) {
+        if (count) {
+            function(0);
+        }
+        return;
+    }
+
+    ChunkGroup group { count };
+    std::vector<std::unique_ptr<ChunkTask>> chunks;
+    chunks.reserve(count - 1);
+    for (size_t i = 1; i < count; i++) {
+        chunks.push_back(std::make_unique<ChunkTask>(group, function, i));
+        // The caller is blocked until the chunks are done, so they go before the other queued tasks
+        m_threadPool.start(chunks.back().get(), static_cast<int>(Priority::High) + 1);
+    }
+
+    group.runChunk(function, 0);
+
+    // Steal back the chunks that are still queued, e.g. because the workers are busy or this is a worker itself
+    for (auto && chunk : chunks) {
+        if (m_threadPool.tryTake(chunk.get())) {
+            chunk->run();
+        }
+    }
+
+    group.waitAndRethrow();
+}
+
+void TaskPool::parallelFor(size_t count, size_t minItemsPerChunk, const std::function<void(size_t begin, size_t end)> & function)
+{
+    if (!count) {
+        return;
+    }
+
+    const auto chunks = chunkCount(count, minItemsPerChunk);
+    const auto chunkSize = (count + chunks - 1) / chunks;
+    run(chunks, [&](size_t chunk) {
+        if (const auto begin = chunk * chunkSize; begin < count) {
+            function(begin, std::min(begin + chunkSize, count));
+        }
+    });
+}
+
+size_t TaskPool::chunkCount(size_t itemCount, size_t minItemsPerChunk) const
+{
+    return std::clamp<size_t>(itemCount / std::max<size_t>(1, minItemsPerChunk), 1, threadCount());
+}
+
+size_t TaskPool::threadCount() const
+{
+    return static_cast<size_t>(std::max(1, m_threadPool.maxThreadCount()));
+}
+
+void TaskPool::waitForDone()
+{
+    m_threadPool.waitForDone();
+}
+
+void TaskPool::queueContinuation(Handle handle, Continuation continuation)
+{
+    {
+        const std::lock_guard<std::mutex> lock { m_continuationMutex };
+        m_continuations.emplace_back(handle, continuation);
+    }
+    QMetaObject::invokeMethod(this, "runContinuations", Qt::QueuedConnection);
+}
+
+void TaskPool::runContinuations()
+{
+    std::vector<std::pair<Handle, Continuation>> continuations;
+    {
+        const std::lock_guard<std::mutex> lock { m_continuationMutex };
+        continuations.swap(m_continuations);
+    }
+
+    for (auto && continuation : continuations) {
+        // The task may have been cancelled after it finished, e.g. when the receiver got destroyed
+        if (!continuation.first.isCancelled()) {
+            continuation.second();
+        }
+    }
+}
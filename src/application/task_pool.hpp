@@ -0,0 +1,113 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TASK_POOL_HPP
+#define TASK_POOL_HPP
+
+#include <QObject>
+#include <QThreadPool>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+//! Worker threads shared by all the background work, e.g. layout optimization, image decoding and serialization,
+//! so that they don't each start threads of their own and oversubscribe the cores.
+//!
+//! Queued tasks are started in the order of their priority. A thread that waits in run() for its chunks takes back
+//! the chunks that no worker has started yet and runs them itself, so nested parallel work, e.g. serialization
+//! started from a background save, doesn't deadlock even if all the workers are busy.
+class TaskPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    //! Queued tasks of a higher priority are started first.
+    enum class Priority
+    {
+        Low,
+        Normal,
+        High
+    };
+
+    //! Shared by a started task and its starter.
+    class Handle
+    {
+    public:
+        //! Requests the task to stop. A task that hasn't started yet is skipped and the continuation
+        //! of a cancelled task is not called. A running task needs to check isCancelled() by itself.
+        void cancel();
+
+        bool isCancelled() const;
+
+        bool isFinished() const;
+
+        //! Waits until the task has finished or has been skipped. Does nothing for a default constructed handle.
+        void wait() const;
+
+    private:
+        friend class TaskPool;
+
+        struct State;
+
+        std::shared_ptr<State> m_state;
+    };
+
+    //! Called on a worker thread with the handle of the task.
+    using Task = std::function<void(const Handle & handle)>;
+
+    //! Called on the GUI thread after the task has finished.
+    using Continuation = std::function<void()>;
+
+    TaskPool();
+
+    //! Waits for the running and the queued tasks.
+    ~TaskPool() override;
+
+    //! Queues the given task. The continuation, if any, is called later on the thread of the pool, i.e. the
+    //! GUI thread, unless the task has been cancelled by then.
+    Handle start(Task task, Priority priority = Priority::Normal, Continuation continuation = {});
+
+    //! Calls the given function with 0 ... count - 1 in parallel, the first one on the calling thread, and waits until all have returned.
+    void run(size_t count, const std::function<void(size_t)> & function);
+
+    //! Splits [0, count) into at most chunkCount() ranges and calls the given function for them in parallel, see run().
+    void parallelFor(size_t count, size_t minItemsPerChunk, const std::function<void(size_t begin, size_t end)> & function);
+
+    //! \return The number of chunks so that each has at least the given number of items, but there are no more chunks than threads.
+    size_t chunkCount(size_t itemCount, size_t minItemsPerChunk) const;
+
+    size_t threadCount() const;
+
+    //! Waits for the running and the queued tasks. The continuations are still delivered via the event loop.
+    void waitForDone();
+
+private slots:
+
+    void runContinuations();
+
+private:
+    void queueContinuation(Handle handle, Continuation continuation);
+
+    QThreadPool m_threadPool;
+
+    std::mutex m_continuationMutex;
+
+    std::vector<std::pair<Handle, Continuation>> m_continuations;
+};
+
+#endif // TASK_POOL_HPP
@@ -0,0 +1,117 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "teardown_scheduler.hpp"
+
+#include "service_container.hpp"
+
+#include "../domain/graph.hpp"
+#include "../domain/graph_snapshot.hpp"
+#include "../domain/mind_map_data.hpp"
+#include "../view/scene_items/edge.hpp"
+#include "../view/scene_items/node.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+
+static const auto TAG = "TeardownScheduler";
+
+TeardownScheduler::TeardownScheduler(std::chrono::milliseconds sliceDuration)
+  : m_sliceDuration(sliceDuration)
+{
+    // A zero interval timer fires whenever the event loop has nothing else to do
+    m_sliceTimer.setInterval(0);
+    connect(&m_sliceTimer, &QTimer::timeout, this, &TeardownScheduler::deleteSlice);
+}
+
+TeardownScheduler::~TeardownScheduler()
+{
+    flush();
+}
+
+void TeardownScheduler::retire(MindMapDataS mindMapData)
+{
+    if (!mindMapData || mindMapData.use_count() > 1) {
+        return;
+    }
+
+    auto graphAndSnapshot = mindMapData->releaseGraph();
+    auto items = graphAndSnapshot.first->releaseItems();
+    juzzlin::L(TAG).debug() << "Retiring " << items.nodes.size() << " nodes and " << items.edges.size() << " edges";
+
+    for (auto && edge : items.edges) {
+        edge->removeFromScene();
+        m_edges.push_back(std::move(edge));
+    }
+    for (auto && node : items.nodes) {
+        node->removeFromScene();
+        m_nodes.push_back(std::move(node));
+    }
+
+    m_destroyTasks.erase(std::remove_if(m_destroyTasks.begin(), m_destroyTasks.end(), [](auto && task) {
+                             return task.isFinished();
+                         }),
+                         m_destroyTasks.end());
+    // Shared as the task function must be copyable. Moved all the way so that only the task keeps the data alive.
+    m_destroyTasks.push_back(SC::instance().taskPool()->start([plainData = std::make_shared<decltype(graphAndSnapshot)>(std::move(graphAndSnapshot))](auto &&) {
+        plainData->first.reset();
+        plainData->second.reset();
+    },
+                                                              TaskPool::Priority::Low));
+
+    if (!m_edges.empty() || !m_nodes.empty()) {
+        m_sliceTimer.start();
+    }
+}
+
+void TeardownScheduler::flush()
+{
+    m_sliceTimer.stop();
+    m_edges.clear();
+    m_nodes.clear();
+    for (auto && task : m_destroyTasks) {
+        task.wait();
+    }
+    m_destroyTasks.clear();
+}
+
+size_t TeardownScheduler::pendingItemCount() const
+{
+    return m_edges.size() + m_nodes.size();
+}
+
+void TeardownScheduler::deleteSlice()
+{
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    // Check the clock only every few items as a single item is cheap to delete
+    const size_t itemsPerCheck = 32;
+    while (elapsed.elapsed() < m_sliceDuration.count()) {
+        for (size_t i = 0; i < itemsPerCheck && !m_edges.empty(); i++) {
+            m_edges.pop_front();
+        }
+        for (size_t i = 0; i < itemsPerCheck && m_edges.empty() && !m_nodes.empty(); i++) {
+            m_nodes.pop_front();
+        }
+        if (m_edges.empty() && m_nodes.empty()) {
+            m_sliceTimer.stop();
+            return;
+        }
+    }
+}
@@ -0,0 +1,71 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TEARDOWN_SCHEDULER_HPP
+#define TEARDOWN_SCHEDULER_HPP
+
+#include <QObject>
+#include <QTimer>
+
+#include <chrono>
+#include <deque>
+#include <vector>
+
+#include "../common/types.hpp"
+#include "task_pool.hpp"
+
+//! Destroys replaced mind maps without blocking the GUI on big maps. The scene items are detached from the
+//! scene right away, but as they are QObjects and QGraphicsItems, they are deleted on the GUI thread in
+//! time-sliced chunks whenever the event loop is idle. What remains of the graph is plain data, which is
+//! destroyed on the shared task pool.
+class TeardownScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    //! \param sliceDuration Time budget for deleting items per event loop iteration.
+    explicit TeardownScheduler(std::chrono::milliseconds sliceDuration);
+
+    //! Deletes the remaining items synchronously.
+    ~TeardownScheduler() override;
+
+    //! Takes over the given mind map. Does nothing but drops the reference if the mind map is still used elsewhere.
+    void retire(MindMapDataS mindMapData);
+
+    //! Deletes the remaining items synchronously and waits until the plain data has been destroyed.
+    void flush();
+
+    //! \return Number of items waiting for deletion.
+    size_t pendingItemCount() const;
+
+private slots:
+
+    void deleteSlice();
+
+private:
+    std::chrono::milliseconds m_sliceDuration;
+
+    QTimer m_sliceTimer;
+
+    //! Destruction of the plain data on the shared task pool.
+    std::vector<TaskPool::Handle> m_destroyTasks;
+
+    // The edges refer to their nodes when deleted, so all the edges go before any node
+    std::deque<EdgeS> m_edges;
+
+    std::deque<NodeS> m_nodes;
+};
+
+#endif // TEARDOWN_SCHEDULER_HPP
@@ -0,0 +1,213 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "thumbnail_cache.hpp"
+
+#include "../common/constants.hpp"
+#include "../domain/graph_snapshot.hpp"
+#include "../domain/mind_map_data.hpp"
+#include "../view/thumbnail_renderer.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QSettings>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+static const auto TAG = "ThumbnailCache";
+
+namespace {
+
+const auto indexFileName = "index.ini";
+
+const auto keysGroup = "keys";
+
+QString thumbnailPath(QString cacheDir, QString key, int size)
+{
+    return QDir { cacheDir }.filePath(QString { "%1-%2.png" }.arg(key).arg(size));
+}
+
+class ThumbnailTask : public QRunnable
+{
+public:
+    ThumbnailTask(QObject & cache, QString cacheDir, QString filePath, GraphSnapshot graph, ThumbnailRenderer::Style style)
+      : m_cache(cache)
+      , m_cacheDir(cacheDir)
+      , m_filePath(filePath)
+      , m_graph(std::move(graph))
+      , m_style(style)
+    {
+    }
+
+    void run() override
+    {
+        const auto key = contentKey();
+        for (auto && size : Constants::View::thumbnailSizes()) {
+            if (const auto path = thumbnailPath(m_cacheDir, key, size); !QFile::exists(path) && !ThumbnailRenderer::render(m_graph, m_style, size).save(path, "PNG")) {
+                juzzlin::L(TAG).warning() << "Couldn't write " << path.toStdString();
+                return;
+            }
+        }
+        QMetaObject::invokeMethod(&m_cache, "handleThumbnailGenerated", Qt::QueuedConnection, Q_ARG(QString, m_filePath), Q_ARG(QString, key));
+    }
+
+private:
+    //! \return Hash of everything that affects the thumbnails.
+    QString contentKey() const
+    {
+        QByteArray style;
+        QDataStream stream { &style, QIODevice::WriteOnly };
+        stream << m_style.backgroundColor << m_style.edgeColor << m_style.cornerRadius;
+        QCryptographicHash hash { QCryptographicHash::Sha1 };
+        hash.addData(m_graph.toCompressedData());
+        hash.addData(style);
+        return QString::fromLatin1(hash.result().toHex());
+    }
+
+    QObject & m_cache;
+
+    QString m_cacheDir;
+
+    QString m_filePath;
+
+    GraphSnapshot m_graph;
+
+    ThumbnailRenderer::Style m_style;
+};
+
+} // namespace
+
+ThumbnailCache::ThumbnailCache()
+  : ThumbnailCache(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QDir::separator() + "thumbnails")
+{
+}
+
+ThumbnailCache::ThumbnailCache(QString cacheDir)
+  : m_cacheDir(cacheDir)
+{
+    // A single thread is enough for the small images and keeps the writes in order
+    m_threadPool.setMaxThreadCount(1);
+
+    if (!QDir().mkpath(m_cacheDir)) {
+        juzzlin::L(TAG).warning() << "Couldn't create " << m_cacheDir.toStdString();
+    }
+
+    loadIndex();
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    m_threadPool.waitForDone();
+}
+
+void ThumbnailCache::generate(QString filePath, const MindMapData & mindMapData)
+{
+    filePath = QFileInfo { filePath }.absoluteFilePath();
+    const ThumbnailRenderer::Style style { mindMapData.backgroundColor(), mindMapData.edgeColor(), mindMapData.cornerRadius() };
+    m_threadPool.start(new ThumbnailTask(*this, m_cacheDir, filePath, mindMapData.graphSnapshot(), style));
+}
+
+void ThumbnailCache::handleThumbnailGenerated(QString filePath, QString key)
+{
+    const auto oldKey = m_keys.value(filePath);
+    m_keys[filePath] = key;
+    if (!oldKey.isEmpty() && oldKey != key) {
+        removeUnusedImages(oldKey);
+    }
+    saveIndex();
+
+    juzzlin::L(TAG).debug() << "Thumbnails generated for " << filePath.toStdString();
+    emit thumbnailGenerated(filePath);
+}
+
+QString ThumbnailCache::imagePath(QString key, int size) const
+{
+    return thumbnailPath(m_cacheDir, key, size);
+}
+
+void ThumbnailCache::loadIndex()
+{
+    QSettings index { QDir { m_cacheDir }.filePath(indexFileName), QSettings::IniFormat };
+    const int size = index.beginReadArray(keysGroup);
+    for (int i = 0; i < size; i++) {
+        index.setArrayIndex(i);
+        m_keys[index.value("filePath").toString()] = index.value("key").toString();
+    }
+    index.endArray();
+}
+
+void ThumbnailCache::removeUnusedImages(QString key)
+{
+    // Identical mind maps share the images
+    if (std::find(m_keys.cbegin(), m_keys.cend(), key) == m_keys.cend()) {
+        for (auto && size : Constants::View::thumbnailSizes()) {
+            QFile::remove(imagePath(key, size));
+        }
+    }
+}
+
+void ThumbnailCache::retain(const QStringList & filePaths)
+{
+    bool changed = false;
+    for (auto && filePath : m_keys.keys()) {
+        if (!filePaths.contains(filePath)) {
+            const auto key = m_keys.take(filePath);
+            removeUnusedImages(key);
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        saveIndex();
+    }
+}
+
+void ThumbnailCache::saveIndex() const
+{
+    QSettings index { QDir { m_cacheDir }.filePath(indexFileName), QSettings::IniFormat };
+    index.remove(keysGroup);
+    index.beginWriteArray(keysGroup);
+    int i = 0;
+    for (auto && filePath : m_keys.keys()) {
+        index.setArrayIndex(i++);
+        index.setValue("filePath", filePath);
+        index.setValue("key", m_keys.value(filePath));
+    }
+    index.endArray();
+}
+
+QImage ThumbnailCache::thumbnail(QString filePath, int size) const
+{
+    const auto key = m_keys.value(QFileInfo { filePath }.absoluteFilePath());
+    if (key.isEmpty()) {
+        return {};
+    }
+
+    const auto sizes = Constants::View::thumbnailSizes();
+    const auto match = std::lower_bound(sizes.cbegin(), sizes.cend(), size);
+    return QImage { imagePath(key, match != sizes.cend() ? *match : sizes.back()) };
+}
+
+void ThumbnailCache::waitForDone()
+{
+    m_threadPool.waitForDone();
+}
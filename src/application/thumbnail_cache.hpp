@@ -0,0 +1,79 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef THUMBNAIL_CACHE_HPP
+#define THUMBNAIL_CACHE_HPP
+
+#include <QImage>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+
+class MindMapData;
+
+//! Stores small previews of the recent files, so that they can be shown without opening the files.
+//! The previews are rendered in a few sizes from plain copies of the graphs on a background thread
+//! when the files are saved. The images are named by a hash of the content, so unchanged mind maps
+//! aren't rendered again and identical ones share the images.
+class ThumbnailCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    ThumbnailCache();
+
+    //! \param cacheDir Directory for the images and the index, e.g. a temporary directory in tests.
+    explicit ThumbnailCache(QString cacheDir);
+
+    ~ThumbnailCache() override;
+
+    //! Renders the thumbnails of the given mind map saved to the given file in the background.
+    void generate(QString filePath, const MindMapData & mindMapData);
+
+    //! \return The smallest cached thumbnail of the file whose longest side is at least the given size,
+    //! or the largest one if all are smaller. A null image if there's none.
+    QImage thumbnail(QString filePath, int size) const;
+
+    //! Removes the thumbnails of the files that are not in the given list.
+    void retain(const QStringList & filePaths);
+
+    //! Blocks until the pending thumbnails have been written.
+    void waitForDone();
+
+signals:
+    void thumbnailGenerated(QString filePath);
+
+private slots:
+    void handleThumbnailGenerated(QString filePath, QString key);
+
+private:
+    QString imagePath(QString key, int size) const;
+
+    void loadIndex();
+
+    void removeUnusedImages(QString key);
+
+    void saveIndex() const;
+
+    QString m_cacheDir;
+
+    //! File path => content key of the thumbnails
+    QMap<QString, QString> m_keys;
+
+    QThreadPool m_threadPool;
+};
+
+#endif // THUMBNAIL_CACHE_HPP
@@ -0,0 +1,306 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "workspace_index.hpp"
+
+#include "../infra/io/alz_stream_reader.hpp"
+#include "service_container.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+
+#include <stdexcept>
+
+static const auto TAG = "WorkspaceIndex";
+
+namespace {
+
+const auto indexFileName = "index.dat";
+
+const quint32 indexFormatVersion = 1;
+
+TextSearchIndex::Key textKey(int fileId, int textNumber)
+{
+    return (static_cast<TextSearchIndex::Key>(fileId) << 32) | static_cast<TextSearchIndex::Key>(textNumber);
+}
+
+} // namespace
+
+WorkspaceIndex::WorkspaceIndex()
+  : WorkspaceIndex(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QDir::separator() + "workspace_index")
+{
+}
+
+WorkspaceIndex::WorkspaceIndex(QString indexDir)
+  : m_indexDir(indexDir)
+  , m_data(std::make_shared<Data>())
+{
+    if (!QDir().mkpath(m_indexDir)) {
+        juzzlin::L(TAG).warning() << "Couldn't create " << m_indexDir.toStdString();
+    }
+
+    loadIndex();
+}
+
+WorkspaceIndex::~WorkspaceIndex()
+{
+    // The continuation of a cancelled update is not called anymore
+    m_update.cancel();
+    m_update.wait();
+}
+
+QString WorkspaceIndex::directory() const
+{
+    return m_data->directory;
+}
+
+size_t WorkspaceIndex::fileCount() const
+{
+    return m_data->files.size();
+}
+
+bool WorkspaceIndex::isUpdating() const
+{
+    return m_isUpdating;
+}
+
+QString WorkspaceIndex::indexFilePath() const
+{
+    return QDir { m_indexDir }.filePath(indexFileName);
+}
+
+void WorkspaceIndex::loadIndex()
+{
+    QFile file { indexFilePath() };
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream stream { &file };
+    quint32 formatVersion = 0;
+    stream >> formatVersion;
+    if (formatVersion != indexFormatVersion) {
+        juzzlin::L(TAG).info() << "Ignoring an index of format version " << formatVersion;
+        return;
+    }
+
+    const auto data = std::make_shared<Data>();
+    quint64 fileCount = 0;
+    stream >> data->directory >> data->nextId >> fileCount;
+    for (quint64 i = 0; i < fileCount && stream.status() == QDataStream::Ok; i++) {
+        QString filePath;
+        FileEntry entry;
+        stream >> filePath >> entry.id >> entry.lastModified >> entry.size >> entry.hash >> entry.texts;
+        data->filePaths[entry.id] = filePath;
+        data->files.emplace(filePath, entry);
+    }
+
+    // The files just get indexed again on the next update if the index is broken
+    if (stream.status() != QDataStream::Ok || !data->texts.read(stream)) {
+        juzzlin::L(TAG).warning() << "Corrupted index " << file.fileName().toStdString();
+        return;
+    }
+
+    juzzlin::L(TAG).debug() << "Loaded the index of " << data->files.size() << " files in " << data->directory.toStdString();
+    m_data = data;
+}
+
+void WorkspaceIndex::saveIndex(const Data & data, QString indexFilePath)
+{
+    // A crash while writing leaves the previous index intact
+    QSaveFile file { indexFilePath };
+    if (!file.open(QIODevice::WriteOnly)) {
+        juzzlin::L(TAG).warning() << "Couldn't write " << indexFilePath.toStdString();
+        return;
+    }
+
+    QDataStream stream { &file };
+    stream << indexFormatVersion << data.directory << data.nextId << static_cast<quint64>(data.files.size());
+    for (auto && [filePath, entry] : data.files) {
+        stream << filePath << entry.id << entry.lastModified << entry.size << entry.hash << entry.texts;
+    }
+    data.texts.write(stream);
+
+    if (!file.commit()) {
+        juzzlin::L(TAG).warning() << "Couldn't write " << indexFilePath.toStdString();
+    }
+}
+
+void WorkspaceIndex::removeFileTexts(Data & data, const FileEntry & entry)
+{
+    for (int i = 0; i < entry.texts.size(); i++) {
+        data.texts.remove(textKey(entry.id, i));
+    }
+}
+
+void WorkspaceIndex::setFileTexts(Data & data, const FileEntry & entry, const QStringList & texts)
+{
+    // Texts that didn't change keep their grams
+    for (int i = 0; i < texts.size(); i++) {
+        data.texts.setText(textKey(entry.id, i), texts.at(i));
+    }
+
+    for (int i = texts.size(); i < entry.texts.size(); i++) {
+        data.texts.remove(textKey(entry.id, i));
+    }
+}
+
+std::shared_ptr<WorkspaceIndex::Data> WorkspaceIndex::scan(const Data & previous, QString directory, const TaskPool::Handle & handle)
+{
+    auto data = previous.directory == directory ? std::make_shared<Data>(previous) : std::make_shared<Data>();
+    data->directory = directory;
+
+    size_t parsedCount = 0;
+    QSet<QString> existingFilePaths;
+    QDirIterator iter { directory, { "*.alz" }, QDir::Files, QDirIterator::Subdirectories };
+    while (iter.hasNext()) {
+        if (handle.isCancelled()) {
+            return {};
+        }
+
+        const QFileInfo fileInfo { iter.next() };
+        const auto filePath = fileInfo.absoluteFilePath();
+        existingFilePaths.insert(filePath);
+
+        const auto lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+        auto entryIter = data->files.find(filePath);
+        if (entryIter != data->files.end() && entryIter->second.lastModified == lastModified && entryIter->second.size == fileInfo.size()) {
+            continue;
+        }
+
+        QFile file { filePath };
+        if (!file.open(QIODevice::ReadOnly)) {
+            juzzlin::L(TAG).warning() << "Couldn't open " << filePath.toStdString();
+            continue;
+        }
+
+        QCryptographicHash hash { QCryptographicHash::Sha1 };
+        hash.addData(&file);
+
+        if (entryIter == data->files.end()) {
+            FileEntry entry;
+            entry.id = data->nextId++;
+            data->filePaths[entry.id] = filePath;
+            entryIter = data->files.emplace(filePath, entry).first;
+        }
+
+        auto && entry = entryIter->second;
+        entry.lastModified = lastModified;
+        entry.size = fileInfo.size();
+        if (entry.hash == hash.result()) {
+            continue;
+        }
+
+        // A map that can't be read is kept without texts, so that it isn't read again until it changes
+        QStringList texts;
+        try {
+            // The header tells about empty maps, e.g. new or template files, without parsing them
+            if (const auto header = IO::AlzStreamReader::readHeader(filePath); !header || header->nodeCount || header->edgeCount) {
+                texts = IO::AlzStreamReader::readTexts(filePath);
+            }
+        } catch (const std::exception & e) {
+            juzzlin::L(TAG).warning() << "Couldn't index " << filePath.toStdString() << ": " << e.what();
+        }
+
+        setFileTexts(*data, entry, texts);
+        entry.texts = texts;
+        entry.hash = hash.result();
+        parsedCount++;
+    }
+
+    for (auto entryIter = data->files.begin(); entryIter != data->files.end();) {
+        if (!existingFilePaths.contains(entryIter->first)) {
+            removeFileTexts(*data, entryIter->second);
+            data->filePaths.erase(entryIter->second.id);
+            entryIter = data->files.erase(entryIter);
+        } else {
+            entryIter++;
+        }
+    }
+
+    juzzlin::L(TAG).debug() << "Indexed " << parsedCount << " changed files of " << data->files.size() << " in " << directory.toStdString();
+
+    return data;
+}
+
+std::vector<WorkspaceIndex::Hit> WorkspaceIndex::search(QString text, size_t maxHits) const
+{
+    std::vector<Hit> hits;
+    if (text.isEmpty()) {
+        return hits;
+    }
+
+    QSet<int> hitFileIds;
+    for (auto && key : m_data->texts.search(text)) {
+        if (hits.size() >= maxHits) {
+            break;
+        }
+
+        // The keys are ranked, so the first text of a file is its best match
+        const auto fileId = static_cast<int>(key >> 32);
+        if (hitFileIds.contains(fileId)) {
+            continue;
+        }
+        hitFileIds.insert(fileId);
+
+        const auto & filePath = m_data->filePaths.at(fileId);
+        hits.push_back({ filePath, m_data->files.at(filePath).texts.at(static_cast<int>(key & 0xffffffff)) });
+    }
+
+    return hits;
+}
+
+void WorkspaceIndex::update(QString directory)
+{
+    directory = QFileInfo { directory }.absoluteFilePath();
+
+    // The previous update is waited for, so that the updates don't write the index file at the same time
+    auto previousUpdate = m_update;
+    previousUpdate.cancel();
+
+    m_isUpdating = true;
+    const auto result = std::make_shared<DataS>();
+    m_update = SC::instance().taskPool()->start(
+      [previousUpdate, previous = m_data, directory, indexFilePath = indexFilePath(), result](const TaskPool::Handle & handle) {
+          previousUpdate.wait();
+          if (auto data = scan(*previous, directory, handle); data && !handle.isCancelled()) {
+              saveIndex(*data, indexFilePath);
+              *result = std::move(data);
+          }
+      },
+      TaskPool::Priority::Low,
+      [this, result] {
+          if (*result) {
+              m_data = *result;
+          }
+          m_isUpdating = false;
+          emit updateFinished();
+      });
+}
+
+void WorkspaceIndex::waitForDone()
+{
+    m_update.wait();
+}
@@ -0,0 +1,129 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef WORKSPACE_INDEX_HPP
+#define WORKSPACE_INDEX_HPP
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "../domain/text_search_index.hpp"
+#include "task_pool.hpp"
+
+//! Inverted index of the node and edge texts of all the mind maps in a directory, so that the maps mentioning
+//! something can be found without opening them. The files are read with the streaming reader on a background
+//! thread and only the ones whose modification time or size changed are read again. The index is stored on disk
+//! with the n-gram postings, so searching right after a restart doesn't need to build it again.
+class WorkspaceIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    WorkspaceIndex();
+
+    //! \param indexDir Directory for the index file, e.g. a temporary directory in tests.
+    explicit WorkspaceIndex(QString indexDir);
+
+    ~WorkspaceIndex() override;
+
+    struct Hit
+    {
+        QString filePath;
+
+        //! The best matching text of the mind map, e.g. to be shown next to the file and searched for once opened.
+        QString text;
+    };
+
+    //! \returns The mind maps that contain the given text, the best match first, with at most one hit per file.
+    std::vector<Hit> search(QString text, size_t maxHits) const;
+
+    //! \returns The directory of the current index, which is empty until a directory has been indexed.
+    QString directory() const;
+
+    size_t fileCount() const;
+
+    bool isUpdating() const;
+
+    //! Brings the index up to date with the ALZ-files in the given directory and its subdirectories in the background.
+    //! Indexing another directory replaces the index. An update that is still running is cancelled.
+    void update(QString directory);
+
+    //! Blocks until a pending update has finished.
+    void waitForDone();
+
+signals:
+    void updateFinished();
+
+private:
+    struct FileEntry
+    {
+        int id = 0;
+
+        qint64 lastModified = 0;
+
+        qint64 size = 0;
+
+        //! Identical content found again, e.g. after a touch or a copy, doesn't need to be parsed again.
+        QByteArray hash;
+
+        QStringList texts;
+    };
+
+    struct Data
+    {
+        QString directory;
+
+        std::map<QString, FileEntry> files;
+
+        std::unordered_map<int, QString> filePaths;
+
+        //! Keyed by the file id in the upper and the text number in the lower 32 bits.
+        TextSearchIndex texts;
+
+        int nextId = 0;
+    };
+
+    using DataS = std::shared_ptr<const Data>;
+
+    static std::shared_ptr<Data> scan(const Data & previous, QString directory, const TaskPool::Handle & handle);
+
+    static void setFileTexts(Data & data, const FileEntry & entry, const QStringList & texts);
+
+    static void removeFileTexts(Data & data, const FileEntry & entry);
+
+    void loadIndex();
+
+    static void saveIndex(const Data & data, QString indexFilePath);
+
+    QString indexFilePath() const;
+
+    QString m_indexDir;
+
+    //! Only replaced on the GUI thread, and never modified once published, so that an update can read it.
+    DataS m_data;
+
+    TaskPool::Handle m_update;
+
+    bool m_isUpdating = false;
+};
+
+#endif // WORKSPACE_INDEX_HPP
@@ -0,0 +1,256 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "../../application/service_container.hpp"
+#include "../../common/test_mode.hpp"
+#include "../../domain/graph.hpp"
+#include "../../domain/mind_map_data.hpp"
+#include "../../domain/undo_stack.hpp"
+#include "../../infra/io/alz_file_io.hpp"
+#include "../../view/editor_scene.hpp"
+#include "../../view/scene_items/edge.hpp"
+#include "../../view/scene_items/node.hpp"
+#include "../synthetic_map.hpp"
+
+#include "argengine.hpp"
+#include "simple_logger.hpp"
+
+#include <QApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+using juzzlin::Argengine;
+using juzzlin::L;
+
+namespace {
+
+struct Options
+{
+    uint32_t seed = 1;
+
+    size_t maxNodeCount = 100000;
+
+    size_t repeatCount = 3;
+
+    std::string jsonFile;
+};
+
+struct MapShape
+{
+    std::string name;
+
+    SyntheticMap::Parameters parameters;
+};
+
+//! \returns The best of the runs in seconds, as the best run is the least disturbed by the rest of the system.
+double measure(size_t repeatCount, const std::function<void()> & run)
+{
+    double best = 0;
+    for (size_t i = 0; i < repeatCount; i++) {
+        const auto start = std::chrono::steady_clock::now();
+        run();
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = i ? std::min(best, seconds) : seconds;
+    }
+    return best;
+}
+
+//! Same as what ApplicationService::addExistingGraphToScene() does on open, without the view.
+void populateScene(EditorScene & scene, MindMapDataCR data)
+{
+    scene.beginBulkInsert();
+    for (auto && node : data.graph().nodes()) {
+        scene.addItem(node.get());
+        scene.includeInNodeBounds(*node);
+    }
+    scene.endBulkInsert();
+
+    scene.beginBulkInsert();
+    for (auto && edge : data.graph().edges()) {
+        scene.addItem(edge.get());
+        edge->sourceNode().addGraphicsEdge(*edge);
+        edge->targetNode().addGraphicsEdge(*edge);
+        edge->updateLine();
+    }
+    scene.endBulkInsert();
+}
+
+QJsonObject runBenchmarks(const MapShape & shape, const Options & options, const QTemporaryDir & tempDir)
+{
+    auto parameters = shape.parameters;
+    parameters.seed = options.seed;
+    const auto data = SyntheticMap::build(parameters);
+    const auto path = tempDir.filePath(QString::fromStdString(shape.name) + ".alz");
+
+    QJsonObject timings;
+
+    timings["toFile"] = measure(options.repeatCount, [&] {
+        IO::AlzFileIO {}.toFile(data, path, false);
+    });
+
+    timings["fileSize"] = static_cast<double>(QFile { path }.size());
+
+    timings["fromFile"] = measure(options.repeatCount, [&] {
+        IO::AlzFileIO {}.fromFile(path);
+    });
+
+    timings["copy"] = measure(options.repeatCount, [&] {
+        MindMapData copy { *data };
+        copy.graph();
+    });
+
+    // Every push after the first one is a delta against the previous point
+    const size_t undoPointCount = 20;
+    timings["pushUndoPoint"] = measure(options.repeatCount, [&] {
+        UndoStack undoStack;
+        for (size_t i = 0; i < undoPointCount; i++) {
+            auto && node = data->graph().nodes().at(i % data->graph().nodeCount());
+            node->setLocation(node->location() + QPointF { 1, 1 });
+            undoStack.pushUndoPoint(*data);
+        }
+    }) / undoPointCount;
+
+    timings["sceneBulkInsert"] = measure(options.repeatCount, [&] {
+        const auto copy = std::make_shared<MindMapData>(*data);
+        EditorScene scene;
+        populateScene(scene, *copy);
+    });
+
+    size_t matchCount = 0;
+    timings["search"] = measure(options.repeatCount, [&] {
+        matchCount = 0;
+        for (auto && word : SyntheticMap::words()) {
+            matchCount += data->graph().searchNodesByText(word).size();
+        }
+    }) / static_cast<double>(SyntheticMap::words().size());
+
+    QJsonObject result;
+    result["name"] = QString::fromStdString(shape.name);
+    result["nodes"] = static_cast<double>(data->graph().nodeCount());
+    result["edges"] = static_cast<double>(data->graph().edgeCount());
+    result["images"] = static_cast<double>(parameters.imageCount);
+    result["searchMatches"] = static_cast<double>(matchCount);
+    result["seconds"] = timings;
+
+    std::printf("%-24s %8zu %8zu %10.4f %10.4f %10.4f %10.4f %10.4f %10.6f\n", shape.name.c_str(),
+                data->graph().nodeCount(), data->graph().edgeCount(), timings["toFile"].toDouble(), timings["fromFile"].toDouble(),
+                timings["copy"].toDouble(), timings["pushUndoPoint"].toDouble(), timings["sceneBulkInsert"].toDouble(), timings["search"].toDouble());
+    std::fflush(stdout);
+
+    return result;
+}
+
+void parseArgs(int argc, char ** argv, Options & options)
+{
+    Argengine ae(argc, argv);
+
+    ae.addOption(
+      { "--seed" }, [&options](std::string value) {
+          options.seed = static_cast<uint32_t>(std::stoul(value));
+      },
+      false, "Seed of the synthetic maps. Default: 1.");
+
+    ae.addOption(
+      { "--max-nodes" }, [&options](std::string value) {
+          options.maxNodeCount = std::stoul(value);
+      },
+      false, "Largest synthetic map to run, 1k-100k nodes. Default: 100000.");
+
+    ae.addOption(
+      { "--repeat" }, [&options](std::string value) {
+          options.repeatCount = std::max<size_t>(1, std::stoul(value));
+      },
+      false, "Number of runs per measurement, the best one is reported. Default: 3.");
+
+    ae.addOption(
+      { "--json" }, [&options](std::string value) {
+          options.jsonFile = value;
+      },
+      false, "Write the results to the given JSON file.", "FILE");
+
+    ae.setHelpText(std::string("\nUsage: ") + argv[0] + " [OPTIONS]\n\nTimes file IO, undo, copying, scene population and search on synthetic maps.");
+
+    ae.parse();
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    // Nodes are graphics items and need a GUI application for fonts
+    QApplication application(argc, argv);
+
+    TestMode::setEnabled(true);
+    L::setLoggingLevel(L::Level::Warning);
+
+    Options options;
+    parseArgs(argc, argv, options);
+
+    const ServiceContainer serviceContainer;
+
+    const QTemporaryDir tempDir;
+    if (!tempDir.isValid()) {
+        L().error() << "Cannot create a temporary directory";
+        return EXIT_FAILURE;
+    }
+
+    std::printf("%-24s %8s %8s %10s %10s %10s %10s %10s %10s\n", "Map", "Nodes", "Edges", "Save [s]", "Load [s]", "Copy [s]", "Undo [s]", "Scene [s]", "Search [s]");
+
+    QJsonArray results;
+    for (size_t nodeCount = 1000; nodeCount <= options.maxNodeCount; nodeCount *= 10) {
+        const auto size = std::to_string(nodeCount);
+        SyntheticMap::Parameters tree;
+        tree.nodeCount = nodeCount;
+        auto dense = tree;
+        dense.extraEdgesPerNode = 2;
+        auto images = tree;
+        images.imageCount = 100;
+        for (auto && shape : { MapShape { "tree-" + size, tree }, MapShape { "dense-" + size, dense }, MapShape { "images-" + size, images } }) {
+            try {
+                results.append(runBenchmarks(shape, options, tempDir));
+            } catch (const std::exception & e) {
+                L().error() << "Cannot run " << shape.name << ": " << e.what();
+            }
+        }
+    }
+
+    if (!options.jsonFile.empty()) {
+        QFile file { QString::fromStdString(options.jsonFile) };
+        if (!file.open(QIODevice::WriteOnly)) {
+            L().error() << "Cannot write " << options.jsonFile;
+            return EXIT_FAILURE;
+        }
+        QJsonObject root;
+        root["seed"] = static_cast<double>(options.seed);
+        root["repeat"] = static_cast<double>(options.repeatCount);
+        root["results"] = results;
+        file.write(QJsonDocument { root }.toJson());
+    }
+
+    return EXIT_SUCCESS;
+}
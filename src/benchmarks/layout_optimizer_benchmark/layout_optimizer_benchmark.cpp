@@ -0,0 +1,277 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "../../application/service_container.hpp"
+#include "../../common/constants.hpp"
+#include "../../common/test_mode.hpp"
+#include "../../domain/graph.hpp"
+#include "../../domain/layout_optimizer.hpp"
+#include "../../domain/mind_map_data.hpp"
+#include "../../infra/io/alz_file_io.hpp"
+#include "../../view/grid.hpp"
+#include "../../view/scene_items/edge.hpp"
+#include "../../view/scene_items/node.hpp"
+
+#include "argengine.hpp"
+#include "simple_logger.hpp"
+
+#include <QApplication>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using juzzlin::Argengine;
+using juzzlin::L;
+
+namespace {
+
+struct Options
+{
+    uint32_t seed = 1;
+
+    size_t maxNodeCount = 100000;
+
+    size_t replicaCount = 1;
+
+    LayoutOptimizer::Engine engine = LayoutOptimizer::Engine::Annealing;
+
+    std::chrono::milliseconds timeBudget { 0 };
+
+    LayoutOptimizer::Schedule schedule = LayoutOptimizer::Schedule::Geometric;
+
+    LayoutOptimizer::InitialPlacement initialPlacement = LayoutOptimizer::InitialPlacement::Current;
+
+    double crossingPenalty = 0;
+
+    //! CSV file of the convergence traces of all runs, empty for none.
+    std::string traceFile;
+
+    Argengine::ArgumentVector files;
+};
+
+//! Random tree with the nodes scattered over an area that roughly fits them.
+MindMapDataS buildRandomTree(size_t nodeCount, uint32_t seed)
+{
+    auto data = std::make_shared<MindMapData>();
+    std::mt19937 engine { seed };
+    const auto extent = std::sqrt(static_cast<double>(nodeCount)) * Constants::Node::minWidth();
+    std::uniform_real_distribution<double> locationDist { -extent / 2, extent / 2 };
+    std::vector<NodeS> nodes;
+    for (size_t i = 0; i < nodeCount; i++) {
+        auto node = std::make_shared<SceneItems::Node>();
+        data->graph().addNode(node);
+        node->setPos({ locationDist(engine), locationDist(engine) });
+        if (!nodes.empty()) {
+            std::uniform_int_distribution<size_t> parentDist { 0, nodes.size() - 1 };
+            data->graph().addEdge(std::make_shared<SceneItems::Edge>(nodes.at(parentDist(engine)), node));
+        }
+        nodes.push_back(node);
+    }
+    return data;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void writeTrace(const std::string & name, const LayoutOptimizer::OptimizationInfo & optimizationInfo, const Options & options)
+{
+    const auto file = std::fopen(options.traceFile.c_str(), "a");
+    if (!file) {
+        L().error() << "Cannot write the trace to " << options.traceFile;
+        return;
+    }
+
+    for (auto && sample : optimizationInfo.trace) {
+        std::fprintf(file, "%s,%.6f,%.6g,%.6g,%.6f,%.0f,%.6f\n", name.c_str(), sample.time, sample.temperature, sample.cost,
+                     sample.acceptRatio, sample.movesPerSecond, sample.sliceDuration);
+    }
+
+    std::fclose(file);
+}
+
+void runBenchmark(const std::string & name, MindMapDataS data, const Options & options)
+{
+    Grid grid;
+    LayoutOptimizer layoutOptimizer { data, grid };
+    layoutOptimizer.setSeed(options.seed);
+    layoutOptimizer.setReplicaCount(options.replicaCount);
+    layoutOptimizer.setEngine(options.engine);
+    layoutOptimizer.setTimeBudget(options.timeBudget);
+    layoutOptimizer.setSchedule(options.schedule);
+    layoutOptimizer.setInitialPlacement(options.initialPlacement);
+    layoutOptimizer.setCrossingPenalty(options.crossingPenalty);
+    layoutOptimizer.setMultilevelThreshold(Constants::LayoutOptimizer::multilevelNodeCount());
+
+    auto start = std::chrono::steady_clock::now();
+    if (!layoutOptimizer.initialize(data->aspectRatio(), data->minEdgeLength())) {
+        std::printf("%-24s no nodes\n", name.c_str());
+        return;
+    }
+    const auto initializeTime = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    const auto optimizationInfo = layoutOptimizer.optimize();
+    const auto optimizeTime = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    layoutOptimizer.extract();
+    const auto extractTime = secondsSince(start);
+
+    if (!options.traceFile.empty()) {
+        writeTrace(name, optimizationInfo, options);
+    }
+
+    std::printf("%-24s %8zu %8zu %10.3f %10.3f %10.3f %12zu %12.0f %8.3f %14.0f %14.0f\n", name.c_str(),
+                data->graph().nodeCount(), data->graph().edgeCount(), initializeTime, optimizeTime, extractTime,
+                optimizationInfo.changes, optimizeTime > 0 ? static_cast<double>(optimizationInfo.changes) / optimizeTime : 0.0,
+                optimizationInfo.acceptRatio, optimizationInfo.initialCost, optimizationInfo.finalCost);
+    std::fflush(stdout);
+}
+
+void parseArgs(int argc, char ** argv, Options & options)
+{
+    Argengine ae(argc, argv);
+
+    ae.addOption(
+      { "--seed" }, [&options](std::string value) {
+          options.seed = static_cast<uint32_t>(std::stoul(value));
+      },
+      false, "Seed of the optimizer and of the synthetic graphs. Default: 1.");
+
+    ae.addOption(
+      { "--max-nodes" }, [&options](std::string value) {
+          options.maxNodeCount = std::stoul(value);
+      },
+      false, "Largest synthetic graph to run, 1k-100k nodes. Default: 100000.");
+
+    ae.addOption(
+      { "--replicas" }, [&options](std::string value) {
+          options.replicaCount = std::stoul(value);
+      },
+      false, "Number of parallel tempering replicas or threads. Default: 1.");
+
+    ae.addOption(
+      { "--time-budget" }, [&options](std::string value) {
+          options.timeBudget = std::chrono::milliseconds { std::stoul(value) };
+      },
+      false, "Time budget of each optimization in milliseconds. Default: 0, no limit.");
+
+    ae.addOption(
+      { "--lam" }, [&options] {
+          options.schedule = LayoutOptimizer::Schedule::ModifiedLam;
+      },
+      false, "Cool with the adaptive modified Lam schedule instead of the geometric one. Compare the moves and the final costs.");
+
+    ae.addOption(
+      { "--locality" }, [&options] {
+          options.initialPlacement = LayoutOptimizer::InitialPlacement::Locality;
+      },
+      false, "Place the nodes breadth-first along a Hilbert curve before annealing instead of at their scattered locations.");
+
+    ae.addOption(
+      { "--crossing-penalty" }, [&options](std::string value) {
+          options.crossingPenalty = std::stod(value);
+      },
+      false, "Cost of an edge crossing in the annealed cost. Default: 0, crossings are ignored.");
+
+    ae.addOption(
+      { "--trace" }, [&options](std::string value) {
+          options.traceFile = value;
+      },
+      false, "Write the convergence trace of the annealing of each graph to the given CSV file, one row per slice.");
+
+    ae.addOption(
+      { "--force-directed" }, [&options] {
+          options.engine = LayoutOptimizer::Engine::ForceDirected;
+      },
+      false, "Use the force-directed engine instead of the annealer.");
+
+    ae.addOption(
+      { "--tidy-tree" }, [&options] {
+          options.engine = LayoutOptimizer::Engine::TidyTree;
+      },
+      false, "Use the left-right tidy tree engine instead of the annealer.");
+
+    ae.addOption(
+      { "--radial-tree" }, [&options] {
+          options.engine = LayoutOptimizer::Engine::RadialTree;
+      },
+      false, "Use the radial tidy tree engine instead of the annealer.");
+
+    ae.setPositionalArgumentCallback([&options](Argengine::ArgumentVector args) {
+        options.files = args;
+    });
+
+    ae.setHelpText(std::string("\nUsage: ") + argv[0] + " [OPTIONS] [MIND_MAP_FILES]\n\nRuns the examples Large.alz and Matrix.alz if no files are given.");
+
+    ae.parse();
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    // Nodes are graphics items and need a GUI application for fonts
+    QApplication application(argc, argv);
+
+    TestMode::setEnabled(true);
+    L::setLoggingLevel(L::Level::Warning);
+
+    Options options;
+    parseArgs(argc, argv, options);
+
+    // Mind map data reads the settings and the layout optimizer runs in the task pool of the container
+    const ServiceContainer serviceContainer;
+
+    if (options.files.empty()) {
+        options.files = { HEIMER_EXAMPLES_DIR "/Large.alz", HEIMER_EXAMPLES_DIR "/Matrix.alz" };
+    }
+
+    if (!options.traceFile.empty()) {
+        if (const auto file = std::fopen(options.traceFile.c_str(), "w"); file) {
+            std::fprintf(file, "graph,time_s,temperature,cost,accept_ratio,moves_per_s,slice_duration_s\n");
+            std::fclose(file);
+        }
+    }
+
+    std::printf("%-24s %8s %8s %10s %10s %10s %12s %12s %8s %14s %14s\n", "Graph", "Nodes", "Edges", "Init [s]", "Opt [s]", "Extr [s]", "Moves", "Moves/s", "Accept", "Initial cost", "Final cost");
+
+    for (auto && file : options.files) {
+        try {
+            runBenchmark(file.substr(file.find_last_of("/\\") + 1), IO::AlzFileIO {}.fromFile(file.c_str()), options);
+        } catch (const std::exception & e) {
+            L().error() << "Cannot run " << file << ": " << e.what();
+        }
+    }
+
+    for (size_t nodeCount = 1000; nodeCount <= options.maxNodeCount; nodeCount *= 10) {
+        const auto name = "tree-" + std::to_string(nodeCount);
+        try {
+            runBenchmark(name, buildRandomTree(nodeCount, options.seed), options);
+        } catch (const std::exception & e) {
+            L().error() << "Cannot run " << name << ": " << e.what();
+        }
+    }
+
+    return 0;
+}
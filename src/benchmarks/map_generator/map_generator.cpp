@@ -0,0 +1,129 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "../../application/service_container.hpp"
+#include "../../common/test_mode.hpp"
+#include "../../domain/graph.hpp"
+#include "../../domain/mind_map_data.hpp"
+#include "../../infra/io/alz_file_io_worker.hpp"
+#include "../synthetic_map.hpp"
+
+#include "argengine.hpp"
+#include "simple_logger.hpp"
+
+#include <QApplication>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using juzzlin::Argengine;
+using juzzlin::L;
+
+namespace {
+
+struct Options
+{
+    SyntheticMap::Parameters parameters;
+
+    bool compress = false;
+
+    std::string outputFile;
+};
+
+void parseArgs(int argc, char ** argv, Options & options)
+{
+    Argengine ae(argc, argv);
+
+    ae.addOption(
+      { "--nodes" }, [&options](std::string value) {
+          options.parameters.nodeCount = std::stoul(value);
+      },
+      false, "Number of nodes. Default: 1000.");
+
+    ae.addOption(
+      { "--branching" }, [&options](std::string value) {
+          options.parameters.branchingFactor = std::stoul(value);
+      },
+      false, "Children per node of a complete tree. Default: 0, which builds a random tree.");
+
+    ae.addOption(
+      { "--extra-edges" }, [&options](std::string value) {
+          options.parameters.extraEdgesPerNode = std::stod(value);
+      },
+      false, "Random edges per node on top of the tree. Default: 0.");
+
+    ae.addOption(
+      { "--words" }, [&options](std::string value) {
+          options.parameters.wordsPerNode = std::stoul(value);
+      },
+      false, "Words in the text of each node. Default: 2.");
+
+    ae.addOption(
+      { "--images" }, [&options](std::string value) {
+          options.parameters.imageCount = std::stoul(value);
+      },
+      false, "Number of distinct images spread over the nodes. Default: 0.");
+
+    ae.addOption(
+      { "--seed" }, [&options](std::string value) {
+          options.parameters.seed = static_cast<uint32_t>(std::stoul(value));
+      },
+      false, "Seed of the generator. The same options and seed always generate the same map. Default: 1.");
+
+    ae.addOption(
+      { "--compress" }, [&options] {
+          options.compress = true;
+      },
+      false, "Compress the output file.");
+
+    ae.setPositionalArgumentCallback([&options](Argengine::ArgumentVector args) {
+        options.outputFile = args.at(0);
+    });
+
+    ae.setHelpText(std::string("\nUsage: ") + argv[0] + " [OPTIONS] OUTPUT_FILE\n\nGenerates a synthetic mind map for stress tests.");
+
+    ae.parse();
+}
+
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    // Nodes are graphics items and need a GUI application for fonts
+    QApplication application(argc, argv);
+
+    TestMode::setEnabled(true);
+    L::setLoggingLevel(L::Level::Warning);
+
+    Options options;
+    parseArgs(argc, argv, options);
+    if (options.outputFile.empty()) {
+        L().error() << "No output file given";
+        return EXIT_FAILURE;
+    }
+
+    const ServiceContainer serviceContainer;
+
+    const auto data = SyntheticMap::build(options.parameters);
+    if (!IO::AlzFileIOWorker { IO::AlzFormatVersion::V2 }.toFile(data, options.outputFile.c_str(), options.compress)) {
+        L().error() << "Cannot write " << options.outputFile;
+        return EXIT_FAILURE;
+    }
+
+    std::printf("Wrote %zu nodes and %zu edges to %s\n", data->graph().nodeCount(), data->graph().edgeCount(), options.outputFile.c_str());
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,99 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "synthetic_map.hpp"
+
+#include "../common/constants.hpp"
+#include "../domain/graph.hpp"
+#include "../domain/image.hpp"
+#include "../domain/image_manager.hpp"
+#include "../domain/mind_map_data.hpp"
+#include "../view/scene_items/edge.hpp"
+#include "../view/scene_items/node.hpp"
+
+#include <QColor>
+#include <QImage>
+#include <QStringList>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+
+namespace SyntheticMap {
+
+const std::vector<const char *> & words()
+{
+    static const std::vector<const char *> words { "alpha", "beta", "gamma", "delta", "epsilon", "map", "mind", "node", "edge", "idea", "plan", "task" };
+    return words;
+}
+
+MindMapDataS build(const Parameters & parameters)
+{
+    auto data = std::make_shared<MindMapData>();
+    std::mt19937 engine { parameters.seed };
+    const auto extent = std::sqrt(static_cast<double>(parameters.nodeCount)) * Constants::Node::minWidth() * 2;
+    std::uniform_real_distribution<double> locationDist { -extent / 2, extent / 2 };
+    std::uniform_int_distribution<size_t> wordDist { 0, words().size() - 1 };
+
+    std::vector<size_t> imageIds;
+    for (size_t i = 0; i < parameters.imageCount; i++) {
+        QImage image { 64, 64, QImage::Format_ARGB32 };
+        image.fill(QColor::fromHsv(static_cast<int>(i * 37 % 360), 255, 255));
+        imageIds.push_back(data->imageManager().addImage({ image, "image" + std::to_string(i) + ".png" }));
+    }
+    const auto nodesPerImage = imageIds.empty() ? size_t { 0 } : std::max<size_t>(1, parameters.nodeCount / imageIds.size());
+
+    std::vector<NodeS> nodes;
+    nodes.reserve(parameters.nodeCount);
+    for (size_t i = 0; i < parameters.nodeCount; i++) {
+        auto node = std::make_shared<SceneItems::Node>();
+        data->graph().addNode(node);
+        node->setLocation({ locationDist(engine), locationDist(engine) });
+
+        QStringList text;
+        for (size_t word = 0; word < parameters.wordsPerNode; word++) {
+            text << words().at(wordDist(engine));
+        }
+        text << QString::number(i);
+        node->setText(text.join(' '));
+
+        if (nodesPerImage && i % nodesPerImage == 0) {
+            node->setImageRef(imageIds.at(i / nodesPerImage % imageIds.size()));
+        }
+
+        if (!nodes.empty()) {
+            const auto parent = parameters.branchingFactor ? (i - 1) / parameters.branchingFactor : std::uniform_int_distribution<size_t> { 0, nodes.size() - 1 }(engine);
+            data->graph().addEdge(std::make_shared<SceneItems::Edge>(nodes.at(parent), node));
+        }
+        nodes.push_back(node);
+    }
+
+    if (nodes.size() > 1) {
+        std::uniform_int_distribution<size_t> nodeDist { 0, nodes.size() - 1 };
+        const auto extraEdgeCount = static_cast<size_t>(parameters.extraEdgesPerNode * static_cast<double>(nodes.size()));
+        for (size_t i = 0; i < extraEdgeCount; i++) {
+            const auto source = nodes.at(nodeDist(engine));
+            const auto target = nodes.at(nodeDist(engine));
+            if (source != target && !data->graph().areDirectlyConnected(source, target)) {
+                data->graph().addEdge(std::make_shared<SceneItems::Edge>(source, target));
+            }
+        }
+    }
+
+    return data;
+}
+
+} // namespace SyntheticMap
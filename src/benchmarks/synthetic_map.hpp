@@ -0,0 +1,55 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SYNTHETIC_MAP_HPP
+#define SYNTHETIC_MAP_HPP
+
+#include "../common/types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//! Seeded generator of large mind maps for benchmarks and stress tests.
+namespace SyntheticMap {
+
+struct Parameters
+{
+    size_t nodeCount = 1000;
+
+    //! Children per node of a complete tree, or 0 for a random tree.
+    size_t branchingFactor = 0;
+
+    //! Edges per node on top of the spanning tree.
+    double extraEdgesPerNode = 0;
+
+    size_t wordsPerNode = 2;
+
+    //! Number of distinct images that get spread evenly over the nodes.
+    size_t imageCount = 0;
+
+    uint32_t seed = 1;
+};
+
+//! \returns The words that the node texts are built from. Useful as search queries.
+const std::vector<const char *> & words();
+
+//! Builds a spanning tree with the nodes scattered over an area that roughly fits them.
+//! The same parameters always build the same map.
+MindMapDataS build(const Parameters & parameters);
+
+} // namespace SyntheticMap
+
+#endif // SYNTHETIC_MAP_HPP
@@ -0,0 +1,242 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "compact_text.hpp"
+
+#include <QDataStream>
+
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+
+struct CompactText::Entry
+{
+    std::atomic<size_t> referenceCount { 1 };
+
+    size_t hash = 0;
+
+    size_t size = 0;
+
+    // The UTF-8 bytes follow the entry in the same allocation
+
+    const char * data() const
+    {
+        return reinterpret_cast<const char *>(this + 1);
+    }
+
+    char * data()
+    {
+        return reinterpret_cast<char *>(this + 1);
+    }
+
+    std::string_view view() const
+    {
+        return { data(), size };
+    }
+};
+
+namespace {
+
+class Pool
+{
+public:
+    CompactText::Entry * acquire(std::string_view utf8)
+    {
+        const std::lock_guard<std::mutex> lock { m_mutex };
+        if (const auto iter = m_entries.find(utf8); iter != m_entries.end()) {
+            // Also revives an entry whose last reference is being released, see release()
+            iter->second->referenceCount.fetch_add(1, std::memory_order_relaxed);
+            return iter->second;
+        }
+
+        const auto entry = new (::operator new(sizeof(CompactText::Entry) + utf8.size())) CompactText::Entry;
+        entry->hash = std::hash<std::string_view> {}(utf8);
+        entry->size = utf8.size();
+        std::memcpy(entry->data(), utf8.data(), utf8.size());
+        m_entries.emplace(entry->view(), entry);
+        return entry;
+    }
+
+    void addReference(CompactText::Entry * entry)
+    {
+        // The caller holds a reference, so the entry can't be released meanwhile
+        entry->referenceCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release(CompactText::Entry * entry)
+    {
+        // Only the last reference needs the lock, so that acquire() can't find an entry that is being deleted
+        auto referenceCount = entry->referenceCount.load(std::memory_order_relaxed);
+        while (referenceCount > 1) {
+            if (entry->referenceCount.compare_exchange_weak(referenceCount, referenceCount - 1, std::memory_order_release, std::memory_order_relaxed)) {
+                return;
+            }
+        }
+
+        const std::lock_guard<std::mutex> lock { m_mutex };
+        if (entry->referenceCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            m_entries.erase(entry->view());
+            entry->~Entry();
+            ::operator delete(entry);
+        }
+    }
+
+    size_t size() const
+    {
+        const std::lock_guard<std::mutex> lock { m_mutex };
+        return m_entries.size();
+    }
+
+private:
+    mutable std::mutex m_mutex;
+
+    //! The keys point to the bytes of the entries.
+    std::unordered_map<std::string_view, CompactText::Entry *> m_entries;
+};
+
+Pool & pool()
+{
+    // Never destroyed, as texts may be released by other static objects on exit
+    static const auto pool = new Pool;
+    return *pool;
+}
+
+} // namespace
+
+CompactText::CompactText(const QString & text)
+{
+    if (!text.isEmpty()) {
+        const auto utf8 = text.toUtf8();
+        m_entry = pool().acquire({ utf8.constData(), static_cast<size_t>(utf8.size()) });
+    }
+}
+
+CompactText::CompactText(const CompactText & other)
+  : m_entry(other.m_entry)
+{
+    if (m_entry) {
+        pool().addReference(m_entry);
+    }
+}
+
+CompactText::CompactText(CompactText && other) noexcept
+  : m_entry(other.m_entry)
+{
+    other.m_entry = nullptr;
+}
+
+CompactText & CompactText::operator=(const CompactText & other)
+{
+    if (m_entry != other.m_entry) {
+        CompactText copy { other };
+        std::swap(m_entry, copy.m_entry);
+    }
+    return *this;
+}
+
+CompactText & CompactText::operator=(CompactText && other) noexcept
+{
+    std::swap(m_entry, other.m_entry);
+    return *this;
+}
+
+CompactText::~CompactText()
+{
+    if (m_entry) {
+        pool().release(m_entry);
+    }
+}
+
+CompactText::operator QString() const
+{
+    return toString();
+}
+
+QString CompactText::toString() const
+{
+    return m_entry ? QString::fromUtf8(m_entry->data(), static_cast<int>(m_entry->size)) : QString {};
+}
+
+bool CompactText::contains(const QString & text, Qt::CaseSensitivity caseSensitivity) const
+{
+    return toString().contains(text, caseSensitivity);
+}
+
+bool CompactText::isEmpty() const
+{
+    return !m_entry;
+}
+
+std::string_view CompactText::utf8() const
+{
+    return m_entry ? m_entry->view() : std::string_view {};
+}
+
+size_t CompactText::estimatedSize() const
+{
+    return m_entry ? sizeof(Entry) + m_entry->size : 0;
+}
+
+size_t CompactText::pooledCount()
+{
+    return pool().size();
+}
+
+bool operator==(const CompactText & text0, const QString & text1)
+{
+    const auto utf8 = text1.toUtf8();
+    return text0.utf8() == std::string_view { utf8.constData(), static_cast<size_t>(utf8.size()) };
+}
+
+bool operator!=(const CompactText & text0, const QString & text1)
+{
+    return !(text0 == text1);
+}
+
+bool operator==(const QString & text0, const CompactText & text1)
+{
+    return text1 == text0;
+}
+
+bool operator!=(const QString & text0, const CompactText & text1)
+{
+    return !(text1 == text0);
+}
+
+size_t CompactText::hash() const
+{
+    return m_entry ? m_entry->hash : 0;
+}
+
+size_t qHash(const CompactText & text, size_t seed)
+{
+    return text.hash() ^ seed;
+}
+
+QDataStream & operator<<(QDataStream & out, const CompactText & text)
+{
+    return out << text.toString();
+}
+
+QDataStream & operator>>(QDataStream & in, CompactText & text)
+{
+    QString string;
+    in >> string;
+    text = string;
+    return in;
+}
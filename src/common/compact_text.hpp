@@ -0,0 +1,98 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef COMPACT_TEXT_HPP
+#define COMPACT_TEXT_HPP
+
+#include <QString>
+
+#include <cstddef>
+#include <string_view>
+
+class QDataStream;
+
+//! Immutable text of the plain-data models stored as interned UTF-8. Identical texts share a single
+//! reference-counted copy in a pool, so the texts of the undo snapshots, the copy buffer and the mind maps
+//! read again e.g. from the autosave journal cost no extra memory, and comparing two texts is a pointer
+//! comparison. The text converts to QString only at the scene and the file boundaries. Thread-safe.
+class CompactText
+{
+public:
+    CompactText() = default;
+
+    CompactText(const QString & text);
+
+    CompactText(const CompactText & other);
+
+    CompactText(CompactText && other) noexcept;
+
+    CompactText & operator=(const CompactText & other);
+
+    CompactText & operator=(CompactText && other) noexcept;
+
+    ~CompactText();
+
+    operator QString() const;
+
+    QString toString() const;
+
+    bool contains(const QString & text, Qt::CaseSensitivity caseSensitivity = Qt::CaseSensitive) const;
+
+    bool isEmpty() const;
+
+    std::string_view utf8() const;
+
+    //! \returns Hash of the UTF-8 bytes computed once when the text was pooled.
+    size_t hash() const;
+
+    //! \returns Bytes used by the text in the pool, shared by all the copies.
+    size_t estimatedSize() const;
+
+    //! \returns Number of distinct texts in the pool.
+    static size_t pooledCount();
+
+    friend bool operator==(const CompactText & text0, const CompactText & text1)
+    {
+        return text0.m_entry == text1.m_entry;
+    }
+
+    friend bool operator!=(const CompactText & text0, const CompactText & text1)
+    {
+        return !(text0 == text1);
+    }
+
+    friend bool operator==(const CompactText & text0, const QString & text1);
+
+    friend bool operator!=(const CompactText & text0, const QString & text1);
+
+    friend bool operator==(const QString & text0, const CompactText & text1);
+
+    friend bool operator!=(const QString & text0, const CompactText & text1);
+
+    struct Entry;
+
+private:
+    //! nullptr for the empty text.
+    Entry * m_entry = nullptr;
+};
+
+size_t qHash(const CompactText & text, size_t seed = 0);
+
+//! Streamed as QString so that the data streams stay compatible.
+QDataStream & operator<<(QDataStream & out, const CompactText & text);
+
+QDataStream & operator>>(QDataStream & in, CompactText & text);
+
+#endif // COMPACT_TEXT_HPP
@@ -45,6 +45,26 @@ IO::AlzFormatVersion alzFormatVersion()
     return IO::AlzFormatVersion::V2;
 }
 
+std::chrono::milliseconds autosaveDebounceDelay()
+{
+    return std::chrono::milliseconds { 1000 };
+}
+
+size_t autosaveJournalCompactionInterval()
+{
+    return 50;
+}
+
+QString binaryFileExtension()
+{
+    return ".alzb";
+}
+
+QString clipboardMimeType()
+{
+    return "application/x-heimer-subgraph";
+}
+
 QString copyright()
 {
     return "Copyright (c) 2018-2024 Jussi Lind";
@@ -55,6 +75,16 @@ QString fileExtension()
     return ".alz";
 }
 
+std::chrono::milliseconds fileChangeDebounceDelay()
+{
+    return std::chrono::milliseconds { 500 };
+}
+
+std::chrono::milliseconds memoryUsageLogInterval()
+{
+    return std::chrono::milliseconds { 60000 };
+}
+
 LanguageSet supportedLanguages()
 {
     return { "de", "en", "es", "eu", "fi", "fr", "it", "pt_Br", "pt_Pt", "nl", "zh" };
@@ -80,16 +110,52 @@ QString releasesUrl()
     return "https://github.com/juzzlin/Heimer/releases";
 }
 
+std::chrono::milliseconds sessionHandshakeTimeout()
+{
+    return std::chrono::milliseconds { 10000 };
+}
+
+int sessionMaxFrameSize()
+{
+    return 256 * 1024 * 1024;
+}
+
+int sessionMaxOperationSize()
+{
+    return 1024 * 1024 * 1024;
+}
+
 QString supportSiteUrl()
 {
     return "https://paypal.me/juzzlin";
 }
 
+std::chrono::milliseconds urlTransferTimeout()
+{
+    return std::chrono::milliseconds { 30000 };
+}
+
+std::chrono::milliseconds guiJobSliceDuration()
+{
+    // Half a frame leaves time for the input events and the repaint
+    return std::chrono::milliseconds { 8 };
+}
+
+std::chrono::milliseconds teardownSliceDuration()
+{
+    return std::chrono::milliseconds { 4 };
+}
+
 QString translationsResourceBase()
 {
     return ":/translations/heimer_";
 }
 
+std::chrono::milliseconds versionCheckDelay()
+{
+    return std::chrono::milliseconds { 3000 };
+}
+
 } // namespace Application
 
 namespace Settings {
@@ -134,8 +200,67 @@ QColor defaultShadowEffectSelectedItemShadowColor()
     return { 255, 0, 0 };
 }
 
+int defaultUndoMemoryBudgetMiB()
+{
+    return 256;
+}
+
+int defaultImageMemoryCapMiB()
+{
+    return 512;
+}
+
+size_t defaultBalancedProfileItemCount()
+{
+    return 5000;
+}
+
+size_t defaultSpeedProfileItemCount()
+{
+    return 20000;
+}
+
 } // namespace Settings
 
+namespace Cache {
+
+size_t backgroundImageBudget()
+{
+    return 64 * 1024 * 1024;
+}
+
+size_t backgroundPixmapBudget()
+{
+    return 8 * 1024 * 1024;
+}
+
+size_t backgroundTextSizeBudget()
+{
+    return 1024 * 1024;
+}
+
+size_t backgroundUndoBudget()
+{
+    return 32 * 1024 * 1024;
+}
+
+std::chrono::milliseconds backgroundTrimDelay()
+{
+    return std::chrono::milliseconds { 30000 };
+}
+
+double lowMemoryRatio()
+{
+    return 0.05;
+}
+
+std::chrono::milliseconds memoryPressurePollInterval()
+{
+    return std::chrono::milliseconds { 5000 };
+}
+
+} // namespace Cache
+
 namespace Edge {
 
 double arrowSizeStep()
@@ -168,8 +293,47 @@ double edgeWidthStep()
     return 0.25;
 }
 
+std::chrono::milliseconds dotAnimationDuration()
+{
+    return std::chrono::milliseconds { 2000 };
+}
+
+std::chrono::milliseconds dotAnimationTickInterval()
+{
+    return std::chrono::milliseconds { 16 };
+}
+
+QColor labelColor()
+{
+    return { 0xff, 0xee, 0xaa };
+}
+
+int bundleSectorCount()
+{
+    return 8;
+}
+
+size_t bundlingThreshold()
+{
+    return 16;
+}
+
 } // namespace Edge
 
+namespace Image {
+
+int maxVectorLevelSize()
+{
+    return 4096;
+}
+
+int minLevelSize()
+{
+    return 64;
+}
+
+} // namespace Image
+
 namespace MindMap {
 
 QColor defaultBackgroundColor()
@@ -206,11 +370,21 @@ int defaultTextSize()
 
 namespace Node {
 
+int contentPadding()
+{
+    return 10;
+}
+
 int defaultCornerRadius()
 {
     return 5;
 }
 
+double maxCachedPixelArea()
+{
+    return 1024 * 512;
+}
+
 int minHeight()
 {
     return 75;
@@ -221,6 +395,16 @@ int minWidth()
     return 200;
 }
 
+double placementSpacing()
+{
+    return 10;
+}
+
+size_t textSizeCacheSize()
+{
+    return 100000;
+}
+
 } // namespace Node
 
 namespace LayoutOptimizer {
@@ -245,6 +429,52 @@ double maxAspectRatio()
     return 100;
 }
 
+size_t maxReplicaCount()
+{
+    return 8;
+}
+
+size_t multilevelNodeCount()
+{
+    return 1000;
+}
+
+size_t multilevelCoarsestNodeCount()
+{
+    return 250;
+}
+
+std::chrono::milliseconds previewInterval()
+{
+    return std::chrono::milliseconds { 500 };
+}
+
+size_t subgraphHopCount()
+{
+    return 1;
+}
+
+std::chrono::seconds maxTimeBudget()
+{
+    return std::chrono::hours { 1 };
+}
+
+double crossingPenalty()
+{
+    // Each edge is counted from both ends, so this equals lengthening an edge by the width of a cell
+    return 2 * Node::minWidth();
+}
+
+size_t layoutCacheSize()
+{
+    return 8;
+}
+
+size_t traceSize()
+{
+    return 4096;
+}
+
 } // namespace LayoutOptimizer
 
 namespace Misc {
@@ -258,6 +488,118 @@ QString threeDots()
 
 namespace View {
 
+size_t bulkInsertThreshold()
+{
+    return 100;
+}
+
+double bulkMoveFraction()
+{
+    return 0.1;
+}
+
+size_t batchedRenderingThreshold()
+{
+    return 5000;
+}
+
+QColor diffAddedColor()
+{
+    return { 0, 192, 0 };
+}
+
+QColor diffEditedColor()
+{
+    return { 255, 160, 0 };
+}
+
+QColor diffMovedColor()
+{
+    return { 0, 128, 255 };
+}
+
+size_t dragTileCacheThreshold()
+{
+    return 200;
+}
+
+std::chrono::milliseconds gestureSettleInterval()
+{
+    return std::chrono::milliseconds { 150 };
+}
+
+size_t gestureSnapshotThreshold()
+{
+    return 200;
+}
+
+double gestureSnapshotMinCoverage()
+{
+    return 0.5;
+}
+
+std::chrono::milliseconds layoutTransitionDuration()
+{
+    return std::chrono::milliseconds { 400 };
+}
+
+std::chrono::milliseconds layoutTransitionTickInterval()
+{
+    return std::chrono::milliseconds { 16 };
+}
+
+size_t minimapThreshold()
+{
+    return 1000;
+}
+
+std::chrono::milliseconds minimapUpdateInterval()
+{
+    return std::chrono::milliseconds { 100 };
+}
+
+std::chrono::milliseconds mouseMoveInterval()
+{
+    // About one frame
+    return std::chrono::milliseconds { 16 };
+}
+
+size_t prewarmChunkSize()
+{
+    return 50;
+}
+
+std::chrono::milliseconds prewarmIdleDelay()
+{
+    return std::chrono::milliseconds { 300 };
+}
+
+size_t progressiveLoadChunkSize()
+{
+    return 100;
+}
+
+size_t progressiveLoadThreshold()
+{
+    return 2000;
+}
+
+double slowFrameMilliseconds()
+{
+    // Below 30 fps
+    return 1000.0 / 30;
+}
+
+double fastFrameMilliseconds()
+{
+    return 8;
+}
+
+size_t performanceProfileSettleFrames()
+{
+    return 30;
+}
+
 int minTextSize()
 {
     return 6;
@@ -268,11 +610,52 @@ int maxTextSize()
     return 72;
 }
 
+double reducedLevelOfDetail()
+{
+    return 0.4;
+}
+
+double minimalLevelOfDetail()
+{
+    return 0.15;
+}
+
+int pixmapCacheLimitKb()
+{
+    return 64 * 1024;
+}
+
+size_t pngExportBandBytes()
+{
+    return 16 * 1024 * 1024;
+}
+
+QVector<int> thumbnailSizes()
+{
+    return { 64, 128, 256 };
+}
+
+int headerThumbnailSize()
+{
+    return 128;
+}
+
+std::chrono::milliseconds styleChangeInterval()
+{
+    // About one frame
+    return std::chrono::milliseconds { 16 };
+}
+
 std::chrono::milliseconds tooQuickActionDelay()
 {
     return std::chrono::milliseconds { 500 };
 }
 
+std::chrono::milliseconds undoCoalescingPause()
+{
+    return std::chrono::milliseconds { 1000 };
+}
+
 double zoomSensitivity()
 {
     return 1.1;
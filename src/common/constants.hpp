@@ -37,10 +37,27 @@ QString applicationPackageType();
 
 QString applicationVersion();
 
+//! Delay that coalesces bursts of autosave requests into a single save.
+std::chrono::milliseconds autosaveDebounceDelay();
+
+//! Number of journal records after which autosave compacts the journal into a full save.
+size_t autosaveJournalCompactionInterval();
+
+QString binaryFileExtension();
+
+//! MIME type of copied subgraphs on the system clipboard.
+QString clipboardMimeType();
+
 QString copyright();
 
 QString fileExtension();
 
+//! Delay that coalesces the change notifications of an external save of the open file into a single reload.
+std::chrono::milliseconds fileChangeDebounceDelay();
+
+//! Interval of logging the memory usage report when debug logging is enabled.
+std::chrono::milliseconds memoryUsageLogInterval();
+
 using LanguageSet = std::set<std::string>;
 
 LanguageSet supportedLanguages();
@@ -51,10 +68,31 @@ QString qSettingsSoftwareName();
 
 QString releasesUrl();
 
+//! Time that a peer has to answer the challenge of the host of a collaboration session.
+std::chrono::milliseconds sessionHandshakeTimeout();
+
+//! Largest frame of a collaboration session, e.g. the compressed reset of a large mind map with images.
+int sessionMaxFrameSize();
+
+//! Largest edit operation of a collaboration session after inflating.
+int sessionMaxOperationSize();
+
 QString supportSiteUrl();
 
+//! Time that a download of a mind map may stall before it's aborted.
+std::chrono::milliseconds urlTransferTimeout();
+
+//! Time budget per event loop iteration for the jobs of the GUI thread, see GuiJobScheduler.
+std::chrono::milliseconds guiJobSliceDuration();
+
+//! Time budget per event loop iteration for deleting the scene items of replaced mind maps.
+std::chrono::milliseconds teardownSliceDuration();
+
 QString translationsResourceBase();
 
+//! Delay after the main window has become interactive before checking for new releases.
+std::chrono::milliseconds versionCheckDelay();
+
 QString webSiteUrl();
 
 } // namespace Application
@@ -77,12 +115,53 @@ QColor defaultShadowEffectShadowColor();
 
 QColor defaultShadowEffectSelectedItemShadowColor();
 
+int defaultUndoMemoryBudgetMiB();
+
+int defaultImageMemoryCapMiB();
+
+//! Number of nodes and edges from which the automatic performance profile uses the balanced tier, see PerformanceProfile.
+size_t defaultBalancedProfileItemCount();
+
+//! Number of nodes and edges from which the automatic performance profile uses the speed tier.
+size_t defaultSpeedProfileItemCount();
+
 } // namespace Settings
 
+namespace Cache {
+
+//! Bytes of decoded images kept while the application is in the background, see CacheRegistry.
+size_t backgroundImageBudget();
+
+//! Bytes of the pixmap cache kept while the application is in the background.
+size_t backgroundPixmapBudget();
+
+//! Bytes of cached text sizes kept while the application is in the background.
+size_t backgroundTextSizeBudget();
+
+//! Bytes of uncompressed undo keyframes kept per stack while the application is in the background.
+size_t backgroundUndoBudget();
+
+//! Time in the background, i.e. minimized or inactive, after which the caches are trimmed to their background budgets.
+std::chrono::milliseconds backgroundTrimDelay();
+
+//! Fraction of the physical memory below which the available memory counts as low and the caches are emptied.
+double lowMemoryRatio();
+
+//! Interval of checking the available memory, as there's no portable notification of memory pressure.
+std::chrono::milliseconds memoryPressurePollInterval();
+
+} // namespace Cache
+
 namespace Edge {
 
 double arrowSizeStep();
 
+//! Edges are bundled into trunks by the direction from their source node in this many sectors, see EdgeBundler.
+int bundleSectorCount();
+
+//! Nodes with at least this many outgoing edges get their edges bundled, see EdgeBundler.
+size_t bundlingThreshold();
+
 double minArrowSize();
 
 double maxArrowSize();
@@ -93,8 +172,24 @@ double maxEdgeWidth();
 
 double edgeWidthStep();
 
+std::chrono::milliseconds dotAnimationDuration();
+
+std::chrono::milliseconds dotAnimationTickInterval();
+
+QColor labelColor();
+
 } // namespace Edge
 
+namespace Image {
+
+//! Max size of the longer side of a rendering of an SVG image in pixels.
+int maxVectorLevelSize();
+
+//! Downscaled image levels are generated until the shorter side would get smaller than this.
+int minLevelSize();
+
+} // namespace Image
+
 namespace MindMap {
 
 QColor defaultBackgroundColor();
@@ -119,12 +214,24 @@ QString threeDots();
 
 namespace Node {
 
+//! Padding between the borders and the text of a node.
+int contentPadding();
+
 int defaultCornerRadius();
 
+//! Area in device pixels above which a node is painted directly instead of from a cached pixmap.
+double maxCachedPixelArea();
+
 int minHeight();
 
 int minWidth();
 
+//! Minimum free space between a new node and the existing nodes when the new node is placed automatically.
+double placementSpacing();
+
+//! Number of text sizes kept in the cache shared by all nodes.
+size_t textSizeCacheSize();
+
 } // namespace Node
 
 namespace LayoutOptimizer {
@@ -137,16 +244,133 @@ double minAspectRatio();
 
 double maxAspectRatio();
 
+//! Upper limit for the number of parallel tempering replicas, i.e. threads used by the optimizer.
+size_t maxReplicaCount();
+
+//! Node count from which the optimizer coarsens the graph and refines level by level.
+size_t multilevelNodeCount();
+
+//! The coarsening stops once a level has at most this many vertices.
+size_t multilevelCoarsestNodeCount();
+
+//! Interval of the intermediate layouts published while optimizing.
+std::chrono::milliseconds previewInterval();
+
+//! Number of hops around the selected nodes that are re-optimized with them.
+size_t subgraphHopCount();
+
+//! Upper limit of the time budget that can be given to the optimizer.
+std::chrono::seconds maxTimeBudget();
+
+//! Cost of an edge crossing when crossings are avoided.
+double crossingPenalty();
+
+//! Number of optimized layouts kept per mind map, see LayoutCache.
+size_t layoutCacheSize();
+
+//! Number of the latest annealing slices kept in the convergence trace of an optimization.
+size_t traceSize();
+
 } // namespace LayoutOptimizer
 
 namespace View {
 
+//! Minimum number of new items for which the scene index is rebuilt once instead of updated per item.
+size_t bulkInsertThreshold();
+
+//! Fraction of the edges in the scene, but at least bulkInsertThreshold(), that must move within one event loop
+//! iteration for the scene index to be rebuilt instead of updated per move.
+double bulkMoveFraction();
+
+//! Minimum number of nodes for which the mind map is drawn in batches at the Minimal level of detail, if enabled.
+size_t batchedRenderingThreshold();
+
+//! Glow colors of the added, edited and moved items when the mind map is compared with a file.
+QColor diffAddedColor();
+
+QColor diffEditedColor();
+
+QColor diffMovedColor();
+
+//! Minimum number of static nodes and edges in the viewport for which they are drawn from cached tiles during a drag.
+size_t dragTileCacheThreshold();
+
+//! Number of items added to the scene per step when a large mind map is opened progressively.
+//! The steps run in time slices, see GuiJobScheduler.
+size_t progressiveLoadChunkSize();
+
+//! Time without zoom or pan input after which a gesture ends and the view is repainted at full quality.
+std::chrono::milliseconds gestureSettleInterval();
+
+//! Minimum number of items in the viewport for which zooming and panning transform a snapshot of the view.
+size_t gestureSnapshotThreshold();
+
+//! Fraction of the viewport below which the snapshot of a gesture is captured again.
+double gestureSnapshotMinCoverage();
+
+//! Duration of the transition of the nodes to the locations of an applied layout, see LayoutTransition.
+std::chrono::milliseconds layoutTransitionDuration();
+
+//! Interval of the steps of a layout transition.
+std::chrono::milliseconds layoutTransitionTickInterval();
+
+//! Minimum number of nodes for which the minimap is shown.
+size_t minimapThreshold();
+
+//! Interval at which the dirty parts of the minimap are redrawn at most.
+std::chrono::milliseconds minimapUpdateInterval();
+
+//! Interval at which the mouse moves are handled at most. The positions in between are dropped.
+std::chrono::milliseconds mouseMoveInterval();
+
+//! Number of nodes whose caches are filled per step while the GUI is idle, see ScenePrewarmer.
+size_t prewarmChunkSize();
+
+//! Time without user input after which the caches are filled, see ScenePrewarmer.
+std::chrono::milliseconds prewarmIdleDelay();
+
+//! Minimum number of nodes and edges for which an opened mind map is added to the scene progressively.
+size_t progressiveLoadThreshold();
+
+//! Average paint time of a frame above which the automatic performance profile raises its tier.
+double slowFrameMilliseconds();
+
+//! Average paint time of a frame below which the automatic performance profile lowers a tier raised by slow frames.
+double fastFrameMilliseconds();
+
+//! Number of frames painted after a tier change before the performance profile judges the paint times again.
+size_t performanceProfileSettleFrames();
+
 int minTextSize();
 
 int maxTextSize();
 
+//! Level of detail below which texts, labels, arrowheads and edge dots are not drawn in the quality performance tier.
+double reducedLevelOfDetail();
+
+//! Level of detail below which nodes are drawn as flat rects and edges as hairlines in the quality performance tier.
+double minimalLevelOfDetail();
+
+//! Minimum size of the shared pixmap cache in kilobytes.
+int pixmapCacheLimitKb();
+
+//! Approximate size of one band of a PNG export, which is rendered and compressed at once.
+size_t pngExportBandBytes();
+
+//! Lengths of the longest sides of the cached thumbnails of the recent files in ascending order.
+QVector<int> thumbnailSizes();
+
+//! Length of the longest side of the thumbnail embedded in the header of the saved files.
+int headerThumbnailSize();
+
+//! Interval at which the style changes from the tool bar spin boxes are applied to all items at most.
+std::chrono::milliseconds styleChangeInterval();
+
 std::chrono::milliseconds tooQuickActionDelay();
 
+//! Pause after which the next change of a coalesced operation, e.g. typing, gets an undo point of its own.
+std::chrono::milliseconds undoCoalescingPause();
+
 double zoomSensitivity();
 
 } // namespace View
@@ -0,0 +1,231 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "profiler.hpp"
+
+#include "simple_logger.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+static const auto TAG = "Profiler";
+
+namespace Profiler {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct SectionCounters
+{
+    std::atomic<uint64_t> frameNanoseconds { 0 };
+
+    std::atomic<uint64_t> frameCalls { 0 };
+
+    std::atomic<uint64_t> totalNanoseconds { 0 };
+
+    std::atomic<uint64_t> totalCalls { 0 };
+};
+
+std::atomic<bool> profilingEnabled { false };
+
+std::array<SectionCounters, static_cast<size_t>(Section::Count)> sectionCounters;
+
+std::atomic<uint64_t> frameShadowsDrawn { 0 };
+
+std::atomic<uint64_t> totalShadowsDrawn { 0 };
+
+std::atomic<bool> frameObserved { false };
+
+// The frame bookkeeping is only touched by the GUI thread
+FrameStats lastFrameStats;
+
+FrameObserver frameObserver;
+
+uint64_t observedFrameNanoseconds = 0;
+
+uint64_t totalFrames = 0;
+
+size_t framesInFpsWindow = 0;
+
+Clock::time_point fpsWindowStart = Clock::now();
+
+std::string reportFileName;
+
+const char * sectionName(Section section)
+{
+    switch (section) {
+    case Section::View:
+        return "View";
+    case Section::Background:
+        return "Background";
+    case Section::Shadows:
+        return "Shadows";
+    case Section::NodePaint:
+        return "Node paint";
+    case Section::EdgePaint:
+        return "Edge paint";
+    case Section::VisibleItems:
+        return "Visible items";
+    case Section::Count:
+        break;
+    }
+    return "";
+}
+
+double toMilliseconds(uint64_t nanoseconds)
+{
+    return static_cast<double>(nanoseconds) / 1'000'000;
+}
+
+SectionCounters & counters(Section section)
+{
+    return sectionCounters.at(static_cast<size_t>(section));
+}
+
+} // namespace
+
+bool enabled()
+{
+    return profilingEnabled.load(std::memory_order_relaxed);
+}
+
+void setEnabled(bool enabled)
+{
+    profilingEnabled = enabled;
+}
+
+ScopedTimer::ScopedTimer(Section section)
+  : m_section(section)
+  , m_active(Profiler::enabled() || (section == Section::View && frameObserved.load(std::memory_order_relaxed)))
+{
+    if (m_active) {
+        m_start = Clock::now();
+    }
+}
+
+ScopedTimer::~ScopedTimer()
+{
+    if (m_active) {
+        const auto nanoseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_start).count());
+        if (m_section == Section::View) {
+            observedFrameNanoseconds += nanoseconds;
+        }
+        if (!Profiler::enabled()) {
+            return;
+        }
+        auto && sectionCounters = counters(m_section);
+        sectionCounters.frameNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+        sectionCounters.frameCalls.fetch_add(1, std::memory_order_relaxed);
+        sectionCounters.totalNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+        sectionCounters.totalCalls.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void addShadowsDrawn(size_t count)
+{
+    if (enabled()) {
+        frameShadowsDrawn.fetch_add(count, std::memory_order_relaxed);
+        totalShadowsDrawn.fetch_add(count, std::memory_order_relaxed);
+    }
+}
+
+void finishFrame()
+{
+    if (frameObserver) {
+        frameObserver(toMilliseconds(observedFrameNanoseconds));
+    }
+    observedFrameNanoseconds = 0;
+
+    if (!enabled()) {
+        return;
+    }
+
+    FrameStats stats;
+    for (size_t i = 0; i < sectionCounters.size(); i++) {
+        const auto section = static_cast<Section>(i);
+        stats.sectionMilliseconds.at(i) = toMilliseconds(counters(section).frameNanoseconds.exchange(0, std::memory_order_relaxed));
+        const auto calls = counters(section).frameCalls.exchange(0, std::memory_order_relaxed);
+        if (section == Section::NodePaint || section == Section::EdgePaint) {
+            stats.itemsPainted += calls;
+        }
+    }
+    stats.paintMilliseconds = stats.sectionMilliseconds.at(static_cast<size_t>(Section::View));
+    stats.shadowsDrawn = frameShadowsDrawn.exchange(0, std::memory_order_relaxed);
+
+    totalFrames++;
+    framesInFpsWindow++;
+    const auto now = Clock::now();
+    if (const auto elapsed = std::chrono::duration<double>(now - fpsWindowStart).count(); elapsed >= 1.0) {
+        stats.fps = framesInFpsWindow / elapsed;
+        framesInFpsWindow = 0;
+        fpsWindowStart = now;
+    } else {
+        stats.fps = lastFrameStats.fps;
+    }
+
+    lastFrameStats = stats;
+}
+
+void setFrameObserver(FrameObserver observer)
+{
+    frameObserver = observer;
+    frameObserved = static_cast<bool>(frameObserver);
+}
+
+FrameStats lastFrame()
+{
+    return lastFrameStats;
+}
+
+std::string report()
+{
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(3);
+    ss << "Frames: " << totalFrames << std::endl;
+    ss << "Shadows drawn: " << totalShadowsDrawn.load() << std::endl;
+    for (size_t i = 0; i < sectionCounters.size(); i++) {
+        const auto section = static_cast<Section>(i);
+        const auto calls = counters(section).totalCalls.load();
+        const auto milliseconds = toMilliseconds(counters(section).totalNanoseconds.load());
+        ss << sectionName(section) << ": " << calls << " calls, " << milliseconds << " ms total, " //
+           << (calls ? milliseconds / static_cast<double>(calls) : 0.0) << " ms average" << std::endl;
+    }
+    return ss.str();
+}
+
+void setReportFile(const std::string & fileName)
+{
+    reportFileName = fileName;
+}
+
+void writeReport()
+{
+    if (reportFileName.empty()) {
+        return;
+    }
+
+    if (std::ofstream file { reportFileName }; file) {
+        file << report();
+        juzzlin::L(TAG).info() << "Profiling report written to '" << reportFileName << "'";
+    } else {
+        juzzlin::L(TAG).error() << "Could not write profiling report to '" << reportFileName << "'";
+    }
+}
+
+} // namespace Profiler
@@ -0,0 +1,102 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+
+//! Optional instrumentation of the paint hot paths. The timers feed lock-free counters, so they can
+//! be left in place: when profiling is disabled a timer costs a single relaxed atomic load.
+namespace Profiler {
+
+enum class Section
+{
+    View,
+    Background,
+    Shadows,
+    NodePaint,
+    EdgePaint,
+    VisibleItems,
+    Count
+};
+
+bool enabled();
+
+void setEnabled(bool enabled);
+
+//! Measures the time from construction to destruction and adds it to the given section.
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(Section section);
+
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer &) = delete;
+
+    ScopedTimer & operator=(const ScopedTimer &) = delete;
+
+private:
+    Section m_section;
+
+    bool m_active;
+
+    std::chrono::steady_clock::time_point m_start;
+};
+
+void addShadowsDrawn(size_t count);
+
+struct FrameStats
+{
+    double fps = 0;
+
+    //! Total time spent in EditorView::paintEvent().
+    double paintMilliseconds = 0;
+
+    size_t itemsPainted = 0;
+
+    size_t shadowsDrawn = 0;
+
+    std::array<double, static_cast<size_t>(Section::Count)> sectionMilliseconds {};
+};
+
+//! Moves the counters of the current frame to lastFrame(). Called by the view after each paint.
+void finishFrame();
+
+using FrameObserver = std::function<void(double paintMilliseconds)>;
+
+//! Sets the function that finishFrame() calls with the paint time of each frame, also when profiling is disabled,
+//! e.g. for PerformanceProfile. Only the view section is then timed. Pass an empty function to stop observing.
+void setFrameObserver(FrameObserver observer);
+
+FrameStats lastFrame();
+
+//! \returns Totals and averages per section since profiling was enabled.
+std::string report();
+
+//! Sets the file that writeReport() writes to.
+void setReportFile(const std::string & fileName);
+
+//! Writes report() to the report file if one has been set.
+void writeReport();
+
+} // namespace Profiler
+
+#endif // PROFILER_HPP
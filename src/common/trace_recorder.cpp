@@ -0,0 +1,283 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "trace_recorder.hpp"
+
+#include "simple_logger.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+static const auto TAG = "TraceRecorder";
+
+namespace TraceRecorder {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Span
+{
+    const char * name = nullptr;
+
+    uint64_t startNanoseconds = 0;
+
+    uint64_t durationNanoseconds = 0;
+};
+
+constexpr size_t CHUNK_CAPACITY = 4096;
+
+//! Keeps the memory bounded when tracing a long session.
+constexpr size_t MAX_SPANS_PER_THREAD = 1'000'000;
+
+//! The owner thread fills the spans and publishes them by incrementing the count,
+//! so the reader sees only complete spans without any locking.
+struct Chunk
+{
+    std::array<Span, CHUNK_CAPACITY> spans;
+
+    std::atomic<size_t> count { 0 };
+
+    std::atomic<Chunk *> next { nullptr };
+};
+
+class ThreadBuffer
+{
+public:
+    explicit ThreadBuffer(size_t id)
+      : m_id(id)
+      , m_head(std::make_unique<Chunk>())
+      , m_tail(m_head.get())
+    {
+    }
+
+    ~ThreadBuffer()
+    {
+        auto chunk = m_head->next.load();
+        while (chunk) {
+            const auto next = chunk->next.load();
+            delete chunk;
+            chunk = next;
+        }
+    }
+
+    //! Only called by the owner thread.
+    void append(const Span & span)
+    {
+        if (m_spanCount.load(std::memory_order_relaxed) >= MAX_SPANS_PER_THREAD) {
+            m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        auto count = m_tail->count.load(std::memory_order_relaxed);
+        if (count == CHUNK_CAPACITY) {
+            const auto chunk = new Chunk;
+            m_tail->next.store(chunk, std::memory_order_release);
+            m_tail = chunk;
+            count = 0;
+        }
+
+        m_tail->spans.at(count) = span;
+        m_tail->count.store(count + 1, std::memory_order_release);
+        m_spanCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //! Can be called by any thread while the owner thread is appending.
+    template<typename Visitor>
+    void visit(Visitor && visitor) const
+    {
+        for (auto chunk = m_head.get(); chunk; chunk = chunk->next.load(std::memory_order_acquire)) {
+            const auto count = chunk->count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; i++) {
+                visitor(chunk->spans.at(i));
+            }
+        }
+    }
+
+    size_t id() const
+    {
+        return m_id;
+    }
+
+    size_t spanCount() const
+    {
+        return m_spanCount.load(std::memory_order_relaxed);
+    }
+
+    size_t droppedCount() const
+    {
+        return m_droppedCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    size_t m_id;
+
+    std::unique_ptr<Chunk> m_head;
+
+    Chunk * m_tail;
+
+    std::atomic<size_t> m_spanCount { 0 };
+
+    std::atomic<size_t> m_droppedCount { 0 };
+};
+
+std::atomic<bool> tracingEnabled { false };
+
+Clock::time_point traceStart = Clock::now();
+
+std::string outputFileName;
+
+// Only locked when a thread records its first span and when the trace is written
+std::mutex threadBuffersMutex;
+
+std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+
+ThreadBuffer & threadBuffer()
+{
+    thread_local ThreadBuffer * buffer = nullptr;
+    if (!buffer) {
+        const std::lock_guard<std::mutex> lock { threadBuffersMutex };
+        threadBuffers.push_back(std::make_unique<ThreadBuffer>(threadBuffers.size()));
+        buffer = threadBuffers.back().get();
+    }
+    return *buffer;
+}
+
+uint64_t nanosecondsSinceStart(Clock::time_point timePoint)
+{
+    return timePoint > traceStart ? static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(timePoint - traceStart).count()) : 0;
+}
+
+void writeMicroseconds(std::ostream & out, uint64_t nanoseconds)
+{
+    out << nanoseconds / 1000 << '.' << std::setw(3) << std::setfill('0') << nanoseconds % 1000;
+}
+
+void writeString(std::ostream & out, const char * string)
+{
+    out << '"';
+    for (auto c = string; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            out << '\\';
+        }
+        out << *c;
+    }
+    out << '"';
+}
+
+} // namespace
+
+bool enabled()
+{
+    return tracingEnabled.load(std::memory_order_relaxed);
+}
+
+void setOutputFile(const std::string & fileName)
+{
+    outputFileName = fileName;
+    traceStart = Clock::now();
+
+    // The thread that enables tracing is the main thread and gets the first id
+    threadBuffer();
+
+    tracingEnabled = true;
+}
+
+ScopedSpan::ScopedSpan(const char * name)
+  : m_name(name)
+  , m_active(TraceRecorder::enabled())
+{
+    if (m_active) {
+        m_start = Clock::now();
+    }
+}
+
+ScopedSpan::~ScopedSpan()
+{
+    if (m_active) {
+        const auto end = Clock::now();
+        threadBuffer().append({ m_name, nanosecondsSinceStart(m_start), static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - m_start).count()) });
+    }
+}
+
+size_t spanCount()
+{
+    const std::lock_guard<std::mutex> lock { threadBuffersMutex };
+    size_t count = 0;
+    for (auto && buffer : threadBuffers) {
+        count += buffer->spanCount();
+    }
+    return count;
+}
+
+std::string toJson()
+{
+    const std::lock_guard<std::mutex> lock { threadBuffersMutex };
+
+    std::ostringstream ss;
+    ss << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool isFirst = true;
+    const auto separator = [&] {
+        ss << (isFirst ? "\n" : ",\n");
+        isFirst = false;
+    };
+
+    for (auto && buffer : threadBuffers) {
+        separator();
+        ss << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id() //
+           << ",\"args\":{\"name\":\"" << (buffer->id() ? "Worker " + std::to_string(buffer->id()) : "Main") << "\"}}";
+
+        buffer->visit([&](const Span & span) {
+            separator();
+            ss << "{\"name\":";
+            writeString(ss, span.name);
+            ss << ",\"cat\":\"heimer\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id() << ",\"ts\":";
+            writeMicroseconds(ss, span.startNanoseconds);
+            ss << ",\"dur\":";
+            writeMicroseconds(ss, span.durationNanoseconds);
+            ss << "}";
+        });
+
+        if (const auto droppedCount = buffer->droppedCount()) {
+            juzzlin::L(TAG).warning() << "Dropped " << droppedCount << " spans of thread " << buffer->id();
+        }
+    }
+
+    ss << "\n]}\n";
+    return ss.str();
+}
+
+void writeTrace()
+{
+    if (outputFileName.empty()) {
+        return;
+    }
+
+    if (std::ofstream file { outputFileName }; file) {
+        file << toJson();
+        juzzlin::L(TAG).info() << "Trace events written to '" << outputFileName << "'";
+    } else {
+        juzzlin::L(TAG).error() << "Could not write trace events to '" << outputFileName << "'";
+    }
+}
+
+} // namespace TraceRecorder
@@ -0,0 +1,66 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TRACE_RECORDER_HPP
+#define TRACE_RECORDER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+//! Records timelines of the hot operations, e.g. opening, saving and layout optimization, and writes them
+//! in the Chrome trace event format, which chrome://tracing and https://ui.perfetto.dev can show.
+//! Each thread appends to its own buffer without locks, and the buffers are only read by writeTrace().
+//! When tracing is disabled a span costs a single relaxed atomic load.
+namespace TraceRecorder {
+
+bool enabled();
+
+//! Enables tracing and sets the file that writeTrace() writes to.
+void setOutputFile(const std::string & fileName);
+
+//! Records the time from construction to destruction as a span of the calling thread.
+class ScopedSpan
+{
+public:
+    //! \param name Must outlive the recorder, e.g. a string literal, as only the pointer is stored.
+    explicit ScopedSpan(const char * name);
+
+    ~ScopedSpan();
+
+    ScopedSpan(const ScopedSpan &) = delete;
+
+    ScopedSpan & operator=(const ScopedSpan &) = delete;
+
+private:
+    const char * m_name;
+
+    bool m_active;
+
+    std::chrono::steady_clock::time_point m_start;
+};
+
+//! \returns Number of spans recorded by all threads so far.
+size_t spanCount();
+
+//! \returns The recorded spans as Chrome trace JSON.
+std::string toJson();
+
+//! Writes toJson() to the output file if one has been set. Threads may still be recording.
+void writeTrace();
+
+} // namespace TraceRecorder
+
+#endif // TRACE_RECORDER_HPP
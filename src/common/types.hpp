@@ -21,6 +21,9 @@
 class ApplicationService;
 using ApplicationServiceS = std::shared_ptr<ApplicationService>;
 
+class CacheRegistry;
+using CacheRegistryS = std::shared_ptr<CacheRegistry>;
+
 class ControlStrategy;
 
 using ControlStrategyS = std::shared_ptr<ControlStrategy>;
@@ -88,6 +91,21 @@ using RecentFilesManagerS = std::shared_ptr<RecentFilesManager>;
 
 using SettingsProxyS = std::shared_ptr<SettingsProxy>;
 
+struct SettingsSnapshot;
+using SettingsSnapshotS = std::shared_ptr<const SettingsSnapshot>;
+
+class GuiJobScheduler;
+using GuiJobSchedulerS = std::shared_ptr<GuiJobScheduler>;
+
+class TaskPool;
+using TaskPoolS = std::shared_ptr<TaskPool>;
+
+class ThumbnailCache;
+using ThumbnailCacheS = std::shared_ptr<ThumbnailCache>;
+
+class WorkspaceIndex;
+using WorkspaceIndexS = std::shared_ptr<WorkspaceIndex>;
+
 class ServiceContainer;
 using SC = ServiceContainer;
 
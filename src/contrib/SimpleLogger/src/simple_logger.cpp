@@ -24,7 +24,10 @@
 
 #include "simple_logger.hpp"
 
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstdlib>
 #include <ctime>
 #include <fstream>
 #include <iomanip>
@@ -32,14 +35,264 @@
 #include <map>
 #include <mutex>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 namespace juzzlin {
 
-class SimpleLogger::Impl
+//! Bounded multi-producer single-consumer ring buffer (Vyukov) of formatted messages drained by a
+//! background thread. Producers never take a lock unless the consumer is sleeping or they wait
+//! for their message to be written.
+class AsyncWriter
 {
 public:
-    Impl();
+    using WriteFunction = void (*)(SimpleLogger::Level, const std::string &);
+
+    //! Flushes the streams of the levels set in the given bit mask.
+    using FlushFunction = void (*)(unsigned int);
+
+    AsyncWriter(WriteFunction writeFunction, FlushFunction flushFunction);
+
+    ~AsyncWriter();
+
+    bool isRunning() const;
+
+    //! \param wait Return only after the message has been written and flushed.
+    //! \returns false if the writer is not running and the message has to be written directly.
+    bool push(SimpleLogger::Level level, std::string && message, bool wait);
+
+    void start();
+
+    void stop();
+
+private:
+    struct Record
+    {
+        SimpleLogger::Level level = SimpleLogger::Level::Info;
+
+        std::string message;
+    };
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+
+        Record record;
+    };
+
+    bool tryPush(Record & record, size_t & position);
+
+    //! Consumer side only.
+    bool hasPending() const;
+
+    //! Consumer side only.
+    bool tryPop(Record & record);
+
+    //! Consumer side only.
+    size_t drain();
+
+    void run();
+
+    static constexpr size_t Capacity = 8192;
+
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    WriteFunction m_writeFunction;
+
+    FlushFunction m_flushFunction;
+
+    std::unique_ptr<Cell[]> m_cells;
+
+    std::atomic<size_t> m_enqueuePosition { 0 };
+
+    size_t m_dequeuePosition = 0;
+
+    //! Position up to which the messages have been written and flushed.
+    std::atomic<size_t> m_flushedPosition { 0 };
+
+    std::mutex m_flushMutex;
+
+    std::condition_variable m_flushCondition;
+
+    std::atomic<bool> m_running { false };
+
+    std::atomic<size_t> m_activeProducers { 0 };
+
+    std::atomic<bool> m_sleeping { false };
+
+    std::mutex m_wakeMutex;
+
+    std::condition_variable m_wakeCondition;
+
+    std::thread m_thread;
+};
+
+AsyncWriter::AsyncWriter(WriteFunction writeFunction, FlushFunction flushFunction)
+  : m_writeFunction(writeFunction)
+  , m_flushFunction(flushFunction)
+  , m_cells(std::make_unique<Cell[]>(Capacity))
+{
+    for (size_t i = 0; i < Capacity; i++) {
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+AsyncWriter::~AsyncWriter()
+{
+    stop();
+}
+
+bool AsyncWriter::isRunning() const
+{
+    return m_running.load(std::memory_order_acquire);
+}
+
+bool AsyncWriter::push(SimpleLogger::Level level, std::string && message, bool wait)
+{
+    // Together with stop() this is a store-load handshake: either stop() sees this producer
+    // or this producer sees that the writer has stopped. That requires sequential consistency.
+    m_activeProducers.fetch_add(1, std::memory_order_seq_cst);
+    if (!m_running.load(std::memory_order_seq_cst)) {
+        m_activeProducers.fetch_sub(1, std::memory_order_seq_cst);
+        return false;
+    }
+
+    Record record { level, std::move(message) };
+    size_t position = 0;
+    while (!tryPush(record, position)) {
+        // Buffer is full: make sure the consumer is awake and back off.
+        m_wakeCondition.notify_one();
+        std::this_thread::yield();
+    }
+
+    // Pairs with the fence in run(): either the consumer sees the message before it goes to sleep
+    // or this producer sees it sleeping and wakes it up.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_sleeping.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_wakeCondition.notify_one();
+    }
+
+    if (wait) {
+        std::unique_lock<std::mutex> lock(m_flushMutex);
+        m_flushCondition.wait(lock, [this, position] {
+            return m_flushedPosition.load(std::memory_order_acquire) > position;
+        });
+    }
+
+    m_activeProducers.fetch_sub(1, std::memory_order_seq_cst);
+    return true;
+}
+
+bool AsyncWriter::tryPush(Record & record, size_t & pushPosition)
+{
+    auto position = m_enqueuePosition.load(std::memory_order_relaxed);
+    while (true) {
+        auto && cell = m_cells[position & (Capacity - 1)];
+        const auto sequence = cell.sequence.load(std::memory_order_acquire);
+        const auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+        if (difference == 0) {
+            if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                cell.record = std::move(record);
+                cell.sequence.store(position + 1, std::memory_order_release);
+                pushPosition = position;
+                return true;
+            }
+        } else if (difference < 0) {
+            return false;
+        } else {
+            position = m_enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool AsyncWriter::hasPending() const
+{
+    return m_cells[m_dequeuePosition & (Capacity - 1)].sequence.load(std::memory_order_acquire) == m_dequeuePosition + 1;
+}
+
+bool AsyncWriter::tryPop(Record & record)
+{
+    auto && cell = m_cells[m_dequeuePosition & (Capacity - 1)];
+    if (cell.sequence.load(std::memory_order_acquire) != m_dequeuePosition + 1) {
+        return false;
+    }
+
+    record = std::move(cell.record);
+    cell.sequence.store(m_dequeuePosition + Capacity, std::memory_order_release);
+    m_dequeuePosition++;
+    return true;
+}
+
+size_t AsyncWriter::drain()
+{
+    size_t count = 0;
+    unsigned int levelMask = 0;
+    Record record;
+    while (tryPop(record)) {
+        m_writeFunction(record.level, record.message);
+        levelMask |= 1u << static_cast<unsigned int>(record.level);
+        count++;
+    }
+
+    if (count) {
+        m_flushFunction(levelMask);
+        {
+            std::lock_guard<std::mutex> lock(m_flushMutex);
+            m_flushedPosition.store(m_dequeuePosition, std::memory_order_release);
+        }
+        m_flushCondition.notify_all();
+    }
 
+    return count;
+}
+
+void AsyncWriter::run()
+{
+    while (isRunning()) {
+        if (!drain()) {
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            m_sleeping.store(true, std::memory_order_relaxed);
+            // Pairs with the fence in push()
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!hasPending() && isRunning()) {
+                m_wakeCondition.wait_for(lock, std::chrono::milliseconds(50));
+            }
+            m_sleeping.store(false, std::memory_order_relaxed);
+        }
+    }
+}
+
+void AsyncWriter::start()
+{
+    if (!isRunning()) {
+        m_running.store(true, std::memory_order_release);
+        m_thread = std::thread(&AsyncWriter::run, this);
+    }
+}
+
+void AsyncWriter::stop()
+{
+    if (isRunning()) {
+        m_running.store(false, std::memory_order_seq_cst);
+        {
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            m_wakeCondition.notify_one();
+        }
+        m_thread.join();
+        // Producers that saw the writer running may still be pushing, possibly into a full buffer.
+        while (m_activeProducers.load(std::memory_order_seq_cst)) {
+            if (!drain()) {
+                std::this_thread::yield();
+            }
+        }
+        drain();
+    }
+}
+
+class SimpleLogger::Impl
+{
+public:
     Impl(const std::string & tag);
 
     ~Impl();
@@ -58,6 +311,12 @@ public:
 
     static void enableEchoMode(bool enable);
 
+    static void enableAsyncMode(bool enable);
+
+    static void shutdown();
+
+    static bool isLevelEnabled(SimpleLogger::Level level);
+
     static void setLevelSymbol(SimpleLogger::Level level, std::string symbol);
 
     static void setLoggingLevel(SimpleLogger::Level level);
@@ -77,11 +336,13 @@ public:
     std::ostringstream & prepareStreamForLoggingLevel(SimpleLogger::Level level);
 
 private:
-    std::string currentDateTime(std::chrono::time_point<std::chrono::system_clock> now, const std::string & dateTimeFormat) const;
+    static AsyncWriter & asyncWriter();
+
+    static void writeMessage(SimpleLogger::Level level, const std::string & message);
 
-    void flushFileIfOpen();
+    static void flushStreams(unsigned int levelMask);
 
-    void flushEchoIfEnabled();
+    std::string currentDateTime(std::chrono::time_point<std::chrono::system_clock> now, const std::string & dateTimeFormat) const;
 
     void prefixWithLevelAndTag(SimpleLogger::Level level);
 
@@ -91,7 +352,7 @@ private:
 
     static bool m_echoMode;
 
-    static SimpleLogger::Level m_level;
+    static std::atomic<SimpleLogger::Level> m_level;
 
     static SimpleLogger::TimestampMode m_timestampMode;
 
@@ -111,8 +372,6 @@ private:
 
     SimpleLogger::Level m_activeLevel = SimpleLogger::Level::Info;
 
-    std::lock_guard<std::recursive_mutex> m_lock;
-
     std::string m_tag;
 
     std::ostringstream m_message;
@@ -120,7 +379,7 @@ private:
 
 bool SimpleLogger::Impl::m_echoMode = true;
 
-SimpleLogger::Level SimpleLogger::Impl::m_level = SimpleLogger::Level::Info;
+std::atomic<SimpleLogger::Level> SimpleLogger::Impl::m_level = SimpleLogger::Level::Info;
 
 SimpleLogger::TimestampMode SimpleLogger::Impl::m_timestampMode = SimpleLogger::TimestampMode::DateTime;
 
@@ -152,14 +411,8 @@ SimpleLogger::Impl::StreamMap SimpleLogger::Impl::m_streams = {
 
 std::recursive_mutex SimpleLogger::Impl::m_mutex;
 
-SimpleLogger::Impl::Impl()
-  : m_lock(m_mutex)
-{
-}
-
 SimpleLogger::Impl::Impl(const std::string & tag)
-  : m_lock(m_mutex)
-  , m_tag(tag)
+  : m_tag(tag)
 {
 }
 
@@ -170,9 +423,41 @@ SimpleLogger::Impl::~Impl()
 
 void SimpleLogger::Impl::enableEchoMode(bool enable)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
     m_echoMode = enable;
 }
 
+AsyncWriter & SimpleLogger::Impl::asyncWriter()
+{
+    // Intentionally never destroyed, so that loggers used by other static destructors still find it.
+    // The thread is stopped by shutdown().
+    static const auto asyncWriter = new AsyncWriter(&SimpleLogger::Impl::writeMessage, &SimpleLogger::Impl::flushStreams);
+    return *asyncWriter;
+}
+
+void SimpleLogger::Impl::enableAsyncMode(bool enable)
+{
+    if (enable) {
+        // The streams were constructed before the handler is registered, so it runs before they are destroyed
+        static const auto exitHandlerResult = std::atexit(&SimpleLogger::Impl::shutdown);
+        static_cast<void>(exitHandlerResult);
+        asyncWriter().start();
+    } else {
+        asyncWriter().stop();
+    }
+}
+
+void SimpleLogger::Impl::shutdown()
+{
+    // Each written batch has already been flushed
+    asyncWriter().stop();
+}
+
+bool SimpleLogger::Impl::isLevelEnabled(SimpleLogger::Level level)
+{
+    return level >= m_level.load(std::memory_order_relaxed);
+}
+
 std::ostringstream & SimpleLogger::Impl::prepareStreamForLoggingLevel(SimpleLogger::Level level)
 {
     m_activeLevel = level;
@@ -183,6 +468,7 @@ std::ostringstream & SimpleLogger::Impl::prepareStreamForLoggingLevel(SimpleLogg
 
 void SimpleLogger::Impl::setLevelSymbol(Level level, std::string symbol)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
     m_symbols[level] = symbol;
 }
 
@@ -193,16 +479,19 @@ void SimpleLogger::Impl::setLoggingLevel(SimpleLogger::Level level)
 
 void SimpleLogger::Impl::setCustomTimestampFormat(std::string customTimestampFormat)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
     m_customTimestampFormat = customTimestampFormat;
 }
 
 void SimpleLogger::Impl::setTimestampMode(TimestampMode timestampMode)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
     m_timestampMode = timestampMode;
 }
 
 void SimpleLogger::Impl::setTimestampSeparator(std::string separator)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
     m_timestampSeparator = separator;
 }
 
@@ -217,11 +506,14 @@ std::string SimpleLogger::Impl::currentDateTime(std::chrono::time_point<std::chr
 
 void SimpleLogger::Impl::prefixWithLevelAndTag(SimpleLogger::Level level)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
     m_message << m_symbols[level] << (!m_tag.empty() ? " " + m_tag + ":" : "") << " ";
 }
 
 void SimpleLogger::Impl::prefixWithTimestamp()
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
     std::string timestamp;
 
     using std::chrono::duration_cast;
@@ -259,23 +551,37 @@ void SimpleLogger::Impl::prefixWithTimestamp()
 
 bool SimpleLogger::Impl::shouldFlush() const
 {
-    return m_activeLevel >= m_level && !m_message.str().empty();
+    return isLevelEnabled(m_activeLevel) && !m_message.str().empty();
 }
 
-void SimpleLogger::Impl::flushFileIfOpen()
+void SimpleLogger::Impl::writeMessage(SimpleLogger::Level level, const std::string & message)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
     if (m_fileStream.is_open()) {
-        m_fileStream << m_message.str() << std::endl;
-        m_fileStream.flush();
+        m_fileStream << message << '\n';
+    }
+
+    if (m_echoMode) {
+        if (auto && stream = m_streams[level]; stream) {
+            *stream << message << '\n';
+        }
     }
 }
 
-void SimpleLogger::Impl::flushEchoIfEnabled()
+void SimpleLogger::Impl::flushStreams(unsigned int levelMask)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+    if (m_fileStream.is_open()) {
+        m_fileStream.flush();
+    }
+
     if (m_echoMode) {
-        if (auto && stream = m_streams[m_activeLevel]; stream) {
-            *stream << m_message.str() << std::endl;
-            stream->flush();
+        for (auto && stream : m_streams) {
+            if (stream.second && (levelMask & (1u << static_cast<unsigned int>(stream.first)))) {
+                stream.second->flush();
+            }
         }
     }
 }
@@ -283,13 +589,19 @@ void SimpleLogger::Impl::flushEchoIfEnabled()
 void SimpleLogger::Impl::flush()
 {
     if (shouldFlush()) {
-        flushFileIfOpen();
-        flushEchoIfEnabled();
+        // Errors are written before returning, as the program may be about to crash or abort
+        const bool wait = m_activeLevel >= SimpleLogger::Level::Error;
+        if (!asyncWriter().push(m_activeLevel, m_message.str(), wait)) {
+            std::lock_guard<std::recursive_mutex> lock(m_mutex);
+            writeMessage(m_activeLevel, m_message.str());
+            flushStreams(1u << static_cast<unsigned int>(m_activeLevel));
+        }
     }
 }
 
 void SimpleLogger::Impl::initialize(std::string filename, bool append)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
     if (!filename.empty()) {
         m_fileStream.open(filename, append ? std::ofstream::out | std::ofstream::app : std::ofstream::out);
         if (!m_fileStream.is_open()) {
@@ -330,17 +642,43 @@ std::ostringstream & SimpleLogger::Impl::fatalStream()
 
 void SimpleLogger::Impl::setStream(Level level, std::ostream & stream)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
     m_streams[level] = &stream;
 }
 
-SimpleLogger::SimpleLogger()
-  : m_impl(std::make_unique<SimpleLogger::Impl>())
+SimpleLogger::SimpleLogger() = default;
+
+SimpleLogger::SimpleLogger(const std::string & tag)
+  : m_tag(tag)
 {
 }
 
-SimpleLogger::SimpleLogger(const std::string & tag)
-  : m_impl(std::make_unique<SimpleLogger::Impl>(tag))
+std::ostringstream & SimpleLogger::prepareStream(Level level)
 {
+    if (!Impl::isLevelEnabled(level)) {
+        // Nothing gets formatted into a failed stream
+        static thread_local std::ostringstream discardStream;
+        discardStream.setstate(std::ios_base::badbit);
+        return discardStream;
+    }
+
+    m_impl = std::make_unique<SimpleLogger::Impl>(m_tag);
+    switch (level) {
+    case Level::Trace:
+        return m_impl->traceStream();
+    case Level::Debug:
+        return m_impl->debugStream();
+    case Level::Info:
+        return m_impl->infoStream();
+    case Level::Warning:
+        return m_impl->warningStream();
+    case Level::Error:
+        return m_impl->errorStream();
+    case Level::Fatal:
+    case Level::None:
+        break;
+    }
+    return m_impl->fatalStream();
 }
 
 void SimpleLogger::initialize(std::string filename, bool append)
@@ -353,6 +691,16 @@ void SimpleLogger::enableEchoMode(bool enable)
     Impl::enableEchoMode(enable);
 }
 
+void SimpleLogger::enableAsyncMode(bool enable)
+{
+    Impl::enableAsyncMode(enable);
+}
+
+void SimpleLogger::shutdown()
+{
+    Impl::shutdown();
+}
+
 void SimpleLogger::setLoggingLevel(Level level)
 {
     Impl::setLoggingLevel(level);
@@ -386,37 +734,37 @@ void SimpleLogger::setStream(Level level, std::ostream & stream)
 
 std::ostringstream & SimpleLogger::trace()
 {
-    return m_impl->traceStream();
+    return prepareStream(Level::Trace);
 }
 
 std::ostringstream & SimpleLogger::debug()
 {
-    return m_impl->debugStream();
+    return prepareStream(Level::Debug);
 }
 
 std::ostringstream & SimpleLogger::info()
 {
-    return m_impl->infoStream();
+    return prepareStream(Level::Info);
 }
 
 std::ostringstream & SimpleLogger::warning()
 {
-    return m_impl->warningStream();
+    return prepareStream(Level::Warning);
 }
 
 std::ostringstream & SimpleLogger::error()
 {
-    return m_impl->errorStream();
+    return prepareStream(Level::Error);
 }
 
 std::ostringstream & SimpleLogger::fatal()
 {
-    return m_impl->fatalStream();
+    return prepareStream(Level::Fatal);
 }
 
 std::string SimpleLogger::version()
 {
-    return "2.0.0";
+    return "2.1.0";
 }
 
 SimpleLogger::~SimpleLogger() = default;
@@ -27,6 +27,7 @@
 
 #include <memory>
 #include <sstream>
+#include <string>
 
 namespace juzzlin {
 
@@ -41,6 +42,9 @@ namespace juzzlin {
  *
  * L().info() << "Initialization finished.";
  * L().error() << "Foo happened!";
+ *
+ * Messages below the logging level are discarded before any message
+ * stream gets constructed.
  */
 class SimpleLogger
 {
@@ -87,6 +91,17 @@ public:
     //! \param enable Echo everything if true. Default is false.
     static void enableEchoMode(bool enable);
 
+    //! Enable/disable asynchronous mode. In asynchronous mode formatted messages are pushed into
+    //! a lock-free ring buffer and written and flushed by a background thread. Errors and fatals
+    //! are still written before the logger returns. Disabling waits until all pending messages
+    //! have been written.
+    //! \param enable Write asynchronously if true. Default is false.
+    static void enableAsyncMode(bool enable);
+
+    //! Write all pending messages, stop the background thread of the asynchronous mode and flush
+    //! the streams. Messages logged after this are written synchronously. Also done at exit.
+    static void shutdown();
+
     //! Set the logging level.
     //! \param level The minimum level. Default is Info.
     static void setLoggingLevel(Level level);
@@ -138,8 +153,12 @@ private:
     SimpleLogger(const SimpleLogger &) = delete;
     SimpleLogger & operator=(const SimpleLogger &) = delete;
 
+    std::ostringstream & prepareStream(Level level);
+
     class Impl;
     std::unique_ptr<Impl> m_impl;
+
+    std::string m_tag;
 };
 
 using L = SimpleLogger;
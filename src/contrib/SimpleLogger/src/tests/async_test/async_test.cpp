@@ -0,0 +1,174 @@
+// MIT License
+//
+// Copyright (c) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// https://github.com/juzzlin/SimpleLogger
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "../../simple_logger.hpp"
+
+// Don't compile asserts away
+#ifdef NDEBUG
+#undef NDEBUG
+#endif
+
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace juzzlin::AsyncTest {
+
+size_t countOccurrences(const std::string & text, const std::string & pattern)
+{
+    size_t count = 0;
+    for (auto position = text.find(pattern); position != std::string::npos; position = text.find(pattern, position + pattern.size())) {
+        count++;
+    }
+    return count;
+}
+
+void testAsyncMode_singleThread_shouldPrintAllMessagesInOrder()
+{
+    std::stringstream ss;
+    L::setStream(L::Level::Info, ss);
+    L::setLoggingLevel(L::Level::Info);
+    L::enableAsyncMode(true);
+    for (int i = 0; i < 100; i++) {
+        L().info() << "Message " << i << ";";
+    }
+    L::enableAsyncMode(false);
+
+    size_t previous = 0;
+    for (int i = 0; i < 100; i++) {
+        const auto position = ss.str().find("Message " + std::to_string(i) + ";");
+        if (position == std::string::npos || position < previous) {
+            throw std::runtime_error("ERROR!!: Message " + std::to_string(i) + " missing or out of order in '" + ss.str() + "'");
+        }
+        previous = position;
+    }
+}
+
+void testAsyncMode_multipleThreads_shouldPrintAllMessages()
+{
+    std::stringstream ss;
+    L::setStream(L::Level::Info, ss);
+    L::setLoggingLevel(L::Level::Info);
+    L::enableAsyncMode(true);
+
+    // Enough messages to wrap around the ring buffer a few times
+    const int threadCount = 4;
+    const int messageCount = 10000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([messageCount] {
+            for (int i = 0; i < messageCount; i++) {
+                L("TAG").info() << "Async message";
+            }
+        });
+    }
+    for (auto && thread : threads) {
+        thread.join();
+    }
+    L::enableAsyncMode(false);
+
+    assert(countOccurrences(ss.str(), "TAG: Async message") == static_cast<size_t>(threadCount * messageCount));
+}
+
+void testAsyncMode_higherLoggingLevel_shouldNotPrintMessage()
+{
+    std::stringstream ss;
+    L::setStream(L::Level::Debug, ss);
+    L::setLoggingLevel(L::Level::Info);
+    L::enableAsyncMode(true);
+    L().debug() << "Debug message";
+    L::enableAsyncMode(false);
+
+    assert(ss.str().empty());
+}
+
+void testAsyncMode_error_shouldBeWrittenBeforeReturning()
+{
+    std::stringstream ss;
+    L::setStream(L::Level::Info, ss);
+    L::setStream(L::Level::Error, ss);
+    L::setLoggingLevel(L::Level::Info);
+    L::enableAsyncMode(true);
+    L().info() << "Info message";
+    L().error() << "Error message";
+
+    // The pending info message is written first
+    const auto text = ss.str();
+    const auto infoPosition = text.find("Info message");
+    const auto errorPosition = text.find("Error message");
+    L::enableAsyncMode(false);
+    L::setStream(L::Level::Error, std::cerr);
+
+    assert(infoPosition != std::string::npos);
+    assert(errorPosition != std::string::npos);
+    assert(infoPosition < errorPosition);
+}
+
+void testShutdown_shouldWritePendingMessages()
+{
+    std::stringstream ss;
+    L::setStream(L::Level::Info, ss);
+    L::setLoggingLevel(L::Level::Info);
+    L::enableAsyncMode(true);
+    for (int i = 0; i < 1000; i++) {
+        L().info() << "Pending message";
+    }
+    L::shutdown();
+
+    assert(countOccurrences(ss.str(), "Pending message") == 1000);
+
+    // Written synchronously after the shutdown
+    L().info() << "Late message";
+    assert(countOccurrences(ss.str(), "Late message") == 1);
+}
+
+void runTests()
+{
+    L::enableEchoMode(true);
+    L::setTimestampMode(L::TimestampMode::None);
+
+    testAsyncMode_singleThread_shouldPrintAllMessagesInOrder();
+
+    testAsyncMode_multipleThreads_shouldPrintAllMessages();
+
+    testAsyncMode_higherLoggingLevel_shouldNotPrintMessage();
+
+    testAsyncMode_error_shouldBeWrittenBeforeReturning();
+
+    testShutdown_shouldWritePendingMessages();
+}
+
+} // namespace juzzlin::AsyncTest
+
+int main()
+{
+    juzzlin::AsyncTest::runTests();
+
+    return EXIT_SUCCESS;
+}
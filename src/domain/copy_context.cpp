@@ -16,12 +16,26 @@
 #include "copy_context.hpp"
 
 #include "../domain/graph.hpp"
+#include "../domain/image_manager.hpp"
 #include "../view/scene_items/node.hpp"
 
 #include "simple_logger.hpp"
 
+#include <QDataStream>
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <unordered_set>
+
 static const auto TAG = "CopyContext";
 
+namespace {
+const quint32 serializationMagic = 0x484d5347; // "HMSG"
+
+const quint32 serializationVersion = 1;
+} // namespace
+
 CopyContext::CopyContext() = default;
 
 void CopyContext::clear()
@@ -34,33 +48,50 @@ size_t CopyContext::copyStackSize() const
     return m_copiedData.nodes.size();
 }
 
+MemoryUsage CopyContext::memoryUsage() const
+{
+    MemoryUsage usage { m_copiedData.nodes.size() + m_copiedData.edges.size() + m_copiedData.images.size(),
+                        GraphSnapshot::estimatedNodesSize(m_copiedData.nodes) + GraphSnapshot::estimatedEdgesSize(m_copiedData.edges) };
+    for (auto && image : m_copiedData.images) {
+        usage.bytes += image.estimatedSize();
+    }
+    return usage;
+}
+
 void CopyContext::pushEdges(NodePVector nodes, GraphCR graph)
 {
-    // Test all nodes against each other
-    for (size_t i = 0; i < nodes.size(); i++) {
-        for (size_t j = i + 1; j < nodes.size(); j++) {
-            // Check if the nodes are directly connected
-            int i0 = nodes.at(i)->index();
-            int i1 = nodes.at(j)->index();
-            if (const auto edge = graph.getEdge(i0, i1)) {
-                m_copiedData.edges.push_back({ std::make_shared<SceneItems::Edge>(*edge), i0, i1 });
-            }
-            // Same as above, but to the other direction
-            i0 = nodes.at(j)->index();
-            i1 = nodes.at(i)->index();
-            if (const auto edge = graph.getEdge(i0, i1)) {
-                m_copiedData.edges.push_back({ std::make_shared<SceneItems::Edge>(*edge), i0, i1 });
+    std::unordered_set<int> selectedIndices;
+    for (auto && node : nodes) {
+        selectedIndices.insert(node->index());
+    }
+
+    // Every edge between the selected nodes is an outgoing edge of exactly one of them,
+    // so walking the outgoing adjacency costs O(nodes + edges) and finds each edge once
+    for (auto && node : nodes) {
+        for (auto && edge : graph.edgesFromNode(node->index())) {
+            if (const auto targetIndex = edge->targetNode().index(); selectedIndices.count(targetIndex)) {
+                m_copiedData.edges.push_back({ edge->model(), node->index(), targetIndex });
             }
         }
     }
 }
 
-void CopyContext::push(NodePVector nodes, GraphCR graph)
+void CopyContext::push(NodePVector nodes, GraphCR graph, ImageManager & imageManager)
 {
     pushEdges(nodes, graph);
 
+    std::set<size_t> imageRefs;
     for (auto && node : nodes) {
         push(*node);
+        if (node->imageRef()) {
+            imageRefs.insert(node->imageRef());
+        }
+    }
+
+    for (auto && imageRef : imageRefs) {
+        if (const auto image = imageManager.getImage(imageRef); image) {
+            m_copiedData.images.push_back(*image);
+        }
     }
 
     juzzlin::L(TAG).debug() << m_copiedData.edges.size() << " edge(s) in copy stack";
@@ -69,13 +100,95 @@ void CopyContext::push(NodePVector nodes, GraphCR graph)
 
 void CopyContext::push(NodeCR node)
 {
-    m_copiedData.nodes.push_back(std::make_shared<SceneItems::Node>(node));
+    m_copiedData.nodes.push_back(node.model());
     m_copiedData.copyReferencePoint *= static_cast<qreal>(m_copiedData.nodes.size() - 1);
     m_copiedData.copyReferencePoint += node.pos();
     m_copiedData.copyReferencePoint /= static_cast<qreal>(m_copiedData.nodes.size());
 }
 
-CopyContext::CopiedData CopyContext::copiedData() const
+const CopyContext::CopiedData & CopyContext::copiedData() const
 {
     return m_copiedData;
 }
+
+QByteArray CopyContext::serialize() const
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out << serializationMagic << serializationVersion;
+    out << m_copiedData.copyReferencePoint;
+    out << GraphSnapshot { m_copiedData.nodes, m_copiedData.edges }.toCompressedData();
+
+    // Images that have identical content are stored only once and referred to by their content
+    std::vector<std::pair<QByteArray, std::vector<size_t>>> distinctImages;
+    for (auto && image : m_copiedData.images) {
+        const auto imageData = image.data();
+        const auto iter = std::find_if(distinctImages.begin(), distinctImages.end(), [&imageData](auto && distinctImage) {
+            return distinctImage.first == imageData;
+        });
+        if (iter != distinctImages.end()) {
+            iter->second.push_back(image.id());
+        } else {
+            distinctImages.push_back({ imageData, { image.id() } });
+        }
+    }
+
+    out << static_cast<quint32>(distinctImages.size());
+    for (auto && distinctImage : distinctImages) {
+        out << distinctImage.first;
+        out << static_cast<quint32>(distinctImage.second.size());
+        for (auto && id : distinctImage.second) {
+            out << static_cast<quint64>(id);
+        }
+    }
+
+    return data;
+}
+
+bool CopyContext::deserialize(const QByteArray & data)
+{
+    QDataStream in(data);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (magic != serializationMagic || version != serializationVersion) {
+        juzzlin::L(TAG).warning() << "Unsupported clipboard data";
+        return false;
+    }
+
+    CopiedData copiedData;
+    in >> copiedData.copyReferencePoint;
+
+    QByteArray compressedGraph;
+    in >> compressedGraph;
+    auto snapshot = GraphSnapshot::fromCompressedData(compressedGraph);
+    copiedData.nodes = snapshot.nodes();
+    copiedData.edges = snapshot.edges();
+
+    quint32 imageCount = 0;
+    in >> imageCount;
+    for (quint32 i = 0; i < imageCount && in.status() == QDataStream::Ok; i++) {
+        QByteArray imageData;
+        quint32 idCount = 0;
+        in >> imageData >> idCount;
+        // Decoded once, the copies share the decoded image
+        const auto image = Image::fromEncodedData(imageData, "clipboard-image-" + std::to_string(i) + ".png");
+        for (quint32 j = 0; j < idCount && in.status() == QDataStream::Ok; j++) {
+            quint64 id = 0;
+            in >> id;
+            copiedData.images.push_back(image);
+            copiedData.images.back().setId(static_cast<size_t>(id));
+        }
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        juzzlin::L(TAG).warning() << "Corrupted clipboard data";
+        return false;
+    }
+
+    m_copiedData = std::move(copiedData);
+
+    juzzlin::L(TAG).debug() << m_copiedData.nodes.size() << " node(s) and " << m_copiedData.edges.size() << " edge(s) read from clipboard";
+
+    return true;
+}
@@ -18,9 +18,15 @@
 
 #include <vector>
 
+#include <QByteArray>
 #include <QPointF>
 
 #include "../common/types.hpp"
+#include "graph_snapshot.hpp"
+#include "image.hpp"
+#include "memory_usage.hpp"
+
+class ImageManager;
 
 class CopyContext
 {
@@ -32,31 +38,17 @@ public:
     size_t copyStackSize() const;
 
     using NodePVector = std::vector<NodeP>;
-    void push(NodePVector nodes, GraphCR graph);
+    //! Copies the given nodes, the edges between them and the images they refer to.
+    void push(NodePVector nodes, GraphCR graph, ImageManager & imageManager);
     void push(NodeCR node);
 
-    //! Store node indices into a separate metadata structure
-    //! because Edge instances currently need references to
-    //! the actual node instances and we are working with copies
-    //! here..
-    struct EdgeMetadata
-    {
-        EdgeMetadata(EdgeS edge, int sourceNodeIndex, int targetNodeIndex)
-          : edge(edge)
-          , sourceNodeIndex(sourceNodeIndex)
-          , targetNodeIndex(targetNodeIndex)
-        {
-        }
-
-        EdgeS edge;
-
-        int sourceNodeIndex = -1;
-
-        int targetNodeIndex = -1;
-    };
+    //! Edges are stored as plain data with node indices, because Edge instances
+    //! need references to the actual node instances and we are working with copies here.
+    using EdgeVector = GraphSnapshot::EdgeDataVector;
+    //! Nodes are stored as plain data, scene items get created only when pasting.
+    using NodeVector = GraphSnapshot::NodeDataVector;
 
-    using EdgeVector = std::vector<EdgeMetadata>;
-    using NodeVector = std::vector<NodeS>;
+    using ImageVector = std::vector<Image>;
 
     struct CopiedData
     {
@@ -65,9 +57,23 @@ public:
         EdgeVector edges;
 
         NodeVector nodes;
+
+        //! Images referred to by the copied nodes. The ids are the ones of the source mind map.
+        ImageVector images;
     };
 
-    CopiedData copiedData() const;
+    const CopiedData & copiedData() const;
+
+    //! \returns Item count and estimated memory usage of the copied nodes, edges and images.
+    MemoryUsage memoryUsage() const;
+
+    //! \returns The copied data in the binary form put on the system clipboard, see Constants::Application::clipboardMimeType().
+    //! The graph uses the compact snapshot encoding and each distinct image is stored once as its already encoded file data.
+    QByteArray serialize() const;
+
+    //! Replaces the copied data with data serialized by another window or instance.
+    //! \returns false if the data is not valid.
+    bool deserialize(const QByteArray & data);
 
 private:
     CopyContext(const CopyContext & other) = delete;
@@ -0,0 +1,170 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "edge_crossing_index.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// The bucket count per axis grows with the square root of the edge count, so that a bucket holds a few short edges
+static const size_t MAX_BUCKETS_PER_AXIS = 512;
+
+void EdgeCrossingIndex::setEdges(EdgeVector edges)
+{
+    m_edges = std::move(edges);
+    m_edgeBuckets.assign(m_edges.size(), {});
+    m_testedIds.assign(m_edges.size(), 0);
+    m_movingIds.assign(m_edges.size(), 0);
+    m_queryId = 0;
+    m_movingId = 0;
+}
+
+void EdgeCrossingIndex::rebuild(const double * x, const double * y, size_t vertexCount)
+{
+    const auto bucketsPerAxis = std::clamp<size_t>(static_cast<size_t>(std::sqrt(static_cast<double>(m_edges.size()))), 1, MAX_BUCKETS_PER_AXIS);
+    m_columnCount = bucketsPerAxis;
+    m_rowCount = bucketsPerAxis;
+    if (vertexCount) {
+        const auto [minX, maxX] = std::minmax_element(x, x + vertexCount);
+        const auto [minY, maxY] = std::minmax_element(y, y + vertexCount);
+        m_minX = *minX;
+        m_minY = *minY;
+        m_bucketWidth = std::max(1.0, (*maxX - *minX) / static_cast<double>(m_columnCount));
+        m_bucketHeight = std::max(1.0, (*maxY - *minY) / static_cast<double>(m_rowCount));
+    }
+
+    m_buckets.resize(m_columnCount * m_rowCount);
+    for (auto && bucket : m_buckets) {
+        bucket.clear();
+    }
+
+    for (size_t edge = 0; edge < m_edges.size(); edge++) {
+        insert(x, y, edge);
+    }
+}
+
+size_t EdgeCrossingIndex::crossingCount(const double * x, const double * y)
+{
+    // Stamping nothing as moving
+    m_movingId = ++m_queryId;
+    size_t count = 0;
+    for (size_t edge = 0; edge < m_edges.size(); edge++) {
+        count += countIndexedCrossings(x, y, edge, true);
+    }
+    return count;
+}
+
+size_t EdgeCrossingIndex::crossingCount(const double * x, const double * y, const std::vector<size_t> & edges)
+{
+    m_movingId = ++m_queryId;
+    for (auto && edge : edges) {
+        m_movingIds[edge] = m_movingId;
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i < edges.size(); i++) {
+        count += countIndexedCrossings(x, y, edges[i], false);
+        for (auto j = i + 1; j < edges.size(); j++) {
+            count += static_cast<size_t>(isCrossing(x, y, m_edges[edges[i]], m_edges[edges[j]]));
+        }
+    }
+    return count;
+}
+
+void EdgeCrossingIndex::update(const double * x, const double * y, const std::vector<size_t> & edges)
+{
+    for (auto && edge : edges) {
+        for (auto && bucket : m_edgeBuckets[edge]) {
+            auto && bucketEdges = m_buckets[bucket];
+            *std::find(bucketEdges.begin(), bucketEdges.end(), edge) = bucketEdges.back();
+            bucketEdges.pop_back();
+        }
+        insert(x, y, edge);
+    }
+}
+
+void EdgeCrossingIndex::insert(const double * x, const double * y, size_t edge)
+{
+    auto && edgeBuckets = m_edgeBuckets[edge];
+    edgeBuckets.clear();
+    forEachBucket(x, y, edge, [&](size_t bucket) {
+        m_buckets[bucket].push_back(edge);
+        edgeBuckets.push_back(bucket);
+    });
+}
+
+//! Visits the buckets column by column. In each column the edge covers the rows between its heights at the column borders.
+template<typename Function>
+void EdgeCrossingIndex::forEachBucket(const double * x, const double * y, size_t edge, Function function) const
+{
+    const auto [vertex0, vertex1] = m_edges[edge];
+    auto u0 = (x[vertex0] - m_minX) / m_bucketWidth;
+    auto v0 = (y[vertex0] - m_minY) / m_bucketHeight;
+    auto u1 = (x[vertex1] - m_minX) / m_bucketWidth;
+    auto v1 = (y[vertex1] - m_minY) / m_bucketHeight;
+    if (u0 > u1) {
+        std::swap(u0, u1);
+        std::swap(v0, v1);
+    }
+
+    const auto toIndex = [](double value, size_t count) {
+        return static_cast<size_t>(std::clamp(std::floor(value), 0.0, static_cast<double>(count - 1)));
+    };
+
+    const auto isVertical = u1 == u0;
+    const auto slope = isVertical ? 0.0 : (v1 - v0) / (u1 - u0);
+    const auto lastColumn = toIndex(u1, m_columnCount);
+    for (auto column = toIndex(u0, m_columnCount); column <= lastColumn; column++) {
+        const auto ua = std::max(u0, static_cast<double>(column));
+        const auto ub = std::min(u1, static_cast<double>(column + 1));
+        const auto va = isVertical ? v0 : v0 + slope * (ua - u0);
+        const auto vb = isVertical ? v1 : v0 + slope * (ub - u0);
+        const auto lastRow = toIndex(std::max(va, vb), m_rowCount);
+        for (auto row = toIndex(std::min(va, vb), m_rowCount); row <= lastRow; row++) {
+            function(row * m_columnCount + column);
+        }
+    }
+}
+
+size_t EdgeCrossingIndex::countIndexedCrossings(const double * x, const double * y, size_t edge, bool onlyHigherEdges)
+{
+    const auto testedId = ++m_queryId;
+    size_t count = 0;
+    forEachBucket(x, y, edge, [&](size_t bucket) {
+        for (auto && other : m_buckets[bucket]) {
+            if (m_testedIds[other] != testedId) {
+                m_testedIds[other] = testedId;
+                if ((!onlyHigherEdges || other > edge) && m_movingIds[other] != m_movingId && isCrossing(x, y, m_edges[edge], m_edges[other])) {
+                    count++;
+                }
+            }
+        }
+    });
+    return count;
+}
+
+bool EdgeCrossingIndex::isCrossing(const double * x, const double * y, const std::pair<size_t, size_t> & edge0, const std::pair<size_t, size_t> & edge1)
+{
+    const auto [a, b] = edge0;
+    const auto [c, d] = edge1;
+    if (a == c || a == d || b == c || b == d) {
+        return false;
+    }
+
+    const auto orientation = [x, y](size_t p, size_t q, size_t r) {
+        return (x[q] - x[p]) * (y[r] - y[p]) - (y[q] - y[p]) * (x[r] - x[p]);
+    };
+    return orientation(a, b, c) * orientation(a, b, d) < 0 && orientation(c, d, a) * orientation(c, d, b) < 0;
+}
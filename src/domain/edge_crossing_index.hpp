@@ -0,0 +1,86 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef EDGE_CROSSING_INDEX_HPP
+#define EDGE_CROSSING_INDEX_HPP
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+//! Uniform grid of buckets over the edges of a straight-line drawing, so that the crossings of an edge are counted
+//! by testing only the edges in the buckets it passes through instead of all the edges. The vertices are indices to
+//! flat coordinate arrays. Edges that share a vertex don't cross, and neither do edges that only touch.
+class EdgeCrossingIndex
+{
+public:
+    using EdgeVector = std::vector<std::pair<size_t, size_t>>;
+
+    void setEdges(EdgeVector edges);
+
+    //! Puts the edges to the buckets. The buckets cover all the given vertices, also the ones without edges,
+    //! so later the vertices can be moved to each other's positions without rebuilding.
+    void rebuild(const double * x, const double * y, size_t vertexCount);
+
+    //! \return Number of pairs of crossing edges at the indexed positions. Linear in the number of edges for short edges.
+    size_t crossingCount(const double * x, const double * y);
+
+    //! \return Number of crossings of the given edges with each other and with the other edges, when the given edges
+    //! are at the given positions and the other edges are where they were indexed. The index is not changed.
+    size_t crossingCount(const double * x, const double * y, const std::vector<size_t> & edges);
+
+    //! Moves the given edges to the buckets of their current positions.
+    void update(const double * x, const double * y, const std::vector<size_t> & edges);
+
+private:
+    void insert(const double * x, const double * y, size_t edge);
+
+    template<typename Function>
+    void forEachBucket(const double * x, const double * y, size_t edge, Function function) const;
+
+    //! \return Crossings of the edge at the given positions with the indexed edges that are not marked moving.
+    size_t countIndexedCrossings(const double * x, const double * y, size_t edge, bool onlyHigherEdges);
+
+    static bool isCrossing(const double * x, const double * y, const std::pair<size_t, size_t> & edge0, const std::pair<size_t, size_t> & edge1);
+
+    EdgeVector m_edges;
+
+    std::vector<std::vector<size_t>> m_buckets;
+
+    std::vector<std::vector<size_t>> m_edgeBuckets;
+
+    size_t m_columnCount = 0;
+
+    size_t m_rowCount = 0;
+
+    double m_minX = 0;
+
+    double m_minY = 0;
+
+    double m_bucketWidth = 1;
+
+    double m_bucketHeight = 1;
+
+    // Stamps of the edges tested in the current query and of the edges moving in the current query
+    std::vector<size_t> m_testedIds;
+
+    std::vector<size_t> m_movingIds;
+
+    size_t m_queryId = 0;
+
+    size_t m_movingId = 0;
+};
+
+#endif // EDGE_CROSSING_INDEX_HPP
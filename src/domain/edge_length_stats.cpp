@@ -0,0 +1,91 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "edge_length_stats.hpp"
+
+namespace {
+// The running sum accumulates rounding errors, so it's recalculated now and then
+const size_t maxUpdatesBetweenRecalculations = 100000;
+} // namespace
+
+void EdgeLengthStats::clear()
+{
+    m_lengths.clear();
+    m_sortedLengths.clear();
+    m_sum = 0;
+    m_updatesSinceRecalculation = 0;
+}
+
+void EdgeLengthStats::remove(Key key)
+{
+    if (const auto iter = m_lengths.find(key); iter != m_lengths.end()) {
+        m_sortedLengths.erase(m_sortedLengths.find(iter->second));
+        m_sum -= iter->second;
+        m_lengths.erase(iter);
+        if (m_lengths.empty()) {
+            m_sum = 0;
+        }
+    }
+}
+
+void EdgeLengthStats::setLength(Key key, double length)
+{
+    if (const auto iter = m_lengths.find(key); iter != m_lengths.end()) {
+        if (iter->second == length) {
+            return;
+        }
+        m_sortedLengths.erase(m_sortedLengths.find(iter->second));
+        m_sum -= iter->second;
+        iter->second = length;
+    } else {
+        m_lengths.emplace(key, length);
+    }
+
+    m_sortedLengths.insert(length);
+    m_sum += length;
+
+    if (++m_updatesSinceRecalculation >= maxUpdatesBetweenRecalculations) {
+        recalculateSum();
+    }
+}
+
+std::optional<double> EdgeLengthStats::average() const
+{
+    return m_lengths.empty() ? std::optional<double> {} : m_sum / static_cast<double>(m_lengths.size());
+}
+
+std::optional<double> EdgeLengthStats::maximum() const
+{
+    return m_sortedLengths.empty() ? std::optional<double> {} : *m_sortedLengths.rbegin();
+}
+
+std::optional<double> EdgeLengthStats::minimum() const
+{
+    return m_sortedLengths.empty() ? std::optional<double> {} : *m_sortedLengths.begin();
+}
+
+size_t EdgeLengthStats::size() const
+{
+    return m_lengths.size();
+}
+
+void EdgeLengthStats::recalculateSum()
+{
+    m_sum = 0;
+    for (auto && length : m_sortedLengths) {
+        m_sum += length;
+    }
+    m_updatesSinceRecalculation = 0;
+}
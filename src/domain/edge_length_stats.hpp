@@ -0,0 +1,58 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef EDGE_LENGTH_STATS_HPP
+#define EDGE_LENGTH_STATS_HPP
+
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <unordered_map>
+
+//! Incrementally maintained edge length statistics so that they can be queried without a pass over all edges.
+//! The lengths are kept in an ordered multiset, so minimum and maximum are constant time and updates logarithmic.
+class EdgeLengthStats
+{
+public:
+    using Key = int64_t;
+
+    void clear();
+
+    void remove(Key key);
+
+    //! Adds or updates the length of the given key.
+    void setLength(Key key, double length);
+
+    std::optional<double> average() const;
+
+    std::optional<double> maximum() const;
+
+    std::optional<double> minimum() const;
+
+    size_t size() const;
+
+private:
+    void recalculateSum();
+
+    std::unordered_map<Key, double> m_lengths;
+
+    std::multiset<double> m_sortedLengths;
+
+    double m_sum = 0;
+
+    size_t m_updatesSinceRecalculation = 0;
+};
+
+#endif // EDGE_LENGTH_STATS_HPP
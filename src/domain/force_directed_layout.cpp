@@ -0,0 +1,423 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "force_directed_layout.hpp"
+
+#include "../application/service_container.hpp"
+#include "../application/task_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+// Cooling factor per iteration
+static const double COOLING_FACTOR = 0.95;
+
+// A quadtree node is approximated by its center of mass if it's seen at an angle smaller than this
+static const double BARNES_HUT_THETA = 0.8;
+
+static const size_t QUAD_TREE_LEAF_SIZE = 8;
+
+// Limits the depth when many vertices are at the same position
+static const size_t QUAD_TREE_MAX_DEPTH = 24;
+
+static const size_t MIN_VERTICES_PER_THREAD = 256;
+
+// The forces balance at this many minimum edge lengths between the borders. The slack keeps the final overlap removal short.
+static const double IDEAL_GAP_SCALE = 3;
+
+static const size_t MAX_OVERLAP_REMOVAL_PASSES = 100;
+
+ForceDirectedLayout::ForceDirectedLayout(std::vector<QPointF> positions, std::vector<QSizeF> sizes, const EdgeVector & edges, size_t fixedCount, Parameters parameters)
+  : m_positions(std::move(positions))
+  , m_sizes(std::move(sizes))
+  , m_displacements(m_positions.size())
+  , m_movableCount(m_positions.size() - std::min(fixedCount, m_positions.size()))
+  , m_parameters(parameters)
+  , m_idealGap(IDEAL_GAP_SCALE * std::max(1.0, parameters.minEdgeLength))
+{
+    m_neighborOffsets.assign(m_positions.size() + 1, 0);
+    for (auto && [vertex0, vertex1] : edges) {
+        m_neighborOffsets.at(vertex0 + 1)++;
+        m_neighborOffsets.at(vertex1 + 1)++;
+    }
+    std::partial_sum(m_neighborOffsets.begin(), m_neighborOffsets.end(), m_neighborOffsets.begin());
+    m_neighbors.resize(m_neighborOffsets.back());
+    std::vector<size_t> insertPositions(m_neighborOffsets.begin(), m_neighborOffsets.end() - 1);
+    for (auto && [vertex0, vertex1] : edges) {
+        m_neighbors.at(insertPositions.at(vertex0)++) = vertex1;
+        m_neighbors.at(insertPositions.at(vertex1)++) = vertex0;
+    }
+
+    for (auto && size : m_sizes) {
+        m_maxExtent = std::max({ m_maxExtent, size.width(), size.height() });
+    }
+
+    if (!m_parameters.warmStart && m_movableCount == m_positions.size()) {
+        scaleToArea();
+    }
+
+    // A cold start may move the vertices across the whole layout, a warm start only about one gap
+    const auto bounds = boundingRect();
+    m_initialTemperature = m_parameters.warmStart ? m_idealGap : std::max(m_idealGap, std::hypot(bounds.width(), bounds.height()) / 10);
+    m_finalTemperature = m_idealGap / 100;
+    m_temperature = m_initialTemperature;
+}
+
+bool ForceDirectedLayout::step()
+{
+    if (!m_movableCount || m_temperature <= m_finalTemperature) {
+        return false;
+    }
+
+    buildQuadTree();
+
+    auto && taskPool = *SC::instance().taskPool();
+    const auto threadCount = std::min(taskPool.chunkCount(m_movableCount, MIN_VERTICES_PER_THREAD), std::max<size_t>(1, m_parameters.threadCount));
+    const auto chunkSize = (m_movableCount + threadCount - 1) / threadCount;
+    taskPool.run(threadCount, [this, chunkSize](size_t chunk) {
+        if (const auto begin = chunk * chunkSize; begin < m_movableCount) {
+            calculateDisplacements(begin, std::min(begin + chunkSize, m_movableCount));
+        }
+    });
+
+    // The steps are limited by the temperature
+    for (size_t vertex = 0; vertex < m_movableCount; vertex++) {
+        const auto displacement = m_displacements.at(vertex);
+        if (const auto length = std::hypot(displacement.x(), displacement.y()); length > 0) {
+            m_positions.at(vertex) += displacement * (std::min(length, m_temperature) / length);
+        }
+    }
+
+    m_temperature *= COOLING_FACTOR;
+    m_iterationCount++;
+
+    return true;
+}
+
+void ForceDirectedLayout::finalize()
+{
+    if (!m_movableCount) {
+        return;
+    }
+
+    // The anchors define the scale and the position, so a subgraph is not rescaled
+    if (m_movableCount == m_positions.size()) {
+        scaleToAspectRatio();
+    }
+
+    removeOverlaps();
+}
+
+double ForceDirectedLayout::cost() const
+{
+    double cost = 0;
+    for (size_t vertex = 0; vertex < m_positions.size(); vertex++) {
+        for (auto i = m_neighborOffsets.at(vertex); i < m_neighborOffsets.at(vertex + 1); i++) {
+            const auto neighbor = m_neighbors.at(i);
+            cost += std::max(0.0, gapBetween(vertex, neighbor, m_positions.at(vertex) - m_positions.at(neighbor)));
+        }
+    }
+    // Each edge was counted from both ends
+    return cost / 2;
+}
+
+double ForceDirectedLayout::progress() const
+{
+    if (m_initialTemperature <= m_finalTemperature) {
+        return 1;
+    }
+    return std::clamp(std::log(m_initialTemperature / m_temperature) / std::log(m_initialTemperature / m_finalTemperature), 0.0, 1.0);
+}
+
+size_t ForceDirectedLayout::iterationCount() const
+{
+    return m_iterationCount;
+}
+
+const std::vector<QPointF> & ForceDirectedLayout::positions() const
+{
+    return m_positions;
+}
+
+void ForceDirectedLayout::buildQuadTree()
+{
+    const auto [minX, maxX] = std::minmax_element(m_positions.begin(), m_positions.end(), [](auto && lhs, auto && rhs) {
+        return lhs.x() < rhs.x();
+    });
+    const auto [minY, maxY] = std::minmax_element(m_positions.begin(), m_positions.end(), [](auto && lhs, auto && rhs) {
+        return lhs.y() < rhs.y();
+    });
+
+    m_treeVertices.resize(m_positions.size());
+    std::iota(m_treeVertices.begin(), m_treeVertices.end(), 0);
+    m_tree.clear();
+    m_tree.emplace_back();
+    buildQuadTreeNode(0, 0, m_treeVertices.size(), minX->x(), minY->y(), std::max({ maxX->x() - minX->x(), maxY->y() - minY->y(), 1.0 }), 0);
+}
+
+void ForceDirectedLayout::buildQuadTreeNode(size_t nodeIndex, size_t begin, size_t end, double x, double y, double size, size_t depth)
+{
+    QPointF centerOfMass;
+    for (auto i = begin; i < end; i++) {
+        centerOfMass += m_positions.at(m_treeVertices.at(i));
+    }
+
+    auto && node = m_tree.at(nodeIndex);
+    node.mass = static_cast<double>(end - begin);
+    node.centerOfMass = end > begin ? centerOfMass / node.mass : QPointF { x + size / 2, y + size / 2 };
+    node.size = size;
+    node.begin = begin;
+    node.end = end;
+    if (end - begin <= QUAD_TREE_LEAF_SIZE || depth >= QUAD_TREE_MAX_DEPTH) {
+        return;
+    }
+
+    // Children are ordered top-left, top-right, bottom-left, bottom-right
+    const auto half = size / 2;
+    const auto first = m_treeVertices.begin();
+    const auto isTop = [&](size_t vertex) {
+        return m_positions.at(vertex).y() < y + half;
+    };
+    const auto isLeft = [&](size_t vertex) {
+        return m_positions.at(vertex).x() < x + half;
+    };
+    const auto middle = static_cast<size_t>(std::partition(first + static_cast<std::ptrdiff_t>(begin), first + static_cast<std::ptrdiff_t>(end), isTop) - first);
+    const auto topMiddle = static_cast<size_t>(std::partition(first + static_cast<std::ptrdiff_t>(begin), first + static_cast<std::ptrdiff_t>(middle), isLeft) - first);
+    const auto bottomMiddle = static_cast<size_t>(std::partition(first + static_cast<std::ptrdiff_t>(middle), first + static_cast<std::ptrdiff_t>(end), isLeft) - first);
+
+    const auto firstChild = m_tree.size();
+    m_tree.at(nodeIndex).firstChild = firstChild;
+    m_tree.resize(firstChild + 4);
+    buildQuadTreeNode(firstChild, begin, topMiddle, x, y, half, depth + 1);
+    buildQuadTreeNode(firstChild + 1, topMiddle, middle, x + half, y, half, depth + 1);
+    buildQuadTreeNode(firstChild + 2, middle, bottomMiddle, x, y + half, half, depth + 1);
+    buildQuadTreeNode(firstChild + 3, bottomMiddle, end, x + half, y + half, half, depth + 1);
+}
+
+void ForceDirectedLayout::buildGrid(double cellSize)
+{
+    const auto [minX, maxX] = std::minmax_element(m_positions.begin(), m_positions.end(), [](auto && lhs, auto && rhs) {
+        return lhs.x() < rhs.x();
+    });
+    const auto [minY, maxY] = std::minmax_element(m_positions.begin(), m_positions.end(), [](auto && lhs, auto && rhs) {
+        return lhs.y() < rhs.y();
+    });
+
+    // Coarsen the grid for very sparse layouts so that its size stays linear in the number of vertices
+    m_gridX = minX->x();
+    m_gridY = minY->y();
+    m_gridCellSize = cellSize / 2;
+    do {
+        m_gridCellSize *= 2;
+        m_gridCols = static_cast<size_t>((maxX->x() - m_gridX) / m_gridCellSize) + 1;
+        m_gridRows = static_cast<size_t>((maxY->y() - m_gridY) / m_gridCellSize) + 1;
+    } while (m_gridCols * m_gridRows > 4 * m_positions.size() + 16);
+
+    const auto cellOf = [this](size_t vertex) {
+        const auto col = static_cast<size_t>((m_positions.at(vertex).x() - m_gridX) / m_gridCellSize);
+        const auto row = static_cast<size_t>((m_positions.at(vertex).y() - m_gridY) / m_gridCellSize);
+        return row * m_gridCols + col;
+    };
+
+    m_gridOffsets.assign(m_gridCols * m_gridRows + 1, 0);
+    for (size_t vertex = 0; vertex < m_positions.size(); vertex++) {
+        m_gridOffsets.at(cellOf(vertex) + 1)++;
+    }
+    std::partial_sum(m_gridOffsets.begin(), m_gridOffsets.end(), m_gridOffsets.begin());
+    m_gridVertices.resize(m_positions.size());
+    std::vector<size_t> insertPositions(m_gridOffsets.begin(), m_gridOffsets.end() - 1);
+    for (size_t vertex = 0; vertex < m_positions.size(); vertex++) {
+        m_gridVertices.at(insertPositions.at(cellOf(vertex))++) = vertex;
+    }
+}
+
+template<typename Visitor>
+void ForceDirectedLayout::forEachVertexNear(size_t vertex, Visitor && visitor) const
+{
+    const auto col = static_cast<int>((m_positions.at(vertex).x() - m_gridX) / m_gridCellSize);
+    const auto row = static_cast<int>((m_positions.at(vertex).y() - m_gridY) / m_gridCellSize);
+    for (int j = std::max(0, row - 1); j <= std::min(static_cast<int>(m_gridRows) - 1, row + 1); j++) {
+        for (int i = std::max(0, col - 1); i <= std::min(static_cast<int>(m_gridCols) - 1, col + 1); i++) {
+            const auto cell = static_cast<size_t>(j) * m_gridCols + static_cast<size_t>(i);
+            for (auto k = m_gridOffsets.at(cell); k < m_gridOffsets.at(cell + 1); k++) {
+                if (const auto other = m_gridVertices.at(k); other != vertex) {
+                    visitor(other);
+                }
+            }
+        }
+    }
+}
+
+double ForceDirectedLayout::gapBetween(size_t vertex0, size_t vertex1, QPointF delta) const
+{
+    return std::max(std::abs(delta.x()) - (m_sizes.at(vertex0).width() + m_sizes.at(vertex1).width()) / 2,
+                    std::abs(delta.y()) - (m_sizes.at(vertex0).height() + m_sizes.at(vertex1).height()) / 2);
+}
+
+void ForceDirectedLayout::calculateDisplacements(size_t begin, size_t end)
+{
+    const auto minGap = m_idealGap / 100;
+    const auto repulsion = m_idealGap * m_idealGap;
+    std::vector<size_t> stack;
+    for (size_t vertex = begin; vertex < end; vertex++) {
+        QPointF displacement;
+        const auto position = m_positions.at(vertex);
+
+        // Vertices at the same position are separated deterministically by their order
+        const auto direction = [&](size_t other, QPointF delta) {
+            if (const auto length = std::hypot(delta.x(), delta.y()); length > 0) {
+                return delta / length;
+            }
+            return QPointF { vertex < other ? 1.0 : -1.0, 0.0 };
+        };
+
+        // Near vertices repel by the gap between their borders, distant groups as a point mass
+        stack.assign(1, 0);
+        while (!stack.empty()) {
+            const auto & node = m_tree.at(stack.back());
+            stack.pop_back();
+            if (!node.firstChild) {
+                for (auto i = node.begin; i < node.end; i++) {
+                    if (const auto other = m_treeVertices.at(i); other != vertex) {
+                        const auto delta = position - m_positions.at(other);
+                        displacement += direction(other, delta) * (repulsion / std::max(gapBetween(vertex, other, delta), minGap));
+                    }
+                }
+                continue;
+            }
+
+            const auto delta = position - node.centerOfMass;
+            if (const auto distance = std::hypot(delta.x(), delta.y()); node.size < BARNES_HUT_THETA * distance) {
+                displacement += delta / distance * (node.mass * repulsion / distance);
+            } else {
+                for (auto child = node.firstChild; child < node.firstChild + 4; child++) {
+                    if (m_tree.at(child).mass > 0) {
+                        stack.push_back(child);
+                    }
+                }
+            }
+        }
+
+        for (auto i = m_neighborOffsets.at(vertex); i < m_neighborOffsets.at(vertex + 1); i++) {
+            const auto neighbor = m_neighbors.at(i);
+            const auto delta = position - m_positions.at(neighbor);
+            if (const auto gap = gapBetween(vertex, neighbor, delta); gap > 0) {
+                displacement -= direction(neighbor, delta) * (gap * gap / m_idealGap);
+            }
+        }
+
+        m_displacements.at(vertex) = displacement;
+    }
+}
+
+QRectF ForceDirectedLayout::boundingRect() const
+{
+    if (m_positions.empty()) {
+        return {};
+    }
+
+    double minX = m_positions.front().x();
+    double maxX = minX;
+    double minY = m_positions.front().y();
+    double maxY = minY;
+    for (size_t vertex = 0; vertex < m_positions.size(); vertex++) {
+        minX = std::min(minX, m_positions.at(vertex).x() - m_sizes.at(vertex).width() / 2);
+        maxX = std::max(maxX, m_positions.at(vertex).x() + m_sizes.at(vertex).width() / 2);
+        minY = std::min(minY, m_positions.at(vertex).y() - m_sizes.at(vertex).height() / 2);
+        maxY = std::max(maxY, m_positions.at(vertex).y() + m_sizes.at(vertex).height() / 2);
+    }
+    return { minX, minY, maxX - minX, maxY - minY };
+}
+
+void ForceDirectedLayout::scale(double scaleX, double scaleY)
+{
+    const auto center = boundingRect().center();
+    for (auto && position : m_positions) {
+        position = { center.x() + (position.x() - center.x()) * scaleX, center.y() + (position.y() - center.y()) * scaleY };
+    }
+}
+
+void ForceDirectedLayout::scaleToArea()
+{
+    const auto bounds = boundingRect();
+    if (m_positions.size() < 2 || bounds.width() <= 0 || bounds.height() <= 0) {
+        return;
+    }
+
+    // Start from roughly the area that the vertices need with ideal gaps, so that the forces don't have to spread or
+    // contract the whole layout first
+    double area = 0;
+    for (auto && size : m_sizes) {
+        area += (size.width() + m_idealGap) * (size.height() + m_idealGap);
+    }
+    scale(std::sqrt(area * m_parameters.aspectRatio) / bounds.width(), std::sqrt(area / m_parameters.aspectRatio) / bounds.height());
+}
+
+void ForceDirectedLayout::scaleToAspectRatio()
+{
+    const auto bounds = boundingRect();
+    if (m_positions.size() < 2 || bounds.width() <= 0 || bounds.height() <= 0) {
+        return;
+    }
+
+    // Keep the area, the overlaps caused by compressing an axis are removed afterwards
+    const auto scaleX = std::sqrt(m_parameters.aspectRatio / (bounds.width() / bounds.height()));
+    scale(scaleX, 1 / scaleX);
+}
+
+void ForceDirectedLayout::removeOverlaps()
+{
+    const auto minGap = m_parameters.minEdgeLength;
+    for (size_t pass = 0; pass < MAX_OVERLAP_REMOVAL_PASSES; pass++) {
+        buildGrid(m_maxExtent + minGap);
+        bool overlaps = false;
+        for (size_t vertex = 0; vertex < m_movableCount; vertex++) {
+            forEachVertexNear(vertex, [&](size_t other) {
+                // Pairs of movable vertices are handled once, pairs with an anchor always from the movable side
+                if (other < m_movableCount && other < vertex) {
+                    return;
+                }
+                const auto delta = m_positions.at(vertex) - m_positions.at(other);
+                const auto overlapX = (m_sizes.at(vertex).width() + m_sizes.at(other).width()) / 2 + minGap - std::abs(delta.x());
+                const auto overlapY = (m_sizes.at(vertex).height() + m_sizes.at(other).height()) / 2 + minGap - std::abs(delta.y());
+                if (overlapX <= 0 || overlapY <= 0) {
+                    return;
+                }
+
+                // Push apart along the axis that needs the shorter move
+                overlaps = true;
+                const auto share = other < m_movableCount ? 0.5 : 1.0;
+                if (overlapX < overlapY) {
+                    const auto push = (delta.x() > 0 || (delta.x() == 0 && vertex < other) ? 1.0 : -1.0) * overlapX;
+                    m_positions.at(vertex).rx() += push * share;
+                    if (other < m_movableCount) {
+                        m_positions.at(other).rx() -= push * share;
+                    }
+                } else {
+                    const auto push = (delta.y() > 0 || (delta.y() == 0 && vertex < other) ? 1.0 : -1.0) * overlapY;
+                    m_positions.at(vertex).ry() += push * share;
+                    if (other < m_movableCount) {
+                        m_positions.at(other).ry() -= push * share;
+                    }
+                }
+            });
+        }
+
+        if (!overlaps) {
+            return;
+        }
+    }
+}
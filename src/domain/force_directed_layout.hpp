@@ -0,0 +1,159 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FORCE_DIRECTED_LAYOUT_HPP
+#define FORCE_DIRECTED_LAYOUT_HPP
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <QPointF>
+#include <QRectF>
+#include <QSizeF>
+
+//! Fruchterman–Reingold style force-directed layout. The repulsion of distant vertices is approximated with a
+//! Barnes–Hut quadtree, so an iteration is O(N log N). The forces of an iteration are calculated in parallel.
+class ForceDirectedLayout
+{
+public:
+    struct Parameters
+    {
+        double aspectRatio = 1;
+
+        double minEdgeLength = 0;
+
+        size_t threadCount = 1;
+
+        //! Starts with small steps so that the current layout is only refined.
+        bool warmStart = false;
+    };
+
+    using EdgeVector = std::vector<std::pair<size_t, size_t>>;
+
+    //! \param positions Centers of the vertices.
+    //! \param fixedCount The last fixedCount vertices are anchors that attract and repel the others, but don't move.
+    ForceDirectedLayout(std::vector<QPointF> positions, std::vector<QSizeF> sizes, const EdgeVector & edges, size_t fixedCount, Parameters parameters);
+
+    //! Runs one iteration.
+    //! \return false if the layout has converged.
+    bool step();
+
+    //! Scales the layout to the aspect ratio and pushes overlapping vertices apart until there are at least
+    //! minEdgeLength between them. Call once after the iterations.
+    void finalize();
+
+    //! \return Sum of the edge lengths measured between the borders of the vertices.
+    double cost() const;
+
+    //! \return Progress in [0, 1] estimated from the cooling schedule.
+    double progress() const;
+
+    size_t iterationCount() const;
+
+    const std::vector<QPointF> & positions() const;
+
+private:
+    void buildQuadTree();
+
+    void buildQuadTreeNode(size_t nodeIndex, size_t begin, size_t end, double x, double y, double size, size_t depth);
+
+    //! Uniform grid used to find overlapping vertices.
+    void buildGrid(double cellSize);
+
+    void calculateDisplacements(size_t begin, size_t end);
+
+    //! \return Distance between the borders of the vertices, negative if they overlap.
+    double gapBetween(size_t vertex0, size_t vertex1, QPointF delta) const;
+
+    template<typename Visitor>
+    void forEachVertexNear(size_t vertex, Visitor && visitor) const;
+
+    //! \return Bounding rect of the vertices including their sizes.
+    QRectF boundingRect() const;
+
+    void removeOverlaps();
+
+    void scale(double scaleX, double scaleY);
+
+    void scaleToArea();
+
+    void scaleToAspectRatio();
+
+    std::vector<QPointF> m_positions;
+
+    std::vector<QSizeF> m_sizes;
+
+    double m_maxExtent = 0;
+
+    std::vector<QPointF> m_displacements;
+
+    // Neighbors in CSR form
+    std::vector<size_t> m_neighborOffsets;
+
+    std::vector<size_t> m_neighbors;
+
+    size_t m_movableCount = 0;
+
+    Parameters m_parameters;
+
+    double m_idealGap = 0;
+
+    double m_temperature = 0;
+
+    double m_initialTemperature = 0;
+
+    double m_finalTemperature = 0;
+
+    size_t m_iterationCount = 0;
+
+    struct QuadTreeNode
+    {
+        QPointF centerOfMass;
+
+        double mass = 0;
+
+        double size = 0;
+
+        //! Index of the first of the four consecutive children, 0 for a leaf.
+        size_t firstChild = 0;
+
+        //! Range of the vertices of a leaf in m_treeVertices.
+        size_t begin = 0;
+
+        size_t end = 0;
+    };
+
+    std::vector<QuadTreeNode> m_tree;
+
+    std::vector<size_t> m_treeVertices;
+
+    // Vertices sorted by grid cell in CSR form
+    double m_gridX = 0;
+
+    double m_gridY = 0;
+
+    double m_gridCellSize = 1;
+
+    size_t m_gridCols = 1;
+
+    size_t m_gridRows = 1;
+
+    std::vector<size_t> m_gridOffsets;
+
+    std::vector<size_t> m_gridVertices;
+};
+
+#endif // FORCE_DIRECTED_LAYOUT_HPP
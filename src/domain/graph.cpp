@@ -18,19 +18,95 @@
 #include "simple_logger.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <stdexcept>
 #include <string>
+#include <unordered_set>
 
 static const auto TAG = "Graph";
 
-Graph::Graph() = default;
+namespace {
+
+size_t estimatedNodeSize(NodeCR node)
+{
+    return sizeof(SceneItems::Node) + sizeof(SceneItems::NodeModel) + static_cast<size_t>(node.text().size()) * sizeof(QChar);
+}
+
+size_t estimatedEdgeSize(EdgeCR edge)
+{
+    return sizeof(SceneItems::Edge) + sizeof(SceneItems::EdgeModel) + static_cast<size_t>(edge.text().size()) * sizeof(QChar);
+}
+
+// Shared by all graphs so that a revision identifies also the graph
+std::atomic<size_t> topologyRevisionCounter { 0 };
+
+// The free slots of the deleted nodes are bounded by these, so that an index e.g. from a corrupted file can't allocate gigabytes
+const size_t MAX_SLOTS_PER_NODE = 16;
+
+const size_t MAX_FREE_SLOTS = 1 << 20;
+
+//! Disconnects only the connection of the graph stored for the given key, as others may follow the same signal.
+template<typename ConnectionMap>
+void disconnectIndex(ConnectionMap & connections, typename ConnectionMap::key_type key)
+{
+    if (const auto iter = connections.find(key); iter != connections.end()) {
+        QObject::disconnect(iter->second);
+        connections.erase(iter);
+    }
+}
+
+} // namespace
+
+Graph::Graph()
+{
+    updateTopologyRevision();
+}
 
 void Graph::clear()
 {
+    for (auto && edge : m_edges) {
+        unindexEdgeLength(*edge.second);
+        unindexEdgeStyle(*edge.second);
+        unindexEdgeText(*edge.second);
+    }
+    for (auto && node : m_nodes) {
+        unindexNodePlacement(*node);
+        unindexNodeStyle(*node);
+        unindexNodeText(*node);
+    }
     m_edges.clear();
+    m_outgoingEdges.clear();
+    m_incomingEdges.clear();
     m_deletedEdges.clear();
     m_nodes.clear();
+    m_nodeSlots.clear();
     m_deletedNodes.clear();
+    updateTopologyRevision();
+}
+
+Graph::Items Graph::releaseItems()
+{
+    Items items;
+
+    items.edges.reserve(m_edges.size() + m_deletedEdges.size());
+    for (auto && edge : m_edges) {
+        items.edges.push_back(edge.second);
+    }
+    for (auto && deletedEdge : m_deletedEdges) {
+        items.edges.push_back(deletedEdge.edge);
+    }
+
+    items.nodes.reserve(m_nodes.size() + m_deletedNodes.size());
+    items.nodes = m_nodes;
+    for (auto && deletedNode : m_deletedNodes) {
+        items.nodes.push_back(deletedNode.node);
+    }
+
+    // The items are disconnected from the indices, as they may outlive the graph, and the adjacency lists
+    // share the edges, so they must not outlive the released items elsewhere
+    clear();
+
+    return items;
 }
 
 void Graph::addNode(NodeS node)
@@ -38,12 +114,54 @@ void Graph::addNode(NodeS node)
     if (node->index() == -1) {
         node->setIndex(m_count++);
     } else {
+        if (!isValidNodeIndex(node->index(), std::max(m_nodes.capacity(), m_nodes.size() + 1))) {
+            throw std::out_of_range("Node index " + std::to_string(node->index()) + " is out of range for " + std::to_string(m_nodes.size()) + " nodes");
+        }
         if (node->index() >= m_count) {
             m_count = node->index() + 1;
         }
     }
 
-    m_nodes[node->index()] = node;
+    if (const auto slot = slotOfNode(node->index()); slot >= 0) {
+        unindexNodePlacement(*m_nodes.at(static_cast<size_t>(slot)));
+        unindexNodeStyle(*m_nodes.at(static_cast<size_t>(slot)));
+        unindexNodeText(*m_nodes.at(static_cast<size_t>(slot)));
+        m_nodes.at(static_cast<size_t>(slot)) = node;
+        m_changeNotifier.notify({ GraphChange::Type::NodeRemoved, node->index() });
+    } else {
+        if (static_cast<size_t>(node->index()) >= m_nodeSlots.size()) {
+            m_nodeSlots.resize(static_cast<size_t>(node->index()) + 1, -1);
+        }
+        m_nodeSlots.at(static_cast<size_t>(node->index())) = static_cast<int>(m_nodes.size());
+        m_nodes.push_back(node);
+    }
+
+    indexNodePlacement(node);
+    indexNodeStyle(node);
+    indexNodeText(node);
+    m_changeNotifier.notify({ GraphChange::Type::NodeAdded, node->index() });
+    updateTopologyRevision();
+}
+
+bool Graph::isValidNodeIndex(int index, size_t nodeCount)
+{
+    return index >= 0 && static_cast<size_t>(index) < nodeCount * MAX_SLOTS_PER_NODE + MAX_FREE_SLOTS;
+}
+
+void Graph::reserveNodes(size_t count)
+{
+    m_nodes.reserve(count);
+}
+
+void Graph::addNodes(const std::vector<NodeS> & nodes)
+{
+    // Allocate the indices and the storage at once instead of growing them node by node
+    m_nodes.reserve(m_nodes.size() + nodes.size());
+    m_nodeSlots.resize(static_cast<size_t>(m_count) + nodes.size(), -1);
+    for (auto && node : nodes) {
+        node->setIndex(m_count++);
+        addNode(node);
+    }
 }
 
 EdgeS Graph::deleteEdge(int index0, int index1)
@@ -51,8 +169,15 @@ EdgeS Graph::deleteEdge(int index0, int index1)
     EdgeS deletedEdge;
     if (const auto edgeIter = m_edges.find(buildKeyFromIndices(index0, index1)); edgeIter != m_edges.end()) {
         deletedEdge = (*edgeIter).second;
-        m_deletedEdges.push_back(deletedEdge);
+        removeFromAdjacency(*deletedEdge);
+        notifyEdgeChange(*deletedEdge);
+        unindexEdgeLength(*deletedEdge);
+        unindexEdgeStyle(*deletedEdge);
+        unindexEdgeText(*deletedEdge);
+        publishEdgeChange(GraphChange::Type::EdgeRemoved, *deletedEdge);
+        m_deletedEdges.push_back({ deletedEdge, m_epoch });
         m_edges.erase(edgeIter);
+        updateTopologyRevision();
     }
     return deletedEdge;
 }
@@ -61,20 +186,32 @@ std::pair<NodeS, Graph::EdgeVector> Graph::deleteNode(int index)
 {
     NodeS deletedNode;
     Graph::EdgeVector deletedEdges;
-    if (const auto iter = m_nodes.find(index); iter != m_nodes.end()) {
-        auto edgeIter = m_edges.begin();
-        while (edgeIter != m_edges.end()) {
-            if (const auto edgePair = *edgeIter; edgePair.second->sourceNode().index() == index || edgePair.second->targetNode().index() == index) {
-                deletedEdges.push_back(edgePair.second);
-                m_deletedEdges.push_back(edgePair.second);
-                edgeIter = m_edges.erase(edgeIter);
-            } else {
-                edgeIter++;
+    if (const auto slot = slotOfNode(index); slot >= 0) {
+        // Collect first, because deleting edges modifies the adjacency lists
+        deletedEdges = edgesToNode(index);
+        for (auto && edge : edgesFromNode(index)) {
+            if (edge->targetNode().index() != index) {
+                deletedEdges.push_back(edge);
             }
         }
-        deletedNode = iter->second;
-        m_deletedNodes.push_back(deletedNode);
-        m_nodes.erase(iter);
+        for (auto && edge : deletedEdges) {
+            deleteEdge(edge->sourceNode().index(), edge->targetNode().index());
+        }
+        m_outgoingEdges.erase(index);
+        m_incomingEdges.erase(index);
+        deletedNode = m_nodes.at(static_cast<size_t>(slot));
+        notifyPlacementChange(index, {});
+        unindexNodePlacement(*deletedNode);
+        unindexNodeStyle(*deletedNode);
+        unindexNodeText(*deletedNode);
+        m_changeNotifier.notify({ GraphChange::Type::NodeRemoved, index });
+        m_deletedNodes.push_back({ deletedNode, m_epoch });
+        // Keep the storage dense by moving the last node into the freed slot
+        m_nodes.at(static_cast<size_t>(slot)) = m_nodes.back();
+        m_nodeSlots.at(static_cast<size_t>(m_nodes.back()->index())) = slot;
+        m_nodes.pop_back();
+        m_nodeSlots.at(static_cast<size_t>(index)) = -1;
+        updateTopologyRevision();
     }
 
     return { deletedNode, deletedEdges };
@@ -85,8 +222,23 @@ void Graph::addEdge(EdgeS newEdge)
     // Add if such edge doesn't already exist
     const auto c0 = newEdge->sourceNode().index();
     const auto c1 = newEdge->targetNode().index();
-    if (!m_edges.count(buildKeyFromIndices(c0, c1))) {
-        m_edges.insert({ buildKeyFromIndices(c0, c1), newEdge });
+    if (m_edges.insert({ buildKeyFromIndices(c0, c1), newEdge }).second) {
+        m_outgoingEdges[c0].push_back(newEdge);
+        m_incomingEdges[c1].push_back(newEdge);
+        indexEdgeLength(newEdge);
+        indexEdgeStyle(newEdge);
+        indexEdgeText(newEdge);
+        notifyEdgeChange(*newEdge);
+        publishEdgeChange(GraphChange::Type::EdgeAdded, *newEdge);
+        updateTopologyRevision();
+    }
+}
+
+void Graph::addEdges(const EdgeVector & edges)
+{
+    m_edges.reserve(m_edges.size() + edges.size());
+    for (auto && edge : edges) {
+        addEdge(edge);
     }
 }
 
@@ -110,6 +262,11 @@ size_t Graph::nodeCount() const
     return m_nodes.size();
 }
 
+int Graph::nextNodeIndex() const
+{
+    return m_count;
+}
+
 EdgeS Graph::getEdge(int index0, int index1) const
 {
     const auto iter = m_edges.find(buildKeyFromIndices(index0, index1));
@@ -123,58 +280,388 @@ Graph::EdgeVector Graph::getEdges() const
     return edges;
 }
 
+const EdgeLengthStats & Graph::edgeLengthStats() const
+{
+    return m_edgeLengthStats;
+}
+
+const NodePlacementStats & Graph::nodePlacementStats() const
+{
+    return m_nodePlacementStats;
+}
+
+const NodeSpatialIndex & Graph::nodeSpatialIndex() const
+{
+    return m_nodeSpatialIndex;
+}
+
+void Graph::setPlacementChangeCallback(PlacementChangeCallback callback)
+{
+    m_placementChangeCallback = callback;
+}
+
+GraphChangeNotifier & Graph::changeNotifier()
+{
+    return m_changeNotifier;
+}
+
+Graph::EdgeRange Graph::edges() const
+{
+    return EdgeRange(m_edges);
+}
+
 Graph::EdgeVector Graph::getEdgesFromNode(NodeS node) const
 {
-    EdgeVector edges;
-    for (auto && edge : m_edges) {
-        if (edge.second->sourceNode().index() == node->index()) {
-            edges.push_back(edge.second);
-        }
-    }
-    return edges;
+    return edgesFromNode(node->index());
 }
 
 Graph::EdgeVector Graph::getEdgesToNode(NodeS node) const
 {
-    Graph::EdgeVector edges;
-    for (auto && edge : m_edges) {
-        if (edge.second->targetNode().index() == node->index()) {
-            edges.push_back(edge.second);
+    return edgesToNode(node->index());
+}
+
+const Graph::EdgeVector & Graph::edgesFromNode(int index) const
+{
+    static const EdgeVector empty;
+    const auto iter = m_outgoingEdges.find(index);
+    return iter != m_outgoingEdges.end() ? iter->second : empty;
+}
+
+std::unordered_set<int> Graph::descendantIndices(int index) const
+{
+    // The edges may form cycles, but the start node is only visited once as the first one
+    const auto branch = traverse({ index }, TraversalDirection::Descendants);
+    return { std::next(branch.begin()), branch.end() };
+}
+
+std::vector<int> Graph::traverse(const std::vector<int> & indices, TraversalDirection direction) const
+{
+    // Indices of the nodes in the graph are always below the size of the slot table
+    std::vector<bool> visited(m_nodeSlots.size());
+    std::vector<int> result;
+    const auto visit = [&](int index) {
+        if (index >= 0 && static_cast<size_t>(index) < visited.size() && !visited.at(static_cast<size_t>(index))) {
+            visited.at(static_cast<size_t>(index)) = true;
+            result.push_back(index);
         }
+    };
+
+    for (auto && index : indices) {
+        visit(index);
     }
-    return edges;
+
+    // The result doubles as the queue
+    for (size_t next = 0; next < result.size(); next++) {
+        const auto current = result.at(next);
+        if (direction == TraversalDirection::Descendants) {
+            for (auto && edge : edgesFromNode(current)) {
+                visit(edge->targetNode().index());
+            }
+        } else {
+            for (auto && edge : edgesToNode(current)) {
+                visit(edge->sourceNode().index());
+            }
+        }
+    }
+
+    return result;
+}
+
+const Graph::EdgeVector & Graph::edgesToNode(int index) const
+{
+    static const EdgeVector empty;
+    const auto iter = m_incomingEdges.find(index);
+    return iter != m_incomingEdges.end() ? iter->second : empty;
+}
+
+size_t Graph::topologyRevision() const
+{
+    return m_topologyRevision;
+}
+
+void Graph::updateTopologyRevision()
+{
+    m_topologyRevision = ++topologyRevisionCounter;
+}
+
+size_t Graph::degree(int index) const
+{
+    return edgesFromNode(index).size() + edgesToNode(index).size();
 }
 
 NodeS Graph::getNode(int index) const
 {
-    if (const auto iter = m_nodes.find(index); iter != m_nodes.end()) {
-        return iter->second;
+    if (const auto slot = slotOfNode(index); slot >= 0) {
+        return m_nodes.at(static_cast<size_t>(slot));
     }
     throw std::runtime_error("Invalid node index: " + std::to_string(index));
 }
 
+bool Graph::hasNode(int index) const
+{
+    return slotOfNode(index) >= 0;
+}
+
 Graph::NodeVector Graph::getNodes() const
 {
-    NodeVector nodes(m_nodes.size());
-    std::transform(std::begin(m_nodes), std::end(m_nodes), std::begin(nodes), [](auto && node) { return node.second; });
-    return nodes;
+    return m_nodes;
+}
+
+const Graph::NodeVector & Graph::nodes() const
+{
+    return m_nodes;
 }
 
 Graph::NodeVector Graph::getNodesConnectedToNode(NodeS node) const
 {
     NodeVector result;
-    const auto edgesToNode = getEdgesToNode(node);
-    std::transform(std::begin(edgesToNode), std::end(edgesToNode), std::back_inserter(result), [this](auto && edge) { return getNode(edge->sourceNode().index()); });
+    const auto & edgesTo = edgesToNode(node->index());
+    const auto & edgesFrom = edgesFromNode(node->index());
+    result.reserve(edgesTo.size() + edgesFrom.size());
+    std::transform(std::begin(edgesTo), std::end(edgesTo), std::back_inserter(result), [this](auto && edge) { return getNode(edge->sourceNode().index()); });
+    std::transform(std::begin(edgesFrom), std::end(edgesFrom), std::back_inserter(result), [this](auto && edge) { return getNode(edge->targetNode().index()); });
+    return result;
+}
 
-    const auto edgesFromNode = getEdgesFromNode(node);
-    std::transform(std::begin(edgesFromNode), std::end(edgesFromNode), std::back_inserter(result), [this](auto && edge) { return getNode(edge->targetNode().index()); });
+int64_t Graph::buildKeyFromIndices(int index0, int index1)
+{
+    return (int64_t(index0) << 32) + index1;
+}
 
+Graph::NodeVector Graph::searchNodesByText(const QString & text) const
+{
+    NodeVector result;
+    for (auto && key : m_nodeTextIndex.search(text)) {
+        result.push_back(getNode(static_cast<int>(key)));
+    }
     return result;
 }
 
-int64_t Graph::buildKeyFromIndices(int index0, int index1) const
+Graph::EdgeVector Graph::searchEdgesByText(const QString & text) const
 {
-    return (int64_t(index0) << 32) + index1;
+    EdgeVector result;
+    for (auto && key : m_edgeTextIndex.search(text)) {
+        result.push_back(m_edges.at(key));
+    }
+    return result;
+}
+
+void Graph::indexEdgeLength(EdgeS edge)
+{
+    const auto key = buildKeyFromIndices(edge->sourceNode().index(), edge->targetNode().index());
+    m_edgeLengthStats.setLength(key, edge->length());
+    m_edgeLengthConnections[key] = QObject::connect(edge.get(), &SceneItems::Edge::lengthChanged, edge.get(), [this, key](double length) {
+        m_edgeLengthStats.setLength(key, length);
+    });
+}
+
+void Graph::indexEdgeStyle(EdgeS edge)
+{
+    m_edgeStyleConnections[buildKeyFromIndices(edge->sourceNode().index(), edge->targetNode().index())] = QObject::connect(edge.get(), &SceneItems::Edge::styleChanged, edge.get(), [this, edge = edge.get()] {
+        publishEdgeChange(GraphChange::Type::EdgeRestyled, *edge);
+    });
+}
+
+void Graph::indexEdgeText(EdgeS edge)
+{
+    const auto key = buildKeyFromIndices(edge->sourceNode().index(), edge->targetNode().index());
+    m_edgeTextIndex.setText(key, edge->text());
+    m_edgeTextConnections[key] = QObject::connect(edge.get(), &SceneItems::Edge::textChanged, edge.get(), [this, key, edge = edge.get()](const QString & text) {
+        m_edgeTextIndex.setText(key, text);
+        publishEdgeChange(GraphChange::Type::EdgeTexted, *edge);
+    });
+}
+
+void Graph::indexNodePlacement(NodeS node)
+{
+    const auto key = node->index();
+    const auto rect = node->placementBoundingRect().translated(node->location());
+    m_nodePlacementStats.setRect(key, rect);
+    m_nodeSpatialIndex.setRect(key, rect);
+    notifyPlacementChange(key, {});
+    m_nodePlacementConnections[key] = QObject::connect(node.get(), &SceneItems::Node::placementChanged, node.get(), [this, key, node = node.get()] {
+        const auto previousRect = m_nodeSpatialIndex.rect(key);
+        const auto rect = node->placementBoundingRect().translated(node->location());
+        m_nodePlacementStats.setRect(key, rect);
+        m_nodeSpatialIndex.setRect(key, rect);
+        notifyPlacementChange(key, previousRect);
+        m_changeNotifier.notify({ GraphChange::Type::NodeMoved, key });
+    });
+}
+
+void Graph::indexNodeStyle(NodeS node)
+{
+    const auto key = node->index();
+    m_nodeStyleConnections[key] = QObject::connect(node.get(), &SceneItems::Node::styleChanged, node.get(), [this, key] {
+        m_changeNotifier.notify({ GraphChange::Type::NodeRestyled, key });
+    });
+}
+
+void Graph::indexNodeText(NodeS node)
+{
+    const auto key = node->index();
+    m_nodeTextIndex.setText(key, node->text());
+    m_nodeTextConnections[key] = QObject::connect(node.get(), &SceneItems::Node::textChanged, node.get(), [this, key](const QString & text) {
+        m_nodeTextIndex.setText(key, text);
+        m_changeNotifier.notify({ GraphChange::Type::NodeTexted, key });
+    });
+}
+
+void Graph::unindexEdgeLength(EdgeCR edge)
+{
+    const auto key = buildKeyFromIndices(edge.sourceNode().index(), edge.targetNode().index());
+    disconnectIndex(m_edgeLengthConnections, key);
+    m_edgeLengthStats.remove(key);
+}
+
+void Graph::unindexEdgeStyle(EdgeCR edge)
+{
+    disconnectIndex(m_edgeStyleConnections, buildKeyFromIndices(edge.sourceNode().index(), edge.targetNode().index()));
+}
+
+void Graph::unindexEdgeText(EdgeCR edge)
+{
+    const auto key = buildKeyFromIndices(edge.sourceNode().index(), edge.targetNode().index());
+    disconnectIndex(m_edgeTextConnections, key);
+    m_edgeTextIndex.remove(key);
+}
+
+void Graph::unindexNodePlacement(NodeCR node)
+{
+    disconnectIndex(m_nodePlacementConnections, node.index());
+    m_nodePlacementStats.remove(node.index());
+    m_nodeSpatialIndex.remove(node.index());
+}
+
+void Graph::unindexNodeStyle(NodeCR node)
+{
+    disconnectIndex(m_nodeStyleConnections, node.index());
+}
+
+void Graph::unindexNodeText(NodeCR node)
+{
+    disconnectIndex(m_nodeTextConnections, node.index());
+    m_nodeTextIndex.remove(node.index());
+}
+
+size_t Graph::advanceEpoch()
+{
+    m_epoch++;
+
+    // Raw pointers held by Qt (animations, hover state, mouse actions) may outlive the deletion
+    // by an interaction, so keep items around for one full epoch before freeing them.
+    const size_t epochDelay = 2;
+    const auto isReclaimable = [this, epochDelay](auto && item, size_t epoch) {
+        return epoch + epochDelay <= m_epoch && !item->scene() && item.use_count() == 1;
+    };
+
+    // Edges refer to their nodes in their destructors, so free edges first
+    const auto edgeCountBefore = m_deletedEdges.size();
+    m_deletedEdges.erase(std::remove_if(m_deletedEdges.begin(), m_deletedEdges.end(), [&](auto && deleted) {
+                             return isReclaimable(deleted.edge, deleted.epoch);
+                         }),
+                         m_deletedEdges.end());
+
+    std::unordered_set<const SceneItems::Node *> referencedNodes;
+    for (auto && deleted : m_deletedEdges) {
+        referencedNodes.insert(&deleted.edge->sourceNode());
+        referencedNodes.insert(&deleted.edge->targetNode());
+    }
+
+    const auto nodeCountBefore = m_deletedNodes.size();
+    m_deletedNodes.erase(std::remove_if(m_deletedNodes.begin(), m_deletedNodes.end(), [&](auto && deleted) {
+                             return !referencedNodes.count(deleted.node.get()) && isReclaimable(deleted.node, deleted.epoch);
+                         }),
+                         m_deletedNodes.end());
+
+    const auto reclaimed = (edgeCountBefore - m_deletedEdges.size()) + (nodeCountBefore - m_deletedNodes.size());
+    if (reclaimed) {
+        juzzlin::L(TAG).debug() << "Reclaimed " << reclaimed << " deleted items, still holding " << m_deletedNodes.size() << " nodes and " << m_deletedEdges.size() << " edges";
+    }
+
+    return reclaimed;
+}
+
+size_t Graph::deletedNodeCount() const
+{
+    return m_deletedNodes.size();
+}
+
+size_t Graph::deletedEdgeCount() const
+{
+    return m_deletedEdges.size();
+}
+
+MemoryUsage Graph::memoryUsage() const
+{
+    MemoryUsage usage;
+    for (auto && node : m_nodes) {
+        usage += { 1, estimatedNodeSize(*node) };
+    }
+    for (auto && edge : m_edges) {
+        usage += { 1, estimatedEdgeSize(*edge.second) };
+    }
+    return usage;
+}
+
+MemoryUsage Graph::deletedMemoryUsage() const
+{
+    MemoryUsage usage;
+    for (auto && deletedNode : m_deletedNodes) {
+        usage += { 1, estimatedNodeSize(*deletedNode.node) };
+    }
+    for (auto && deletedEdge : m_deletedEdges) {
+        usage += { 1, estimatedEdgeSize(*deletedEdge.edge) };
+    }
+    return usage;
+}
+
+int Graph::slotOfNode(int index) const
+{
+    return index >= 0 && static_cast<size_t>(index) < m_nodeSlots.size() ? m_nodeSlots.at(static_cast<size_t>(index)) : -1;
+}
+
+void Graph::notifyEdgeChange(EdgeCR edge) const
+{
+    if (m_placementChangeCallback) {
+        m_placementChangeCallback(m_nodeSpatialIndex.rect(edge.sourceNode().index()).united(m_nodeSpatialIndex.rect(edge.targetNode().index())));
+    }
+}
+
+void Graph::publishEdgeChange(GraphChange::Type type, EdgeCR edge)
+{
+    m_changeNotifier.notify({ type, -1, edge.sourceNode().index(), edge.targetNode().index() });
+}
+
+void Graph::notifyPlacementChange(int index, const QRectF & previousRect) const
+{
+    if (!m_placementChangeCallback) {
+        return;
+    }
+
+    auto rect = previousRect.united(m_nodeSpatialIndex.rect(index));
+    for (auto && edge : edgesFromNode(index)) {
+        rect = rect.united(m_nodeSpatialIndex.rect(edge->targetNode().index()));
+    }
+    for (auto && edge : edgesToNode(index)) {
+        rect = rect.united(m_nodeSpatialIndex.rect(edge->sourceNode().index()));
+    }
+    m_placementChangeCallback(rect);
+}
+
+void Graph::removeFromAdjacency(EdgeCR edge)
+{
+    const auto removeFrom = [&edge](auto && adjacency, int index) {
+        if (const auto iter = adjacency.find(index); iter != adjacency.end()) {
+            auto && edges = iter->second;
+            edges.erase(std::remove_if(edges.begin(), edges.end(), [&edge](auto && candidate) { return candidate.get() == &edge; }), edges.end());
+            if (edges.empty()) {
+                adjacency.erase(iter);
+            }
+        }
+    };
+    removeFrom(m_outgoingEdges, edge.sourceNode().index());
+    removeFrom(m_incomingEdges, edge.targetNode().index());
 }
 
 Graph::~Graph()
@@ -19,14 +19,111 @@
 #include "../common/types.hpp"
 #include "../view/scene_items/edge.hpp"
 #include "../view/scene_items/node.hpp"
+#include "edge_length_stats.hpp"
+#include "graph_change_notifier.hpp"
+#include "memory_usage.hpp"
+#include "node_placement_stats.hpp"
+#include "node_spatial_index.hpp"
+#include "text_search_index.hpp"
 
+#include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <iterator>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 class Graph
 {
+private:
+    using NodeId = int32_t;
+
+    // Maps a connection hash (node id -> node id) to an Edge object
+    using ConnectionHash = int64_t;
+    using EdgeMap = std::unordered_map<ConnectionHash, EdgeS>;
+
 public:
+    //! Lightweight non-owning range over the values of an internal map.
+    //! Iteration yields const references, so no vectors get allocated and no refcounts get touched.
+    //! The range is invalidated if the graph is modified during iteration.
+    template<typename MapType>
+    class ValueRange
+    {
+    public:
+        class Iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = typename MapType::mapped_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const value_type *;
+            using reference = const value_type &;
+
+            explicit Iterator(typename MapType::const_iterator iter)
+              : m_iter(iter)
+            {
+            }
+
+            const typename MapType::mapped_type & operator*() const
+            {
+                return m_iter->second;
+            }
+
+            Iterator & operator++()
+            {
+                ++m_iter;
+                return *this;
+            }
+
+            bool operator==(const Iterator & other) const
+            {
+                return m_iter == other.m_iter;
+            }
+
+            bool operator!=(const Iterator & other) const
+            {
+                return m_iter != other.m_iter;
+            }
+
+        private:
+            typename MapType::const_iterator m_iter;
+        };
+
+        explicit ValueRange(const MapType & map)
+          : m_map(map)
+        {
+        }
+
+        Iterator begin() const
+        {
+            return Iterator(m_map.cbegin());
+        }
+
+        Iterator end() const
+        {
+            return Iterator(m_map.cend());
+        }
+
+        bool empty() const
+        {
+            return m_map.empty();
+        }
+
+        size_t size() const
+        {
+            return m_map.size();
+        }
+
+    private:
+        const MapType & m_map;
+    };
+
+    using EdgeRange = ValueRange<EdgeMap>;
+
+    //! \returns The connection hash of the edge from node index0 to node index1.
+    static int64_t buildKeyFromIndices(int index0, int index1);
+
     Graph();
 
     Graph(GraphCR other) = delete;
@@ -37,10 +134,36 @@ public:
 
     void clear();
 
+    //! The nodes and edges of a graph being torn down, see releaseItems().
+    struct Items
+    {
+        std::vector<EdgeS> edges;
+
+        std::vector<NodeS> nodes;
+    };
+
+    //! Moves all the nodes and edges, including the soft-deleted ones, out of the graph and clears it like clear().
+    //! The items are disconnected from the search and placement indices, so that the rest of the graph is plain data
+    //! that can be destroyed separately from the items, e.g. on a worker thread.
+    Items releaseItems();
+
+    //! \throws std::out_of_range if the index of the node is not valid, see isValidNodeIndex().
     void addNode(NodeS node);
 
+    //! \returns true if a node of the given index fits in a graph of the given node count. The indices of deleted
+    //! nodes are not reused, so the indices may be sparse, but every index up to the largest one takes a slot.
+    static bool isValidNodeIndex(int index, size_t nodeCount);
+
+    //! Reserves the storage of the given number of nodes, e.g. before restoring a snapshot, so that the indices of the
+    //! first nodes may already be as far apart as isValidNodeIndex() allows for all of them.
+    void reserveNodes(size_t count);
+
+    //! Adds the given new nodes in one go, e.g. when importing or pasting.
+    //! The nodes get consecutive indices starting from the next free index, in the given order.
+    void addNodes(const std::vector<NodeS> & nodes);
+
     //! "Soft deletes" the given node.
-    //! The node gets **really** deleted only when the Graph is deleted.
+    //! The node gets **really** deleted when it's reclaimed (see advanceEpoch()) or when the Graph is deleted.
     //! This is to help integration with Qt that operates only on raw pointers.
     //! \param index Index of the node to be deleted.
     //! \returns The deleted node and connected edges that were also removed.
@@ -49,8 +172,11 @@ public:
 
     void addEdge(EdgeS edge);
 
+    //! Adds the given edges in one go, see addEdge().
+    void addEdges(const EdgeVector & edges);
+
     //! "Soft deletes" the given edge.
-    //! The edge gets **really** deleted only when the Graph is deleted.
+    //! The edge gets **really** deleted when it's reclaimed (see advanceEpoch()) or when the Graph is deleted.
     //! This is to help integration with Qt that operates only on raw pointers.
     //! \param index0 Index of the source node.
     //! \param index1 Index of the target node.
@@ -65,35 +191,226 @@ public:
 
     size_t nodeCount() const;
 
+    //! \returns The index that the next node added without an index gets. Indices of deleted nodes are not reused.
+    int nextNodeIndex() const;
+
     EdgeS getEdge(int index0, int index1) const;
 
     EdgeVector getEdgesFromNode(NodeS node) const;
 
     EdgeVector getEdgesToNode(NodeS node) const;
 
+    //! Non-allocating view of the outgoing edges of the given node.
+    //! \returns Reference to the adjacency list or to an empty list if the node has no outgoing edges.
+    const EdgeVector & edgesFromNode(int index) const;
+
+    //! Non-allocating view of the incoming edges of the given node.
+    //! \returns Reference to the adjacency list or to an empty list if the node has no incoming edges.
+    const EdgeVector & edgesToNode(int index) const;
+
+    //! \returns Indices of the nodes reachable from the given node through outgoing edges, excluding the node itself.
+    std::unordered_set<int> descendantIndices(int index) const;
+
+    enum class TraversalDirection
+    {
+        Ancestors,
+        Descendants
+    };
+
+    //! Breadth-first traversal over the adjacency lists with the visited nodes marked in a flat bitset by node index,
+    //! so that selecting big branches doesn't hash every node.
+    //! \returns The given nodes followed by the nodes reachable from them in the given direction, each only once.
+    std::vector<int> traverse(const std::vector<int> & indices, TraversalDirection direction) const;
+
+    //! \returns Number of edges connected to the given node in O(1).
+    size_t degree(int index) const;
+
+    //! \returns Revision that changes whenever a node or an edge is added or deleted. Revisions are unique
+    //! across all graphs, so an equal revision also means the same graph, e.g. for caches computed from the topology.
+    size_t topologyRevision() const;
+
     EdgeVector getEdges() const;
 
+    //! \returns Non-allocating range over all edges.
+    EdgeRange edges() const;
+
+    //! Calls the given visitor for each edge without copying the edge list.
+    template<typename Visitor>
+    void forEachEdge(Visitor && visitor) const
+    {
+        for (auto && edge : m_edges) {
+            visitor(edge.second);
+        }
+    }
+
     NodeS getNode(int index) const;
 
+    bool hasNode(int index) const;
+
     using NodeVector = std::vector<NodeS>;
     NodeVector getNodes() const;
 
+    //! \returns Non-allocating view of the dense node storage.
+    const NodeVector & nodes() const;
+
+    //! Calls the given visitor for each node without copying the node list.
+    template<typename Visitor>
+    void forEachNode(Visitor && visitor) const
+    {
+        for (auto && node : m_nodes) {
+            visitor(node);
+        }
+    }
+
     NodeVector getNodesConnectedToNode(NodeS node) const;
 
+    //! Searches the text index, which follows the text changes of the items in the graph.
+    //! \returns Nodes whose text contains the given text case-insensitively, best matches first.
+    NodeVector searchNodesByText(const QString & text) const;
+
+    //! Searches the text index, which follows the text changes of the items in the graph.
+    //! \returns Edges whose text contains the given text case-insensitively, best matches first.
+    EdgeVector searchEdgesByText(const QString & text) const;
+
+    //! Advances the reclamation epoch and frees soft-deleted items that can't be referenced anymore.
+    //! An item is freed when it was deleted at least two epochs ago, it's no longer in a scene and
+    //! the graph holds the only reference to it. This should be called once per undo point.
+    //! \returns Number of items freed.
+    size_t advanceEpoch();
+
+    //! \returns Number of soft-deleted nodes still held by the graph.
+    size_t deletedNodeCount() const;
+
+    //! \returns Number of soft-deleted edges still held by the graph.
+    size_t deletedEdgeCount() const;
+
+    //! \returns Item count and estimated memory usage of the live nodes and edges.
+    MemoryUsage memoryUsage() const;
+
+    //! \returns Item count and estimated memory usage of the soft-deleted nodes and edges waiting for reclamation.
+    MemoryUsage deletedMemoryUsage() const;
+
+    //! \returns Length statistics of the edges, which follow the geometry changes of the edges in the graph.
+    const EdgeLengthStats & edgeLengthStats() const;
+
+    //! \returns Bounding rect and total area of the nodes, which follow the location and size changes of the nodes in the graph.
+    const NodePlacementStats & nodePlacementStats() const;
+
+    //! \returns Grid of the placement rects of the nodes by node index, which follows the location and size changes
+    //! of the nodes in the graph. Finds the nodes in a rect also without a scene, e.g. for placement and selection.
+    const NodeSpatialIndex & nodeSpatialIndex() const;
+
+    //! Called with the scene rect whose drawing is affected when a node is added, moved, resized or deleted,
+    //! including the edges of the node, or when an edge is added or deleted.
+    using PlacementChangeCallback = std::function<void(const QRectF & sceneRect)>;
+
+    //! Sets the callback of placement changes, e.g. for redrawing an overview of the graph. Clearing the graph doesn't call it.
+    void setPlacementChangeCallback(PlacementChangeCallback callback);
+
+    //! \returns The typed change stream of the graph for incremental consumers. Clearing or releasing the graph
+    //! doesn't notify, and the subscribers don't move to a graph that replaces this one, e.g. on undo.
+    GraphChangeNotifier & changeNotifier();
+
 private:
-    int64_t buildKeyFromIndices(int index0, int index1) const;
+    void indexEdgeLength(EdgeS edge);
 
-    // Maps node id (index) to a Node object
-    using NodeId = int32_t;
-    std::unordered_map<NodeId, NodeS> m_nodes;
+    void indexEdgeStyle(EdgeS edge);
 
-    // Maps a connection hash (node id -> node id) to an Edge object
-    using ConnectionHash = int64_t;
-    std::unordered_map<ConnectionHash, EdgeS> m_edges;
+    void indexEdgeText(EdgeS edge);
+
+    void indexNodePlacement(NodeS node);
+
+    void indexNodeStyle(NodeS node);
+
+    void indexNodeText(NodeS node);
+
+    void unindexEdgeLength(EdgeCR edge);
+
+    void unindexEdgeStyle(EdgeCR edge);
+
+    void unindexEdgeText(EdgeCR edge);
+
+    void unindexNodePlacement(NodeCR node);
+
+    void unindexNodeStyle(NodeCR node);
+
+    void unindexNodeText(NodeCR node);
+
+    void publishEdgeChange(GraphChange::Type type, EdgeCR edge);
+
+    void notifyEdgeChange(EdgeCR edge) const;
+
+    //! Unites the previous rect with the current rects of the node and its neighbors, as the edges move with the node.
+    void notifyPlacementChange(int index, const QRectF & previousRect) const;
+
+    void removeFromAdjacency(EdgeCR edge);
+
+    void updateTopologyRevision();
+
+    //! \returns Position of the node in the dense storage or -1 if not found.
+    int slotOfNode(int index) const;
+
+    // Dense, contiguous node storage. Deletion moves the last node into the freed slot.
+    NodeVector m_nodes;
+
+    // Maps node id (index) to a position in m_nodes, -1 marks an unused id
+    std::vector<int> m_nodeSlots;
+
+    EdgeMap m_edges;
+
+    // Per-node adjacency lists so that neighbour queries cost O(degree) instead of O(E)
+    std::unordered_map<NodeId, EdgeVector> m_outgoingEdges;
+
+    std::unordered_map<NodeId, EdgeVector> m_incomingEdges;
+
+    struct DeletedNode
+    {
+        NodeS node;
+
+        size_t epoch = 0;
+    };
+
+    std::vector<DeletedNode> m_deletedNodes;
+
+    struct DeletedEdge
+    {
+        EdgeS edge;
+
+        size_t epoch = 0;
+    };
+
+    std::vector<DeletedEdge> m_deletedEdges;
+
+    TextSearchIndex m_nodeTextIndex;
+
+    TextSearchIndex m_edgeTextIndex;
+
+    // Only these are disconnected when an item is unindexed, as others may follow the same signals, too
+    std::unordered_map<NodeId, QMetaObject::Connection> m_nodeTextConnections;
+
+    std::unordered_map<ConnectionHash, QMetaObject::Connection> m_edgeTextConnections;
+
+    std::unordered_map<ConnectionHash, QMetaObject::Connection> m_edgeLengthConnections;
+
+    std::unordered_map<NodeId, QMetaObject::Connection> m_nodePlacementConnections;
+
+    std::unordered_map<NodeId, QMetaObject::Connection> m_nodeStyleConnections;
+
+    std::unordered_map<ConnectionHash, QMetaObject::Connection> m_edgeStyleConnections;
+
+    EdgeLengthStats m_edgeLengthStats;
+
+    NodePlacementStats m_nodePlacementStats;
+
+    NodeSpatialIndex m_nodeSpatialIndex;
+
+    PlacementChangeCallback m_placementChangeCallback;
+
+    GraphChangeNotifier m_changeNotifier;
 
-    NodeVector m_deletedNodes;
+    size_t m_epoch = 0;
 
-    EdgeVector m_deletedEdges;
+    size_t m_topologyRevision = 0;
 
     int m_count = 0;
 };
@@ -0,0 +1,128 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "graph_change_notifier.hpp"
+
+#include <algorithm>
+
+GraphChangeNotifier::Batch::Batch(GraphChangeNotifier & notifier)
+  : m_notifier(notifier)
+{
+    m_notifier.beginBatch();
+}
+
+GraphChangeNotifier::Batch::~Batch()
+{
+    m_notifier.endBatch();
+}
+
+GraphChangeNotifier::GraphChangeNotifier() = default;
+
+GraphChangeNotifier::~GraphChangeNotifier() = default;
+
+GraphChangeNotifier::SubscriptionId GraphChangeNotifier::subscribe(Subscriber subscriber)
+{
+    const auto id = m_nextSubscriptionId++;
+    m_subscribers.push_back({ id, std::move(subscriber) });
+    return id;
+}
+
+void GraphChangeNotifier::unsubscribe(SubscriptionId id)
+{
+    m_subscribers.erase(std::remove_if(m_subscribers.begin(), m_subscribers.end(), [id](auto && subscriber) { return subscriber.first == id; }), m_subscribers.end());
+}
+
+bool GraphChangeNotifier::hasSubscribers() const
+{
+    return !m_subscribers.empty();
+}
+
+void GraphChangeNotifier::beginBatch()
+{
+    m_batchDepth++;
+}
+
+void GraphChangeNotifier::endBatch()
+{
+    if (!m_batchDepth || --m_batchDepth) {
+        return;
+    }
+
+    const auto changes = std::exchange(m_pendingChanges, {});
+    m_pendingCoalescedChanges.clear();
+    if (!changes.empty()) {
+        deliver(changes);
+    }
+}
+
+bool GraphChangeNotifier::isInBatch() const
+{
+    return m_batchDepth > 0;
+}
+
+void GraphChangeNotifier::notify(GraphChange change)
+{
+    if (m_subscribers.empty()) {
+        return;
+    }
+
+    if (!m_batchDepth) {
+        deliver({ change });
+        return;
+    }
+
+    if (isCoalesced(change.type) && !m_pendingCoalescedChanges.insert(change).second) {
+        return;
+    }
+
+    m_pendingChanges.push_back(change);
+}
+
+void GraphChangeNotifier::deliver(const GraphChangeBatch & changes)
+{
+    // A copy, as the subscribers may subscribe or unsubscribe meanwhile
+    const auto subscribers = m_subscribers;
+    for (auto && subscriber : subscribers) {
+        subscriber.second(changes);
+    }
+}
+
+bool GraphChangeNotifier::isCoalesced(GraphChange::Type type)
+{
+    switch (type) {
+    case GraphChange::Type::NodeMoved:
+    case GraphChange::Type::NodeRestyled:
+    case GraphChange::Type::NodeTexted:
+    case GraphChange::Type::EdgeRestyled:
+    case GraphChange::Type::EdgeTexted:
+    case GraphChange::Type::StyleChanged:
+        return true;
+    case GraphChange::Type::NodeAdded:
+    case GraphChange::Type::NodeRemoved:
+    case GraphChange::Type::EdgeAdded:
+    case GraphChange::Type::EdgeRemoved:
+        break;
+    }
+    return false;
+}
+
+size_t GraphChangeNotifier::GraphChangeHash::operator()(const GraphChange & change) const
+{
+    auto hash = static_cast<size_t>(change.type);
+    for (auto && index : { change.nodeIndex, change.sourceIndex, change.targetIndex }) {
+        hash = hash * 31 + static_cast<size_t>(static_cast<unsigned int>(index));
+    }
+    return hash;
+}
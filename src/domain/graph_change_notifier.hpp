@@ -0,0 +1,136 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef GRAPH_CHANGE_NOTIFIER_HPP
+#define GRAPH_CHANGE_NOTIFIER_HPP
+
+#include <cstddef>
+#include <functional>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+//! A change of the mind map as seen by the derived structures, e.g. caches, indices and stats.
+struct GraphChange
+{
+    enum class Type
+    {
+        NodeAdded,
+        NodeRemoved,
+        //! The location or the size of the node changed.
+        NodeMoved,
+        //! The color, the text color, the image or the collapsed state of the node changed.
+        NodeRestyled,
+        NodeTexted,
+        EdgeAdded,
+        EdgeRemoved,
+        //! The arrow mode, the dashing or the direction of the edge changed.
+        EdgeRestyled,
+        EdgeTexted,
+        //! The global style of the mind map, e.g. the colors or the edge width, changed.
+        StyleChanged
+    };
+
+    Type type;
+
+    //! -1 for edge and style changes.
+    int nodeIndex = -1;
+
+    //! -1 for node and style changes.
+    int sourceIndex = -1;
+
+    int targetIndex = -1;
+
+    bool operator==(const GraphChange & other) const
+    {
+        return type == other.type && nodeIndex == other.nodeIndex && sourceIndex == other.sourceIndex && targetIndex == other.targetIndex;
+    }
+};
+
+using GraphChangeBatch = std::vector<GraphChange>;
+
+//! Typed change stream of a Graph and its MindMapData, so that derived structures can update incrementally
+//! instead of rescanning the graph. Subscribers are registered once and get the changes in batches: between
+//! beginBatch() and the outermost endBatch(), e.g. during an editor transaction or an undo, the changes are
+//! collected and delivered together in order. Repeated moves, restyles and text changes of the same item are
+//! delivered only once per batch. Outside of batches each change is delivered right away.
+//! Without subscribers notifying costs a single check.
+class GraphChangeNotifier
+{
+public:
+    using Subscriber = std::function<void(const GraphChangeBatch & changes)>;
+
+    using SubscriptionId = size_t;
+
+    //! Starts a batch for the lifetime of the guard.
+    class Batch
+    {
+    public:
+        explicit Batch(GraphChangeNotifier & notifier);
+
+        ~Batch();
+
+        Batch(const Batch &) = delete;
+
+        Batch & operator=(const Batch &) = delete;
+
+    private:
+        GraphChangeNotifier & m_notifier;
+    };
+
+    GraphChangeNotifier();
+
+    ~GraphChangeNotifier();
+
+    //! \returns Id for unsubscribe(). Subscribers may unsubscribe while being called.
+    SubscriptionId subscribe(Subscriber subscriber);
+
+    void unsubscribe(SubscriptionId id);
+
+    bool hasSubscribers() const;
+
+    //! Batches can be nested.
+    void beginBatch();
+
+    //! Delivers the collected changes when the outermost batch ends. Does nothing if no batch is open.
+    void endBatch();
+
+    bool isInBatch() const;
+
+    void notify(GraphChange change);
+
+private:
+    void deliver(const GraphChangeBatch & changes);
+
+    //! \returns true if the given change is kept only once per batch.
+    static bool isCoalesced(GraphChange::Type type);
+
+    std::vector<std::pair<SubscriptionId, Subscriber>> m_subscribers;
+
+    SubscriptionId m_nextSubscriptionId = 1;
+
+    size_t m_batchDepth = 0;
+
+    GraphChangeBatch m_pendingChanges;
+
+    struct GraphChangeHash
+    {
+        size_t operator()(const GraphChange & change) const;
+    };
+
+    std::unordered_set<GraphChange, GraphChangeHash> m_pendingCoalescedChanges;
+};
+
+#endif // GRAPH_CHANGE_NOTIFIER_HPP
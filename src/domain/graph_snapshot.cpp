@@ -0,0 +1,410 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "graph_snapshot.hpp"
+
+#include "graph.hpp"
+
+#include <QDataStream>
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+bool nodeDataEquals(const SceneItems::NodeModel & node0, const SceneItems::NodeModel & node1)
+{
+    return node0.index == node1.index && node0.color == node1.color && node0.imageRef == node1.imageRef && node0.location == node1.location //
+      && node0.size == node1.size && node0.textColor == node1.textColor && node0.text == node1.text && node0.collapsed == node1.collapsed //
+      && node0.uuid == node1.uuid;
+}
+
+bool edgeDataEquals(const GraphSnapshot::EdgeData & edge0, const GraphSnapshot::EdgeData & edge1)
+{
+    const auto & style0 = edge0.model.style;
+    const auto & style1 = edge1.model.style;
+    return edge0.sourceIndex == edge1.sourceIndex && edge0.targetIndex == edge1.targetIndex && edge0.model.reversed == edge1.model.reversed //
+      && style0.arrowMode == style1.arrowMode && style0.arrowSize == style1.arrowSize && style0.dashedLine == style1.dashedLine //
+      && style0.edgeWidth == style1.edgeWidth && edge0.model.text == edge1.model.text;
+}
+
+int64_t edgeKey(const GraphSnapshot::EdgeData & edge)
+{
+    return (int64_t(edge.sourceIndex) << 32) + edge.targetIndex;
+}
+
+// The smallest records that writeNodes() and writeEdges() write, i.e. with empty texts
+const qint64 MIN_NODE_RECORD_SIZE = 87;
+
+const qint64 MIN_EDGE_RECORD_SIZE = 34;
+
+//! \returns The given count limited to the records that the rest of the stream can hold, so that
+//! a corrupted count can't reserve more memory than the data itself takes.
+size_t reservableCount(QDataStream & in, quint32 count, qint64 minRecordSize)
+{
+    const auto available = in.device() ? std::max<qint64>(0, in.device()->bytesAvailable()) : 0;
+    return static_cast<size_t>(std::min<qint64>(count, available / minRecordSize));
+}
+
+void writeNodes(QDataStream & out, const GraphSnapshot::NodeDataVector & nodes)
+{
+    out << static_cast<quint32>(nodes.size());
+    for (auto && node : nodes) {
+        out << node.index << node.color << static_cast<quint64>(node.imageRef) << node.location << node.size << node.textColor << node.text << node.collapsed << node.uuid;
+    }
+}
+
+GraphSnapshot::NodeDataVector readNodes(QDataStream & in)
+{
+    GraphSnapshot::NodeDataVector nodes;
+    quint32 nodeCount = 0;
+    in >> nodeCount;
+    nodes.reserve(reservableCount(in, nodeCount, MIN_NODE_RECORD_SIZE));
+    for (quint32 i = 0; i < nodeCount && in.status() == QDataStream::Ok; i++) {
+        SceneItems::NodeModel node { {}, {} };
+        quint64 imageRef = 0;
+        in >> node.index >> node.color >> imageRef >> node.location >> node.size >> node.textColor >> node.text >> node.collapsed >> node.uuid;
+        node.imageRef = static_cast<size_t>(imageRef);
+        if (node.index < 0) {
+            in.setStatus(QDataStream::ReadCorruptData);
+        }
+        nodes.push_back(node);
+    }
+    return nodes;
+}
+
+void writeEdges(QDataStream & out, const GraphSnapshot::EdgeDataVector & edges)
+{
+    out << static_cast<quint32>(edges.size());
+    for (auto && edge : edges) {
+        const auto & style = edge.model.style;
+        out << edge.sourceIndex << edge.targetIndex << edge.model.reversed << static_cast<int>(style.arrowMode) //
+            << style.arrowSize << style.dashedLine << style.edgeWidth << edge.model.text;
+    }
+}
+
+GraphSnapshot::EdgeDataVector readEdges(QDataStream & in)
+{
+    GraphSnapshot::EdgeDataVector edges;
+    quint32 edgeCount = 0;
+    in >> edgeCount;
+    edges.reserve(reservableCount(in, edgeCount, MIN_EDGE_RECORD_SIZE));
+    for (quint32 i = 0; i < edgeCount && in.status() == QDataStream::Ok; i++) {
+        GraphSnapshot::EdgeData edge { { false, SceneItems::EdgeModel::Style { SceneItems::EdgeModel::ArrowMode::Single } }, -1, -1 };
+        int arrowMode = 0;
+        auto & style = edge.model.style;
+        in >> edge.sourceIndex >> edge.targetIndex >> edge.model.reversed >> arrowMode >> style.arrowSize >> style.dashedLine >> style.edgeWidth >> edge.model.text;
+        style.arrowMode = static_cast<SceneItems::EdgeModel::ArrowMode>(arrowMode);
+        if (edge.sourceIndex < 0 || edge.targetIndex < 0 || arrowMode < static_cast<int>(SceneItems::EdgeModel::ArrowMode::Single) || arrowMode > static_cast<int>(SceneItems::EdgeModel::ArrowMode::Hidden)) {
+            in.setStatus(QDataStream::ReadCorruptData);
+        }
+        edges.push_back(edge);
+    }
+    return edges;
+}
+
+} // namespace
+
+void GraphSnapshot::NodeIndexSet::insert(int index)
+{
+    if (m_isDense && index == m_denseCount) {
+        m_denseCount++;
+        return;
+    }
+
+    if (m_isDense) {
+        m_isDense = false;
+        for (int denseIndex = 0; denseIndex < m_denseCount; denseIndex++) {
+            m_sparseIndices.insert(denseIndex);
+        }
+    }
+    m_sparseIndices.insert(index);
+}
+
+bool GraphSnapshot::NodeIndexSet::contains(int index) const
+{
+    return m_isDense ? index >= 0 && index < m_denseCount : m_sparseIndices.count(index) > 0;
+}
+
+GraphSnapshot::GraphSnapshot(GraphCR graph)
+{
+    m_nodes.reserve(graph.nodeCount());
+    for (auto && node : graph.nodes()) {
+        m_nodes.push_back(node->model());
+    }
+
+    m_edges.reserve(graph.edgeCount());
+    for (auto && edge : graph.edges()) {
+        m_edges.push_back({ edge->model(), edge->sourceNode().index(), edge->targetNode().index() });
+    }
+}
+
+GraphSnapshot::GraphSnapshot(NodeDataVector nodes, EdgeDataVector edges)
+  : m_nodes(std::move(nodes))
+  , m_edges(std::move(edges))
+{
+}
+
+void GraphSnapshot::restore(GraphR graph, const NodeFactory & nodeFactory) const
+{
+    graph.reserveNodes(graph.nodeCount() + m_nodes.size());
+    for (auto && model : m_nodes) {
+        graph.addNode(nodeFactory ? nodeFactory(model) : std::make_shared<SceneItems::Node>(model));
+    }
+
+    for (auto && edgeData : m_edges) {
+        graph.addEdge(std::make_shared<SceneItems::Edge>(edgeData.model, graph.getNode(edgeData.sourceIndex).get(), graph.getNode(edgeData.targetIndex).get()));
+    }
+}
+
+const GraphSnapshot::NodeDataVector & GraphSnapshot::nodes() const
+{
+    return m_nodes;
+}
+
+const GraphSnapshot::EdgeDataVector & GraphSnapshot::edges() const
+{
+    return m_edges;
+}
+
+GraphSnapshot::EdgeDataVector GraphSnapshot::edgesBySourceNode() const
+{
+    std::unordered_map<int, size_t> nodePositions;
+    for (size_t i = 0; i < m_nodes.size(); i++) {
+        nodePositions[m_nodes.at(i).index] = i;
+    }
+
+    auto edges = m_edges;
+    std::stable_sort(edges.begin(), edges.end(), [&nodePositions](auto && edge0, auto && edge1) {
+        return nodePositions.at(edge0.sourceIndex) < nodePositions.at(edge1.sourceIndex);
+    });
+    return edges;
+}
+
+bool GraphSnapshot::hasDenseIndices() const
+{
+    for (size_t i = 0; i < m_nodes.size(); i++) {
+        if (m_nodes.at(i).index != static_cast<int>(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+GraphSnapshot::IndexMap GraphSnapshot::denseIndexMap() const
+{
+    int maxIndex = -1;
+    for (auto && node : m_nodes) {
+        maxIndex = std::max(maxIndex, node.index);
+    }
+
+    // Marking the indices in place yields them in ascending order without sorting
+    IndexMap indexMap(static_cast<size_t>(maxIndex + 1), -1);
+    for (auto && node : m_nodes) {
+        indexMap.at(static_cast<size_t>(node.index)) = 0;
+    }
+    int rank = 0;
+    for (auto && mappedIndex : indexMap) {
+        if (mappedIndex == 0) {
+            mappedIndex = rank++;
+        }
+    }
+    return indexMap;
+}
+
+GraphSnapshot GraphSnapshot::renumbered(const IndexMap & indexMap) const
+{
+    NodeDataVector nodes(m_nodes.size(), SceneItems::NodeModel { {}, {} });
+    for (auto && node : m_nodes) {
+        const auto index = indexMap.at(static_cast<size_t>(node.index));
+        nodes.at(static_cast<size_t>(index)) = node;
+        nodes.at(static_cast<size_t>(index)).index = index;
+    }
+
+    EdgeDataVector edges = m_edges;
+    for (auto && edge : edges) {
+        edge.sourceIndex = indexMap.at(static_cast<size_t>(edge.sourceIndex));
+        edge.targetIndex = indexMap.at(static_cast<size_t>(edge.targetIndex));
+    }
+
+    return { std::move(nodes), std::move(edges) };
+}
+
+GraphSnapshot GraphSnapshot::densified() const
+{
+    return hasDenseIndices() ? *this : renumbered(denseIndexMap());
+}
+
+bool GraphSnapshot::equals(const SceneItems::NodeModel & node0, const SceneItems::NodeModel & node1)
+{
+    return nodeDataEquals(node0, node1);
+}
+
+bool GraphSnapshot::equals(const EdgeData & edge0, const EdgeData & edge1)
+{
+    return edgeDataEquals(edge0, edge1);
+}
+
+bool GraphSnapshot::Delta::isEmpty() const
+{
+    return removedNodes.empty() && addedNodes.empty() && removedEdges.empty() && addedEdges.empty();
+}
+
+void GraphSnapshot::Delta::reverse()
+{
+    std::swap(removedNodes, addedNodes);
+    std::swap(removedEdges, addedEdges);
+}
+
+GraphSnapshot::Delta GraphSnapshot::diff(const GraphSnapshot & from, const GraphSnapshot & to)
+{
+    Delta delta;
+
+    std::unordered_map<int, const SceneItems::NodeModel *> fromNodes;
+    for (auto && node : from.m_nodes) {
+        fromNodes[node.index] = &node;
+    }
+    for (auto && node : to.m_nodes) {
+        if (const auto iter = fromNodes.find(node.index); iter != fromNodes.end()) {
+            if (!nodeDataEquals(*iter->second, node)) {
+                delta.removedNodes.push_back(*iter->second);
+                delta.addedNodes.push_back(node);
+            }
+            fromNodes.erase(iter);
+        } else {
+            delta.addedNodes.push_back(node);
+        }
+    }
+    for (auto && node : from.m_nodes) {
+        if (fromNodes.count(node.index)) {
+            delta.removedNodes.push_back(node);
+        }
+    }
+
+    std::unordered_map<int64_t, const EdgeData *> fromEdges;
+    for (auto && edge : from.m_edges) {
+        fromEdges[edgeKey(edge)] = &edge;
+    }
+    for (auto && edge : to.m_edges) {
+        if (const auto iter = fromEdges.find(edgeKey(edge)); iter != fromEdges.end()) {
+            if (!edgeDataEquals(*iter->second, edge)) {
+                delta.removedEdges.push_back(*iter->second);
+                delta.addedEdges.push_back(edge);
+            }
+            fromEdges.erase(iter);
+        } else {
+            delta.addedEdges.push_back(edge);
+        }
+    }
+    for (auto && edge : from.m_edges) {
+        if (fromEdges.count(edgeKey(edge))) {
+            delta.removedEdges.push_back(edge);
+        }
+    }
+
+    return delta;
+}
+
+void GraphSnapshot::apply(const Delta & delta, bool reverse)
+{
+    const auto & removedNodes = reverse ? delta.addedNodes : delta.removedNodes;
+    const auto & addedNodes = reverse ? delta.removedNodes : delta.addedNodes;
+    if (!removedNodes.empty()) {
+        std::unordered_set<int> removedIndices;
+        for (auto && node : removedNodes) {
+            removedIndices.insert(node.index);
+        }
+        m_nodes.erase(std::remove_if(m_nodes.begin(), m_nodes.end(), [&](auto && node) { return removedIndices.count(node.index); }), m_nodes.end());
+    }
+    m_nodes.insert(m_nodes.end(), addedNodes.begin(), addedNodes.end());
+
+    const auto & removedEdges = reverse ? delta.addedEdges : delta.removedEdges;
+    const auto & addedEdges = reverse ? delta.removedEdges : delta.addedEdges;
+    if (!removedEdges.empty()) {
+        std::unordered_set<int64_t> removedKeys;
+        for (auto && edge : removedEdges) {
+            removedKeys.insert(edgeKey(edge));
+        }
+        m_edges.erase(std::remove_if(m_edges.begin(), m_edges.end(), [&](auto && edge) { return removedKeys.count(edgeKey(edge)); }), m_edges.end());
+    }
+    m_edges.insert(m_edges.end(), addedEdges.begin(), addedEdges.end());
+}
+
+size_t GraphSnapshot::estimatedNodesSize(const NodeDataVector & nodes)
+{
+    size_t size = nodes.capacity() * sizeof(SceneItems::NodeModel);
+    for (auto && node : nodes) {
+        size += node.text.estimatedSize();
+    }
+    return size;
+}
+
+size_t GraphSnapshot::estimatedEdgesSize(const EdgeDataVector & edges)
+{
+    size_t size = edges.capacity() * sizeof(EdgeData);
+    for (auto && edge : edges) {
+        size += edge.model.text.estimatedSize();
+    }
+    return size;
+}
+
+size_t GraphSnapshot::Delta::estimatedSize() const
+{
+    return estimatedNodesSize(removedNodes) + estimatedNodesSize(addedNodes) + estimatedEdgesSize(removedEdges) + estimatedEdgesSize(addedEdges);
+}
+
+size_t GraphSnapshot::estimatedSize() const
+{
+    return estimatedNodesSize(m_nodes) + estimatedEdgesSize(m_edges);
+}
+
+QByteArray GraphSnapshot::toCompressedData() const
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    writeNodes(out, m_nodes);
+    writeEdges(out, m_edges);
+    return qCompress(data);
+}
+
+GraphSnapshot GraphSnapshot::fromCompressedData(const QByteArray & compressedData)
+{
+    GraphSnapshot snapshot;
+    const auto data = qUncompress(compressedData);
+    QDataStream in(data);
+    snapshot.m_nodes = readNodes(in);
+    snapshot.m_edges = readEdges(in);
+    return snapshot;
+}
+
+void GraphSnapshot::Delta::write(QDataStream & out) const
+{
+    writeNodes(out, removedNodes);
+    writeNodes(out, addedNodes);
+    writeEdges(out, removedEdges);
+    writeEdges(out, addedEdges);
+}
+
+GraphSnapshot::Delta GraphSnapshot::Delta::read(QDataStream & in)
+{
+    Delta delta;
+    delta.removedNodes = readNodes(in);
+    delta.addedNodes = readNodes(in);
+    delta.removedEdges = readEdges(in);
+    delta.addedEdges = readEdges(in);
+    return delta;
+}
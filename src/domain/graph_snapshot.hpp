@@ -0,0 +1,164 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef GRAPH_SNAPSHOT_HPP
+#define GRAPH_SNAPSHOT_HPP
+
+#include "../common/types.hpp"
+#include "../view/scene_items/edge_model.hpp"
+#include "../view/scene_items/node_model.hpp"
+
+#include <QByteArray>
+
+#include <functional>
+
+#include <unordered_set>
+#include <vector>
+
+class QDataStream;
+
+//! Plain-data copy of a Graph that doesn't contain any scene items.
+//! Taking and copying a snapshot is cheap compared to copying the actual
+//! QGraphicsItem-based nodes and edges, which get created only on restore().
+class GraphSnapshot
+{
+public:
+    struct EdgeData
+    {
+        SceneItems::EdgeModel model;
+
+        int sourceIndex = -1;
+
+        int targetIndex = -1;
+    };
+
+    using NodeDataVector = std::vector<SceneItems::NodeModel>;
+
+    using EdgeDataVector = std::vector<EdgeData>;
+
+    //! New node index by old node index, or -1 for indices that aren't used.
+    using IndexMap = std::vector<int>;
+
+    //! Difference between two snapshots. Changed items are stored as removed old + added new,
+    //! so a delta can be applied in both directions.
+    struct Delta
+    {
+        NodeDataVector removedNodes;
+
+        NodeDataVector addedNodes;
+
+        EdgeDataVector removedEdges;
+
+        EdgeDataVector addedEdges;
+
+        bool isEmpty() const;
+
+        //! Swaps the removed and the added items, so that the delta turns snapshot "to" back into "from".
+        void reverse();
+
+        //! \returns Rough estimate of the memory used by the delta in bytes.
+        size_t estimatedSize() const;
+
+        //! Serializes the delta e.g. for the autosave journal.
+        void write(QDataStream & out) const;
+
+        static Delta read(QDataStream & in);
+    };
+
+    //! Indices of the nodes read so far, e.g. to check the edges of a file. As long as the nodes come in the order
+    //! of their indices 0..n-1, like in files saved with dense indices, a lookup is just a comparison of the index.
+    //! Older files may have gaps in the indices, and then the indices are hashed instead.
+    class NodeIndexSet
+    {
+    public:
+        void insert(int index);
+
+        bool contains(int index) const;
+
+    private:
+        int m_denseCount = 0;
+
+        bool m_isDense = true;
+
+        std::unordered_set<int> m_sparseIndices;
+    };
+
+    GraphSnapshot() = default;
+
+    explicit GraphSnapshot(GraphCR graph);
+
+    //! Creates a snapshot from models read e.g. from a file. Edges refer to nodes by index.
+    GraphSnapshot(NodeDataVector nodes, EdgeDataVector edges);
+
+    using NodeFactory = std::function<NodeS(const SceneItems::NodeModel &)>;
+
+    //! Creates scene items for the snapshot and adds them to the given graph. The nodes are created
+    //! by the given factory, if any, e.g. to create them directly in the style of the mind map.
+    void restore(GraphR graph, const NodeFactory & nodeFactory = {}) const;
+
+    const NodeDataVector & nodes() const;
+
+    const EdgeDataVector & edges() const;
+
+    //! \returns The edges grouped by their source nodes in the order of the nodes, like they are written to files.
+    EdgeDataVector edgesBySourceNode() const;
+
+    //! \returns true if the node indices are the positions of the nodes, i.e. 0..n-1 in order, as in saved files.
+    bool hasDenseIndices() const;
+
+    //! \returns Map that numbers the nodes 0..n-1 in the order of their current indices.
+    IndexMap denseIndexMap() const;
+
+    //! \returns Copy of the snapshot with the nodes and edges renumbered by the given map and the nodes in the new order.
+    //! The map must number all the nodes 0..n-1, like denseIndexMap().
+    GraphSnapshot renumbered(const IndexMap & indexMap) const;
+
+    //! \returns The snapshot as it's saved to files, i.e. renumbered by denseIndexMap() unless it's dense already.
+    GraphSnapshot densified() const;
+
+    //! \returns true if all the data of the given nodes is equal.
+    static bool equals(const SceneItems::NodeModel & node0, const SceneItems::NodeModel & node1);
+
+    //! \returns true if all the data of the given edges is equal.
+    static bool equals(const EdgeData & edge0, const EdgeData & edge1);
+
+    //! \returns Delta that turns snapshot from into snapshot to.
+    static Delta diff(const GraphSnapshot & from, const GraphSnapshot & to);
+
+    //! Applies the given delta to this snapshot.
+    //! \param reverse Undo the delta instead, i.e. turn snapshot "to" back into "from".
+    void apply(const Delta & delta, bool reverse = false);
+
+    //! \returns Rough estimate of the memory used by the snapshot in bytes.
+    size_t estimatedSize() const;
+
+    //! \returns Rough estimate of the memory used by the given node data in bytes.
+    static size_t estimatedNodesSize(const NodeDataVector & nodes);
+
+    //! \returns Rough estimate of the memory used by the given edge data in bytes.
+    static size_t estimatedEdgesSize(const EdgeDataVector & edges);
+
+    //! \returns Compact, compressed binary form of the snapshot.
+    QByteArray toCompressedData() const;
+
+    static GraphSnapshot fromCompressedData(const QByteArray & data);
+
+private:
+    NodeDataVector m_nodes;
+
+    EdgeDataVector m_edges;
+};
+
+#endif // GRAPH_SNAPSHOT_HPP
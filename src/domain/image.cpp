@@ -14,20 +14,114 @@
 // along with Heimer. If not, see <http://www.gnu.org/licenses/>.
 
 #include "image.hpp"
+#include "image_decoder.hpp"
+
+#include <QBuffer>
+#include <QFileInfo>
+#include <QImageWriter>
+
+static QByteArray encode(const QImage & image, const std::string & path)
+{
+    if (image.isNull()) {
+        return {};
+    }
+
+    auto format = QFileInfo(path.c_str()).suffix().toLower().toLatin1();
+    if (!QImageWriter::supportedImageFormats().contains(format)) {
+        format = "png";
+    }
+
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, format.constData());
+    return data;
+}
 
 Image::Image()
 {
 }
 
-Image::Image(QImage image, std::string path)
-  : m_image(image)
-  , m_path(path)
+Image::Image(QImage image, std::string path, QByteArray data)
+  : m_path(path)
 {
+    if (data.isEmpty()) {
+        data = encode(image, path);
+    }
+
+    if (!image.isNull() || !data.isEmpty()) {
+        m_decoder = ImageDecoder::create(data, image);
+    }
+}
+
+Image Image::fromEncodedData(QByteArray data, std::string path)
+{
+    return { {}, path, data };
 }
 
 QImage Image::image() const
 {
-    return m_image;
+    return m_decoder ? m_decoder->image() : QImage {};
+}
+
+bool Image::isDecoded() const
+{
+    return !m_decoder || m_decoder->isFinished();
+}
+
+QImage Image::level(QSize size) const
+{
+    return m_decoder && m_decoder->isFinished() ? m_decoder->level(size) : QImage {};
+}
+
+void Image::requestDecode() const
+{
+    if (m_decoder) {
+        m_decoder->requestDecode();
+    }
+}
+
+bool Image::isVector() const
+{
+    return m_decoder && m_decoder->isVector();
+}
+
+bool Image::hasLevel(QSize size) const
+{
+    return m_decoder && m_decoder->hasLevel(size);
+}
+
+void Image::requestLevel(QSize size) const
+{
+    if (m_decoder) {
+        m_decoder->requestLevel(size);
+    }
+}
+
+bool Image::isVectorFileName(const QString & fileName)
+{
+    const auto suffix = QFileInfo(fileName).suffix().toLower();
+    return suffix == "svg" || suffix == "svgz";
+}
+
+qint64 Image::cacheKey() const
+{
+    return m_decoder ? m_decoder->cacheKey() : 0;
+}
+
+ImageDecoder * Image::decoder() const
+{
+    return m_decoder.get();
+}
+
+QByteArray Image::data() const
+{
+    return m_decoder ? m_decoder->data() : QByteArray {};
+}
+
+QString Image::mimeType() const
+{
+    return m_decoder ? m_decoder->mimeType() : QString {};
 }
 
 std::string Image::path() const
@@ -35,6 +129,11 @@ std::string Image::path() const
     return m_path;
 }
 
+size_t Image::estimatedSize() const
+{
+    return m_decoder ? m_decoder->residentBytes() : 0;
+}
+
 size_t Image::id() const
 {
     return m_id;
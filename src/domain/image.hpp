@@ -16,27 +16,76 @@
 #ifndef IMAGE_HPP
 #define IMAGE_HPP
 
+#include <QByteArray>
 #include <QImage>
+#include <QSize>
+#include <QString>
 
+#include <memory>
 #include <string>
 
+class ImageDecoder;
+
 class Image
 {
 public:
     Image();
 
-    Image(QImage image, std::string path);
+    //! \param data The encoded image file contents as read from disk or from a mind map file.
+    //!        If empty, the image is encoded once here based on the suffix of the path.
+    Image(QImage image, std::string path, QByteArray data = {});
+
+    //! Creates an image that gets decoded from the given data in the background on request.
+    static Image fromEncodedData(QByteArray data, std::string path);
 
+    //! \return The decoded image. Waits for the background decoding if it's in progress or decodes synchronously.
     QImage image() const;
 
+    bool isDecoded() const;
+
+    //! \return The smallest downscaled level of the image that still covers the given size in pixels,
+    //! see ImageDecoder. Shared by all copies of the image. Null until the image is decoded.
+    QImage level(QSize size) const;
+
+    //! Starts decoding the image and its levels in the background, e.g. when a node showing it gets painted.
+    void requestDecode() const;
+
+    //! \return True if the image is an SVG image that gets rendered at the resolution it's shown at.
+    bool isVector() const;
+
+    //! \return True if level() can return an image covering the given size in pixels without rendering, see ImageDecoder.
+    bool hasLevel(QSize size) const;
+
+    //! Starts rendering an SVG image for the given size in pixels in the background.
+    void requestLevel(QSize size) const;
+
+    //! \return True if the file name has the suffix of an SVG image, which doesn't need an image format plugin.
+    static bool isVectorFileName(const QString & fileName);
+
+    //! \return Key that is the same for all copies of the image and unique otherwise, or 0 for a null image.
+    qint64 cacheKey() const;
+
+    //! \return The decoder that notifies when the background decoding is finished, or nullptr.
+    ImageDecoder * decoder() const;
+
+    //! \return The encoded image file contents that get embedded into saved mind maps.
+    QByteArray data() const;
+
+    //! \return MIME type of the encoded data, e.g. "image/jpeg", or an empty string if there's no data.
+    QString mimeType() const;
+
     std::string path() const;
 
+    //! \return Rough estimate of the memory used by the encoded data, the decoded image and its levels in bytes.
+    //! Data that has been moved to the sidecar file, see ImageDecoder, doesn't count.
+    size_t estimatedSize() const;
+
     size_t id() const;
 
     void setId(size_t id);
 
 private:
-    QImage m_image;
+    std::shared_ptr<ImageDecoder> m_decoder;
 
     std::string m_path;
 
@@ -0,0 +1,524 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "image_decoder.hpp"
+
+#include "../application/service_container.hpp"
+#include "../application/task_pool.hpp"
+#include "../common/constants.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QMimeDatabase>
+#include <QPainter>
+#include <QSvgRenderer>
+#include <QTemporaryFile>
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <list>
+#include <unordered_map>
+
+static const auto TAG = "ImageDecoder";
+
+namespace {
+
+//! All decoders that hold memory, the most recently used first.
+struct MemoryAccounting
+{
+    std::mutex mutex;
+
+    using List = std::list<const ImageDecoder *>;
+    List decoders;
+
+    std::unordered_map<const ImageDecoder *, std::pair<List::iterator, size_t>> entries;
+
+    size_t bytes = 0;
+
+    size_t cap = 0;
+};
+
+MemoryAccounting & memoryAccounting()
+{
+    static MemoryAccounting accounting;
+    return accounting;
+}
+
+//! Encoded data of released decoders. The data is only appended, and the file
+//! gets removed when the application exits.
+class SidecarFile
+{
+public:
+    //! \return The offset of the data in the file or -1 on failure.
+    qint64 write(const QByteArray & data)
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_file.isOpen() && !m_file.open()) {
+            juzzlin::L(TAG).error() << "Cannot open sidecar file: " << m_file.errorString().toStdString();
+            return -1;
+        }
+
+        const auto offset = m_file.size();
+        if (!m_file.seek(offset) || m_file.write(data) != data.size()) {
+            juzzlin::L(TAG).error() << "Cannot write sidecar file: " << m_file.errorString().toStdString();
+            return -1;
+        }
+
+        return offset;
+    }
+
+    QByteArray read(qint64 offset, int size)
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_file.seek(offset)) {
+            juzzlin::L(TAG).error() << "Cannot read sidecar file: " << m_file.errorString().toStdString();
+            return {};
+        }
+
+        return m_file.read(size);
+    }
+
+private:
+    std::mutex m_mutex;
+
+    QTemporaryFile m_file;
+};
+
+SidecarFile & sidecarFile()
+{
+    static SidecarFile file;
+    return file;
+}
+
+std::atomic<qint64> cacheKeyCounter { 0 };
+
+size_t imageBytes(const QImage & image)
+{
+    return static_cast<size_t>(image.bytesPerLine()) * static_cast<size_t>(image.height());
+}
+
+bool isVectorMimeType(const QString & mimeType)
+{
+    return mimeType == "image/svg+xml" || mimeType == "image/svg+xml-compressed";
+}
+
+bool covers(QSize size, QSize target)
+{
+    return size.width() >= target.width() && size.height() >= target.height();
+}
+
+//! \return The size that covers the given size with the aspect ratio of the given default size.
+QSize vectorLevelSize(QSize defaultSize, QSize size)
+{
+    if (defaultSize.isEmpty()) {
+        return size;
+    }
+
+    const auto scale = std::max(static_cast<double>(size.width()) / defaultSize.width(), static_cast<double>(size.height()) / defaultSize.height());
+    QSize levelSize { static_cast<int>(std::ceil(defaultSize.width() * scale)), static_cast<int>(std::ceil(defaultSize.height() * scale)) };
+    if (const auto maxSize = Constants::Image::maxVectorLevelSize(); std::max(levelSize.width(), levelSize.height()) > maxSize) {
+        levelSize.scale(maxSize, maxSize, Qt::KeepAspectRatio);
+    }
+    return levelSize.expandedTo({ 1, 1 });
+}
+
+//! Renders the SVG data at the given size or at its default size if the given size is empty.
+QImage renderVector(const QByteArray & data, QSize size)
+{
+    // A renderer of its own for each rendering, as the renderers are not thread-safe
+    QSvgRenderer renderer { data };
+    if (!renderer.isValid()) {
+        juzzlin::L(TAG).error() << "Could not parse SVG image of " << data.size() << " bytes";
+        return {};
+    }
+
+    if (size.isEmpty()) {
+        size = renderer.defaultSize().isEmpty() ? QSize { Constants::Image::minLevelSize(), Constants::Image::minLevelSize() } : renderer.defaultSize();
+    }
+
+    QImage image { size, QImage::Format_ARGB32_Premultiplied };
+    image.fill(Qt::transparent);
+    QPainter painter { &image };
+    painter.setRenderHint(QPainter::Antialiasing);
+    renderer.render(&painter);
+    return image;
+}
+
+std::vector<QImage> buildLevels(const QImage & image)
+{
+    std::vector<QImage> levels;
+    auto level = image;
+    while (std::min(level.width(), level.height()) / 2 >= Constants::Image::minLevelSize()) {
+        level = level.scaled(level.size() / 2, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        levels.push_back(level);
+    }
+    return levels;
+}
+
+} // namespace
+
+ImageDecoder::ImageDecoder(QByteArray data, QImage image)
+  : m_data(data)
+  , m_dataSize(data.size())
+  , m_mimeType(data.isEmpty() ? QString {} : QMimeDatabase().mimeTypeForData(data).name())
+  , m_isVector(isVectorMimeType(m_mimeType))
+  , m_image(image)
+  , m_cacheKey(++cacheKeyCounter)
+{
+}
+
+std::shared_ptr<ImageDecoder> ImageDecoder::create(QByteArray data, QImage image)
+{
+    // The last reference may be dropped by the decoding thread, so let the owning thread delete it
+    const std::shared_ptr<ImageDecoder> decoder(new ImageDecoder(data, image), [](ImageDecoder * decoder) {
+        if (QThread::currentThread() == decoder->thread()) {
+            delete decoder;
+        } else {
+            decoder->deleteLater();
+        }
+    });
+    decoder->updateAccounting();
+    return decoder;
+}
+
+void ImageDecoder::requestDecode()
+{
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_state != State::NotDecoded) {
+            return;
+        }
+        m_state = State::Decoding;
+    }
+
+    SC::instance().taskPool()->start([decoder = shared_from_this()](auto &&) {
+        decoder->decode();
+    });
+}
+
+void ImageDecoder::decode()
+{
+    QImage image;
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        image = m_image;
+        m_state = State::Decoding;
+    }
+
+    if (image.isNull()) {
+        if (m_isVector) {
+            image = renderVector(data(), {});
+        } else if (const auto encoded = data(); !image.loadFromData(encoded)) {
+            juzzlin::L(TAG).error() << "Could not decode image of " << encoded.size() << " bytes";
+        }
+    }
+
+    // The levels of SVG images are rendered at the resolution they are requested at
+    auto levels = m_isVector ? std::vector<QImage> {} : buildLevels(image);
+
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        m_image = image;
+        m_levels = std::move(levels);
+        m_state = State::Decoded;
+    }
+    m_condition.notify_all();
+
+    updateAccounting();
+
+    emit finished();
+}
+
+bool ImageDecoder::isFinished() const
+{
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    return m_state == State::Decoded;
+}
+
+bool ImageDecoder::isVector() const
+{
+    return m_isVector;
+}
+
+bool ImageDecoder::hasLevel(QSize size) const
+{
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_state != State::Decoded) {
+        return false;
+    }
+
+    if (!m_isVector || m_image.isNull()) {
+        return true;
+    }
+
+    const auto target = vectorLevelSize(m_image.size(), size);
+    return covers(m_image.size(), target) || (!m_levels.empty() && covers(m_levels.front().size(), target));
+}
+
+void ImageDecoder::requestLevel(QSize size)
+{
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_isVector || m_state != State::Decoded || (!m_pendingLevelSize.isEmpty() && covers(m_pendingLevelSize, vectorLevelSize(m_image.size(), size)))) {
+            return;
+        }
+        m_pendingLevelSize = vectorLevelSize(m_image.size(), size);
+    }
+
+    SC::instance().taskPool()->start([decoder = shared_from_this(), size](auto &&) {
+        decoder->renderLevel(size);
+    });
+}
+
+void ImageDecoder::renderLevel(QSize size)
+{
+    QSize defaultSize;
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_isVector || m_state != State::Decoded) {
+            return;
+        }
+        defaultSize = m_image.size();
+    }
+
+    const auto levelSize = vectorLevelSize(defaultSize, size);
+    auto level = renderVector(data(), levelSize);
+
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pendingLevelSize == levelSize) {
+            m_pendingLevelSize = {};
+        }
+        // Released meanwhile, e.g. over the memory cap
+        if (m_state != State::Decoded) {
+            return;
+        }
+        m_levels = { level };
+    }
+
+    updateAccounting();
+
+    emit finished();
+}
+
+void ImageDecoder::waitForDecoding(std::unique_lock<std::mutex> & lock) const
+{
+    m_condition.wait(lock, [this] { return m_state != State::Decoding; });
+}
+
+QImage ImageDecoder::image() const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    waitForDecoding(lock);
+    if (m_state == State::Decoded || !m_image.isNull()) {
+        const auto image = m_image;
+        lock.unlock();
+        touch();
+        return image;
+    }
+    lock.unlock();
+
+    // The levels are only prepared by the background decoding
+    const auto encoded = data();
+    juzzlin::L(TAG).debug() << "Decoding image of " << encoded.size() << " bytes synchronously";
+    QImage image;
+    if (m_isVector) {
+        if (image = renderVector(encoded, {}); image.isNull()) {
+            return {};
+        }
+    } else if (!image.loadFromData(encoded)) {
+        juzzlin::L(TAG).error() << "Could not decode image of " << encoded.size() << " bytes";
+        return {};
+    }
+
+    lock.lock();
+    m_image = image;
+    lock.unlock();
+
+    updateAccounting();
+
+    return image;
+}
+
+QImage ImageDecoder::level(QSize size) const
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        waitForDecoding(lock);
+        if (m_state == State::Decoded) {
+            for (auto iter = m_levels.rbegin(); iter != m_levels.rend(); iter++) {
+                if (iter->width() >= size.width() && iter->height() >= size.height()) {
+                    return *iter;
+                }
+            }
+            // Scaled up until the rendering for the size is ready
+            if (m_isVector && !m_levels.empty() && !covers(m_image.size(), size) && m_levels.front().width() > m_image.width()) {
+                return m_levels.front();
+            }
+        }
+    }
+
+    return image();
+}
+
+QByteArray ImageDecoder::data() const
+{
+    qint64 offset = 0;
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_dataOffset < 0) {
+            return m_data;
+        }
+        offset = m_dataOffset;
+    }
+
+    return sidecarFile().read(offset, m_dataSize);
+}
+
+QString ImageDecoder::mimeType() const
+{
+    return m_mimeType;
+}
+
+bool ImageDecoder::isDataOnDisk() const
+{
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dataOffset >= 0;
+}
+
+size_t ImageDecoder::residentBytes() const
+{
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    size_t bytes = static_cast<size_t>(m_data.size()) + imageBytes(m_image);
+    for (auto && level : m_levels) {
+        bytes += imageBytes(level);
+    }
+    return bytes;
+}
+
+qint64 ImageDecoder::cacheKey() const
+{
+    return m_cacheKey;
+}
+
+void ImageDecoder::setMemoryCap(size_t bytes)
+{
+    auto && accounting = memoryAccounting();
+    const std::lock_guard<std::mutex> lock(accounting.mutex);
+    accounting.cap = bytes;
+    releaseOverCap(nullptr);
+}
+
+void ImageDecoder::updateAccounting() const
+{
+    // Only decoders that can decode the image again can be released
+    if (!m_dataSize) {
+        return;
+    }
+
+    const auto bytes = residentBytes();
+
+    auto && accounting = memoryAccounting();
+    const std::lock_guard<std::mutex> lock(accounting.mutex);
+    if (const auto iter = accounting.entries.find(this); iter != accounting.entries.end()) {
+        accounting.bytes -= iter->second.second;
+        accounting.decoders.splice(accounting.decoders.begin(), accounting.decoders, iter->second.first);
+        iter->second.second = bytes;
+    } else {
+        accounting.decoders.push_front(this);
+        accounting.entries[this] = { accounting.decoders.begin(), bytes };
+    }
+    accounting.bytes += bytes;
+
+    releaseOverCap(this);
+}
+
+void ImageDecoder::touch() const
+{
+    auto && accounting = memoryAccounting();
+    const std::lock_guard<std::mutex> lock(accounting.mutex);
+    if (const auto iter = accounting.entries.find(this); iter != accounting.entries.end()) {
+        accounting.decoders.splice(accounting.decoders.begin(), accounting.decoders, iter->second.first);
+    }
+}
+
+void ImageDecoder::release() const
+{
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_dataOffset < 0) {
+        // Keep the data in memory if it can't be written
+        if (const auto offset = sidecarFile().write(m_data); offset >= 0) {
+            m_dataOffset = offset;
+            m_data = {};
+        }
+    }
+
+    // An ongoing decoding accounts for its result when it's done
+    if (m_state != State::Decoding) {
+        m_image = {};
+        m_levels.clear();
+        m_state = State::NotDecoded;
+    }
+}
+
+size_t ImageDecoder::releasableBytes()
+{
+    auto && accounting = memoryAccounting();
+    const std::lock_guard<std::mutex> lock(accounting.mutex);
+    return accounting.bytes;
+}
+
+size_t ImageDecoder::trim(size_t bytes)
+{
+    auto && accounting = memoryAccounting();
+    const std::lock_guard<std::mutex> lock(accounting.mutex);
+    const auto bytesBefore = accounting.bytes;
+    releaseOver(bytes, nullptr);
+    return bytesBefore - accounting.bytes;
+}
+
+void ImageDecoder::releaseOverCap(const ImageDecoder * keep)
+{
+    if (const auto cap = memoryAccounting().cap; cap) {
+        releaseOver(cap, keep);
+    }
+}
+
+void ImageDecoder::releaseOver(size_t bytes, const ImageDecoder * keep)
+{
+    auto && accounting = memoryAccounting();
+    while (accounting.bytes > bytes && !accounting.decoders.empty() && accounting.decoders.back() != keep) {
+        const auto decoder = accounting.decoders.back();
+        const auto iter = accounting.entries.find(decoder);
+        juzzlin::L(TAG).debug() << "Releasing image of " << iter->second.second << " resident bytes";
+        decoder->release();
+        accounting.bytes -= iter->second.second;
+        accounting.entries.erase(iter);
+        accounting.decoders.pop_back();
+    }
+}
+
+ImageDecoder::~ImageDecoder()
+{
+    auto && accounting = memoryAccounting();
+    const std::lock_guard<std::mutex> lock(accounting.mutex);
+    if (const auto iter = accounting.entries.find(this); iter != accounting.entries.end()) {
+        accounting.bytes -= iter->second.second;
+        accounting.decoders.erase(iter->second.first);
+        accounting.entries.erase(iter);
+    }
+}
@@ -0,0 +1,177 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef IMAGE_DECODER_HPP
+#define IMAGE_DECODER_HPP
+
+#include <QByteArray>
+#include <QImage>
+#include <QObject>
+#include <QSize>
+#include <QString>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//! Decodes encoded image data on the shared task pool so that loading a mind map
+//! doesn't block on image decoding. Shared by all copies of an Image.
+//!
+//! Nothing is decoded until requested, normally when a node showing the image gets painted,
+//! so images of nodes that are never viewed stay encoded. The decoding also prepares
+//! power-of-two downscaled levels of the image, so that nodes can be painted from a level close
+//! to their size on screen.
+//!
+//! SVG images are kept as source and decoded at their default size only. The levels of an SVG image
+//! are rendered on request at the resolution they are shown at instead, see requestLevel(), so they
+//! stay sharp when zoomed in and their memory follows the displayed resolution.
+//!
+//! The encoded data and the decoded images of all decoders are kept under a common memory cap:
+//! the least recently used decoders drop their decoded images and move their encoded data to a
+//! temporary sidecar file, from where it's read again when the image is needed.
+class ImageDecoder : public QObject, public std::enable_shared_from_this<ImageDecoder>
+{
+    Q_OBJECT
+
+public:
+    //! \param image Already decoded image, if any. The levels still get prepared on request.
+    explicit ImageDecoder(QByteArray data, QImage image = {});
+
+    ~ImageDecoder() override;
+
+    //! Creates a decoder that doesn't decode anything until requested.
+    //! \param data The encoded image that the image can be decoded again from if it gets released.
+    static std::shared_ptr<ImageDecoder> create(QByteArray data, QImage image = {});
+
+    //! Starts decoding the data on the shared task pool unless already decoded or being decoded.
+    void requestDecode();
+
+    //! Decodes the data and prepares the levels synchronously. Normally called by the task pool.
+    void decode();
+
+    bool isFinished() const;
+
+    //! \return True if the data is an SVG image.
+    bool isVector() const;
+
+    //! \return True if level() returns an image that covers the given size in pixels, which is always
+    //! the case for decoded raster images. SVG images need to be rendered for the size, see requestLevel().
+    bool hasLevel(QSize size) const;
+
+    //! Starts rendering an SVG image to cover the given size in pixels on the shared task pool
+    //! unless already rendered or being rendered. Emits finished() when done.
+    void requestLevel(QSize size);
+
+    //! Renders an SVG image to cover the given size in pixels synchronously. Normally called by the task pool.
+    //! The rendering replaces the previous one, so only the latest resolution is kept.
+    void renderLevel(QSize size);
+
+    //! \return The full resolution image. Waits for the decoding if it's in progress or decodes synchronously if not requested.
+    QImage image() const;
+
+    //! \return The smallest level that still covers the given size in pixels, or the full resolution image
+    //! if the levels are not ready. Waits for the decoding if it's in progress. For SVG images the
+    //! largest rendering is returned if none covers the size.
+    QImage level(QSize size) const;
+
+    //! \return The encoded data, which is read from the sidecar file if it has been moved there.
+    QByteArray data() const;
+
+    //! \return MIME type of the encoded data, e.g. "image/jpeg", detected from its contents.
+    QString mimeType() const;
+
+    //! \return True if the encoded data has been moved to the sidecar file.
+    bool isDataOnDisk() const;
+
+    //! \return Number of bytes of the encoded data, the full resolution image and the levels currently held in memory.
+    size_t residentBytes() const;
+
+    //! \return Unique key of the decoded image, e.g. for pixmap caches. Doesn't change when the image is decoded again.
+    qint64 cacheKey() const;
+
+    //! Sets the cap of the memory held by all decoders.
+    //! \param bytes The cap in bytes or 0 for "unlimited".
+    static void setMemoryCap(size_t bytes);
+
+    //! \return The bytes held by all decoders that can decode their image again.
+    static size_t releasableBytes();
+
+    //! Releases the least recently used decoders until at most the given bytes are held, e.g. when memory runs low.
+    //! \return The released bytes.
+    static size_t trim(size_t bytes);
+
+signals:
+
+    //! Emitted from the decoding thread when the image and the levels are available, or when an SVG level has been rendered.
+    void finished();
+
+private:
+    enum class State
+    {
+        NotDecoded,
+        Decoding,
+        Decoded
+    };
+
+    void waitForDecoding(std::unique_lock<std::mutex> & lock) const;
+
+    //! Updates the memory accounting with the current resident bytes and releases least recently used decoders over the cap.
+    void updateAccounting() const;
+
+    //! Marks the decoder as used most recently.
+    void touch() const;
+
+    //! Releases the decoded images and moves the encoded data to the sidecar file.
+    //! Called with the lock of the memory accounting held.
+    void release() const;
+
+    //! Releases least recently used decoders until the cap is met. Called with the lock of the memory accounting held.
+    //! \param keep Decoder that must not be released, e.g. the one whose accounting is being updated.
+    static void releaseOverCap(const ImageDecoder * keep);
+
+    //! Releases least recently used decoders until at most the given bytes are held. Called with the lock of the memory accounting held.
+    static void releaseOver(size_t bytes, const ImageDecoder * keep);
+
+    //! Empty when moved to the sidecar file, see m_dataOffset.
+    mutable QByteArray m_data;
+
+    //! Offset of the encoded data in the sidecar file or -1.
+    mutable qint64 m_dataOffset = -1;
+
+    const int m_dataSize;
+
+    const QString m_mimeType;
+
+    const bool m_isVector;
+
+    mutable QImage m_image;
+
+    //! Levels of half, quarter, ... of the full resolution, or the latest rendering of an SVG image.
+    mutable std::vector<QImage> m_levels;
+
+    //! Size of the SVG rendering in progress, if any.
+    QSize m_pendingLevelSize;
+
+    mutable State m_state = State::NotDecoded;
+
+    const qint64 m_cacheKey;
+
+    mutable std::mutex m_mutex;
+
+    mutable std::condition_variable m_condition;
+};
+
+#endif // IMAGE_DECODER_HPP
@@ -19,23 +19,31 @@
 
 #include "simple_logger.hpp"
 
+#include <QCryptographicHash>
+
 #include <algorithm>
 
 static const auto TAG = "ImageManager";
 
-ImageManager::ImageManager() = default;
+ImageManager::ImageManager()
+  : m_images(std::make_shared<ImageMap>())
+  , m_hashes(std::make_shared<HashMap>())
+{
+}
 
 ImageManager::ImageManager(const ImageManager & other)
   : QObject()
+  , m_images(other.m_images)
+  , m_hashes(other.m_hashes)
+  , m_count(other.m_count)
 {
-    m_images = other.m_images;
-    m_count = other.m_count;
 }
 
 ImageManager & ImageManager::operator=(const ImageManager & other)
 {
     if (this != &other) {
         m_images = other.m_images;
+        m_hashes = other.m_hashes;
         m_count = other.m_count;
     }
     return *this;
@@ -43,9 +51,18 @@ ImageManager & ImageManager::operator=(const ImageManager & other)
 
 size_t ImageManager::addImage(const Image & image)
 {
+    if (const auto existingId = findImageByData(image.data()); existingId.has_value()) {
+        juzzlin::L(TAG).debug() << "Reusing identical image, path=" << image.path() << ", id=" << *existingId;
+        return *existingId;
+    }
+
+    detach();
+
     const auto id = ++m_count;
-    m_images[id] = image;
-    m_images[id].setId(id);
+    auto && newImage = (*m_images)[id];
+    newImage = image;
+    newImage.setId(id);
+    indexImage(newImage);
 
     juzzlin::L(TAG).debug() << "Adding new image, path=" << image.path() << ", id=" << id;
 
@@ -60,36 +77,93 @@ void ImageManager::setImage(const Image & image)
         throw std::runtime_error("Image must have id > 0 !");
     }
 
-    if (!image.image().size().height() || !image.image().size().width()) {
+    // Don't wait for images that are still being decoded in the background
+    if (image.isDecoded() && (!image.image().size().height() || !image.image().size().width())) {
         juzzlin::L(TAG).warning() << "QImage size is zero!";
     }
 
+    detach();
+
     m_count = std::max(image.id(), m_count);
-    m_images[image.id()] = image;
+    unindexImage(image.id());
+    (*m_images)[image.id()] = image;
+    indexImage(image);
+}
+
+const Image * ImageManager::getImage(size_t id) const
+{
+    const auto iter = m_images->find(id);
+    return iter != m_images->end() ? &iter->second : nullptr;
 }
 
-std::optional<Image> ImageManager::getImage(size_t id)
+std::optional<size_t> ImageManager::findImageByData(const QByteArray & data) const
 {
-    if (m_images.count(id)) {
-        return { m_images[id] };
+    if (data.isEmpty()) {
+        return {};
+    }
+
+    if (const auto iter = m_hashes->find(hashOf(data)); iter != m_hashes->end()) {
+        // Compare the data as well so that a hash collision can never merge different images
+        if (const auto imageIter = m_images->find(iter->second); imageIter != m_images->end() && imageIter->second.data() == data) {
+            return iter->second;
+        }
     }
     return {};
 }
 
 void ImageManager::handleImageRequest(size_t id, NodeR node)
 {
-    if (const auto && imagePair = getImage(id); imagePair.has_value()) {
+    if (const auto image = getImage(id); image) {
+        // The node requests the decoding when it gets painted and shows a placeholder until it's done
         juzzlin::L(TAG).debug() << "Applying image id=" << id << " to node " << node.index();
-        node.applyImage(*imagePair);
+        node.applyImage(*image);
     } else {
         juzzlin::L(TAG).warning() << "Cannot find image with id=" << id;
     }
 }
 
-ImageManager::ImageVector ImageManager::images() const
+ImageManager::ImageRange ImageManager::images() const
+{
+    return ImageRange { m_images };
+}
+
+MemoryUsage ImageManager::memoryUsage() const
+{
+    MemoryUsage usage;
+    for (auto && image : *m_images) {
+        usage += { 1, image.second.estimatedSize() };
+    }
+    return usage;
+}
+
+QByteArray ImageManager::hashOf(const QByteArray & data)
+{
+    return QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+}
+
+void ImageManager::indexImage(const Image & image)
+{
+    // Images without encoded data are never considered identical
+    if (const auto data = image.data(); !data.isEmpty()) {
+        m_hashes->emplace(hashOf(data), image.id());
+    }
+}
+
+void ImageManager::unindexImage(size_t id)
+{
+    if (const auto iter = m_images->find(id); iter != m_images->end() && !iter->second.data().isEmpty()) {
+        if (const auto hashIter = m_hashes->find(hashOf(iter->second.data())); hashIter != m_hashes->end() && hashIter->second == id) {
+            m_hashes->erase(hashIter);
+        }
+    }
+}
+
+void ImageManager::detach()
 {
-    ImageVector images;
-    std::transform(std::begin(m_images), std::end(m_images), std::back_inserter(images),
-                   [](auto && image) { return image.second; });
-    return images;
+    if (m_images.use_count() > 1) {
+        m_images = std::make_shared<ImageMap>(*m_images);
+    }
+    if (m_hashes.use_count() > 1) {
+        m_hashes = std::make_shared<HashMap>(*m_hashes);
+    }
 }
@@ -19,11 +19,15 @@
 #include <QObject>
 
 #include <map>
+#include <memory>
 #include <optional>
+#include <unordered_map>
 
 #include "../common/types.hpp"
 #include "image.hpp"
+#include "memory_usage.hpp"
 
+//! Stores the images of a mind map. Copies share the image records until either one is modified.
 class ImageManager : public QObject
 {
     Q_OBJECT
@@ -31,23 +35,118 @@ class ImageManager : public QObject
 public:
     ImageManager();
 
+    //! Copy constructor. Cheap, because the image records are shared copy-on-write.
     ImageManager(const ImageManager & other);
 
     ImageManager & operator=(const ImageManager & other);
 
+    //! Adds the image unless an image with exactly the same encoded data already exists.
+    //! \returns Id of the added image or of the existing identical image.
     size_t addImage(const Image & image);
 
     void setImage(const Image & image);
 
-    std::optional<Image> getImage(size_t id);
+    //! \returns The image with the given id or nullptr. Valid until the image manager is modified.
+    const Image * getImage(size_t id) const;
+
+    //! \returns Id of an image that has exactly the given encoded data, e.g. when pasting a copied image.
+    //! Looked up by the content hash of the data.
+    std::optional<size_t> findImageByData(const QByteArray & data) const;
 
     void handleImageRequest(size_t id, NodeR node);
 
-    using ImageVector = std::vector<Image>;
-    ImageVector images() const;
+private:
+    using ImageMap = std::unordered_map<size_t, Image>;
+
+public:
+    //! Iterates the images in no particular order without copying them. Keeps the iterated
+    //! image records alive even if the image manager is modified meanwhile.
+    class ImageRange
+    {
+    public:
+        class const_iterator
+        {
+        public:
+            explicit const_iterator(ImageMap::const_iterator iter)
+              : m_iter(iter)
+            {
+            }
+
+            const Image & operator*() const
+            {
+                return m_iter->second;
+            }
+
+            const Image * operator->() const
+            {
+                return &m_iter->second;
+            }
+
+            const_iterator & operator++()
+            {
+                ++m_iter;
+                return *this;
+            }
+
+            bool operator!=(const const_iterator & other) const
+            {
+                return m_iter != other.m_iter;
+            }
+
+        private:
+            ImageMap::const_iterator m_iter;
+        };
+
+        explicit ImageRange(std::shared_ptr<const ImageMap> images)
+          : m_images(images)
+        {
+        }
+
+        const_iterator begin() const
+        {
+            return const_iterator { m_images->cbegin() };
+        }
+
+        const_iterator end() const
+        {
+            return const_iterator { m_images->cend() };
+        }
+
+        size_t size() const
+        {
+            return m_images->size();
+        }
+
+        bool empty() const
+        {
+            return m_images->empty();
+        }
+
+    private:
+        std::shared_ptr<const ImageMap> m_images;
+    };
+
+    ImageRange images() const;
+
+    //! \returns Image count and estimated memory usage of the encoded and decoded images.
+    MemoryUsage memoryUsage() const;
 
 private:
-    std::map<size_t, Image> m_images;
+    //! Clones the shared image records before modification.
+    void detach();
+
+    //! \returns Content hash of the encoded image data.
+    static QByteArray hashOf(const QByteArray & data);
+
+    void indexImage(const Image & image);
+
+    void unindexImage(size_t id);
+
+    std::shared_ptr<ImageMap> m_images;
+
+    //! Maps content hashes of the encoded image data to image ids. Shared copy-on-write like m_images.
+    using HashMap = std::map<QByteArray, size_t>;
+    std::shared_ptr<HashMap> m_hashes;
 
     size_t m_count = 0;
 };
@@ -0,0 +1,78 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "incremental_layout.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+// The locations are tried on square rings around the requested one up to this many steps away
+static const int MAX_RING_COUNT = 32;
+
+// Tried locations closer than this are too slow to search, so small grids are searched with a multiple of their size
+static const double MIN_STEP = 10;
+
+// Cost per unit the edge from the parent gets longer than at the requested location
+static const double PARENT_DISTANCE_WEIGHT = 1;
+
+IncrementalLayout::IncrementalLayout(const NodeSpatialIndex & nodeSpatialIndex, double step, double spacing)
+  : m_nodeSpatialIndex(nodeSpatialIndex)
+  , m_step(step > 0 ? std::ceil(MIN_STEP / step) * step : MIN_STEP)
+  , m_spacing(spacing)
+{
+}
+
+bool IncrementalLayout::isFree(const QRectF & rect, NodeSpatialIndex::Key ignoredKey) const
+{
+    return m_nodeSpatialIndex.isFree(rect.adjusted(-m_spacing, -m_spacing, m_spacing, m_spacing), ignoredKey);
+}
+
+QPointF IncrementalLayout::findFreeOffset(const QRectF & rect, std::optional<QPointF> parentLocation, NodeSpatialIndex::Key ignoredKey) const
+{
+    if (isFree(rect, ignoredKey)) {
+        return {};
+    }
+
+    const auto cost = [&](const QPointF & offset) {
+        double cost = std::hypot(offset.x(), offset.y());
+        if (parentLocation) {
+            const auto requested = rect.center() - *parentLocation;
+            const auto moved = requested + offset;
+            cost += PARENT_DISTANCE_WEIGHT * std::max(0.0, std::hypot(moved.x(), moved.y()) - std::hypot(requested.x(), requested.y()));
+        }
+        return cost;
+    };
+
+    std::optional<QPointF> bestOffset;
+    double bestCost = std::numeric_limits<double>::max();
+    // All locations of a ring are at least its radius away, so the search stops when a ring can't beat the best cost
+    for (int ring = 1; ring <= MAX_RING_COUNT && ring * m_step < bestCost; ring++) {
+        for (int row = -ring; row <= ring; row++) {
+            // The inner rows only have their two ends on the ring
+            const int columnStep = std::abs(row) == ring ? 1 : 2 * ring;
+            for (int column = -ring; column <= ring; column += columnStep) {
+                const QPointF offset { column * m_step, row * m_step };
+                if (const auto offsetCost = cost(offset); offsetCost < bestCost && isFree(rect.translated(offset), ignoredKey)) {
+                    bestOffset = offset;
+                    bestCost = offsetCost;
+                }
+            }
+        }
+    }
+
+    return bestOffset.value_or(QPointF {});
+}
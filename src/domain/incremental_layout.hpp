@@ -0,0 +1,52 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef INCREMENTAL_LAYOUT_HPP
+#define INCREMENTAL_LAYOUT_HPP
+
+#include <QPointF>
+#include <QRectF>
+
+#include <optional>
+
+#include "node_spatial_index.hpp"
+
+//! Finds free space for new nodes near where they were requested, so that adding nodes doesn't need a full
+//! re-optimization and the existing nodes are never moved. The tried locations are tested against the spatial
+//! index of the nodes, so the cost doesn't grow with the size of the mind map.
+class IncrementalLayout
+{
+public:
+    //! \param step Distance of the tried locations, e.g. the grid size so that snapped locations stay snapped. 0 for any.
+    //! \param spacing Minimum free space between a placed rect and the existing nodes.
+    IncrementalLayout(const NodeSpatialIndex & nodeSpatialIndex, double step, double spacing);
+
+    //! \returns The offset by which the given rect can be moved so that it doesn't overlap the existing nodes. Of the
+    //! free locations the one closest to the requested one is chosen, but locations that make the edge from the given
+    //! parent location longer are penalized. A null offset if the rect is already free or there's no free space nearby.
+    //! \param ignoredKey Key of the placed node in the index if it has been added to the graph already.
+    QPointF findFreeOffset(const QRectF & rect, std::optional<QPointF> parentLocation = {}, NodeSpatialIndex::Key ignoredKey = -1) const;
+
+private:
+    bool isFree(const QRectF & rect, NodeSpatialIndex::Key ignoredKey) const;
+
+    const NodeSpatialIndex & m_nodeSpatialIndex;
+
+    double m_step;
+
+    double m_spacing;
+};
+
+#endif // INCREMENTAL_LAYOUT_HPP
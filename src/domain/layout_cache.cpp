@@ -0,0 +1,158 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "layout_cache.hpp"
+
+#include "graph.hpp"
+#include "graph_snapshot.hpp"
+
+#include "../view/scene_items/edge.hpp"
+#include "../view/scene_items/node.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Sizes and parameters are rounded to this precision so that they stay the same when saved and loaded
+static const double PRECISION = 1000;
+
+static void combine(LayoutCache::Key & hash, int64_t value)
+{
+    // splitmix64 finalizer, so that e.g. nearby indices don't collide when combined
+    auto z = static_cast<uint64_t>(value) + 0x9e3779b97f4a7c15;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    hash = (hash ^ (z ^ (z >> 31))) * 0x100000001b3;
+}
+
+static int64_t rounded(double value)
+{
+    return std::llround(value * PRECISION);
+}
+
+LayoutCache::LayoutCache(size_t capacity)
+  : m_capacity(capacity)
+{
+}
+
+LayoutCache::Key LayoutCache::topologyKey(GraphCR graph)
+{
+    NodeVector nodes;
+    for (auto && node : graph.nodes()) {
+        // Whole pixels, because the sizes are rounded to different precisions when saved and measured
+        nodes.push_back({ node->index(), { std::llround(node->size().width()), std::llround(node->size().height()) } });
+    }
+    EdgeVector edges;
+    for (auto && edge : graph.getEdges()) {
+        edges.emplace_back(edge->sourceNode().index(), edge->targetNode().index());
+    }
+    return topologyKey(std::move(nodes), std::move(edges));
+}
+
+LayoutCache::Key LayoutCache::topologyKey(const GraphSnapshot & graphSnapshot)
+{
+    NodeVector nodes;
+    for (auto && node : graphSnapshot.nodes()) {
+        nodes.push_back({ node.index, { std::llround(node.size.width()), std::llround(node.size.height()) } });
+    }
+    EdgeVector edges;
+    for (auto && edge : graphSnapshot.edges()) {
+        edges.emplace_back(edge.sourceIndex, edge.targetIndex);
+    }
+    return topologyKey(std::move(nodes), std::move(edges));
+}
+
+LayoutCache::Key LayoutCache::topologyKey(NodeVector nodes, EdgeVector edges)
+{
+    std::sort(nodes.begin(), nodes.end());
+    std::sort(edges.begin(), edges.end());
+
+    Key hash = 0xcbf29ce484222325;
+    combine(hash, static_cast<int64_t>(nodes.size()));
+    for (auto && [index, size] : nodes) {
+        combine(hash, index);
+        combine(hash, size.first);
+        combine(hash, size.second);
+    }
+    combine(hash, static_cast<int64_t>(edges.size()));
+    for (auto && [index0, index1] : edges) {
+        combine(hash, index0);
+        combine(hash, index1);
+    }
+    return hash;
+}
+
+LayoutCache::Key LayoutCache::key(Key topologyKey, std::initializer_list<double> parameters)
+{
+    // The parameters are hashed apart from the topology, so that a renumbered entry can be rekeyed without them
+    Key hash = 0xcbf29ce484222325;
+    for (auto && parameter : parameters) {
+        combine(hash, rounded(parameter));
+    }
+    return topologyKey ^ hash;
+}
+
+LayoutCache::Entry LayoutCache::renumbered(const Entry & entry, const std::vector<int> & indexMap, Key topologyKey)
+{
+    Entry renumberedEntry;
+    renumberedEntry.topologyKey = topologyKey;
+    renumberedEntry.key = entry.key ^ entry.topologyKey ^ topologyKey;
+    renumberedEntry.layout.reserve(entry.layout.size());
+    for (auto && [index, location] : entry.layout) {
+        if (index >= 0 && static_cast<size_t>(index) < indexMap.size() && indexMap.at(static_cast<size_t>(index)) >= 0) {
+            renumberedEntry.layout.emplace_back(indexMap.at(static_cast<size_t>(index)), location);
+        }
+    }
+    return renumberedEntry;
+}
+
+std::optional<LayoutCache::Layout> LayoutCache::find(Key key)
+{
+    const std::lock_guard<std::mutex> lock { m_mutex };
+    if (const auto iter = std::find_if(m_entries.begin(), m_entries.end(), [key](auto && entry) {
+            return entry.key == key;
+        });
+        iter != m_entries.end()) {
+        m_entries.splice(m_entries.begin(), m_entries, iter);
+        return m_entries.front().layout;
+    }
+    return {};
+}
+
+void LayoutCache::insert(Entry entry)
+{
+    const std::lock_guard<std::mutex> lock { m_mutex };
+    m_entries.remove_if([&entry](auto && other) {
+        return other.key == entry.key;
+    });
+    m_entries.push_front(std::move(entry));
+    while (m_entries.size() > m_capacity) {
+        m_entries.pop_back();
+    }
+}
+
+std::optional<LayoutCache::Entry> LayoutCache::latest() const
+{
+    const std::lock_guard<std::mutex> lock { m_mutex };
+    if (m_entries.empty()) {
+        return {};
+    }
+    return m_entries.front();
+}
+
+size_t LayoutCache::size() const
+{
+    const std::lock_guard<std::mutex> lock { m_mutex };
+    return m_entries.size();
+}
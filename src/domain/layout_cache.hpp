@@ -0,0 +1,94 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LAYOUT_CACHE_HPP
+#define LAYOUT_CACHE_HPP
+
+#include <QPointF>
+
+#include <cstdint>
+#include <initializer_list>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "../common/types.hpp"
+
+class GraphSnapshot;
+
+//! Recently optimized layouts, so that optimizing a mind map whose structure hasn't changed, e.g. after an undo,
+//! just re-applies its layout. The layouts are keyed by the topology, the node sizes and the optimizer parameters,
+//! but not by the node locations. Thread-safe, because a copy of the mind map may be saved on a worker thread.
+class LayoutCache
+{
+public:
+    using Key = uint64_t;
+
+    //! Locations of the nodes by node index.
+    using Layout = std::vector<std::pair<int, QPointF>>;
+
+    struct Entry
+    {
+        Key topologyKey = 0;
+
+        Key key = 0;
+
+        Layout layout;
+    };
+
+    explicit LayoutCache(size_t capacity);
+
+    //! \return Hash of the node indices, the node sizes and the edges. It doesn't depend on the order of the items and
+    //! stays the same across runs, so it can be saved to files.
+    static Key topologyKey(GraphCR graph);
+
+    static Key topologyKey(const GraphSnapshot & graphSnapshot);
+
+    //! \return Hash of the topology and of the optimizer parameters that change the layout. The parameters are
+    //! rounded like when they are saved to files.
+    static Key key(Key topologyKey, std::initializer_list<double> parameters);
+
+    //! \return The entry with the node indices renumbered by the given map, e.g. when the nodes are saved with dense
+    //! indices, and rekeyed to the given topology of the renumbered graph.
+    static Entry renumbered(const Entry & entry, const std::vector<int> & indexMap, Key topologyKey);
+
+    //! \return The layout stored with the given key, if any. It becomes the most recently used layout.
+    std::optional<Layout> find(Key key);
+
+    //! Stores the layout as the most recently used one. The least recently used layout is dropped if the cache is full.
+    void insert(Entry entry);
+
+    //! \return The most recently used layout, e.g. to be saved with the mind map.
+    std::optional<Entry> latest() const;
+
+    size_t size() const;
+
+private:
+    using NodeVector = std::vector<std::pair<int, std::pair<int64_t, int64_t>>>;
+
+    using EdgeVector = std::vector<std::pair<int, int>>;
+
+    static Key topologyKey(NodeVector nodes, EdgeVector edges);
+
+    mutable std::mutex m_mutex;
+
+    size_t m_capacity;
+
+    std::list<Entry> m_entries; // The most recently used first
+};
+
+#endif // LAYOUT_CACHE_HPP
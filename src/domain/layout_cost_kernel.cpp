@@ -0,0 +1,165 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "layout_cost_kernel.hpp"
+
+#include <cmath>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define LAYOUT_COST_KERNEL_AVX2
+#include <immintrin.h>
+#endif
+
+// Overlapping connections are collinear vectors pointing to the same direction
+static const double COLLINEARITY_EPSILON = 0.001;
+
+namespace LayoutCostKernel {
+
+static double distance(const double * x, const double * y, size_t cell, size_t other)
+{
+    const auto dx = x[other] - x[cell];
+    const auto dy = y[other] - y[cell];
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+double overlapCost(const double * x, const double * y, size_t cell, size_t cell1, size_t cell2)
+{
+    const auto x1 = x[cell1] - x[cell];
+    const auto y1 = y[cell1] - y[cell];
+    const auto x2 = x[cell2] - x[cell];
+    const auto y2 = y[cell2] - y[cell];
+    if (std::fabs(x1 * y2 - x2 * y1) < COLLINEARITY_EPSILON && x1 * x2 + y1 * y2 > 0) {
+        const auto l1 = x1 * x1 + y1 * y1;
+        const auto l2 = x2 * x2 + y2 * y2;
+        return l1 < l2 ? 2 * std::sqrt(l1) : 2 * std::sqrt(l2);
+    }
+
+    return 0;
+}
+
+static double sumDistancesScalar(const double * x, const double * y, size_t cell, const size_t * others, size_t count)
+{
+    double sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += distance(x, y, cell, others[i]);
+    }
+    return sum;
+}
+
+static double sumOverlapCostsScalar(const double * x, const double * y, size_t cell, size_t moved, const size_t * others, size_t count)
+{
+    double sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (others[i] != moved) {
+            sum += overlapCost(x, y, cell, moved, others[i]);
+        }
+    }
+    return sum;
+}
+
+#ifdef LAYOUT_COST_KERNEL_AVX2
+
+__attribute__((target("avx2"))) static double horizontalSum(__m256d values)
+{
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, values);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+__attribute__((target("avx2"))) static double sumDistancesAvx2(const double * x, const double * y, size_t cell, const size_t * others, size_t count)
+{
+    const auto cellX = _mm256_set1_pd(x[cell]);
+    const auto cellY = _mm256_set1_pd(y[cell]);
+    auto sum = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const auto indices = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(others + i));
+        const auto dx = _mm256_sub_pd(_mm256_i64gather_pd(x, indices, 8), cellX);
+        const auto dy = _mm256_sub_pd(_mm256_i64gather_pd(y, indices, 8), cellY);
+        sum = _mm256_add_pd(sum, _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy))));
+    }
+    return horizontalSum(sum) + sumDistancesScalar(x, y, cell, others + i, count - i);
+}
+
+__attribute__((target("avx2"))) static double sumOverlapCostsAvx2(const double * x, const double * y, size_t cell, size_t moved, const size_t * others, size_t count)
+{
+    const auto x1 = x[moved] - x[cell];
+    const auto y1 = y[moved] - y[cell];
+    const auto movedX = _mm256_set1_pd(x1);
+    const auto movedY = _mm256_set1_pd(y1);
+    const auto movedLength = _mm256_set1_pd(x1 * x1 + y1 * y1);
+    const auto cellX = _mm256_set1_pd(x[cell]);
+    const auto cellY = _mm256_set1_pd(y[cell]);
+    const auto movedIndex = _mm256_set1_epi64x(static_cast<long long>(moved));
+    const auto signMask = _mm256_set1_pd(-0.0);
+    const auto epsilon = _mm256_set1_pd(COLLINEARITY_EPSILON);
+    const auto zero = _mm256_setzero_pd();
+    auto sum = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const auto indices = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(others + i));
+        const auto x2 = _mm256_sub_pd(_mm256_i64gather_pd(x, indices, 8), cellX);
+        const auto y2 = _mm256_sub_pd(_mm256_i64gather_pd(y, indices, 8), cellY);
+        const auto cross = _mm256_sub_pd(_mm256_mul_pd(movedX, y2), _mm256_mul_pd(x2, movedY));
+        const auto dot = _mm256_add_pd(_mm256_mul_pd(movedX, x2), _mm256_mul_pd(movedY, y2));
+        const auto isCollinear = _mm256_cmp_pd(_mm256_andnot_pd(signMask, cross), epsilon, _CMP_LT_OQ);
+        const auto isSameDirection = _mm256_cmp_pd(dot, zero, _CMP_GT_OQ);
+        const auto isMoved = _mm256_castsi256_pd(_mm256_cmpeq_epi64(indices, movedIndex));
+        // Overlaps are rare, so the square roots are skipped unless there is one
+        if (const auto mask = _mm256_andnot_pd(isMoved, _mm256_and_pd(isCollinear, isSameDirection)); _mm256_movemask_pd(mask)) {
+            const auto length = _mm256_add_pd(_mm256_mul_pd(x2, x2), _mm256_mul_pd(y2, y2));
+            const auto cost = _mm256_mul_pd(_mm256_set1_pd(2), _mm256_sqrt_pd(_mm256_min_pd(movedLength, length)));
+            sum = _mm256_add_pd(sum, _mm256_and_pd(mask, cost));
+        }
+    }
+    return horizontalSum(sum) + sumOverlapCostsScalar(x, y, cell, moved, others + i, count - i);
+}
+
+#endif // LAYOUT_COST_KERNEL_AVX2
+
+bool isSupported(Implementation implementation)
+{
+    switch (implementation) {
+    case Implementation::Scalar:
+        return true;
+    case Implementation::Avx2:
+#ifdef LAYOUT_COST_KERNEL_AVX2
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+const Kernel & kernel(Implementation implementation)
+{
+    static const Kernel scalar { Implementation::Scalar, sumDistancesScalar, sumOverlapCostsScalar };
+#ifdef LAYOUT_COST_KERNEL_AVX2
+    static const Kernel avx2 { Implementation::Avx2, sumDistancesAvx2, sumOverlapCostsAvx2 };
+    if (implementation == Implementation::Avx2 && isSupported(implementation)) {
+        return avx2;
+    }
+#endif
+    return scalar;
+}
+
+const Kernel & bestKernel()
+{
+    static const Kernel & best = kernel(Implementation::Avx2);
+    return best;
+}
+
+} // namespace LayoutCostKernel
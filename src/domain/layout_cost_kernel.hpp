@@ -0,0 +1,59 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LAYOUT_COST_KERNEL_HPP
+#define LAYOUT_COST_KERNEL_HPP
+
+#include <cstddef>
+
+//! Cost loops of the layout optimizer over cells stored as flat coordinate arrays.
+//! A SIMD implementation is selected at runtime when the CPU supports it.
+namespace LayoutCostKernel {
+
+enum class Implementation
+{
+    Scalar,
+    Avx2
+};
+
+//! \return Sum of the distances from the given cell to the other cells.
+using SumDistances = double (*)(const double * x, const double * y, size_t cell, const size_t * others, size_t count);
+
+//! \return Sum of the overlap costs of the pairs (moved, other) as seen from the given cell. Others equal to moved are skipped.
+using SumOverlapCosts = double (*)(const double * x, const double * y, size_t cell, size_t moved, const size_t * others, size_t count);
+
+struct Kernel
+{
+    Implementation implementation;
+
+    SumDistances sumDistances;
+
+    SumOverlapCosts sumOverlapCosts;
+};
+
+//! \return Overlap cost of a single pair as seen from the given cell. This is what SumOverlapCosts sums up.
+double overlapCost(const double * x, const double * y, size_t cell, size_t cell1, size_t cell2);
+
+bool isSupported(Implementation implementation);
+
+//! \return The kernel of the given implementation. Falls back to the scalar kernel if the implementation is not supported.
+const Kernel & kernel(Implementation implementation);
+
+//! \return The fastest kernel supported by the CPU.
+const Kernel & bestKernel();
+
+} // namespace LayoutCostKernel
+
+#endif // LAYOUT_COST_KERNEL_HPP
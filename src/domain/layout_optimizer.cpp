@@ -14,27 +14,152 @@
 // along with Heimer. If not, see <http://www.gnu.org/licenses/>.
 
 #include "layout_optimizer.hpp"
-
+#include "edge_crossing_index.hpp"
+#include "force_directed_layout.hpp"
+#include "layout_cache.hpp"
+#include "layout_cost_kernel.hpp"
+#include "tree_layout.hpp"
+
+#include "../application/service_container.hpp"
+#include "../application/task_pool.hpp"
 #include "../common/constants.hpp"
+#include "../common/trace_recorder.hpp"
 #include "../domain/graph.hpp"
 #include "../domain/mind_map_data.hpp"
 #include "../view/grid.hpp"
+#include "../view/scene_items/edge_update_batch.hpp"
 #include "../view/scene_items/node.hpp"
 
 #include "simple_logger.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <optional>
 #include <random>
+#include <set>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 class Graph;
 
 static const auto TAG = "LayoutOptimizer";
 
+static const double INITIAL_TEMPERATURE = 33;
+
+// Projected layouts are already good globally, so the finer levels are only annealed from a low temperature
+static const double REFINEMENT_TEMPERATURE = 1;
+
+// A warm start begins at the temperature where this share of the uphill moves from the current layout would be accepted
+static const double WARM_START_ACCEPT_RATIO = 0.001;
+
+static const size_t WARM_START_SAMPLE_COUNT = 1000;
+
+// The modified Lam schedule gets this many moves per cell. The geometric schedule uses at least 18 temperature steps of
+// five slices of 200 moves per cell.
+static const double LAM_MOVES_PER_CELL = 6000;
+
+// Number of slices of the modified Lam schedule, i.e. the resolution of the target acceptance rate, progress and previews
+static const size_t LAM_SLICE_COUNT = 500;
+
+// Refinements and warm starts skip the heating and the exploration and only follow the final cooling of the target curve
+static const double LAM_REFINEMENT_PROGRESS = 0.65;
+
+// Share of the moves that put a node next to a node it's connected to instead of near its own slot
+static const double CONNECTED_MOVE_SHARE = 0.5;
+
+// Upper limit of the distance of the random moves in rows and columns while the layout is hot
+static const size_t MAX_MOVE_RADIUS = 8;
+
+static const std::array<std::pair<long, long>, 8> ADJACENT_SLOT_OFFSETS { { { -1, -1 }, { -1, 0 }, { -1, 1 }, { 0, -1 }, { 0, 1 }, { 1, -1 }, { 1, 0 }, { 1, 1 } } };
+
+//! xoshiro256** of Blackman and Vigna seeded with splitmix64. The annealer draws several numbers per move, and
+//! std::mt19937 with the standard distributions used to be a large part of the cost of a move.
+class FastRandom
+{
+public:
+    using result_type = uint64_t;
+
+    explicit FastRandom(uint64_t seed = std::mt19937::default_seed)
+    {
+        this->seed(seed);
+    }
+
+    void seed(uint64_t seed)
+    {
+        for (auto && state : m_state) {
+            seed += 0x9e3779b97f4a7c15;
+            auto z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            state = z ^ (z >> 31);
+        }
+    }
+
+    static constexpr result_type min()
+    {
+        return 0;
+    }
+
+    static constexpr result_type max()
+    {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    result_type operator()()
+    {
+        const auto result = rotateLeft(m_state[1] * 5, 7) * 9;
+        const auto t = m_state[1] << 17;
+        m_state[2] ^= m_state[0];
+        m_state[3] ^= m_state[1];
+        m_state[1] ^= m_state[2];
+        m_state[0] ^= m_state[3];
+        m_state[2] ^= t;
+        m_state[3] = rotateLeft(m_state[3], 45);
+        return result;
+    }
+
+    //! \return Integer in [0, bound) by Lemire's multiply-shift, which needs no division. The bound must be below 2^32.
+    size_t below(size_t bound)
+    {
+        return static_cast<size_t>(((*this)() >> 32) * static_cast<uint64_t>(bound) >> 32);
+    }
+
+    //! \return Number in [0, 1).
+    double uniform()
+    {
+        return static_cast<double>((*this)() >> 11) * 0x1.0p-53;
+    }
+
+private:
+    static uint64_t rotateLeft(uint64_t value, int shift)
+    {
+        return (value << shift) | (value >> (64 - shift));
+    }
+
+    std::array<uint64_t, 4> m_state;
+};
+
+// Connected components smaller than this are optimized together in one grid, as they are cheap to anneal
+static const size_t MIN_COMPONENT_NODE_COUNT = 8;
+
+// Below this the threads would cost more than spreading or extracting the layout
+static const size_t MIN_CELLS_PER_THREAD = 10000;
+
 class LayoutOptimizer::Impl
 {
 public:
@@ -48,73 +173,233 @@ public:
 
     bool initialize(double aspectRatio, double minEdgeLength)
     {
+        const TraceRecorder::ScopedSpan span { "LayoutOptimizer::initialize" };
+
         juzzlin::L(TAG).info() << "Initializing LayoutOptimizer: aspectRatio=" << aspectRatio << ", minEdgeLength=" << minEdgeLength;
 
-        const auto nodes = m_mindMapData->graph().getNodes();
+        const auto nodes = !m_componentNodes.empty() ? m_componentNodes : m_subgraph.empty() ? m_mindMapData->graph().getNodes()
+                                                                                               : expandSubgraph();
         if (nodes.empty()) {
             juzzlin::L(TAG).info() << "No nodes";
             return false;
         }
 
-        assignNodesToNearestCells(nodes, buildInitialCellLayout(nodes, aspectRatio, minEdgeLength));
+        m_cancelled = false;
+        m_levels.clear();
+        m_nodesToCells.clear();
+        m_forceDirectedLayout.reset();
+        m_treeLayout.reset();
+        m_components.clear();
+        m_cachedLayout.reset();
+        m_cacheEntry.reset();
+        m_isLocalityPlaced = false;
+
+        // A warm start or a subgraph refines the current locations, which are not part of the key
+        if (m_useLayoutCache && m_componentNodes.empty() && m_subgraph.empty() && !m_warmStart) {
+            LayoutCache::Entry entry;
+            entry.topologyKey = LayoutCache::topologyKey(m_mindMapData->graph());
+            entry.key = LayoutCache::key(entry.topologyKey, { aspectRatio, minEdgeLength, static_cast<double>(m_engine), m_crossingPenalty, static_cast<double>(m_seed), static_cast<double>(m_initialPlacement) });
+            if (m_cachedLayout = m_mindMapData->layoutCache().find(entry.key); m_cachedLayout && isValidCachedLayout(nodes)) {
+                juzzlin::L(TAG).info() << "Using the cached layout";
+                return true;
+            }
+            m_cachedLayout.reset();
+            m_cacheEntry = std::move(entry);
+        }
+
+        // Trees are laid out in linear time, so a forest is not split into components
+        if (m_engine == Engine::TidyTree || m_engine == Engine::RadialTree) {
+            initializeTreeLayout(nodes, minEdgeLength);
+            return true;
+        }
+
+        // A warm start keeps the current layout, so the components are not packed again
+        if (m_componentNodes.empty() && m_subgraph.empty() && !m_warmStart) {
+            if (auto components = findComponents(nodes); components.size() > 1) {
+                initializeComponents(std::move(components), aspectRatio, minEdgeLength);
+                return true;
+            }
+        }
+
+        if (m_engine == Engine::ForceDirected) {
+            initializeForceDirectedLayout(nodes, aspectRatio, minEdgeLength);
+            return true;
+        }
+
+        if (m_subgraph.empty() && !m_warmStart && m_multilevelThreshold && nodes.size() >= m_multilevelThreshold) {
+            initializeLevels(nodes, aspectRatio, minEdgeLength);
+            return true;
+        }
+
+        buildInitialCellLayout(calculateLayoutArea(nodes, minEdgeLength), aspectRatio, minEdgeLength);
+        assignNodesToNearestCells(nodes);
+
+        if (!m_subgraph.empty()) {
+            m_layout->center = calculateNodeLayoutRect(nodes).center();
+            juzzlin::L(TAG).info() << "Subgraph: " << nodes.size() << " nodes";
+        }
 
         setupConnections();
 
+        if (isLocalityPlacementUsed()) {
+            placeByLocality(vertexEdges(nodes), [this, &nodes] {
+                m_nodesToCells.clear();
+                setNodesToCells(nodes);
+                setupConnections();
+            });
+        }
+
         return true;
     }
 
     OptimizationInfo optimize()
     {
+        const TraceRecorder::ScopedSpan span { "LayoutOptimizer::optimize" };
+
+        if (m_cachedLayout) {
+            OptimizationInfo optimizationInfo;
+            optimizationInfo.cached = true;
+            updateProgress(1);
+            return optimizationInfo;
+        }
+
+        m_startTime = std::chrono::steady_clock::now();
+        m_deadline = m_startTime + m_timeBudget;
+        m_trace.clear();
+        auto optimizationInfo = optimizeUntilDeadline();
+        optimizationInfo.trace = (m_components.empty() ? m_trace : m_components.front().optimizer->m_trace).samples();
+        // Only layouts that had the time they needed are good enough to be re-applied
+        if (optimizationInfo.cancelled || optimizationInfo.outOfTime) {
+            m_cacheEntry.reset();
+        }
+        return optimizationInfo;
+    }
+
+    //! Child optimizers of the components share the deadline of the parent.
+    OptimizationInfo optimizeUntilDeadline()
+    {
+        if (!m_components.empty()) {
+            return optimizeComponents();
+        }
+
+        if (m_forceDirectedLayout) {
+            return optimizeForceDirected();
+        }
+
+        if (m_treeLayout) {
+            return optimizeTree();
+        }
+
+        if (!m_levels.empty()) {
+            return optimizeMultilevel();
+        }
+
         if (m_layout->all.size() < 2) {
             return {};
         }
 
-        OptimizationInfo optimizationInfo;
-        optimizationInfo.initialCost = calculateCost();
-        optimizationInfo.currentCost = optimizationInfo.initialCost;
-        optimizationInfo.sliceSize = m_layout->all.size() * 200;
-        optimizationInfo.t0 = 33;
-        optimizationInfo.tC = optimizationInfo.t0;
+        return m_warmStart || m_isLocalityPlaced ? optimizeLayout(estimateWarmStartTemperature(), true) : optimizeLayout(INITIAL_TEMPERATURE, false);
+    }
 
-        juzzlin::L(TAG).info() << "Initial cost: " << optimizationInfo.initialCost;
+    void setEngine(Engine engine)
+    {
+        m_engine = engine;
+    }
 
-        while (optimizationInfo.tC > optimizationInfo.t1 && optimizationInfo.currentCost > 0) {
-            optimizationInfo.acceptRatio = 0;
-            size_t stuckCounter = 0;
-            do {
-                optimizationInfo.accepts = 0;
-                optimizationInfo.rejects = 0;
-                double sliceCost = optimizationInfo.currentCost;
-                for (size_t i = 0; i < optimizationInfo.sliceSize; i++) {
-                    changeLayoutAndUpdateCost(optimizationInfo);
-                }
-                optimizationInfo.acceptRatio = static_cast<double>(optimizationInfo.accepts) / static_cast<double>(optimizationInfo.rejects + 1);
-                const double gain = (optimizationInfo.currentCost - sliceCost) / sliceCost;
-                juzzlin::L(TAG).debug() << "Cost: " << optimizationInfo.currentCost << " (" << gain * 100 << "%)"
-                                     << " acc: " << optimizationInfo.acceptRatio << " t: " << optimizationInfo.tC;
-                stuckCounter = gain < optimizationInfo.stuckTh ? stuckCounter + 1 : 0;
+    void setSchedule(Schedule schedule)
+    {
+        m_schedule = schedule;
+    }
 
-            } while (stuckCounter < optimizationInfo.stuckLimit);
+    void setSeed(uint32_t seed)
+    {
+        m_seed = seed;
+    }
 
-            optimizationInfo.tC *= optimizationInfo.cS;
+    void setCrossingPenalty(double crossingPenalty)
+    {
+        m_crossingPenalty = std::max(0.0, crossingPenalty);
+    }
 
-            updateProgress(std::min(1.0, 1.0 - std::log(optimizationInfo.tC) / std::log(optimizationInfo.t0)));
-        }
+    void setUseLayoutCache(bool useLayoutCache)
+    {
+        m_useLayoutCache = useLayoutCache;
+    }
 
-        optimizationInfo.finalCost = optimizationInfo.currentCost;
+    void setReplicaCount(size_t replicaCount)
+    {
+        m_replicaCount = std::max<size_t>(1, replicaCount);
+    }
 
-        return optimizationInfo;
+    void setMultilevelThreshold(size_t nodeCount)
+    {
+        m_multilevelThreshold = nodeCount;
+    }
+
+    void setSubgraph(const std::vector<int> & nodeIndices, size_t hopCount)
+    {
+        m_subgraph = nodeIndices;
+        m_hopCount = hopCount;
+    }
+
+    void setInitialPlacement(InitialPlacement initialPlacement)
+    {
+        m_initialPlacement = initialPlacement;
+    }
+
+    void setWarmStart(bool warmStart)
+    {
+        m_warmStart = warmStart;
+    }
+
+    void setTimeBudget(std::chrono::milliseconds timeBudget)
+    {
+        m_timeBudget = timeBudget;
     }
 
     void updateProgress(double val)
     {
         if (m_progressCallback) {
-            m_progressCallback(val);
+            m_progressCallback(m_progressOffset + val * m_progressScale);
         }
     }
 
     void extract()
     {
+        const TraceRecorder::ScopedSpan span { "LayoutOptimizer::extract" };
+
+        if (m_cachedLayout) {
+            applyCachedLayout();
+            return;
+        }
+
+        extractLayout();
+
+        if (m_cacheEntry) {
+            storeLayout();
+        }
+    }
+
+    void extractLayout()
+    {
+        if (!m_components.empty()) {
+            for (auto && component : m_components) {
+                component.optimizer->extract();
+            }
+            packComponents();
+            return;
+        }
+
+        if (m_forceDirectedLayout) {
+            applyPositions(m_forceDirectedLayout->positions());
+            return;
+        }
+
+        if (m_treeLayout) {
+            applyPositions(m_treeLayout->positions());
+            return;
+        }
+
         if (m_layout->all.empty()) {
             return;
         }
@@ -123,577 +408,2192 @@ public:
         m_layout->applyCoordinates(m_grid);
     }
 
+    void cancel()
+    {
+        m_cancelled = true;
+        for (auto && component : m_components) {
+            component.optimizer->cancel();
+        }
+    }
+
+    bool extractPreview()
+    {
+        if (!m_components.empty()) {
+            bool extracted = false;
+            for (auto && component : m_components) {
+                extracted = component.optimizer->extractPreview() || extracted;
+            }
+            if (extracted) {
+                packComponents();
+            }
+            return extracted;
+        }
+
+        std::unique_ptr<Layout> preview;
+        std::optional<std::vector<QPointF>> positions;
+        {
+            std::lock_guard<std::mutex> lock { m_previewMutex };
+            preview = std::move(m_preview);
+            positions.swap(m_forceDirectedPreview);
+        }
+
+        if (positions) {
+            applyPositions(*positions);
+            return true;
+        }
+
+        if (!preview) {
+            return false;
+        }
+
+        preview->spread();
+        preview->applyCoordinates(m_grid);
+        return true;
+    }
+
     void setProgressCallback(ProgressCallback progressCallback)
     {
         m_progressCallback = progressCallback;
     }
 
+    void setTraceCallback(TraceCallback traceCallback)
+    {
+        m_traceCallback = traceCallback;
+    }
+
+    void setPreviewCallback(PreviewCallback previewCallback, std::chrono::milliseconds interval)
+    {
+        m_previewCallback = previewCallback;
+        m_previewInterval = interval;
+    }
+
 private:
     QRectF calculateNodeLayoutRect(const Graph::NodeVector & nodes) const
     {
         if (nodes.empty()) {
             return {};
         }
-        QRectF dimensions = nodes.at(0)->placementBoundingRect();
+        QRectF dimensions = nodes.at(0)->placementBoundingRect().translated(nodes.at(0)->location());
         for (auto && node : nodes) {
             dimensions = dimensions.united(node->placementBoundingRect().translated(node->location()));
         }
         return dimensions;
     }
 
-    double calculateCost() const
-    {
-        return std::accumulate(std::begin(m_layout->all), std::end(m_layout->all), double {},
-                               [](auto totalCost, auto && cell) {
-                                   return totalCost + cell->calculateCost();
-                               });
-    }
+    using CellVector = std::vector<size_t>;
 
-    class Cell;
+    struct Layout;
+
+    bool isPreviewDue()
+    {
+        if (!m_previewCallback) {
+            return false;
+        }
 
-    struct Row;
+        if (const auto now = std::chrono::steady_clock::now(); now - m_lastPreviewTime >= m_previewInterval) {
+            m_lastPreviewTime = now;
+            return true;
+        }
 
-    using CellVector = std::vector<std::shared_ptr<Cell>>;
+        return false;
+    }
 
-    void assignNodeToCell(const NodeS & node, CellVector::iterator nearestCellIter, CellVector & cells)
+    //! Copies the layout for extractPreview() if the preview interval has passed. Layouts of coarse levels have no nodes and are not published.
+    void publishPreview(const Layout & layout)
     {
-        const auto cell = *nearestCellIter;
-        cell->setNode(node);
-        std::swap(*nearestCellIter, cells.back());
-        cells.pop_back();
-        m_nodesToCells[node->index()] = cell;
-        m_layout->all.push_back(cell);
+        if (layout.all.empty() || !layout.nodes.at(layout.all.front()) || !isPreviewDue()) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock { m_previewMutex };
+            m_preview = std::make_unique<Layout>(layout);
+        }
+        m_previewCallback();
     }
 
-    struct CellLayoutMetrics
+    void publishPreview(const ForceDirectedLayout & forceDirectedLayout)
     {
-        const double minX;
+        if (!isPreviewDue()) {
+            return;
+        }
 
-        const double maxX;
+        {
+            std::lock_guard<std::mutex> lock { m_previewMutex };
+            m_forceDirectedPreview = forceDirectedLayout.positions();
+        }
+        m_previewCallback();
+    }
 
-        const double minY;
+    //! Moves the nodes of the force-directed layout. The anchors after them are not touched.
+    //! A cached layout loaded from a file could be broken, but it must match the nodes exactly.
+    bool isValidCachedLayout(const Graph::NodeVector & nodes) const
+    {
+        if (m_cachedLayout->size() != nodes.size()) {
+            return false;
+        }
+        std::set<int> indices;
+        for (auto && node : nodes) {
+            indices.insert(node->index());
+        }
+        return std::all_of(m_cachedLayout->begin(), m_cachedLayout->end(), [&indices](auto && indexAndLocation) {
+            return indices.erase(indexAndLocation.first) > 0;
+        });
+    }
 
-        const double maxY;
+    void applyCachedLayout()
+    {
+        const auto & graph = m_mindMapData->graph();
+        const SceneItems::EdgeUpdateBatch edgeUpdateBatch;
+        for (auto && [index, location] : *m_cachedLayout) {
+            graph.getNode(index)->setLocation(location);
+        }
+    }
 
-        const double cellAreaW;
+    void storeLayout()
+    {
+        for (auto && node : m_mindMapData->graph().nodes()) {
+            m_cacheEntry->layout.emplace_back(node->index(), node->location());
+        }
+        m_mindMapData->layoutCache().insert(std::move(*m_cacheEntry));
+        m_cacheEntry.reset();
+    }
 
-        const double cellAreaH;
-    };
+    void applyPositions(const std::vector<QPointF> & positions)
+    {
+        const SceneItems::EdgeUpdateBatch edgeUpdateBatch;
+        for (size_t i = 0; i < m_nodes.size(); i++) {
+            m_nodes.at(i)->setLocation(m_grid.snapToGrid(positions.at(i)));
+        }
+    }
 
-    CellLayoutMetrics calculateCellLayoutMetrics(const CellVector & cells)
+    void initializeForceDirectedLayout(const Graph::NodeVector & nodes, double aspectRatio, double minEdgeLength)
     {
-        const auto [minXIt, maxXIt] = std::minmax_element(cells.begin(), cells.end(), [](const auto & lhs, const auto & rhs) {
-            return lhs->x() < rhs->x();
-        });
-        const auto [minYIt, maxYIt] = std::minmax_element(cells.begin(), cells.end(), [](const auto & lhs, const auto & rhs) {
-            return lhs->y() < rhs->y();
-        });
+        m_nodes = nodes;
 
-        return {
-            (*minXIt)->x(),
-            (*maxXIt)->x(),
-            (*minYIt)->y(),
-            (*maxYIt)->y(),
-            (*maxXIt)->x() - (*minXIt)->x(),
-            (*maxYIt)->y() - (*minYIt)->y()
+        std::vector<QPointF> positions;
+        std::vector<QSizeF> sizes;
+        std::map<int, size_t> nodesToVertices;
+        for (auto && node : nodes) {
+            nodesToVertices[node->index()] = positions.size();
+            positions.push_back(node->location());
+            sizes.push_back(node->size());
+        }
+
+        // Nodes outside of the subgraph are appended as anchors
+        const auto & graph = m_mindMapData->graph();
+        const auto vertexOf = [&](int index) {
+            if (const auto iter = nodesToVertices.find(index); iter != nodesToVertices.end()) {
+                return iter->second;
+            }
+            if (m_subgraph.empty() && m_componentNodes.empty()) {
+                throw std::runtime_error("Broken node-to-vertex mapping!");
+            }
+            const auto anchor = graph.getNode(index);
+            nodesToVertices[index] = positions.size();
+            positions.push_back(anchor->location());
+            sizes.push_back(anchor->size());
+            return positions.size() - 1;
+        };
+
+        const auto isMovable = [&](int index) {
+            const auto iter = nodesToVertices.find(index);
+            return iter != nodesToVertices.end() && iter->second < nodes.size();
         };
+
+        ForceDirectedLayout::EdgeVector edges;
+        for (auto && edge : graph.edges()) {
+            const auto sourceIndex = edge->sourceNode().index();
+            const auto targetIndex = edge->targetNode().index();
+            // A component is closed, so its edges are the ones with a movable node
+            if ((m_subgraph.empty() && m_componentNodes.empty()) || isMovable(sourceIndex) || isMovable(targetIndex)) {
+                edges.emplace_back(vertexOf(sourceIndex), vertexOf(targetIndex));
+            }
+        }
+
+        juzzlin::L(TAG).info() << "Force-directed layout: " << nodes.size() << " nodes, " << positions.size() - nodes.size() << " anchors";
+
+        m_forceDirectedLayout = std::make_unique<ForceDirectedLayout>(positions, sizes, edges, positions.size() - nodes.size(),
+                                                                      ForceDirectedLayout::Parameters { aspectRatio, minEdgeLength, m_replicaCount, m_warmStart });
     }
 
-    double normalizeDistanceFromCellToNode(const std::shared_ptr<Cell> & cell, const NodeS & node, const QRectF & nodeLayoutRect, const CellLayoutMetrics & cellMetrics)
+    OptimizationInfo optimizeForceDirected()
     {
-        const auto deltaX = (cell->x() - cellMetrics.minX - cellMetrics.cellAreaW / 2) / cellMetrics.cellAreaW - (node->location().x() - nodeLayoutRect.x() - nodeLayoutRect.width() / 2) / nodeLayoutRect.width();
-        const auto deltaY = (cell->y() - cellMetrics.minY - cellMetrics.cellAreaH / 2) / cellMetrics.cellAreaH - (node->location().y() - nodeLayoutRect.y() - nodeLayoutRect.height() / 2) / nodeLayoutRect.height();
-        return deltaX * deltaX + deltaY * deltaY;
+        const TraceRecorder::ScopedSpan span { "LayoutOptimizer::optimizeForceDirected" };
+
+        auto && forceDirectedLayout = *m_forceDirectedLayout;
+        OptimizationInfo optimizationInfo;
+        optimizationInfo.initialCost = forceDirectedLayout.cost();
+        juzzlin::L(TAG).info() << "Initial cost: " << optimizationInfo.initialCost;
+
+        while (!m_cancelled && !isOutOfTime() && forceDirectedLayout.step()) {
+            updateProgress(forceDirectedLayout.progress());
+            publishPreview(forceDirectedLayout);
+        }
+
+        // Also a cancelled layout gets the overlaps removed
+        forceDirectedLayout.finalize();
+
+        optimizationInfo.finalCost = forceDirectedLayout.cost();
+        optimizationInfo.currentCost = optimizationInfo.finalCost;
+        optimizationInfo.changes = forceDirectedLayout.iterationCount() * m_nodes.size();
+        optimizationInfo.replicas = m_replicaCount;
+        optimizationInfo.cancelled = m_cancelled;
+        optimizationInfo.outOfTime = isOutOfTime();
+        juzzlin::L(TAG).info() << "Final cost: " << optimizationInfo.finalCost << ", iterations: " << forceDirectedLayout.iterationCount();
+
+        updateProgress(1);
+
+        return optimizationInfo;
     }
 
-    void assignNodesToNearestCells(const Graph::NodeVector & nodes, CellVector cells)
+    //! The edges outside of the nodes are ignored, so that a subgraph is laid out as a tree of its own around its current center.
+    void initializeTreeLayout(const Graph::NodeVector & nodes, double minEdgeLength)
     {
-        const auto nodeLayoutRect = calculateNodeLayoutRect(nodes);
-        juzzlin::L(TAG).info() << "Area: " << nodeLayoutRect.height() * nodeLayoutRect.width();
+        m_nodes = nodes;
 
-        const auto cellMetrics = calculateCellLayoutMetrics(cells);
+        std::vector<QPointF> positions;
+        std::vector<QSizeF> sizes;
+        std::map<int, size_t> nodesToVertices;
         for (auto && node : nodes) {
-            if (!cells.empty()) {
-                if (const auto nearestCellIter = std::min_element(cells.begin(), cells.end(),
-                                                                  [&](const std::shared_ptr<Cell> & lhs, const std::shared_ptr<Cell> & rhs) {
-                                                                      return normalizeDistanceFromCellToNode(lhs, node, nodeLayoutRect, cellMetrics) < //
-                                                                        normalizeDistanceFromCellToNode(rhs, node, nodeLayoutRect, cellMetrics);
-                                                                  });
-                    nearestCellIter != cells.end()) {
-                    assignNodeToCell(node, nearestCellIter, cells);
-                } else {
-                    throw std::runtime_error("All nodes cannot be mapped to cells!");
-                }
-            } else {
-                throw std::runtime_error("All nodes cannot be mapped to cells!");
+            nodesToVertices[node->index()] = positions.size();
+            positions.push_back(node->location());
+            sizes.push_back(node->size());
+        }
+
+        TreeLayout::EdgeVector edges;
+        for (auto && edge : m_mindMapData->graph().edges()) {
+            const auto source = nodesToVertices.find(edge->sourceNode().index());
+            const auto target = nodesToVertices.find(edge->targetNode().index());
+            if (source != nodesToVertices.end() && target != nodesToVertices.end()) {
+                edges.emplace_back(source->second, target->second);
             }
         }
+
+        const auto style = m_engine == Engine::RadialTree ? TreeLayout::Style::Radial : TreeLayout::Style::LeftRight;
+        m_treeLayout = std::make_unique<TreeLayout>(positions, sizes, edges, TreeLayout::Parameters { style, minEdgeLength, calculateNodeLayoutRect(nodes).center() });
     }
 
-    CellVector buildInitialCellLayout(const Graph::NodeVector & nodes, double aspectRatio, double minEdgeLength)
+    OptimizationInfo optimizeTree()
     {
-        const double area = std::accumulate(nodes.begin(), nodes.end(), 0.0, [&](double sum, auto && node) {
-            return sum + (node->size().width() + minEdgeLength) * (node->size().height() + minEdgeLength);
-        });
-        const double height = std::sqrt(area / aspectRatio);
-        const double width = area / height;
+        const TraceRecorder::ScopedSpan span { "LayoutOptimizer::optimizeTree" };
 
-        m_layout = std::make_unique<Layout>();
-        m_layout->cols = static_cast<size_t>(width / (Constants::Node::minWidth() + minEdgeLength)) + 1;
-        m_layout->minEdgeLength = minEdgeLength;
+        auto && treeLayout = *m_treeLayout;
+        OptimizationInfo optimizationInfo;
+        optimizationInfo.initialCost = treeLayout.cost();
+        treeLayout.run();
+        optimizationInfo.finalCost = treeLayout.cost();
+        optimizationInfo.currentCost = optimizationInfo.finalCost;
+        optimizationInfo.changes = m_nodes.size();
+        optimizationInfo.cancelled = m_cancelled;
+        juzzlin::L(TAG).info() << "Tree layout: " << m_nodes.size() << " nodes, " << treeLayout.treeCount() << " trees, final cost: " << optimizationInfo.finalCost;
 
-        CellVector cells;
+        updateProgress(1);
+
+        return optimizationInfo;
+    }
+
+    //! \returns The connected components of the given nodes, the largest first. Components smaller than
+    //! MIN_COMPONENT_NODE_COUNT are merged into one, which goes last.
+    std::vector<Graph::NodeVector> findComponents(const Graph::NodeVector & nodes) const
+    {
+        const auto & graph = m_mindMapData->graph();
+        std::vector<Graph::NodeVector> components;
+        Graph::NodeVector smallComponents;
+        std::set<int> visited;
+        for (auto && node : nodes) {
+            if (!visited.insert(node->index()).second) {
+                continue;
+            }
+
+            Graph::NodeVector component { node };
+            for (size_t i = 0; i < component.size(); i++) {
+                const auto index = component.at(i)->index();
+                for (auto && edge : graph.edgesFromNode(index)) {
+                    if (visited.insert(edge->targetNode().index()).second) {
+                        component.push_back(graph.getNode(edge->targetNode().index()));
+                    }
+                }
+                for (auto && edge : graph.edgesToNode(index)) {
+                    if (visited.insert(edge->sourceNode().index()).second) {
+                        component.push_back(graph.getNode(edge->sourceNode().index()));
+                    }
+                }
+            }
+
+            if (component.size() < MIN_COMPONENT_NODE_COUNT) {
+                smallComponents.insert(smallComponents.end(), component.begin(), component.end());
+            } else {
+                components.push_back(std::move(component));
+            }
+        }
+
+        std::stable_sort(components.begin(), components.end(), [](auto && lhs, auto && rhs) {
+            return lhs.size() > rhs.size();
+        });
+
+        if (!smallComponents.empty()) {
+            components.push_back(std::move(smallComponents));
+        }
+
+        return components;
+    }
+
+    //! Creates an optimizer with its own grid for each component. The components are packed back around the current center.
+    void initializeComponents(std::vector<Graph::NodeVector> components, double aspectRatio, double minEdgeLength)
+    {
+        m_aspectRatio = aspectRatio;
+        m_minEdgeLength = minEdgeLength;
+        m_componentsCenter = calculateNodeLayoutRect(m_mindMapData->graph().getNodes()).center();
+        m_componentProgress.assign(components.size(), 0);
+        m_componentNodeCount = 0;
+
+        for (size_t i = 0; i < components.size(); i++) {
+            Component component;
+            component.nodes = std::move(components.at(i));
+            component.optimizer = std::make_unique<Impl>(m_mindMapData, m_grid);
+            auto && optimizer = *component.optimizer;
+            optimizer.m_componentNodes = component.nodes;
+            optimizer.m_engine = m_engine;
+            optimizer.m_schedule = m_schedule;
+            optimizer.m_crossingPenalty = m_crossingPenalty;
+            optimizer.m_replicaCount = m_replicaCount;
+            // Keep the replica seeds of the components apart
+            optimizer.m_seed = m_seed + static_cast<uint32_t>(i * m_replicaCount);
+            optimizer.m_multilevelThreshold = m_multilevelThreshold;
+            optimizer.m_initialPlacement = m_initialPlacement;
+            optimizer.m_timeBudget = m_timeBudget;
+            optimizer.m_progressCallback = [this, i](double progress) {
+                updateComponentProgress(i, progress);
+            };
+            if (m_previewCallback) {
+                // The components are annealed on separate threads, but the callback is only called from one at a time
+                optimizer.m_previewCallback = [this] {
+                    std::lock_guard<std::mutex> lock { m_previewMutex };
+                    m_previewCallback();
+                };
+                optimizer.m_previewInterval = m_previewInterval;
+            }
+            // The components converge concurrently, so only the largest one is traced
+            if (!i) {
+                optimizer.m_traceCallback = m_traceCallback;
+            }
+            optimizer.initialize(aspectRatio, minEdgeLength);
+            m_componentNodeCount += component.nodes.size();
+            m_components.push_back(std::move(component));
+        }
+
+        juzzlin::L(TAG).info() << "Components: " << m_components.size() << ", largest: " << m_components.front().nodes.size() << " nodes";
+    }
+
+    //! Reports the progress of all components weighted by their node counts. Called from the worker threads.
+    void updateComponentProgress(size_t componentIndex, double progress)
+    {
+        std::lock_guard<std::mutex> lock { m_componentProgressMutex };
+        m_componentProgress.at(componentIndex) = progress;
+        double totalProgress = 0;
+        for (size_t i = 0; i < m_components.size(); i++) {
+            totalProgress += m_componentProgress.at(i) * static_cast<double>(m_components.at(i).nodes.size());
+        }
+        updateProgress(totalProgress / static_cast<double>(m_componentNodeCount));
+    }
+
+    //! Optimizes the components concurrently. The largest one is run on the calling thread, as it bounds the total time.
+    OptimizationInfo optimizeComponents()
+    {
+        std::vector<OptimizationInfo> infos(m_components.size());
+        SC::instance().taskPool()->run(m_components.size(), [&](size_t i) {
+            auto && optimizer = *m_components.at(i).optimizer;
+            optimizer.m_deadline = m_deadline;
+            optimizer.m_startTime = m_startTime;
+            optimizer.m_trace.clear();
+            infos.at(i) = optimizer.optimizeUntilDeadline();
+        });
+
+        OptimizationInfo optimizationInfo;
+        optimizationInfo.t0 = infos.front().t0;
+        optimizationInfo.tC = infos.front().tC;
+        optimizationInfo.replicas = infos.front().replicas;
+        for (auto && info : infos) {
+            optimizationInfo.initialCost += info.initialCost;
+            optimizationInfo.finalCost += info.finalCost;
+            optimizationInfo.currentCost += info.currentCost;
+            optimizationInfo.accepts += info.accepts;
+            optimizationInfo.rejects += info.rejects;
+            optimizationInfo.changes += info.changes;
+            optimizationInfo.swaps += info.swaps;
+            optimizationInfo.levels = std::max(optimizationInfo.levels, info.levels);
+            optimizationInfo.outOfTime = optimizationInfo.outOfTime || info.outOfTime;
+        }
+        if (const auto moves = optimizationInfo.accepts + optimizationInfo.rejects; moves) {
+            optimizationInfo.acceptRatio = static_cast<double>(optimizationInfo.accepts) / static_cast<double>(moves);
+        }
+        optimizationInfo.cancelled = m_cancelled;
+
+        if (!m_cancelled) {
+            updateProgress(1);
+        }
+
+        return optimizationInfo;
+    }
+
+    //! Packs the extracted components on shelves, so that the packing is close to the target aspect ratio.
+    void packComponents()
+    {
+        const TraceRecorder::ScopedSpan span { "LayoutOptimizer::packComponents" };
+
+        std::vector<QRectF> rects;
+        double area = 0;
+        double maxWidth = 0;
+        for (auto && component : m_components) {
+            const auto rect = calculateNodeLayoutRect(component.nodes).adjusted(0, 0, m_minEdgeLength, m_minEdgeLength);
+            area += rect.width() * rect.height();
+            maxWidth = std::max(maxWidth, rect.width());
+            rects.push_back(rect);
+        }
+
+        std::vector<size_t> order(rects.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&rects](size_t lhs, size_t rhs) {
+            return rects.at(lhs).height() > rects.at(rhs).height();
+        });
+
+        const double shelfWidth = std::max(maxWidth, std::sqrt(area * m_aspectRatio));
+        std::vector<QPointF> topLefts(rects.size());
+        double x = 0;
+        double y = 0;
+        double shelfHeight = 0;
+        double packedWidth = 0;
+        for (auto && i : order) {
+            if (x > 0 && x + rects.at(i).width() > shelfWidth) {
+                x = 0;
+                y += shelfHeight;
+                shelfHeight = 0;
+            }
+            topLefts.at(i) = { x, y };
+            x += rects.at(i).width();
+            shelfHeight = std::max(shelfHeight, rects.at(i).height());
+            packedWidth = std::max(packedWidth, x);
+        }
+
+        const auto origin = m_componentsCenter - QPointF { packedWidth, y + shelfHeight } / 2;
+        const SceneItems::EdgeUpdateBatch edgeUpdateBatch;
+        for (size_t i = 0; i < m_components.size(); i++) {
+            const auto offset = origin + topLefts.at(i) - rects.at(i).topLeft();
+            for (auto && node : m_components.at(i).nodes) {
+                node->setLocation(m_grid.snapToGrid(node->location() + offset));
+            }
+        }
+    }
+
+    //! Snaps the nodes to the nearest free cells, so that the current layout is preserved as well as the grid allows.
+    void assignNodesToNearestCells(const Graph::NodeVector & nodes)
+    {
+        const auto nodeLayoutRect = calculateNodeLayoutRect(nodes);
+        juzzlin::L(TAG).info() << "Area: " << nodeLayoutRect.height() * nodeLayoutRect.width();
+
+        std::vector<QPointF> positions;
+        for (auto && node : nodes) {
+            positions.push_back(normalizedNodeLocation(node, nodeLayoutRect));
+        }
+        assignVerticesToNearestFreeCells(positions);
+        setNodesToCells(nodes);
+    }
+
+    //! Puts the node i into the cell m_layout->all.at(i).
+    void setNodesToCells(const Graph::NodeVector & nodes)
+    {
+        for (size_t i = 0; i < nodes.size(); i++) {
+            const auto cell = m_layout->all.at(i);
+            m_layout->setNode(cell, nodes.at(i));
+            m_nodesToCells[nodes.at(i)->index()] = cell;
+        }
+    }
+
+    //! \returns The edges between the given nodes as pairs of their positions in the vector.
+    std::vector<std::pair<size_t, size_t>> vertexEdges(const Graph::NodeVector & nodes) const
+    {
+        std::unordered_map<int, size_t> nodesToVertices;
+        for (size_t i = 0; i < nodes.size(); i++) {
+            nodesToVertices[nodes.at(i)->index()] = i;
+        }
+        std::vector<std::pair<size_t, size_t>> edges;
+        for (auto && edge : m_mindMapData->graph().edges()) {
+            const auto vertex0 = nodesToVertices.find(edge->sourceNode().index());
+            const auto vertex1 = nodesToVertices.find(edge->targetNode().index());
+            if (vertex0 != nodesToVertices.end() && vertex1 != nodesToVertices.end()) {
+                edges.emplace_back(vertex0->second, vertex1->second);
+            }
+        }
+        return edges;
+    }
+
+    bool isLocalityPlacementUsed() const
+    {
+        return m_initialPlacement == InitialPlacement::Locality && m_subgraph.empty() && !m_warmStart;
+    }
+
+    //! \returns The vertices breadth-first over the given edges, each component from its vertex of the highest degree,
+    //! so that connected vertices are near each other in the order.
+    static CellVector breadthFirstOrder(size_t vertexCount, const std::vector<std::pair<size_t, size_t>> & edges)
+    {
+        CellVector offsets(vertexCount + 1, 0);
+        for (auto && [vertex0, vertex1] : edges) {
+            offsets.at(vertex0 + 1)++;
+            offsets.at(vertex1 + 1)++;
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        CellVector neighbors(offsets.back());
+        CellVector insertPositions(offsets.begin(), offsets.end() - 1);
+        for (auto && [vertex0, vertex1] : edges) {
+            neighbors.at(insertPositions.at(vertex0)++) = vertex1;
+            neighbors.at(insertPositions.at(vertex1)++) = vertex0;
+        }
+
+        CellVector roots(vertexCount);
+        std::iota(roots.begin(), roots.end(), 0);
+        std::stable_sort(roots.begin(), roots.end(), [&offsets](size_t lhs, size_t rhs) {
+            return offsets.at(lhs + 1) - offsets.at(lhs) > offsets.at(rhs + 1) - offsets.at(rhs);
+        });
+
+        CellVector order;
+        order.reserve(vertexCount);
+        std::vector<bool> visited(vertexCount, false);
+        for (auto && root : roots) {
+            if (visited.at(root)) {
+                continue;
+            }
+            visited.at(root) = true;
+            order.push_back(root);
+            for (size_t head = order.size() - 1; head < order.size(); head++) {
+                const auto vertex = order.at(head);
+                for (auto i = offsets.at(vertex); i < offsets.at(vertex + 1); i++) {
+                    if (const auto neighbor = neighbors.at(i); !visited.at(neighbor)) {
+                        visited.at(neighbor) = true;
+                        order.push_back(neighbor);
+                    }
+                }
+            }
+        }
+        return order;
+    }
+
+    //! \returns The rows and columns of the cells of the grid in the order of a Hilbert curve over the smallest
+    //! power-of-two square that covers the grid. Cells that are consecutive on the curve are near each other.
+    std::vector<std::pair<size_t, size_t>> hilbertCells() const
+    {
+        const auto rowCount = m_layout->rows.size();
+        const auto colCount = m_layout->cols;
+        size_t side = 1;
+        while (side < std::max(rowCount, colCount)) {
+            side *= 2;
+        }
+
+        std::vector<std::pair<size_t, size_t>> cells;
+        cells.reserve(rowCount * colCount);
+        for (size_t distance = 0; distance < side * side; distance++) {
+            // Hilbert curve index to coordinates by rotating the quadrants from the lowest bits up
+            size_t x = 0;
+            size_t y = 0;
+            for (size_t scale = 1, t = distance; scale < side; scale *= 2, t /= 4) {
+                const auto rx = 1 & (t / 2);
+                const auto ry = 1 & (t ^ rx);
+                if (!ry) {
+                    if (rx) {
+                        x = scale - 1 - x;
+                        y = scale - 1 - y;
+                    }
+                    std::swap(x, y);
+                }
+                x += scale * rx;
+                y += scale * ry;
+            }
+            if (y < rowCount && x < colCount) {
+                cells.emplace_back(y, x);
+            }
+        }
+        return cells;
+    }
+
+    //! \returns Normalized positions of the vertices in breadth-first order spread evenly along a Hilbert curve over
+    //! the cells, see assignVerticesToNearestFreeCells().
+    std::vector<QPointF> localityPositions(size_t vertexCount, const std::vector<std::pair<size_t, size_t>> & edges) const
+    {
+        const auto order = breadthFirstOrder(vertexCount, edges);
+        const auto cells = hilbertCells();
+        const auto rowCount = m_layout->rows.size();
+        const auto colCount = m_layout->cols;
+        std::vector<QPointF> positions(vertexCount);
+        for (size_t i = 0; i < order.size(); i++) {
+            const auto [row, col] = cells.at(i * cells.size() / order.size());
+            positions.at(order.at(i)) = {
+                colCount > 1 ? static_cast<double>(col) / static_cast<double>(colCount - 1) : 0,
+                rowCount > 1 ? static_cast<double>(row) / static_cast<double>(rowCount - 1) : 0
+            };
+        }
+        return positions;
+    }
+
+    //! Replaces the current placement of the vertices in m_layout->all by localityPositions() unless that is more
+    //! expensive. setCells sets the nodes and the connections of the cells in m_layout->all after each placement.
+    void placeByLocality(const std::vector<std::pair<size_t, size_t>> & edges, const std::function<void()> & setCells)
+    {
+        const TraceRecorder::ScopedSpan span { "LayoutOptimizer::placeByLocality" };
+
+        const auto currentCost = m_layout->calculateCost();
+        const auto currentCells = m_layout->all;
+        m_layout->clearPlacement();
+        assignVerticesToNearestFreeCells(localityPositions(currentCells.size(), edges));
+        setCells();
+        if (const auto localityCost = m_layout->calculateCost(); localityCost < currentCost) {
+            juzzlin::L(TAG).info() << "Locality placement: " << localityCost << " instead of " << currentCost;
+            m_isLocalityPlaced = true;
+        } else {
+            m_layout->clearPlacement();
+            m_layout->all = currentCells;
+            setCells();
+        }
+    }
+
+    double calculateLayoutArea(const Graph::NodeVector & nodes, double minEdgeLength) const
+    {
+        return std::accumulate(nodes.begin(), nodes.end(), 0.0, [&](double sum, auto && node) {
+            return sum + (node->size().width() + minEdgeLength) * (node->size().height() + minEdgeLength);
+        });
+    }
+
+    void buildInitialCellLayout(double area, double aspectRatio, double minEdgeLength)
+    {
+        const double height = std::sqrt(area / aspectRatio);
+        const double width = area / height;
+
+        m_layout = std::make_unique<Layout>();
+        m_layout->cols = static_cast<size_t>(width / (Constants::Node::minWidth() + minEdgeLength)) + 1;
+        m_layout->minEdgeLength = minEdgeLength;
+        m_layout->cellW = Constants::Node::minHeight();
+        m_layout->cellH = Constants::Node::minWidth();
+        m_layout->slotWidth = Constants::Node::minWidth();
+        m_layout->slotHeight = Constants::Node::minHeight();
+        m_layout->crossingPenalty = m_crossingPenalty;
+
+        const auto rows = static_cast<size_t>(height / (Constants::Node::minHeight() + minEdgeLength)) + 1;
+        for (size_t j = 0; j < rows; j++) {
+            Row row;
+            row.x = 0;
+            row.y = static_cast<int>(j) * Constants::Node::minHeight();
+            for (size_t i = 0; i < m_layout->cols; i++) {
+                const auto cell = m_layout->addCell(row.x + static_cast<int>(i) * Constants::Node::minWidth(), row.y);
+                row.cells.push_back(cell);
+            }
+            m_layout->rows.push_back(row);
+        }
+    }
+
+    //! \returns The selected nodes and the nodes within m_hopCount edges from them.
+    Graph::NodeVector expandSubgraph() const
+    {
+        const auto & graph = m_mindMapData->graph();
+        Graph::NodeVector nodes;
+        std::set<int> visited;
+        for (auto && index : m_subgraph) {
+            if (visited.insert(index).second) {
+                nodes.push_back(graph.getNode(index));
+            }
+        }
+
+        size_t begin = 0;
+        for (size_t hop = 0; hop < m_hopCount && begin < nodes.size(); hop++) {
+            const auto end = nodes.size();
+            for (size_t i = begin; i < end; i++) {
+                const auto index = nodes.at(i)->index();
+                for (auto && edge : graph.edgesFromNode(index)) {
+                    if (visited.insert(edge->targetNode().index()).second) {
+                        nodes.push_back(graph.getNode(edge->targetNode().index()));
+                    }
+                }
+                for (auto && edge : graph.edgesToNode(index)) {
+                    if (visited.insert(edge->sourceNode().index()).second) {
+                        nodes.push_back(graph.getNode(edge->sourceNode().index()));
+                    }
+                }
+            }
+            begin = end;
+        }
+
+        return nodes;
+    }
+
+    //! \returns Cell of a node outside of the subgraph. Anchors are not in any row, so they never move.
+    size_t anchorCell(const NodeS & node)
+    {
+        if (const auto iter = m_anchorsToCells.find(node->index()); iter != m_anchorsToCells.end()) {
+            return iter->second;
+        }
+
+        // Inverse of applyCoordinates(), assuming that the layout doesn't grow when spread
+        const auto gridWidth = static_cast<double>(m_layout->cols - 1) * Constants::Node::minWidth() + m_layout->cellW;
+        const auto gridHeight = static_cast<double>(m_layout->rows.size() - 1) * Constants::Node::minHeight() + m_layout->cellH;
+        const auto cell = m_layout->addCell(0, 0);
+        m_layout->x.at(cell) = node->location().x() - m_layout->center.x() + gridWidth / 2;
+        m_layout->y.at(cell) = node->location().y() - m_layout->center.y() + gridHeight / 2;
+        m_layout->anchors.push_back(cell);
+        m_anchorsToCells[node->index()] = cell;
+        return cell;
+    }
+
+    void setupConnections()
+    {
+        m_anchorsToCells.clear();
+        const auto & graph = m_mindMapData->graph();
+        std::vector<std::pair<size_t, size_t>> connections;
+        for (auto && edge : graph.edges()) {
+            const auto cell0 = m_nodesToCells.find(edge->sourceNode().index());
+            const auto cell1 = m_nodesToCells.find(edge->targetNode().index());
+            if (cell0 != m_nodesToCells.end() && cell1 != m_nodesToCells.end()) {
+                connections.emplace_back(cell0->second, cell1->second);
+            } else if (m_subgraph.empty() && m_componentNodes.empty()) {
+                throw std::runtime_error("Broken node-to-cell mapping!");
+            } else if (!m_componentNodes.empty()) {
+                continue;
+            } else if (cell0 != m_nodesToCells.end()) {
+                connections.emplace_back(cell0->second, anchorCell(graph.getNode(edge->targetNode().index())));
+            } else if (cell1 != m_nodesToCells.end()) {
+                connections.emplace_back(anchorCell(graph.getNode(edge->sourceNode().index())), cell1->second);
+            }
+        }
+
+        m_layout->setConnections(connections);
+    }
+
+    struct Change
+    {
+        size_t sourceCell = 0;
+
+        size_t targetCell = 0;
+
+        size_t sourceRow = 0;
+
+        size_t targetRow = 0;
+
+        size_t sourceIndex = 0;
+
+        size_t targetIndex = 0;
+    };
+
+    //! Cost terms that change when the cells of the given change move: the own overlap costs of the moved cells,
+    //! the overlap terms of their neighbors that involve a moved cell, the lengths of the edges of the moved cells
+    //! and the crossings of those edges.
+    struct LocalCost
+    {
+        double sourceOverlapCost = 0;
+
+        double targetOverlapCost = 0;
+
+        std::vector<double> neighborOverlapCosts;
+
+        double connectionCost = 0;
+
+        double crossingCost = 0;
+
+        double total() const
+        {
+            return std::accumulate(neighborOverlapCosts.begin(), neighborOverlapCosts.end(), sourceOverlapCost + targetOverlapCost + connectionCost + crossingCost);
+        }
+    };
+
+    //! Modified Lam schedule of Swartz and Boyan. The moves that don't change the cost, e.g. swaps of empty cells,
+    //! don't tell anything about the temperature and are left out of the acceptance rate.
+    struct LamSchedule
+    {
+        //! \return The acceptance rate targeted after the given share of the moves: it falls from 1 to 0.44 during
+        //! the first 15 %, stays there until 65 % and then falls exponentially towards 0.
+        static double targetAcceptRateAt(double progress)
+        {
+            if (progress < 0.15) {
+                return 0.44 + 0.56 * std::pow(560.0, -progress / 0.15);
+            }
+
+            if (progress < 0.65) {
+                return 0.44;
+            }
+
+            return 0.44 * std::pow(440.0, -(progress - 0.65) / 0.35);
+        }
+
+        void update(bool accepted, double & temperature)
+        {
+            acceptRate = 0.998 * acceptRate + (accepted ? 0.002 : 0.0);
+            temperature = acceptRate > targetAcceptRate ? temperature * 0.999 : temperature / 0.999;
+        }
+
+        bool enabled = false;
+
+        double acceptRate = 0.5;
+
+        double targetAcceptRate = 1;
+    };
+
+    //! A layout with its own random engine, so that replicas can be annealed on separate threads.
+    struct Replica
+    {
+        std::unique_ptr<Layout> layout;
+
+        FastRandom engine;
+
+        OptimizationInfo info;
+
+        //! Maximum distance of the target slot from the source slot in rows and columns, see updateMoveRadius().
+        size_t moveRadius = 1;
+
+        LamSchedule lamSchedule;
+
+        // Scratch buffers reused by every move so that the inner loop doesn't allocate
+        CellVector neighbors;
+
+        std::vector<size_t> edges; // Edges of the moved cells, only collected if crossings are penalized
+
+        LocalCost oldCost;
+
+        LocalCost newCost;
+    };
+
+    //! A warm start is already a good layout, so it's done once a whole temperature step doesn't improve it anymore.
+    bool hasConvergedFromWarmStart(double temperatureStepCost, double cost) const
+    {
+        return m_warmStart && cost >= temperatureStepCost;
+    }
+
+    bool hasTimeBudget() const
+    {
+        return m_timeBudget.count() > 0;
+    }
+
+    bool isOutOfTime() const
+    {
+        return hasTimeBudget() && std::chrono::steady_clock::now() >= m_deadline;
+    }
+
+    //! \return Cooling factor of the next temperature step. With a time budget the cooling is sped up so that the steps
+    //! down to t1 fit into the remaining time, if they take as long as the steps so far.
+    double coolingFactor(const OptimizationInfo & optimizationInfo, size_t stepCount, std::chrono::steady_clock::time_point startTime) const
+    {
+        if (!hasTimeBudget()) {
+            return optimizationInfo.cS;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        const auto stepDuration = std::chrono::duration<double>(now - startTime) / static_cast<double>(stepCount);
+        if (const auto remainingStepCount = std::chrono::duration<double>(m_deadline - now) / stepDuration; remainingStepCount >= 1) {
+            return std::min(optimizationInfo.cS, std::pow(optimizationInfo.t1 / optimizationInfo.tC, 1 / remainingStepCount));
+        }
+
+        // The time is up after this step, so finish at t1
+        return optimizationInfo.t1 / optimizationInfo.tC;
+    }
+
+    //! Keeps a copy of the best layout when there is a time budget, because the time can run out while the annealing is still hot.
+    class BestLayout
+    {
+    public:
+        BestLayout(bool enabled, const Layout & layout, double cost)
+          : m_cost(cost)
+        {
+            if (enabled) {
+                m_layout = std::make_unique<Layout>(layout);
+            }
+        }
+
+        void update(const Layout & layout, double cost)
+        {
+            if (m_layout && cost < m_cost) {
+                *m_layout = layout;
+                m_cost = cost;
+            }
+        }
+
+        //! Replaces the given layout with the best one if that is better.
+        void restore(std::unique_ptr<Layout> & layout, double & cost)
+        {
+            if (m_layout && m_cost < cost) {
+                layout = std::move(m_layout);
+                cost = m_cost;
+            }
+        }
+
+    private:
+        std::unique_ptr<Layout> m_layout;
+
+        double m_cost = 0;
+    };
+
+    //! Keeps the latest samples of the convergence trace, so that long runs are traced in constant memory.
+    class TraceBuffer
+    {
+    public:
+        explicit TraceBuffer(size_t capacity)
+          : m_capacity(capacity)
+        {
+        }
+
+        void clear()
+        {
+            m_samples.clear();
+            m_next = 0;
+        }
+
+        void push(const TraceSample & sample)
+        {
+            if (m_samples.size() < m_capacity) {
+                m_samples.push_back(sample);
+            } else if (m_capacity) {
+                m_samples.at(m_next) = sample;
+                m_next = (m_next + 1) % m_capacity;
+            }
+        }
+
+        //! \return The samples from the oldest to the latest.
+        std::vector<TraceSample> samples() const
+        {
+            std::vector<TraceSample> samples;
+            samples.reserve(m_samples.size());
+            samples.insert(samples.end(), m_samples.begin() + static_cast<std::ptrdiff_t>(m_next), m_samples.end());
+            samples.insert(samples.end(), m_samples.begin(), m_samples.begin() + static_cast<std::ptrdiff_t>(m_next));
+            return samples;
+        }
+
+    private:
+        size_t m_capacity;
+
+        std::vector<TraceSample> m_samples;
+
+        size_t m_next = 0; // Oldest sample once the buffer is full
+    };
+
+    //! Adds the slice that started at the given time to the trace.
+    void recordSlice(std::chrono::steady_clock::time_point sliceStartTime, double temperature, double cost, size_t accepts, size_t rejects)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        const auto moveCount = accepts + rejects;
+        TraceSample sample;
+        sample.time = std::chrono::duration<double>(now - m_startTime).count();
+        sample.temperature = temperature;
+        sample.cost = cost;
+        sample.acceptRatio = moveCount ? static_cast<double>(accepts) / static_cast<double>(moveCount) : 0;
+        sample.sliceDuration = std::chrono::duration<double>(now - sliceStartTime).count();
+        sample.movesPerSecond = sample.sliceDuration > 0 ? static_cast<double>(moveCount) / sample.sliceDuration : 0;
+        m_trace.push(sample);
+        if (m_traceCallback) {
+            m_traceCallback(sample);
+        }
+    }
+
+    //! \param isRefinement The layout is already good, e.g. a warm start or a projected level.
+    OptimizationInfo optimizeLayout(double t0, bool isRefinement)
+    {
+        const TraceRecorder::ScopedSpan span { "LayoutOptimizer::anneal" };
+
+        if (m_replicaCount > 1) {
+            return optimizeWithParallelTempering(t0);
+        }
+
+        return m_schedule == Schedule::ModifiedLam ? optimizeWithModifiedLam(t0, isRefinement ? LAM_REFINEMENT_PROGRESS : 0) : optimizeWithSingleChain(t0);
+    }
+
+    //! Follows the target acceptance rate from the given share of the moves on. With a time budget the share of the
+    //! elapsed time is used when it's larger, so that the quench is done in time.
+    OptimizationInfo optimizeWithModifiedLam(double t0, double startProgress)
+    {
+        Replica replica;
+        replica.engine.seed(m_seed);
+        replica.layout = std::move(m_layout);
+        replica.lamSchedule.enabled = true;
+        auto & optimizationInfo = replica.info;
+        optimizationInfo.initialCost = replica.layout->calculateCost();
+        optimizationInfo.currentCost = optimizationInfo.initialCost;
+        optimizationInfo.t0 = t0;
+        optimizationInfo.tC = optimizationInfo.t0;
+        const auto moveCount = std::max<size_t>(1, static_cast<size_t>(LAM_MOVES_PER_CELL * (1 - startProgress) * static_cast<double>(replica.layout->all.size())));
+        optimizationInfo.sliceSize = std::max<size_t>(1, moveCount / LAM_SLICE_COUNT);
+
+        juzzlin::L(TAG).info() << "Initial cost: " << optimizationInfo.initialCost << ", moves: " << moveCount;
+
+        BestLayout bestLayout { hasTimeBudget(), *replica.layout, optimizationInfo.initialCost };
+        const auto startTime = std::chrono::steady_clock::now();
+        const auto progress = [&] {
+            auto share = static_cast<double>(optimizationInfo.changes) / static_cast<double>(moveCount);
+            if (hasTimeBudget()) {
+                share = std::max(share, std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime) / std::chrono::duration<double>(m_deadline - startTime));
+            }
+            return startProgress + (1 - startProgress) * std::min(1.0, share);
+        };
+
+        auto currentProgress = startProgress;
+        while (currentProgress < 1 && optimizationInfo.currentCost > 0 && !m_cancelled) {
+            replica.lamSchedule.targetAcceptRate = LamSchedule::targetAcceptRateAt(currentProgress);
+            optimizationInfo.accepts = 0;
+            optimizationInfo.rejects = 0;
+            const auto sliceStartTime = std::chrono::steady_clock::now();
+            runSlice(replica);
+            recordSlice(sliceStartTime, optimizationInfo.tC, optimizationInfo.currentCost, optimizationInfo.accepts, optimizationInfo.rejects);
+            optimizationInfo.acceptRatio = static_cast<double>(optimizationInfo.accepts) / static_cast<double>(optimizationInfo.rejects + 1);
+            juzzlin::L(TAG).debug() << "Cost: " << optimizationInfo.currentCost << " acc: " << replica.lamSchedule.acceptRate
+                                 << " target: " << replica.lamSchedule.targetAcceptRate << " t: " << optimizationInfo.tC;
+
+            bestLayout.update(*replica.layout, optimizationInfo.currentCost);
+            publishPreview(*replica.layout);
+
+            currentProgress = progress();
+            updateProgress((currentProgress - startProgress) / (1 - startProgress));
+        }
+
+        optimizationInfo.outOfTime = isOutOfTime();
+        optimizationInfo.cancelled = m_cancelled;
+
+        m_layout = std::move(replica.layout);
+        bestLayout.restore(m_layout, optimizationInfo.currentCost);
+        optimizationInfo.finalCost = optimizationInfo.currentCost;
+
+        return optimizationInfo;
+    }
+
+    OptimizationInfo optimizeWithSingleChain(double t0)
+    {
+        Replica replica;
+        replica.engine.seed(m_seed);
+        replica.layout = std::move(m_layout);
+        auto & optimizationInfo = replica.info;
+        optimizationInfo.initialCost = replica.layout->calculateCost();
+        optimizationInfo.currentCost = optimizationInfo.initialCost;
+        optimizationInfo.sliceSize = replica.layout->all.size() * 200;
+        optimizationInfo.t0 = t0;
+        optimizationInfo.tC = optimizationInfo.t0;
+
+        juzzlin::L(TAG).info() << "Initial cost: " << optimizationInfo.initialCost;
+
+        BestLayout bestLayout { hasTimeBudget(), *replica.layout, optimizationInfo.initialCost };
+        const auto startTime = std::chrono::steady_clock::now();
+        size_t stepCount = 0;
+        while (optimizationInfo.tC > optimizationInfo.t1 && optimizationInfo.currentCost > 0 && !m_cancelled && !isOutOfTime()) {
+            optimizationInfo.acceptRatio = 0;
+            size_t stuckCounter = 0;
+            const double temperatureStepCost = optimizationInfo.currentCost;
+            do {
+                optimizationInfo.accepts = 0;
+                optimizationInfo.rejects = 0;
+                double sliceCost = optimizationInfo.currentCost;
+                const auto sliceStartTime = std::chrono::steady_clock::now();
+                runSlice(replica);
+                recordSlice(sliceStartTime, optimizationInfo.tC, optimizationInfo.currentCost, optimizationInfo.accepts, optimizationInfo.rejects);
+                optimizationInfo.acceptRatio = static_cast<double>(optimizationInfo.accepts) / static_cast<double>(optimizationInfo.rejects + 1);
+                const double gain = (optimizationInfo.currentCost - sliceCost) / sliceCost;
+                juzzlin::L(TAG).debug() << "Cost: " << optimizationInfo.currentCost << " (" << gain * 100 << "%)"
+                                     << " acc: " << optimizationInfo.acceptRatio << " t: " << optimizationInfo.tC;
+                stuckCounter = gain < optimizationInfo.stuckTh ? stuckCounter + 1 : 0;
+
+                bestLayout.update(*replica.layout, optimizationInfo.currentCost);
+                publishPreview(*replica.layout);
+
+            } while (stuckCounter < optimizationInfo.stuckLimit && !m_cancelled && !isOutOfTime());
+
+            optimizationInfo.tC *= coolingFactor(optimizationInfo, ++stepCount, startTime);
+
+            updateProgress(std::min(1.0, 1.0 - std::log(optimizationInfo.tC) / std::log(optimizationInfo.t0)));
+
+            if (hasConvergedFromWarmStart(temperatureStepCost, optimizationInfo.currentCost)) {
+                break;
+            }
+        }
+
+        optimizationInfo.outOfTime = isOutOfTime();
+        optimizationInfo.cancelled = m_cancelled;
+
+        m_layout = std::move(replica.layout);
+        bestLayout.restore(m_layout, optimizationInfo.currentCost);
+        optimizationInfo.finalCost = optimizationInfo.currentCost;
+
+        return optimizationInfo;
+    }
+
+    // Runs replicas on a ladder of temperatures in parallel and periodically lets neighboring replicas
+    // exchange their temperatures. The whole ladder is cooled like the single chain when the best cost
+    // gets stuck, and the best replica is the result.
+    OptimizationInfo optimizeWithParallelTempering(double t0)
+    {
+        OptimizationInfo optimizationInfo;
+        optimizationInfo.initialCost = m_layout->calculateCost();
+        optimizationInfo.currentCost = optimizationInfo.initialCost;
+        optimizationInfo.sliceSize = m_layout->all.size() * 200;
+        optimizationInfo.t0 = t0;
+        optimizationInfo.tC = optimizationInfo.t0;
+        optimizationInfo.replicas = m_replicaCount;
+
+        juzzlin::L(TAG).info() << "Initial cost: " << optimizationInfo.initialCost << ", replicas: " << m_replicaCount;
+
+        // The coldest replica starts at t1 relative to the hottest one
+        std::vector<Replica> replicas(m_replicaCount);
+        for (size_t i = 0; i < replicas.size(); i++) {
+            auto && replica = replicas.at(i);
+            replica.layout = std::make_unique<Layout>(*m_layout);
+            replica.engine.seed(m_seed + static_cast<uint32_t>(i));
+            replica.info = optimizationInfo;
+            replica.info.tC = optimizationInfo.t0 * std::pow(optimizationInfo.t1 / optimizationInfo.t0, static_cast<double>(i) / static_cast<double>(replicas.size()));
+        }
+
+        std::uniform_real_distribution<double> swapDist { 0, 1 };
+        std::mt19937 swapEngine { m_seed };
+        const auto bestReplica = [&replicas]() -> Replica & {
+            return *std::min_element(replicas.begin(), replicas.end(), [](auto && lhs, auto && rhs) {
+                return lhs.info.currentCost < rhs.info.currentCost;
+            });
+        };
+        const auto bestCost = [&bestReplica] {
+            return bestReplica().info.currentCost;
+        };
+
+        BestLayout bestLayout { hasTimeBudget(), *m_layout, optimizationInfo.initialCost };
+        const auto startTime = std::chrono::steady_clock::now();
+        size_t stepCount = 0;
+        while (optimizationInfo.tC > optimizationInfo.t1 && bestCost() > 0 && !m_cancelled && !isOutOfTime()) {
+            size_t stuckCounter = 0;
+            const double temperatureStepCost = bestCost();
+            do {
+                const double sliceCost = bestCost();
+
+                for (auto && replica : replicas) {
+                    replica.info.accepts = 0;
+                    replica.info.rejects = 0;
+                }
+                const auto sliceStartTime = std::chrono::steady_clock::now();
+                SC::instance().taskPool()->run(replicas.size(), [&replicas](size_t i) {
+                    runSlice(replicas.at(i));
+                });
+                size_t sliceAccepts = 0;
+                size_t sliceRejects = 0;
+                for (auto && replica : replicas) {
+                    sliceAccepts += replica.info.accepts;
+                    sliceRejects += replica.info.rejects;
+                }
+                recordSlice(sliceStartTime, optimizationInfo.tC, bestCost(), sliceAccepts, sliceRejects);
+
+                // Replicas are ordered from hot to cold, so a swap moves the better layout towards the cold end
+                for (size_t i = 0; i + 1 < replicas.size(); i++) {
+                    auto && hot = replicas.at(i).info;
+                    auto && cold = replicas.at(i + 1).info;
+                    const double exponent = (cold.currentCost - hot.currentCost) * (1 / cold.tC - 1 / hot.tC);
+                    if (exponent >= 0 || swapDist(swapEngine) < std::exp(exponent)) {
+                        std::swap(hot.tC, cold.tC);
+                        std::swap(replicas.at(i), replicas.at(i + 1));
+                        optimizationInfo.swaps++;
+                    }
+                }
+
+                const double gain = (bestCost() - sliceCost) / sliceCost;
+                juzzlin::L(TAG).debug() << "Best cost: " << bestCost() << " (" << gain * 100 << "%)"
+                                     << " t: " << optimizationInfo.tC << " swaps: " << optimizationInfo.swaps;
+                stuckCounter = gain < optimizationInfo.stuckTh ? stuckCounter + 1 : 0;
+
+                bestLayout.update(*bestReplica().layout, bestCost());
+                publishPreview(*bestReplica().layout);
+
+            } while (stuckCounter < optimizationInfo.stuckLimit && !m_cancelled && !isOutOfTime());
+
+            const auto cS = coolingFactor(optimizationInfo, ++stepCount, startTime);
+            optimizationInfo.tC *= cS;
+            for (auto && replica : replicas) {
+                replica.info.tC *= cS;
+            }
+
+            updateProgress(std::min(1.0, 1.0 - std::log(optimizationInfo.tC) / std::log(optimizationInfo.t0)));
+
+            if (hasConvergedFromWarmStart(temperatureStepCost, bestCost())) {
+                break;
+            }
+        }
+
+        for (auto && replica : replicas) {
+            optimizationInfo.accepts += replica.info.accepts;
+            optimizationInfo.rejects += replica.info.rejects;
+            optimizationInfo.changes += replica.info.changes;
+        }
+        optimizationInfo.acceptRatio = static_cast<double>(optimizationInfo.accepts) / static_cast<double>(optimizationInfo.rejects + 1);
+
+        auto && best = bestReplica();
+        optimizationInfo.cancelled = m_cancelled;
+        optimizationInfo.outOfTime = isOutOfTime();
+        optimizationInfo.currentCost = best.info.currentCost;
+        m_layout = std::move(best.layout);
+        bestLayout.restore(m_layout, optimizationInfo.currentCost);
+        optimizationInfo.finalCost = optimizationInfo.currentCost;
+
+        return optimizationInfo;
+    }
+
+
+    //! A level of the multilevel hierarchy. Level 0 has a vertex per node in the order of m_nodes.
+    struct Level
+    {
+        size_t vertexCount = 0;
+
+        std::vector<std::pair<size_t, size_t>> edges;
+
+        //! Number of nodes collapsed into each vertex.
+        std::vector<size_t> weights;
+
+        //! Wanted positions of the vertices, normalized to [0, 1] over the layout.
+        std::vector<QPointF> positions;
+
+        //! Vertex of the next coarser level that each vertex was collapsed into.
+        CellVector coarseVertices;
+    };
+
+    QPointF normalizedNodeLocation(const NodeS & node, const QRectF & nodeLayoutRect) const
+    {
+        return {
+            nodeLayoutRect.width() > 0 ? (node->location().x() - nodeLayoutRect.x()) / nodeLayoutRect.width() : 0.5,
+            nodeLayoutRect.height() > 0 ? (node->location().y() - nodeLayoutRect.y()) / nodeLayoutRect.height() : 0.5
+        };
+    }
+
+    void initializeLevels(const Graph::NodeVector & nodes, double aspectRatio, double minEdgeLength)
+    {
+        const TraceRecorder::ScopedSpan span { "LayoutOptimizer::coarsen" };
+
+        m_nodes = nodes;
+        m_aspectRatio = aspectRatio;
+        m_minEdgeLength = minEdgeLength;
+
+        Level level;
+        level.vertexCount = nodes.size();
+        level.weights.assign(nodes.size(), 1);
+        const auto nodeLayoutRect = calculateNodeLayoutRect(nodes);
+        std::map<int, size_t> nodesToVertices;
+        for (size_t i = 0; i < nodes.size(); i++) {
+            nodesToVertices[nodes.at(i)->index()] = i;
+            level.positions.push_back(normalizedNodeLocation(nodes.at(i), nodeLayoutRect));
+        }
+        for (auto && edge : m_mindMapData->graph().edges()) {
+            const auto vertex0 = nodesToVertices.find(edge->sourceNode().index());
+            const auto vertex1 = nodesToVertices.find(edge->targetNode().index());
+            if (vertex0 != nodesToVertices.end() && vertex1 != nodesToVertices.end()) {
+                level.edges.emplace_back(vertex0->second, vertex1->second);
+            } else if (m_componentNodes.empty()) {
+                throw std::runtime_error("Broken node-to-vertex mapping!");
+            }
+        }
+        m_levels.push_back(level);
+
+        while (m_levels.back().vertexCount > Constants::LayoutOptimizer::multilevelCoarsestNodeCount()) {
+            auto coarseLevel = coarsen(m_levels.back());
+            // Stop if the graph doesn't really coarsen anymore
+            if (coarseLevel.vertexCount * 20 > m_levels.back().vertexCount * 19) {
+                break;
+            }
+            m_levels.push_back(std::move(coarseLevel));
+        }
+
+        juzzlin::L(TAG).info() << "Levels: " << m_levels.size() << ", coarsest vertex count: " << m_levels.back().vertexCount;
+
+        buildLevelLayout(m_levels.size() - 1);
+    }
+
+    //! Collapses leaves into their neighbors and merges the remaining vertices pairwise with their lightest unmatched neighbor.
+    static Level coarsen(Level & level)
+    {
+        std::vector<CellVector> neighbors(level.vertexCount);
+        for (auto && [vertex0, vertex1] : level.edges) {
+            if (vertex0 != vertex1) {
+                neighbors.at(vertex0).push_back(vertex1);
+                neighbors.at(vertex1).push_back(vertex0);
+            }
+        }
+
+        const auto isLeaf = [&neighbors](size_t vertex) {
+            return neighbors.at(vertex).size() == 1 && neighbors.at(neighbors.at(vertex).front()).size() > 1;
+        };
+
+        Level coarseLevel;
+        const auto unmatched = std::numeric_limits<size_t>::max();
+        auto & coarseVertices = level.coarseVertices;
+        coarseVertices.assign(level.vertexCount, unmatched);
+        for (size_t vertex = 0; vertex < level.vertexCount; vertex++) {
+            if (coarseVertices.at(vertex) != unmatched || isLeaf(vertex)) {
+                continue;
+            }
+            std::optional<size_t> match;
+            for (auto && neighbor : neighbors.at(vertex)) {
+                if (coarseVertices.at(neighbor) == unmatched && !isLeaf(neighbor) && (!match || level.weights.at(neighbor) < level.weights.at(*match))) {
+                    match = neighbor;
+                }
+            }
+            coarseVertices.at(vertex) = coarseLevel.vertexCount;
+            if (match) {
+                coarseVertices.at(*match) = coarseLevel.vertexCount;
+            }
+            coarseLevel.vertexCount++;
+        }
+        for (size_t vertex = 0; vertex < level.vertexCount; vertex++) {
+            if (isLeaf(vertex)) {
+                coarseVertices.at(vertex) = coarseVertices.at(neighbors.at(vertex).front());
+            }
+        }
+
+        coarseLevel.weights.assign(coarseLevel.vertexCount, 0);
+        coarseLevel.positions.assign(coarseLevel.vertexCount, {});
+        for (size_t vertex = 0; vertex < level.vertexCount; vertex++) {
+            const auto coarseVertex = coarseVertices.at(vertex);
+            coarseLevel.weights.at(coarseVertex) += level.weights.at(vertex);
+            coarseLevel.positions.at(coarseVertex) += level.positions.at(vertex) * static_cast<double>(level.weights.at(vertex));
+        }
+        for (size_t vertex = 0; vertex < coarseLevel.vertexCount; vertex++) {
+            coarseLevel.positions.at(vertex) /= static_cast<double>(coarseLevel.weights.at(vertex));
+        }
+
+        for (auto && [vertex0, vertex1] : level.edges) {
+            if (const auto coarseVertex0 = coarseVertices.at(vertex0), coarseVertex1 = coarseVertices.at(vertex1); coarseVertex0 != coarseVertex1) {
+                coarseLevel.edges.emplace_back(std::min(coarseVertex0, coarseVertex1), std::max(coarseVertex0, coarseVertex1));
+            }
+        }
+        std::sort(coarseLevel.edges.begin(), coarseLevel.edges.end());
+        coarseLevel.edges.erase(std::unique(coarseLevel.edges.begin(), coarseLevel.edges.end()), coarseLevel.edges.end());
+
+        return coarseLevel;
+    }
+
+    //! Builds m_layout for the given level. The vertex i is in the cell m_layout->all.at(i).
+    void buildLevelLayout(size_t levelIndex)
+    {
+        const auto & level = m_levels.at(levelIndex);
+        const double area = levelIndex ? static_cast<double>(level.vertexCount) * (Constants::Node::minWidth() + m_minEdgeLength) * (Constants::Node::minHeight() + m_minEdgeLength)
+                                       : calculateLayoutArea(m_nodes, m_minEdgeLength);
+        buildInitialCellLayout(area, m_aspectRatio, m_minEdgeLength);
+        assignVerticesToNearestFreeCells(level.positions);
+        const auto setCells = [this, &level, levelIndex] {
+            if (!levelIndex) {
+                for (size_t i = 0; i < m_nodes.size(); i++) {
+                    m_layout->setNode(m_layout->all.at(i), m_nodes.at(i));
+                }
+            }
+            std::vector<std::pair<size_t, size_t>> connections;
+            for (auto && [vertex0, vertex1] : level.edges) {
+                connections.emplace_back(m_layout->all.at(vertex0), m_layout->all.at(vertex1));
+            }
+            m_layout->setConnections(connections);
+        };
+        setCells();
+
+        // The finer levels start from the projection of the coarser one
+        if (levelIndex + 1 == m_levels.size() && isLocalityPlacementUsed()) {
+            placeByLocality(level.edges, setCells);
+        }
+    }
+
+    //! Searches the free cells in growing rings around the wanted cell, so that the cost doesn't depend on the size of the layout.
+    void assignVerticesToNearestFreeCells(const std::vector<QPointF> & positions)
+    {
+        const auto rowCount = static_cast<int>(m_layout->rows.size());
+        const auto colCount = static_cast<int>(m_layout->cols);
+        std::vector<bool> occupied(m_layout->rows.size() * m_layout->cols);
+        for (auto && position : positions) {
+            const auto wantedRow = static_cast<int>(std::round(std::clamp(position.y(), 0.0, 1.0) * (rowCount - 1)));
+            const auto wantedCol = static_cast<int>(std::round(std::clamp(position.x(), 0.0, 1.0) * (colCount - 1)));
+            std::optional<std::pair<int, int>> nearest;
+            int nearestDistance = std::numeric_limits<int>::max();
+            const auto consider = [&](int row, int col) {
+                const auto distance = (row - wantedRow) * (row - wantedRow) + (col - wantedCol) * (col - wantedCol);
+                if (col >= 0 && col < colCount && !occupied.at(static_cast<size_t>(row * colCount + col)) && distance < nearestDistance) {
+                    nearest = { row, col };
+                    nearestDistance = distance;
+                }
+            };
+            for (int radius = 0; !nearest && radius < std::max(rowCount, colCount); radius++) {
+                for (int row = std::max(0, wantedRow - radius); row <= std::min(rowCount - 1, wantedRow + radius); row++) {
+                    if (std::abs(row - wantedRow) == radius) {
+                        for (int col = wantedCol - radius; col <= wantedCol + radius; col++) {
+                            consider(row, col);
+                        }
+                    } else {
+                        consider(row, wantedCol - radius);
+                        consider(row, wantedCol + radius);
+                    }
+                }
+            }
+            if (!nearest) {
+                throw std::runtime_error("All nodes cannot be mapped to cells!");
+            }
+            occupied.at(static_cast<size_t>(nearest->first * colCount + nearest->second)) = true;
+            m_layout->all.push_back(m_layout->rows.at(static_cast<size_t>(nearest->first)).cells.at(static_cast<size_t>(nearest->second)));
+        }
+    }
+
+    QPointF normalizedCellPosition(size_t cell) const
+    {
+        const auto col = m_layout->x.at(cell) / Constants::Node::minWidth();
+        const auto row = m_layout->y.at(cell) / Constants::Node::minHeight();
+        return {
+            m_layout->cols > 1 ? col / static_cast<double>(m_layout->cols - 1) : 0.5,
+            m_layout->rows.size() > 1 ? row / static_cast<double>(m_layout->rows.size() - 1) : 0.5
+        };
+    }
+
+    OptimizationInfo optimizeMultilevel()
+    {
+        OptimizationInfo optimizationInfo;
+        optimizationInfo.levels = m_levels.size();
+        optimizationInfo.replicas = m_replicaCount;
+        m_progressScale = 1.0 / static_cast<double>(m_levels.size());
+        // The remaining time is shared between the remaining levels by their vertex counts
+        const auto deadline = m_deadline;
+        size_t remainingVertexCount = 0;
+        for (auto && level : m_levels) {
+            remainingVertexCount += level.vertexCount;
+        }
+        for (size_t levelIndex = m_levels.size(); levelIndex-- > 0;) {
+            const bool isCoarsest = levelIndex + 1 == m_levels.size();
+            if (!isCoarsest) {
+                // Project: the vertices start around the optimized positions of the vertices they were collapsed into
+                auto & level = m_levels.at(levelIndex);
+                for (size_t vertex = 0; vertex < level.vertexCount; vertex++) {
+                    level.positions.at(vertex) = normalizedCellPosition(m_layout->all.at(level.coarseVertices.at(vertex)));
+                }
+                buildLevelLayout(levelIndex);
+            }
+
+            m_progressOffset = static_cast<double>(m_levels.size() - 1 - levelIndex) * m_progressScale;
+            const auto now = std::chrono::steady_clock::now();
+            const auto levelShare = static_cast<double>(m_levels.at(levelIndex).vertexCount) / static_cast<double>(remainingVertexCount);
+            m_deadline = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>((deadline - now) * levelShare);
+            remainingVertexCount -= m_levels.at(levelIndex).vertexCount;
+            OptimizationInfo levelInfo;
+            // When cancelled, the remaining levels are only projected so that the result is a layout of the nodes
+            if (m_layout->all.size() > 1 && !m_cancelled) {
+                if (isCoarsest) {
+                    levelInfo = m_isLocalityPlaced ? optimizeLayout(estimateWarmStartTemperature(), true) : optimizeLayout(INITIAL_TEMPERATURE, false);
+                } else {
+                    levelInfo = optimizeLayout(REFINEMENT_TEMPERATURE, true);
+                }
+            } else {
+                levelInfo.initialCost = m_layout->calculateCost();
+                levelInfo.finalCost = levelInfo.initialCost;
+                levelInfo.currentCost = levelInfo.initialCost;
+            }
+            juzzlin::L(TAG).info() << "Level " << levelIndex << ": " << m_layout->all.size() << " vertices, cost: " << levelInfo.finalCost;
+
+            optimizationInfo.accepts += levelInfo.accepts;
+            optimizationInfo.rejects += levelInfo.rejects;
+            optimizationInfo.changes += levelInfo.changes;
+            optimizationInfo.swaps += levelInfo.swaps;
+            if (!levelIndex) {
+                optimizationInfo.initialCost = levelInfo.initialCost;
+                optimizationInfo.finalCost = levelInfo.finalCost;
+                optimizationInfo.currentCost = levelInfo.currentCost;
+                optimizationInfo.tC = levelInfo.tC;
+                optimizationInfo.t0 = levelInfo.t0;
+            }
+        }
+        optimizationInfo.acceptRatio = static_cast<double>(optimizationInfo.accepts) / static_cast<double>(optimizationInfo.rejects + 1);
+        optimizationInfo.cancelled = m_cancelled;
+        m_deadline = deadline;
+        optimizationInfo.outOfTime = isOutOfTime();
+
+        m_progressOffset = 0;
+        m_progressScale = 1;
+        updateProgress(1);
+
+        return optimizationInfo;
+    }
+
+    //! \return Temperature at which WARM_START_ACCEPT_RATIO of sampled uphill moves from the current layout would be accepted.
+    double estimateWarmStartTemperature()
+    {
+        Replica replica;
+        replica.engine.seed(m_seed);
+        replica.layout = std::move(m_layout);
+        replica.layout->calculateCost();
+
+        std::vector<double> uphillDeltas;
+        for (size_t i = 0; i < WARM_START_SAMPLE_COUNT; i++) {
+            const auto change = planChange(replica);
+            applyChangeAndCalculateCosts(replica, change);
+            if (const double delta = replica.newCost.total() - replica.oldCost.total(); delta > 0) {
+                uphillDeltas.push_back(delta);
+            }
+            undoChange(*replica.layout, change);
+        }
+
+        m_layout = std::move(replica.layout);
+
+        const auto acceptRatio = [&uphillDeltas](double temperature) {
+            return std::accumulate(uphillDeltas.begin(), uphillDeltas.end(), 0.0, [temperature](double sum, double delta) {
+                       return sum + std::exp(-delta / temperature);
+                   })
+              / static_cast<double>(uphillDeltas.size());
+        };
 
-        const auto rows = static_cast<size_t>(height / (Constants::Node::minHeight() + minEdgeLength)) + 1;
-        for (size_t j = 0; j < rows; j++) {
-            const auto row = std::make_shared<Row>();
-            row->rect.x = 0;
-            row->rect.y = static_cast<int>(j) * Constants::Node::minHeight();
-            for (size_t i = 0; i < m_layout->cols; i++) {
-                const auto cell = std::make_shared<Cell>();
-                row->cells.push_back(cell);
-                cells.push_back(cell);
-                cell->setRect({ row->rect.x + static_cast<int>(i) * Constants::Node::minWidth(),
-                                row->rect.y,
-                                Constants::Node::minHeight(),
-                                Constants::Node::minWidth() });
-            }
-            m_layout->rows.push_back(row);
+        // Still do a couple of cooling steps so that the warm start also gets refined
+        const OptimizationInfo defaults;
+        double minTemperature = defaults.t1 / defaults.cS / defaults.cS;
+        double maxTemperature = INITIAL_TEMPERATURE;
+        if (uphillDeltas.empty() || acceptRatio(minTemperature) >= WARM_START_ACCEPT_RATIO) {
+            return minTemperature;
+        }
+        if (acceptRatio(maxTemperature) <= WARM_START_ACCEPT_RATIO) {
+            return maxTemperature;
         }
 
-        m_rowDist = std::uniform_int_distribution<size_t> { 0, m_layout->rows.size() - 1 };
+        // The accept ratio grows monotonically with the temperature
+        for (size_t i = 0; i < 32; i++) {
+            const double temperature = std::sqrt(minTemperature * maxTemperature);
+            (acceptRatio(temperature) < WARM_START_ACCEPT_RATIO ? minTemperature : maxTemperature) = temperature;
+        }
 
-        return cells;
+        juzzlin::L(TAG).info() << "Warm start temperature: " << maxTemperature;
+        return maxTemperature;
     }
 
-    void setupConnections()
+    //! Long moves help while the layout is hot but mostly get rejected once it's cold, so the range shrinks from half of
+    //! the grid, at most MAX_MOVE_RADIUS, to the adjacent slots as the temperature drops from INITIAL_TEMPERATURE to t1.
+    static void updateMoveRadius(Replica & replica)
     {
-        for (auto && edge : m_mindMapData->graph().getEdges()) {
-            const auto cell0 = m_nodesToCells[edge->sourceNode().index()];
-            const auto cell1 = m_nodesToCells[edge->targetNode().index()];
-            if (cell0 && cell1) {
-                cell0->addConnection(cell1);
-                cell1->addConnection(cell0);
-            } else {
-                throw std::runtime_error("Broken node-to-cell mapping!");
-            }
+        const auto & layout = *replica.layout;
+        const auto & info = replica.info;
+        const auto maxRadius = std::clamp<size_t>(std::max(layout.rows.size(), layout.cols) / 2, 1, MAX_MOVE_RADIUS);
+        if (const auto heat = std::log(info.tC / info.t1) / std::log(INITIAL_TEMPERATURE / info.t1); std::isfinite(heat)) {
+            replica.moveRadius = 1 + static_cast<size_t>(std::clamp(heat, 0.0, 1.0) * static_cast<double>(maxRadius - 1));
+        } else {
+            replica.moveRadius = 1;
         }
     }
 
-    struct Change
+    static void runSlice(Replica & replica)
     {
-        std::shared_ptr<Cell> sourceCell;
+        updateMoveRadius(replica);
+        for (size_t i = 0; i < replica.info.sliceSize; i++) {
+            changeLayoutAndUpdateCost(replica);
+        }
 
-        std::shared_ptr<Cell> targetCell;
+        // Resync with the full cost so that rounding errors of the deltas don't accumulate
+        replica.info.currentCost = replica.layout->calculateCost();
+    }
 
-        std::shared_ptr<Row> sourceRow;
+    static void calculateLocalCost(Layout & layout, const Change & change, const CellVector & neighbors, const std::vector<size_t> & edges, bool useCachedOverlapCosts, LocalCost & cost)
+    {
+        cost.sourceOverlapCost = useCachedOverlapCosts ? layout.overlapCosts[change.sourceCell] : layout.calculateOverlapCost(change.sourceCell);
+        cost.targetOverlapCost = useCachedOverlapCosts ? layout.overlapCosts[change.targetCell] : layout.calculateOverlapCost(change.targetCell);
+        cost.neighborOverlapCosts.clear();
+        for (auto && neighbor : neighbors) {
+            cost.neighborOverlapCosts.push_back(layout.calculateOverlapCostInvolving(neighbor, change.sourceCell, change.targetCell));
+        }
+        // Each edge is counted from both ends in the full cost
+        cost.connectionCost = layout.calculateConnectionCostExcept(change.sourceCell, change.targetCell, 2) + layout.calculateConnectionCostExcept(change.targetCell, change.sourceCell, 2);
+        cost.crossingCost = layout.hasCrossingCost() ? layout.calculateCrossingCost(edges) : 0;
+    }
 
-        std::shared_ptr<Row> targetRow;
+    //! Applies the change and calculates the local costs before and after it to replica.oldCost and replica.newCost.
+    static void applyChangeAndCalculateCosts(Replica & replica, const Change & change)
+    {
+        auto & layout = *replica.layout;
+
+        // Only the neighbors of the moved cells are affected, so the cost of a move doesn't depend on the degree of the neighbors
+        layout.moveId++;
+        auto & neighbors = replica.neighbors;
+        neighbors.clear();
+        for (auto && cell : { change.sourceCell, change.targetCell }) {
+            for (auto i = layout.connectionOffsets[cell]; i < layout.connectionOffsets[cell + 1]; i++) {
+                if (const auto neighbor = layout.connections[i]; neighbor != change.sourceCell && neighbor != change.targetCell && layout.mark(neighbor, layout.moveId)) {
+                    neighbors.push_back(neighbor);
+                }
+            }
+        }
 
-        size_t sourceIndex = 0;
+        auto & edges = replica.edges;
+        edges.clear();
+        if (layout.hasCrossingCost()) {
+            for (auto && cell : { change.sourceCell, change.targetCell }) {
+                for (auto i = layout.connectionOffsets[cell]; i < layout.connectionOffsets[cell + 1]; i++) {
+                    // The edges between the moved cells are seen from both of them
+                    if (cell == change.sourceCell || layout.connections[i] != change.sourceCell) {
+                        edges.push_back(layout.connectionEdges[i]);
+                    }
+                }
+            }
+        }
 
-        size_t targetIndex = 0;
-    };
+        calculateLocalCost(layout, change, neighbors, edges, true, replica.oldCost);
+        applyChangeAsSwap(layout, change);
+        calculateLocalCost(layout, change, neighbors, edges, false, replica.newCost);
+    }
 
-    void changeLayoutAndUpdateCost(OptimizationInfo & optimizationInfo)
+    static void changeLayoutAndUpdateCost(Replica & replica)
     {
-        const auto change = planChange();
-        LayoutOptimizer::Impl::Cell::globalMoveId++;
-        double newCost = optimizationInfo.currentCost;
-        newCost -= change.sourceCell->calculateCost();
-        newCost -= change.targetCell->calculateCost();
-        applyChangeAsSwap(change);
+        auto & optimizationInfo = replica.info;
+        auto & layout = *replica.layout;
+        const auto change = planChange(replica);
+        applyChangeAndCalculateCosts(replica, change);
         optimizationInfo.changes++;
-        LayoutOptimizer::Impl::Cell::globalMoveId++;
-        newCost += change.sourceCell->calculateCost();
-        newCost += change.targetCell->calculateCost();
-        if (const double delta = newCost - optimizationInfo.currentCost; delta <= 0) {
-            optimizationInfo.currentCost = newCost;
+
+        const auto & neighbors = replica.neighbors;
+        const auto & oldCost = replica.oldCost;
+        const auto & newCost = replica.newCost;
+
+        const auto accept = [&] {
+            optimizationInfo.currentCost += newCost.total() - oldCost.total();
             optimizationInfo.accepts++;
+            layout.overlapCosts[change.sourceCell] = newCost.sourceOverlapCost;
+            layout.overlapCosts[change.targetCell] = newCost.targetOverlapCost;
+            for (size_t i = 0; i < neighbors.size(); i++) {
+                layout.overlapCosts[neighbors[i]] += newCost.neighborOverlapCosts[i] - oldCost.neighborOverlapCosts[i];
+            }
+            if (layout.hasCrossingCost()) {
+                layout.crossingIndex.update(layout.x.data(), layout.y.data(), replica.edges);
+            }
+        };
+
+        const double delta = newCost.total() - oldCost.total();
+        bool accepted = true;
+        if (delta <= 0) {
+            accept();
         } else {
-            if (m_saDist(m_engine) < std::exp(-delta / optimizationInfo.tC)) {
-                optimizationInfo.currentCost = newCost;
-                optimizationInfo.accepts++;
+            if (replica.engine.uniform() < std::exp(-delta / optimizationInfo.tC)) {
+                accept();
             } else {
-                undoChange(change);
+                undoChange(layout, change);
                 optimizationInfo.rejects++;
+                accepted = false;
             }
         }
-    }
-
-    void applyChangeAsSwap(const Change & change)
-    {
-        change.sourceRow->cells.at(change.sourceIndex) = change.targetCell;
-        change.targetRow->cells.at(change.targetIndex) = change.sourceCell;
 
-        change.sourceCell->pushRect();
-        change.sourceCell->setRectXY(change.targetRow->rect.x + static_cast<int>(change.targetIndex) * Constants::Node::minWidth(),
-                                     change.targetRow->rect.y);
-
-        change.targetCell->pushRect();
-        change.targetCell->setRectXY(change.sourceRow->rect.x + static_cast<int>(change.sourceIndex) * Constants::Node::minWidth(),
-                                     change.sourceRow->rect.y);
-    }
-
-    void undoChange(const Change & change)
-    {
-        change.sourceRow->cells.at(change.sourceIndex) = change.sourceCell;
-        change.targetRow->cells.at(change.targetIndex) = change.targetCell;
-        change.sourceCell->popRect();
-        change.targetCell->popRect();
-    }
-
-    size_t getTargetRowIndex(size_t sourceRowIndex, size_t rowDelta)
-    {
-        return sourceRowIndex + rowDelta < m_layout->rows.size() ? sourceRowIndex + rowDelta : sourceRowIndex;
+        if (replica.lamSchedule.enabled && delta != 0.0) {
+            replica.lamSchedule.update(accepted, optimizationInfo.tC);
+        }
     }
 
-    void setSource(Change & change, size_t sourceRowIndex)
+    // The cells always sit at the positions of their grid slots, so moving them to each other's slots is a swap of positions
+    static void applyChangeAsSwap(Layout & layout, const Change & change)
     {
-        change.sourceRow = m_layout->rows.at(sourceRowIndex);
-        std::uniform_int_distribution<size_t> sourceCellDist { 0, change.sourceRow->cells.size() - 1 };
-        change.sourceIndex = sourceCellDist(m_engine);
-        change.sourceCell = change.sourceRow->cells.at(change.sourceIndex);
+        layout.rows.at(change.sourceRow).cells.at(change.sourceIndex) = change.targetCell;
+        layout.rows.at(change.targetRow).cells.at(change.targetIndex) = change.sourceCell;
+        std::swap(layout.x[change.sourceCell], layout.x[change.targetCell]);
+        std::swap(layout.y[change.sourceCell], layout.y[change.targetCell]);
     }
 
-    void setTarget(Change & change, size_t targetRowIndex)
+    static void undoChange(Layout & layout, const Change & change)
     {
-        change.targetRow = m_layout->rows.at(targetRowIndex);
-        const auto cellDelta = m_oneOrTwoDist(m_engine);
-        change.targetIndex = change.sourceIndex + cellDelta < change.targetRow->cells.size() ? change.sourceIndex + cellDelta : change.sourceIndex;
-        change.targetCell = change.targetRow->cells.at(change.targetIndex);
+        layout.rows.at(change.sourceRow).cells.at(change.sourceIndex) = change.sourceCell;
+        layout.rows.at(change.targetRow).cells.at(change.targetIndex) = change.targetCell;
+        std::swap(layout.x[change.sourceCell], layout.x[change.targetCell]);
+        std::swap(layout.y[change.sourceCell], layout.y[change.targetCell]);
     }
 
-    // Note: Here we plan only very local changes with a very small search radius as we assume that the nodes are already relatively well placed globally.
-    Change planChange()
+    //! Moves a node to a random slot within the move radius, or next to a node it's connected to. Moving empty cells
+    //! doesn't change the cost, so the source is always a cell with a node.
+    static Change planChange(Replica & replica)
     {
+        const auto & layout = *replica.layout;
+        auto & random = replica.engine;
         Change change;
-
-        do {
-            if (const auto sourceRowIndex = m_rowDist(m_engine); !m_layout->rows.at(sourceRowIndex)->cells.empty()) {
-                setSource(change, sourceRowIndex);
-
-                if (const auto targetRowIndex = getTargetRowIndex(sourceRowIndex, m_oneOrTwoDist(m_engine)); !m_layout->rows.at(targetRowIndex)->cells.empty()) {
-                    setTarget(change, targetRowIndex);
-                }
+        for (;;) {
+            change.sourceCell = layout.all[random.below(layout.all.size())];
+            std::tie(change.sourceRow, change.sourceIndex) = layout.nearestSlot(change.sourceCell);
+
+            long targetRow = 0;
+            long targetIndex = 0;
+            const auto connectionsBegin = layout.connectionOffsets[change.sourceCell];
+            const auto connectionCount = layout.connectionOffsets[change.sourceCell + 1] - connectionsBegin;
+            if (connectionCount && random.uniform() < CONNECTED_MOVE_SHARE) {
+                const auto [neighborRow, neighborIndex] = layout.nearestSlot(layout.connections[connectionsBegin + random.below(connectionCount)]);
+                const auto & offset = ADJACENT_SLOT_OFFSETS.at(random.below(ADJACENT_SLOT_OFFSETS.size()));
+                targetRow = static_cast<long>(neighborRow) + offset.first;
+                targetIndex = static_cast<long>(neighborIndex) + offset.second;
+            } else {
+                const auto radius = static_cast<long>(replica.moveRadius);
+                targetRow = static_cast<long>(change.sourceRow) + static_cast<long>(random.below(2 * replica.moveRadius + 1)) - radius;
+                targetIndex = static_cast<long>(change.sourceIndex) + static_cast<long>(random.below(2 * replica.moveRadius + 1)) - radius;
             }
 
-        } while (change.sourceCell == change.targetCell);
+            if (targetRow < 0 || targetRow >= static_cast<long>(layout.rows.size()) || targetIndex < 0 || targetIndex >= static_cast<long>(layout.cols)) {
+                continue;
+            }
 
-        return change;
+            change.targetRow = static_cast<size_t>(targetRow);
+            change.targetIndex = static_cast<size_t>(targetIndex);
+            change.targetCell = layout.rows[change.targetRow].cells[change.targetIndex];
+            if (change.targetCell != change.sourceCell) {
+                return change;
+            }
+        }
     }
 
     MindMapDataS m_mindMapData;
 
     const Grid & m_grid;
 
-    struct Rect
+    struct Row
     {
-        Rect()
-          : x(0)
-          , y(0)
-          , w(0)
-          , h(0)
-        {
-        }
-
-        Rect(int x, int y, int w, int h)
-          : x(x)
-          , y(y)
-          , w(w)
-          , h(h)
-        {
-        }
-
-        int x;
-
-        int y;
+        CellVector cells;
 
-        int w;
+        int x = 0;
 
-        int h;
+        int y = 0;
     };
 
-    class Cell
+    using RowVector = std::vector<Row>;
+
+    //! Cells are indices to flat per-cell arrays and the connections are stored in CSR form,
+    //! so that copying a layout is a plain copy and the cost loops don't chase pointers.
+    struct Layout
     {
-    public:
-        void addConnection(std::shared_ptr<Cell> other)
+        size_t addCell(int cellX, int cellY)
         {
-            m_connectedCells.push_back(other);
+            x.push_back(cellX);
+            y.push_back(cellY);
+            overlapCosts.push_back(0);
+            marks.push_back(0);
+            nodes.push_back({});
+            nodeWidths.push_back(0);
+            nodeHeights.push_back(0);
+            return x.size() - 1;
         }
 
-        double calculateCost()
+        //! Empties all cells, e.g. to place the vertices again.
+        void clearPlacement()
         {
-            double overlapCost = calculateOverlapCost();
-            for (auto && dependency : m_connectedCells) {
-                overlapCost += dependency->calculateOverlapCost();
-            }
-            return overlapCost + calculateConnectionCost();
+            all.clear();
+            std::fill(nodes.begin(), nodes.end(), NodeS {});
+            std::fill(nodeWidths.begin(), nodeWidths.end(), 0);
+            std::fill(nodeHeights.begin(), nodeHeights.end(), 0);
         }
 
-        std::weak_ptr<SceneItems::Node> node() const
+        void setNode(size_t cell, NodeS node)
         {
-            return m_node;
+            nodeWidths.at(cell) = node->size().width();
+            nodeHeights.at(cell) = node->size().height();
+            nodes.at(cell) = node;
         }
 
-        void setNode(std::shared_ptr<SceneItems::Node> node)
+        //! Builds the CSR arrays. Both ends of each connection get an entry in the order the connections are given,
+        //! and the index of the connection is the index of the edge in the crossing index.
+        void setConnections(const std::vector<std::pair<size_t, size_t>> & cellPairs)
         {
-            m_node = node;
-        }
+            connectionOffsets.assign(x.size() + 1, 0);
+            for (auto && [cell0, cell1] : cellPairs) {
+                connectionOffsets.at(cell0 + 1)++;
+                connectionOffsets.at(cell1 + 1)++;
+            }
+            std::partial_sum(connectionOffsets.begin(), connectionOffsets.end(), connectionOffsets.begin());
+
+            connections.resize(connectionOffsets.back());
+            connectionEdges.resize(connectionOffsets.back());
+            CellVector insertPositions(connectionOffsets.begin(), connectionOffsets.end() - 1);
+            for (size_t edge = 0; edge < cellPairs.size(); edge++) {
+                const auto [cell0, cell1] = cellPairs.at(edge);
+                connectionEdges.at(insertPositions.at(cell0)) = edge;
+                connections.at(insertPositions.at(cell0)++) = cell1;
+                connectionEdges.at(insertPositions.at(cell1)) = edge;
+                connections.at(insertPositions.at(cell1)++) = cell0;
+            }
 
-        void popRect()
-        {
-            m_rect = m_stash;
+            if (hasCrossingCost()) {
+                crossingIndex.setEdges(cellPairs);
+            }
         }
 
-        void pushRect()
+        //! Calculates the full cost from scratch and refreshes the cached overlap costs of the cells and the crossing index.
+        //! The anchors are included, so that each edge is counted from both ends like in the move deltas.
+        double calculateCost()
         {
-            m_stash = m_rect;
+            const auto addCost = [this](auto totalCost, auto cell) {
+                overlapCosts[cell] = calculateOverlapCost(cell);
+                return totalCost + overlapCosts[cell] + calculateConnectionCost(cell);
+            };
+            double crossingCost = 0;
+            if (hasCrossingCost()) {
+                crossingIndex.rebuild(x.data(), y.data(), x.size());
+                crossingCost = crossingPenalty * static_cast<double>(crossingIndex.crossingCount(x.data(), y.data()));
+            }
+            return std::accumulate(std::begin(anchors), std::end(anchors), std::accumulate(std::begin(all), std::end(all), crossingCost, addCost), addCost);
         }
 
-        const Rect & rect() const
+        bool hasCrossingCost() const
         {
-            return m_rect;
+            return crossingPenalty > 0;
         }
 
-        void setRect(const Rect & rect)
+        //! \return Penalty of the crossings of the given edges at the current positions. The other edges must be indexed where they are.
+        double calculateCrossingCost(const std::vector<size_t> & edges)
         {
-            m_rect = rect;
+            return crossingPenalty * static_cast<double>(crossingIndex.crossingCount(x.data(), y.data(), edges));
         }
 
-        void setRectXY(int x, int y)
+        double calculateConnectionCost(size_t cell) const
         {
-            m_rect.x = x;
-            m_rect.y = y;
+            return kernel->sumDistances(x.data(), y.data(), cell, connections.data() + connectionOffsets[cell], connectionCount(cell));
         }
 
-        void moveRectXByDelta(int delta)
+        //! \return Connection cost where edges to other cells are weighted, but edges to the excluded cell are not.
+        double calculateConnectionCostExcept(size_t cell, size_t excluded, double weight) const
         {
-            m_rect.x += delta;
+            const auto excludedCount = std::count(connections.begin() + static_cast<std::ptrdiff_t>(connectionOffsets[cell]),
+                                                  connections.begin() + static_cast<std::ptrdiff_t>(connectionOffsets[cell + 1]), excluded);
+            return weight * calculateConnectionCost(cell) - (weight - 1) * static_cast<double>(excludedCount) * kernel->sumDistances(x.data(), y.data(), cell, &excluded, 1);
         }
 
-        void moveRectYByDelta(int delta)
+        //! \return Overlap cost of all pairs of connected cells as seen from the given cell.
+        double calculateOverlapCost(size_t cell) const
         {
-            m_rect.y += delta;
+            double cost = 0;
+            const auto end = connectionOffsets[cell + 1];
+            for (auto i = connectionOffsets[cell]; i < end; i++) {
+                cost += kernel->sumOverlapCosts(x.data(), y.data(), cell, connections[i], connections.data() + i + 1, end - i - 1);
+            }
+            return cost;
         }
 
-        double x() const
+        //! \return The part of calculateOverlapCost() that involves either of the given cells. Linear in the number of connections.
+        double calculateOverlapCostInvolving(size_t cell, size_t cell1, size_t cell2) const
         {
-            return m_rect.x + m_rect.w / 2;
+            double cost = 0;
+            size_t cell1Count = 0;
+            size_t cell2Count = 0;
+            const auto others = connections.data() + connectionOffsets[cell];
+            for (auto i = connectionOffsets[cell]; i < connectionOffsets[cell + 1]; i++) {
+                if (const auto moved = connections[i]; moved == cell1 || moved == cell2) {
+                    cost += kernel->sumOverlapCosts(x.data(), y.data(), cell, moved, others, connectionCount(cell));
+                    (moved == cell1 ? cell1Count : cell2Count)++;
+                }
+            }
+            // Pairs of two moved cells were counted from both sides
+            return cost - static_cast<double>(cell1Count * cell2Count) * LayoutCostKernel::overlapCost(x.data(), y.data(), cell, cell1, cell2);
         }
 
-        double y() const
+        size_t connectionCount(size_t cell) const
         {
-            return m_rect.y + m_rect.h / 2;
+            return connectionOffsets[cell + 1] - connectionOffsets[cell];
         }
 
-        static size_t globalMoveId;
-
-    private:
-        double distance(Cell & other) const
+        //! Marks the cell as visited during the given move.
+        //! \return false if the cell was already marked during the move.
+        bool mark(size_t cell, size_t markId)
         {
-            const auto dx = x() - other.x();
-            const auto dy = y() - other.y();
-            return std::sqrt(dx * dx + dy * dy);
+            if (marks[cell] == markId) {
+                return false;
+            }
+            marks[cell] = markId;
+            return true;
         }
 
-        double dot(double x1, double y1, double x2, double y2) const
+        double centerX(size_t cell) const
         {
-            return x1 * x2 + y1 * y2;
+            return x.at(cell) + cellW / 2;
         }
 
-        bool equals(double x, double y) const
+        double centerY(size_t cell) const
         {
-            return std::fabs(x - y) < 0.001;
+            return y.at(cell) + cellH / 2;
         }
 
-        double overlapCost(Cell & c1, Cell & c2) const
+        void applyCoordinates(const Grid & grid)
         {
-            const auto x1 = c1.x() - x();
-            const auto y1 = c1.y() - y();
-            const auto x2 = c2.x() - x();
-            const auto y2 = c2.y() - y();
-            if (equals(x1 * y2, x2 * y1) && dot(x1, y1, x2, y2) > 0) {
-                const auto l1 = x1 * x1 + y1 * y1;
-                const auto l2 = x2 * x2 + y2 * y2;
-                return l1 < l2 ? 2 * std::sqrt(l1) : 2 * std::sqrt(l2);
+            if (all.empty()) {
+                return;
             }
 
-            return 0;
-        }
-
-        double calculateConnectionCost() const
-        {
-            return std::accumulate(std::begin(m_connectedCells), std::end(m_connectedCells), double {},
-                                   [this](auto totalCost, auto && cell) {
-                                       return totalCost + distance(*cell);
-                                   });
-        }
+            const auto maxWidthIt = std::max_element(all.begin(), all.end(), [this](auto lhs, auto rhs) {
+                return x.at(lhs) < x.at(rhs);
+            });
+            const double maxWidth = x.at(*maxWidthIt) + cellW;
 
-        double calculateOverlapCost()
-        {
-            if (m_moveId == Cell::globalMoveId) {
-                return 0;
-            }
+            const auto maxHeightIt = std::max_element(all.begin(), all.end(), [this](auto lhs, auto rhs) {
+                return y.at(lhs) < y.at(rhs);
+            });
+            const double maxHeight = y.at(*maxHeightIt) + cellH;
 
-            m_moveId = Cell::globalMoveId;
+            std::vector<QPointF> locations(all.size());
+            forEachChunk(all.size(), 1, [&](size_t begin, size_t end) {
+                for (auto i = begin; i < end; i++) {
+                    const auto cell = all[i];
+                    locations[i] = grid.snapToGrid({ center.x() + x[cell] - maxWidth / 2, center.y() + y[cell] - maxHeight / 2 });
+                }
+            });
 
-            double cost = 0;
-            for (size_t i = 0; i < m_connectedCells.size(); i++) {
-                const auto outer = m_connectedCells.at(i);
-                for (size_t j = i + 1; j < m_connectedCells.size(); j++) {
-                    const auto inner = m_connectedCells.at(j);
-                    if (outer != inner) {
-                        cost += overlapCost(*outer, *inner);
-                    }
+            // Items can only be touched from the GUI thread. Edges between moved nodes get updated only once.
+            const SceneItems::EdgeUpdateBatch edgeUpdateBatch;
+            for (size_t i = 0; i < all.size(); i++) {
+                if (auto && node = nodes[all[i]]; node->location() != locations[i]) {
+                    node->setLocation(locations[i]);
                 }
             }
-
-            return cost;
         }
 
-        std::weak_ptr<SceneItems::Node> m_node;
-
-        CellVector m_connectedCells;
-
-        Rect m_stash;
-
-        Rect m_rect;
+        //! Min and max of the node edges along one axis in a column or a row. Empty if it has no nodes.
+        struct Extent
+        {
+            void add(double minValue, double maxValue)
+            {
+                min = std::min(min, minValue);
+                max = std::max(max, maxValue);
+            }
 
-        size_t m_moveId = 0;
-    };
+            void add(const Extent & other)
+            {
+                add(other.min, other.max);
+            }
 
-    struct Row
-    {
-        CellVector cells;
+            bool isEmpty() const
+            {
+                return min > max;
+            }
 
-        Rect rect;
-    };
+            double min = std::numeric_limits<double>::max();
 
-    using RowVector = std::vector<std::shared_ptr<Row>>;
+            double max = std::numeric_limits<double>::lowest();
+        };
 
-    struct Layout
-    {
-        void applyCoordinates(const Grid & grid)
+        //! Calculates the horizontal extents of the columns and the vertical extents of the rows in one pass over the cells.
+        //! Each thread handles a range of rows and the column extents of the ranges are merged afterwards.
+        void calculateExtents(std::vector<Extent> & colExtents, std::vector<Extent> & rowExtents) const
         {
-            if (all.empty()) {
-                return;
-            }
-
-            const auto maxWidthIt = std::max_element(all.begin(), all.end(), [](const auto & lhs, const auto & rhs) {
-                return lhs->rect().x + lhs->rect().w < rhs->rect().x + rhs->rect().w;
-            });
-            const double maxWidth = (*maxWidthIt)->rect().x + (*maxWidthIt)->rect().w;
-
-            const auto maxHeightIt = std::max_element(all.begin(), all.end(), [](const auto & lhs, const auto & rhs) {
-                return lhs->rect().y + lhs->rect().h < rhs->rect().y + rhs->rect().h;
+            const auto chunkCount = chunkCountFor(rows.size() * cols);
+            const auto chunkSize = (rows.size() + chunkCount - 1) / chunkCount;
+            std::vector<std::vector<Extent>> partialColExtents(chunkCount, std::vector<Extent>(cols));
+            rowExtents.assign(rows.size(), {});
+            forEachChunk(rows.size(), cols, [&](size_t begin, size_t end) {
+                auto && chunkColExtents = partialColExtents.at(begin / chunkSize);
+                for (auto j = begin; j < end; j++) {
+                    auto && cells = rows[j].cells;
+                    for (size_t i = 0; i < cells.size(); i++) {
+                        if (const auto cell = cells[i]; nodes[cell]) {
+                            chunkColExtents[i].add(centerX(cell) - nodeWidths[cell] / 2, centerX(cell) + nodeWidths[cell] / 2);
+                            rowExtents[j].add(centerY(cell) - nodeHeights[cell] / 2, centerY(cell) + nodeHeights[cell] / 2);
+                        }
+                    }
+                }
             });
-            const double maxHeight = (*maxHeightIt)->rect().y + (*maxHeightIt)->rect().h;
 
-            for (auto && cell : all) {
-                if (cell) {
-                    cell->node().lock()->setLocation(grid.snapToGrid({ cell->rect().x - maxWidth / 2, cell->rect().y - maxHeight / 2 }));
+            colExtents.assign(cols, {});
+            for (auto && chunkColExtents : partialColExtents) {
+                for (size_t i = 0; i < cols; i++) {
+                    colExtents[i].add(chunkColExtents[i]);
                 }
             }
         }
 
-        double getMaxColX(size_t colIndex)
+        //! \returns The shift of each column or row so that it's at least minEdgeLength apart from the previous one.
+        //! Because a shift moves the whole extent, the shifts are accumulated from the original extents.
+        std::vector<double> calculateShifts(const std::vector<Extent> & extents) const
         {
-            double maxX = 0;
-            for (auto && row : rows) {
-                if (const auto cell = row->cells.at(colIndex); cell && cell->node().lock()) {
-                    maxX = std::max(maxX, cell->x() + cell->node().lock()->size().width() / 2);
+            std::vector<double> shifts(extents.size(), 0);
+            for (size_t i = 1; i < extents.size(); i++) {
+                // The end of an empty column or row is at zero
+                const auto previous = extents[i - 1];
+                const auto prevMax = (previous.isEmpty() ? 0 : std::max(0.0, previous.max + shifts[i - 1])) + minEdgeLength;
+                if (!extents[i].isEmpty() && extents[i].min < prevMax) {
+                    shifts[i] = static_cast<int>(prevMax - extents[i].min);
                 }
             }
-            return maxX;
+            return shifts;
         }
 
-        std::optional<double> getMinColX(size_t colIndex)
+        //! Pushes overlapping columns and rows apart. Linear in the number of cells.
+        void spread()
         {
-            std::optional<double> minX;
-            for (auto && row : rows) {
-                if (const auto cell = row->cells.at(colIndex); cell && cell->node().lock()) {
-                    minX = std::min(minX.value_or(std::numeric_limits<double>::max()), cell->x() - cell->node().lock()->size().width() / 2);
+            std::vector<Extent> colExtents;
+            std::vector<Extent> rowExtents;
+            calculateExtents(colExtents, rowExtents);
+
+            const auto colShifts = calculateShifts(colExtents);
+            const auto rowShifts = calculateShifts(rowExtents);
+            forEachChunk(rows.size(), cols, [&](size_t begin, size_t end) {
+                for (auto j = begin; j < end; j++) {
+                    auto && cells = rows[j].cells;
+                    for (size_t i = 0; i < cells.size(); i++) {
+                        x[cells[i]] += colShifts[i];
+                        y[cells[i]] += rowShifts[j];
+                    }
                 }
-            }
-            return minX;
+            });
         }
 
-        double getMaxRowY(size_t rowIndex)
+        //! \returns The number of threads for the given number of cells.
+        static size_t chunkCountFor(size_t cellCount)
         {
-            double maxY = 0;
-            for (auto && cell : rows.at(rowIndex)->cells) {
-                if (cell && cell->node().lock()) {
-                    maxY = std::max(maxY, cell->y() + cell->node().lock()->size().height() / 2);
-                }
-            }
-            return maxY;
+            return SC::instance().taskPool()->chunkCount(cellCount, MIN_CELLS_PER_THREAD);
         }
 
-        std::optional<double> getMinRowY(size_t rowIndex)
+        //! Calls the function for ranges of [0, count) on several threads if there are enough cells.
+        template<typename Function>
+        static void forEachChunk(size_t count, size_t cellsPerItem, Function function)
         {
-            std::optional<double> minY;
-            for (auto && cell : rows.at(rowIndex)->cells) {
-                if (cell && cell->node().lock()) {
-                    minY = std::min(minY.value_or(std::numeric_limits<double>::max()), cell->y() - cell->node().lock()->size().height() / 2);
-                }
+            if (!count) {
+                return;
             }
-            return minY;
-        }
 
-        void spread()
-        {
-            for (size_t i = 1; i < cols; i++) {
-                const auto prevMaxX = getMaxColX(i - 1) + minEdgeLength;
-                const auto minX = getMinColX(i);
-                if (minX.has_value() && *minX < prevMaxX) {
-                    for (auto && row : rows) {
-                        if (const auto cell = row->cells.at(i); cell) {
-                            cell->moveRectXByDelta(static_cast<int>(prevMaxX - *minX));
-                        }
-                    }
+            const auto chunkCount = chunkCountFor(count * cellsPerItem);
+            const auto chunkSize = (count + chunkCount - 1) / chunkCount;
+            SC::instance().taskPool()->run(chunkCount, [&](size_t chunk) {
+                if (const auto begin = chunk * chunkSize; begin < count) {
+                    function(begin, std::min(begin + chunkSize, count));
                 }
-            }
+            });
+        }
 
-            for (size_t j = 1; j < rows.size(); j++) {
-                const auto prevMaxY = getMaxRowY(j - 1) + minEdgeLength;
-                const auto minY = getMinRowY(j);
-                if (minY.has_value() && *minY < prevMaxY) {
-                    for (auto && cell : rows.at(j)->cells) {
-                        if (cell) {
-                            cell->moveRectYByDelta(static_cast<int>(prevMaxY - *minY));
-                        }
-                    }
-                }
-            }
+        //! \return Row and index of the slot nearest to the position of the cell. Only anchors can be outside of the grid.
+        std::pair<size_t, size_t> nearestSlot(size_t cell) const
+        {
+            const auto row = std::clamp<long>(std::lround(y[cell] / slotHeight), 0, static_cast<long>(rows.size()) - 1);
+            const auto index = std::clamp<long>(std::lround(x[cell] / slotWidth), 0, static_cast<long>(cols) - 1);
+            return { static_cast<size_t>(row), static_cast<size_t>(index) };
         }
 
         double minEdgeLength = 0;
 
-        CellVector all;
+        CellVector all; // Cells that have a node
+
+        CellVector anchors; // Fixed cells of the nodes connected to a subgraph
+
+        QPointF center; // Scene position of the center of the layout
 
         RowVector rows;
 
         size_t cols = 0;
+
+        size_t moveId = 0;
+
+        int cellW = 0;
+
+        int cellH = 0;
+
+        // Distances between the positions of neighboring slots in a row and in a column
+        int slotWidth = 1;
+
+        int slotHeight = 1;
+
+        // Positions of the top-left corners of the cells
+        std::vector<double> x;
+
+        std::vector<double> y;
+
+        std::vector<double> overlapCosts;
+
+        std::vector<size_t> marks;
+
+        CellVector connectionOffsets;
+
+        CellVector connections;
+
+        CellVector connectionEdges; // Index of the edge of each connection
+
+        // Cost of each edge crossing, zero if crossings are not penalized
+        double crossingPenalty = 0;
+
+        EdgeCrossingIndex crossingIndex;
+
+        // Only used when extracting the final layout
+        std::vector<NodeS> nodes;
+
+        std::vector<double> nodeWidths;
+
+        std::vector<double> nodeHeights;
+
+        const LayoutCostKernel::Kernel * kernel = &LayoutCostKernel::bestKernel();
+
     };
 
     std::unique_ptr<Layout> m_layout;
 
-    std::map<int, std::shared_ptr<Cell>> m_nodesToCells; // Used when building connections
+    std::map<int, size_t> m_nodesToCells; // Used when building connections
+
+    std::map<int, size_t> m_anchorsToCells;
+
+    std::vector<int> m_subgraph; // Indices of the selected nodes, empty for the whole graph
+
+    size_t m_hopCount = 0;
+
+    bool m_warmStart = false;
+
+    InitialPlacement m_initialPlacement = InitialPlacement::Current;
+
+    //! The annealing starts from the placement of placeByLocality(), which is already good.
+    bool m_isLocalityPlaced = false;
+
+    std::chrono::milliseconds m_timeBudget { 0 };
+
+    std::chrono::steady_clock::time_point m_deadline;
+
+    size_t m_replicaCount = 1;
+
+    uint32_t m_seed = std::mt19937::default_seed;
+
+    size_t m_multilevelThreshold = 0;
+
+    std::vector<Level> m_levels;
+
+    Graph::NodeVector m_nodes; // Nodes of the vertices of level 0 or of the force-directed layout
+
+    Engine m_engine = Engine::Annealing;
+
+    Schedule m_schedule = Schedule::Geometric;
+
+    double m_crossingPenalty = 0;
+
+    bool m_useLayoutCache = false;
+
+    std::optional<LayoutCache::Layout> m_cachedLayout; // Set if the layout was found in the cache
+
+    std::optional<LayoutCache::Entry> m_cacheEntry; // Set if the optimized layout is to be cached
+
+    std::unique_ptr<ForceDirectedLayout> m_forceDirectedLayout;
+
+    std::unique_ptr<TreeLayout> m_treeLayout;
+
+    struct Component
+    {
+        Graph::NodeVector nodes;
+
+        std::unique_ptr<Impl> optimizer;
+    };
+
+    std::vector<Component> m_components; // Empty unless the graph has several connected components
+
+    Graph::NodeVector m_componentNodes; // Nodes of the component of a child optimizer, empty otherwise
+
+    size_t m_componentNodeCount = 0;
+
+    QPointF m_componentsCenter;
+
+    std::mutex m_componentProgressMutex;
+
+    std::vector<double> m_componentProgress;
 
-    std::mt19937 m_engine;
+    double m_aspectRatio = 1;
 
-    // Will be initialized once we now the row count after building the initial layout
-    std::uniform_int_distribution<size_t> m_rowDist;
+    double m_minEdgeLength = 0;
 
-    std::uniform_int_distribution<size_t> m_oneOrTwoDist { 0, 1 };
+    double m_progressOffset = 0;
 
-    std::uniform_real_distribution<double> m_saDist { 0, 1 };
+    double m_progressScale = 1;
 
     ProgressCallback m_progressCallback = nullptr;
-};
 
-size_t LayoutOptimizer::Impl::Cell::globalMoveId = 0;
+    std::atomic<bool> m_cancelled { false };
+
+    PreviewCallback m_previewCallback = nullptr;
+
+    TraceCallback m_traceCallback = nullptr;
+
+    std::chrono::steady_clock::time_point m_startTime;
+
+    TraceBuffer m_trace { Constants::LayoutOptimizer::traceSize() };
+
+    std::chrono::milliseconds m_previewInterval { 0 };
+
+    std::chrono::steady_clock::time_point m_lastPreviewTime;
+
+    std::mutex m_previewMutex;
+
+    std::unique_ptr<Layout> m_preview;
+
+    std::optional<std::vector<QPointF>> m_forceDirectedPreview;
+};
 
 LayoutOptimizer::LayoutOptimizer(MindMapDataS mindMapData, const Grid & grid)
   : m_impl(std::make_unique<Impl>(mindMapData, grid))
@@ -715,9 +2615,84 @@ void LayoutOptimizer::extract()
     m_impl->extract();
 }
 
+void LayoutOptimizer::setEngine(Engine engine)
+{
+    m_impl->setEngine(engine);
+}
+
+void LayoutOptimizer::setSchedule(Schedule schedule)
+{
+    m_impl->setSchedule(schedule);
+}
+
+void LayoutOptimizer::setCrossingPenalty(double crossingPenalty)
+{
+    m_impl->setCrossingPenalty(crossingPenalty);
+}
+
+void LayoutOptimizer::setUseLayoutCache(bool useLayoutCache)
+{
+    m_impl->setUseLayoutCache(useLayoutCache);
+}
+
+void LayoutOptimizer::setReplicaCount(size_t replicaCount)
+{
+    m_impl->setReplicaCount(replicaCount);
+}
+
+void LayoutOptimizer::setSeed(uint32_t seed)
+{
+    m_impl->setSeed(seed);
+}
+
+void LayoutOptimizer::setMultilevelThreshold(size_t nodeCount)
+{
+    m_impl->setMultilevelThreshold(nodeCount);
+}
+
+void LayoutOptimizer::setSubgraph(const std::vector<int> & nodeIndices, size_t hopCount)
+{
+    m_impl->setSubgraph(nodeIndices, hopCount);
+}
+
+void LayoutOptimizer::setInitialPlacement(InitialPlacement initialPlacement)
+{
+    m_impl->setInitialPlacement(initialPlacement);
+}
+
+void LayoutOptimizer::setWarmStart(bool warmStart)
+{
+    m_impl->setWarmStart(warmStart);
+}
+
+void LayoutOptimizer::setTimeBudget(std::chrono::milliseconds timeBudget)
+{
+    m_impl->setTimeBudget(timeBudget);
+}
+
+void LayoutOptimizer::cancel()
+{
+    m_impl->cancel();
+}
+
+bool LayoutOptimizer::extractPreview()
+{
+    return m_impl->extractPreview();
+}
+
 void LayoutOptimizer::setProgressCallback(ProgressCallback progressCallback)
 {
     m_impl->setProgressCallback(progressCallback);
 }
 
+void LayoutOptimizer::setTraceCallback(TraceCallback traceCallback)
+{
+    m_impl->setTraceCallback(traceCallback);
+}
+
+void LayoutOptimizer::setPreviewCallback(PreviewCallback previewCallback, std::chrono::milliseconds interval)
+{
+    m_impl->setPreviewCallback(previewCallback, interval);
+}
+
 LayoutOptimizer::~LayoutOptimizer() = default;
@@ -16,8 +16,11 @@
 #ifndef LAYOUT_OPTIMIZER_HPP
 #define LAYOUT_OPTIMIZER_HPP
 
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "../common/types.hpp"
 
@@ -32,6 +35,25 @@ public:
 
     bool initialize(double aspectRatio, double minEdgeLength);
 
+    //! State of the annealing after a slice of moves, see OptimizationInfo::trace.
+    struct TraceSample
+    {
+        //! Seconds from the start of optimize().
+        double time = 0;
+
+        double temperature = 0;
+
+        double cost = 0;
+
+        //! Share of the moves of the slice that were accepted.
+        double acceptRatio = 0;
+
+        double movesPerSecond = 0;
+
+        //! Seconds.
+        double sliceDuration = 0;
+    };
+
     struct OptimizationInfo
     {
         double acceptRatio = 0;
@@ -61,15 +83,130 @@ public:
         size_t stuckLimit = 5;
 
         double stuckTh = 0.1;
+
+        size_t replicas = 1;
+
+        size_t swaps = 0;
+
+        size_t levels = 1;
+
+        bool cancelled = false;
+
+        //! The time budget ran out before the layout converged.
+        bool outOfTime = false;
+
+        //! The mind map was optimized before with the same structure and parameters, and extract() applies that layout.
+        bool cached = false;
+
+        //! The convergence of the annealing, one sample per slice and oldest first. Only the latest
+        //! Constants::LayoutOptimizer::traceSize() samples are kept. Multilevel runs trace all levels one after another
+        //! and several components trace the largest one. The other engines don't record a trace.
+        std::vector<TraceSample> trace;
     };
 
     OptimizationInfo optimize();
 
+    enum class Engine
+    {
+        //! Simulated annealing of the nodes on a grid of cells.
+        Annealing,
+        //! Force-directed placement. Converges faster for organic maps, but the costs are not comparable with the annealer.
+        ForceDirected,
+        //! Tidy tree with the root in the middle and the branches on its left and right. Instant, but edges that
+        //! don't fit a tree are ignored.
+        TidyTree,
+        //! Tidy tree with the branches on rings around the root.
+        RadialTree
+    };
+
+    //! Must be set before initialize().
+    void setEngine(Engine engine);
+
+    enum class Schedule
+    {
+        //! The temperature is lowered by a constant factor once the cost doesn't improve anymore.
+        Geometric,
+        //! Modified Lam: the temperature is adjusted after every move so that the acceptance rate follows a target
+        //! curve over a fixed number of moves per cell. Needs no tuning of the cooling factor or of the slice size.
+        ModifiedLam
+    };
+
+    //! Sets the cooling schedule of a single annealing chain. Parallel tempering cools its ladder geometrically.
+    void setSchedule(Schedule schedule);
+
+    //! Adds the given cost per edge crossing to the annealed cost, in the same units as the edge lengths. The crossings of
+    //! the edges of the moved cells are counted with a grid of buckets over the edges, so the cost of a move doesn't grow
+    //! with the edge count. The default 0 ignores crossings. The other engines ignore the penalty. Must be set before initialize().
+    void setCrossingPenalty(double crossingPenalty);
+
+    //! Re-applies the layout of an earlier optimization of the whole mind map if its structure, node sizes and parameters
+    //! haven't changed, and stores complete optimizations for that in the layout cache of the mind map by extract().
+    //! Warm starts and subgraphs depend on the current layout and are never cached. Must be set before initialize().
+    void setUseLayoutCache(bool useLayoutCache);
+
+    //! Sets the number of replicas annealed in parallel at different temperatures (parallel tempering).
+    //! The default 1 runs a single simulated annealing chain. The force-directed engine uses as many threads.
+    void setReplicaCount(size_t replicaCount);
+
+    //! Seeds the random number generators so that runs can be reproduced. Replica i is seeded with seed + i.
+    void setSeed(uint32_t seed);
+
+    //! Enables the multilevel mode for graphs of at least the given number of nodes: the graph is coarsened by collapsing
+    //! leaves and matching neighbors, the coarsest graph is optimized and the result is projected back and refined level by level.
+    //! The default 0 disables the mode. Must be set before initialize().
+    void setMultilevelThreshold(size_t nodeCount);
+
+    //! Restricts the optimization to the given nodes and the nodes within hopCount edges from them. The other nodes
+    //! connected to the subgraph stay where they are and pull the subgraph towards them, so the runtime depends on the
+    //! size of the subgraph only. An empty list optimizes the whole graph (the default). Must be set before initialize().
+    void setSubgraph(const std::vector<int> & nodeIndices, size_t hopCount);
+
+    enum class InitialPlacement
+    {
+        //! The nodes start in the cells nearest to their current locations.
+        Current,
+        //! The nodes are ordered breadth-first over the edges and laid in that order along a Hilbert curve over the
+        //! cells, so that connected nodes start near each other even if they are far apart or piled up now. The
+        //! annealing then starts from a temperature estimated like for a warm start, which needs far fewer moves.
+        //! If the current locations are cheaper yet, they are kept.
+        Locality
+    };
+
+    //! Sets how the nodes are placed before the annealing. The default is InitialPlacement::Current. Warm starts and
+    //! subgraphs keep the current layout. Multilevel runs place the coarsest level. Must be set before initialize().
+    void setInitialPlacement(InitialPlacement initialPlacement);
+
+    //! Starts from the current layout instead of scrambling it: the annealing starts from a low temperature estimated
+    //! from the cost changes of sampled moves, so re-running after small edits is fast. Must be set before initialize().
+    void setWarmStart(bool warmStart);
+
+    //! Limits the wall-clock time of optimize(): the cooling is sped up so that the remaining temperature steps fit into
+    //! the remaining time, and the best layout found so far is kept if the time runs out. The default 0 means no limit.
+    void setTimeBudget(std::chrono::milliseconds timeBudget);
+
     void extract();
 
+    //! Stops a running optimize() after the current slice. The layout found so far can be extracted as usual.
+    //! Thread-safe. The request is cleared by initialize().
+    void cancel();
+
+    //! Applies the latest intermediate layout published while optimizing.
+    //! Call from the thread that owns the nodes, e.g. when the preview callback has notified about a new layout.
+    //! \return false if there was no new layout.
+    bool extractPreview();
+
+    //! Called on the optimizing thread.
     using ProgressCallback = std::function<void(double)>;
     void setProgressCallback(ProgressCallback progressCallback);
 
+    //! Called on the optimizing thread when a new intermediate layout is available, at most once per interval.
+    using PreviewCallback = std::function<void()>;
+    void setPreviewCallback(PreviewCallback previewCallback, std::chrono::milliseconds interval);
+
+    //! Called on the optimizing thread after each slice of annealing moves, e.g. to plot the convergence live.
+    using TraceCallback = std::function<void(const TraceSample &)>;
+    void setTraceCallback(TraceCallback traceCallback);
+
 private:
     class Impl;
     std::unique_ptr<Impl> m_impl;
@@ -17,12 +17,28 @@
 
 #include "../application/service_container.hpp"
 #include "../application/settings_proxy.hpp"
+#include "../application/task_pool.hpp"
+#include "../common/test_mode.hpp"
 #include "../domain/graph.hpp"
+#include "../domain/graph_snapshot.hpp"
 #include "../domain/image_manager.hpp"
+#include "../domain/layout_cache.hpp"
 #include "../view/grid.hpp"
+#include "../view/scene_items/edge_update_batch.hpp"
 #include "../view/scene_items/node.hpp"
+#include "../view/scene_items/text_size_cache.hpp"
 #include "../view/shadow_effect_params.hpp"
 
+#include <QDataStream>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+// Below this the threads would cost more than the transform itself
+const size_t minNodesPerThread = 10000;
+} // namespace
+
 struct MindMapData::Style
 {
     Style(const SettingsProxy & settingsProxy)
@@ -51,13 +67,20 @@ struct MindMapData::Style
     int textSize;
 
     int cornerRadius = Constants::Node::defaultCornerRadius();
+
+    bool operator==(const Style & other) const
+    {
+        return arrowSize == other.arrowSize && backgroundColor == other.backgroundColor && edgeColor == other.edgeColor && edgeWidth == other.edgeWidth //
+          && font == other.font && gridColor == other.gridColor && textSize == other.textSize && cornerRadius == other.cornerRadius;
+    }
 };
 
 MindMapData::MindMapData(QString name)
   : MindMapDataBase(name)
-  , m_style(std::make_unique<Style>(*SC::instance().settingsProxy()))
+  , m_style(std::make_shared<Style>(*SC::instance().settingsProxy()))
   , m_graph(std::make_unique<Graph>())
   , m_imageManager(std::make_unique<ImageManager>())
+  , m_layoutCache(std::make_shared<LayoutCache>(Constants::LayoutOptimizer::layoutCacheSize()))
 {
 }
 
@@ -65,26 +88,61 @@ MindMapData::MindMapData(const MindMapData & other)
   : MindMapDataBase(other)
   , m_fileName(other.m_fileName)
   , m_applicationVersion(other.m_applicationVersion)
-  , m_style(std::make_unique<Style>(*other.m_style))
+  , m_alzFormatVersion(other.m_alzFormatVersion)
+  , m_style(other.m_style)
   , m_graph(std::make_unique<Graph>())
+  , m_graphSnapshot(std::make_unique<GraphSnapshot>(other.graphSnapshot()))
   , m_imageManager(std::make_unique<ImageManager>(*other.m_imageManager))
+  , m_layoutCache(other.m_layoutCache)
   , m_layoutOptimizerParameters(other.m_layoutOptimizerParameters)
 {
-    copyGraph(other);
 }
 
-void MindMapData::copyGraph(const MindMapData & other)
+MindMapData::MindMapData(const MindMapData & other, GraphSnapshot graphSnapshot)
+  : MindMapDataBase(other)
+  , m_fileName(other.m_fileName)
+  , m_applicationVersion(other.m_applicationVersion)
+  , m_alzFormatVersion(other.m_alzFormatVersion)
+  , m_style(other.m_style)
+  , m_graph(std::make_unique<Graph>())
+  , m_graphSnapshot(std::make_unique<GraphSnapshot>(std::move(graphSnapshot)))
+  , m_imageManager(std::make_unique<ImageManager>(*other.m_imageManager))
+  , m_layoutCache(other.m_layoutCache)
+  , m_layoutOptimizerParameters(other.m_layoutOptimizerParameters)
 {
-    m_graph->clear();
+}
 
-    // Use copy constructor for nodes
-    for (auto && node : other.m_graph->getNodes()) {
-        m_graph->addNode(std::make_unique<SceneItems::Node>(*node));
+MindMapData::Style & MindMapData::mutableStyle()
+{
+    // Style is shared copy-on-write between copies, e.g. undo points
+    if (m_style.use_count() > 1) {
+        m_style = std::make_shared<Style>(*m_style);
     }
+    return *m_style;
+}
+
+void MindMapData::notifyStyleChange()
+{
+    m_graph->changeNotifier().notify({ GraphChange::Type::StyleChanged });
+}
 
-    // Use copy constructor for edges
-    for (auto && otherEdge : other.m_graph->getEdges()) {
-        m_graph->addEdge(std::make_unique<SceneItems::Edge>(*otherEdge, *m_graph));
+void MindMapData::restoreGraphSnapshot() const
+{
+    if (m_graphSnapshot) {
+        const auto snapshot = std::move(m_graphSnapshot);
+
+        // The scene items can only be created on the GUI thread, but their text layouts are the
+        // expensive part, so the texts are laid out beforehand on several threads
+        std::vector<QString> texts;
+        texts.reserve(snapshot->nodes().size());
+        for (auto && model : snapshot->nodes()) {
+            texts.push_back(model.text);
+        }
+        measureTexts(texts, m_style->font, m_style->textSize);
+
+        snapshot->restore(*m_graph, [this](const SceneItems::NodeModel & model) {
+            return std::make_shared<SceneItems::Node>(model, m_style->font, m_style->textSize, m_style->cornerRadius);
+        });
     }
 }
 
@@ -110,9 +168,9 @@ void MindMapData::setApplicationVersion(const QString & version)
 
 void MindMapData::applyGrid(const Grid & grid)
 {
-    for (auto && node : m_graph->getNodes()) {
-        node->setLocation(grid.snapToGrid(node->location()));
-    }
+    transformNodeLocations([&grid](QPointF location) {
+        return grid.snapToGrid(location);
+    });
 }
 
 double MindMapData::aspectRatio() const
@@ -132,7 +190,8 @@ QColor MindMapData::backgroundColor() const
 
 void MindMapData::setBackgroundColor(const QColor & backgroundColor)
 {
-    m_style->backgroundColor = backgroundColor;
+    mutableStyle().backgroundColor = backgroundColor;
+    notifyStyleChange();
 }
 
 int MindMapData::cornerRadius() const
@@ -142,11 +201,14 @@ int MindMapData::cornerRadius() const
 
 void MindMapData::setCornerRadius(int cornerRadius)
 {
-    m_style->cornerRadius = cornerRadius;
+    mutableStyle().cornerRadius = cornerRadius;
 
-    for (auto && node : m_graph->getNodes()) {
+    const SceneItems::EdgeUpdateBatch edgeUpdateBatch;
+    for (auto && node : graph().nodes()) {
         node->setCornerRadius(cornerRadius);
     }
+
+    notifyStyleChange();
 }
 
 QColor MindMapData::edgeColor() const
@@ -156,11 +218,13 @@ QColor MindMapData::edgeColor() const
 
 void MindMapData::setEdgeColor(const QColor & edgeColor)
 {
-    m_style->edgeColor = edgeColor;
+    mutableStyle().edgeColor = edgeColor;
 
-    for (auto && edge : m_graph->getEdges()) {
+    for (auto && edge : graph().edges()) {
         edge->setColor(edgeColor);
     }
+
+    notifyStyleChange();
 }
 
 QColor MindMapData::gridColor() const
@@ -170,7 +234,8 @@ QColor MindMapData::gridColor() const
 
 void MindMapData::setGridColor(const QColor & gridColor)
 {
-    m_style->gridColor = gridColor;
+    mutableStyle().gridColor = gridColor;
+    notifyStyleChange();
 }
 
 double MindMapData::arrowSize() const
@@ -180,11 +245,13 @@ double MindMapData::arrowSize() const
 
 void MindMapData::setArrowSize(double arrowSize)
 {
-    m_style->arrowSize = arrowSize;
+    mutableStyle().arrowSize = arrowSize;
 
-    for (auto && edge : m_graph->getEdges()) {
+    for (auto && edge : graph().edges()) {
         edge->setArrowSize(arrowSize);
     }
+
+    notifyStyleChange();
 }
 
 double MindMapData::edgeWidth() const
@@ -194,11 +261,13 @@ double MindMapData::edgeWidth() const
 
 void MindMapData::setEdgeWidth(double edgeWidth)
 {
-    m_style->edgeWidth = edgeWidth;
+    mutableStyle().edgeWidth = edgeWidth;
 
-    for (auto && edge : m_graph->getEdges()) {
+    for (auto && edge : graph().edges()) {
         edge->setEdgeWidth(edgeWidth);
     }
+
+    notifyStyleChange();
 }
 
 QString MindMapData::fileName() const
@@ -213,14 +282,87 @@ void MindMapData::setFileName(QString newFileName)
 
 GraphR MindMapData::graph()
 {
+    restoreGraphSnapshot();
     return *m_graph;
 }
 
 GraphCR MindMapData::graph() const
 {
+    restoreGraphSnapshot();
     return *m_graph;
 }
 
+GraphSnapshot MindMapData::graphSnapshot() const
+{
+    return m_graphSnapshot ? *m_graphSnapshot : GraphSnapshot { *m_graph };
+}
+
+void MindMapData::setGraphSnapshot(GraphSnapshot graphSnapshot)
+{
+    m_graph = std::make_unique<Graph>();
+    m_graphSnapshot = std::make_unique<GraphSnapshot>(std::move(graphSnapshot));
+}
+
+std::pair<std::unique_ptr<Graph>, std::unique_ptr<GraphSnapshot>> MindMapData::releaseGraph()
+{
+    auto graph = std::exchange(m_graph, std::make_unique<Graph>());
+    return { std::move(graph), std::move(m_graphSnapshot) };
+}
+
+bool MindMapData::sharesStyleWith(const MindMapData & other) const
+{
+    // Data read e.g. from a file has a style of its own, which may still be equal
+    return m_style == other.m_style || *m_style == *other.m_style;
+}
+
+QByteArray MindMapData::styleData() const
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out << arrowSize() << aspectRatio() << backgroundColor() << cornerRadius() << edgeColor() << edgeWidth() //
+        << font() << gridColor() << minEdgeLength() << textSize();
+    return data;
+}
+
+void MindMapData::applyStyleData(const QByteArray & data)
+{
+    QDataStream in(data);
+    double arrowSize = 0;
+    double aspectRatio = 0;
+    QColor backgroundColor;
+    int cornerRadius = 0;
+    QColor edgeColor;
+    double edgeWidth = 0;
+    QFont font;
+    QColor gridColor;
+    double minEdgeLength = 0;
+    int textSize = 0;
+    in >> arrowSize >> aspectRatio >> backgroundColor >> cornerRadius >> edgeColor >> edgeWidth >> font >> gridColor >> minEdgeLength >> textSize;
+    if (in.status() != QDataStream::Ok) {
+        return;
+    }
+
+    setArrowSize(arrowSize);
+    setAspectRatio(aspectRatio);
+    setBackgroundColor(backgroundColor);
+    setCornerRadius(cornerRadius);
+    setEdgeColor(edgeColor);
+    setEdgeWidth(edgeWidth);
+    changeFont(font);
+    setGridColor(gridColor);
+    setMinEdgeLength(minEdgeLength);
+    setTextSize(textSize);
+}
+
+void MindMapData::takeAttributesFrom(const MindMapData & other)
+{
+    m_fileName = other.m_fileName;
+    m_applicationVersion = other.m_applicationVersion;
+    m_alzFormatVersion = other.m_alzFormatVersion;
+    *m_imageManager = *other.m_imageManager;
+    m_layoutOptimizerParameters = other.m_layoutOptimizerParameters;
+}
+
 ImageManager & MindMapData::imageManager()
 {
     return *m_imageManager;
@@ -231,6 +373,11 @@ const ImageManager & MindMapData::imageManager() const
     return *m_imageManager;
 }
 
+LayoutCache & MindMapData::layoutCache() const
+{
+    return *m_layoutCache;
+}
+
 double MindMapData::minEdgeLength() const
 {
     return m_layoutOptimizerParameters.minEdgeLength;
@@ -243,26 +390,48 @@ void MindMapData::setMinEdgeLength(double minEdgeLength)
 
 void MindMapData::mirror(bool vertically)
 {
-    if (!m_graph->getNodes().size()) {
+    if (!graph().nodeCount()) {
         return;
     }
 
-    const auto firstNode = m_graph->getNodes().at(0);
+    const auto & firstNode = *graph().nodes().begin();
     QRectF rect = firstNode->placementBoundingRect().translated(firstNode->location());
-    for (auto && node : m_graph->getNodes()) {
-        const auto pbr = node->placementBoundingRect().translated(node->location());
-        rect = rect.united(pbr);
+    for (auto && node : graph().nodes()) {
+        rect = rect.united(node->placementBoundingRect().translated(node->location()));
     }
 
+    const auto center = rect.center();
     if (vertically) {
-        for (auto && node : m_graph->getNodes()) {
-            const auto centerY = (rect.y() + rect.height() / 2);
-            node->setLocation({ node->location().x(), centerY * 2 - node->location().y() });
-        }
+        transformNodeLocations([center](QPointF location) {
+            return QPointF { location.x(), center.y() * 2 - location.y() };
+        });
     } else {
-        for (auto && node : m_graph->getNodes()) {
-            const auto centerX = (rect.x() + rect.width() / 2);
-            node->setLocation({ centerX * 2 - node->location().x(), node->location().y() });
+        transformNodeLocations([center](QPointF location) {
+            return QPointF { center.x() * 2 - location.x(), location.y() };
+        });
+    }
+}
+
+void MindMapData::transformNodeLocations(const std::function<QPointF(QPointF)> & transform)
+{
+    auto && nodes = graph().nodes();
+
+    std::vector<QPointF> locations(nodes.size());
+    for (size_t i = 0; i < nodes.size(); i++) {
+        locations[i] = nodes[i]->location();
+    }
+
+    const auto transformRange = [&](size_t begin, size_t end) {
+        std::transform(locations.begin() + static_cast<std::ptrdiff_t>(begin), locations.begin() + static_cast<std::ptrdiff_t>(end), locations.begin() + static_cast<std::ptrdiff_t>(begin), transform);
+    };
+
+    SC::instance().taskPool()->parallelFor(locations.size(), minNodesPerThread, transformRange);
+
+    // Items can only be touched from the GUI thread. Edges between moved nodes get updated only once.
+    const SceneItems::EdgeUpdateBatch edgeUpdateBatch;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i]->location() != locations[i]) {
+            nodes[i]->setLocation(locations[i]);
         }
     }
 }
@@ -272,26 +441,59 @@ QFont MindMapData::font() const
     return m_style->font;
 }
 
+void MindMapData::measureNodeTexts(QFont font, int textSize) const
+{
+    std::vector<QString> texts;
+    texts.reserve(graph().nodeCount());
+    for (auto && node : graph().nodes()) {
+        texts.push_back(node->text());
+    }
+
+    measureTexts(texts, font, textSize);
+}
+
+void MindMapData::measureTexts(const std::vector<QString> & texts, QFont font, int textSize)
+{
+    if (TestMode::enabled()) {
+        return;
+    }
+
+    // Same as the font of the text edit of a node, see Node::changeFont()
+    if (textSize > 0) {
+        font.setPointSize(textSize);
+    }
+
+    SceneItems::TextSizeCache::measure(texts, font, -1);
+}
+
 void MindMapData::changeFont(QFont font)
 {
-    m_style->font = font;
+    mutableStyle().font = font;
+
+    // The nodes are resized one by one, so the texts are laid out beforehand on several threads
+    measureNodeTexts(font, m_style->textSize);
+
+    // Resized nodes update their edges, so each edge is updated only once
+    const SceneItems::EdgeUpdateBatch edgeUpdateBatch;
 
-    for (auto && edge : m_graph->getEdges()) {
+    for (auto && edge : graph().edges()) {
         edge->changeFont(font);
     }
 
-    for (auto && node : m_graph->getNodes()) {
+    for (auto && node : graph().nodes()) {
         node->changeFont(font);
     }
+
+    notifyStyleChange();
 }
 
 void MindMapData::setShadowEffect(const ShadowEffectParams & params)
 {
-    for (auto && node : m_graph->getNodes()) {
+    for (auto && node : graph().nodes()) {
         node->setShadowEffect(params);
     }
 
-    for (auto && edge : m_graph->getEdges()) {
+    for (auto && edge : graph().edges()) {
         edge->setShadowEffect(params);
     }
 }
@@ -303,49 +505,36 @@ int MindMapData::textSize() const
 
 void MindMapData::setTextSize(int textSize)
 {
-    m_style->textSize = textSize;
+    mutableStyle().textSize = textSize;
+
+    measureNodeTexts(m_style->font, textSize);
+
+    const SceneItems::EdgeUpdateBatch edgeUpdateBatch;
 
-    for (auto && edge : m_graph->getEdges()) {
+    for (auto && edge : graph().edges()) {
         edge->setTextSize(textSize);
     }
 
-    for (auto && node : m_graph->getNodes()) {
+    for (auto && node : graph().nodes()) {
         node->setTextSize(textSize);
     }
+
+    notifyStyleChange();
 }
 
 MindMapStats MindMapData::stats() const
 {
     MindMapStats mms;
 
-    if (m_graph->edgeCount()) {
-
-        // Calculate average edge length
-        double averageEdgeLength = 0;
-        for (auto && edge : m_graph->getEdges()) {
-            averageEdgeLength += edge->length();
-        }
-        averageEdgeLength /= m_graph->edgeCount();
-        mms.averageEdgeLength = averageEdgeLength;
-
-        // Calculate minimum edge length
-        double minimumEdgeLength = m_graph->getEdges().at(0)->length();
-        for (auto && edge : m_graph->getEdges()) {
-            minimumEdgeLength = std::min(minimumEdgeLength, edge->length());
-        }
-        mms.minimumEdgeLength = minimumEdgeLength;
-
-        // Calculate maximum edge length
-        double maximumEdgeLength = m_graph->getEdges().at(0)->length();
-        for (auto && edge : m_graph->getEdges()) {
-            maximumEdgeLength = std::max(maximumEdgeLength, edge->length());
-        }
-        mms.maximumEdgeLength = maximumEdgeLength;
-    }
+    // The edge length statistics are maintained by the graph as the edges change
+    auto && edgeLengthStats = graph().edgeLengthStats();
+    mms.averageEdgeLength = edgeLengthStats.average();
+    mms.minimumEdgeLength = edgeLengthStats.minimum();
+    mms.maximumEdgeLength = edgeLengthStats.maximum();
 
     // Calculate layout aspect ratio
     QRectF rect;
-    for (auto && node : m_graph->getNodes()) {
+    for (auto && node : graph().nodes()) {
         const auto nodeRect = node->placementBoundingRect();
         rect = rect.united(nodeRect.translated(node->pos().x(), node->pos().y()));
     }
@@ -16,10 +16,15 @@
 #ifndef MIND_MAP_DATA_HPP
 #define MIND_MAP_DATA_HPP
 
+#include <QByteArray>
 #include <QFont>
+#include <QPointF>
 #include <QString>
 
+#include <functional>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "../common/constants.hpp"
 #include "mind_map_data_base.hpp"
@@ -27,20 +32,26 @@
 
 #include "../infra/io/alz_file_io_version.hpp"
 
+class Graph;
+class GraphSnapshot;
 class Grid;
 class ImageManager;
+class LayoutCache;
 class ObjectModelLoader;
 class ShadowEffectParams;
 
-class Graph;
-
 class MindMapData : public MindMapDataBase
 {
 public:
     MindMapData(QString name = "");
 
+    //! Copy constructor. The graph is copied as a lightweight GraphSnapshot and the actual
+    //! scene items get created only when the graph is accessed for the first time.
     MindMapData(const MindMapData & other);
 
+    //! Copies everything but the graph, which is replaced by the given snapshot, e.g. a part of the graph.
+    MindMapData(const MindMapData & other, GraphSnapshot graphSnapshot);
+
     virtual ~MindMapData() override;
 
     void applyGrid(const Grid & grid);
@@ -81,12 +92,41 @@ public:
 
     GraphCR graph() const override;
 
+    //! \returns Plain-data copy of the graph without creating any scene items.
+    GraphSnapshot graphSnapshot() const;
+
+    //! Replaces the graph with the given snapshot. Scene items get created when the graph is accessed.
+    void setGraphSnapshot(GraphSnapshot graphSnapshot);
+
+    //! Moves the graph and the pending graph snapshot, if any, out of the mind map and leaves an empty graph
+    //! behind, so that they can be torn down separately, see TeardownScheduler.
+    std::pair<std::unique_ptr<Graph>, std::unique_ptr<GraphSnapshot>> releaseGraph();
+
+    //! \returns true if the style is still shared with the given copy, i.e. neither has changed it since copying,
+    //! or if it's otherwise equal, e.g. with the same mind map read from a file again.
+    bool sharesStyleWith(const MindMapData & other) const;
+
+    //! \returns The style and the layout optimizer parameters in a compact binary form, e.g. for journals.
+    QByteArray styleData() const;
+
+    //! Applies data created by styleData(). Invalid data is ignored.
+    void applyStyleData(const QByteArray & data);
+
+    //! Takes everything but the graph and the style from the given copy, e.g. when undoing in place.
+    //! The images are assigned so that connections to the image manager stay valid.
+    void takeAttributesFrom(const MindMapData & other);
+
     double minEdgeLength() const;
 
     void setMinEdgeLength(double minEdgeLength);
 
     void mirror(bool vertically);
 
+    //! Moves every node to the location that the given function returns for its current location.
+    //! The new locations are calculated in parallel on large maps and then applied in a single pass,
+    //! so that each edge is updated only once. The function must be safe to call from multiple threads.
+    void transformNodeLocations(const std::function<QPointF(QPointF)> & transform);
+
     QFont font() const;
 
     void changeFont(QFont font);
@@ -111,8 +151,23 @@ public:
 
     const ImageManager & imageManager() const;
 
+    //! The cache is shared by the copies of the mind map, e.g. undo points, so undoing and redoing keeps the layouts.
+    LayoutCache & layoutCache() const;
+
 private:
-    void copyGraph(const MindMapData & other);
+    //! Fills the shared text size cache for the given style of the nodes before they are resized.
+    void measureNodeTexts(QFont font, int textSize) const;
+
+    //! Fills the shared text size cache for the given texts of nodes in the given style.
+    static void measureTexts(const std::vector<QString> & texts, QFont font, int textSize);
+
+    //! Notifies the change subscribers of the graph after a setter of the global style.
+    void notifyStyleChange();
+
+    void restoreGraphSnapshot() const;
+
+    struct Style;
+    Style & mutableStyle();
 
     struct LayoutOptimizerParameters
     {
@@ -127,13 +182,17 @@ private:
 
     std::optional<IO::AlzFormatVersion> m_alzFormatVersion;
 
-    struct Style;
-    std::unique_ptr<Style> m_style;
+    std::shared_ptr<Style> m_style;
 
     std::unique_ptr<Graph> m_graph;
 
+    // Pending plain-data copy of the graph, restored lazily by graph()
+    mutable std::unique_ptr<GraphSnapshot> m_graphSnapshot;
+
     std::unique_ptr<ImageManager> m_imageManager;
 
+    std::shared_ptr<LayoutCache> m_layoutCache;
+
     LayoutOptimizerParameters m_layoutOptimizerParameters;
 };
 
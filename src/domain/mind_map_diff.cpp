@@ -0,0 +1,194 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "mind_map_diff.hpp"
+
+#include "graph.hpp"
+#include "graph_snapshot.hpp"
+
+#include <QHash>
+#include <QUuid>
+
+#include <algorithm>
+#include <optional>
+#include <unordered_map>
+
+namespace {
+
+bool contentEquals(const SceneItems::NodeModel & node0, const SceneItems::NodeModel & node1)
+{
+    // The size follows from the text and the collapsed state is only a view of the branch
+    return node0.text == node1.text && node0.color == node1.color && node0.textColor == node1.textColor && node0.imageRef == node1.imageRef;
+}
+
+//! Maps the hashes of the texts that are unique among the given nodes to the nodes. Empty texts are left out.
+std::unordered_map<size_t, const SceneItems::NodeModel *> uniqueTextHashes(const std::vector<const SceneItems::NodeModel *> & nodes)
+{
+    std::unordered_map<size_t, const SceneItems::NodeModel *> textHashes;
+    for (auto && node : nodes) {
+        if (!node->text.isEmpty()) {
+            if (const auto result = textHashes.emplace(static_cast<size_t>(qHash(node->text)), node); !result.second) {
+                // Duplicates and colliding texts can't be matched reliably
+                result.first->second = nullptr;
+            }
+        }
+    }
+    return textHashes;
+}
+
+} // namespace
+
+MindMapDiff::MindMapDiff(const GraphSnapshot & oldGraph, const GraphSnapshot & newGraph)
+{
+    std::unordered_map<int, const SceneItems::NodeModel *> oldNodes;
+    for (auto && node : oldGraph.nodes()) {
+        oldNodes[node.index] = &node;
+    }
+
+    std::unordered_map<int, const SceneItems::NodeModel *> matchedOldNodes; // By the new index
+
+    // The UUIDs stay the same when the nodes are renumbered on save, so they are matched first
+    QHash<QUuid, const SceneItems::NodeModel *> oldNodesByUuid;
+    for (auto && node : oldGraph.nodes()) {
+        if (!node.uuid.isNull()) {
+            oldNodesByUuid.insert(node.uuid, &node);
+        }
+    }
+    if (!oldNodesByUuid.isEmpty()) {
+        for (auto && node : newGraph.nodes()) {
+            if (const auto iter = oldNodesByUuid.find(node.uuid); !node.uuid.isNull() && iter != oldNodesByUuid.end()) {
+                matchedOldNodes[node.index] = iter.value();
+                oldNodes.erase(iter.value()->index);
+            }
+        }
+    }
+
+    std::vector<const SceneItems::NodeModel *> unmatchedNewNodes;
+    for (auto && node : newGraph.nodes()) {
+        if (matchedOldNodes.count(node.index)) {
+            continue;
+        }
+        if (const auto iter = oldNodes.find(node.index); iter != oldNodes.end()) {
+            matchedOldNodes[node.index] = iter->second;
+            oldNodes.erase(iter);
+        } else {
+            unmatchedNewNodes.push_back(&node);
+        }
+    }
+
+    std::vector<const SceneItems::NodeModel *> unmatchedOldNodes;
+    for (auto && node : oldGraph.nodes()) {
+        if (oldNodes.count(node.index)) {
+            unmatchedOldNodes.push_back(&node);
+        }
+    }
+
+    if (!unmatchedOldNodes.empty() && !unmatchedNewNodes.empty()) {
+        const auto oldTextHashes = uniqueTextHashes(unmatchedOldNodes);
+        for (auto && textHash : uniqueTextHashes(unmatchedNewNodes)) {
+            if (const auto iter = oldTextHashes.find(textHash.first); iter != oldTextHashes.end() && iter->second && textHash.second //
+                && iter->second->text == textHash.second->text) {
+                matchedOldNodes[textHash.second->index] = iter->second;
+                oldNodes.erase(iter->second->index);
+            }
+        }
+    }
+
+    std::unordered_map<int, int> newIndices; // By the old index
+    for (auto && node : newGraph.nodes()) {
+        if (const auto iter = matchedOldNodes.find(node.index); iter != matchedOldNodes.end()) {
+            const auto oldNode = iter->second;
+            newIndices[oldNode->index] = node.index;
+            if (!contentEquals(*oldNode, node)) {
+                m_nodeChanges.push_back({ Change::Edited, oldNode->index, node.index, node.text });
+            } else if (oldNode->location != node.location) {
+                m_nodeChanges.push_back({ Change::Moved, oldNode->index, node.index, node.text });
+            }
+        } else {
+            m_nodeChanges.push_back({ Change::Added, -1, node.index, node.text });
+        }
+    }
+    for (auto && node : oldGraph.nodes()) {
+        if (oldNodes.count(node.index)) {
+            m_nodeChanges.push_back({ Change::Removed, node.index, -1, node.text });
+        }
+    }
+
+    // The old edges are keyed by their new node indices
+    const auto newEdgeKey = [&newIndices](const GraphSnapshot::EdgeData & edge) -> std::optional<int64_t> {
+        const auto source = newIndices.find(edge.sourceIndex);
+        const auto target = newIndices.find(edge.targetIndex);
+        if (source == newIndices.end() || target == newIndices.end()) {
+            return {};
+        }
+        return Graph::buildKeyFromIndices(source->second, target->second);
+    };
+
+    std::unordered_map<int64_t, const GraphSnapshot::EdgeData *> unmatchedOldEdges;
+    for (auto && edge : oldGraph.edges()) {
+        if (const auto key = newEdgeKey(edge); key.has_value()) {
+            unmatchedOldEdges[*key] = &edge;
+        }
+    }
+
+    for (auto && edge : newGraph.edges()) {
+        if (const auto iter = unmatchedOldEdges.find(Graph::buildKeyFromIndices(edge.sourceIndex, edge.targetIndex)); iter != unmatchedOldEdges.end()) {
+            auto oldEdge = *iter->second;
+            oldEdge.sourceIndex = edge.sourceIndex;
+            oldEdge.targetIndex = edge.targetIndex;
+            if (!GraphSnapshot::equals(oldEdge, edge)) {
+                m_edgeChanges.push_back({ Change::Edited, edge.sourceIndex, edge.targetIndex, edge.model.text });
+            }
+            unmatchedOldEdges.erase(iter);
+        } else {
+            m_edgeChanges.push_back({ Change::Added, edge.sourceIndex, edge.targetIndex, edge.model.text });
+        }
+    }
+
+    for (auto && edge : oldGraph.edges()) {
+        if (const auto key = newEdgeKey(edge); !key.has_value() || unmatchedOldEdges.count(*key)) {
+            m_edgeChanges.push_back({ Change::Removed, edge.sourceIndex, edge.targetIndex, edge.model.text });
+        }
+    }
+}
+
+const std::vector<MindMapDiff::NodeChange> & MindMapDiff::nodeChanges() const
+{
+    return m_nodeChanges;
+}
+
+const std::vector<MindMapDiff::EdgeChange> & MindMapDiff::edgeChanges() const
+{
+    return m_edgeChanges;
+}
+
+size_t MindMapDiff::nodeCount(Change change) const
+{
+    return static_cast<size_t>(std::count_if(m_nodeChanges.begin(), m_nodeChanges.end(), [change](auto && nodeChange) {
+        return nodeChange.change == change;
+    }));
+}
+
+size_t MindMapDiff::edgeCount(Change change) const
+{
+    return static_cast<size_t>(std::count_if(m_edgeChanges.begin(), m_edgeChanges.end(), [change](auto && edgeChange) {
+        return edgeChange.change == change;
+    }));
+}
+
+bool MindMapDiff::isEmpty() const
+{
+    return m_nodeChanges.empty() && m_edgeChanges.empty();
+}
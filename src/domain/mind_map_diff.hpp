@@ -0,0 +1,90 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIND_MAP_DIFF_HPP
+#define MIND_MAP_DIFF_HPP
+
+#include <QString>
+
+#include <vector>
+
+class GraphSnapshot;
+
+//! Structural difference between two versions of a mind map, e.g. for reviewing the changes of a generated mind map.
+//! Nodes are matched by their UUID if they have one, then by their index, and the nodes whose index is only in one of
+//! the versions by their text if it's unique, so that renumbered nodes are still matched. Edges are matched through their matched nodes. The matching
+//! runs in expected linear time, as both are looked up from hash maps.
+class MindMapDiff
+{
+public:
+    enum class Change
+    {
+        Added,
+
+        Removed,
+
+        //! Only the location has changed.
+        Moved,
+
+        //! The text, the colors or the image of a node, or the data of an edge, has changed.
+        Edited
+    };
+
+    struct NodeChange
+    {
+        Change change;
+
+        //! -1 for added nodes.
+        int oldIndex = -1;
+
+        //! -1 for removed nodes.
+        int newIndex = -1;
+
+        QString text;
+    };
+
+    struct EdgeChange
+    {
+        Change change;
+
+        //! The node indices in the new version, or in the old version for removed edges.
+        int sourceIndex = -1;
+
+        int targetIndex = -1;
+
+        QString text;
+    };
+
+    MindMapDiff(const GraphSnapshot & oldGraph, const GraphSnapshot & newGraph);
+
+    //! The changes of the nodes in the new version in their order, followed by the removed nodes.
+    const std::vector<NodeChange> & nodeChanges() const;
+
+    //! The changes of the edges in the new version in their order, followed by the removed edges.
+    const std::vector<EdgeChange> & edgeChanges() const;
+
+    size_t nodeCount(Change change) const;
+
+    size_t edgeCount(Change change) const;
+
+    bool isEmpty() const;
+
+private:
+    std::vector<NodeChange> m_nodeChanges;
+
+    std::vector<EdgeChange> m_edgeChanges;
+};
+
+#endif // MIND_MAP_DIFF_HPP
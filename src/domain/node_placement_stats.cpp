@@ -0,0 +1,89 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "node_placement_stats.hpp"
+
+void NodePlacementStats::clear()
+{
+    m_rects.clear();
+    m_lefts.clear();
+    m_tops.clear();
+    m_rights.clear();
+    m_bottoms.clear();
+    m_totalArea = 0;
+}
+
+void NodePlacementStats::remove(Key key)
+{
+    if (const auto iter = m_rects.find(key); iter != m_rects.end()) {
+        eraseEdges(iter->second);
+        m_rects.erase(iter);
+        if (m_rects.empty()) {
+            m_totalArea = 0;
+        }
+    }
+}
+
+void NodePlacementStats::setRect(Key key, const QRectF & rect)
+{
+    if (const auto iter = m_rects.find(key); iter != m_rects.end()) {
+        if (iter->second == rect) {
+            return;
+        }
+        eraseEdges(iter->second);
+        iter->second = rect;
+    } else {
+        m_rects.emplace(key, rect);
+    }
+
+    insertEdges(rect);
+}
+
+QRectF NodePlacementStats::boundingRect() const
+{
+    if (m_rects.empty()) {
+        return {};
+    }
+
+    return QRectF { QPointF { *m_lefts.begin(), *m_tops.begin() }, QPointF { *m_rights.rbegin(), *m_bottoms.rbegin() } };
+}
+
+double NodePlacementStats::totalArea() const
+{
+    return m_totalArea;
+}
+
+size_t NodePlacementStats::size() const
+{
+    return m_rects.size();
+}
+
+void NodePlacementStats::insertEdges(const QRectF & rect)
+{
+    m_lefts.insert(rect.left());
+    m_tops.insert(rect.top());
+    m_rights.insert(rect.right());
+    m_bottoms.insert(rect.bottom());
+    m_totalArea += rect.width() * rect.height();
+}
+
+void NodePlacementStats::eraseEdges(const QRectF & rect)
+{
+    m_lefts.erase(m_lefts.find(rect.left()));
+    m_tops.erase(m_tops.find(rect.top()));
+    m_rights.erase(m_rights.find(rect.right()));
+    m_bottoms.erase(m_bottoms.find(rect.bottom()));
+    m_totalArea -= rect.width() * rect.height();
+}
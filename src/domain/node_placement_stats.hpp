@@ -0,0 +1,65 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef NODE_PLACEMENT_STATS_HPP
+#define NODE_PLACEMENT_STATS_HPP
+
+#include <QRectF>
+
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+
+//! Incrementally maintained bounding rect and total area of the placement rects of nodes, so that
+//! zoom-to-fit and export sizes don't need a pass over all nodes. The edges of the rects are kept
+//! in ordered multisets, so the bounding rect survives moves and removals of the outermost nodes.
+class NodePlacementStats
+{
+public:
+    using Key = int64_t;
+
+    void clear();
+
+    void remove(Key key);
+
+    //! Adds or updates the placement rect, in scene coordinates, of the given key.
+    void setRect(Key key, const QRectF & rect);
+
+    //! \returns United placement rect of all nodes, or a null rect if there are no nodes.
+    QRectF boundingRect() const;
+
+    double totalArea() const;
+
+    size_t size() const;
+
+private:
+    void insertEdges(const QRectF & rect);
+
+    void eraseEdges(const QRectF & rect);
+
+    std::unordered_map<Key, QRectF> m_rects;
+
+    std::multiset<double> m_lefts;
+
+    std::multiset<double> m_tops;
+
+    std::multiset<double> m_rights;
+
+    std::multiset<double> m_bottoms;
+
+    double m_totalArea = 0;
+};
+
+#endif // NODE_PLACEMENT_STATS_HPP
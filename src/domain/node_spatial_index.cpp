@@ -0,0 +1,201 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "node_spatial_index.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+NodeSpatialIndex::NodeSpatialIndex(double cellSize)
+  : m_cellSize(cellSize)
+{
+}
+
+void NodeSpatialIndex::clear()
+{
+    m_cells.clear();
+    m_rects.clear();
+}
+
+void NodeSpatialIndex::remove(Key key)
+{
+    const auto iter = m_rects.find(key);
+    if (iter == m_rects.end()) {
+        return;
+    }
+
+    const auto range = cellRange(iter->second);
+    for (auto row = range.top; row <= range.bottom; row++) {
+        for (auto column = range.left; column <= range.right; column++) {
+            const auto cellIter = m_cells.find(cellKey(column, row));
+            auto && entries = cellIter->second;
+            const auto entryIter = std::find_if(entries.begin(), entries.end(), [key](auto && entry) {
+                return entry.key == key;
+            });
+            *entryIter = entries.back();
+            entries.pop_back();
+            if (entries.empty()) {
+                m_cells.erase(cellIter);
+            }
+        }
+    }
+
+    m_rects.erase(iter);
+}
+
+void NodeSpatialIndex::setRect(Key key, const QRectF & rect)
+{
+    if (const auto iter = m_rects.find(key); iter != m_rects.end()) {
+        if (iter->second == rect) {
+            return;
+        }
+        remove(key);
+    }
+
+    m_rects.emplace(key, rect);
+    const auto range = cellRange(rect);
+    for (auto row = range.top; row <= range.bottom; row++) {
+        for (auto column = range.left; column <= range.right; column++) {
+            m_cells[cellKey(column, row)].push_back({ key, rect });
+        }
+    }
+}
+
+template<typename Visitor>
+void NodeSpatialIndex::visitRectsIn(const QRectF & rect, Visitor && visitor) const
+{
+    // A rect larger than the indexed area would mostly visit empty cells
+    const auto range = cellRange(rect);
+    if (static_cast<double>(range.right - range.left + 1) * static_cast<double>(range.bottom - range.top + 1) > static_cast<double>(m_cells.size())) {
+        for (auto && [key, keyRect] : m_rects) {
+            if (keyRect.intersects(rect) && !visitor(key)) {
+                return;
+            }
+        }
+        return;
+    }
+
+    for (auto row = range.top; row <= range.bottom; row++) {
+        for (auto column = range.left; column <= range.right; column++) {
+            const auto cellIter = m_cells.find(cellKey(column, row));
+            if (cellIter == m_cells.end()) {
+                continue;
+            }
+            for (auto && entry : cellIter->second) {
+                if (!entry.rect.intersects(rect)) {
+                    continue;
+                }
+                // A rect in several cells is only visited in the first cell that both rects share
+                const auto entryRange = cellRange(entry.rect);
+                if (column == std::max(range.left, entryRange.left) && row == std::max(range.top, entryRange.top) && !visitor(entry.key)) {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+bool NodeSpatialIndex::isFree(const QRectF & rect, Key ignoredKey) const
+{
+    bool isFree = true;
+    visitRectsIn(rect, [&isFree, ignoredKey](Key key) {
+        isFree = key == ignoredKey;
+        return isFree;
+    });
+    return isFree;
+}
+
+std::vector<NodeSpatialIndex::Key> NodeSpatialIndex::keysInRect(const QRectF & rect) const
+{
+    std::vector<Key> keys;
+    visitRectsIn(rect, [&keys](Key key) {
+        keys.push_back(key);
+        return true;
+    });
+    return keys;
+}
+
+NodeSpatialIndex::Key NodeSpatialIndex::nearestInDirection(const QPointF & origin, const QPointF & direction, const std::function<bool(Key)> & isCandidate) const
+{
+    const auto directionLength = std::hypot(direction.x(), direction.y());
+    if (directionLength <= 0) {
+        return -1;
+    }
+
+    const QPointF unit { direction.x() / directionLength, direction.y() / directionLength };
+    Key nearestKey = -1;
+    double nearestDistance = 0;
+    const auto consider = [&](Key key, const QRectF & rect) {
+        const auto offset = rect.center() - origin;
+        const auto along = offset.x() * unit.x() + offset.y() * unit.y();
+        const auto across = offset.x() * unit.y() - offset.y() * unit.x();
+        if (along <= 0 || std::abs(across) > along) {
+            return;
+        }
+        if (const auto distance = std::hypot(along, across); (nearestKey == -1 || distance < nearestDistance) && isCandidate(key)) {
+            nearestKey = key;
+            nearestDistance = distance;
+        }
+    };
+
+    // Every rect whose center is within the radius intersects the square around the origin, so the search can end
+    // as soon as the nearest candidate so far is within the radius
+    for (auto radius = m_cellSize;; radius *= 2) {
+        const QRectF square { origin.x() - radius, origin.y() - radius, 2 * radius, 2 * radius };
+        const auto range = cellRange(square);
+        if (static_cast<double>(range.right - range.left + 1) * static_cast<double>(range.bottom - range.top + 1) > static_cast<double>(m_cells.size())) {
+            // Sparse neighbourhood of a far away point: the cells don't help anymore
+            for (auto && [key, keyRect] : m_rects) {
+                consider(key, keyRect);
+            }
+            return nearestKey;
+        }
+
+        visitRectsIn(square, [&](Key key) {
+            consider(key, m_rects.at(key));
+            return true;
+        });
+
+        if (nearestKey != -1 && nearestDistance <= radius) {
+            return nearestKey;
+        }
+    }
+}
+
+QRectF NodeSpatialIndex::rect(Key key) const
+{
+    const auto iter = m_rects.find(key);
+    return iter != m_rects.end() ? iter->second : QRectF {};
+}
+
+size_t NodeSpatialIndex::size() const
+{
+    return m_rects.size();
+}
+
+NodeSpatialIndex::CellRange NodeSpatialIndex::cellRange(const QRectF & rect) const
+{
+    return {
+        static_cast<int64_t>(std::floor(rect.left() / m_cellSize)),
+        static_cast<int64_t>(std::floor(rect.top() / m_cellSize)),
+        static_cast<int64_t>(std::floor(rect.right() / m_cellSize)),
+        static_cast<int64_t>(std::floor(rect.bottom() / m_cellSize))
+    };
+}
+
+uint64_t NodeSpatialIndex::cellKey(int64_t column, int64_t row)
+{
+    return (static_cast<uint64_t>(column) << 32) ^ static_cast<uint32_t>(row);
+}
@@ -0,0 +1,93 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef NODE_SPATIAL_INDEX_HPP
+#define NODE_SPATIAL_INDEX_HPP
+
+#include <QRectF>
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+//! Uniform grid over the placement rects of the nodes, in scene coordinates. A rect is stored in all cells that it
+//! intersects, so a query only visits the cells under the queried rect and its cost depends on the number of nodes
+//! near it. Unlike the scene index it also covers the nodes that aren't in the scene, e.g. without a view.
+class NodeSpatialIndex
+{
+public:
+    using Key = int;
+
+    explicit NodeSpatialIndex(double cellSize = 256);
+
+    void clear();
+
+    void remove(Key key);
+
+    //! Adds or updates the placement rect of the given key.
+    void setRect(Key key, const QRectF & rect);
+
+    //! \returns True if no rect other than the one of ignoredKey intersects the given rect.
+    bool isFree(const QRectF & rect, Key ignoredKey = -1) const;
+
+    //! \returns The keys of the rects that intersect the given rect, each once, in no particular order.
+    std::vector<Key> keysInRect(const QRectF & rect) const;
+
+    //! \returns The key of the rect whose center is nearest to the given point within 45 degrees of the given direction,
+    //! or -1 if there's none. The search widens from the cells around the point, so it only visits the rects nearby
+    //! unless the neighbourhood is empty. Keys rejected by isCandidate are skipped.
+    Key nearestInDirection(const QPointF & origin, const QPointF & direction, const std::function<bool(Key)> & isCandidate) const;
+
+    //! \returns The rect of the given key, or a null rect if the key isn't indexed.
+    QRectF rect(Key key) const;
+
+    size_t size() const;
+
+private:
+    struct CellRange
+    {
+        int64_t left = 0;
+
+        int64_t top = 0;
+
+        int64_t right = 0;
+
+        int64_t bottom = 0;
+    };
+
+    CellRange cellRange(const QRectF & rect) const;
+
+    static uint64_t cellKey(int64_t column, int64_t row);
+
+    //! Calls the visitor once per rect that intersects the given rect until it returns false.
+    template<typename Visitor>
+    void visitRectsIn(const QRectF & rect, Visitor && visitor) const;
+
+    double m_cellSize;
+
+    struct Entry
+    {
+        Key key = -1;
+
+        QRectF rect;
+    };
+
+    std::unordered_map<uint64_t, std::vector<Entry>> m_cells;
+
+    std::unordered_map<Key, QRectF> m_rects;
+};
+
+#endif // NODE_SPATIAL_INDEX_HPP
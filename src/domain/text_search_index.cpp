@@ -0,0 +1,210 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "text_search_index.hpp"
+
+#include <algorithm>
+#include <tuple>
+
+namespace {
+const int gramLength = 3;
+
+int rankMatch(const QString & foldedText, const QString & foldedQuery)
+{
+    if (foldedText == foldedQuery) {
+        return 0;
+    }
+
+    if (foldedText.startsWith(foldedQuery)) {
+        return 1;
+    }
+
+    for (auto index = foldedText.indexOf(foldedQuery); index > 0; index = foldedText.indexOf(foldedQuery, index + 1)) {
+        if (!foldedText.at(index - 1).isLetterOrNumber()) {
+            return 2;
+        }
+    }
+
+    return 3;
+}
+} // namespace
+
+void TextSearchIndex::clear()
+{
+    m_texts.clear();
+    m_postings.clear();
+}
+
+void TextSearchIndex::remove(Key key)
+{
+    if (const auto iter = m_texts.find(key); iter != m_texts.end()) {
+        for (auto && gram : buildGrams(iter->second)) {
+            if (const auto posting = m_postings.find(gram); posting != m_postings.end()) {
+                posting->second.erase(key);
+                if (posting->second.empty()) {
+                    m_postings.erase(posting);
+                }
+            }
+        }
+        m_texts.erase(iter);
+    }
+}
+
+void TextSearchIndex::setText(Key key, const QString & text)
+{
+    const auto foldedText = text.toCaseFolded();
+    GramSet oldGrams;
+    if (const auto iter = m_texts.find(key); iter != m_texts.end()) {
+        if (iter->second == foldedText) {
+            return;
+        }
+        oldGrams = buildGrams(iter->second);
+    }
+
+    const auto newGrams = buildGrams(foldedText);
+    for (auto && gram : oldGrams) {
+        if (!newGrams.contains(gram)) {
+            if (const auto posting = m_postings.find(gram); posting != m_postings.end()) {
+                posting->second.erase(key);
+                if (posting->second.empty()) {
+                    m_postings.erase(posting);
+                }
+            }
+        }
+    }
+
+    for (auto && gram : newGrams) {
+        if (!oldGrams.contains(gram)) {
+            m_postings[gram].insert(key);
+        }
+    }
+
+    m_texts[key] = foldedText;
+}
+
+std::vector<TextSearchIndex::Key> TextSearchIndex::search(const QString & text) const
+{
+    const auto foldedQuery = text.toCaseFolded();
+    if (foldedQuery.isEmpty()) {
+        return {};
+    }
+
+    std::vector<Key> candidates;
+    if (foldedQuery.length() >= gramLength) {
+        // Every match must contain all grams of the query, so only the rarest posting needs to be verified
+        const std::unordered_set<Key> * rarest = nullptr;
+        for (int i = 0; i + gramLength <= foldedQuery.length(); i++) {
+            const auto posting = m_postings.find(foldedQuery.mid(i, gramLength));
+            if (posting == m_postings.end()) {
+                return {};
+            }
+            if (!rarest || posting->second.size() < rarest->size()) {
+                rarest = &posting->second;
+            }
+        }
+        for (auto && key : *rarest) {
+            if (m_texts.at(key).contains(foldedQuery)) {
+                candidates.push_back(key);
+            }
+        }
+    } else {
+        // A short query matches exactly the texts having a gram that starts with it
+        std::unordered_set<Key> uniqueKeys;
+        for (auto posting = m_postings.lower_bound(foldedQuery); posting != m_postings.end() && posting->first.startsWith(foldedQuery); posting++) {
+            uniqueKeys.insert(posting->second.begin(), posting->second.end());
+        }
+        candidates.assign(uniqueKeys.begin(), uniqueKeys.end());
+    }
+
+    std::vector<std::tuple<int, int, Key>> ranked;
+    ranked.reserve(candidates.size());
+    for (auto && key : candidates) {
+        const auto & foldedText = m_texts.at(key);
+        ranked.emplace_back(rankMatch(foldedText, foldedQuery), static_cast<int>(foldedText.length()), key);
+    }
+    std::sort(ranked.begin(), ranked.end());
+
+    std::vector<Key> result;
+    result.reserve(ranked.size());
+    for (auto && match : ranked) {
+        result.push_back(std::get<2>(match));
+    }
+    return result;
+}
+
+bool TextSearchIndex::read(QDataStream & stream)
+{
+    clear();
+
+    quint64 textCount = 0;
+    stream >> textCount;
+    for (quint64 i = 0; i < textCount && stream.status() == QDataStream::Ok; i++) {
+        qint64 key = 0;
+        QString text;
+        stream >> key >> text;
+        m_texts.emplace(key, text);
+    }
+
+    quint64 postingCount = 0;
+    stream >> postingCount;
+    for (quint64 i = 0; i < postingCount && stream.status() == QDataStream::Ok; i++) {
+        QString gram;
+        quint64 keyCount = 0;
+        stream >> gram >> keyCount;
+        auto && keys = m_postings[gram];
+        for (quint64 j = 0; j < keyCount && stream.status() == QDataStream::Ok; j++) {
+            qint64 key = 0;
+            stream >> key;
+            keys.insert(key);
+        }
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        clear();
+        return false;
+    }
+
+    return true;
+}
+
+size_t TextSearchIndex::size() const
+{
+    return m_texts.size();
+}
+
+TextSearchIndex::GramSet TextSearchIndex::buildGrams(const QString & foldedText)
+{
+    GramSet grams;
+    for (int i = 0; i < foldedText.length(); i++) {
+        grams.insert(foldedText.mid(i, gramLength));
+    }
+    return grams;
+}
+
+void TextSearchIndex::write(QDataStream & stream) const
+{
+    stream << static_cast<quint64>(m_texts.size());
+    for (auto && [key, text] : m_texts) {
+        stream << static_cast<qint64>(key) << text;
+    }
+
+    stream << static_cast<quint64>(m_postings.size());
+    for (auto && [gram, keys] : m_postings) {
+        stream << gram << static_cast<quint64>(keys.size());
+        for (auto && key : keys) {
+            stream << static_cast<qint64>(key);
+        }
+    }
+}
@@ -0,0 +1,67 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TEXT_SEARCH_INDEX_HPP
+#define TEXT_SEARCH_INDEX_HPP
+
+#include <QDataStream>
+#include <QSet>
+#include <QString>
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+//! Incrementally maintained n-gram index for case-insensitive substring search.
+//! Every position of a text contributes the gram starting there, so grams near the end are shorter.
+//! Queries of at least gram length intersect via the rarest gram, shorter ones scan the sorted grams by prefix.
+class TextSearchIndex
+{
+public:
+    using Key = int64_t;
+
+    void clear();
+
+    void remove(Key key);
+
+    //! Adds or updates the text of the given key. Only the grams that changed are touched.
+    void setText(Key key, const QString & text);
+
+    //! \returns Keys whose text contains the given text ranked by exact, prefix, word prefix and
+    //! plain substring matches. Ties are broken by shorter text first.
+    std::vector<Key> search(const QString & text) const;
+
+    size_t size() const;
+
+    //! Writes the texts and the postings, e.g. for an index on disk, so that read() doesn't build the grams again.
+    void write(QDataStream & stream) const;
+
+    //! Replaces the contents with the ones written by write().
+    //! \returns false if the data is truncated or corrupted, in which case the index is left empty.
+    bool read(QDataStream & stream);
+
+private:
+    using GramSet = QSet<QString>;
+
+    static GramSet buildGrams(const QString & foldedText);
+
+    std::unordered_map<Key, QString> m_texts;
+
+    std::map<QString, std::unordered_set<Key>> m_postings;
+};
+
+#endif // TEXT_SEARCH_INDEX_HPP
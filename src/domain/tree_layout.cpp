@@ -0,0 +1,504 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "tree_layout.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+static const size_t NONE = std::numeric_limits<size_t>::max();
+
+static const double PI = std::acos(-1.0);
+
+// Siblings are closer to each other than to their parent
+static const double SIBLING_GAP_SCALE = 0.5;
+
+// The nodes of a tree are in breadth-first order, so the root is 0, the children of a node are consecutive
+// and the nodes on a level are from left to right.
+struct TreeLayout::Tree
+{
+    std::vector<size_t> vertices;
+
+    std::vector<size_t> parents;
+
+    std::vector<size_t> childBegins;
+
+    std::vector<size_t> childEnds;
+
+    std::vector<size_t> depths;
+
+    //! Sizes along the axis on which the siblings are.
+    std::vector<double> breadths;
+
+    //! Sizes along the axis from the root to the leaves.
+    std::vector<double> lengths;
+
+    //! Results of the tidy layout on the breadth axis.
+    std::vector<double> coordinates;
+
+    double separation(size_t node0, size_t node1, double gap) const
+    {
+        return (breadths.at(node0) + breadths.at(node1)) / 2 + gap;
+    }
+
+    std::vector<double> maxLengthsByDepth() const
+    {
+        std::vector<double> maxLengths(depths.back() + 1, 0);
+        for (size_t i = 0; i < depths.size(); i++) {
+            maxLengths.at(depths.at(i)) = std::max(maxLengths.at(depths.at(i)), lengths.at(i));
+        }
+        return maxLengths;
+    }
+};
+
+TreeLayout::TreeLayout(std::vector<QPointF> positions, std::vector<QSizeF> sizes, const EdgeVector & edges, Parameters parameters)
+  : m_positions(std::move(positions))
+  , m_sizes(std::move(sizes))
+  , m_edges(edges)
+  , m_parameters(parameters)
+{
+}
+
+void TreeLayout::run()
+{
+    buildForest();
+
+    for (size_t treeIndex = 0; treeIndex + 1 < m_treeOffsets.size(); treeIndex++) {
+        if (const auto root = m_order.at(m_treeOffsets.at(treeIndex)); m_parameters.style == Style::LeftRight) {
+            layOutLeftRight(root);
+        } else {
+            layOutRadial(root);
+        }
+    }
+
+    // The trees of a forest are stacked below each other, or side by side if they are round
+    QRectF layoutRect;
+    QPointF cursor;
+    for (size_t treeIndex = 0; treeIndex < treeCount(); treeIndex++) {
+        const auto rect = boundingRect(treeIndex);
+        if (m_parameters.style == Style::LeftRight) {
+            translate(treeIndex, cursor - QPointF { rect.center().x(), rect.top() });
+            cursor.ry() += rect.height() + m_parameters.minEdgeLength;
+        } else {
+            translate(treeIndex, cursor - QPointF { rect.left(), rect.center().y() });
+            cursor.rx() += rect.width() + m_parameters.minEdgeLength;
+        }
+        layoutRect = layoutRect.united(boundingRect(treeIndex));
+    }
+
+    for (size_t treeIndex = 0; treeIndex < treeCount(); treeIndex++) {
+        translate(treeIndex, m_parameters.center - layoutRect.center());
+    }
+}
+
+double TreeLayout::cost() const
+{
+    double cost = 0;
+    for (auto && [vertex0, vertex1] : m_edges) {
+        const auto delta = m_positions.at(vertex1) - m_positions.at(vertex0);
+        cost += std::hypot(delta.x(), delta.y());
+    }
+    return cost;
+}
+
+size_t TreeLayout::treeCount() const
+{
+    return m_treeOffsets.empty() ? 0 : m_treeOffsets.size() - 1;
+}
+
+const std::vector<QPointF> & TreeLayout::positions() const
+{
+    return m_positions;
+}
+
+void TreeLayout::buildForest()
+{
+    const auto vertexCount = m_positions.size();
+    std::vector<size_t> inDegrees(vertexCount, 0);
+    std::vector<size_t> neighborOffsets(vertexCount + 1, 0);
+    for (auto && [vertex0, vertex1] : m_edges) {
+        if (vertex0 != vertex1) {
+            inDegrees.at(vertex1)++;
+            neighborOffsets.at(vertex0 + 1)++;
+            neighborOffsets.at(vertex1 + 1)++;
+        }
+    }
+    std::partial_sum(neighborOffsets.begin(), neighborOffsets.end(), neighborOffsets.begin());
+    std::vector<size_t> neighbors(neighborOffsets.back());
+    std::vector<size_t> insertPositions(neighborOffsets.begin(), neighborOffsets.end() - 1);
+    for (auto && [vertex0, vertex1] : m_edges) {
+        if (vertex0 != vertex1) {
+            neighbors.at(insertPositions.at(vertex0)++) = vertex1;
+            neighbors.at(insertPositions.at(vertex1)++) = vertex0;
+        }
+    }
+
+    // Vertices without parents are the natural roots, a cycle is rooted at its first vertex
+    std::vector<size_t> candidates;
+    for (size_t vertex = 0; vertex < vertexCount; vertex++) {
+        if (!inDegrees.at(vertex)) {
+            candidates.push_back(vertex);
+        }
+    }
+    candidates.resize(candidates.size() + vertexCount);
+    std::iota(candidates.end() - static_cast<std::ptrdiff_t>(vertexCount), candidates.end(), 0);
+
+    std::vector<size_t> parents(vertexCount, NONE);
+    std::vector<bool> visited(vertexCount, false);
+    m_order.clear();
+    m_order.reserve(vertexCount);
+    m_treeOffsets.assign(1, 0);
+    for (auto && candidate : candidates) {
+        if (visited.at(candidate)) {
+            continue;
+        }
+        visited.at(candidate) = true;
+        m_order.push_back(candidate);
+        for (size_t i = m_treeOffsets.back(); i < m_order.size(); i++) {
+            const auto vertex = m_order.at(i);
+            for (size_t j = neighborOffsets.at(vertex); j < neighborOffsets.at(vertex + 1); j++) {
+                if (const auto neighbor = neighbors.at(j); !visited.at(neighbor)) {
+                    visited.at(neighbor) = true;
+                    parents.at(neighbor) = vertex;
+                    m_order.push_back(neighbor);
+                }
+            }
+        }
+        m_treeOffsets.push_back(m_order.size());
+    }
+
+    // The children keep their current order: from top to bottom, or around the root for the radial style
+    std::vector<size_t> roots(vertexCount);
+    std::vector<double> angles(vertexCount, 0);
+    std::vector<double> sortKeys(vertexCount, 0);
+    for (auto && vertex : m_order) {
+        const auto parent = parents.at(vertex);
+        roots.at(vertex) = parent == NONE ? vertex : roots.at(parent);
+        const auto delta = m_positions.at(vertex) - m_positions.at(roots.at(vertex));
+        angles.at(vertex) = std::atan2(delta.y(), delta.x());
+        if (m_parameters.style == Style::LeftRight) {
+            sortKeys.at(vertex) = m_positions.at(vertex).y();
+        } else if (parent != NONE) {
+            sortKeys.at(vertex) = parent == roots.at(vertex) ? angles.at(vertex) : std::remainder(angles.at(vertex) - angles.at(parent), 2 * PI);
+        }
+    }
+
+    m_childOffsets.assign(vertexCount + 1, 0);
+    for (auto && vertex : m_order) {
+        if (const auto parent = parents.at(vertex); parent != NONE) {
+            m_childOffsets.at(parent + 1)++;
+        }
+    }
+    std::partial_sum(m_childOffsets.begin(), m_childOffsets.end(), m_childOffsets.begin());
+    m_children.resize(m_childOffsets.back());
+    insertPositions.assign(m_childOffsets.begin(), m_childOffsets.end() - 1);
+    for (auto && vertex : m_order) {
+        if (const auto parent = parents.at(vertex); parent != NONE) {
+            m_children.at(insertPositions.at(parent)++) = vertex;
+        }
+    }
+    for (size_t vertex = 0; vertex < vertexCount; vertex++) {
+        const auto begin = m_children.begin() + static_cast<std::ptrdiff_t>(m_childOffsets.at(vertex));
+        const auto end = m_children.begin() + static_cast<std::ptrdiff_t>(m_childOffsets.at(vertex + 1));
+        std::stable_sort(begin, end, [&sortKeys](size_t lhs, size_t rhs) {
+            return sortKeys.at(lhs) < sortKeys.at(rhs);
+        });
+    }
+}
+
+TreeLayout::Tree TreeLayout::buildTree(size_t root, const std::vector<size_t> & rootChildren) const
+{
+    Tree tree;
+    const auto addNode = [&](size_t vertex, size_t parent) {
+        const auto size = m_sizes.at(vertex);
+        tree.vertices.push_back(vertex);
+        tree.parents.push_back(parent);
+        tree.childBegins.push_back(0);
+        tree.childEnds.push_back(0);
+        tree.depths.push_back(parent == NONE ? 0 : tree.depths.at(parent) + 1);
+        if (m_parameters.style == Style::LeftRight) {
+            tree.breadths.push_back(size.height());
+            tree.lengths.push_back(size.width());
+        } else {
+            // The nodes are not rotated on the rings, so any direction must fit the diagonal
+            tree.breadths.push_back(std::hypot(size.width(), size.height()));
+            tree.lengths.push_back(tree.breadths.back());
+        }
+    };
+
+    addNode(root, NONE);
+    for (size_t node = 0; node < tree.vertices.size(); node++) {
+        tree.childBegins.at(node) = tree.vertices.size();
+        if (node == 0) {
+            for (auto && child : rootChildren) {
+                addNode(child, node);
+            }
+        } else {
+            const auto vertex = tree.vertices.at(node);
+            for (size_t i = m_childOffsets.at(vertex); i < m_childOffsets.at(vertex + 1); i++) {
+                addNode(m_children.at(i), node);
+            }
+        }
+        tree.childEnds.at(node) = tree.vertices.size();
+    }
+
+    return tree;
+}
+
+// Buchheim, Jünger and Leipert: Improving Walker's Algorithm to Run in Linear Time. The first walk is done
+// iteratively in post-order, so that long chains don't overflow the stack.
+void TreeLayout::layOutTidy(Tree & tree) const
+{
+    const auto count = tree.vertices.size();
+    const auto gap = m_parameters.minEdgeLength * SIBLING_GAP_SCALE;
+    std::vector<double> prelims(count, 0);
+    std::vector<double> mods(count, 0);
+    std::vector<double> shifts(count, 0);
+    std::vector<double> changes(count, 0);
+    std::vector<size_t> threads(count, NONE);
+    std::vector<size_t> ancestors(count);
+    std::iota(ancestors.begin(), ancestors.end(), 0);
+    std::vector<size_t> defaultAncestors(tree.childBegins);
+
+    const auto isLeaf = [&](size_t node) {
+        return tree.childBegins.at(node) == tree.childEnds.at(node);
+    };
+
+    const auto leftSibling = [&](size_t node) {
+        return node && node > tree.childBegins.at(tree.parents.at(node)) ? node - 1 : NONE;
+    };
+
+    const auto nextLeft = [&](size_t node) {
+        return isLeaf(node) ? threads.at(node) : tree.childBegins.at(node);
+    };
+
+    const auto nextRight = [&](size_t node) {
+        return isLeaf(node) ? threads.at(node) : tree.childEnds.at(node) - 1;
+    };
+
+    // The siblings are consecutive, so the difference of the nodes is the number of subtrees between them
+    const auto moveSubtree = [&](size_t left, size_t right, double shift) {
+        const auto subtrees = static_cast<double>(right - left);
+        changes.at(right) -= shift / subtrees;
+        shifts.at(right) += shift;
+        changes.at(left) += shift / subtrees;
+        prelims.at(right) += shift;
+        mods.at(right) += shift;
+    };
+
+    const auto executeShifts = [&](size_t node) {
+        double shift = 0;
+        double change = 0;
+        for (size_t child = tree.childEnds.at(node); child-- > tree.childBegins.at(node);) {
+            prelims.at(child) += shift;
+            mods.at(child) += shift;
+            change += changes.at(child);
+            shift += shifts.at(child) + change;
+        }
+    };
+
+    const auto apportion = [&](size_t node) {
+        const auto sibling = leftSibling(node);
+        if (sibling == NONE) {
+            return;
+        }
+
+        const auto parent = tree.parents.at(node);
+        auto & defaultAncestor = defaultAncestors.at(parent);
+        auto insideRight = node;
+        auto outsideRight = node;
+        auto insideLeft = sibling;
+        auto outsideLeft = tree.childBegins.at(parent);
+        auto insideRightMod = mods.at(insideRight);
+        auto outsideRightMod = mods.at(outsideRight);
+        auto insideLeftMod = mods.at(insideLeft);
+        auto outsideLeftMod = mods.at(outsideLeft);
+        while (nextRight(insideLeft) != NONE && nextLeft(insideRight) != NONE) {
+            insideLeft = nextRight(insideLeft);
+            insideRight = nextLeft(insideRight);
+            outsideLeft = nextLeft(outsideLeft);
+            outsideRight = nextRight(outsideRight);
+            ancestors.at(outsideRight) = node;
+            const auto shift = (prelims.at(insideLeft) + insideLeftMod) - (prelims.at(insideRight) + insideRightMod) + tree.separation(insideLeft, insideRight, gap);
+            if (shift > 0) {
+                const auto ancestor = tree.parents.at(ancestors.at(insideLeft)) == parent ? ancestors.at(insideLeft) : defaultAncestor;
+                moveSubtree(ancestor, node, shift);
+                insideRightMod += shift;
+                outsideRightMod += shift;
+            }
+            insideLeftMod += mods.at(insideLeft);
+            insideRightMod += mods.at(insideRight);
+            outsideLeftMod += mods.at(outsideLeft);
+            outsideRightMod += mods.at(outsideRight);
+        }
+
+        if (nextRight(insideLeft) != NONE && nextRight(outsideRight) == NONE) {
+            threads.at(outsideRight) = nextRight(insideLeft);
+            mods.at(outsideRight) += insideLeftMod - outsideRightMod;
+        }
+
+        if (nextLeft(insideRight) != NONE && nextLeft(outsideLeft) == NONE) {
+            threads.at(outsideLeft) = nextLeft(insideRight);
+            mods.at(outsideLeft) += insideRightMod - outsideLeftMod;
+            defaultAncestor = node;
+        }
+    };
+
+    std::vector<size_t> stack { 0 };
+    std::vector<size_t> nextChildren(tree.childBegins);
+    while (!stack.empty()) {
+        const auto node = stack.back();
+        if (nextChildren.at(node) < tree.childEnds.at(node)) {
+            stack.push_back(nextChildren.at(node)++);
+            continue;
+        }
+        stack.pop_back();
+
+        const auto sibling = leftSibling(node);
+        if (isLeaf(node)) {
+            prelims.at(node) = sibling != NONE ? prelims.at(sibling) + tree.separation(sibling, node, gap) : 0;
+        } else {
+            executeShifts(node);
+            const auto midpoint = (prelims.at(tree.childBegins.at(node)) + prelims.at(tree.childEnds.at(node) - 1)) / 2;
+            if (sibling != NONE) {
+                prelims.at(node) = prelims.at(sibling) + tree.separation(sibling, node, gap);
+                mods.at(node) = prelims.at(node) - midpoint;
+            } else {
+                prelims.at(node) = midpoint;
+            }
+        }
+
+        if (node) {
+            apportion(node);
+        }
+    }
+
+    // The second walk: the parents are before their children
+    std::vector<double> modSums(count, 0);
+    tree.coordinates.assign(count, 0);
+    for (size_t node = 0; node < count; node++) {
+        if (const auto parent = tree.parents.at(node); parent != NONE) {
+            modSums.at(node) = modSums.at(parent) + mods.at(parent);
+        }
+        tree.coordinates.at(node) = prelims.at(node) + modSums.at(node);
+    }
+}
+
+void TreeLayout::layOutLeftRight(size_t root)
+{
+    std::vector<size_t> leftChildren;
+    std::vector<size_t> rightChildren;
+    for (size_t i = m_childOffsets.at(root); i < m_childOffsets.at(root + 1); i++) {
+        const auto child = m_children.at(i);
+        (m_positions.at(child).x() < m_positions.at(root).x() ? leftChildren : rightChildren).push_back(child);
+    }
+
+    m_positions.at(root) = {};
+    const auto layOutSide = [&](const std::vector<size_t> & children, double direction) {
+        if (children.empty()) {
+            return;
+        }
+
+        auto tree = buildTree(root, children);
+        layOutTidy(tree);
+
+        const auto maxLengths = tree.maxLengthsByDepth();
+        std::vector<double> levelOffsets(maxLengths.size(), 0);
+        for (size_t depth = 1; depth < maxLengths.size(); depth++) {
+            levelOffsets.at(depth) = levelOffsets.at(depth - 1) + (maxLengths.at(depth - 1) + maxLengths.at(depth)) / 2 + m_parameters.minEdgeLength;
+        }
+
+        for (size_t node = 1; node < tree.vertices.size(); node++) {
+            m_positions.at(tree.vertices.at(node)) = { direction * levelOffsets.at(tree.depths.at(node)), tree.coordinates.at(node) - tree.coordinates.at(0) };
+        }
+    };
+
+    layOutSide(rightChildren, 1);
+    layOutSide(leftChildren, -1);
+}
+
+void TreeLayout::layOutRadial(size_t root)
+{
+    const std::vector<size_t> rootChildren(m_children.begin() + static_cast<std::ptrdiff_t>(m_childOffsets.at(root)),
+                                           m_children.begin() + static_cast<std::ptrdiff_t>(m_childOffsets.at(root + 1)));
+    auto tree = buildTree(root, rootChildren);
+    layOutTidy(tree);
+
+    m_positions.at(root) = {};
+    const auto count = tree.vertices.size();
+    if (count < 2) {
+        return;
+    }
+
+    // The breadth axis is wrapped around the root with a gap between the first and the last subtree
+    const auto gap = m_parameters.minEdgeLength * SIBLING_GAP_SCALE;
+    const auto [minCoordinate, maxCoordinate] = std::minmax_element(tree.coordinates.begin() + 1, tree.coordinates.end());
+    const auto circumference = *maxCoordinate - *minCoordinate + *std::max_element(tree.breadths.begin(), tree.breadths.end()) + gap;
+    std::vector<double> angles(count, 0);
+    for (size_t node = 1; node < count; node++) {
+        angles.at(node) = 2 * PI * (tree.coordinates.at(node) - *minCoordinate) / circumference;
+    }
+
+    // A ring is far enough from the previous one and large enough that the chords between its neighbors fit them
+    const auto requiredRadius = [](double distance, double angle) {
+        return distance / (2 * std::sin(std::min(angle, PI) / 2));
+    };
+
+    const auto maxLengths = tree.maxLengthsByDepth();
+    std::vector<double> radii(maxLengths.size(), 0);
+    for (size_t begin = 1; begin < count;) {
+        const auto depth = tree.depths.at(begin);
+        auto end = begin;
+        while (end < count && tree.depths.at(end) == depth) {
+            end++;
+        }
+
+        auto radius = radii.at(depth - 1) + (maxLengths.at(depth - 1) + maxLengths.at(depth)) / 2 + m_parameters.minEdgeLength;
+        for (size_t node = begin + 1; node < end; node++) {
+            radius = std::max(radius, requiredRadius(tree.separation(node - 1, node, gap), angles.at(node) - angles.at(node - 1)));
+        }
+        if (end - begin > 1) {
+            radius = std::max(radius, requiredRadius(tree.separation(end - 1, begin, gap), 2 * PI - angles.at(end - 1) + angles.at(begin)));
+        }
+        radii.at(depth) = radius;
+
+        for (size_t node = begin; node < end; node++) {
+            m_positions.at(tree.vertices.at(node)) = { radius * std::cos(angles.at(node)), radius * std::sin(angles.at(node)) };
+        }
+
+        begin = end;
+    }
+}
+
+QRectF TreeLayout::boundingRect(size_t treeIndex) const
+{
+    QRectF rect;
+    for (size_t i = m_treeOffsets.at(treeIndex); i < m_treeOffsets.at(treeIndex + 1); i++) {
+        const auto vertex = m_order.at(i);
+        const auto size = m_sizes.at(vertex);
+        const QRectF vertexRect { m_positions.at(vertex) - QPointF { size.width(), size.height() } / 2, size };
+        rect = i == m_treeOffsets.at(treeIndex) ? vertexRect : rect.united(vertexRect);
+    }
+    return rect;
+}
+
+void TreeLayout::translate(size_t treeIndex, QPointF offset)
+{
+    for (size_t i = m_treeOffsets.at(treeIndex); i < m_treeOffsets.at(treeIndex + 1); i++) {
+        m_positions.at(m_order.at(i)) += offset;
+    }
+}
@@ -0,0 +1,104 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TREE_LAYOUT_HPP
+#define TREE_LAYOUT_HPP
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <QPointF>
+#include <QRectF>
+#include <QSizeF>
+
+//! Tidy tree layout of Reingold–Tilford and Buchheim et al. Siblings are separated by their real sizes and
+//! the subtrees are packed as close as their contours allow. Runs in linear time apart from sorting the children.
+class TreeLayout
+{
+public:
+    enum class Style
+    {
+        //! The root is in the middle and the branches grow to the side of the root they are on now.
+        LeftRight,
+        //! The branches grow around the root on rings.
+        Radial
+    };
+
+    struct Parameters
+    {
+        Style style = Style::LeftRight;
+
+        double minEdgeLength = 0;
+
+        //! The layout is centered here.
+        QPointF center;
+    };
+
+    using EdgeVector = std::vector<std::pair<size_t, size_t>>;
+
+    //! \param positions Current centers of the vertices. They decide the order of the children.
+    //! \param edges Edges from parents to children. Edges that would close a cycle are ignored, and vertices
+    //! without incoming edges are preferred as roots. Each tree of a forest is laid out separately.
+    TreeLayout(std::vector<QPointF> positions, std::vector<QSizeF> sizes, const EdgeVector & edges, Parameters parameters);
+
+    void run();
+
+    //! \return Sum of the edge lengths measured between the centers of the vertices.
+    double cost() const;
+
+    size_t treeCount() const;
+
+    const std::vector<QPointF> & positions() const;
+
+private:
+    struct Tree;
+
+    void buildForest();
+
+    Tree buildTree(size_t root, const std::vector<size_t> & rootChildren) const;
+
+    void layOutTidy(Tree & tree) const;
+
+    //! Lays out the tree in m_positions relative to its root.
+    void layOutLeftRight(size_t root);
+
+    void layOutRadial(size_t root);
+
+    //! \return Bounding rect of the given tree including the sizes of the vertices.
+    QRectF boundingRect(size_t treeIndex) const;
+
+    void translate(size_t treeIndex, QPointF offset);
+
+    std::vector<QPointF> m_positions;
+
+    std::vector<QSizeF> m_sizes;
+
+    EdgeVector m_edges;
+
+    Parameters m_parameters;
+
+    // Vertices of the trees in breadth-first order, the first vertex of a tree is its root
+    std::vector<size_t> m_order;
+
+    std::vector<size_t> m_treeOffsets;
+
+    // Children of the spanning forest in CSR form
+    std::vector<size_t> m_childOffsets;
+
+    std::vector<size_t> m_children;
+};
+
+#endif // TREE_LAYOUT_HPP
@@ -15,70 +15,722 @@
 
 #include "undo_stack.hpp"
 
+#include "../common/trace_recorder.hpp"
+#include "../infra/io/undo_journal.hpp"
+#include "graph_snapshot.hpp"
 #include "mind_map_data.hpp"
 
-UndoStack::UndoStack(size_t maxHistorySize)
-  : m_maxHistorySize(maxHistorySize)
+#include "simple_logger.hpp"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+
+#include <algorithm>
+#include <list>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+static const auto TAG = "UndoStack";
+
+namespace {
+
+//! Thrown when a record of the journal cannot be read. The whole journal is lost then, as the newer records build on the older ones.
+class CorruptedJournal : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+//! \returns Hash of the graph and the style of the given mind map that stays the same when it's saved and opened again.
+QByteArray stateHash(MindMapDataCR mindMapData)
+{
+    const auto graph = mindMapData.graphSnapshot().densified();
+    auto edges = graph.edges();
+    std::sort(edges.begin(), edges.end(), [](auto && edge0, auto && edge1) {
+        return std::make_pair(edge0.sourceIndex, edge0.targetIndex) < std::make_pair(edge1.sourceIndex, edge1.targetIndex);
+    });
+
+    QCryptographicHash hash { QCryptographicHash::Sha1 };
+    hash.addData(mindMapData.styleData());
+    hash.addData(GraphSnapshot { graph.nodes(), edges }.toCompressedData());
+    return hash.result();
+}
+
+} // namespace
+
+class UndoStack::History
+{
+public:
+    History(size_t maxSize, size_t keyframeInterval)
+      : m_maxSize(maxSize)
+      , m_keyframeInterval(keyframeInterval)
+    {
+    }
+
+    void push(MindMapDataCR mindMapData)
+    {
+        push(std::make_unique<MindMapData>(mindMapData));
+    }
+
+    //! \param delta The delta from the newest entry to the given mind map, if known, so that the graphs don't need to be diffed.
+    void push(MindMapDataU mindMapData, std::optional<GraphSnapshot::Delta> delta = {})
+    {
+        Entry entry { std::move(mindMapData), {}, {}, 0, true, {}, false };
+        auto graph = entry.mindMapData->graphSnapshot();
+        if (!m_entries.empty() && deltasSinceKeyframe() + 1 < m_keyframeInterval) {
+            entry.delta = delta ? std::move(*delta) : GraphSnapshot::diff(m_newestGraph, graph);
+            entry.mindMapData->setGraphSnapshot({});
+            entry.estimatedSize = entry.delta->estimatedSize();
+            entry.isKeyframe = false;
+        } else {
+            entry.estimatedSize = graph.estimatedSize();
+        }
+
+        if (m_journal) {
+            m_pageTemplate = std::make_unique<MindMapData>(*entry.mindMapData, GraphSnapshot {});
+            if (m_journal->push(createRecord(entry, &graph))) {
+                entry.journalIndex = m_journal->recordCount() - 1;
+            }
+        }
+
+        m_newestGraph = std::move(graph);
+        m_entries.push_back(std::move(entry));
+
+        if (m_journal && !m_entries.back().journalIndex) {
+            detachJournal();
+        }
+
+        removeOldestEntries();
+
+        pageOutOldEntries();
+
+        enforceMemoryBudget();
+    }
+
+    //! \param reverseDelta Receives the delta from the returned entry to the new newest entry, if the returned entry has a delta.
+    MindMapDataU pop(std::optional<GraphSnapshot::Delta> * reverseDelta = nullptr)
+    {
+        if (m_entries.empty()) {
+            return {};
+        }
+
+        pageIn(m_entries.back());
+        auto entry = std::move(m_entries.back());
+        m_entries.pop_back();
+
+        auto graph = std::move(m_newestGraph);
+        if (m_entries.empty()) {
+            m_newestGraph = {};
+        } else if (!entry.isKeyframe) {
+            m_newestGraph = graph;
+            m_newestGraph.apply(*entry.delta, true);
+            if (reverseDelta) {
+                entry.delta->reverse();
+                *reverseDelta = std::move(entry.delta);
+            }
+        } else {
+            m_newestGraph = rebuildNewestGraph();
+        }
+
+        // The records of the removed oldest entries go when the history becomes empty. The oldest entry also loses
+        // its record when it's turned into a keyframe, but then it's the only one left to pop.
+        if (m_journal) {
+            const auto recordCount = m_entries.empty() || !entry.journalIndex ? 0 : *entry.journalIndex;
+            if (m_journal->truncate(recordCount)) {
+                m_droppedRecordCount = std::min(m_droppedRecordCount, recordCount);
+            } else {
+                detachJournal();
+            }
+        }
+
+        pageOutOldEntries();
+
+        entry.mindMapData->setGraphSnapshot(std::move(graph));
+        return std::move(entry.mindMapData);
+    }
+
+    //! Pops the given number of entries and returns the oldest of them. The others are pushed to the given history
+    //! newest first as if popped and pushed one by one, but with their deltas reversed instead of diffing the graphs.
+    MindMapDataU pop(size_t count, History & skipped)
+    {
+        std::optional<GraphSnapshot::Delta> delta;
+        for (size_t index = 1; index < count && m_entries.size() > 1; index++) {
+            std::optional<GraphSnapshot::Delta> reverseDelta;
+            auto mindMapData = pop(&reverseDelta);
+            skipped.push(std::move(mindMapData), std::move(delta));
+            delta = std::move(reverseDelta);
+        }
+        return pop();
+    }
+
+    void clear()
+    {
+        m_entries.clear();
+        m_newestGraph = {};
+        m_journal.reset();
+        m_pageTemplate.reset();
+        m_droppedRecordCount = 0;
+    }
+
+    bool empty() const
+    {
+        return m_entries.empty();
+    }
+
+    size_t size() const
+    {
+        return m_entries.size();
+    }
+
+    MemoryUsage memoryUsage() const
+    {
+        return { m_entries.size(), estimatedSize() };
+    }
+
+    void setMemoryBudget(size_t bytes)
+    {
+        m_memoryBudget = bytes;
+
+        enforceMemoryBudget();
+    }
+
+    bool openJournal(QString path, MindMapDataCR mindMapData)
+    {
+        clear();
+
+        // A journal that cannot be read, e.g. one of an older version, is replaced
+        auto journal = std::make_unique<IO::UndoJournal>();
+        if (!journal->open(path) && !journal->create(path, {})) {
+            return false;
+        }
+
+        m_journal = std::move(journal);
+        m_pageTemplate = std::make_unique<MindMapData>(mindMapData, GraphSnapshot {});
+
+        // Only the kind of each record is read here, the records themselves are paged in when undo reaches them
+        for (size_t index = 0; index < m_journal->recordCount(); index++) {
+            const bool isKeyframe = m_journal->record(index, 1) != QByteArray(1, '\0');
+            if (m_entries.empty() && !isKeyframe) {
+                juzzlin::L(TAG).warning() << "Undo journal doesn't start with a keyframe";
+                m_journal->truncate(0);
+                break;
+            }
+            m_entries.push_back({ nullptr, {}, {}, 0, isKeyframe, index, true });
+        }
+
+        const auto state = stateHash(mindMapData);
+        try {
+            if (!m_entries.empty()) {
+                m_newestGraph = rebuildNewestGraph();
+
+                // The history is kept only if it leads to the opened state. A session that ended without saving has
+                // left behind the undo points after the saved state, which are dropped, and if the file has been
+                // changed elsewhere, none of the history applies to it.
+                if (m_journal->stateHash() != state) {
+                    const auto entryCount = findEntry(mindMapData);
+                    if (!entryCount) {
+                        juzzlin::L(TAG).warning() << "Undo journal '" << path.toStdString() << "' doesn't belong to the opened mind map";
+                    }
+                    truncate(entryCount.value_or(0));
+                }
+            }
+
+            setJournalState(mindMapData);
+
+            removeOldestEntries();
+
+            pageOutOldEntries();
+        } catch (const CorruptedJournal & e) {
+            juzzlin::L(TAG).error() << e.what();
+            discardJournal();
+            setJournalState(mindMapData);
+        }
+
+        juzzlin::L(TAG).debug() << "Undo history of " << m_entries.size() << " entries opened from '" << path.toStdString() << "'";
+
+        return true;
+    }
+
+    void setJournalState(MindMapDataCR mindMapData)
+    {
+        if (m_journal && !m_journal->setStateHash(stateHash(mindMapData))) {
+            detachJournal();
+        }
+    }
+
+    //! Forgets the history and empties the journal, e.g. if a record of it is corrupted.
+    void discardJournal()
+    {
+        juzzlin::L(TAG).warning() << "Discarding the undo history of '" << journalPath().toStdString() << "'";
+        auto journal = std::move(m_journal);
+        clear();
+        if (journal && journal->truncate(0)) {
+            m_journal = std::move(journal);
+        }
+    }
+
+    QString journalPath() const
+    {
+        return m_journal ? m_journal->path() : QString {};
+    }
+
+    bool saveJournal(QString path)
+    {
+        std::vector<QByteArray> records;
+        for (auto && entry : m_entries) {
+            records.push_back(createRecord(entry));
+        }
+
+        // The previous journal may be the same file, so it's closed by create() before writing
+        const auto previousPath = m_journal ? m_journal->path() : QString {};
+        auto journal = m_journal ? std::move(m_journal) : std::make_unique<IO::UndoJournal>();
+        if (!journal->create(path, records)) {
+            if (!previousPath.isEmpty()) {
+                if (journal->open(previousPath)) {
+                    m_journal = std::move(journal);
+                } else {
+                    juzzlin::L(TAG).error() << "Cannot reopen undo journal, the undo history is lost";
+                    clear();
+                }
+            }
+            return false;
+        }
+
+        m_journal = std::move(journal);
+        m_droppedRecordCount = 0;
+        size_t index = 0;
+        for (auto && entry : m_entries) {
+            entry.journalIndex = index++;
+        }
+
+        if (!m_entries.empty() && !m_pageTemplate) {
+            m_pageTemplate = std::make_unique<MindMapData>(*m_entries.back().mindMapData, GraphSnapshot {});
+        }
+
+        pageOutOldEntries();
+
+        return true;
+    }
+
+private:
+    struct Entry
+    {
+        MindMapDataU mindMapData;
+
+        // Delta against the previous entry, or empty for keyframes that store the whole graph
+        std::optional<GraphSnapshot::Delta> delta;
+
+        // Graph of a cold keyframe, which doesn't store the graph in mindMapData
+        QByteArray compressedGraph;
+
+        size_t estimatedSize;
+
+        bool isKeyframe;
+
+        // Index of the record of the entry in the journal, if any
+        std::optional<size_t> journalIndex;
+
+        // Only the journal has the data of a paged out entry
+        bool isPagedOut;
+    };
+
+    size_t deltasSinceKeyframe() const
+    {
+        size_t count = 0;
+        for (auto iter = m_entries.rbegin(); iter != m_entries.rend() && !iter->isKeyframe; iter++) {
+            count++;
+        }
+        return count;
+    }
+
+    GraphSnapshot rebuildNewestGraph()
+    {
+        return rebuildGraph(std::prev(m_entries.end()));
+    }
+
+    //! \returns The graph of the given entry, applying the deltas from the keyframe before it.
+    GraphSnapshot rebuildGraph(std::list<Entry>::iterator entry)
+    {
+        auto keyframe = std::next(entry);
+        do {
+            keyframe--;
+        } while (!keyframe->isKeyframe);
+
+        auto graph = keyframeGraph(*keyframe);
+        for (auto iter = std::next(keyframe); iter != std::next(entry); iter++) {
+            pageIn(*iter);
+            graph.apply(*iter->delta);
+        }
+        return graph;
+    }
+
+    //! \returns The number of entries before the newest entry that has the state of the given mind map, if any.
+    //! The file has dense indices, so the states are compared as saved.
+    std::optional<size_t> findEntry(MindMapDataCR mindMapData)
+    {
+        const auto target = mindMapData.graphSnapshot().densified();
+        auto graph = m_newestGraph;
+        auto entryCount = m_entries.size();
+        for (auto iter = std::prev(m_entries.end());; iter--) {
+            entryCount--;
+            pageIn(*iter);
+            // The counts rule out most of the entries without diffing the graphs
+            if (graph.nodes().size() == target.nodes().size() && graph.edges().size() == target.edges().size()
+                && iter->mindMapData->sharesStyleWith(mindMapData) && GraphSnapshot::diff(graph.densified(), target).isEmpty()) {
+                return entryCount;
+            }
+            if (iter == m_entries.begin()) {
+                return {};
+            }
+            if (iter->isKeyframe) {
+                graph = rebuildGraph(std::prev(iter));
+            } else {
+                graph.apply(*iter->delta, true);
+            }
+        }
+    }
+
+    //! Removes the newest entries so that the given number of entries is left.
+    void truncate(size_t entryCount)
+    {
+        m_entries.resize(entryCount);
+        m_newestGraph = m_entries.empty() ? GraphSnapshot {} : rebuildNewestGraph();
+        if (m_journal && !m_journal->truncate(entryCount)) {
+            detachJournal();
+        }
+    }
+
+    void removeOldestEntries()
+    {
+        // The oldest entry is always a keyframe, so turn the next one into a keyframe before removal
+        while (m_maxSize && m_entries.size() > m_maxSize) {
+            auto graph = keyframeGraph(m_entries.front());
+            m_entries.pop_front();
+            m_droppedRecordCount++;
+            if (!m_entries.empty() && !m_entries.front().isKeyframe) {
+                auto && front = m_entries.front();
+                pageIn(front);
+                graph.apply(*front.delta);
+                front.estimatedSize = graph.estimatedSize();
+                front.mindMapData->setGraphSnapshot(std::move(graph));
+                front.delta.reset();
+                front.isKeyframe = true;
+                // Its record is still a delta, so it stays in memory until the journal is compacted
+                front.journalIndex.reset();
+            }
+        }
+
+        // The records of the removed entries are dropped once they'd make up half of the journal
+        if (m_journal && m_droppedRecordCount && m_droppedRecordCount >= m_entries.size()) {
+            juzzlin::L(TAG).debug() << "Compacting undo journal";
+            if (!saveJournal(m_journal->path())) {
+                detachJournal();
+            }
+        }
+    }
+
+    size_t estimatedSize() const
+    {
+        size_t size = m_newestGraph.estimatedSize();
+        for (auto && entry : m_entries) {
+            size += entry.estimatedSize;
+        }
+        return size;
+    }
+
+    GraphSnapshot keyframeGraph(Entry & entry)
+    {
+        pageIn(entry);
+        return entry.compressedGraph.isEmpty() ? entry.mindMapData->graphSnapshot() : GraphSnapshot::fromCompressedData(entry.compressedGraph);
+    }
+
+    //! \param graph The full graph of the entry if it's at hand, as a keyframe doesn't store its graph when it's hot.
+    QByteArray createRecord(Entry & entry, const GraphSnapshot * graph = nullptr)
+    {
+        if (entry.isPagedOut) {
+            return m_journal->record(*entry.journalIndex);
+        }
+
+        QByteArray record;
+        QDataStream out(&record, QIODevice::WriteOnly);
+        out << entry.isKeyframe << entry.mindMapData->styleData();
+        if (entry.isKeyframe) {
+            if (!entry.compressedGraph.isEmpty()) {
+                out << entry.compressedGraph;
+            } else {
+                out << (graph ? graph->toCompressedData() : entry.mindMapData->graphSnapshot().toCompressedData());
+            }
+        } else {
+            QByteArray deltaData;
+            QDataStream deltaOut(&deltaData, QIODevice::WriteOnly);
+            entry.delta->write(deltaOut);
+            out << qCompress(deltaData);
+        }
+        return record;
+    }
+
+    void pageIn(Entry & entry)
+    {
+        if (!entry.isPagedOut) {
+            return;
+        }
+
+        const auto record = m_journal->record(*entry.journalIndex);
+        QDataStream in(record);
+        bool isKeyframe = false;
+        QByteArray styleData;
+        QByteArray graphData;
+        in >> isKeyframe >> styleData >> graphData;
+        if (in.status() != QDataStream::Ok || isKeyframe != entry.isKeyframe) {
+            throw CorruptedJournal { "Corrupted undo journal record " + std::to_string(*entry.journalIndex) };
+        }
+
+        // The images and everything else but the graph and the style come from the newest undo point
+        entry.mindMapData = std::make_unique<MindMapData>(*m_pageTemplate);
+        entry.mindMapData->applyStyleData(styleData);
+        if (entry.isKeyframe) {
+            entry.compressedGraph = graphData;
+            entry.estimatedSize = static_cast<size_t>(graphData.size());
+        } else {
+            const auto deltaData = qUncompress(graphData);
+            QDataStream deltaIn(deltaData);
+            entry.delta = GraphSnapshot::Delta::read(deltaIn);
+            if (deltaIn.status() != QDataStream::Ok) {
+                throw CorruptedJournal { "Corrupted undo journal record " + std::to_string(*entry.journalIndex) };
+            }
+            entry.estimatedSize = entry.delta->estimatedSize();
+        }
+        entry.isPagedOut = false;
+    }
+
+    //! Drops the data of all but the newest entries from memory, as the journal has it.
+    void pageOutOldEntries()
+    {
+        if (!m_journal) {
+            return;
+        }
+
+        const auto hotEntryCount = std::max<size_t>(m_keyframeInterval, 1);
+        auto iter = m_entries.begin();
+        for (size_t index = 0; index + hotEntryCount < m_entries.size(); index++, iter++) {
+            if (!iter->isPagedOut && iter->journalIndex) {
+                iter->mindMapData.reset();
+                iter->delta.reset();
+                iter->compressedGraph.clear();
+                iter->estimatedSize = 0;
+                iter->isPagedOut = true;
+            }
+        }
+    }
+
+    //! Keeps the history in memory only, e.g. if writing the journal fails.
+    void detachJournal()
+    {
+        juzzlin::L(TAG).warning() << "Undo journal disabled";
+        for (auto && entry : m_entries) {
+            pageIn(entry);
+            entry.journalIndex.reset();
+        }
+        m_journal.reset();
+        m_droppedRecordCount = 0;
+    }
+
+    void enforceMemoryBudget()
+    {
+        if (m_memoryBudget) {
+            compressKeyframes(m_memoryBudget);
+        }
+    }
+
+    //! \return The estimated bytes given back.
+    size_t compressKeyframes(size_t bytes)
+    {
+        const auto sizeBefore = estimatedSize();
+        auto totalSize = sizeBefore;
+
+        // Compress hot keyframes starting from the oldest one
+        for (auto && entry : m_entries) {
+            if (totalSize <= bytes) {
+                break;
+            }
+            if (entry.isKeyframe && !entry.isPagedOut && entry.compressedGraph.isEmpty()) {
+                const auto hotSize = entry.estimatedSize;
+                entry.compressedGraph = entry.mindMapData->graphSnapshot().toCompressedData();
+                entry.mindMapData->setGraphSnapshot({});
+                entry.estimatedSize = static_cast<size_t>(entry.compressedGraph.size());
+                totalSize = totalSize - hotSize + entry.estimatedSize;
+                juzzlin::L(TAG).debug() << "Compressed undo keyframe: " << hotSize << " => " << entry.estimatedSize << " bytes";
+            }
+        }
+
+        return sizeBefore - std::min(sizeBefore, totalSize);
+    }
+
+    std::list<Entry> m_entries;
+
+    // Full graph of the newest entry so that new deltas can be calculated
+    GraphSnapshot m_newestGraph;
+
+    size_t m_maxSize;
+
+    size_t m_keyframeInterval;
+
+    size_t m_memoryBudget = 0;
+
+    std::unique_ptr<IO::UndoJournal> m_journal;
+
+    // Everything but the graph and the style of the newest undo point, for the entries paged in from the journal
+    MindMapDataU m_pageTemplate;
+
+    // Records of the entries removed from the front that are still in the journal
+    size_t m_droppedRecordCount = 0;
+};
+
+void UndoStack::setMemoryBudget(size_t bytes)
+{
+    m_undoStack->setMemoryBudget(bytes);
+    m_redoStack->setMemoryBudget(bytes);
+}
+
+size_t UndoStack::trim(size_t bytes)
+{
+    return m_undoStack->compressKeyframes(bytes) + m_redoStack->compressKeyframes(bytes);
+}
+
+UndoStack::UndoStack(size_t maxHistorySize, size_t keyframeInterval)
+  : m_undoStack(std::make_unique<History>(maxHistorySize, keyframeInterval))
+  , m_redoStack(std::make_unique<History>(maxHistorySize, keyframeInterval))
 {
 }
 
 void UndoStack::pushUndoPoint(MindMapDataCR mindMapData)
 {
-    m_undoStack.push_back(std::make_unique<MindMapData>(mindMapData));
+    const TraceRecorder::ScopedSpan span { "UndoStack::pushUndoPoint" };
 
-    if (m_undoStack.size() > m_maxHistorySize && m_maxHistorySize) {
-        m_undoStack.pop_front();
+    try {
+        m_undoStack->push(mindMapData);
+    } catch (const CorruptedJournal & e) {
+        discardJournal(e.what());
     }
 }
 
 void UndoStack::pushRedoPoint(MindMapDataCR mindMapData)
 {
-    m_redoStack.push_back(std::make_unique<MindMapData>(mindMapData));
+    const TraceRecorder::ScopedSpan span { "UndoStack::pushRedoPoint" };
+
+    m_redoStack->push(mindMapData);
+}
+
+bool UndoStack::openJournal(QString path, MindMapDataCR mindMapData)
+{
+    m_redoStack->clear();
+    return m_undoStack->openJournal(path, mindMapData);
+}
+
+bool UndoStack::saveJournal(QString path)
+{
+    return m_undoStack->saveJournal(path);
+}
 
-    if (m_redoStack.size() > m_maxHistorySize && m_maxHistorySize) {
-        m_redoStack.pop_front();
+void UndoStack::setJournalState(MindMapDataCR mindMapData)
+{
+    try {
+        m_undoStack->setJournalState(mindMapData);
+    } catch (const CorruptedJournal & e) {
+        discardJournal(e.what());
     }
 }
 
+QString UndoStack::journalPath() const
+{
+    return m_undoStack->journalPath();
+}
+
 void UndoStack::clear()
 {
-    m_undoStack.clear();
-    m_redoStack.clear();
+    m_undoStack->clear();
+    m_redoStack->clear();
 }
 
 void UndoStack::clearRedoStack()
 {
-    m_redoStack.clear();
+    m_redoStack->clear();
 }
 
 bool UndoStack::isUndoable() const
 {
-    return !m_undoStack.empty();
+    return !m_undoStack->empty();
+}
+
+size_t UndoStack::undoCount() const
+{
+    return m_undoStack->size();
 }
 
-MindMapDataU UndoStack::undo()
+MindMapDataU UndoStack::undo(size_t steps)
 {
-    if (isUndoable()) {
-        auto head = std::move(m_undoStack.back());
-        m_undoStack.pop_back();
-        return head;
+    const TraceRecorder::ScopedSpan span { "UndoStack::undo" };
+
+    MindMapDataU head;
+    try {
+        head = m_undoStack->pop(steps, *m_redoStack);
+    } catch (const CorruptedJournal & e) {
+        discardJournal(e.what());
     }
 
-    return {};
+    if (head) {
+        // Materialize the graph snapshot in the calling (GUI) thread before anybody else accesses it
+        head->graph();
+    }
+    return head;
 }
 
 bool UndoStack::isRedoable() const
 {
-    return !m_redoStack.empty();
+    return !m_redoStack->empty();
+}
+
+size_t UndoStack::redoCount() const
+{
+    return m_redoStack->size();
 }
 
-MindMapDataU UndoStack::redo()
+MindMapDataU UndoStack::redo(size_t steps)
 {
-    if (isRedoable()) {
-        auto head = std::move(m_redoStack.back());
-        m_redoStack.pop_back();
-        return head;
+    const TraceRecorder::ScopedSpan span { "UndoStack::redo" };
+
+    MindMapDataU head;
+    try {
+        head = m_redoStack->pop(steps, *m_undoStack);
+    } catch (const CorruptedJournal & e) {
+        discardJournal(e.what());
+    }
+
+    if (head) {
+        // Materialize the graph snapshot in the calling (GUI) thread before anybody else accesses it
+        head->graph();
     }
+    return head;
+}
+
+MemoryUsage UndoStack::undoMemoryUsage() const
+{
+    return m_undoStack->memoryUsage();
+}
+
+MemoryUsage UndoStack::redoMemoryUsage() const
+{
+    return m_redoStack->memoryUsage();
+}
 
-    return {};
+void UndoStack::discardJournal(const char * reason)
+{
+    juzzlin::L(TAG).error() << reason;
+
+    // The redo points are lost as well, as the undo points that they were taken from have been popped already
+    m_undoStack->discardJournal();
+    m_redoStack->clear();
 }
+
+UndoStack::~UndoStack() = default;
@@ -17,39 +17,100 @@
 #define UNDO_STACK_HPP
 
 #include "../common/types.hpp"
+#include "memory_usage.hpp"
 
-#include <list>
+#include <QString>
 
+#include <memory>
+
+//! Undo/redo history. Only every Nth undo point (a keyframe) stores the full graph, the others
+//! store a delta against the previous point so that the memory scales with the size of the edits.
+//! The undo history can optionally be kept in a journal file, see IO::UndoJournal. Then only the
+//! newest undo points stay in memory and the history survives restarts and crashes.
 class UndoStack
 {
 public:
     //! \param maxHistorySize The size of undo stack or 0 for "unlimited".
-    UndoStack(size_t maxHistorySize = 0);
+    //! \param keyframeInterval Interval of full graph keyframes. 0 or 1 stores only keyframes.
+    UndoStack(size_t maxHistorySize = 0, size_t keyframeInterval = 20);
+
+    ~UndoStack();
+
+    //! Sets the memory budget of the history. When the budget is exceeded, the oldest keyframes
+    //! get compressed and are inflated only when undo actually reaches them.
+    //! \param bytes Budget per stack (undo, redo) in bytes or 0 for "unlimited".
+    void setMemoryBudget(size_t bytes);
+
+    //! Compresses the oldest keyframes until each stack is within the given bytes, e.g. when memory runs low.
+    //! Unlike the budget, this doesn't affect the undo points pushed later.
+    //! \return The estimated bytes given back.
+    size_t trim(size_t bytes);
+
+    //! Replaces the history with the undo history in the given journal, which is created if it doesn't exist.
+    //! The undo history is kept in the journal from then on. The history is discarded if it doesn't lead to the state
+    //! of the given mind map, e.g. if the file has been changed elsewhere, or if the journal is corrupted.
+    //! \param mindMapData The current mind map. Its images are used for the undo points read from the journal.
+    //! \return false if the journal cannot be opened, in which case the history is just cleared.
+    bool openJournal(QString path, MindMapDataCR mindMapData);
+
+    //! \returns Path of the journal in use or an empty string.
+    QString journalPath() const;
+
+    //! Writes the current undo history to the given journal and keeps it there from then on, e.g. after "save as".
+    //! \return false if the journal cannot be written.
+    bool saveJournal(QString path);
+
+    //! Marks the given mind map as the state that the undo history in the journal leads to, e.g. when the mind map
+    //! is closed. openJournal() keeps the history only for this state or for one of its undo points, which
+    //! is then the newest undo point that is kept.
+    void setJournalState(MindMapDataCR mindMapData);
 
     void pushUndoPoint(MindMapDataCR mindMapData);
 
     void pushRedoPoint(MindMapDataCR mindMapData);
 
+    //! Clears the history in memory and stops using the journal, if any. The journal file is left as it is.
     void clear();
 
     void clearRedoStack();
 
     bool isUndoable() const;
 
-    MindMapDataU undo();
+    //! \returns The number of undo points.
+    size_t undoCount() const;
+
+    //! Goes the given number of undo points back at once. The skipped undo points become redo points like on
+    //! undo step by step, but their deltas are just reversed instead of diffing the graphs, and only the graph
+    //! of the returned undo point is rebuilt, from its nearest keyframe. The redo point of the current state
+    //! must have been pushed before.
+    //! \param steps The number of undo points to go back, at most undoCount().
+    //! \returns nullptr if the history was discarded, because a record of the journal was corrupted.
+    MindMapDataU undo(size_t steps = 1);
 
     bool isRedoable() const;
 
-    MindMapDataU redo();
+    //! \returns The number of redo points.
+    size_t redoCount() const;
+
+    //! Goes the given number of redo points forward at once like undo(size_t) goes back.
+    //! The undo point of the current state must have been pushed before.
+    //! \returns nullptr if the history was discarded, see undo(size_t).
+    MindMapDataU redo(size_t steps = 1);
+
+    //! \returns Entry count and estimated memory usage of the undo history.
+    MemoryUsage undoMemoryUsage() const;
+
+    //! \returns Entry count and estimated memory usage of the redo history.
+    MemoryUsage redoMemoryUsage() const;
 
 private:
-    using MindMapDataVector = std::list<MindMapDataU>;
+    class History;
 
-    MindMapDataVector m_undoStack;
+    void discardJournal(const char * reason);
 
-    MindMapDataVector m_redoStack;
+    std::unique_ptr<History> m_undoStack;
 
-    size_t m_maxHistorySize;
+    std::unique_ptr<History> m_redoStack;
 };
 
 #endif // UNDO_STACK_HPP
@@ -13,20 +13,66 @@
 // You should have received a copy of the GNU General Public License
 // along with Heimer. If not, see <http://www.gnu.org/licenses/>.
 
+#ifndef EXPORT_PARAMS_HPP
+#define EXPORT_PARAMS_HPP
+
+#include <QPageLayout>
 #include <QSize>
+#include <QSizeF>
 #include <QString>
 
+#include <algorithm>
+#include <cmath>
+
 struct ExportParams
 {
-    ExportParams(QString fileName)
+    //! Part of the mind map to export.
+    enum class Region
+    {
+        //! The whole mind map.
+        MindMap,
+        //! The area currently shown in the editor.
+        View,
+        //! The selected nodes, e.g. selected with a rubber band.
+        SelectedNodes
+    };
+
+    //! Encoding of an exported image.
+    enum class ImageFormat
+    {
+        Png,
+        Jpeg,
+        WebP
+    };
+
+    //! \returns The file extension including the dot, e.g. ".png".
+    static QString fileExtension(ImageFormat imageFormat)
+    {
+        switch (imageFormat) {
+        case ImageFormat::Jpeg:
+            return ".jpg";
+        case ImageFormat::WebP:
+            return ".webp";
+        case ImageFormat::Png:
+            break;
+        }
+        return ".png";
+    }
+
+    //! Resolution of the PDF painter, so that a scene unit is a CSS pixel at the page scale 1.0.
+    static constexpr int pdfResolution = 96;
+
+    ExportParams(QString fileName, Region region = Region::MindMap)
       : fileName(fileName)
+      , region(region)
     {
     }
 
-    ExportParams(QString fileName, QSize imageSize, bool transparentBackground)
+    ExportParams(QString fileName, QSize imageSize, bool transparentBackground, Region region = Region::MindMap)
       : fileName(fileName)
       , imageSize(imageSize)
       , transparentBackground(transparentBackground)
+      , region(region)
     {
     }
 
@@ -35,4 +81,38 @@ struct ExportParams
     QSize imageSize;
 
     bool transparentBackground = false;
+
+    Region region = Region::MindMap;
+
+    ImageFormat imageFormat = ImageFormat::Png;
+
+    //! Deflate level of a PNG from 0 (fastest) to 9 (smallest). 6 is the zlib default.
+    int compressionLevel = 6;
+
+    //! Quality of a JPEG or WebP from 0 to 100.
+    int quality = 90;
+
+    //! Page size, orientation and margins of a PDF.
+    QPageLayout pageLayout { QPageSize(QPageSize::A4), QPageLayout::Portrait, QMarginsF(10, 10, 10, 10), QPageLayout::Millimeter };
+
+    //! Scale of a PDF. The mind map is split into as many pages as it takes at this scale.
+    double pageScale = 1.0;
+
+    //! \returns The part of the scene that fits on one PDF page.
+    QSizeF pageSceneSize() const
+    {
+        return QSizeF(pageLayout.paintRectPixels(pdfResolution).size()) / pageScale;
+    }
+
+    //! \returns The number of page columns and rows needed for a PDF of a scene area of the given size.
+    QSize pageGrid(QSizeF sceneSize) const
+    {
+        // Rounding errors shouldn't add a page for a sliver of the scene
+        const double epsilon = 1e-6;
+        const auto pageSize = pageSceneSize();
+        return { std::max(1, static_cast<int>(std::ceil(sceneSize.width() / pageSize.width() - epsilon))), //
+                 std::max(1, static_cast<int>(std::ceil(sceneSize.height() / pageSize.height() - epsilon))) };
+    }
 };
+
+#endif // EXPORT_PARAMS_HPP
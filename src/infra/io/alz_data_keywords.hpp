@@ -0,0 +1,224 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ALZ_DATA_KEYWORDS_HPP
+#define ALZ_DATA_KEYWORDS_HPP
+
+namespace IO {
+
+// Element and attribute names of the ALZ-format shared by the readers and writers
+namespace DataKeywords::MindMap {
+
+const auto ATTRIBUTE_APPLICATION_VERSION = "version";
+
+namespace V2 {
+
+const auto ATTRIBUTE_APPLICATION_VERSION = "application-version";
+
+const auto ATTRIBUTE_ALZ_FORMAT_VERSION = "alz-format-version";
+
+namespace Metadata {
+
+const auto ELEMENT_METADATA = "metadata";
+
+// Written before anything else, so that it can be read without parsing the rest of the file
+const auto ELEMENT_HEADER = "header";
+
+namespace Header {
+
+const auto ATTRIBUTE_NODE_COUNT = "node-count";
+
+const auto ATTRIBUTE_EDGE_COUNT = "edge-count";
+
+const auto ATTRIBUTE_X = "x";
+
+const auto ATTRIBUTE_Y = "y";
+
+const auto ATTRIBUTE_W = "w";
+
+const auto ATTRIBUTE_H = "h";
+
+const auto ELEMENT_THUMBNAIL = "thumbnail";
+
+} // namespace Header
+
+} // namespace Metadata
+
+namespace Style {
+
+const auto ELEMENT_STYLE = "style";
+
+} // namespace Style
+
+} // namespace V2
+
+const auto ELEMENT_ARROW_SIZE = "arrow-size";
+
+const auto ELEMENT_COLOR = "color";
+
+const auto ELEMENT_CORNER_RADIUS = "corner-radius";
+
+const auto ELEMENT_EDGE_COLOR = "edge-color";
+
+const auto ELEMENT_EDGE_THICKNESS = "edge-width";
+
+const auto ELEMENT_FONT_FAMILY = "font-family";
+
+const auto ATTRIBUTE_FONT_BOLD = "bold";
+
+const auto ATTRIBUTE_FONT_OVERLINE = "overline";
+
+const auto ATTRIBUTE_FONT_STRIKE_OUT = "strike-out";
+
+const auto ATTRIBUTE_FONT_UNDERLINE = "underline";
+
+const auto ATTRIBUTE_FONT_WEIGHT = "weight";
+
+const auto ATTRIBUTE_FONT_ITALIC = "italic";
+
+const auto ELEMENT_GRAPH = "graph";
+
+const auto ELEMENT_GRID_COLOR = "grid-color";
+
+const auto ELEMENT_HEIMER_MIND_MAP = "heimer-mind-map";
+
+const auto ELEMENT_IMAGE = "image";
+
+const auto ELEMENT_TEXT_SIZE = "text-size";
+
+// Used for Design and Node
+namespace Color {
+
+const auto ATTRIBUTE_R = "r";
+
+const auto ATTRIBUTE_G = "g";
+
+const auto ATTRIBUTE_B = "b";
+} // namespace Color
+
+namespace Graph {
+
+const auto ELEMENT_NODE = "node";
+
+namespace Node {
+
+const auto ELEMENT_TEXT = "text";
+
+const auto ATTRIBUTE_COLLAPSED = "collapsed";
+
+const auto ATTRIBUTE_COLOR = "color";
+
+const auto ATTRIBUTE_IMAGE = "image";
+
+const auto ATTRIBUTE_INDEX = "index";
+
+const auto ATTRIBUTE_TEXT_COLOR = "text-color";
+
+const auto ATTRIBUTE_UUID = "uuid";
+
+const auto ATTRIBUTE_X = "x";
+
+const auto ATTRIBUTE_Y = "y";
+
+const auto ATTRIBUTE_W = "w";
+
+const auto ATTRIBUTE_H = "h";
+
+namespace Image {
+
+const auto ATTRIBUTE_REF = "ref";
+} // namespace Image
+
+namespace V2 {
+
+const auto ATTRIBUTE_INDEX = "i";
+}
+
+} // namespace Node
+
+const auto ELEMENT_EDGE = "edge";
+
+namespace Edge {
+
+const auto ATTRIBUTE_ARROW_MODE = "arrow-mode";
+
+const auto ATTRIBUTE_DASHED_LINE = "dashed-line";
+
+const auto ATTRIBUTE_INDEX0 = "index0";
+
+const auto ATTRIBUTE_INDEX1 = "index1";
+
+const auto ATTRIBUTE_REVERSED = "reversed";
+
+namespace V2 {
+
+const auto ATTRIBUTE_INDEX0 = "i0";
+
+const auto ATTRIBUTE_INDEX1 = "i1";
+
+} // namespace V2
+
+} // namespace Edge
+} // namespace Graph
+
+namespace Image {
+
+const auto ATTRIBUTE_ID = "id";
+
+const auto ATTRIBUTE_PATH = "path";
+
+} // namespace Image
+
+// Note!!: Moved into metadata element in V2
+namespace LayoutOptimizer {
+
+const auto ELEMENT_LAYOUT_OPTIMIZER = "layout-optimizer";
+
+const auto ATTRIBUTE_ASPECT_RATIO = "aspect-ratio";
+
+const auto ATTRIBUTE_MIN_EDGE_LENGTH = "min-edge-length";
+
+// Only in V2
+const auto ELEMENT_CACHED_LAYOUT = "cached-layout";
+
+namespace CachedLayout {
+
+const auto ATTRIBUTE_KEY = "key";
+
+const auto ATTRIBUTE_TOPOLOGY_KEY = "topology-key";
+
+const auto ELEMENT_NODE = "n";
+
+namespace Node {
+
+const auto ATTRIBUTE_INDEX = "i";
+
+const auto ATTRIBUTE_X = "x";
+
+const auto ATTRIBUTE_Y = "y";
+
+} // namespace Node
+
+} // namespace CachedLayout
+
+} // namespace LayoutOptimizer
+
+} // namespace DataKeywords::MindMap
+
+const double SCALE = 1000; // https://bugreports.qt.io/browse/QTBUG-67129
+
+} // namespace IO
+
+#endif // ALZ_DATA_KEYWORDS_HPP
@@ -17,6 +17,7 @@
 
 #include "../../domain/mind_map_data.hpp"
 #include "alz_file_io_worker.hpp"
+#include "compressed_device.hpp"
 
 #include <QApplication>
 #include <QThread>
@@ -37,6 +38,21 @@ AlzFileIO::AlzFileIO(AlzFormatVersion outputVersion)
     }
 }
 
+bool AlzFileIO::isCompressedFile(QString path)
+{
+    return CompressedDevice::isCompressedFile(path);
+}
+
+void AlzFileIO::setCompressionEnabled(bool compressionEnabled)
+{
+    m_compressionEnabled = compressionEnabled;
+}
+
+bool AlzFileIO::compressionEnabled() const
+{
+    return m_compressionEnabled;
+}
+
 void AlzFileIO::finish()
 {
     m_workerThread->quit();
@@ -52,9 +68,23 @@ bool AlzFileIO::toFile(MindMapDataS mindMapData, QString path, bool async) const
 {
     const auto connectionType = async ? Qt::QueuedConnection : Qt::BlockingQueuedConnection;
 
+    // An asynchronous save gets a plain-data snapshot shared copy-on-write with the mind map,
+    // so that the caller can keep editing the mind map while the worker is writing the snapshot
+    const auto snapshot = async ? std::make_shared<MindMapData>(*mindMapData) : mindMapData;
+
     return QMetaObject::invokeMethod(m_worker.get(), "toFile", connectionType,
-                                     Q_ARG(MindMapDataS, mindMapData),
-                                     Q_ARG(QString, path));
+                                     Q_ARG(MindMapDataS, snapshot),
+                                     Q_ARG(QString, path),
+                                     Q_ARG(bool, m_compressionEnabled));
+}
+
+bool AlzFileIO::appendToJournal(QString path, QByteArray record, bool async) const
+{
+    const auto connectionType = async ? Qt::QueuedConnection : Qt::BlockingQueuedConnection;
+
+    return QMetaObject::invokeMethod(m_worker.get(), "appendToJournal", connectionType,
+                                     Q_ARG(QString, path),
+                                     Q_ARG(QByteArray, record));
 }
 
 MindMapDataU AlzFileIO::fromXml(QString xml) const
@@ -35,12 +35,23 @@ public:
 
     ~AlzFileIO();
 
+    //! \return true if the given file is a compressed ALZ-file.
+    static bool isCompressedFile(QString path);
+
+    //! Enables compressing the XML into a CompressedDevice container on subsequent saves.
+    void setCompressionEnabled(bool compressionEnabled);
+
+    bool compressionEnabled() const;
+
     void finish() override;
 
     MindMapDataU fromFile(QString path) const override;
 
     bool toFile(MindMapDataS mindMapData, QString path, bool async) const override;
 
+    //! Appends a record created by AutosaveJournal to the journal of the given file. Queued after any pending saves.
+    bool appendToJournal(QString path, QByteArray record, bool async) const;
+
     MindMapDataU fromXml(QString xml) const;
 
     QString toXml(MindMapDataS mindMapData) const;
@@ -49,6 +60,8 @@ private:
     std::unique_ptr<AlzFileIOWorker> m_worker;
 
     std::unique_ptr<QThread> m_workerThread;
+
+    bool m_compressionEnabled = false;
 };
 
 } // namespace IO
@@ -18,409 +18,40 @@
 #include "../../application/progress_manager.hpp"
 #include "../../application/service_container.hpp"
 #include "../../common/constants.hpp"
-#include "../../common/test_mode.hpp"
+#include "../../common/trace_recorder.hpp"
 #include "../../common/types.hpp"
 #include "../../common/utils.hpp"
 #include "../../domain/graph.hpp"
 #include "../../domain/image_manager.hpp"
+#include "../../domain/layout_cache.hpp"
 #include "../../domain/mind_map_data.hpp"
 #include "../../view/scene_items/edge.hpp"
 #include "../../view/scene_items/node.hpp"
+#include "alz_data_keywords.hpp"
+#include "alz_stream_reader.hpp"
+#include "alz_stream_writer.hpp"
+#include "autosave_journal.hpp"
+#include "base64.hpp"
+#include "compressed_device.hpp"
+#include "file_exception.hpp"
 #include "xml_reader.hpp"
-#include "xml_writer.hpp"
 
 #include "simple_logger.hpp"
 
 #include <functional>
 #include <map>
-#include <set>
+#include <stdexcept>
 
 #include <QApplication>
 #include <QDebug>
 #include <QDomElement>
 #include <QFile>
-#include <QTemporaryDir>
+#include <QUuid>
 
 namespace IO {
 
 static const auto TAG = "AlzFileIOWorker";
 
-namespace DataKeywords::MindMap {
-
-const auto ATTRIBUTE_APPLICATION_VERSION = "version";
-
-namespace V2 {
-
-const auto ATTRIBUTE_APPLICATION_VERSION = "application-version";
-
-const auto ATTRIBUTE_ALZ_FORMAT_VERSION = "alz-format-version";
-
-namespace Metadata {
-
-const auto ELEMENT_METADATA = "metadata";
-
-} // namespace Metadata
-
-namespace Style {
-
-const auto ELEMENT_STYLE = "style";
-
-} // namespace Style
-
-} // namespace V2
-
-const auto ELEMENT_ARROW_SIZE = "arrow-size";
-
-const auto ELEMENT_COLOR = "color";
-
-const auto ELEMENT_CORNER_RADIUS = "corner-radius";
-
-const auto ELEMENT_EDGE_COLOR = "edge-color";
-
-const auto ELEMENT_EDGE_THICKNESS = "edge-width";
-
-const auto ELEMENT_FONT_FAMILY = "font-family";
-
-const auto ATTRIBUTE_FONT_BOLD = "bold";
-
-const auto ATTRIBUTE_FONT_OVERLINE = "overline";
-
-const auto ATTRIBUTE_FONT_STRIKE_OUT = "strike-out";
-
-const auto ATTRIBUTE_FONT_UNDERLINE = "underline";
-
-const auto ATTRIBUTE_FONT_WEIGHT = "weight";
-
-const auto ATTRIBUTE_FONT_ITALIC = "italic";
-
-const auto ELEMENT_GRAPH = "graph";
-
-const auto ELEMENT_GRID_COLOR = "grid-color";
-
-const auto ELEMENT_HEIMER_MIND_MAP = "heimer-mind-map";
-
-const auto ELEMENT_IMAGE = "image";
-
-const auto ELEMENT_TEXT_SIZE = "text-size";
-
-// Used for Design and Node
-namespace Color {
-
-const auto ATTRIBUTE_R = "r";
-
-const auto ATTRIBUTE_G = "g";
-
-const auto ATTRIBUTE_B = "b";
-} // namespace Color
-
-namespace Graph {
-
-const auto ELEMENT_NODE = "node";
-
-namespace Node {
-
-const auto ELEMENT_TEXT = "text";
-
-const auto ATTRIBUTE_COLOR = "color";
-
-const auto ATTRIBUTE_IMAGE = "image";
-
-const auto ATTRIBUTE_INDEX = "index";
-
-const auto ATTRIBUTE_TEXT_COLOR = "text-color";
-
-const auto ATTRIBUTE_X = "x";
-
-const auto ATTRIBUTE_Y = "y";
-
-const auto ATTRIBUTE_W = "w";
-
-const auto ATTRIBUTE_H = "h";
-
-namespace Image {
-
-const auto ATTRIBUTE_REF = "ref";
-} // namespace Image
-
-namespace V2 {
-
-const auto ATTRIBUTE_INDEX = "i";
-}
-
-} // namespace Node
-
-const auto ELEMENT_EDGE = "edge";
-
-namespace Edge {
-
-const auto ATTRIBUTE_ARROW_MODE = "arrow-mode";
-
-const auto ATTRIBUTE_DASHED_LINE = "dashed-line";
-
-const auto ATTRIBUTE_INDEX0 = "index0";
-
-const auto ATTRIBUTE_INDEX1 = "index1";
-
-const auto ATTRIBUTE_REVERSED = "reversed";
-
-namespace V2 {
-
-const auto ATTRIBUTE_INDEX0 = "i0";
-
-const auto ATTRIBUTE_INDEX1 = "i1";
-
-} // namespace V2
-
-} // namespace Edge
-} // namespace Graph
-
-namespace Image {
-
-const auto ATTRIBUTE_ID = "id";
-
-const auto ATTRIBUTE_PATH = "path";
-
-} // namespace Image
-
-// Note!!: Moved into metadata element in V2
-namespace LayoutOptimizer {
-
-const auto ELEMENT_LAYOUT_OPTIMIZER = "layout-optimizer";
-
-const auto ATTRIBUTE_ASPECT_RATIO = "aspect-ratio";
-
-const auto ATTRIBUTE_MIN_EDGE_LENGTH = "min-edge-length";
-
-} // namespace LayoutOptimizer
-
-} // namespace DataKeywords::MindMap
-
-static const double SCALE = 1000; // https://bugreports.qt.io/browse/QTBUG-67129
-
-static void writeColor(QDomElement & parent, QDomDocument & doc, QColor color, QString elementName)
-{
-    auto colorElement = doc.createElement(elementName);
-    colorElement.setAttribute(DataKeywords::MindMap::Color::ATTRIBUTE_R, color.red());
-    colorElement.setAttribute(DataKeywords::MindMap::Color::ATTRIBUTE_G, color.green());
-    colorElement.setAttribute(DataKeywords::MindMap::Color::ATTRIBUTE_B, color.blue());
-    parent.appendChild(colorElement);
-}
-
-static void writeImageRef(QDomElement & parent, QDomDocument & doc, size_t imageRef, QString elementName)
-{
-    auto colorElement = doc.createElement(elementName);
-    colorElement.setAttribute(DataKeywords::MindMap::Graph::Node::Image::ATTRIBUTE_REF, static_cast<int>(imageRef));
-    parent.appendChild(colorElement);
-}
-
-static void writeNodes(MindMapDataS mindMapData, QDomElement & root, QDomDocument & doc, AlzFormatVersion outputVersion)
-{
-    for (auto && node : mindMapData->graph().getNodes()) {
-
-        using namespace DataKeywords::MindMap::Graph;
-
-        auto nodeElement = doc.createElement(ELEMENT_NODE);
-        nodeElement.setAttribute(outputVersion == AlzFormatVersion::V1 ? Node::ATTRIBUTE_INDEX : Node::V2::ATTRIBUTE_INDEX, node->index());
-        nodeElement.setAttribute(Node::ATTRIBUTE_X, static_cast<int>(node->location().x() * SCALE));
-        nodeElement.setAttribute(Node::ATTRIBUTE_Y, static_cast<int>(node->location().y() * SCALE));
-        nodeElement.setAttribute(Node::ATTRIBUTE_W, static_cast<int>(node->size().width() * SCALE));
-        nodeElement.setAttribute(Node::ATTRIBUTE_H, static_cast<int>(node->size().height() * SCALE));
-        root.appendChild(nodeElement);
-
-        // Create a child node for the text content
-        if (!node->text().isEmpty()) {
-            auto textElement = doc.createElement(Node::ELEMENT_TEXT);
-            textElement.appendChild(doc.createTextNode(node->text()));
-            nodeElement.appendChild(textElement);
-        }
-
-        // Create a child node for color
-        writeColor(nodeElement, doc, node->color(), Node::ATTRIBUTE_COLOR);
-
-        // Create a child node for text color
-        writeColor(nodeElement, doc, node->textColor(), Node::ATTRIBUTE_TEXT_COLOR);
-
-        // Create a child node for image ref
-        if (node->imageRef()) {
-            writeImageRef(nodeElement, doc, node->imageRef(), Node::ATTRIBUTE_IMAGE);
-        }
-    }
-}
-
-static void writeEdges(MindMapDataS mindMapData, QDomElement & root, QDomDocument & doc, AlzFormatVersion outputVersion)
-{
-    for (auto && node : mindMapData->graph().getNodes()) {
-        for (auto && edge : mindMapData->graph().getEdgesFromNode(node)) {
-            using namespace DataKeywords::MindMap::Graph;
-            auto edgeElement = doc.createElement(ELEMENT_EDGE);
-            edgeElement.setAttribute(Edge::ATTRIBUTE_ARROW_MODE, static_cast<int>(edge->arrowMode()));
-            if (edge->dashedLine()) {
-                edgeElement.setAttribute(Edge::ATTRIBUTE_DASHED_LINE, edge->dashedLine());
-            }
-            edgeElement.setAttribute(outputVersion == AlzFormatVersion::V1 ? Edge::ATTRIBUTE_INDEX0 : Edge::V2::ATTRIBUTE_INDEX0, edge->sourceNode().index());
-            edgeElement.setAttribute(outputVersion == AlzFormatVersion::V1 ? Edge::ATTRIBUTE_INDEX1 : Edge::V2::ATTRIBUTE_INDEX1, edge->targetNode().index());
-            if (edge->reversed()) {
-                edgeElement.setAttribute(Edge::ATTRIBUTE_REVERSED, edge->reversed());
-            }
-            root.appendChild(edgeElement);
-
-            // Create a child node for the text content
-            if (!edge->text().isEmpty()) {
-                auto textElement = doc.createElement(Node::ELEMENT_TEXT);
-                edgeElement.appendChild(textElement);
-                const auto textNode = doc.createTextNode(edge->text());
-                textElement.appendChild(textNode);
-            }
-        }
-    }
-}
-
-static void writeGraph(MindMapDataS mindMapData, QDomElement & root, QDomDocument & doc, AlzFormatVersion outputVersion)
-{
-    auto graph = doc.createElement(DataKeywords::MindMap::ELEMENT_GRAPH);
-    root.appendChild(graph);
-
-    writeNodes(mindMapData, graph, doc, outputVersion);
-
-    writeEdges(mindMapData, graph, doc, outputVersion);
-}
-
-static void writeStyle(MindMapDataS mindMapData, QDomElement & root, QDomDocument & doc, AlzFormatVersion outputVersion)
-{
-    const auto doWriteStyle = [](MindMapDataS mindMapData, QDomElement & root, QDomDocument & doc) {
-        writeColor(root, doc, mindMapData->backgroundColor(), DataKeywords::MindMap::ELEMENT_COLOR);
-
-        writeColor(root, doc, mindMapData->edgeColor(), DataKeywords::MindMap::ELEMENT_EDGE_COLOR);
-
-        writeColor(root, doc, mindMapData->gridColor(), DataKeywords::MindMap::ELEMENT_GRID_COLOR);
-
-        auto arrowSizeElement = doc.createElement(DataKeywords::MindMap::ELEMENT_ARROW_SIZE);
-        arrowSizeElement.appendChild(doc.createTextNode(QString::number(static_cast<int>(mindMapData->arrowSize() * SCALE))));
-        root.appendChild(arrowSizeElement);
-
-        auto edgeWidthElement = doc.createElement(DataKeywords::MindMap::ELEMENT_EDGE_THICKNESS);
-        edgeWidthElement.appendChild(doc.createTextNode(QString::number(static_cast<int>(mindMapData->edgeWidth() * SCALE))));
-        root.appendChild(edgeWidthElement);
-
-        auto fontFamilyElement = doc.createElement(DataKeywords::MindMap::ELEMENT_FONT_FAMILY);
-        fontFamilyElement.setAttribute(DataKeywords::MindMap::ATTRIBUTE_FONT_BOLD, mindMapData->font().bold());
-        fontFamilyElement.setAttribute(DataKeywords::MindMap::ATTRIBUTE_FONT_ITALIC, mindMapData->font().italic());
-        fontFamilyElement.setAttribute(DataKeywords::MindMap::ATTRIBUTE_FONT_OVERLINE, mindMapData->font().overline());
-        fontFamilyElement.setAttribute(DataKeywords::MindMap::ATTRIBUTE_FONT_STRIKE_OUT, mindMapData->font().strikeOut());
-        fontFamilyElement.setAttribute(DataKeywords::MindMap::ATTRIBUTE_FONT_UNDERLINE, mindMapData->font().underline());
-        fontFamilyElement.setAttribute(DataKeywords::MindMap::ATTRIBUTE_FONT_WEIGHT, Utils::fontWeightToInt(mindMapData->font().weight()));
-        fontFamilyElement.appendChild(doc.createTextNode(mindMapData->font().family()));
-        root.appendChild(fontFamilyElement);
-
-        auto textSizeElement = doc.createElement(DataKeywords::MindMap::ELEMENT_TEXT_SIZE);
-        textSizeElement.appendChild(doc.createTextNode(QString::number(static_cast<int>(mindMapData->textSize() * SCALE))));
-        root.appendChild(textSizeElement);
-
-        auto cornerRadiusElement = doc.createElement(DataKeywords::MindMap::ELEMENT_CORNER_RADIUS);
-        cornerRadiusElement.appendChild(doc.createTextNode(QString::number(static_cast<int>(mindMapData->cornerRadius() * SCALE))));
-        root.appendChild(cornerRadiusElement);
-    };
-
-    if (outputVersion == AlzFormatVersion::V1) {
-        doWriteStyle(mindMapData, root, doc);
-    } else {
-        auto styleElement = doc.createElement(DataKeywords::MindMap::V2::Style::ELEMENT_STYLE);
-        doWriteStyle(mindMapData, styleElement, doc);
-        root.appendChild(styleElement);
-    }
-}
-
-static void writeVersion(QDomElement & root, QDomDocument & doc, AlzFormatVersion outputVersion)
-{
-    if (outputVersion == AlzFormatVersion::V1) {
-        root.setAttribute(DataKeywords::MindMap::ATTRIBUTE_APPLICATION_VERSION, Constants::Application::applicationVersion());
-    } else {
-        root.setAttribute(DataKeywords::MindMap::V2::ATTRIBUTE_APPLICATION_VERSION, Constants::Application::applicationVersion());
-        root.setAttribute(DataKeywords::MindMap::V2::ATTRIBUTE_ALZ_FORMAT_VERSION, static_cast<int>(Constants::Application::alzFormatVersion()));
-    }
-    doc.appendChild(root);
-}
-
-static QString getBase64Data(std::string path)
-{
-    if (!TestMode::enabled()) {
-        QFile in(path.c_str());
-        if (!in.open(QIODevice::ReadOnly)) {
-            throw std::runtime_error("Cannot open file: '" + path + "'");
-        }
-        return in.readAll().toBase64(QByteArray::Base64Encoding);
-    } else {
-        TestMode::logDisabledCode("getBase64Data");
-        return {};
-    }
-}
-
-static QImage base64ToQImage(const std::string & base64, size_t imageId, std::string imagePath)
-{
-    juzzlin::L(TAG).debug() << "Extracting embedded Image id=" << imageId << ", path=" << imagePath;
-    const auto ba = QByteArray::fromBase64(base64.c_str(), QByteArray::Base64Encoding);
-    QImage in;
-    if (!in.loadFromData(ba)) {
-        juzzlin::L(TAG).error() << "Could not load embedded Image id=" << imageId << ", path=" << imagePath;
-    }
-#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
-    juzzlin::L(TAG).debug() << "Image size: " << in.sizeInBytes() << " bytes";
-#endif
-    return in;
-}
-
-static void writeImages(MindMapDataS mindMapData, QDomElement & root, QDomDocument & doc)
-{
-    std::set<size_t> writtenImageRefs;
-    for (auto && node : mindMapData->graph().getNodes()) {
-        if (node->imageRef()) {
-            if (writtenImageRefs.count(node->imageRef())) {
-                juzzlin::L(TAG).debug() << "Image id=" << node->imageRef() << " already written";
-            } else {
-                if (const auto image = mindMapData->imageManager().getImage(node->imageRef()); image.has_value()) {
-                    auto imageElement = doc.createElement(DataKeywords::MindMap::ELEMENT_IMAGE);
-                    imageElement.setAttribute(DataKeywords::MindMap::Image::ATTRIBUTE_ID, static_cast<int>(image->id()));
-                    imageElement.setAttribute(DataKeywords::MindMap::Image::ATTRIBUTE_PATH, image->path().c_str());
-                    root.appendChild(imageElement);
-
-                    // Create a child node for the image content
-                    if (!TestMode::enabled()) {
-                        QTemporaryDir dir;
-                        const QFileInfo info(image->path().c_str());
-                        const QString tempImagePath = (dir.path() + QDir::separator() + info.fileName());
-                        image->image().save(tempImagePath);
-                        imageElement.appendChild(doc.createTextNode(getBase64Data(tempImagePath.toStdString())));
-                        writtenImageRefs.insert(image->id());
-                    } else {
-                        TestMode::logDisabledCode("writeImages");
-                    }
-                } else {
-                    throw std::runtime_error("Image id=" + std::to_string(node->imageRef()) + " doesn't exist!");
-                }
-            }
-        }
-    }
-}
-
-static void writeLayoutOptimizer(MindMapDataS mindMapData, QDomElement & root, QDomDocument & doc)
-{
-    auto layoutOptimizerElement = doc.createElement(DataKeywords::MindMap::LayoutOptimizer::ELEMENT_LAYOUT_OPTIMIZER);
-    layoutOptimizerElement.setAttribute(DataKeywords::MindMap::LayoutOptimizer::ATTRIBUTE_ASPECT_RATIO, mindMapData->aspectRatio() * SCALE);
-    layoutOptimizerElement.setAttribute(DataKeywords::MindMap::LayoutOptimizer::ATTRIBUTE_MIN_EDGE_LENGTH, mindMapData->minEdgeLength() * SCALE);
-    root.appendChild(layoutOptimizerElement);
-}
-
-static void writeMetadata(MindMapDataS mindMapData, QDomElement & root, QDomDocument & doc, AlzFormatVersion outputVersion)
-{
-    if (outputVersion == AlzFormatVersion::V1) {
-        writeLayoutOptimizer(mindMapData, root, doc);
-    } else {
-        auto metadataElement = doc.createElement(DataKeywords::MindMap::V2::Metadata::ELEMENT_METADATA);
-        writeLayoutOptimizer(mindMapData, metadataElement, doc);
-        root.appendChild(metadataElement);
-    }
-}
-
 static QColor readColorElement(const QDomElement & element)
 {
     return {
@@ -493,6 +124,10 @@ static NodeU readNode(const QDomElement & element)
           element.attribute(Node::ATTRIBUTE_H).toInt() / SCALE));
     }
 
+    node->setCollapsed(element.attribute(Node::ATTRIBUTE_COLLAPSED, "0").toInt());
+
+    node->setUuid(QUuid { element.attribute(Node::ATTRIBUTE_UUID) });
+
     readChildren(element, { { QString(Node::ELEMENT_TEXT), [&node](const QDomElement & e) {
                                  node->setText(readFirstTextNodeContent(e));
                              } },
@@ -526,6 +161,13 @@ static EdgeU readEdge(const QDomElement & element, MindMapData & data)
 
     const bool reversed = element.attribute(Edge::ATTRIBUTE_REVERSED, "0").toInt();
 
+    // Fail while loading like adding the edge to the graph would
+    for (auto && index : { index0, index1 }) {
+        if (!data.graph().hasNode(index)) {
+            throw std::runtime_error("Invalid node index: " + std::to_string(index));
+        }
+    }
+
     // Initialize a new edge. QGraphicsScene will take the ownership eventually.
     auto edge = std::make_unique<SceneItems::Edge>(data.graph().getNode(index0), data.graph().getNode(index1));
     edge->setArrowMode(static_cast<SceneItems::EdgeModel::ArrowMode>(arrowMode));
@@ -539,6 +181,27 @@ static EdgeU readEdge(const QDomElement & element, MindMapData & data)
     return edge;
 }
 
+static void readCachedLayout(const QDomElement & element, MindMapData & data)
+{
+    using namespace DataKeywords::MindMap::LayoutOptimizer::CachedLayout;
+
+    bool keyOk = false;
+    bool topologyKeyOk = false;
+    LayoutCache::Entry entry;
+    entry.key = element.attribute(ATTRIBUTE_KEY).toULongLong(&keyOk, 16);
+    entry.topologyKey = element.attribute(ATTRIBUTE_TOPOLOGY_KEY).toULongLong(&topologyKeyOk, 16);
+
+    readChildren(element, { { QString(ELEMENT_NODE), [&entry](const QDomElement & e) {
+                                 entry.layout.emplace_back(e.attribute(Node::ATTRIBUTE_INDEX, "-1").toInt(),
+                                                           QPointF { e.attribute(Node::ATTRIBUTE_X, "0").toInt() / SCALE, e.attribute(Node::ATTRIBUTE_Y, "0").toInt() / SCALE });
+                             } } });
+
+    // The key is checked against the graph only when optimizing, so a broken cache just gets ignored
+    if (keyOk && topologyKeyOk) {
+        data.layoutCache().insert(std::move(entry));
+    }
+}
+
 static void readLayoutOptimizer(const QDomElement & element, MindMapData & data)
 {
     double aspectRatio = element.attribute(DataKeywords::MindMap::LayoutOptimizer::ATTRIBUTE_ASPECT_RATIO, "-1").toDouble() / SCALE;
@@ -550,6 +213,10 @@ static void readLayoutOptimizer(const QDomElement & element, MindMapData & data)
     minEdgeLength = std::min(minEdgeLength, Constants::LayoutOptimizer::maxEdgeLength());
     minEdgeLength = std::max(minEdgeLength, Constants::LayoutOptimizer::minEdgeLength());
     data.setMinEdgeLength(minEdgeLength);
+
+    readChildren(element, { { QString(DataKeywords::MindMap::LayoutOptimizer::ELEMENT_CACHED_LAYOUT), [&](const QDomElement & e) {
+                                 readCachedLayout(e, data);
+                             } } });
 }
 
 static void readMetadata(const QDomElement & element, MindMapData & data)
@@ -597,6 +264,8 @@ static void readStyle(const QDomElement & element, MindMapData & data)
 
 static void readGraph(const QDomElement & graph, MindMapData & data)
 {
+    // The indices may be as sparse as for all the nodes from the first node on, see Graph::isValidNodeIndex()
+    data.graph().reserveNodes(static_cast<size_t>(graph.childNodes().count()));
     readChildren(graph, {
                           { QString(DataKeywords::MindMap::Graph::ELEMENT_NODE), [&data](const QDomElement & e) {
                                data.graph().addNode(readNode(e));
@@ -655,7 +324,8 @@ MindMapDataU fromXml(QDomDocument document)
                          { QString(DataKeywords::MindMap::ELEMENT_IMAGE), [&data](const QDomElement & e) {
                               const auto id = e.attribute(DataKeywords::MindMap::Image::ATTRIBUTE_ID).toUInt();
                               const auto path = e.attribute(DataKeywords::MindMap::Image::ATTRIBUTE_PATH).toStdString();
-                              Image image(base64ToQImage(readFirstTextNodeContent(e).toStdString(), id, path), path);
+                              juzzlin::L(TAG).debug() << "Extracting embedded Image id=" << id << ", path=" << path;
+                              auto image = Image::fromEncodedData(Base64::decode(readFirstTextNodeContent(e).toLatin1()), path);
                               image.setId(id);
                               data->imageManager().setImage(image);
                           } },
@@ -668,6 +338,9 @@ MindMapDataU fromXml(QDomDocument document)
                          { QString(DataKeywords::MindMap::LayoutOptimizer::ELEMENT_LAYOUT_OPTIMIZER), [&data](const QDomElement & e) {
                               readLayoutOptimizer(e, *data);
                           } },
+                         { QString(DataKeywords::MindMap::V2::Metadata::ELEMENT_HEADER), [](const QDomElement &) {
+                              // Everything in the header is also in the rest of the document
+                          } },
                          { QString(DataKeywords::MindMap::V2::Metadata::ELEMENT_METADATA), [&data](const QDomElement & e) {
                               readMetadata(e, *data);
                           } },
@@ -678,25 +351,6 @@ MindMapDataU fromXml(QDomDocument document)
     return data;
 }
 
-QDomDocument toXml(MindMapDataS mindMapData, AlzFormatVersion outputVersion)
-{
-    QDomDocument doc;
-    doc.appendChild(doc.createProcessingInstruction("xml", "version='1.0' encoding='UTF-8'"));
-    auto root = doc.createElement(DataKeywords::MindMap::ELEMENT_HEIMER_MIND_MAP);
-
-    writeVersion(root, doc, outputVersion);
-
-    writeStyle(mindMapData, root, doc, outputVersion);
-
-    writeGraph(mindMapData, root, doc, outputVersion);
-
-    writeImages(mindMapData, root, doc);
-
-    writeMetadata(mindMapData, root, doc, outputVersion);
-
-    return doc;
-}
-
 AlzFileIOWorker::AlzFileIOWorker(AlzFormatVersion outputVersion)
   : m_outputVersion(outputVersion)
 {
@@ -706,12 +360,46 @@ AlzFileIOWorker::~AlzFileIOWorker() = default;
 
 MindMapDataU AlzFileIOWorker::fromFile(QString path) const
 {
-    return IO::fromXml(XmlReader::readFromFile(path));
+    const TraceRecorder::ScopedSpan span { "AlzFileIO::fromFile" };
+
+    try {
+        return AlzStreamReader::readFromFile(path);
+    } catch (const FileException & e) {
+        if (CompressedDevice::isCompressedFile(path)) {
+            throw;
+        }
+        // The DOM-based reader is more forgiving with some malformed files
+        juzzlin::L(TAG).warning() << "Streaming read failed: " << e.message().toStdString() << ", falling back to DOM";
+        const auto document = XmlReader::readFromFile(path);
+        try {
+            return IO::fromXml(document);
+        } catch (const std::runtime_error & error) {
+            // E.g. an edge or a node index that the graph rejects
+            juzzlin::L(TAG).warning() << "Invalid data: " << error.what();
+            throw FileException(QObject::tr("Corrupted file: '") + path + "'");
+        }
+    }
+}
+
+bool AlzFileIOWorker::toFile(MindMapDataS mindMapData, QString path, bool compress) const
+{
+    const TraceRecorder::ScopedSpan span { "AlzFileIO::toFile" };
+
+    if (!AlzStreamWriter::writeToFile(mindMapData, path, m_outputVersion, compress, &m_fragmentCache)) {
+        return false;
+    }
+
+    // The main file now contains everything that was journaled
+    if (const auto journalPath = AutosaveJournal::journalPath(path); QFile::exists(journalPath) && !QFile::remove(journalPath)) {
+        juzzlin::L(TAG).warning() << "Cannot remove journal '" << journalPath.toStdString() << "'";
+    }
+
+    return true;
 }
 
-bool AlzFileIOWorker::toFile(MindMapDataS mindMapData, QString path) const
+bool AlzFileIOWorker::appendToJournal(QString path, QByteArray record) const
 {
-    return XmlWriter::writeToFile(IO::toXml(mindMapData, m_outputVersion), path);
+    return AutosaveJournal::appendRecord(AutosaveJournal::journalPath(path), record);
 }
 
 MindMapDataU AlzFileIOWorker::fromXml(QString xml) const
@@ -724,7 +412,7 @@ MindMapDataU AlzFileIOWorker::fromXml(QString xml) const
 
 QString AlzFileIOWorker::toXml(MindMapDataS mindMapData) const
 {
-    return IO::toXml(mindMapData, m_outputVersion).toString();
+    return AlzStreamWriter::writeToString(mindMapData, m_outputVersion);
 }
 
 } // namespace IO
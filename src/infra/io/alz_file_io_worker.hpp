@@ -20,6 +20,7 @@
 #include <QString>
 
 #include "alz_file_io_version.hpp"
+#include "alz_stream_writer.hpp"
 
 #include "../../common/types.hpp"
 
@@ -38,7 +39,11 @@ public slots:
 
     MindMapDataU fromFile(QString path) const;
 
-    bool toFile(MindMapDataS mindMapData, QString path) const;
+    //! Saves the whole mind map and removes the autosave journal of the file.
+    bool toFile(MindMapDataS mindMapData, QString path, bool compress) const;
+
+    //! Appends a record to the autosave journal of the file.
+    bool appendToJournal(QString path, QByteArray record) const;
 
     MindMapDataU fromXml(QString xml) const;
 
@@ -46,6 +51,9 @@ public slots:
 
 private:
     AlzFormatVersion m_outputVersion;
+
+    //! Only used by saves, which all run on the worker thread.
+    mutable AlzStreamWriter::FragmentCache m_fragmentCache;
 };
 
 } // namespace IO
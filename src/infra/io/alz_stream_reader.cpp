@@ -0,0 +1,525 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "alz_stream_reader.hpp"
+
+#include "../../application/progress_manager.hpp"
+#include "../../application/service_container.hpp"
+#include "../../application/settings_proxy.hpp"
+#include "../../common/constants.hpp"
+#include "../../common/utils.hpp"
+#include "../../domain/graph.hpp"
+#include "../../domain/graph_snapshot.hpp"
+#include "../../domain/image_manager.hpp"
+#include "../../domain/layout_cache.hpp"
+#include "../../domain/mind_map_data.hpp"
+#include "alz_data_keywords.hpp"
+#include "alz_file_io_version.hpp"
+#include "base64.hpp"
+#include "compressed_device.hpp"
+#include "file_exception.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QFile>
+#include <QObject>
+#include <QUuid>
+#include <QXmlStreamReader>
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace IO {
+
+static const auto TAG = "AlzStreamReader";
+
+namespace {
+
+// Handlers are plain function pointers in static tables so that nothing gets built per element
+template<typename Context>
+using HandlerMap = std::map<QString, void (*)(QXmlStreamReader &, Context &)>;
+
+QString attribute(const QXmlStreamReader & reader, const QString & name, const QString & defaultValue = {})
+{
+    const auto attributes = reader.attributes();
+    return attributes.hasAttribute(name) ? attributes.value(name).toString() : defaultValue;
+}
+
+QString readText(QXmlStreamReader & reader)
+{
+    // See: https://github.com/juzzlin/Heimer/issues/73
+    return reader.readElementText(QXmlStreamReader::SkipChildElements).replace(QChar(QChar::CarriageReturn), "");
+}
+
+QColor readColor(QXmlStreamReader & reader)
+{
+    const QColor color {
+        attribute(reader, DataKeywords::MindMap::Color::ATTRIBUTE_R, "255").toInt(),
+        attribute(reader, DataKeywords::MindMap::Color::ATTRIBUTE_G, "255").toInt(),
+        attribute(reader, DataKeywords::MindMap::Color::ATTRIBUTE_B, "255").toInt()
+    };
+    reader.skipCurrentElement();
+    return color;
+}
+
+// Generic helper that loops through the children of the current element
+template<typename Context>
+void readChildren(QXmlStreamReader & reader, Context & context, const HandlerMap<Context> & handlerMap)
+{
+    while (reader.readNextStartElement()) {
+        SC::instance().progressManager()->updateProgress();
+        if (const auto iter = handlerMap.find(reader.name().toString()); iter != handlerMap.end()) {
+            iter->second(reader, context);
+        } else {
+            juzzlin::L(TAG).warning() << "Unknown element '" << reader.name().toString().toStdString() << "'";
+            reader.skipCurrentElement();
+        }
+    }
+}
+
+// Nodes and edges are read into plain models so that no scene items get created while parsing.
+// The scene items are created from the snapshot only when the graph is first accessed.
+struct GraphContext
+{
+    GraphSnapshot::NodeDataVector nodes;
+
+    GraphSnapshot::EdgeDataVector edges;
+
+    GraphSnapshot::NodeIndexSet nodeIndices;
+};
+
+void readNode(QXmlStreamReader & reader, GraphContext & context)
+{
+    using namespace DataKeywords::MindMap::Graph;
+
+    const auto settingsProxy = SC::instance().settingsProxy();
+    SceneItems::NodeModel node { settingsProxy->nodeColor(), settingsProxy->nodeTextColor() };
+    const auto noIndex = "-1";
+    node.index = attribute(reader, Node::V2::ATTRIBUTE_INDEX, attribute(reader, Node::ATTRIBUTE_INDEX, noIndex)).toInt();
+
+    node.location = QPointF(
+      attribute(reader, Node::ATTRIBUTE_X, "0").toInt() / SCALE,
+      attribute(reader, Node::ATTRIBUTE_Y, "0").toInt() / SCALE);
+
+    if (reader.attributes().hasAttribute(Node::ATTRIBUTE_W) && reader.attributes().hasAttribute(Node::ATTRIBUTE_H)) {
+        node.size = QSizeF(
+          attribute(reader, Node::ATTRIBUTE_W).toInt() / SCALE,
+          attribute(reader, Node::ATTRIBUTE_H).toInt() / SCALE);
+    } else {
+        node.size = QSizeF(Constants::Node::minWidth(), Constants::Node::minHeight());
+    }
+
+    node.collapsed = attribute(reader, Node::ATTRIBUTE_COLLAPSED, "0").toInt();
+
+    node.uuid = QUuid { attribute(reader, Node::ATTRIBUTE_UUID) };
+
+    static const HandlerMap<SceneItems::NodeModel> handlerMap = {
+        { Node::ELEMENT_TEXT, [](QXmlStreamReader & reader, SceneItems::NodeModel & node) {
+             node.text = readText(reader);
+         } },
+        { Node::ATTRIBUTE_COLOR, [](QXmlStreamReader & reader, SceneItems::NodeModel & node) {
+             node.color = readColor(reader);
+         } },
+        { Node::ATTRIBUTE_TEXT_COLOR, [](QXmlStreamReader & reader, SceneItems::NodeModel & node) {
+             node.textColor = readColor(reader);
+         } },
+        { Node::ATTRIBUTE_IMAGE, [](QXmlStreamReader & reader, SceneItems::NodeModel & node) {
+             node.imageRef = static_cast<size_t>(attribute(reader, Node::Image::ATTRIBUTE_REF, "0").toInt());
+             reader.skipCurrentElement();
+         } }
+    };
+    readChildren(reader, node, handlerMap);
+
+    if (node.index < 0) {
+        throw std::runtime_error("Invalid node index: " + std::to_string(node.index));
+    }
+
+    context.nodeIndices.insert(node.index);
+    context.nodes.push_back(node);
+}
+
+void readEdge(QXmlStreamReader & reader, GraphContext & context)
+{
+    using namespace DataKeywords::MindMap::Graph;
+
+    const int arrowMode = attribute(reader, Edge::ATTRIBUTE_ARROW_MODE, "0").toInt();
+    const bool dashedLine = attribute(reader, Edge::ATTRIBUTE_DASHED_LINE, "0").toInt();
+
+    const auto noIndex = "-1";
+    const int index0 = attribute(reader, Edge::V2::ATTRIBUTE_INDEX0, attribute(reader, Edge::ATTRIBUTE_INDEX0, noIndex)).toInt();
+    const int index1 = attribute(reader, Edge::V2::ATTRIBUTE_INDEX1, attribute(reader, Edge::ATTRIBUTE_INDEX1, noIndex)).toInt();
+
+    // Fail while loading like adding the edge to the graph would
+    for (auto && index : { index0, index1 }) {
+        if (!context.nodeIndices.contains(index)) {
+            throw std::runtime_error("Invalid node index: " + std::to_string(index));
+        }
+    }
+
+    const bool reversed = attribute(reader, Edge::ATTRIBUTE_REVERSED, "0").toInt();
+
+    GraphSnapshot::EdgeData edge { { reversed, SceneItems::EdgeModel::Style { static_cast<SceneItems::EdgeModel::ArrowMode>(arrowMode) } }, index0, index1 };
+    edge.model.style.dashedLine = dashedLine;
+
+    static const HandlerMap<SceneItems::EdgeModel> handlerMap = {
+        { Node::ELEMENT_TEXT, [](QXmlStreamReader & reader, SceneItems::EdgeModel & edge) {
+             edge.text = readText(reader);
+         } }
+    };
+    readChildren(reader, edge.model, handlerMap);
+
+    context.edges.push_back(edge);
+}
+
+void readGraph(QXmlStreamReader & reader, MindMapData & data)
+{
+    static const HandlerMap<GraphContext> handlerMap = {
+        { DataKeywords::MindMap::Graph::ELEMENT_NODE, readNode },
+        { DataKeywords::MindMap::Graph::ELEMENT_EDGE, readEdge }
+    };
+    GraphContext context;
+    readChildren(reader, context, handlerMap);
+
+    // The graph would allocate a slot for every index up to the largest one
+    for (auto && node : context.nodes) {
+        if (!Graph::isValidNodeIndex(node.index, context.nodes.size())) {
+            throw std::runtime_error("Node index out of range: " + std::to_string(node.index));
+        }
+    }
+
+    data.setGraphSnapshot({ std::move(context.nodes), std::move(context.edges) });
+}
+
+void readImage(QXmlStreamReader & reader, MindMapData & data)
+{
+    const auto id = attribute(reader, DataKeywords::MindMap::Image::ATTRIBUTE_ID).toUInt();
+    const auto path = attribute(reader, DataKeywords::MindMap::Image::ATTRIBUTE_PATH).toStdString();
+    juzzlin::L(TAG).debug() << "Extracting embedded Image id=" << id << ", path=" << path;
+    auto image = Image::fromEncodedData(Base64::decode(readText(reader).toLatin1()), path);
+    image.setId(id);
+    data.imageManager().setImage(image);
+}
+
+void readFont(QXmlStreamReader & reader, MindMapData & data)
+{
+    using namespace DataKeywords::MindMap;
+
+    QFont font;
+    font.setBold(attribute(reader, ATTRIBUTE_FONT_BOLD).toInt());
+    font.setItalic(attribute(reader, ATTRIBUTE_FONT_ITALIC).toUInt());
+    font.setOverline(attribute(reader, ATTRIBUTE_FONT_OVERLINE).toInt());
+    font.setUnderline(attribute(reader, ATTRIBUTE_FONT_UNDERLINE).toInt());
+    font.setStrikeOut(attribute(reader, ATTRIBUTE_FONT_STRIKE_OUT).toInt());
+    font.setWeight(Utils::intToFontWeight(attribute(reader, ATTRIBUTE_FONT_WEIGHT).toInt()));
+    font.setFamily(readText(reader));
+    data.changeFont(font);
+}
+
+void readCachedLayout(QXmlStreamReader & reader, MindMapData & data)
+{
+    using namespace DataKeywords::MindMap::LayoutOptimizer::CachedLayout;
+
+    bool keyOk = false;
+    bool topologyKeyOk = false;
+    LayoutCache::Entry entry;
+    entry.key = attribute(reader, ATTRIBUTE_KEY).toULongLong(&keyOk, 16);
+    entry.topologyKey = attribute(reader, ATTRIBUTE_TOPOLOGY_KEY).toULongLong(&topologyKeyOk, 16);
+
+    static const HandlerMap<LayoutCache::Layout> handlerMap = {
+        { ELEMENT_NODE, [](QXmlStreamReader & reader, LayoutCache::Layout & layout) {
+             layout.emplace_back(attribute(reader, Node::ATTRIBUTE_INDEX, "-1").toInt(),
+                                 QPointF { attribute(reader, Node::ATTRIBUTE_X, "0").toInt() / SCALE, attribute(reader, Node::ATTRIBUTE_Y, "0").toInt() / SCALE });
+             reader.skipCurrentElement();
+         } }
+    };
+    readChildren(reader, entry.layout, handlerMap);
+
+    // The key is checked against the graph only when optimizing, so a broken cache just gets ignored
+    if (keyOk && topologyKeyOk) {
+        data.layoutCache().insert(std::move(entry));
+    }
+}
+
+void readLayoutOptimizer(QXmlStreamReader & reader, MindMapData & data)
+{
+    using namespace DataKeywords::MindMap::LayoutOptimizer;
+
+    double aspectRatio = attribute(reader, ATTRIBUTE_ASPECT_RATIO, "-1").toDouble() / SCALE;
+    aspectRatio = std::min(aspectRatio, Constants::LayoutOptimizer::maxAspectRatio());
+    aspectRatio = std::max(aspectRatio, Constants::LayoutOptimizer::minAspectRatio());
+    data.setAspectRatio(aspectRatio);
+
+    double minEdgeLength = attribute(reader, ATTRIBUTE_MIN_EDGE_LENGTH, "-1").toDouble() / SCALE;
+    minEdgeLength = std::min(minEdgeLength, Constants::LayoutOptimizer::maxEdgeLength());
+    minEdgeLength = std::max(minEdgeLength, Constants::LayoutOptimizer::minEdgeLength());
+    data.setMinEdgeLength(minEdgeLength);
+
+    static const HandlerMap<MindMapData> handlerMap = {
+        { ELEMENT_CACHED_LAYOUT, readCachedLayout }
+    };
+    readChildren(reader, data, handlerMap);
+}
+
+void readMetadata(QXmlStreamReader & reader, MindMapData & data)
+{
+    static const HandlerMap<MindMapData> handlerMap = {
+        { DataKeywords::MindMap::LayoutOptimizer::ELEMENT_LAYOUT_OPTIMIZER, readLayoutOptimizer }
+    };
+    readChildren(reader, data, handlerMap);
+}
+
+const HandlerMap<MindMapData> & styleHandlerMap()
+{
+    using namespace DataKeywords::MindMap;
+
+    static const HandlerMap<MindMapData> handlerMap = {
+        { ELEMENT_ARROW_SIZE, [](QXmlStreamReader & reader, MindMapData & data) {
+             data.setArrowSize(readText(reader).toDouble() / SCALE);
+         } },
+        { ELEMENT_COLOR, [](QXmlStreamReader & reader, MindMapData & data) {
+             data.setBackgroundColor(readColor(reader));
+         } },
+        { ELEMENT_EDGE_COLOR, [](QXmlStreamReader & reader, MindMapData & data) {
+             data.setEdgeColor(readColor(reader));
+         } },
+        { ELEMENT_FONT_FAMILY, readFont },
+        { ELEMENT_GRID_COLOR, [](QXmlStreamReader & reader, MindMapData & data) {
+             data.setGridColor(readColor(reader));
+         } },
+        { ELEMENT_EDGE_THICKNESS, [](QXmlStreamReader & reader, MindMapData & data) {
+             data.setEdgeWidth(readText(reader).toDouble() / SCALE);
+         } },
+        { ELEMENT_TEXT_SIZE, [](QXmlStreamReader & reader, MindMapData & data) {
+             data.setTextSize(static_cast<int>(readText(reader).toDouble() / SCALE));
+         } },
+        { ELEMENT_CORNER_RADIUS, [](QXmlStreamReader & reader, MindMapData & data) {
+             data.setCornerRadius(static_cast<int>(readText(reader).toDouble() / SCALE));
+         } }
+    };
+    return handlerMap;
+}
+
+void readStyle(QXmlStreamReader & reader, MindMapData & data)
+{
+    readChildren(reader, data, styleHandlerMap());
+}
+
+// V1 has the style elements directly under the root element
+const HandlerMap<MindMapData> & rootHandlerMap()
+{
+    static const auto handlerMap = [] {
+        auto handlerMap = styleHandlerMap();
+        handlerMap[DataKeywords::MindMap::ELEMENT_GRAPH] = readGraph;
+        handlerMap[DataKeywords::MindMap::ELEMENT_IMAGE] = readImage;
+        handlerMap[DataKeywords::MindMap::LayoutOptimizer::ELEMENT_LAYOUT_OPTIMIZER] = readLayoutOptimizer;
+        handlerMap[DataKeywords::MindMap::V2::Metadata::ELEMENT_HEADER] = [](QXmlStreamReader & reader, MindMapData &) {
+            // Everything in the header is also in the rest of the file
+            reader.skipCurrentElement();
+        };
+        handlerMap[DataKeywords::MindMap::V2::Metadata::ELEMENT_METADATA] = readMetadata;
+        handlerMap[DataKeywords::MindMap::V2::Style::ELEMENT_STYLE] = readStyle;
+        return handlerMap;
+    }();
+    return handlerMap;
+}
+
+//! Calls the parser with a reader positioned before the root element of the given device, inflating it if compressed.
+//! \param sourceName The file path or the URL of the data for the error messages.
+template<typename Parser>
+void parseDevice(QIODevice & device, QString sourceName, Parser && parser)
+{
+    // Compressed data is inflated chunk by chunk while parsing
+    CompressedDevice compressedDevice(device);
+    const bool isCompressed = CompressedDevice::isCompressed(device);
+    if (isCompressed && !compressedDevice.open(QIODevice::ReadOnly)) {
+        throw FileException(QObject::tr("Corrupted file: '") + sourceName + "'");
+    }
+
+    QXmlStreamReader reader(isCompressed ? static_cast<QIODevice *>(&compressedDevice) : &device);
+    try {
+        parser(reader);
+    } catch (const FileException &) {
+        throw;
+    } catch (const std::runtime_error & e) {
+        // E.g. an invalid node index
+        juzzlin::L(TAG).warning() << "Invalid data: " << e.what();
+        throw FileException(QObject::tr("Corrupted file: '") + sourceName + "'");
+    }
+
+    if (reader.hasError()) {
+        juzzlin::L(TAG).warning() << "Parse error: " << reader.errorString().toStdString();
+        throw FileException(QObject::tr("Corrupted file: '") + sourceName + "'");
+    }
+}
+
+//! Opens the given file and calls the parser like parseDevice() does.
+template<typename Parser>
+void parseFile(QString filePath, Parser && parser)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw FileException(QObject::tr("Cannot open file: '") + filePath + "'");
+    }
+
+    parseDevice(file, filePath, std::forward<Parser>(parser));
+}
+
+void readMindMap(QXmlStreamReader & reader, MindMapData & data)
+{
+    if (reader.readNextStartElement()) {
+        const auto undefinedVersion = "UNDEFINED";
+        data.setApplicationVersion(attribute(reader, DataKeywords::MindMap::V2::ATTRIBUTE_APPLICATION_VERSION,
+                                             attribute(reader, DataKeywords::MindMap::ATTRIBUTE_APPLICATION_VERSION, undefinedVersion)));
+
+        data.setAlzFormatVersion(static_cast<IO::AlzFormatVersion>(attribute(reader, DataKeywords::MindMap::V2::ATTRIBUTE_ALZ_FORMAT_VERSION, "1").toInt()));
+
+        readChildren(reader, data, rootHandlerMap());
+    }
+}
+
+} // namespace
+
+// Import always assumes the newest ALZ-format version, but it's backwards compatible
+MindMapDataU AlzStreamReader::readFromFile(QString filePath)
+{
+    auto data = std::make_unique<MindMapData>();
+
+    parseFile(filePath, [&data](QXmlStreamReader & reader) {
+        readMindMap(reader, *data);
+    });
+
+    return data;
+}
+
+MindMapDataU AlzStreamReader::readFromDevice(QIODevice & device, QString sourceName)
+{
+    auto data = std::make_unique<MindMapData>();
+
+    parseDevice(device, sourceName, [&data](QXmlStreamReader & reader) {
+        readMindMap(reader, *data);
+    });
+
+    return data;
+}
+
+QStringList AlzStreamReader::readTexts(QString filePath)
+{
+    using namespace DataKeywords::MindMap;
+
+    QStringList texts;
+    parseFile(filePath, [&texts](QXmlStreamReader & reader) {
+        // Only the text elements directly under a node or an edge are wanted, wherever the graph is
+        bool isInNodeOrEdge = false;
+        while (!reader.atEnd()) {
+            switch (reader.readNext()) {
+            case QXmlStreamReader::StartElement:
+                if (reader.name() == QLatin1String { Graph::ELEMENT_NODE } || reader.name() == QLatin1String { Graph::ELEMENT_EDGE }) {
+                    isInNodeOrEdge = true;
+                } else if (isInNodeOrEdge && reader.name() == QLatin1String { Graph::Node::ELEMENT_TEXT }) {
+                    if (const auto text = readText(reader); !text.isEmpty()) {
+                        texts << text;
+                    }
+                } else if (reader.name() == QLatin1String { ELEMENT_IMAGE }) {
+                    reader.skipCurrentElement();
+                }
+                break;
+            case QXmlStreamReader::EndElement:
+                if (reader.name() == QLatin1String { Graph::ELEMENT_NODE } || reader.name() == QLatin1String { Graph::ELEMENT_EDGE }) {
+                    isInNodeOrEdge = false;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    });
+
+    return texts;
+}
+
+std::optional<MindMapHeader> AlzStreamReader::readHeader(QString filePath)
+{
+    using namespace DataKeywords::MindMap;
+
+    std::optional<MindMapHeader> result;
+    parseFile(filePath, [&result](QXmlStreamReader & reader) {
+        if (!reader.readNextStartElement()) {
+            return;
+        }
+
+        const auto applicationVersion = attribute(reader, V2::ATTRIBUTE_APPLICATION_VERSION, attribute(reader, ATTRIBUTE_APPLICATION_VERSION));
+
+        // Nothing after the first child is read, so large files cost the same as small ones
+        if (!reader.readNextStartElement() || reader.name() != QLatin1String { V2::Metadata::ELEMENT_HEADER }) {
+            return;
+        }
+
+        using namespace V2::Metadata;
+        MindMapHeader header;
+        header.applicationVersion = applicationVersion;
+        header.nodeCount = attribute(reader, Header::ATTRIBUTE_NODE_COUNT, "0").toULongLong();
+        header.edgeCount = attribute(reader, Header::ATTRIBUTE_EDGE_COUNT, "0").toULongLong();
+        header.bounds = QRectF(
+          attribute(reader, Header::ATTRIBUTE_X, "0").toInt() / SCALE,
+          attribute(reader, Header::ATTRIBUTE_Y, "0").toInt() / SCALE,
+          attribute(reader, Header::ATTRIBUTE_W, "0").toInt() / SCALE,
+          attribute(reader, Header::ATTRIBUTE_H, "0").toInt() / SCALE);
+
+        while (reader.readNextStartElement()) {
+            if (reader.name() == QLatin1String { Header::ELEMENT_THUMBNAIL }) {
+                header.thumbnail = Base64::decode(reader.readElementText().toLatin1());
+            } else {
+                reader.skipCurrentElement();
+            }
+        }
+
+        result = header;
+    });
+
+    return result;
+}
+
+FileSections AlzStreamReader::readSections(QString filePath)
+{
+    FileSections sections;
+    parseFile(filePath, [&sections](QXmlStreamReader & reader) {
+        if (!reader.readNextStartElement()) {
+            return;
+        }
+
+        // The whitespace before each element is counted to it, so that the sections add up to the whole root element
+        auto start = reader.characterOffset();
+        while (reader.readNextStartElement()) {
+            const auto name = reader.name().toString();
+            reader.skipCurrentElement();
+            auto section = std::find_if(sections.begin(), sections.end(), [&name](auto && section) {
+                return section.name == name;
+            });
+            if (section == sections.end()) {
+                section = sections.insert(sections.end(), { name, 0, 0 });
+            }
+            section->size += reader.characterOffset() - start;
+            section->count++;
+            start = reader.characterOffset();
+        }
+    });
+
+    return sections;
+}
+
+} // namespace IO
@@ -0,0 +1,60 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ALZ_STREAM_READER_HPP
+#define ALZ_STREAM_READER_HPP
+
+#include <QString>
+#include <QStringList>
+
+#include "../../common/types.hpp"
+#include "file_section.hpp"
+#include "mind_map_header.hpp"
+
+#include <optional>
+
+class QIODevice;
+
+namespace IO::AlzStreamReader {
+
+//! Reads a mind map from the given ALZ-file in a single pass with QXmlStreamReader
+//! without building an intermediate QDomDocument.
+//! \throws FileException if the file cannot be opened or parsed.
+MindMapDataU readFromFile(QString filePath);
+
+//! Reads a mind map from the given ALZ-data like readFromFile() does, e.g. while the data is being downloaded.
+//! The device is read sequentially only, so it doesn't need to have all of the data yet.
+//! \param sourceName The file path or the URL of the data for the error messages.
+//! \throws FileException if the data cannot be parsed.
+MindMapDataU readFromDevice(QIODevice & device, QString sourceName);
+
+//! Reads only the texts of the nodes and the edges from the given ALZ-file, e.g. for indexing,
+//! skipping the styles and the embedded images without decoding them. Empty texts are left out.
+//! \throws FileException if the file cannot be opened or parsed.
+QStringList readTexts(QString filePath);
+
+//! Reads the root element and the header that directly follows it from the given ALZ-file and stops there.
+//! \return The header, or nothing if the file was written by a version without headers.
+//! \throws FileException if the file cannot be opened or parsed.
+std::optional<MindMapHeader> readHeader(QString filePath);
+
+//! Skips through the elements under the root element of the given ALZ-file without reading them, e.g. for an analysis.
+//! \return The sizes of the elements merged by name in the order of the file, e.g. one section for all the images.
+//! \throws FileException if the file cannot be opened or parsed.
+FileSections readSections(QString filePath);
+
+} // namespace IO::AlzStreamReader
+
+#endif // ALZ_STREAM_READER_HPP
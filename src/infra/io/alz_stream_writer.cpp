@@ -0,0 +1,483 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "alz_stream_writer.hpp"
+
+#include "../../application/service_container.hpp"
+#include "../../application/task_pool.hpp"
+#include "../../common/constants.hpp"
+#include "../../common/utils.hpp"
+#include "../../domain/graph_snapshot.hpp"
+#include "../../domain/image_manager.hpp"
+#include "../../domain/layout_cache.hpp"
+#include "../../domain/mind_map_data.hpp"
+#include "alz_data_keywords.hpp"
+#include "base64.hpp"
+#include "compressed_device.hpp"
+#include "mind_map_header.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QSaveFile>
+#include <QXmlStreamWriter>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <set>
+
+namespace IO {
+
+static const auto TAG = "AlzStreamWriter";
+
+namespace {
+
+const int INDENT = 1;
+
+// Enough work per thread to outweigh starting it
+const size_t minItemsPerThread = 2000;
+
+//! Writes already formatted UTF-8 data past the QXmlStreamWriter.
+using RawWriter = std::function<void(const QByteArray &)>;
+
+// Formats floating point attributes the same way as QDomElement::setAttribute(QString, double)
+QString doubleToString(double value)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    return QString::number(value, 'g', QLocale::FloatingPointShortest);
+#else
+    return QString::number(value, 'g', 17);
+#endif
+}
+
+// Writes the data as base64 in chunks so that a large image is never held as one big base64 string
+void writeBase64(QXmlStreamWriter & writer, const QByteArray & data)
+{
+    Base64::encode(data, [&writer](const QByteArray & encodedChunk) {
+        writer.writeCharacters(QString::fromLatin1(encodedChunk));
+    });
+}
+
+void writeColor(QXmlStreamWriter & writer, QColor color, QString elementName)
+{
+    writer.writeEmptyElement(elementName);
+    writer.writeAttribute(DataKeywords::MindMap::Color::ATTRIBUTE_R, QString::number(color.red()));
+    writer.writeAttribute(DataKeywords::MindMap::Color::ATTRIBUTE_G, QString::number(color.green()));
+    writer.writeAttribute(DataKeywords::MindMap::Color::ATTRIBUTE_B, QString::number(color.blue()));
+}
+
+void writeScaledElement(QXmlStreamWriter & writer, QString elementName, double value)
+{
+    writer.writeTextElement(elementName, QString::number(static_cast<int>(value * SCALE)));
+}
+
+void writeNode(QXmlStreamWriter & writer, const SceneItems::NodeModel & node, AlzFormatVersion outputVersion)
+{
+    using namespace DataKeywords::MindMap::Graph;
+
+    writer.writeStartElement(ELEMENT_NODE);
+    writer.writeAttribute(outputVersion == AlzFormatVersion::V1 ? Node::ATTRIBUTE_INDEX : Node::V2::ATTRIBUTE_INDEX, QString::number(node.index));
+    writer.writeAttribute(Node::ATTRIBUTE_X, QString::number(static_cast<int>(node.location.x() * SCALE)));
+    writer.writeAttribute(Node::ATTRIBUTE_Y, QString::number(static_cast<int>(node.location.y() * SCALE)));
+    writer.writeAttribute(Node::ATTRIBUTE_W, QString::number(static_cast<int>(node.size.width() * SCALE)));
+    writer.writeAttribute(Node::ATTRIBUTE_H, QString::number(static_cast<int>(node.size.height() * SCALE)));
+    if (node.collapsed) {
+        writer.writeAttribute(Node::ATTRIBUTE_COLLAPSED, "1");
+    }
+    if (!node.uuid.isNull()) {
+        writer.writeAttribute(Node::ATTRIBUTE_UUID, node.uuid.toString());
+    }
+
+    if (!node.text.isEmpty()) {
+        writer.writeTextElement(Node::ELEMENT_TEXT, node.text.toString());
+    }
+
+    writeColor(writer, node.color, Node::ATTRIBUTE_COLOR);
+
+    writeColor(writer, node.textColor, Node::ATTRIBUTE_TEXT_COLOR);
+
+    if (node.imageRef) {
+        writer.writeEmptyElement(Node::ATTRIBUTE_IMAGE);
+        writer.writeAttribute(Node::Image::ATTRIBUTE_REF, QString::number(static_cast<int>(node.imageRef)));
+    }
+
+    writer.writeEndElement();
+}
+
+void writeEdge(QXmlStreamWriter & writer, const GraphSnapshot::EdgeData & edge, AlzFormatVersion outputVersion)
+{
+    using namespace DataKeywords::MindMap::Graph;
+
+    writer.writeStartElement(ELEMENT_EDGE);
+    writer.writeAttribute(Edge::ATTRIBUTE_ARROW_MODE, QString::number(static_cast<int>(edge.model.style.arrowMode)));
+    if (edge.model.style.dashedLine) {
+        writer.writeAttribute(Edge::ATTRIBUTE_DASHED_LINE, QString::number(edge.model.style.dashedLine));
+    }
+    writer.writeAttribute(outputVersion == AlzFormatVersion::V1 ? Edge::ATTRIBUTE_INDEX0 : Edge::V2::ATTRIBUTE_INDEX0, QString::number(edge.sourceIndex));
+    writer.writeAttribute(outputVersion == AlzFormatVersion::V1 ? Edge::ATTRIBUTE_INDEX1 : Edge::V2::ATTRIBUTE_INDEX1, QString::number(edge.targetIndex));
+    if (edge.model.reversed) {
+        writer.writeAttribute(Edge::ATTRIBUTE_REVERSED, QString::number(edge.model.reversed));
+    }
+
+    if (!edge.model.text.isEmpty()) {
+        writer.writeTextElement(Node::ELEMENT_TEXT, edge.model.text.toString());
+    }
+
+    writer.writeEndElement();
+}
+
+//! Formats single nodes and edges exactly like they would be formatted inside the graph element of the document.
+class FragmentWriter
+{
+public:
+    explicit FragmentWriter(AlzFormatVersion outputVersion)
+      : m_writer(&m_fragment)
+      , m_outputVersion(outputVersion)
+    {
+        m_writer.setAutoFormatting(true);
+        m_writer.setAutoFormattingIndent(INDENT);
+        m_writer.writeStartElement(DataKeywords::MindMap::ELEMENT_HEIMER_MIND_MAP);
+        m_writer.writeStartElement(DataKeywords::MindMap::ELEMENT_GRAPH);
+        // A complete dummy child closes the start tag of the graph, so that every fragment begins like a sibling of a previous one
+        m_writer.writeStartElement(DataKeywords::MindMap::Graph::ELEMENT_NODE);
+        m_writer.writeEndElement();
+    }
+
+    QString write(const SceneItems::NodeModel & node)
+    {
+        m_fragment.clear();
+        writeNode(m_writer, node, m_outputVersion);
+        return m_fragment;
+    }
+
+    QString write(const GraphSnapshot::EdgeData & edge)
+    {
+        m_fragment.clear();
+        writeEdge(m_writer, edge, m_outputVersion);
+        return m_fragment;
+    }
+
+private:
+    QString m_fragment;
+
+    QXmlStreamWriter m_writer;
+
+    AlzFormatVersion m_outputVersion;
+};
+
+int key(const SceneItems::NodeModel & node)
+{
+    return node.index;
+}
+
+int64_t key(const GraphSnapshot::EdgeData & edge)
+{
+    return (int64_t(edge.sourceIndex) << 32) + edge.targetIndex;
+}
+
+// The items are formatted in parallel chunks, each with its own writer, into UTF-8 buffers that are then written in order.
+// The fragments of unchanged items are taken from the cache, and afterwards the cache contains exactly the written items.
+template<typename Item, typename Key>
+void writeFragments(const RawWriter & writeRaw, const std::vector<Item> & items, std::unordered_map<Key, AlzStreamWriter::FragmentCache::Entry<Item>> & cacheEntries,
+                    bool updateCache, size_t & reusedCount, AlzFormatVersion outputVersion)
+{
+    std::vector<QString> fragments(updateCache ? items.size() : 0);
+    auto && taskPool = *SC::instance().taskPool();
+    const auto threadCount = taskPool.chunkCount(items.size(), minItemsPerThread);
+    const auto chunkSize = (items.size() + threadCount - 1) / threadCount;
+    std::vector<QByteArray> chunks(threadCount);
+    std::atomic<size_t> reused { 0 };
+    const auto formatChunk = [&](size_t chunk) {
+        FragmentWriter fragmentWriter { outputVersion };
+        QString chunkFragments;
+        size_t chunkReused = 0;
+        for (size_t i = chunk * chunkSize; i < std::min((chunk + 1) * chunkSize, items.size()); i++) {
+            auto && item = items.at(i);
+            QString fragment;
+            if (const auto iter = cacheEntries.find(key(item)); iter != cacheEntries.end() && GraphSnapshot::equals(iter->second.data, item)) {
+                fragment = iter->second.fragment;
+                chunkReused++;
+            } else {
+                fragment = fragmentWriter.write(item);
+            }
+            chunkFragments += fragment;
+            if (updateCache) {
+                fragments.at(i) = fragment;
+            }
+        }
+        chunks.at(chunk) = chunkFragments.toUtf8();
+        reused += chunkReused;
+    };
+
+    taskPool.run(threadCount, formatChunk);
+
+    for (auto && chunk : chunks) {
+        writeRaw(chunk);
+    }
+
+    reusedCount += reused;
+
+    cacheEntries.clear();
+    if (updateCache) {
+        cacheEntries.reserve(items.size());
+        for (size_t i = 0; i < items.size(); i++) {
+            cacheEntries.emplace(key(items.at(i)), AlzStreamWriter::FragmentCache::Entry<Item> { items.at(i), fragments.at(i) });
+        }
+    }
+}
+
+void writeGraph(QXmlStreamWriter & writer, const RawWriter & writeRaw, const GraphSnapshot & graphSnapshot,
+                AlzFormatVersion outputVersion, AlzStreamWriter::FragmentCache * fragmentCache)
+{
+    if (graphSnapshot.nodes().empty() && graphSnapshot.edges().empty()) {
+        writer.writeStartElement(DataKeywords::MindMap::ELEMENT_GRAPH);
+        writer.writeEndElement();
+        return;
+    }
+
+    AlzStreamWriter::FragmentCache unusedCache;
+    auto & cache = fragmentCache ? *fragmentCache : unusedCache;
+    if (cache.outputVersion != outputVersion) {
+        cache = {};
+        cache.outputVersion = outputVersion;
+    }
+    cache.reusedCount = 0;
+
+    const auto graphIndent = "\n" + QString(INDENT, ' ');
+
+    writeRaw((graphIndent + "<" + DataKeywords::MindMap::ELEMENT_GRAPH + ">").toUtf8());
+
+    writeFragments(writeRaw, graphSnapshot.nodes(), cache.nodes, fragmentCache != nullptr, cache.reusedCount, outputVersion);
+
+    writeFragments(writeRaw, graphSnapshot.edgesBySourceNode(), cache.edges, fragmentCache != nullptr, cache.reusedCount, outputVersion);
+
+    writeRaw((graphIndent + "</" + DataKeywords::MindMap::ELEMENT_GRAPH + ">").toUtf8());
+}
+
+void writeHeader(QXmlStreamWriter & writer, MindMapDataS mindMapData, const GraphSnapshot & graphSnapshot)
+{
+    using namespace DataKeywords::MindMap::V2::Metadata;
+
+    const auto header = MindMapHeader::fromMindMap(*mindMapData, graphSnapshot);
+    writer.writeStartElement(ELEMENT_HEADER);
+    writer.writeAttribute(Header::ATTRIBUTE_NODE_COUNT, QString::number(header.nodeCount));
+    writer.writeAttribute(Header::ATTRIBUTE_EDGE_COUNT, QString::number(header.edgeCount));
+    writer.writeAttribute(Header::ATTRIBUTE_X, QString::number(static_cast<int>(header.bounds.x() * SCALE)));
+    writer.writeAttribute(Header::ATTRIBUTE_Y, QString::number(static_cast<int>(header.bounds.y() * SCALE)));
+    writer.writeAttribute(Header::ATTRIBUTE_W, QString::number(static_cast<int>(header.bounds.width() * SCALE)));
+    writer.writeAttribute(Header::ATTRIBUTE_H, QString::number(static_cast<int>(header.bounds.height() * SCALE)));
+    if (!header.thumbnail.isEmpty()) {
+        writer.writeStartElement(Header::ELEMENT_THUMBNAIL);
+        writeBase64(writer, header.thumbnail);
+        writer.writeEndElement();
+    }
+    writer.writeEndElement();
+}
+
+void writeStyle(QXmlStreamWriter & writer, MindMapDataS mindMapData, AlzFormatVersion outputVersion)
+{
+    using namespace DataKeywords::MindMap;
+
+    if (outputVersion != AlzFormatVersion::V1) {
+        writer.writeStartElement(V2::Style::ELEMENT_STYLE);
+    }
+
+    writeColor(writer, mindMapData->backgroundColor(), ELEMENT_COLOR);
+
+    writeColor(writer, mindMapData->edgeColor(), ELEMENT_EDGE_COLOR);
+
+    writeColor(writer, mindMapData->gridColor(), ELEMENT_GRID_COLOR);
+
+    writeScaledElement(writer, ELEMENT_ARROW_SIZE, mindMapData->arrowSize());
+
+    writeScaledElement(writer, ELEMENT_EDGE_THICKNESS, mindMapData->edgeWidth());
+
+    const auto font = mindMapData->font();
+    writer.writeStartElement(ELEMENT_FONT_FAMILY);
+    writer.writeAttribute(ATTRIBUTE_FONT_BOLD, QString::number(font.bold()));
+    writer.writeAttribute(ATTRIBUTE_FONT_ITALIC, QString::number(font.italic()));
+    writer.writeAttribute(ATTRIBUTE_FONT_OVERLINE, QString::number(font.overline()));
+    writer.writeAttribute(ATTRIBUTE_FONT_STRIKE_OUT, QString::number(font.strikeOut()));
+    writer.writeAttribute(ATTRIBUTE_FONT_UNDERLINE, QString::number(font.underline()));
+    writer.writeAttribute(ATTRIBUTE_FONT_WEIGHT, QString::number(Utils::fontWeightToInt(font.weight())));
+    writer.writeCharacters(font.family());
+    writer.writeEndElement();
+
+    writeScaledElement(writer, ELEMENT_TEXT_SIZE, mindMapData->textSize());
+
+    writeScaledElement(writer, ELEMENT_CORNER_RADIUS, mindMapData->cornerRadius());
+
+    if (outputVersion != AlzFormatVersion::V1) {
+        writer.writeEndElement();
+    }
+}
+
+void writeImages(QXmlStreamWriter & writer, MindMapDataS mindMapData, const GraphSnapshot & graphSnapshot)
+{
+    std::set<size_t> writtenImageRefs;
+    for (auto && node : graphSnapshot.nodes()) {
+        if (node.imageRef) {
+            if (writtenImageRefs.count(node.imageRef)) {
+                juzzlin::L(TAG).debug() << "Image id=" << node.imageRef << " already written";
+            } else {
+                if (const auto image = mindMapData->imageManager().getImage(node.imageRef); image) {
+                    writer.writeStartElement(DataKeywords::MindMap::ELEMENT_IMAGE);
+                    writer.writeAttribute(DataKeywords::MindMap::Image::ATTRIBUTE_ID, QString::number(static_cast<int>(image->id())));
+                    writer.writeAttribute(DataKeywords::MindMap::Image::ATTRIBUTE_PATH, image->path().c_str());
+
+                    // Write the image content as encoded when the image was attached or loaded without touching the pixel data
+                    writeBase64(writer, image->data());
+                    writtenImageRefs.insert(image->id());
+
+                    writer.writeEndElement();
+                } else {
+                    throw std::runtime_error("Image id=" + std::to_string(node.imageRef) + " doesn't exist!");
+                }
+            }
+        }
+    }
+}
+
+void writeCachedLayout(QXmlStreamWriter & writer, const LayoutCache::Entry & entry)
+{
+    using namespace DataKeywords::MindMap::LayoutOptimizer;
+    writer.writeStartElement(ELEMENT_CACHED_LAYOUT);
+    writer.writeAttribute(CachedLayout::ATTRIBUTE_KEY, QString::number(entry.key, 16));
+    writer.writeAttribute(CachedLayout::ATTRIBUTE_TOPOLOGY_KEY, QString::number(entry.topologyKey, 16));
+    for (auto && [index, location] : entry.layout) {
+        writer.writeEmptyElement(CachedLayout::ELEMENT_NODE);
+        writer.writeAttribute(CachedLayout::Node::ATTRIBUTE_INDEX, QString::number(index));
+        writer.writeAttribute(CachedLayout::Node::ATTRIBUTE_X, QString::number(static_cast<int>(location.x() * SCALE)));
+        writer.writeAttribute(CachedLayout::Node::ATTRIBUTE_Y, QString::number(static_cast<int>(location.y() * SCALE)));
+    }
+    writer.writeEndElement();
+}
+
+// Only the latest layout is saved, and only if the mind map still has the same structure
+std::optional<LayoutCache::Entry> cachedLayout(MindMapDataS mindMapData, const GraphSnapshot & graphSnapshot, const std::optional<GraphSnapshot> & densifiedSnapshot)
+{
+    const auto entry = mindMapData->layoutCache().latest();
+    if (!entry || entry->topologyKey != LayoutCache::topologyKey(graphSnapshot)) {
+        return {};
+    }
+
+    if (!densifiedSnapshot) {
+        return entry;
+    }
+
+    return LayoutCache::renumbered(*entry, graphSnapshot.denseIndexMap(), LayoutCache::topologyKey(*densifiedSnapshot));
+}
+
+void writeMetadata(QXmlStreamWriter & writer, MindMapDataS mindMapData, const std::optional<LayoutCache::Entry> & cachedLayout, AlzFormatVersion outputVersion)
+{
+    if (outputVersion != AlzFormatVersion::V1) {
+        writer.writeStartElement(DataKeywords::MindMap::V2::Metadata::ELEMENT_METADATA);
+    }
+
+    using namespace DataKeywords::MindMap::LayoutOptimizer;
+    writer.writeStartElement(ELEMENT_LAYOUT_OPTIMIZER);
+    writer.writeAttribute(ATTRIBUTE_ASPECT_RATIO, doubleToString(mindMapData->aspectRatio() * SCALE));
+    writer.writeAttribute(ATTRIBUTE_MIN_EDGE_LENGTH, doubleToString(mindMapData->minEdgeLength() * SCALE));
+
+    if (outputVersion != AlzFormatVersion::V1 && cachedLayout) {
+        writeCachedLayout(writer, *cachedLayout);
+    }
+
+    writer.writeEndElement();
+
+    if (outputVersion != AlzFormatVersion::V1) {
+        writer.writeEndElement();
+    }
+}
+
+void writeMindMap(QXmlStreamWriter & writer, const RawWriter & writeRaw, MindMapDataS mindMapData, AlzFormatVersion outputVersion, AlzStreamWriter::FragmentCache * fragmentCache)
+{
+    writer.setAutoFormatting(true);
+    writer.setAutoFormattingIndent(INDENT);
+
+    // Keep the declaration exactly as it used to be written by QDomDocument
+    writer.writeProcessingInstruction("xml", "version='1.0' encoding='UTF-8'");
+
+    writer.writeStartElement(DataKeywords::MindMap::ELEMENT_HEIMER_MIND_MAP);
+    if (outputVersion == AlzFormatVersion::V1) {
+        writer.writeAttribute(DataKeywords::MindMap::ATTRIBUTE_APPLICATION_VERSION, Constants::Application::applicationVersion());
+    } else {
+        writer.writeAttribute(DataKeywords::MindMap::V2::ATTRIBUTE_APPLICATION_VERSION, Constants::Application::applicationVersion());
+        writer.writeAttribute(DataKeywords::MindMap::V2::ATTRIBUTE_ALZ_FORMAT_VERSION, QString::number(static_cast<int>(Constants::Application::alzFormatVersion())));
+    }
+
+    // Written from plain data, so that e.g. a snapshot handed to the worker thread never creates scene items
+    const auto graphSnapshot = mindMapData->graphSnapshot();
+
+    // The nodes are saved with the dense indices 0..n-1 in order, so that loading needs no index lookups
+    const auto densifiedSnapshot = graphSnapshot.hasDenseIndices() ? std::optional<GraphSnapshot> {} : graphSnapshot.renumbered(graphSnapshot.denseIndexMap());
+    const auto & savedSnapshot = densifiedSnapshot ? *densifiedSnapshot : graphSnapshot;
+
+    if (outputVersion != AlzFormatVersion::V1) {
+        writeHeader(writer, mindMapData, savedSnapshot);
+    }
+
+    writeStyle(writer, mindMapData, outputVersion);
+
+    writeGraph(writer, writeRaw, savedSnapshot, outputVersion, fragmentCache);
+
+    writeImages(writer, mindMapData, savedSnapshot);
+
+    writeMetadata(writer, mindMapData, cachedLayout(mindMapData, graphSnapshot, densifiedSnapshot), outputVersion);
+
+    writer.writeEndDocument();
+}
+
+} // namespace
+
+bool AlzStreamWriter::writeToFile(MindMapDataS mindMapData, QString filePath, AlzFormatVersion outputVersion, bool compress, FragmentCache * fragmentCache)
+{
+    // Written to a temporary file that atomically replaces the target on commit, so that
+    // a crash in the middle of a save never leaves a truncated file behind
+    QSaveFile file(filePath);
+    if (!file.open(compress ? QIODevice::WriteOnly : QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+
+    // Compressed output is deflated chunk by chunk while writing
+    CompressedDevice compressedDevice(file);
+    if (compress && !compressedDevice.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    const auto device = compress ? static_cast<QIODevice *>(&compressedDevice) : &file;
+    QXmlStreamWriter writer(device);
+    writeMindMap(
+      writer, [device](const QByteArray & data) { device->write(data); }, mindMapData, outputVersion, fragmentCache);
+    if (writer.hasError() || !compressedDevice.finish() || !file.commit()) {
+        juzzlin::L(TAG).error() << "Failed to write '" << filePath.toStdString() << "': " << file.errorString().toStdString();
+        return false;
+    }
+
+    return true;
+}
+
+QString AlzStreamWriter::writeToString(MindMapDataS mindMapData, AlzFormatVersion outputVersion)
+{
+    QString xml;
+    QXmlStreamWriter writer(&xml);
+    writeMindMap(
+      writer, [&xml](const QByteArray & data) { xml += QString::fromUtf8(data); }, mindMapData, outputVersion, nullptr);
+    return xml;
+}
+
+} // namespace IO
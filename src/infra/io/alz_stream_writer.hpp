@@ -0,0 +1,67 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ALZ_STREAM_WRITER_HPP
+#define ALZ_STREAM_WRITER_HPP
+
+#include <QString>
+
+#include "alz_file_io_version.hpp"
+
+#include "../../common/types.hpp"
+#include "../../domain/graph_snapshot.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+
+namespace IO::AlzStreamWriter {
+
+//! Serialized XML of the nodes and edges of the previous save together with the data they were formatted from.
+//! Most saves change only a few items, so the fragments of the unchanged ones are written as they are.
+struct FragmentCache
+{
+    template<typename Data>
+    struct Entry
+    {
+        Data data;
+
+        QString fragment;
+    };
+
+    std::optional<AlzFormatVersion> outputVersion;
+
+    std::unordered_map<int, Entry<SceneItems::NodeModel>> nodes;
+
+    std::unordered_map<int64_t, Entry<GraphSnapshot::EdgeData>> edges;
+
+    //! Number of fragments that were reused in the latest save.
+    size_t reusedCount = 0;
+};
+
+//! Writes the mind map directly to the given file with QXmlStreamWriter.
+//! The layout matches the former QDomDocument-based output: one-space indentation,
+//! the same XML declaration and the same element and attribute order.
+//! \param compress Wraps the XML into a CompressedDevice container.
+//! \param fragmentCache Reused and updated if given. Must not be shared between threads.
+//! \return true on success.
+bool writeToFile(MindMapDataS mindMapData, QString filePath, AlzFormatVersion outputVersion, bool compress = false, FragmentCache * fragmentCache = nullptr);
+
+//! Like writeToFile(), but writes into a string.
+QString writeToString(MindMapDataS mindMapData, AlzFormatVersion outputVersion);
+
+} // namespace IO::AlzStreamWriter
+
+#endif // ALZ_STREAM_WRITER_HPP
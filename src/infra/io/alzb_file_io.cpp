@@ -0,0 +1,73 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "alzb_file_io.hpp"
+
+#include "../../domain/mind_map_data.hpp"
+#include "alzb_file_io_worker.hpp"
+
+#include <QThread>
+
+Q_DECLARE_METATYPE(MindMapDataS)
+
+namespace IO {
+
+AlzbFileIO::AlzbFileIO()
+  : m_worker(std::make_unique<AlzbFileIOWorker>())
+  , m_workerThread(std::make_unique<QThread>())
+{
+    qRegisterMetaType<MindMapDataS>();
+
+    if (!m_workerThread->isRunning()) {
+        m_workerThread->start();
+        m_worker->moveToThread(m_workerThread.get());
+    }
+}
+
+bool AlzbFileIO::isAlzbFile(QString path)
+{
+    return AlzbFileIOWorker::isAlzbFile(path);
+}
+
+void AlzbFileIO::finish()
+{
+    m_workerThread->quit();
+    m_workerThread->wait();
+}
+
+MindMapDataU AlzbFileIO::fromFile(QString path) const
+{
+    return m_worker->fromFile(path);
+}
+
+bool AlzbFileIO::toFile(MindMapDataS mindMapData, QString path, bool async) const
+{
+    const auto connectionType = async ? Qt::QueuedConnection : Qt::BlockingQueuedConnection;
+
+    // An asynchronous save gets a plain-data snapshot shared copy-on-write with the mind map,
+    // so that the caller can keep editing the mind map while the worker is writing the snapshot
+    const auto snapshot = async ? std::make_shared<MindMapData>(*mindMapData) : mindMapData;
+
+    return QMetaObject::invokeMethod(m_worker.get(), "toFile", connectionType,
+                                     Q_ARG(MindMapDataS, snapshot),
+                                     Q_ARG(QString, path));
+}
+
+AlzbFileIO::~AlzbFileIO()
+{
+    AlzbFileIO::finish();
+}
+
+} // namespace IO
@@ -0,0 +1,672 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "alzb_file_io_worker.hpp"
+
+#include "../../application/service_container.hpp"
+#include "../../application/task_pool.hpp"
+#include "../../common/constants.hpp"
+#include "../../common/trace_recorder.hpp"
+#include "../../common/utils.hpp"
+#include "../../domain/graph.hpp"
+#include "../../domain/graph_snapshot.hpp"
+#include "../../domain/image_manager.hpp"
+#include "../../domain/mind_map_data.hpp"
+#include "file_exception.hpp"
+#include "mind_map_header.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QBuffer>
+#include <QFile>
+#include <QSaveFile>
+#include <QObject>
+#include <QUuid>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <set>
+
+namespace IO {
+
+static const auto TAG = "AlzbFileIOWorker";
+
+namespace {
+
+const char MAGIC[] = { 'A', 'L', 'Z', 'B' };
+
+// Bump this whenever the layout of the records changes
+const quint32 FORMAT_VERSION = 4;
+
+// Version 1 files don't have the node flags and versions before 3 don't have the summary header
+const quint32 MIN_FORMAT_VERSION = 1;
+
+const quint32 FIRST_FORMAT_VERSION_WITH_HEADER = 3;
+
+// From version 4 on the nodes are saved in the order of their dense indices 0..n-1, which aren't written
+const quint32 FIRST_FORMAT_VERSION_WITH_DENSE_INDICES = 4;
+
+const int UUID_SIZE = 16;
+
+// Smallest possible records: dense nodes without an UUID or flags, and edges
+const qint64 MIN_NODE_RECORD_SIZE = 4 * sizeof(double) + 4 * sizeof(quint32);
+const qint64 MIN_EDGE_RECORD_SIZE = 3 * sizeof(quint32) + 2 * sizeof(quint8) + sizeof(quint16);
+
+// Enough work per thread to outweigh starting it
+const size_t minRecordsPerThread = 10000;
+
+namespace NodeFlags {
+const quint8 COLLAPSED = 0x1;
+const quint8 HAS_UUID = 0x2;
+} // namespace NodeFlags
+
+namespace EdgeFlags {
+const quint8 DASHED_LINE = 0x1;
+const quint8 REVERSED = 0x2;
+} // namespace EdgeFlags
+
+class Writer
+{
+public:
+    explicit Writer(QIODevice & device)
+      : m_device(device)
+    {
+    }
+
+    template<typename T>
+    void write(T value)
+    {
+        value = qToLittleEndian(value);
+        writeRaw(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    void write(double value)
+    {
+        quint64 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        write(bits);
+    }
+
+    void writeRaw(const char * data, qint64 size)
+    {
+        m_ok = m_ok && m_device.write(data, size) == size;
+    }
+
+    qint64 pos() const
+    {
+        return m_device.pos();
+    }
+
+    bool ok() const
+    {
+        return m_ok;
+    }
+
+private:
+    QIODevice & m_device;
+
+    bool m_ok = true;
+};
+
+class Reader
+{
+public:
+    Reader(const uchar * data, qint64 size, QString filePath)
+      : m_data(data)
+      , m_size(size)
+      , m_filePath(filePath)
+    {
+    }
+
+    template<typename T>
+    T read()
+    {
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return qFromLittleEndian(value);
+    }
+
+    double readDouble()
+    {
+        const auto bits = read<quint64>();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    const char * take(qint64 size)
+    {
+        if (size < 0 || m_pos + size > m_size) {
+            throw FileException(QObject::tr("Corrupted file: '") + m_filePath + "'");
+        }
+        const auto data = reinterpret_cast<const char *>(m_data + m_pos);
+        m_pos += size;
+        return data;
+    }
+
+    qint64 pos() const
+    {
+        return m_pos;
+    }
+
+    //! \return Upper bound for the count of records that can still follow, so that a corrupted count can't cause a huge allocation.
+    quint32 maxRecordCount(quint32 count, qint64 minRecordSize) const
+    {
+        return static_cast<quint32>(std::min<qint64>(count, (m_size - m_pos) / minRecordSize));
+    }
+
+    //! Returns a view to the given range without moving the cursor.
+    const char * at(quint64 offset, quint64 size) const
+    {
+        if (offset > static_cast<quint64>(m_size) || size > static_cast<quint64>(m_size) - offset) {
+            throw FileException(QObject::tr("Corrupted file: '") + m_filePath + "'");
+        }
+        return reinterpret_cast<const char *>(m_data + offset);
+    }
+
+private:
+    const uchar * m_data;
+
+    qint64 m_size;
+
+    qint64 m_pos = 0;
+
+    QString m_filePath;
+};
+
+class StringTable
+{
+public:
+    quint32 add(const QString & string)
+    {
+        if (string.isEmpty()) {
+            return 0;
+        }
+        if (const auto iter = m_indices.find(string); iter != m_indices.end()) {
+            return iter->second;
+        }
+        m_strings.push_back(string.toUtf8());
+        const auto index = static_cast<quint32>(m_strings.size());
+        m_indices[string] = index;
+        return index;
+    }
+
+    void write(Writer & writer) const
+    {
+        writer.write(static_cast<quint32>(m_strings.size()));
+        for (auto && string : m_strings) {
+            writer.write(static_cast<quint32>(string.size()));
+            writer.writeRaw(string.constData(), string.size());
+        }
+    }
+
+private:
+    std::vector<QByteArray> m_strings;
+
+    std::map<QString, quint32> m_indices;
+};
+
+// Index 0 is reserved for the empty string
+std::vector<QString> readStringTable(Reader & reader)
+{
+    std::vector<QString> strings(1);
+    const auto count = reader.read<quint32>();
+    for (quint32 i = 0; i < count; i++) {
+        const auto size = reader.read<quint32>();
+        strings.push_back(QString::fromUtf8(reader.take(size), static_cast<int>(size)));
+    }
+    return strings;
+}
+
+QString stringAt(const std::vector<QString> & strings, quint32 index, QString filePath)
+{
+    if (index >= strings.size()) {
+        throw FileException(QObject::tr("Corrupted file: '") + filePath + "'");
+    }
+    return strings.at(index);
+}
+
+std::vector<Image> usedImages(const MindMapData & mindMapData, const GraphSnapshot & graphSnapshot)
+{
+    std::vector<Image> images;
+    std::set<size_t> imageRefs;
+    for (auto && node : graphSnapshot.nodes()) {
+        if (node.imageRef && imageRefs.insert(node.imageRef).second) {
+            if (const auto image = mindMapData.imageManager().getImage(node.imageRef); image) {
+                images.push_back(*image);
+            } else {
+                throw std::runtime_error("Image id=" + std::to_string(node.imageRef) + " doesn't exist!");
+            }
+        }
+    }
+    return images;
+}
+
+// Writes the records in parallel chunks into buffers of their own and then the buffers in order
+void writeRecords(Writer & writer, size_t count, const std::function<void(Writer &, size_t)> & writeRecord)
+{
+    auto && taskPool = *SC::instance().taskPool();
+    const auto threadCount = taskPool.chunkCount(count, minRecordsPerThread);
+    const auto chunkSize = (count + threadCount - 1) / threadCount;
+    std::vector<QByteArray> chunks(threadCount);
+    const auto writeChunk = [&](size_t chunk) {
+        QBuffer buffer(&chunks.at(chunk));
+        buffer.open(QIODevice::WriteOnly);
+        Writer chunkWriter { buffer };
+        for (size_t i = chunk * chunkSize; i < std::min((chunk + 1) * chunkSize, count); i++) {
+            writeRecord(chunkWriter, i);
+        }
+    };
+
+    taskPool.run(threadCount, writeChunk);
+
+    for (auto && chunk : chunks) {
+        writer.writeRaw(chunk.constData(), chunk.size());
+    }
+}
+
+// Prefixed with its size, so that the full reader can skip it and the header reader doesn't need to read any further
+void writeHeaderSection(Writer & writer, const MindMapHeader & header)
+{
+    QByteArray data;
+    QBuffer buffer { &data };
+    buffer.open(QIODevice::WriteOnly);
+    Writer headerWriter { buffer };
+    const auto applicationVersion = header.applicationVersion.toUtf8();
+    headerWriter.write(static_cast<quint32>(applicationVersion.size()));
+    headerWriter.writeRaw(applicationVersion.constData(), applicationVersion.size());
+    headerWriter.write(static_cast<quint64>(header.nodeCount));
+    headerWriter.write(static_cast<quint64>(header.edgeCount));
+    headerWriter.write(header.bounds.x());
+    headerWriter.write(header.bounds.y());
+    headerWriter.write(header.bounds.width());
+    headerWriter.write(header.bounds.height());
+    headerWriter.write(static_cast<quint32>(header.thumbnail.size()));
+    headerWriter.writeRaw(header.thumbnail.constData(), header.thumbnail.size());
+
+    writer.write(static_cast<quint32>(data.size()));
+    writer.writeRaw(data.constData(), data.size());
+}
+
+MindMapHeader readHeaderSection(Reader & reader)
+{
+    MindMapHeader header;
+    const auto applicationVersionSize = reader.read<quint32>();
+    header.applicationVersion = QString::fromUtf8(reader.take(applicationVersionSize), static_cast<int>(applicationVersionSize));
+    header.nodeCount = reader.read<quint64>();
+    header.edgeCount = reader.read<quint64>();
+    const auto x = reader.readDouble();
+    const auto y = reader.readDouble();
+    const auto w = reader.readDouble();
+    const auto h = reader.readDouble();
+    header.bounds = { x, y, w, h };
+    const auto thumbnailSize = reader.read<quint32>();
+    header.thumbnail = QByteArray { reader.take(thumbnailSize), static_cast<int>(thumbnailSize) };
+    return header;
+}
+
+void writeMindMap(Writer & writer, const MindMapData & mindMapData)
+{
+    // Written from plain data, so that e.g. a snapshot handed to the worker thread never creates scene items
+    const auto graphSnapshot = mindMapData.graphSnapshot().densified();
+
+    StringTable strings;
+    const auto applicationVersion = strings.add(Constants::Application::applicationVersion());
+    const auto fontFamily = strings.add(mindMapData.font().family());
+    // The indices are collected first, so that the records can be written in parallel without touching the table
+    std::vector<quint32> nodeTextIndices;
+    nodeTextIndices.reserve(graphSnapshot.nodes().size());
+    for (auto && node : graphSnapshot.nodes()) {
+        nodeTextIndices.push_back(strings.add(node.text));
+    }
+    // Same order as in the XML so that the output is deterministic
+    const auto edges = graphSnapshot.edgesBySourceNode();
+    std::vector<quint32> edgeTextIndices;
+    edgeTextIndices.reserve(edges.size());
+    for (auto && edge : edges) {
+        edgeTextIndices.push_back(strings.add(edge.model.text));
+    }
+    const auto images = usedImages(mindMapData, graphSnapshot);
+    for (auto && image : images) {
+        strings.add(image.path().c_str());
+    }
+
+    // Header
+    writer.writeRaw(MAGIC, sizeof(MAGIC));
+    writer.write(FORMAT_VERSION);
+    writeHeaderSection(writer, MindMapHeader::fromMindMap(mindMapData, graphSnapshot));
+    writer.write(applicationVersion);
+
+    strings.write(writer);
+
+    // Style
+    writer.write(static_cast<quint32>(mindMapData.backgroundColor().rgba()));
+    writer.write(static_cast<quint32>(mindMapData.edgeColor().rgba()));
+    writer.write(static_cast<quint32>(mindMapData.gridColor().rgba()));
+    writer.write(mindMapData.arrowSize());
+    writer.write(mindMapData.edgeWidth());
+    const auto font = mindMapData.font();
+    writer.write(fontFamily);
+    writer.write(static_cast<qint32>(Utils::fontWeightToInt(font.weight())));
+    writer.write(static_cast<quint8>(font.bold()));
+    writer.write(static_cast<quint8>(font.italic()));
+    writer.write(static_cast<quint8>(font.overline()));
+    writer.write(static_cast<quint8>(font.strikeOut()));
+    writer.write(static_cast<quint8>(font.underline()));
+    writer.write(static_cast<qint32>(mindMapData.textSize()));
+    writer.write(static_cast<qint32>(mindMapData.cornerRadius()));
+
+    // Metadata
+    writer.write(mindMapData.aspectRatio());
+    writer.write(mindMapData.minEdgeLength());
+
+    // Nodes
+    const auto & nodes = graphSnapshot.nodes();
+    writer.write(static_cast<quint32>(nodes.size()));
+    writeRecords(writer, nodes.size(), [&nodes, &nodeTextIndices](Writer & writer, size_t i) {
+        auto && node = nodes.at(i);
+        writer.write(node.location.x());
+        writer.write(node.location.y());
+        writer.write(node.size.width());
+        writer.write(node.size.height());
+        writer.write(static_cast<quint32>(node.color.rgba()));
+        writer.write(static_cast<quint32>(node.textColor.rgba()));
+        writer.write(nodeTextIndices.at(i));
+        writer.write(static_cast<quint32>(node.imageRef));
+        writer.write(static_cast<quint8>((node.collapsed ? NodeFlags::COLLAPSED : 0) | (node.uuid.isNull() ? 0 : NodeFlags::HAS_UUID)));
+        if (!node.uuid.isNull()) {
+            const auto uuid = node.uuid.toRfc4122();
+            writer.writeRaw(uuid.constData(), uuid.size());
+        }
+    });
+
+    // Edges
+    writer.write(static_cast<quint32>(edges.size()));
+    writeRecords(writer, edges.size(), [&edges, &edgeTextIndices](Writer & writer, size_t i) {
+        auto && edge = edges.at(i);
+        writer.write(static_cast<qint32>(edge.sourceIndex));
+        writer.write(static_cast<qint32>(edge.targetIndex));
+        writer.write(edgeTextIndices.at(i));
+        writer.write(static_cast<quint8>(edge.model.style.arrowMode));
+        writer.write(static_cast<quint8>((edge.model.style.dashedLine ? EdgeFlags::DASHED_LINE : 0) | (edge.model.reversed ? EdgeFlags::REVERSED : 0)));
+        writer.write(static_cast<quint16>(0));
+    });
+
+    // Image index followed by the blobs
+    const quint64 indexEntrySize = sizeof(quint32) * 2 + sizeof(quint64) * 2;
+    writer.write(static_cast<quint32>(images.size()));
+    auto offset = static_cast<quint64>(writer.pos()) + images.size() * indexEntrySize;
+    for (auto && image : images) {
+        const auto size = static_cast<quint64>(image.data().size());
+        writer.write(static_cast<quint32>(image.id()));
+        writer.write(strings.add(image.path().c_str()));
+        writer.write(offset);
+        writer.write(size);
+        offset += size;
+    }
+    for (auto && image : images) {
+        const auto data = image.data();
+        writer.writeRaw(data.constData(), data.size());
+    }
+}
+
+//! Adds the bytes read since the previous section as a section, if the sections are wanted.
+class SectionRecorder
+{
+public:
+    SectionRecorder(const Reader & reader, FileSections * sections)
+      : m_reader(reader)
+      , m_sections(sections)
+    {
+    }
+
+    void add(QString name, size_t count = 1)
+    {
+        if (m_sections) {
+            m_sections->push_back({ name, m_reader.pos() - m_start, count });
+        }
+        m_start = m_reader.pos();
+    }
+
+private:
+    const Reader & m_reader;
+
+    FileSections * m_sections;
+
+    qint64 m_start = 0;
+};
+
+//! \param sections Receives the sizes of the sections of the file, if given.
+MindMapDataU readMindMap(Reader & reader, QString filePath, FileSections * sections = nullptr)
+{
+    SectionRecorder sectionRecorder { reader, sections };
+
+    if (std::memcmp(reader.take(sizeof(MAGIC)), MAGIC, sizeof(MAGIC))) {
+        throw FileException(QObject::tr("Corrupted file: '") + filePath + "'");
+    }
+
+    const auto formatVersion = reader.read<quint32>();
+    if (formatVersion < MIN_FORMAT_VERSION || formatVersion > FORMAT_VERSION) {
+        throw FileException(QObject::tr("Unsupported file version %1: '").arg(formatVersion) + filePath + "'");
+    }
+
+    if (formatVersion >= FIRST_FORMAT_VERSION_WITH_HEADER) {
+        reader.take(reader.read<quint32>());
+    }
+
+    auto data = std::make_unique<MindMapData>();
+    data->setAlzFormatVersion(Constants::Application::alzFormatVersion());
+
+    const auto applicationVersion = reader.read<quint32>();
+    sectionRecorder.add("header");
+
+    const auto strings = readStringTable(reader);
+    data->setApplicationVersion(stringAt(strings, applicationVersion, filePath));
+    sectionRecorder.add("strings", strings.size() - 1);
+
+    // Style
+    data->setBackgroundColor(QColor::fromRgba(reader.read<quint32>()));
+    data->setEdgeColor(QColor::fromRgba(reader.read<quint32>()));
+    data->setGridColor(QColor::fromRgba(reader.read<quint32>()));
+    data->setArrowSize(reader.readDouble());
+    data->setEdgeWidth(reader.readDouble());
+    QFont font;
+    font.setFamily(stringAt(strings, reader.read<quint32>(), filePath));
+    font.setWeight(Utils::intToFontWeight(reader.read<qint32>()));
+    font.setBold(reader.read<quint8>());
+    font.setItalic(reader.read<quint8>());
+    font.setOverline(reader.read<quint8>());
+    font.setStrikeOut(reader.read<quint8>());
+    font.setUnderline(reader.read<quint8>());
+    data->changeFont(font);
+    data->setTextSize(reader.read<qint32>());
+    data->setCornerRadius(reader.read<qint32>());
+
+    // Metadata
+    data->setAspectRatio(reader.readDouble());
+    data->setMinEdgeLength(reader.readDouble());
+    sectionRecorder.add("style");
+
+    // Nodes are read into plain models like in the XML and the scene items are created only when the graph is first accessed
+    const auto nodeCount = reader.read<quint32>();
+    GraphSnapshot::NodeDataVector nodes;
+    nodes.reserve(reader.maxRecordCount(nodeCount, MIN_NODE_RECORD_SIZE));
+    GraphSnapshot::NodeIndexSet nodeIndices;
+    for (quint32 i = 0; i < nodeCount; i++) {
+        SceneItems::NodeModel node { {}, {} };
+        node.index = formatVersion >= FIRST_FORMAT_VERSION_WITH_DENSE_INDICES ? static_cast<int>(i) : reader.read<qint32>();
+        if (!Graph::isValidNodeIndex(node.index, nodeCount)) {
+            throw FileException(QObject::tr("Corrupted file: '") + filePath + "'");
+        }
+        const auto x = reader.readDouble();
+        const auto y = reader.readDouble();
+        node.location = { x, y };
+        const auto w = reader.readDouble();
+        const auto h = reader.readDouble();
+        node.size = { w, h };
+        node.color = QColor::fromRgba(reader.read<quint32>());
+        node.textColor = QColor::fromRgba(reader.read<quint32>());
+        node.text = stringAt(strings, reader.read<quint32>(), filePath);
+        node.imageRef = reader.read<quint32>();
+        if (formatVersion >= 2) {
+            const auto flags = reader.read<quint8>();
+            node.collapsed = flags & NodeFlags::COLLAPSED;
+            if (flags & NodeFlags::HAS_UUID) {
+                node.uuid = QUuid::fromRfc4122(QByteArray::fromRawData(reader.take(UUID_SIZE), UUID_SIZE));
+            }
+        }
+        nodeIndices.insert(node.index);
+        nodes.push_back(node);
+    }
+    sectionRecorder.add("nodes", nodeCount);
+
+    // Edges
+    const auto edgeCount = reader.read<quint32>();
+    GraphSnapshot::EdgeDataVector edges;
+    edges.reserve(reader.maxRecordCount(edgeCount, MIN_EDGE_RECORD_SIZE));
+    for (quint32 i = 0; i < edgeCount; i++) {
+        GraphSnapshot::EdgeData edge { { false, SceneItems::EdgeModel::Style { SceneItems::EdgeModel::ArrowMode::Single } }, -1, -1 };
+        edge.sourceIndex = reader.read<qint32>();
+        edge.targetIndex = reader.read<qint32>();
+        if (!nodeIndices.contains(edge.sourceIndex) || !nodeIndices.contains(edge.targetIndex)) {
+            throw FileException(QObject::tr("Corrupted file: '") + filePath + "'");
+        }
+        edge.model.text = stringAt(strings, reader.read<quint32>(), filePath);
+        edge.model.style.arrowMode = static_cast<SceneItems::EdgeModel::ArrowMode>(reader.read<quint8>());
+        const auto flags = reader.read<quint8>();
+        edge.model.style.dashedLine = flags & EdgeFlags::DASHED_LINE;
+        edge.model.reversed = flags & EdgeFlags::REVERSED;
+        reader.read<quint16>();
+        edges.push_back(edge);
+    }
+    sectionRecorder.add("edges", edgeCount);
+    data->setGraphSnapshot({ std::move(nodes), std::move(edges) });
+
+    // Images
+    const auto imageCount = reader.read<quint32>();
+    quint64 imageDataSize = 0;
+    for (quint32 i = 0; i < imageCount; i++) {
+        const auto id = reader.read<quint32>();
+        const auto path = stringAt(strings, reader.read<quint32>(), filePath).toStdString();
+        const auto offset = reader.read<quint64>();
+        const auto size = reader.read<quint64>();
+        juzzlin::L(TAG).debug() << "Extracting embedded Image id=" << id << ", path=" << path;
+        auto image = Image::fromEncodedData(QByteArray(reader.at(offset, size), static_cast<int>(size)), path);
+        image.setId(id);
+        data->imageManager().setImage(image);
+        imageDataSize += size;
+    }
+    sectionRecorder.add("imageIndex", imageCount);
+
+    // The blobs are after the index and are not read in order
+    if (sections) {
+        sections->push_back({ "images", static_cast<qint64>(imageDataSize), imageCount });
+    }
+
+    return data;
+}
+
+//! Maps the whole file so that parsing doesn't need to copy it. Falls back to reading if mapping isn't supported.
+MindMapDataU readFile(QString path, FileSections * sections = nullptr)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw FileException(QObject::tr("Cannot open file: '") + path + "'");
+    }
+
+    QByteArray buffer;
+    const uchar * data = file.size() ? file.map(0, file.size()) : nullptr;
+    if (!data) {
+        buffer = file.readAll();
+        data = reinterpret_cast<const uchar *>(buffer.constData());
+    }
+
+    Reader reader(data, file.size(), path);
+    return readMindMap(reader, path, sections);
+}
+
+} // namespace
+
+AlzbFileIOWorker::AlzbFileIOWorker() = default;
+
+AlzbFileIOWorker::~AlzbFileIOWorker() = default;
+
+bool AlzbFileIOWorker::isAlzbFile(QString path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) && file.read(sizeof(MAGIC)) == QByteArray::fromRawData(MAGIC, sizeof(MAGIC));
+}
+
+std::optional<MindMapHeader> AlzbFileIOWorker::readHeader(QString path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw FileException(QObject::tr("Cannot open file: '") + path + "'");
+    }
+
+    // Only the fixed prefix and the header itself are read
+    const auto prefix = file.read(sizeof(MAGIC) + sizeof(quint32) * 2);
+    Reader prefixReader(reinterpret_cast<const uchar *>(prefix.constData()), prefix.size(), path);
+    if (std::memcmp(prefixReader.take(sizeof(MAGIC)), MAGIC, sizeof(MAGIC))) {
+        throw FileException(QObject::tr("Corrupted file: '") + path + "'");
+    }
+
+    if (prefixReader.read<quint32>() < FIRST_FORMAT_VERSION_WITH_HEADER) {
+        return {};
+    }
+
+    const auto headerData = file.read(prefixReader.read<quint32>());
+    Reader headerReader(reinterpret_cast<const uchar *>(headerData.constData()), headerData.size(), path);
+    return readHeaderSection(headerReader);
+}
+
+MindMapDataU AlzbFileIOWorker::fromFile(QString path) const
+{
+    const TraceRecorder::ScopedSpan span { "AlzbFileIO::fromFile" };
+
+    return readFile(path);
+}
+
+FileSections AlzbFileIOWorker::readSections(QString path)
+{
+    FileSections sections;
+    readFile(path, &sections);
+    return sections;
+}
+
+bool AlzbFileIOWorker::toFile(MindMapDataS mindMapData, QString path) const
+{
+    const TraceRecorder::ScopedSpan span { "AlzbFileIO::toFile" };
+
+    // Replacing the file atomically also keeps any existing memory mapping of the old file valid
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    Writer writer(file);
+    writeMindMap(writer, *mindMapData);
+    if (!writer.ok() || !file.commit()) {
+        juzzlin::L(TAG).error() << "Failed to write '" << path.toStdString() << "': " << file.errorString().toStdString();
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace IO
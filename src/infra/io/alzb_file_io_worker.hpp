@@ -0,0 +1,63 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ALZB_FILE_IO_WORKER_HPP
+#define ALZB_FILE_IO_WORKER_HPP
+
+#include <QObject>
+#include <QString>
+
+#include "../../common/types.hpp"
+#include "file_section.hpp"
+#include "mind_map_header.hpp"
+
+#include <optional>
+
+namespace IO {
+
+//! Reads and writes the binary ALZB-format. The file consists of a header, a summary header, a string table,
+//! the style and metadata, fixed-size node and edge records, an image index, and the raw image blobs.
+//! All values are little-endian. Files are loaded via memory mapping.
+class AlzbFileIOWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    AlzbFileIOWorker();
+
+    ~AlzbFileIOWorker() override;
+
+    //! \return true if the file starts with the ALZB magic bytes.
+    static bool isAlzbFile(QString path);
+
+    //! Reads only the summary header from the start of the given file.
+    //! \return The header, or nothing if the file was written by a version without headers.
+    //! \throws FileException if the file cannot be opened or is corrupted.
+    static std::optional<MindMapHeader> readHeader(QString path);
+
+    //! Reads the given file like fromFile() does and records the sizes of its sections on the way, e.g. for an analysis.
+    //! \throws FileException if the file cannot be opened or is corrupted.
+    static FileSections readSections(QString path);
+
+public slots:
+
+    MindMapDataU fromFile(QString path) const;
+
+    bool toFile(MindMapDataS mindMapData, QString path) const;
+};
+
+} // namespace IO
+
+#endif // ALZB_FILE_IO_WORKER_HPP
@@ -0,0 +1,219 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "autosave_journal.hpp"
+
+#include "../../domain/image_manager.hpp"
+#include "../../domain/mind_map_data.hpp"
+#include "file_exception.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QDataStream>
+#include <QFile>
+#include <QObject>
+
+namespace IO {
+
+static const auto TAG = "AutosaveJournal";
+
+namespace {
+
+const QByteArray JOURNAL_MAGIC = "ALZJ";
+
+// 2: The node data has the UUID and the node indices are those of the saved file
+const quint32 JOURNAL_VERSION = 2;
+
+} // namespace
+
+QString AutosaveJournal::journalPath(QString filePath)
+{
+    return filePath + ".journal";
+}
+
+void AutosaveJournal::reset(const MindMapData & mindMapData, bool isSaved)
+{
+    m_graphSnapshot = mindMapData.graphSnapshot();
+    m_fileIndices = isSaved && !m_graphSnapshot.hasDenseIndices() ? m_graphSnapshot.denseIndexMap() : GraphSnapshot::IndexMap {};
+    m_nextFileIndex = static_cast<int>(m_graphSnapshot.nodes().size());
+    m_styleData = mindMapData.styleData();
+    m_imageIds.clear();
+    for (auto && image : mindMapData.imageManager().images()) {
+        m_imageIds.insert(image.id());
+    }
+    m_recordCount = 0;
+}
+
+QByteArray AutosaveJournal::createRecord(const MindMapData & mindMapData)
+{
+    auto graphSnapshot = mindMapData.graphSnapshot();
+    auto delta = GraphSnapshot::diff(m_graphSnapshot, graphSnapshot);
+    auto newStyleData = mindMapData.styleData();
+
+    const auto images = mindMapData.imageManager().images();
+    std::vector<const Image *> newImages;
+    for (auto && image : images) {
+        if (!m_imageIds.count(image.id())) {
+            newImages.push_back(&image);
+        }
+    }
+
+    if (delta.isEmpty() && newStyleData == m_styleData && newImages.empty()) {
+        return {};
+    }
+
+    renumber(delta);
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    delta.write(out);
+    out << newStyleData;
+    out << static_cast<quint32>(newImages.size());
+    for (auto && image : newImages) {
+        out << static_cast<quint64>(image->id()) << QString::fromStdString(image->path()) << image->data();
+        m_imageIds.insert(image->id());
+    }
+
+    m_graphSnapshot = std::move(graphSnapshot);
+    m_styleData = std::move(newStyleData);
+    m_recordCount++;
+
+    return qCompress(data);
+}
+
+int AutosaveJournal::fileIndex(int index)
+{
+    if (static_cast<size_t>(index) >= m_fileIndices.size()) {
+        m_fileIndices.resize(static_cast<size_t>(index) + 1, -1);
+    }
+    auto & fileIndex = m_fileIndices.at(static_cast<size_t>(index));
+    if (fileIndex < 0) {
+        fileIndex = m_nextFileIndex++;
+    }
+    return fileIndex;
+}
+
+void AutosaveJournal::renumber(GraphSnapshot::Delta & delta)
+{
+    if (m_fileIndices.empty()) {
+        return;
+    }
+
+    for (auto nodes : { &delta.removedNodes, &delta.addedNodes }) {
+        for (auto && node : *nodes) {
+            node.index = fileIndex(node.index);
+        }
+    }
+    for (auto edges : { &delta.removedEdges, &delta.addedEdges }) {
+        for (auto && edge : *edges) {
+            edge.sourceIndex = fileIndex(edge.sourceIndex);
+            edge.targetIndex = fileIndex(edge.targetIndex);
+        }
+    }
+}
+
+size_t AutosaveJournal::recordCount() const
+{
+    return m_recordCount;
+}
+
+bool AutosaveJournal::appendRecord(QString journalPath, QByteArray record)
+{
+    QFile file(journalPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        juzzlin::L(TAG).error() << "Cannot open '" << journalPath.toStdString() << "' for appending";
+        return false;
+    }
+
+    QDataStream out(&file);
+    if (!file.size()) {
+        out.writeRawData(JOURNAL_MAGIC.constData(), JOURNAL_MAGIC.size());
+        out << JOURNAL_VERSION;
+    }
+
+    out << record;
+    return out.status() == QDataStream::Ok && file.flush();
+}
+
+size_t AutosaveJournal::replay(QString journalPath, MindMapData & mindMapData)
+{
+    QFile file(journalPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw FileException(QObject::tr("Cannot open file: '") + journalPath + "'");
+    }
+
+    QDataStream in(&file);
+    QByteArray magic(JOURNAL_MAGIC.size(), '\0');
+    in.readRawData(magic.data(), magic.size());
+    quint32 version = 0;
+    in >> version;
+    if (in.status() != QDataStream::Ok || magic != JOURNAL_MAGIC || version != JOURNAL_VERSION) {
+        throw FileException(QObject::tr("Corrupted file: '") + journalPath + "'");
+    }
+
+    auto graphSnapshot = mindMapData.graphSnapshot();
+    QByteArray latestStyleData;
+    size_t recordCount = 0;
+    while (!in.atEnd()) {
+        QByteArray record;
+        in >> record;
+        const auto data = qUncompress(record);
+        if (in.status() != QDataStream::Ok || data.isEmpty()) {
+            juzzlin::L(TAG).warning() << "Ignoring truncated record in '" << journalPath.toStdString() << "'";
+            break;
+        }
+
+        QDataStream recordIn(data);
+        const auto delta = GraphSnapshot::Delta::read(recordIn);
+        QByteArray recordStyleData;
+        recordIn >> recordStyleData;
+        quint32 imageCount = 0;
+        recordIn >> imageCount;
+        std::vector<Image> images;
+        for (quint32 i = 0; i < imageCount && recordIn.status() == QDataStream::Ok; i++) {
+            quint64 id = 0;
+            QString path;
+            QByteArray imageData;
+            recordIn >> id >> path >> imageData;
+            auto image = Image::fromEncodedData(imageData, path.toStdString());
+            image.setId(static_cast<size_t>(id));
+            images.push_back(image);
+        }
+
+        if (recordIn.status() != QDataStream::Ok) {
+            juzzlin::L(TAG).warning() << "Ignoring corrupted record in '" << journalPath.toStdString() << "'";
+            break;
+        }
+
+        graphSnapshot.apply(delta);
+        latestStyleData = recordStyleData;
+        for (auto && image : images) {
+            mindMapData.imageManager().setImage(image);
+        }
+        recordCount++;
+    }
+
+    if (recordCount) {
+        // Style is recorded as a whole, so only the latest one matters
+        mindMapData.applyStyleData(latestStyleData);
+        mindMapData.setGraphSnapshot(std::move(graphSnapshot));
+    }
+
+    juzzlin::L(TAG).debug() << "Replayed " << recordCount << " records from '" << journalPath.toStdString() << "'";
+
+    return recordCount;
+}
+
+} // namespace IO
@@ -0,0 +1,86 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef AUTOSAVE_JOURNAL_HPP
+#define AUTOSAVE_JOURNAL_HPP
+
+#include "../../domain/graph_snapshot.hpp"
+
+#include <QByteArray>
+#include <QString>
+
+#include <set>
+
+class MindMapData;
+
+namespace IO {
+
+//! Append-only journal of changes written next to an ALZ-file by autosave. Each record contains
+//! the graph delta since the previous record, the current style, and the images added since
+//! the previous record. The journal is removed when the main file is fully saved, so replaying
+//! it on top of the main file recovers changes that were autosaved only to the journal.
+//!
+//! Layout: magic, version, then records of [32-bit big-endian size][qCompress() data].
+class AutosaveJournal
+{
+public:
+    //! \return Path of the journal that belongs to the given file.
+    static QString journalPath(QString filePath);
+
+    //! Starts a new journal generation from the state of the given data.
+    //! \param isSaved The data has just been saved. The file has the nodes renumbered with dense indices, see
+    //! GraphSnapshot::densified(), so the records need to be renumbered the same way to be replayed on top of it.
+    void reset(const MindMapData & mindMapData, bool isSaved = false);
+
+    //! Creates a record of the changes since the previous record or reset.
+    //! \return Empty data if nothing has changed.
+    QByteArray createRecord(const MindMapData & mindMapData);
+
+    //! \return Number of records created since the last reset.
+    size_t recordCount() const;
+
+    //! Appends a record created by createRecord() to the given journal file.
+    //! \return false if writing failed.
+    static bool appendRecord(QString journalPath, QByteArray record);
+
+    //! Applies all complete records of the given journal file to the data. A truncated last
+    //! record, e.g. due to a crash in the middle of writing, is ignored.
+    //! Throws FileException if the journal is not valid.
+    //! \return Number of records applied.
+    static size_t replay(QString journalPath, MindMapData & mindMapData);
+
+private:
+    int fileIndex(int index);
+
+    void renumber(GraphSnapshot::Delta & delta);
+
+    GraphSnapshot m_graphSnapshot;
+
+    //! Index in the saved file by node index, or empty if the indices are the same.
+    GraphSnapshot::IndexMap m_fileIndices;
+
+    //! Nodes added or restored after the save go after the saved nodes.
+    int m_nextFileIndex = 0;
+
+    QByteArray m_styleData;
+
+    std::set<size_t> m_imageIds;
+
+    size_t m_recordCount = 0;
+};
+
+} // namespace IO
+
+#endif // AUTOSAVE_JOURNAL_HPP
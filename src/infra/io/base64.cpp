@@ -0,0 +1,125 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "base64.hpp"
+
+#include "../../application/service_container.hpp"
+#include "../../application/task_pool.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace IO {
+
+namespace Base64 {
+
+namespace {
+
+// Multiples of three and four so that only the last chunk can be padded
+const int encodeChunkSize = 3 * 256 * 1024;
+
+const int decodeChunkSize = 4 * 256 * 1024;
+
+size_t threadCount()
+{
+    return SC::instance().taskPool()->threadCount();
+}
+
+bool isBase64Alphabet(char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '+' || c == '/';
+}
+
+//! \return True if the data can be split at any multiple of four, i.e. has only padding at the end.
+bool isSplittable(const QByteArray & base64)
+{
+    auto end = base64.constEnd();
+    while (end != base64.constBegin() && *(end - 1) == '=') {
+        end--;
+    }
+    return base64.size() % 4 == 0 && base64.constEnd() - end <= 2 && std::all_of(base64.constBegin(), end, isBase64Alphabet);
+}
+
+//! Runs the given chunk tasks on the shared task pool so that the first one runs on the calling thread.
+void runInParallel(size_t count, const std::function<void(size_t)> & task)
+{
+    SC::instance().taskPool()->run(count, task);
+}
+
+} // namespace
+
+void encode(const QByteArray & data, const std::function<void(const QByteArray &)> & sink)
+{
+    const auto chunkCount = (static_cast<size_t>(data.size()) + encodeChunkSize - 1) / encodeChunkSize;
+    const auto batchSize = threadCount();
+    std::vector<QByteArray> encodedChunks;
+    for (size_t batchBegin = 0; batchBegin < chunkCount; batchBegin += batchSize) {
+        const auto batchCount = std::min(batchSize, chunkCount - batchBegin);
+        encodedChunks.assign(batchCount, {});
+        runInParallel(batchCount, [&](size_t i) {
+            const auto offset = static_cast<int>((batchBegin + i) * encodeChunkSize);
+            const auto chunk = QByteArray::fromRawData(data.constData() + offset, std::min<int>(encodeChunkSize, data.size() - offset));
+            encodedChunks.at(i) = chunk.toBase64(QByteArray::Base64Encoding);
+        });
+        for (auto && encodedChunk : encodedChunks) {
+            sink(encodedChunk);
+        }
+    }
+}
+
+QByteArray encode(const QByteArray & data)
+{
+    if (data.size() <= encodeChunkSize) {
+        return data.toBase64(QByteArray::Base64Encoding);
+    }
+
+    QByteArray base64;
+    base64.reserve((data.size() + 2) / 3 * 4);
+    encode(data, [&base64](const QByteArray & encodedChunk) {
+        base64.append(encodedChunk);
+    });
+    return base64;
+}
+
+QByteArray decode(const QByteArray & base64)
+{
+    if (base64.size() <= decodeChunkSize || !isSplittable(base64)) {
+        return QByteArray::fromBase64(base64, QByteArray::Base64Encoding);
+    }
+
+    // Every chunk but the last one decodes to exactly three quarters of its size
+    const auto chunkCount = (static_cast<size_t>(base64.size()) + decodeChunkSize - 1) / decodeChunkSize;
+    std::vector<QByteArray> decodedChunks(chunkCount);
+    const auto batchSize = threadCount();
+    for (size_t batchBegin = 0; batchBegin < chunkCount; batchBegin += batchSize) {
+        runInParallel(std::min(batchSize, chunkCount - batchBegin), [&](size_t i) {
+            const auto offset = static_cast<int>((batchBegin + i) * decodeChunkSize);
+            const auto chunk = QByteArray::fromRawData(base64.constData() + offset, std::min<int>(decodeChunkSize, base64.size() - offset));
+            decodedChunks.at(batchBegin + i) = QByteArray::fromBase64(chunk, QByteArray::Base64Encoding);
+        });
+    }
+
+    QByteArray data;
+    data.reserve(base64.size() / 4 * 3);
+    for (auto && decodedChunk : decodedChunks) {
+        data.append(decodedChunk);
+    }
+    return data;
+}
+
+} // namespace Base64
+
+} // namespace IO
@@ -0,0 +1,43 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef BASE64_HPP
+#define BASE64_HPP
+
+#include <QByteArray>
+
+#include <functional>
+
+namespace IO {
+
+//! Base64 codec for embedded image data. Large payloads are split into chunks that are
+//! encoded or decoded on several threads, small ones are handled on the calling thread.
+namespace Base64 {
+
+//! Encodes the data and passes the encoded chunks to the sink in order, so that only a few
+//! chunks are held in memory at a time.
+void encode(const QByteArray & data, const std::function<void(const QByteArray &)> & sink);
+
+QByteArray encode(const QByteArray & data);
+
+//! Decodes like QByteArray::fromBase64(). Input with whitespace or other characters outside
+//! of the base64 alphabet is decoded on the calling thread.
+QByteArray decode(const QByteArray & base64);
+
+} // namespace Base64
+
+} // namespace IO
+
+#endif // BASE64_HPP
@@ -0,0 +1,108 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "buffered_image_writer.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QImageWriter>
+
+#include <algorithm>
+#include <cstring>
+
+namespace IO {
+
+namespace {
+
+const auto TAG = "BufferedImageWriter";
+
+} // namespace
+
+BufferedImageWriter::BufferedImageWriter(QString fileName, QSize size, QByteArray format, int quality)
+  : m_fileName(fileName)
+  , m_size(size)
+  , m_format(format)
+  , m_quality(std::clamp(quality, 0, 100))
+{
+}
+
+bool BufferedImageWriter::open()
+{
+    if (!isFormatSupported(m_format)) {
+        juzzlin::L(TAG).error() << "Writing " << m_format.toStdString() << " images is not supported";
+        m_failed = true;
+        return false;
+    }
+
+    m_image = QImage { m_size, QImage::Format_ARGB32 };
+    if (m_image.isNull()) {
+        juzzlin::L(TAG).error() << "Cannot allocate an image of size " << m_size.width() << "x" << m_size.height();
+        m_failed = true;
+        return false;
+    }
+
+    return true;
+}
+
+bool BufferedImageWriter::writeBand(const QImage & band)
+{
+    if (m_failed) {
+        return false;
+    }
+
+    if (band.width() != m_size.width() || m_writtenRows + band.height() > m_size.height()) {
+        juzzlin::L(TAG).error() << "Band of size " << band.width() << "x" << band.height() << " doesn't fit the image";
+        m_failed = true;
+        return false;
+    }
+
+    const auto rows = band.convertToFormat(m_image.format());
+    const auto rowLength = static_cast<size_t>(m_image.width()) * 4;
+    for (int y = 0; y < rows.height(); y++) {
+        std::memcpy(m_image.scanLine(m_writtenRows + y), rows.constScanLine(y), rowLength);
+    }
+    m_writtenRows += rows.height();
+
+    return true;
+}
+
+bool BufferedImageWriter::finish()
+{
+    if (m_failed) {
+        return false;
+    }
+
+    if (m_writtenRows != m_size.height()) {
+        juzzlin::L(TAG).error() << "Only " << m_writtenRows << " of " << m_size.height() << " rows written";
+        return false;
+    }
+
+    QImageWriter writer { m_fileName, m_format };
+    writer.setQuality(m_quality);
+    const bool written = writer.write(m_image);
+    if (!written) {
+        juzzlin::L(TAG).error() << "Failed to write " << m_fileName.toStdString() << ": " << writer.errorString().toStdString();
+    }
+
+    m_image = {};
+    return written;
+}
+
+bool BufferedImageWriter::isFormatSupported(const QByteArray & format)
+{
+    return QImageWriter::supportedImageFormats().contains(format);
+}
+
+} // namespace IO
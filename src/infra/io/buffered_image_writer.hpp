@@ -0,0 +1,67 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef BUFFERED_IMAGE_WRITER_HPP
+#define BUFFERED_IMAGE_WRITER_HPP
+
+#include <QByteArray>
+#include <QImage>
+#include <QSize>
+#include <QString>
+
+#include "image_stream_writer.hpp"
+
+namespace IO {
+
+//! Collects the bands into one image and encodes it with a Qt image plugin, e.g. as JPEG or WebP.
+//! Unlike PngStreamWriter, the whole image is kept in memory until finish().
+class BufferedImageWriter : public ImageStreamWriter
+{
+public:
+    //! \param format Format name of a Qt image plugin, e.g. "jpg".
+    //! \param quality Quality from 0 to 100.
+    BufferedImageWriter(QString fileName, QSize size, QByteArray format, int quality);
+
+    //! Allocates the image.
+    //! \return false if there's no plugin for the format or the image doesn't fit in memory.
+    bool open() override;
+
+    bool writeBand(const QImage & band) override;
+
+    //! Encodes the image and writes the file.
+    bool finish() override;
+
+    //! \returns true if Qt can write images of the given format.
+    static bool isFormatSupported(const QByteArray & format);
+
+private:
+    QString m_fileName;
+
+    QImage m_image;
+
+    QSize m_size;
+
+    QByteArray m_format;
+
+    int m_quality;
+
+    int m_writtenRows = 0;
+
+    bool m_failed = false;
+};
+
+} // namespace IO
+
+#endif // BUFFERED_IMAGE_WRITER_HPP
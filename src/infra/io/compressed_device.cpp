@@ -0,0 +1,226 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "compressed_device.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QFile>
+#include <QtEndian>
+
+#include <algorithm>
+
+namespace IO {
+
+static const auto TAG = "CompressedDevice";
+
+namespace {
+
+const char MAGIC[] = { 'A', 'L', 'Z', 'C' };
+
+const quint32 FORMAT_VERSION = 1;
+
+const int CHUNK_SIZE = 1024 * 1024;
+
+// Big enough to hold any chunk written by us, but keeps corrupted sizes from allocating gigabytes
+const quint32 MAX_COMPRESSED_CHUNK_SIZE = 2 * CHUNK_SIZE;
+
+bool writeUInt32(QIODevice & device, quint32 value)
+{
+    const auto bigEndian = qToBigEndian(value);
+    return device.write(reinterpret_cast<const char *>(&bigEndian), sizeof(bigEndian)) == sizeof(bigEndian);
+}
+
+bool readUInt32(QIODevice & device, quint32 & value)
+{
+    quint32 bigEndian;
+    if (device.read(reinterpret_cast<char *>(&bigEndian), sizeof(bigEndian)) != sizeof(bigEndian)) {
+        return false;
+    }
+    value = qFromBigEndian(bigEndian);
+    return true;
+}
+
+} // namespace
+
+CompressedDevice::CompressedDevice(QIODevice & device)
+  : m_device(device)
+{
+}
+
+CompressedDevice::~CompressedDevice()
+{
+    CompressedDevice::close();
+}
+
+bool CompressedDevice::isCompressed(QIODevice & device)
+{
+    return device.peek(sizeof(MAGIC)) == QByteArray::fromRawData(MAGIC, sizeof(MAGIC));
+}
+
+bool CompressedDevice::isCompressedFile(QString path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) && isCompressed(file);
+}
+
+bool CompressedDevice::open(OpenMode mode)
+{
+    if ((mode & ReadWrite) == ReadWrite) {
+        juzzlin::L(TAG).error() << "Cannot open for both reading and writing";
+        return false;
+    }
+
+    m_buffer.clear();
+    m_bufferPos = 0;
+    m_finished = false;
+
+    if (mode & ReadOnly) {
+        quint32 version = 0;
+        if (m_device.read(sizeof(MAGIC)) != QByteArray::fromRawData(MAGIC, sizeof(MAGIC)) || !readUInt32(m_device, version)) {
+            setErrorString(tr("Not compressed data"));
+            return false;
+        }
+        if (version != FORMAT_VERSION) {
+            setErrorString(tr("Unsupported compression version %1").arg(version));
+            return false;
+        }
+    } else if (mode & WriteOnly) {
+        if (m_device.write(MAGIC, sizeof(MAGIC)) != sizeof(MAGIC) || !writeUInt32(m_device, FORMAT_VERSION)) {
+            setErrorString(m_device.errorString());
+            return false;
+        }
+        m_buffer.reserve(CHUNK_SIZE);
+    }
+
+    return QIODevice::open(mode | Unbuffered);
+}
+
+bool CompressedDevice::finish()
+{
+    if (!(openMode() & WriteOnly) || m_finished) {
+        return true;
+    }
+
+    m_finished = true;
+    if (!writeChunk() || !writeUInt32(m_device, 0)) {
+        juzzlin::L(TAG).error() << "Failed to finish compressed data: " << m_device.errorString().toStdString();
+        return false;
+    }
+
+    return true;
+}
+
+void CompressedDevice::close()
+{
+    if (!isOpen()) {
+        return;
+    }
+
+    finish();
+
+    QIODevice::close();
+}
+
+bool CompressedDevice::isSequential() const
+{
+    return true;
+}
+
+qint64 CompressedDevice::bytesAvailable() const
+{
+    return m_buffer.size() - m_bufferPos + QIODevice::bytesAvailable();
+}
+
+bool CompressedDevice::readChunk()
+{
+    quint32 size = 0;
+    if (!readUInt32(m_device, size) || size > MAX_COMPRESSED_CHUNK_SIZE) {
+        setErrorString(tr("Corrupted compressed data"));
+        return false;
+    }
+
+    m_bufferPos = 0;
+    if (!size) {
+        m_buffer.clear();
+        m_finished = true;
+        return true;
+    }
+
+    const auto compressed = m_device.read(size);
+    m_buffer = compressed.size() == static_cast<int>(size) ? qUncompress(compressed) : QByteArray {};
+    if (m_buffer.isEmpty()) {
+        setErrorString(tr("Corrupted compressed data"));
+        return false;
+    }
+
+    return true;
+}
+
+bool CompressedDevice::writeChunk()
+{
+    if (m_buffer.isEmpty()) {
+        return true;
+    }
+
+    const auto compressed = qCompress(m_buffer);
+    m_buffer.resize(0);
+    if (!writeUInt32(m_device, static_cast<quint32>(compressed.size())) || m_device.write(compressed) != compressed.size()) {
+        setErrorString(m_device.errorString());
+        return false;
+    }
+
+    return true;
+}
+
+qint64 CompressedDevice::readData(char * data, qint64 maxSize)
+{
+    qint64 total = 0;
+    while (total < maxSize) {
+        if (m_bufferPos >= m_buffer.size()) {
+            if (m_finished) {
+                break;
+            }
+            if (!readChunk()) {
+                return -1;
+            }
+            continue;
+        }
+
+        const auto count = std::min<qint64>(maxSize - total, m_buffer.size() - m_bufferPos);
+        std::copy_n(m_buffer.constData() + m_bufferPos, count, data + total);
+        m_bufferPos += static_cast<int>(count);
+        total += count;
+    }
+
+    return total;
+}
+
+qint64 CompressedDevice::writeData(const char * data, qint64 maxSize)
+{
+    qint64 total = 0;
+    while (total < maxSize) {
+        const auto count = std::min<qint64>(maxSize - total, CHUNK_SIZE - m_buffer.size());
+        m_buffer.append(data + total, static_cast<int>(count));
+        total += count;
+        if (m_buffer.size() >= CHUNK_SIZE && !writeChunk()) {
+            return -1;
+        }
+    }
+
+    return total;
+}
+
+} // namespace IO
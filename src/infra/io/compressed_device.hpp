@@ -0,0 +1,76 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef COMPRESSED_DEVICE_HPP
+#define COMPRESSED_DEVICE_HPP
+
+#include <QByteArray>
+#include <QIODevice>
+
+namespace IO {
+
+//! Sequential device that deflates everything written to it into the wrapped device and
+//! inflates everything read from it. The data is compressed in independent chunks so that
+//! only one chunk needs to be in memory at a time.
+//!
+//! Layout: magic, version, then chunks of [32-bit big-endian size][qCompress() data],
+//! terminated by a chunk of size zero.
+class CompressedDevice : public QIODevice
+{
+public:
+    explicit CompressedDevice(QIODevice & device);
+
+    ~CompressedDevice() override;
+
+    //! \return true if the device is positioned at the start of compressed data. Doesn't consume anything.
+    static bool isCompressed(QIODevice & device);
+
+    //! \return true if the given file starts with the compressed magic bytes.
+    static bool isCompressedFile(QString path);
+
+    bool open(OpenMode mode) override;
+
+    //! Writes the remaining data and the terminator. Called by close() if not called before.
+    //! \return false if writing failed.
+    bool finish();
+
+    void close() override;
+
+    bool isSequential() const override;
+
+    qint64 bytesAvailable() const override;
+
+protected:
+    qint64 readData(char * data, qint64 maxSize) override;
+
+    qint64 writeData(const char * data, qint64 maxSize) override;
+
+private:
+    bool readChunk();
+
+    bool writeChunk();
+
+    QIODevice & m_device;
+
+    QByteArray m_buffer;
+
+    int m_bufferPos = 0;
+
+    bool m_finished = false;
+};
+
+} // namespace IO
+
+#endif // COMPRESSED_DEVICE_HPP
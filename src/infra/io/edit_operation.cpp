@@ -0,0 +1,127 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "edit_operation.hpp"
+
+#include "../../common/constants.hpp"
+#include "../../domain/image_manager.hpp"
+#include "../../domain/mind_map_data.hpp"
+
+#include <QDataStream>
+#include <QtEndian>
+
+#include <zlib.h>
+
+namespace IO {
+
+namespace {
+
+const quint32 EDIT_OPERATION_MAGIC = 0x484d4f50; // "HMOP"
+
+// 2: The node data has the UUID
+const quint16 EDIT_OPERATION_VERSION = 2;
+
+//! Inflates data compressed by qCompress() like qUncompress(), but only if it inflates to at most the given size.
+//! qUncompress() would trust the size in the data and keep growing the buffer beyond it.
+QByteArray uncompress(const QByteArray & data, int maxSize)
+{
+    if (data.size() < static_cast<int>(sizeof(quint32))) {
+        return {};
+    }
+
+    const auto size = qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(data.constData()));
+    if (!size || size > static_cast<quint32>(maxSize)) {
+        return {};
+    }
+
+    QByteArray uncompressedData { static_cast<int>(size), Qt::Uninitialized };
+    z_stream stream {};
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.constData() + sizeof(quint32)));
+    stream.avail_in = static_cast<uInt>(data.size() - static_cast<int>(sizeof(quint32)));
+    stream.next_out = reinterpret_cast<Bytef *>(uncompressedData.data());
+    stream.avail_out = size;
+    if (inflateInit(&stream) != Z_OK) {
+        return {};
+    }
+
+    const auto status = inflate(&stream, Z_FINISH);
+    inflateEnd(&stream);
+    return status == Z_STREAM_END && stream.total_out == size ? uncompressedData : QByteArray {};
+}
+
+} // namespace
+
+EditOperation EditOperation::reset(const MindMapData & mindMapData)
+{
+    EditOperation operation;
+    operation.isReset = true;
+    const auto graphSnapshot = mindMapData.graphSnapshot();
+    operation.delta.addedNodes = graphSnapshot.nodes();
+    operation.delta.addedEdges = graphSnapshot.edges();
+    operation.styleData = mindMapData.styleData();
+    for (auto && image : mindMapData.imageManager().images()) {
+        operation.images.push_back(image);
+    }
+    return operation;
+}
+
+QByteArray EditOperation::encode() const
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out << EDIT_OPERATION_MAGIC << EDIT_OPERATION_VERSION << isReset;
+    delta.write(out);
+    out << styleData;
+    out << static_cast<quint32>(images.size());
+    for (auto && image : images) {
+        out << static_cast<quint64>(image.id()) << QString::fromStdString(image.path()) << image.data();
+    }
+    return qCompress(data);
+}
+
+std::optional<EditOperation> EditOperation::decode(const QByteArray & data)
+{
+    const auto uncompressedData = uncompress(data, Constants::Application::sessionMaxOperationSize());
+    QDataStream in(uncompressedData);
+    quint32 magic = 0;
+    quint16 version = 0;
+    EditOperation operation;
+    in >> magic >> version >> operation.isReset;
+    if (in.status() != QDataStream::Ok || magic != EDIT_OPERATION_MAGIC || version != EDIT_OPERATION_VERSION) {
+        return {};
+    }
+
+    operation.delta = GraphSnapshot::Delta::read(in);
+    in >> operation.styleData;
+    quint32 imageCount = 0;
+    in >> imageCount;
+    for (quint32 i = 0; i < imageCount && in.status() == QDataStream::Ok; i++) {
+        quint64 id = 0;
+        QString path;
+        QByteArray imageData;
+        in >> id >> path >> imageData;
+        auto image = Image::fromEncodedData(imageData, path.toStdString());
+        image.setId(static_cast<size_t>(id));
+        operation.images.push_back(image);
+    }
+
+    if (in.status() != QDataStream::Ok) {
+        return {};
+    }
+
+    return operation;
+}
+
+} // namespace IO
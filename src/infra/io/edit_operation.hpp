@@ -0,0 +1,59 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef EDIT_OPERATION_HPP
+#define EDIT_OPERATION_HPP
+
+#include "../../domain/graph_snapshot.hpp"
+#include "../../domain/image.hpp"
+
+#include <QByteArray>
+
+#include <optional>
+#include <vector>
+
+class MindMapData;
+
+namespace IO {
+
+//! An edit of a mind map in a compact binary form, e.g. for streaming the edits to other instances. Usually
+//! only the changed items: a changed item is both in the removed and in the added items of the delta like in
+//! GraphSnapshot::Delta. A reset carries instead the whole mind map, whose nodes and edges are the added items.
+struct EditOperation
+{
+    bool isReset = false;
+
+    GraphSnapshot::Delta delta;
+
+    //! Empty if the style didn't change, see MindMapData::styleData().
+    QByteArray styleData;
+
+    //! Images referred to by the added nodes that the receivers may not have yet.
+    std::vector<Image> images;
+
+    //! \returns An operation that replaces the whole mind map with the given one.
+    static EditOperation reset(const MindMapData & mindMapData);
+
+    //! \returns Compressed operation data.
+    QByteArray encode() const;
+
+    //! \returns Nothing if the data is not a valid operation, e.g. from another version, or if it would
+    //! inflate to more than Constants::Application::sessionMaxOperationSize().
+    static std::optional<EditOperation> decode(const QByteArray & data);
+};
+
+} // namespace IO
+
+#endif // EDIT_OPERATION_HPP
@@ -29,6 +29,8 @@ public:
 
     virtual MindMapDataU fromFile(QString path) const = 0;
 
+    //! \param async Save a snapshot of the mind map in the background. Otherwise the mind map must not be
+    //!              modified until the call returns.
     virtual bool toFile(MindMapDataS mindMapData, QString path, bool async) const = 0;
 };
 
@@ -0,0 +1,41 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef FILE_SECTION_HPP
+#define FILE_SECTION_HPP
+
+#include <QString>
+
+#include <vector>
+
+namespace IO {
+
+//! Size of a part of a mind map file, e.g. the graph or the images, for the analysis of the file.
+struct FileSection
+{
+    QString name;
+
+    //! In bytes, or in characters of the XML for ALZ-files, which are counted after inflating compressed files.
+    qint64 size = 0;
+
+    //! The number of elements of the section, e.g. images, or 1 for single elements like the style.
+    size_t count = 0;
+};
+
+using FileSections = std::vector<FileSection>;
+
+} // namespace IO
+
+#endif // FILE_SECTION_HPP
@@ -0,0 +1,240 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "graph_stream_writer.hpp"
+#include "../../common/trace_recorder.hpp"
+#include "../../domain/graph_snapshot.hpp"
+#include "../../domain/mind_map_data.hpp"
+#include "simple_logger.hpp"
+
+#include <QBuffer>
+#include <QSaveFile>
+#include <QTextStream>
+
+#include <unordered_map>
+#include <vector>
+
+namespace IO {
+
+static const auto TAG = "GraphStreamWriter";
+
+namespace {
+
+QString jsonString(const QString & value)
+{
+    QString result;
+    result.reserve(value.size() + 2);
+    result += '"';
+    for (auto && c : value) {
+        switch (c.unicode()) {
+        case '"':
+            result += "\\\"";
+            break;
+        case '\\':
+            result += "\\\\";
+            break;
+        case '\n':
+            result += "\\n";
+            break;
+        case '\r':
+            result += "\\r";
+            break;
+        case '\t':
+            result += "\\t";
+            break;
+        default:
+            if (c.unicode() < 0x20) {
+                result += QString { "\\u%1" }.arg(c.unicode(), 4, 16, QChar('0'));
+            } else {
+                result += c;
+            }
+        }
+    }
+    result += '"';
+    return result;
+}
+
+QString jsonString(const QColor & color)
+{
+    return jsonString(color.name());
+}
+
+QString jsonBool(bool value)
+{
+    return value ? "true" : "false";
+}
+
+QString jsonNumber(double value)
+{
+    return QString::number(value, 'g', 15);
+}
+
+QString arrowModeName(SceneItems::EdgeModel::ArrowMode arrowMode)
+{
+    switch (arrowMode) {
+    case SceneItems::EdgeModel::ArrowMode::Double:
+        return "double";
+    case SceneItems::EdgeModel::ArrowMode::Hidden:
+        return "hidden";
+    case SceneItems::EdgeModel::ArrowMode::Single:
+        break;
+    }
+    return "single";
+}
+
+void writeJsonLines(QTextStream & stream, MindMapDataCR mindMapData, const GraphSnapshot & snapshot)
+{
+    stream << "{\"type\":\"mindmap\""
+           << ",\"version\":" << jsonString(mindMapData.applicationVersion())
+           << ",\"backgroundColor\":" << jsonString(mindMapData.backgroundColor())
+           << ",\"edgeColor\":" << jsonString(mindMapData.edgeColor())
+           << ",\"gridColor\":" << jsonString(mindMapData.gridColor())
+           << ",\"font\":" << jsonString(mindMapData.font().family())
+           << ",\"textSize\":" << mindMapData.textSize()
+           << ",\"cornerRadius\":" << mindMapData.cornerRadius()
+           << ",\"edgeWidth\":" << jsonNumber(mindMapData.edgeWidth())
+           << ",\"arrowSize\":" << jsonNumber(mindMapData.arrowSize())
+           << "}\n";
+
+    for (auto && node : snapshot.nodes()) {
+        stream << "{\"type\":\"node\""
+               << ",\"index\":" << node.index
+               << ",\"text\":" << jsonString(node.text.toString())
+               << ",\"x\":" << jsonNumber(node.location.x())
+               << ",\"y\":" << jsonNumber(node.location.y())
+               << ",\"width\":" << jsonNumber(node.size.width())
+               << ",\"height\":" << jsonNumber(node.size.height())
+               << ",\"color\":" << jsonString(node.color)
+               << ",\"textColor\":" << jsonString(node.textColor)
+               << ",\"imageRef\":" << node.imageRef
+               << ",\"collapsed\":" << jsonBool(node.collapsed);
+        if (!node.uuid.isNull()) {
+            stream << ",\"uuid\":" << jsonString(node.uuid.toString());
+        }
+        stream << "}\n";
+    }
+
+    for (auto && edge : snapshot.edges()) {
+        stream << "{\"type\":\"edge\""
+               << ",\"source\":" << edge.sourceIndex
+               << ",\"target\":" << edge.targetIndex
+               << ",\"text\":" << jsonString(edge.model.text.toString())
+               << ",\"arrowMode\":\"" << arrowModeName(edge.model.style.arrowMode) << "\""
+               << ",\"dashedLine\":" << jsonBool(edge.model.style.dashedLine)
+               << ",\"reversed\":" << jsonBool(edge.model.reversed)
+               << "}\n";
+    }
+}
+
+// Nodes without incoming edges are the roots of the outline. Nodes that are reachable via several
+// paths, or only via cycles, are written once: at their first occurrence in depth-first order.
+void writeOutline(QTextStream & stream, const GraphSnapshot & snapshot)
+{
+    const auto & nodes = snapshot.nodes();
+
+    std::unordered_map<int, size_t> positions;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        positions[nodes.at(i).index] = i;
+    }
+
+    std::vector<std::vector<size_t>> children(nodes.size());
+    std::vector<bool> hasParent(nodes.size(), false);
+    for (auto && edge : snapshot.edges()) {
+        const auto source = positions.find(edge.sourceIndex);
+        const auto target = positions.find(edge.targetIndex);
+        if (source != positions.end() && target != positions.end()) {
+            children.at(source->second).push_back(target->second);
+            hasParent.at(target->second) = true;
+        }
+    }
+
+    std::vector<bool> written(nodes.size(), false);
+    std::vector<std::pair<size_t, int>> stack;
+    const auto writeTree = [&](size_t root) {
+        stack.push_back({ root, 0 });
+        while (!stack.empty()) {
+            const auto [position, depth] = stack.back();
+            stack.pop_back();
+            if (written.at(position)) {
+                continue;
+            }
+            written.at(position) = true;
+
+            stream << QString(depth * 2, ' ') << nodes.at(position).text.toString().replace('\n', ' ') << '\n';
+
+            // Pushed in reverse so that the children are written in the order of the edges
+            const auto & nodeChildren = children.at(position);
+            for (auto iter = nodeChildren.rbegin(); iter != nodeChildren.rend(); iter++) {
+                stack.push_back({ *iter, depth + 1 });
+            }
+        }
+    };
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (!hasParent.at(i)) {
+            writeTree(i);
+        }
+    }
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        writeTree(i);
+    }
+}
+
+void write(QIODevice & device, MindMapDataCR mindMapData, GraphStreamWriter::Format format)
+{
+    QTextStream stream(&device);
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    stream.setCodec("UTF-8");
+#endif
+
+    const auto snapshot = mindMapData.graphSnapshot();
+    if (format == GraphStreamWriter::Format::JsonLines) {
+        writeJsonLines(stream, mindMapData, snapshot);
+    } else {
+        writeOutline(stream, snapshot);
+    }
+}
+
+} // namespace
+
+bool GraphStreamWriter::writeToFile(MindMapDataCR mindMapData, QString filePath, Format format)
+{
+    const TraceRecorder::ScopedSpan span { "GraphStreamWriter::writeToFile" };
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        juzzlin::L(TAG).error() << "Cannot open '" << filePath.toStdString() << "': " << file.errorString().toStdString();
+        return false;
+    }
+
+    write(file, mindMapData, format);
+    if (!file.commit()) {
+        juzzlin::L(TAG).error() << "Failed to write '" << filePath.toStdString() << "': " << file.errorString().toStdString();
+        return false;
+    }
+
+    return true;
+}
+
+QString GraphStreamWriter::writeToString(MindMapDataCR mindMapData, Format format)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    write(buffer, mindMapData, format);
+    return QString::fromUtf8(buffer.data());
+}
+
+} // namespace IO
@@ -0,0 +1,44 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef GRAPH_STREAM_WRITER_HPP
+#define GRAPH_STREAM_WRITER_HPP
+
+#include <QString>
+
+#include "../../common/types.hpp"
+
+namespace IO::GraphStreamWriter {
+
+enum class Format
+{
+    //! One JSON object per line: the style of the mind map first, then every node and every edge.
+    JsonLines,
+
+    //! The texts of the nodes as a tree, indented by two spaces per level.
+    Outline
+};
+
+//! Writes the graph of the mind map record by record from its plain-data snapshot, so that
+//! no scene items or intermediate documents get created.
+//! \return true on success.
+bool writeToFile(MindMapDataCR mindMapData, QString filePath, Format format);
+
+//! Like writeToFile(), but writes into a string.
+QString writeToString(MindMapDataCR mindMapData, Format format);
+
+} // namespace IO::GraphStreamWriter
+
+#endif // GRAPH_STREAM_WRITER_HPP
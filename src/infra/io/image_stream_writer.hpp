@@ -0,0 +1,44 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef IMAGE_STREAM_WRITER_HPP
+#define IMAGE_STREAM_WRITER_HPP
+
+class QImage;
+
+namespace IO {
+
+//! Writes an image file from bands of rows that are produced from the top to the bottom.
+class ImageStreamWriter
+{
+public:
+    virtual ~ImageStreamWriter() = default;
+
+    //! Opens the file.
+    //! \return false if the file couldn't be opened.
+    virtual bool open() = 0;
+
+    //! Queues the next rows of the image. The band must be as wide as the image.
+    //! \return false if writing failed or the band doesn't fit the image.
+    virtual bool writeBand(const QImage & band) = 0;
+
+    //! Writes the rest of the file.
+    //! \return false if writing failed or not all rows were written.
+    virtual bool finish() = 0;
+};
+
+} // namespace IO
+
+#endif // IMAGE_STREAM_WRITER_HPP
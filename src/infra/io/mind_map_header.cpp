@@ -0,0 +1,68 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "mind_map_header.hpp"
+
+#include "../../common/constants.hpp"
+#include "../../domain/graph_snapshot.hpp"
+#include "../../domain/mind_map_data.hpp"
+#include "../../view/thumbnail_renderer.hpp"
+#include "alz_stream_reader.hpp"
+#include "alzb_file_io_worker.hpp"
+#include "file_exception.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QBuffer>
+
+namespace IO {
+
+static const auto TAG = "MindMapHeader";
+
+MindMapHeader MindMapHeader::fromMindMap(const MindMapData & mindMapData, const GraphSnapshot & graphSnapshot)
+{
+    MindMapHeader header;
+    header.applicationVersion = Constants::Application::applicationVersion();
+    header.nodeCount = graphSnapshot.nodes().size();
+    header.edgeCount = graphSnapshot.edges().size();
+    header.bounds = ThumbnailRenderer::bounds(graphSnapshot);
+
+    const ThumbnailRenderer::Style style { mindMapData.backgroundColor(), mindMapData.edgeColor(), mindMapData.cornerRadius() };
+    QBuffer buffer { &header.thumbnail };
+    buffer.open(QIODevice::WriteOnly);
+    if (!ThumbnailRenderer::render(graphSnapshot, style, Constants::View::headerThumbnailSize()).save(&buffer, "PNG")) {
+        juzzlin::L(TAG).warning() << "Couldn't encode the thumbnail";
+        header.thumbnail.clear();
+    }
+
+    return header;
+}
+
+QImage MindMapHeader::thumbnailImage() const
+{
+    return thumbnail.isEmpty() ? QImage {} : QImage::fromData(thumbnail, "PNG");
+}
+
+std::optional<MindMapHeader> readHeader(QString filePath)
+{
+    try {
+        return AlzbFileIOWorker::isAlzbFile(filePath) ? AlzbFileIOWorker::readHeader(filePath) : AlzStreamReader::readHeader(filePath);
+    } catch (const FileException & e) {
+        juzzlin::L(TAG).warning() << "Couldn't read the header of " << filePath.toStdString() << ": " << e.message().toStdString();
+        return {};
+    }
+}
+
+} // namespace IO
@@ -0,0 +1,60 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MIND_MAP_HEADER_HPP
+#define MIND_MAP_HEADER_HPP
+
+#include <QByteArray>
+#include <QImage>
+#include <QRectF>
+#include <QString>
+
+#include <optional>
+
+class GraphSnapshot;
+class MindMapData;
+
+namespace IO {
+
+//! Summary of a mind map that both file formats store before anything else, so that e.g. the recent files menu,
+//! the workspace index and the command line can show it without parsing the rest of the file.
+struct MindMapHeader
+{
+    //! Builds the header from plain data, so that it can be written from a snapshot on a worker thread.
+    static MindMapHeader fromMindMap(const MindMapData & mindMapData, const GraphSnapshot & graphSnapshot);
+
+    //! \return The decoded thumbnail or a null image if there's none.
+    QImage thumbnailImage() const;
+
+    QString applicationVersion;
+
+    size_t nodeCount = 0;
+
+    size_t edgeCount = 0;
+
+    //! The rect covered by the nodes.
+    QRectF bounds;
+
+    //! PNG-encoded preview, see Constants::View::headerThumbnailSize().
+    QByteArray thumbnail;
+};
+
+//! Reads only the header of the given ALZ- or ALZB-file and stops there.
+//! \return The header, or nothing if the file was written by a version without headers or can't be read.
+std::optional<MindMapHeader> readHeader(QString filePath);
+
+} // namespace IO
+
+#endif // MIND_MAP_HEADER_HPP
@@ -0,0 +1,242 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "outline_importer.hpp"
+#include "../../application/progress_manager.hpp"
+#include "../../application/service_container.hpp"
+#include "../../application/settings_proxy.hpp"
+#include "../../common/constants.hpp"
+#include "../../domain/graph_snapshot.hpp"
+#include "../../domain/mind_map_data.hpp"
+#include "file_exception.hpp"
+#include "simple_logger.hpp"
+
+#include <QColor>
+#include <QFile>
+#include <QFileInfo>
+#include <QObject>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QXmlStreamReader>
+
+#include <algorithm>
+#include <vector>
+
+namespace IO {
+
+static const auto TAG = "OutlineImporter";
+
+namespace {
+
+//! Builds the graph of an outline as plain data in document order. Every node is placed on its own
+//! row and in the column of its depth, which is a valid initial layout that needs no second pass.
+class OutlineBuilder
+{
+public:
+    OutlineBuilder()
+      : m_settingsProxy(SC::instance().settingsProxy())
+      , m_columnWidth(Constants::Node::minWidth() * 3 / 2)
+      , m_rowHeight(Constants::Node::minHeight() * 3 / 2)
+    {
+    }
+
+    //! Adds a node under the latest node of the previous depth. Skipped depths are attached to the deepest open node.
+    SceneItems::NodeModel & addNode(int depth, QString text)
+    {
+        depth = std::clamp(depth, 0, static_cast<int>(m_openNodes.size()));
+        m_openNodes.resize(static_cast<size_t>(depth));
+
+        SceneItems::NodeModel node { m_settingsProxy->nodeColor(), m_settingsProxy->nodeTextColor() };
+        node.index = static_cast<int>(m_nodes.size());
+        node.location = { depth * m_columnWidth, static_cast<double>(m_nodes.size()) * m_rowHeight };
+        node.size = { static_cast<double>(Constants::Node::minWidth()), static_cast<double>(Constants::Node::minHeight()) };
+        node.text = text.trimmed();
+
+        if (!m_openNodes.empty()) {
+            m_edges.push_back({ { false, SceneItems::EdgeModel::Style { m_settingsProxy->edgeArrowMode() } }, m_openNodes.back(), node.index });
+        }
+
+        m_openNodes.push_back(node.index);
+        m_nodes.push_back(node);
+
+        SC::instance().progressManager()->updateProgress();
+
+        return m_nodes.back();
+    }
+
+    bool empty() const
+    {
+        return m_nodes.empty();
+    }
+
+    MindMapDataU finish()
+    {
+        auto data = std::make_unique<MindMapData>();
+        data->setGraphSnapshot({ std::move(m_nodes), std::move(m_edges) });
+        return data;
+    }
+
+private:
+    SettingsProxyS m_settingsProxy;
+
+    const double m_columnWidth;
+
+    const double m_rowHeight;
+
+    GraphSnapshot::NodeDataVector m_nodes;
+
+    GraphSnapshot::EdgeDataVector m_edges;
+
+    //! The indices of the nodes that new nodes can still be attached to, by depth.
+    std::vector<int> m_openNodes;
+};
+
+QString attribute(const QXmlStreamReader & reader, const QString & name)
+{
+    return reader.attributes().value(name).toString();
+}
+
+void throwIfError(const QXmlStreamReader & reader, QString filePath)
+{
+    if (reader.hasError()) {
+        juzzlin::L(TAG).warning() << "Parse error: " << reader.errorString().toStdString();
+        throw FileException(QObject::tr("Corrupted file: '") + filePath + "'");
+    }
+}
+
+// <opml><head><title/></head><body><outline text="..."><outline .../></outline></body></opml>
+void readOpml(QIODevice & device, QString filePath, OutlineBuilder & builder)
+{
+    QXmlStreamReader reader(&device);
+    QString title = QFileInfo { filePath }.completeBaseName();
+    int depth = 0;
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (reader.isStartElement()) {
+            if (reader.name() == QLatin1String("title") && builder.empty()) {
+                if (const auto text = reader.readElementText(QXmlStreamReader::SkipChildElements); !text.trimmed().isEmpty()) {
+                    title = text;
+                }
+            } else if (reader.name() == QLatin1String("outline")) {
+                if (builder.empty()) {
+                    builder.addNode(0, title);
+                }
+                const auto text = attribute(reader, "text");
+                builder.addNode(++depth, text.isEmpty() ? attribute(reader, "title") : text);
+            }
+        } else if (reader.isEndElement() && reader.name() == QLatin1String("outline")) {
+            depth--;
+        }
+    }
+    throwIfError(reader, filePath);
+
+    if (builder.empty()) {
+        builder.addNode(0, title);
+    }
+}
+
+// <map><node TEXT="..." COLOR="#rrggbb" BACKGROUND_COLOR="#rrggbb"><node .../></node></map>
+void readFreeMind(QIODevice & device, QString filePath, OutlineBuilder & builder)
+{
+    QXmlStreamReader reader(&device);
+    int depth = 0;
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (reader.isStartElement() && reader.name() == QLatin1String("node")) {
+            auto && node = builder.addNode(depth++, attribute(reader, "TEXT"));
+            if (const QColor color { attribute(reader, "BACKGROUND_COLOR") }; color.isValid()) {
+                node.color = color;
+            }
+            if (const QColor textColor { attribute(reader, "COLOR") }; textColor.isValid()) {
+                node.textColor = textColor;
+            }
+        } else if (reader.isEndElement() && reader.name() == QLatin1String("node")) {
+            depth--;
+        }
+    }
+    throwIfError(reader, filePath);
+
+    if (builder.empty()) {
+        builder.addNode(0, QFileInfo { filePath }.completeBaseName());
+    }
+}
+
+// Headings nest by their level and list items nest under the preceding heading by their indentation.
+// Other lines, e.g. paragraphs and fenced code blocks, are not part of the outline.
+void readMarkdown(QIODevice & device, QString filePath, OutlineBuilder & builder)
+{
+    static const QRegularExpression headingRegExp { R"(^(#{1,6})\s+(.*?)\s*#*\s*$)" };
+    static const QRegularExpression listItemRegExp { R"(^([ \t]*)(?:[-*+]|\d+[.)])\s+(.*)$)" };
+
+    builder.addNode(0, QFileInfo { filePath }.completeBaseName());
+
+    QTextStream stream(&device);
+    int headingDepth = 0;
+    std::vector<int> listIndents;
+    bool isInCodeBlock = false;
+    QString line;
+    while (stream.readLineInto(&line)) {
+        if (line.trimmed().startsWith("```")) {
+            isInCodeBlock = !isInCodeBlock;
+        } else if (isInCodeBlock) {
+            continue;
+        } else if (const auto heading = headingRegExp.match(line); heading.hasMatch()) {
+            headingDepth = heading.capturedLength(1);
+            listIndents.clear();
+            builder.addNode(headingDepth, heading.captured(2));
+        } else if (const auto listItem = listItemRegExp.match(line); listItem.hasMatch()) {
+            const int indent = static_cast<int>(listItem.captured(1).replace('\t', "    ").size());
+            while (!listIndents.empty() && listIndents.back() > indent) {
+                listIndents.pop_back();
+            }
+            if (listIndents.empty() || listIndents.back() < indent) {
+                listIndents.push_back(indent);
+            }
+            builder.addNode(headingDepth + static_cast<int>(listIndents.size()), listItem.captured(2));
+        }
+    }
+}
+
+} // namespace
+
+bool OutlineImporter::isOutlineFile(QString filePath)
+{
+    const auto suffix = QFileInfo { filePath }.suffix().toLower();
+    return suffix == "opml" || suffix == "mm" || suffix == "md" || suffix == "markdown";
+}
+
+MindMapDataU OutlineImporter::readFromFile(QString filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw FileException(QObject::tr("Cannot open file: '") + filePath + "'");
+    }
+
+    juzzlin::L(TAG).info() << "Importing outline '" << filePath.toStdString() << "'";
+
+    OutlineBuilder builder;
+    const auto suffix = QFileInfo { filePath }.suffix().toLower();
+    if (suffix == "opml") {
+        readOpml(file, filePath, builder);
+    } else if (suffix == "mm") {
+        readFreeMind(file, filePath, builder);
+    } else {
+        readMarkdown(file, filePath, builder);
+    }
+
+    return builder.finish();
+}
+
+} // namespace IO
@@ -0,0 +1,36 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef OUTLINE_IMPORTER_HPP
+#define OUTLINE_IMPORTER_HPP
+
+#include <QString>
+
+#include "../../common/types.hpp"
+
+namespace IO::OutlineImporter {
+
+//! \returns true if the given file is an outline that can be imported, detected by the file extension.
+bool isOutlineFile(QString filePath);
+
+//! Reads an OPML, FreeMind (.mm) or Markdown outline into a mind map in a single streaming pass.
+//! The nodes and edges are built as plain data and laid out as a tree, so that no scene items
+//! are created while parsing.
+//! \throws FileException if the file cannot be opened or parsed.
+MindMapDataU readFromFile(QString filePath);
+
+} // namespace IO::OutlineImporter
+
+#endif // OUTLINE_IMPORTER_HPP
@@ -0,0 +1,309 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "png_stream_writer.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QRunnable>
+#include <QtEndian>
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <vector>
+
+#include <zlib.h>
+
+namespace IO {
+
+namespace {
+
+const auto TAG = "PngStreamWriter";
+
+const QByteArray signature { "\x89PNG\r\n\x1a\n", 8 };
+
+//! \returns The zlib header of a deflate stream with a 32K window, see RFC 1950. The level is only informative.
+QByteArray zlibHeader(int compressionLevel)
+{
+    if (compressionLevel <= 1) {
+        return { "\x78\x01", 2 };
+    }
+    if (compressionLevel <= 5) {
+        return { "\x78\x5e", 2 };
+    }
+    if (compressionLevel == 6) {
+        return { "\x78\x9c", 2 };
+    }
+    return { "\x78\xda", 2 };
+}
+
+void appendBigEndian(QByteArray & data, quint32 value)
+{
+    const auto bigEndian = qToBigEndian(value);
+    data.append(reinterpret_cast<const char *>(&bigEndian), sizeof(bigEndian));
+}
+
+int paethPredictor(int a, int b, int c)
+{
+    const auto p = a + b - c;
+    const auto pa = std::abs(p - a);
+    const auto pb = std::abs(p - b);
+    const auto pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return a;
+    }
+    return pb <= pc ? b : c;
+}
+
+//! Appends the row using the filter type that gives the smallest sum of absolute differences,
+//! which is the heuristic recommended by the PNG specification.
+void appendFilteredRow(const uchar * row, const uchar * previousRow, int length, int bytesPerPixel, QByteArray & output)
+{
+    // None, Sub, Up, Average, Paeth
+    const size_t filterCount = 5;
+    static thread_local std::array<std::vector<uchar>, filterCount> filtered;
+    std::array<long, filterCount> sums {};
+    for (auto && buffer : filtered) {
+        buffer.resize(static_cast<size_t>(length));
+    }
+
+    for (int i = 0; i < length; i++) {
+        const int a = i >= bytesPerPixel ? row[i - bytesPerPixel] : 0;
+        const int b = previousRow[i];
+        const int c = i >= bytesPerPixel ? previousRow[i - bytesPerPixel] : 0;
+        const std::array<int, filterCount> predictions { 0, a, b, (a + b) / 2, paethPredictor(a, b, c) };
+        for (size_t filter = 0; filter < filterCount; filter++) {
+            const auto value = static_cast<uchar>(row[i] - predictions[filter]);
+            filtered[filter][static_cast<size_t>(i)] = value;
+            sums[filter] += std::abs(static_cast<signed char>(value));
+        }
+    }
+
+    const auto best = static_cast<size_t>(std::distance(sums.begin(), std::min_element(sums.begin(), sums.end())));
+    output.append(static_cast<char>(best));
+    output.append(reinterpret_cast<const char *>(filtered[best].data()), length);
+}
+
+template<typename T>
+class EncodeTask : public QRunnable
+{
+public:
+    explicit EncodeTask(std::packaged_task<T()> task)
+      : m_task(std::move(task))
+    {
+    }
+
+    void run() override
+    {
+        m_task();
+    }
+
+private:
+    std::packaged_task<T()> m_task;
+};
+
+} // namespace
+
+PngStreamWriter::PngStreamWriter(QString fileName, QSize size, bool hasAlpha, int compressionLevel)
+  : m_file(fileName)
+  , m_size(size)
+  , m_hasAlpha(hasAlpha)
+  , m_compressionLevel(std::clamp(compressionLevel, 0, 9))
+{
+}
+
+PngStreamWriter::~PngStreamWriter() = default;
+
+bool PngStreamWriter::open()
+{
+    if (!m_file.open(QIODevice::WriteOnly)) {
+        juzzlin::L(TAG).error() << "Cannot open " << m_file.fileName().toStdString() << ": " << m_file.errorString().toStdString();
+        m_failed = true;
+        return false;
+    }
+
+    QByteArray header;
+    appendBigEndian(header, static_cast<quint32>(m_size.width()));
+    appendBigEndian(header, static_cast<quint32>(m_size.height()));
+    header.append(static_cast<char>(8)); // Bit depth
+    header.append(static_cast<char>(m_hasAlpha ? 6 : 2)); // Color type: RGBA or RGB
+    header.append(3, 0); // Compression, filter and interlace methods
+
+    if (m_file.write(signature) != signature.size()) {
+        m_failed = true;
+        return false;
+    }
+
+    return writeChunk("IHDR", header);
+}
+
+PngStreamWriter::EncodedBand PngStreamWriter::encodeBand(QImage band, QImage previousBand, bool hasAlpha, int compressionLevel, bool isLast)
+{
+    const auto format = hasAlpha ? QImage::Format_RGBA8888 : QImage::Format_RGB888;
+    const int bytesPerPixel = hasAlpha ? 4 : 3;
+    const auto image = band.convertToFormat(format);
+    const int rowLength = image.width() * bytesPerPixel;
+
+    // The first row of the image is filtered against a row of zeros
+    std::vector<uchar> firstPreviousRow(static_cast<size_t>(rowLength), 0);
+    if (!previousBand.isNull()) {
+        const auto lastRow = previousBand.copy(0, previousBand.height() - 1, previousBand.width(), 1).convertToFormat(format);
+        std::copy(lastRow.constScanLine(0), lastRow.constScanLine(0) + rowLength, firstPreviousRow.begin());
+    }
+
+    QByteArray raw;
+    raw.reserve(image.height() * (rowLength + 1));
+    const uchar * previousRow = firstPreviousRow.data();
+    for (int y = 0; y < image.height(); y++) {
+        const auto row = image.constScanLine(y);
+        appendFilteredRow(row, previousRow, rowLength, bytesPerPixel, raw);
+        previousRow = row;
+    }
+
+    EncodedBand encoded;
+    encoded.length = raw.size();
+    encoded.adler = adler32(adler32(0L, Z_NULL, 0), reinterpret_cast<const Bytef *>(raw.constData()), static_cast<uInt>(raw.size()));
+
+    // Raw deflate without the zlib wrapper so that the bands can be concatenated. All but the last
+    // band end with a sync flush, i.e. a non-final block aligned to a byte boundary.
+    z_stream stream {};
+    if (deflateInit2(&stream, compressionLevel, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return encoded;
+    }
+
+    const int flushMarkerSize = 16;
+    encoded.data.resize(static_cast<int>(deflateBound(&stream, static_cast<uLong>(raw.size()))) + flushMarkerSize);
+    stream.next_in = reinterpret_cast<Bytef *>(raw.data());
+    stream.avail_in = static_cast<uInt>(raw.size());
+    stream.next_out = reinterpret_cast<Bytef *>(encoded.data.data());
+    stream.avail_out = static_cast<uInt>(encoded.data.size());
+
+    const auto result = deflate(&stream, isLast ? Z_FINISH : Z_SYNC_FLUSH);
+    encoded.ok = isLast ? result == Z_STREAM_END : (result == Z_OK && stream.avail_in == 0 && stream.avail_out > 0);
+    encoded.data.resize(static_cast<int>(stream.total_out));
+    deflateEnd(&stream);
+
+    return encoded;
+}
+
+bool PngStreamWriter::writeBand(const QImage & band)
+{
+    if (m_failed) {
+        return false;
+    }
+
+    if (band.width() != m_size.width() || m_queuedRows + band.height() > m_size.height()) {
+        juzzlin::L(TAG).error() << "Band of size " << band.width() << "x" << band.height() << " doesn't fit the image";
+        m_failed = true;
+        return false;
+    }
+
+    m_queuedRows += band.height();
+    const bool isLast = m_queuedRows == m_size.height();
+    std::packaged_task<EncodedBand()> task { [band, previousBand = m_previousBand, hasAlpha = m_hasAlpha, compressionLevel = m_compressionLevel, isLast] {
+        return encodeBand(band, previousBand, hasAlpha, compressionLevel, isLast);
+    } };
+    m_pendingBands.push_back(task.get_future());
+    m_threadPool.start(new EncodeTask<EncodedBand>(std::move(task)));
+    m_previousBand = band;
+
+    // Bound the memory used by bands waiting to be written
+    while (m_pendingBands.size() > static_cast<size_t>(std::max(1, m_threadPool.maxThreadCount()))) {
+        if (!writePendingBand()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool PngStreamWriter::finish()
+{
+    while (!m_pendingBands.empty()) {
+        writePendingBand();
+    }
+
+    if (m_failed) {
+        return false;
+    }
+
+    if (m_queuedRows != m_size.height()) {
+        juzzlin::L(TAG).error() << "Only " << m_queuedRows << " of " << m_size.height() << " rows written";
+        m_failed = true;
+        return false;
+    }
+
+    QByteArray adler;
+    appendBigEndian(adler, static_cast<quint32>(m_adler));
+    if (!writeChunk("IDAT", adler) || !writeChunk("IEND", {})) {
+        return false;
+    }
+
+    if (!m_file.commit()) {
+        juzzlin::L(TAG).error() << "Failed to write " << m_file.fileName().toStdString() << ": " << m_file.errorString().toStdString();
+        m_failed = true;
+        return false;
+    }
+
+    return true;
+}
+
+bool PngStreamWriter::writeChunk(const char * type, const QByteArray & data)
+{
+    QByteArray chunk;
+    chunk.reserve(data.size() + 12);
+    appendBigEndian(chunk, static_cast<quint32>(data.size()));
+    chunk.append(type, 4);
+    chunk.append(data);
+    // The checksum covers the type and the data, but not the length
+    const auto crc = crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef *>(chunk.constData()) + 4, static_cast<uInt>(chunk.size() - 4));
+    appendBigEndian(chunk, static_cast<quint32>(crc));
+
+    if (m_file.write(chunk) != chunk.size()) {
+        juzzlin::L(TAG).error() << "Failed to write " << m_file.fileName().toStdString() << ": " << m_file.errorString().toStdString();
+        m_failed = true;
+        return false;
+    }
+
+    return true;
+}
+
+bool PngStreamWriter::writeEncodedBand(const EncodedBand & band)
+{
+    if (!band.ok) {
+        juzzlin::L(TAG).error() << "Failed to compress a band of " << band.length << " bytes";
+        m_failed = true;
+        return false;
+    }
+
+    m_adler = adler32_combine(m_adler, band.adler, static_cast<z_off_t>(band.length));
+
+    if (!m_headerWritten) {
+        m_headerWritten = true;
+        return writeChunk("IDAT", zlibHeader(m_compressionLevel) + band.data);
+    }
+
+    return writeChunk("IDAT", band.data);
+}
+
+bool PngStreamWriter::writePendingBand()
+{
+    const auto band = m_pendingBands.front().get();
+    m_pendingBands.pop_front();
+    return !m_failed && writeEncodedBand(band);
+}
+
+} // namespace IO
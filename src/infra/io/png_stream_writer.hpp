@@ -0,0 +1,110 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PNG_STREAM_WRITER_HPP
+#define PNG_STREAM_WRITER_HPP
+
+#include <QByteArray>
+#include <QImage>
+#include <QSaveFile>
+#include <QSize>
+#include <QThreadPool>
+
+#include <deque>
+#include <future>
+
+#include "image_stream_writer.hpp"
+
+namespace IO {
+
+//! Writes a PNG file band by band so that the whole image never needs to be in memory.
+//! Each band is converted, filtered and deflated on a thread pool while the next band is
+//! being produced. The raw deflate blocks of the bands are then written in order as a single
+//! zlib stream, so only a few bands are in flight at a time. The file is replaced only when
+//! finish() succeeds, so a failed or cancelled export never leaves a truncated image behind.
+class PngStreamWriter : public ImageStreamWriter
+{
+public:
+    //! \param compressionLevel Deflate level from 0 (fastest) to 9 (smallest).
+    PngStreamWriter(QString fileName, QSize size, bool hasAlpha, int compressionLevel = 6);
+
+    ~PngStreamWriter() override;
+
+    //! Opens the file and writes the PNG header.
+    //! \return false if the file couldn't be opened.
+    bool open() override;
+
+    //! Queues the next rows of the image. The band must be as wide as the image.
+    //! Blocks while too many earlier bands are still being encoded.
+    //! \return false if writing failed or the band doesn't fit the image.
+    bool writeBand(const QImage & band) override;
+
+    //! Waits for the pending bands, writes the end of the file and commits it.
+    //! \return false if writing failed or not all rows were written.
+    bool finish() override;
+
+private:
+    struct EncodedBand
+    {
+        bool ok = false;
+
+        QByteArray data;
+
+        unsigned long adler = 1;
+
+        qint64 length = 0;
+    };
+
+    //! Converts and filters the rows of the band and deflates them into raw deflate blocks.
+    //! Runs on the thread pool.
+    static EncodedBand encodeBand(QImage band, QImage previousBand, bool hasAlpha, int compressionLevel, bool isLast);
+
+    PngStreamWriter(const PngStreamWriter & other) = delete;
+
+    PngStreamWriter & operator=(const PngStreamWriter & other) = delete;
+
+    bool writeChunk(const char * type, const QByteArray & data);
+
+    bool writeEncodedBand(const EncodedBand & band);
+
+    bool writePendingBand();
+
+    QSaveFile m_file;
+
+    QSize m_size;
+
+    bool m_hasAlpha;
+
+    int m_compressionLevel;
+
+    QThreadPool m_threadPool;
+
+    std::deque<std::future<EncodedBand>> m_pendingBands;
+
+    //! Last band is needed for filtering the first row of the next one.
+    QImage m_previousBand;
+
+    int m_queuedRows = 0;
+
+    bool m_headerWritten = false;
+
+    bool m_failed = false;
+
+    unsigned long m_adler = 1;
+};
+
+} // namespace IO
+
+#endif // PNG_STREAM_WRITER_HPP
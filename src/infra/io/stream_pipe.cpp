@@ -0,0 +1,117 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "stream_pipe.hpp"
+
+#include <QMutexLocker>
+
+#include <algorithm>
+
+namespace IO {
+
+namespace {
+
+// Consumed data is dropped once there's this much of it, so that a long download isn't kept in memory
+const int COMPACT_THRESHOLD = 1024 * 1024;
+
+} // namespace
+
+StreamPipe::StreamPipe()
+{
+    QIODevice::open(ReadOnly);
+}
+
+StreamPipe::~StreamPipe()
+{
+    StreamPipe::close();
+}
+
+void StreamPipe::append(const QByteArray & data)
+{
+    const QMutexLocker locker { &m_mutex };
+    if (m_finished) {
+        return;
+    }
+
+    if (m_bufferPos >= COMPACT_THRESHOLD) {
+        m_buffer.remove(0, m_bufferPos);
+        m_bufferPos = 0;
+    }
+    m_buffer.append(data);
+    m_dataAvailable.wakeAll();
+}
+
+void StreamPipe::finish(QString errorString)
+{
+    const QMutexLocker locker { &m_mutex };
+    if (m_finished) {
+        return;
+    }
+
+    m_finished = true;
+    m_writerError = errorString;
+    m_dataAvailable.wakeAll();
+}
+
+QString StreamPipe::writerError() const
+{
+    const QMutexLocker locker { &m_mutex };
+    return m_writerError;
+}
+
+void StreamPipe::close()
+{
+    {
+        // Wakes up a blocked reader and makes further appends no-ops
+        const QMutexLocker locker { &m_mutex };
+        m_finished = true;
+        m_buffer.clear();
+        m_bufferPos = 0;
+        m_dataAvailable.wakeAll();
+    }
+
+    QIODevice::close();
+}
+
+bool StreamPipe::isSequential() const
+{
+    return true;
+}
+
+qint64 StreamPipe::bytesAvailable() const
+{
+    const QMutexLocker locker { &m_mutex };
+    return m_buffer.size() - m_bufferPos + QIODevice::bytesAvailable();
+}
+
+qint64 StreamPipe::readData(char * data, qint64 maxSize)
+{
+    QMutexLocker locker { &m_mutex };
+    while (!m_finished && m_buffer.size() - m_bufferPos < maxSize) {
+        m_dataAvailable.wait(&m_mutex);
+    }
+
+    const auto count = std::min<qint64>(maxSize, m_buffer.size() - m_bufferPos);
+    std::copy_n(m_buffer.constData() + m_bufferPos, count, data);
+    m_bufferPos += static_cast<int>(count);
+    return count;
+}
+
+qint64 StreamPipe::writeData(const char *, qint64)
+{
+    return -1;
+}
+
+} // namespace IO
@@ -0,0 +1,73 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef STREAM_PIPE_HPP
+#define STREAM_PIPE_HPP
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QMutex>
+#include <QWaitCondition>
+
+namespace IO {
+
+//! Sequential device that one thread appends data to while another thread reads it, e.g. a download
+//! that is parsed while it's still arriving. Reading blocks until the requested amount of data has
+//! arrived or the writer has finished, so that readers of fixed-size fields don't see short reads.
+class StreamPipe : public QIODevice
+{
+public:
+    StreamPipe();
+
+    ~StreamPipe() override;
+
+    //! Appends data for the reader. Ignored after finish() or if the reader has closed the pipe.
+    void append(const QByteArray & data);
+
+    //! Ends the data. The reader gets the rest of the data and then the end.
+    //! \param errorString Non-empty if the writer failed, so that the reader can tell a broken stream from a complete one.
+    void finish(QString errorString = {});
+
+    //! \return The error given to finish(), if any.
+    QString writerError() const;
+
+    void close() override;
+
+    bool isSequential() const override;
+
+    qint64 bytesAvailable() const override;
+
+protected:
+    qint64 readData(char * data, qint64 maxSize) override;
+
+    qint64 writeData(const char * data, qint64 maxSize) override;
+
+private:
+    mutable QMutex m_mutex;
+
+    QWaitCondition m_dataAvailable;
+
+    QByteArray m_buffer;
+
+    int m_bufferPos = 0;
+
+    bool m_finished = false;
+
+    QString m_writerError;
+};
+
+} // namespace IO
+
+#endif // STREAM_PIPE_HPP
@@ -0,0 +1,299 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "undo_journal.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <algorithm>
+
+namespace IO {
+
+static const auto TAG = "UndoJournal";
+
+namespace {
+
+const QByteArray JOURNAL_MAGIC = "ALZU";
+
+// 2: The node data of the records has the UUID
+// 3: The header has the state hash
+const quint32 JOURNAL_VERSION = 3;
+
+const qint64 SIZE_FIELD_SIZE = sizeof(quint32);
+
+const qint64 STATE_HASH_OFFSET = JOURNAL_MAGIC.size() + SIZE_FIELD_SIZE;
+
+const qint64 HEADER_SIZE = STATE_HASH_OFFSET + UndoJournal::STATE_HASH_SIZE;
+
+QByteArray paddedStateHash(const QByteArray & stateHash)
+{
+    auto padded = stateHash.left(UndoJournal::STATE_HASH_SIZE);
+    padded.append(QByteArray(UndoJournal::STATE_HASH_SIZE - padded.size(), '\0'));
+    return padded;
+}
+
+bool writeUInt32(QIODevice & device, quint32 value)
+{
+    const auto bigEndian = qToBigEndian(value);
+    return device.write(reinterpret_cast<const char *>(&bigEndian), sizeof(bigEndian)) == sizeof(bigEndian);
+}
+
+bool writeHeader(QIODevice & device, const QByteArray & stateHash)
+{
+    return device.write(JOURNAL_MAGIC) == JOURNAL_MAGIC.size() && writeUInt32(device, JOURNAL_VERSION)
+      && device.write(paddedStateHash(stateHash)) == UndoJournal::STATE_HASH_SIZE;
+}
+
+bool writeRecord(QIODevice & device, const QByteArray & record)
+{
+    return writeUInt32(device, static_cast<quint32>(record.size())) && device.write(record) == record.size();
+}
+
+} // namespace
+
+UndoJournal::UndoJournal() = default;
+
+UndoJournal::~UndoJournal()
+{
+    close();
+}
+
+QString UndoJournal::journalPath(QString filePath)
+{
+    return filePath + ".undo";
+}
+
+bool UndoJournal::open(QString path)
+{
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        juzzlin::L(TAG).error() << "Cannot open '" << path.toStdString() << "': " << m_file.errorString().toStdString();
+        return false;
+    }
+
+    if (!m_file.size() && (!writeHeader(m_file, {}) || !m_file.flush())) {
+        juzzlin::L(TAG).error() << "Cannot write '" << path.toStdString() << "': " << m_file.errorString().toStdString();
+        close();
+        return false;
+    }
+
+    if (!indexRecords()) {
+        juzzlin::L(TAG).warning() << "Ignoring invalid undo journal '" << path.toStdString() << "'";
+        close();
+        return false;
+    }
+
+    juzzlin::L(TAG).debug() << "Opened '" << path.toStdString() << "' with " << m_offsets.size() << " records";
+
+    return true;
+}
+
+bool UndoJournal::create(QString path, const std::vector<QByteArray> & records, const QByteArray & stateHash)
+{
+    close();
+
+    // Written aside and renamed, so that the previous journal stays intact if writing fails
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || !writeHeader(file, stateHash)) {
+        juzzlin::L(TAG).error() << "Cannot write '" << path.toStdString() << "': " << file.errorString().toStdString();
+        return false;
+    }
+
+    for (auto && record : records) {
+        if (!writeRecord(file, record)) {
+            juzzlin::L(TAG).error() << "Cannot write '" << path.toStdString() << "': " << file.errorString().toStdString();
+            return false;
+        }
+    }
+
+    if (!file.commit()) {
+        juzzlin::L(TAG).error() << "Cannot write '" << path.toStdString() << "': " << file.errorString().toStdString();
+        return false;
+    }
+
+    return open(path);
+}
+
+void UndoJournal::close()
+{
+    unmap();
+
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+
+    m_offsets.clear();
+    m_sizes.clear();
+    m_stateHash.clear();
+}
+
+bool UndoJournal::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+QString UndoJournal::path() const
+{
+    return isOpen() ? m_file.fileName() : QString {};
+}
+
+size_t UndoJournal::recordCount() const
+{
+    return m_offsets.size();
+}
+
+QByteArray UndoJournal::stateHash() const
+{
+    return m_stateHash;
+}
+
+bool UndoJournal::setStateHash(const QByteArray & stateHash)
+{
+    if (!isOpen()) {
+        return false;
+    }
+
+    const auto padded = paddedStateHash(stateHash);
+    if (!m_file.seek(STATE_HASH_OFFSET) || m_file.write(padded) != padded.size() || !m_file.flush()) {
+        juzzlin::L(TAG).error() << "Cannot write '" << m_file.fileName().toStdString() << "': " << m_file.errorString().toStdString();
+        return false;
+    }
+
+    m_stateHash = padded;
+
+    return true;
+}
+
+QByteArray UndoJournal::record(size_t index, qint64 length) const
+{
+    const auto offset = m_offsets.at(index);
+    const auto size = length < 0 ? m_sizes.at(index) : std::min<qint64>(length, m_sizes.at(index));
+
+    // The file is mapped again only if it has grown past the mapping
+    if (!m_map || m_mappedSize < offset + size) {
+        unmap();
+        m_mappedSize = m_file.size();
+        m_map = m_file.map(0, m_mappedSize);
+    }
+
+    if (!m_map) {
+        juzzlin::L(TAG).warning() << "Cannot map '" << m_file.fileName().toStdString() << "', reading it instead";
+        m_mappedSize = 0;
+        return m_file.seek(offset) ? m_file.read(size) : QByteArray {};
+    }
+
+    return QByteArray { reinterpret_cast<const char *>(m_map + offset), static_cast<int>(size) };
+}
+
+bool UndoJournal::push(const QByteArray & record)
+{
+    if (!isOpen()) {
+        return false;
+    }
+
+    // Some platforms cannot resize a file that is mapped
+    unmap();
+
+    const auto end = m_file.size();
+    if (!m_file.seek(end) || !writeRecord(m_file, record) || !m_file.flush()) {
+        juzzlin::L(TAG).error() << "Cannot write '" << m_file.fileName().toStdString() << "': " << m_file.errorString().toStdString();
+        m_file.resize(end);
+        return false;
+    }
+
+    m_offsets.push_back(end + SIZE_FIELD_SIZE);
+    m_sizes.push_back(static_cast<quint32>(record.size()));
+
+    return true;
+}
+
+bool UndoJournal::truncate(size_t recordCount)
+{
+    if (recordCount >= m_offsets.size()) {
+        return true;
+    }
+
+    unmap();
+
+    if (!m_file.resize(m_offsets.at(recordCount) - SIZE_FIELD_SIZE)) {
+        juzzlin::L(TAG).error() << "Cannot truncate '" << m_file.fileName().toStdString() << "': " << m_file.errorString().toStdString();
+        return false;
+    }
+
+    m_offsets.resize(recordCount);
+    m_sizes.resize(recordCount);
+
+    return true;
+}
+
+bool UndoJournal::indexRecords()
+{
+    m_offsets.clear();
+    m_sizes.clear();
+
+    const auto fileSize = m_file.size();
+    if (fileSize < HEADER_SIZE) {
+        return false;
+    }
+
+    m_mappedSize = fileSize;
+    m_map = m_file.map(0, m_mappedSize);
+    if (!m_map) {
+        m_mappedSize = 0;
+        return false;
+    }
+
+    if (QByteArray::fromRawData(reinterpret_cast<const char *>(m_map), JOURNAL_MAGIC.size()) != JOURNAL_MAGIC
+        || qFromBigEndian<quint32>(m_map + JOURNAL_MAGIC.size()) != JOURNAL_VERSION) {
+        return false;
+    }
+
+    m_stateHash = QByteArray { reinterpret_cast<const char *>(m_map + STATE_HASH_OFFSET), STATE_HASH_SIZE };
+
+    auto position = HEADER_SIZE;
+    while (position + SIZE_FIELD_SIZE <= fileSize) {
+        const auto size = qFromBigEndian<quint32>(m_map + position);
+        if (position + SIZE_FIELD_SIZE + size > fileSize) {
+            break;
+        }
+        m_offsets.push_back(position + SIZE_FIELD_SIZE);
+        m_sizes.push_back(size);
+        position += SIZE_FIELD_SIZE + size;
+    }
+
+    if (position != fileSize) {
+        juzzlin::L(TAG).warning() << "Removing truncated record from '" << m_file.fileName().toStdString() << "'";
+        unmap();
+        return m_file.resize(position);
+    }
+
+    return true;
+}
+
+void UndoJournal::unmap() const
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+        m_mappedSize = 0;
+    }
+}
+
+} // namespace IO
@@ -0,0 +1,103 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef UNDO_JOURNAL_HPP
+#define UNDO_JOURNAL_HPP
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include <vector>
+
+namespace IO {
+
+//! Stack of opaque records in a file next to a mind map, e.g. the undo history. The file is memory-mapped,
+//! so that a record costs resident memory only while it's being read. The file always mirrors the stack:
+//! pushing appends a record and popping truncates the file, so nothing needs to be written on exit.
+//!
+//! Layout: magic, version, state hash, then records of [32-bit big-endian size][data]. The state hash tells
+//! which state the records lead to, so that a journal isn't applied to a file that has changed elsewhere.
+class UndoJournal
+{
+public:
+    UndoJournal();
+
+    ~UndoJournal();
+
+    //! \return Path of the journal that belongs to the given file.
+    static QString journalPath(QString filePath);
+
+    //! Opens the given journal, creating it if it doesn't exist. A truncated last record,
+    //! e.g. due to a crash in the middle of writing, is removed.
+    //! \return false if the file cannot be opened or isn't a journal.
+    bool open(QString path);
+
+    //! Replaces the given journal with one that contains the given records and opens it.
+    //! \param stateHash See setStateHash().
+    //! \return false if writing failed.
+    bool create(QString path, const std::vector<QByteArray> & records, const QByteArray & stateHash = {});
+
+    void close();
+
+    bool isOpen() const;
+
+    QString path() const;
+
+    size_t recordCount() const;
+
+    //! \return The hash given to setStateHash(), or zeros if none has been given.
+    QByteArray stateHash() const;
+
+    //! Stores the hash of the state that the records lead to, e.g. of the mind map when it's closed.
+    //! The hash is truncated or padded with zeros to STATE_HASH_SIZE bytes.
+    //! \return false if writing failed.
+    bool setStateHash(const QByteArray & stateHash);
+
+    static const int STATE_HASH_SIZE = 20;
+
+    //! \return The data of the given record, paged in from the mapped file.
+    //! \param length Reads only the given number of bytes from the beginning of the record, or all of it if negative.
+    QByteArray record(size_t index, qint64 length = -1) const;
+
+    //! \return false if writing failed.
+    bool push(const QByteArray & record);
+
+    //! Removes the newest records so that the given number of records is left.
+    //! \return false if truncating the file failed.
+    bool truncate(size_t recordCount);
+
+private:
+    bool indexRecords();
+
+    void unmap() const;
+
+    mutable QFile m_file;
+
+    mutable uchar * m_map = nullptr;
+
+    mutable qint64 m_mappedSize = 0;
+
+    // Start offsets of the record data in the file
+    std::vector<qint64> m_offsets;
+
+    std::vector<quint32> m_sizes;
+
+    QByteArray m_stateHash;
+};
+
+} // namespace IO
+
+#endif // UNDO_JOURNAL_HPP
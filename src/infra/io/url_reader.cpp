@@ -0,0 +1,134 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "url_reader.hpp"
+
+#include "../../common/constants.hpp"
+#include "../../domain/mind_map_data.hpp"
+#include "alz_stream_reader.hpp"
+#include "file_exception.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkReply>
+
+namespace IO {
+
+static const auto TAG = "UrlReader";
+
+UrlReader::UrlReader(QUrl url, QObject * parent)
+  : QObject { parent }
+  , m_url { url }
+{
+    m_transferTimer.setSingleShot(true);
+    m_transferTimer.setInterval(static_cast<int>(Constants::Application::urlTransferTimeout().count()));
+    connect(&m_transferTimer, &QTimer::timeout, this, [this] {
+        if (m_reply) {
+            m_reply->abort();
+        }
+    });
+}
+
+UrlReader::~UrlReader()
+{
+    // Wakes up a reader that still waits for data
+    m_pipe.close();
+}
+
+bool UrlReader::isUrl(QString fileName)
+{
+    return fileName.startsWith("http://", Qt::CaseInsensitive) || fileName.startsWith("https://", Qt::CaseInsensitive);
+}
+
+QUrl UrlReader::url() const
+{
+    return m_url;
+}
+
+void UrlReader::start()
+{
+    juzzlin::L(TAG).info() << "Downloading '" << m_url.toString().toStdString() << "'";
+
+    m_manager = new QNetworkAccessManager { this };
+    QNetworkRequest request { m_url };
+    request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    request.setTransferTimeout(static_cast<int>(Constants::Application::urlTransferTimeout().count()));
+#endif
+    const auto reply = m_manager->get(request);
+    m_reply = reply;
+#if QT_VERSION < QT_VERSION_CHECK(5, 15, 0)
+    m_transferTimer.start();
+    connect(reply, &QNetworkReply::downloadProgress, &m_transferTimer, [this] {
+        m_transferTimer.start();
+    });
+#endif
+
+    // The pipe gets the data chunk by chunk as it arrives instead of once the download has finished
+    connect(reply, &QNetworkReply::readyRead, this, [this, reply] {
+        m_pipe.append(reply->readAll());
+    });
+    connect(reply, &QNetworkReply::finished, this, [this, reply] {
+        m_transferTimer.stop();
+        m_pipe.append(reply->readAll());
+        if (reply->error() != QNetworkReply::NoError) {
+            // Only cancel() and the transfer timeout abort the reply
+            const auto error = !m_cancelReason.isEmpty() ? m_cancelReason //
+                                                         : (reply->error() == QNetworkReply::OperationCanceledError ? tr("The download timed out") : reply->errorString());
+            juzzlin::L(TAG).warning() << "Download failed: " << error.toStdString();
+            m_pipe.finish(error);
+        } else {
+            m_pipe.finish();
+        }
+        reply->deleteLater();
+    });
+}
+
+void UrlReader::cancel(QString reason)
+{
+    juzzlin::L(TAG).info() << "Cancelling the download of '" << m_url.toString().toStdString() << "'";
+
+    m_cancelReason = reason;
+    if (m_reply) {
+        // Finishes the pipe via the finished signal, which abort() emits at once
+        m_reply->abort();
+    }
+
+    // Also if the download hasn't started or has ended already
+    m_pipe.finish(reason);
+}
+
+MindMapDataU UrlReader::read()
+{
+    MindMapDataU data;
+    try {
+        data = AlzStreamReader::readFromDevice(m_pipe, m_url.toString());
+    } catch (const FileException &) {
+        // A broken download shows up as a premature end of the data, so the network error is the more helpful message
+        if (m_pipe.writerError().isEmpty()) {
+            throw;
+        }
+    }
+
+    // The parser may be done before the download has ended, but a failed download never gives a complete mind map
+    if (const auto error = m_pipe.writerError(); !error.isEmpty()) {
+        throw FileException(tr("Cannot download '%1': %2").arg(m_url.toString(), error));
+    }
+
+    return data;
+}
+
+} // namespace IO
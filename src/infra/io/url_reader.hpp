@@ -0,0 +1,76 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef URL_READER_HPP
+#define URL_READER_HPP
+
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QUrl>
+
+#include "../../common/types.hpp"
+#include "stream_pipe.hpp"
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+namespace IO {
+
+//! Reads a mind map from an HTTP(S) URL. The data is parsed while it's still being downloaded,
+//! so that the transfer and the parsing overlap instead of following each other.
+class UrlReader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit UrlReader(QUrl url, QObject * parent = nullptr);
+
+    ~UrlReader() override;
+
+    //! \return true if the given file name is an HTTP(S) URL instead of a local path.
+    static bool isUrl(QString fileName);
+
+    QUrl url() const;
+
+    //! Starts the download. Called on the GUI thread, which then needs to get back to the event loop for the data to arrive.
+    void start();
+
+    //! Aborts the download, so that read() stops waiting for data and fails with the given reason.
+    //! Called on the GUI thread, also when it cannot get back to the event loop anymore, e.g. on exit.
+    void cancel(QString reason);
+
+    //! Parses the mind map as the data arrives. Blocks until the mind map has been read, so this is called on a background thread.
+    //! \throws FileException if the download fails or the data cannot be parsed.
+    MindMapDataU read();
+
+private:
+    QUrl m_url;
+
+    QNetworkAccessManager * m_manager = nullptr;
+
+    QPointer<QNetworkReply> m_reply;
+
+    //! Aborts a stalled download with Qt versions that don't have QNetworkRequest::setTransferTimeout().
+    QTimer m_transferTimer;
+
+    QString m_cancelReason;
+
+    StreamPipe m_pipe;
+};
+
+} // namespace IO
+
+#endif // URL_READER_HPP
@@ -0,0 +1,88 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "memory_pressure_monitor.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QFile>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#endif
+
+static const auto TAG = "MemoryPressureMonitor";
+
+MemoryPressureMonitor::MemoryPressureMonitor(std::chrono::milliseconds pollInterval, double lowMemoryRatio)
+  : m_lowMemoryRatio(lowMemoryRatio)
+{
+    if (!availableMemoryRatio()) {
+        juzzlin::L(TAG).info() << "Available memory can't be read on this platform";
+        return;
+    }
+
+    m_timer.setInterval(static_cast<int>(pollInterval.count()));
+    connect(&m_timer, &QTimer::timeout, this, &MemoryPressureMonitor::poll);
+    m_timer.start();
+}
+
+std::optional<double> MemoryPressureMonitor::availableMemoryRatio()
+{
+#if defined(Q_OS_WIN)
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if (GlobalMemoryStatusEx(&status) && status.ullTotalPhys) {
+        return static_cast<double>(status.ullAvailPhys) / static_cast<double>(status.ullTotalPhys);
+    }
+    return {};
+#elif defined(Q_OS_LINUX)
+    // MemAvailable accounts for the page cache that can be dropped, unlike MemFree
+    QFile file { "/proc/meminfo" };
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+
+    double total = 0;
+    double available = -1;
+    while (!file.atEnd() && (!total || available < 0)) {
+        const auto line = file.readLine().simplified();
+        if (line.startsWith("MemTotal:")) {
+            total = line.split(' ').value(1).toDouble();
+        } else if (line.startsWith("MemAvailable:")) {
+            available = line.split(' ').value(1).toDouble();
+        }
+    }
+
+    if (total > 0 && available >= 0) {
+        return available / total;
+    }
+    return {};
+#else
+    return {};
+#endif
+}
+
+void MemoryPressureMonitor::poll()
+{
+    if (const auto ratio = availableMemoryRatio(); ratio) {
+        if (const auto isMemoryLow = *ratio < m_lowMemoryRatio; isMemoryLow != m_isMemoryLow) {
+            m_isMemoryLow = isMemoryLow;
+            if (isMemoryLow) {
+                juzzlin::L(TAG).warning() << "Low on memory: " << *ratio * 100 << "% available";
+                emit memoryLow();
+            }
+        }
+    }
+}
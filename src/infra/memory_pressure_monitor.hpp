@@ -0,0 +1,53 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MEMORY_PRESSURE_MONITOR_HPP
+#define MEMORY_PRESSURE_MONITOR_HPP
+
+#include <QObject>
+#include <QTimer>
+
+#include <chrono>
+#include <optional>
+
+//! Tells when the system runs low on memory. Qt doesn't signal memory pressure, so the available
+//! physical memory is polled, which is cheap enough to do every few seconds.
+class MemoryPressureMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    //! \param lowMemoryRatio Fraction of the physical memory below which the available memory counts as low.
+    MemoryPressureMonitor(std::chrono::milliseconds pollInterval, double lowMemoryRatio);
+
+    //! \returns The fraction of the physical memory available to applications, or nothing if it can't be read
+    //! on this platform.
+    static std::optional<double> availableMemoryRatio();
+
+signals:
+    //! Emitted when the available memory drops below the limit. Emitted again only after it has recovered.
+    void memoryLow();
+
+private:
+    void poll();
+
+    QTimer m_timer;
+
+    double m_lowMemoryRatio;
+
+    bool m_isMemoryLow = false;
+};
+
+#endif // MEMORY_PRESSURE_MONITOR_HPP
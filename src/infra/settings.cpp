@@ -17,11 +17,17 @@
 #include "../common/constants.hpp"
 #include "../common/utils.hpp"
 
+#include <QRunnable>
 #include <QSettings>
 #include <QStandardPaths>
+#include <QThreadPool>
 #include <QTimer>
 
+#include <algorithm>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace {
 
@@ -69,6 +75,14 @@ const auto settingGroupEditing = "Editing";
 
 const auto settingGroupMainWindow = "MainWindow";
 
+const auto viewportsArrayKey = "viewportsArray";
+
+const auto viewportFilePathKey = "filePath";
+
+const auto viewportSceneRectKey = "sceneRect";
+
+const auto viewportScaleKey = "scale";
+
 const auto windowFullScreenKey = "fullScreen";
 
 const auto windowSizeKey = "size";
@@ -319,106 +333,240 @@ void saveSelectNodeGroupByIntersection(bool selectNodeGroupByIntersection)
     settings.endGroup();
 }
 
+std::optional<Viewport> loadViewport(QString filePath)
+{
+    QSettings settings;
+    std::optional<Viewport> viewport;
+    const int size = settings.beginReadArray(viewportsArrayKey);
+    for (int i = 0; i < size && !viewport; i++) {
+        settings.setArrayIndex(i);
+        if (settings.value(viewportFilePathKey).toString() == filePath) {
+            if (const auto sceneRect = settings.value(viewportSceneRectKey).toRectF(); sceneRect.isValid()) {
+                viewport = Viewport { sceneRect, settings.value(viewportScaleKey, 1.0).toDouble() };
+            }
+        }
+    }
+    settings.endArray();
+    return viewport;
+}
+
+void saveViewport(QString filePath, const Viewport & viewport)
+{
+    QSettings settings;
+    std::vector<std::pair<QString, Viewport>> viewports { { filePath, viewport } };
+    const int size = settings.beginReadArray(viewportsArrayKey);
+    for (int i = 0; i < size; i++) {
+        settings.setArrayIndex(i);
+        if (const auto otherFilePath = settings.value(viewportFilePathKey).toString(); otherFilePath != filePath) {
+            viewports.push_back({ otherFilePath, { settings.value(viewportSceneRectKey).toRectF(), settings.value(viewportScaleKey, 1.0).toDouble() } });
+        }
+    }
+    settings.endArray();
+
+    // The most recent first
+    const size_t maxViewportCount = 32;
+    viewports.resize(std::min(viewports.size(), maxViewportCount));
+
+    settings.beginWriteArray(viewportsArrayKey);
+    for (size_t i = 0; i < viewports.size(); i++) {
+        settings.setArrayIndex(static_cast<int>(i));
+        settings.setValue(viewportFilePathKey, viewports.at(i).first);
+        settings.setValue(viewportSceneRectKey, viewports.at(i).second.sceneRect);
+        settings.setValue(viewportScaleKey, viewports.at(i).second.scale);
+    }
+    settings.endArray();
+}
+
 } // namespace Custom
 
 namespace Generic {
 
+namespace {
+
+//! Settings::Generic writes are collected here and written by a background thread in batches, so that
+//! e.g. dragging a slider in the settings dialog doesn't hit the disk on the GUI thread at every step.
+//! Reads check the queued values first.
+class PendingWrites
+{
+public:
+    static PendingWrites & instance()
+    {
+        static PendingWrites pendingWrites;
+        return pendingWrites;
+    }
+
+    void enqueue(QString group, QString key, QVariant value)
+    {
+        std::lock_guard<std::mutex> lock { m_mutex };
+        m_pending[group + "/" + key] = value;
+        if (!m_isWriteScheduled) {
+            m_isWriteScheduled = true;
+            m_threadPool.start(new WriteTask { *this });
+        }
+    }
+
+    bool find(QString group, QString key, QVariant & value) const
+    {
+        const auto path = group + "/" + key;
+        std::lock_guard<std::mutex> lock { m_mutex };
+        if (const auto iter = m_pending.find(path); iter != m_pending.end()) {
+            value = iter->second;
+            return true;
+        }
+        if (const auto iter = m_writing.find(path); iter != m_writing.end()) {
+            value = iter->second;
+            return true;
+        }
+        return false;
+    }
+
+    void waitForDone()
+    {
+        m_threadPool.waitForDone();
+    }
+
+private:
+    class WriteTask : public QRunnable
+    {
+    public:
+        explicit WriteTask(PendingWrites & pendingWrites)
+          : m_pendingWrites(pendingWrites)
+        {
+        }
+
+        void run() override
+        {
+            m_pendingWrites.write();
+        }
+
+    private:
+        PendingWrites & m_pendingWrites;
+    };
+
+    PendingWrites()
+    {
+        // Batches must not overtake each other
+        m_threadPool.setMaxThreadCount(1);
+    }
+
+    ~PendingWrites()
+    {
+        m_threadPool.waitForDone();
+    }
+
+    void write()
+    {
+        {
+            std::lock_guard<std::mutex> lock { m_mutex };
+            m_writing.swap(m_pending);
+            m_isWriteScheduled = false;
+        }
+
+        QSettings settings;
+        for (auto && [path, value] : m_writing) {
+            settings.setValue(path, value);
+        }
+        settings.sync();
+
+        std::lock_guard<std::mutex> lock { m_mutex };
+        m_writing.clear();
+    }
+
+    mutable std::mutex m_mutex;
+
+    std::map<QString, QVariant> m_pending;
+
+    //! Values of the batch that is being written. Only modified by the write task.
+    std::map<QString, QVariant> m_writing;
+
+    bool m_isWriteScheduled = false;
+
+    QThreadPool m_threadPool;
+};
+
+QVariant readValue(QSettings & settings, QString group, QString key, QVariant defaultValue)
+{
+    if (QVariant pendingValue; PendingWrites::instance().find(group, key, pendingValue)) {
+        return pendingValue;
+    }
+    return settings.value(group + "/" + key, defaultValue);
+}
+
+} // namespace
+
 bool getBoolean(QString group, QString key, bool defaultValue)
 {
     QSettings settings;
-    settings.beginGroup(group);
-    const auto val = settings.value(key, defaultValue).toBool();
-    settings.endGroup();
-    return val;
+    return readValue(settings, group, key, defaultValue).toBool();
 }
 
 void setBoolean(QString group, QString key, bool value)
 {
-    QSettings settings;
-    settings.beginGroup(group);
-    settings.setValue(key, value);
-    settings.endGroup();
+    PendingWrites::instance().enqueue(group, key, value);
 }
 
 QColor getColor(QString group, QString key, QColor defaultValue)
 {
     QSettings settings;
-    settings.beginGroup(group);
-    const auto val = settings.value(key, defaultValue).value<QColor>();
-    settings.endGroup();
-    return val;
+    return readValue(settings, group, key, defaultValue).value<QColor>();
 }
 
 void setColor(QString group, QString key, QColor value)
 {
-    QSettings settings;
-    settings.beginGroup(group);
-    settings.setValue(key, value);
-    settings.endGroup();
+    PendingWrites::instance().enqueue(group, key, value);
 }
 
 double getNumber(QString group, QString key, double defaultValue)
 {
     QSettings settings;
-    settings.beginGroup(group);
-    const auto val = settings.value(key, defaultValue).toDouble();
-    settings.endGroup();
-    return val;
+    return readValue(settings, group, key, defaultValue).toDouble();
 }
 
 void setNumber(QString group, QString key, double value)
 {
-    QSettings settings;
-    settings.beginGroup(group);
-    settings.setValue(key, value);
-    settings.endGroup();
+    PendingWrites::instance().enqueue(group, key, value);
 }
 
 QString getString(QString group, QString key, QString defaultValue)
 {
     QSettings settings;
-    settings.beginGroup(group);
-    const auto val = settings.value(key, defaultValue).toString();
-    settings.endGroup();
-    return val;
+    return readValue(settings, group, key, defaultValue).toString();
 }
 
 void setString(QString group, QString key, QString value)
 {
-    QSettings settings;
-    settings.beginGroup(group);
-    settings.setValue(key, value);
-    settings.endGroup();
+    PendingWrites::instance().enqueue(group, key, value);
 }
 
 QFont getFont(QString group, QString key, QFont defaultValue)
 {
     QSettings settings;
-    settings.beginGroup(group);
     auto font = defaultValue;
-    font.setFamily(settings.value(key + fontFamilyPostfix, defaultValue.family()).toString());
-    font.setBold(settings.value(key + fontBoldPostfix, defaultValue.bold()).toBool());
-    font.setItalic(settings.value(key + fontItalicPostfix, defaultValue.italic()).toBool());
-    font.setOverline(settings.value(key + fontOverlinePostfix, defaultValue.overline()).toBool());
-    font.setStrikeOut(settings.value(key + fontStrikeOutPostfix, defaultValue.strikeOut()).toBool());
-    font.setUnderline(settings.value(key + fontUnderlinePostfix, defaultValue.underline()).toBool());
-    font.setWeight(Utils::intToFontWeight(settings.value(key + fontWeightPostfix, defaultValue.weight()).toInt()));
-    settings.endGroup();
+    font.setFamily(readValue(settings, group, key + fontFamilyPostfix, defaultValue.family()).toString());
+    font.setBold(readValue(settings, group, key + fontBoldPostfix, defaultValue.bold()).toBool());
+    font.setItalic(readValue(settings, group, key + fontItalicPostfix, defaultValue.italic()).toBool());
+    font.setOverline(readValue(settings, group, key + fontOverlinePostfix, defaultValue.overline()).toBool());
+    font.setStrikeOut(readValue(settings, group, key + fontStrikeOutPostfix, defaultValue.strikeOut()).toBool());
+    font.setUnderline(readValue(settings, group, key + fontUnderlinePostfix, defaultValue.underline()).toBool());
+    font.setWeight(Utils::intToFontWeight(readValue(settings, group, key + fontWeightPostfix, defaultValue.weight()).toInt()));
     return font;
 }
 
 void setFont(QString group, QString key, QFont value)
 {
-    QSettings settings;
-    settings.beginGroup(group);
-    settings.setValue(key + fontFamilyPostfix, value.family());
-    settings.setValue(key + fontBoldPostfix, value.bold());
-    settings.setValue(key + fontItalicPostfix, value.italic());
-    settings.setValue(key + fontOverlinePostfix, value.overline());
-    settings.setValue(key + fontStrikeOutPostfix, value.strikeOut());
-    settings.setValue(key + fontUnderlinePostfix, value.underline());
-    settings.setValue(key + fontWeightPostfix, Utils::fontWeightToInt(value.weight()));
-    settings.endGroup();
+    auto && pendingWrites = PendingWrites::instance();
+    pendingWrites.enqueue(group, key + fontFamilyPostfix, value.family());
+    pendingWrites.enqueue(group, key + fontBoldPostfix, value.bold());
+    pendingWrites.enqueue(group, key + fontItalicPostfix, value.italic());
+    pendingWrites.enqueue(group, key + fontOverlinePostfix, value.overline());
+    pendingWrites.enqueue(group, key + fontStrikeOutPostfix, value.strikeOut());
+    pendingWrites.enqueue(group, key + fontUnderlinePostfix, value.underline());
+    pendingWrites.enqueue(group, key + fontWeightPostfix, Utils::fontWeightToInt(value.weight()));
+}
+
+void flush()
+{
+    PendingWrites::instance().waitForDone();
 }
 
 } // namespace Generic
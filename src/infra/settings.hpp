@@ -20,9 +20,12 @@
 
 #include <QColor>
 #include <QFont>
+#include <QRectF>
 #include <QSize>
 #include <QString>
 
+#include <optional>
+
 namespace Settings {
 
 namespace Custom {
@@ -79,6 +82,20 @@ bool loadFullScreen();
 
 void saveFullScreen(bool fullScreen);
 
+//! The visible part of a mind map when it was last closed.
+struct Viewport
+{
+    QRectF sceneRect;
+
+    double scale = 1.0;
+};
+
+//! \returns The viewport saved for the given mind map file, if any.
+std::optional<Viewport> loadViewport(QString filePath);
+
+//! Saves the viewport of the given mind map file. Only the viewports of the most recent files are kept.
+void saveViewport(QString filePath, const Viewport & viewport);
+
 } // namespace Custom
 
 namespace Generic {
@@ -103,6 +120,10 @@ QFont getFont(QString group, QString key, QFont defaultValue);
 
 void setFont(QString group, QString key, QFont value);
 
+//! Generic setters only queue the values and they are written in batches by a background thread.
+//! Blocks until all queued values have been written.
+void flush();
+
 } // namespace Generic
 
 } // namespace Settings
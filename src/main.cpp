@@ -16,8 +16,12 @@
 #include <QApplication>
 #include <QSettings>
 
+#include "application/analysis_reporter.hpp"
 #include "application/application.hpp"
+#include "application/batch_exporter.hpp"
+#include "application/diff_reporter.hpp"
 #include "application/hash_seed.hpp"
+#include "application/info_reporter.hpp"
 #include "application/user_exception.hpp"
 #include "common/constants.hpp"
 #include "common/utils.hpp"
@@ -59,6 +63,9 @@ static void initLogger()
     L::setLoggingLevel(L::Level::Debug);
 #endif
 
+    // Keep file writes and flushes off the GUI thread
+    L::enableAsyncMode(true);
+
     L(TAG).info() << applicationName().toStdString() << " version " << applicationVersion().toStdString();
     L(TAG).info() << copyright().toStdString();
     L(TAG).info() << "Compiled against Qt version " << QT_VERSION_STR;
@@ -76,11 +83,20 @@ int main(int argc, char ** argv)
 #ifdef Q_OS_WIN32
     QSettings::setDefaultFormat(QSettings::IniFormat);
 #endif
+    // Batch exports, diffs, infos and analyses must also work without a display, e.g. on build servers
+    if ((BatchExporter::isRequested(argc, argv) || DiffReporter::isRequested(argc, argv) || InfoReporter::isRequested(argc, argv) || AnalysisReporter::isRequested(argc, argv))
+        && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
 
     try {
         initLogger();
-        return Application(argc, argv).run();
+        const auto result = Application(argc, argv).run();
+        // Write the queued messages before the static objects get destroyed
+        juzzlin::L::shutdown();
+        return result;
     } catch (std::exception & e) {
+        juzzlin::L::shutdown();
         if (!dynamic_cast<UserException *>(&e)) {
             std::cerr << e.what() << std::endl;
         }
@@ -18,10 +18,30 @@
 #include "../../common/constants.hpp"
 #include "../../common/test_mode.hpp"
 #include "../../domain/graph.hpp"
+#include "../../domain/image_decoder.hpp"
 #include "../../domain/image_manager.hpp"
+#include "../../domain/layout_cache.hpp"
 #include "../../domain/mind_map_data.hpp"
+#include "../../infra/io/alz_data_keywords.hpp"
 #include "../../infra/io/alz_file_io.hpp"
 #include "../../infra/io/alz_file_io_version.hpp"
+#include "../../infra/io/alz_stream_reader.hpp"
+#include "../../infra/io/alz_stream_writer.hpp"
+#include "../../infra/io/autosave_journal.hpp"
+#include "../../infra/io/base64.hpp"
+#include "../../infra/io/file_exception.hpp"
+#include "../../infra/io/graph_stream_writer.hpp"
+#include "../../infra/io/mind_map_header.hpp"
+#include "../../infra/io/outline_importer.hpp"
+#include "../../infra/io/stream_pipe.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <thread>
 
 using SceneItems::Edge;
 using SceneItems::EdgeModel;
@@ -250,7 +270,7 @@ void AlzFileIOTest::testLoadJpg()
     const auto inData = IO::AlzFileIO().fromXml(xml);
     QCOMPARE(inData->imageManager().images().size(), size_t { 1 });
     const auto image = inData->imageManager().getImage(1);
-    QVERIFY(image.has_value());
+    QVERIFY(image);
     QCOMPARE(image->image().width(), 4);
     QCOMPARE(image->image().height(), 4);
     QCOMPARE(image->id(), size_t(1));
@@ -272,13 +292,118 @@ void AlzFileIOTest::testLoadPng()
     const auto inData = IO::AlzFileIO().fromXml(xml);
     QCOMPARE(inData->imageManager().images().size(), size_t { 1 });
     const auto image = inData->imageManager().getImage(1);
-    QVERIFY(image.has_value());
+    QVERIFY(image);
     QCOMPARE(image->image().width(), 4);
     QCOMPARE(image->image().height(), 4);
     QCOMPARE(image->id(), size_t(1));
     QCOMPARE(image->path(), std::string("test.png"));
 }
 
+void AlzFileIOTest::testLoadImageDecodesOnRequest()
+{
+    const QString xml =
+      "<?xml version='1.0' encoding='UTF-8'?>"
+      "<heimer-mind-map version=\"3.6.1\">"
+      " <image path=\"test.png\" id=\"1\">iVBORw0KGgoAAAANSUhEUgAAAAQAAAAECAIAAAAmkwkpAAAACXBIWXMAAAsTAAALEwEAmpwYAAAAGXRFWHRDb21tZW50AENyZWF0ZWQgd2l0aCBHSU1QV4EOFwAAABRJREFUCJlj/P//PwMMMDEgAdwcAJZuAwUDbWh7AAAAAElFTkSuQmCC</image>"
+      "</heimer-mind-map>";
+    const auto inData = IO::AlzFileIO().fromXml(xml);
+    const auto image = inData->imageManager().getImage(1);
+    QVERIFY(image);
+    QVERIFY(image->decoder());
+    QVERIFY(!image->isDecoded());
+    QCOMPARE(image->mimeType(), QString("image/png"));
+    image->requestDecode();
+    QTRY_VERIFY(image->isDecoded());
+    QCOMPARE(image->image().size(), QSize(4, 4));
+}
+
+void AlzFileIOTest::testImageDataMovesToDiskOverMemoryCap()
+{
+    const auto data = QByteArray::fromBase64("iVBORw0KGgoAAAANSUhEUgAAAAQAAAAECAIAAAAmkwkpAAAACXBIWXMAAAsTAAALEwEAmpwYAAAAGXRFWHRDb21tZW50AENyZWF0ZWQgd2l0aCBHSU1QV4EOFwAAABRJREFUCJlj/P//PwMMMDEgAdwcAJZuAwUDbWh7AAAAAElFTkSuQmCC");
+    ImageDecoder::setMemoryCap(1);
+    const auto image1 = Image::fromEncodedData(data, "test1.png");
+    const auto image2 = Image::fromEncodedData(data, "test2.png");
+    QVERIFY(image1.decoder()->isDataOnDisk());
+    QVERIFY(!image2.decoder()->isDataOnDisk());
+    QCOMPARE(image1.data(), data);
+    QCOMPARE(image1.image().size(), QSize(4, 4));
+    QVERIFY(image2.decoder()->isDataOnDisk());
+    QCOMPARE(image2.data(), data);
+    ImageDecoder::setMemoryCap(0);
+}
+
+void AlzFileIOTest::testLoadSvgRendersLevelsForSize()
+{
+    const QByteArray svg = "<?xml version=\"1.0\"?>"
+                           "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"20\" height=\"10\">"
+                           "<rect width=\"20\" height=\"10\" fill=\"#ff0000\"/>"
+                           "</svg>";
+    const auto image = Image::fromEncodedData(svg, "logo.svg");
+    QVERIFY(image.isVector());
+    QCOMPARE(image.mimeType(), QString("image/svg+xml"));
+    QCOMPARE(image.data(), svg);
+    QCOMPARE(image.image().size(), QSize(20, 10));
+
+    image.decoder()->decode();
+    QVERIFY(image.hasLevel({ 20, 10 }));
+    QVERIFY(!image.hasLevel({ 100, 100 }));
+
+    // Rendered to cover the size with the aspect ratio of the image, not scaled up from the default size
+    image.decoder()->renderLevel({ 100, 100 });
+    QVERIFY(image.hasLevel({ 100, 100 }));
+    QCOMPARE(image.level({ 100, 100 }).size(), QSize(200, 100));
+    QCOMPARE(image.level({ 100, 100 }).pixelColor(199, 99), QColor(Qt::red));
+
+    // Only the latest rendering is kept
+    image.decoder()->renderLevel({ 40, 20 });
+    QCOMPARE(image.level({ 40, 20 }).size(), QSize(40, 20));
+    QVERIFY(!image.hasLevel({ 100, 100 }));
+
+    QVERIFY(Image::isVectorFileName("logo.SVG"));
+    QVERIFY(!Image::isVectorFileName("logo.png"));
+}
+
+void AlzFileIOTest::testBase64OfLargeDataMatchesQt()
+{
+    // Large enough to be split into several chunks, and not a multiple of three to get padding
+    QByteArray data;
+    for (int i = 0; i < 5 * 1024 * 1024 + 1; i++) {
+        data.append(static_cast<char>((i * 7919) % 251));
+    }
+
+    const auto base64 = IO::Base64::encode(data);
+    QCOMPARE(base64, data.toBase64());
+    QCOMPARE(IO::Base64::decode(base64), data);
+
+    // Not splittable, decoded in one go
+    auto base64WithNewline = base64;
+    base64WithNewline.insert(100, '\n');
+    QCOMPARE(IO::Base64::decode(base64WithNewline), data);
+}
+
+void AlzFileIOTest::testSaveKeepsEncodedImageData()
+{
+    const QString base64 = "iVBORw0KGgoAAAANSUhEUgAAAAQAAAAECAIAAAAmkwkpAAAACXBIWXMAAAsTAAALEwEAmpwYAAAAGXRFWHRDb21tZW50AENyZWF0ZWQgd2l0aCBHSU1QV4EOFwAAABRJREFUCJlj/P//PwMMMDEgAdwcAJZuAwUDbWh7AAAAAElFTkSuQmCC";
+    const QString xml =
+      "<?xml version='1.0' encoding='UTF-8'?>"
+      "<heimer-mind-map version=\"3.6.1\">"
+      " <graph>"
+      "  <node w=\"200000\" x=\"0\" y=\"0\" h=\"75000\" index=\"0\">"
+      "   <image ref=\"1\"/>"
+      "  </node>"
+      " </graph>"
+      " <image path=\"test.png\" id=\"1\">"
+      + base64 + "</image>"
+                 "</heimer-mind-map>";
+    const std::shared_ptr<MindMapData> inData = IO::AlzFileIO().fromXml(xml);
+    const auto image = inData->imageManager().getImage(1);
+    QVERIFY(image);
+    QCOMPARE(image->data(), QByteArray::fromBase64(base64.toLatin1()));
+
+    // The original bytes are written back as-is instead of re-encoding the image
+    QVERIFY(IO::AlzFileIO().toXml(inData).contains(base64));
+}
+
 void AlzFileIOTest::testNotUsedImages()
 {
     const auto outData = std::make_shared<MindMapData>();
@@ -309,6 +434,28 @@ void AlzFileIOTest::testUsedImages()
     QCOMPARE(inData->imageManager().images().size(), size_t { 2 });
 }
 
+void AlzFileIOTest::testIdenticalImagesAreStoredOnce()
+{
+    const auto outData = std::make_shared<MindMapData>();
+    const auto id1 = outData->imageManager().addImage({ QImage {}, "foo.png", "imagedata" });
+    const auto id2 = outData->imageManager().addImage({ QImage {}, "bar.png", "imagedata" });
+    const auto id3 = outData->imageManager().addImage({ QImage {}, "baz.png", "otherdata" });
+    QCOMPARE(id2, id1);
+    QVERIFY(id3 != id1);
+    QCOMPARE(outData->imageManager().images().size(), size_t { 2 });
+    QCOMPARE(outData->imageManager().findImageByData("otherdata").value_or(0), id3);
+
+    auto node1 = std::make_shared<Node>();
+    outData->graph().addNode(node1);
+    node1->setImageRef(id1);
+    auto node2 = std::make_shared<Node>();
+    outData->graph().addNode(node2);
+    node2->setImageRef(id2);
+
+    const auto inData = IO::AlzFileIO().fromXml(IO::AlzFileIO().toXml(outData));
+    QCOMPARE(inData->imageManager().images().size(), size_t { 1 });
+}
+
 void AlzFileIOTest::testGraph_NodeDeletion()
 {
     const auto outData = std::make_shared<MindMapData>();
@@ -386,6 +533,26 @@ void AlzFileIOTest::testGraph_SingleNode()
     QCOMPARE(node->textColor(), outNode->textColor());
 }
 
+void AlzFileIOTest::testStreamWriter_ReplacesFileAtomically()
+{
+    QTemporaryDir dir;
+    const auto path = dir.filePath("test.alz");
+    IO::AlzFileIO io;
+
+    const auto outData1 = std::make_shared<MindMapData>();
+    outData1->graph().addNode(std::make_shared<Node>());
+    QVERIFY(io.toFile(outData1, path, false));
+
+    const auto outData2 = std::make_shared<MindMapData>();
+    outData2->graph().addNode(std::make_shared<Node>());
+    outData2->graph().addNode(std::make_shared<Node>());
+    QVERIFY(io.toFile(outData2, path, false));
+
+    // No temporary files are left behind
+    QCOMPARE(QDir(dir.path()).entryList(QDir::Files), QStringList { "test.alz" });
+    QCOMPARE(io.toXml(io.fromFile(path)), io.toXml(outData2));
+}
+
 void AlzFileIOTest::testV1_ArrowSize()
 {
     const auto outData = std::make_shared<MindMapData>();
@@ -657,6 +824,668 @@ void AlzFileIOTest::testV2_Version()
     QCOMPARE(inData->alzFormatVersion(), Constants::Application::alzFormatVersion());
 }
 
+void AlzFileIOTest::testV2_CachedLayout()
+{
+    const auto outData = std::make_shared<MindMapData>();
+    const auto outNode0 = std::make_shared<Node>();
+    outData->graph().addNode(outNode0);
+    const auto outNode1 = std::make_shared<Node>();
+    outData->graph().addNode(outNode1);
+    outData->graph().addEdge(std::make_shared<Edge>(outNode0, outNode1));
+
+    LayoutCache::Entry entry;
+    entry.topologyKey = LayoutCache::topologyKey(outData->graph());
+    entry.key = LayoutCache::key(entry.topologyKey, { 1.0, 100 });
+    entry.layout = { { outNode0->index(), { 1.5, -2 } }, { outNode1->index(), { 300, 400.25 } } };
+    outData->layoutCache().insert(entry);
+
+    const auto inData = IO::AlzFileIO().fromXml(IO::AlzFileIO().toXml(outData));
+    const auto inEntry = inData->layoutCache().latest();
+    QVERIFY(inEntry);
+    QCOMPARE(inEntry->key, entry.key);
+    QCOMPARE(inEntry->topologyKey, LayoutCache::topologyKey(inData->graph()));
+    QCOMPARE(inEntry->layout, entry.layout);
+
+    // V1 has no cached layouts
+    QCOMPARE(IO::AlzFileIO().fromXml(IO::AlzFileIO(IO::AlzFormatVersion::V1).toXml(outData))->layoutCache().size(), size_t { 0 });
+
+    // A layout of an older structure is not saved
+    outData->graph().addNode(std::make_shared<Node>());
+    QCOMPARE(IO::AlzFileIO().fromXml(IO::AlzFileIO().toXml(outData))->layoutCache().size(), size_t { 0 });
+}
+
+void AlzFileIOTest::testV2_DenseIndices()
+{
+    const auto outData = std::make_shared<MindMapData>();
+    const auto outNode0 = std::make_shared<Node>();
+    outNode0->setText("Node0");
+    outData->graph().addNode(outNode0);
+    const auto outNode1 = std::make_shared<Node>();
+    outData->graph().addNode(outNode1);
+    const auto outNode2 = std::make_shared<Node>();
+    outNode2->setText("Node2");
+    outNode2->setUuid(QUuid::createUuid());
+    outData->graph().addNode(outNode2);
+    outData->graph().addEdge(std::make_shared<Edge>(outNode2, outNode0));
+    outData->graph().deleteNode(outNode1->index());
+
+    LayoutCache::Entry entry;
+    entry.topologyKey = LayoutCache::topologyKey(outData->graph());
+    entry.key = LayoutCache::key(entry.topologyKey, { 1.0, 100 });
+    entry.layout = { { outNode0->index(), { 1, 2 } }, { outNode2->index(), { 3, 4 } } };
+    outData->layoutCache().insert(entry);
+
+    const auto xml = IO::AlzFileIO().toXml(outData);
+    QVERIFY(xml.contains("<node i=\"1\""));
+    QVERIFY(!xml.contains("<node i=\"2\""));
+
+    // The nodes are renumbered in the order of their indices and the edges follow them
+    const auto inData = IO::AlzFileIO().fromXml(xml);
+    QCOMPARE(inData->graph().nodeCount(), size_t(2));
+    QCOMPARE(inData->graph().getNode(0)->text(), outNode0->text());
+    QCOMPARE(inData->graph().getNode(1)->text(), outNode2->text());
+    QCOMPARE(inData->graph().getNode(1)->uuid(), outNode2->uuid());
+    QVERIFY(inData->graph().getEdge(1, 0));
+
+    // The cached layout is renumbered and rekeyed along with the nodes
+    const auto inEntry = inData->layoutCache().latest();
+    QVERIFY(inEntry);
+    QCOMPARE(inEntry->topologyKey, LayoutCache::topologyKey(inData->graph()));
+    QCOMPARE(inEntry->key, LayoutCache::key(inEntry->topologyKey, { 1.0, 100 }));
+    QCOMPARE(inEntry->layout, (LayoutCache::Layout { { 0, { 1, 2 } }, { 1, { 3, 4 } } }));
+
+    // The in-memory indices are left as they are
+    QCOMPARE(outNode2->index(), 2);
+}
+
+static QString writeTestFile(const QTemporaryDir & dir, QString content, QString fileName = "test.alz")
+{
+    const auto path = dir.filePath(fileName);
+    QFile file(path);
+    file.open(QIODevice::WriteOnly);
+    file.write(content.toUtf8());
+    return path;
+}
+
+void AlzFileIOTest::testAutosaveJournal_Replay()
+{
+    const auto outData = std::make_shared<MindMapData>();
+    const auto outNode0 = std::make_shared<Node>();
+    outNode0->setText("Node0");
+    outData->graph().addNode(outNode0);
+
+    QTemporaryDir dir;
+    const auto path = dir.filePath("test.alz");
+    IO::AlzFileIO io;
+    QVERIFY(io.toFile(outData, path, false));
+
+    IO::AutosaveJournal journal;
+    journal.reset(*outData);
+    QVERIFY(journal.createRecord(*outData).isEmpty());
+
+    const auto outNode1 = std::make_shared<Node>();
+    outNode1->setText("Node1");
+    outData->graph().addNode(outNode1);
+    outData->graph().addEdge(std::make_shared<Edge>(outNode0, outNode1));
+    QVERIFY(IO::AutosaveJournal::appendRecord(IO::AutosaveJournal::journalPath(path), journal.createRecord(*outData)));
+
+    outNode0->setText("Node0 modified");
+    outData->setBackgroundColor({ 1, 2, 3 });
+    QVERIFY(IO::AutosaveJournal::appendRecord(IO::AutosaveJournal::journalPath(path), journal.createRecord(*outData)));
+    QCOMPARE(journal.recordCount(), size_t(2));
+
+    const std::shared_ptr<MindMapData> inData = io.fromFile(path);
+    QCOMPARE(IO::AutosaveJournal::replay(IO::AutosaveJournal::journalPath(path), *inData), size_t(2));
+    QCOMPARE(io.toXml(inData), io.toXml(outData));
+}
+
+void AlzFileIOTest::testAutosaveJournal_ReplayAfterRenumberedSave()
+{
+    const auto outData = std::make_shared<MindMapData>();
+    std::vector<NodeS> outNodes;
+    for (int i = 0; i < 3; i++) {
+        outNodes.push_back(std::make_shared<Node>());
+        outNodes.back()->setText(QString { "Node%1" }.arg(i));
+        outData->graph().addNode(outNodes.back());
+    }
+    outData->graph().addEdge(std::make_shared<Edge>(outNodes.at(0), outNodes.at(2)));
+    outData->graph().deleteNode(outNodes.at(1)->index());
+
+    QTemporaryDir dir;
+    const auto path = dir.filePath("test.alz");
+    IO::AlzFileIO io;
+    QVERIFY(io.toFile(outData, path, false));
+
+    // The file has the dense indices 0 and 1, while the nodes in memory still have 0 and 2
+    IO::AutosaveJournal journal;
+    journal.reset(*outData, true);
+
+    const auto outNode3 = std::make_shared<Node>();
+    outNode3->setText("Node3");
+    outData->graph().addNode(outNode3);
+    outData->graph().addEdge(std::make_shared<Edge>(outNodes.at(2), outNode3));
+    outNodes.at(2)->setText("Node2 modified");
+    QVERIFY(IO::AutosaveJournal::appendRecord(IO::AutosaveJournal::journalPath(path), journal.createRecord(*outData)));
+
+    const std::shared_ptr<MindMapData> inData = io.fromFile(path);
+    QCOMPARE(IO::AutosaveJournal::replay(IO::AutosaveJournal::journalPath(path), *inData), size_t(1));
+    QCOMPARE(io.toXml(inData), io.toXml(outData));
+}
+
+void AlzFileIOTest::testAutosaveJournal_TruncatedRecord()
+{
+    const auto outData = std::make_shared<MindMapData>();
+    outData->graph().addNode(std::make_shared<Node>());
+
+    QTemporaryDir dir;
+    const auto path = dir.filePath("test.alz");
+    IO::AlzFileIO io;
+    QVERIFY(io.toFile(outData, path, false));
+
+    IO::AutosaveJournal journal;
+    journal.reset(*outData);
+    outData->graph().addNode(std::make_shared<Node>());
+    QVERIFY(IO::AutosaveJournal::appendRecord(IO::AutosaveJournal::journalPath(path), journal.createRecord(*outData)));
+    const auto expectedXml = io.toXml(outData);
+
+    outData->graph().addNode(std::make_shared<Node>());
+    QVERIFY(IO::AutosaveJournal::appendRecord(IO::AutosaveJournal::journalPath(path), journal.createRecord(*outData)));
+
+    QFile file(IO::AutosaveJournal::journalPath(path));
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.resize(file.size() - 4));
+    file.close();
+
+    const std::shared_ptr<MindMapData> inData = io.fromFile(path);
+    QCOMPARE(IO::AutosaveJournal::replay(IO::AutosaveJournal::journalPath(path), *inData), size_t(1));
+    QCOMPARE(io.toXml(inData), expectedXml);
+}
+
+void AlzFileIOTest::testAutosaveJournal_RemovedOnSave()
+{
+    const auto outData = std::make_shared<MindMapData>();
+
+    QTemporaryDir dir;
+    const auto path = dir.filePath("test.alz");
+    IO::AlzFileIO io;
+    IO::AutosaveJournal journal;
+    journal.reset(*outData);
+    outData->graph().addNode(std::make_shared<Node>());
+    QVERIFY(io.appendToJournal(path, journal.createRecord(*outData), false));
+    QVERIFY(QFile::exists(IO::AutosaveJournal::journalPath(path)));
+
+    QVERIFY(io.toFile(outData, path, false));
+    QVERIFY(!QFile::exists(IO::AutosaveJournal::journalPath(path)));
+}
+
+void AlzFileIOTest::testCompressedFile()
+{
+    const auto outData = std::make_shared<MindMapData>();
+    // Spans multiple compression chunks
+    for (int i = 0; i < 3000; i++) {
+        const auto node = std::make_shared<Node>();
+        node->setText(QString(500, QChar('a' + i % 26)));
+        outData->graph().addNode(node);
+    }
+
+    QTemporaryDir dir;
+    const auto path = dir.filePath("test.alz");
+    IO::AlzFileIO io;
+    io.setCompressionEnabled(true);
+    QVERIFY(io.toFile(outData, path, false));
+    QVERIFY(IO::AlzFileIO::isCompressedFile(path));
+    QVERIFY(QFileInfo(path).size() < io.toXml(outData).size() / 10);
+
+    const std::shared_ptr<MindMapData> inData = io.fromFile(path);
+    QCOMPARE(io.toXml(inData), io.toXml(outData));
+}
+
+void AlzFileIOTest::testCompressedFile_Corrupted()
+{
+    const auto outData = std::make_shared<MindMapData>();
+    outData->graph().addNode(std::make_shared<Node>());
+
+    QTemporaryDir dir;
+    const auto path = dir.filePath("test.alz");
+    IO::AlzFileIO io;
+    io.setCompressionEnabled(true);
+    QVERIFY(io.toFile(outData, path, false));
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.resize(file.size() - 8));
+    file.close();
+
+    QVERIFY_EXCEPTION_THROWN(io.fromFile(path), IO::FileException);
+}
+
+void AlzFileIOTest::testStreamReader_Graph()
+{
+    const auto outData = std::make_shared<MindMapData>();
+    const auto outNode0 = std::make_shared<Node>();
+    outNode0->setLocation({ 1.5, 2.5 });
+    outNode0->setText("Node 0\nSecond line");
+    outNode0->setColor(Qt::red);
+    outData->graph().addNode(outNode0);
+    const auto outNode1 = std::make_shared<Node>();
+    outNode1->setTextColor(Qt::blue);
+    outData->graph().addNode(outNode1);
+    const auto outEdge = std::make_shared<Edge>(outNode0, outNode1);
+    outEdge->setText("Edge");
+    outEdge->setDashedLine(true);
+    outEdge->setReversed(true);
+    outEdge->setArrowMode(EdgeModel::ArrowMode::Double);
+    outData->graph().addEdge(outEdge);
+
+    QTemporaryDir dir;
+    const auto inData = IO::AlzStreamReader::readFromFile(writeTestFile(dir, IO::AlzFileIO().toXml(outData)));
+    QCOMPARE(inData->applicationVersion(), Constants::Application::applicationVersion());
+    QCOMPARE(inData->alzFormatVersion(), Constants::Application::alzFormatVersion());
+    QCOMPARE(inData->graph().nodeCount(), outData->graph().nodeCount());
+    QCOMPARE(inData->graph().edgeCount(), outData->graph().edgeCount());
+
+    const auto inNode0 = inData->graph().getNode(outNode0->index());
+    QVERIFY(inNode0);
+    QCOMPARE(inNode0->location(), outNode0->location());
+    QCOMPARE(inNode0->text(), outNode0->text());
+    QCOMPARE(inNode0->color(), outNode0->color());
+    const auto inNode1 = inData->graph().getNode(outNode1->index());
+    QVERIFY(inNode1);
+    QCOMPARE(inNode1->textColor(), outNode1->textColor());
+
+    const auto inEdge = inData->graph().getEdge(outNode0->index(), outNode1->index());
+    QVERIFY(inEdge);
+    QCOMPARE(inEdge->text(), outEdge->text());
+    QCOMPARE(inEdge->dashedLine(), outEdge->dashedLine());
+    QCOMPARE(inEdge->reversed(), outEdge->reversed());
+    QCOMPARE(inEdge->arrowMode(), outEdge->arrowMode());
+}
+
+void AlzFileIOTest::testStreamReader_Style()
+{
+    const auto outData = std::make_shared<MindMapData>();
+    outData->setArrowSize(42.0);
+    outData->setBackgroundColor({ 1, 2, 3 });
+    outData->setCornerRadius(7);
+    outData->setEdgeColor({ 4, 5, 6 });
+    outData->setEdgeWidth(3.5);
+    outData->setGridColor({ 7, 8, 9 });
+    outData->setTextSize(13);
+    QFont font;
+    font.setFamily("Foo");
+    font.setBold(true);
+    font.setItalic(true);
+    outData->changeFont(font);
+    outData->setAspectRatio(1.5);
+    outData->setMinEdgeLength(123.0);
+
+    for (auto && version : { IO::AlzFormatVersion::V1, IO::AlzFormatVersion::V2 }) {
+        QTemporaryDir dir;
+        const auto inData = IO::AlzStreamReader::readFromFile(writeTestFile(dir, IO::AlzFileIO(version).toXml(outData)));
+        QCOMPARE(inData->arrowSize(), outData->arrowSize());
+        QCOMPARE(inData->backgroundColor(), outData->backgroundColor());
+        QCOMPARE(inData->cornerRadius(), outData->cornerRadius());
+        QCOMPARE(inData->edgeColor(), outData->edgeColor());
+        QCOMPARE(inData->edgeWidth(), outData->edgeWidth());
+        QCOMPARE(inData->gridColor(), outData->gridColor());
+        QCOMPARE(inData->textSize(), outData->textSize());
+        QCOMPARE(inData->font().family(), outData->font().family());
+        QCOMPARE(inData->font().bold(), outData->font().bold());
+        QCOMPARE(inData->font().italic(), outData->font().italic());
+        QCOMPARE(inData->aspectRatio(), outData->aspectRatio());
+        QCOMPARE(inData->minEdgeLength(), outData->minEdgeLength());
+    }
+}
+
+void AlzFileIOTest::testStreamReader_CorruptedFile()
+{
+    QTemporaryDir dir;
+    const auto path = writeTestFile(dir, "<heimer-mind-map><graph><node i=\"0\">");
+    QVERIFY_EXCEPTION_THROWN(IO::AlzStreamReader::readFromFile(path), IO::FileException);
+}
+
+void AlzFileIOTest::testStreamReader_InvalidEdgeIndex()
+{
+    QTemporaryDir dir;
+    for (auto && index : { "-1", "7" }) {
+        const auto path = writeTestFile(dir, QString("<heimer-mind-map><graph><node i=\"0\"/><edge i0=\"0\" i1=\"%1\"/></graph></heimer-mind-map>").arg(index));
+        QVERIFY_EXCEPTION_THROWN(IO::AlzStreamReader::readFromFile(path), IO::FileException);
+        // Also the fallback to the DOM-based reader
+        QVERIFY_EXCEPTION_THROWN(IO::AlzFileIO().fromFile(path), IO::FileException);
+    }
+}
+
+void AlzFileIOTest::testStreamReader_InvalidNodeIndex()
+{
+    QTemporaryDir dir;
+    for (auto && index : { "-5", "2000000000" }) {
+        const auto path = writeTestFile(dir, QString("<heimer-mind-map><graph><node i=\"%1\"/></graph></heimer-mind-map>").arg(index));
+        QVERIFY_EXCEPTION_THROWN(IO::AlzStreamReader::readFromFile(path), IO::FileException);
+        // Also the fallback to the DOM-based reader
+        QVERIFY_EXCEPTION_THROWN(IO::AlzFileIO().fromFile(path), IO::FileException);
+    }
+}
+
+void AlzFileIOTest::testStreamReader_Header()
+{
+    const auto outData = std::make_shared<MindMapData>();
+    const auto outNode0 = std::make_shared<Node>();
+    outNode0->setLocation({ 0, 0 });
+    outNode0->setSize({ 100, 50 });
+    outData->graph().addNode(outNode0);
+    const auto outNode1 = std::make_shared<Node>();
+    outNode1->setLocation({ 200, 100 });
+    outNode1->setSize({ 100, 50 });
+    outData->graph().addNode(outNode1);
+    outData->graph().addEdge(std::make_shared<Edge>(outNode0, outNode1));
+
+    QTemporaryDir dir;
+    const auto path = dir.filePath("test.alz");
+    IO::AlzFileIO io;
+    QVERIFY(io.toFile(outData, path, false));
+
+    // Cut off everything after the header, which must not be read
+    const auto xml = io.toXml(outData);
+    const auto headerEnd = xml.indexOf("</header>") + QString { "</header>" }.size();
+    QVERIFY(headerEnd < xml.indexOf("<style>"));
+    const auto truncatedPath = writeTestFile(dir, xml.left(headerEnd), "truncated.alz");
+
+    for (auto && filePath : { path, truncatedPath }) {
+        const auto header = IO::readHeader(filePath);
+        QVERIFY(header);
+        QCOMPARE(header->applicationVersion, Constants::Application::applicationVersion());
+        QCOMPARE(header->nodeCount, size_t { 2 });
+        QCOMPARE(header->edgeCount, size_t { 1 });
+        QCOMPARE(header->bounds, QRectF(-50, -25, 300, 150));
+        const auto thumbnail = header->thumbnailImage();
+        QVERIFY(!thumbnail.isNull());
+        QVERIFY(thumbnail.width() > thumbnail.height());
+    }
+
+    io.setCompressionEnabled(true);
+    QVERIFY(io.toFile(outData, path, false));
+    QCOMPARE(IO::readHeader(path)->nodeCount, size_t { 2 });
+}
+
+void AlzFileIOTest::testStreamReader_Header_OldFile()
+{
+    QTemporaryDir dir;
+    const auto path = writeTestFile(dir, "<?xml version='1.0' encoding='UTF-8'?><heimer-mind-map application-version=\"4.0.0\" alz-format-version=\"2\"><style/><graph/></heimer-mind-map>");
+    QVERIFY(!IO::readHeader(path));
+
+    // V1 output has no header either, but is still read as before
+    const auto outData = std::make_shared<MindMapData>();
+    outData->graph().addNode(std::make_shared<Node>());
+    const auto v1Path = writeTestFile(dir, IO::AlzFileIO(IO::AlzFormatVersion::V1).toXml(outData), "v1.alz");
+    QVERIFY(!IO::readHeader(v1Path));
+    QCOMPARE(IO::AlzFileIO().fromFile(v1Path)->graph().nodeCount(), size_t { 1 });
+}
+
+void AlzFileIOTest::testStreamReader_Sections()
+{
+    const auto outData = std::make_shared<MindMapData>();
+    QImage qImage(4, 2, QImage::Format_ARGB32);
+    qImage.fill(Qt::red);
+    for (int i = 0; i < 100; i++) {
+        const auto node = std::make_shared<Node>();
+        node->setText(QString(100, QChar('a' + i % 26)));
+        if (i < 2) {
+            node->setImageRef(outData->imageManager().addImage(Image(qImage, "red.png")));
+        }
+        outData->graph().addNode(node);
+    }
+    const auto xml = IO::AlzFileIO().toXml(outData);
+    QTemporaryDir dir;
+    const auto sections = IO::AlzStreamReader::readSections(writeTestFile(dir, xml));
+
+    QVERIFY(!sections.empty());
+    QCOMPARE(sections.front().name, QString { IO::DataKeywords::MindMap::V2::Metadata::ELEMENT_HEADER });
+    const auto section = [&sections](QString name) {
+        return std::find_if(sections.begin(), sections.end(), [&name](auto && section) {
+            return section.name == name;
+        });
+    };
+    const auto graph = section(IO::DataKeywords::MindMap::ELEMENT_GRAPH);
+    QVERIFY(graph != sections.end());
+    QCOMPARE(graph->count, size_t { 1 });
+    QVERIFY(graph->size > 100 * 100);
+    const auto images = section(IO::DataKeywords::MindMap::ELEMENT_IMAGE);
+    QVERIFY(images != sections.end());
+    QCOMPARE(images->count, size_t { 2 });
+
+    // Everything but the start and the end of the root element is in the sections
+    qint64 totalSize = 0;
+    for (auto && section : sections) {
+        totalSize += section.size;
+    }
+    QVERIFY(totalSize < xml.size());
+    QVERIFY(totalSize > xml.size() - 500);
+}
+
+void AlzFileIOTest::testStreamReader_FromPipe()
+{
+    const auto outData = std::make_shared<MindMapData>();
+    for (int i = 0; i < 1000; i++) {
+        const auto node = std::make_shared<Node>();
+        node->setText(QString(100, QChar('a' + i % 26)));
+        outData->graph().addNode(node);
+    }
+    const auto xml = IO::AlzFileIO().toXml(outData).toUtf8();
+
+    // The data arrives in small chunks while the reader is parsing, like a download
+    IO::StreamPipe pipe;
+    std::thread writer([&pipe, &xml] {
+        const int chunkSize = 1000;
+        for (int pos = 0; pos < xml.size(); pos += chunkSize) {
+            pipe.append(xml.mid(pos, chunkSize));
+        }
+        pipe.finish();
+    });
+    const std::shared_ptr<MindMapData> inData = IO::AlzStreamReader::readFromDevice(pipe, "test");
+    writer.join();
+
+    QCOMPARE(IO::AlzFileIO().toXml(inData), IO::AlzFileIO().toXml(outData));
+}
+
+void AlzFileIOTest::testStreamReader_FromBrokenPipe()
+{
+    const auto outData = std::make_shared<MindMapData>();
+    outData->graph().addNode(std::make_shared<Node>());
+    const auto xml = IO::AlzFileIO().toXml(outData).toUtf8();
+
+    IO::StreamPipe pipe;
+    pipe.append(xml.left(xml.size() / 2));
+    pipe.finish("Connection closed");
+    QVERIFY_EXCEPTION_THROWN(IO::AlzStreamReader::readFromDevice(pipe, "test"), IO::FileException);
+    QCOMPARE(pipe.writerError(), QString { "Connection closed" });
+}
+
+void AlzFileIOTest::testStreamWriter_Layout()
+{
+    const auto outData = std::make_shared<MindMapData>();
+    const auto node = std::make_shared<Node>();
+    node->setText("A & B");
+    outData->graph().addNode(node);
+
+    const auto xml = IO::AlzFileIO().toXml(outData);
+    QVERIFY(xml.startsWith("<?xml version='1.0' encoding='UTF-8'?>\n<heimer-mind-map application-version=\""));
+    QVERIFY(xml.contains("\n <style>\n  <color r=\""));
+    QVERIFY(xml.contains("\n <graph>\n  <node i=\"0\""));
+    QVERIFY(xml.contains("\n   <text>A &amp; B</text>\n"));
+    QVERIFY(xml.contains("\n  </node>\n </graph>\n <metadata>"));
+    QVERIFY(xml.contains("\n <metadata>\n  <layout-optimizer aspect-ratio=\""));
+    QVERIFY(xml.endsWith("</heimer-mind-map>\n"));
+}
+
+void AlzFileIOTest::testStreamWriter_ToFile()
+{
+    const auto outData = std::make_shared<MindMapData>();
+    const auto outNode = std::make_shared<Node>();
+    outNode->setText("<Node>");
+    outData->graph().addNode(outNode);
+
+    QTemporaryDir dir;
+    const auto path = dir.filePath("test.alz");
+    QVERIFY(IO::AlzFileIO().toFile(outData, path, false));
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly | QIODevice::Text));
+    QCOMPARE(QString::fromUtf8(file.readAll()), IO::AlzFileIO().toXml(outData));
+
+    const auto inData = IO::AlzStreamReader::readFromFile(path);
+    QCOMPARE(inData->graph().nodeCount(), static_cast<size_t>(1));
+    QCOMPARE(inData->graph().getNode(outNode->index())->text(), outNode->text());
+}
+
+void AlzFileIOTest::testStreamWriter_FragmentCache()
+{
+    const auto outData = std::make_shared<MindMapData>();
+    std::vector<NodeS> nodes;
+    for (int i = 0; i < 3; i++) {
+        nodes.push_back(std::make_shared<Node>());
+        nodes.back()->setText(QString("<Node %1>").arg(i));
+        outData->graph().addNode(nodes.back());
+    }
+    outData->graph().addEdge(std::make_shared<Edge>(nodes.at(0), nodes.at(1)));
+    outData->graph().addEdge(std::make_shared<Edge>(nodes.at(0), nodes.at(2)));
+
+    QTemporaryDir dir;
+    const auto path = dir.filePath("test.alz");
+    const auto readFile = [&path] {
+        QFile file(path);
+        file.open(QIODevice::ReadOnly | QIODevice::Text);
+        return QString::fromUtf8(file.readAll());
+    };
+
+    IO::AlzStreamWriter::FragmentCache cache;
+    const auto version = Constants::Application::alzFormatVersion();
+    QVERIFY(IO::AlzStreamWriter::writeToFile(outData, path, version, false, &cache));
+    QCOMPARE(cache.reusedCount, size_t(0));
+    QCOMPARE(readFile(), IO::AlzStreamWriter::writeToString(outData, version));
+
+    nodes.at(1)->setText("Edited");
+    QVERIFY(IO::AlzStreamWriter::writeToFile(outData, path, version, false, &cache));
+    QCOMPARE(cache.reusedCount, size_t(4));
+    QCOMPARE(readFile(), IO::AlzStreamWriter::writeToString(outData, version));
+
+    outData->graph().deleteNode(nodes.at(2)->index());
+    QVERIFY(IO::AlzStreamWriter::writeToFile(outData, path, version, false, &cache));
+    QCOMPARE(cache.reusedCount, size_t(3));
+    QCOMPARE(cache.nodes.size(), size_t(2));
+    QCOMPARE(cache.edges.size(), size_t(1));
+    QCOMPARE(readFile(), IO::AlzStreamWriter::writeToString(outData, version));
+}
+
+void AlzFileIOTest::testOutlineImporter_FreeMind()
+{
+    QTemporaryDir dir;
+    const auto path = writeTestFile(dir, R"(<map version="1.0.1"><node TEXT="Root" BACKGROUND_COLOR="#010203">)"
+                                         R"(<node TEXT="A"><node TEXT="A1"/></node><node TEXT="B"/></node></map>)",
+                                    "test.mm");
+    QVERIFY(IO::OutlineImporter::isOutlineFile(path));
+
+    const auto inData = IO::OutlineImporter::readFromFile(path);
+    QCOMPARE(inData->graph().nodeCount(), size_t(4));
+    QCOMPARE(inData->graph().edgeCount(), size_t(3));
+    QCOMPARE(inData->graph().getNode(0)->text(), QString("Root"));
+    QCOMPARE(inData->graph().getNode(0)->color(), QColor(1, 2, 3));
+    QVERIFY(inData->graph().areDirectlyConnected(0, 1));
+    QVERIFY(inData->graph().areDirectlyConnected(1, 2));
+    QVERIFY(inData->graph().areDirectlyConnected(0, 3));
+}
+
+void AlzFileIOTest::testOutlineImporter_Markdown()
+{
+    QTemporaryDir dir;
+    const auto path = writeTestFile(dir, "# A\n\nParagraph\n- A1\n  - A11\n- A2\n```\n- Code\n```\n## B\n", "test.md");
+    QVERIFY(IO::OutlineImporter::isOutlineFile(path));
+
+    const auto inData = IO::OutlineImporter::readFromFile(path);
+    QCOMPARE(inData->graph().nodeCount(), size_t(6));
+    QCOMPARE(inData->graph().edgeCount(), size_t(5));
+    QCOMPARE(inData->graph().getNode(0)->text(), QString("test"));
+    QCOMPARE(inData->graph().getNode(3)->text(), QString("A11"));
+    QVERIFY(inData->graph().areDirectlyConnected(0, 1));
+    QVERIFY(inData->graph().areDirectlyConnected(1, 2));
+    QVERIFY(inData->graph().areDirectlyConnected(2, 3));
+    QVERIFY(inData->graph().areDirectlyConnected(1, 4));
+    QVERIFY(inData->graph().areDirectlyConnected(1, 5));
+}
+
+void AlzFileIOTest::testOutlineImporter_Opml()
+{
+    QTemporaryDir dir;
+    const auto path = writeTestFile(dir, R"(<?xml version="1.0"?><opml version="2.0"><head><title>Title</title></head>)"
+                                         R"(<body><outline text="A"><outline text="A1"/></outline><outline text="B"/></body></opml>)",
+                                    "test.opml");
+    QVERIFY(IO::OutlineImporter::isOutlineFile(path));
+    QVERIFY(!IO::OutlineImporter::isOutlineFile(dir.filePath("test.alz")));
+
+    const auto inData = IO::OutlineImporter::readFromFile(path);
+    QCOMPARE(inData->graph().nodeCount(), size_t(4));
+    QCOMPARE(inData->graph().getNode(0)->text(), QString("Title"));
+    QCOMPARE(inData->graph().getNode(2)->text(), QString("A1"));
+    QVERIFY(inData->graph().areDirectlyConnected(1, 2));
+    QVERIFY(inData->graph().areDirectlyConnected(0, 3));
+    QVERIFY(inData->graph().getNode(2)->location().x() > inData->graph().getNode(1)->location().x());
+
+    QVERIFY_EXCEPTION_THROWN(IO::OutlineImporter::readFromFile(writeTestFile(dir, "<opml><body><outline>", "corrupted.opml")), IO::FileException);
+}
+
+void AlzFileIOTest::testAsyncSaveWritesSnapshot()
+{
+    const auto outData = std::make_shared<MindMapData>();
+    const auto outNode = std::make_shared<Node>();
+    outNode->setText("Saved");
+    outData->graph().addNode(outNode);
+    const auto expectedXml = IO::AlzFileIO().toXml(outData);
+
+    QTemporaryDir dir;
+    const auto path = dir.filePath("test.alz");
+    IO::AlzFileIO io;
+    QVERIFY(io.toFile(outData, path, true));
+    outNode->setText("Edited while saving");
+    outData->graph().addNode(std::make_shared<Node>());
+    io.finish();
+
+    QCOMPARE(IO::AlzFileIO().toXml(IO::AlzFileIO().fromFile(path)), expectedXml);
+}
+
+void AlzFileIOTest::testGraphStreamWriter_JsonLines()
+{
+    const auto outData = std::make_shared<MindMapData>();
+    const auto outNode0 = std::make_shared<Node>();
+    outNode0->setText("Line \"1\"\nLine 2");
+    outData->graph().addNode(outNode0);
+    const auto outNode1 = std::make_shared<Node>();
+    outData->graph().addNode(outNode1);
+    outData->graph().addEdge(std::make_shared<Edge>(outNode0, outNode1));
+
+    const auto lines = IO::GraphStreamWriter::writeToString(*outData, IO::GraphStreamWriter::Format::JsonLines).trimmed().split('\n');
+    QCOMPARE(lines.size(), 4);
+    QVERIFY(lines.at(0).startsWith(R"({"type":"mindmap")"));
+    QVERIFY(lines.at(1).startsWith(R"({"type":"node","index":0,"text":"Line \"1\"\nLine 2")"));
+    QVERIFY(lines.at(3).startsWith(R"({"type":"edge","source":0,"target":1)"));
+}
+
+void AlzFileIOTest::testGraphStreamWriter_Outline()
+{
+    const auto outData = std::make_shared<MindMapData>();
+    std::vector<NodeS> nodes;
+    for (auto && text : { "Root", "A", "A1", "B" }) {
+        nodes.push_back(std::make_shared<Node>());
+        nodes.back()->setText(text);
+        outData->graph().addNode(nodes.back());
+    }
+    outData->graph().addEdge(std::make_shared<Edge>(nodes.at(0), nodes.at(1)));
+    outData->graph().addEdge(std::make_shared<Edge>(nodes.at(1), nodes.at(2)));
+    outData->graph().addEdge(std::make_shared<Edge>(nodes.at(0), nodes.at(3)));
+    // A cycle must not repeat nodes
+    outData->graph().addEdge(std::make_shared<Edge>(nodes.at(2), nodes.at(0)));
+
+    QCOMPARE(IO::GraphStreamWriter::writeToString(*outData, IO::GraphStreamWriter::Format::Outline), QString("Root\n  A\n    A1\n  B\n"));
+}
+
 AlzFileIOTest::~AlzFileIOTest() = default;
 
 QTEST_GUILESS_MAIN(AlzFileIOTest)
@@ -85,10 +85,74 @@ private slots:
 
     void testLoadPng();
 
+    void testLoadImageDecodesOnRequest();
+
+    void testImageDataMovesToDiskOverMemoryCap();
+
+    void testLoadSvgRendersLevelsForSize();
+
+    void testBase64OfLargeDataMatchesQt();
+
+    void testSaveKeepsEncodedImageData();
+
     void testNotUsedImages();
 
     void testUsedImages();
 
+    void testIdenticalImagesAreStoredOnce();
+
+    void testAutosaveJournal_Replay();
+
+    void testAutosaveJournal_ReplayAfterRenumberedSave();
+
+    void testAutosaveJournal_TruncatedRecord();
+
+    void testAutosaveJournal_RemovedOnSave();
+
+    void testCompressedFile();
+
+    void testCompressedFile_Corrupted();
+
+    void testStreamReader_Graph();
+
+    void testStreamReader_Style();
+
+    void testStreamReader_CorruptedFile();
+
+    void testStreamReader_Header();
+
+    void testStreamReader_Header_OldFile();
+
+    void testStreamReader_InvalidEdgeIndex();
+
+    void testStreamReader_InvalidNodeIndex();
+
+    void testStreamReader_Sections();
+
+    void testStreamReader_FromPipe();
+
+    void testStreamReader_FromBrokenPipe();
+
+    void testStreamWriter_Layout();
+
+    void testStreamWriter_ToFile();
+
+    void testStreamWriter_FragmentCache();
+
+    void testStreamWriter_ReplacesFileAtomically();
+
+    void testAsyncSaveWritesSnapshot();
+
+    void testGraphStreamWriter_JsonLines();
+
+    void testGraphStreamWriter_Outline();
+
+    void testOutlineImporter_FreeMind();
+
+    void testOutlineImporter_Markdown();
+
+    void testOutlineImporter_Opml();
+
     void testV1_ArrowSize();
 
     void testV1_BackgroundColor();
@@ -138,6 +202,10 @@ private slots:
     void testV1_Version();
 
     void testV2_Version();
+
+    void testV2_CachedLayout();
+
+    void testV2_DenseIndices();
 };
 
 #endif // ALZ_FILE_IO_TEST_HPP
@@ -0,0 +1,340 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "alzb_file_io_test.hpp"
+
+#include "../../common/constants.hpp"
+#include "../../common/test_mode.hpp"
+#include "../../domain/graph.hpp"
+#include "../../domain/image_manager.hpp"
+#include "../../domain/mind_map_data.hpp"
+#include "../../infra/io/alz_file_io.hpp"
+#include "../../infra/io/alzb_file_io.hpp"
+#include "../../infra/io/alzb_file_io_worker.hpp"
+#include "../../infra/io/file_exception.hpp"
+#include "../../infra/io/mind_map_header.hpp"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+using SceneItems::Edge;
+using SceneItems::EdgeModel;
+using SceneItems::Node;
+
+AlzbFileIOTest::AlzbFileIOTest()
+{
+    TestMode::setEnabled(true);
+}
+
+static MindMapDataU roundTrip(MindMapDataS outData)
+{
+    QTemporaryDir dir;
+    const auto path = dir.filePath("test.alzb");
+    IO::AlzbFileIO io;
+    if (!io.toFile(outData, path, false) || !IO::AlzbFileIO::isAlzbFile(path)) {
+        return {};
+    }
+    return io.fromFile(path);
+}
+
+static MindMapDataS createTestData()
+{
+    const auto data = std::make_shared<MindMapData>();
+    const auto node0 = std::make_shared<Node>();
+    node0->setLocation({ 1.25, -2.5 });
+    node0->setSize({ 120.5, 60.125 });
+    node0->setText("Node 0 with ünicode");
+    node0->setColor(QColor(10, 20, 30));
+    node0->setTextColor(QColor(40, 50, 60));
+    data->graph().addNode(node0);
+    const auto node1 = std::make_shared<Node>();
+    node1->setText("Node 0 with ünicode");
+    node1->setCollapsed(true);
+    node1->setUuid(QUuid::createUuid());
+    data->graph().addNode(node1);
+    const auto node2 = std::make_shared<Node>();
+    data->graph().addNode(node2);
+
+    const auto edge0 = std::make_shared<Edge>(node0, node1);
+    edge0->setText("Edge 0");
+    edge0->setArrowMode(EdgeModel::ArrowMode::Hidden);
+    edge0->setDashedLine(true);
+    data->graph().addEdge(edge0);
+    const auto edge1 = std::make_shared<Edge>(node1, node2);
+    edge1->setReversed(true);
+    data->graph().addEdge(edge1);
+    return data;
+}
+
+void AlzbFileIOTest::testCorruptedEdgeIndex()
+{
+    QTemporaryDir dir;
+    const auto path = dir.filePath("test.alzb");
+    QVERIFY(IO::AlzbFileIO().toFile(createTestData(), path, false));
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    auto bytes = file.readAll();
+    // Edge count 2 followed by the first edge 0 => 1
+    const QByteArray firstEdge("\x02\0\0\0\0\0\0\0\x01\0\0\0", 12);
+    const auto offset = bytes.indexOf(firstEdge);
+    QVERIFY(offset >= 0);
+    QCOMPARE(bytes.lastIndexOf(firstEdge), offset);
+    // Point the target to a missing node
+    bytes[offset + 8] = '\x07';
+    QVERIFY(file.seek(0));
+    QCOMPARE(file.write(bytes), bytes.size());
+    file.close();
+
+    QVERIFY_EXCEPTION_THROWN(IO::AlzbFileIO().fromFile(path), IO::FileException);
+}
+
+void AlzbFileIOTest::testCorruptedFile()
+{
+    QTemporaryDir dir;
+    const auto path = dir.filePath("test.alzb");
+    QVERIFY(IO::AlzbFileIO().toFile(createTestData(), path, false));
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.resize(file.size() / 2));
+    file.close();
+
+    QVERIFY_EXCEPTION_THROWN(IO::AlzbFileIO().fromFile(path), IO::FileException);
+}
+
+void AlzbFileIOTest::testCorruptedNodeCount()
+{
+    QTemporaryDir dir;
+    const auto path = dir.filePath("test.alzb");
+    QVERIFY(IO::AlzbFileIO().toFile(createTestData(), path, false));
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    auto bytes = file.readAll();
+    // Node count 3 followed by the x-coordinate 1.25 of the first node
+    const QByteArray firstNode("\x03\0\0\0\0\0\0\0\0\0\xf4\x3f", 12);
+    const auto offset = bytes.indexOf(firstNode);
+    QVERIFY(offset >= 0);
+    QCOMPARE(bytes.lastIndexOf(firstNode), offset);
+    // Must fail as a corrupted file instead of trying to reserve memory for all the nodes
+    bytes.replace(offset, 4, QByteArray(4, '\xff'));
+    QVERIFY(file.seek(0));
+    QCOMPARE(file.write(bytes), bytes.size());
+    file.close();
+
+    QVERIFY_EXCEPTION_THROWN(IO::AlzbFileIO().fromFile(path), IO::FileException);
+}
+
+void AlzbFileIOTest::testDenseIndices()
+{
+    const auto outData = createTestData();
+    outData->graph().deleteNode(0);
+
+    // The remaining nodes 1 and 2 are saved as 0 and 1
+    const auto inData = roundTrip(outData);
+    QVERIFY(inData);
+    QCOMPARE(inData->graph().nodeCount(), size_t { 2 });
+    QCOMPARE(inData->graph().getNode(0)->uuid(), outData->graph().getNode(1)->uuid());
+    QVERIFY(inData->graph().getNode(0)->collapsed());
+    QCOMPARE(inData->graph().edgeCount(), size_t { 1 });
+    const auto inEdge = inData->graph().getEdge(0, 1);
+    QVERIFY(inEdge);
+    QVERIFY(inEdge->reversed());
+}
+
+void AlzbFileIOTest::testEmptyDesign()
+{
+    const auto inData = roundTrip(std::make_shared<MindMapData>());
+    QVERIFY(inData);
+    QCOMPARE(inData->applicationVersion(), Constants::Application::applicationVersion());
+    QCOMPARE(inData->alzFormatVersion(), Constants::Application::alzFormatVersion());
+    QCOMPARE(inData->graph().nodeCount(), size_t { 0 });
+}
+
+void AlzbFileIOTest::testGraph()
+{
+    const auto outData = createTestData();
+    const auto inData = roundTrip(outData);
+    QVERIFY(inData);
+    QCOMPARE(inData->graph().nodeCount(), outData->graph().nodeCount());
+    QCOMPARE(inData->graph().edgeCount(), outData->graph().edgeCount());
+
+    for (auto && outNode : outData->graph().nodes()) {
+        const auto inNode = inData->graph().getNode(outNode->index());
+        QVERIFY(inNode);
+        QCOMPARE(inNode->location(), outNode->location());
+        QCOMPARE(inNode->size(), outNode->size());
+        QCOMPARE(inNode->text(), outNode->text());
+        QCOMPARE(inNode->color(), outNode->color());
+        QCOMPARE(inNode->textColor(), outNode->textColor());
+        QCOMPARE(inNode->collapsed(), outNode->collapsed());
+        QCOMPARE(inNode->uuid(), outNode->uuid());
+    }
+
+    outData->graph().forEachEdge([&inData](auto && outEdge) {
+        const auto inEdge = inData->graph().getEdge(outEdge->sourceNode().index(), outEdge->targetNode().index());
+        QVERIFY(inEdge);
+        QCOMPARE(inEdge->text(), outEdge->text());
+        QCOMPARE(inEdge->arrowMode(), outEdge->arrowMode());
+        QCOMPARE(inEdge->dashedLine(), outEdge->dashedLine());
+        QCOMPARE(inEdge->reversed(), outEdge->reversed());
+    });
+}
+
+void AlzbFileIOTest::testHeader()
+{
+    QTemporaryDir dir;
+    const auto path = dir.filePath("test.alzb");
+    QVERIFY(IO::AlzbFileIO().toFile(createTestData(), path, false));
+
+    // Only the start of the file is needed
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.resize(file.size() - 8));
+    file.close();
+    QVERIFY_EXCEPTION_THROWN(IO::AlzbFileIO().fromFile(path), IO::FileException);
+
+    const auto header = IO::readHeader(path);
+    QVERIFY(header);
+    QCOMPARE(header->applicationVersion, Constants::Application::applicationVersion());
+    QCOMPARE(header->nodeCount, size_t { 3 });
+    QCOMPARE(header->edgeCount, size_t { 2 });
+    QVERIFY(header->bounds.contains(QPointF { 1.25, -2.5 }));
+    QVERIFY(!header->thumbnailImage().isNull());
+}
+
+void AlzbFileIOTest::testSections()
+{
+    const auto outData = createTestData();
+    QImage qImage(4, 2, QImage::Format_ARGB32);
+    qImage.fill(Qt::red);
+    outData->graph().getNode(0)->setImageRef(outData->imageManager().addImage(Image(qImage, "red.png")));
+
+    QTemporaryDir dir;
+    const auto path = dir.filePath("test.alzb");
+    QVERIFY(IO::AlzbFileIO().toFile(outData, path, false));
+
+    const auto sections = IO::AlzbFileIOWorker::readSections(path);
+    QStringList names;
+    qint64 totalSize = 0;
+    for (auto && section : sections) {
+        names << section.name;
+        totalSize += section.size;
+    }
+    QCOMPARE(names, QStringList({ "header", "strings", "style", "nodes", "edges", "imageIndex", "images" }));
+    QCOMPARE(sections.at(3).count, size_t { 3 });
+    QCOMPARE(sections.at(4).count, size_t { 2 });
+    QCOMPARE(sections.at(6).count, size_t { 1 });
+
+    // The sections cover the whole file
+    QCOMPARE(totalSize, QFileInfo(path).size());
+}
+
+void AlzbFileIOTest::testImages()
+{
+    const auto outData = createTestData();
+    QImage qImage(4, 2, QImage::Format_ARGB32);
+    qImage.fill(Qt::red);
+    const auto imageRef = outData->imageManager().addImage(Image(qImage, "red.png"));
+    outData->graph().getNode(0)->setImageRef(imageRef);
+    outData->graph().getNode(1)->setImageRef(imageRef);
+    // Not used by any node, so it's not stored
+    outData->imageManager().addImage(Image(qImage, "unused.png"));
+
+    const auto inData = roundTrip(outData);
+    QVERIFY(inData);
+    QCOMPARE(inData->imageManager().images().size(), size_t { 1 });
+    const auto image = inData->imageManager().getImage(imageRef);
+    QVERIFY(image);
+    QCOMPARE(image->path(), std::string("red.png"));
+    QCOMPARE(image->data(), outData->imageManager().getImage(imageRef)->data());
+    QCOMPARE(image->image().size(), qImage.size());
+    QCOMPARE(inData->graph().getNode(1)->imageRef(), imageRef);
+}
+
+void AlzbFileIOTest::testMatchesXml()
+{
+    const auto outData = createTestData();
+    outData->setAspectRatio(1.5);
+    outData->setMinEdgeLength(150);
+
+    const MindMapDataS inData = roundTrip(outData);
+    QVERIFY(inData);
+    QCOMPARE(IO::AlzFileIO().toXml(inData), IO::AlzFileIO().toXml(outData));
+}
+
+void AlzbFileIOTest::testMatchesXml_LargeGraph()
+{
+    // Large enough that the records get written in several chunks
+    const auto outData = std::make_shared<MindMapData>();
+    NodeS previous;
+    for (int i = 0; i < 25000; i++) {
+        const auto node = std::make_shared<Node>();
+        node->setText(QString::number(i % 100));
+        node->setLocation({ static_cast<double>(i), static_cast<double>(-i) });
+        outData->graph().addNode(node);
+        if (previous) {
+            outData->graph().addEdge(std::make_shared<Edge>(previous, node));
+        }
+        previous = node;
+    }
+
+    const MindMapDataS inData = roundTrip(outData);
+    QVERIFY(inData);
+    QCOMPARE(inData->graph().nodeCount(), outData->graph().nodeCount());
+    QCOMPARE(IO::AlzFileIO().toXml(inData), IO::AlzFileIO().toXml(outData));
+}
+
+void AlzbFileIOTest::testStyle()
+{
+    const auto outData = std::make_shared<MindMapData>();
+    outData->setArrowSize(12.5);
+    outData->setBackgroundColor({ 1, 2, 3 });
+    outData->setCornerRadius(8);
+    outData->setEdgeColor({ 4, 5, 6 });
+    outData->setEdgeWidth(2.25);
+    outData->setGridColor({ 7, 8, 9 });
+    outData->setTextSize(14);
+    QFont font;
+    font.setFamily("Foo");
+    font.setItalic(true);
+    font.setUnderline(true);
+    font.setWeight(QFont::Bold);
+    outData->changeFont(font);
+    outData->setAspectRatio(1.25);
+    outData->setMinEdgeLength(123.5);
+
+    const auto inData = roundTrip(outData);
+    QVERIFY(inData);
+    QCOMPARE(inData->arrowSize(), outData->arrowSize());
+    QCOMPARE(inData->backgroundColor(), outData->backgroundColor());
+    QCOMPARE(inData->cornerRadius(), outData->cornerRadius());
+    QCOMPARE(inData->edgeColor(), outData->edgeColor());
+    QCOMPARE(inData->edgeWidth(), outData->edgeWidth());
+    QCOMPARE(inData->gridColor(), outData->gridColor());
+    QCOMPARE(inData->textSize(), outData->textSize());
+    QCOMPARE(inData->font().family(), outData->font().family());
+    QCOMPARE(inData->font().italic(), outData->font().italic());
+    QCOMPARE(inData->font().underline(), outData->font().underline());
+    QCOMPARE(inData->font().weight(), outData->font().weight());
+    QCOMPARE(inData->aspectRatio(), outData->aspectRatio());
+    QCOMPARE(inData->minEdgeLength(), outData->minEdgeLength());
+}
+
+AlzbFileIOTest::~AlzbFileIOTest() = default;
+
+QTEST_GUILESS_MAIN(AlzbFileIOTest)
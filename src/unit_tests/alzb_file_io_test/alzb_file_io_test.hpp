@@ -0,0 +1,59 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ALZB_FILE_IO_TEST_HPP
+#define ALZB_FILE_IO_TEST_HPP
+
+#include <QTest>
+
+#include "../unit_test_base.hpp"
+
+class AlzbFileIOTest : public UnitTestBase
+{
+    Q_OBJECT
+
+public:
+    AlzbFileIOTest();
+
+    ~AlzbFileIOTest() override;
+
+private slots:
+
+    void testCorruptedEdgeIndex();
+
+    void testCorruptedFile();
+
+    void testCorruptedNodeCount();
+
+    void testDenseIndices();
+
+    void testEmptyDesign();
+
+    void testGraph();
+
+    void testHeader();
+
+    void testImages();
+
+    void testMatchesXml();
+
+    void testMatchesXml_LargeGraph();
+
+    void testSections();
+
+    void testStyle();
+};
+
+#endif // ALZB_FILE_IO_TEST_HPP
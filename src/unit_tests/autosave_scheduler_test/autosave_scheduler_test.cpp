@@ -0,0 +1,139 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "autosave_scheduler_test.hpp"
+
+#include "../../application/autosave_scheduler.hpp"
+#include "../../common/test_mode.hpp"
+#include "../../domain/mind_map_data.hpp"
+
+#include <QSignalSpy>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+AutosaveSchedulerTest::AutosaveSchedulerTest()
+{
+    TestMode::setEnabled(true);
+}
+
+void AutosaveSchedulerTest::testBurstIsCoalesced()
+{
+    std::atomic<int> saveCount { 0 };
+    const auto save = [&](MindMapDataS, QString) {
+        saveCount++;
+        return true;
+    };
+    AutosaveScheduler dut(save, std::chrono::milliseconds { 10 });
+    QSignalSpy finishedSpy(&dut, &AutosaveScheduler::saveFinished);
+
+    const auto mindMapData = std::make_shared<MindMapData>();
+    dut.schedule([mindMapData] { return mindMapData; }, "a.alz");
+    dut.schedule([mindMapData] { return mindMapData; }, "a.alz");
+    dut.schedule([mindMapData] { return mindMapData; }, "a.alz");
+    QCOMPARE(dut.queueDepth(), size_t(1));
+
+    QTRY_COMPARE(finishedSpy.count(), 1);
+    QCOMPARE(saveCount.load(), 1);
+    QCOMPARE(dut.coalescedCount(), size_t(2));
+    QCOMPARE(dut.queueDepth(), size_t(0));
+    QCOMPARE(mindMapData.use_count(), 1L);
+}
+
+void AutosaveSchedulerTest::testCancel()
+{
+    std::atomic<int> saveCount { 0 };
+    const auto save = [&](MindMapDataS, QString) {
+        saveCount++;
+        return true;
+    };
+    AutosaveScheduler dut(save, std::chrono::milliseconds { 10 });
+
+    dut.schedule([] { return std::make_shared<MindMapData>(); }, "a.alz");
+    dut.cancel();
+    QCOMPARE(dut.queueDepth(), size_t(0));
+
+    QTest::qWait(50);
+    QCOMPARE(saveCount.load(), 0);
+}
+
+void AutosaveSchedulerTest::testRequestDuringSaveIsQueued()
+{
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool released = false;
+    std::atomic<int> saveCount { 0 };
+    const auto save = [&](MindMapDataS, QString) {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&] { return released; });
+        saveCount++;
+        return true;
+    };
+    AutosaveScheduler dut(save, std::chrono::milliseconds { 10 });
+    QSignalSpy finishedSpy(&dut, &AutosaveScheduler::saveFinished);
+
+    dut.schedule([] { return std::make_shared<MindMapData>(); }, "a.alz");
+    QTest::qWait(50);
+    QCOMPARE(dut.queueDepth(), size_t(1));
+
+    // The first save is now blocked, so these get coalesced into a single pending save
+    dut.schedule([] { return std::make_shared<MindMapData>(); }, "a.alz");
+    dut.schedule([] { return std::make_shared<MindMapData>(); }, "a.alz");
+    QCOMPARE(dut.queueDepth(), size_t(2));
+
+    {
+        const std::lock_guard<std::mutex> lock(mutex);
+        released = true;
+    }
+    condition.notify_all();
+
+    QTRY_COMPARE(finishedSpy.count(), 2);
+    QCOMPARE(saveCount.load(), 2);
+    QCOMPARE(dut.queueDepth(), size_t(0));
+}
+
+void AutosaveSchedulerTest::testSnapshotIsTakenWhenSaveStarts()
+{
+    std::atomic<int> saveCount { 0 };
+    const auto save = [&](MindMapDataS, QString) {
+        saveCount++;
+        return true;
+    };
+    AutosaveScheduler dut(save, std::chrono::milliseconds { 10 });
+    QSignalSpy finishedSpy(&dut, &AutosaveScheduler::saveFinished);
+
+    int snapshotCount = 0;
+    const auto takeSnapshot = [&] {
+        snapshotCount++;
+        return std::make_shared<MindMapData>();
+    };
+    dut.schedule(takeSnapshot, "a.alz");
+    dut.schedule(takeSnapshot, "a.alz");
+    QCOMPARE(snapshotCount, 0);
+
+    QTRY_COMPARE(finishedSpy.count(), 1);
+    QCOMPARE(snapshotCount, 1);
+    QCOMPARE(saveCount.load(), 1);
+
+    // Nothing is saved if there's nothing to snapshot
+    dut.schedule([] { return MindMapDataS {}; }, "a.alz");
+    QTRY_COMPARE(dut.queueDepth(), size_t(0));
+    QTest::qWait(50);
+    QCOMPARE(saveCount.load(), 1);
+}
+
+QTEST_GUILESS_MAIN(AutosaveSchedulerTest)
@@ -0,0 +1,142 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "batched_graph_renderer_test.hpp"
+
+#include "../../common/test_mode.hpp"
+#include "../../domain/graph.hpp"
+#include "../../domain/mind_map_data.hpp"
+#include "../../view/batched_graph_renderer.hpp"
+#include "../../view/scene_items/edge.hpp"
+#include "../../view/scene_items/node.hpp"
+
+#include <memory>
+
+using SceneItems::Edge;
+using SceneItems::Node;
+
+namespace {
+size_t batchedNodeCount(BatchedGraphRenderer & renderer)
+{
+    size_t count = 0;
+    for (auto && batch : renderer.nodeBatches()) {
+        count += static_cast<size_t>(batch.rects.size());
+    }
+    return count;
+}
+} // namespace
+
+BatchedGraphRendererTest::BatchedGraphRendererTest()
+{
+    TestMode::setEnabled(true);
+}
+
+void BatchedGraphRendererTest::testBatches_shouldGroupNodesByColor()
+{
+    const auto mindMapData = std::make_shared<MindMapData>();
+    for (auto && color : { Qt::red, Qt::green, Qt::red }) {
+        const auto node = std::make_shared<Node>();
+        node->setColor(color);
+        mindMapData->graph().addNode(node);
+    }
+
+    BatchedGraphRenderer dut;
+    dut.setMindMapData(mindMapData);
+
+    QCOMPARE(dut.nodeBatches().size(), size_t { 2 });
+    QCOMPARE(dut.nodeBatches().at(0).color, QColor { Qt::red });
+    QCOMPARE(dut.nodeBatches().at(0).rects.size(), 2);
+    QCOMPARE(dut.nodeBatches().at(1).color, QColor { Qt::green });
+    QCOMPARE(dut.nodeBatches().at(1).rects.size(), 1);
+}
+
+void BatchedGraphRendererTest::testChanges_shouldUpdateBatches()
+{
+    const auto mindMapData = std::make_shared<MindMapData>();
+    auto && graph = mindMapData->graph();
+    const auto node0 = std::make_shared<Node>();
+    graph.addNode(node0);
+
+    BatchedGraphRenderer dut;
+    dut.setMindMapData(mindMapData);
+    QCOMPARE(batchedNodeCount(dut), size_t { 1 });
+    QVERIFY(dut.edgeLines().isEmpty());
+
+    const auto node1 = std::make_shared<Node>();
+    graph.addNode(node1);
+    node1->setLocation({ 500, 0 });
+    graph.addEdge(std::make_shared<Edge>(node0, node1));
+    QCOMPARE(batchedNodeCount(dut), size_t { 2 });
+    QCOMPARE(dut.edgeLines().size(), 1);
+    QCOMPARE(dut.edgeLines().at(0), (QLineF { node0->location(), { 500, 0 } }));
+
+    node1->setColor(Qt::blue);
+    QCOMPARE(dut.nodeBatches().size(), size_t { 2 });
+
+    graph.deleteNode(node1->index());
+    QCOMPARE(batchedNodeCount(dut), size_t { 1 });
+    QVERIFY(dut.edgeLines().isEmpty());
+}
+
+void BatchedGraphRendererTest::testCollapsedNode_shouldHideDescendants()
+{
+    const auto mindMapData = std::make_shared<MindMapData>();
+    auto && graph = mindMapData->graph();
+    const auto root = std::make_shared<Node>();
+    graph.addNode(root);
+    const auto child = std::make_shared<Node>();
+    graph.addNode(child);
+    graph.addEdge(std::make_shared<Edge>(root, child));
+
+    BatchedGraphRenderer dut;
+    dut.setMindMapData(mindMapData);
+    QCOMPARE(batchedNodeCount(dut), size_t { 2 });
+
+    root->setCollapsed(true);
+    QCOMPARE(batchedNodeCount(dut), size_t { 1 });
+    QVERIFY(dut.edgeLines().isEmpty());
+
+    root->setCollapsed(false);
+    QCOMPARE(batchedNodeCount(dut), size_t { 2 });
+    QCOMPARE(dut.edgeLines().size(), 1);
+}
+
+void BatchedGraphRendererTest::testSetMindMapData_shouldFollowNewGraph()
+{
+    auto oldMindMapData = std::make_shared<MindMapData>();
+    oldMindMapData->graph().addNode(std::make_shared<Node>());
+
+    BatchedGraphRenderer dut;
+    dut.setMindMapData(oldMindMapData);
+    QCOMPARE(batchedNodeCount(dut), size_t { 1 });
+
+    const auto newMindMapData = std::make_shared<MindMapData>();
+    dut.setMindMapData(newMindMapData);
+    QVERIFY(dut.nodeBatches().empty());
+
+    // No longer followed
+    oldMindMapData->graph().addNode(std::make_shared<Node>());
+    QVERIFY(dut.nodeBatches().empty());
+
+    newMindMapData->graph().addNode(std::make_shared<Node>());
+    QCOMPARE(batchedNodeCount(dut), size_t { 1 });
+
+    // A destroyed mind map is not followed either
+    oldMindMapData.reset();
+    dut.setMindMapData(newMindMapData);
+    QCOMPARE(batchedNodeCount(dut), size_t { 1 });
+}
+
+QTEST_GUILESS_MAIN(BatchedGraphRendererTest)
@@ -0,0 +1,110 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "cache_registry_test.hpp"
+
+#include "../../application/cache_registry.hpp"
+
+#include <vector>
+
+namespace {
+//! A fake cache of the given bytes that records the requested budgets.
+struct FakeCache
+{
+    size_t bytes = 0;
+
+    std::vector<size_t> budgets;
+
+    CacheRegistry::Cache cache(QString name, size_t backgroundBudget)
+    {
+        return { name, backgroundBudget, [this](size_t budget) {
+                    budgets.push_back(budget);
+                    const auto reclaimed = bytes > budget ? bytes - budget : 0;
+                    bytes -= reclaimed;
+                    return reclaimed;
+                },
+                 [this] { return MemoryUsage { 1, bytes }; } };
+    }
+};
+} // namespace
+
+void CacheRegistryTest::testMemoryReport_shouldListReportingCaches()
+{
+    CacheRegistry registry;
+    FakeCache reporting { 100, {} };
+    registry.add(reporting.cache("Reporting", 0));
+    registry.add({ "Silent", 0, [](size_t) { return size_t { 0 }; }, {} });
+
+    const auto report = registry.memoryReport();
+    QCOMPARE(report.entries.size(), size_t { 1 });
+    QCOMPARE(report.entries.at(0).first, QString { "Reporting" });
+    QCOMPARE(report.entries.at(0).second.bytes, size_t { 100 });
+    QCOMPARE(report.reclaimed.itemCount, size_t { 0 });
+}
+
+void CacheRegistryTest::testRemove_shouldNotTrimRemovedCache()
+{
+    CacheRegistry registry;
+    FakeCache fake { 100, {} };
+    registry.remove(registry.add(fake.cache("Fake", 0)));
+
+    QCOMPARE(registry.trim(CacheRegistry::TrimReason::MemoryPressure), size_t { 0 });
+    QVERIFY(fake.budgets.empty());
+    QVERIFY(registry.memoryReport().entries.empty());
+}
+
+void CacheRegistryTest::testTrim_shouldAccumulateReclaimedBytes()
+{
+    CacheRegistry registry;
+    FakeCache fake { 100, {} };
+    registry.add(fake.cache("Fake", 60));
+
+    registry.trim(CacheRegistry::TrimReason::Background);
+    registry.trim(CacheRegistry::TrimReason::MemoryPressure);
+
+    const auto reclaimed = registry.memoryReport().reclaimed;
+    QCOMPARE(reclaimed.itemCount, size_t { 2 });
+    QCOMPARE(reclaimed.bytes, size_t { 100 });
+}
+
+void CacheRegistryTest::testTrim_shouldEmptyCachesOnMemoryPressure()
+{
+    CacheRegistry registry;
+    FakeCache first { 100, {} };
+    FakeCache second { 50, {} };
+    registry.add(first.cache("First", 80));
+    registry.add(second.cache("Second", 10));
+
+    QCOMPARE(registry.trim(CacheRegistry::TrimReason::MemoryPressure), size_t { 150 });
+    QCOMPARE(first.budgets, std::vector<size_t> { 0 });
+    QCOMPARE(second.budgets, std::vector<size_t> { 0 });
+}
+
+void CacheRegistryTest::testTrim_shouldTrimToBackgroundBudgets()
+{
+    CacheRegistry registry;
+    FakeCache overBudget { 100, {} };
+    FakeCache underBudget { 5, {} };
+    registry.add(overBudget.cache("Over", 80));
+    registry.add(underBudget.cache("Under", 10));
+
+    QCOMPARE(registry.trim(CacheRegistry::TrimReason::Background), size_t { 20 });
+    QCOMPARE(overBudget.bytes, size_t { 80 });
+    QCOMPARE(underBudget.bytes, size_t { 5 });
+    QCOMPARE(overBudget.budgets, std::vector<size_t> { 80 });
+    QCOMPARE(underBudget.budgets, std::vector<size_t> { 10 });
+}
+
+QTEST_GUILESS_MAIN(CacheRegistryTest)
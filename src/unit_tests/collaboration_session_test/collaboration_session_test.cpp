@@ -0,0 +1,216 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "collaboration_session_test.hpp"
+
+#include "../../application/collaboration_session.hpp"
+#include "../../application/editor_service.hpp"
+#include "../../common/test_mode.hpp"
+#include "../../domain/graph.hpp"
+#include "../../domain/image_manager.hpp"
+#include "../../domain/mind_map_data.hpp"
+#include "../../infra/io/edit_operation.hpp"
+
+#include <QDataStream>
+#include <QSignalSpy>
+#include <QTcpSocket>
+#include <QtEndian>
+
+#include <memory>
+
+using SceneItems::Edge;
+using SceneItems::Node;
+
+namespace {
+
+//! An editor that applies the edits of the session like ApplicationService does.
+struct Instance
+{
+    Instance()
+    {
+        editorService.setMindMapData(std::make_shared<MindMapData>());
+        session.setMindMapData(editorService.mindMapData());
+        QObject::connect(&session, &CollaborationSession::operationReceived, &session, [this](const IO::EditOperation & operation) {
+            editorService.applyEditOperation(operation);
+        });
+        QObject::connect(&editorService, &EditorService::mindMapDataReplaced, &session, [this] {
+            session.setMindMapData(editorService.mindMapData());
+        });
+    }
+
+    GraphR graph()
+    {
+        return editorService.mindMapData()->graph();
+    }
+
+    EditorService editorService;
+
+    CollaborationSession session;
+};
+
+} // namespace
+
+CollaborationSessionTest::CollaborationSessionTest()
+{
+    TestMode::setEnabled(true);
+}
+
+void CollaborationSessionTest::testEditOperationRoundTrip()
+{
+    MindMapData mindMapData;
+    mindMapData.setEdgeWidth(3.5);
+    const auto imageId = mindMapData.imageManager().addImage({ QImage {}, "foo.png", "imagedata" });
+    const auto node0 = std::make_shared<Node>();
+    node0->setText("Foo");
+    node0->setImageRef(imageId);
+    mindMapData.graph().addNode(node0);
+    const auto node1 = std::make_shared<Node>();
+    mindMapData.graph().addNode(node1);
+    mindMapData.graph().addEdge(std::make_shared<Edge>(node0, node1));
+
+    const auto operation = IO::EditOperation::decode(IO::EditOperation::reset(mindMapData).encode());
+    QVERIFY(operation.has_value());
+    QVERIFY(operation->isReset);
+    QCOMPARE(operation->delta.addedNodes.size(), static_cast<size_t>(2));
+    QCOMPARE(operation->delta.addedEdges.size(), static_cast<size_t>(1));
+    QCOMPARE(operation->styleData, mindMapData.styleData());
+    QCOMPARE(operation->images.size(), static_cast<size_t>(1));
+    QCOMPARE(operation->images.at(0).id(), imageId);
+    QCOMPARE(operation->images.at(0).data(), QByteArray { "imagedata" });
+
+    QVERIFY(!IO::EditOperation::decode("garbage").has_value());
+}
+
+void CollaborationSessionTest::testEditOperationDecode_InvalidData()
+{
+    IO::EditOperation operation;
+    operation.delta.addedNodes.push_back({ {}, {} });
+    operation.delta.addedNodes.back().index = 0;
+    QVERIFY(IO::EditOperation::decode(operation.encode()).has_value());
+
+    auto negativeIndex = operation;
+    negativeIndex.delta.addedNodes.back().index = -5;
+    QVERIFY(!IO::EditOperation::decode(negativeIndex.encode()).has_value());
+
+    auto invalidArrowMode = operation;
+    invalidArrowMode.delta.addedEdges.push_back({ { false, SceneItems::EdgeModel::Style { static_cast<SceneItems::EdgeModel::ArrowMode>(42) } }, 0, 0 });
+    QVERIFY(!IO::EditOperation::decode(invalidArrowMode.encode()).has_value());
+
+    // The size header of qCompress() is big-endian
+    const auto setSizeHeader = [](QByteArray data, quint32 size) {
+        qToBigEndian(size, reinterpret_cast<uchar *>(data.data()));
+        return data;
+    };
+    const auto data = operation.encode();
+    QVERIFY(IO::EditOperation::decode(setSizeHeader(data, qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(data.constData())))).has_value());
+    QVERIFY(!IO::EditOperation::decode(setSizeHeader(data, 0xffffffff)).has_value());
+    QVERIFY(!IO::EditOperation::decode(setSizeHeader(data, 1)).has_value());
+    QVERIFY(!IO::EditOperation::decode(setSizeHeader(data, 100000)).has_value());
+}
+
+void CollaborationSessionTest::testJoinedPeerGetsMindMapOfHost()
+{
+    Instance host;
+    host.editorService.addNodeAt({ 10, 20 })->setText("Foo");
+    host.editorService.mindMapData()->setEdgeWidth(3.5);
+    QVERIFY(host.session.host(0));
+
+    Instance peer;
+    peer.editorService.addNodeAt({ 0, 0 });
+    peer.editorService.addNodeAt({ 0, 0 });
+    peer.session.join("127.0.0.1", host.session.port(), host.session.secret());
+
+    QTRY_COMPARE(peer.graph().nodeCount(), static_cast<size_t>(1));
+    QCOMPARE(peer.graph().nodes().at(0)->text(), QString { "Foo" });
+    QCOMPARE(peer.graph().nodes().at(0)->location(), QPointF(10, 20));
+    QCOMPARE(peer.editorService.mindMapData()->edgeWidth(), 3.5);
+    QCOMPARE(host.session.peerCount(), static_cast<size_t>(1));
+
+    // The shared mind map is not the file of the peer
+    QVERIFY(peer.editorService.fileName().isEmpty());
+}
+
+void CollaborationSessionTest::testEditsAreStreamedBothWays()
+{
+    Instance host;
+    const auto node0 = host.editorService.addNodeAt({ 0, 0 });
+    QVERIFY(host.session.host(0));
+
+    Instance peer;
+    peer.session.join("127.0.0.1", host.session.port(), host.session.secret());
+    QTRY_COMPARE(peer.graph().nodeCount(), static_cast<size_t>(1));
+
+    node0->setText("Bar");
+    node0->setLocation({ 100, 0 });
+    QTRY_COMPARE(peer.graph().getNode(node0->index())->text(), QString { "Bar" });
+    QCOMPARE(peer.graph().getNode(node0->index())->location(), QPointF(100, 0));
+
+    const auto node1 = peer.editorService.addNodeAt({ 0, 100 });
+    peer.editorService.addEdge(std::make_shared<Edge>(peer.graph().getNode(node0->index()), node1));
+    QTRY_COMPARE(host.graph().edgeCount(), static_cast<size_t>(1));
+    QVERIFY(host.graph().areDirectlyConnected(node0->index(), node1->index()));
+
+    // The style changes replace the mind map data, which the sessions follow
+    host.editorService.mindMapData()->setEdgeWidth(4.5);
+    QTRY_COMPARE(peer.editorService.mindMapData()->edgeWidth(), 4.5);
+    QCOMPARE(peer.graph().edgeCount(), static_cast<size_t>(1));
+
+    peer.editorService.deleteNode(*peer.graph().getNode(node0->index()));
+    QTRY_COMPARE(host.graph().nodeCount(), static_cast<size_t>(1));
+    QCOMPARE(host.graph().edgeCount(), static_cast<size_t>(0));
+
+    // The edits of the peer are relayed back to it in the order of the host, so both end up the same
+    QTRY_COMPARE(peer.graph().nodeCount(), static_cast<size_t>(1));
+    QCOMPARE(peer.graph().nodes().at(0)->location(), host.graph().nodes().at(0)->location());
+}
+
+void CollaborationSessionTest::testPeerWithWrongSecretIsRejected()
+{
+    Instance host;
+    host.editorService.addNodeAt({ 0, 0 });
+    QVERIFY(host.session.host(0, "secret"));
+    QCOMPARE(host.session.secret(), QString { "secret" });
+
+    Instance peer;
+    peer.editorService.addNodeAt({ 0, 0 });
+    peer.editorService.addNodeAt({ 0, 0 });
+    QSignalSpy endedSpy { &peer.session, &CollaborationSession::ended };
+    peer.session.join("127.0.0.1", host.session.port(), "wrong");
+
+    QTRY_COMPARE(endedSpy.count(), 1);
+    QCOMPARE(peer.graph().nodeCount(), static_cast<size_t>(2));
+    QCOMPARE(host.session.peerCount(), static_cast<size_t>(0));
+}
+
+void CollaborationSessionTest::testOversizedFrameIsRejected()
+{
+    Instance host;
+    QVERIFY(host.session.host(0));
+
+    QTcpSocket socket;
+    socket.connectToHost("127.0.0.1", host.session.port());
+    QVERIFY(socket.waitForConnected(5000));
+
+    // A response frame that claims to be larger than any handshake frame
+    QByteArray header;
+    QDataStream out { &header, QIODevice::WriteOnly };
+    out << static_cast<quint8>(1) << static_cast<quint32>(0x7fffffff);
+    socket.write(header);
+
+    QTRY_COMPARE(socket.state(), QAbstractSocket::UnconnectedState);
+    QCOMPARE(host.session.peerCount(), static_cast<size_t>(0));
+}
+
+QTEST_GUILESS_MAIN(CollaborationSessionTest)
@@ -0,0 +1,89 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "compact_text_test.hpp"
+
+#include "../../common/compact_text.hpp"
+#include "../../domain/graph_snapshot.hpp"
+
+#include <QDataStream>
+
+void CompactTextTest::testConversion()
+{
+    const QString string { "Mind map äö €\nSecond line" };
+    const CompactText text { string };
+    QCOMPARE(text.toString(), string);
+    QCOMPARE(QString { text }, string);
+    QVERIFY(text == string);
+    QVERIFY(string == text);
+    QVERIFY(text != QString { "Other" });
+    QVERIFY(text.contains("ÄÖ", Qt::CaseInsensitive));
+    QCOMPARE(text.utf8().size(), static_cast<size_t>(string.toUtf8().size()));
+
+    QVERIFY(CompactText {}.isEmpty());
+    QVERIFY(CompactText { QString {} }.isEmpty());
+    QVERIFY(CompactText { "" } == CompactText {});
+    QCOMPARE(CompactText {}.toString(), QString {});
+}
+
+void CompactTextTest::testEqualTexts_shouldBePooledOnce()
+{
+    const auto pooledCount = CompactText::pooledCount();
+    {
+        const CompactText text0 { QString { "Pooled" } };
+        const CompactText text1 { QString { "Pooled" } };
+        const CompactText text2 { QString { "Other" } };
+        QVERIFY(text0 == text1);
+        QVERIFY(text0 != text2);
+        QVERIFY(text0.utf8().data() == text1.utf8().data());
+        QCOMPARE(qHash(text0), qHash(text1));
+        QCOMPARE(CompactText::pooledCount(), pooledCount + 2);
+    }
+    QCOMPARE(CompactText::pooledCount(), pooledCount);
+}
+
+void CompactTextTest::testModelCopies_shouldShareText()
+{
+    SceneItems::NodeModel node { Qt::white, Qt::black };
+    node.text = QString { "Shared" };
+    GraphSnapshot::NodeDataVector nodes(100, node);
+
+    // E.g. a snapshot read back from the undo journal
+    QByteArray data;
+    QDataStream out { &data, QIODevice::WriteOnly };
+    out << node.text;
+    QDataStream in { data };
+    SceneItems::NodeModel readNode { Qt::white, Qt::black };
+    in >> readNode.text;
+
+    QVERIFY(readNode.text == node.text);
+    QVERIFY(readNode.text.utf8().data() == nodes.back().text.utf8().data());
+}
+
+void CompactTextTest::testStreaming()
+{
+    const CompactText text { QString { "Streamed" } };
+
+    // Streamed like QString for the compatibility of the existing data
+    QByteArray data;
+    QDataStream out { &data, QIODevice::WriteOnly };
+    out << text;
+    QDataStream in { data };
+    QString string;
+    in >> string;
+    QCOMPARE(string, text.toString());
+}
+
+QTEST_GUILESS_MAIN(CompactTextTest)
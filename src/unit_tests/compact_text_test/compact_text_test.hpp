@@ -1,5 +1,5 @@
 // This file is part of Heimer.
-// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
 //
 // Heimer is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -13,24 +13,26 @@
 // You should have received a copy of the GNU General Public License
 // along with Heimer. If not, see <http://www.gnu.org/licenses/>.
 
-#include "xml_writer.hpp"
+#ifndef COMPACT_TEXT_TEST_HPP
+#define COMPACT_TEXT_TEST_HPP
 
-#include <QFile>
-#include <QTextStream>
+#include <QTest>
 
-namespace IO {
+#include "../unit_test_base.hpp"
 
-bool XmlWriter::writeToFile(QDomDocument document, QString filePath)
+class CompactTextTest : public UnitTestBase
 {
-    QFile file(filePath);
-    if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QTextStream out(&file);
-        out << document;
-        file.close();
-        return true;
-    }
-
-    return false;
-}
-
-} // namespace IO
+    Q_OBJECT
+
+private slots:
+
+    void testConversion();
+
+    void testEqualTexts_shouldBePooledOnce();
+
+    void testModelCopies_shouldShareText();
+
+    void testStreaming();
+};
+
+#endif // COMPACT_TEXT_TEST_HPP
@@ -0,0 +1,171 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "edge_bundler_test.hpp"
+
+#include "../../common/constants.hpp"
+#include "../../common/test_mode.hpp"
+#include "../../domain/graph.hpp"
+#include "../../domain/mind_map_data.hpp"
+#include "../../view/edge_bundler.hpp"
+#include "../../view/scene_items/edge.hpp"
+#include "../../view/scene_items/node.hpp"
+
+#include <algorithm>
+#include <memory>
+
+using SceneItems::Edge;
+using SceneItems::Node;
+
+namespace {
+//! Adds a hub with the given number of children on the right and given number of children on the left.
+std::vector<EdgeS> addHub(MindMapData & mindMapData, size_t rightCount, size_t leftCount = 0)
+{
+    auto && graph = mindMapData.graph();
+    const auto hub = std::make_shared<Node>();
+    graph.addNode(hub);
+
+    std::vector<EdgeS> edges;
+    for (size_t i = 0; i < rightCount + leftCount; i++) {
+        const auto child = std::make_shared<Node>();
+        graph.addNode(child);
+        const auto row = static_cast<double>(i < rightCount ? i : i - rightCount);
+        child->setLocation({ i < rightCount ? 500.0 : -500.0, row * 20 - 150 });
+        const auto edge = std::make_shared<Edge>(hub, child);
+        graph.addEdge(edge);
+        edge->updateLine();
+        edges.push_back(edge);
+    }
+    return edges;
+}
+
+size_t bundledEdgeCount(const std::vector<EdgeS> & edges)
+{
+    return static_cast<size_t>(std::count_if(edges.begin(), edges.end(), [](auto && edge) {
+        return edge->isBundled();
+    }));
+}
+} // namespace
+
+EdgeBundlerTest::EdgeBundlerTest()
+{
+    TestMode::setEnabled(true);
+}
+
+void EdgeBundlerTest::testDisabled_shouldRouteEdgesStraight()
+{
+    const auto mindMapData = std::make_shared<MindMapData>();
+    const auto edges = addHub(*mindMapData, Constants::Edge::bundlingThreshold());
+
+    EdgeBundler dut;
+    dut.setMindMapData(mindMapData);
+    dut.update();
+    QVERIFY(!dut.hasBundles());
+    QCOMPARE(bundledEdgeCount(edges), size_t { 0 });
+
+    dut.setEnabled(true);
+    dut.update();
+    QCOMPARE(bundledEdgeCount(edges), edges.size());
+
+    dut.setEnabled(false);
+    dut.update();
+    QVERIFY(!dut.hasBundles());
+    QCOMPARE(bundledEdgeCount(edges), size_t { 0 });
+}
+
+void EdgeBundlerTest::testEdgeWithText_shouldNotBeBundled()
+{
+    const auto mindMapData = std::make_shared<MindMapData>();
+    const auto edges = addHub(*mindMapData, Constants::Edge::bundlingThreshold());
+
+    EdgeBundler dut;
+    dut.setMindMapData(mindMapData);
+    dut.setEnabled(true);
+    dut.update();
+    QVERIFY(edges.front()->isBundled());
+
+    // The label is positioned on the straight line
+    edges.front()->setText("Label");
+    dut.update();
+    QVERIFY(!edges.front()->isBundled());
+    QCOMPARE(bundledEdgeCount(edges), edges.size() - 1);
+}
+
+void EdgeBundlerTest::testFewEdges_shouldNotBeBundled()
+{
+    const auto mindMapData = std::make_shared<MindMapData>();
+    const auto edges = addHub(*mindMapData, Constants::Edge::bundlingThreshold() - 1);
+
+    EdgeBundler dut;
+    dut.setMindMapData(mindMapData);
+    dut.setEnabled(true);
+    dut.update();
+    QVERIFY(!dut.hasBundles());
+    QCOMPARE(bundledEdgeCount(edges), size_t { 0 });
+}
+
+void EdgeBundlerTest::testHub_shouldBundleEdgesByDirection()
+{
+    const auto mindMapData = std::make_shared<MindMapData>();
+    const auto rightCount = Constants::Edge::bundlingThreshold();
+    const auto leftCount = size_t { 3 };
+    const auto edges = addHub(*mindMapData, rightCount, leftCount);
+
+    EdgeBundler dut;
+    dut.setMindMapData(mindMapData);
+    dut.setEnabled(true);
+    dut.update();
+
+    const auto bundles = dut.bundles();
+    QCOMPARE(bundles.size(), size_t { 2 });
+    QCOMPARE(bundles.at(0).edgeCount + bundles.at(1).edgeCount, rightCount + leftCount);
+    QCOMPARE(bundledEdgeCount(edges), edges.size());
+
+    // Hit tested along the trunk, which is away from the straight line of the edge
+    const auto & lastRightEdge = edges.at(rightCount - 1);
+    const auto trunkEnd = lastRightEdge->routeSegments().front().p2();
+    QVERIFY(trunkEnd.x() > 0);
+    QVERIFY(lastRightEdge->shape().contains(trunkEnd));
+    QVERIFY(lastRightEdge->boundingRect().contains(trunkEnd));
+}
+
+void EdgeBundlerTest::testTargetMoved_shouldUpdateBundle()
+{
+    const auto mindMapData = std::make_shared<MindMapData>();
+    const auto edges = addHub(*mindMapData, Constants::Edge::bundlingThreshold());
+
+    EdgeBundler dut;
+    dut.setMindMapData(mindMapData);
+    dut.setEnabled(true);
+    dut.update();
+    QCOMPARE(dut.bundles().size(), size_t { 1 });
+
+    // Alone in its direction
+    auto && target = edges.front()->targetNode();
+    target.setLocation({ -500, 0 });
+    edges.front()->updateLine();
+    dut.update();
+    QCOMPARE(dut.bundles().size(), size_t { 1 });
+    QVERIFY(!edges.front()->isBundled());
+    QCOMPARE(bundledEdgeCount(edges), edges.size() - 1);
+
+    target.setLocation({ 500, -150 });
+    edges.front()->updateLine();
+    dut.update();
+    QCOMPARE(dut.bundles().size(), size_t { 1 });
+    QCOMPARE(bundledEdgeCount(edges), edges.size());
+}
+
+QTEST_GUILESS_MAIN(EdgeBundlerTest)
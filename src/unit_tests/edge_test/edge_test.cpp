@@ -0,0 +1,157 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "edge_test.hpp"
+
+#include "../../common/test_mode.hpp"
+#include "../../view/scene_items/edge.hpp"
+#include "../../view/scene_items/edge_text_edit.hpp"
+#include "../../view/scene_items/node.hpp"
+
+#include <QCoreApplication>
+#include <QEvent>
+#include <QPainterPath>
+
+using SceneItems::Edge;
+using SceneItems::EdgeModel;
+using SceneItems::EdgeTextEdit;
+using SceneItems::Node;
+
+namespace {
+
+size_t labelCount(const Edge & edge)
+{
+    // Deleted labels are gone only after the deferred deletes
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+
+    size_t count = 0;
+    for (auto && child : edge.childItems()) {
+        if (qgraphicsitem_cast<EdgeTextEdit *>(child)) {
+            count++;
+        }
+    }
+    return count;
+}
+
+QPainterPath rectPath(const QRectF & rect)
+{
+    QPainterPath path;
+    path.addRect(rect);
+    return path;
+}
+
+} // namespace
+
+EdgeTest::EdgeTest()
+{
+    TestMode::setEnabled(true);
+}
+
+void EdgeTest::testBoundingRect_shouldContainShape()
+{
+    const auto node0 = std::make_shared<Node>();
+    const auto node1 = std::make_shared<Node>();
+    node1->setLocation({ 300, 200 });
+    Edge edge { node0, node1, false, false };
+
+    for (auto && arrowMode : { EdgeModel::ArrowMode::Single, EdgeModel::ArrowMode::Double, EdgeModel::ArrowMode::Hidden }) {
+        for (auto && reversed : { false, true }) {
+            edge.setArrowMode(arrowMode);
+            edge.setReversed(reversed);
+            edge.updateLine();
+            // The stroker approximates the round caps with curves that may bulge a fraction of a pixel
+            QVERIFY(edge.boundingRect().adjusted(-0.1, -0.1, 0.1, 0.1).contains(edge.shape().boundingRect()));
+            QVERIFY(edge.shape().contains(edge.mapFromScene(edge.line().center())));
+        }
+    }
+
+    const auto line = edge.line();
+    edge.setArrowMode(EdgeModel::ArrowMode::Single);
+    edge.setBundleTrunk(QLineF { line.p1(), line.center() + QPointF { 0, 400 } });
+    edge.updateLine();
+    QVERIFY(edge.boundingRect().adjusted(-0.1, -0.1, 0.1, 0.1).contains(edge.shape().boundingRect()));
+    QVERIFY(edge.boundingRect().contains(line.center() + QPointF { 0, 400 }));
+
+    edge.setBundleTrunk({});
+    QVERIFY(!edge.boundingRect().contains(line.center() + QPointF { 0, 400 }));
+}
+
+void EdgeTest::testCollidesWithRect_shouldMatchShape()
+{
+    const auto node0 = std::make_shared<Node>();
+    const auto node1 = std::make_shared<Node>();
+    node1->setLocation({ 500, 300 });
+    Edge edge { node0, node1, false, false };
+    edge.updateLine();
+
+    const auto line = edge.line();
+    const auto step = QPointF { 20, 20 };
+    for (double x = line.x1() - 100; x < line.x2() + 100; x += 37) {
+        for (double y = line.y1() - 100; y < line.y2() + 100; y += 37) {
+            const QRectF rect { QPointF { x, y }, QPointF { x, y } + step };
+            // The stroked shape approximates the round caps, so only rects clearly in or out are compared
+            const auto intersectsShape = edge.shape().intersects(edge.mapFromScene(rectPath(rect)));
+            if (intersectsShape == edge.shape().intersects(edge.mapFromScene(rectPath(rect.adjusted(1, 1, -1, -1))))
+                && intersectsShape == edge.shape().intersects(edge.mapFromScene(rectPath(rect.adjusted(-1, -1, 1, 1))))) {
+                QCOMPARE(edge.collidesWithPath(edge.mapFromScene(rectPath(rect)), Qt::IntersectsItemShape), intersectsShape);
+            }
+        }
+    }
+
+    QVERIFY(edge.collidesWithPath(edge.mapFromScene(rectPath({ line.center() - step, line.center() + step })), Qt::IntersectsItemShape));
+}
+
+void EdgeTest::testCollidesWithRect_shouldTestContainment()
+{
+    const auto node0 = std::make_shared<Node>();
+    const auto node1 = std::make_shared<Node>();
+    node1->setLocation({ 500, 0 });
+    Edge edge { node0, node1, false, false };
+    edge.updateLine();
+
+    const auto lineRect = edge.mapRectToScene(edge.boundingRect());
+    QVERIFY(edge.collidesWithPath(edge.mapFromScene(rectPath(lineRect.adjusted(-50, -50, 50, 50))), Qt::ContainsItemShape));
+    QVERIFY(!edge.collidesWithPath(edge.mapFromScene(rectPath(lineRect.adjusted(50, -50, -50, 50))), Qt::ContainsItemShape));
+    QVERIFY(edge.collidesWithPath(edge.mapFromScene(rectPath(lineRect.adjusted(50, -50, -50, 50))), Qt::IntersectsItemShape));
+}
+
+void EdgeTest::testLabelsAreCreatedOnlyForText()
+{
+    Edge edge { nullptr, nullptr, false, true };
+    edge.setTextSize(42);
+    QCOMPARE(labelCount(edge), size_t(0));
+
+    edge.setText("Foo");
+    QCOMPARE(labelCount(edge), size_t(2));
+    QCOMPARE(edge.text(), QString("Foo"));
+
+    edge.setText("Bar");
+    QCOMPARE(labelCount(edge), size_t(2));
+
+    edge.setText("");
+    QCOMPARE(labelCount(edge), size_t(0));
+    QCOMPARE(edge.text(), QString(""));
+    QCOMPARE(edge.translatedLabelBoundingRect().size(), QSizeF(0, 0));
+}
+
+void EdgeTest::testLabelsAreNotCreatedIfDisabled()
+{
+    Edge edge { nullptr, nullptr, false, false };
+    edge.setText("Foo");
+    QCOMPARE(labelCount(edge), size_t(0));
+    QCOMPARE(edge.text(), QString("Foo"));
+}
+
+QTEST_GUILESS_MAIN(EdgeTest)
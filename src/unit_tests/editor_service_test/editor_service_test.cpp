@@ -18,7 +18,15 @@
 #include "../../application/editor_service.hpp"
 #include "../../common/test_mode.hpp"
 #include "../../domain/graph.hpp"
+#include "../../domain/image_manager.hpp"
 #include "../../domain/mind_map_data.hpp"
+#include "../../domain/undo_stack.hpp"
+#include "../../infra/io/alz_file_io.hpp"
+#include "../../infra/io/undo_journal.hpp"
+
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
 
 using SceneItems::Edge;
 using SceneItems::EdgeModel;
@@ -62,6 +70,47 @@ void EditorServiceTest::testAddAndDeleteEdge()
     node1.reset();
 }
 
+void EditorServiceTest::testCopiedDataSerialization()
+{
+    EditorService source;
+    source.setMindMapData(std::make_shared<MindMapData>());
+
+    const auto node0 = source.addNodeAt(QPointF(1, 2));
+    node0->setText("Foo");
+    const auto imageId = source.mindMapData()->imageManager().addImage({ QImage {}, "foo.png", "imagedata" });
+    node0->setImageRef(imageId);
+    const auto node1 = source.addNodeAt(QPointF(3, 4));
+    source.addEdge(std::make_shared<Edge>(node0, node1));
+
+    source.addNodeToSelectionGroup(*node0);
+    source.addNodeToSelectionGroup(*node1);
+    source.copySelectedNodes();
+
+    EditorService target;
+    target.setMindMapData(std::make_shared<MindMapData>());
+    // Make the image ids differ between the mind maps
+    target.mindMapData()->imageManager().addImage({ QImage {}, "bar.png", "otherdata" });
+
+    QVERIFY(target.deserializeCopiedData(source.serializedCopiedData()));
+
+    const auto & copiedData = target.copiedData();
+    QCOMPARE(copiedData.nodes.size(), size_t(2));
+    QCOMPARE(copiedData.edges.size(), size_t(1));
+    QCOMPARE(copiedData.nodes.at(0).text.toString(), QString("Foo"));
+    QCOMPARE(copiedData.copyReferencePoint, source.copiedData().copyReferencePoint);
+
+    const auto imageMapping = target.addCopiedImages();
+    QCOMPARE(imageMapping.size(), size_t(1));
+    const auto targetImage = target.mindMapData()->imageManager().getImage(imageMapping.at(imageId));
+    QVERIFY(targetImage);
+    QCOMPARE(targetImage->data(), QByteArray("imagedata"));
+
+    // Pasting again reuses the already added image
+    QCOMPARE(target.addCopiedImages().at(imageId), imageMapping.at(imageId));
+
+    QVERIFY(!target.deserializeCopiedData("garbage"));
+}
+
 void EditorServiceTest::testGroupConnection()
 {
     EditorService editorService;
@@ -162,6 +211,20 @@ void EditorServiceTest::testGroupMove()
     QCOMPARE(qFuzzyCompare(node0->location().y(), 1), true);
     QCOMPARE(qFuzzyCompare(node1->location().x(), 2), true);
     QCOMPARE(qFuzzyCompare(node1->location().y(), 2), true);
+
+    // The relative positions are kept for the rest of the drag
+    editorService.moveSelectionGroup(*node0, { 3, 2 });
+
+    QCOMPARE(qFuzzyCompare(node1->location().x(), 4), true);
+    QCOMPARE(qFuzzyCompare(node1->location().y(), 3), true);
+
+    // ...and taken again when the next drag starts
+    node1->setLocation({ 10, 10 });
+    editorService.beginSelectionGroupMove();
+    editorService.moveSelectionGroup(*node0, { 4, 2 });
+
+    QCOMPARE(qFuzzyCompare(node1->location().x(), 11), true);
+    QCOMPARE(qFuzzyCompare(node1->location().y(), 10), true);
 }
 
 void EditorServiceTest::testInitializationResetsFileName()
@@ -319,6 +382,95 @@ void EditorServiceTest::testRedoAddNodes()
     QCOMPARE(editorService.mindMapData()->graph().nodeCount(), static_cast<size_t>(2));
 }
 
+void EditorServiceTest::testReload_shouldUpdateChangedItemsInPlace()
+{
+    QTemporaryDir dir;
+    const auto fileName = dir.filePath("test.alz");
+    IO::AlzFileIO alzFileIO;
+
+    EditorService editorService;
+    editorService.setMindMapData(std::make_shared<MindMapData>());
+    const auto node0 = editorService.addNodeAt(QPointF(0, 0));
+    const auto node1 = editorService.addNodeAt(QPointF(1, 1));
+    editorService.addEdge(std::make_shared<Edge>(node0, node1));
+    QVERIFY(alzFileIO.toFile(editorService.mindMapData(), fileName, false));
+    editorService.loadMindMapData(fileName); // Only takes the file name in test mode
+
+    QCOMPARE(editorService.reloadMindMapData().status, EditorService::ReloadResult::Status::Unchanged);
+
+    const auto changedMindMapData = std::make_shared<MindMapData>(*editorService.mindMapData());
+    changedMindMapData->graph().getNode(node0->index())->setText("Foo");
+    changedMindMapData->graph().deleteNode(node1->index());
+    QVERIFY(alzFileIO.toFile(changedMindMapData, fileName, false));
+
+    editorService.addNodeToSelectionGroup(*node0);
+
+    const auto result = editorService.reloadMindMapData();
+    QCOMPARE(result.status, EditorService::ReloadResult::Status::Reloaded);
+    QCOMPARE(result.undoResult.isReplaced, false);
+    QVERIFY(editorService.getNodeByIndex(node0->index()) == node0);
+    QCOMPARE(node0->text(), QString("Foo"));
+    QCOMPARE(editorService.mindMapData()->graph().nodeCount(), static_cast<size_t>(1));
+    QVERIFY(editorService.isInSelectionGroup(*node0));
+    QCOMPARE(editorService.isModified(), false);
+
+    editorService.undo();
+    QCOMPARE(node0->text(), QString {});
+    QCOMPARE(editorService.mindMapData()->graph().nodeCount(), static_cast<size_t>(2));
+}
+
+void EditorServiceTest::testReload_shouldNotOverwriteUnsavedChanges()
+{
+    QTemporaryDir dir;
+    const auto fileName = dir.filePath("test.alz");
+    IO::AlzFileIO alzFileIO;
+
+    EditorService editorService;
+    editorService.setMindMapData(std::make_shared<MindMapData>());
+    const auto node = editorService.addNodeAt(QPointF(0, 0));
+    QVERIFY(alzFileIO.toFile(editorService.mindMapData(), fileName, false));
+    editorService.loadMindMapData(fileName); // Only takes the file name in test mode
+
+    const auto changedMindMapData = std::make_shared<MindMapData>(*editorService.mindMapData());
+    changedMindMapData->graph().getNode(node->index())->setText("Foo");
+    QVERIFY(alzFileIO.toFile(changedMindMapData, fileName, false));
+
+    editorService.saveUndoPoint();
+    node->setText("Bar");
+
+    QCOMPARE(editorService.reloadMindMapData().status, EditorService::ReloadResult::Status::Conflict);
+    QCOMPARE(node->text(), QString("Bar"));
+}
+
+void EditorServiceTest::testReleaseSceneItems_shouldKeepMindMapAndUndoHistory()
+{
+    EditorService editorService;
+    editorService.setMindMapData(std::make_shared<MindMapData>());
+    editorService.saveUndoPoint();
+    const auto node0 = editorService.addNodeAt(QPointF(0, 0));
+    const auto node1 = editorService.addNodeAt(QPointF(10, 20));
+    node1->setText("Foo");
+    editorService.addEdge(std::make_shared<Edge>(node0, node1));
+    editorService.addNodeToSelectionGroup(*node1);
+
+    editorService.releaseSceneItems();
+
+    QCOMPARE(editorService.nodeSelectionGroupSize(), size_t { 0 });
+    QCOMPARE(editorService.isModified(), true);
+    QCOMPARE(editorService.isUndoable(), true);
+
+    auto && graph = editorService.mindMapData()->graph();
+    QCOMPARE(graph.nodeCount(), size_t { 2 });
+    QCOMPARE(graph.edgeCount(), size_t { 1 });
+    const auto restoredNode1 = graph.getNode(node1->index());
+    QVERIFY(restoredNode1 != node1);
+    QCOMPARE(restoredNode1->text(), QString("Foo"));
+    QCOMPARE(restoredNode1->location(), QPointF(10, 20));
+
+    editorService.undo();
+    QCOMPARE(editorService.mindMapData()->graph().nodeCount(), size_t { 0 });
+}
+
 void EditorServiceTest::testTextSearch()
 {
     const auto data = std::make_shared<MindMapData>();
@@ -895,6 +1047,154 @@ void EditorServiceTest::testUndoNodeTextColor()
     QCOMPARE(redoneNode->textColor(), color);
 }
 
+void EditorServiceTest::testUndoKeepsFileAttributes()
+{
+    EditorService editorService;
+
+    editorService.setMindMapData(std::make_shared<MindMapData>());
+    editorService.mindMapData()->setFileName("test.alz");
+    editorService.mindMapData()->setAlzFormatVersion(IO::AlzFormatVersion::V1);
+
+    // Undone in place
+    editorService.saveUndoPoint();
+    editorService.addNodeAt(QPointF(0, 0));
+    // Undone by replacing the data
+    editorService.saveUndoPoint();
+    editorService.mindMapData()->setBackgroundColor(QColor(1, 1, 1));
+
+    editorService.undo();
+    QCOMPARE(editorService.mindMapData()->fileName(), QString { "test.alz" });
+    QVERIFY(editorService.mindMapData()->alzFormatVersion() == IO::AlzFormatVersion::V1);
+
+    editorService.undo();
+    QCOMPARE(editorService.mindMapData()->fileName(), QString { "test.alz" });
+    QVERIFY(editorService.mindMapData()->alzFormatVersion() == IO::AlzFormatVersion::V1);
+
+    editorService.redo();
+    QCOMPARE(editorService.mindMapData()->fileName(), QString { "test.alz" });
+    QVERIFY(editorService.mindMapData()->alzFormatVersion() == IO::AlzFormatVersion::V1);
+}
+
+void EditorServiceTest::testUndoKeepsUnchangedItems()
+{
+    EditorService editorService;
+    editorService.setMindMapData(std::make_shared<MindMapData>());
+
+    const auto node0 = editorService.addNodeAt(QPointF(0, 0));
+    const auto node1 = editorService.addNodeAt(QPointF(1, 1));
+    const auto node2 = editorService.addNodeAt(QPointF(2, 2));
+    const auto edge01 = editorService.addEdge(std::make_shared<Edge>(node0, node1));
+    const auto edge12 = editorService.addEdge(std::make_shared<Edge>(node1, node2));
+
+    editorService.saveUndoPoint();
+
+    node1->setLocation({ 666, 666 });
+    edge01->setText("Foo");
+    editorService.deleteNode(*node2);
+
+    const auto undoResult = editorService.undo();
+    QCOMPARE(undoResult.isReplaced, false);
+    QCOMPARE(undoResult.addedNodes.size(), size_t(1));
+    QCOMPARE(undoResult.addedEdges.size(), size_t(1));
+
+    // Changed items are updated in place and only the deleted ones get recreated
+    QVERIFY(editorService.getNodeByIndex(node0->index()) == node0);
+    QVERIFY(editorService.getNodeByIndex(node1->index()) == node1);
+    QCOMPARE(node1->location(), QPointF(1, 1));
+    QVERIFY(editorService.mindMapData()->graph().getEdge(node0->index(), node1->index()) == edge01);
+    QCOMPARE(edge01->text(), QString {});
+
+    const auto undoneNode2 = editorService.getNodeByIndex(node2->index());
+    QVERIFY(undoneNode2 != node2);
+    QCOMPARE(undoneNode2->location(), QPointF(2, 2));
+    QVERIFY(editorService.mindMapData()->graph().areDirectlyConnected(node1->index(), node2->index()));
+    QVERIFY(editorService.mindMapData()->graph().getEdge(node1->index(), node2->index()) != edge12);
+
+    const auto redoResult = editorService.redo();
+    QCOMPARE(redoResult.isReplaced, false);
+    QCOMPARE(redoResult.addedNodes.size(), size_t(0));
+    QVERIFY(editorService.getNodeByIndex(node1->index()) == node1);
+    QCOMPARE(node1->location(), QPointF(666, 666));
+    QCOMPARE(edge01->text(), QString("Foo"));
+    QCOMPARE(editorService.mindMapData()->graph().nodeCount(), size_t(2));
+
+    editorService.saveUndoPoint();
+    editorService.mindMapData()->setCornerRadius(1);
+    QCOMPARE(editorService.undo().isReplaced, true);
+}
+
+void EditorServiceTest::testTransaction_SavesOnlyFirstUndoPoint()
+{
+    EditorService editorService;
+    editorService.setMindMapData(std::make_shared<MindMapData>());
+    QSignalSpy undoEnabledSpy(&editorService, &EditorService::undoEnabled);
+
+    editorService.beginTransaction();
+    editorService.beginTransaction();
+    QVERIFY(editorService.isInTransaction());
+
+    editorService.saveUndoPoint();
+    editorService.addNodeAt(QPointF(0, 0));
+    editorService.saveUndoPoint();
+    editorService.addNodeAt(QPointF(1, 1));
+
+    QCOMPARE(editorService.commitTransaction(), false);
+    QCOMPARE(undoEnabledSpy.count(), 0);
+    QCOMPARE(editorService.commitTransaction(), true);
+    QVERIFY(!editorService.isInTransaction());
+    QCOMPARE(undoEnabledSpy.count(), 1);
+
+    editorService.undo();
+    QCOMPARE(editorService.mindMapData()->graph().nodeCount(), size_t(0));
+    QCOMPARE(editorService.isUndoable(), false);
+
+    // The next transaction saves an undo point again
+    editorService.beginTransaction();
+    editorService.saveUndoPoint();
+    editorService.addNodeAt(QPointF(0, 0));
+    editorService.commitTransaction();
+    QCOMPARE(editorService.isUndoable(), true);
+}
+
+void EditorServiceTest::testUndoCoalescing_shouldMergeConsecutiveChanges()
+{
+    using UndoCoalescing = EditorService::UndoCoalescing;
+
+    EditorService editorService;
+    editorService.setMindMapData(std::make_shared<MindMapData>());
+    const auto node = editorService.addNodeAt(QPointF(0, 0));
+    const auto index = node->index();
+
+    for (auto && text : { "a", "ab", "abc" }) {
+        editorService.saveCoalescedUndoPoint(UndoCoalescing::EditText, node.get());
+        node->setText(text);
+    }
+
+    editorService.saveCoalescedUndoPoint(UndoCoalescing::MoveSelection, node.get());
+    node->setLocation(QPointF(10, 10));
+    editorService.saveCoalescedUndoPoint(UndoCoalescing::MoveSelection, node.get());
+    node->setLocation(QPointF(20, 20));
+
+    // A changed selection starts a new move
+    editorService.addNodeToSelectionGroup(*node);
+    editorService.saveCoalescedUndoPoint(UndoCoalescing::MoveSelection, nullptr);
+    node->setLocation(QPointF(30, 30));
+
+    editorService.undo();
+    QCOMPARE(editorService.mindMapData()->graph().getNode(index)->location(), QPointF(20, 20));
+    editorService.undo();
+    QCOMPARE(editorService.mindMapData()->graph().getNode(index)->location(), QPointF(0, 0));
+    QCOMPARE(editorService.mindMapData()->graph().getNode(index)->text(), QString("abc"));
+    editorService.undo();
+    QCOMPARE(editorService.mindMapData()->graph().getNode(index)->text(), QString(""));
+    QCOMPARE(editorService.isUndoable(), false);
+
+    // Undo ends the coalescing
+    editorService.redo();
+    editorService.saveCoalescedUndoPoint(UndoCoalescing::EditText, node.get());
+    QCOMPARE(editorService.isUndoable(), true);
+}
+
 void EditorServiceTest::testUndoTextSize()
 {
     EditorService editorService;
@@ -1008,6 +1308,202 @@ void EditorServiceTest::testUndoStackResetOnLoadDesign()
     QCOMPARE(editorService.isUndoable(), false);
 }
 
+namespace {
+
+//! \returns Mind map with the given number of nodes and a background color that tells the states apart.
+MindMapDataU buildUndoJournalState(int nodeCount)
+{
+    auto mindMapData = std::make_unique<MindMapData>();
+    mindMapData->setBackgroundColor({ nodeCount, 0, 0 });
+    for (int i = 0; i < nodeCount; i++) {
+        mindMapData->graph().addNode(std::make_shared<Node>());
+    }
+    return mindMapData;
+}
+
+} // namespace
+
+void EditorServiceTest::testUndoStackJournal_shouldKeepHistoryBetweenSessions()
+{
+    QTemporaryDir dir;
+    const auto path = dir.filePath("test.alz.undo");
+    const int stateCount = 10;
+    {
+        // Only the newest points of the small keyframe interval stay in memory
+        UndoStack undoStack { 0, 3 };
+        QVERIFY(undoStack.openJournal(path, *buildUndoJournalState(0)));
+        for (int i = 0; i < stateCount; i++) {
+            undoStack.pushUndoPoint(*buildUndoJournalState(i));
+        }
+        QCOMPARE(undoStack.undoMemoryUsage().itemCount, static_cast<size_t>(stateCount));
+        undoStack.setJournalState(*buildUndoJournalState(stateCount));
+    }
+
+    UndoStack undoStack { 0, 3 };
+    QVERIFY(undoStack.openJournal(path, *buildUndoJournalState(stateCount)));
+    for (int i = stateCount - 1; i >= 0; i--) {
+        QVERIFY(undoStack.isUndoable());
+        const auto mindMapData = undoStack.undo();
+        QCOMPARE(mindMapData->graph().nodeCount(), static_cast<size_t>(i));
+        QCOMPARE(mindMapData->backgroundColor(), QColor(i, 0, 0));
+    }
+    QCOMPARE(undoStack.isUndoable(), false);
+}
+
+void EditorServiceTest::testUndoStackJournal_shouldFollowUndo()
+{
+    QTemporaryDir dir;
+    const auto path = dir.filePath("test.alz.undo");
+    {
+        UndoStack undoStack { 0, 3 };
+        QVERIFY(undoStack.openJournal(path, *buildUndoJournalState(0)));
+        for (int i = 0; i < 5; i++) {
+            undoStack.pushUndoPoint(*buildUndoJournalState(i));
+        }
+        undoStack.undo();
+        undoStack.undo();
+    }
+
+    // The state that was open last time is left out, as it's the one that is open again
+    UndoStack undoStack { 0, 3 };
+    QVERIFY(undoStack.openJournal(path, *buildUndoJournalState(2)));
+    QCOMPARE(undoStack.undoMemoryUsage().itemCount, static_cast<size_t>(2));
+    QCOMPARE(undoStack.undo()->graph().nodeCount(), static_cast<size_t>(1));
+    QCOMPARE(undoStack.undo()->graph().nodeCount(), static_cast<size_t>(0));
+    QCOMPARE(undoStack.isUndoable(), false);
+}
+
+void EditorServiceTest::testUndoStackJournal_shouldDiscardHistoryOfOtherState()
+{
+    QTemporaryDir dir;
+    const auto path = dir.filePath("test.alz.undo");
+    {
+        UndoStack undoStack { 0, 3 };
+        QVERIFY(undoStack.openJournal(path, *buildUndoJournalState(0)));
+        for (int i = 0; i < 5; i++) {
+            undoStack.pushUndoPoint(*buildUndoJournalState(i));
+        }
+        undoStack.setJournalState(*buildUndoJournalState(5));
+    }
+
+    // E.g. the file has been changed elsewhere
+    UndoStack undoStack { 0, 3 };
+    QVERIFY(undoStack.openJournal(path, *buildUndoJournalState(7)));
+    QCOMPARE(undoStack.isUndoable(), false);
+
+    QVERIFY(undoStack.openJournal(path, *buildUndoJournalState(5)));
+    QCOMPARE(undoStack.isUndoable(), false);
+}
+
+void EditorServiceTest::testUndoStackJournal_shouldDiscardCorruptedHistory()
+{
+    QTemporaryDir dir;
+    const auto path = dir.filePath("test.alz.undo");
+    const int stateCount = 10;
+    {
+        UndoStack undoStack { 0, 3 };
+        QVERIFY(undoStack.openJournal(path, *buildUndoJournalState(0)));
+        for (int i = 0; i < stateCount; i++) {
+            undoStack.pushUndoPoint(*buildUndoJournalState(i));
+        }
+        undoStack.setJournalState(*buildUndoJournalState(stateCount));
+    }
+
+    // The size of the style data of the first record: magic, version, state hash, record size, keyframe flag
+    QFile file { path };
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.seek(4 + 4 + IO::UndoJournal::STATE_HASH_SIZE + 4 + 1));
+    QCOMPARE(file.write(QByteArray { "\xff\xff\xff\xf0" }), qint64 { 4 });
+    file.close();
+
+    // Only the keyframe before the newest points is read when opening, so the corruption shows up on undo
+    UndoStack undoStack { 0, 3 };
+    QVERIFY(undoStack.openJournal(path, *buildUndoJournalState(stateCount)));
+    QCOMPARE(undoStack.undoCount(), static_cast<size_t>(stateCount));
+    size_t undoCount = 0;
+    while (undoStack.isUndoable() && undoStack.undo()) {
+        undoCount++;
+    }
+    QVERIFY(undoCount < static_cast<size_t>(stateCount));
+    QCOMPARE(undoStack.isUndoable(), false);
+    QCOMPARE(undoStack.isRedoable(), false);
+
+    QVERIFY(undoStack.openJournal(path, *buildUndoJournalState(stateCount)));
+    QCOMPARE(undoStack.isUndoable(), false);
+}
+
+void EditorServiceTest::testUndoStackSteps_shouldKeepSkippedPointsRedoable()
+{
+    // The steps cross several keyframes of the small keyframe interval
+    UndoStack undoStack { 0, 3 };
+    const int stateCount = 10;
+    for (int i = 0; i < stateCount; i++) {
+        undoStack.pushUndoPoint(*buildUndoJournalState(i));
+    }
+
+    undoStack.pushRedoPoint(*buildUndoJournalState(stateCount));
+    QCOMPARE(undoStack.undo(7)->graph().nodeCount(), static_cast<size_t>(3));
+    QCOMPARE(undoStack.undoCount(), static_cast<size_t>(3));
+    QCOMPARE(undoStack.redoCount(), static_cast<size_t>(7));
+
+    // The skipped points are redone one by one
+    for (int i = 4; i <= stateCount; i++) {
+        undoStack.pushUndoPoint(*buildUndoJournalState(i - 1));
+        QCOMPARE(undoStack.redo()->graph().nodeCount(), static_cast<size_t>(i));
+    }
+    QCOMPARE(undoStack.isRedoable(), false);
+
+    undoStack.pushRedoPoint(*buildUndoJournalState(stateCount));
+    QCOMPARE(undoStack.undo(stateCount)->graph().nodeCount(), static_cast<size_t>(0));
+    QCOMPARE(undoStack.isUndoable(), false);
+    QCOMPARE(undoStack.redoCount(), static_cast<size_t>(stateCount));
+
+    undoStack.pushUndoPoint(*buildUndoJournalState(0));
+    QCOMPARE(undoStack.redo(stateCount)->graph().nodeCount(), static_cast<size_t>(stateCount));
+    QCOMPARE(undoStack.undoCount(), static_cast<size_t>(stateCount));
+    QCOMPARE(undoStack.undo()->graph().nodeCount(), static_cast<size_t>(stateCount - 1));
+}
+
+void EditorServiceTest::testJumpToHistoryPosition_shouldApplyStateAtPosition()
+{
+    const auto data = std::make_shared<MindMapData>();
+    const auto node = std::make_shared<Node>();
+    data->graph().addNode(node);
+
+    EditorService editorService;
+    editorService.setMindMapData(data);
+
+    // The state at each position has the node at x = position
+    const int stepCount = 50;
+    for (int i = 0; i < stepCount; i++) {
+        editorService.saveUndoPoint();
+        node->setLocation({ static_cast<double>(i + 1), 0 });
+    }
+    QCOMPARE(editorService.historyPosition(), static_cast<size_t>(stepCount));
+    QCOMPARE(editorService.historyLength(), static_cast<size_t>(stepCount));
+
+    editorService.jumpToHistoryPosition(10);
+    QCOMPARE(editorService.getNodeByIndex(node->index())->location(), QPointF(10, 0));
+    QCOMPARE(editorService.historyPosition(), static_cast<size_t>(10));
+    QCOMPARE(editorService.historyLength(), static_cast<size_t>(stepCount));
+
+    editorService.jumpToHistoryPosition(45);
+    QCOMPARE(editorService.getNodeByIndex(node->index())->location(), QPointF(45, 0));
+
+    editorService.undo();
+    QCOMPARE(editorService.getNodeByIndex(node->index())->location(), QPointF(44, 0));
+    editorService.redo();
+    QCOMPARE(editorService.getNodeByIndex(node->index())->location(), QPointF(45, 0));
+
+    editorService.jumpToHistoryPosition(0);
+    QCOMPARE(editorService.getNodeByIndex(node->index())->location(), QPointF(0, 0));
+    QCOMPARE(editorService.isUndoable(), false);
+
+    editorService.jumpToHistoryPosition(stepCount);
+    QCOMPARE(editorService.getNodeByIndex(node->index())->location(), QPointF(stepCount, 0));
+    QCOMPARE(editorService.isRedoable(), false);
+}
+
 void EditorServiceTest::testUndoModificationFlagOnNewDesign()
 {
     EditorService editorService;
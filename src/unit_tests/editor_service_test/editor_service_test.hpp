@@ -31,6 +31,8 @@ private slots:
 
     void testAddAndDeleteEdge();
 
+    void testCopiedDataSerialization();
+
     void testGroupConnection();
 
     void testGroupDisconnection();
@@ -55,6 +57,12 @@ private slots:
 
     void testRedoState();
 
+    void testReload_shouldUpdateChangedItemsInPlace();
+
+    void testReload_shouldNotOverwriteUnsavedChanges();
+
+    void testReleaseSceneItems_shouldKeepMindMapAndUndoHistory();
+
     void testTextSearch();
 
     void testUndoAddEdge();
@@ -93,6 +101,14 @@ private slots:
 
     void testUndoNodeTextColor();
 
+    void testUndoKeepsFileAttributes();
+
+    void testUndoKeepsUnchangedItems();
+
+    void testTransaction_SavesOnlyFirstUndoPoint();
+
+    void testUndoCoalescing_shouldMergeConsecutiveChanges();
+
     void testUndoTextSize();
 
     void testUndoState();
@@ -101,6 +117,18 @@ private slots:
 
     void testUndoStackResetOnLoadDesign();
 
+    void testUndoStackJournal_shouldKeepHistoryBetweenSessions();
+
+    void testUndoStackJournal_shouldFollowUndo();
+
+    void testUndoStackJournal_shouldDiscardHistoryOfOtherState();
+
+    void testUndoStackJournal_shouldDiscardCorruptedHistory();
+
+    void testUndoStackSteps_shouldKeepSkippedPointsRedoable();
+
+    void testJumpToHistoryPosition_shouldApplyStateAtPosition();
+
     void testUndoModificationFlagOnNewDesign();
 
     void testUndoModificationFlagOnLoadDesign();
@@ -17,8 +17,16 @@
 
 #include "../../common/test_mode.hpp"
 #include "../../domain/graph.hpp"
+#include "../../domain/graph_change_notifier.hpp"
+#include "../../domain/graph_snapshot.hpp"
+#include "../../domain/node_spatial_index.hpp"
 #include "../../view/scene_items/node.hpp"
 
+#include <QSignalSpy>
+
+#include <algorithm>
+#include <map>
+#include <random>
 #include <stdexcept>
 #include <string>
 
@@ -89,6 +97,22 @@ void GraphTest::testAddNode()
     QCOMPARE(node->index(), 667); // Node index should be automatically 667
 }
 
+void GraphTest::testAddNode_InvalidIndex()
+{
+    Graph dut;
+    for (auto && index : { -2, 2000000000 }) {
+        const auto node = make_shared<Node>();
+        node->setIndex(index);
+        QVERIFY_EXCEPTION_THROWN(dut.addNode(node), std::out_of_range);
+    }
+    QCOMPARE(dut.nodeCount(), size_t { 0 });
+
+    // Sparse indices are fine as long as the slots stay in proportion to the nodes
+    QVERIFY(Graph::isValidNodeIndex(100000, 1));
+    QVERIFY(!Graph::isValidNodeIndex(100000000, 1000));
+    QVERIFY(Graph::isValidNodeIndex(100000000, 10000000));
+}
+
 void GraphTest::testAddTwoNodes()
 {
     Graph dut;
@@ -106,6 +130,59 @@ void GraphTest::testAddTwoNodes()
     QCOMPARE(node1->index(), 1);
 }
 
+void GraphTest::testAddNodesAndEdges()
+{
+    Graph dut;
+    const auto node0 = make_shared<Node>();
+    node0->setIndex(10);
+    dut.addNode(node0);
+
+    // The indices of the nodes get overridden
+    const Graph::NodeVector nodes = { make_shared<Node>(), make_shared<Node>(), make_shared<Node>() };
+    nodes.at(1)->setIndex(0);
+    dut.addNodes(nodes);
+
+    QCOMPARE(dut.nodeCount(), static_cast<size_t>(4));
+    QCOMPARE(nodes.at(0)->index(), 11);
+    QCOMPARE(nodes.at(1)->index(), 12);
+    QCOMPARE(nodes.at(2)->index(), 13);
+    QVERIFY(dut.getNode(12) == nodes.at(1));
+
+    dut.addEdges({ make_shared<Edge>(node0, nodes.at(0)), make_shared<Edge>(nodes.at(0), nodes.at(1)), make_shared<Edge>(node0, nodes.at(0)) });
+
+    QCOMPARE(dut.edgeCount(), static_cast<size_t>(2));
+    QVERIFY(dut.areDirectlyConnected(10, 11));
+    QVERIFY(dut.areDirectlyConnected(11, 12));
+}
+
+void GraphTest::testAdvanceEpochReclaimsDeletedItems()
+{
+    Graph dut;
+
+    auto node0 = make_shared<Node>();
+    dut.addNode(node0);
+
+    const auto node1 = make_shared<Node>();
+    dut.addNode(node1);
+
+    dut.addEdge(make_shared<Edge>(node0, node1));
+
+    const auto index0 = node0->index();
+    node0.reset();
+    dut.deleteNode(index0);
+
+    QCOMPARE(dut.deletedNodeCount(), static_cast<size_t>(1));
+    QCOMPARE(dut.deletedEdgeCount(), static_cast<size_t>(1));
+
+    // Deleted items are kept for one full epoch
+    QCOMPARE(dut.advanceEpoch(), static_cast<size_t>(0));
+    QCOMPARE(dut.deletedNodeCount(), static_cast<size_t>(1));
+
+    QCOMPARE(dut.advanceEpoch(), static_cast<size_t>(2));
+    QCOMPARE(dut.deletedNodeCount(), static_cast<size_t>(0));
+    QCOMPARE(dut.deletedEdgeCount(), static_cast<size_t>(0));
+}
+
 void GraphTest::testAreNodesDirectlyConnected()
 {
     Graph dut;
@@ -195,6 +272,97 @@ void GraphTest::testDeleteNodeInvolvingEdge()
     QCOMPARE(dut.getEdgesToNode(node1).size(), static_cast<size_t>(0));
 }
 
+void GraphTest::testDegree()
+{
+    Graph dut;
+
+    const auto node0 = make_shared<Node>();
+    dut.addNode(node0);
+
+    const auto node1 = make_shared<Node>();
+    dut.addNode(node1);
+
+    const auto node2 = make_shared<Node>();
+    dut.addNode(node2);
+
+    dut.addEdge(make_shared<Edge>(node0, node1));
+    dut.addEdge(make_shared<Edge>(node2, node0));
+
+    QCOMPARE(dut.degree(node0->index()), static_cast<size_t>(2));
+    QCOMPARE(dut.edgesFromNode(node0->index()).size(), static_cast<size_t>(1));
+    QCOMPARE(dut.edgesToNode(node0->index()).size(), static_cast<size_t>(1));
+
+    dut.deleteEdge(node0->index(), node1->index());
+
+    QCOMPARE(dut.degree(node0->index()), static_cast<size_t>(1));
+    QCOMPARE(dut.degree(node1->index()), static_cast<size_t>(0));
+
+    dut.deleteNode(node2->index());
+
+    QCOMPARE(dut.degree(node0->index()), static_cast<size_t>(0));
+    QCOMPARE(dut.edgeCount(), static_cast<size_t>(0));
+}
+
+void GraphTest::testDescendantIndices()
+{
+    Graph dut;
+
+    const auto node0 = make_shared<Node>();
+    dut.addNode(node0);
+
+    const auto node1 = make_shared<Node>();
+    dut.addNode(node1);
+
+    const auto node2 = make_shared<Node>();
+    dut.addNode(node2);
+
+    const auto node3 = make_shared<Node>();
+    dut.addNode(node3);
+
+    dut.addEdge(make_shared<Edge>(node0, node1));
+    dut.addEdge(make_shared<Edge>(node1, node2));
+    dut.addEdge(make_shared<Edge>(node3, node1));
+
+    QCOMPARE(dut.descendantIndices(node0->index()), (std::unordered_set<int> { node1->index(), node2->index() }));
+    QCOMPARE(dut.descendantIndices(node2->index()).size(), static_cast<size_t>(0));
+
+    // A cycle doesn't hide the node itself
+    dut.addEdge(make_shared<Edge>(node2, node0));
+    QCOMPARE(dut.descendantIndices(node0->index()), (std::unordered_set<int> { node1->index(), node2->index() }));
+}
+
+void GraphTest::testTraverse()
+{
+    Graph dut;
+
+    const auto node0 = make_shared<Node>();
+    dut.addNode(node0);
+
+    const auto node1 = make_shared<Node>();
+    dut.addNode(node1);
+
+    const auto node2 = make_shared<Node>();
+    dut.addNode(node2);
+
+    const auto node3 = make_shared<Node>();
+    dut.addNode(node3);
+
+    dut.addEdge(make_shared<Edge>(node0, node1));
+    dut.addEdge(make_shared<Edge>(node1, node2));
+    dut.addEdge(make_shared<Edge>(node3, node1));
+
+    using Direction = Graph::TraversalDirection;
+    QCOMPARE(dut.traverse({ node0->index() }, Direction::Descendants), (std::vector<int> { node0->index(), node1->index(), node2->index() }));
+    QCOMPARE(dut.traverse({ node2->index() }, Direction::Descendants), (std::vector<int> { node2->index() }));
+    QCOMPARE(dut.traverse({ node2->index() }, Direction::Ancestors), (std::vector<int> { node2->index(), node1->index(), node0->index(), node3->index() }));
+
+    // Overlapping branches and cycles yield each node only once
+    dut.addEdge(make_shared<Edge>(node2, node0));
+    QCOMPARE(dut.traverse({ node1->index(), node0->index() }, Direction::Descendants), (std::vector<int> { node1->index(), node0->index(), node2->index() }));
+
+    QCOMPARE(dut.traverse({}, Direction::Ancestors).size(), static_cast<size_t>(0));
+}
+
 void GraphTest::testGetEdges()
 {
     Graph dut;
@@ -246,6 +414,37 @@ void GraphTest::testGetNodes()
             == 1);
 }
 
+void GraphTest::testNodeAndEdgeRanges()
+{
+    Graph dut;
+
+    const auto node0 = make_shared<Node>();
+    dut.addNode(node0);
+
+    const auto node1 = make_shared<Node>();
+    dut.addNode(node1);
+
+    dut.addEdge(make_shared<Edge>(node0, node1));
+
+    QCOMPARE(dut.nodes().size(), static_cast<size_t>(2));
+    QCOMPARE(static_cast<size_t>(std::distance(dut.nodes().begin(), dut.nodes().end())), static_cast<size_t>(2));
+
+    int indexSum = 0;
+    dut.forEachNode([&](auto && node) {
+        indexSum += node->index();
+    });
+    QCOMPARE(indexSum, node0->index() + node1->index());
+
+    QCOMPARE(dut.edges().size(), static_cast<size_t>(1));
+
+    size_t edgeCount = 0;
+    dut.forEachEdge([&](auto && edge) {
+        QCOMPARE(edge->sourceNode().index(), node0->index());
+        edgeCount++;
+    });
+    QCOMPARE(edgeCount, static_cast<size_t>(1));
+}
+
 void GraphTest::testGetNodesConnectedToNode()
 {
     Graph dut;
@@ -298,4 +497,681 @@ void GraphTest::testGetNodeByIndex_NotFound()
     QVERIFY(message == "Invalid node index: " + std::to_string(666));
 }
 
+void GraphTest::testGraphSnapshot()
+{
+    Graph graph;
+
+    const auto node0 = make_shared<Node>();
+    node0->setText("Foo");
+    graph.addNode(node0);
+
+    const auto node1 = make_shared<Node>();
+    node1->setLocation({ 1, 2 });
+    graph.addNode(node1);
+
+    const auto edge = make_shared<Edge>(node0, node1);
+    edge->setText("Bar");
+    graph.addEdge(edge);
+
+    const GraphSnapshot snapshot { graph };
+    QCOMPARE(snapshot.nodes().size(), static_cast<size_t>(2));
+    QCOMPARE(snapshot.edges().size(), static_cast<size_t>(1));
+
+    Graph dut;
+    snapshot.restore(dut);
+
+    QCOMPARE(dut.nodeCount(), static_cast<size_t>(2));
+    QCOMPARE(dut.getNode(node0->index())->text(), QString { "Foo" });
+    QCOMPARE(dut.getNode(node1->index())->location(), QPointF(1, 2));
+    QVERIFY(dut.getNode(node0->index()) != node0);
+
+    QCOMPARE(dut.edgeCount(), static_cast<size_t>(1));
+    const auto restoredEdge = dut.getEdge(node0->index(), node1->index());
+    QVERIFY(restoredEdge);
+    QCOMPARE(restoredEdge->text(), QString { "Bar" });
+    QCOMPARE(&restoredEdge->sourceNode(), dut.getNode(node0->index()).get());
+}
+
+void GraphTest::testGraphSnapshotDelta()
+{
+    Graph graph;
+
+    const auto node0 = make_shared<Node>();
+    graph.addNode(node0);
+
+    const auto node1 = make_shared<Node>();
+    graph.addNode(node1);
+
+    const GraphSnapshot from { graph };
+
+    node0->setText("Foo");
+    const auto node2 = make_shared<Node>();
+    graph.addNode(node2);
+    graph.addEdge(make_shared<Edge>(node0, node2));
+    graph.deleteNode(node1->index());
+
+    const GraphSnapshot to { graph };
+
+    const auto delta = GraphSnapshot::diff(from, to);
+    QCOMPARE(delta.removedNodes.size(), static_cast<size_t>(2)); // Old node0 and node1
+    QCOMPARE(delta.addedNodes.size(), static_cast<size_t>(2)); // New node0 and node2
+    QCOMPARE(delta.addedEdges.size(), static_cast<size_t>(1));
+    QVERIFY(GraphSnapshot::diff(to, to).isEmpty());
+
+    auto snapshot = from;
+    snapshot.apply(delta);
+    QVERIFY(GraphSnapshot::diff(snapshot, to).isEmpty());
+
+    snapshot.apply(delta, true);
+    QVERIFY(GraphSnapshot::diff(snapshot, from).isEmpty());
+}
+
+void GraphTest::testGraphSnapshotDensified()
+{
+    Graph graph;
+    std::vector<NodeS> nodes;
+    for (int i = 0; i < 4; i++) {
+        nodes.push_back(make_shared<Node>());
+        graph.addNode(nodes.back());
+    }
+    const auto uuid = QUuid::createUuid();
+    nodes.at(3)->setText("Last");
+    nodes.at(3)->setUuid(uuid);
+    graph.addEdge(make_shared<Edge>(nodes.at(0), nodes.at(3)));
+    graph.addEdge(make_shared<Edge>(nodes.at(2), nodes.at(0)));
+    graph.deleteNode(nodes.at(1)->index());
+
+    const GraphSnapshot snapshot { graph };
+    QVERIFY(!snapshot.hasDenseIndices());
+    QCOMPARE(snapshot.denseIndexMap(), (GraphSnapshot::IndexMap { 0, -1, 1, 2 }));
+
+    const auto densified = snapshot.densified();
+    QVERIFY(densified.hasDenseIndices());
+    QCOMPARE(densified.nodes().size(), size_t(3));
+    QCOMPARE(densified.nodes().at(2).text.toString(), QString { "Last" });
+    QCOMPARE(densified.nodes().at(2).uuid, uuid);
+
+    const auto hasEdge = [&densified](int sourceIndex, int targetIndex) {
+        return std::any_of(densified.edges().begin(), densified.edges().end(), [=](auto && edge) {
+            return edge.sourceIndex == sourceIndex && edge.targetIndex == targetIndex;
+        });
+    };
+    QCOMPARE(densified.edges().size(), size_t(2));
+    QVERIFY(hasEdge(0, 2));
+    QVERIFY(hasEdge(1, 0));
+
+    // Already dense
+    QVERIFY(GraphSnapshot::diff(densified.densified(), densified).isEmpty());
+}
+
+void GraphTest::testGraphSnapshotNodeIndexSet()
+{
+    GraphSnapshot::NodeIndexSet indices;
+    QVERIFY(!indices.contains(0));
+
+    indices.insert(0);
+    indices.insert(1);
+    QVERIFY(indices.contains(1));
+    QVERIFY(!indices.contains(2));
+    QVERIFY(!indices.contains(-1));
+
+    // A gap falls back to hashing without losing the indices so far
+    indices.insert(5);
+    QVERIFY(indices.contains(0));
+    QVERIFY(indices.contains(1));
+    QVERIFY(!indices.contains(2));
+    QVERIFY(indices.contains(5));
+}
+
+void GraphTest::testGraphSnapshotCompression()
+{
+    Graph graph;
+
+    const auto node0 = make_shared<Node>();
+    node0->setText("Foo");
+    node0->setLocation({ 3, 4 });
+    graph.addNode(node0);
+
+    const auto node1 = make_shared<Node>();
+    graph.addNode(node1);
+
+    const auto edge = make_shared<Edge>(node0, node1);
+    edge->setText("Bar");
+    edge->setDashedLine(true);
+    graph.addEdge(edge);
+
+    const GraphSnapshot snapshot { graph };
+    const auto dut = GraphSnapshot::fromCompressedData(snapshot.toCompressedData());
+
+    QCOMPARE(dut.nodes().size(), static_cast<size_t>(2));
+    QCOMPARE(dut.edges().size(), static_cast<size_t>(1));
+    QVERIFY(GraphSnapshot::diff(snapshot, dut).isEmpty());
+}
+
+void GraphTest::testSearchByText()
+{
+    Graph graph;
+
+    const auto node0 = make_shared<Node>();
+    node0->setText("Mind maps");
+    graph.addNode(node0);
+
+    const auto node1 = make_shared<Node>();
+    node1->setText("Map");
+    graph.addNode(node1);
+
+    const auto node2 = make_shared<Node>();
+    node2->setText("Bitmap");
+    graph.addNode(node2);
+
+    const auto node3 = make_shared<Node>();
+    node3->setText("Foo");
+    graph.addNode(node3);
+
+    // Exact match first, then word prefix, then plain substring
+    const auto nodes = graph.searchNodesByText("map");
+    QCOMPARE(nodes.size(), static_cast<size_t>(3));
+    QCOMPARE(nodes.at(0), node1);
+    QCOMPARE(nodes.at(1), node0);
+    QCOMPARE(nodes.at(2), node2);
+
+    QCOMPARE(graph.searchNodesByText("m").size(), static_cast<size_t>(3));
+    QCOMPARE(graph.searchNodesByText("FOO").size(), static_cast<size_t>(1));
+    QVERIFY(graph.searchNodesByText("maps!").empty());
+    QVERIFY(graph.searchNodesByText("").empty());
+
+    const auto edge = make_shared<Edge>(node0, node3);
+    edge->setText("Bar");
+    graph.addEdge(edge);
+
+    QCOMPARE(graph.searchEdgesByText("ar").size(), static_cast<size_t>(1));
+    QCOMPARE(graph.searchEdgesByText("ar").at(0), edge);
+}
+
+void GraphTest::testSearchByTextFollowsChanges()
+{
+    Graph graph;
+
+    const auto node0 = make_shared<Node>();
+    node0->setText("Foo");
+    graph.addNode(node0);
+
+    const auto node1 = make_shared<Node>();
+    graph.addNode(node1);
+
+    const auto edge = make_shared<Edge>(node0, node1);
+    graph.addEdge(edge);
+
+    node0->setText("Bar");
+    edge->setText("Foobar");
+
+    QVERIFY(graph.searchNodesByText("foo").empty());
+    QCOMPARE(graph.searchNodesByText("bar").size(), static_cast<size_t>(1));
+    QCOMPARE(graph.searchEdgesByText("foo").size(), static_cast<size_t>(1));
+
+    graph.deleteNode(node0->index());
+
+    QVERIFY(graph.searchNodesByText("bar").empty());
+    QVERIFY(graph.searchEdgesByText("foo").empty());
+
+    // Removed items aren't followed anymore
+    node0->setText("Bar");
+    QVERIFY(graph.searchNodesByText("bar").empty());
+}
+
+void GraphTest::testEdgeLengthStats()
+{
+    EdgeLengthStats stats;
+    QVERIFY(!stats.average());
+    QVERIFY(!stats.minimum());
+    QVERIFY(!stats.maximum());
+
+    stats.setLength(0, 10);
+    stats.setLength(1, 20);
+    stats.setLength(2, 30);
+    QCOMPARE(*stats.average(), 20.0);
+    QCOMPARE(*stats.minimum(), 10.0);
+    QCOMPARE(*stats.maximum(), 30.0);
+
+    stats.setLength(2, 15);
+    QCOMPARE(*stats.average(), 15.0);
+    QCOMPARE(*stats.maximum(), 20.0);
+
+    stats.remove(0);
+    QCOMPARE(stats.size(), static_cast<size_t>(2));
+    QCOMPARE(*stats.minimum(), 15.0);
+
+    stats.clear();
+    QVERIFY(!stats.average());
+}
+
+void GraphTest::testEdgeLengthStatsFollowsEdges()
+{
+    Graph graph;
+
+    const auto node0 = make_shared<Node>();
+    graph.addNode(node0);
+
+    const auto node1 = make_shared<Node>();
+    graph.addNode(node1);
+
+    const auto node2 = make_shared<Node>();
+    graph.addNode(node2);
+
+    graph.addEdge(make_shared<Edge>(node0, node1));
+    graph.addEdge(make_shared<Edge>(node1, node2));
+    QCOMPARE(graph.edgeLengthStats().size(), static_cast<size_t>(2));
+
+    graph.deleteNode(node0->index());
+    QCOMPARE(graph.edgeLengthStats().size(), static_cast<size_t>(1));
+
+    graph.clear();
+    QCOMPARE(graph.edgeLengthStats().size(), static_cast<size_t>(0));
+}
+
+void GraphTest::testNodePlacementStatsFollowsNodes()
+{
+    Graph graph;
+    QVERIFY(graph.nodePlacementStats().boundingRect().isNull());
+
+    const auto node0 = make_shared<Node>();
+    node0->setSize({ 10, 10 });
+    graph.addNode(node0);
+
+    const auto node1 = make_shared<Node>();
+    node1->setSize({ 20, 20 });
+    node1->setLocation({ 100, 100 });
+    graph.addNode(node1);
+
+    QCOMPARE(graph.nodePlacementStats().boundingRect(), QRectF(-5, -5, 115, 115));
+    QCOMPARE(graph.nodePlacementStats().totalArea(), 500.0);
+
+    // Moving the outermost node shrinks the bounds
+    node1->setLocation({ 50, 0 });
+    QCOMPARE(graph.nodePlacementStats().boundingRect(), QRectF(-5, -10, 65, 20));
+
+    graph.deleteNode(node1->index());
+    QCOMPARE(graph.nodePlacementStats().boundingRect(), QRectF(-5, -5, 10, 10));
+    QCOMPARE(graph.nodePlacementStats().totalArea(), 100.0);
+}
+
+void GraphTest::testNodeSpatialIndexFollowsNodes()
+{
+    Graph graph;
+    QVERIFY(graph.nodeSpatialIndex().keysInRect({ -1000, -1000, 2000, 2000 }).empty());
+
+    const auto node0 = make_shared<Node>();
+    node0->setSize({ 10, 10 });
+    graph.addNode(node0);
+
+    // Larger than a cell of the index
+    const auto node1 = make_shared<Node>();
+    node1->setSize({ 600, 20 });
+    node1->setLocation({ 1000, 100 });
+    graph.addNode(node1);
+
+    QCOMPARE(graph.nodeSpatialIndex().keysInRect({ -1, -1, 2, 2 }), std::vector<int> { node0->index() });
+    QCOMPARE(graph.nodeSpatialIndex().keysInRect({ 500, 0, 1000, 200 }), std::vector<int> { node1->index() });
+    QCOMPARE(graph.nodeSpatialIndex().keysInRect({ -1000, -1000, 3000, 2000 }).size(), static_cast<size_t>(2));
+    QVERIFY(graph.nodeSpatialIndex().isFree({ 20, 20, 100, 100 }));
+    QVERIFY(graph.nodeSpatialIndex().isFree({ -1, -1, 2, 2 }, node0->index()));
+
+    node1->setLocation({ 0, 0 });
+    QVERIFY(graph.nodeSpatialIndex().isFree({ 500, 0, 1000, 200 }));
+    QCOMPARE(graph.nodeSpatialIndex().keysInRect({ -1, -1, 2, 2 }).size(), static_cast<size_t>(2));
+
+    graph.deleteNode(node1->index());
+    QCOMPARE(graph.nodeSpatialIndex().keysInRect({ -1, -1, 2, 2 }), std::vector<int> { node0->index() });
+    QCOMPARE(graph.nodeSpatialIndex().size(), static_cast<size_t>(1));
+}
+
+void GraphTest::testNodeSpatialIndexMatchesBruteForce()
+{
+    NodeSpatialIndex dut { 50 };
+    std::map<int, QRectF> rects;
+    std::mt19937 engine;
+    std::uniform_real_distribution<double> position { -500, 500 };
+    std::uniform_real_distribution<double> extent { 1, 200 };
+    std::uniform_int_distribution<int> keys { 0, 39 };
+    const auto randomRect = [&] {
+        return QRectF { position(engine), position(engine), extent(engine), extent(engine) };
+    };
+
+    for (int round = 0; round < 1000; round++) {
+        const auto key = keys(engine);
+        if (engine() % 4) {
+            const auto rect = randomRect();
+            dut.setRect(key, rect);
+            rects[key] = rect;
+        } else {
+            dut.remove(key);
+            rects.erase(key);
+        }
+        QCOMPARE(dut.size(), rects.size());
+
+        // Some queries cover the whole area, which scans the rects instead of the cells
+        const auto query = round % 10 ? randomRect() : QRectF { -1000, -1000, 2000, 2000 };
+        std::vector<int> expected;
+        for (auto && [expectedKey, rect] : rects) {
+            if (rect.intersects(query)) {
+                expected.push_back(expectedKey);
+            }
+        }
+        auto actual = dut.keysInRect(query);
+        std::sort(actual.begin(), actual.end());
+        QCOMPARE(actual, expected);
+
+        const auto ignoredKey = keys(engine);
+        QCOMPARE(dut.isFree(query, ignoredKey), std::all_of(expected.begin(), expected.end(), [ignoredKey](int expectedKey) {
+                     return expectedKey == ignoredKey;
+                 }));
+    }
+}
+
+void GraphTest::testNodeSpatialIndexNearestInDirection()
+{
+    NodeSpatialIndex dut { 10 };
+    const auto any = [](int) {
+        return true;
+    };
+    QCOMPARE(dut.nearestInDirection({ 0, 0 }, { 1, 0 }, any), -1);
+
+    dut.setRect(0, { -1, -1, 2, 2 });
+    dut.setRect(1, { 19, -1, 2, 2 });
+    dut.setRect(2, { 9, 14, 2, 2 });
+    // Far away beyond many empty cells
+    dut.setRect(3, { 999, -1, 2, 2 });
+
+    QCOMPARE(dut.nearestInDirection({ 0, 0 }, { 1, 0 }, any), 1);
+    QCOMPARE(dut.nearestInDirection({ 0, 0 }, { 0, 1 }, any), 2);
+    QCOMPARE(dut.nearestInDirection({ 0, 0 }, { -1, 0 }, any), -1);
+    QCOMPARE(dut.nearestInDirection({ 20, 0 }, { 1, 0 }, any), 3);
+    QCOMPARE(dut.nearestInDirection({ 0, 0 }, { 1, 0 }, [](int key) {
+        return key != 1;
+    }),
+             3);
+}
+
+void GraphTest::testPlacementChangeCallbackCoversEdges()
+{
+    Graph graph;
+    QRectF dirtyRect;
+    graph.setPlacementChangeCallback([&dirtyRect](const QRectF & sceneRect) {
+        dirtyRect = sceneRect;
+    });
+
+    const auto node0 = make_shared<Node>();
+    node0->setSize({ 10, 10 });
+    graph.addNode(node0);
+    QCOMPARE(dirtyRect, graph.nodeSpatialIndex().rect(node0->index()));
+
+    const auto node1 = make_shared<Node>();
+    node1->setSize({ 10, 10 });
+    node1->setLocation({ 1000, 0 });
+    graph.addNode(node1);
+    graph.addEdge(make_shared<Edge>(node0, node1));
+    const auto edgeRect = graph.nodeSpatialIndex().rect(node0->index()).united(graph.nodeSpatialIndex().rect(node1->index()));
+    QCOMPARE(dirtyRect, edgeRect);
+
+    // The old place of the node and the edge to the neighbor get dirty
+    const auto previousRect = graph.nodeSpatialIndex().rect(node1->index());
+    node1->setLocation({ 0, 1000 });
+    QVERIFY(dirtyRect.contains(previousRect));
+    QVERIFY(dirtyRect.contains(graph.nodeSpatialIndex().rect(node1->index())));
+    QVERIFY(dirtyRect.contains(graph.nodeSpatialIndex().rect(node0->index())));
+
+    dirtyRect = {};
+    graph.clear();
+    QVERIFY(dirtyRect.isNull());
+}
+
+void GraphTest::testChangeNotifierFollowsChanges()
+{
+    Graph graph;
+    std::vector<GraphChangeBatch> batches;
+    graph.changeNotifier().subscribe([&batches](const GraphChangeBatch & changes) {
+        batches.push_back(changes);
+    });
+
+    const auto node0 = make_shared<Node>();
+    graph.addNode(node0);
+    const auto node1 = make_shared<Node>();
+    graph.addNode(node1);
+    const auto edge = make_shared<Edge>(node0, node1);
+    graph.addEdge(edge);
+    QCOMPARE(batches.size(), static_cast<size_t>(3));
+    QCOMPARE(batches.at(0), GraphChangeBatch({ { GraphChange::Type::NodeAdded, node0->index() } }));
+    QCOMPARE(batches.at(2), GraphChangeBatch({ { GraphChange::Type::EdgeAdded, -1, node0->index(), node1->index() } }));
+
+    batches.clear();
+    node0->setLocation({ 100, 100 });
+    node0->setColor(Qt::red);
+    node0->setColor(Qt::red);
+    edge->setDashedLine(true);
+    QCOMPARE(batches.size(), static_cast<size_t>(3));
+    QCOMPARE(batches.at(0), GraphChangeBatch({ { GraphChange::Type::NodeMoved, node0->index() } }));
+    QCOMPARE(batches.at(1), GraphChangeBatch({ { GraphChange::Type::NodeRestyled, node0->index() } }));
+    QCOMPARE(batches.at(2), GraphChangeBatch({ { GraphChange::Type::EdgeRestyled, -1, node0->index(), node1->index() } }));
+
+    // The edges of a deleted node are removed first
+    batches.clear();
+    graph.deleteNode(node1->index());
+    QCOMPARE(batches.size(), static_cast<size_t>(2));
+    QCOMPARE(batches.at(0), GraphChangeBatch({ { GraphChange::Type::EdgeRemoved, -1, node0->index(), node1->index() } }));
+    QCOMPARE(batches.at(1), GraphChangeBatch({ { GraphChange::Type::NodeRemoved, node1->index() } }));
+
+    // The deleted items are not followed anymore
+    batches.clear();
+    node1->setColor(Qt::blue);
+    edge->setReversed(true);
+    graph.clear();
+    QVERIFY(batches.empty());
+}
+
+void GraphTest::testChangeNotifierBatchesChanges()
+{
+    Graph graph;
+    std::vector<GraphChangeBatch> batches;
+    const auto id = graph.changeNotifier().subscribe([&batches](const GraphChangeBatch & changes) {
+        batches.push_back(changes);
+    });
+
+    const auto node0 = make_shared<Node>();
+    graph.addNode(node0);
+    batches.clear();
+
+    const auto node1 = make_shared<Node>();
+    {
+        const GraphChangeNotifier::Batch batch { graph.changeNotifier() };
+        node0->setLocation({ 100, 100 });
+        {
+            const GraphChangeNotifier::Batch nestedBatch { graph.changeNotifier() };
+            node0->setText("Foo");
+            node0->setLocation({ 200, 200 });
+            graph.addNode(node1);
+        }
+        node0->setText("Bar");
+        QVERIFY(batches.empty());
+    }
+
+    // Repeated changes of the same node are delivered once in the order of the first change
+    QCOMPARE(batches.size(), static_cast<size_t>(1));
+    const GraphChangeBatch expected = {
+        { GraphChange::Type::NodeMoved, node0->index() },
+        { GraphChange::Type::NodeTexted, node0->index() },
+        { GraphChange::Type::NodeAdded, node1->index() }
+    };
+    QCOMPARE(batches.at(0), expected);
+
+    batches.clear();
+    graph.changeNotifier().unsubscribe(id);
+    QVERIFY(!graph.changeNotifier().hasSubscribers());
+    node0->setLocation({ 300, 300 });
+    QVERIFY(batches.empty());
+}
+
+void GraphTest::testMemoryUsage()
+{
+    Graph graph;
+    QCOMPARE(graph.memoryUsage().itemCount, static_cast<size_t>(0));
+    QCOMPARE(graph.memoryUsage().bytes, static_cast<size_t>(0));
+
+    const auto node0 = make_shared<Node>();
+    graph.addNode(node0);
+
+    const auto node1 = make_shared<Node>();
+    graph.addNode(node1);
+
+    graph.addEdge(make_shared<Edge>(node0, node1));
+    QCOMPARE(graph.memoryUsage().itemCount, static_cast<size_t>(3));
+
+    // Longer texts take more memory
+    const auto bytes = graph.memoryUsage().bytes;
+    node0->setText("Lorem ipsum dolor sit amet");
+    QVERIFY(graph.memoryUsage().bytes > bytes);
+
+    graph.deleteNode(node0->index());
+    QCOMPARE(graph.memoryUsage().itemCount, static_cast<size_t>(1));
+    QCOMPARE(graph.deletedMemoryUsage().itemCount, static_cast<size_t>(2));
+}
+
+void GraphTest::testReleaseItems()
+{
+    Graph dut;
+
+    const auto node0 = make_shared<Node>();
+    dut.addNode(node0);
+
+    const auto node1 = make_shared<Node>();
+    dut.addNode(node1);
+
+    const auto node2 = make_shared<Node>();
+    dut.addNode(node2);
+
+    const auto edge01 = make_shared<Edge>(node0, node1);
+    dut.addEdge(edge01);
+    dut.addEdge(make_shared<Edge>(node1, node2));
+    dut.deleteNode(node2->index());
+
+    const auto items = dut.releaseItems();
+
+    // The soft-deleted items are released, too
+    QCOMPARE(items.nodes.size(), static_cast<size_t>(3));
+    QCOMPARE(items.edges.size(), static_cast<size_t>(2));
+    QVERIFY(std::find(items.edges.begin(), items.edges.end(), edge01) != items.edges.end());
+
+    QCOMPARE(dut.nodeCount(), static_cast<size_t>(0));
+    QCOMPARE(dut.edgeCount(), static_cast<size_t>(0));
+    QCOMPARE(dut.deletedNodeCount(), static_cast<size_t>(0));
+    QCOMPARE(dut.deletedEdgeCount(), static_cast<size_t>(0));
+
+    // Only the caller keeps the items alive
+    QCOMPARE(edge01.use_count(), 2L);
+
+    // The released items don't reach the indices of the graph anymore
+    QCOMPARE(dut.nodeSpatialIndex().size(), static_cast<size_t>(0));
+    node0->setText("Foo");
+    node0->setLocation({ 100, 100 });
+    edge01->setText("Bar");
+    QVERIFY(dut.searchNodesByText("Foo").empty());
+    QVERIFY(dut.searchEdgesByText("Bar").empty());
+    QCOMPARE(dut.nodeSpatialIndex().size(), static_cast<size_t>(0));
+}
+
+void GraphTest::testDeleteItems_ShouldKeepOtherLengthConnections()
+{
+    Graph dut;
+
+    const auto node0 = make_shared<Node>();
+    dut.addNode(node0);
+
+    const auto node1 = make_shared<Node>();
+    node1->setLocation({ 500, 0 });
+    dut.addNode(node1);
+
+    const auto edge01 = make_shared<Edge>(node0, node1);
+    dut.addEdge(edge01);
+    edge01->updateLine();
+
+    const QSignalSpy lengthSpy { edge01.get(), &Edge::lengthChanged };
+    dut.deleteEdge(node0->index(), node1->index());
+
+    // Only the connection of the graph is gone
+    node1->setLocation({ 1000, 0 });
+    edge01->updateLine();
+    QCOMPARE(lengthSpy.count(), 1);
+}
+
+void GraphTest::testDeleteItems_ShouldKeepOtherPlacementConnections()
+{
+    Graph dut;
+
+    const auto node0 = make_shared<Node>();
+    dut.addNode(node0);
+
+    // E.g. a hover overlay follows the node
+    const QSignalSpy placementSpy { node0.get(), &Node::placementChanged };
+    dut.deleteNode(node0->index());
+
+    node0->setLocation({ 100, 100 });
+    QCOMPARE(placementSpy.count(), 1);
+    QVERIFY(dut.nodeSpatialIndex().keysInRect({ 50, 50, 100, 100 }).empty());
+
+    // Restoring the node connects the graph again without touching the others
+    dut.addNode(node0);
+    node0->setLocation({ 200, 200 });
+    QCOMPARE(placementSpy.count(), 2);
+    QCOMPARE(dut.nodeSpatialIndex().keysInRect({ 150, 150, 100, 100 }), std::vector<int> { node0->index() });
+}
+
+void GraphTest::testDeleteItems_ShouldKeepOtherStyleConnections()
+{
+    Graph dut;
+
+    const auto node0 = make_shared<Node>();
+    dut.addNode(node0);
+
+    const auto node1 = make_shared<Node>();
+    dut.addNode(node1);
+
+    const auto edge01 = make_shared<Edge>(node0, node1);
+    dut.addEdge(edge01);
+
+    const QSignalSpy nodeStyleSpy { node0.get(), &Node::styleChanged };
+    const QSignalSpy edgeStyleSpy { edge01.get(), &Edge::styleChanged };
+    dut.deleteNode(node0->index());
+
+    // Only the connections of the graph are gone
+    node0->setCollapsed(true);
+    edge01->setDashedLine(true);
+    QCOMPARE(nodeStyleSpy.count(), 1);
+    QCOMPARE(edgeStyleSpy.count(), 1);
+}
+
+void GraphTest::testDeleteItems_ShouldKeepOtherTextConnections()
+{
+    Graph dut;
+
+    const auto node0 = make_shared<Node>();
+    dut.addNode(node0);
+
+    const auto node1 = make_shared<Node>();
+    dut.addNode(node1);
+
+    const auto edge01 = make_shared<Edge>(node0, node1);
+    dut.addEdge(edge01);
+
+    const QSignalSpy nodeTextSpy { node0.get(), &Node::textChanged };
+    const QSignalSpy edgeTextSpy { edge01.get(), &Edge::textChanged };
+    dut.deleteNode(node0->index());
+
+    // Only the connections of the graph are gone
+    node0->setText("Foo");
+    edge01->setText("Bar");
+    QCOMPARE(nodeTextSpy.count(), 1);
+    QCOMPARE(edgeTextSpy.count(), 1);
+    QVERIFY(dut.searchNodesByText("Foo").empty());
+    QVERIFY(dut.searchEdgesByText("Bar").empty());
+}
+
 QTEST_GUILESS_MAIN(GraphTest)
@@ -33,8 +33,14 @@ private slots:
 
     void testAddNode();
 
+    void testAddNode_InvalidIndex();
+
     void testAddTwoNodes();
 
+    void testAddNodesAndEdges();
+
+    void testAdvanceEpochReclaimsDeletedItems();
+
     void testAreNodesDirectlyConnected();
 
     void testDeleteEdge();
@@ -43,15 +49,67 @@ private slots:
 
     void testDeleteNodeInvolvingEdge();
 
+    void testDegree();
+
+    void testDescendantIndices();
+
+    void testTraverse();
+
     void testGetEdges();
 
     void testGetNodes();
 
+    void testNodeAndEdgeRanges();
+
     void testGetNodesConnectedToNode();
 
     void testGetNodeByIndex();
 
     void testGetNodeByIndex_NotFound();
+
+    void testGraphSnapshot();
+
+    void testGraphSnapshotDelta();
+
+    void testGraphSnapshotCompression();
+
+    void testGraphSnapshotDensified();
+
+    void testGraphSnapshotNodeIndexSet();
+
+    void testSearchByText();
+
+    void testSearchByTextFollowsChanges();
+
+    void testEdgeLengthStats();
+
+    void testEdgeLengthStatsFollowsEdges();
+
+    void testNodePlacementStatsFollowsNodes();
+
+    void testNodeSpatialIndexFollowsNodes();
+
+    void testNodeSpatialIndexMatchesBruteForce();
+
+    void testNodeSpatialIndexNearestInDirection();
+
+    void testPlacementChangeCallbackCoversEdges();
+
+    void testChangeNotifierFollowsChanges();
+
+    void testChangeNotifierBatchesChanges();
+
+    void testMemoryUsage();
+
+    void testReleaseItems();
+
+    void testDeleteItems_ShouldKeepOtherLengthConnections();
+
+    void testDeleteItems_ShouldKeepOtherPlacementConnections();
+
+    void testDeleteItems_ShouldKeepOtherStyleConnections();
+
+    void testDeleteItems_ShouldKeepOtherTextConnections();
 };
 
 #endif // GRAPH_TEST_HPP
@@ -0,0 +1,108 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "gui_job_scheduler_test.hpp"
+
+#include "../../application/gui_job_scheduler.hpp"
+#include "../../common/test_mode.hpp"
+
+#include <QTimer>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+GuiJobSchedulerTest::GuiJobSchedulerTest()
+{
+    TestMode::setEnabled(true);
+}
+
+void GuiJobSchedulerTest::testJobsRunInOrder()
+{
+    GuiJobScheduler dut { std::chrono::milliseconds { 10 } };
+    std::vector<int> steps;
+    int firstCount = 0;
+    int secondCount = 0;
+    const auto first = dut.schedule([&] {
+        steps.push_back(1);
+        return ++firstCount == 3;
+    });
+    const auto second = dut.schedule([&] {
+        steps.push_back(2);
+        return ++secondCount == 2;
+    });
+    QVERIFY(first != second);
+    QCOMPARE(dut.jobCount(), size_t(2));
+
+    QTRY_COMPARE(dut.jobCount(), size_t(0));
+    QCOMPARE(steps, std::vector<int>({ 1, 1, 1, 2, 2 }));
+    QVERIFY(!dut.isScheduled(first));
+    QVERIFY(!dut.isScheduled(second));
+}
+
+void GuiJobSchedulerTest::testCancelFromStep()
+{
+    GuiJobScheduler dut { std::chrono::milliseconds { 10 } };
+    GuiJobScheduler::JobId id = 0;
+    int count = 0;
+    id = dut.schedule([&] {
+        if (++count == 2) {
+            dut.cancel(id);
+        }
+        return false;
+    });
+
+    QTRY_COMPARE(dut.jobCount(), size_t(0));
+    QCOMPARE(count, 2);
+}
+
+void GuiJobSchedulerTest::testFinish()
+{
+    GuiJobScheduler dut { std::chrono::milliseconds { 10 } };
+    int count = 0;
+    const auto id = dut.schedule([&] {
+        return ++count == 100;
+    });
+
+    dut.finish(id);
+    QCOMPARE(count, 100);
+    QVERIFY(!dut.isScheduled(id));
+    QCOMPARE(dut.jobCount(), size_t(0));
+}
+
+void GuiJobSchedulerTest::testSliceYieldsToEventLoop()
+{
+    GuiJobScheduler dut { std::chrono::milliseconds { 5 } };
+    int count = 0;
+    dut.schedule([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds { 1 });
+        return ++count == 100;
+    });
+
+    // Another event gets handled long before the job is done
+    bool isTimerHandled = false;
+    int countAtTimer = 0;
+    QTimer::singleShot(0, [&] {
+        isTimerHandled = true;
+        countAtTimer = count;
+    });
+
+    QTRY_VERIFY(isTimerHandled);
+    QVERIFY(countAtTimer < 100);
+    QTRY_COMPARE(dut.jobCount(), size_t(0));
+    QCOMPARE(count, 100);
+}
+
+QTEST_GUILESS_MAIN(GuiJobSchedulerTest)
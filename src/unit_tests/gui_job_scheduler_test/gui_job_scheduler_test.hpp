@@ -0,0 +1,41 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef GUI_JOB_SCHEDULER_TEST_HPP
+#define GUI_JOB_SCHEDULER_TEST_HPP
+
+#include <QTest>
+
+#include "../unit_test_base.hpp"
+
+class GuiJobSchedulerTest : public UnitTestBase
+{
+    Q_OBJECT
+
+public:
+    GuiJobSchedulerTest();
+
+private slots:
+
+    void testJobsRunInOrder();
+
+    void testCancelFromStep();
+
+    void testFinish();
+
+    void testSliceYieldsToEventLoop();
+};
+
+#endif // GUI_JOB_SCHEDULER_TEST_HPP
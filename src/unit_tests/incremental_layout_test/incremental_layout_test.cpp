@@ -0,0 +1,107 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "incremental_layout_test.hpp"
+
+#include "../../domain/incremental_layout.hpp"
+#include "../../domain/node_spatial_index.hpp"
+
+#include <cmath>
+#include <random>
+
+void IncrementalLayoutTest::testFindFreeOffset_freeRect_shouldNotMove()
+{
+    NodeSpatialIndex index { 50 };
+    index.setRect(0, { 0, 0, 100, 50 });
+    const IncrementalLayout layout { index, 10, 10 };
+
+    QCOMPARE(layout.findFreeOffset({ 200, 0, 100, 50 }), QPointF {});
+
+    // Closer than the spacing isn't free
+    QVERIFY(layout.findFreeOffset({ 105, 0, 100, 50 }) != QPointF {});
+}
+
+void IncrementalLayoutTest::testFindFreeOffset_ignoredKey_shouldNotBlock()
+{
+    NodeSpatialIndex index { 50 };
+    index.setRect(0, { 0, 0, 100, 50 });
+    index.setRect(1, { 200, 0, 100, 50 });
+    const IncrementalLayout layout { index, 10, 10 };
+
+    // The placed node has been indexed already
+    QVERIFY(layout.findFreeOffset(index.rect(1)) != QPointF {});
+    QCOMPARE(layout.findFreeOffset(index.rect(1), {}, 1), QPointF {});
+}
+
+void IncrementalLayoutTest::testFindFreeOffset_nearParent_shouldNotMoveAway()
+{
+    // A sibling blocks the node. Moving right is the shortest way out, but the parent is on the left.
+    NodeSpatialIndex index { 50 };
+    index.setRect(0, { 0, -25, 100, 50 });
+    const IncrementalLayout layout { index, 10, 0 };
+
+    const QRectF rect { 70, -15, 100, 50 };
+    QCOMPARE(layout.findFreeOffset(rect), QPointF(30, 0));
+
+    const auto offset = layout.findFreeOffset(rect, QPointF { -1000, 10 });
+    QVERIFY(index.isFree(rect.translated(offset)));
+    QVERIFY(offset.x() <= 0);
+    QCOMPARE(offset.y(), 40.0);
+}
+
+void IncrementalLayoutTest::testFindFreeOffset_randomNodes_shouldFindNearestFreeLocation()
+{
+    const double step = 10;
+    const double spacing = 5;
+    NodeSpatialIndex index { 100 };
+    std::mt19937 engine;
+    std::uniform_real_distribution<double> locationDist { -1000, 1000 };
+    for (int key = 0; key < 100; key++) {
+        index.setRect(key, { locationDist(engine), locationDist(engine), 100, 50 });
+    }
+    const IncrementalLayout layout { index, step, spacing };
+
+    const auto isFree = [&](const QRectF & rect) {
+        return index.isFree(rect.adjusted(-spacing, -spacing, spacing, spacing));
+    };
+
+    for (int i = 0; i < 100; i++) {
+        const QRectF rect { locationDist(engine), locationDist(engine), 100, 50 };
+        const auto offset = layout.findFreeOffset(rect);
+        if (isFree(rect)) {
+            QCOMPARE(offset, QPointF {});
+            continue;
+        }
+
+        QVERIFY(offset != QPointF {});
+        QVERIFY(isFree(rect.translated(offset)));
+        QCOMPARE(std::fmod(offset.x(), step), 0.0);
+        QCOMPARE(std::fmod(offset.y(), step), 0.0);
+
+        // No location on the step grid closer than the chosen one is free
+        const auto distance = std::hypot(offset.x(), offset.y());
+        const int range = static_cast<int>(distance / step);
+        for (int row = -range; row <= range; row++) {
+            for (int column = -range; column <= range; column++) {
+                const QPointF closer { column * step, row * step };
+                if (std::hypot(closer.x(), closer.y()) < distance) {
+                    QVERIFY(!isFree(rect.translated(closer)));
+                }
+            }
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(IncrementalLayoutTest)
@@ -16,15 +16,22 @@
 #include "layout_optimizer_test.hpp"
 
 #include "../../domain/mind_map_data.hpp"
+#include "../../common/constants.hpp"
 #include "../../common/test_mode.hpp"
 #include "../../domain/graph.hpp"
+#include "../../domain/layout_cache.hpp"
+#include "../../domain/layout_cost_kernel.hpp"
 #include "../../domain/layout_optimizer.hpp"
 #include "../../view/grid.hpp"
 
 #include "simple_logger.hpp"
 
+#include <chrono>
+#include <cmath>
 #include <memory>
 #include <random>
+#include <set>
+#include <utility>
 #include <vector>
 
 using SceneItems::Edge;
@@ -144,4 +151,832 @@ void LayoutOptimizerTest::testMultipleNodes_ShouldReduceCost()
     }
 }
 
+void LayoutOptimizerTest::testMultipleNodes_ParallelTempering_ShouldReduceCost()
+{
+    auto data = std::make_shared<MindMapData>();
+    const size_t nodeCount = 50;
+    std::uniform_real_distribution<double> xDist { -1000, 1000 };
+    std::uniform_real_distribution<double> yDist { -1000, 1000 };
+    std::mt19937 engine;
+    std::vector<NodeS> nodes;
+    for (size_t i = 0; i < nodeCount; i++) {
+        auto node = std::make_shared<Node>();
+        data->graph().addNode(node);
+        node->setPos({ xDist(engine), yDist(engine) });
+        nodes.push_back(node);
+    }
+    std::uniform_int_distribution<size_t> iDist { 0, nodes.size() - 1 };
+    for (auto && node : nodes) {
+        const auto otherNode = data->graph().getNode(static_cast<int>(iDist(engine)));
+        data->graph().addEdge(std::make_shared<Edge>(node, otherNode));
+    }
+
+    Grid grid;
+    grid.setSize(10);
+    LayoutOptimizer lol { data, grid };
+    lol.setReplicaCount(4);
+    QVERIFY(lol.initialize(1.0, 50));
+    double progress = 0;
+    lol.setProgressCallback([&](double progress_) {
+        progress = progress_;
+    });
+    const auto optimizationInfo = lol.optimize();
+    QCOMPARE(progress, 1.0);
+    QCOMPARE(optimizationInfo.replicas, static_cast<size_t>(4));
+    QVERIFY(optimizationInfo.changes > 100);
+    const double gain = (optimizationInfo.finalCost - optimizationInfo.initialCost) / optimizationInfo.initialCost;
+    juzzlin::L(TAG).info() << "Final cost: " << optimizationInfo.finalCost << " (" << gain * 100 << "%), swaps: " << optimizationInfo.swaps;
+    QVERIFY(gain < -0.25);
+
+    lol.extract();
+    for (auto && node : nodes) {
+        QCOMPARE(node->pos().x(), static_cast<double>(static_cast<int>(node->pos().x() / grid.size()) * grid.size()));
+        QCOMPARE(node->pos().y(), static_cast<double>(static_cast<int>(node->pos().y() / grid.size()) * grid.size()));
+    }
+}
+
+void LayoutOptimizerTest::testMultipleNodes_ModifiedLam_ShouldReduceCost()
+{
+    auto data = std::make_shared<MindMapData>();
+    const size_t nodeCount = 50;
+    std::uniform_real_distribution<double> xDist { -1000, 1000 };
+    std::uniform_real_distribution<double> yDist { -1000, 1000 };
+    std::mt19937 engine;
+    std::vector<NodeS> nodes;
+    for (size_t i = 0; i < nodeCount; i++) {
+        auto node = std::make_shared<Node>();
+        data->graph().addNode(node);
+        node->setPos({ xDist(engine), yDist(engine) });
+        if (!nodes.empty()) {
+            std::uniform_int_distribution<size_t> parentDist { 0, nodes.size() - 1 };
+            data->graph().addEdge(std::make_shared<Edge>(nodes.at(parentDist(engine)), node));
+        }
+        nodes.push_back(node);
+    }
+
+    Grid grid;
+    grid.setSize(10);
+    LayoutOptimizer lol { data, grid };
+    lol.setSchedule(LayoutOptimizer::Schedule::ModifiedLam);
+    QVERIFY(lol.initialize(1.0, 50));
+    double progress = 0;
+    lol.setProgressCallback([&](double progress_) {
+        progress = progress_;
+    });
+    const auto optimizationInfo = lol.optimize();
+    QCOMPARE(progress, 1.0);
+    QVERIFY(optimizationInfo.changes > 100);
+    const double gain = (optimizationInfo.finalCost - optimizationInfo.initialCost) / optimizationInfo.initialCost;
+    juzzlin::L(TAG).info() << "Final cost: " << optimizationInfo.finalCost << " (" << gain * 100 << "%), moves: " << optimizationInfo.changes;
+    QVERIFY(gain < -0.25);
+
+    lol.extract();
+    for (auto && node : nodes) {
+        QCOMPARE(node->location(), grid.snapToGrid(node->location()));
+    }
+}
+
+static size_t countCrossings(const std::vector<std::pair<NodeS, NodeS>> & edges)
+{
+    const auto orientation = [](QPointF p, QPointF q, QPointF r) {
+        return (q.x() - p.x()) * (r.y() - p.y()) - (q.y() - p.y()) * (r.x() - p.x());
+    };
+    size_t count = 0;
+    for (size_t i = 0; i < edges.size(); i++) {
+        for (auto j = i + 1; j < edges.size(); j++) {
+            const auto [a, b] = edges.at(i);
+            const auto [c, d] = edges.at(j);
+            if (a != c && a != d && b != c && b != d
+                && orientation(a->location(), b->location(), c->location()) * orientation(a->location(), b->location(), d->location()) < 0
+                && orientation(c->location(), d->location(), a->location()) * orientation(c->location(), d->location(), b->location()) < 0) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+void LayoutOptimizerTest::testMultipleNodes_CrossingPenalty_ShouldReduceCrossings()
+{
+    auto data = std::make_shared<MindMapData>();
+    const size_t nodeCount = 50;
+    std::uniform_real_distribution<double> xDist { -1000, 1000 };
+    std::uniform_real_distribution<double> yDist { -1000, 1000 };
+    std::mt19937 engine;
+    std::vector<NodeS> nodes;
+    std::vector<std::pair<NodeS, NodeS>> edges;
+    for (size_t i = 0; i < nodeCount; i++) {
+        auto node = std::make_shared<Node>();
+        data->graph().addNode(node);
+        // countCrossings() uses the locations, which setPos() doesn't change
+        node->setLocation({ xDist(engine), yDist(engine) });
+        if (!nodes.empty()) {
+            std::uniform_int_distribution<size_t> parentDist { 0, nodes.size() - 1 };
+            edges.emplace_back(nodes.at(parentDist(engine)), node);
+            data->graph().addEdge(std::make_shared<Edge>(edges.back().first, node));
+        }
+        nodes.push_back(node);
+    }
+
+    const auto initialCrossings = countCrossings(edges);
+    QVERIFY(initialCrossings > 0);
+    Grid grid;
+    LayoutOptimizer lol { data, grid };
+    lol.setCrossingPenalty(Constants::LayoutOptimizer::crossingPenalty());
+    QVERIFY(lol.initialize(1.0, 50));
+    const auto optimizationInfo = lol.optimize();
+    QVERIFY(optimizationInfo.finalCost < optimizationInfo.initialCost);
+
+    lol.extract();
+    const auto finalCrossings = countCrossings(edges);
+    juzzlin::L(TAG).info() << "Crossings: " << initialCrossings << " -> " << finalCrossings;
+    QVERIFY(finalCrossings < initialCrossings / 4);
+}
+
+void LayoutOptimizerTest::testMultipleNodes_HighDegreeHub_ShouldReduceCost()
+{
+    auto data = std::make_shared<MindMapData>();
+    const size_t nodeCount = 100;
+    std::uniform_real_distribution<double> xDist { -1000, 1000 };
+    std::uniform_real_distribution<double> yDist { -1000, 1000 };
+    std::mt19937 engine;
+    std::vector<NodeS> nodes;
+    for (size_t i = 0; i < nodeCount; i++) {
+        auto node = std::make_shared<Node>();
+        data->graph().addNode(node);
+        node->setLocation({ xDist(engine), yDist(engine) });
+        nodes.push_back(node);
+    }
+    for (size_t i = 1; i < nodes.size(); i++) {
+        data->graph().addEdge(std::make_shared<Edge>(nodes.at(0), nodes.at(i)));
+    }
+
+    Grid grid;
+    grid.setSize(10);
+    LayoutOptimizer lol { data, grid };
+    QVERIFY(lol.initialize(1.0, 50));
+    const auto optimizationInfo = lol.optimize();
+    QVERIFY(optimizationInfo.changes > 100);
+    QVERIFY(optimizationInfo.finalCost >= 0);
+    const double gain = (optimizationInfo.finalCost - optimizationInfo.initialCost) / optimizationInfo.initialCost;
+    juzzlin::L(TAG).info() << "Final cost: " << optimizationInfo.finalCost << " (" << gain * 100 << "%)";
+    QVERIFY(gain < -0.25);
+}
+
+void LayoutOptimizerTest::testMultipleNodes_Multilevel_ShouldReduceCost()
+{
+    auto data = std::make_shared<MindMapData>();
+    const size_t nodeCount = 600;
+    std::uniform_real_distribution<double> xDist { -1000, 1000 };
+    std::uniform_real_distribution<double> yDist { -1000, 1000 };
+    std::mt19937 engine;
+    std::vector<NodeS> nodes;
+    for (size_t i = 0; i < nodeCount; i++) {
+        auto node = std::make_shared<Node>();
+        data->graph().addNode(node);
+        node->setPos({ xDist(engine), yDist(engine) });
+        if (!nodes.empty()) {
+            std::uniform_int_distribution<size_t> parentDist { 0, nodes.size() - 1 };
+            data->graph().addEdge(std::make_shared<Edge>(nodes.at(parentDist(engine)), node));
+        }
+        nodes.push_back(node);
+    }
+
+    Grid grid;
+    grid.setSize(10);
+    LayoutOptimizer lol { data, grid };
+    lol.setMultilevelThreshold(nodeCount);
+    QVERIFY(lol.initialize(1.0, 50));
+    double progress = 0;
+    lol.setProgressCallback([&](double progress_) {
+        QVERIFY(progress_ >= progress);
+        progress = progress_;
+    });
+    const auto optimizationInfo = lol.optimize();
+    QCOMPARE(progress, 1.0);
+    QVERIFY(optimizationInfo.levels > 1);
+    QVERIFY(optimizationInfo.changes > 100);
+    QVERIFY(optimizationInfo.finalCost < optimizationInfo.initialCost);
+    juzzlin::L(TAG).info() << "Final cost: " << optimizationInfo.finalCost << ", levels: " << optimizationInfo.levels;
+
+    lol.extract();
+    std::set<std::pair<double, double>> locations;
+    for (auto && node : nodes) {
+        locations.insert({ node->location().x(), node->location().y() });
+    }
+    QCOMPARE(locations.size(), nodes.size());
+}
+
+void LayoutOptimizerTest::testMultipleNodes_Subgraph_ShouldMoveOnlySubgraph()
+{
+    auto data = std::make_shared<MindMapData>();
+    const size_t nodeCount = 200;
+    std::uniform_real_distribution<double> xDist { -1000, 1000 };
+    std::uniform_real_distribution<double> yDist { -1000, 1000 };
+    std::mt19937 engine;
+    std::vector<NodeS> nodes;
+    for (size_t i = 0; i < nodeCount; i++) {
+        auto node = std::make_shared<Node>();
+        data->graph().addNode(node);
+        node->setLocation({ xDist(engine), yDist(engine) });
+        if (!nodes.empty()) {
+            std::uniform_int_distribution<size_t> parentDist { 0, nodes.size() - 1 };
+            data->graph().addEdge(std::make_shared<Edge>(nodes.at(parentDist(engine)), node));
+        }
+        nodes.push_back(node);
+    }
+
+    // Select a few nodes, the subgraph also contains their direct neighbors
+    std::set<int> subgraph;
+    std::vector<int> selectedNodeIndices;
+    for (auto && selected : { nodes.at(0), nodes.at(10), nodes.at(20) }) {
+        selectedNodeIndices.push_back(selected->index());
+        subgraph.insert(selected->index());
+        for (auto && neighbor : data->graph().getNodesConnectedToNode(selected)) {
+            subgraph.insert(neighbor->index());
+        }
+    }
+
+    std::vector<QPointF> locations;
+    for (auto && node : nodes) {
+        locations.push_back(node->location());
+    }
+
+    Grid grid;
+    grid.setSize(10);
+    LayoutOptimizer lol { data, grid };
+    lol.setSubgraph(selectedNodeIndices, 1);
+    QVERIFY(lol.initialize(1.0, 50));
+    const auto optimizationInfo = lol.optimize();
+    QVERIFY(optimizationInfo.changes > 0);
+    QVERIFY(optimizationInfo.finalCost < optimizationInfo.initialCost);
+    // Only the subgraph is annealed
+    QVERIFY(optimizationInfo.sliceSize == subgraph.size() * 200);
+
+    lol.extract();
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (subgraph.count(nodes.at(i)->index())) {
+            QCOMPARE(nodes.at(i)->location(), grid.snapToGrid(nodes.at(i)->location()));
+        } else {
+            QCOMPARE(nodes.at(i)->location(), locations.at(i));
+        }
+    }
+}
+
+void LayoutOptimizerTest::testMultipleNodes_WarmStart_ShouldKeepLayoutAndConvergeFast()
+{
+    auto data = std::make_shared<MindMapData>();
+    const size_t nodeCount = 200;
+    std::uniform_real_distribution<double> xDist { -1000, 1000 };
+    std::uniform_real_distribution<double> yDist { -1000, 1000 };
+    std::mt19937 engine;
+    std::vector<NodeS> nodes;
+    for (size_t i = 0; i < nodeCount; i++) {
+        auto node = std::make_shared<Node>();
+        data->graph().addNode(node);
+        node->setPos({ xDist(engine), yDist(engine) });
+        if (!nodes.empty()) {
+            std::uniform_int_distribution<size_t> parentDist { 0, nodes.size() - 1 };
+            data->graph().addEdge(std::make_shared<Edge>(nodes.at(parentDist(engine)), node));
+        }
+        nodes.push_back(node);
+    }
+
+    Grid grid;
+    LayoutOptimizer lol { data, grid };
+    QVERIFY(lol.initialize(1.0, 50));
+    const auto coldInfo = lol.optimize();
+    lol.extract();
+
+    // Re-optimizing the optimized layout must not scramble it
+    lol.setWarmStart(true);
+    QVERIFY(lol.initialize(1.0, 50));
+    const auto warmInfo = lol.optimize();
+    juzzlin::L(TAG).info() << "Cold: " << coldInfo.finalCost << " " << coldInfo.changes << ", warm: " << warmInfo.initialCost << " " << warmInfo.finalCost << " " << warmInfo.changes;
+    QVERIFY(std::abs(warmInfo.initialCost - coldInfo.finalCost) < coldInfo.finalCost * 0.01);
+    QVERIFY(warmInfo.finalCost < coldInfo.finalCost * 1.01);
+    QVERIFY(warmInfo.t0 < coldInfo.t0);
+    QVERIFY(warmInfo.changes * 4 < coldInfo.changes);
+}
+
+void LayoutOptimizerTest::testMultipleNodes_LocalityPlacement_ShouldStartCheaperAndConvergeFast()
+{
+    const auto buildData = [] {
+        auto data = std::make_shared<MindMapData>();
+        std::uniform_real_distribution<double> xDist { -1000, 1000 };
+        std::uniform_real_distribution<double> yDist { -1000, 1000 };
+        std::mt19937 engine;
+        std::vector<NodeS> nodes;
+        for (size_t i = 0; i < 200; i++) {
+            auto node = std::make_shared<Node>();
+            data->graph().addNode(node);
+            node->setLocation({ xDist(engine), yDist(engine) });
+            if (!nodes.empty()) {
+                std::uniform_int_distribution<size_t> parentDist { 0, nodes.size() - 1 };
+                data->graph().addEdge(std::make_shared<Edge>(nodes.at(parentDist(engine)), node));
+            }
+            nodes.push_back(node);
+        }
+        return data;
+    };
+
+    Grid grid;
+    LayoutOptimizer current { buildData(), grid };
+    QVERIFY(current.initialize(1.0, 50));
+    const auto currentInfo = current.optimize();
+
+    LayoutOptimizer locality { buildData(), grid };
+    locality.setInitialPlacement(LayoutOptimizer::InitialPlacement::Locality);
+    QVERIFY(locality.initialize(1.0, 50));
+    const auto localityInfo = locality.optimize();
+    juzzlin::L(TAG).info() << "Current: " << currentInfo.initialCost << " " << currentInfo.finalCost << " " << currentInfo.changes
+                           << ", locality: " << localityInfo.initialCost << " " << localityInfo.finalCost << " " << localityInfo.changes;
+
+    // Scattered connected nodes start far apart, breadth-first neighbors along the curve don't
+    QVERIFY(localityInfo.initialCost < currentInfo.initialCost);
+    QVERIFY(localityInfo.t0 < currentInfo.t0);
+    QVERIFY(localityInfo.changes < currentInfo.changes);
+    QVERIFY(localityInfo.finalCost <= localityInfo.initialCost);
+}
+
+void LayoutOptimizerTest::testMultipleNodes_ForceDirected_ShouldRemoveOverlaps()
+{
+    auto data = std::make_shared<MindMapData>();
+    const size_t nodeCount = 300;
+    std::uniform_real_distribution<double> xDist { -1000, 1000 };
+    std::uniform_real_distribution<double> yDist { -1000, 1000 };
+    std::mt19937 engine;
+    std::vector<NodeS> nodes;
+    for (size_t i = 0; i < nodeCount; i++) {
+        auto node = std::make_shared<Node>();
+        data->graph().addNode(node);
+        node->setLocation({ xDist(engine), yDist(engine) });
+        if (!nodes.empty()) {
+            std::uniform_int_distribution<size_t> parentDist { 0, nodes.size() - 1 };
+            data->graph().addEdge(std::make_shared<Edge>(nodes.at(parentDist(engine)), node));
+        }
+        nodes.push_back(node);
+    }
+
+    Grid grid;
+    LayoutOptimizer lol { data, grid };
+    lol.setEngine(LayoutOptimizer::Engine::ForceDirected);
+    lol.setReplicaCount(4);
+    const double minEdgeLength = 50;
+    QVERIFY(lol.initialize(1.0, minEdgeLength));
+    const auto optimizationInfo = lol.optimize();
+    QVERIFY(optimizationInfo.changes > 0);
+    QVERIFY(optimizationInfo.finalCost < optimizationInfo.initialCost);
+    lol.extract();
+
+    // Nodes grown by half of the minimum edge length must not overlap
+    const auto margin = (minEdgeLength - 1) / 2;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        for (size_t j = i + 1; j < nodes.size(); j++) {
+            const auto rect0 = nodes.at(i)->placementBoundingRect().translated(nodes.at(i)->location()).adjusted(-margin, -margin, margin, margin);
+            const auto rect1 = nodes.at(j)->placementBoundingRect().translated(nodes.at(j)->location()).adjusted(-margin, -margin, margin, margin);
+            QVERIFY(!rect0.intersects(rect1));
+        }
+    }
+}
+
+static void testTreeEngine(LayoutOptimizer::Engine layoutEngine)
+{
+    auto data = std::make_shared<MindMapData>();
+    const size_t nodeCount = 300;
+    std::uniform_real_distribution<double> xDist { -1000, 1000 };
+    std::uniform_real_distribution<double> yDist { -1000, 1000 };
+    std::mt19937 engine;
+    std::vector<NodeS> nodes;
+    for (size_t i = 0; i < nodeCount; i++) {
+        auto node = std::make_shared<Node>();
+        data->graph().addNode(node);
+        node->setLocation({ xDist(engine), yDist(engine) });
+        if (!nodes.empty()) {
+            std::uniform_int_distribution<size_t> parentDist { 0, nodes.size() - 1 };
+            data->graph().addEdge(std::make_shared<Edge>(nodes.at(parentDist(engine)), node));
+        }
+        nodes.push_back(node);
+    }
+
+    // The sides of the root are kept in the left-right style
+    std::vector<std::pair<NodeS, bool>> rootChildren;
+    for (auto && child : data->graph().getNodesConnectedToNode(nodes.at(0))) {
+        rootChildren.push_back({ child, child->location().x() < nodes.at(0)->location().x() });
+    }
+
+    Grid grid;
+    LayoutOptimizer lol { data, grid };
+    lol.setEngine(layoutEngine);
+    QVERIFY(lol.initialize(1.0, 50));
+    double progress = 0;
+    lol.setProgressCallback([&](double progress_) {
+        progress = progress_;
+    });
+    const auto optimizationInfo = lol.optimize();
+    QCOMPARE(progress, 1.0);
+    QCOMPARE(optimizationInfo.changes, nodeCount);
+    QVERIFY(optimizationInfo.finalCost < optimizationInfo.initialCost);
+    lol.extract();
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        for (size_t j = i + 1; j < nodes.size(); j++) {
+            const auto rect0 = nodes.at(i)->placementBoundingRect().translated(nodes.at(i)->location());
+            const auto rect1 = nodes.at(j)->placementBoundingRect().translated(nodes.at(j)->location());
+            QVERIFY(!rect0.intersects(rect1));
+        }
+    }
+
+    if (layoutEngine == LayoutOptimizer::Engine::TidyTree) {
+        for (auto && [child, isOnLeft] : rootChildren) {
+            QCOMPARE(child->location().x() < nodes.at(0)->location().x(), isOnLeft);
+        }
+    }
+}
+
+void LayoutOptimizerTest::testMultipleNodes_TidyTree_ShouldRemoveOverlaps()
+{
+    testTreeEngine(LayoutOptimizer::Engine::TidyTree);
+}
+
+void LayoutOptimizerTest::testMultipleNodes_RadialTree_ShouldRemoveOverlaps()
+{
+    testTreeEngine(LayoutOptimizer::Engine::RadialTree);
+}
+
+void LayoutOptimizerTest::testMultipleNodes_Cancel_ShouldStopAndPublishPreviews()
+{
+    auto data = std::make_shared<MindMapData>();
+    const size_t nodeCount = 50;
+    std::uniform_real_distribution<double> xDist { -1000, 1000 };
+    std::uniform_real_distribution<double> yDist { -1000, 1000 };
+    std::mt19937 engine;
+    std::vector<NodeS> nodes;
+    for (size_t i = 0; i < nodeCount; i++) {
+        auto node = std::make_shared<Node>();
+        data->graph().addNode(node);
+        node->setPos({ xDist(engine), yDist(engine) });
+        nodes.push_back(node);
+    }
+    std::uniform_int_distribution<size_t> iDist { 0, nodes.size() - 1 };
+    for (auto && node : nodes) {
+        const auto otherNode = data->graph().getNode(static_cast<int>(iDist(engine)));
+        data->graph().addEdge(std::make_shared<Edge>(node, otherNode));
+    }
+
+    Grid grid;
+    grid.setSize(10);
+    LayoutOptimizer lol { data, grid };
+    size_t previews = 0;
+    lol.setPreviewCallback([&] {
+        previews++;
+    },
+                           std::chrono::milliseconds { 0 });
+    double progress = 0;
+    lol.setProgressCallback([&](double progress_) {
+        progress = progress_;
+        lol.cancel();
+    });
+    QVERIFY(lol.initialize(1.0, 50));
+    const auto optimizationInfo = lol.optimize();
+    QVERIFY(optimizationInfo.cancelled);
+    QVERIFY(optimizationInfo.changes > 0);
+    QVERIFY(progress < 1.0);
+    QVERIFY(previews > 0);
+
+    QVERIFY(lol.extractPreview());
+    QVERIFY(!lol.extractPreview());
+
+    lol.extract();
+    for (auto && node : nodes) {
+        QCOMPARE(node->pos().x(), static_cast<double>(static_cast<int>(node->pos().x() / grid.size()) * grid.size()));
+        QCOMPARE(node->pos().y(), static_cast<double>(static_cast<int>(node->pos().y() / grid.size()) * grid.size()));
+    }
+
+    // A new initialization clears the cancellation
+    QVERIFY(lol.initialize(1.0, 50));
+    lol.setProgressCallback(nullptr);
+    QVERIFY(!lol.optimize().cancelled);
+}
+
+void LayoutOptimizerTest::testMultipleNodes_Components_ShouldBePackedApart()
+{
+    auto data = std::make_shared<MindMapData>();
+    const size_t componentCount = 3;
+    const size_t nodeCount = 40;
+    std::uniform_real_distribution<double> xDist { -1000, 1000 };
+    std::uniform_real_distribution<double> yDist { -1000, 1000 };
+    std::mt19937 engine;
+    std::vector<std::vector<NodeS>> components(componentCount);
+    for (auto && component : components) {
+        for (size_t i = 0; i < nodeCount; i++) {
+            auto node = std::make_shared<Node>();
+            data->graph().addNode(node);
+            node->setPos({ xDist(engine), yDist(engine) });
+            if (!component.empty()) {
+                std::uniform_int_distribution<size_t> parentDist { 0, component.size() - 1 };
+                data->graph().addEdge(std::make_shared<Edge>(component.at(parentDist(engine)), node));
+            }
+            component.push_back(node);
+        }
+    }
+
+    Grid grid;
+    grid.setSize(10);
+    LayoutOptimizer lol { data, grid };
+    QVERIFY(lol.initialize(1.0, 50));
+    double progress = 0;
+    lol.setProgressCallback([&](double progress_) {
+        progress = progress_;
+    });
+    const auto optimizationInfo = lol.optimize();
+    QCOMPARE(progress, 1.0);
+    QVERIFY(optimizationInfo.changes > 0);
+    QVERIFY(optimizationInfo.finalCost < optimizationInfo.initialCost);
+    lol.extract();
+
+    // The bounding rectangles of the components must not overlap after the packing
+    std::vector<QRectF> rects;
+    for (auto && component : components) {
+        QRectF rect;
+        for (auto && node : component) {
+            QCOMPARE(node->location(), grid.snapToGrid(node->location()));
+            rect = rect.united(node->placementBoundingRect().translated(node->location()));
+        }
+        rects.push_back(rect);
+    }
+    for (size_t i = 0; i < rects.size(); i++) {
+        for (size_t j = i + 1; j < rects.size(); j++) {
+            QVERIFY(!rects.at(i).intersects(rects.at(j)));
+        }
+    }
+}
+
+void LayoutOptimizerTest::testMultipleNodes_Seed_ShouldReproduceLayout()
+{
+    auto data = std::make_shared<MindMapData>();
+    const size_t nodeCount = 100;
+    std::mt19937 engine;
+    std::vector<NodeS> nodes;
+    for (size_t i = 0; i < nodeCount; i++) {
+        auto node = std::make_shared<Node>();
+        data->graph().addNode(node);
+        if (!nodes.empty()) {
+            std::uniform_int_distribution<size_t> parentDist { 0, nodes.size() - 1 };
+            data->graph().addEdge(std::make_shared<Edge>(nodes.at(parentDist(engine)), node));
+        }
+        nodes.push_back(node);
+    }
+
+    const auto run = [&](uint32_t seed) {
+        for (auto && node : nodes) {
+            node->setLocation({});
+        }
+        Grid grid;
+        LayoutOptimizer lol { data, grid };
+        lol.setSeed(seed);
+        lol.setReplicaCount(2);
+        lol.initialize(1.0, 50);
+        const auto optimizationInfo = lol.optimize();
+        lol.extract();
+        std::vector<QPointF> locations;
+        for (auto && node : nodes) {
+            locations.push_back(node->location());
+        }
+        return std::make_pair(optimizationInfo, locations);
+    };
+
+    const auto first = run(42);
+    const auto second = run(42);
+    QCOMPARE(first.first.finalCost, second.first.finalCost);
+    QCOMPARE(first.first.changes, second.first.changes);
+    QCOMPARE(first.second, second.second);
+
+    const auto other = run(43);
+    QVERIFY(other.second != first.second);
+}
+
+void LayoutOptimizerTest::testMultipleNodes_LayoutCache_ShouldReapplyLayout()
+{
+    auto data = std::make_shared<MindMapData>();
+    const size_t nodeCount = 50;
+    std::mt19937 engine;
+    std::vector<NodeS> nodes;
+    for (size_t i = 0; i < nodeCount; i++) {
+        auto node = std::make_shared<Node>();
+        data->graph().addNode(node);
+        if (!nodes.empty()) {
+            std::uniform_int_distribution<size_t> parentDist { 0, nodes.size() - 1 };
+            data->graph().addEdge(std::make_shared<Edge>(nodes.at(parentDist(engine)), node));
+        }
+        nodes.push_back(node);
+    }
+
+    const auto run = [&](double minEdgeLength) {
+        Grid grid;
+        LayoutOptimizer lol { data, grid };
+        lol.setUseLayoutCache(true);
+        lol.initialize(1.0, minEdgeLength);
+        const auto optimizationInfo = lol.optimize();
+        lol.extract();
+        std::vector<QPointF> locations;
+        for (auto && node : nodes) {
+            locations.push_back(node->location());
+        }
+        return std::make_pair(optimizationInfo, locations);
+    };
+
+    const auto first = run(50);
+    QVERIFY(!first.first.cached);
+    QVERIFY(first.first.changes > 0);
+
+    // Moving the nodes doesn't change the key
+    for (auto && node : nodes) {
+        node->setLocation({});
+    }
+    const auto second = run(50);
+    QVERIFY(second.first.cached);
+    QCOMPARE(second.first.changes, size_t { 0 });
+    QCOMPARE(second.second, first.second);
+
+    // Undo points share the cache
+    const MindMapData copy { *data };
+    QVERIFY(copy.layoutCache().latest());
+    QCOMPARE(copy.layoutCache().latest()->layout.size(), nodeCount);
+
+    QVERIFY(!run(60).first.cached);
+
+    data->graph().addEdge(std::make_shared<Edge>(nodes.back(), nodes.front()));
+    QVERIFY(!run(50).first.cached);
+}
+
+void LayoutOptimizerTest::testMultipleNodes_TimeBudget_ShouldFinishInTime()
+{
+    auto data = std::make_shared<MindMapData>();
+    const size_t nodeCount = 1000;
+    std::uniform_real_distribution<double> xDist { -5000, 5000 };
+    std::uniform_real_distribution<double> yDist { -5000, 5000 };
+    std::mt19937 engine;
+    std::vector<NodeS> nodes;
+    for (size_t i = 0; i < nodeCount; i++) {
+        auto node = std::make_shared<Node>();
+        data->graph().addNode(node);
+        node->setPos({ xDist(engine), yDist(engine) });
+        if (!nodes.empty()) {
+            std::uniform_int_distribution<size_t> parentDist { 0, nodes.size() - 1 };
+            data->graph().addEdge(std::make_shared<Edge>(nodes.at(parentDist(engine)), node));
+        }
+        nodes.push_back(node);
+    }
+
+    Grid grid;
+    grid.setSize(10);
+    LayoutOptimizer lol { data, grid };
+    const std::chrono::milliseconds timeBudget { 250 };
+    lol.setTimeBudget(timeBudget);
+    QVERIFY(lol.initialize(1.0, 50));
+    const auto startTime = std::chrono::steady_clock::now();
+    const auto optimizationInfo = lol.optimize();
+    const auto duration = std::chrono::steady_clock::now() - startTime;
+    juzzlin::L(TAG).info() << "Final cost: " << optimizationInfo.finalCost << ", duration: "
+                           << std::chrono::duration_cast<std::chrono::milliseconds>(duration).count() << " ms";
+    // The slice running when the time runs out is finished
+    QVERIFY(duration < timeBudget * 4);
+    QVERIFY(optimizationInfo.changes > 0);
+    QVERIFY(optimizationInfo.finalCost < optimizationInfo.initialCost);
+    lol.extract();
+}
+
+void LayoutOptimizerTest::testMultipleNodes_Trace_ShouldRecordConvergence()
+{
+    auto data = std::make_shared<MindMapData>();
+    const size_t nodeCount = 50;
+    std::mt19937 engine;
+    std::vector<NodeS> nodes;
+    for (size_t i = 0; i < nodeCount; i++) {
+        auto node = std::make_shared<Node>();
+        data->graph().addNode(node);
+        if (!nodes.empty()) {
+            std::uniform_int_distribution<size_t> parentDist { 0, nodes.size() - 1 };
+            data->graph().addEdge(std::make_shared<Edge>(nodes.at(parentDist(engine)), node));
+        }
+        nodes.push_back(node);
+    }
+
+    Grid grid;
+    LayoutOptimizer lol { data, grid };
+    size_t tracedSamples = 0;
+    lol.setTraceCallback([&](const LayoutOptimizer::TraceSample &) {
+        tracedSamples++;
+    });
+    QVERIFY(lol.initialize(1.0, 50));
+    const auto optimizationInfo = lol.optimize();
+    lol.extract();
+
+    QVERIFY(!optimizationInfo.trace.empty());
+    QCOMPARE(optimizationInfo.trace.size(), std::min(tracedSamples, Constants::LayoutOptimizer::traceSize()));
+    for (size_t i = 0; i < optimizationInfo.trace.size(); i++) {
+        auto && sample = optimizationInfo.trace.at(i);
+        QVERIFY(sample.acceptRatio >= 0 && sample.acceptRatio <= 1);
+        QVERIFY(sample.movesPerSecond > 0);
+        QVERIFY(sample.sliceDuration <= sample.time);
+        if (i) {
+            QVERIFY(sample.time >= optimizationInfo.trace.at(i - 1).time);
+            QVERIFY(sample.temperature <= optimizationInfo.trace.at(i - 1).temperature);
+        }
+    }
+    // The first sample is only kept if the ring buffer didn't wrap
+    QVERIFY(tracedSamples <= Constants::LayoutOptimizer::traceSize());
+    QCOMPARE(optimizationInfo.trace.front().temperature, optimizationInfo.t0);
+    QCOMPARE(optimizationInfo.trace.back().cost, optimizationInfo.finalCost);
+}
+
+void LayoutOptimizerTest::testMultipleNodes_TraceOfOtherSchedules_ShouldRecordSlices()
+{
+    // The temperature of these schedules isn't monotonic, so only the time and the final cost are checked
+    for (auto && [schedule, replicaCount] : std::vector<std::pair<LayoutOptimizer::Schedule, size_t>> { { LayoutOptimizer::Schedule::ModifiedLam, 1 }, { LayoutOptimizer::Schedule::Geometric, 2 } }) {
+        auto data = std::make_shared<MindMapData>();
+        std::mt19937 engine;
+        std::vector<NodeS> nodes;
+        for (size_t i = 0; i < 30; i++) {
+            auto node = std::make_shared<Node>();
+            data->graph().addNode(node);
+            if (!nodes.empty()) {
+                std::uniform_int_distribution<size_t> parentDist { 0, nodes.size() - 1 };
+                data->graph().addEdge(std::make_shared<Edge>(nodes.at(parentDist(engine)), node));
+            }
+            nodes.push_back(node);
+        }
+
+        Grid grid;
+        LayoutOptimizer lol { data, grid };
+        lol.setSchedule(schedule);
+        lol.setReplicaCount(replicaCount);
+        size_t tracedSamples = 0;
+        lol.setTraceCallback([&](const LayoutOptimizer::TraceSample &) {
+            tracedSamples++;
+        });
+        QVERIFY(lol.initialize(1.0, 50));
+        const auto optimizationInfo = lol.optimize();
+        lol.extract();
+
+        QVERIFY(!optimizationInfo.trace.empty());
+        QCOMPARE(optimizationInfo.trace.size(), std::min(tracedSamples, Constants::LayoutOptimizer::traceSize()));
+        for (size_t i = 0; i < optimizationInfo.trace.size(); i++) {
+            auto && sample = optimizationInfo.trace.at(i);
+            QVERIFY(sample.acceptRatio >= 0 && sample.acceptRatio <= 1);
+            if (i) {
+                QVERIFY(sample.time >= optimizationInfo.trace.at(i - 1).time);
+            }
+        }
+        QCOMPARE(optimizationInfo.trace.back().cost, optimizationInfo.finalCost);
+    }
+}
+
+void LayoutOptimizerTest::testCostKernels_ShouldMatchScalarKernel()
+{
+    // Cells on a coarse grid so that there are plenty of collinear, overlapping connections
+    std::mt19937 engine;
+    std::uniform_int_distribution<int> coordinateDist { 0, 10 };
+    std::vector<double> x;
+    std::vector<double> y;
+    const size_t cellCount = 200;
+    for (size_t i = 0; i < cellCount; i++) {
+        x.push_back(coordinateDist(engine) * 200);
+        y.push_back(coordinateDist(engine) * 75);
+    }
+
+    std::uniform_int_distribution<size_t> cellDist { 0, cellCount - 1 };
+    const auto & scalar = LayoutCostKernel::kernel(LayoutCostKernel::Implementation::Scalar);
+    QVERIFY(scalar.implementation == LayoutCostKernel::Implementation::Scalar);
+    QVERIFY(LayoutCostKernel::isSupported(LayoutCostKernel::bestKernel().implementation));
+    if (!LayoutCostKernel::isSupported(LayoutCostKernel::Implementation::Avx2)) {
+        QSKIP("No SIMD cost kernel is supported on this CPU");
+    }
+
+    const auto & simd = LayoutCostKernel::kernel(LayoutCostKernel::Implementation::Avx2);
+    QVERIFY(simd.implementation == LayoutCostKernel::Implementation::Avx2);
+    QVERIFY(LayoutCostKernel::bestKernel().implementation == LayoutCostKernel::Implementation::Avx2);
+    size_t overlapCount = 0;
+    for (size_t round = 0; round < 10; round++) {
+        // Odd counts exercise the scalar tails
+        for (size_t count = 0; count < 40; count++) {
+            std::vector<size_t> others;
+            for (size_t i = 0; i < count; i++) {
+                others.push_back(cellDist(engine));
+            }
+            const auto cell = cellDist(engine);
+            const auto moved = others.empty() ? cell : others.at(count / 2);
+            const auto expectedDistances = scalar.sumDistances(x.data(), y.data(), cell, others.data(), others.size());
+            const auto expectedOverlaps = scalar.sumOverlapCosts(x.data(), y.data(), cell, moved, others.data(), others.size());
+            QVERIFY(std::fabs(simd.sumDistances(x.data(), y.data(), cell, others.data(), others.size()) - expectedDistances) < 1e-6 * (1 + expectedDistances));
+            QVERIFY(std::fabs(simd.sumOverlapCosts(x.data(), y.data(), cell, moved, others.data(), others.size()) - expectedOverlaps) < 1e-6 * (1 + expectedOverlaps));
+            overlapCount += expectedOverlaps > 0;
+        }
+    }
+
+    // Otherwise the vector overlap path would not have been compared at all
+    QVERIFY(overlapCount > 0);
+}
+
 QTEST_GUILESS_MAIN(LayoutOptimizerTest)
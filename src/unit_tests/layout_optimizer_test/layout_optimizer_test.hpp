@@ -35,7 +35,45 @@ private slots:
 
     void testMultipleNodes_ShouldReduceCost();
 
+    void testMultipleNodes_ParallelTempering_ShouldReduceCost();
+
+    void testMultipleNodes_ModifiedLam_ShouldReduceCost();
+
+    void testMultipleNodes_CrossingPenalty_ShouldReduceCrossings();
+
     void testMultipleNodes_NoEdges_ShouldSpread();
+
+    void testMultipleNodes_HighDegreeHub_ShouldReduceCost();
+
+    void testMultipleNodes_Multilevel_ShouldReduceCost();
+
+    void testMultipleNodes_Cancel_ShouldStopAndPublishPreviews();
+
+    void testMultipleNodes_Components_ShouldBePackedApart();
+
+    void testMultipleNodes_Subgraph_ShouldMoveOnlySubgraph();
+
+    void testMultipleNodes_WarmStart_ShouldKeepLayoutAndConvergeFast();
+
+    void testMultipleNodes_LocalityPlacement_ShouldStartCheaperAndConvergeFast();
+
+    void testMultipleNodes_ForceDirected_ShouldRemoveOverlaps();
+
+    void testMultipleNodes_TidyTree_ShouldRemoveOverlaps();
+
+    void testMultipleNodes_RadialTree_ShouldRemoveOverlaps();
+
+    void testMultipleNodes_Seed_ShouldReproduceLayout();
+
+    void testMultipleNodes_LayoutCache_ShouldReapplyLayout();
+
+    void testMultipleNodes_TimeBudget_ShouldFinishInTime();
+
+    void testMultipleNodes_Trace_ShouldRecordConvergence();
+
+    void testMultipleNodes_TraceOfOtherSchedules_ShouldRecordSlices();
+
+    void testCostKernels_ShouldMatchScalarKernel();
 };
 
 #endif // LAYOUT_OPTIMIZER_TEST_HPP
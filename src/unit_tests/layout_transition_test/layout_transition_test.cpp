@@ -0,0 +1,44 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "layout_transition_test.hpp"
+
+#include "../../view/layout_transition.hpp"
+
+void LayoutTransitionTest::testEase_shouldBeMonotonic()
+{
+    double previous = 0;
+    for (int i = 1; i <= 100; i++) {
+        const auto eased = LayoutTransition::ease(i / 100.0);
+        QVERIFY(eased >= previous);
+        previous = eased;
+    }
+
+    QCOMPARE(LayoutTransition::ease(0.5), 0.5);
+}
+
+void LayoutTransitionTest::testEase_shouldClampProgress()
+{
+    QCOMPARE(LayoutTransition::ease(-1), 0.0);
+    QCOMPARE(LayoutTransition::ease(2), 1.0);
+}
+
+void LayoutTransitionTest::testEase_shouldStartAndEndExactly()
+{
+    QCOMPARE(LayoutTransition::ease(0), 0.0);
+    QCOMPARE(LayoutTransition::ease(1), 1.0);
+}
+
+QTEST_GUILESS_MAIN(LayoutTransitionTest)
@@ -0,0 +1,157 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "mind_map_diff_test.hpp"
+
+#include "../../application/diff_reporter.hpp"
+#include "../../common/test_mode.hpp"
+#include "../../domain/graph_snapshot.hpp"
+#include "../../domain/mind_map_diff.hpp"
+
+namespace {
+
+SceneItems::NodeModel createNode(int index, QString text, QPointF location = {}, QUuid uuid = {})
+{
+    SceneItems::NodeModel node { Qt::white, Qt::black };
+    node.index = index;
+    node.text = text;
+    node.location = location;
+    node.uuid = uuid;
+    return node;
+}
+
+GraphSnapshot::EdgeData createEdge(int sourceIndex, int targetIndex, QString text = {})
+{
+    SceneItems::EdgeModel edge { false, { SceneItems::EdgeModel::ArrowMode::Single } };
+    edge.text = text;
+    return { edge, sourceIndex, targetIndex };
+}
+
+} // namespace
+
+MindMapDiffTest::MindMapDiffTest()
+{
+    TestMode::setEnabled(true);
+}
+
+void MindMapDiffTest::testChangesOfNodesAndEdges()
+{
+    const GraphSnapshot oldGraph {
+        { createNode(0, "Root"), createNode(1, "Moved"), createNode(2, "Edited"), createNode(3, "Removed") },
+        { createEdge(0, 1), createEdge(0, 2, "Foo"), createEdge(0, 3) }
+    };
+    const GraphSnapshot newGraph {
+        { createNode(0, "Root"), createNode(1, "Moved", { 10, 10 }), createNode(2, "Edited!"), createNode(4, "Added") },
+        { createEdge(0, 1), createEdge(0, 2, "Bar"), createEdge(0, 4) }
+    };
+
+    const MindMapDiff diff { oldGraph, newGraph };
+
+    QCOMPARE(diff.nodeChanges().size(), size_t(4));
+    QCOMPARE(diff.nodeChanges().at(0).change, MindMapDiff::Change::Moved);
+    QCOMPARE(diff.nodeChanges().at(0).newIndex, 1);
+    QCOMPARE(diff.nodeChanges().at(1).change, MindMapDiff::Change::Edited);
+    QCOMPARE(diff.nodeChanges().at(1).text, QString { "Edited!" });
+    QCOMPARE(diff.nodeChanges().at(2).change, MindMapDiff::Change::Added);
+    QCOMPARE(diff.nodeChanges().at(2).newIndex, 4);
+    QCOMPARE(diff.nodeChanges().at(3).change, MindMapDiff::Change::Removed);
+    QCOMPARE(diff.nodeChanges().at(3).oldIndex, 3);
+
+    QCOMPARE(diff.edgeChanges().size(), size_t(3));
+    QCOMPARE(diff.edgeChanges().at(0).change, MindMapDiff::Change::Edited);
+    QCOMPARE(diff.edgeChanges().at(0).text, QString { "Bar" });
+    QCOMPARE(diff.edgeChanges().at(1).change, MindMapDiff::Change::Added);
+    QCOMPARE(diff.edgeChanges().at(1).targetIndex, 4);
+    QCOMPARE(diff.edgeChanges().at(2).change, MindMapDiff::Change::Removed);
+    QCOMPARE(diff.edgeChanges().at(2).targetIndex, 3);
+
+    QCOMPARE(diff.nodeCount(MindMapDiff::Change::Added), size_t(1));
+    QCOMPARE(diff.edgeCount(MindMapDiff::Change::Moved), size_t(0));
+}
+
+void MindMapDiffTest::testIdenticalGraphsHaveNoChanges()
+{
+    const GraphSnapshot graph { { createNode(0, "Root"), createNode(1, "Child", { 10, 10 }) }, { createEdge(0, 1, "Foo") } };
+
+    QVERIFY(MindMapDiff(graph, graph).isEmpty());
+}
+
+void MindMapDiffTest::testRenumberedNodesAreMatchedByUniqueText()
+{
+    const GraphSnapshot oldGraph {
+        { createNode(0, "Root"), createNode(1, "Child"), createNode(2, "Twin"), createNode(3, "Twin") },
+        { createEdge(0, 1), createEdge(0, 2) }
+    };
+    const GraphSnapshot newGraph {
+        { createNode(10, "Root"), createNode(11, "Child", { 10, 10 }), createNode(12, "Twin"), createNode(13, "Twin") },
+        { createEdge(10, 11), createEdge(10, 12) }
+    };
+
+    const MindMapDiff diff { oldGraph, newGraph };
+
+    // The duplicate texts can't be matched, so those nodes and their edge are replaced
+    QCOMPARE(diff.nodeCount(MindMapDiff::Change::Moved), size_t(1));
+    QCOMPARE(diff.nodeChanges().at(0).oldIndex, 1);
+    QCOMPARE(diff.nodeChanges().at(0).newIndex, 11);
+    QCOMPARE(diff.nodeCount(MindMapDiff::Change::Added), size_t(2));
+    QCOMPARE(diff.nodeCount(MindMapDiff::Change::Removed), size_t(2));
+    QCOMPARE(diff.nodeCount(MindMapDiff::Change::Edited), size_t(0));
+
+    QCOMPARE(diff.edgeChanges().size(), size_t(2));
+    QCOMPARE(diff.edgeChanges().at(0).change, MindMapDiff::Change::Added);
+    QCOMPARE(diff.edgeChanges().at(0).targetIndex, 12);
+    QCOMPARE(diff.edgeChanges().at(1).change, MindMapDiff::Change::Removed);
+    QCOMPARE(diff.edgeChanges().at(1).targetIndex, 2);
+}
+
+void MindMapDiffTest::testRenumberedNodesAreMatchedByUuid()
+{
+    const auto uuid0 = QUuid::createUuid();
+    const auto uuid1 = QUuid::createUuid();
+    const GraphSnapshot oldGraph {
+        { createNode(0, "Twin", {}, uuid0), createNode(1, "Twin", {}, uuid1), createNode(2, "Root") },
+        { createEdge(2, 0) }
+    };
+    const GraphSnapshot newGraph {
+        { createNode(0, "Twin", {}, uuid1), createNode(1, "Twin", { 10, 10 }, uuid0), createNode(2, "Root") },
+        { createEdge(2, 1) }
+    };
+
+    const MindMapDiff diff { oldGraph, newGraph };
+
+    // The duplicate texts are matched by the UUIDs although their indices have been swapped
+    QCOMPARE(diff.nodeChanges().size(), size_t(1));
+    QCOMPARE(diff.nodeChanges().at(0).change, MindMapDiff::Change::Moved);
+    QCOMPARE(diff.nodeChanges().at(0).oldIndex, 0);
+    QCOMPARE(diff.nodeChanges().at(0).newIndex, 1);
+    QVERIFY(diff.edgeChanges().empty());
+}
+
+void MindMapDiffTest::testReport()
+{
+    const GraphSnapshot oldGraph { { createNode(0, "Root"), createNode(1, "Child") }, { createEdge(0, 1) } };
+    const GraphSnapshot newGraph { { createNode(0, "Root"), createNode(2, "New\nchild") }, { createEdge(0, 2) } };
+
+    const auto lines = DiffReporter::report({ oldGraph, newGraph });
+
+    QCOMPARE(lines, (QStringList { //
+                      "Added node 2 \"New child\"",
+                      "Removed node 1 \"Child\"",
+                      "Added edge 0 -> 2 \"\"",
+                      "Removed edge 0 -> 1 \"\"",
+                      "Nodes: 1 added, 1 removed, 0 moved, 0 edited. Edges: 1 added, 1 removed, 0 edited." }));
+}
+
+QTEST_GUILESS_MAIN(MindMapDiffTest)
@@ -17,6 +17,13 @@
 
 #include "../../common/test_mode.hpp"
 #include "../../view/scene_items/node.hpp"
+#include "../../view/scene_items/node_hover_overlay.hpp"
+#include "../../view/scene_items/node_model.hpp"
+#include "../../view/scene_items/text_size_cache.hpp"
+
+#include <QFont>
+
+#include <memory>
 
 using SceneItems::Node;
 
@@ -25,6 +32,18 @@ NodeTest::NodeTest()
     TestMode::setEnabled(true);
 }
 
+void NodeTest::testCacheModeFollowsTextInput()
+{
+    Node node;
+    QCOMPARE(node.cacheMode(), QGraphicsItem::DeviceCoordinateCache);
+
+    node.setTextInputActive(true);
+    QCOMPARE(node.cacheMode(), QGraphicsItem::NoCache);
+
+    node.setTextInputActive(false);
+    QCOMPARE(node.cacheMode(), QGraphicsItem::DeviceCoordinateCache);
+}
+
 void NodeTest::testContainsText()
 {
     Node node;
@@ -35,4 +54,95 @@ void NodeTest::testContainsText()
     QVERIFY(node.containsText("bar"));
 }
 
+void NodeTest::testGetNearestEdgePoints()
+{
+    Node node1;
+    Node node2;
+    node2.setPos(node1.size().width() * 3, 0);
+    auto nearestPoints = Node::getNearestEdgePoints(node1, node2);
+    QVERIFY(!nearestPoints.first.isCorner);
+    QVERIFY(nearestPoints.first.location.x() > 0);
+    QCOMPARE(nearestPoints.first.location.y(), 0.0);
+    QVERIFY(!nearestPoints.second.isCorner);
+    QVERIFY(nearestPoints.second.location.x() < 0);
+    QCOMPARE(nearestPoints.second.location.y(), 0.0);
+
+    node2.setPos(-node1.size().width() * 3, -node1.size().height() * 3);
+    nearestPoints = Node::getNearestEdgePoints(node1, node2);
+    QVERIFY(nearestPoints.first.isCorner);
+    QVERIFY(nearestPoints.first.location.x() < 0);
+    QVERIFY(nearestPoints.first.location.y() < 0);
+    QVERIFY(nearestPoints.second.isCorner);
+    QVERIFY(nearestPoints.second.location.x() > 0);
+    QVERIFY(nearestPoints.second.location.y() > 0);
+
+    // Overlapping nodes use the full search
+    node2.setPos(0, 0);
+    nearestPoints = Node::getNearestEdgePoints(node1, node2);
+    QCOMPARE(nearestPoints.first.location, nearestPoints.second.location);
+}
+
+void NodeTest::testStyledModelConstructor()
+{
+    SceneItems::NodeModel model { Qt::red, Qt::blue };
+    model.index = 42;
+    model.location = { 10, 20 };
+    model.size = { 200, 100 };
+    model.uuid = QUuid::createUuid();
+
+    const Node node { model, QFont {}, 14, 7 };
+    QCOMPARE(node.index(), 42);
+    QCOMPARE(node.location(), QPointF(10, 20));
+    QCOMPARE(node.size(), QSizeF(200, 100));
+    QCOMPARE(node.uuid(), model.uuid);
+    QCOMPARE(node.color(), QColor(Qt::red));
+    QCOMPARE(node.textColor(), QColor(Qt::blue));
+    QCOMPARE(node.cornerRadius(), 7);
+}
+
+void NodeTest::testTextSizeCache()
+{
+    using SceneItems::TextSizeCache;
+
+    TextSizeCache::clear();
+    QFont font;
+    font.setPointSize(11);
+    TextSizeCache::insert("Foo", font, -1, { 30, 20 });
+    QCOMPARE(TextSizeCache::find("Foo", font, -1), std::optional<QSizeF>(QSizeF { 30, 20 }));
+    QVERIFY(!TextSizeCache::find("Bar", font, -1));
+    QVERIFY(!TextSizeCache::find("Foo", font, 100));
+
+    auto largerFont = font;
+    largerFont.setPointSize(22);
+    QVERIFY(!TextSizeCache::find("Foo", largerFont, -1));
+
+    TextSizeCache::insert("Foo", font, -1, { 40, 20 });
+    QCOMPARE(TextSizeCache::size(), size_t { 1 });
+    QCOMPARE(TextSizeCache::find("Foo", font, -1)->width(), 40.0);
+
+    TextSizeCache::clear();
+    QVERIFY(!TextSizeCache::find("Foo", font, -1));
+}
+
+void NodeTest::testHoverOverlayFollowsNode()
+{
+    SceneItems::NodeHoverOverlay overlay;
+    QVERIFY(!overlay.isVisible());
+
+    auto node = std::make_unique<Node>();
+    overlay.setNode(node.get());
+    QVERIFY(overlay.isVisible());
+    QCOMPARE(overlay.node(), node.get());
+    QVERIFY(overlay.boundingRect().contains(node->sceneBoundingRect()));
+
+    node->setLocation({ 100, 200 });
+    QVERIFY(overlay.boundingRect().contains(node->sceneBoundingRect()));
+
+    node.reset();
+    QVERIFY(!overlay.node());
+
+    overlay.setNode(nullptr);
+    QVERIFY(!overlay.isVisible());
+}
+
 QTEST_GUILESS_MAIN(NodeTest)
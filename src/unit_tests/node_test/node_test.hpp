@@ -29,7 +29,17 @@ public:
 
 private slots:
 
+    void testCacheModeFollowsTextInput();
+
     void testContainsText();
+
+    void testGetNearestEdgePoints();
+
+    void testHoverOverlayFollowsNode();
+
+    void testStyledModelConstructor();
+
+    void testTextSizeCache();
 };
 
 #endif // NODE_TEST_HPP
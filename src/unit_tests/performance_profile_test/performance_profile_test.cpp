@@ -0,0 +1,113 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "performance_profile_test.hpp"
+
+#include "../../application/performance_profile.hpp"
+#include "../../common/constants.hpp"
+
+namespace {
+
+void addFrames(PerformanceProfile & profile, double paintMilliseconds, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        profile.addFrameTime(paintMilliseconds);
+    }
+}
+
+} // namespace
+
+void PerformanceProfileTest::testFixedModeIgnoresItemCountAndFrameTimes()
+{
+    PerformanceProfile profile;
+    QVERIFY(profile.setMode(PerformanceProfile::Mode::Speed));
+    QCOMPARE(profile.tier(), PerformanceProfile::Tier::Speed);
+    QVERIFY(!profile.policy().shadows);
+    QVERIFY(profile.policy().virtualization);
+
+    QVERIFY(!profile.setItemCount(0));
+    QVERIFY(profile.setMode(PerformanceProfile::Mode::Quality));
+    QVERIFY(!profile.setItemCount(1'000'000));
+    addFrames(profile, 1000, 10 * Constants::View::performanceProfileSettleFrames());
+    QCOMPARE(profile.tier(), PerformanceProfile::Tier::Quality);
+    QVERIFY(profile.policy().shadows);
+    QVERIFY(profile.policy().edgeAnimations);
+}
+
+void PerformanceProfileTest::testSlowFramesRaiseTier()
+{
+    PerformanceProfile profile;
+    profile.setItemCount(10);
+    const auto slowFrame = 2 * Constants::View::slowFrameMilliseconds();
+
+    // A single slow frame is not enough
+    QVERIFY(!profile.addFrameTime(slowFrame));
+    addFrames(profile, slowFrame, Constants::View::performanceProfileSettleFrames() - 2);
+    QCOMPARE(profile.tier(), PerformanceProfile::Tier::Quality);
+    QVERIFY(profile.addFrameTime(slowFrame));
+    QCOMPARE(profile.tier(), PerformanceProfile::Tier::Balanced);
+
+    // The new tier settles before it's judged
+    QVERIFY(!profile.addFrameTime(slowFrame));
+    addFrames(profile, slowFrame, Constants::View::performanceProfileSettleFrames());
+    QCOMPARE(profile.tier(), PerformanceProfile::Tier::Speed);
+
+    addFrames(profile, slowFrame, 10 * Constants::View::performanceProfileSettleFrames());
+    QCOMPARE(profile.tier(), PerformanceProfile::Tier::Speed);
+}
+
+void PerformanceProfileTest::testTierFollowsItemCountWithHysteresis()
+{
+    PerformanceProfile profile;
+    profile.setItemCountThresholds(1000, 2000);
+    QCOMPARE(profile.tier(), PerformanceProfile::Tier::Quality);
+
+    QVERIFY(profile.setItemCount(1000));
+    QCOMPARE(profile.tier(), PerformanceProfile::Tier::Balanced);
+    QVERIFY(!profile.policy().edgeAnimations);
+    QVERIFY(profile.policy().shadows);
+
+    QVERIFY(!profile.setItemCount(950));
+    QCOMPARE(profile.tier(), PerformanceProfile::Tier::Balanced);
+    QVERIFY(profile.setItemCount(899));
+    QCOMPARE(profile.tier(), PerformanceProfile::Tier::Quality);
+
+    QVERIFY(profile.setItemCount(5000));
+    QCOMPARE(profile.tier(), PerformanceProfile::Tier::Speed);
+    QVERIFY(profile.setItemCount(1500));
+    QCOMPARE(profile.tier(), PerformanceProfile::Tier::Balanced);
+
+    QVERIFY(profile.setItemCountThresholds(100, 200));
+    QCOMPARE(profile.tier(), PerformanceProfile::Tier::Speed);
+}
+
+void PerformanceProfileTest::testFastFramesLowerRaisedTier()
+{
+    PerformanceProfile profile;
+    profile.setItemCountThresholds(1000, 2000);
+    profile.setItemCount(1500);
+    addFrames(profile, 2 * Constants::View::slowFrameMilliseconds(), Constants::View::performanceProfileSettleFrames());
+    QCOMPARE(profile.tier(), PerformanceProfile::Tier::Speed);
+
+    // Frames between the limits keep the tier
+    addFrames(profile, Constants::View::fastFrameMilliseconds() + 1, 10 * Constants::View::performanceProfileSettleFrames());
+    QCOMPARE(profile.tier(), PerformanceProfile::Tier::Speed);
+
+    // Fast frames only undo the raise, not the tier of the item count
+    addFrames(profile, Constants::View::fastFrameMilliseconds() / 2, 10 * Constants::View::performanceProfileSettleFrames());
+    QCOMPARE(profile.tier(), PerformanceProfile::Tier::Balanced);
+}
+
+QTEST_GUILESS_MAIN(PerformanceProfileTest)
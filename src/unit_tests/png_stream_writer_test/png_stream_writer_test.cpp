@@ -0,0 +1,124 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "png_stream_writer_test.hpp"
+
+#include "../../infra/io/png_stream_writer.hpp"
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <random>
+
+static QImage createTestImage(QSize size, bool hasAlpha)
+{
+    QImage image { size, QImage::Format_ARGB32 };
+    std::mt19937 engine;
+    std::uniform_int_distribution<int> channel { 0, 255 };
+    for (int y = 0; y < size.height(); y++) {
+        for (int x = 0; x < size.width(); x++) {
+            // Smooth areas mixed with noise so that all the row filters get used
+            const int noise = channel(engine);
+            const int alpha = hasAlpha ? (x + y) % 256 : 255;
+            image.setPixel(x, y, qRgba((x * 7) % 256, noise, (y * 3) % 256, alpha));
+        }
+    }
+    return image;
+}
+
+static bool writeInBands(QString fileName, const QImage & image, bool hasAlpha, int bandHeight, int compressionLevel)
+{
+    IO::PngStreamWriter writer { fileName, image.size(), hasAlpha, compressionLevel };
+    if (!writer.open()) {
+        return false;
+    }
+    for (int y = 0; y < image.height(); y += bandHeight) {
+        if (!writer.writeBand(image.copy(0, y, image.width(), std::min(bandHeight, image.height() - y)))) {
+            return false;
+        }
+    }
+    return writer.finish();
+}
+
+void PngStreamWriterTest::testFailedExport_shouldKeepExistingFile()
+{
+    QTemporaryDir dir;
+    const auto fileName = dir.filePath("test.png");
+    QFile existingFile { fileName };
+    QVERIFY(existingFile.open(QIODevice::WriteOnly));
+    existingFile.write("Existing");
+    existingFile.close();
+
+    {
+        const auto image = createTestImage({ 16, 16 }, false);
+        IO::PngStreamWriter writer { fileName, image.size(), false };
+        QVERIFY(writer.open());
+        QVERIFY(writer.writeBand(image.copy(0, 0, 16, 8)));
+        // Cancelled before finish()
+    }
+
+    QVERIFY(existingFile.open(QIODevice::ReadOnly));
+    QCOMPARE(existingFile.readAll(), QByteArray { "Existing" });
+}
+
+void PngStreamWriterTest::testIncompleteImage_shouldFail()
+{
+    QTemporaryDir dir;
+    const auto fileName = dir.filePath("test.png");
+    const auto image = createTestImage({ 16, 16 }, false);
+    IO::PngStreamWriter writer { fileName, image.size(), false };
+    QVERIFY(writer.open());
+    QVERIFY(writer.writeBand(image.copy(0, 0, 16, 8)));
+    QVERIFY(!writer.finish());
+    QVERIFY(!QFile::exists(fileName));
+}
+
+void PngStreamWriterTest::testRoundTrip_data()
+{
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<bool>("hasAlpha");
+    QTest::addColumn<int>("bandHeight");
+    QTest::addColumn<int>("compressionLevel");
+
+    QTest::newRow("single band") << QSize { 64, 32 } << false << 32 << 6;
+    QTest::newRow("single row bands") << QSize { 33, 17 } << false << 1 << 6;
+    QTest::newRow("uneven bands") << QSize { 101, 77 } << false << 10 << 1;
+    QTest::newRow("alpha") << QSize { 101, 77 } << true << 10 << 9;
+    QTest::newRow("alpha, stored") << QSize { 31, 45 } << true << 7 << 0;
+    QTest::newRow("single pixel") << QSize { 1, 1 } << true << 1 << 6;
+}
+
+void PngStreamWriterTest::testRoundTrip()
+{
+    QFETCH(QSize, size);
+    QFETCH(bool, hasAlpha);
+    QFETCH(int, bandHeight);
+    QFETCH(int, compressionLevel);
+
+    QTemporaryDir dir;
+    const auto fileName = dir.filePath("test.png");
+    const auto outImage = createTestImage(size, hasAlpha);
+    QVERIFY(writeInBands(fileName, outImage, hasAlpha, bandHeight, compressionLevel));
+
+    QImage inImage;
+    QVERIFY(inImage.load(fileName, "PNG"));
+    QCOMPARE(inImage.size(), size);
+    QCOMPARE(inImage.hasAlphaChannel(), hasAlpha);
+    const auto format = hasAlpha ? QImage::Format_ARGB32 : QImage::Format_RGB32;
+    QCOMPARE(inImage.convertToFormat(format), outImage.convertToFormat(format));
+}
+
+QTEST_GUILESS_MAIN(PngStreamWriterTest)
@@ -0,0 +1,70 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "scene_prewarmer_test.hpp"
+
+#include "../../application/gui_job_scheduler.hpp"
+#include "../../common/test_mode.hpp"
+#include "../../domain/graph.hpp"
+#include "../../view/scene_items/node.hpp"
+#include "../../view/scene_prewarmer.hpp"
+
+#include <chrono>
+#include <memory>
+
+using SceneItems::Node;
+
+ScenePrewarmerTest::ScenePrewarmerTest()
+{
+    TestMode::setEnabled(true);
+}
+
+void ScenePrewarmerTest::testStart_shouldStopWithoutGraph()
+{
+    ScenePrewarmer dut { [] { return nullptr; }, std::make_shared<GuiJobScheduler>(std::chrono::milliseconds { 10 }) };
+    dut.start({ 0, 0, 100, 100 }, 1, {});
+    QVERIFY(dut.isActive());
+
+    QTRY_VERIFY(!dut.isActive());
+}
+
+void ScenePrewarmerTest::testStop_shouldDeactivate()
+{
+    Graph graph;
+    ScenePrewarmer dut { [&graph] { return &graph; }, std::make_shared<GuiJobScheduler>(std::chrono::milliseconds { 10 }) };
+    dut.start({ 0, 0, 100, 100 }, 1, {});
+    dut.stop();
+
+    QVERIFY(!dut.isActive());
+}
+
+void ScenePrewarmerTest::testWarmingOrder_shouldStartNearestToCenter()
+{
+    Graph graph;
+    const auto far = std::make_shared<Node>();
+    graph.addNode(far);
+    far->setLocation({ 1000, 0 });
+    const auto near = std::make_shared<Node>();
+    graph.addNode(near);
+    near->setLocation({ 10, 10 });
+    const auto middle = std::make_shared<Node>();
+    graph.addNode(middle);
+    middle->setLocation({ 0, -100 });
+
+    const auto order = ScenePrewarmer::warmingOrder(graph, { 0, 0 });
+    QCOMPARE(order, (std::vector<int> { near->index(), middle->index(), far->index() }));
+}
+
+QTEST_GUILESS_MAIN(ScenePrewarmerTest)
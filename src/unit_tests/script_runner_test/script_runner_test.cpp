@@ -0,0 +1,160 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "script_runner_test.hpp"
+
+#include "../../application/editor_service.hpp"
+#include "../../application/script_runner.hpp"
+#include "../../common/test_mode.hpp"
+#include "../../domain/graph.hpp"
+#include "../../domain/graph_snapshot.hpp"
+#include "../../domain/mind_map_data.hpp"
+
+#include <QLineF>
+
+namespace {
+
+// ES5 only, as older Qt versions don't support newer JavaScript
+
+//! Adds a root and n children connected to it in one call each.
+const auto addTreeProgram = R"(
+    var root = map.addNode({ text: "Root" });
+    var children = [];
+    for (var i = 0; i < %1; i++) {
+        children.push({ text: "Child " + i, x: i * 10 });
+    }
+    map.addEdges(map.addNodes(children).map(function(child) { return { source: root, target: child }; }));
+)";
+
+} // namespace
+
+ScriptRunnerTest::ScriptRunnerTest()
+{
+    TestMode::setEnabled(true);
+}
+
+void ScriptRunnerTest::testAddNodesAndEdges()
+{
+    const MindMapData mindMapData;
+    const auto result = ScriptRunner::run(mindMapData, QString { addTreeProgram }.arg(1000));
+    QVERIFY(result.error.isEmpty());
+    QVERIFY(result.mindMapData);
+
+    const auto snapshot = result.mindMapData->graphSnapshot();
+    QCOMPARE(snapshot.nodes().size(), static_cast<size_t>(1001));
+    QCOMPARE(snapshot.edges().size(), static_cast<size_t>(1000));
+    QCOMPARE(snapshot.nodes().at(0).text.toString(), QString { "Root" });
+    QCOMPARE(snapshot.nodes().at(2).text.toString(), QString { "Child 1" });
+    QCOMPARE(snapshot.nodes().at(2).location, QPointF(10, 0));
+    QCOMPARE(snapshot.edges().at(0).sourceIndex, snapshot.nodes().at(0).index);
+}
+
+void ScriptRunnerTest::testApply_shouldSaveSingleUndoPoint()
+{
+    EditorService editorService;
+    editorService.setMindMapData(std::make_shared<MindMapData>());
+    const auto node = editorService.addNodeAt(QPointF(0, 0));
+    auto result = ScriptRunner::run(*editorService.mindMapData(), QString { addTreeProgram }.arg(100));
+    QVERIFY(result.mindMapData);
+    const auto undoResult = editorService.applyMindMapData(std::move(result.mindMapData));
+    QCOMPARE(undoResult.isReplaced, false);
+    QCOMPARE(undoResult.addedNodes.size(), static_cast<size_t>(101));
+    QCOMPARE(undoResult.addedEdges.size(), static_cast<size_t>(100));
+    QCOMPARE(editorService.mindMapData()->graph().nodeCount(), static_cast<size_t>(102));
+    QVERIFY(editorService.getNodeByIndex(node->index()) == node);
+    QVERIFY(editorService.isModified());
+
+    editorService.undo();
+    QCOMPARE(editorService.mindMapData()->graph().nodeCount(), static_cast<size_t>(1));
+    QCOMPARE(editorService.mindMapData()->graph().edgeCount(), static_cast<size_t>(0));
+
+    editorService.redo();
+    QCOMPARE(editorService.mindMapData()->graph().nodeCount(), static_cast<size_t>(102));
+    QCOMPARE(editorService.mindMapData()->graph().edgeCount(), static_cast<size_t>(100));
+}
+
+void ScriptRunnerTest::testDeleteNode_shouldDeleteEdges()
+{
+    const MindMapData mindMapData;
+    const auto result = ScriptRunner::run(mindMapData, R"(
+        var nodes = map.addNodes([{}, {}, {}]);
+        map.addEdge(nodes[0], nodes[1]);
+        map.addEdge(nodes[1], nodes[2], { text: "Foo", arrowMode: "double", dashed: true });
+        map.deleteNode(nodes[0]);
+        if (map.edgeCount() !== 1 || map.edges()[0].text !== "Foo" || map.node(nodes[0]) !== undefined) {
+            throw new Error("Unexpected state");
+        }
+    )");
+    QVERIFY2(result.error.isEmpty(), result.error.toStdString().c_str());
+    QVERIFY(result.mindMapData);
+
+    const auto snapshot = result.mindMapData->graphSnapshot();
+    QCOMPARE(snapshot.nodes().size(), static_cast<size_t>(2));
+    QCOMPARE(snapshot.edges().size(), static_cast<size_t>(1));
+    QCOMPARE(snapshot.edges().at(0).model.style.arrowMode, SceneItems::EdgeModel::ArrowMode::Double);
+    QCOMPARE(snapshot.edges().at(0).model.style.dashedLine, true);
+}
+
+void ScriptRunnerTest::testError_shouldNotChangeMindMap()
+{
+    const MindMapData mindMapData;
+
+    auto result = ScriptRunner::run(mindMapData, "map.addNode({});\nmap.addEdge(0, 42);");
+    QVERIFY(!result.error.isEmpty());
+    QVERIFY(!result.mindMapData);
+
+    result = ScriptRunner::run(mindMapData, "map.addNode({});\nfoo();");
+    QVERIFY(!result.error.isEmpty());
+    QCOMPARE(result.errorLine, 2);
+    QVERIFY(!result.mindMapData);
+
+    result = ScriptRunner::run(mindMapData, R"(map.addNode({ color: "not a color" });)");
+    QVERIFY(!result.error.isEmpty());
+    QVERIFY(!result.mindMapData);
+}
+
+void ScriptRunnerTest::testLayoutTree()
+{
+    const MindMapData mindMapData;
+    const auto result = ScriptRunner::run(mindMapData, QString { addTreeProgram }.arg(10) + "map.layoutTree(true);");
+    QVERIFY(result.mindMapData);
+
+    const auto snapshot = result.mindMapData->graphSnapshot();
+    for (auto && edge : snapshot.edges()) {
+        const auto & source = snapshot.nodes().at(static_cast<size_t>(edge.sourceIndex));
+        const auto & target = snapshot.nodes().at(static_cast<size_t>(edge.targetIndex));
+        QVERIFY(QLineF(source.location, target.location).length() >= mindMapData.minEdgeLength());
+    }
+}
+
+void ScriptRunnerTest::testNoChanges_shouldReturnNull()
+{
+    const MindMapData mindMapData;
+    const auto result = ScriptRunner::run(mindMapData, "var count = map.nodeCount();");
+    QVERIFY(result.error.isEmpty());
+    QVERIFY(!result.mindMapData);
+}
+
+void ScriptRunnerTest::testSetStyle()
+{
+    const MindMapData mindMapData;
+    const auto result = ScriptRunner::run(mindMapData, R"(map.setStyle({ backgroundColor: "#123456", edgeWidth: 3 });)");
+    QVERIFY(result.mindMapData);
+    QCOMPARE(result.mindMapData->backgroundColor(), QColor("#123456"));
+    QCOMPARE(result.mindMapData->edgeWidth(), 3.0);
+    QVERIFY(!result.mindMapData->sharesStyleWith(mindMapData));
+}
+
+QTEST_GUILESS_MAIN(ScriptRunnerTest)
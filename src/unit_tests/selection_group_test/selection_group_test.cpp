@@ -16,6 +16,7 @@
 #include "selection_group_test.hpp"
 
 #include "../../common/test_mode.hpp"
+#include "../../domain/graph.hpp"
 #include "../../view/edge_selection_group.hpp"
 #include "../../view/node_selection_group.hpp"
 #include "../../view/scene_items/edge.hpp"
@@ -138,6 +139,34 @@ void SelectionGroupTest::testSelectedEdge()
     QCOMPARE(selectionGroup.selectedEdge().value(), edge1.get());
 }
 
+void SelectionGroupTest::testSetEdges()
+{
+    const auto edge1 = std::make_unique<Edge>(nullptr, nullptr);
+    const auto edge2 = std::make_unique<Edge>(nullptr, nullptr);
+    const auto edge3 = std::make_unique<Edge>(nullptr, nullptr);
+
+    EdgeSelectionGroup selectionGroup;
+    selectionGroup.add(*edge1, true);
+    selectionGroup.add(*edge2);
+
+    selectionGroup.set({ edge2.get(), edge3.get(), edge3.get() });
+
+    QVERIFY(!selectionGroup.contains(*edge1));
+    QVERIFY(!edge1->selected());
+    QVERIFY(selectionGroup.contains(*edge2));
+    QVERIFY(edge2->selected());
+    QVERIFY(selectionGroup.contains(*edge3));
+    QVERIFY(edge3->selected());
+    QCOMPARE(selectionGroup.size(), size_t(2));
+    QCOMPARE(selectionGroup.edges().at(0), edge2.get());
+    QCOMPARE(selectionGroup.edges().at(1), edge3.get());
+
+    // The replaced selection is explicit
+    selectionGroup.clear(true);
+
+    QCOMPARE(selectionGroup.size(), size_t(2));
+}
+
 void SelectionGroupTest::testToggleEdge()
 {
     const auto edge = std::make_unique<Edge>(nullptr, nullptr);
@@ -262,6 +291,34 @@ void SelectionGroupTest::testSelectedNode()
     QCOMPARE(selectionGroup.selectedNode().value(), node1.get());
 }
 
+void SelectionGroupTest::testSetNodes()
+{
+    const auto node1 = std::make_unique<Node>();
+    const auto node2 = std::make_unique<Node>();
+    const auto node3 = std::make_unique<Node>();
+
+    NodeSelectionGroup selectionGroup;
+    selectionGroup.add(*node1, true);
+    selectionGroup.add(*node2);
+
+    selectionGroup.set({ node2.get(), node3.get(), node3.get() });
+
+    QVERIFY(!selectionGroup.contains(*node1));
+    QVERIFY(!node1->selected());
+    QVERIFY(selectionGroup.contains(*node2));
+    QVERIFY(node2->selected());
+    QVERIFY(selectionGroup.contains(*node3));
+    QVERIFY(node3->selected());
+    QCOMPARE(selectionGroup.size(), size_t(2));
+    QCOMPARE(selectionGroup.nodes().at(0), node2.get());
+    QCOMPARE(selectionGroup.nodes().at(1), node3.get());
+
+    // The replaced selection is explicit
+    selectionGroup.clear(true);
+
+    QCOMPARE(selectionGroup.size(), size_t(2));
+}
+
 void SelectionGroupTest::testToggleNode()
 {
     const auto node = std::make_unique<Node>();
@@ -278,4 +335,80 @@ void SelectionGroupTest::testToggleNode()
     QVERIFY(!node->selected());
 }
 
+void SelectionGroupTest::testToggleNodes()
+{
+    const auto node1 = std::make_unique<Node>();
+    const auto node2 = std::make_unique<Node>();
+    const auto node3 = std::make_unique<Node>();
+
+    NodeSelectionGroup selectionGroup;
+    selectionGroup.add(*node1);
+    selectionGroup.add(*node2);
+
+    selectionGroup.toggle({ node2.get(), node3.get() });
+
+    QVERIFY(selectionGroup.contains(*node1));
+    QVERIFY(node1->selected());
+    QVERIFY(!selectionGroup.contains(*node2));
+    QVERIFY(!node2->selected());
+    QVERIFY(selectionGroup.contains(*node3));
+    QVERIFY(node3->selected());
+    QCOMPARE(selectionGroup.size(), size_t(2));
+    QCOMPARE(selectionGroup.nodes().at(0), node1.get());
+    QCOMPARE(selectionGroup.nodes().at(1), node3.get());
+}
+
+void SelectionGroupTest::testInternalEdgeCount()
+{
+    Graph graph;
+    const auto node0 = std::make_shared<Node>();
+    const auto node1 = std::make_shared<Node>();
+    const auto node2 = std::make_shared<Node>();
+    const auto node3 = std::make_shared<Node>();
+    graph.addNodes({ node0, node1, node2, node3 });
+    graph.addEdge(std::make_shared<Edge>(node0, node1));
+    graph.addEdge(std::make_shared<Edge>(node1, node0));
+    graph.addEdge(std::make_shared<Edge>(node1, node2));
+    graph.addEdge(std::make_shared<Edge>(node2, node3));
+
+    NodeSelectionGroup selectionGroup;
+    QCOMPARE(selectionGroup.internalEdgeCount(graph), size_t(0));
+
+    selectionGroup.add(*node0);
+    QCOMPARE(selectionGroup.internalEdgeCount(graph), size_t(0));
+
+    selectionGroup.add(*node1);
+    QCOMPARE(selectionGroup.internalEdgeCount(graph), size_t(2));
+
+    selectionGroup.add(*node2);
+    QCOMPARE(selectionGroup.internalEdgeCount(graph), size_t(3));
+
+    selectionGroup.toggle(*node1);
+    QCOMPARE(selectionGroup.internalEdgeCount(graph), size_t(0));
+
+    // Several changes between the counts
+    selectionGroup.add(*node3);
+    selectionGroup.toggle({ node1.get(), node0.get() });
+    QCOMPARE(selectionGroup.internalEdgeCount(graph), size_t(2));
+
+    selectionGroup.toggle({ node0.get(), node2.get() });
+    selectionGroup.add(*node2);
+    QCOMPARE(selectionGroup.internalEdgeCount(graph), size_t(4));
+    QCOMPARE(selectionGroup.internalEdges(graph).size(), size_t(4));
+
+    // Topology changes
+    graph.deleteEdge(node2->index(), node3->index());
+    QCOMPARE(selectionGroup.internalEdgeCount(graph), size_t(3));
+
+    graph.addEdge(std::make_shared<Edge>(node3, node0));
+    QCOMPARE(selectionGroup.internalEdgeCount(graph), size_t(4));
+
+    selectionGroup.set({ node0.get(), node3.get() });
+    QCOMPARE(selectionGroup.internalEdgeCount(graph), size_t(1));
+    QCOMPARE(selectionGroup.internalEdges(graph).at(0), graph.getEdge(node3->index(), node0->index()).get());
+
+    selectionGroup.clear();
+    QCOMPARE(selectionGroup.internalEdgeCount(graph), size_t(0));
+}
+
 QTEST_GUILESS_MAIN(SelectionGroupTest)
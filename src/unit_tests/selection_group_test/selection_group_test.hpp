@@ -39,10 +39,14 @@ private slots:
 
     void testSelectedEdge();
 
+    void testSetEdges();
+
     void testToggleEdge();
 
     void testAddNodes_Explicit();
 
+    void testInternalEdgeCount();
+
     void testAddNodes_Implicit();
 
     void testAddNodes_ImplicitAndExplicit();
@@ -51,7 +55,11 @@ private slots:
 
     void testSelectedNode();
 
+    void testSetNodes();
+
     void testToggleNode();
+
+    void testToggleNodes();
 };
 
 #endif // SELECTION_GROUP_TEST_HPP
@@ -0,0 +1,271 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "svg_writer_test.hpp"
+
+#include "../../common/test_mode.hpp"
+#include "../../domain/graph.hpp"
+#include "../../domain/mind_map_data.hpp"
+#include "../../view/scene_items/edge.hpp"
+#include "../../view/scene_items/node.hpp"
+#include "../../view/svg_writer.hpp"
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QXmlStreamReader>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <set>
+
+using SceneItems::Edge;
+using SceneItems::EdgeModel;
+using SceneItems::Node;
+
+namespace {
+
+struct Element
+{
+    QString name;
+
+    QXmlStreamAttributes attributes;
+
+    //! Id of the closest group with an id, e.g. "nodes".
+    QString group;
+
+    //! Character data of text elements.
+    QString text;
+};
+
+//! Parsed elements of an SVG file in document order.
+struct SvgDocument
+{
+    bool ok = false;
+
+    std::vector<Element> elements;
+
+    std::vector<Element> elementsInGroup(QString name, QString group) const
+    {
+        std::vector<Element> result;
+        std::copy_if(elements.begin(), elements.end(), std::back_inserter(result), [&](auto && element) {
+            return element.name == name && element.group == group;
+        });
+        return result;
+    }
+
+    //! \return The lines of the texts in the given group.
+    QStringList textsInGroup(QString group) const
+    {
+        QStringList texts;
+        for (auto && element : elementsInGroup("tspan", group)) {
+            texts << element.text;
+        }
+        return texts;
+    }
+};
+
+SvgDocument writeAndParse(MindMapDataS data, QString title, QRectF viewBox, const std::vector<QLineF> & gridLines = {})
+{
+    // The lines of the edges are otherwise laid out when exporting
+    for (auto && edge : data->graph().edges()) {
+        edge->updateLine();
+    }
+
+    SvgDocument document;
+    QTemporaryDir dir;
+    const auto fileName = dir.filePath("test.svg");
+    if (!SvgWriter { *data, {} }.write(fileName, title, viewBox, gridLines)) {
+        return document;
+    }
+
+    QFile file { fileName };
+    if (!file.open(QIODevice::ReadOnly)) {
+        return document;
+    }
+
+    QXmlStreamReader reader { &file };
+    std::vector<QString> groups;
+    while (!reader.atEnd()) {
+        reader.readNext();
+        if (reader.isStartElement()) {
+            const auto id = reader.attributes().value("id").toString();
+            groups.push_back(reader.name() == QString { "g" } && !id.isEmpty() ? id : (groups.empty() ? QString {} : groups.back()));
+            document.elements.push_back({ reader.name().toString(), reader.attributes(), groups.back(), {} });
+        } else if (reader.isEndElement()) {
+            groups.pop_back();
+        } else if (reader.isCharacters() && !reader.isWhitespace() && !document.elements.empty()) {
+            document.elements.back().text += reader.text().toString();
+        }
+    }
+
+    document.ok = !reader.hasError();
+    return document;
+}
+
+MindMapDataS createTestData()
+{
+    const auto data = std::make_shared<MindMapData>();
+    const auto node0 = std::make_shared<Node>();
+    node0->setLocation({ 0, 0 });
+    node0->setText("First line\nSecond line");
+    data->graph().addNode(node0);
+    const auto node1 = std::make_shared<Node>();
+    node1->setLocation({ 400, 200 });
+    node1->setColor(QColor(10, 20, 30));
+    data->graph().addNode(node1);
+    const auto node2 = std::make_shared<Node>();
+    node2->setLocation({ -400, 200 });
+    data->graph().addNode(node2);
+
+    const auto edge0 = std::make_shared<Edge>(node0, node1, false, false);
+    edge0->setArrowMode(EdgeModel::ArrowMode::Double);
+    edge0->setText("Edge label");
+    data->graph().addEdge(edge0);
+    const auto edge1 = std::make_shared<Edge>(node0, node2, false, false);
+    edge1->setArrowMode(EdgeModel::ArrowMode::Hidden);
+    edge1->setDashedLine(true);
+    data->graph().addEdge(edge1);
+    return data;
+}
+
+} // namespace
+
+SvgWriterTest::SvgWriterTest()
+{
+    TestMode::setEnabled(true);
+}
+
+void SvgWriterTest::testEdges()
+{
+    const auto data = createTestData();
+    const auto document = writeAndParse(data, "Edges", { -500, -100, 1000, 400 });
+    QVERIFY(document.ok);
+
+    const auto lines = document.elementsInGroup("line", "edges");
+    QCOMPARE(lines.size(), size_t { 2 });
+
+    std::set<QString> markerIds;
+    for (auto && marker : document.elementsInGroup("marker", "")) {
+        markerIds.insert(marker.attributes.value("id").toString());
+    }
+
+    // The double arrow refers to both arrowheads, which are defined
+    const auto & doubleArrow = lines.at(0).attributes.hasAttribute("marker-start") ? lines.at(0) : lines.at(1);
+    const auto & hiddenArrow = &doubleArrow == &lines.at(0) ? lines.at(1) : lines.at(0);
+    for (auto && marker : { "marker-start", "marker-end" }) {
+        const auto reference = doubleArrow.attributes.value(marker).toString();
+        QVERIFY(reference.startsWith("url(#") && reference.endsWith(")"));
+        QVERIFY(markerIds.count(reference.mid(5, reference.size() - 6)));
+        QVERIFY(!hiddenArrow.attributes.hasAttribute(marker));
+    }
+    QVERIFY(!doubleArrow.attributes.hasAttribute("stroke-dasharray"));
+    QVERIFY(hiddenArrow.attributes.hasAttribute("stroke-dasharray"));
+
+    // The end points are those of the laid out edges, written with a limited precision
+    const auto edge = data->graph().getEdge(0, 1);
+    QVERIFY(edge);
+    QVERIFY(std::abs(doubleArrow.attributes.value("x1").toDouble() - edge->line().x1()) < 0.001);
+    QVERIFY(std::abs(doubleArrow.attributes.value("y1").toDouble() - edge->line().y1()) < 0.001);
+    QVERIFY(std::abs(doubleArrow.attributes.value("x2").toDouble() - edge->line().x2()) < 0.001);
+    QVERIFY(std::abs(doubleArrow.attributes.value("y2").toDouble() - edge->line().y2()) < 0.001);
+
+    QCOMPARE(document.textsInGroup("edge-labels"), QStringList { "Edge label" });
+}
+
+void SvgWriterTest::testGrid()
+{
+    const auto document = writeAndParse(createTestData(), "Grid", { -500, -100, 1000, 400 }, { { 0, -100, 0, 300 }, { -500, 0, 500, 0 } });
+    QVERIFY(document.ok);
+    QCOMPARE(document.elementsInGroup("line", "grid").size(), size_t { 2 });
+
+    // No grid group without grid lines
+    const auto withoutGrid = writeAndParse(createTestData(), "Grid", { -500, -100, 1000, 400 });
+    QVERIFY(withoutGrid.ok);
+    QVERIFY(withoutGrid.elementsInGroup("line", "grid").empty());
+}
+
+void SvgWriterTest::testNodes()
+{
+    const auto data = createTestData();
+    const auto document = writeAndParse(data, "Nodes", { -500, -100, 1000, 400 });
+    QVERIFY(document.ok);
+
+    const auto nodes = document.elementsInGroup("g", "nodes");
+    QCOMPARE(nodes.size(), data->graph().nodeCount());
+    for (auto && node : nodes) {
+        QCOMPARE(node.attributes.value("class").toString(), QString { "node" });
+    }
+
+    // The node rects are centered on the node locations
+    const auto rects = document.elementsInGroup("rect", "nodes");
+    QCOMPARE(rects.size(), data->graph().nodeCount());
+    const auto node1 = data->graph().getNode(1);
+    const auto rect = std::find_if(rects.begin(), rects.end(), [](auto && rect) {
+        return rect.attributes.value("fill").toString() == QColor(10, 20, 30).name();
+    });
+    QVERIFY(rect != rects.end());
+    QCOMPARE(rect->attributes.value("x").toDouble() + rect->attributes.value("width").toDouble() / 2, node1->location().x());
+    QCOMPARE(rect->attributes.value("y").toDouble() + rect->attributes.value("height").toDouble() / 2, node1->location().y());
+
+    // Each line of the text is a span of its own
+    QCOMPARE(document.textsInGroup("nodes"), (QStringList { "First line", "Second line" }));
+}
+
+void SvgWriterTest::testTextEscaping()
+{
+    const auto data = createTestData();
+    const QString nodeText { "<b>Tom & \"Jerry\"</b> 'quoted' ]]>" };
+    data->graph().getNode(2)->setText(nodeText);
+    const QString edgeText { "A < B && C > D" };
+    data->graph().getEdge(0, 2)->setText(edgeText);
+    const QString title { "Title with <markup> & entities &amp;" };
+
+    const auto document = writeAndParse(data, title, { -500, -100, 1000, 400 });
+    QVERIFY(document.ok);
+
+    QVERIFY(document.textsInGroup("nodes").contains(nodeText));
+    QVERIFY(document.textsInGroup("edge-labels").contains(edgeText));
+    const auto titles = document.elementsInGroup("title", "");
+    QCOMPARE(titles.size(), size_t { 1 });
+    QCOMPARE(titles.at(0).text, title);
+
+    // No markup of the texts became elements
+    QVERIFY(document.elementsInGroup("b", "nodes").empty());
+    QVERIFY(document.elementsInGroup("markup", "").empty());
+}
+
+void SvgWriterTest::testViewBox()
+{
+    const auto document = writeAndParse(createTestData(), "View box", { -500.5, -100, 1000, 400.25 });
+    QVERIFY(document.ok);
+    QVERIFY(!document.elements.empty());
+
+    auto && svg = document.elements.at(0);
+    QCOMPARE(svg.name, QString { "svg" });
+    QCOMPARE(svg.attributes.value("viewBox").toString(), QString { "-500.5 -100 1000 400.25" });
+    QCOMPARE(svg.attributes.value("width").toString(), QString { "1000" });
+    QCOMPARE(svg.attributes.value("height").toString(), QString { "400.25" });
+
+    // The background covers the view box
+    const auto background = std::find_if(document.elements.begin(), document.elements.end(), [](auto && element) {
+        return element.attributes.value("id") == QString { "background" };
+    });
+    QVERIFY(background != document.elements.end());
+    QCOMPARE(background->attributes.value("x").toDouble(), -500.5);
+    QCOMPARE(background->attributes.value("height").toDouble(), 400.25);
+}
+
+QTEST_MAIN(SvgWriterTest)
@@ -0,0 +1,260 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "task_pool_test.hpp"
+
+#include "../../application/task_chain.hpp"
+#include "../../application/task_pool.hpp"
+#include "../../common/test_mode.hpp"
+
+#include <QThread>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+//! Keeps tasks running until released.
+class Gate
+{
+public:
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this] {
+            return m_isOpen;
+        });
+    }
+
+    void open()
+    {
+        {
+            const std::lock_guard<std::mutex> lock(m_mutex);
+            m_isOpen = true;
+        }
+        m_condition.notify_all();
+    }
+
+private:
+    std::mutex m_mutex;
+
+    std::condition_variable m_condition;
+
+    bool m_isOpen = false;
+};
+
+} // namespace
+
+TaskPoolTest::TaskPoolTest()
+{
+    TestMode::setEnabled(true);
+}
+
+void TaskPoolTest::testCancelledTaskIsSkipped()
+{
+    TaskPool dut;
+    Gate gate;
+    std::vector<TaskPool::Handle> blockers;
+    for (size_t i = 0; i < dut.threadCount(); i++) {
+        blockers.push_back(dut.start([&](auto &&) {
+            gate.wait();
+        }));
+    }
+
+    std::atomic<bool> isRun { false };
+    bool isContinued = false;
+    auto handle = dut.start(
+      [&](auto &&) {
+          isRun = true;
+      },
+      TaskPool::Priority::Normal, [&] {
+          isContinued = true;
+      });
+    handle.cancel();
+    gate.open();
+
+    handle.wait();
+    QVERIFY(handle.isFinished());
+    QVERIFY(handle.isCancelled());
+    QVERIFY(!isRun);
+
+    QTest::qWait(20);
+    QVERIFY(!isContinued);
+}
+
+void TaskPoolTest::testChainCancel()
+{
+    TaskPool dut;
+    std::vector<int> steps;
+    std::optional<TaskChain::Result> result;
+    const auto chain = TaskChain::create(dut);
+    chain->onGuiThread([&] {
+        steps.push_back(1);
+        chain->cancel();
+    });
+    chain->inBackground([&] {
+        steps.push_back(2);
+    });
+    chain->start([&](TaskChain::Result chainResult, QString) {
+        result = chainResult;
+    });
+
+    QTRY_VERIFY(result.has_value());
+    QCOMPARE(*result, TaskChain::Result::Cancelled);
+    QCOMPARE(steps, std::vector<int>({ 1 }));
+}
+
+void TaskPoolTest::testChainRunsStepsInOrder()
+{
+    TaskPool dut;
+    std::vector<int> steps;
+    std::atomic<QThread *> backgroundThread { nullptr };
+    QThread * guiStepThread = nullptr;
+    std::optional<TaskChain::Result> result;
+    TaskChain::create(dut)
+      ->onGuiThread([&] {
+          steps.push_back(1);
+      })
+      .inBackground([&] {
+          backgroundThread = QThread::currentThread();
+          steps.push_back(2);
+      })
+      .onGuiThread([&] {
+          guiStepThread = QThread::currentThread();
+          steps.push_back(3);
+      })
+      .start([&](TaskChain::Result chainResult, QString) {
+          result = chainResult;
+      });
+
+    // Nothing runs before the event loop does
+    QVERIFY(steps.empty());
+
+    QTRY_VERIFY(result.has_value());
+    QCOMPARE(*result, TaskChain::Result::Finished);
+    QCOMPARE(steps, std::vector<int>({ 1, 2, 3 }));
+    QVERIFY(backgroundThread.load() != QThread::currentThread());
+    QCOMPARE(guiStepThread, QThread::currentThread());
+}
+
+void TaskPoolTest::testChainStopsOnException()
+{
+    TaskPool dut;
+    bool isLastStepRun = false;
+    std::optional<TaskChain::Result> result;
+    QString error;
+    TaskChain::create(dut)
+      ->inBackground([] {
+          throw std::runtime_error("Read failed");
+      })
+      .onGuiThread([&] {
+          isLastStepRun = true;
+      })
+      .start([&](TaskChain::Result chainResult, QString chainError) {
+          result = chainResult;
+          error = chainError;
+      });
+
+    QTRY_VERIFY(result.has_value());
+    QCOMPARE(*result, TaskChain::Result::Failed);
+    QCOMPARE(error, QString("Read failed"));
+    QVERIFY(!isLastStepRun);
+}
+
+void TaskPoolTest::testContinuationIsCalledOnGuiThread()
+{
+    TaskPool dut;
+    std::atomic<QThread *> taskThread { nullptr };
+    QThread * continuationThread = nullptr;
+    dut.start(
+      [&](auto &&) {
+          taskThread = QThread::currentThread();
+      },
+      TaskPool::Priority::Normal, [&] {
+          continuationThread = QThread::currentThread();
+      });
+
+    QTRY_VERIFY(continuationThread);
+    QCOMPARE(continuationThread, QThread::currentThread());
+    QVERIFY(taskThread.load() != QThread::currentThread());
+}
+
+void TaskPoolTest::testNestedRunWithBusyWorkers()
+{
+    TaskPool dut;
+    const size_t chunkCount = dut.threadCount() * 2;
+    std::atomic<size_t> sum { 0 };
+
+    // Every worker runs a task that waits for chunks of its own, which would deadlock without taking the chunks back
+    std::vector<TaskPool::Handle> handles;
+    for (size_t i = 0; i < dut.threadCount(); i++) {
+        handles.push_back(dut.start([&](auto &&) {
+            dut.run(chunkCount, [&](size_t chunk) {
+                sum += chunk;
+            });
+        }));
+    }
+    for (auto && handle : handles) {
+        handle.wait();
+    }
+
+    QCOMPARE(sum.load(), dut.threadCount() * chunkCount * (chunkCount - 1) / 2);
+}
+
+void TaskPoolTest::testParallelForCoversRange()
+{
+    TaskPool dut;
+    const size_t count = 10007;
+    std::vector<int> visits(count, 0);
+    dut.parallelFor(count, 100, [&](size_t begin, size_t end) {
+        for (auto i = begin; i < end; i++) {
+            visits[i]++;
+        }
+    });
+
+    QVERIFY(std::all_of(visits.begin(), visits.end(), [](int visitCount) {
+        return visitCount == 1;
+    }));
+    QCOMPARE(dut.chunkCount(count, 100), std::min<size_t>(100, dut.threadCount()));
+    QCOMPARE(dut.chunkCount(10, 100), size_t(1));
+}
+
+void TaskPoolTest::testRunRethrows()
+{
+    TaskPool dut;
+    std::atomic<size_t> runCount { 0 };
+    bool isThrown = false;
+    try {
+        dut.run(4, [&](size_t chunk) {
+            runCount++;
+            if (chunk == 2) {
+                throw std::runtime_error("Chunk failed");
+            }
+        });
+    } catch (const std::runtime_error &) {
+        isThrown = true;
+    }
+
+    QVERIFY(isThrown);
+    // The other chunks still finish before the exception is rethrown
+    QCOMPARE(runCount.load(), size_t(4));
+}
+
+QTEST_GUILESS_MAIN(TaskPoolTest)
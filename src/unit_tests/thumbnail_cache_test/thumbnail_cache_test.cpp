@@ -0,0 +1,110 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "thumbnail_cache_test.hpp"
+
+#include "../../application/thumbnail_cache.hpp"
+#include "../../common/constants.hpp"
+#include "../../common/test_mode.hpp"
+#include "../../domain/graph_snapshot.hpp"
+#include "../../domain/mind_map_data.hpp"
+
+#include <QDir>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+#include <algorithm>
+
+namespace {
+
+MindMapData createMindMapData()
+{
+    SceneItems::NodeModel node0 { Qt::red, Qt::black };
+    node0.index = 0;
+    node0.size = { 200, 100 };
+    SceneItems::NodeModel node1 { Qt::blue, Qt::black };
+    node1.index = 1;
+    node1.location = { 400, 300 };
+    node1.size = { 200, 100 };
+    const SceneItems::EdgeModel edge { false, { SceneItems::EdgeModel::ArrowMode::Single } };
+
+    MindMapData mindMapData;
+    mindMapData.setGraphSnapshot({ { node0, node1 }, { { edge, 0, 1 } } });
+    return mindMapData;
+}
+
+int longestSide(const QImage & image)
+{
+    return std::max(image.width(), image.height());
+}
+
+} // namespace
+
+ThumbnailCacheTest::ThumbnailCacheTest()
+{
+    TestMode::setEnabled(true);
+}
+
+void ThumbnailCacheTest::testGenerateAndLookup()
+{
+    QTemporaryDir cacheDir;
+    const auto filePath = QDir { cacheDir.path() }.filePath("a.alz");
+    const auto sizes = Constants::View::thumbnailSizes();
+    {
+        ThumbnailCache dut { cacheDir.path() };
+        QVERIFY(dut.thumbnail(filePath, sizes.first()).isNull());
+
+        QSignalSpy generatedSpy { &dut, &ThumbnailCache::thumbnailGenerated };
+        dut.generate(filePath, createMindMapData());
+        QTRY_COMPARE(generatedSpy.count(), 1);
+
+        QVERIFY(std::abs(longestSide(dut.thumbnail(filePath, 1)) - sizes.first()) <= 1);
+        QVERIFY(std::abs(longestSide(dut.thumbnail(filePath, sizes.first() + 1)) - sizes.at(1)) <= 1);
+        QVERIFY(std::abs(longestSide(dut.thumbnail(filePath, sizes.last() * 2)) - sizes.last()) <= 1);
+    }
+
+    // The index is persisted with the images
+    ThumbnailCache dut { cacheDir.path() };
+    QVERIFY(!dut.thumbnail(filePath, sizes.first()).isNull());
+}
+
+void ThumbnailCacheTest::testRetainRemovesUnusedImages()
+{
+    QTemporaryDir cacheDir;
+    const auto filePathA = QDir { cacheDir.path() }.filePath("a.alz");
+    const auto filePathB = QDir { cacheDir.path() }.filePath("b.alz");
+    const auto sizes = Constants::View::thumbnailSizes();
+
+    ThumbnailCache dut { cacheDir.path() };
+    QSignalSpy generatedSpy { &dut, &ThumbnailCache::thumbnailGenerated };
+    dut.generate(filePathA, createMindMapData());
+    dut.generate(filePathB, createMindMapData());
+    QTRY_COMPARE(generatedSpy.count(), 2);
+
+    // Identical mind maps share the images
+    const auto imageFilter = QStringList { "*.png" };
+    QCOMPARE(QDir { cacheDir.path() }.entryList(imageFilter).size(), sizes.size());
+
+    dut.retain({ filePathA });
+    QVERIFY(!dut.thumbnail(filePathA, sizes.first()).isNull());
+    QVERIFY(dut.thumbnail(filePathB, sizes.first()).isNull());
+    QCOMPARE(QDir { cacheDir.path() }.entryList(imageFilter).size(), sizes.size());
+
+    dut.retain({});
+    QVERIFY(dut.thumbnail(filePathA, sizes.first()).isNull());
+    QVERIFY(QDir { cacheDir.path() }.entryList(imageFilter).isEmpty());
+}
+
+QTEST_GUILESS_MAIN(ThumbnailCacheTest)
@@ -0,0 +1,105 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "trace_recorder_test.hpp"
+
+#include "../../common/trace_recorder.hpp"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+
+#include <set>
+#include <thread>
+#include <vector>
+
+void TraceRecorderTest::testDisabled_shouldNotRecord()
+{
+    QVERIFY(!TraceRecorder::enabled());
+
+    {
+        const TraceRecorder::ScopedSpan span { "Disabled" };
+    }
+
+    QCOMPARE(TraceRecorder::spanCount(), size_t { 0 });
+}
+
+void TraceRecorderTest::testSpansOfThreads_shouldBeWrittenAsChromeTrace()
+{
+    QTemporaryDir dir;
+    const auto fileName = dir.filePath("trace.json");
+    TraceRecorder::setOutputFile(fileName.toStdString());
+    QVERIFY(TraceRecorder::enabled());
+
+    {
+        const TraceRecorder::ScopedSpan span { "Outer" };
+        const TraceRecorder::ScopedSpan innerSpan { "Inner" };
+    }
+
+    // More spans than fit in a single buffer chunk
+    const size_t threadCount = 4;
+    const size_t spansPerThread = 10000;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < threadCount; i++) {
+        threads.emplace_back([] {
+            for (size_t j = 0; j < spansPerThread; j++) {
+                const TraceRecorder::ScopedSpan span { "Worker" };
+            }
+        });
+    }
+    for (auto && thread : threads) {
+        thread.join();
+    }
+
+    QCOMPARE(TraceRecorder::spanCount(), 2 + threadCount * spansPerThread);
+
+    TraceRecorder::writeTrace();
+
+    QFile file { fileName };
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QJsonParseError error;
+    const auto document = QJsonDocument::fromJson(file.readAll(), &error);
+    QCOMPARE(error.error, QJsonParseError::NoError);
+
+    size_t workerSpanCount = 0;
+    std::set<int> workerThreadIds;
+    QJsonObject outerSpan;
+    QJsonObject innerSpan;
+    for (auto && value : document.object().value("traceEvents").toArray()) {
+        const auto event = value.toObject();
+        if (event.value("ph").toString() != "X") {
+            continue;
+        }
+        const auto name = event.value("name").toString();
+        if (name == "Worker") {
+            workerSpanCount++;
+            workerThreadIds.insert(event.value("tid").toInt());
+        } else if (name == "Outer") {
+            outerSpan = event;
+        } else if (name == "Inner") {
+            innerSpan = event;
+        }
+    }
+
+    QCOMPARE(workerSpanCount, threadCount * spansPerThread);
+    QCOMPARE(workerThreadIds.size(), threadCount);
+    QVERIFY(!workerThreadIds.count(outerSpan.value("tid").toInt()));
+    QVERIFY(innerSpan.value("ts").toDouble() >= outerSpan.value("ts").toDouble());
+    QVERIFY(innerSpan.value("dur").toDouble() <= outerSpan.value("dur").toDouble());
+}
+
+QTEST_GUILESS_MAIN(TraceRecorderTest)
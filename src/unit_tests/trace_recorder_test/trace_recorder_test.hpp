@@ -1,5 +1,5 @@
 // This file is part of Heimer.
-// Copyright (C) 2018 Jussi Lind <jussi.lind@iki.fi>
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
 //
 // Heimer is free software: you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -13,13 +13,22 @@
 // You should have received a copy of the GNU General Public License
 // along with Heimer. If not, see <http://www.gnu.org/licenses/>.
 
-#ifndef XML_WRITER_HPP
-#define XML_WRITER_HPP
+#ifndef TRACE_RECORDER_TEST_HPP
+#define TRACE_RECORDER_TEST_HPP
 
-#include <QDomDocument>
+#include <QTest>
 
-namespace IO::XmlWriter {
-bool writeToFile(QDomDocument document, QString filePath);
-}
+#include "../unit_test_base.hpp"
 
-#endif // XML_WRITER_HPP
+class TraceRecorderTest : public UnitTestBase
+{
+    Q_OBJECT
+
+private slots:
+
+    void testDisabled_shouldNotRecord();
+
+    void testSpansOfThreads_shouldBeWrittenAsChromeTrace();
+};
+
+#endif // TRACE_RECORDER_TEST_HPP
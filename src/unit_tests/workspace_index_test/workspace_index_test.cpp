@@ -0,0 +1,119 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "workspace_index_test.hpp"
+
+#include "../../application/workspace_index.hpp"
+#include "../../common/test_mode.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+namespace {
+
+void writeMindMap(QString filePath, QString nodeText0, QString nodeText1, QString edgeText)
+{
+    QFile file { filePath };
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(QString { "<?xml version='1.0'?>"
+                         "<heimer-mind-map version='4.0.0'><graph>"
+                         "<node index='0' x='0' y='0'><text>%1</text></node>"
+                         "<node index='1' x='0' y='0'><text>%2</text></node>"
+                         "<edge index0='0' index1='1'><text>%3</text></edge>"
+                         "</graph></heimer-mind-map>" }
+                 .arg(nodeText0, nodeText1, edgeText)
+                 .toUtf8());
+}
+
+} // namespace
+
+WorkspaceIndexTest::WorkspaceIndexTest()
+{
+    TestMode::setEnabled(true);
+}
+
+void WorkspaceIndexTest::testSearchFindsNodeAndEdgeTexts()
+{
+    QTemporaryDir indexDir;
+    QTemporaryDir workspaceDir;
+    QVERIFY(QDir { workspaceDir.path() }.mkdir("sub"));
+    const auto filePathA = QDir { workspaceDir.path() }.filePath("a.alz");
+    const auto filePathB = QDir { workspaceDir.path() }.filePath("sub/b.alz");
+    writeMindMap(filePathA, "Apple pie", "Recipes", "needs");
+    writeMindMap(filePathB, "Banana split", "apple", "");
+    {
+        WorkspaceIndex dut { indexDir.path() };
+        QVERIFY(dut.directory().isEmpty());
+
+        QSignalSpy updateFinishedSpy { &dut, &WorkspaceIndex::updateFinished };
+        dut.update(workspaceDir.path());
+        QVERIFY(dut.isUpdating());
+        QTRY_COMPARE(updateFinishedSpy.count(), 1);
+        QVERIFY(!dut.isUpdating());
+        QCOMPARE(dut.fileCount(), static_cast<size_t>(2));
+
+        // The exact match of b ranks above the prefix match of a
+        const auto hits = dut.search("APPLE", 10);
+        QCOMPARE(hits.size(), static_cast<size_t>(2));
+        QCOMPARE(hits.at(0).filePath, filePathB);
+        QCOMPARE(hits.at(0).text, QString { "apple" });
+        QCOMPARE(hits.at(1).filePath, filePathA);
+        QCOMPARE(hits.at(1).text, QString { "Apple pie" });
+
+        QCOMPARE(dut.search("apple", 1).size(), static_cast<size_t>(1));
+        QCOMPARE(dut.search("needs", 10).at(0).filePath, filePathA);
+        QVERIFY(dut.search("cherry", 10).empty());
+        QVERIFY(dut.search("", 10).empty());
+    }
+
+    // The index is persisted
+    WorkspaceIndex dut { indexDir.path() };
+    QCOMPARE(QDir { dut.directory() }, QDir { workspaceDir.path() });
+    QCOMPARE(dut.fileCount(), static_cast<size_t>(2));
+    QCOMPARE(dut.search("split", 10).at(0).filePath, filePathB);
+}
+
+void WorkspaceIndexTest::testUpdateFollowsChangedAndRemovedFiles()
+{
+    QTemporaryDir indexDir;
+    QTemporaryDir workspaceDir;
+    const auto filePathA = QDir { workspaceDir.path() }.filePath("a.alz");
+    const auto filePathB = QDir { workspaceDir.path() }.filePath("b.alz");
+    writeMindMap(filePathA, "Apple", "Cherry", "");
+    writeMindMap(filePathB, "Banana", "Cherry", "");
+    // Not a mind map
+    writeMindMap(QDir { workspaceDir.path() }.filePath("c.txt"), "Cherry", "", "");
+
+    WorkspaceIndex dut { indexDir.path() };
+    QSignalSpy updateFinishedSpy { &dut, &WorkspaceIndex::updateFinished };
+    dut.update(workspaceDir.path());
+    QTRY_COMPARE(updateFinishedSpy.count(), 1);
+    QCOMPARE(dut.search("cherry", 10).size(), static_cast<size_t>(2));
+
+    // The size changes even if the modification time doesn't within its resolution
+    writeMindMap(filePathA, "Apricot", "Date palm", "");
+    QVERIFY(QFile::remove(filePathB));
+    dut.update(workspaceDir.path());
+    QTRY_COMPARE(updateFinishedSpy.count(), 2);
+
+    QCOMPARE(dut.fileCount(), static_cast<size_t>(1));
+    QVERIFY(dut.search("cherry", 10).empty());
+    QVERIFY(dut.search("banana", 10).empty());
+    QCOMPARE(dut.search("date", 10).at(0).text, QString { "Date palm" });
+}
+
+QTEST_GUILESS_MAIN(WorkspaceIndexTest)
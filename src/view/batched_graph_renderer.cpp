@@ -0,0 +1,274 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "batched_graph_renderer.hpp"
+
+#include "../domain/graph.hpp"
+#include "../domain/mind_map_data.hpp"
+#include "scene_items/edge.hpp"
+#include "scene_items/node.hpp"
+
+#include <QPainter>
+#include <QPen>
+
+BatchedGraphRenderer::BatchedGraphRenderer() = default;
+
+BatchedGraphRenderer::~BatchedGraphRenderer()
+{
+    unsubscribe();
+}
+
+void BatchedGraphRenderer::setMindMapData(MindMapDataS mindMapData)
+{
+    unsubscribe();
+
+    m_mindMapData = mindMapData;
+    m_nodes.clear();
+    m_nodeCount = 0;
+    m_collapsedIndices.clear();
+    m_edges.clear();
+    m_isRebuildPending = true;
+    m_areBatchesDirty = true;
+
+    if (mindMapData) {
+        m_graph = &mindMapData->graph();
+        m_subscriptionId = mindMapData->graph().changeNotifier().subscribe([this](const GraphChangeBatch & changes) {
+            handleChanges(changes);
+        });
+    }
+}
+
+void BatchedGraphRenderer::unsubscribe()
+{
+    if (m_subscriptionId) {
+        if (const auto mindMapData = m_mindMapData.lock(); mindMapData && &mindMapData->graph() == m_graph) {
+            mindMapData->graph().changeNotifier().unsubscribe(m_subscriptionId);
+        }
+        m_subscriptionId = 0;
+    }
+    m_graph = nullptr;
+}
+
+void BatchedGraphRenderer::draw(QPainter & painter, const QRectF & sceneRect)
+{
+    updateBatches();
+
+    const bool isEverythingVisible = sceneRect.contains(m_boundingRect);
+
+    painter.save();
+    // Hairlines and axis-aligned rects, so nothing to antialias
+    painter.setRenderHint(QPainter::Antialiasing, false);
+
+    // Zero width makes a cosmetic one pixel pen like the edges of the Minimal level of detail
+    painter.setPen(QPen { m_edgeColor, 0 });
+    if (isEverythingVisible) {
+        painter.drawLines(m_edgeLines);
+    } else {
+        QVector<QLineF> lines;
+        for (auto && line : m_edgeLines) {
+            if (QRectF { line.p1(), line.p2() }.normalized().intersects(sceneRect)) {
+                lines.push_back(line);
+            }
+        }
+        painter.drawLines(lines);
+    }
+
+    painter.setPen(Qt::NoPen);
+    QVector<QRectF> rects;
+    for (auto && batch : m_nodeBatches) {
+        painter.setBrush(batch.color);
+        if (isEverythingVisible) {
+            painter.drawRects(batch.rects);
+        } else {
+            rects.clear();
+            for (auto && rect : batch.rects) {
+                if (rect.intersects(sceneRect)) {
+                    rects.push_back(rect);
+                }
+            }
+            painter.drawRects(rects);
+        }
+    }
+
+    painter.restore();
+}
+
+const std::vector<BatchedGraphRenderer::NodeBatch> & BatchedGraphRenderer::nodeBatches()
+{
+    updateBatches();
+    return m_nodeBatches;
+}
+
+const QVector<QLineF> & BatchedGraphRenderer::edgeLines()
+{
+    updateBatches();
+    return m_edgeLines;
+}
+
+void BatchedGraphRenderer::handleChanges(const GraphChangeBatch & changes)
+{
+    const auto mindMapData = m_mindMapData.lock();
+    if (!mindMapData || &mindMapData->graph() != m_graph || m_isRebuildPending) {
+        return;
+    }
+
+    const auto & graph = mindMapData->graph();
+    for (auto && change : changes) {
+        switch (change.type) {
+        case GraphChange::Type::NodeAdded:
+        case GraphChange::Type::NodeMoved:
+        case GraphChange::Type::NodeRestyled:
+            // The node may have been deleted again later in the same batch
+            if (graph.hasNode(change.nodeIndex)) {
+                updateNode(graph, change.nodeIndex);
+            } else {
+                removeNode(change.nodeIndex);
+            }
+            break;
+        case GraphChange::Type::NodeRemoved:
+            removeNode(change.nodeIndex);
+            break;
+        case GraphChange::Type::EdgeAdded:
+            m_edges[Graph::buildKeyFromIndices(change.sourceIndex, change.targetIndex)] = { change.sourceIndex, change.targetIndex };
+            break;
+        case GraphChange::Type::EdgeRemoved:
+            m_edges.erase(Graph::buildKeyFromIndices(change.sourceIndex, change.targetIndex));
+            break;
+        case GraphChange::Type::StyleChanged:
+            break;
+        case GraphChange::Type::NodeTexted:
+        case GraphChange::Type::EdgeRestyled:
+        case GraphChange::Type::EdgeTexted:
+            // Not visible in the batches
+            continue;
+        }
+        m_areBatchesDirty = true;
+    }
+}
+
+void BatchedGraphRenderer::updateNode(const Graph & graph, int index)
+{
+    const auto node = graph.getNode(index);
+    if (static_cast<size_t>(index) >= m_nodes.size()) {
+        m_nodes.resize(static_cast<size_t>(index) + 1);
+    }
+
+    auto && entry = m_nodes.at(static_cast<size_t>(index));
+    if (!entry.valid) {
+        entry.valid = true;
+        m_nodeCount++;
+    }
+    const auto size = node->size();
+    entry.rect = { node->location() - QPointF { size.width() / 2, size.height() / 2 }, size };
+    entry.color = node->color();
+    entry.collapsed = node->collapsed();
+    if (entry.collapsed) {
+        m_collapsedIndices.insert(index);
+    } else {
+        m_collapsedIndices.erase(index);
+    }
+}
+
+void BatchedGraphRenderer::removeNode(int index)
+{
+    if (static_cast<size_t>(index) < m_nodes.size() && m_nodes.at(static_cast<size_t>(index)).valid) {
+        m_nodes.at(static_cast<size_t>(index)) = {};
+        m_nodeCount--;
+    }
+    m_collapsedIndices.erase(index);
+}
+
+void BatchedGraphRenderer::rebuildEntries(const Graph & graph)
+{
+    m_nodes.clear();
+    m_nodeCount = 0;
+    m_collapsedIndices.clear();
+    for (auto && node : graph.nodes()) {
+        updateNode(graph, node->index());
+    }
+
+    m_edges.clear();
+    graph.forEachEdge([this](auto && edge) {
+        const auto sourceIndex = edge->sourceNode().index();
+        const auto targetIndex = edge->targetNode().index();
+        m_edges[Graph::buildKeyFromIndices(sourceIndex, targetIndex)] = { sourceIndex, targetIndex };
+    });
+
+    m_isRebuildPending = false;
+    m_areBatchesDirty = true;
+}
+
+void BatchedGraphRenderer::updateBatches()
+{
+    const auto mindMapData = m_mindMapData.lock();
+    if (!mindMapData || &mindMapData->graph() != m_graph) {
+        // The mind map is gone or its graph has been replaced without a notification
+        if (!m_nodeBatches.empty() || !m_edgeLines.isEmpty()) {
+            m_nodeBatches.clear();
+            m_edgeLines.clear();
+            m_boundingRect = {};
+        }
+        return;
+    }
+
+    const auto & graph = mindMapData->graph();
+    // Clearing the graph isn't in the change stream
+    if (m_isRebuildPending || m_nodeCount != graph.nodeCount() || m_edges.size() != graph.edgeCount()) {
+        rebuildEntries(graph);
+    }
+
+    // Applied when drawing, so a change of the edge color doesn't regroup the batches
+    m_edgeColor = mindMapData->edgeColor();
+
+    if (!m_areBatchesDirty) {
+        return;
+    }
+
+    std::unordered_set<int> hiddenIndices;
+    for (auto && index : m_collapsedIndices) {
+        const auto descendantIndices = graph.descendantIndices(index);
+        hiddenIndices.insert(descendantIndices.begin(), descendantIndices.end());
+    }
+
+    const auto isVisible = [this, &hiddenIndices](int index) {
+        return static_cast<size_t>(index) < m_nodes.size() && m_nodes.at(static_cast<size_t>(index)).valid && !hiddenIndices.count(index);
+    };
+
+    m_nodeBatches.clear();
+    m_boundingRect = {};
+    std::unordered_map<QRgb, size_t> batchIndices;
+    for (size_t index = 0; index < m_nodes.size(); index++) {
+        if (!isVisible(static_cast<int>(index))) {
+            continue;
+        }
+        auto && entry = m_nodes.at(index);
+        const auto [iter, isNewColor] = batchIndices.insert({ entry.color.rgba(), m_nodeBatches.size() });
+        if (isNewColor) {
+            m_nodeBatches.push_back({ entry.color, {} });
+        }
+        m_nodeBatches.at(iter->second).rects.push_back(entry.rect);
+        m_boundingRect = m_boundingRect.united(entry.rect);
+    }
+
+    m_edgeLines.clear();
+    m_edgeLines.reserve(static_cast<int>(m_edges.size()));
+    for (auto && edge : m_edges) {
+        if (isVisible(edge.second.first) && isVisible(edge.second.second)) {
+            m_edgeLines.push_back({ m_nodes.at(static_cast<size_t>(edge.second.first)).rect.center(), m_nodes.at(static_cast<size_t>(edge.second.second)).rect.center() });
+        }
+    }
+
+    m_areBatchesDirty = false;
+}
@@ -0,0 +1,127 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef BATCHED_GRAPH_RENDERER_HPP
+#define BATCHED_GRAPH_RENDERER_HPP
+
+#include "../common/types.hpp"
+#include "../domain/graph_change_notifier.hpp"
+
+#include <QColor>
+#include <QLineF>
+#include <QRectF>
+#include <QVector>
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class Graph;
+class QPainter;
+
+//! Draws the nodes and edges of a mind map like the Minimal level of detail, i.e. as flat rects and hairlines,
+//! but as a few batches instead of item by item: one draw call per node color and one for all edges. The batches
+//! are built from the plain data of the graph without the scene and follow its change stream, so that a change
+//! only updates the entries of the changed items and the batches are regrouped once before the next frame.
+//! EditorView uses it for very large mind maps zoomed far out, see SettingsProxy::batchedRendering().
+class BatchedGraphRenderer
+{
+public:
+    //! The rects of the nodes of the same color.
+    struct NodeBatch
+    {
+        QColor color;
+
+        QVector<QRectF> rects;
+    };
+
+    BatchedGraphRenderer();
+
+    ~BatchedGraphRenderer();
+
+    BatchedGraphRenderer(const BatchedGraphRenderer &) = delete;
+
+    BatchedGraphRenderer & operator=(const BatchedGraphRenderer &) = delete;
+
+    //! Follows the graph of the given mind map until another one is set. The mind map is not kept alive.
+    void setMindMapData(MindMapDataS mindMapData);
+
+    //! Draws the nodes and edges that intersect the given scene rect with the current transform of the painter.
+    void draw(QPainter & painter, const QRectF & sceneRect);
+
+    //! \returns The node batches of the next frame. The descendants of collapsed nodes are left out.
+    const std::vector<NodeBatch> & nodeBatches();
+
+    //! \returns The edge lines of the next frame, between the centers of the nodes.
+    const QVector<QLineF> & edgeLines();
+
+private:
+    void handleChanges(const GraphChangeBatch & changes);
+
+    void unsubscribe();
+
+    void updateNode(const Graph & graph, int index);
+
+    void removeNode(int index);
+
+    //! Regroups the batches if something has changed since the last frame.
+    void updateBatches();
+
+    void rebuildEntries(const Graph & graph);
+
+    std::weak_ptr<MindMapData> m_mindMapData;
+
+    //! Only compared with the graph of the mind map, which may have been replaced since subscribing.
+    const Graph * m_graph = nullptr;
+
+    GraphChangeNotifier::SubscriptionId m_subscriptionId = 0;
+
+    struct NodeEntry
+    {
+        bool valid = false;
+
+        bool collapsed = false;
+
+        QRectF rect;
+
+        QColor color;
+    };
+
+    //! By node index.
+    std::vector<NodeEntry> m_nodes;
+
+    size_t m_nodeCount = 0;
+
+    std::unordered_set<int> m_collapsedIndices;
+
+    //! Source and target indices by the edge key of the graph.
+    std::unordered_map<int64_t, std::pair<int, int>> m_edges;
+
+    bool m_isRebuildPending = true;
+
+    bool m_areBatchesDirty = true;
+
+    std::vector<NodeBatch> m_nodeBatches;
+
+    QVector<QLineF> m_edgeLines;
+
+    QColor m_edgeColor;
+
+    QRectF m_boundingRect;
+};
+
+#endif // BATCHED_GRAPH_RENDERER_HPP
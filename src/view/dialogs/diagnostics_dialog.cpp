@@ -0,0 +1,80 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "diagnostics_dialog.hpp"
+
+#include <QDialogButtonBox>
+#include <QGridLayout>
+#include <QGroupBox>
+#include <QLabel>
+#include <QLocale>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+namespace Dialogs {
+
+DiagnosticsDialog::DiagnosticsDialog(MemoryReportProvider memoryReportProvider, QWidget * parent)
+  : QDialog(parent)
+  , m_memoryReportProvider(memoryReportProvider)
+{
+    setWindowTitle(tr("Diagnostics"));
+    initWidgets();
+    refresh();
+}
+
+void DiagnosticsDialog::initWidgets()
+{
+    const auto vLayout = new QVBoxLayout(this);
+
+    const auto memoryGroup = new QGroupBox(tr("Estimated memory usage"), this);
+    m_reportLayout = new QGridLayout(memoryGroup);
+    vLayout->addWidget(memoryGroup);
+
+    const auto buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok);
+    const auto refreshButton = buttonBox->addButton(tr("Refresh"), QDialogButtonBox::ActionRole);
+    connect(refreshButton, &QPushButton::clicked, this, &DiagnosticsDialog::refresh);
+    connect(buttonBox, &QDialogButtonBox::accepted, this, &QDialog::accept);
+
+    vLayout->addWidget(buttonBox);
+}
+
+void DiagnosticsDialog::refresh()
+{
+    while (const auto item = m_reportLayout->takeAt(0)) {
+        delete item->widget();
+        delete item;
+    }
+
+    const auto addRow = [this](int row, QString name, QString count, QString size) {
+        m_reportLayout->addWidget(new QLabel(name), row, 0);
+        m_reportLayout->addWidget(new QLabel(count), row, 1, Qt::AlignRight);
+        m_reportLayout->addWidget(new QLabel(size), row, 2, Qt::AlignRight);
+    };
+
+    const auto formatSize = [](size_t bytes) {
+        return QLocale().toString(static_cast<double>(bytes) / 1024, 'f', 1) + " KiB";
+    };
+
+    const auto report = m_memoryReportProvider();
+    int row = 0;
+    addRow(row++, tr("Subsystem"), tr("Items"), tr("Size"));
+    for (auto && entry : report.entries) {
+        addRow(row++, entry.first, QLocale().toString(static_cast<qulonglong>(entry.second.itemCount)), formatSize(entry.second.bytes));
+    }
+    addRow(row++, tr("Total"), {}, formatSize(report.totalBytes()));
+    addRow(row, tr("Given back by cache trims"), QLocale().toString(static_cast<qulonglong>(report.reclaimed.itemCount)), formatSize(report.reclaimed.bytes));
+}
+
+} // namespace Dialogs
@@ -0,0 +1,53 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef DIAGNOSTICS_DIALOG_HPP
+#define DIAGNOSTICS_DIALOG_HPP
+
+#include <QDialog>
+
+#include <functional>
+
+#include "../../application/memory_report.hpp"
+
+class QGridLayout;
+
+namespace Dialogs {
+
+//! Dialog that shows the estimated memory usage per subsystem.
+class DiagnosticsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    using MemoryReportProvider = std::function<MemoryReport()>;
+
+    //! Constructor.
+    //! \param memoryReportProvider Called to get a fresh report on construction and on refresh.
+    explicit DiagnosticsDialog(MemoryReportProvider memoryReportProvider, QWidget * parent = nullptr);
+
+private:
+    void initWidgets();
+
+    void refresh();
+
+    MemoryReportProvider m_memoryReportProvider;
+
+    QGridLayout * m_reportLayout = nullptr;
+};
+
+} // namespace Dialogs
+
+#endif // DIAGNOSTICS_DIALOG_HPP
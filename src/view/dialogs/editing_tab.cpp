@@ -34,6 +34,7 @@ EditingTab::EditingTab(QString name, QWidget * parent)
   , m_invertedControlsCheckBox(new QCheckBox(tr("Inverted controls")))
   , m_autoloadCheckBox(new QCheckBox(tr("Enable autoload")))
   , m_autosaveCheckBox(new QCheckBox(tr("Enable autosave")))
+  , m_undoJournalCheckBox(new QCheckBox(tr("Keep undo history between sessions")))
 {
     initWidgets();
 }
@@ -50,6 +51,8 @@ void EditingTab::apply()
 
     settingsProxy()->setAutoload(m_autoloadCheckBox->isChecked());
 
+    settingsProxy()->setUndoJournal(m_undoJournalCheckBox->isChecked());
+
     settingsProxy()->setInvertedControls(m_invertedControlsCheckBox->isChecked());
 }
 
@@ -73,6 +76,11 @@ void EditingTab::initWidgets()
     m_autoloadCheckBox->setToolTip(tr("Autoload feature will automatically load your recent mind map on application start."));
     fileOperationsGroupLayout->addWidget(m_autoloadCheckBox);
 
+    fileOperationsGroupLayout->addWidget(WidgetFactory::buildHorizontalLine());
+
+    m_undoJournalCheckBox->setToolTip(tr("The undo history is kept in a file next to the mind map, so that it survives restarts and takes little memory. Takes effect when a mind map is opened or saved."));
+    fileOperationsGroupLayout->addWidget(m_undoJournalCheckBox);
+
     const auto && [controlsGroup, controlsGroupLayout] = WidgetFactory::buildGroupBoxWithVLayout(tr("Controls"), *mainLayout);
     m_invertedControlsCheckBox->setToolTip(tr("Scroll the view with a modifier key pressed and select a group of items without a modifier key being pressed."));
     controlsGroupLayout->addWidget(m_invertedControlsCheckBox);
@@ -92,6 +100,8 @@ void EditingTab::setActiveSettings()
 
     m_autoloadCheckBox->setChecked(settingsProxy()->autoload());
 
+    m_undoJournalCheckBox->setChecked(settingsProxy()->undoJournal());
+
     m_invertedControlsCheckBox->setChecked(settingsProxy()->invertedControls());
 }
 
@@ -48,6 +48,8 @@ private:
     QCheckBox * m_autoloadCheckBox = nullptr;
 
     QCheckBox * m_autosaveCheckBox = nullptr;
+
+    QCheckBox * m_undoJournalCheckBox = nullptr;
 };
 
 } // namespace Dialogs
@@ -38,7 +38,9 @@ EffectsTab::EffectsTab(QString name, QWidget * parent)
   , m_selectedItemShadowBlurRadiusSpinBox(new QSpinBox(this))
   , m_shadowColorButton(new ColorSettingButton(tr("Shadow color"), ColorDialog::Role::ShadowColor, this))
   , m_selectedItemShadowColorButton(new ColorSettingButton(tr("Selected item shadow color"), ColorDialog::Role::SelectedItemShadowColor, this))
-  , m_optimizeShadowsCheckBox(new QCheckBox(tr("Optimize shadow effects"), this))
+  , m_hardwareAccelerationCheckBox(new QCheckBox(tr("Use hardware acceleration (OpenGL)"), this))
+  , m_batchedRenderingCheckBox(new QCheckBox(tr("Draw very large mind maps in batches when zoomed out"), this))
+  , m_edgeBundlingCheckBox(new QCheckBox(tr("Bundle the edges of nodes with many edges"), this))
 {
     m_shadowOffsetSpinBox->setMinimum(m_shadowEffectMinOffset);
     m_shadowOffsetSpinBox->setMaximum(m_shadowEffectMaxOffset);
@@ -52,7 +54,11 @@ EffectsTab::EffectsTab(QString name, QWidget * parent)
     m_selectedItemShadowBlurRadiusSpinBox->setMaximum(m_shadowEffectMaxBlurRadius);
     m_selectedItemShadowBlurRadiusSpinBox->setValue(settingsProxy()->shadowEffect().selectedItemBlurRadius());
 
-    m_optimizeShadowsCheckBox->setChecked(settingsProxy()->optimizeShadowEffects());
+    m_hardwareAccelerationCheckBox->setChecked(settingsProxy()->hardwareAcceleration());
+
+    m_batchedRenderingCheckBox->setChecked(settingsProxy()->batchedRendering());
+
+    m_edgeBundlingCheckBox->setChecked(settingsProxy()->edgeBundling());
 
     initWidgets();
 
@@ -86,7 +92,15 @@ void EffectsTab::apply(const ShadowEffectParams & params)
         emit shadowEffectChanged(params);
     }
 
-    settingsProxy()->setOptimizeShadowEffects(m_optimizeShadowsCheckBox->isChecked());
+    if (settingsProxy()->hardwareAcceleration() != m_hardwareAccelerationCheckBox->isChecked()) {
+        settingsProxy()->setHardwareAcceleration(m_hardwareAccelerationCheckBox->isChecked());
+        emit hardwareAccelerationChanged(m_hardwareAccelerationCheckBox->isChecked());
+    }
+
+    // Read by the editor view on every frame
+    settingsProxy()->setBatchedRendering(m_batchedRenderingCheckBox->isChecked());
+
+    settingsProxy()->setEdgeBundling(m_edgeBundlingCheckBox->isChecked());
 }
 
 void EffectsTab::initWidgets()
@@ -124,11 +138,6 @@ void EffectsTab::initWidgets()
 
     shadowsGroupLayout->addWidget(WidgetFactory::buildHorizontalLine());
 
-    shadowsGroupLayout->addWidget(m_optimizeShadowsCheckBox);
-    m_optimizeShadowsCheckBox->setToolTip(tr("Optimizing shadow effects makes the performance better, but might introduce some visual glitches."));
-
-    shadowsGroupLayout->addWidget(WidgetFactory::buildHorizontalLine());
-
     const auto && [resetToDefaultsButton, resetToDefaultsButtonLayout] = WidgetFactory::buildResetToDefaultsButtonWithHLayout();
     shadowsGroupLayout->addLayout(resetToDefaultsButtonLayout);
     connect(resetToDefaultsButton, &QPushButton::clicked, this, [=] {
@@ -140,6 +149,14 @@ void EffectsTab::initWidgets()
         apply();
     });
 
+    const auto && [renderingGroup, renderingGroupLayout] = WidgetFactory::buildGroupBoxWithVLayout(tr("Rendering"), *mainLayout);
+    renderingGroupLayout->addWidget(m_hardwareAccelerationCheckBox);
+    m_hardwareAccelerationCheckBox->setToolTip(tr("Renders the mind map via OpenGL, which makes panning large mind maps faster on high resolution displays. Falls back to software rendering if OpenGL is not available."));
+    renderingGroupLayout->addWidget(m_batchedRenderingCheckBox);
+    m_batchedRenderingCheckBox->setToolTip(tr("Draws the nodes and edges of mind maps with thousands of nodes as a few batches of rects and lines when zoomed so far out that the details are hidden anyway. Fastest together with hardware acceleration."));
+    renderingGroupLayout->addWidget(m_edgeBundlingCheckBox);
+    m_edgeBundlingCheckBox->setToolTip(tr("Draws the edges that leave a node with many outgoing edges in the same direction as branches of a shared trunk. Each edge can still be selected on its own. Exported images show the edges as usual."));
+
     setLayout(mainLayout);
 }
 
@@ -38,6 +38,8 @@ public:
 signals:
     void shadowEffectChanged(const ShadowEffectParams & params);
 
+    void hardwareAccelerationChanged(bool enabled);
+
 private:
     void apply(const ShadowEffectParams & params);
 
@@ -53,7 +55,11 @@ private:
 
     ColorSettingButton * m_selectedItemShadowColorButton;
 
-    QCheckBox * m_optimizeShadowsCheckBox;
+    QCheckBox * m_hardwareAccelerationCheckBox;
+
+    QCheckBox * m_batchedRenderingCheckBox;
+
+    QCheckBox * m_edgeBundlingCheckBox;
 
     const int m_shadowEffectMaxOffset = 10;
 
@@ -0,0 +1,205 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "pdf_export_dialog.hpp"
+
+#include "../../../common/constants.hpp"
+#include "../../../common/utils.hpp"
+#include "../../widgets/export_region_combo_box.hpp"
+#include "../widget_factory.hpp"
+
+#include <QCheckBox>
+#include <QComboBox>
+#include <QDialogButtonBox>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QPageSize>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QStandardPaths>
+#include <QTimer>
+#include <QVBoxLayout>
+
+namespace Dialogs::Export {
+
+PdfExportDialog::PdfExportDialog(QWidget & parent)
+  : QDialog(&parent)
+{
+    setWindowTitle(tr("Export to a PDF File"));
+    setMinimumWidth(480);
+    initWidgets();
+
+    connect(m_fileNameButton, &QPushButton::clicked, this, [=] {
+        if (const auto fileName = QFileDialog::getSaveFileName(this,
+                                                               tr("Export As"),
+                                                               QStandardPaths::writableLocation(QStandardPaths::HomeLocation),
+                                                               tr("PDF Files") + " (*" + m_pdfFileExtension + ")");
+            !fileName.isEmpty()) {
+            m_fileNameLineEdit->setText(fileName);
+        }
+    });
+
+    connect(m_fileNameLineEdit, &QLineEdit::textChanged, this, &PdfExportDialog::validate);
+
+    connect(m_pageSizeComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &PdfExportDialog::updatePageCount);
+
+    connect(m_landscapeCheckBox, &QCheckBox::toggled, this, &PdfExportDialog::updatePageCount);
+
+    connect(m_scaleSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, &PdfExportDialog::updatePageCount);
+
+    connect(m_regionComboBox, &Widgets::ExportRegionComboBox::regionChanged, this, &PdfExportDialog::updatePageCount);
+
+    connect(m_buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    connect(m_buttonBox, &QDialogButtonBox::accepted, this, [=] {
+        m_buttonBox->setEnabled(false);
+        m_progressBar->setValue(0);
+        emit pdfExportRequested(exportParams());
+    });
+}
+
+void PdfExportDialog::setCurrentMindMapFileName(QString fileName)
+{
+    if (!fileName.isEmpty()) {
+        m_fileNameLineEdit->setText(Utils::exportFileName(fileName, m_pdfFileExtension));
+    }
+}
+
+void PdfExportDialog::addRegion(ExportParams::Region region, QSizeF sceneSize)
+{
+    // Adding the first region selects it, which updates the page count
+    m_sceneSizes[region] = sceneSize;
+    m_regionComboBox->addRegion(region);
+}
+
+int PdfExportDialog::exec()
+{
+    m_progressBar->setValue(0);
+    m_buttonBox->setEnabled(true);
+
+    validate();
+    updatePageCount();
+
+    return QDialog::exec();
+}
+
+ExportParams PdfExportDialog::exportParams() const
+{
+    ExportParams exportParams { m_fileNameWithExtension, m_regionComboBox->region() };
+    exportParams.pageLayout.setPageSize(QPageSize { static_cast<QPageSize::PageSizeId>(m_pageSizeComboBox->currentData().toInt()) });
+    exportParams.pageLayout.setOrientation(m_landscapeCheckBox->isChecked() ? QPageLayout::Landscape : QPageLayout::Portrait);
+    exportParams.pageScale = m_scaleSpinBox->value() / 100.0;
+    return exportParams;
+}
+
+void PdfExportDialog::finishExport(bool success)
+{
+    if (success) {
+        m_progressBar->setValue(100);
+        QTimer::singleShot(500, this, &QDialog::accept);
+    } else {
+        QMessageBox::critical(this, Constants::Application::applicationName(), tr("Couldn't write to") + " '" + m_fileNameLineEdit->text() + "'", QMessageBox::Ok);
+    }
+}
+
+void PdfExportDialog::setProgress(int percentage)
+{
+    m_progressBar->setValue(percentage);
+}
+
+void PdfExportDialog::updatePageCount()
+{
+    if (const auto sceneSize = m_sceneSizes.find(m_regionComboBox->region()); sceneSize != m_sceneSizes.end()) {
+        const auto pageGrid = exportParams().pageGrid(sceneSize->second);
+        m_pageCountLabel->setText(tr("Pages: %1 (%2 x %3)").arg(pageGrid.width() * pageGrid.height()).arg(pageGrid.width()).arg(pageGrid.height()));
+    }
+}
+
+void PdfExportDialog::validate()
+{
+    m_progressBar->setValue(0);
+
+    m_buttonBox->button(QDialogButtonBox::Ok)->setEnabled(!m_fileNameLineEdit->text().isEmpty());
+
+    m_fileNameWithExtension = m_fileNameLineEdit->text();
+
+    if (m_fileNameWithExtension.isEmpty()) {
+        return;
+    }
+
+    if (!m_fileNameWithExtension.endsWith(m_pdfFileExtension, Qt::CaseInsensitive)) {
+        m_fileNameWithExtension += m_pdfFileExtension;
+    }
+}
+
+void PdfExportDialog::initWidgets()
+{
+    const auto mainLayout = new QVBoxLayout(this);
+
+    const auto filenameGroup = WidgetFactory::buildGroupBoxWithVLayout(tr("Filename"), *mainLayout);
+
+    const auto filenameLayout = new QHBoxLayout;
+    m_fileNameLineEdit = new QLineEdit;
+    filenameLayout->addWidget(m_fileNameLineEdit);
+    m_fileNameButton = new QPushButton;
+    m_fileNameButton->setText(tr("Export as.."));
+    filenameLayout->addWidget(m_fileNameButton);
+    filenameGroup.second->addLayout(filenameLayout);
+
+    const auto regionGroup = WidgetFactory::buildGroupBoxWithVLayout(tr("Region"), *mainLayout);
+    m_regionComboBox = new Widgets::ExportRegionComboBox;
+    regionGroup.second->addWidget(m_regionComboBox);
+
+    const auto pageGroup = WidgetFactory::buildGroupBoxWithVLayout(tr("Pages"), *mainLayout);
+
+    const auto pageLayout = new QHBoxLayout;
+    m_pageSizeComboBox = new QComboBox;
+    for (auto && pageSizeId : { QPageSize::A4, QPageSize::A3, QPageSize::A5, QPageSize::Letter, QPageSize::Legal, QPageSize::Tabloid }) {
+        m_pageSizeComboBox->addItem(QPageSize::name(pageSizeId), static_cast<int>(pageSizeId));
+    }
+    pageLayout->addWidget(m_pageSizeComboBox);
+    m_landscapeCheckBox = new QCheckBox;
+    m_landscapeCheckBox->setText(tr("Landscape"));
+    pageLayout->addWidget(m_landscapeCheckBox);
+    pageLayout->addWidget(new QLabel(tr("Scale (%):")));
+    m_scaleSpinBox = new QSpinBox;
+    m_scaleSpinBox->setRange(5, 400);
+    m_scaleSpinBox->setValue(100);
+    pageLayout->addWidget(m_scaleSpinBox);
+    pageGroup.second->addLayout(pageLayout);
+    m_pageCountLabel = new QLabel;
+    pageGroup.second->addWidget(m_pageCountLabel);
+
+    const auto progressBarLayout = new QHBoxLayout;
+    m_progressBar = new QProgressBar;
+    m_progressBar->setEnabled(false);
+    m_progressBar->setMaximum(100);
+    m_progressBar->setValue(0);
+    progressBarLayout->addWidget(m_progressBar);
+    mainLayout->addLayout(progressBarLayout);
+
+    m_buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok
+                                       | QDialogButtonBox::Cancel);
+    m_buttonBox->button(QDialogButtonBox::Ok)->setEnabled(false);
+
+    mainLayout->addWidget(m_buttonBox);
+
+    setLayout(mainLayout);
+}
+
+} // namespace Dialogs::Export
@@ -0,0 +1,103 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PDF_EXPORT_DIALOG_HPP
+#define PDF_EXPORT_DIALOG_HPP
+
+#include <QDialog>
+
+#include <map>
+
+#include "../../../infra/export_params.hpp"
+
+class QCheckBox;
+class QComboBox;
+class QDialogButtonBox;
+class QLabel;
+class QLineEdit;
+class QProgressBar;
+class QPushButton;
+class QSpinBox;
+
+namespace Widgets {
+class ExportRegionComboBox;
+}
+
+namespace Dialogs::Export {
+
+class PdfExportDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit PdfExportDialog(QWidget & parent);
+
+    void setCurrentMindMapFileName(QString fileName);
+
+    //! Offers the given region for export. The first region added is selected.
+    //! \param sceneSize Size of the region in scene coordinates, which determines the number of pages.
+    void addRegion(ExportParams::Region region, QSizeF sceneSize);
+
+    int exec() override;
+
+public slots:
+
+    void finishExport(bool success);
+
+    void setProgress(int percentage);
+
+signals:
+
+    void pdfExportRequested(const ExportParams & exportParams);
+
+private slots:
+
+    void validate();
+
+private:
+    ExportParams exportParams() const;
+
+    void initWidgets();
+
+    void updatePageCount();
+
+    QLineEdit * m_fileNameLineEdit = nullptr;
+
+    QPushButton * m_fileNameButton = nullptr;
+
+    QComboBox * m_pageSizeComboBox = nullptr;
+
+    QCheckBox * m_landscapeCheckBox = nullptr;
+
+    QSpinBox * m_scaleSpinBox = nullptr;
+
+    QLabel * m_pageCountLabel = nullptr;
+
+    QDialogButtonBox * m_buttonBox = nullptr;
+
+    QProgressBar * m_progressBar = nullptr;
+
+    Widgets::ExportRegionComboBox * m_regionComboBox = nullptr;
+
+    std::map<ExportParams::Region, QSizeF> m_sceneSizes;
+
+    QString m_fileNameWithExtension;
+
+    const QString m_pdfFileExtension = ".pdf";
+};
+
+} // namespace Dialogs::Export
+
+#endif // PDF_EXPORT_DIALOG_HPP
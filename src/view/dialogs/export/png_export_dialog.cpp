@@ -18,9 +18,12 @@
 #include "../../../common/constants.hpp"
 #include "../../../common/utils.hpp"
 #include "../../../infra/export_params.hpp"
+#include "../../../infra/io/buffered_image_writer.hpp"
+#include "../../widgets/export_region_combo_box.hpp"
 #include "../widget_factory.hpp"
 
 #include <QCheckBox>
+#include <QComboBox>
 #include <QDialogButtonBox>
 #include <QFileDialog>
 #include <QGroupBox>
@@ -40,7 +43,7 @@ namespace Dialogs::Export {
 PngExportDialog::PngExportDialog(QWidget & parent)
   : QDialog(&parent)
 {
-    setWindowTitle(tr("Export to PNG Image"));
+    setWindowTitle(tr("Export to Image"));
     setMinimumWidth(480);
 
     initWidgets();
@@ -49,7 +52,7 @@ PngExportDialog::PngExportDialog(QWidget & parent)
         if (const auto fileName = QFileDialog::getSaveFileName(this,
                                                                tr("Export As"),
                                                                QStandardPaths::writableLocation(QStandardPaths::HomeLocation),
-                                                               tr("PNG Files") + " (*" + m_pngFileExtension + ")");
+                                                               tr("%1 Files").arg(m_imageFormatComboBox->currentText()) + " (*" + fileExtension() + ")");
             !fileName.isEmpty()) {
             m_fileNameLineEdit->setText(fileName);
         }
@@ -83,37 +86,77 @@ PngExportDialog::PngExportDialog(QWidget & parent)
 
     connect(m_fileNameLineEdit, &QLineEdit::textChanged, this, &PngExportDialog::validate);
 
+    connect(m_imageFormatComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &PngExportDialog::updateImageFormat);
+
+    connect(m_regionComboBox, &Widgets::ExportRegionComboBox::regionChanged, this, [=](ExportParams::Region region) {
+        if (const auto size = m_defaultImageSizes.find(region); size != m_defaultImageSizes.end()) {
+            setDefaultImageSize(size->second);
+        }
+    });
+
     connect(m_buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
     connect(m_buttonBox, &QDialogButtonBox::accepted, this, [=] {
         m_buttonBox->setEnabled(false);
-        m_progressBar->setValue(50);
-        emit pngExportRequested({ m_fileNameWithExtension, QSize(m_imageWidthSpinBox->value(), m_imageHeightSpinBox->value()), m_transparentBackgroundCheckBox->isChecked() });
+        m_progressBar->setValue(0);
+        ExportParams exportParams { m_fileNameWithExtension, QSize(m_imageWidthSpinBox->value(), m_imageHeightSpinBox->value()), m_transparentBackgroundCheckBox->isChecked(), m_regionComboBox->region() };
+        exportParams.imageFormat = imageFormat();
+        exportParams.compressionLevel = m_compressionLevelSpinBox->value();
+        exportParams.quality = m_qualitySpinBox->value();
+        emit pngExportRequested(exportParams);
     });
 }
 
 void PngExportDialog::setCurrentMindMapFileName(QString fileName)
 {
     if (!fileName.isEmpty()) {
-        m_fileNameLineEdit->setText(Utils::exportFileName(fileName, m_pngFileExtension));
+        m_fileNameLineEdit->setText(Utils::exportFileName(fileName, fileExtension()));
     }
 }
 
+void PngExportDialog::addRegion(ExportParams::Region region, QSize defaultImageSize)
+{
+    // Adding the first region selects it, which sets the default size
+    m_defaultImageSizes[region] = defaultImageSize;
+    m_regionComboBox->addRegion(region);
+}
+
+void PngExportDialog::addImageFormat(ExportParams::ImageFormat imageFormat, QString name)
+{
+    m_imageFormatComboBox->addItem(name, static_cast<int>(imageFormat));
+}
+
+QString PngExportDialog::fileExtension() const
+{
+    return ExportParams::fileExtension(imageFormat());
+}
+
+ExportParams::ImageFormat PngExportDialog::imageFormat() const
+{
+    return static_cast<ExportParams::ImageFormat>(m_imageFormatComboBox->currentData().toInt());
+}
+
+int PngExportDialog::maxImageSize() const
+{
+    return imageFormat() == ExportParams::ImageFormat::WebP ? m_maxWebPImageSize : m_maxImageSize;
+}
+
 void PngExportDialog::setDefaultImageSize(QSize size)
 {
     m_enableSpinBoxConnection = false;
 
     m_aspectRatio = static_cast<double>(size.width()) / static_cast<double>(size.height());
 
-    if (size.height() <= m_maxImageSize && size.width() <= m_maxImageSize) {
+    const auto maxImageSize = this->maxImageSize();
+    if (size.height() <= maxImageSize && size.width() <= maxImageSize) {
         m_imageWidthSpinBox->setValue(size.width());
         m_imageHeightSpinBox->setValue(size.height());
     } else {
         if (size.height() > size.width()) {
-            m_imageHeightSpinBox->setValue(m_maxImageSize);
-            m_imageWidthSpinBox->setValue(static_cast<int>(m_maxImageSize * m_aspectRatio));
+            m_imageHeightSpinBox->setValue(maxImageSize);
+            m_imageWidthSpinBox->setValue(static_cast<int>(maxImageSize * m_aspectRatio));
         } else {
-            m_imageWidthSpinBox->setValue(m_maxImageSize);
-            m_imageHeightSpinBox->setValue(static_cast<int>(m_maxImageSize / m_aspectRatio));
+            m_imageWidthSpinBox->setValue(maxImageSize);
+            m_imageHeightSpinBox->setValue(static_cast<int>(maxImageSize / m_aspectRatio));
         }
     }
 
@@ -140,15 +183,20 @@ void PngExportDialog::finishExport(bool success)
     }
 }
 
+void PngExportDialog::setProgress(int percentage)
+{
+    m_progressBar->setValue(percentage);
+}
+
 void PngExportDialog::validate()
 {
     m_progressBar->setValue(0);
 
     m_buttonBox->button(QDialogButtonBox::Ok)->setEnabled( //
       m_imageHeightSpinBox->value() >= m_minImageSize && //
-      m_imageHeightSpinBox->value() <= m_maxImageSize && //
+      m_imageHeightSpinBox->value() <= maxImageSize() && //
       m_imageWidthSpinBox->value() >= m_minImageSize && //
-      m_imageWidthSpinBox->value() <= m_maxImageSize && //
+      m_imageWidthSpinBox->value() <= maxImageSize() && //
       !m_fileNameLineEdit->text().isEmpty());
 
     m_fileNameWithExtension = m_fileNameLineEdit->text();
@@ -157,11 +205,35 @@ void PngExportDialog::validate()
         return;
     }
 
-    if (!m_fileNameWithExtension.endsWith(m_pngFileExtension, Qt::CaseInsensitive)) {
-        m_fileNameWithExtension += m_pngFileExtension;
+    if (!m_fileNameWithExtension.endsWith(fileExtension(), Qt::CaseInsensitive)) {
+        m_fileNameWithExtension += fileExtension();
     }
 }
 
+void PngExportDialog::updateImageFormat()
+{
+    const auto format = imageFormat();
+    m_compressionLevelSpinBox->setEnabled(format == ExportParams::ImageFormat::Png);
+    m_qualitySpinBox->setEnabled(format != ExportParams::ImageFormat::Png);
+
+    // JPEG has no alpha channel
+    if (format == ExportParams::ImageFormat::Jpeg) {
+        m_transparentBackgroundCheckBox->setChecked(false);
+    }
+    m_transparentBackgroundCheckBox->setEnabled(format != ExportParams::ImageFormat::Jpeg);
+
+    auto fileName = m_fileNameLineEdit->text();
+    for (auto && otherFormat : { ExportParams::ImageFormat::Png, ExportParams::ImageFormat::Jpeg, ExportParams::ImageFormat::WebP }) {
+        if (const auto extension = ExportParams::fileExtension(otherFormat); fileName.endsWith(extension, Qt::CaseInsensitive)) {
+            fileName.chop(extension.length());
+            m_fileNameLineEdit->setText(fileName + fileExtension());
+            break;
+        }
+    }
+
+    validate();
+}
+
 void PngExportDialog::initWidgets()
 {
     const auto mainLayout = new QVBoxLayout(this);
@@ -177,6 +249,10 @@ void PngExportDialog::initWidgets()
     filenameLayout->addWidget(m_fileNameButton);
     nameGroup.second->addLayout(filenameLayout);
 
+    const auto regionGroup = WidgetFactory::buildGroupBoxWithVLayout(tr("Region"), *mainLayout);
+    m_regionComboBox = new Widgets::ExportRegionComboBox;
+    regionGroup.second->addWidget(m_regionComboBox);
+
     const auto sizeGroup = WidgetFactory::buildGroupBoxWithVLayout(tr("Image Size"), *mainLayout);
 
     const auto imageSizeLayout = new QHBoxLayout;
@@ -202,6 +278,32 @@ void PngExportDialog::initWidgets()
     backgroundLayout->addWidget(m_transparentBackgroundCheckBox);
     bgGroup.second->addLayout(backgroundLayout);
 
+    const auto formatGroup = WidgetFactory::buildGroupBoxWithVLayout(tr("Format"), *mainLayout);
+
+    const ExportParams defaultParams { QString {} };
+    const auto formatLayout = new QHBoxLayout;
+    m_imageFormatComboBox = new QComboBox;
+    addImageFormat(ExportParams::ImageFormat::Png, "PNG");
+    addImageFormat(ExportParams::ImageFormat::Jpeg, "JPEG");
+    // WebP needs the plugin from Qt Image Formats
+    if (IO::BufferedImageWriter::isFormatSupported("webp")) {
+        addImageFormat(ExportParams::ImageFormat::WebP, "WebP");
+    }
+    formatLayout->addWidget(m_imageFormatComboBox);
+    formatLayout->addWidget(new QLabel(tr("Compression level:")));
+    m_compressionLevelSpinBox = new QSpinBox;
+    m_compressionLevelSpinBox->setRange(0, 9);
+    m_compressionLevelSpinBox->setValue(defaultParams.compressionLevel);
+    m_compressionLevelSpinBox->setToolTip(tr("Lower levels are faster to export, higher levels make smaller files"));
+    formatLayout->addWidget(m_compressionLevelSpinBox);
+    formatLayout->addWidget(new QLabel(tr("Quality:")));
+    m_qualitySpinBox = new QSpinBox;
+    m_qualitySpinBox->setRange(0, 100);
+    m_qualitySpinBox->setValue(defaultParams.quality);
+    m_qualitySpinBox->setEnabled(false);
+    formatLayout->addWidget(m_qualitySpinBox);
+    formatGroup.second->addLayout(formatLayout);
+
     const auto progressBarLayout = new QHBoxLayout;
     m_progressBar = new QProgressBar;
     m_progressBar->setEnabled(false);
@@ -18,14 +18,21 @@
 
 #include <QDialog>
 
+#include <map>
+
+#include "../../../infra/export_params.hpp"
+
 class QCheckBox;
+class QComboBox;
 class QDialogButtonBox;
 class QLineEdit;
 class QProgressBar;
 class QPushButton;
 class QSpinBox;
 
-class ExportParams;
+namespace Widgets {
+class ExportRegionComboBox;
+}
 
 namespace Dialogs::Export {
 
@@ -38,7 +45,9 @@ public:
 
     void setCurrentMindMapFileName(QString fileName);
 
-    void setDefaultImageSize(QSize size);
+    //! Offers the given region for export. The first region added is selected.
+    //! \param defaultImageSize Size of the region at the current zoom level.
+    void addRegion(ExportParams::Region region, QSize defaultImageSize);
 
     int exec() override;
 
@@ -46,6 +55,8 @@ public slots:
 
     void finishExport(bool success);
 
+    void setProgress(int percentage);
+
 signals:
 
     void pngExportRequested(const ExportParams & exportParams);
@@ -55,8 +66,21 @@ private slots:
     void validate();
 
 private:
+    void addImageFormat(ExportParams::ImageFormat imageFormat, QString name);
+
+    QString fileExtension() const;
+
+    ExportParams::ImageFormat imageFormat() const;
+
     void initWidgets();
 
+    int maxImageSize() const;
+
+    void setDefaultImageSize(QSize size);
+
+    //! Enables the settings that apply to the selected format and fixes the extension of the file name.
+    void updateImageFormat();
+
     QLineEdit * m_fileNameLineEdit = nullptr;
 
     QSpinBox * m_imageHeightSpinBox = nullptr;
@@ -71,17 +95,28 @@ private:
 
     QCheckBox * m_transparentBackgroundCheckBox = nullptr;
 
+    QComboBox * m_imageFormatComboBox = nullptr;
+
+    QSpinBox * m_compressionLevelSpinBox = nullptr;
+
+    QSpinBox * m_qualitySpinBox = nullptr;
+
+    Widgets::ExportRegionComboBox * m_regionComboBox = nullptr;
+
+    std::map<ExportParams::Region, QSize> m_defaultImageSizes;
+
     QString m_fileNameWithExtension;
 
     bool m_enableSpinBoxConnection = true;
 
     double m_aspectRatio = 1.0;
 
-    const QString m_pngFileExtension = ".png";
-
     const int m_minImageSize = 1;
 
-    const int m_maxImageSize = 16'384;
+    const int m_maxImageSize = 32'767;
+
+    //! WebP can't store larger images.
+    const int m_maxWebPImageSize = 16'383;
 };
 
 } // namespace Dialogs::Export
@@ -18,6 +18,7 @@
 #include "../../../common/constants.hpp"
 #include "../../../common/utils.hpp"
 #include "../../../infra/export_params.hpp"
+#include "../../widgets/export_region_combo_box.hpp"
 #include "../widget_factory.hpp"
 
 #include <QCheckBox>
@@ -57,7 +58,7 @@ SvgExportDialog::SvgExportDialog(QWidget & parent)
     connect(m_buttonBox, &QDialogButtonBox::accepted, this, [=] {
         m_buttonBox->setEnabled(false);
         m_progressBar->setValue(50);
-        emit svgExportRequested({ m_fileNameWithExtension });
+        emit svgExportRequested({ m_fileNameWithExtension, m_regionComboBox->region() });
     });
 
     connect(m_fileNameLineEdit, &QLineEdit::textChanged, this, &SvgExportDialog::validate);
@@ -70,6 +71,11 @@ void SvgExportDialog::setCurrentMindMapFileName(QString fileName)
     }
 }
 
+void SvgExportDialog::addRegion(ExportParams::Region region)
+{
+    m_regionComboBox->addRegion(region);
+}
+
 int SvgExportDialog::exec()
 {
     m_progressBar->setValue(0);
@@ -121,6 +127,10 @@ void SvgExportDialog::initWidgets()
     filenameLayout->addWidget(m_fileNameButton);
     filenameGroup.second->addLayout(filenameLayout);
 
+    const auto regionGroup = WidgetFactory::buildGroupBoxWithVLayout(tr("Region"), *mainLayout);
+    m_regionComboBox = new Widgets::ExportRegionComboBox;
+    regionGroup.second->addWidget(m_regionComboBox);
+
     const auto progressBarLayout = new QHBoxLayout;
     m_progressBar = new QProgressBar;
     m_progressBar->setEnabled(false);
@@ -18,7 +18,8 @@
 
 #include <QDialog>
 
-class ExportParams;
+#include "../../../infra/export_params.hpp"
+
 class QCheckBox;
 class QDialogButtonBox;
 class QLineEdit;
@@ -26,6 +27,10 @@ class QProgressBar;
 class QPushButton;
 class QSpinBox;
 
+namespace Widgets {
+class ExportRegionComboBox;
+}
+
 namespace Dialogs::Export {
 
 class SvgExportDialog : public QDialog
@@ -38,6 +43,9 @@ public:
 
     void setCurrentMindMapFileName(QString fileName);
 
+    //! Offers the given region for export. The first region added is selected.
+    void addRegion(ExportParams::Region region);
+
     int exec() override;
 
 public slots:
@@ -63,6 +71,8 @@ private:
 
     QProgressBar * m_progressBar = nullptr;
 
+    Widgets::ExportRegionComboBox * m_regionComboBox = nullptr;
+
     QString m_fileNameWithExtension;
 
     const QString m_svgFileExtension = ".svg";
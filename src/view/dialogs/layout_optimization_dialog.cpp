@@ -15,14 +15,19 @@
 
 #include "layout_optimization_dialog.hpp"
 
+#include "../../application/application_service.hpp"
+#include "../../application/service_container.hpp"
 #include "../../common/constants.hpp"
 #include "../../domain/layout_optimizer.hpp"
 #include "../../domain/mind_map_data.hpp"
 #include "../editor_view.hpp"
+#include "../widgets/convergence_plot.hpp"
 #include "widget_factory.hpp"
 
 #include "simple_logger.hpp"
 
+#include <QCheckBox>
+#include <QComboBox>
 #include <QDialogButtonBox>
 #include <QDoubleSpinBox>
 #include <QGridLayout>
@@ -32,6 +37,7 @@
 #include <QMessageBox>
 #include <QProgressBar>
 #include <QPushButton>
+#include <QSpinBox>
 #include <QTimer>
 #include <QVBoxLayout>
 
@@ -51,20 +57,90 @@ LayoutOptimizationDialog::LayoutOptimizationDialog(QWidget & parent, MindMapData
 
     initWidgets(mindMapData);
 
+    // The callbacks are called on the optimizing thread
     m_layoutOptimizer.setProgressCallback([=](double progress) {
-        m_progressBar->setValue(static_cast<int>(100.0 * progress));
+        QMetaObject::invokeMethod(m_progressBar, "setValue", Qt::QueuedConnection, Q_ARG(int, static_cast<int>(100.0 * progress)));
     });
+    m_layoutOptimizer.setPreviewCallback([=] {
+        QMetaObject::invokeMethod(this, "applyPreview", Qt::QueuedConnection);
+    },
+                                         Constants::LayoutOptimizer::previewInterval());
+    m_layoutOptimizer.setTraceCallback([=](const LayoutOptimizer::TraceSample & sample) {
+        QMetaObject::invokeMethod(m_convergencePlot, "addSample", Qt::QueuedConnection, Q_ARG(double, sample.cost), Q_ARG(double, sample.temperature));
+    });
+}
+
+LayoutOptimizationDialog::~LayoutOptimizationDialog()
+{
+    m_optimization.cancel();
+    m_optimization.wait();
 }
 
 int LayoutOptimizationDialog::exec()
 {
     m_progressBar->setValue(0);
+    m_convergencePlot->clear();
 
     return QDialog::exec();
 }
 
+void LayoutOptimizationDialog::reject()
+{
+    if (m_isOptimizing) {
+        juzzlin::L(TAG).info() << "Cancelling";
+        m_buttonBox->setEnabled(false);
+        m_layoutOptimizer.cancel();
+    } else {
+        QDialog::reject();
+    }
+}
+
+void LayoutOptimizationDialog::startOptimization()
+{
+    emit undoPointRequested();
+    m_layoutOptimizer.setWarmStart(m_warmStartCheckBox->isChecked());
+    m_layoutOptimizer.setEngine(static_cast<LayoutOptimizer::Engine>(m_engineComboBox->currentData().toInt()));
+    m_layoutOptimizer.setTimeBudget(std::chrono::seconds { m_timeBudgetSpinBox->value() });
+    m_layoutOptimizer.setCrossingPenalty(m_avoidCrossingsCheckBox->isChecked() ? Constants::LayoutOptimizer::crossingPenalty() : 0);
+    if (m_layoutOptimizer.initialize(m_aspectRatioSpinBox->value(), m_minEdgeLengthSpinBox->value())) {
+        m_isOptimizing = true;
+        m_optimization = SC::instance().taskPool()->start(
+          [this](auto &&) {
+              if (const auto optimizationInfo = m_layoutOptimizer.optimize(); optimizationInfo.cached) {
+                  juzzlin::L(TAG).info() << "No changes, the layout was cached";
+              } else if (optimizationInfo.changes) {
+                  const double gain = (optimizationInfo.finalCost - optimizationInfo.initialCost) / optimizationInfo.initialCost;
+                  juzzlin::L(TAG).info() << "Final cost: " << optimizationInfo.finalCost << " (" << gain * 100 << "%)"
+                                         << (optimizationInfo.cancelled ? " cancelled" : "") << (optimizationInfo.outOfTime ? " out of time" : "");
+              } else {
+                  juzzlin::L(TAG).info() << "No changes";
+              }
+          },
+          TaskPool::Priority::High, [this] {
+              finishOptimization();
+          });
+    } else {
+        finishOptimization();
+    }
+}
+
+void LayoutOptimizationDialog::applyPreview()
+{
+    // A preview queued before the optimization finished must not override the final layout
+    if (m_isOptimizing) {
+        m_layoutOptimizer.extractPreview();
+    }
+}
+
 void LayoutOptimizationDialog::finishOptimization()
 {
+    if (m_isOptimizing) {
+        m_isOptimizing = false;
+        SC::instance().applicationService()->applyLayout([this] {
+            m_layoutOptimizer.extract();
+        });
+    }
+
     m_progressBar->setValue(100);
 
     m_mindMapData.setAspectRatio(m_aspectRatioSpinBox->value());
@@ -141,6 +217,37 @@ void LayoutOptimizationDialog::initWidgets(MindMapDataCR mindMapData)
     calculateAvgELFromLayout->setToolTip(tr("Calculate average edge length from current layout"));
     parameterWidgetLayout->addWidget(calculateAvgELFromLayout, 1, 5);
 
+    m_warmStartCheckBox = new QCheckBox(tr("Start from the current layout"));
+    m_warmStartCheckBox->setToolTip(tr("Only refine the current layout. This is much faster after small edits."));
+    parameterWidgetLayout->addWidget(m_warmStartCheckBox, 2, 0, 1, 6);
+
+    const auto engineLabel = new QLabel(tr("Engine:"));
+    engineLabel->setToolTip(tr("Force-directed layouts are organic and fast, annealed layouts follow a grid and tree layouts are instant for tree-shaped maps"));
+    parameterWidgetLayout->addWidget(engineLabel, 3, 0);
+    m_engineComboBox = new QComboBox;
+    m_engineComboBox->addItem(tr("Annealing"), static_cast<int>(LayoutOptimizer::Engine::Annealing));
+    m_engineComboBox->addItem(tr("Force-directed"), static_cast<int>(LayoutOptimizer::Engine::ForceDirected));
+    m_engineComboBox->addItem(tr("Tidy tree"), static_cast<int>(LayoutOptimizer::Engine::TidyTree));
+    m_engineComboBox->addItem(tr("Radial tree"), static_cast<int>(LayoutOptimizer::Engine::RadialTree));
+    parameterWidgetLayout->addWidget(m_engineComboBox, 3, 1, 1, 2);
+
+    const auto timeBudgetLabel = new QLabel(tr("Time Budget:"));
+    timeBudgetLabel->setToolTip(tr("The optimization cools faster to finish in time and keeps the best layout found"));
+    parameterWidgetLayout->addWidget(timeBudgetLabel, 4, 0);
+    m_timeBudgetSpinBox = new QSpinBox;
+    m_timeBudgetSpinBox->setMinimum(0);
+    m_timeBudgetSpinBox->setMaximum(static_cast<int>(Constants::LayoutOptimizer::maxTimeBudget().count()));
+    m_timeBudgetSpinBox->setSuffix(tr(" s"));
+    m_timeBudgetSpinBox->setSpecialValueText(tr("Unlimited"));
+    parameterWidgetLayout->addWidget(m_timeBudgetSpinBox, 4, 1);
+
+    m_avoidCrossingsCheckBox = new QCheckBox(tr("Avoid edge crossings"));
+    m_avoidCrossingsCheckBox->setToolTip(tr("Penalize crossing edges when annealing. This makes the optimization slower."));
+    parameterWidgetLayout->addWidget(m_avoidCrossingsCheckBox, 5, 0, 1, 6);
+
+    m_convergencePlot = new Widgets::ConvergencePlot;
+    mainLayout->addWidget(m_convergencePlot);
+
     const auto progressBarLayout = new QHBoxLayout;
     m_progressBar = new QProgressBar;
     m_progressBar->setEnabled(false);
@@ -149,27 +256,17 @@ void LayoutOptimizationDialog::initWidgets(MindMapDataCR mindMapData)
     progressBarLayout->addWidget(m_progressBar);
     mainLayout->addLayout(progressBarLayout);
 
-    const auto buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
-    connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
-
-    connect(buttonBox, &QDialogButtonBox::accepted, this, [=] {
-        buttonBox->setEnabled(false);
-        QTimer::singleShot(0, this, [=] { // Trick to make disabled buttons apply immediately
-            emit undoPointRequested();
-            if (m_layoutOptimizer.initialize(m_aspectRatioSpinBox->value(), m_minEdgeLengthSpinBox->value())) {
-                if (const auto optimizationInfo = m_layoutOptimizer.optimize(); optimizationInfo.changes) {
-                    const double gain = (optimizationInfo.finalCost - optimizationInfo.initialCost) / optimizationInfo.initialCost;
-                    juzzlin::L(TAG).info() << "Final cost: " << optimizationInfo.finalCost << " (" << gain * 100 << "%)";
-                } else {
-                    juzzlin::L(TAG).info() << "No changes";
-                }
-                m_layoutOptimizer.extract();
-            }
-            finishOptimization();
-        });
+    m_buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    connect(m_buttonBox, &QDialogButtonBox::rejected, this, &LayoutOptimizationDialog::reject);
+
+    connect(m_buttonBox, &QDialogButtonBox::accepted, this, [=] {
+        // Cancel stops the optimization and keeps the layout found so far
+        m_buttonBox->button(QDialogButtonBox::Ok)->setEnabled(false);
+        m_buttonBox->button(QDialogButtonBox::Cancel)->setText(tr("Stop"));
+        QTimer::singleShot(0, this, &LayoutOptimizationDialog::startOptimization); // Trick to make disabled buttons apply immediately
     });
 
-    mainLayout->addWidget(buttonBox);
+    mainLayout->addWidget(m_buttonBox);
 
     setLayout(mainLayout);
 }
@@ -18,12 +18,21 @@
 
 #include <QDialog>
 
+#include "../../application/task_pool.hpp"
 #include "../../common/types.hpp"
 
 class EditorView;
 class LayoutOptimizer;
+class QCheckBox;
+class QComboBox;
+class QDialogButtonBox;
 class QDoubleSpinBox;
 class QProgressBar;
+class QSpinBox;
+
+namespace Widgets {
+class ConvergencePlot;
+}
 
 namespace Dialogs {
 
@@ -35,19 +44,29 @@ public:
     //! Constructor.
     explicit LayoutOptimizationDialog(QWidget & parent, MindMapDataR mindMapData, LayoutOptimizer & layoutOptimizer, EditorView & editorView);
 
+    //! Waits for a running optimization, but drops its continuation.
+    ~LayoutOptimizationDialog() override;
+
     int exec() override;
 
+    //! Stops a running optimization and keeps the layout found so far instead of closing the dialog.
+    void reject() override;
+
 signals:
 
     void undoPointRequested();
 
 private slots:
 
+    void applyPreview();
+
     void finishOptimization();
 
 private:
     void initWidgets(MindMapDataCR mindMapData);
 
+    void startOptimization();
+
     MindMapDataR m_mindMapData;
 
     LayoutOptimizer & m_layoutOptimizer;
@@ -58,7 +77,24 @@ private:
 
     QDoubleSpinBox * m_minEdgeLengthSpinBox = nullptr;
 
+    QCheckBox * m_warmStartCheckBox = nullptr;
+
+    QCheckBox * m_avoidCrossingsCheckBox = nullptr;
+
+    QComboBox * m_engineComboBox = nullptr;
+
+    QSpinBox * m_timeBudgetSpinBox = nullptr;
+
+    Widgets::ConvergencePlot * m_convergencePlot = nullptr;
+
     QProgressBar * m_progressBar = nullptr;
+
+    QDialogButtonBox * m_buttonBox = nullptr;
+
+    bool m_isOptimizing = false;
+
+    // The optimization runs on the shared task pool so that the event loop keeps running
+    TaskPool::Handle m_optimization;
 };
 
 } // namespace Dialogs
@@ -0,0 +1,141 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "performance_tab.hpp"
+
+#include "../../application/settings_proxy.hpp"
+#include "../../common/constants.hpp"
+#include "widget_factory.hpp"
+
+#include <QComboBox>
+#include <QGroupBox>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QVBoxLayout>
+
+namespace Dialogs {
+
+PerformanceTab::PerformanceTab(QString name, QWidget * parent)
+  : SettingsTabBase { name, parent }
+  , m_profileComboBox(new QComboBox(this))
+  , m_balancedItemCountSpinBox(new QSpinBox(this))
+  , m_speedItemCountSpinBox(new QSpinBox(this))
+{
+    // The indices follow PerformanceProfile::Mode
+    m_profileComboBox->addItem(tr("Automatic"));
+    m_profileComboBox->setItemData(0, tr("Picks the profile by the size of the mind map and the measured paint times."), Qt::ToolTipRole);
+    m_profileComboBox->addItem(tr("Quality"));
+    m_profileComboBox->setItemData(1, tr("Everything is drawn with shadows and animations."), Qt::ToolTipRole);
+    m_profileComboBox->addItem(tr("Balanced"));
+    m_profileComboBox->setItemData(2, tr("No edge animations and the details are hidden sooner when zooming out."), Qt::ToolTipRole);
+    m_profileComboBox->addItem(tr("Speed"));
+    m_profileComboBox->setItemData(3, tr("No shadows or animations, only the items near the view are kept in the scene and OpenGL is used if available."), Qt::ToolTipRole);
+
+    for (auto && spinBox : { m_balancedItemCountSpinBox, m_speedItemCountSpinBox }) {
+        spinBox->setMinimum(0);
+        spinBox->setMaximum(m_maxItemCount);
+        spinBox->setSingleStep(m_itemCountStep);
+    }
+
+    initWidgets();
+
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
+    const auto signal = QOverload<int>::of(&QComboBox::currentIndexChanged);
+#else
+    const auto signal = static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged);
+#endif
+    connect(m_profileComboBox, signal, this, &PerformanceTab::updateItemCountsEnabled);
+}
+
+void PerformanceTab::apply()
+{
+    const auto mode = static_cast<PerformanceProfile::Mode>(m_profileComboBox->currentIndex());
+    const auto balancedItemCount = static_cast<size_t>(m_balancedItemCountSpinBox->value());
+    const auto speedItemCount = static_cast<size_t>(m_speedItemCountSpinBox->value());
+    if (settingsProxy()->performanceProfileMode() != mode || settingsProxy()->balancedProfileItemCount() != balancedItemCount || settingsProxy()->speedProfileItemCount() != speedItemCount) {
+        settingsProxy()->setPerformanceProfileMode(mode);
+        settingsProxy()->setBalancedProfileItemCount(balancedItemCount);
+        settingsProxy()->setSpeedProfileItemCount(speedItemCount);
+        emit performanceProfileChanged();
+    }
+}
+
+void PerformanceTab::initWidgets()
+{
+    const auto mainLayout = new QVBoxLayout;
+    const auto && [profileGroup, profileGroupLayout] = WidgetFactory::buildGroupBoxWithVLayout(tr("Performance Profile"), *mainLayout);
+
+    const auto profileLayout = new QHBoxLayout;
+    profileLayout->addWidget(new QLabel(tr("Profile:")));
+    const auto profileLayoutSpacer = new QWidget;
+    profileLayoutSpacer->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
+    profileLayout->addWidget(profileLayoutSpacer);
+    m_profileComboBox->setToolTip(tr("The profile decides on the shadows, edge animations, level of detail, rendering and undo memory in one place."));
+    profileLayout->addWidget(m_profileComboBox);
+    profileGroupLayout->addLayout(profileLayout);
+
+    profileGroupLayout->addWidget(WidgetFactory::buildHorizontalLine());
+
+    const auto balancedLayout = new QHBoxLayout;
+    balancedLayout->addWidget(new QLabel(tr("Balanced from nodes and edges:")));
+    const auto balancedLayoutSpacer = new QWidget;
+    balancedLayoutSpacer->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
+    balancedLayout->addWidget(balancedLayoutSpacer);
+    balancedLayout->addWidget(m_balancedItemCountSpinBox);
+    profileGroupLayout->addLayout(balancedLayout);
+
+    const auto speedLayout = new QHBoxLayout;
+    speedLayout->addWidget(new QLabel(tr("Speed from nodes and edges:")));
+    const auto speedLayoutSpacer = new QWidget;
+    speedLayoutSpacer->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
+    speedLayout->addWidget(speedLayoutSpacer);
+    speedLayout->addWidget(m_speedItemCountSpinBox);
+    profileGroupLayout->addLayout(speedLayout);
+
+    const auto && [resetToDefaultsButton, resetToDefaultsButtonLayout] = WidgetFactory::buildResetToDefaultsButtonWithHLayout();
+    profileGroupLayout->addLayout(resetToDefaultsButtonLayout);
+    connect(resetToDefaultsButton, &QPushButton::clicked, this, [=] {
+        m_profileComboBox->setCurrentIndex(static_cast<int>(PerformanceProfile::Mode::Automatic));
+        m_balancedItemCountSpinBox->setValue(static_cast<int>(Constants::Settings::defaultBalancedProfileItemCount()));
+        m_speedItemCountSpinBox->setValue(static_cast<int>(Constants::Settings::defaultSpeedProfileItemCount()));
+    });
+
+    setLayout(mainLayout);
+
+    setActiveSettings();
+}
+
+void PerformanceTab::setActiveSettings()
+{
+    m_profileComboBox->setCurrentIndex(static_cast<int>(settingsProxy()->performanceProfileMode()));
+
+    m_balancedItemCountSpinBox->setValue(static_cast<int>(settingsProxy()->balancedProfileItemCount()));
+
+    m_speedItemCountSpinBox->setValue(static_cast<int>(settingsProxy()->speedProfileItemCount()));
+
+    updateItemCountsEnabled();
+}
+
+void PerformanceTab::updateItemCountsEnabled()
+{
+    // The thresholds only apply to the automatic profile
+    const bool isAutomatic = m_profileComboBox->currentIndex() == static_cast<int>(PerformanceProfile::Mode::Automatic);
+    m_balancedItemCountSpinBox->setEnabled(isAutomatic);
+    m_speedItemCountSpinBox->setEnabled(isAutomatic);
+}
+
+} // namespace Dialogs
@@ -0,0 +1,58 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PERFORMANCE_TAB_HPP
+#define PERFORMANCE_TAB_HPP
+
+#include "settings_tab_base.hpp"
+
+class QComboBox;
+class QSpinBox;
+
+namespace Dialogs {
+
+class PerformanceTab : public SettingsTabBase
+{
+    Q_OBJECT
+
+public:
+    explicit PerformanceTab(QString name, QWidget * parent = nullptr);
+
+    void apply() override;
+
+signals:
+    void performanceProfileChanged();
+
+private:
+    void initWidgets();
+
+    void setActiveSettings();
+
+    void updateItemCountsEnabled();
+
+    QComboBox * m_profileComboBox;
+
+    QSpinBox * m_balancedItemCountSpinBox;
+
+    QSpinBox * m_speedItemCountSpinBox;
+
+    const int m_maxItemCount = 10'000'000;
+
+    const int m_itemCountStep = 1000;
+};
+
+} // namespace Dialogs
+
+#endif // PERFORMANCE_TAB_HPP
@@ -18,6 +18,7 @@
 #include "defaults_tab.hpp"
 #include "editing_tab.hpp"
 #include "effects_tab.hpp"
+#include "performance_tab.hpp"
 
 #include "../shadow_effect_params.hpp"
 
@@ -64,8 +65,13 @@ void SettingsDialog::initWidgets()
 
     const auto effectsTab = new EffectsTab(tr("Effects"), this);
     connect(effectsTab, &EffectsTab::shadowEffectChanged, this, &SettingsDialog::shadowEffectChanged);
+    connect(effectsTab, &EffectsTab::hardwareAccelerationChanged, this, &SettingsDialog::hardwareAccelerationChanged);
     m_tabs.push_back(effectsTab);
 
+    const auto performanceTab = new PerformanceTab(tr("Performance"), this);
+    connect(performanceTab, &PerformanceTab::performanceProfileChanged, this, &SettingsDialog::performanceProfileChanged);
+    m_tabs.push_back(performanceTab);
+
     const auto tabWidget = new QTabWidget;
 
     for (auto && tab : m_tabs) {
@@ -38,6 +38,10 @@ signals:
 
     void shadowEffectChanged(const ShadowEffectParams & params);
 
+    void hardwareAccelerationChanged(bool enabled);
+
+    void performanceProfileChanged();
+
 private:
     void accept() override;
 
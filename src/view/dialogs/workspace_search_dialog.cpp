@@ -0,0 +1,144 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "workspace_search_dialog.hpp"
+
+#include "../../infra/settings.hpp"
+#include "widget_factory.hpp"
+
+#include <QDialogButtonBox>
+#include <QDir>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+namespace Dialogs {
+
+namespace {
+
+const size_t maxHits = 500;
+
+} // namespace
+
+WorkspaceSearchDialog::WorkspaceSearchDialog(WorkspaceIndex & workspaceIndex, QWidget * parent)
+  : QDialog(parent)
+  , m_workspaceIndex(workspaceIndex)
+{
+    setWindowTitle(tr("Search Workspace"));
+
+    initWidgets();
+
+    connect(&m_workspaceIndex, &WorkspaceIndex::updateFinished, this, [this] {
+        refreshStatus();
+        refreshHits();
+    });
+
+    // Only the files that changed since the last time get read again
+    if (!m_workspaceIndex.directory().isEmpty()) {
+        m_workspaceIndex.update(m_workspaceIndex.directory());
+    }
+
+    refreshStatus();
+}
+
+void WorkspaceSearchDialog::initWidgets()
+{
+    const auto mainLayout = new QVBoxLayout(this);
+
+    const auto directoryGroup = WidgetFactory::buildGroupBoxWithVLayout(tr("Directory"), *mainLayout);
+    const auto directoryLayout = new QHBoxLayout;
+    m_directoryLineEdit = new QLineEdit;
+    m_directoryLineEdit->setReadOnly(true);
+    directoryLayout->addWidget(m_directoryLineEdit);
+    m_directoryButton = new QPushButton;
+    m_directoryButton->setText(tr("Select..."));
+    connect(m_directoryButton, &QPushButton::clicked, this, &WorkspaceSearchDialog::selectDirectory);
+    directoryLayout->addWidget(m_directoryButton);
+    directoryGroup.second->addLayout(directoryLayout);
+    m_statusLabel = new QLabel;
+    directoryGroup.second->addWidget(m_statusLabel);
+
+    const auto searchGroup = WidgetFactory::buildGroupBoxWithVLayout(tr("Search"), *mainLayout);
+    m_searchLineEdit = new QLineEdit;
+    m_searchLineEdit->setClearButtonEnabled(true);
+    m_searchLineEdit->setPlaceholderText(tr("Text in nodes or edges"));
+    connect(m_searchLineEdit, &QLineEdit::textChanged, this, &WorkspaceSearchDialog::refreshHits);
+    searchGroup.second->addWidget(m_searchLineEdit);
+    m_hitList = new QListWidget;
+    searchGroup.second->addWidget(m_hitList);
+
+    m_buttonBox = new QDialogButtonBox(QDialogButtonBox::Open | QDialogButtonBox::Cancel);
+    m_buttonBox->button(QDialogButtonBox::Open)->setEnabled(false);
+    connect(m_buttonBox, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    connect(m_buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    mainLayout->addWidget(m_buttonBox);
+
+    connect(m_hitList, &QListWidget::currentRowChanged, this, [this](int row) {
+        m_buttonBox->button(QDialogButtonBox::Open)->setEnabled(row >= 0);
+    });
+    connect(m_hitList, &QListWidget::itemActivated, this, &QDialog::accept);
+
+    m_searchLineEdit->setFocus();
+}
+
+void WorkspaceSearchDialog::refreshHits()
+{
+    m_hits = m_workspaceIndex.search(m_searchLineEdit->text(), maxHits);
+
+    m_hitList->clear();
+    for (auto && hit : m_hits) {
+        const auto item = new QListWidgetItem(QFileInfo { hit.filePath }.fileName() + ": " + hit.text.simplified(), m_hitList);
+        item->setToolTip(QDir::toNativeSeparators(hit.filePath));
+    }
+
+    if (!m_hits.empty()) {
+        m_hitList->setCurrentRow(0);
+    }
+}
+
+void WorkspaceSearchDialog::refreshStatus()
+{
+    m_directoryLineEdit->setText(QDir::toNativeSeparators(m_workspaceIndex.directory()));
+
+    if (m_workspaceIndex.isUpdating()) {
+        m_statusLabel->setText(tr("Indexing..."));
+    } else if (m_workspaceIndex.directory().isEmpty()) {
+        m_statusLabel->setText(tr("Select the directory of the mind maps to be searched."));
+    } else {
+        m_statusLabel->setText(tr("%n mind map(s) indexed.", "", static_cast<int>(m_workspaceIndex.fileCount())));
+    }
+}
+
+void WorkspaceSearchDialog::selectDirectory()
+{
+    const auto startDirectory = m_workspaceIndex.directory().isEmpty() ? QFileInfo { Settings::Custom::loadRecentPath() }.path() : m_workspaceIndex.directory();
+    if (const auto directory = QFileDialog::getExistingDirectory(this, tr("Select Directory"), startDirectory); !directory.isEmpty()) {
+        m_workspaceIndex.update(directory);
+        refreshStatus();
+    }
+}
+
+WorkspaceIndex::Hit WorkspaceSearchDialog::selectedHit() const
+{
+    const auto row = m_hitList->currentRow();
+    return row >= 0 && static_cast<size_t>(row) < m_hits.size() ? m_hits.at(static_cast<size_t>(row)) : WorkspaceIndex::Hit {};
+}
+
+} // namespace Dialogs
@@ -0,0 +1,73 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef WORKSPACE_SEARCH_DIALOG_HPP
+#define WORKSPACE_SEARCH_DIALOG_HPP
+
+#include <QDialog>
+
+#include <vector>
+
+#include "../../application/workspace_index.hpp"
+
+class QDialogButtonBox;
+class QLabel;
+class QLineEdit;
+class QListWidget;
+class QPushButton;
+
+namespace Dialogs {
+
+//! Dialog that searches the mind maps of a directory through the workspace index and lets the user pick a hit to open.
+class WorkspaceSearchDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    //! Constructor. Updates the index of the previously searched directory, if any, in the background.
+    explicit WorkspaceSearchDialog(WorkspaceIndex & workspaceIndex, QWidget * parent = nullptr);
+
+    //! \returns The hit to be opened once the dialog has been accepted.
+    WorkspaceIndex::Hit selectedHit() const;
+
+private:
+    void initWidgets();
+
+    void refreshHits();
+
+    void refreshStatus();
+
+    void selectDirectory();
+
+    WorkspaceIndex & m_workspaceIndex;
+
+    std::vector<WorkspaceIndex::Hit> m_hits;
+
+    QLineEdit * m_directoryLineEdit = nullptr;
+
+    QPushButton * m_directoryButton = nullptr;
+
+    QLineEdit * m_searchLineEdit = nullptr;
+
+    QListWidget * m_hitList = nullptr;
+
+    QLabel * m_statusLabel = nullptr;
+
+    QDialogButtonBox * m_buttonBox = nullptr;
+};
+
+} // namespace Dialogs
+
+#endif // WORKSPACE_SEARCH_DIALOG_HPP
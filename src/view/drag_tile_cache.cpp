@@ -0,0 +1,154 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "drag_tile_cache.hpp"
+
+#include "scene_items/edge.hpp"
+#include "scene_items/node.hpp"
+
+#include <QGraphicsScene>
+#include <QGraphicsView>
+#include <QPainter>
+
+namespace {
+
+const int TILE_SIZE = 256;
+
+bool isStatic(QGraphicsItem & item, const std::unordered_set<NodeP> & movingNodes)
+{
+    // Items that are e.g. fading in must be painted live
+    if (item.parentItem() || !item.isVisible() || item.opacity() < 1.0) {
+        return false;
+    }
+
+    if (const auto node = dynamic_cast<NodeP>(&item); node) {
+        return !movingNodes.count(node);
+    }
+
+    if (const auto edge = dynamic_cast<EdgeP>(&item); edge) {
+        return !movingNodes.count(&edge->sourceNode()) && !movingNodes.count(&edge->targetNode());
+    }
+
+    // E.g. the dummy drag items
+    return false;
+}
+
+} // namespace
+
+void DragTileCache::begin(QGraphicsView & view, const std::vector<NodeP> & movingNodes, size_t minItemCount)
+{
+    if (isStarted() || !view.scene()) {
+        return;
+    }
+
+    m_view = &view;
+    m_viewportTransform = view.viewportTransform();
+    const auto viewportRect = view.viewport()->rect();
+    m_sceneRect = view.mapToScene(viewportRect).boundingRect();
+
+    const std::unordered_set<NodeP> movingNodeSet { movingNodes.begin(), movingNodes.end() };
+    std::vector<QGraphicsItem *> liveItems;
+    for (auto && item : view.scene()->items(m_sceneRect, Qt::IntersectsItemBoundingRect)) {
+        if (isStatic(*item, movingNodeSet)) {
+            m_staticItems.insert(item);
+        } else if (!item->parentItem() && item->isVisible()) {
+            liveItems.push_back(item);
+        }
+    }
+
+    if (m_staticItems.size() < minItemCount) {
+        m_staticItems.clear();
+        return;
+    }
+
+    // Hide the moving items from the tiles, as they are painted live on top of them
+    std::vector<std::pair<QGraphicsItem *, double>> liveOpacities;
+    for (auto && item : liveItems) {
+        liveOpacities.push_back({ item, item->opacity() });
+        item->setOpacity(0);
+    }
+
+    m_isRendering = true;
+    const auto devicePixelRatio = view.viewport()->devicePixelRatioF();
+    for (int y = viewportRect.top(); y <= viewportRect.bottom(); y += TILE_SIZE) {
+        for (int x = viewportRect.left(); x <= viewportRect.right(); x += TILE_SIZE) {
+            const auto tileRect = QRect { x, y, TILE_SIZE, TILE_SIZE }.intersected(viewportRect);
+            QPixmap tile { tileRect.size() * devicePixelRatio };
+            tile.setDevicePixelRatio(devicePixelRatio);
+            QPainter painter { &tile };
+            painter.setRenderHints(view.renderHints());
+            view.render(&painter, QRectF { QPointF {}, QSizeF { tileRect.size() } }, tileRect);
+            painter.end();
+            m_tiles.push_back({ tileRect, tile });
+        }
+    }
+    m_isRendering = false;
+
+    for (auto && liveOpacity : liveOpacities) {
+        liveOpacity.first->setOpacity(liveOpacity.second);
+    }
+
+    // Transparent items are skipped by the view, but they are still in the scene index and receive events
+    for (auto && item : m_staticItems) {
+        item->setOpacity(0);
+    }
+
+    m_isActive = true;
+}
+
+void DragTileCache::end()
+{
+    if (m_isActive && m_view && m_view->scene()) {
+        // The static items didn't move, so the ones that are still in the scene are found in the cached area
+        for (auto && item : m_view->scene()->items(m_sceneRect, Qt::IntersectsItemBoundingRect)) {
+            if (m_staticItems.count(item)) {
+                item->setOpacity(1.0);
+            }
+        }
+    }
+
+    m_view = nullptr;
+    m_isActive = false;
+    m_tiles.clear();
+    m_staticItems.clear();
+}
+
+bool DragTileCache::isActive() const
+{
+    return m_isActive;
+}
+
+bool DragTileCache::isStarted() const
+{
+    return m_view != nullptr;
+}
+
+bool DragTileCache::isRendering() const
+{
+    return m_isRendering;
+}
+
+void DragTileCache::draw(QPainter & painter, const QRectF & sceneRect) const
+{
+    const auto exposedRect = m_viewportTransform.mapRect(sceneRect).toAlignedRect();
+    painter.save();
+    painter.resetTransform();
+    for (auto && tile : m_tiles) {
+        if (tile.first.intersects(exposedRect)) {
+            painter.drawPixmap(tile.first.topLeft(), tile.second);
+        }
+    }
+    painter.restore();
+}
@@ -0,0 +1,78 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef DRAG_TILE_CACHE_HPP
+#define DRAG_TILE_CACHE_HPP
+
+#include <QPixmap>
+#include <QRect>
+#include <QTransform>
+
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../common/types.hpp"
+
+class QGraphicsItem;
+class QGraphicsView;
+class QPainter;
+
+//! Speeds up dragging of nodes on dense mind maps. When a drag starts, the nodes and edges that don't move are
+//! rendered into viewport sized tiles together with the background, and they are made transparent so that the
+//! view skips them. Each frame then only blits the tiles and paints the moving items on top. The items stay in
+//! the scene, so hit testing is not affected. The tiles are only valid for the viewport transform they were
+//! rendered with, so the cache must be ended before the view scrolls or zooms.
+class DragTileCache
+{
+public:
+    //! Renders the static items in the viewport into tiles unless there are fewer than minItemCount of them.
+    //! Does nothing if the cache has already been started.
+    void begin(QGraphicsView & view, const std::vector<NodeP> & movingNodes, size_t minItemCount);
+
+    //! Makes the static items opaque again and drops the tiles.
+    void end();
+
+    //! \return true if the tiles are in use.
+    bool isActive() const;
+
+    //! \return true if begin() has been called since the last end(), even if the tiles were not needed.
+    bool isStarted() const;
+
+    //! \return true while the tiles are being rendered, i.e. the view paints into a tile instead of the viewport.
+    bool isRendering() const;
+
+    //! Draws the tiles that intersect the given scene rect. The painter must have the viewport transform.
+    void draw(QPainter & painter, const QRectF & sceneRect) const;
+
+private:
+    QGraphicsView * m_view = nullptr;
+
+    bool m_isActive = false;
+
+    bool m_isRendering = false;
+
+    QTransform m_viewportTransform;
+
+    QRectF m_sceneRect;
+
+    //! The tile rects are in viewport coordinates.
+    std::vector<std::pair<QRect, QPixmap>> m_tiles;
+
+    //! Only used to restore the opacity of the items that are still in the scene.
+    std::unordered_set<QGraphicsItem *> m_staticItems;
+};
+
+#endif // DRAG_TILE_CACHE_HPP
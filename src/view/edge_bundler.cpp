@@ -0,0 +1,360 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "edge_bundler.hpp"
+
+#include "../common/constants.hpp"
+#include "../domain/graph.hpp"
+#include "../domain/mind_map_data.hpp"
+#include "scene_items/edge.hpp"
+#include "scene_items/level_of_detail.hpp"
+#include "scene_items/node.hpp"
+
+#include <QPainter>
+
+#include <QtMath>
+
+#include <cmath>
+#include <limits>
+#include <map>
+#include <optional>
+
+namespace {
+
+//! Targets closer to the hub than this beyond its border are connected straight.
+const double MIN_TRUNK_LENGTH = 20;
+
+struct EdgeGroup
+{
+    std::vector<EdgeP> edges;
+
+    QPointF directionSum;
+};
+
+//! \returns The distance from the center of a rect of the given size to its border in the given unit direction.
+double distanceToBorder(QSizeF size, QPointF direction)
+{
+    const auto x = std::abs(direction.x()) > 0 ? size.width() / 2 / std::abs(direction.x()) : std::numeric_limits<double>::max();
+    const auto y = std::abs(direction.y()) > 0 ? size.height() / 2 / std::abs(direction.y()) : std::numeric_limits<double>::max();
+    return std::min(x, y);
+}
+
+} // namespace
+
+EdgeBundler::EdgeBundler()
+{
+    m_updateTimer.setSingleShot(true);
+    m_updateTimer.setInterval(0);
+    QObject::connect(&m_updateTimer, &QTimer::timeout, [this] {
+        update();
+    });
+}
+
+EdgeBundler::~EdgeBundler()
+{
+    unsubscribe();
+}
+
+void EdgeBundler::setMindMapData(MindMapDataS mindMapData)
+{
+    if (const auto oldMindMapData = m_mindMapData.lock(); oldMindMapData && &oldMindMapData->graph() == m_graph) {
+        releaseHubs(*m_graph);
+    }
+    unsubscribe();
+
+    m_mindMapData = mindMapData;
+    m_hubs.clear();
+    m_dirtyHubIndices.clear();
+    m_isRebuildPending = true;
+
+    if (mindMapData) {
+        m_graph = &mindMapData->graph();
+        m_subscriptionId = mindMapData->graph().changeNotifier().subscribe([this](const GraphChangeBatch & changes) {
+            handleChanges(changes);
+        });
+        scheduleUpdate();
+    }
+}
+
+void EdgeBundler::unsubscribe()
+{
+    if (m_subscriptionId) {
+        if (const auto mindMapData = m_mindMapData.lock(); mindMapData && &mindMapData->graph() == m_graph) {
+            mindMapData->graph().changeNotifier().unsubscribe(m_subscriptionId);
+        }
+        m_subscriptionId = 0;
+    }
+    m_graph = nullptr;
+}
+
+void EdgeBundler::setEnabled(bool enabled)
+{
+    if (m_isEnabled != enabled) {
+        m_isEnabled = enabled;
+        m_isRebuildPending = true;
+        scheduleUpdate();
+    }
+}
+
+bool EdgeBundler::isEnabled() const
+{
+    return m_isEnabled;
+}
+
+void EdgeBundler::scheduleUpdate()
+{
+    if (!m_updateTimer.isActive()) {
+        m_updateTimer.start();
+    }
+}
+
+void EdgeBundler::markHubDirty(int index)
+{
+    if (m_hubs.count(index) || (m_graph && m_graph->edgesFromNode(index).size() >= Constants::Edge::bundlingThreshold())) {
+        m_dirtyHubIndices.insert(index);
+    }
+}
+
+void EdgeBundler::handleChanges(const GraphChangeBatch & changes)
+{
+    const auto mindMapData = m_mindMapData.lock();
+    if (!m_isEnabled || !mindMapData || &mindMapData->graph() != m_graph || m_isRebuildPending) {
+        return;
+    }
+
+    const auto & graph = mindMapData->graph();
+    for (auto && change : changes) {
+        switch (change.type) {
+        case GraphChange::Type::NodeMoved:
+            // Moves the trunks of the node and the branches to it
+            if (graph.hasNode(change.nodeIndex)) {
+                markHubDirty(change.nodeIndex);
+                for (auto && edge : graph.edgesToNode(change.nodeIndex)) {
+                    markHubDirty(edge->sourceNode().index());
+                }
+            }
+            break;
+        case GraphChange::Type::NodeRestyled:
+            if (graph.hasNode(change.nodeIndex) && graph.getNode(change.nodeIndex)->collapsed() != static_cast<bool>(m_collapsedIndices.count(change.nodeIndex))) {
+                m_isRebuildPending = true;
+            }
+            break;
+        case GraphChange::Type::NodeRemoved:
+            m_hubs.erase(change.nodeIndex);
+            m_dirtyHubIndices.erase(change.nodeIndex);
+            break;
+        case GraphChange::Type::EdgeAdded:
+        case GraphChange::Type::EdgeRemoved:
+            // The hidden descendants of the collapsed nodes may change
+            if (!m_collapsedIndices.empty()) {
+                m_isRebuildPending = true;
+            }
+            [[fallthrough]];
+        case GraphChange::Type::EdgeRestyled:
+        case GraphChange::Type::EdgeTexted:
+            if (graph.hasNode(change.sourceIndex)) {
+                markHubDirty(change.sourceIndex);
+            }
+            break;
+        case GraphChange::Type::StyleChanged:
+            m_isRebuildPending = true;
+            break;
+        case GraphChange::Type::NodeAdded:
+        case GraphChange::Type::NodeTexted:
+            continue;
+        }
+    }
+
+    if (m_isRebuildPending || !m_dirtyHubIndices.empty()) {
+        scheduleUpdate();
+    }
+}
+
+void EdgeBundler::update()
+{
+    m_updateTimer.stop();
+
+    const auto mindMapData = m_mindMapData.lock();
+    if (!mindMapData || &mindMapData->graph() != m_graph) {
+        // The mind map is gone or its graph has been replaced without a notification
+        m_hubs.clear();
+        m_dirtyHubIndices.clear();
+        return;
+    }
+
+    const auto & graph = mindMapData->graph();
+    if (m_isRebuildPending) {
+        m_isRebuildPending = false;
+        m_dirtyHubIndices.clear();
+        releaseHubs(graph);
+        if (m_isEnabled) {
+            rebuildHubs(graph);
+        }
+    } else if (m_isEnabled) {
+        for (auto && index : m_dirtyHubIndices) {
+            rebuildHub(graph, index);
+        }
+        m_dirtyHubIndices.clear();
+    }
+}
+
+void EdgeBundler::releaseHubs(const Graph & graph)
+{
+    for (auto && hub : m_hubs) {
+        for (auto && edge : graph.edgesFromNode(hub.first)) {
+            edge->setBundleTrunk({});
+        }
+    }
+    m_hubs.clear();
+}
+
+void EdgeBundler::updateHiddenIndices(const Graph & graph)
+{
+    m_collapsedIndices.clear();
+    m_hiddenIndices.clear();
+    for (auto && node : graph.nodes()) {
+        if (node->collapsed()) {
+            m_collapsedIndices.insert(node->index());
+            const auto descendantIndices = graph.descendantIndices(node->index());
+            m_hiddenIndices.insert(descendantIndices.begin(), descendantIndices.end());
+        }
+    }
+}
+
+void EdgeBundler::rebuildHubs(const Graph & graph)
+{
+    updateHiddenIndices(graph);
+    for (auto && node : graph.nodes()) {
+        if (graph.edgesFromNode(node->index()).size() >= Constants::Edge::bundlingThreshold()) {
+            rebuildHub(graph, node->index());
+        }
+    }
+}
+
+void EdgeBundler::rebuildHub(const Graph & graph, int index)
+{
+    m_hubs.erase(index);
+    if (!graph.hasNode(index)) {
+        return;
+    }
+
+    const auto & edges = graph.edgesFromNode(index);
+    const auto hub = graph.getNode(index);
+    const bool isHub = edges.size() >= Constants::Edge::bundlingThreshold() && !hub->collapsed() && !m_hiddenIndices.count(index);
+
+    // Grouped by the sector of the direction and by the dashing, as the color and the width are the same for all edges
+    std::map<int, EdgeGroup> groups;
+    const auto sectorCount = Constants::Edge::bundleSectorCount();
+    const auto hubPos = hub->location();
+    for (auto && edge : edges) {
+        const auto direction = edge->line().p2() - hubPos;
+        const auto length = std::hypot(direction.x(), direction.y());
+        // The labels are positioned on the straight line
+        if (!isHub || &edge->targetNode() == hub.get() || !edge->text().isEmpty() || m_hiddenIndices.count(edge->targetNode().index()) || length <= 0) {
+            edge->setBundleTrunk({});
+            continue;
+        }
+
+        // The sectors are centered on the axes, so that e.g. a fan of children to the right is one bundle
+        const auto angle = std::atan2(direction.y(), direction.x()) + M_PI + M_PI / sectorCount;
+        const auto sector = static_cast<int>(angle / (2 * M_PI) * sectorCount) % sectorCount;
+        auto && group = groups[sector * 2 + (edge->dashedLine() ? 1 : 0)];
+        group.edges.push_back(edge.get());
+        group.directionSum += direction / length;
+    }
+
+    std::vector<Bundle> bundles;
+    for (auto && keyAndGroup : groups) {
+        auto && group = keyAndGroup.second;
+        const auto sumLength = std::hypot(group.directionSum.x(), group.directionSum.y());
+        std::optional<QLineF> trunk;
+        if (group.edges.size() >= 2 && sumLength > 0) {
+            // The fork is halfway between the border of the hub and the nearest target along the trunk
+            const auto direction = group.directionSum / sumLength;
+            const auto borderDistance = distanceToBorder(hub->size(), direction);
+            auto nearestDistance = std::numeric_limits<double>::max();
+            for (auto && edge : group.edges) {
+                const auto offset = edge->line().p2() - hubPos;
+                nearestDistance = std::min(nearestDistance, QPointF::dotProduct(offset, direction));
+            }
+            if (nearestDistance - borderDistance >= 2 * MIN_TRUNK_LENGTH) {
+                trunk = QLineF { hubPos + direction * borderDistance, hubPos + direction * (borderDistance + nearestDistance) / 2 };
+            }
+        }
+
+        if (!trunk) {
+            for (auto && edge : group.edges) {
+                edge->setBundleTrunk({});
+            }
+            continue;
+        }
+
+        Bundle bundle;
+        bundle.pen = group.edges.front()->pen();
+        bundle.edgeCount = group.edges.size();
+        bundle.path.moveTo(trunk->p1());
+        bundle.path.lineTo(trunk->p2());
+        for (auto && edge : group.edges) {
+            edge->setBundleTrunk(trunk);
+            bundle.path.moveTo(trunk->p2());
+            bundle.path.lineTo(edge->line().p2());
+        }
+        const auto margin = bundle.pen.widthF() / 2 + 1;
+        bundle.boundingRect = bundle.path.boundingRect().adjusted(-margin, -margin, margin, margin);
+        bundles.push_back(bundle);
+    }
+
+    if (!bundles.empty()) {
+        m_hubs[index] = std::move(bundles);
+    }
+}
+
+void EdgeBundler::draw(QPainter & painter, const QRectF & sceneRect) const
+{
+    if (m_hubs.empty()) {
+        return;
+    }
+
+    painter.save();
+    painter.setBrush(Qt::NoBrush);
+    const bool isMinimal = LevelOfDetail::tier(painter) == LevelOfDetail::Tier::Minimal;
+    if (isMinimal) {
+        painter.setRenderHint(QPainter::Antialiasing, false);
+    }
+    for (auto && hub : m_hubs) {
+        for (auto && bundle : hub.second) {
+            if (bundle.boundingRect.intersects(sceneRect)) {
+                // Zero width makes a cosmetic one pixel pen like the edges of the Minimal level of detail
+                painter.setPen(isMinimal ? QPen { bundle.pen.color(), 0 } : bundle.pen);
+                painter.drawPath(bundle.path);
+            }
+        }
+    }
+    painter.restore();
+}
+
+std::vector<EdgeBundler::Bundle> EdgeBundler::bundles() const
+{
+    std::vector<Bundle> bundles;
+    for (auto && hub : m_hubs) {
+        bundles.insert(bundles.end(), hub.second.begin(), hub.second.end());
+    }
+    return bundles;
+}
+
+bool EdgeBundler::hasBundles() const
+{
+    return !m_hubs.empty();
+}
@@ -0,0 +1,130 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef EDGE_BUNDLER_HPP
+#define EDGE_BUNDLER_HPP
+
+#include "../common/types.hpp"
+#include "../domain/graph_change_notifier.hpp"
+
+#include <QPainterPath>
+#include <QPen>
+#include <QRectF>
+#include <QTimer>
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class Graph;
+class QPainter;
+
+//! Bundles the edges of hub nodes, i.e. nodes with many outgoing edges, so that the edges that leave a hub in the
+//! same direction share a trunk from the hub to a fork, from where they branch to their targets. The trunk and the
+//! branches of a bundle are drawn as one path instead of each edge drawing its own line, arrowheads and dots.
+//! The edges stay in the scene and keep their own cached shapes along their routes, so they are still hit tested
+//! and selected one by one, see SceneItems::Edge::setBundleTrunk().
+//!
+//! The bundles follow the change stream of the graph: the bundles of the hubs whose edges have moved are computed
+//! again once on the next event loop iteration, however many changes there were. EditorView draws them below the
+//! items, see SettingsProxy::edgeBundling(). Exports are rendered from their own items without bundles.
+class EdgeBundler
+{
+public:
+    //! The trunk and the branches of the edges that leave a hub in one direction with the same pen.
+    struct Bundle
+    {
+        QPainterPath path;
+
+        QPen pen;
+
+        QRectF boundingRect;
+
+        size_t edgeCount = 0;
+    };
+
+    EdgeBundler();
+
+    ~EdgeBundler();
+
+    EdgeBundler(const EdgeBundler &) = delete;
+
+    EdgeBundler & operator=(const EdgeBundler &) = delete;
+
+    //! Follows the graph of the given mind map until another one is set. The mind map is not kept alive.
+    void setMindMapData(MindMapDataS mindMapData);
+
+    //! Bundles the edges, or routes them straight again, on the next event loop iteration.
+    void setEnabled(bool enabled);
+
+    bool isEnabled() const;
+
+    //! Draws the bundles that intersect the given scene rect with the current transform of the painter.
+    void draw(QPainter & painter, const QRectF & sceneRect) const;
+
+    //! \returns The current bundles of all hubs.
+    std::vector<Bundle> bundles() const;
+
+    bool hasBundles() const;
+
+    //! Computes the pending bundles now instead of on the next event loop iteration, e.g. in tests.
+    void update();
+
+private:
+    void handleChanges(const GraphChangeBatch & changes);
+
+    void markHubDirty(int index);
+
+    void scheduleUpdate();
+
+    void unsubscribe();
+
+    //! Routes the edges of all hubs straight again.
+    void releaseHubs(const Graph & graph);
+
+    void rebuildHubs(const Graph & graph);
+
+    //! Groups the outgoing edges of the given node by direction and pen and sets or clears their trunks.
+    void rebuildHub(const Graph & graph, int index);
+
+    void updateHiddenIndices(const Graph & graph);
+
+    std::weak_ptr<MindMapData> m_mindMapData;
+
+    //! Only compared with the graph of the mind map, which may have been replaced since subscribing.
+    const Graph * m_graph = nullptr;
+
+    GraphChangeNotifier::SubscriptionId m_subscriptionId = 0;
+
+    bool m_isEnabled = false;
+
+    //! True if all hubs need to be computed again, e.g. after enabling or a collapse.
+    bool m_isRebuildPending = false;
+
+    std::unordered_set<int> m_dirtyHubIndices;
+
+    //! Bundles by the index of the hub.
+    std::unordered_map<int, std::vector<Bundle>> m_hubs;
+
+    std::unordered_set<int> m_collapsedIndices;
+
+    //! The descendants of the collapsed nodes, whose edges are not in the scene.
+    std::unordered_set<int> m_hiddenIndices;
+
+    QTimer m_updateTimer;
+};
+
+#endif // EDGE_BUNDLER_HPP
@@ -16,6 +16,7 @@
 #include "edge_selection_group.hpp"
 
 #include "scene_items/edge.hpp"
+#include "scene_items/selection_update_batch.hpp"
 
 #include <algorithm>
 
@@ -39,6 +40,8 @@ void EdgeSelectionGroup::clear(bool implicitOnly)
 
 void EdgeSelectionGroup::clearAll()
 {
+    const SceneItems::SelectionUpdateBatch selectionUpdateBatch;
+
     for (auto && edge : m_edges) {
         edge->setSelected(false);
     }
@@ -48,6 +51,8 @@ void EdgeSelectionGroup::clearAll()
 
 void EdgeSelectionGroup::clearImplicitOnly()
 {
+    const SceneItems::SelectionUpdateBatch selectionUpdateBatch;
+
     for (auto && edge : m_edges) {
         if (m_implicitlyAdded.count(edge) && m_implicitlyAdded.at(edge)) {
             edge->setSelected(false);
@@ -87,6 +92,28 @@ std::optional<EdgeP> EdgeSelectionGroup::selectedEdge() const
     return !m_edges.empty() ? std::optional<EdgeP> { *m_edges.begin() } : std::optional<EdgeP> {};
 }
 
+void EdgeSelectionGroup::set(const std::vector<EdgeP> & edges)
+{
+    const SceneItems::SelectionUpdateBatch selectionUpdateBatch;
+
+    const std::unordered_set<EdgeP> selected(edges.begin(), edges.end());
+    for (auto && edge : m_edges) {
+        if (!selected.count(edge)) {
+            edge->setSelected(false);
+        }
+    }
+    m_implicitlyAdded.clear();
+    m_edges.clear();
+
+    m_edges.reserve(selected.size());
+    for (auto && edge : edges) {
+        if (m_implicitlyAdded.emplace(edge, false).second) {
+            m_edges.push_back(edge);
+            edge->setSelected(true);
+        }
+    }
+}
+
 size_t EdgeSelectionGroup::size() const
 {
     return m_edges.size();
@@ -102,3 +129,28 @@ void EdgeSelectionGroup::toggle(EdgeR edge)
         add(edge);
     }
 }
+
+void EdgeSelectionGroup::toggle(const std::vector<EdgeP> & edges)
+{
+    const SceneItems::SelectionUpdateBatch selectionUpdateBatch;
+
+    std::unordered_set<EdgeP> unselected;
+    for (auto && edge : edges) {
+        if (edge->selected()) {
+            unselected.insert(edge);
+        } else {
+            add(*edge);
+        }
+    }
+
+    if (!unselected.empty()) {
+        m_edges.erase(std::remove_if(m_edges.begin(), m_edges.end(), [&unselected](auto && edge) {
+                          return unselected.count(edge);
+                      }),
+                      m_edges.end());
+        for (auto && edge : unselected) {
+            edge->setSelected(false);
+            m_implicitlyAdded.erase(edge);
+        }
+    }
+}
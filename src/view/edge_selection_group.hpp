@@ -20,6 +20,7 @@
 
 #include <optional>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "../common/types.hpp"
@@ -44,10 +45,16 @@ public:
 
     std::optional<EdgeP> selectedEdge() const;
 
+    //! Replaces the group with the given edges. Only the edges whose selection actually changes are updated.
+    void set(const std::vector<EdgeP> & edges);
+
     size_t size() const;
 
     void toggle(EdgeR edge);
 
+    //! Toggles all given edges at once in O(group size + edges) instead of O(group size) per edge.
+    void toggle(const std::vector<EdgeP> & edges);
+
 private:
     void clearAll();
 
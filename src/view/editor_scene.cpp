@@ -15,26 +15,50 @@
 
 #include "editor_scene.hpp"
 
+#include "../application/service_container.hpp"
+#include "../application/settings_proxy.hpp"
+#include "../application/settings_snapshot.hpp"
 #include "../common/constants.hpp"
+#include "../domain/graph.hpp"
+#include "../domain/graph_snapshot.hpp"
 #include "magic_zoom.hpp"
+#include "shadow_renderer.hpp"
 
 #include "scene_items/edge.hpp"
 #include "scene_items/edge_text_edit.hpp"
 #include "scene_items/node.hpp"
+#include "scene_items/node_hover_overlay.hpp"
 
 #include "simple_logger.hpp"
 
-#include <QGraphicsEffect>
 #include <QGraphicsLineItem>
 #include <QPainter>
-#include <QtSvg/QSvgGenerator>
+#include <QTimer>
+
+#include <algorithm>
+#include <cmath>
+#include <set>
 
 static const auto TAG = "EditorScene";
 
+namespace {
+
+// Rough size of the private data of a graphics item and its entry in the item index
+const size_t estimatedItemOverhead = 512;
+
+// Rough size of a node of the edge registry maps including the bucket
+const size_t estimatedEdgeRegistryEntrySize = 64;
+
+} // namespace
+
 EditorScene::EditorScene()
+  : m_settingsProxy(ServiceContainer::instance().settingsProxy())
+  , m_nodeHoverOverlay(std::make_unique<SceneItems::NodeHoverOverlay>())
 {
     setSceneRect(-m_initialSize, -m_initialSize, m_initialSize * 2, m_initialSize * 2);
 
+    addItem(m_nodeHoverOverlay.get());
+
     connect(this, &QGraphicsScene::focusItemChanged, this, [](QGraphicsItem *, QGraphicsItem * oldFocus, Qt::FocusReason) {
         if (const auto edgeTextEdit = dynamic_cast<SceneItems::EdgeTextEdit *>(oldFocus); edgeTextEdit) {
             edgeTextEdit->updateDueToLostFocus();
@@ -44,9 +68,92 @@ EditorScene::EditorScene()
 
 void EditorScene::adjustSceneRect()
 {
-    while (!containsAll()) {
-        setSceneRect(sceneRect().adjusted(-m_initialSize, -m_initialSize, m_initialSize, m_initialSize));
-        juzzlin::L(TAG).debug() << "New scene rect: " << sceneRect().x() << " " << sceneRect().y() << " " << sceneRect().width() << " " << sceneRect().height();
+    const auto bounds = nodeBounds();
+    if (bounds.isNull()) {
+        return;
+    }
+
+    // The nodes must fit inside the scene rect shrunk by the margin on each side
+    const double marginFactor = .25;
+    const auto containsBounds = [&](const QRectF & rect) {
+        const auto marginX = rect.width() * marginFactor;
+        const auto marginY = rect.height() * marginFactor;
+        return rect.adjusted(marginX, marginY, -marginX, -marginY).contains(bounds);
+    };
+
+    auto rect = sceneRect();
+    while (!containsBounds(rect)) {
+        rect.adjust(-m_initialSize, -m_initialSize, m_initialSize, m_initialSize);
+    }
+
+    if (rect != sceneRect()) {
+        setSceneRect(rect);
+        juzzlin::L(TAG).debug() << "New scene rect: " << rect.x() << " " << rect.y() << " " << rect.width() << " " << rect.height();
+    }
+}
+
+void EditorScene::beginBulkInsert()
+{
+    beginBulkUpdate();
+}
+
+void EditorScene::endBulkInsert()
+{
+    endBulkUpdate();
+    adjustSceneRect();
+}
+
+void EditorScene::beginBulkMove()
+{
+    beginBulkUpdate();
+}
+
+void EditorScene::endBulkMove()
+{
+    endBulkUpdate();
+    invalidateNodeBounds();
+    adjustSceneRect();
+}
+
+void EditorScene::beginBulkUpdate()
+{
+    if (!m_bulkUpdateDepth++) {
+        setItemIndexMethod(NoIndex);
+    }
+}
+
+void EditorScene::endBulkUpdate()
+{
+    if (!--m_bulkUpdateDepth) {
+        // Setting the index method rebuilds the index from all items at once
+        const auto depth = tunedBspTreeDepth();
+        juzzlin::L(TAG).debug() << "Rebuilding the item index with BSP tree depth " << depth;
+        setBspTreeDepth(depth);
+        setItemIndexMethod(BspTreeIndex);
+    }
+}
+
+void EditorScene::notifyNodeMove()
+{
+    if (!m_nodeMoveCount) {
+        // Re-inserting a few nodes is cheaper than rebuilding the whole index, e.g. when dragging a selection
+        m_bulkMoveThreshold = std::max(Constants::View::bulkInsertThreshold(), static_cast<size_t>(static_cast<double>(m_edges.size()) * Constants::View::bulkMoveFraction()));
+        QTimer::singleShot(0, this, &EditorScene::finishNodeMoves);
+    }
+
+    if (++m_nodeMoveCount == m_bulkMoveThreshold) {
+        juzzlin::L(TAG).debug() << "Disabling the item index for a bulk move";
+        m_isBulkMoveActive = true;
+        beginBulkUpdate();
+    }
+}
+
+void EditorScene::finishNodeMoves()
+{
+    m_nodeMoveCount = 0;
+    if (m_isBulkMoveActive) {
+        m_isBulkMoveActive = false;
+        endBulkUpdate();
     }
 }
 
@@ -60,79 +167,215 @@ QRectF EditorScene::calculateZoomToFitRectangleByNodes(const std::vector<NodeP>
     return MagicZoom::calculateRectangleByNodes(nodes, false);
 }
 
-bool EditorScene::containsAll() const
+void EditorScene::drawBackground(QPainter * painter, const QRectF & rect)
 {
-    const double marginFactor = .25;
-    const auto testMarginX = sceneRect().width() * marginFactor;
-    const auto testMarginY = sceneRect().height() * marginFactor;
-    const auto testRect = sceneRect().adjusted(testMarginX, testMarginY, -testMarginX, -testMarginY);
-    for (auto && item : items()) {
-        if (const auto node = dynamic_cast<NodeP>(item); node && !testRect.contains(item->sceneBoundingRect())) {
-            return false;
+    QGraphicsScene::drawBackground(painter, rect);
+
+    ShadowRenderer::drawShadows(*painter, rect, *this, m_settingsProxy->snapshot()->shadowEffect);
+}
+
+GraphSnapshot EditorScene::graphSnapshotInRect(QRectF rect) const
+{
+    // The text items and lines of the nodes and edges are their children
+    std::set<NodeP> nodes;
+    std::set<EdgeP> edges;
+    for (auto && item : items(rect)) {
+        if (const auto node = qgraphicsitem_cast<NodeP>(item->topLevelItem())) {
+            nodes.insert(node);
+        } else if (const auto edge = qgraphicsitem_cast<EdgeP>(item->topLevelItem())) {
+            edges.insert(edge);
+            nodes.insert(&edge->sourceNode());
+            nodes.insert(&edge->targetNode());
         }
     }
-    return true;
+
+    GraphSnapshot::NodeDataVector nodeData;
+    nodeData.reserve(nodes.size());
+    for (auto && node : nodes) {
+        nodeData.push_back(node->model());
+    }
+    // Keep the order of the graph so that the stacking of the items doesn't depend on the addresses
+    std::sort(nodeData.begin(), nodeData.end(), [](auto && lhs, auto && rhs) {
+        return lhs.index < rhs.index;
+    });
+
+    GraphSnapshot::EdgeDataVector edgeData;
+    edgeData.reserve(edges.size());
+    for (auto && edge : edges) {
+        edgeData.push_back({ edge->model(), edge->sourceNode().index(), edge->targetNode().index() });
+    }
+
+    return { std::move(nodeData), std::move(edgeData) };
 }
 
-void EditorScene::enableGraphicsEffects(bool enable) const
+std::vector<EdgeP> EditorScene::edgesInRect(QRectF rect, Qt::ItemSelectionMode mode) const
 {
-    for (auto && item : items()) {
-        if (item->graphicsEffect()) {
-            item->graphicsEffect()->setEnabled(enable);
+    std::vector<EdgeP> edges;
+    for (auto && item : items(rect, mode)) {
+        if (const auto edge = qgraphicsitem_cast<EdgeP>(item)) {
+            edges.push_back(edge);
         }
     }
+    return edges;
 }
 
-bool EditorScene::hasEdge(NodeR node0, NodeR node1)
+std::vector<NodeP> EditorScene::nodesInRect(QRectF rect, Qt::ItemSelectionMode mode) const
 {
-    for (auto && item : items()) {
-        if (const auto edge = dynamic_cast<EdgeP>(item); edge && edge->sourceNode().index() == node0.index() && edge->targetNode().index() == node1.index()) {
-            return true;
+    std::vector<NodeP> nodes;
+    for (auto && item : items(rect, mode)) {
+        if (const auto node = qgraphicsitem_cast<NodeP>(item)) {
+            nodes.push_back(node);
         }
     }
-    return false;
+    return nodes;
 }
 
-void EditorScene::removeItems()
+SceneItems::NodeHoverOverlay & EditorScene::nodeHoverOverlay()
 {
-    // We don't want the scene to destroy the items as they are managed elsewhere
-    for (auto && item : items()) {
-        removeItem(item);
+    return *m_nodeHoverOverlay;
+}
+
+MemoryUsage EditorScene::memoryUsage() const
+{
+    const auto itemCount = static_cast<size_t>(items().size());
+    return { itemCount, itemCount * estimatedItemOverhead + (m_edges.size() + m_edgeKeys.size()) * estimatedEdgeRegistryEntrySize };
+}
+
+bool EditorScene::hasEdge(NodeR node0, NodeR node1) const
+{
+    return m_edges.count(Graph::buildKeyFromIndices(node0.index(), node1.index()));
+}
+
+void EditorScene::includeInNodeBounds(QGraphicsItem & item)
+{
+    if (!m_nodeBoundsDirty && qgraphicsitem_cast<NodeP>(&item)) {
+        m_nodeBounds = m_nodeBounds.united(item.sceneBoundingRect());
+    }
+}
+
+void EditorScene::invalidateNodeBounds()
+{
+    m_nodeBoundsDirty = true;
+}
+
+QRectF EditorScene::nodeBounds()
+{
+    if (m_nodeBoundsDirty) {
+        m_nodeBounds = {};
+        for (auto && item : items()) {
+            if (qgraphicsitem_cast<NodeP>(item)) {
+                m_nodeBounds = m_nodeBounds.united(item->sceneBoundingRect());
+            }
+        }
+        m_nodeBoundsDirty = false;
+    }
+    return m_nodeBounds;
+}
+
+int EditorScene::tunedBspTreeDepth() const
+{
+    const auto allItems = items();
+    QRectF itemBounds;
+    for (auto && item : allItems) {
+        if (!item->parentItem()) {
+            itemBounds = itemBounds.united(item->sceneBoundingRect());
+        }
+    }
+
+    const auto sceneArea = sceneRect().width() * sceneRect().height();
+    const auto occupiedFraction = itemBounds.isNull() || sceneArea <= 0 ? 1.0 : std::clamp(itemBounds.width() * itemBounds.height() / sceneArea, 1e-6, 1.0);
+
+    // A tree of depth d has 2^d leaves over the scene rect
+    const double itemsPerLeaf = 8;
+    const auto leafCount = static_cast<double>(allItems.size()) / (itemsPerLeaf * occupiedFraction);
+    const int minDepth = 1;
+    const int maxDepth = 16;
+    return std::clamp(static_cast<int>(std::ceil(std::log2(std::max(leafCount, 1.0)))), minDepth, maxDepth);
+}
+
+void EditorScene::registerEdge(EdgeR edge)
+{
+    const auto key = Graph::buildKeyFromIndices(edge.sourceNode().index(), edge.targetNode().index());
+    m_edges[key] = &edge;
+    m_edgeKeys[&edge] = key;
+}
+
+void EditorScene::unregisterEdge(EdgeR edge)
+{
+    if (const auto keyIter = m_edgeKeys.find(&edge); keyIter != m_edgeKeys.end()) {
+        // Don't drop a newer edge item between the same nodes
+        if (const auto edgeIter = m_edges.find(keyIter->second); edgeIter != m_edges.end() && edgeIter->second == &edge) {
+            m_edges.erase(edgeIter);
+        }
+        m_edgeKeys.erase(keyIter);
     }
 }
 
-QImage EditorScene::toImage(QSize size, QColor backgroundColor, bool transparentBackground)
+void EditorScene::setUndoPointHandler(std::function<void(const QGraphicsItem & item)> handler)
 {
-    QImage image(size, QImage::Format_ARGB32);
-    image.fill(transparentBackground ? Qt::transparent : backgroundColor);
+    m_undoPointHandler = handler;
+}
 
-    QPainter painter(&image);
-    painter.setRenderHint(QPainter::Antialiasing);
-    painter.setRenderHint(QPainter::TextAntialiasing);
-    render(&painter);
+void EditorScene::requestUndoPoint(const QGraphicsItem & item)
+{
+    if (m_undoPointHandler) {
+        m_undoPointHandler(item);
+    }
+}
 
-    return image;
+void EditorScene::setTextEditHandler(std::function<void()> handler)
+{
+    m_textEditHandler = handler;
 }
 
-void EditorScene::toSvg(QString filename, QString title)
+void EditorScene::notifyTextEdited()
 {
-    // Need to disable effects in order to get vectorized SVG.
-    // Otherwise all items will be just bitmapped.
-    enableGraphicsEffects(false);
+    if (m_textEditHandler) {
+        m_textEditHandler();
+    }
+}
 
-    QSvgGenerator generator;
-    generator.setFileName(filename);
-    generator.setSize(QSize(static_cast<int>(width()), static_cast<int>(height())));
-    generator.setViewBox(QRect(0, 0, static_cast<int>(width()), static_cast<int>(height())));
-    generator.setTitle(title);
-    generator.setDescription(QString { "SVG exported from %1 version %2" }.arg(Constants::Application::applicationName(), Constants::Application::applicationVersion()));
+void EditorScene::setImageHandler(ImageHandler handler)
+{
+    m_imageHandler = handler;
+}
 
-    QPainter painter;
-    painter.begin(&generator);
-    render(&painter);
-    painter.end();
+void EditorScene::requestImage(size_t imageRef, NodeR node)
+{
+    if (m_imageHandler) {
+        m_imageHandler(imageRef, node);
+    }
+}
+
+void EditorScene::removeItems()
+{
+    // We don't want the scene to destroy the items as they are managed elsewhere
+    for (auto && item : items()) {
+        removeItem(item);
+    }
+}
+
+QImage EditorScene::toImageBand(QSize size, QColor backgroundColor, bool transparentBackground, int bandTop, int bandHeight)
+{
+    // Same mapping as render() would use for the whole image with Qt::KeepAspectRatio
+    const auto source = sceneRect();
+    const auto ratio = std::min(size.width() / source.width(), size.height() / source.height());
+    const auto contentWidth = std::min(static_cast<double>(size.width()), source.width() * ratio);
+    const auto contentHeight = std::min(static_cast<double>(size.height()), source.height() * ratio);
+
+    QImage band(size.width(), std::min(bandHeight, size.height() - bandTop), QImage::Format_ARGB32_Premultiplied);
+    band.fill(transparentBackground ? Qt::transparent : backgroundColor);
+
+    // Only render the part of the scene that's visible in this band so that items are culled per band
+    if (const auto bandContentHeight = std::min(static_cast<double>(band.height()), contentHeight - bandTop); bandContentHeight > 0) {
+        QPainter painter(&band);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setRenderHint(QPainter::TextAntialiasing);
+        const QRectF bandSource { source.left(), source.top() + bandTop / ratio, contentWidth / ratio, bandContentHeight / ratio };
+        render(&painter, { 0, 0, contentWidth, bandContentHeight }, bandSource, Qt::IgnoreAspectRatio);
+    }
 
-    enableGraphicsEffects(true);
+    return band;
 }
 
 EditorScene::~EditorScene()
@@ -16,45 +16,169 @@
 #ifndef EDITOR_SCENE_HPP
 #define EDITOR_SCENE_HPP
 
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include <QGraphicsScene>
 
 #include "../common/types.hpp"
+#include "../domain/memory_usage.hpp"
 
+class GraphSnapshot;
 class Node;
 
+namespace SceneItems {
+class NodeHoverOverlay;
+}
+
 class EditorScene : public QGraphicsScene
 {
 public:
     EditorScene();
 
+    //! Grows the scene rect in one step so that it has enough margin around the node bounds.
     void adjustSceneRect();
 
+    //! Disables the item index so that many items can be added without updating the index for each one.
+    void beginBulkInsert();
+
+    //! Rebuilds the item index and adjusts the scene rect once for all items added since beginBulkInsert().
+    void endBulkInsert();
+
+    //! Disables the item index while nodes move over several event loop iterations, e.g. during a LayoutTransition.
+    void beginBulkMove();
+
+    //! Rebuilds the item index and recomputes the node bounds and the scene rect once for the moves since beginBulkMove().
+    void endBulkMove();
+
+    //! Called by the nodes before they move. Once enough nodes move within one event loop iteration, e.g. on a layout,
+    //! mirroring or undo, the item index is disabled so that the rest of the moves don't re-insert the nodes and their
+    //! edges into the BSP tree one by one. The index is rebuilt once when control returns to the event loop.
+    void notifyNodeMove();
+
     QRectF calculateZoomToFitRectangle(bool isForExport = false) const;
 
     QRectF calculateZoomToFitRectangleByNodes(const std::vector<NodeP> & nodes) const;
 
+    //! \returns Plain copy of the nodes and edges intersecting the given rect, found through the item index
+    //! so that the cost depends on the size of the rect only. Includes the nodes at the ends of the edges.
+    GraphSnapshot graphSnapshotInRect(QRectF rect) const;
+
+    //! \returns The edges in the given rect, found through the item index and identified by their item type.
+    std::vector<EdgeP> edgesInRect(QRectF rect, Qt::ItemSelectionMode mode = Qt::IntersectsItemShape) const;
+
+    //! \returns The nodes in the given rect, found through the item index and identified by their item type.
+    std::vector<NodeP> nodesInRect(QRectF rect, Qt::ItemSelectionMode mode = Qt::IntersectsItemBoundingRect) const;
+
+    //! Extends the cached node bounds by the given item if it's a node. Call when a node has been added to the scene.
+    void includeInNodeBounds(QGraphicsItem & item);
+
+    //! Marks the cached node bounds to be recomputed on the next adjustSceneRect(), e.g. after nodes have been moved.
+    void invalidateNodeBounds();
+
+    //! \returns The overlay that paints the node raised on mouse hover on top of the other items.
+    SceneItems::NodeHoverOverlay & nodeHoverOverlay();
+
+    //! \returns Item count and estimated bookkeeping memory of all items in the scene, including child items
+    //! such as edge labels. The memory of the nodes and edges themselves is accounted by Graph::memoryUsage().
+    MemoryUsage memoryUsage() const;
+
     //! Checks if the graphics scene already has the given edge item added
-    bool hasEdge(NodeR node0, NodeR node1);
+    bool hasEdge(NodeR node0, NodeR node1) const;
+
+    //! Adds the edge to the edge registry. Called by the edge when it's added to the scene.
+    void registerEdge(EdgeR edge);
+
+    //! Removes the edge from the edge registry. Called by the edge when it's removed from the scene.
+    void unregisterEdge(EdgeR edge);
+
+    //! Handles the undo point requests of all the items in the scene, so that the items don't need to be connected one by one.
+    //! The handler gets the item that requests the undo point, so that consecutive requests of the same item can be merged.
+    void setUndoPointHandler(std::function<void(const QGraphicsItem & item)> handler);
+
+    //! Called by the items in the scene, e.g. when text editing begins and on each keystroke.
+    void requestUndoPoint(const QGraphicsItem & item);
+
+    //! Handles the text edits of all the items in the scene, which change the mind map without an undo point per key press.
+    void setTextEditHandler(std::function<void()> handler);
+
+    //! Called by the items in the scene when their text is edited.
+    void notifyTextEdited();
 
-    QImage toImage(QSize size, QColor backgroundColor, bool transparentBackground);
+    using ImageHandler = std::function<void(size_t imageRef, NodeR node)>;
 
-    void toSvg(QString fileName, QString title);
+    //! Handles the image requests of all the nodes in the scene, see ImageManager::handleImageRequest().
+    void setImageHandler(ImageHandler handler);
+
+    //! Called by the nodes in the scene when their image changes or when they are added to the scene.
+    void requestImage(size_t imageRef, NodeR node);
+
+    //! Renders one horizontal band of the image of the given size that the scene rect would be rendered to,
+    //! so that large images can be rendered without ever having the whole image in memory.
+    QImage toImageBand(QSize size, QColor backgroundColor, bool transparentBackground, int bandTop, int bandHeight);
 
     virtual ~EditorScene() override;
 
+protected:
+    //! Draws the item shadows when the scene is rendered without a view, e.g. on PNG export.
+    void drawBackground(QPainter * painter, const QRectF & rect) override;
+
 private:
-    bool containsAll() const;
+    //! Disables the item index until the matching endBulkUpdate(). Bulk inserts and bulk moves can be nested.
+    void beginBulkUpdate();
+
+    //! Rebuilds the item index with a tuned depth when the outermost bulk update ends.
+    void endBulkUpdate();
+
+    void finishNodeMoves();
 
-    void enableGraphicsEffects(bool enable) const;
+    QRectF nodeBounds();
+
+    //! \returns BSP tree depth for which the leaves covering the items hold a few items each.
+    //! Qt splits the whole scene rect, which grows in big steps around the nodes, so its automatic depth
+    //! only accounts for the item count and not for how much of the scene rect the items occupy.
+    int tunedBspTreeDepth() const;
 
     void removeItems();
 
     using ItemPtr = std::unique_ptr<QGraphicsItem>;
     std::vector<ItemPtr> m_ownItems;
 
+    SettingsProxyS m_settingsProxy;
+
+    //! Removed from the scene with the other items on destruction so that the scene doesn't delete it.
+    std::unique_ptr<SceneItems::NodeHoverOverlay> m_nodeHoverOverlay;
+
     const int m_initialSize = 10000;
+
+    int m_bulkUpdateDepth = 0;
+
+    //! Node moves in the current event loop iteration.
+    size_t m_nodeMoveCount = 0;
+
+    size_t m_bulkMoveThreshold = 0;
+
+    bool m_isBulkMoveActive = false;
+
+    //! Union of the scene bounding rects of the nodes. Removed nodes are not subtracted as the scene rect never shrinks.
+    QRectF m_nodeBounds;
+
+    bool m_nodeBoundsDirty = false;
+
+    //! Maps the connection hash of the edges in the scene, see Graph::buildKeyFromIndices(), to the edge items.
+    std::unordered_map<int64_t, EdgeP> m_edges;
+
+    //! Reverse of m_edges so that unregistering doesn't need to access the nodes, which may already be gone.
+    std::unordered_map<EdgeP, int64_t> m_edgeKeys;
+
+    std::function<void(const QGraphicsItem & item)> m_undoPointHandler;
+
+    std::function<void()> m_textEditHandler;
+
+    ImageHandler m_imageHandler;
 };
 
 #endif // EDITOR_SCENE_HPP
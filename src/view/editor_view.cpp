@@ -16,10 +16,20 @@
 #include <QApplication>
 #include <QGraphicsItem>
 #include <QGraphicsSimpleTextItem>
+#include <QImageReader>
+#include <QKeyEvent>
 #include <QLabel>
 #include <QMimeData>
 #include <QMouseEvent>
+#if QT_CONFIG(opengl)
+#include <QOpenGLContext>
+#include <QOpenGLWidget>
+#endif
+#include <QPainter>
+#include <QPixmap>
+#include <QPixmapCache>
 #include <QRectF>
+#include <QResizeEvent>
 #include <QRubberBand>
 #include <QStatusBar>
 #include <QString>
@@ -31,8 +41,12 @@
 #include "../application/control_strategy.hpp"
 #include "../application/service_container.hpp"
 #include "../application/settings_proxy.hpp"
+#include "../application/settings_snapshot.hpp"
 #include "../common/constants.hpp"
+#include "../common/profiler.hpp"
+#include "../common/trace_recorder.hpp"
 #include "../common/utils.hpp"
+#include "../domain/image.hpp"
 #include "../domain/mind_map_data.hpp"
 #include "item_filter.hpp"
 #include "magic_zoom.hpp"
@@ -40,23 +54,36 @@
 #include "mouse_action.hpp"
 #include "scene_items/edge.hpp"
 #include "scene_items/edge_text_edit.hpp"
+#include "scene_items/level_of_detail.hpp"
 #include "scene_items/node.hpp"
 #include "scene_items/node_handle.hpp"
-#include "scene_items/scene_item_base.hpp"
+#include "shadow_renderer.hpp"
+#include "widgets/minimap.hpp"
 #include "widgets/status_label.hpp"
 
 #include "simple_logger.hpp"
 
-#include <unordered_set>
+#include <algorithm>
+#include <cmath>
 
 using juzzlin::L;
 
 static const auto TAG = "EditorView";
 
+namespace {
+const Graph * currentGraph()
+{
+    const auto applicationService = SC::instance().applicationService();
+    return applicationService && applicationService->mindMapData() ? &applicationService->mindMapData()->graph() : nullptr;
+}
+} // namespace
+
 EditorView::EditorView()
   : m_edgeContextMenu { new Menus::EdgeContextMenu { this } }
   , m_mainContextMenu { new Menus::MainContextMenu { this, m_grid } }
   , m_controlStrategy { SC::instance().controlStrategy() }
+  , m_settingsProxy { SC::instance().settingsProxy() }
+  , m_scenePrewarmer { currentGraph, SC::instance().guiJobScheduler() }
 {
     setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
@@ -66,13 +93,64 @@ EditorView::EditorView()
 
     setRenderHint(QPainter::Antialiasing);
 
+    // Node backgrounds, shadows and texts at rest are all drawn from cached pixmaps
+    QPixmapCache::setCacheLimit(std::max(QPixmapCache::cacheLimit(), Constants::View::pixmapCacheLimitKb()));
+
+    setHardwareAccelerationEnabled(m_settingsProxy->hardwareAcceleration());
+
+    m_mouseMoveTimer.setSingleShot(true);
+    m_mouseMoveTimer.setInterval(Constants::View::mouseMoveInterval());
+    connect(&m_mouseMoveTimer, &QTimer::timeout, this, [this] {
+        if (m_isMouseMovePending) {
+            processMouseMove();
+            m_mouseMoveTimer.start();
+        }
+    });
+
+    m_minimap = new Widgets::Minimap { currentGraph, this };
+    connect(m_minimap, &Widgets::Minimap::centerRequested, this, [this](QPointF scenePosition) {
+        centerOn(scenePosition);
+    });
+
+    m_gestureSettleTimer.setSingleShot(true);
+    m_gestureSettleTimer.setInterval(Constants::View::gestureSettleInterval());
+    connect(&m_gestureSettleTimer, &QTimer::timeout, this, &EditorView::finishGesture);
+
     // Forward signals from main context menu
     connect(m_mainContextMenu, &Menus::MainContextMenu::actionTriggered, this, &EditorView::actionTriggered);
     connect(m_mainContextMenu, &Menus::MainContextMenu::newNodeRequested, this, &EditorView::newNodeRequested);
+}
 
-    m_updateShadowEffectsOnZoomTimer.setInterval(250);
-    m_updateShadowEffectsOnZoomTimer.setSingleShot(true);
-    connect(&m_updateShadowEffectsOnZoomTimer, &QTimer::timeout, this, &EditorView::updateShadowEffectsBasedOnItemVisiblity);
+void EditorView::continueGesture()
+{
+    if (!m_gestureSnapshot.isValid()) {
+        // The batches are cheap enough to draw on every step of the gesture
+        if (!scene() || isBatchedRenderingActive() || static_cast<size_t>(scene()->items(mapToScene(viewport()->rect()).boundingRect()).size()) < Constants::View::gestureSnapshotThreshold()) {
+            return;
+        }
+        m_gestureSnapshot.capture(*this);
+    }
+
+    m_gestureSettleTimer.start();
+}
+
+void EditorView::finishGesture()
+{
+    m_gestureSettleTimer.stop();
+    m_gestureSnapshot.clear();
+    // The virtualization was deferred during the gesture
+    updateVisibleItems();
+    viewport()->update();
+}
+
+void EditorView::setMindMapData(MindMapDataS mindMapData)
+{
+    mindMapData->graph().setPlacementChangeCallback([this](const QRectF & sceneRect) {
+        m_minimap->addDirtyRect(sceneRect);
+    });
+    m_minimap->invalidate();
+    m_batchedGraphRenderer.setMindMapData(mindMapData);
+    m_edgeBundler.setMindMapData(mindMapData);
 }
 
 const Grid & EditorView::grid() const
@@ -224,11 +302,58 @@ void EditorView::initiateRubberBand()
     m_rubberBand->show();
 }
 
+bool EditorView::isBatchedRenderingActive() const
+{
+    if (!m_settingsProxy->batchedRendering() || LevelOfDetail::tier(m_scale) != LevelOfDetail::Tier::Minimal || m_dragTileCache.isActive()) {
+        return false;
+    }
+
+    if (const auto graph = currentGraph(); !graph || graph->nodeCount() < Constants::View::batchedRenderingThreshold()) {
+        return false;
+    }
+
+    return SC::instance().applicationService()->mouseAction().action() != MouseAction::Action::CreateOrConnectNode;
+}
+
 bool EditorView::isModifierPressed() const
 {
     return QGuiApplication::queryKeyboardModifiers().testFlag(Qt::ControlModifier) || QGuiApplication::queryKeyboardModifiers().testFlag(Qt::ShiftModifier);
 }
 
+void EditorView::keyPressEvent(QKeyEvent * event)
+{
+    if (scene() && !scene()->focusItem()) {
+        const bool alongEdge = event->modifiers() & Qt::AltModifier;
+        bool navigated = false;
+        switch (event->key()) {
+        case Qt::Key_Left:
+            navigated = !alongEdge && SC::instance().applicationService()->navigateToNearestNode({ -1, 0 });
+            break;
+        case Qt::Key_Right:
+            navigated = !alongEdge && SC::instance().applicationService()->navigateToNearestNode({ 1, 0 });
+            break;
+        case Qt::Key_Up:
+            navigated = alongEdge ? SC::instance().applicationService()->navigateAlongEdge(Graph::TraversalDirection::Ancestors)
+                                  : SC::instance().applicationService()->navigateToNearestNode({ 0, -1 });
+            break;
+        case Qt::Key_Down:
+            navigated = alongEdge ? SC::instance().applicationService()->navigateAlongEdge(Graph::TraversalDirection::Descendants)
+                                  : SC::instance().applicationService()->navigateToNearestNode({ 0, 1 });
+            break;
+        default:
+            break;
+        }
+
+        if (navigated) {
+            event->accept();
+            return;
+        }
+    }
+
+    // E.g. scroll the view with the arrow keys if nothing is selected
+    QGraphicsView::keyPressEvent(event);
+}
+
 void EditorView::mouseDoubleClickEvent(QMouseEvent * event)
 {
     const auto clickedScenePos = mapToScene(event->pos());
@@ -246,11 +371,32 @@ void EditorView::mouseMoveEvent(QMouseEvent * event)
 {
     updateMousePosition(*event);
 
+    // High polling rate mice deliver many more moves than there are frames, so
+    // only the latest position is handled once per frame and the others are dropped
+    if (m_mouseMoveTimer.isActive()) {
+        m_isMouseMovePending = true;
+    } else {
+        processMouseMove();
+        m_mouseMoveTimer.start();
+    }
+
+    QGraphicsView::mouseMoveEvent(event);
+}
+
+void EditorView::flushMouseMove()
+{
+    if (m_isMouseMovePending) {
+        processMouseMove();
+    }
+}
+
+void EditorView::processMouseMove()
+{
+    m_isMouseMovePending = false;
+
     hideHandlesOfLastHoveredNode();
 
     handleMouseMoveActions();
-
-    QGraphicsView::mouseMoveEvent(event);
 }
 
 void EditorView::updateMousePosition(QMouseEvent & event)
@@ -284,14 +430,26 @@ void EditorView::handleMouseMoveActions()
         updateRubberBand();
         break;
     case MouseAction::Action::Scroll:
-        removeShadowEffectsDuringDrag();
         break;
     }
 }
 
+void EditorView::beginDragTileCache(NodeR node)
+{
+    // The batches are cheaper to draw than the tiles, and the bundles of the moving nodes would be in the tiles
+    if (m_dragTileCache.isStarted() || isBatchedRenderingActive() || m_edgeBundler.hasBundles()) {
+        return;
+    }
+
+    const auto applicationService = SC::instance().applicationService();
+    const auto movingNodes = applicationService->nodeSelectionGroupSize() ? applicationService->selectedNodes() : std::vector<NodeP> { &node };
+    m_dragTileCache.begin(*this, movingNodes, Constants::View::dragTileCacheThreshold());
+}
+
 void EditorView::handleMoveNodeAction()
 {
     if (const auto node = SC::instance().applicationService()->mouseAction().sourceNode()) {
+        beginDragTileCache(*node);
         if (SC::instance().applicationService()->nodeSelectionGroupSize()) {
             SC::instance().applicationService()->moveSelectionGroup(*node, m_grid.snapToGrid(m_mousePositionOnScene - SC::instance().applicationService()->mouseAction().sourcePosOnNode()));
         } else {
@@ -323,6 +481,12 @@ void EditorView::handleCreateOrConnectNodeAction()
 
 void EditorView::mousePressEvent(QMouseEvent * event)
 {
+    if (m_gestureSnapshot.isValid()) {
+        finishGesture();
+    }
+
+    flushMouseMove();
+
     m_clickedPos = event->pos();
     const auto clickedScenePos = mapToScene(m_clickedPos);
     SC::instance().applicationService()->mouseAction().setClickedScenePos(clickedScenePos);
@@ -364,6 +528,9 @@ void EditorView::mousePressEvent(QMouseEvent * event)
 
 void EditorView::mouseReleaseEvent(QMouseEvent * event)
 {
+    // E.g. a dragged node ends up at the released position
+    flushMouseMove();
+
     if (event->button() == Qt::MiddleButton) {
         switch (SC::instance().applicationService()->mouseAction().action()) {
         case MouseAction::Action::RubberBand:
@@ -402,13 +569,14 @@ void EditorView::mouseReleaseEvent(QMouseEvent * event)
             break;
         case MouseAction::Action::Scroll:
             setDragMode(NoDrag);
-            updateShadowEffectsBasedOnItemVisiblity();
             break;
         }
 
         QApplication::restoreOverrideCursor();
     }
 
+    m_dragTileCache.end();
+
     SC::instance().applicationService()->mouseAction().clear();
 
     QGraphicsView::mouseReleaseEvent(event);
@@ -467,62 +635,122 @@ void EditorView::showDummyDragNode(bool show)
     m_dummyDragNode->setVisible(show);
 }
 
+void EditorView::restoreViewport(QRectF sceneRect, double scale)
+{
+    m_scale = std::clamp(scale, 0.02, 2.00);
+
+    updateScale();
+
+    // The items may not all be in the scene yet, so the scene must not clamp the center
+    scene()->setSceneRect(scene()->sceneRect().united(sceneRect));
+
+    centerOn(sceneRect.center());
+
+    prewarmScene();
+}
+
+double EditorView::scale() const
+{
+    return m_scale;
+}
+
 void EditorView::updateScale()
 {
+    // The tiles don't match the new transform
+    m_dragTileCache.end();
+
     QTransform transform;
     transform.scale(m_scale, m_scale);
     setTransform(transform);
 
-    m_updateShadowEffectsOnZoomTimer.stop();
-    m_updateShadowEffectsOnZoomTimer.start();
+    if (m_gestureSnapshot.isValid()) {
+        updateGestureSnapshot();
+    } else {
+        updateVisibleItems();
+    }
 }
 
-void EditorView::removeShadowEffectsDuringDrag()
+void EditorView::updateGestureSnapshot()
 {
-    if (SC::instance().settingsProxy()->optimizeShadowEffects()) {
+    m_minimap->setViewportRect(mapToScene(viewport()->rect()).boundingRect());
 
-        if (!m_shadowEffectsDuringDragRemoved) {
-            m_shadowEffectsDuringDragRemoved = true;
+    if (m_gestureSnapshot.coverage(*this) < Constants::View::gestureSnapshotMinCoverage()) {
+        // Bring the items of the new viewport to the scene first
+        updateVisibleItems();
+        m_gestureSnapshot.capture(*this);
+    }
+}
 
-            // Remove shadow effects from edges that are not completely visible while dragging.
-            // We can assume that the effects of off-screen items have already been removed in
-            // updateShadowEffectsBasedOnItemVisiblity().
-            const auto mappedViewRect = mapToScene(rect());
-            for (auto && item : scene()->items(mappedViewRect, Qt::IntersectsItemShape)) {
-                if (const auto edge = dynamic_cast<SceneItems::Edge *>(item); edge) {
-                    if (!mappedViewRect.boundingRect().contains(edge->sceneBoundingRect().toRect())) {
-                        edge->enableShadowEffect(false);
-                    }
-                }
-            }
+void EditorView::updateMinimapGeometry()
+{
+    const int margin = 8;
+    m_minimap->move(viewport()->geometry().bottomRight() - QPoint { m_minimap->width() + margin, m_minimap->height() + margin });
+    // A new viewport would otherwise cover it
+    m_minimap->raise();
+}
+
+void EditorView::paintEvent(QPaintEvent * event)
+{
+    {
+        const TraceRecorder::ScopedSpan span { "EditorView::paintEvent" };
+        const Profiler::ScopedTimer timer { Profiler::Section::View };
+        // Applied on the next event loop iteration, as the edges can't be rerouted while painting
+        m_edgeBundler.setEnabled(m_settingsProxy->edgeBundling());
+        if (m_gestureSnapshot.isValid()) {
+            QPainter painter { viewport() };
+            m_gestureSnapshot.draw(painter, *this);
+        } else if (isBatchedRenderingActive()) {
+            paintBatched(*event);
+        } else {
+            QGraphicsView::paintEvent(event);
         }
     }
+
+    Profiler::finishFrame();
 }
 
-void EditorView::updateShadowEffectsBasedOnItemVisiblity()
+void EditorView::paintBatched(const QPaintEvent & event)
 {
-    std::unordered_set<SceneItems::SceneItemBase *> enabledItems;
+    QPainter painter { viewport() };
+    painter.setRenderHints(renderHints());
+    painter.setTransform(viewportTransform());
+    const auto sceneRect = mapToScene(event.rect()).boundingRect();
+    drawBackground(&painter, sceneRect);
+    m_batchedGraphRenderer.draw(painter, sceneRect);
+    drawForeground(&painter, sceneRect);
+}
 
-    const int marginFraction = 20;
-    const int glitchMargin = rect().width() / marginFraction;
-    for (auto && item : scene()->items(mapToScene(rect().adjusted(-glitchMargin, -glitchMargin, glitchMargin, glitchMargin)))) {
-        if (const auto sceneItem = dynamic_cast<SceneItems::SceneItemBase *>(item); sceneItem) {
-            sceneItem->enableShadowEffect(true);
-            enabledItems.insert(sceneItem);
-        }
+void EditorView::resizeEvent(QResizeEvent * event)
+{
+    m_dragTileCache.end();
+
+    QGraphicsView::resizeEvent(event);
+
+    updateMinimapGeometry();
+
+    if (m_gestureSnapshot.isValid()) {
+        finishGesture();
+    } else {
+        updateVisibleItems();
     }
+}
 
-    if (SC::instance().settingsProxy()->optimizeShadowEffects()) {
-        for (auto && item : scene()->items()) {
-            if (const auto sceneItem = dynamic_cast<SceneItems::SceneItemBase *>(item); sceneItem) {
-                if (!enabledItems.count(sceneItem)) {
-                    sceneItem->enableShadowEffect(false);
-                }
-            }
-        }
+void EditorView::scrollContentsBy(int dx, int dy)
+{
+    m_dragTileCache.end();
+
+    QGraphicsView::scrollContentsBy(dx, dy);
+
+    if (const auto applicationService = SC::instance().applicationService(); applicationService && applicationService->mouseAction().action() == MouseAction::Action::Scroll) {
+        continueGesture();
     }
 
-    m_shadowEffectsDuringDragRemoved = false;
+    if (m_gestureSnapshot.isValid()) {
+        m_gestureSettleTimer.start();
+        updateGestureSnapshot();
+    } else {
+        updateVisibleItems();
+    }
 }
 
 void EditorView::updateRubberBand()
@@ -530,24 +758,22 @@ void EditorView::updateRubberBand()
     m_rubberBand->setGeometry(QRect(SC::instance().applicationService()->mouseAction().rubberBandOrigin().toPoint(), m_mousePositionOnView.toPoint()).normalized());
 }
 
-void EditorView::restoreZoom()
+void EditorView::updateVisibleItems()
 {
-    if (m_savedZoom.has_value()) {
-        juzzlin::L(TAG).debug() << "Restoring zoom";
-        scene()->setSceneRect(m_savedZoom->sceneRect);
-        m_scale = m_savedZoom->scale;
-        updateScale();
-        centerOn(m_savedZoom->viewCenter);
-        m_savedZoom.reset();
+    if (scene()) {
+        const Profiler::ScopedTimer timer { Profiler::Section::VisibleItems };
+        // Before tracking so that the items added back to the scene get notified as well
+        if (const auto applicationService = SC::instance().applicationService(); applicationService) {
+            applicationService->updateVirtualization(mapToScene(rect()).boundingRect());
+        }
+        // Some margin so that animations are already running when items scroll into view
+        const int marginFraction = 20;
+        const int margin = rect().width() / marginFraction;
+        m_visibleItemTracker.update(*scene(), mapToScene(rect().adjusted(-margin, -margin, margin, margin)).boundingRect());
+        m_minimap->setViewportRect(mapToScene(viewport()->rect()).boundingRect());
     }
 }
 
-void EditorView::saveZoom()
-{
-    juzzlin::L(TAG).debug() << "Saving zoom";
-    m_savedZoom = { scene()->sceneRect(), mapToScene(viewport()->rect().center()), m_scale };
-}
-
 void EditorView::setArrowSize(double arrowSize)
 {
     m_arrowSize = arrowSize;
@@ -581,6 +807,56 @@ void EditorView::setGridColor(const QColor & gridColor)
     SC::instance().applicationService()->mindMapData()->setGridColor(gridColor);
 }
 
+void EditorView::setHardwareAccelerationEnabled(bool enabled)
+{
+    if (m_hardwareAccelerationEnabled == enabled) {
+        return;
+    }
+
+    if (enabled) {
+#if QT_CONFIG(opengl)
+        if (QOpenGLContext context; !context.create()) {
+            juzzlin::L(TAG).warning() << "OpenGL is not available. Using software rendering.";
+            return;
+        }
+        const auto glViewport = new QOpenGLWidget;
+        auto format = glViewport->format();
+        format.setSamples(4); // Antialiasing is done by multisampling on OpenGL
+        glViewport->setFormat(format);
+        setViewport(glViewport);
+        // A GL viewport is redrawn as a whole anyway, so skip the costly dirty region bookkeeping
+        setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
+        juzzlin::L(TAG).info() << "Using OpenGL rendering";
+#else
+        juzzlin::L(TAG).warning() << "Built without OpenGL support. Using software rendering.";
+        return;
+#endif
+    } else {
+        setViewport(new QWidget);
+        setViewportUpdateMode(QGraphicsView::MinimalViewportUpdate);
+        juzzlin::L(TAG).info() << "Using software rendering";
+    }
+
+    m_hardwareAccelerationEnabled = enabled;
+
+    // Not created yet when called from the constructor
+    if (m_minimap) {
+        updateMinimapGeometry();
+    }
+}
+
+void EditorView::setShadowsEnabled(bool enabled)
+{
+    if (m_shadowsEnabled != enabled) {
+        m_shadowsEnabled = enabled;
+        // The cached tiles contain the shadows
+        m_dragTileCache.end();
+        if (scene()) {
+            scene()->update();
+        }
+    }
+}
+
 void EditorView::setGridVisible(bool visible)
 {
     m_gridVisible = visible;
@@ -607,6 +883,19 @@ void EditorView::dropEvent(QDropEvent * event)
     if (urls.isEmpty()) {
         return;
     }
+
+    // Image files get attached to nodes, anything else is opened as a mind map
+    QStringList imageFileNames;
+    for (auto && url : urls) {
+        if (const auto fileName = url.toLocalFile(); !fileName.isEmpty() && (!QImageReader::imageFormat(fileName).isEmpty() || Image::isVectorFileName(fileName))) {
+            imageFileNames << fileName;
+        }
+    }
+    if (!imageFileNames.isEmpty()) {
+        SC::instance().applicationService()->attachDroppedImages(imageFileNames, mapToScene(event->pos()));
+        return;
+    }
+
     if (const auto fileName = urls.first().toLocalFile(); !fileName.isEmpty()) {
         m_dropFile = fileName;
         emit actionTriggered(StateMachine::Action::DropFileSelected);
@@ -629,15 +918,23 @@ void EditorView::zoom(double amount)
     juzzlin::L(TAG).debug() << "View rectangle width: " << rect().width();
     const auto testScale = amount * amount;
     if (amount > 1.0 || (mappedSceneRect.width() * testScale > rect().width() && mappedSceneRect.height() * testScale > rect().height())) {
+        // The snapshot must be captured at the transform before the zoom
+        continueGesture();
         m_scale *= amount;
         m_scale = std::min(m_scale, 2.00);
         m_scale = std::max(m_scale, 0.02);
         updateScale();
+        prewarmScene();
     } else {
         juzzlin::L(TAG).debug() << "Zoom end";
     }
 }
 
+QRectF EditorView::visibleSceneRect() const
+{
+    return mapToScene(viewport()->rect()).boundingRect();
+}
+
 void EditorView::zoomToFit(QRectF nodeBoundingRect)
 {
     const double nodeAspect = nodeBoundingRect.height() / nodeBoundingRect.width();
@@ -660,6 +957,15 @@ void EditorView::zoomToFit(QRectF nodeBoundingRect)
     centerOn(nodeBoundingRect.center());
 
     m_nodeBoundingRect = nodeBoundingRect;
+
+    prewarmScene();
+}
+
+void EditorView::prewarmScene()
+{
+    // Same as the pixel scale of the painters of the view, which have the transform of the view
+    const auto pixelScale = LevelOfDetail::pixelScale(m_scale * viewport()->devicePixelRatioF());
+    m_scenePrewarmer.start(visibleSceneRect(), pixelScale, m_shadowsEnabled ? std::optional { m_settingsProxy->snapshot()->shadowEffect } : std::nullopt);
 }
 
 QString EditorView::dropFile() const
@@ -669,12 +975,48 @@ QString EditorView::dropFile() const
 
 void EditorView::drawBackground(QPainter * painter, const QRectF & sceneRect)
 {
+    const Profiler::ScopedTimer timer { Profiler::Section::Background };
     painter->save();
-    painter->fillRect(sceneRect, backgroundBrush());
-    drawGrid(*painter, sceneRect);
+    if (m_dragTileCache.isActive()) {
+        // The tiles already contain the background and the static items with their shadows
+        m_dragTileCache.draw(*painter, sceneRect);
+    } else {
+        painter->fillRect(sceneRect, backgroundBrush());
+        drawGrid(*painter, sceneRect);
+    }
+    if (m_shadowsEnabled) {
+        ShadowRenderer::drawShadows(*painter, sceneRect, *scene(), m_settingsProxy->snapshot()->shadowEffect);
+    }
+    // Below the items like the lines of the edges, but the batches and the tiles already contain them
+    if (!m_dragTileCache.isActive() && !isBatchedRenderingActive()) {
+        m_edgeBundler.draw(*painter, sceneRect);
+    }
     painter->restore();
 }
 
+void EditorView::drawForeground(QPainter * painter, const QRectF & sceneRect)
+{
+    QGraphicsView::drawForeground(painter, sceneRect);
+
+    if (Profiler::enabled() && !m_dragTileCache.isRendering() && !m_gestureSnapshot.isCapturing()) {
+        // The stats are of the previous frame as this frame is still being painted
+        const auto stats = Profiler::lastFrame();
+        const auto text = QString { "%1 fps, paint %2 ms, %3 items, %4 shadows" }
+                            .arg(stats.fps, 0, 'f', 1)
+                            .arg(stats.paintMilliseconds, 0, 'f', 2)
+                            .arg(stats.itemsPainted)
+                            .arg(stats.shadowsDrawn);
+        painter->save();
+        painter->resetTransform();
+        const int margin = 8;
+        const QRect textRect { margin, margin, painter->fontMetrics().boundingRect(text).width() + margin, painter->fontMetrics().height() + margin };
+        painter->fillRect(textRect, QColor { 0, 0, 0, 160 });
+        painter->setPen(Qt::white);
+        painter->drawText(textRect, Qt::AlignCenter, text);
+        painter->restore();
+    }
+}
+
 void EditorView::drawGrid(QPainter & painter, const QRectF & sceneRect)
 {
     // Draw grid only if we have enough details visible versus the grid size. Otherwise fake it with a colored rectangle.
@@ -683,10 +1025,7 @@ void EditorView::drawGrid(QPainter & painter, const QRectF & sceneRect)
     if (m_gridVisible && m_grid.size()) {
         const int virtualLineWidth = 5;
         if (const auto detailRect = mapFromScene(QRectF { 0, 0, static_cast<double>(m_grid.size()), 1 }).boundingRect(); detailRect.width() > virtualLineWidth) {
-            if (auto && lines = m_grid.calculateLines(sceneRect); !lines.empty()) {
-                painter.setPen(SC::instance().applicationService()->mindMapData()->gridColor());
-                painter.drawLines(m_grid.calculateLines(sceneRect).data(), static_cast<int>(lines.size()));
-            }
+            painter.fillRect(sceneRect, gridBrush(SC::instance().applicationService()->mindMapData()->gridColor()));
         } else {
             const double balance = static_cast<double>(detailRect.width()) / virtualLineWidth;
             painter.fillRect(sceneRect, Utils::mixedColor(backgroundBrush().color(), SC::instance().applicationService()->mindMapData()->gridColor(), balance));
@@ -694,4 +1033,30 @@ void EditorView::drawGrid(QPainter & painter, const QRectF & sceneRect)
     }
 }
 
+const QBrush & EditorView::gridBrush(const QColor & gridColor)
+{
+    if (const GridBrushKey key { m_grid.size(), m_scale, gridColor }; !(key == m_gridBrushKey)) {
+        // The tile is rendered in view pixels and the brush transform maps it exactly onto one grid cell,
+        // so the lines stay sharp and the tiling doesn't drift from the grid.
+        const auto tileSize = std::max(1, static_cast<int>(std::ceil(m_grid.size() * m_scale)));
+        QPixmap tile { tileSize, tileSize };
+        tile.fill(Qt::transparent);
+        QPainter tilePainter { &tile };
+        const auto lineWidth = std::max(1, qRound(m_scale));
+        const auto lineStart = (tileSize - lineWidth) / 2;
+        tilePainter.fillRect(lineStart, 0, lineWidth, tileSize, gridColor);
+        tilePainter.fillRect(0, lineStart, tileSize, lineWidth, gridColor);
+        tilePainter.end();
+
+        // Center the tile on the grid points
+        const auto halfCell = static_cast<double>(m_grid.size()) / 2;
+        const auto tileScale = static_cast<double>(m_grid.size()) / tileSize;
+        m_gridBrush = QBrush { tile };
+        m_gridBrush.setTransform(QTransform {}.translate(-halfCell, -halfCell).scale(tileScale, tileScale));
+        m_gridBrushKey = key;
+    }
+
+    return m_gridBrush;
+}
+
 EditorView::~EditorView() = default;
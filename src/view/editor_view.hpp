@@ -19,21 +19,28 @@
 #include "../application/state_machine.hpp"
 #include "../common/constants.hpp"
 #include "../common/types.hpp"
+#include "batched_graph_renderer.hpp"
+#include "edge_bundler.hpp"
+#include "drag_tile_cache.hpp"
+#include "gesture_snapshot.hpp"
 #include "grid.hpp"
 #include "menus/main_context_menu.hpp"
+#include "scene_prewarmer.hpp"
+#include "visible_item_tracker.hpp"
 
+#include <QBrush>
 #include <QColor>
 #include <QGraphicsView>
 #include <QMenu>
 #include <QTimer>
 
-#include <optional>
-
 class ControlStrategy;
+class Graph;
 class MindMapTile;
 class Object;
 class ObjectModelLoaderoader;
 class QAction;
+class QKeyEvent;
 class QMouseEvent;
 class QPaintEvent;
 class QWheelEvent;
@@ -50,6 +57,10 @@ class Node;
 class NodeHandle;
 } // namespace SceneItems
 
+namespace Widgets {
+class Minimap;
+}
+
 class EditorView : public QGraphicsView
 {
     Q_OBJECT
@@ -63,14 +74,21 @@ public:
 
     void resetDummyDragItems();
 
-    void restoreZoom();
+    //! Restores a viewport saved with visibleSceneRect() and scale(), e.g. when a mind map is reopened.
+    void restoreViewport(QRectF sceneRect, double scale);
 
-    void saveZoom();
+    double scale() const;
+
+    //! Makes the minimap and the batched rendering follow the changes of the graph of the given new mind map.
+    void setMindMapData(MindMapDataS mindMapData);
 
     void showStatusText(QString statusText);
 
     void zoom(double amount);
 
+    //! \returns The part of the scene that is currently shown.
+    QRectF visibleSceneRect() const;
+
     void zoomToFit(QRectF nodeBoundingRect);
 
     QString dropFile() const;
@@ -90,7 +108,16 @@ public slots:
 
     void setGridVisible(bool visible);
 
+    //! Switches the viewport between OpenGL and raster rendering. Stays on raster if OpenGL is not available.
+    void setHardwareAccelerationEnabled(bool enabled);
+
+    //! Enables or disables the drop shadows without changing the shadow settings, see PerformanceProfile.
+    void setShadowsEnabled(bool enabled);
+
 protected:
+    //! Moves the selection between the nodes with the arrow keys unless a text is being edited.
+    void keyPressEvent(QKeyEvent * event) override;
+
     void mouseDoubleClickEvent(QMouseEvent * event) override;
 
     void mouseMoveEvent(QMouseEvent * event) override;
@@ -99,6 +126,12 @@ protected:
 
     void mouseReleaseEvent(QMouseEvent * event) override;
 
+    void paintEvent(QPaintEvent * event) override;
+
+    void resizeEvent(QResizeEvent * event) override;
+
+    void scrollContentsBy(int dx, int dy) override;
+
     void wheelEvent(QWheelEvent * event) override;
 
     void dropEvent(QDropEvent * event) override;
@@ -113,14 +146,32 @@ signals:
 private:
     void drawGrid(QPainter & painter, const QRectF & sceneRect);
 
+    //! \return Brush that tiles one grid cell pre-rendered at the current zoom level. Re-rendered only if the grid size, zoom or color changes.
+    const QBrush & gridBrush(const QColor & gridColor);
+
     void finishRubberBand();
 
+    //! Starts or continues a gesture if the view is dense enough, i.e. paints a transformed snapshot
+    //! of the view until the zoom or pan input settles.
+    void continueGesture();
+
+    //! Repaints the view at full quality.
+    void finishGesture();
+
     void handleCreateOrConnectNodeAction();
 
     void handleMoveNodeAction();
 
+    //! Starts to draw the nodes and edges that don't move from cached tiles if the view is dense enough.
+    void beginDragTileCache(NodeR node);
+
     void handleMouseMoveActions();
 
+    //! Handles the latest mouse position now if a move is still waiting for the next frame, e.g. before a release.
+    void flushMouseMove();
+
+    void processMouseMove();
+
     void hideHandlesOfLastHoveredNode();
 
     void updateMousePosition(QMouseEvent & event);
@@ -146,6 +197,11 @@ private:
 
     void initiateRubberBand();
 
+    //! \returns true if the mind map is large enough and zoomed out so far that it's drawn by the batched renderer
+    //! instead of item by item, see SettingsProxy::batchedRendering(). The items being dragged or connected are
+    //! only drawn by the scene.
+    bool isBatchedRenderingActive() const;
+
     bool isModifierPressed() const;
 
     void openBackgroundContextMenu();
@@ -154,20 +210,33 @@ private:
 
     void openMainContextMenu(Menus::MainContextMenu::Mode mode);
 
-    void removeShadowEffectsDuringDrag();
+    //! Paints the background, the batches and the foreground without walking the scene items.
+    void paintBatched(const QPaintEvent & event);
+
+    //! Fills the caches of the items around the viewport while idle, so that the next pans and zooms don't fill them while painting.
+    void prewarmScene();
 
     void showDummyDragEdge(bool show);
 
     void showDummyDragNode(bool show);
 
-    void updateScale();
+    //! Captures the snapshot again if the view has moved too far from it.
+    void updateGestureSnapshot();
 
-    void updateShadowEffectsBasedOnItemVisiblity();
+    //! Keeps the minimap in the bottom right corner above the viewport.
+    void updateMinimapGeometry();
+
+    void updateScale();
 
     void updateRubberBand();
 
+    void updateVisibleItems();
+
     void drawBackground(QPainter * painter, const QRectF & rect) override;
 
+    //! Draws the profiling overlay when profiling is enabled.
+    void drawForeground(QPainter * painter, const QRectF & rect) override;
+
     Grid m_grid;
 
     QPoint m_clickedPos;
@@ -186,6 +255,11 @@ private:
 
     QPointF m_mousePositionOnScene;
 
+    //! Limits the handled mouse moves to about one per frame, see mouseMoveEvent().
+    QTimer m_mouseMoveTimer;
+
+    bool m_isMouseMovePending = false;
+
     double m_scale = 1.0;
 
     NodeU m_dummyDragNode;
@@ -214,24 +288,50 @@ private:
 
     bool m_gridVisible = false;
 
-    bool m_shadowEffectsDuringDragRemoved = false;
+    bool m_hardwareAccelerationEnabled = false;
 
-    QString m_dropFile {};
+    bool m_shadowsEnabled = true;
+
+    QBrush m_gridBrush;
 
-    struct ZoomParameters
+    struct GridBrushKey
     {
-        QRectF sceneRect;
+        int size = 0;
 
-        QPointF viewCenter;
+        double scale = 0;
 
-        double scale = 1.0;
+        QColor color;
+
+        bool operator==(const GridBrushKey & other) const
+        {
+            return size == other.size && scale == other.scale && color == other.color;
+        }
     };
 
-    std::optional<ZoomParameters> m_savedZoom;
+    GridBrushKey m_gridBrushKey;
+
+    QString m_dropFile {};
 
     ControlStrategyS m_controlStrategy;
 
-    QTimer m_updateShadowEffectsOnZoomTimer;
+    SettingsProxyS m_settingsProxy;
+
+    VisibleItemTracker m_visibleItemTracker;
+
+    DragTileCache m_dragTileCache;
+
+    GestureSnapshot m_gestureSnapshot;
+
+    BatchedGraphRenderer m_batchedGraphRenderer;
+
+    EdgeBundler m_edgeBundler;
+
+    Widgets::Minimap * m_minimap = nullptr;
+
+    //! Restarted on every zoom or pan input of a gesture.
+    QTimer m_gestureSettleTimer;
+
+    ScenePrewarmer m_scenePrewarmer;
 
     const int m_clickTolerance = 5;
 };
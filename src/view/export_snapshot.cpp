@@ -0,0 +1,115 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "export_snapshot.hpp"
+
+#include "../domain/graph.hpp"
+#include "../domain/image_manager.hpp"
+#include "grid.hpp"
+#include "scene_items/edge.hpp"
+#include "scene_items/node.hpp"
+
+ExportSnapshot::ExportSnapshot(const MindMapData & mindMapData, const Grid * grid)
+  : m_mindMapData(mindMapData)
+  , m_scene(std::make_unique<EditorScene>())
+{
+    addGraph();
+
+    m_scene->setSceneRect(m_scene->calculateZoomToFitRectangle(true));
+
+    if (grid) {
+        addGrid(*grid);
+    }
+}
+
+ExportSnapshot::ExportSnapshot(const MindMapData & mindMapData, GraphSnapshot graphSnapshot, QRectF region, const Grid * grid)
+  : m_mindMapData(mindMapData, std::move(graphSnapshot))
+  , m_scene(std::make_unique<EditorScene>())
+{
+    addGraph();
+
+    m_scene->setSceneRect(region);
+
+    if (grid) {
+        addGrid(*grid);
+    }
+}
+
+ExportSnapshot::~ExportSnapshot() = default;
+
+void ExportSnapshot::addGraph()
+{
+    // The nodes request their images when they are added to the scene
+    m_scene->setImageHandler([this](size_t imageRef, NodeR node) {
+        m_mindMapData.imageManager().handleImageRequest(imageRef, node);
+    });
+
+    m_scene->beginBulkInsert();
+
+    auto && graph = m_mindMapData.graph();
+    for (auto && node : graph.nodes()) {
+        m_scene->addItem(node.get());
+    }
+
+    for (auto && edge : graph.edges()) {
+        m_scene->addItem(edge.get());
+        edge->setArrowSize(m_mindMapData.arrowSize());
+        edge->setColor(m_mindMapData.edgeColor());
+        edge->setEdgeWidth(m_mindMapData.edgeWidth());
+        edge->setTextSize(m_mindMapData.textSize());
+        edge->changeFont(m_mindMapData.font());
+        edge->sourceNode().addGraphicsEdge(*edge);
+        edge->targetNode().addGraphicsEdge(*edge);
+        // Not shown in any view, which also keeps the edge dots from animating into the export
+        edge->setInViewport(false);
+        edge->updateLine();
+    }
+
+    m_scene->endBulkInsert();
+}
+
+void ExportSnapshot::addGrid(const Grid & grid)
+{
+    for (auto && line : grid.calculateLines(m_scene->sceneRect())) {
+        auto item = std::make_unique<QGraphicsLineItem>(line);
+        item->setPen(m_mindMapData.gridColor());
+        m_scene->addItem(item.get());
+        m_gridLines.push_back(std::move(item));
+    }
+}
+
+QColor ExportSnapshot::backgroundColor() const
+{
+    return m_mindMapData.backgroundColor();
+}
+
+std::vector<QLineF> ExportSnapshot::gridLines() const
+{
+    std::vector<QLineF> lines;
+    for (auto && item : m_gridLines) {
+        lines.push_back(item->line());
+    }
+    return lines;
+}
+
+const MindMapData & ExportSnapshot::mindMapData() const
+{
+    return m_mindMapData;
+}
+
+EditorScene & ExportSnapshot::scene()
+{
+    return *m_scene;
+}
@@ -0,0 +1,74 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef EXPORT_SNAPSHOT_HPP
+#define EXPORT_SNAPSHOT_HPP
+
+#include <QGraphicsLineItem>
+
+#include <memory>
+#include <vector>
+
+#include "../domain/graph_snapshot.hpp"
+#include "../domain/mind_map_data.hpp"
+#include "editor_scene.hpp"
+
+class Grid;
+
+//! Detached copy of a mind map in a scene of its own. Exports render the copy so that the live
+//! editor scene doesn't need to be zoomed, unselected or decorated with grid lines for it, and
+//! later edits don't affect an export that is still running.
+class ExportSnapshot
+{
+public:
+    //! \param grid Grid to add as line items, or nullptr if the grid is not exported.
+    ExportSnapshot(const MindMapData & mindMapData, const Grid * grid);
+
+    //! Exports only the given part of the graph, e.g. GraphSnapshot of the items in the region,
+    //! so that the cost depends on the size of the region instead of the size of the mind map.
+    //! \param region The exported area in scene coordinates.
+    ExportSnapshot(const MindMapData & mindMapData, GraphSnapshot graphSnapshot, QRectF region, const Grid * grid);
+
+    ~ExportSnapshot();
+
+    ExportSnapshot(const ExportSnapshot & other) = delete;
+
+    ExportSnapshot & operator=(const ExportSnapshot & other) = delete;
+
+    QColor backgroundColor() const;
+
+    //! \return The lines of the exported grid, if any.
+    std::vector<QLineF> gridLines() const;
+
+    //! \return The copied mind map whose nodes and edges are in the scene.
+    const MindMapData & mindMapData() const;
+
+    //! \return The scene whose scene rect covers exactly the exported area.
+    EditorScene & scene();
+
+private:
+    void addGraph();
+
+    void addGrid(const Grid & grid);
+
+    // The scene needs to be destroyed first as it only removes the items of the graph
+    MindMapData m_mindMapData;
+
+    std::unique_ptr<EditorScene> m_scene;
+
+    std::vector<std::unique_ptr<QGraphicsLineItem>> m_gridLines;
+};
+
+#endif // EXPORT_SNAPSHOT_HPP
@@ -0,0 +1,70 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "gesture_snapshot.hpp"
+
+#include <QGraphicsView>
+#include <QPainter>
+
+void GestureSnapshot::capture(QGraphicsView & view)
+{
+    const auto viewportRect = view.viewport()->rect();
+    m_sceneRect = view.mapToScene(viewportRect).boundingRect();
+
+    const auto devicePixelRatio = view.viewport()->devicePixelRatioF();
+    m_pixmap = QPixmap { viewportRect.size() * devicePixelRatio };
+    m_pixmap.setDevicePixelRatio(devicePixelRatio);
+
+    m_isCapturing = true;
+    QPainter painter { &m_pixmap };
+    painter.setRenderHints(view.renderHints());
+    view.render(&painter, QRectF { QPointF {}, QSizeF { viewportRect.size() } }, viewportRect);
+    painter.end();
+    m_isCapturing = false;
+}
+
+void GestureSnapshot::clear()
+{
+    m_pixmap = {};
+    m_sceneRect = {};
+}
+
+bool GestureSnapshot::isValid() const
+{
+    return !m_pixmap.isNull();
+}
+
+bool GestureSnapshot::isCapturing() const
+{
+    return m_isCapturing;
+}
+
+double GestureSnapshot::coverage(const QGraphicsView & view) const
+{
+    const auto viewportRect = QRectF { view.viewport()->rect() };
+    if (!isValid() || viewportRect.isEmpty()) {
+        return 0;
+    }
+
+    const auto covered = view.viewportTransform().mapRect(m_sceneRect).intersected(viewportRect);
+    return covered.width() * covered.height() / (viewportRect.width() * viewportRect.height());
+}
+
+void GestureSnapshot::draw(QPainter & painter, const QGraphicsView & view) const
+{
+    painter.fillRect(view.viewport()->rect(), view.backgroundBrush());
+    // Smooth scaling would cost about as much as the repaint that is being avoided
+    painter.drawPixmap(view.viewportTransform().mapRect(m_sceneRect), m_pixmap, QRectF { m_pixmap.rect() });
+}
@@ -0,0 +1,56 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef GESTURE_SNAPSHOT_HPP
+#define GESTURE_SNAPSHOT_HPP
+
+#include <QPixmap>
+#include <QRectF>
+
+class QGraphicsView;
+class QPainter;
+
+//! A snapshot of the viewport that is scaled and moved with the view during a continuous zoom or pan,
+//! so that the feedback is immediate even if repainting the scene takes longer than a frame.
+//! The view is repainted at full quality once the input settles.
+class GestureSnapshot
+{
+public:
+    //! Renders the viewport of the view at its current transform.
+    void capture(QGraphicsView & view);
+
+    void clear();
+
+    //! \return true if a snapshot has been captured since the last clear().
+    bool isValid() const;
+
+    //! \return true while the view is being rendered into the snapshot.
+    bool isCapturing() const;
+
+    //! \return The fraction of the viewport of the view that the snapshot covers at its current transform.
+    double coverage(const QGraphicsView & view) const;
+
+    //! Fills the viewport with the background and draws the snapshot transformed to the current view transform.
+    void draw(QPainter & painter, const QGraphicsView & view) const;
+
+private:
+    QPixmap m_pixmap;
+
+    QRectF m_sceneRect;
+
+    bool m_isCapturing = false;
+};
+
+#endif // GESTURE_SNAPSHOT_HPP
@@ -19,8 +19,10 @@
 #include "scene_items/edge_text_edit.hpp"
 #include "scene_items/node.hpp"
 #include "scene_items/node_handle.hpp"
+#include "scene_items/node_hover_overlay.hpp"
 
 #include <QGraphicsScene>
+#include <QPainterPath>
 
 namespace ItemFilter {
 
@@ -30,17 +32,40 @@ ItemAtPosition getFirstItemAtPosition(QGraphicsScene & scene, QPointF scenePos,
 
     const QRectF clickRect(scenePos.x() - tolerance, scenePos.y() - tolerance, tolerance * 2, tolerance * 2);
 
-    if (const auto itemsAtPosition = scene.items(clickRect, Qt::IntersectsItemShape, Qt::DescendingOrder); !itemsAtPosition.empty()) {
-        const auto firstItem = *itemsAtPosition.begin();
-        if (const auto edge = dynamic_cast<EdgeP>(firstItem); edge) {
-            itemAtPosition.itemOptional = edge;
-        } else if (const auto nodeHandle = dynamic_cast<SceneItems::NodeHandle *>(firstItem); nodeHandle) {
-            itemAtPosition.itemOptional = nodeHandle;
-        } else if (const auto node = dynamic_cast<NodeP>(firstItem); node) {
-            itemAtPosition.itemOptional = node;
-        } else if (const auto edgeTextEdit = dynamic_cast<SceneItems::EdgeTextEdit *>(firstItem); edgeTextEdit) {
-            itemAtPosition.itemOptional = edgeTextEdit;
+    // The bounding rects come from the scene index, so the exact shapes are only tested from the topmost
+    // candidate down until one of them is hit instead of for every item near the position
+    QPainterPath clickPath;
+    clickPath.addRect(clickRect);
+    for (auto && item : scene.items(clickRect, Qt::IntersectsItemBoundingRect, Qt::DescendingOrder)) {
+        if (!item->collidesWithPath(item->mapFromScene(clickPath), Qt::IntersectsItemShape)) {
+            continue;
         }
+
+        // Only the topmost hit counts, even if it's e.g. an edge line or a dot
+        switch (item->type()) {
+        case SceneItems::Edge::Type:
+            itemAtPosition.itemOptional = static_cast<EdgeP>(item);
+            break;
+        case SceneItems::EdgeTextEdit::Type:
+            itemAtPosition.itemOptional = static_cast<SceneItems::EdgeTextEdit *>(item);
+            break;
+        case SceneItems::Node::Type:
+            itemAtPosition.itemOptional = static_cast<NodeP>(item);
+            break;
+        case SceneItems::NodeHandle::Type:
+            itemAtPosition.itemOptional = static_cast<SceneItems::NodeHandle *>(item);
+            break;
+        case SceneItems::NodeHoverOverlay::Type:
+            // The raised node is under its copy
+            if (const auto node = static_cast<SceneItems::NodeHoverOverlay *>(item)->node()) {
+                itemAtPosition.itemOptional = node;
+            }
+            break;
+        default:
+            break;
+        }
+
+        return itemAtPosition;
     }
 
     return itemAtPosition;
@@ -0,0 +1,127 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "layout_transition.hpp"
+
+#include "editor_scene.hpp"
+#include "scene_items/edge_update_batch.hpp"
+#include "scene_items/node.hpp"
+
+#include "simple_logger.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static const auto TAG = "LayoutTransition";
+
+LayoutTransition::LayoutTransition(std::chrono::milliseconds duration, std::chrono::milliseconds tickInterval)
+  : m_duration(duration)
+{
+    m_timer.setInterval(static_cast<int>(tickInterval.count()));
+    connect(&m_timer, &QTimer::timeout, this, &LayoutTransition::tick);
+}
+
+LayoutTransition::~LayoutTransition()
+{
+    finish();
+}
+
+void LayoutTransition::start(EditorScene & scene, const std::vector<NodeS> & nodes, const std::vector<QPointF> & startLocations)
+{
+    finish();
+
+    // Only the nodes that actually move take part
+    for (size_t i = 0; i < nodes.size() && i < startLocations.size(); i++) {
+        if (auto && node = nodes.at(i); node->location() != startLocations.at(i)) {
+            m_nodes.push_back(node);
+            m_startLocations.push_back(startLocations.at(i));
+            m_endLocations.push_back(node->location());
+        }
+    }
+
+    if (m_nodes.empty() || m_duration.count() <= 0) {
+        m_nodes.clear();
+        m_startLocations.clear();
+        m_endLocations.clear();
+        return;
+    }
+
+    juzzlin::L(TAG).debug() << "Moving " << m_nodes.size() << " nodes";
+
+    m_scene = &scene;
+    m_scene->beginBulkMove();
+
+    // Nothing has been painted at the end locations yet
+    applyLocations(0);
+
+    m_elapsed.start();
+    m_timer.start();
+}
+
+void LayoutTransition::finish()
+{
+    if (m_nodes.empty()) {
+        return;
+    }
+
+    m_timer.stop();
+
+    applyLocations(1);
+
+    m_nodes.clear();
+    m_startLocations.clear();
+    m_endLocations.clear();
+
+    // Rebuilds the index of the scene once with the end locations
+    if (m_scene) {
+        m_scene->endBulkMove();
+    }
+    m_scene.clear();
+
+    emit finished();
+}
+
+bool LayoutTransition::isActive() const
+{
+    return !m_nodes.empty();
+}
+
+double LayoutTransition::ease(double progress)
+{
+    // Cubic ease-in-out
+    progress = std::clamp(progress, 0.0, 1.0);
+    return progress < 0.5 ? 4 * progress * progress * progress : 1 - std::pow(-2 * progress + 2, 3) / 2;
+}
+
+void LayoutTransition::tick()
+{
+    if (const auto progress = static_cast<double>(m_elapsed.elapsed()) / static_cast<double>(m_duration.count()); progress < 1) {
+        applyLocations(ease(progress));
+    } else {
+        finish();
+    }
+}
+
+void LayoutTransition::applyLocations(double progress)
+{
+    // Edges between moved nodes get updated only once
+    const SceneItems::EdgeUpdateBatch edgeUpdateBatch;
+    for (size_t i = 0; i < m_nodes.size(); i++) {
+        if (const auto node = m_nodes[i].lock()) {
+            // Exactly at the end, as the interpolation may be off by a rounding error
+            node->setLocation(progress < 1 ? m_startLocations[i] + (m_endLocations[i] - m_startLocations[i]) * progress : m_endLocations[i]);
+        }
+    }
+}
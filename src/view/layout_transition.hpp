@@ -0,0 +1,82 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LAYOUT_TRANSITION_HPP
+#define LAYOUT_TRANSITION_HPP
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointF>
+#include <QPointer>
+#include <QTimer>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "../common/types.hpp"
+
+class EditorScene;
+
+//! Moves nodes smoothly to the locations of an applied layout instead of letting them jump. A single timer drives
+//! all the nodes instead of one QPropertyAnimation per node: each tick interpolates the locations of all the moving
+//! nodes from contiguous arrays of start and end locations and applies them at once with the edge updates coalesced.
+//! The scene index is switched off during the transition and rebuilt only once at the end.
+class LayoutTransition : public QObject
+{
+    Q_OBJECT
+
+public:
+    LayoutTransition(std::chrono::milliseconds duration, std::chrono::milliseconds tickInterval);
+
+    ~LayoutTransition() override;
+
+    //! Moves the given nodes from the given start locations to their current locations, which are kept as the end
+    //! locations. The nodes are put back to the start locations right away. A running transition is finished first.
+    void start(EditorScene & scene, const std::vector<NodeS> & nodes, const std::vector<QPointF> & startLocations);
+
+    //! Moves the nodes to their end locations at once. Does nothing if no transition is running.
+    void finish();
+
+    bool isActive() const;
+
+    //! \returns The eased progress of the given linear progress, both between 0 and 1.
+    static double ease(double progress);
+
+signals:
+    void finished();
+
+private:
+    void tick();
+
+    void applyLocations(double progress);
+
+    std::chrono::milliseconds m_duration;
+
+    QTimer m_timer;
+
+    QElapsedTimer m_elapsed;
+
+    QPointer<EditorScene> m_scene;
+
+    //! The nodes may get deleted during the transition.
+    std::vector<std::weak_ptr<SceneItems::Node>> m_nodes;
+
+    std::vector<QPointF> m_startLocations;
+
+    std::vector<QPointF> m_endLocations;
+};
+
+#endif // LAYOUT_TRANSITION_HPP
@@ -16,6 +16,7 @@
 #include "magic_zoom.hpp"
 
 #include "../common/types.hpp"
+#include "../domain/node_placement_stats.hpp"
 
 #include "scene_items/node.hpp"
 
@@ -24,7 +25,7 @@
 QRectF MagicZoom::calculateRectangleByItems(const ItemList & items, bool isForExport)
 {
     NodeList nodes;
-    std::transform(items.begin(), items.end(), std::back_inserter(nodes), [](const auto & item) { return dynamic_cast<NodeP>(item); });
+    std::transform(items.begin(), items.end(), std::back_inserter(nodes), [](const auto & item) { return qgraphicsitem_cast<NodeP>(item); });
     nodes.erase(std::remove(nodes.begin(), nodes.end(), nullptr), nodes.end());
     return calculateRectangleByNodes(nodes, isForExport);
 }
@@ -63,6 +64,16 @@ QRectF MagicZoom::calculateRectangleByEdges(const EdgeList & edges)
     return calculateZoomRectBasedOnItemDensity(unitedRect, avgEdgeArea, totalArea);
 }
 
+static QRectF calculateRectangleByNodeBounds(QRectF unitedRect, double averageNodeArea, double totalArea, bool isForExport)
+{
+    if (isForExport) {
+        const int exportMargin = 60;
+        return unitedRect.adjusted(-exportMargin, -exportMargin, exportMargin, exportMargin);
+    }
+
+    return calculateZoomRectBasedOnItemDensity(unitedRect, averageNodeArea, totalArea);
+}
+
 QRectF MagicZoom::calculateRectangleByNodes(const NodeList & nodes, bool isForExport)
 {
     if (nodes.empty()) {
@@ -81,10 +92,14 @@ QRectF MagicZoom::calculateRectangleByNodes(const NodeList & nodes, bool isForEx
     }
     avgNodeArea /= static_cast<double>(nodes.size());
 
-    if (isForExport) {
-        const int exportMargin = 60;
-        return unitedRect.adjusted(-exportMargin, -exportMargin, exportMargin, exportMargin);
+    return calculateRectangleByNodeBounds(unitedRect, avgNodeArea, totalArea, isForExport);
+}
+
+QRectF MagicZoom::calculateRectangleByNodePlacementStats(const NodePlacementStats & stats, bool isForExport)
+{
+    if (!stats.size()) {
+        return {};
     }
 
-    return calculateZoomRectBasedOnItemDensity(unitedRect, avgNodeArea, totalArea);
+    return calculateRectangleByNodeBounds(stats.boundingRect(), stats.totalArea() / static_cast<double>(stats.size()), stats.totalArea(), isForExport);
 }
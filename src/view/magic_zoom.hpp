@@ -23,6 +23,7 @@
 
 #include "../common/types.hpp"
 
+class NodePlacementStats;
 class QGraphicsItem;
 
 namespace MagicZoom {
@@ -36,6 +37,9 @@ QRectF calculateRectangleByEdges(const EdgeList & edges);
 using NodeList = std::vector<NodeP>;
 QRectF calculateRectangleByNodes(const NodeList & nodes, bool isForExport = false);
 
+//! Same as calculateRectangleByNodes() for all nodes of a graph, but in constant time.
+QRectF calculateRectangleByNodePlacementStats(const NodePlacementStats & stats, bool isForExport = false);
+
 } // namespace MagicZoom
 
 #endif // MAGIC_ZOOM_HPP
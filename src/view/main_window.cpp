@@ -19,8 +19,10 @@
 #include "../application/service_container.hpp"
 #include "../common/constants.hpp"
 #include "../infra/settings.hpp"
+#include "editor_view.hpp"
 
 #include "dialogs/about_dialog.hpp"
+#include "dialogs/diagnostics_dialog.hpp"
 #include "dialogs/settings_dialog.hpp"
 #include "dialogs/spinner_dialog.hpp"
 #include "dialogs/whats_new_dialog.hpp"
@@ -41,16 +43,17 @@
 #include <QMenuBar>
 #include <QMessageBox>
 #include <QScreen>
+#include <QSignalBlocker>
 #include <QSpinBox>
 #include <QStatusBar>
+#include <QTabBar>
 #include <QVBoxLayout>
 #include <QWidgetAction>
 
 static const auto TAG = "MainWindow";
 
 MainWindow::MainWindow()
-  : m_spinnerDlg(new Dialogs::SpinnerDialog(this))
-  , m_mainMenu(new Menus::MainMenu)
+  : m_mainMenu(new Menus::MainMenu)
   , m_toolBar(new Menus::ToolBar)
   , m_statusText(new QLabel(this))
 {
@@ -97,6 +100,8 @@ void MainWindow::connectMainMenu()
     connect(m_mainMenu, &Menus::MainMenu::settingsDialogRequested, this, [=] {
         Dialogs::SettingsDialog settingsDialog;
         connect(&settingsDialog, &Dialogs::SettingsDialog::shadowEffectChanged, this, &MainWindow::shadowEffectChanged);
+        connect(&settingsDialog, &Dialogs::SettingsDialog::hardwareAccelerationChanged, this, &MainWindow::hardwareAccelerationChanged);
+        connect(&settingsDialog, &Dialogs::SettingsDialog::performanceProfileChanged, this, &MainWindow::performanceProfileChanged);
         connect(&settingsDialog, &Dialogs::SettingsDialog::autosaveEnabled, this, &MainWindow::autosaveEnabled);
         settingsDialog.exec();
     });
@@ -112,6 +117,11 @@ void MainWindow::connectMainMenu()
         whatsNewDialog.resize(3 * width() / 5, 3 * height() / 5);
         whatsNewDialog.exec();
     });
+
+    connect(m_mainMenu, &Menus::MainMenu::diagnosticsDialogRequested, this, [=] {
+        Dialogs::DiagnosticsDialog diagnosticsDialog([] { return SC::instance().applicationService()->memoryReport(); }, this);
+        diagnosticsDialog.exec();
+    });
 }
 
 void MainWindow::connectToolBar()
@@ -128,6 +138,8 @@ void MainWindow::connectToolBar()
 
     connect(m_toolBar, &Menus::ToolBar::gridVisibleChanged, this, &MainWindow::gridVisibleChanged);
 
+    connect(m_toolBar, &Menus::ToolBar::historyPositionChanged, this, &MainWindow::historyPositionChanged);
+
     connect(m_toolBar, &Menus::ToolBar::searchTextChanged, this, &MainWindow::searchTextChanged);
 
     connect(m_toolBar, &Menus::ToolBar::textSizeChanged, this, &MainWindow::textSizeChanged);
@@ -177,6 +189,53 @@ void MainWindow::initialize()
     emit actionTriggered(StateMachine::Action::MainWindowInitialized);
 }
 
+void MainWindow::setEditorView(EditorView & editorView)
+{
+    if (m_tabBar) {
+        return;
+    }
+
+    m_tabBar = new QTabBar;
+    m_tabBar->setAutoHide(true);
+    m_tabBar->setDocumentMode(true);
+    m_tabBar->setExpanding(false);
+    m_tabBar->setTabsClosable(true);
+    connect(m_tabBar, &QTabBar::currentChanged, this, &MainWindow::tabActivated);
+    connect(m_tabBar, &QTabBar::tabCloseRequested, this, [=](int index) {
+        // The not saved dialog is about the current mind map
+        m_tabBar->setCurrentIndex(index);
+        emit actionTriggered(StateMachine::Action::CloseTabSelected);
+    });
+
+    const auto centralWidget = new QWidget;
+    const auto layout = new QVBoxLayout(centralWidget);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(0);
+    layout->addWidget(m_tabBar);
+    layout->addWidget(&editorView);
+    setCentralWidget(centralWidget);
+}
+
+void MainWindow::setTabs(const QStringList & titles, int currentIndex)
+{
+    if (!m_tabBar) {
+        return;
+    }
+
+    const QSignalBlocker blocker { m_tabBar };
+    while (m_tabBar->count() > titles.size()) {
+        m_tabBar->removeTab(m_tabBar->count() - 1);
+    }
+    for (int i = 0; i < titles.size(); i++) {
+        if (i < m_tabBar->count()) {
+            m_tabBar->setTabText(i, titles.at(i));
+        } else {
+            m_tabBar->addTab(titles.at(i));
+        }
+    }
+    m_tabBar->setCurrentIndex(currentIndex);
+}
+
 void MainWindow::setTitle()
 {
     const auto appInfo = QString { "%1 %2" }.arg(Constants::Application::applicationName(), Constants::Application::applicationVersion());
@@ -188,6 +247,15 @@ void MainWindow::setTitle()
     }
 }
 
+void MainWindow::changeEvent(QEvent * event)
+{
+    if (event->type() == QEvent::WindowStateChange) {
+        emit minimizedChanged(isMinimized());
+    }
+
+    QMainWindow::changeEvent(event);
+}
+
 void MainWindow::closeEvent(QCloseEvent * event)
 {
     event->ignore();
@@ -212,6 +280,7 @@ void MainWindow::disableUndoAndRedo()
 {
     m_mainMenu->setUndoActionEnabled(false);
     m_mainMenu->setRedoActionEnabled(false);
+    m_toolBar->setHistory(0, 0);
 }
 
 void MainWindow::enableConnectSelectedNodesAction(bool enable)
@@ -244,6 +313,16 @@ void MainWindow::setEdgeWidth(double value)
     m_toolBar->setEdgeWidth(value);
 }
 
+void MainWindow::setHistory(size_t position, size_t length)
+{
+    m_toolBar->setHistory(position, length);
+}
+
+void MainWindow::setSearchText(QString text)
+{
+    m_toolBar->setSearchText(text);
+}
+
 void MainWindow::setTextSize(int textSize)
 {
     m_toolBar->setTextSize(textSize);
@@ -286,9 +365,13 @@ void MainWindow::showErrorDialog(QString message)
 void MainWindow::showSpinnerDialog(bool show, QString message)
 {
     if (show) {
+        if (!m_spinnerDlg) {
+            m_spinnerDlg = new Dialogs::SpinnerDialog(this);
+            connect(m_spinnerDlg, &QDialog::rejected, this, &MainWindow::spinnerDialogRejected);
+        }
         m_spinnerDlg->setMessage(message);
         m_spinnerDlg->show();
-    } else {
+    } else if (m_spinnerDlg) {
         m_spinnerDlg->hide();
     }
 }
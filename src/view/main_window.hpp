@@ -20,6 +20,7 @@
 #include <QGraphicsScene>
 #include <QMainWindow>
 #include <QString>
+#include <QStringList>
 #include <QTimer>
 
 #include "../application/state_machine.hpp"
@@ -44,6 +45,7 @@ class QLabel;
 class QLineEdit;
 class QSlider;
 class QSpinBox;
+class QTabBar;
 class QTextEdit;
 class QWidgetAction;
 
@@ -80,6 +82,12 @@ public:
 
     void setSaveActionStatesOnOpenedMindMap();
 
+    //! Shows the given view as the central widget below the tab bar.
+    void setEditorView(EditorView & editorView);
+
+    //! Sets the titles of the open mind maps. The tab bar is shown only if there are several.
+    void setTabs(const QStringList & titles, int currentIndex);
+
     void setTitle();
 
 public slots:
@@ -99,6 +107,11 @@ public slots:
 
     void setEdgeWidth(double value);
 
+    //! Shows the position of the current state in the undo history on the history slider.
+    void setHistory(size_t position, size_t length);
+
+    void setSearchText(QString text);
+
     void setTextSize(int textSize);
 
     void showErrorDialog(QString message);
@@ -106,6 +119,8 @@ public slots:
     void showSpinnerDialog(bool show, QString message = {});
 
 protected:
+    void changeEvent(QEvent * event) override;
+
     void closeEvent(QCloseEvent * event) override;
 
 signals:
@@ -125,10 +140,25 @@ signals:
 
     void gridVisibleChanged(int state);
 
+    void hardwareAccelerationChanged(bool enabled);
+
+    //! Emitted when the user picks another position in the undo history on the history slider.
+    void historyPositionChanged(int position);
+
+    void minimizedChanged(bool minimized);
+
+    void performanceProfileChanged();
+
     void searchTextChanged(QString text);
 
+    //! Emitted when the user closes the spinner dialog, e.g. with Esc, to cancel what it waits for.
+    void spinnerDialogRejected();
+
     void shadowEffectChanged(const ShadowEffectParams & params);
 
+    //! Emitted when the user selects another tab.
+    void tabActivated(int index);
+
     void textSizeChanged(int value);
 
     void zoomInRequested();
@@ -150,12 +180,16 @@ private:
 
     void resizeWindow();
 
-    Dialogs::SpinnerDialog * m_spinnerDlg;
+    //! Created on first use.
+    Dialogs::SpinnerDialog * m_spinnerDlg = nullptr;
 
     Menus::MainMenu * m_mainMenu;
 
     Menus::ToolBar * m_toolBar;
 
+    //! Created with the central widget, see setEditorView().
+    QTabBar * m_tabBar = nullptr;
+
     QString m_argMindMapFile;
 
     bool m_closeNow = false;
@@ -70,6 +70,10 @@ void MainContextMenu::createActions(const Grid & grid)
     createNodeDeletionActions();
 
     createImageActions();
+
+    createToggleCollapsedAction();
+
+    createSelectionActions();
 }
 
 void MainContextMenu::populateWithActions()
@@ -88,6 +92,14 @@ void MainContextMenu::populateWithActions()
 
     addAction(m_deleteNodeAction);
 
+    addAction(m_toggleCollapsedAction);
+
+    addSeparator();
+
+    addAction(m_selectBranchAction);
+
+    addAction(m_selectAncestorsAction);
+
     addSeparator();
 
     addAction(m_attachImageAction);
@@ -190,6 +202,33 @@ void MainContextMenu::createImageActions()
     m_mainContextMenuActions[Mode::Node].push_back(m_removeImageAction);
 }
 
+void MainContextMenu::createSelectionActions()
+{
+    m_selectBranchAction = new QAction { tr("Select branch"), this };
+    connect(m_selectBranchAction, &QAction::triggered, this, [] {
+        SC::instance().applicationService()->performNodeAction({ NodeAction::Type::SelectBranch });
+    });
+
+    m_mainContextMenuActions[Mode::Node].push_back(m_selectBranchAction);
+
+    m_selectAncestorsAction = new QAction { tr("Select ancestors"), this };
+    connect(m_selectAncestorsAction, &QAction::triggered, this, [] {
+        SC::instance().applicationService()->performNodeAction({ NodeAction::Type::SelectAncestors });
+    });
+
+    m_mainContextMenuActions[Mode::Node].push_back(m_selectAncestorsAction);
+}
+
+void MainContextMenu::createToggleCollapsedAction()
+{
+    m_toggleCollapsedAction = new QAction { tr("Collapse branch"), this };
+    connect(m_toggleCollapsedAction, &QAction::triggered, this, [] {
+        SC::instance().applicationService()->performNodeAction({ NodeAction::Type::ToggleCollapsed });
+    });
+
+    m_mainContextMenuActions[Mode::Node].push_back(m_toggleCollapsedAction);
+}
+
 QMenu & MainContextMenu::createColorSubMenu()
 {
     const auto setBackgroundColorAction { new QAction { tr("Set background color"), this } };
@@ -254,6 +293,9 @@ void MainContextMenu::setMode(const Mode & mode)
     m_pasteNodeAction->setText(SC::instance().applicationService()->copyStackSize() > 1 ? tr("Paste nodes") : tr("Paste node"));
 
     m_removeImageAction->setEnabled(SC::instance().applicationService()->nodeHasImageAttached());
+
+    const auto selectedNode = SC::instance().applicationService()->selectedNode();
+    m_toggleCollapsedAction->setText(selectedNode.has_value() && (*selectedNode)->collapsed() ? tr("Expand branch") : tr("Collapse branch"));
 }
 
 } // namespace Menus
@@ -75,6 +75,10 @@ private:
 
     void createPasteNodeAction();
 
+    void createSelectionActions();
+
+    void createToggleCollapsedAction();
+
     void initialize();
 
     void populateWithActions();
@@ -97,6 +101,12 @@ private:
 
     QAction * m_removeImageAction = nullptr;
 
+    QAction * m_selectAncestorsAction = nullptr;
+
+    QAction * m_selectBranchAction = nullptr;
+
+    QAction * m_toggleCollapsedAction = nullptr;
+
     QShortcut * m_copyNodeShortcut = nullptr;
 
     QShortcut * m_pasteNodeShortcut = nullptr;
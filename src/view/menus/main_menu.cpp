@@ -241,8 +241,8 @@ void MainMenu::createExportSubMenu(QMenu & fileMenu)
     const auto exportMenuAction = fileMenu.addMenu(exportMenu);
     exportMenuAction->setText(tr("&Export"));
 
-    // Add "export to PNG image"-action
-    const auto exportToPngAction = new QAction(tr("&PNG"), this);
+    // Add "export to PNG, JPEG or WebP image"-action
+    const auto exportToPngAction = new QAction(tr("&Image"), this);
     exportMenu->addAction(exportToPngAction);
     connect(exportToPngAction, &QAction::triggered, this, [=] {
         emit actionTriggered(StateMachine::Action::PngExportSelected);
@@ -250,6 +250,15 @@ void MainMenu::createExportSubMenu(QMenu & fileMenu)
 
     exportMenu->addSeparator();
 
+    // Add "export to PDF file"-action
+    const auto exportToPdfAction = new QAction(tr("P&DF"), this);
+    exportMenu->addAction(exportToPdfAction);
+    connect(exportToPdfAction, &QAction::triggered, this, [=] {
+        emit actionTriggered(StateMachine::Action::PdfExportSelected);
+    });
+
+    exportMenu->addSeparator();
+
     // Add "export to SVG file"-action
     const auto exportToSvgAction = new QAction(tr("&SVG"), this);
     exportMenu->addAction(exportToSvgAction);
@@ -259,6 +268,7 @@ void MainMenu::createExportSubMenu(QMenu & fileMenu)
 
     connect(&fileMenu, &QMenu::aboutToShow, this, [=] {
         exportToPngAction->setEnabled(SC::instance().applicationService()->hasNodes());
+        exportToPdfAction->setEnabled(SC::instance().applicationService()->hasNodes());
         exportToSvgAction->setEnabled(SC::instance().applicationService()->hasNodes());
     });
 }
@@ -283,6 +293,28 @@ void MainMenu::createFileMenu()
         emit actionTriggered(StateMachine::Action::OpenSelected);
     });
 
+    // Add "new tab"-action
+    const auto newTabAction = new QAction(tr("New &Tab"), this);
+    newTabAction->setShortcut(QKeySequence(QKeySequence::AddTab));
+    fileMenu->addAction(newTabAction);
+    connect(newTabAction, &QAction::triggered, this, [=] {
+        emit actionTriggered(StateMachine::Action::NewTabSelected);
+    });
+
+    // Add "open in new tab"-action
+    const auto openInNewTabAction = new QAction(tr("Open in New Ta&b") + Constants::Misc::threeDots(), this);
+    fileMenu->addAction(openInNewTabAction);
+    connect(openInNewTabAction, &QAction::triggered, this, [=] {
+        emit actionTriggered(StateMachine::Action::OpenInNewTabSelected);
+    });
+
+    // Add "open URL"-action
+    const auto openUrlAction = new QAction(tr("Open &URL") + Constants::Misc::threeDots(), this);
+    fileMenu->addAction(openUrlAction);
+    connect(openUrlAction, &QAction::triggered, this, [=] {
+        emit actionTriggered(StateMachine::Action::OpenUrlSelected);
+    });
+
     // Add "Recent Files"-menu
     const auto recentFilesMenu = new Menus::RecentFilesMenu;
     const auto recentFilesMenuAction = fileMenu->addMenu(recentFilesMenu);
@@ -291,6 +323,28 @@ void MainMenu::createFileMenu()
         emit actionTriggered(StateMachine::Action::RecentFileSelected);
     });
 
+    // Add "search workspace"-action
+    const auto searchWorkspaceAction = new QAction(tr("Search &Workspace") + Constants::Misc::threeDots(), this);
+    searchWorkspaceAction->setShortcut(QKeySequence("Ctrl+Shift+W"));
+    fileMenu->addAction(searchWorkspaceAction);
+    connect(searchWorkspaceAction, &QAction::triggered, this, [=] {
+        emit actionTriggered(StateMachine::Action::WorkspaceSearchSelected);
+    });
+
+    // Add "compare with file"-action
+    const auto compareAction = new QAction(tr("&Compare With File") + Constants::Misc::threeDots(), this);
+    fileMenu->addAction(compareAction);
+    connect(compareAction, &QAction::triggered, this, [=] {
+        emit actionTriggered(StateMachine::Action::CompareSelected);
+    });
+
+    // Add "run script"-action
+    const auto runScriptAction = new QAction(tr("&Run Script") + Constants::Misc::threeDots(), this);
+    fileMenu->addAction(runScriptAction);
+    connect(runScriptAction, &QAction::triggered, this, [=] {
+        emit actionTriggered(StateMachine::Action::RunScriptSelected);
+    });
+
     fileMenu->addSeparator();
 
     // Add "save"-action
@@ -322,6 +376,14 @@ void MainMenu::createFileMenu()
 
     fileMenu->addSeparator();
 
+    // Add "close tab"-action
+    const auto closeTabAction = new QAction(tr("C&lose Tab"), this);
+    closeTabAction->setShortcut(QKeySequence(QKeySequence::Close));
+    fileMenu->addAction(closeTabAction);
+    connect(closeTabAction, &QAction::triggered, this, [=] {
+        emit actionTriggered(StateMachine::Action::CloseTabSelected);
+    });
+
     // Add "quit"-action
     const auto quitAction = new QAction(tr("&Quit"), this);
     quitAction->setShortcut(QKeySequence(QKeySequence::Quit));
@@ -394,6 +456,11 @@ void MainMenu::createHelpMenu()
     const auto whatsNewAction = new QAction(tr("What's New"), this);
     helpMenu->addAction(whatsNewAction);
     connect(whatsNewAction, &QAction::triggered, this, &MainMenu::whatsNewDialogRequested);
+
+    // Add "Diagnostics"-action
+    const auto diagnosticsAction = new QAction(tr("Diagnostics"), this);
+    helpMenu->addAction(diagnosticsAction);
+    connect(diagnosticsAction, &QAction::triggered, this, &MainMenu::diagnosticsDialogRequested);
 }
 
 void MainMenu::createViewMenu()
@@ -430,8 +497,18 @@ void MainMenu::createViewMenu()
     viewMenu->addAction(zoomToFitAction);
     connect(zoomToFitAction, &QAction::triggered, this, &MainMenu::zoomToFitRequested);
 
+    viewMenu->addSeparator();
+
+    // Add "clear comparison"-action
+    const auto clearComparisonAction = new QAction(tr("Clear Comparison"), this);
+    viewMenu->addAction(clearComparisonAction);
+    connect(clearComparisonAction, &QAction::triggered, this, [] {
+        SC::instance().applicationService()->clearComparison();
+    });
+
     connect(viewMenu, &QMenu::aboutToShow, this, [=] {
         zoomToFitAction->setEnabled(SC::instance().applicationService()->hasNodes());
+        clearComparisonAction->setEnabled(SC::instance().applicationService()->isComparing());
     });
 }
 
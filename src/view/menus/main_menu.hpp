@@ -56,6 +56,8 @@ signals:
 
     void actionTriggered(StateMachine::Action action);
 
+    void diagnosticsDialogRequested();
+
     void fullScreenChanged(bool fullScreen);
 
     void settingsDialogRequested();
@@ -17,7 +17,12 @@
 
 #include "../../application/recent_files_manager.hpp"
 #include "../../application/service_container.hpp"
+#include "../../application/thumbnail_cache.hpp"
+#include "../../common/constants.hpp"
 #include "../../common/utils.hpp"
+#include "../../infra/io/mind_map_header.hpp"
+
+#include <QPixmap>
 
 #include <functional>
 
@@ -32,6 +37,16 @@ RecentFilesMenu::RecentFilesMenu(QWidget * parent)
         }
         for (auto && filePath : SC::instance().recentFilesManager()->recentFiles()) {
             const auto action = addAction(filePath);
+            auto thumbnail = SC::instance().thumbnailCache()->thumbnail(filePath, Constants::View::thumbnailSizes().first());
+            if (thumbnail.isNull() && Utils::fileExists(filePath)) {
+                // E.g. a file saved on another machine. Only the header at the start of the file is read.
+                if (const auto header = IO::readHeader(filePath); header) {
+                    thumbnail = header->thumbnailImage();
+                }
+            }
+            if (!thumbnail.isNull()) {
+                action->setIcon(QPixmap::fromImage(thumbnail));
+            }
             const auto handler = std::bind([=](QString filePath) {
                 SC::instance().recentFilesManager()->setSelectedFile(filePath);
                 fileSelected(filePath);
@@ -29,6 +29,7 @@
 #include <QFontDialog>
 #include <QLineEdit>
 #include <QPushButton>
+#include <QSlider>
 #include <QSpinBox>
 #include <QWidgetAction>
 
@@ -50,6 +51,7 @@ void ToolBar::createComponents()
     m_edgeWidthSpinBox = new QDoubleSpinBox { this };
     m_fontButton = new Widgets::FontButton { this };
     m_gridSizeSpinBox = new QSpinBox { this };
+    m_historySlider = new QSlider { Qt::Horizontal, this };
     m_searchLineEdit = new QLineEdit { this };
     m_showGridCheckBox = new QCheckBox { tr("Show grid"), this };
     m_textSizeSpinBox = new QSpinBox { this };
@@ -79,6 +81,10 @@ void ToolBar::addActions()
 
     addAction(createGridSizeAction());
 
+    addSeparator();
+
+    addAction(createHistoryAction());
+
     const auto spacer = new QWidget;
     spacer->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
     addWidget(spacer);
@@ -219,6 +225,17 @@ QWidgetAction * ToolBar::createGridSizeAction()
     return WidgetFactory::buildToolBarWidgetActionWithLabel(tr("Grid size:"), *m_gridSizeSpinBox, *this).second;
 }
 
+QWidgetAction * ToolBar::createHistoryAction()
+{
+    m_historySlider->setMinimumWidth(100);
+    // Only the released position is applied, so that dragging across the history doesn't undo each step on the way
+    m_historySlider->setTracking(false);
+    connect(m_historySlider, &QSlider::valueChanged, this, &ToolBar::historyPositionChanged);
+    setHistory(m_historyPosition, m_historyLength);
+
+    return WidgetFactory::buildToolBarWidgetActionWithLabel(tr("History:"), *m_historySlider, *this).second;
+}
+
 QWidgetAction * ToolBar::createSearchAction()
 {
     m_searchTimer.setSingleShot(true);
@@ -299,6 +316,26 @@ void ToolBar::setEdgeWidth(double value)
     }
 }
 
+void ToolBar::setHistory(size_t position, size_t length)
+{
+    m_historyPosition = position;
+    m_historyLength = length;
+
+    m_historySlider->blockSignals(true);
+    m_historySlider->setRange(0, static_cast<int>(length));
+    m_historySlider->setValue(static_cast<int>(position));
+    m_historySlider->blockSignals(false);
+    m_historySlider->setEnabled(length > 0);
+    m_historySlider->setToolTip(tr("Jump to any point in the undo history: %1 / %2").arg(position).arg(length));
+}
+
+void ToolBar::setSearchText(QString text)
+{
+    m_searchLineEdit->setText(text);
+    // Search right away instead of waiting for more typing
+    m_searchTimer.start(0);
+}
+
 void ToolBar::setTextSize(int textSize)
 {
     if (textSize <= 0) {
@@ -26,6 +26,7 @@ class QEvent;
 class QFont;
 class QLineEdit;
 class QPushButton;
+class QSlider;
 class QSpinBox;
 class QWidgetAction;
 
@@ -60,6 +61,12 @@ public:
 
     void setEdgeWidth(double value);
 
+    //! Sets the range and the position of the history slider. The slider is disabled when there's no history.
+    void setHistory(size_t position, size_t length);
+
+    //! Sets the text of the search field and searches for it as if typed.
+    void setSearchText(QString text);
+
     void setTextSize(int textSize);
 
 signals:
@@ -75,6 +82,9 @@ signals:
 
     void gridVisibleChanged(int state);
 
+    //! Emitted when the history slider is released at another position.
+    void historyPositionChanged(int position);
+
     void searchTextChanged(QString text);
 
     void textSizeChanged(int value);
@@ -93,6 +103,8 @@ private:
 
     QWidgetAction * createGridSizeAction();
 
+    QWidgetAction * createHistoryAction();
+
     QWidgetAction * createSearchAction();
 
     QWidgetAction * createTextSizeAction();
@@ -119,6 +131,13 @@ private:
 
     QSpinBox * m_gridSizeSpinBox = nullptr;
 
+    QSlider * m_historySlider = nullptr;
+
+    //! Kept for the slider that gets created again on retranslate.
+    size_t m_historyPosition = 0;
+
+    size_t m_historyLength = 0;
+
     QLineEdit * m_searchLineEdit = nullptr;
 
     QTimer m_searchTimer;
@@ -17,7 +17,7 @@
 #define NODE_ACTION_HPP
 
 #include <QColor>
-#include <QImage>
+#include <QString>
 
 class NodeAction
 {
@@ -34,8 +34,11 @@ public:
         MirrorLayoutVertically,
         Paste,
         RemoveAttachedImage,
+        SelectAncestors,
+        SelectBranch,
         SetNodeColor,
         SetTextColor,
+        ToggleCollapsed,
     };
 
     NodeAction(Type type)
@@ -49,9 +52,9 @@ public:
     {
     }
 
-    NodeAction(Type type, QImage image, QString fileName)
+    //! The image file is only read when the action is performed and decoded in the background.
+    NodeAction(Type type, QString fileName)
       : m_type(type)
-      , m_image(image)
       , m_fileName(fileName)
     {
     }
@@ -60,8 +63,6 @@ public:
 
     QColor color() const;
 
-    QImage image() const;
-
     QString fileName() const;
 
 private:
@@ -69,8 +70,6 @@ private:
 
     QColor m_color = Qt::white;
 
-    QImage m_image;
-
     QString m_fileName;
 };
 
@@ -84,11 +83,6 @@ inline QColor NodeAction::color() const
     return m_color;
 }
 
-inline QImage NodeAction::image() const
-{
-    return m_image;
-}
-
 inline QString NodeAction::fileName() const
 {
     return m_fileName;
@@ -15,19 +15,35 @@
 
 #include "node_selection_group.hpp"
 
+#include "../domain/graph.hpp"
+#include "scene_items/edge.hpp"
+#include "scene_items/edge_update_batch.hpp"
 #include "scene_items/node.hpp"
+#include "scene_items/selection_update_batch.hpp"
 
 #include <algorithm>
+#include <iterator>
+#include <unordered_set>
 
 void NodeSelectionGroup::add(NodeR node, bool isImplicit)
 {
-    if (!m_implicitlyAdded.count(&node)) {
-        m_implicitlyAdded[&node] = isImplicit;
+    if (!m_entries.count(&node)) {
+        m_entries[&node] = { m_nodes.size(), isImplicit };
         m_nodes.push_back(&node);
         node.setSelected(true);
+        m_moveReference = nullptr;
+        m_revision++;
+        if (!m_removedSinceCount.erase(&node)) {
+            m_addedSinceCount.insert(&node);
+        }
     }
 }
 
+void NodeSelectionGroup::beginMove()
+{
+    m_moveReference = nullptr;
+}
+
 void NodeSelectionGroup::clear(bool onlyImplicitNodes)
 {
     if (onlyImplicitNodes) {
@@ -35,88 +51,276 @@ void NodeSelectionGroup::clear(bool onlyImplicitNodes)
     } else {
         clearAll();
     }
+    m_moveReference = nullptr;
 }
 
 void NodeSelectionGroup::clearAll()
 {
+    const SceneItems::SelectionUpdateBatch selectionUpdateBatch;
+
+    if (!m_entries.empty()) {
+        m_revision++;
+    }
+
     for (auto && node : m_nodes) {
-        node->setSelected(false);
+        if (node) {
+            node->setSelected(false);
+        }
     }
-    m_implicitlyAdded.clear();
+    m_entries.clear();
     m_nodes.clear();
+    m_holeCount = 0;
+    invalidateInternalEdgeCount();
 }
 
 void NodeSelectionGroup::clearImplicitOnly()
 {
+    const SceneItems::SelectionUpdateBatch selectionUpdateBatch;
+
     for (auto && node : m_nodes) {
-        if (m_implicitlyAdded.count(node) && m_implicitlyAdded.at(node)) {
+        if (node && m_entries.at(node).isImplicit) {
             node->setSelected(false);
+            m_entries.erase(node);
+            node = nullptr;
+            m_holeCount++;
+            m_revision++;
         }
     }
-    m_nodes.erase(std::remove_if(m_nodes.begin(), m_nodes.end(), [nodeMap = m_implicitlyAdded](auto && node) {
-                      return nodeMap.count(node) && nodeMap.at(node);
-                  }),
-                  m_nodes.end());
-    // Note!!: std::remove_if will work on maps in C++20 ->
-    for (auto iter = m_implicitlyAdded.begin(); iter != m_implicitlyAdded.end();) {
-        if (iter->second) {
-            iter = m_implicitlyAdded.erase(iter);
-        } else {
-            iter++;
+    compact();
+    invalidateInternalEdgeCount();
+}
+
+void NodeSelectionGroup::compact()
+{
+    if (m_holeCount) {
+        m_nodes.erase(std::remove(m_nodes.begin(), m_nodes.end(), nullptr), m_nodes.end());
+        for (size_t i = 0; i < m_nodes.size(); i++) {
+            m_entries.at(m_nodes.at(i)).position = i;
         }
+        m_holeCount = 0;
     }
 }
 
 bool NodeSelectionGroup::contains(NodeR node) const
 {
-    return m_implicitlyAdded.count(&node);
+    return m_entries.count(&node);
+}
+
+template<typename IsMember>
+size_t NodeSelectionGroup::edgeCountToMembers(GraphCR graph, NodeR node, IsMember && isMember)
+{
+    size_t count = 0;
+    for (auto && edge : graph.edgesFromNode(node.index())) {
+        if (&edge->targetNode() != &node && isMember(edge->targetNode())) {
+            count++;
+        }
+    }
+    for (auto && edge : graph.edgesToNode(node.index())) {
+        if (&edge->sourceNode() != &node && isMember(edge->sourceNode())) {
+            count++;
+        }
+    }
+    return count;
+}
+
+size_t NodeSelectionGroup::internalEdgeCount(GraphCR graph) const
+{
+    const auto isMember = [this](NodeR node) {
+        return contains(node);
+    };
+
+    if (m_internalEdgeCountRevision != graph.topologyRevision() || m_addedSinceCount.size() + m_removedSinceCount.size() > m_entries.size()) {
+        // Each edge is seen from both of its nodes
+        size_t count = 0;
+        for (auto && node : m_nodes) {
+            if (node) {
+                count += edgeCountToMembers(graph, *node, isMember);
+            }
+        }
+        m_internalEdgeCount = count / 2;
+    } else {
+        // The removed nodes are still in the graph, because the topology hasn't changed since the count
+        const auto isRemoved = [this](NodeR node) {
+            return m_removedSinceCount.count(&node) > 0;
+        };
+        const auto wasMember = [this, isRemoved](NodeR node) {
+            return (contains(node) && !m_addedSinceCount.count(&node)) || isRemoved(node);
+        };
+        const auto wasOtherMember = [wasMember, isRemoved](NodeR node) {
+            return wasMember(node) && !isRemoved(node);
+        };
+        size_t removedEdgeCount = 0;
+        size_t edgesBetweenRemovedCount = 0;
+        for (auto && node : m_removedSinceCount) {
+            removedEdgeCount += edgeCountToMembers(graph, *node, wasOtherMember);
+            edgesBetweenRemovedCount += edgeCountToMembers(graph, *node, isRemoved);
+        }
+
+        const auto isAdded = [this](NodeR node) {
+            return m_addedSinceCount.count(&node) > 0;
+        };
+        const auto isOtherMember = [this, isAdded](NodeR node) {
+            return contains(node) && !isAdded(node);
+        };
+        size_t addedEdgeCount = 0;
+        size_t edgesBetweenAddedCount = 0;
+        for (auto && node : m_addedSinceCount) {
+            addedEdgeCount += edgeCountToMembers(graph, *node, isOtherMember);
+            edgesBetweenAddedCount += edgeCountToMembers(graph, *node, isAdded);
+        }
+
+        m_internalEdgeCount = m_internalEdgeCount - removedEdgeCount - edgesBetweenRemovedCount / 2 + addedEdgeCount + edgesBetweenAddedCount / 2;
+    }
+
+    m_internalEdgeCountRevision = graph.topologyRevision();
+    m_addedSinceCount.clear();
+    m_removedSinceCount.clear();
+
+    return m_internalEdgeCount;
+}
+
+std::vector<EdgeP> NodeSelectionGroup::internalEdges(GraphCR graph) const
+{
+    std::vector<EdgeP> edges;
+    for (auto && node : m_nodes) {
+        if (node) {
+            for (auto && edge : graph.edgesFromNode(node->index())) {
+                if (&edge->targetNode() != node && contains(edge->targetNode())) {
+                    edges.push_back(edge.get());
+                }
+            }
+        }
+    }
+    return edges;
+}
+
+void NodeSelectionGroup::invalidateInternalEdgeCount()
+{
+    m_internalEdgeCountRevision = 0;
+    m_addedSinceCount.clear();
+    m_removedSinceCount.clear();
 }
 
 bool NodeSelectionGroup::isEmpty() const
 {
-    return m_implicitlyAdded.empty();
+    return m_entries.empty();
 }
 
 void NodeSelectionGroup::move(NodeR reference, QPointF location)
 {
-    std::map<int, QPointF> delta;
-    for (auto && node : m_nodes) {
-        if (node->index() != reference.index()) {
-            delta[node->index()] = node->location() - reference.location();
+    if (m_moveReference != &reference) {
+        m_moveDeltas.clear();
+        m_moveDeltas.reserve(m_entries.size());
+        for (auto && node : m_nodes) {
+            if (node && node->index() != reference.index()) {
+                m_moveDeltas.push_back({ node, node->location() - reference.location() });
+            }
         }
+        m_moveReference = &reference;
     }
 
+    // Update each edge once after all nodes have moved
+    const SceneItems::EdgeUpdateBatch edgeUpdateBatch;
+
     reference.setLocation(location);
 
-    for (auto && node : m_nodes) {
-        if (node->index() != reference.index()) {
-            node->setLocation(reference.location() + delta[node->index()]);
-        }
+    for (auto && moveDelta : m_moveDeltas) {
+        moveDelta.first->setLocation(reference.location() + moveDelta.second);
     }
 }
 
 const std::vector<NodeP> NodeSelectionGroup::nodes() const
 {
-    return m_nodes;
+    if (!m_holeCount) {
+        return m_nodes;
+    }
+
+    std::vector<NodeP> nodes;
+    nodes.reserve(m_entries.size());
+    std::copy_if(m_nodes.begin(), m_nodes.end(), std::back_inserter(nodes), [](auto && node) {
+        return node != nullptr;
+    });
+    return nodes;
+}
+
+void NodeSelectionGroup::remove(NodeR node)
+{
+    if (const auto iter = m_entries.find(&node); iter != m_entries.end()) {
+        m_nodes.at(iter->second.position) = nullptr;
+        m_entries.erase(iter);
+        m_moveReference = nullptr;
+        m_revision++;
+        if (!m_addedSinceCount.erase(&node)) {
+            m_removedSinceCount.insert(&node);
+        }
+        if (++m_holeCount > m_entries.size()) {
+            compact();
+        }
+    }
+    node.setSelected(false);
+}
+
+size_t NodeSelectionGroup::revision() const
+{
+    return m_revision;
 }
 
 std::optional<NodeP> NodeSelectionGroup::selectedNode() const
 {
-    return !m_nodes.empty() ? std::optional<NodeP> { *m_nodes.begin() } : std::optional<NodeP> {};
+    for (auto && node : m_nodes) {
+        if (node) {
+            return node;
+        }
+    }
+    return {};
+}
+
+void NodeSelectionGroup::set(const std::vector<NodeP> & nodes)
+{
+    const SceneItems::SelectionUpdateBatch selectionUpdateBatch;
+
+    const std::unordered_set<NodeP> selected(nodes.begin(), nodes.end());
+    for (auto && node : m_nodes) {
+        if (node && !selected.count(node)) {
+            node->setSelected(false);
+        }
+    }
+    m_entries.clear();
+    m_nodes.clear();
+    m_holeCount = 0;
+    m_moveReference = nullptr;
+    m_revision++;
+    invalidateInternalEdgeCount();
+
+    m_nodes.reserve(selected.size());
+    for (auto && node : nodes) {
+        if (!m_entries.count(node)) {
+            m_entries[node] = { m_nodes.size(), false };
+            m_nodes.push_back(node);
+            node->setSelected(true);
+        }
+    }
 }
 
 size_t NodeSelectionGroup::size() const
 {
-    return m_nodes.size();
+    return m_entries.size();
 }
 
 void NodeSelectionGroup::toggle(NodeR node)
 {
     if (node.selected()) {
-        m_nodes.erase(std::find(m_nodes.begin(), m_nodes.end(), &node));
-        node.setSelected(false);
-        m_implicitlyAdded.erase(&node);
+        remove(node);
     } else {
         add(node);
     }
 }
+
+void NodeSelectionGroup::toggle(const std::vector<NodeP> & nodes)
+{
+    const SceneItems::SelectionUpdateBatch selectionUpdateBatch;
+
+    for (auto && node : nodes) {
+        toggle(*node);
+    }
+}
@@ -20,6 +20,8 @@
 
 #include <optional>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "../common/types.hpp"
@@ -32,34 +34,93 @@ public:
     //! \param isImplicit Tells if the node is implicitly added e.g. due to some user action.
     void add(NodeR node, bool isImplicit = false);
 
+    //! Should be called when a drag starts, so that move() takes the relative positions of the nodes from their current locations.
+    void beginMove();
+
     //! Clears the selection group.
     //! \param implicitOnly If true, only implicitly added nodes are removed from the group.
     void clear(bool implicitOnly = false);
 
     bool contains(NodeR node) const;
 
+    //! \returns Number of edges of the given graph between the nodes of the group, self-loops excluded.
+    //! The count is updated from the nodes added and removed since the previous call, which costs their degrees,
+    //! and recounted over the whole group only after the group is replaced or the topology of the graph changes.
+    size_t internalEdgeCount(GraphCR graph) const;
+
+    //! \returns Edges of the given graph between the nodes of the group, self-loops excluded, in O(degrees of the nodes).
+    std::vector<EdgeP> internalEdges(GraphCR graph) const;
+
     bool isEmpty() const;
 
+    //! Moves the group so that the reference node ends up at the given location.
+    //! The relative positions are calculated on the first move after the group or the reference changes.
     void move(NodeR reference, QPointF location);
 
     const std::vector<NodeP> nodes() const;
 
+    void remove(NodeR node);
+
+    //! \returns Revision that changes whenever nodes get added to or removed from the group.
+    size_t revision() const;
+
     std::optional<NodeP> selectedNode() const;
 
+    //! Replaces the group with the given nodes. Only the nodes whose selection actually changes are updated.
+    void set(const std::vector<NodeP> & nodes);
+
     size_t size() const;
 
     void toggle(NodeR node);
 
+    //! Toggles all given nodes at once.
+    void toggle(const std::vector<NodeP> & nodes);
+
 private:
     void clearAll();
 
     void clearImplicitOnly();
 
-    // Use vector because we want to keep the order
+    void compact();
+
+    void invalidateInternalEdgeCount();
+
+    //! \returns Number of edges between the given node and the nodes for which isMember() is true.
+    template<typename IsMember>
+    static size_t edgeCountToMembers(GraphCR graph, NodeR node, IsMember && isMember);
+
+    // Use vector because we want to keep the order. Removed nodes leave a nullptr hole
+    // so that removal is O(1), and the holes get compacted away when they become the majority.
     std::vector<NodeP> m_nodes;
 
-    // Map from node -> is implicitly added
-    std::unordered_map<NodeP, bool> m_implicitlyAdded;
+    size_t m_holeCount = 0;
+
+    struct Entry
+    {
+        size_t position = 0;
+
+        bool isImplicit = false;
+    };
+
+    // Map from node -> its position in m_nodes and whether it's implicitly added
+    std::unordered_map<NodeP, Entry> m_entries;
+
+    // Relative positions of the nodes to the reference node, cached for the duration of a drag
+    std::vector<std::pair<NodeP, QPointF>> m_moveDeltas;
+
+    NodeP m_moveReference = nullptr;
+
+    size_t m_revision = 0;
+
+    // The internal edge count and the changes of the group since the count. The count is valid only for
+    // the graph topology revision it was counted for, 0 being no revision.
+    mutable size_t m_internalEdgeCount = 0;
+
+    mutable size_t m_internalEdgeCountRevision = 0;
+
+    mutable std::unordered_set<NodeP> m_addedSinceCount;
+
+    mutable std::unordered_set<NodeP> m_removedSinceCount;
 };
 
 #endif // NODE_SELECTION_GROUP_HPP
@@ -15,15 +15,20 @@
 
 #include "edge.hpp"
 
-#include "../../application/service_container.hpp"
 #include "../../application/settings_proxy.hpp"
+#include "../../application/settings_snapshot.hpp"
+#include "../../common/profiler.hpp"
 #include "../../common/test_mode.hpp"
 #include "../../domain/graph.hpp"
+#include "../editor_scene.hpp"
 #include "../shadow_effect_params.hpp"
 #include "edge_dot.hpp"
+#include "edge_dot_animator.hpp"
+#include "edge_update_batch.hpp"
 #include "edge_text_edit.hpp"
 #include "graphics_factory.hpp"
 #include "layers.hpp"
+#include "level_of_detail.hpp"
 #include "node.hpp"
 
 #include "simple_logger.hpp"
@@ -31,52 +36,120 @@
 #include <QBrush>
 #include <QFont>
 #include <QGraphicsEllipseItem>
-#include <QGraphicsLineItem>
 #include <QGraphicsScene>
+#include <QPainter>
+#include <QPainterPathStroker>
 #include <QPen>
-#include <QPropertyAnimation>
 #include <QTimer>
 #include <QVector2D>
 
 #include <QtMath>
 
+#include <algorithm>
 #include <cmath>
 
 namespace SceneItems {
 
 static const auto TAG = "Edge";
 
+// Thin edges are hit tested as if they were this wide, so that they can be clicked
+static const double MIN_HIT_WIDTH = 4;
+
+namespace {
+
+//! \returns True if the segment crosses or is inside the rect (Liang-Barsky clipping).
+bool segmentIntersectsRect(const QLineF & segment, const QRectF & rect)
+{
+    const std::array<std::pair<double, double>, 4> boundaries = { {
+      { -segment.dx(), segment.x1() - rect.left() },
+      { segment.dx(), rect.right() - segment.x1() },
+      { -segment.dy(), segment.y1() - rect.top() },
+      { segment.dy(), rect.bottom() - segment.y1() },
+    } };
+
+    double enter = 0;
+    double exit = 1;
+    for (auto && [direction, distance] : boundaries) {
+        if (direction == 0.0) {
+            if (distance < 0) {
+                return false;
+            }
+        } else if (const auto t = distance / direction; direction < 0) {
+            enter = std::max(enter, t);
+        } else {
+            exit = std::min(exit, t);
+        }
+
+        if (enter > exit) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+double distanceToSegment(QPointF point, const QLineF & segment)
+{
+    const auto lengthSquared = segment.dx() * segment.dx() + segment.dy() * segment.dy();
+    const auto t = lengthSquared > 0 ? std::clamp(((point.x() - segment.x1()) * segment.dx() + (point.y() - segment.y1()) * segment.dy()) / lengthSquared, 0.0, 1.0) : 0.0;
+    return QLineF { point, segment.pointAt(t) }.length();
+}
+
+double distanceToRect(QPointF point, const QRectF & rect)
+{
+    const auto dx = std::max({ rect.left() - point.x(), 0.0, point.x() - rect.right() });
+    const auto dy = std::max({ rect.top() - point.y(), 0.0, point.y() - rect.bottom() });
+    return std::hypot(dx, dy);
+}
+
+double distanceBetweenSegmentAndRect(const QLineF & segment, const QRectF & rect)
+{
+    if (segmentIntersectsRect(segment, rect)) {
+        return 0;
+    }
+
+    // Otherwise the nearest points are an end of the segment or a corner of the rect
+    auto distance = std::min(distanceToRect(segment.p1(), rect), distanceToRect(segment.p2(), rect));
+    for (auto && corner : { rect.topLeft(), rect.topRight(), rect.bottomLeft(), rect.bottomRight() }) {
+        distance = std::min(distance, distanceToSegment(corner, segment));
+    }
+
+    return distance;
+}
+
+//! QGraphicsScene::items(QRectF) and ItemFilter pass axis-aligned rects as paths of their corners.
+std::optional<QRectF> pathAsRect(const QPainterPath & path)
+{
+    if (path.elementCount() < 4 || path.elementCount() > 6) {
+        return {};
+    }
+
+    const auto rect = path.boundingRect();
+    for (int i = 0; i < path.elementCount(); i++) {
+        const auto element = path.elementAt(i);
+        if ((i ? !element.isLineTo() : !element.isMoveTo()) || (element.x != rect.left() && element.x != rect.right()) || (element.y != rect.top() && element.y != rect.bottom())) {
+            return {};
+        }
+    }
+
+    return rect;
+}
+
+} // namespace
+
 Edge::Edge(NodeP sourceNode, NodeP targetNode, bool enableAnimations, bool enableLabels)
-  : m_settingsProxy(SC::instance().settingsProxy())
-  , m_edgeModel(std::make_unique<EdgeModel>(m_settingsProxy->reversedEdgeDirection(),
-                                            EdgeModel::Style { m_settingsProxy->edgeArrowMode() }))
+  : m_edgeModel(std::make_unique<EdgeModel>(settingsProxy()->reversedEdgeDirection(),
+                                            EdgeModel::Style { settingsProxy()->edgeArrowMode() }))
   , m_sourceNode(sourceNode)
   , m_targetNode(targetNode)
   , m_enableAnimations(enableAnimations)
   , m_enableLabels(enableLabels)
-  , m_sourceDot(new EdgeDot(this))
-  , m_targetDot(new EdgeDot(this))
-  , m_label(new EdgeTextEdit(this))
-  , m_condensedLabel(new EdgeTextEdit(this))
-  , m_line(new QGraphicsLineItem(this))
-  , m_arrowheadBeginLeft(new QGraphicsLineItem(this))
-  , m_arrowheadBeginRight(new QGraphicsLineItem(this))
-  , m_arrowheadEndLeft(new QGraphicsLineItem(this))
-  , m_arrowheadEndRight(new QGraphicsLineItem(this))
-  , m_sourceDotSizeAnimation(new QPropertyAnimation(m_sourceDot, "scale", this))
-  , m_targetDotSizeAnimation(new QPropertyAnimation(m_targetDot, "scale", this))
 {
     setAcceptHoverEvents(enableAnimations);
 
-    setGraphicsEffect(GraphicsFactory::createDropShadowEffect(m_settingsProxy->shadowEffect(), false));
-
     setZValue(static_cast<int>(Layers::Edge));
 
     initializeDots();
-
-    if (m_enableLabels) {
-        initializeLabels();
-    }
 }
 
 Edge::Edge(NodeS sourceNode, NodeS targetNode, bool enableAnimations, bool enableLabel)
@@ -96,9 +169,20 @@ Edge::Edge(EdgeCR other)
     copyData(other);
 }
 
+Edge::Edge(const EdgeModel & model, NodeP sourceNode, NodeP targetNode)
+  : Edge(sourceNode, targetNode)
+{
+    *m_edgeModel = model;
+    m_penDirty = true;
+
+    setText(model.text); // Update text to the label component
+}
+
 void Edge::hoverEnterEvent(QGraphicsSceneHoverEvent * event)
 {
-    m_labelVisibilityTimer.stop();
+    if (m_labelVisibilityTimer) {
+        m_labelVisibilityTimer->stop();
+    }
 
     setLabelVisible(true, EdgeTextEdit::VisibilityChangeReason::Focused);
 
@@ -107,7 +191,9 @@ void Edge::hoverEnterEvent(QGraphicsSceneHoverEvent * event)
 
 void Edge::hoverLeaveEvent(QGraphicsSceneHoverEvent * event)
 {
-    m_labelVisibilityTimer.start();
+    if (m_label) {
+        labelVisibilityTimer().start();
+    }
 
     QGraphicsItem::hoverLeaveEvent(event);
 }
@@ -125,12 +211,19 @@ QPen Edge::buildPen(bool ignoreDashSetting) const
 void Edge::copyData(EdgeCR other)
 {
     *m_edgeModel = *other.m_edgeModel;
+    m_penDirty = true;
 
     setText(other.m_edgeModel->text); // Update text to the label component
 }
 
 void Edge::changeFont(const QFont & font)
 {
+    // Applied also to the labels created later
+    m_labelFont = font;
+    if (!m_label) {
+        return;
+    }
+
     // Handle size and family separately to maintain backwards compatibility
     QFont newFont { font };
     if (m_label->font().pointSize() >= 0) {
@@ -145,16 +238,57 @@ bool Edge::dashedLine() const
     return m_edgeModel->style.dashedLine;
 }
 
-void Edge::enableShadowEffect(bool enable)
+bool Edge::isBundled() const
 {
-    GraphicsFactory::updateDropShadowEffect(graphicsEffect(), m_settingsProxy->shadowEffect(), m_selected, !enable);
-    update();
+    return m_bundleTrunk.has_value();
+}
+
+QPen Edge::pen() const
+{
+    return m_penDirty ? buildPen() : m_pen;
+}
+
+void Edge::setBundleTrunk(std::optional<QLineF> trunk)
+{
+    if (trunk == m_bundleTrunk) {
+        return;
+    }
+
+    m_bundleTrunk = trunk;
+    if (m_bundleTrunk && m_enableAnimations) {
+        // The dots would pile up in the trunk
+        EdgeDotAnimator::stop(*m_sourceDot);
+        EdgeDotAnimator::stop(*m_targetDot);
+    }
+
+    updateArrowhead();
+}
+
+std::vector<QLineF> Edge::routeSegments() const
+{
+    if (m_bundleTrunk) {
+        return { *m_bundleTrunk, { m_bundleTrunk->p2(), m_line.p2() } };
+    }
+
+    return { m_line };
+}
+
+const EdgeModel & Edge::model() const
+{
+    return *m_edgeModel;
+}
+
+double Edge::hitWidth() const
+{
+    return std::max(m_edgeModel->style.edgeWidth, MIN_HIT_WIDTH);
 }
 
 void Edge::highlightText(const QString & text)
 {
     if (!TestMode::enabled()) {
-        m_label->selectText(text);
+        if (m_label) {
+            m_label->selectText(text);
+        }
     } else {
         TestMode::logDisabledCode("highlightText");
     }
@@ -168,26 +302,16 @@ QString Edge::id() const
 
 double Edge::length() const
 {
-    return m_line->line().length();
-}
-
-void Edge::initializeDotAnimations()
-{
-    const int animationDurationMs = 2000;
-
-    m_sourceDotSizeAnimation->setDuration(animationDurationMs);
-    m_sourceDotSizeAnimation->setStartValue(1.0);
-    m_sourceDotSizeAnimation->setEndValue(0.0);
-
-    m_targetDotSizeAnimation->setDuration(animationDurationMs);
-    m_targetDotSizeAnimation->setStartValue(1.0);
-    m_targetDotSizeAnimation->setEndValue(0.0);
+    return m_line.length();
 }
 
 void Edge::initializeDots()
 {
     if (m_enableAnimations) {
 
+        m_sourceDot = new EdgeDot(this);
+        m_targetDot = new EdgeDot(this);
+
         const QColor dotColor { 255, 0, 0, 192 };
 
         m_sourceDot->setPen(QPen(dotColor));
@@ -202,8 +326,6 @@ void Edge::initializeDots()
         m_targetDot->setBrush(QBrush(dotColor));
         m_targetDot->setZValue(zValue() + 10);
         m_targetDot->setRect(rect);
-
-        initializeDotAnimations();
     }
 }
 
@@ -212,10 +334,9 @@ void Edge::connectLabel()
     connect(m_label, &TextEdit::textChanged, this, [=](const QString & text) {
         updateLabel();
         m_edgeModel->text = text;
+        emit textChanged(text);
     });
 
-    connect(m_label, &TextEdit::undoPointRequested, this, &Edge::undoPointRequested);
-
     connect(m_label, &EdgeTextEdit::hoverEntered, this, [=] {
         setLabelVisible(true, EdgeTextEdit::VisibilityChangeReason::Focused);
     });
@@ -225,21 +346,34 @@ void Edge::connectLabel()
     });
 }
 
-void Edge::initializeLabelVisibilityTimer()
+QTimer & Edge::labelVisibilityTimer()
 {
-    m_labelVisibilityTimer.setSingleShot(true);
+    if (!m_labelVisibilityTimer) {
+        m_labelVisibilityTimer = std::make_unique<QTimer>();
+        m_labelVisibilityTimer->setSingleShot(true);
 
-    const int labelDurationMs = 2000;
-    m_labelVisibilityTimer.setInterval(labelDurationMs);
+        const int labelDurationMs = 2000;
+        m_labelVisibilityTimer->setInterval(labelDurationMs);
 
-    connect(&m_labelVisibilityTimer, &QTimer::timeout, this, [=] {
-        setLabelVisible(false);
-    });
+        connect(m_labelVisibilityTimer.get(), &QTimer::timeout, this, [=] {
+            setLabelVisible(false);
+        });
+    }
+
+    return *m_labelVisibilityTimer;
 }
 
-void Edge::initializeLabels()
+void Edge::createLabels()
 {
-    const QColor labelColor { 0xff, 0xee, 0xaa };
+    if (m_label || !m_enableLabels) {
+        return;
+    }
+
+    m_label = new EdgeTextEdit(this);
+    m_condensedLabel = new EdgeTextEdit(this);
+    m_labelMetricsCache.valid = false;
+
+    const auto labelColor = Constants::Edge::labelColor();
 
     m_label->setZValue(static_cast<int>(Layers::EdgeLabel));
     m_label->setBackgroundColor(labelColor);
@@ -250,34 +384,48 @@ void Edge::initializeLabels()
     m_condensedLabel->setText(tr("..."));
     m_condensedLabel->setEnabled(false);
 
-    connectLabel();
+    if (m_labelFont) {
+        changeFont(*m_labelFont);
+    }
+    if (m_labelTextSize > 0) {
+        setTextSize(m_labelTextSize);
+    }
+    m_label->setText(m_edgeModel->text);
+    updateLabel();
 
-    initializeLabelVisibilityTimer();
+    connectLabel();
 }
 
-void Edge::setArrowHeadPen(const QPen & pen)
+void Edge::releaseLabels()
 {
-    m_arrowheadBeginLeft->setPen(pen);
-    m_arrowheadBeginLeft->update();
-    m_arrowheadBeginRight->setPen(pen);
-    m_arrowheadBeginRight->update();
+    if (!m_label) {
+        return;
+    }
 
-    m_arrowheadEndLeft->setPen(pen);
-    m_arrowheadEndLeft->update();
-    m_arrowheadEndRight->setPen(pen);
-    m_arrowheadEndRight->update();
+    if (m_labelVisibilityTimer) {
+        m_labelVisibilityTimer->stop();
+    }
+
+    // Deferred, because this can be called from a signal of the label
+    restoreLabelParent();
+    for (auto && label : { m_label, m_condensedLabel }) {
+        label->disconnect(this);
+        label->hide();
+        label->deleteLater();
+    }
+    m_label = nullptr;
+    m_condensedLabel = nullptr;
+    m_labelMetricsCache.valid = false;
 }
 
 bool Edge::isEnoughSpaceForLabel() const
 {
-    return m_label->scene() && !m_label->sceneBoundingRect().intersects(sourceNode().sceneBoundingRect()) && //
-      !m_label->sceneBoundingRect().intersects(targetNode().sceneBoundingRect());
+    return m_label->scene() && !intersectsNodes(labelSceneRect(*m_label, labelMetrics().labelRect));
 }
 
 bool Edge::isEnoughSpaceForCondensedLabel() const
 {
-    return m_condensedLabel->scene() && !m_condensedLabel->sceneBoundingRect().intersects(sourceNode().sceneBoundingRect()) && //
-      !m_condensedLabel->sceneBoundingRect().intersects(targetNode().sceneBoundingRect());
+    return m_condensedLabel->scene() && !intersectsNodes(labelSceneRect(*m_condensedLabel, labelMetrics().condensedLabelRect));
 }
 
 bool Edge::isCondensedLabelTextShoterThanLabelText() const
@@ -285,9 +433,48 @@ bool Edge::isCondensedLabelTextShoterThanLabelText() const
     return m_condensedLabel->text().length() < m_label->text().length();
 }
 
+bool Edge::intersectsNodes(const QRectF & sceneRect) const
+{
+    return sceneRect.intersects(sourceNode().sceneBoundingRect()) || sceneRect.intersects(targetNode().sceneBoundingRect());
+}
+
+const Edge::LabelMetricsCache & Edge::labelMetrics() const
+{
+    // The condensed label shares the font with the label and its text never changes
+    auto && cache = m_labelMetricsCache;
+    if (!cache.valid || cache.text != m_label->text() || cache.font != m_label->font()) {
+        cache.text = m_label->text();
+        cache.font = m_label->font();
+        cache.labelRect = m_label->boundingRect();
+        cache.condensedLabelRect = m_condensedLabel->boundingRect();
+        cache.valid = true;
+    }
+    return cache;
+}
+
+QRectF Edge::labelSceneRect(const EdgeTextEdit & label, const QRectF & labelRect) const
+{
+    // A focused label is moved out of the edge, so it's mapped by itself
+    if (label.parentItem() != this) {
+        return label.sceneBoundingRect();
+    }
+
+    return mapRectToScene(labelRect.translated(labelPosition(labelRect)));
+}
+
+QPointF Edge::labelPosition(const QRectF & labelRect) const
+{
+    return lineCenter() - QPointF(labelRect.width(), labelRect.height()) * 0.5;
+}
+
+QLineF Edge::line() const
+{
+    return { mapToScene(m_line.p1()), mapToScene(m_line.p2()) };
+}
+
 QPointF Edge::lineCenter() const
 {
-    return m_line->line().center();
+    return m_line.center();
 }
 
 void Edge::toggleLabelVisibilityOnGeometryChange()
@@ -301,7 +488,7 @@ void Edge::showLabelWhenFocused()
 {
     m_label->setVisible(true);
     m_label->setParentItem(nullptr);
-    m_label->setGraphicsEffect(GraphicsFactory::createDropShadowEffect(m_settingsProxy->shadowEffect(), false));
+    m_label->setGraphicsEffect(GraphicsFactory::createDropShadowEffect(settingsProxy()->snapshot()->shadowEffect, false));
     m_condensedLabel->setVisible(false);
 }
 
@@ -313,6 +500,12 @@ void Edge::showOrHideLabelExplicitly(bool show)
 
 void Edge::hideLabelOnTimeout()
 {
+    // An empty label is only shown for editing
+    if (m_label->text().isEmpty() && !m_label->hasFocus()) {
+        releaseLabels();
+        return;
+    }
+
     if ((m_label->text().isEmpty() || (!m_label->text().isEmpty() && !isEnoughSpaceForLabel())) && !m_label->hasFocus()) {
         m_label->setVisible(false);
         m_condensedLabel->setVisible(isEnoughSpaceForCondensedLabel() && isCondensedLabelTextShoterThanLabelText());
@@ -321,6 +514,16 @@ void Edge::hideLabelOnTimeout()
 
 void Edge::setLabelVisible(bool visible, EdgeTextEdit::VisibilityChangeReason visibilityChangeReason)
 {
+    // Edges without text get labels only when they are about to be edited
+    if (!m_label) {
+        if (visible && visibilityChangeReason == EdgeTextEdit::VisibilityChangeReason::Focused) {
+            createLabels();
+        }
+        if (!m_label) {
+            return;
+        }
+    }
+
     switch (visibilityChangeReason) {
     case EdgeTextEdit::VisibilityChangeReason::AvailableSpaceChanged:
         toggleLabelVisibilityOnGeometryChange();
@@ -344,83 +547,112 @@ void Edge::setLabelVisible(bool visible, EdgeTextEdit::VisibilityChangeReason vi
 void Edge::setEdgeWidth(double edgeWidth)
 {
     m_edgeModel->style.edgeWidth = edgeWidth;
+    m_penDirty = true;
 
-    updateLine();
+    updateStyle();
 }
 
 void Edge::setArrowMode(EdgeModel::ArrowMode arrowMode)
 {
+    const auto changed = m_edgeModel->style.arrowMode != arrowMode;
     m_edgeModel->style.arrowMode = arrowMode;
     if (!TestMode::enabled()) {
         updateLine();
     } else {
         TestMode::logDisabledCode("Update line after arrow mode change");
     }
+    if (changed) {
+        emit styleChanged();
+    }
 }
 
 void Edge::setArrowSize(double arrowSize)
 {
     m_edgeModel->style.arrowSize = arrowSize;
 
-    updateLine();
+    updateStyle();
 }
 
 void Edge::setColor(const QColor & color)
 {
     m_color = color;
+    m_penDirty = true;
 
-    updateLine();
+    updateStyle();
 }
 
 void Edge::setDashedLine(bool enable)
 {
+    const auto changed = m_edgeModel->style.dashedLine != enable;
     m_edgeModel->style.dashedLine = enable;
+    m_penDirty = true;
     if (!TestMode::enabled()) {
         updateLine();
     } else {
         TestMode::logDisabledCode("Set dashed line");
     }
+    if (changed) {
+        emit styleChanged();
+    }
 }
 
 void Edge::setText(const QString & text)
 {
     m_edgeModel->text = text;
-    if (m_enableLabels) {
-        m_label->setText(text);
-        setLabelVisible(!text.isEmpty());
+    if (!text.isEmpty()) {
+        createLabels();
     }
+    if (m_label) {
+        if (text.isEmpty() && !m_label->hasFocus()) {
+            releaseLabels();
+        } else {
+            m_label->setText(text);
+            setLabelVisible(!text.isEmpty());
+        }
+    }
+    emit textChanged(text);
 }
 
 void Edge::setTextSize(int textSize)
 {
-    if (m_enableLabels && textSize > 0) {
-        m_label->setTextSize(textSize);
-        m_condensedLabel->setTextSize(textSize);
+    if (textSize > 0) {
+        m_labelTextSize = textSize;
+        if (m_label) {
+            m_label->setTextSize(textSize);
+            m_condensedLabel->setTextSize(textSize);
+        }
     }
 }
 
 void Edge::setReversed(bool reversed)
 {
+    const auto changed = m_edgeModel->reversed != reversed;
     m_edgeModel->reversed = reversed;
 
     updateArrowhead();
+    if (changed) {
+        emit styleChanged();
+    }
 }
 
 void Edge::setSelected(bool selected)
 {
+    if (m_selected == selected) {
+        return;
+    }
+
     m_selected = selected;
-    GraphicsFactory::updateDropShadowEffect(graphicsEffect(), m_settingsProxy->shadowEffect(), selected);
-    if (m_enableLabels && m_label->parentItem() != this) {
-        GraphicsFactory::updateDropShadowEffect(m_label->graphicsEffect(), m_settingsProxy->shadowEffect(), selected);
+    updateShadow();
+    if (m_label && m_label->parentItem() != this) {
+        GraphicsFactory::updateDropShadowEffect(m_label->graphicsEffect(), settingsProxy()->snapshot()->shadowEffect, selected);
     }
-    update();
 }
 
 void Edge::setShadowEffect(const ShadowEffectParams & params)
 {
-    GraphicsFactory::updateDropShadowEffect(graphicsEffect(), params, m_selected);
-    if (m_enableLabels && m_label->parentItem() != this) {
-        GraphicsFactory::updateDropShadowEffect(m_label->graphicsEffect(), m_settingsProxy->shadowEffect(), m_selected);
+    updateShadow();
+    if (m_label && m_label->parentItem() != this) {
+        GraphicsFactory::updateDropShadowEffect(m_label->graphicsEffect(), params, m_selected);
     }
     update();
 }
@@ -442,25 +674,23 @@ void Edge::updateDoubleArrowhead()
     const double arrowOpening = 150;
 
     const auto reversedEdge = m_edgeModel->reversed;
-    const auto pointBegin = reversedEdge ? m_line->line().p1() : m_line->line().p2();
+    const auto pointBegin = reversedEdge ? m_line.p1() : m_line.p2();
     lineBeginLeft.setP1(pointBegin);
 
-    const auto angleBegin = reversedEdge ? -m_line->line().angle() + 180 : -m_line->line().angle();
+    const auto angleBegin = reversedEdge ? -m_line.angle() + 180 : -m_line.angle();
     const auto angleBeginLeft = qDegreesToRadians(angleBegin + arrowOpening);
     lineBeginLeft.setP2(pointBegin + QPointF(std::cos(angleBeginLeft), std::sin(angleBeginLeft)) * m_edgeModel->style.arrowSize);
     lineBeginRight.setP1(pointBegin);
 
     const auto angleBeginRight = qDegreesToRadians(angleBegin - arrowOpening);
     lineBeginRight.setP2(pointBegin + QPointF(std::cos(angleBeginRight), std::sin(angleBeginRight)) * m_edgeModel->style.arrowSize);
-    const auto pointEnd = reversedEdge ? m_line->line().p2() : m_line->line().p1();
+    const auto pointEnd = reversedEdge ? m_line.p2() : m_line.p1();
     lineEndLeft.setP1(pointEnd);
 
-    m_arrowheadBeginLeft->setLine(lineBeginLeft);
-    m_arrowheadBeginRight->setLine(lineBeginRight);
-    m_arrowheadBeginLeft->show();
-    m_arrowheadBeginRight->show();
+    m_arrowheads.at(0) = lineBeginLeft;
+    m_arrowheads.at(1) = lineBeginRight;
 
-    const auto angleEnd = reversedEdge ? -m_line->line().angle() : -m_line->line().angle() + 180;
+    const auto angleEnd = reversedEdge ? -m_line.angle() : -m_line.angle() + 180;
     const auto angleEndLeft = qDegreesToRadians(angleEnd + arrowOpening);
     lineEndLeft.setP2(pointEnd + QPointF(std::cos(angleEndLeft), std::sin(angleEndLeft)) * m_edgeModel->style.arrowSize);
     lineEndRight.setP1(pointEnd);
@@ -468,19 +698,14 @@ void Edge::updateDoubleArrowhead()
     const auto angleEndRight = qDegreesToRadians(angleEnd - arrowOpening);
     lineEndRight.setP2(pointEnd + QPointF(std::cos(angleEndRight), std::sin(angleEndRight)) * m_edgeModel->style.arrowSize);
 
-    m_arrowheadEndLeft->setLine(lineEndLeft);
-    m_arrowheadEndRight->setLine(lineEndRight);
-    m_arrowheadEndLeft->show();
-    m_arrowheadEndRight->show();
+    m_arrowheads.at(2) = lineEndLeft;
+    m_arrowheads.at(3) = lineEndRight;
+    m_arrowheadCount = 4;
 }
 
 void Edge::updateHiddenArrowhead()
 {
-    m_arrowheadBeginLeft->hide();
-    m_arrowheadBeginRight->hide();
-
-    m_arrowheadEndLeft->hide();
-    m_arrowheadEndRight->hide();
+    m_arrowheadCount = 0;
 }
 
 void Edge::updateSingleArrowhead()
@@ -488,11 +713,11 @@ void Edge::updateSingleArrowhead()
     QLineF lineBeginLeft, lineBeginRight;
 
     const auto reversedEdge = m_edgeModel->reversed;
-    const auto pointBegin = reversedEdge ? m_line->line().p1() : m_line->line().p2();
+    const auto pointBegin = reversedEdge ? m_line.p1() : m_line.p2();
     lineBeginLeft.setP1(pointBegin);
 
     const double arrowOpening = 150;
-    const auto angleBegin = reversedEdge ? -m_line->line().angle() + 180 : -m_line->line().angle();
+    const auto angleBegin = reversedEdge ? -m_line.angle() + 180 : -m_line.angle();
     const auto angleLeft = qDegreesToRadians(angleBegin + arrowOpening);
     lineBeginLeft.setP2(pointBegin + QPointF(std::cos(angleLeft), std::sin(angleLeft)) * m_edgeModel->style.arrowSize);
     lineBeginRight.setP1(pointBegin);
@@ -500,63 +725,112 @@ void Edge::updateSingleArrowhead()
     const auto angleRight = qDegreesToRadians(angleBegin - arrowOpening);
     lineBeginRight.setP2(pointBegin + QPointF(std::cos(angleRight), std::sin(angleRight)) * m_edgeModel->style.arrowSize);
 
-    m_arrowheadBeginLeft->setLine(lineBeginLeft);
-    m_arrowheadBeginRight->setLine(lineBeginRight);
+    m_arrowheads.at(0) = lineBeginLeft;
+    m_arrowheads.at(1) = lineBeginRight;
+    m_arrowheadCount = 2;
+}
 
-    m_arrowheadBeginLeft->show();
-    m_arrowheadBeginRight->show();
+void Edge::updateBundledArrowhead()
+{
+    // Only the arrowhead at the target, as the ones at the source would pile up in the trunk
+    const auto arrowMode = m_edgeModel->style.arrowMode;
+    if (arrowMode == EdgeModel::ArrowMode::Hidden || (arrowMode == EdgeModel::ArrowMode::Single && m_edgeModel->reversed)) {
+        m_arrowheadCount = 0;
+        return;
+    }
 
-    m_arrowheadEndLeft->hide();
-    m_arrowheadEndRight->hide();
+    const QLineF branch { m_bundleTrunk->p2(), m_line.p2() };
+    const double arrowOpening = 150;
+    const auto angle = -branch.angle();
+    const auto angleLeft = qDegreesToRadians(angle + arrowOpening);
+    const auto angleRight = qDegreesToRadians(angle - arrowOpening);
+    m_arrowheads.at(0) = { branch.p2(), branch.p2() + QPointF(std::cos(angleLeft), std::sin(angleLeft)) * m_edgeModel->style.arrowSize };
+    m_arrowheads.at(1) = { branch.p2(), branch.p2() + QPointF(std::cos(angleRight), std::sin(angleRight)) * m_edgeModel->style.arrowSize };
+    m_arrowheadCount = 2;
 }
 
 void Edge::updateArrowhead()
 {
-    setArrowHeadPen(buildPen(true));
+    updatePens();
 
-    switch (m_edgeModel->style.arrowMode) {
-    case EdgeModel::ArrowMode::Single:
-        updateSingleArrowhead();
-        break;
-    case EdgeModel::ArrowMode::Double:
-        updateDoubleArrowhead();
-        break;
-    case EdgeModel::ArrowMode::Hidden:
-        updateHiddenArrowhead();
-        break;
+    if (m_bundleTrunk) {
+        updateBundledArrowhead();
+    } else {
+        switch (m_edgeModel->style.arrowMode) {
+        case EdgeModel::ArrowMode::Single:
+            updateSingleArrowhead();
+            break;
+        case EdgeModel::ArrowMode::Double:
+            updateDoubleArrowhead();
+            break;
+        case EdgeModel::ArrowMode::Hidden:
+            updateHiddenArrowhead();
+            break;
+        }
     }
+
+    updateBoundingRect();
+}
+
+void Edge::updateBoundingRect()
+{
+    QRectF boundingRect = QRectF { m_line.p1(), m_line.p2() }.normalized();
+    if (m_bundleTrunk) {
+        boundingRect |= QRectF { m_bundleTrunk->p1(), m_bundleTrunk->p2() }.normalized();
+    }
+    for (size_t i = 0; i < m_arrowheadCount; i++) {
+        boundingRect |= QRectF { m_arrowheads.at(i).p1(), m_arrowheads.at(i).p2() }.normalized();
+    }
+
+    // The arrowheads or the width may have changed
+    m_shapeCache.reset();
+
+    const auto margin = hitWidth() / 2;
+    boundingRect.adjust(-margin, -margin, margin, margin);
+    if (boundingRect != m_boundingRect) {
+        prepareGeometryChange();
+        m_boundingRect = boundingRect;
+    }
+    update();
 }
 
 void Edge::triggerAnimationOnRelativeConnectionLocationChangeAtSourcePosition()
 {
-    const auto newRelativeSourcePos = m_line->line().p1() - sourceNode().pos();
+    const auto newRelativeSourcePos = m_line.p1() - sourceNode().pos();
     if (m_previousRelativeSourcePos != newRelativeSourcePos) {
         m_previousRelativeSourcePos = newRelativeSourcePos;
-        m_sourceDotSizeAnimation->stop();
-        m_sourceDotSizeAnimation->start();
+        // Nobody would see the animation of an off-screen edge, e.g. when a layout is applied
+        if (inViewport()) {
+            EdgeDotAnimator::start(*m_sourceDot);
+        } else {
+            EdgeDotAnimator::stop(*m_sourceDot);
+        }
     }
 
     // Update location of possibly active animation
-    m_sourceDot->setPos(m_line->line().p1());
+    m_sourceDot->setPos(m_line.p1());
 }
 
 void Edge::triggerAnimationOnRelativeConnectionLocationChangeAtTargetPosition()
 {
     // Trigger new animation if relative connection location has changed
-    const auto newRelativeTargetPos = m_line->line().p2() - targetNode().pos();
+    const auto newRelativeTargetPos = m_line.p2() - targetNode().pos();
     if (m_previousRelativeTargetPos != newRelativeTargetPos) {
         m_previousRelativeTargetPos = newRelativeTargetPos;
-        m_targetDotSizeAnimation->stop();
-        m_targetDotSizeAnimation->start();
+        if (inViewport()) {
+            EdgeDotAnimator::start(*m_targetDot);
+        } else {
+            EdgeDotAnimator::stop(*m_targetDot);
+        }
     }
 
     // Update location of possibly active animation
-    m_targetDot->setPos(m_line->line().p2());
+    m_targetDot->setPos(m_line.p2());
 }
 
 void Edge::updateDots()
 {
-    if (m_enableAnimations) {
+    if (m_enableAnimations && !m_bundleTrunk) {
         triggerAnimationOnRelativeConnectionLocationChangeAtSourcePosition();
         triggerAnimationOnRelativeConnectionLocationChangeAtTargetPosition();
     }
@@ -564,8 +838,9 @@ void Edge::updateDots()
 
 void Edge::updateLabel(LabelUpdateReason lur)
 {
-    m_label->setPos(lineCenter() - QPointF(m_label->boundingRect().width(), m_label->boundingRect().height()) * 0.5);
-    m_condensedLabel->setPos(lineCenter() - QPointF(m_condensedLabel->boundingRect().width(), m_condensedLabel->boundingRect().height()) * 0.5);
+    auto && metrics = labelMetrics();
+    m_label->setPos(labelPosition(metrics.labelRect));
+    m_condensedLabel->setPos(labelPosition(metrics.condensedLabelRect));
     // Toggle visibility according to space available if geometry changed
     if (lur == LabelUpdateReason::EdgeGeometryChanged) {
         setLabelVisible(m_label->isVisible(), EdgeTextEdit::VisibilityChangeReason::AvailableSpaceChanged);
@@ -584,10 +859,84 @@ void Edge::setSourceNode(NodeR sourceNode)
 
 void Edge::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget)
 {
-    // Nothing to do as Edge is just a composite object
-    Q_UNUSED(painter)
     Q_UNUSED(option)
     Q_UNUSED(widget)
+
+    // The geometry can't change while painting, so a style change is applied right after this paint
+    if (m_styleDirty) {
+        m_styleDirty = false;
+        QMetaObject::invokeMethod(this, "updateLine", Qt::QueuedConnection);
+    }
+
+    const Profiler::ScopedTimer timer { Profiler::Section::EdgePaint };
+
+    if (m_bundleTrunk) {
+        // The bundle has painted the line already
+        if (m_selected) {
+            const auto segments = routeSegments();
+            painter->setPen(m_pen);
+            painter->drawLines(segments.data(), static_cast<int>(segments.size()));
+        }
+        if (m_arrowheadCount && LevelOfDetail::tier(*painter) == LevelOfDetail::Tier::Full) {
+            painter->setPen(m_arrowheadPen);
+            painter->drawLines(m_arrowheads.data(), static_cast<int>(m_arrowheadCount));
+        }
+        return;
+    }
+
+    switch (LevelOfDetail::tier(*painter)) {
+    case LevelOfDetail::Tier::Full:
+        painter->setPen(m_pen);
+        painter->drawLine(m_line);
+        if (m_arrowheadCount) {
+            painter->setPen(m_arrowheadPen);
+            painter->drawLines(m_arrowheads.data(), static_cast<int>(m_arrowheadCount));
+        }
+        break;
+    case LevelOfDetail::Tier::Reduced:
+        painter->setPen(m_pen);
+        painter->drawLine(m_line);
+        break;
+    case LevelOfDetail::Tier::Minimal:
+        // Zero width makes a cosmetic one pixel pen
+        painter->setRenderHint(QPainter::Antialiasing, false);
+        painter->setPen(QPen { m_pen.color(), 0 });
+        painter->drawLine(m_line);
+        break;
+    }
+}
+
+QPainterPath Edge::shape() const
+{
+    if (m_shapeCache) {
+        return *m_shapeCache;
+    }
+
+    QPainterPath path;
+    if (m_bundleTrunk) {
+        path.moveTo(m_bundleTrunk->p1());
+        path.lineTo(m_bundleTrunk->p2());
+    } else {
+        path.moveTo(m_line.p1());
+    }
+    path.lineTo(m_line.p2());
+    for (size_t i = 0; i < m_arrowheadCount; i++) {
+        path.moveTo(m_arrowheads.at(i).p1());
+        path.lineTo(m_arrowheads.at(i).p2());
+    }
+
+    QPainterPathStroker stroker;
+    stroker.setWidth(hitWidth());
+    stroker.setCapStyle(Qt::RoundCap);
+    m_shapeCache = stroker.createStroke(path);
+    return *m_shapeCache;
+}
+
+void Edge::prewarmCaches() const
+{
+    if (m_label) {
+        static_cast<void>(labelMetrics());
+    }
 }
 
 void Edge::removeFromScene()
@@ -599,6 +948,21 @@ void Edge::removeFromScene()
     }
 }
 
+QVariant Edge::itemChange(GraphicsItemChange change, const QVariant & value)
+{
+    // Keep the edge registry of the editor scene in sync so that EditorScene::hasEdge() doesn't need to scan the items
+    if (change == ItemSceneChange) {
+        if (const auto oldScene = dynamic_cast<EditorScene *>(scene())) {
+            oldScene->unregisterEdge(*this);
+        }
+        if (const auto newScene = dynamic_cast<EditorScene *>(value.value<QGraphicsScene *>()); newScene && m_sourceNode && m_targetNode) {
+            newScene->registerEdge(*this);
+        }
+    }
+
+    return SceneItemBase::itemChange(change, value);
+}
+
 bool Edge::reversed() const
 {
     return m_edgeModel->reversed;
@@ -606,7 +970,9 @@ bool Edge::reversed() const
 
 void Edge::restoreLabelParent()
 {
-    m_label->setParentItem(this);
+    if (m_label) {
+        m_label->setParentItem(this);
+    }
 }
 
 bool Edge::selected() const
@@ -619,9 +985,44 @@ EdgeModel::ArrowMode Edge::arrowMode() const
     return m_edgeModel->style.arrowMode;
 }
 
+int Edge::type() const
+{
+    return Type;
+}
+
 QRectF Edge::boundingRect() const
 {
-    return m_line->boundingRect();
+    return m_boundingRect;
+}
+
+bool Edge::collidesWithPath(const QPainterPath & path, Qt::ItemSelectionMode mode) const
+{
+    const auto rect = pathAsRect(path);
+    if (!rect || (mode != Qt::IntersectsItemShape && mode != Qt::ContainsItemShape)) {
+        return SceneItemBase::collidesWithPath(path, mode);
+    }
+
+    const auto halfWidth = hitWidth() / 2;
+    const auto innerRect = rect->adjusted(halfWidth, halfWidth, -halfWidth, -halfWidth);
+    const auto collides = [&](const QLineF & segment) {
+        // The ends of the segments are rounded like in shape()
+        return mode == Qt::ContainsItemShape ? innerRect.contains(segment.p1()) && innerRect.contains(segment.p2()) : distanceBetweenSegmentAndRect(segment, *rect) <= halfWidth;
+    };
+
+    bool collidesAll = true;
+    bool collidesAny = false;
+    for (auto && segment : routeSegments()) {
+        const auto segmentCollides = collides(segment);
+        collidesAll = collidesAll && segmentCollides;
+        collidesAny = collidesAny || segmentCollides;
+    }
+    for (size_t i = 0; i < m_arrowheadCount; i++) {
+        const auto arrowheadCollides = collides(m_arrowheads.at(i));
+        collidesAll = collidesAll && arrowheadCollides;
+        collidesAny = collidesAny || arrowheadCollides;
+    }
+
+    return mode == Qt::ContainsItemShape ? collidesAll : collidesAny;
 }
 
 bool Edge::containsText(const QString & text) const
@@ -636,17 +1037,29 @@ QString Edge::text() const
 
 QRectF Edge::translatedLabelBoundingRect() const
 {
-    return m_label->boundingRect().translated(lineCenter());
+    return m_label ? m_label->boundingRect().translated(lineCenter()) : QRectF { lineCenter(), lineCenter() };
 }
 
 void Edge::unselectText()
 {
-    m_label->unselectText();
+    if (m_label) {
+        m_label->unselectText();
+    }
 }
 
 void Edge::updateLineGeometry()
 {
-    auto && nearestPoints = Node::getNearestEdgePoints(sourceNode(), targetNode());
+    const auto relativePosition = targetNode().pos() - sourceNode().pos();
+    auto && cache = m_nearestEdgePointsCache;
+    if (!cache.valid || cache.relativePosition != relativePosition || cache.sourceSize != sourceNode().size() || cache.targetSize != targetNode().size()) {
+        cache.points = Node::getNearestEdgePoints(sourceNode(), targetNode());
+        cache.relativePosition = relativePosition;
+        cache.sourceSize = sourceNode().size();
+        cache.targetSize = targetNode().size();
+        cache.valid = true;
+    }
+
+    auto && nearestPoints = cache.points;
     const auto pointBegin = nearestPoints.first.location + sourceNode().pos();
 
     QVector2D directionTowardsSourceNode(sourceNode().pos() - pointBegin);
@@ -659,30 +1072,62 @@ void Edge::updateLineGeometry()
     const double widthScale = 0.5;
     const double cornerRadiusScale = 0.3;
 
-    m_line->setLine(QLineF {
+    const auto previousLength = length();
+
+    m_shapeCache.reset();
+
+    m_line = QLineF {
       pointBegin + (nearestPoints.first.isCorner ? cornerRadiusScale * (directionTowardsSourceNode * static_cast<float>(sourceNode().cornerRadius())).toPointF() : QPointF { 0, 0 }),
       pointEnd + (nearestPoints.second.isCorner ? cornerRadiusScale * (directionTowardsTargetNode * static_cast<float>(targetNode().cornerRadius())).toPointF() : QPointF { 0, 0 }) - //
-        (directionTowardsTargetNode * static_cast<float>(m_edgeModel->style.edgeWidth)).toPointF() * widthScale });
+        (directionTowardsTargetNode * static_cast<float>(m_edgeModel->style.edgeWidth)).toPointF() * widthScale };
 
     // Set correct origin for scale animations
     setTransformOriginPoint(lineCenter());
+
+    if (const auto newLength = length(); newLength != previousLength) {
+        emit lengthChanged(newLength);
+    }
+}
+
+void Edge::updatePens()
+{
+    // Building and setting the pens is surprisingly costly when many edges follow a dragged node
+    if (m_penDirty) {
+        m_pen = buildPen();
+        m_arrowheadPen = buildPen(true);
+        m_penDirty = false;
+        update();
+    }
 }
 
 void Edge::updateLine()
 {
-    m_line->setPen(buildPen());
+    m_styleDirty = false;
+
+    updatePens();
+
+    updateShadow();
 
     updateLineGeometry();
 
+    updateShadow();
+
     updateDots();
 
     updateArrowhead();
 
-    if (m_enableLabels) {
+    if (m_label) {
         updateLabel(LabelUpdateReason::EdgeGeometryChanged);
     }
 }
 
+void Edge::updateStyle()
+{
+    // Edges that are not in the scene are updated when they are linked to their nodes again
+    m_styleDirty = true;
+    update();
+}
+
 void Edge::removeSelfFromNodes()
 {
     if (m_sourceNode) {
@@ -693,19 +1138,19 @@ void Edge::removeSelfFromNodes()
     }
 }
 
-void Edge::stopAnimations()
-{
-    m_sourceDotSizeAnimation->stop();
-    m_targetDotSizeAnimation->stop();
-}
-
 Edge::~Edge()
 {
     juzzlin::L(TAG).trace() << "Deleting edge (" << (m_sourceNode ? std::to_string(m_sourceNode->index()) : "(none)") << ", " //
                          << (m_targetNode ? std::to_string(m_targetNode->index()) : "(none)") << ")";
 
+    EdgeUpdateBatch::forget(*this);
+
+    // ~QGraphicsItem() removes the edge from the scene without notifying itemChange()
+    if (const auto editorScene = dynamic_cast<EditorScene *>(scene())) {
+        editorScene->unregisterEdge(*this);
+    }
+
     if (!TestMode::enabled()) {
-        stopAnimations();
         removeSelfFromNodes();
     } else {
         TestMode::logDisabledCode("Edge destructor");
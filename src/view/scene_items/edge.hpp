@@ -16,19 +16,26 @@
 #ifndef EDGE_HPP
 #define EDGE_HPP
 
+#include <QFont>
+#include <QLineF>
+#include <QPainterPath>
+#include <QPen>
+#include <QSizeF>
 #include <QTimer>
 
+#include <array>
 #include <memory>
+#include <optional>
+#include <vector>
 
 #include "../../common/types.hpp"
 #include "edge_model.hpp"
+#include "edge_point.hpp"
 #include "edge_text_edit.hpp"
+#include "item_type.hpp"
 #include "scene_item_base.hpp"
 
-class QFont;
 class QGraphicsEllipseItem;
-class QGraphicsLineItem;
-class QPropertyAnimation;
 
 class ShadowEffectParams;
 
@@ -39,7 +46,8 @@ namespace SceneItems {
 class EdgeDot;
 class Node;
 
-//! A graphic representation of a graph edge between nodes.
+//! A graphic representation of a graph edge between nodes. The line and the arrowheads are painted and hit tested
+//! by the edge itself instead of by child items, so that an edge is a single item in the scene index.
 class Edge : public SceneItemBase
 {
     Q_OBJECT
@@ -59,17 +67,43 @@ public:
     //! Copy edge data and leave connected nodes as nullptr's.
     Edge(EdgeCR other);
 
+    //! Create an edge from plain model data between the given nodes, e.g. from a GraphSnapshot.
+    Edge(const EdgeModel & model, NodeP sourceNode, NodeP targetNode);
+
     virtual ~Edge() override;
 
     EdgeModel::ArrowMode arrowMode() const;
 
+    enum
+    {
+        Type = static_cast<int>(ItemType::Edge)
+    };
+
+    int type() const override;
+
     QRectF boundingRect() const override;
 
+    //! Tests rects, e.g. from a rubber band selection or a click, against the line and the arrowheads directly
+    //! instead of against the stroked shape. Other paths are tested against the cached shape.
+    bool collidesWithPath(const QPainterPath & path, Qt::ItemSelectionMode mode = Qt::IntersectsItemShape) const override;
+
     bool containsText(const QString & text) const;
 
     bool dashedLine() const;
 
-    void enableShadowEffect(bool enable) override;
+    //! \returns True if the line of the edge is painted by a bundle, see setBundleTrunk().
+    bool isBundled() const;
+
+    //! \returns The pen of the line.
+    QPen pen() const;
+
+    //! Routes the edge through the given trunk shared with other edges from the source node, or straight if empty.
+    //! The trunk and the lines from its end to the targets are painted by EdgeBundler as one path, so a bundled
+    //! edge paints only its arrowhead at the target, or the whole route when selected. Hit testing follows the route.
+    void setBundleTrunk(std::optional<QLineF> trunk);
+
+    //! \returns The plain data model of the edge without any graphics state.
+    const EdgeModel & model() const;
 
     void highlightText(const QString & text);
 
@@ -77,10 +111,22 @@ public:
 
     double length() const;
 
+    //! \returns The line between the nodes in scene coordinates.
+    QLineF line() const;
+
     void paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget = nullptr) override;
 
+    //! Measures the labels ahead of painting, see ScenePrewarmer.
+    void prewarmCaches() const;
+
     void removeFromScene() override;
 
+    //! \returns The segments that are painted and hit tested: the line, or the trunk and the branch if bundled.
+    std::vector<QLineF> routeSegments() const;
+
+    //! \returns The line and the arrowheads widened to the edge width. The stroked path is cached until the geometry changes.
+    QPainterPath shape() const override;
+
     bool reversed() const;
 
     void restoreLabelParent();
@@ -133,7 +179,16 @@ public slots:
 
 signals:
 
-    void undoPointRequested();
+    //! Emitted when the line geometry changes the length of the edge.
+    void lengthChanged(double length);
+
+    //! Emitted when the arrow mode, the dashing or the direction changes.
+    void styleChanged();
+
+    void textChanged(const QString & text);
+
+protected:
+    QVariant itemChange(GraphicsItemChange change, const QVariant & value) override;
 
 private:
     QPen buildPen(bool ignoreDashSetting = false) const;
@@ -142,15 +197,16 @@ private:
 
     void copyData(EdgeCR other);
 
-    void hideLabelOnTimeout();
+    double hitWidth() const;
 
-    void initializeDots();
+    //! Creates the labels when the edge gets text or is about to be edited, as most edges never have text.
+    void createLabels();
 
-    void initializeDotAnimations();
+    void hideLabelOnTimeout();
 
-    void initializeLabels();
+    void initializeDots();
 
-    void initializeLabelVisibilityTimer();
+    QTimer & labelVisibilityTimer();
 
     bool isEnoughSpaceForLabel() const;
 
@@ -158,9 +214,19 @@ private:
 
     bool isCondensedLabelTextShoterThanLabelText() const;
 
-    QPointF lineCenter() const;
+    bool intersectsNodes(const QRectF & sceneRect) const;
 
-    void setArrowHeadPen(const QPen & pen);
+    struct LabelMetricsCache;
+
+    const LabelMetricsCache & labelMetrics() const;
+
+    //! \returns The position of a label of the given bounding rect so that it's centered on the line.
+    QPointF labelPosition(const QRectF & labelRect) const;
+
+    //! \returns The scene rect of the label as it will be after updateLabel() without asking the label.
+    QRectF labelSceneRect(const EdgeTextEdit & label, const QRectF & labelRect) const;
+
+    QPointF lineCenter() const;
 
     void setLabelVisible(bool visible, EdgeTextEdit::VisibilityChangeReason visibilityChangeReason = EdgeTextEdit::VisibilityChangeReason::Timeout);
 
@@ -170,9 +236,10 @@ private:
 
     void showOrHideLabelExplicitly(bool show);
 
-    void removeSelfFromNodes();
+    //! Deletes the labels when the text gets cleared and they are not being edited.
+    void releaseLabels();
 
-    void stopAnimations();
+    void removeSelfFromNodes();
 
     void triggerAnimationOnRelativeConnectionLocationChangeAtSourcePosition();
 
@@ -180,16 +247,26 @@ private:
 
     void updateArrowhead();
 
+    void updateBundledArrowhead();
+
+    void updateBoundingRect();
+
     void updateDoubleArrowhead();
 
     void updateHiddenArrowhead();
 
     void updateSingleArrowhead();
 
+    //! Defers the update of the line after a style change until the edge is painted again, so that
+    //! a global style change doesn't lay out the edges outside of the view.
+    void updateStyle();
+
     void updateDots();
 
     void updateLineGeometry();
 
+    void updatePens();
+
     enum class LabelUpdateReason
     {
         Default,
@@ -198,8 +275,6 @@ private:
 
     void updateLabel(LabelUpdateReason lur = LabelUpdateReason::Default);
 
-    SettingsProxyS m_settingsProxy;
-
     std::unique_ptr<EdgeModel> m_edgeModel;
 
     NodeP m_sourceNode = nullptr;
@@ -210,37 +285,90 @@ private:
 
     bool m_selected = false;
 
+    bool m_penDirty = true;
+
+    bool m_styleDirty = false;
+
     bool m_enableAnimations;
 
     bool m_enableLabels;
 
-    EdgeDot * m_sourceDot;
+    //! Created only if animations are enabled.
+    EdgeDot * m_sourceDot = nullptr;
 
-    EdgeDot * m_targetDot;
+    EdgeDot * m_targetDot = nullptr;
 
     QPointF m_previousRelativeSourcePos;
 
     QPointF m_previousRelativeTargetPos;
 
-    EdgeTextEdit * m_label;
+    //! The nearest edge points only depend on the relative node position and the node sizes,
+    //! so they don't need to be searched again when e.g. both nodes are dragged together.
+    struct NearestEdgePointsCache
+    {
+        bool valid = false;
+
+        QPointF relativePosition;
+
+        QSizeF sourceSize;
+
+        QSizeF targetSize;
+
+        std::pair<EdgePoint, EdgePoint> points;
+    };
+
+    NearestEdgePointsCache m_nearestEdgePointsCache;
+
+    //! The label bounding rects only depend on the text and the font, so the label fitting during
+    //! drags doesn't need to lay out the text again.
+    struct LabelMetricsCache
+    {
+        bool valid = false;
+
+        QString text;
+
+        QFont font;
+
+        QRectF labelRect;
+
+        QRectF condensedLabelRect;
+    };
+
+    mutable LabelMetricsCache m_labelMetricsCache;
+
+    //! Created only when needed, see createLabels().
+    EdgeTextEdit * m_label = nullptr;
+
+    EdgeTextEdit * m_condensedLabel = nullptr;
+
+    //! The label font and text size are kept for the labels created later.
+    std::optional<QFont> m_labelFont;
+
+    int m_labelTextSize = 0;
 
-    EdgeTextEdit * m_condensedLabel;
+    //! In item coordinates like the arrowheads.
+    QLineF m_line;
 
-    QGraphicsLineItem * m_line;
+    //! From the source node to the fork of the bundle, see setBundleTrunk().
+    std::optional<QLineF> m_bundleTrunk;
 
-    QGraphicsLineItem * m_arrowheadBeginLeft;
+    //! The segments of the visible arrowheads, two per arrowhead, painted with one drawLines() call.
+    std::array<QLineF, 4> m_arrowheads;
 
-    QGraphicsLineItem * m_arrowheadBeginRight;
+    size_t m_arrowheadCount = 0;
 
-    QGraphicsLineItem * m_arrowheadEndLeft;
+    QRectF m_boundingRect;
 
-    QGraphicsLineItem * m_arrowheadEndRight;
+    //! Built on the first hit test after a geometry change, as most edges are never picked.
+    mutable std::optional<QPainterPath> m_shapeCache;
 
-    QPropertyAnimation * m_sourceDotSizeAnimation;
+    QPen m_pen;
 
-    QPropertyAnimation * m_targetDotSizeAnimation;
+    //! Arrowheads are never dashed.
+    QPen m_arrowheadPen;
 
-    QTimer m_labelVisibilityTimer;
+    //! Created on first hover so that idle edges don't own a timer each.
+    std::unique_ptr<QTimer> m_labelVisibilityTimer;
 };
 
 } // namespace SceneItems
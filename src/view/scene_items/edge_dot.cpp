@@ -14,12 +14,27 @@
 // along with Heimer. If not, see <http://www.gnu.org/licenses/>.
 
 #include "edge_dot.hpp"
+#include "edge_dot_animator.hpp"
+#include "level_of_detail.hpp"
 
 namespace SceneItems {
 
 EdgeDot::EdgeDot(QGraphicsItem * parentItem)
   : QGraphicsEllipseItem(parentItem)
 {
+    setScale(0);
+}
+
+EdgeDot::~EdgeDot()
+{
+    EdgeDotAnimator::forget(*this);
+}
+
+void EdgeDot::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget)
+{
+    if (LevelOfDetail::tier(*painter) == LevelOfDetail::Tier::Full) {
+        QGraphicsEllipseItem::paint(painter, option, widget);
+    }
 }
 
 } // namespace SceneItems
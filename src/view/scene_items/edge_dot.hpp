@@ -17,17 +17,18 @@
 #define EDGE_DOT_HPP
 
 #include <QGraphicsEllipseItem>
-#include <QObject>
 
 namespace SceneItems {
 
-class EdgeDot : public QObject, public QGraphicsEllipseItem
+//! Animated by EdgeDotAnimator, so this doesn't need to be a QObject.
+class EdgeDot : public QGraphicsEllipseItem
 {
-    Q_OBJECT
-    Q_PROPERTY(qreal scale READ scale WRITE setScale)
-
 public:
     explicit EdgeDot(QGraphicsItem * parentItem = nullptr);
+
+    ~EdgeDot() override;
+
+    void paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget = nullptr) override;
 };
 
 } // namespace SceneItems
@@ -0,0 +1,136 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "edge_dot_animator.hpp"
+#include "edge_dot.hpp"
+
+#include "../../common/constants.hpp"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QTimer>
+
+#include <algorithm>
+#include <vector>
+
+namespace SceneItems {
+
+namespace EdgeDotAnimator {
+
+namespace {
+
+// Only used from the GUI thread
+bool animationsEnabled = true;
+
+struct Animation
+{
+    EdgeDot * dot;
+
+    qint64 startTimeMs;
+};
+
+std::vector<Animation> animations;
+
+QElapsedTimer clock;
+
+// Owned by the application so that it's not deleted after the event loop is gone
+QPointer<QTimer> ticker;
+
+void removeAnimation(EdgeDot & dot)
+{
+    animations.erase(std::remove_if(animations.begin(), animations.end(), [&dot](const Animation & animation) {
+                         return animation.dot == &dot;
+                     }),
+                     animations.end());
+}
+
+void tick()
+{
+    const auto durationMs = static_cast<double>(Constants::Edge::dotAnimationDuration().count());
+    const auto nowMs = clock.elapsed();
+    animations.erase(std::remove_if(animations.begin(), animations.end(), [=](const Animation & animation) {
+                         const auto progress = std::min(1.0, static_cast<double>(nowMs - animation.startTimeMs) / durationMs);
+                         animation.dot->setScale(1.0 - progress);
+                         return progress >= 1.0;
+                     }),
+                     animations.end());
+
+    if (animations.empty()) {
+        ticker->stop();
+    }
+}
+
+void startTicker()
+{
+    if (!ticker) {
+        ticker = new QTimer(QCoreApplication::instance());
+        ticker->setInterval(static_cast<int>(Constants::Edge::dotAnimationTickInterval().count()));
+        QObject::connect(ticker, &QTimer::timeout, tick);
+        clock.start();
+    }
+
+    if (!ticker->isActive()) {
+        ticker->start();
+    }
+}
+
+} // namespace
+
+void start(EdgeDot & dot)
+{
+    if (!animationsEnabled) {
+        dot.setScale(0);
+        return;
+    }
+
+    removeAnimation(dot);
+    startTicker();
+    animations.push_back({ &dot, clock.elapsed() });
+    dot.setScale(1.0);
+}
+
+void stop(EdgeDot & dot)
+{
+    removeAnimation(dot);
+    dot.setScale(0);
+}
+
+void forget(EdgeDot & dot)
+{
+    removeAnimation(dot);
+}
+
+bool enabled()
+{
+    return animationsEnabled;
+}
+
+void setEnabled(bool enabled)
+{
+    if (animationsEnabled != enabled) {
+        animationsEnabled = enabled;
+        if (!animationsEnabled) {
+            for (auto && animation : animations) {
+                animation.dot->setScale(0);
+            }
+            animations.clear();
+        }
+    }
+}
+
+} // namespace EdgeDotAnimator
+
+} // namespace SceneItems
@@ -0,0 +1,45 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef EDGE_DOT_ANIMATOR_HPP
+#define EDGE_DOT_ANIMATOR_HPP
+
+namespace SceneItems {
+
+class EdgeDot;
+
+//! Drives the shrink animations of all edge dots from a single timer instead of one
+//! QPropertyAnimation per dot. Only the dots that are actually animating are updated on a tick.
+//! In large scenes the animations can be disabled altogether, in which case dots are just hidden.
+namespace EdgeDotAnimator {
+
+//! Restarts the animation of the given dot, or hides the dot if animations are disabled.
+void start(EdgeDot & dot);
+
+//! Stops a possibly running animation and hides the dot.
+void stop(EdgeDot & dot);
+
+//! Drops the dot without touching it, e.g. when the dot is being deleted.
+void forget(EdgeDot & dot);
+
+bool enabled();
+
+void setEnabled(bool enabled);
+
+} // namespace EdgeDotAnimator
+
+} // namespace SceneItems
+
+#endif // EDGE_DOT_ANIMATOR_HPP
@@ -18,6 +18,7 @@
 
 #include <QString>
 
+#include "../../common/compact_text.hpp"
 #include "../../common/constants.hpp"
 
 namespace SceneItems {
@@ -59,7 +60,7 @@ struct EdgeModel
 
     Style style;
 
-    QString text;
+    CompactText text;
 };
 
 } // namespace SceneItems
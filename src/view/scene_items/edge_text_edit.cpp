@@ -18,6 +18,7 @@
 #include "../../common/constants.hpp"
 #include "edge.hpp"
 #include "graphics_factory.hpp"
+#include "level_of_detail.hpp"
 
 #include <QPainter>
 #include <QStyleOptionGraphicsItem>
@@ -49,6 +50,11 @@ EdgeP EdgeTextEdit::edge() const
     return m_edge;
 }
 
+int EdgeTextEdit::type() const
+{
+    return Type;
+}
+
 QRectF EdgeTextEdit::boundingRect() const
 {
     const int horPadding = 3;
@@ -74,6 +80,10 @@ void EdgeTextEdit::hoverLeaveEvent(QGraphicsSceneHoverEvent * event)
 
 void EdgeTextEdit::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget)
 {
+    if (LevelOfDetail::tier(*painter) != LevelOfDetail::Tier::Full && !hasFocus()) {
+        return;
+    }
+
     TextEdit::paint(painter, option, widget);
 
     // Outline
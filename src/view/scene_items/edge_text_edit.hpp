@@ -17,6 +17,7 @@
 #define EDGE_TEXT_EDIT_HPP
 
 #include "../../common/types.hpp"
+#include "item_type.hpp"
 #include "scene_item_base.hpp"
 #include "text_edit.hpp"
 
@@ -36,6 +37,13 @@ public:
 
     EdgeP edge() const;
 
+    enum
+    {
+        Type = static_cast<int>(ItemType::EdgeTextEdit)
+    };
+
+    int type() const override;
+
     enum class VisibilityChangeReason
     {
         Timeout,
@@ -0,0 +1,72 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "edge_update_batch.hpp"
+#include "edge.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
+
+namespace SceneItems {
+
+namespace {
+
+// Only used from the GUI thread
+int batchDepth = 0;
+
+std::vector<EdgeP> dirtyEdges;
+
+std::unordered_set<EdgeP> dirtyEdgeSet;
+
+} // namespace
+
+EdgeUpdateBatch::EdgeUpdateBatch()
+{
+    batchDepth++;
+}
+
+EdgeUpdateBatch::~EdgeUpdateBatch()
+{
+    if (--batchDepth == 0) {
+        // Take the dirty edges out first so that the flush can't invalidate the iteration
+        std::vector<EdgeP> edges;
+        edges.swap(dirtyEdges);
+        dirtyEdgeSet.clear();
+        for (auto && edge : edges) {
+            edge->updateLine();
+        }
+    }
+}
+
+void EdgeUpdateBatch::updateLine(EdgeR edge)
+{
+    if (batchDepth > 0) {
+        if (dirtyEdgeSet.insert(&edge).second) {
+            dirtyEdges.push_back(&edge);
+        }
+    } else {
+        edge.updateLine();
+    }
+}
+
+void EdgeUpdateBatch::forget(EdgeR edge)
+{
+    if (dirtyEdgeSet.erase(&edge)) {
+        dirtyEdges.erase(std::remove(dirtyEdges.begin(), dirtyEdges.end(), &edge), dirtyEdges.end());
+    }
+}
+
+} // namespace SceneItems
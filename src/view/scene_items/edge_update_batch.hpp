@@ -0,0 +1,46 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef EDGE_UPDATE_BATCH_HPP
+#define EDGE_UPDATE_BATCH_HPP
+
+#include "../../common/types.hpp"
+
+namespace SceneItems {
+
+//! Defers the line updates of edges while nodes are being moved. Every edge that got dirty during
+//! the outermost batch is updated only once when that batch goes out of scope. This way an edge
+//! between two moved nodes isn't updated twice.
+class EdgeUpdateBatch
+{
+public:
+    EdgeUpdateBatch();
+
+    ~EdgeUpdateBatch();
+
+    EdgeUpdateBatch(const EdgeUpdateBatch &) = delete;
+
+    EdgeUpdateBatch & operator=(const EdgeUpdateBatch &) = delete;
+
+    //! Updates the line of the given edge now or, if a batch is active, when the batch ends.
+    static void updateLine(EdgeR edge);
+
+    //! Drops a pending update of an edge that is being deleted.
+    static void forget(EdgeR edge);
+};
+
+} // namespace SceneItems
+
+#endif // EDGE_UPDATE_BATCH_HPP
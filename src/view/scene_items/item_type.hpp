@@ -0,0 +1,36 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ITEM_TYPE_HPP
+#define ITEM_TYPE_HPP
+
+#include <QGraphicsItem>
+
+namespace SceneItems {
+
+//! Values returned by QGraphicsItem::type() so that items found in the scene
+//! can be identified with qgraphicsitem_cast instead of dynamic_cast.
+enum class ItemType
+{
+    Edge = QGraphicsItem::UserType + 1,
+    Node,
+    EdgeTextEdit,
+    NodeHandle,
+    NodeHoverOverlay
+};
+
+} // namespace SceneItems
+
+#endif // ITEM_TYPE_HPP
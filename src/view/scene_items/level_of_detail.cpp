@@ -0,0 +1,75 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "level_of_detail.hpp"
+
+#include "../../common/constants.hpp"
+
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace LevelOfDetail {
+
+namespace {
+
+// Atomic as exports may paint in worker threads
+std::atomic<double> reducedThreshold { Constants::View::reducedLevelOfDetail() };
+
+std::atomic<double> minimalThreshold { Constants::View::minimalLevelOfDetail() };
+
+} // namespace
+
+Tier tier(const QPainter & painter)
+{
+    return tier(QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter.worldTransform()));
+}
+
+Tier tier(double levelOfDetail)
+{
+    if (levelOfDetail < minimalThreshold.load(std::memory_order_relaxed)) {
+        return Tier::Minimal;
+    } else if (levelOfDetail < reducedThreshold.load(std::memory_order_relaxed)) {
+        return Tier::Reduced;
+    }
+    return Tier::Full;
+}
+
+void setThresholds(double reducedLevelOfDetail, double minimalLevelOfDetail)
+{
+    reducedThreshold = reducedLevelOfDetail;
+    minimalThreshold = minimalLevelOfDetail;
+}
+
+double pixelScale(const QPainter & painter)
+{
+    auto scale = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter.worldTransform());
+    if (painter.device()) {
+        scale *= painter.device()->devicePixelRatioF();
+    }
+    return pixelScale(scale);
+}
+
+double pixelScale(double levelOfDetail)
+{
+    const double minScale = 1.0 / 16;
+    const double maxScale = 4;
+    return std::clamp(std::pow(2.0, std::ceil(std::log2(std::max(levelOfDetail, minScale)))), minScale, maxScale);
+}
+
+} // namespace LevelOfDetail
@@ -0,0 +1,52 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef LEVEL_OF_DETAIL_HPP
+#define LEVEL_OF_DETAIL_HPP
+
+class QPainter;
+
+//! Rendering tiers that let scene items skip details that wouldn't be visible when zoomed far out.
+namespace LevelOfDetail {
+
+enum class Tier
+{
+    //! Everything is drawn.
+    Full,
+    //! Texts, labels, arrowheads and edge dots are hidden.
+    Reduced,
+    //! Like Reduced, but nodes are flat rects and edges hairlines.
+    Minimal
+};
+
+//! \return The tier for the current world transform of the painter.
+Tier tier(const QPainter & painter);
+
+//! \return The tier for the given level of detail, e.g. the scale of a view that isn't being painted.
+Tier tier(double levelOfDetail);
+
+//! Sets the levels of detail below which the Reduced and the Minimal tiers are used, see PerformanceProfile.
+void setThresholds(double reducedLevelOfDetail, double minimalLevelOfDetail);
+
+//! \return Device pixels per scene unit for the current world transform and device of the painter,
+//! rounded up to a power of two so that caches of pre-rendered content don't change on every zoom step.
+double pixelScale(const QPainter & painter);
+
+//! \return Like pixelScale(const QPainter &) for the given device pixels per scene unit, e.g. of a view that isn't being painted.
+double pixelScale(double levelOfDetail);
+
+} // namespace LevelOfDetail
+
+#endif // LEVEL_OF_DETAIL_HPP
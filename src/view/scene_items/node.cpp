@@ -20,26 +20,37 @@
 #include "../../application/language_service.hpp"
 #include "../../application/service_container.hpp"
 #include "../../application/settings_proxy.hpp"
+#include "../../application/settings_snapshot.hpp"
 #include "../../common/constants.hpp"
+#include "../../common/profiler.hpp"
 #include "../../common/utils.hpp"
 #include "../../domain/image.hpp"
+#include "../../domain/image_decoder.hpp"
+#include "../editor_scene.hpp"
 #include "../shadow_effect_params.hpp"
 #include "edge.hpp"
+#include "edge_update_batch.hpp"
 #include "graphics_factory.hpp"
 #include "layers.hpp"
+#include "level_of_detail.hpp"
+#include "node_hover_overlay.hpp"
 #include "node_model.hpp"
 #include "text_edit.hpp"
+#include "text_size_cache.hpp"
 
 #include "simple_logger.hpp"
 
 #include <QDebug>
 #include <QFont>
+#include <QFontMetricsF>
 #include <QGraphicsEffect>
 #include <QGraphicsScene>
 #include <QGraphicsSceneHoverEvent>
 #include <QImage>
 #include <QPainter>
+#include <QPixmapCache>
 #include <QPen>
+#include <QStyleOptionGraphicsItem>
 #include <QTextCursor>
 #include <QVector2D>
 
@@ -50,16 +61,33 @@ namespace SceneItems {
 
 static const auto TAG = "Node";
 
+namespace {
+
+//! The handles are only shown on the hovered node, so all nodes share one set that moves to the node that shows them.
+//! Like the nodes, the handles are never deleted by the scenes, see EditorScene::removeItems().
+struct HandlePool
+{
+    std::map<NodeHandle::Role, NodeHandle *> handles;
+
+    NodeP owner = nullptr;
+};
+
+HandlePool & handlePool()
+{
+    static HandlePool pool;
+    return pool;
+}
+
+} // namespace
+
 NodeP Node::m_lastHoveredNode = nullptr;
 
 Node::Node()
-  : m_settingsProxy(SC::instance().settingsProxy())
-  , m_nodeModel(std::make_unique<NodeModel>(m_settingsProxy->nodeColor(), m_settingsProxy->nodeTextColor()))
+  : m_nodeModel(std::make_unique<NodeModel>(settingsProxy()->nodeColor(), settingsProxy()->nodeTextColor()))
   , m_textEdit(new TextEdit(this))
 {
     setAcceptHoverEvents(true);
 
-    setGraphicsEffect(GraphicsFactory::createDropShadowEffect(m_settingsProxy->shadowEffect(), false));
 
     m_nodeModel->size = QSize { Constants::Node::minWidth(), Constants::Node::minHeight() };
 
@@ -67,10 +95,6 @@ Node::Node()
 
     createEdgePoints();
 
-    createHandles();
-
-    updateHandlePositions();
-
     initTextField();
 
     setSelected(false);
@@ -80,19 +104,21 @@ Node::Node()
         adjustSize();
     });
 
-    connect(m_textEdit, &TextEdit::undoPointRequested, this, &Node::undoPointRequested);
-
     // Set the background transparent as the TextEdit background will be rendered in Node::paint().
     // The reason for this is that TextEdit's background affects only the area that includes letters
     // and we want to render a larger area.
     m_textEdit->setBackgroundColor({ 0, 0, 0, 0 });
 
     setTextColor(m_nodeModel->textColor);
+
+    updateCacheMode();
 }
 
 Node::Node(NodeCR other)
   : Node()
 {
+    setCollapsed(other.m_nodeModel->collapsed);
+
     setColor(other.m_nodeModel->color);
 
     setCornerRadius(other.m_cornerRadius);
@@ -112,6 +138,73 @@ Node::Node(NodeCR other)
     setTextSize(other.m_textSize);
 
     changeFont(other.m_font);
+
+    setUuid(other.m_nodeModel->uuid);
+}
+
+Node::Node(const NodeModel & model)
+  : Node()
+{
+    setCollapsed(model.collapsed);
+
+    setColor(model.color);
+
+    setImageRef(model.imageRef);
+
+    setIndex(model.index);
+
+    setLocation(model.location);
+
+    m_nodeModel->size = model.size;
+
+    setText(model.text);
+
+    setTextColor(model.textColor);
+
+    setUuid(model.uuid);
+}
+
+Node::Node(const NodeModel & model, const QFont & font, int textSize, int cornerRadius)
+  : Node()
+{
+    m_cornerRadius = cornerRadius;
+
+    if (textSize > 0) {
+        m_textSize = textSize;
+    }
+
+    m_font = font;
+    if (!TestMode::enabled()) {
+        // Same as changeFont() and setTextSize() together, but without laying out the text
+        QFont newFont(font);
+        newFont.setPointSize(m_textSize);
+        m_textEdit->setFont(newFont);
+    } else {
+        TestMode::logDisabledCode("set node font");
+    }
+
+    setCollapsed(model.collapsed);
+
+    setColor(model.color);
+
+    setImageRef(model.imageRef);
+
+    setIndex(model.index);
+
+    setLocation(model.location);
+
+    m_nodeModel->size = model.size;
+
+    if (!model.text.isEmpty()) {
+        setText(model.text);
+    } else if (!TestMode::enabled()) {
+        // The style setters would resize also an empty node
+        adjustSize();
+    }
+
+    setTextColor(model.textColor);
+
+    setUuid(model.uuid);
 }
 
 void Node::addGraphicsEdge(EdgeR edge)
@@ -143,13 +236,23 @@ void Node::removeFromScene()
     }
 }
 
+NodeHoverOverlay * Node::hoverOverlay() const
+{
+    const auto editorScene = dynamic_cast<EditorScene *>(scene());
+    return editorScene ? &editorScene->nodeHoverOverlay() : nullptr;
+}
+
 void Node::raiseBody()
 {
     const auto currentSizeRatio = SC::instance().applicationService()->normalizedSizeInView(boundingRect()).width();
     const auto targetSizeRatio = 0.1;
     const auto targetScale = currentSizeRatio < targetSizeRatio ? targetSizeRatio / currentSizeRatio : 1.1;
     raiseWithAnimation(targetScale);
-    setZValue(static_cast<int>(Layers::Last) + static_cast<int>(Layers::Node));
+
+    // Raising the node itself would make the scene sort all its items again
+    if (const auto overlay = hoverOverlay()) {
+        overlay->setNode(this);
+    }
 }
 
 void Node::raiseHandles()
@@ -172,15 +275,20 @@ void Node::removeHandles()
 
 void Node::adjustSize()
 {
+    updateShadow();
+
     prepareGeometryChange();
 
+    const auto textSize = textEditSize();
     const auto newSize = QSize {
-        std::max(Constants::Node::minWidth(), static_cast<int>(m_textEdit->boundingRect().width() + m_contentPadding * 2)),
-        std::max(Constants::Node::minHeight(), static_cast<int>(m_textEdit->boundingRect().height() + m_contentPadding * 2))
+        std::max(Constants::Node::minWidth(), static_cast<int>(textSize.width() + m_contentPadding * 2)),
+        std::max(Constants::Node::minHeight(), static_cast<int>(textSize.height() + m_contentPadding * 2))
     };
 
     m_nodeModel->size = newSize;
 
+    emit placementChanged();
+
     createEdgePoints();
 
     updateEdgeLines();
@@ -189,9 +297,16 @@ void Node::adjustSize()
 
     initTextField();
 
+    updateShadow();
+
     update();
 }
 
+int Node::type() const
+{
+    return Type;
+}
+
 QRectF Node::boundingRect() const
 {
     const auto size = m_nodeModel->size * targetScale();
@@ -232,15 +347,46 @@ void Node::createEdgePoints()
     };
 }
 
-void Node::createHandles()
+void Node::acquireHandles()
 {
-    m_handles[NodeHandle::Role::ConnectOrCreate] = new NodeHandle(*this, NodeHandle::Role::ConnectOrCreate, m_handleRadius);
+    auto && pool = handlePool();
+    if (pool.owner && pool.owner != this) {
+        pool.owner->releaseHandles();
+    }
 
-    m_handles[NodeHandle::Role::NodeColor] = new NodeHandle(*this, NodeHandle::Role::NodeColor, m_handleRadiusSmall);
+    const std::map<NodeHandle::Role, int> radii = {
+        { NodeHandle::Role::ConnectOrCreate, m_handleRadius },
+        { NodeHandle::Role::NodeColor, m_handleRadiusSmall },
+        { NodeHandle::Role::TextColor, m_handleRadiusSmall },
+        { NodeHandle::Role::Move, m_handleRadiusMedium }
+    };
 
-    m_handles[NodeHandle::Role::TextColor] = new NodeHandle(*this, NodeHandle::Role::TextColor, m_handleRadiusSmall);
+    for (auto && [role, radius] : radii) {
+        auto && handle = pool.handles[role];
+        if (handle) {
+            handle->setParentNode(*this);
+        } else {
+            handle = new NodeHandle(*this, role, radius);
+        }
+        m_handles[role] = handle;
+    }
 
-    m_handles[NodeHandle::Role::Move] = new NodeHandle(*this, NodeHandle::Role::Move, m_handleRadiusMedium);
+    pool.owner = this;
+}
+
+void Node::releaseHandles()
+{
+    // Hidden at once, because the handles may be shown on another node or outlive this node
+    for (auto && [role, handle] : m_handles) {
+        handle->setVisible(false);
+        handle->hide();
+    }
+
+    m_handles.clear();
+
+    if (auto && pool = handlePool(); pool.owner == this) {
+        pool.owner = nullptr;
+    }
 }
 
 QRectF Node::expandedTextEditRect() const
@@ -255,16 +401,55 @@ QRectF Node::expandedTextEditRect() const
 
 inline double getDistance(NodeCR node1, const EdgePoint & point1, NodeCR node2, const EdgePoint & point2)
 {
-    return std::pow(node1.pos().x() + point1.location.x() - node2.pos().x() - point2.location.x(), 2) + //
-      std::pow(node1.pos().y() + point1.location.y() - node2.pos().y() - point2.location.y(), 2);
+    const auto dx = node1.pos().x() + point1.location.x() - node2.pos().x() - point2.location.x();
+    const auto dy = node1.pos().y() + point1.location.y() - node2.pos().y() - point2.location.y();
+    return dx * dx + dy * dy;
+}
+
+//! \return The grid steps (-1, 0 or 1) of the points of both nodes along one axis that are nearest to each other.
+static std::pair<int, int> nearestSteps(double delta, double halfSize1, double halfSize2)
+{
+    std::pair<int, int> bestSteps = { 0, 0 };
+    auto bestDistance = std::abs(delta);
+    // Middle points win ties as they are biased outwards
+    for (int step1 = -1; step1 <= 1; step1++) {
+        for (int step2 = -1; step2 <= 1; step2++) {
+            if (const auto distance = std::abs(delta + step2 * halfSize2 - step1 * halfSize1); distance < bestDistance) {
+                bestDistance = distance;
+                bestSteps = { step1, step2 };
+            }
+        }
+    }
+    return bestSteps;
+}
+
+//! \return Index in the edge points created by createEdgePoints().
+static size_t edgePointIndex(int xStep, int yStep)
+{
+    static const size_t indices[3][3] = {
+        { 6, 7, 0 },
+        { 5, 0, 1 },
+        { 4, 3, 2 }
+    };
+    return indices[xStep + 1][yStep + 1];
 }
 
 std::pair<EdgePoint, EdgePoint> Node::getNearestEdgePoints(NodeCR node1, NodeCR node2)
 {
+    // The edge points are a 3x3 grid without the center, so the nearest x and y steps can be searched separately.
+    // Take the half sizes from the points as they're not re-created on every size change.
+    const auto delta = node2.pos() - node1.pos();
+    const auto && corner1 = node1.m_edgePoints.at(2).location;
+    const auto && corner2 = node2.m_edgePoints.at(2).location;
+    const auto xSteps = nearestSteps(delta.x(), corner1.x(), corner2.x());
+    const auto ySteps = nearestSteps(delta.y(), corner1.y(), corner2.y());
+    if ((xSteps.first || ySteps.first) && (xSteps.second || ySteps.second)) {
+        return { node1.m_edgePoints.at(edgePointIndex(xSteps.first, ySteps.first)), node2.m_edgePoints.at(edgePointIndex(xSteps.second, ySteps.second)) };
+    }
+
+    // The nearest grid point would be a center, e.g. for overlapping nodes, so fall back to the full search
     double bestDistance = std::numeric_limits<double>::max();
     std::pair<EdgePoint, EdgePoint> bestPair = { EdgePoint(), EdgePoint() };
-
-    // This is O(n^2) but fine as there are not many points
     for (auto && point1 : node1.m_edgePoints) {
         for (auto && point2 : node2.m_edgePoints) {
             if (const auto distance = getDistance(node1, point1, node2, point2); distance < bestDistance) {
@@ -289,9 +474,9 @@ bool Node::pointBeyondHideHandlesDistance(const QPointF & point) const
 
 void Node::hideHandlesWithAnimation()
 {
-    if (m_settingsProxy->raiseNodeOnMouseHover()) {
+    if (settingsProxy()->snapshot()->raiseNodeOnMouseHover) {
+        // The overlay keeps painting the node until it has been lowered, see animationStateChanged()
         lowerWithAnimation();
-        setZValue(static_cast<int>(Layers::Node));
     }
 
     setHandlesVisible(false);
@@ -306,6 +491,15 @@ void Node::highlightText(const QString & text)
     }
 }
 
+void Node::animationStateChanged()
+{
+    updateCacheMode();
+
+    if (const auto overlay = hoverOverlay(); overlay && overlay->node() == this && !isAnimating() && targetScale() == 1.0) {
+        overlay->setNode(nullptr);
+    }
+}
+
 void Node::hoverEnterEvent(QGraphicsSceneHoverEvent * event)
 {
     // This is to more quickly hide the handles of the previous node when
@@ -317,7 +511,7 @@ void Node::hoverEnterEvent(QGraphicsSceneHoverEvent * event)
 
     setHandlesVisible(true);
 
-    if (m_settingsProxy->raiseNodeOnMouseHover()) {
+    if (settingsProxy()->snapshot()->raiseNodeOnMouseHover) {
         raiseBody();
         raiseHandles();
         updateHandlePositions();
@@ -330,7 +524,7 @@ void Node::hoverMoveEvent(QGraphicsSceneHoverEvent * event)
 {
     setHandlesVisible(true);
 
-    if (m_settingsProxy->raiseNodeOnMouseHover()) {
+    if (settingsProxy()->snapshot()->raiseNodeOnMouseHover) {
         raiseHandles();
         updateHandlePositions();
     }
@@ -349,6 +543,39 @@ void Node::mousePressEvent(QGraphicsSceneMouseEvent * event)
     }
 }
 
+QSizeF Node::textEditSize() const
+{
+    if (TestMode::enabled()) {
+        return m_textEdit->boundingRect().size();
+    }
+
+    // The bounding rect of the text edit lays out the whole document
+    const auto text = m_textEdit->text();
+    const auto font = m_textEdit->font();
+    const auto textWidth = m_textEdit->textWidth();
+    if (const auto size = TextSizeCache::find(text, font, textWidth); size.has_value()) {
+        return *size;
+    }
+
+    const auto size = m_textEdit->boundingRect().size();
+    TextSizeCache::insert(text, font, textWidth, size);
+    return size;
+}
+
+bool Node::isCacheableAt(const QPainter & painter) const
+{
+    if (LevelOfDetail::tier(painter) == LevelOfDetail::Tier::Minimal) {
+        return false;
+    }
+
+    auto scale = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter.worldTransform());
+    if (painter.device()) {
+        scale *= painter.device()->devicePixelRatioF();
+    }
+    const auto size = boundingRect().size() * scale;
+    return size.width() * size.height() <= Constants::Node::maxCachedPixelArea();
+}
+
 void Node::initTextField()
 {
     if (!TestMode::enabled()) {
@@ -362,64 +589,147 @@ void Node::initTextField()
 
 void Node::addHandlesToScene()
 {
-    for (auto && handle : m_handles) {
-        if (!handle.second->scene())
-            scene()->addItem(handle.second);
+    // The handles may still be in the scene of the node that had them before
+    for (auto && [role, handle] : m_handles) {
+        if (handle->scene() != scene()) {
+            if (handle->scene()) {
+                handle->scene()->removeItem(handle);
+            }
+            if (scene()) {
+                scene()->addItem(handle);
+            }
+        }
     }
 }
 
-QBrush Node::scaledBackgroundPixmapBrush() const
+QString Node::backgroundPixmapCacheKey(double pixelScale) const
 {
     const auto size = m_nodeModel->size;
-    const auto pixmapAspect = static_cast<double>(m_pixmap.width()) / m_pixmap.height();
-    if (const auto nodeAspect = size.width() / size.height(); nodeAspect > 1.0) {
-        if (pixmapAspect > nodeAspect) {
-            return QBrush { m_pixmap.scaledToHeight(static_cast<int>(size.height())) };
+    return QString { "heimer_node_background_%1_%2x%3_%4_%5" }
+      .arg(m_imageCacheKey)
+      .arg(static_cast<int>(size.width()))
+      .arg(static_cast<int>(size.height()))
+      .arg(m_cornerRadius)
+      .arg(pixelScale);
+}
+
+QBrush Node::scaledBackgroundImageBrush(QSizeF pixelSize) const
+{
+    // Scale down from the smallest level that still covers the node instead of the full resolution image
+    const auto image = m_image.level(pixelSize.toSize());
+    if (image.isNull()) {
+        return QBrush { m_nodeModel->color };
+    }
+
+    const auto imageAspect = static_cast<double>(image.width()) / image.height();
+    if (const auto nodeAspect = pixelSize.width() / pixelSize.height(); nodeAspect > 1.0) {
+        if (imageAspect > nodeAspect) {
+            return QBrush { image.scaledToHeight(static_cast<int>(pixelSize.height()), Qt::SmoothTransformation) };
         } else {
-            return QBrush { m_pixmap.scaledToWidth(static_cast<int>(size.width())) };
+            return QBrush { image.scaledToWidth(static_cast<int>(pixelSize.width()), Qt::SmoothTransformation) };
         }
     } else {
-        if (pixmapAspect < nodeAspect) {
-            return QBrush { m_pixmap.scaledToWidth(static_cast<int>(size.width())) };
+        if (imageAspect < nodeAspect) {
+            return QBrush { image.scaledToWidth(static_cast<int>(pixelSize.width()), Qt::SmoothTransformation) };
         } else {
-            return QBrush { m_pixmap.scaledToHeight(static_cast<int>(size.height())) };
+            return QBrush { image.scaledToHeight(static_cast<int>(pixelSize.height()), Qt::SmoothTransformation) };
         }
     }
 }
 
-QPixmap Node::createEmptyBackgroundPixmap() const
+QPixmap Node::createEmptyBackgroundPixmap(double pixelScale) const
 {
-    const auto size = m_nodeModel->size;
-    QPixmap backgroundPixmap(static_cast<int>(size.width()), static_cast<int>(size.height()));
+    const auto size = m_nodeModel->size * pixelScale;
+    QPixmap backgroundPixmap(static_cast<int>(std::ceil(size.width())), static_cast<int>(std::ceil(size.height())));
     backgroundPixmap.fill(Qt::transparent);
     return backgroundPixmap;
 }
 
-void Node::paintPixmapOnEmptyBackgroundPixmap(QPixmap & emptyBackgroundPixmap)
+void Node::paintImageOnEmptyBackgroundPixmap(QPixmap & emptyBackgroundPixmap, double pixelScale)
 {
     QPainter pixmapPainter(&emptyBackgroundPixmap);
+    pixmapPainter.setRenderHint(QPainter::Antialiasing);
     QPainterPath scaledPath;
-    const auto size = m_nodeModel->size;
+    const auto size = m_nodeModel->size * pixelScale;
     const QRectF scaledRect(0, 0, size.width(), size.height());
-    scaledPath.addRoundedRect(scaledRect, m_cornerRadius, m_cornerRadius);
-    pixmapPainter.fillPath(scaledPath, scaledBackgroundPixmapBrush());
+    scaledPath.addRoundedRect(scaledRect, m_cornerRadius * pixelScale, m_cornerRadius * pixelScale);
+    pixmapPainter.fillPath(scaledPath, scaledBackgroundImageBrush(size));
+}
+
+void Node::prewarmCaches(double pixelScale)
+{
+    // The document of the text edit is laid out on its first paint otherwise, even if its size is cached
+    static_cast<void>(m_textEdit->boundingRect());
+
+    if (!m_imageCacheKey) {
+        return;
+    }
+
+    if (!m_image.isDecoded()) {
+        // The pixmap is rendered on paint when the background decoding has finished
+        m_image.requestDecode();
+    } else if (const auto pixelSize = (m_nodeModel->size * pixelScale).toSize(); !m_image.hasLevel(pixelSize)) {
+        m_image.requestLevel(pixelSize);
+    } else if (QPixmap pixmap; !QPixmapCache::find(backgroundPixmapCacheKey(pixelScale), &pixmap)) {
+        pixmap = createEmptyBackgroundPixmap(pixelScale);
+        paintImageOnEmptyBackgroundPixmap(pixmap, pixelScale);
+        QPixmapCache::insert(backgroundPixmapCacheKey(pixelScale), pixmap);
+    }
 }
 
 void Node::paintBackgroundPixmapOnNode(QPainter & painter, const QPixmap & backgroundPixmap)
 {
     const auto size = m_nodeModel->size;
-    const QRectF scaledRect(0, 0, size.width(), size.height());
     const QRectF rect(-size.width() / 2, -size.height() / 2, size.width(), size.height());
-    painter.drawPixmap(rect, backgroundPixmap, scaledRect);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.drawPixmap(rect, backgroundPixmap, QRectF(backgroundPixmap.rect()));
 }
 
 void Node::paintBackgroundWithPixmap(QPainter & painter)
 {
-    auto && backgroundPixmap = createEmptyBackgroundPixmap();
+    // The background is rendered at the resolution it's shown at, rounded to a power of two so that zooming doesn't re-render it constantly.
+    // The key changes with the image, node size, corner radius and resolution, so there's no explicit invalidation.
+    const auto pixelScale = LevelOfDetail::pixelScale(painter);
+    if (const auto key = backgroundPixmapCacheKey(pixelScale); key != m_backgroundPixmapKey) {
+        if (!QPixmapCache::find(key, &m_backgroundPixmap)) {
+            // Only nodes in the exposed area get painted, so images of nodes that are never viewed don't get decoded.
+            // Scenes without a view, e.g. export snapshots, are rendered at once and can't wait for the background decoding.
+            if (!m_image.isDecoded()) {
+                if (scene() && scene()->views().isEmpty()) {
+                    m_image.decoder()->decode();
+                } else {
+                    m_image.requestDecode();
+                    paintBackgroundWithSolidColor(painter);
+                    return;
+                }
+            }
+            // SVG images are rendered for the resolution in the background, and meanwhile the coarser
+            // rendering is scaled up without caching it
+            if (const auto pixelSize = (m_nodeModel->size * pixelScale).toSize(); !m_image.hasLevel(pixelSize)) {
+                if (scene() && scene()->views().isEmpty()) {
+                    m_image.decoder()->renderLevel(pixelSize);
+                } else {
+                    m_image.requestLevel(pixelSize);
+                    auto pixmap = createEmptyBackgroundPixmap(pixelScale);
+                    paintImageOnEmptyBackgroundPixmap(pixmap, pixelScale);
+                    paintBackgroundPixmapOnNode(painter, pixmap);
+                    return;
+                }
+            }
+            m_backgroundPixmap = createEmptyBackgroundPixmap(pixelScale);
+            paintImageOnEmptyBackgroundPixmap(m_backgroundPixmap, pixelScale);
+            QPixmapCache::insert(key, m_backgroundPixmap);
+        }
+        m_backgroundPixmapKey = key;
+    }
 
-    paintPixmapOnEmptyBackgroundPixmap(backgroundPixmap);
+    paintBackgroundPixmapOnNode(painter, m_backgroundPixmap);
+}
 
-    paintBackgroundPixmapOnNode(painter, backgroundPixmap);
+void Node::paintBackgroundWithFlatColor(QPainter & painter)
+{
+    const auto size = m_nodeModel->size;
+    painter.fillRect(QRectF { -size.width() / 2, -size.height() / 2, size.width(), size.height() }, m_nodeModel->color);
 }
 
 void Node::paintBackgroundWithSolidColor(QPainter & painter)
@@ -438,43 +748,138 @@ void Node::paintBackground(QPainter & painter)
 {
     painter.setRenderHint(QPainter::Antialiasing);
 
-    if (!m_pixmap.isNull()) {
+    if (m_imageCacheKey) {
         paintBackgroundWithPixmap(painter);
     } else {
         paintBackgroundWithSolidColor(painter);
     }
 }
 
+void Node::paintCollapsedBadge(QPainter & painter)
+{
+    if (!m_nodeModel->collapsed) {
+        return;
+    }
+
+    // Summarizes the folded branch in the bottom right corner
+    const auto badgeText = QString { "+%1" }.arg(m_hiddenDescendantCount);
+    auto font = painter.font();
+    font.setBold(true);
+    const QFontMetricsF metrics { font };
+    const auto height = metrics.height();
+    const auto width = std::max(height, metrics.boundingRect(badgeText).width() + height / 2);
+    const auto size = m_nodeModel->size;
+    const QRectF rect { size.width() / 2 - width - m_contentPadding / 2, size.height() / 2 - height - m_contentPadding / 2, width, height };
+
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(m_nodeModel->textColor);
+    painter.drawRoundedRect(rect, height / 2, height / 2);
+    painter.setPen(m_nodeModel->color);
+    painter.setFont(font);
+    painter.drawText(rect, Qt::AlignCenter, badgeText);
+}
+
 void Node::paintPatchForTextEdit(QPainter & painter)
 {
     painter.fillRect(expandedTextEditRect(),
                      Utils::isColorBright(m_nodeModel->color) ? m_textEditBackgroundColorDark : m_textEditBackgroundColorLight);
 }
 
+QVariant Node::itemChange(GraphicsItemChange change, const QVariant & value)
+{
+    if (change == ItemPositionChange) {
+        if (const auto editorScene = dynamic_cast<EditorScene *>(scene())) {
+            editorScene->notifyNodeMove();
+        }
+    }
+
+    if (change == ItemScaleHasChanged) {
+        if (const auto overlay = hoverOverlay(); overlay && overlay->node() == this) {
+            overlay->updateGeometry();
+        }
+    }
+
+    if (change == ItemSceneHasChanged && m_nodeModel->imageRef && m_image.id() != m_nodeModel->imageRef) {
+        if (const auto editorScene = dynamic_cast<EditorScene *>(value.value<QGraphicsScene *>())) {
+            editorScene->requestImage(m_nodeModel->imageRef, *this);
+        }
+    }
+
+    return SceneItemBase::itemChange(change, value);
+}
+
 void Node::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget)
 {
-    Q_UNUSED(widget)
     Q_UNUSED(option)
 
+    const Profiler::ScopedTimer timer { Profiler::Section::NodePaint };
+
+    // Only the paints on a view tell the zoom the node is shown at, not e.g. exports.
+    // The cache mode can't be changed while the node is being painted.
+    if (widget) {
+        if (const auto cacheable = isCacheableAt(*painter); cacheable != m_isCacheableScale) {
+            m_isCacheableScale = cacheable;
+            QMetaObject::invokeMethod(this, "updateCacheMode", Qt::QueuedConnection);
+        }
+    }
+
     addHandlesToScene();
 
     painter->save();
 
-    paintBackground(*painter);
-
-    paintPatchForTextEdit(*painter);
+    switch (LevelOfDetail::tier(*painter)) {
+    case LevelOfDetail::Tier::Full:
+        paintBackground(*painter);
+        paintPatchForTextEdit(*painter);
+        paintCollapsedBadge(*painter);
+        break;
+    case LevelOfDetail::Tier::Reduced:
+        paintBackground(*painter);
+        paintCollapsedBadge(*painter);
+        break;
+    case LevelOfDetail::Tier::Minimal:
+        paintBackgroundWithFlatColor(*painter);
+        break;
+    }
 
     painter->restore();
 }
 
+bool Node::collapsed() const
+{
+    return m_nodeModel->collapsed;
+}
+
+void Node::setCollapsed(bool collapsed)
+{
+    const auto changed = m_nodeModel->collapsed != collapsed;
+    m_nodeModel->collapsed = collapsed;
+    update();
+    if (changed) {
+        emit styleChanged();
+    }
+}
+
+void Node::setHiddenDescendantCount(size_t count)
+{
+    if (m_hiddenDescendantCount != count) {
+        m_hiddenDescendantCount = count;
+        update();
+    }
+}
+
 void Node::setColor(const QColor & color)
 {
+    const auto changed = m_nodeModel->color != color;
     m_nodeModel->color = color;
     if (!TestMode::enabled()) {
         update();
     } else {
         TestMode::logDisabledCode("update() on setColor");
     }
+    if (changed) {
+        emit styleChanged();
+    }
 }
 
 int Node::cornerRadius() const
@@ -495,14 +900,17 @@ void Node::setCornerRadius(int value)
     update();
 }
 
-void Node::enableShadowEffect(bool enable)
-{
-    GraphicsFactory::updateDropShadowEffect(graphicsEffect(), m_settingsProxy->shadowEffect(), m_selected, !enable);
-    update();
-}
-
 void Node::setHandlesVisible(bool visible)
 {
+    // Most nodes are never hovered, so the handles are taken from the shared pool only when they're shown
+    if (visible && m_handles.empty() && index() != -1) {
+        acquireHandles();
+        updateHandlePositions();
+        if (scene()) {
+            addHandlesToScene();
+        }
+    }
+
     for (auto && handle : m_handles) {
         handle.second->setVisible(visible && index() != -1);
     }
@@ -519,6 +927,8 @@ void Node::setLocation(QPointF newLocation)
 
     setPos(newLocation);
 
+    emit placementChanged();
+
     updateEdgeLines();
 
     updateHandlePositions();
@@ -537,19 +947,25 @@ bool Node::selected() const
 
 void Node::setSelected(bool selected)
 {
-    m_selected = selected;
-    GraphicsFactory::updateDropShadowEffect(graphicsEffect(), m_settingsProxy->shadowEffect(), m_selected);
-    update();
+    // The selection only shows in the shadow, so the node itself and its cached pixmap stay as they are
+    if (m_selected != selected) {
+        m_selected = selected;
+        updateShadow();
+    }
 }
 
 void Node::setShadowEffect(const ShadowEffectParams & params)
 {
-    GraphicsFactory::updateDropShadowEffect(graphicsEffect(), params, m_selected);
-    update();
+    Q_UNUSED(params)
+
+    updateShadow();
 }
 
 void Node::setTextInputActive(bool active)
 {
+    m_isTextInputActive = active;
+    updateCacheMode();
+
     m_textEdit->setActive(active);
     if (active) {
         m_textEdit->setFocus();
@@ -568,12 +984,18 @@ QString Node::text() const
     }
 }
 
+QFont Node::textFont() const
+{
+    return m_textEdit->font();
+}
+
 void Node::setText(const QString & text)
 {
     if (text != m_nodeModel->text) {
         m_nodeModel->text = text;
         m_textEdit->setText(text);
         adjustSize();
+        emit textChanged(text);
     }
 }
 
@@ -584,6 +1006,7 @@ QColor Node::textColor() const
 
 void Node::setTextColor(const QColor & color)
 {
+    const auto changed = m_nodeModel->textColor != color;
     m_nodeModel->textColor = color;
     if (!TestMode::enabled()) {
         m_textEdit->setDefaultTextColor(color);
@@ -591,6 +1014,9 @@ void Node::setTextColor(const QColor & color)
     } else {
         TestMode::logDisabledCode("set widget color");
     }
+    if (changed) {
+        emit styleChanged();
+    }
 }
 
 void Node::setTextSize(int textSize)
@@ -610,31 +1036,58 @@ void Node::setTextSize(int textSize)
 
 void Node::setImageRef(size_t imageRef)
 {
+    const auto changed = m_nodeModel->imageRef != imageRef;
     if (imageRef) {
         m_nodeModel->imageRef = imageRef;
-        emit imageRequested(imageRef, *this);
+        // Requested through the scene, so nodes outside of a scene get theirs when added, see itemChange()
+        if (const auto editorScene = dynamic_cast<EditorScene *>(scene())) {
+            editorScene->requestImage(imageRef, *this);
+        }
     } else if (m_nodeModel->imageRef) {
         m_nodeModel->imageRef = imageRef;
         applyImage({});
     }
+    if (changed) {
+        emit styleChanged();
+    }
 }
 
 void Node::applyImage(const Image & image)
 {
-    m_pixmap = QPixmap::fromImage(image.image());
+    m_image = image;
+    m_imageCacheKey = image.cacheKey();
+    disconnect(m_imageDecodedConnection);
+    if (const auto decoder = image.decoder(); decoder) {
+        m_imageDecodedConnection = connect(decoder, &ImageDecoder::finished, this, [this] {
+            update();
+        });
+    }
+    m_backgroundPixmap = {};
+    m_backgroundPixmapKey.clear();
 
     update();
 }
 
+void Node::updateCacheMode()
+{
+    // Editing and scale animations would re-render the cache on every frame
+    const bool cached = m_isCacheableScale && !m_isTextInputActive && !isAnimating();
+    setCacheMode(cached ? DeviceCoordinateCache : NoCache);
+}
+
 void Node::updateEdgeLines()
 {
     for (auto && edge : m_graphicsEdges) {
-        edge->updateLine();
+        EdgeUpdateBatch::updateLine(*edge);
     }
 }
 
 void Node::updateHandlePositions()
 {
+    if (m_handles.empty()) {
+        return;
+    }
+
     const auto height = m_nodeModel->size.height();
 
     const auto width = m_nodeModel->size.width();
@@ -661,6 +1114,8 @@ QSizeF Node::size() const
 void Node::setSize(const QSizeF & size)
 {
     m_nodeModel->size = size;
+
+    emit placementChanged();
 }
 
 size_t Node::imageRef() const
@@ -683,27 +1138,39 @@ int Node::index() const
     return m_nodeModel->index;
 }
 
+const NodeModel & Node::model() const
+{
+    return *m_nodeModel;
+}
+
 void Node::setIndex(int index)
 {
     m_nodeModel->index = index;
 }
 
+void Node::setUuid(const QUuid & uuid)
+{
+    m_nodeModel->uuid = uuid;
+}
+
 void Node::unselectText()
 {
     m_textEdit->unselectText();
 }
 
+QUuid Node::uuid() const
+{
+    return m_nodeModel->uuid;
+}
+
 Node::~Node()
 {
     if (Node::m_lastHoveredNode == this) {
         Node::m_lastHoveredNode = nullptr;
     }
 
-    juzzlin::L(TAG).trace() << "Deleting handles of node id=" << index();
-
-    for (auto && [role, handle] : m_handles) {
-        delete handle;
-    }
+    // The handles are shared, so they are only given back to the pool
+    releaseHandles();
 
     juzzlin::L(TAG).trace() << "Deleting Node id=" << index();
 }
@@ -20,18 +20,21 @@
 #include <QGraphicsItem>
 #include <QImage>
 #include <QObject>
+#include <QUuid>
 
 #include <map>
 #include <vector>
 
+#include "../../common/constants.hpp"
 #include "../../common/types.hpp"
+#include "../../domain/image.hpp"
 
 #include "edge.hpp"
 #include "edge_point.hpp"
 #include "node_handle.hpp"
+#include "item_type.hpp"
 #include "scene_item_base.hpp"
 
-class Image;
 class QGraphicsTextItem;
 class TextEdit;
 
@@ -41,6 +44,7 @@ class SettingsProxy;
 
 namespace SceneItems {
 
+class NodeHoverOverlay;
 struct NodeModel;
 
 //! Freely placeable target node.
@@ -55,6 +59,13 @@ public:
     //! Copy constructor.
     Node(NodeCR other);
 
+    //! Create a node from plain model data, e.g. from a GraphSnapshot.
+    explicit Node(const NodeModel & model);
+
+    //! Create a node from plain model data in the given style. The font is set before the text,
+    //! so that the text is laid out only once instead of again for each style setter.
+    Node(const NodeModel & model, const QFont & font, int textSize, int cornerRadius);
+
     ~Node() override;
 
     void addGraphicsEdge(EdgeR edge);
@@ -63,22 +74,33 @@ public:
 
     void applyImage(const Image & image);
 
+    enum
+    {
+        Type = static_cast<int>(ItemType::Node)
+    };
+
+    int type() const override;
+
     QRectF boundingRect() const override;
 
+    //! \returns True if the descendants of the node are folded away, see setCollapsed().
+    bool collapsed() const;
+
     QColor color() const;
 
     bool containsText(const QString & text) const;
 
     int cornerRadius() const;
 
-    void enableShadowEffect(bool enable) override;
-
     static std::pair<EdgePoint, EdgePoint> getNearestEdgePoints(NodeCR node1, NodeCR node2);
 
     void hideHandlesWithAnimation();
 
     bool pointBeyondHideHandlesDistance(const QPointF & point) const;
 
+    //! Lays out the text and renders the background image at the given pixel scale ahead of painting, see ScenePrewarmer.
+    void prewarmCaches(double pixelScale);
+
     void highlightText(const QString & text);
 
     size_t imageRef() const;
@@ -89,6 +111,9 @@ public:
 
     QPointF location() const;
 
+    //! \returns The plain data model of the node without any graphics state.
+    const NodeModel & model() const;
+
     QRectF placementBoundingRect() const;
 
     void removeGraphicsEdge(EdgeR edge);
@@ -97,6 +122,10 @@ public:
 
     bool selected() const;
 
+    //! Folds the descendants of the node away. The scene membership is handled by ApplicationService and
+    //! the node only shows a badge with the number of hidden nodes, see setHiddenDescendantCount().
+    void setCollapsed(bool collapsed);
+
     void setColor(const QColor & color);
 
     void setCornerRadius(int value);
@@ -105,6 +134,9 @@ public:
 
     void setHandlesVisible(bool visible);
 
+    //! Sets the number of folded nodes shown in the badge of a collapsed node.
+    void setHiddenDescendantCount(size_t count);
+
     void setImageRef(size_t imageRef);
 
     void setIndex(int index);
@@ -125,21 +157,35 @@ public:
 
     void setTextSize(int textSize);
 
+    //! Sets the optional identity of the node for references from outside of the mind map, see NodeModel::uuid.
+    void setUuid(const QUuid & uuid);
+
     QSizeF size() const;
 
     QString text() const;
 
+    //! \returns The font of the text incl. the text size, e.g. for measuring the text with TextSizeCache.
+    QFont textFont() const;
+
     QColor textColor() const;
 
     void unselectText();
 
+    QUuid uuid() const;
+
 signals:
 
-    void imageRequested(size_t imageRef, Node & node);
+    //! Emitted when the location or the size changes the placement bounding rect in scene coordinates.
+    void placementChanged();
 
-    void undoPointRequested();
+    //! Emitted when the color, the text color, the image or the collapsed state changes.
+    void styleChanged();
+
+    void textChanged(const QString & text);
 
 protected:
+    void animationStateChanged() override;
+
     void hoverEnterEvent(QGraphicsSceneHoverEvent * event) override;
 
     void hoverMoveEvent(QGraphicsSceneHoverEvent * event) override;
@@ -148,45 +194,71 @@ protected:
 
     void paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget = nullptr) override;
 
+    //! Fetches the image when the node is added to a scene, e.g. after being outside of the virtualized area.
+    //! Tells the scene about moves, see EditorScene::notifyNodeMove().
+    QVariant itemChange(GraphicsItemChange change, const QVariant & value) override;
+
+private slots:
+    //! Paints the node from a device coordinate cache while it's at rest. The cached pixmaps are kept in
+    //! QPixmapCache, so their total size is bounded by its global limit.
+    void updateCacheMode();
+
 private:
+    //! Takes the shared handles from the node that currently has them.
+    void acquireHandles();
+
     void addHandlesToScene();
 
-    void createEdgePoints();
+    QString backgroundPixmapCacheKey(double pixelScale) const;
 
-    QPixmap createEmptyBackgroundPixmap() const;
+    void createEdgePoints();
 
-    void createHandles();
+    QPixmap createEmptyBackgroundPixmap(double pixelScale) const;
 
     QRectF expandedTextEditRect() const;
 
     void initTextField();
 
+    //! \returns false if the node is drawn so small that it's a flat rect or so large that a cached pixmap would be huge.
+    bool isCacheableAt(const QPainter & painter) const;
+
     void paintBackground(QPainter & painter);
 
     void paintBackgroundPixmapOnNode(QPainter & painter, const QPixmap & emptyBackgroundPixmap);
 
+    void paintBackgroundWithFlatColor(QPainter & painter);
+
     void paintBackgroundWithPixmap(QPainter & painter);
 
     void paintBackgroundWithSolidColor(QPainter & painter);
 
+    void paintCollapsedBadge(QPainter & painter);
+
     void paintPatchForTextEdit(QPainter & painter);
 
-    void paintPixmapOnEmptyBackgroundPixmap(QPixmap & emptyBackgroundPixmap);
+    void paintImageOnEmptyBackgroundPixmap(QPixmap & emptyBackgroundPixmap, double pixelScale);
+
+    //! \returns The overlay of the editor scene the node is in, or nullptr e.g. in export scenes.
+    NodeHoverOverlay * hoverOverlay() const;
 
     void raiseBody();
 
     void raiseHandles();
 
+    //! Hides the shared handles and gives them back to the pool.
+    void releaseHandles();
+
     void removeHandles();
 
-    QBrush scaledBackgroundPixmapBrush() const;
+    QBrush scaledBackgroundImageBrush(QSizeF pixelSize) const;
+
+    //! \returns The size of the laid out text, see TextSizeCache.
+    QSizeF textEditSize() const;
 
     void updateEdgeLines();
 
     void updateHandlePositions();
 
-    SettingsProxyS m_settingsProxy;
-
     std::unique_ptr<NodeModel> m_nodeModel;
 
     int m_cornerRadius = 0;
@@ -197,6 +269,7 @@ private:
 
     bool m_selected = false;
 
+    //! Borrowed from the handles shared by all nodes while this node shows them, see setHandlesVisible().
     std::map<NodeHandle::Role, NodeHandle *> m_handles;
 
     std::vector<EdgeP> m_graphicsEdges;
@@ -207,11 +280,31 @@ private:
 
     QPointF m_currentMousePos;
 
-    QPixmap m_pixmap;
+    //! Shares the decoded image and its downscaled levels with the other nodes showing the same image.
+    Image m_image;
+
+    //! Cache key of the source image so that nodes showing the same image can share the rendered background.
+    qint64 m_imageCacheKey = 0;
+
+    //! Repaints the node when the image requested on paint has been decoded.
+    QMetaObject::Connection m_imageDecodedConnection;
+
+    //! The pre-scaled and pre-clipped background at the resolution it's shown at.
+    //! Also kept in QPixmapCache for other nodes with the same image and size.
+    QPixmap m_backgroundPixmap;
+
+    QString m_backgroundPixmapKey;
+
+    size_t m_hiddenDescendantCount = 0;
+
+    bool m_isTextInputActive = false;
+
+    //! As seen on the latest paint on a view.
+    bool m_isCacheableScale = true;
 
     static NodeP m_lastHoveredNode;
 
-    const int m_contentPadding = 10;
+    const int m_contentPadding = Constants::Node::contentPadding();
 
     const int m_handleRadius = 28;
 
@@ -26,7 +26,7 @@
 namespace SceneItems {
 
 NodeHandle::NodeHandle(NodeR parentNode, NodeHandle::Role role, int radius)
-  : m_parentNode(parentNode)
+  : m_parentNode(&parentNode)
   , m_role(role)
   , m_radius(radius)
   , m_size({ m_radius * 2, m_radius * 2 })
@@ -65,6 +65,11 @@ QString NodeHandle::getToolTipTextByRole(NodeHandle::Role role) const
     return "";
 }
 
+int NodeHandle::type() const
+{
+    return Type;
+}
+
 QRectF NodeHandle::boundingRect() const
 {
     const int margin = 1;
@@ -122,7 +127,7 @@ void NodeHandle::paint(QPainter * painter, const QStyleOptionGraphicsItem * opti
 
 QColor NodeHandle::calculateBackgroundColor() const
 {
-    return { (230 + m_parentNode.color().red()) / 2, (230 + m_parentNode.color().green()) / 2, (230 + m_parentNode.color().blue()) / 2 };
+    return { (230 + m_parentNode->color().red()) / 2, (230 + m_parentNode->color().green()) / 2, (230 + m_parentNode->color().blue()) / 2 };
 }
 
 qreal NodeHandle::relXToX(qreal relX) const
@@ -152,7 +157,7 @@ QPointF NodeHandle::relPToP(const QPointF & relP) const
 
 QPen NodeHandle::getForegroundPen() const
 {
-    QPen pen(Utils::isColorBright(m_parentNode.color()) ? QColor(20, 20, 20) : QColor(255, 255, 255));
+    QPen pen(Utils::isColorBright(m_parentNode->color()) ? QColor(20, 20, 20) : QColor(255, 255, 255));
     pen.setWidthF(2);
     pen.setCapStyle(Qt::PenCapStyle::SquareCap);
     pen.setJoinStyle(Qt::PenJoinStyle::MiterJoin);
@@ -309,7 +314,13 @@ void NodeHandle::drawTextColorHandle(QPainter & painter) const
 
 NodeR NodeHandle::parentNode() const
 {
-    return m_parentNode;
+    return *m_parentNode;
+}
+
+void NodeHandle::setParentNode(NodeR parentNode)
+{
+    m_parentNode = &parentNode;
+    update();
 }
 
 int NodeHandle::radius() const
@@ -325,7 +336,7 @@ NodeHandle::Role NodeHandle::role() const
 void NodeHandle::setVisible(bool visible)
 {
     if (visible) {
-        if (!m_visible && m_parentNode.index() != -1) {
+        if (!m_visible && m_parentNode->index() != -1) {
             QGraphicsItem::setVisible(true);
 
             m_visible = true;
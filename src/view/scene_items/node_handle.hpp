@@ -21,6 +21,7 @@
 #include <QTimer>
 
 #include "../../common/types.hpp"
+#include "item_type.hpp"
 #include "scene_item_base.hpp"
 
 namespace SceneItems {
@@ -44,6 +45,13 @@ public:
 
     virtual ~NodeHandle() override;
 
+    enum
+    {
+        Type = static_cast<int>(ItemType::NodeHandle)
+    };
+
+    int type() const override;
+
     QRectF boundingRect() const override;
 
     void paint(QPainter * painter,
@@ -55,6 +63,9 @@ public:
 
     NodeR parentNode() const;
 
+    //! Moves the handle to another node, see Node::setHandlesVisible().
+    void setParentNode(NodeR parentNode);
+
     int radius() const;
 
 protected:
@@ -105,7 +116,7 @@ private:
 
     const int m_handleVisibilityDuration = 2500;
 
-    NodeR m_parentNode;
+    NodeP m_parentNode;
 
     Role m_role;
 
@@ -0,0 +1,113 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "node_hover_overlay.hpp"
+
+#include "layers.hpp"
+
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+namespace SceneItems {
+
+NodeHoverOverlay::NodeHoverOverlay()
+{
+    setAcceptHoverEvents(true);
+    setAcceptedMouseButtons(Qt::NoButton);
+    setZValue(static_cast<int>(Layers::Last) + static_cast<int>(Layers::Node));
+    hide();
+}
+
+int NodeHoverOverlay::type() const
+{
+    return Type;
+}
+
+QRectF NodeHoverOverlay::boundingRect() const
+{
+    return m_boundingRect;
+}
+
+QPainterPath NodeHoverOverlay::shape() const
+{
+    return m_node ? m_node->sceneTransform().map(m_node->shape()) : QPainterPath {};
+}
+
+void NodeHoverOverlay::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget)
+{
+    // The node may have been removed from the scene, e.g. when it's outside of the virtualized area
+    if (!m_node || m_node->scene() != scene() || !m_node->isVisible()) {
+        return;
+    }
+
+    // The overlay is in scene coordinates like the sceneTransform() of the node
+    painter->save();
+    painter->setTransform(m_node->sceneTransform(), true);
+    paintItem(*painter, *m_node, *option, widget);
+    painter->restore();
+}
+
+void NodeHoverOverlay::paintItem(QPainter & painter, QGraphicsItem & item, const QStyleOptionGraphicsItem & option, QWidget * widget)
+{
+    QStyleOptionGraphicsItem itemOption { option };
+    itemOption.exposedRect = item.boundingRect();
+    item.paint(&painter, &itemOption, widget);
+
+    // The nodes have only a few children, e.g. the text edit
+    for (auto && child : item.childItems()) {
+        if (child->isVisible()) {
+            painter.save();
+            painter.setTransform(child->itemTransform(&item), true);
+            paintItem(painter, *child, option, widget);
+            painter.restore();
+        }
+    }
+}
+
+NodeP NodeHoverOverlay::node() const
+{
+    return m_node.data();
+}
+
+void NodeHoverOverlay::setNode(NodeP node)
+{
+    if (m_node == node) {
+        return;
+    }
+
+    QObject::disconnect(m_placementConnection);
+
+    m_node = node;
+    if (m_node) {
+        m_placementConnection = QObject::connect(m_node.data(), &Node::placementChanged, m_node.data(), [this] {
+            updateGeometry();
+        });
+    }
+
+    updateGeometry();
+    setVisible(!m_node.isNull());
+}
+
+void NodeHoverOverlay::updateGeometry()
+{
+    const auto boundingRect = m_node ? m_node->mapRectToScene(m_node->boundingRect() | m_node->childrenBoundingRect()) : QRectF {};
+    if (boundingRect != m_boundingRect) {
+        prepareGeometryChange();
+        m_boundingRect = boundingRect;
+    }
+    update();
+}
+
+} // namespace SceneItems
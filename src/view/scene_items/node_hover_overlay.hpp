@@ -0,0 +1,73 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef NODE_HOVER_OVERLAY_HPP
+#define NODE_HOVER_OVERLAY_HPP
+
+#include <QGraphicsItem>
+#include <QMetaObject>
+#include <QPointer>
+
+#include "item_type.hpp"
+#include "node.hpp"
+
+namespace SceneItems {
+
+//! Paints a copy of the node raised on mouse hover on top of all the other items, so that raising a node doesn't
+//! change z-values and make the scene sort its items again while the mouse sweeps across a dense mind map.
+//! The overlay stays in the scene at a fixed z-value and is only hidden when no node is raised.
+//! It accepts hover events so that the nodes under the raised one don't get raised, but no mouse buttons,
+//! so that clicks go to the items below. ItemFilter maps the overlay to its node.
+class NodeHoverOverlay : public QGraphicsItem
+{
+public:
+    NodeHoverOverlay();
+
+    enum
+    {
+        Type = static_cast<int>(ItemType::NodeHoverOverlay)
+    };
+
+    int type() const override;
+
+    QRectF boundingRect() const override;
+
+    //! \returns The shape of the node in scene coordinates.
+    QPainterPath shape() const override;
+
+    void paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget = nullptr) override;
+
+    //! \returns The raised node or nullptr.
+    NodeP node() const;
+
+    //! Starts painting the given node on top. nullptr hides the overlay.
+    void setNode(NodeP node);
+
+    //! Follows the node, e.g. while it's moved or its scale is animated.
+    void updateGeometry();
+
+private:
+    void paintItem(QPainter & painter, QGraphicsItem & item, const QStyleOptionGraphicsItem & option, QWidget * widget);
+
+    QPointer<Node> m_node;
+
+    QMetaObject::Connection m_placementConnection;
+
+    QRectF m_boundingRect;
+};
+
+} // namespace SceneItems
+
+#endif // NODE_HOVER_OVERLAY_HPP
@@ -20,6 +20,9 @@
 #include <QPointF>
 #include <QSizeF>
 #include <QString>
+#include <QUuid>
+
+#include "../../common/compact_text.hpp"
 
 namespace SceneItems {
 
@@ -31,6 +34,9 @@ struct NodeModel
     {
     }
 
+    //! The descendants of the node are folded away and not in the scene.
+    bool collapsed = false;
+
     QColor color;
 
     int index = -1;
@@ -43,7 +49,10 @@ struct NodeModel
 
     QColor textColor;
 
-    QString text;
+    CompactText text;
+
+    //! Optional identity for references from outside of the mind map. Unlike the index it stays the same when the file is saved.
+    QUuid uuid;
 };
 
 } // namespace SceneItems
@@ -16,14 +16,26 @@
 #include "scene_item_base.hpp"
 #include "application/language_service.hpp"
 #include "application/service_container.hpp"
+#include "application/settings_proxy.hpp"
+#include "application/settings_snapshot.hpp"
+#include "selection_update_batch.hpp"
+#include "view/shadow_renderer.hpp"
+
+#include <QGraphicsScene>
 
 namespace SceneItems {
 
 SceneItemBase::SceneItemBase()
-  : m_opacityAnimation(this, "opacity")
+  : m_settingsProxy(ServiceContainer::instance().settingsProxy())
+  , m_opacityAnimation(this, "opacity")
   , m_scaleAnimation(this, "scale")
 {
     connect(ServiceContainer::instance().languageService().get(), &LanguageService::activeLanguageChanged, this, &SceneItemBase::retranslate);
+
+    // Shadows are drawn below the items by ShadowRenderer, so moves need to repaint them explicitly
+    setFlag(QGraphicsItem::ItemSendsGeometryChanges);
+
+    connect(&m_scaleAnimation, &QPropertyAnimation::stateChanged, this, &SceneItemBase::animationStateChanged);
 }
 
 void SceneItemBase::appearWithAnimation()
@@ -91,8 +103,43 @@ void SceneItemBase::lowerWithAnimation()
     m_scaleAnimation.start();
 }
 
-void SceneItemBase::enableShadowEffect(bool)
+void SceneItemBase::animationStateChanged()
+{
+}
+
+bool SceneItemBase::isAnimating() const
+{
+    return m_scaleAnimation.state() == QAbstractAnimation::Running;
+}
+
+QVariant SceneItemBase::itemChange(GraphicsItemChange change, const QVariant & value)
 {
+    switch (change) {
+    case ItemPositionChange:
+    case ItemPositionHasChanged:
+    case ItemScaleChange:
+    case ItemScaleHasChanged:
+    case ItemOpacityHasChanged:
+    case ItemVisibleHasChanged:
+        updateShadow();
+        break;
+    default:
+        break;
+    }
+
+    return QGraphicsItem::itemChange(change, value);
+}
+
+void SceneItemBase::updateShadow()
+{
+    if (scene()) {
+        SelectionUpdateBatch::update(*scene(), ShadowRenderer::shadowRect(sceneBoundingRect(), m_settingsProxy->snapshot()->shadowEffect));
+    }
+}
+
+const SettingsProxyS & SceneItemBase::settingsProxy() const
+{
+    return m_settingsProxy;
 }
 
 void SceneItemBase::setAnimationDuration(int durationMs)
@@ -100,6 +147,29 @@ void SceneItemBase::setAnimationDuration(int durationMs)
     m_animationDuration = durationMs;
 }
 
+bool SceneItemBase::inViewport() const
+{
+    return m_inViewport;
+}
+
+void SceneItemBase::setInViewport(bool inViewport)
+{
+    m_inViewport = inViewport;
+}
+
+QColor SceneItemBase::markColor() const
+{
+    return m_markColor;
+}
+
+void SceneItemBase::setMarkColor(const QColor & markColor)
+{
+    if (m_markColor != markColor) {
+        m_markColor = markColor;
+        updateShadow();
+    }
+}
+
 void SceneItemBase::setAnimationOpacity(qreal animationOpacity)
 {
     m_animationOpacity = animationOpacity;
@@ -16,10 +16,13 @@
 #ifndef SCENE_ITEM_BASE_HPP
 #define SCENE_ITEM_BASE_HPP
 
+#include <QColor>
 #include <QGraphicsItem>
 #include <QObject>
 #include <QPropertyAnimation>
 
+#include "../../common/types.hpp"
+
 namespace SceneItems {
 
 class SceneItemBase : public QObject, public QGraphicsItem
@@ -38,8 +41,6 @@ public:
 
     virtual void disappearWithAnimation();
 
-    virtual void enableShadowEffect(bool enable);
-
     virtual void removeFromScene();
 
     virtual void removeFromSceneWithAnimation();
@@ -52,18 +53,50 @@ public:
 
     void setAnimationOpacity(qreal newAnimationOpacity);
 
+    //! \returns false if the item is known to be outside of the viewport. Set by VisibleItemTracker.
+    bool inViewport() const;
+
+    void setInViewport(bool inViewport);
+
+    //! \returns The color of the glow that marks the item, e.g. as changed in a diff, or an invalid color.
+    QColor markColor() const;
+
+    //! Marks the item with a glow of the given color in place of its shadow. An invalid color removes the mark.
+    //! The selection glow takes precedence.
+    void setMarkColor(const QColor & markColor);
+
     qreal targetScale() const;
 
+protected:
+    //! Called when a scale animation starts or stops.
+    virtual void animationStateChanged();
+
+    //! \returns true while the item is being scaled by an animation.
+    bool isAnimating() const;
+
+    QVariant itemChange(GraphicsItemChange change, const QVariant & value) override;
+
+    //! Repaints the area where ShadowRenderer draws the shadow of this item.
+    void updateShadow();
+
+    const SettingsProxyS & settingsProxy() const;
+
 protected slots:
     virtual void retranslate();
 
 private:
+    SettingsProxyS m_settingsProxy;
+
     int m_animationDuration = 75;
 
     qreal m_animationOpacity = 1.0;
 
     qreal m_targetScale = 1.0;
 
+    bool m_inViewport = true;
+
+    QColor m_markColor;
+
     QPropertyAnimation m_opacityAnimation;
 
     QPropertyAnimation m_scaleAnimation;
@@ -0,0 +1,69 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "selection_update_batch.hpp"
+
+#include <QGraphicsScene>
+#include <QPointer>
+
+#include <utility>
+#include <vector>
+
+namespace SceneItems {
+
+namespace {
+
+// Only used from the GUI thread
+int batchDepth = 0;
+
+// There's practically only one scene, but an export scene may also be alive
+std::vector<std::pair<QPointer<QGraphicsScene>, QRectF>> dirtyRects;
+
+} // namespace
+
+SelectionUpdateBatch::SelectionUpdateBatch()
+{
+    batchDepth++;
+}
+
+SelectionUpdateBatch::~SelectionUpdateBatch()
+{
+    if (--batchDepth == 0) {
+        std::vector<std::pair<QPointer<QGraphicsScene>, QRectF>> rects;
+        rects.swap(dirtyRects);
+        for (auto && [scene, rect] : rects) {
+            if (scene) {
+                scene->update(rect);
+            }
+        }
+    }
+}
+
+void SelectionUpdateBatch::update(QGraphicsScene & scene, const QRectF & rect)
+{
+    if (batchDepth > 0) {
+        for (auto && dirtyRect : dirtyRects) {
+            if (dirtyRect.first == &scene) {
+                dirtyRect.second = dirtyRect.second.united(rect);
+                return;
+            }
+        }
+        dirtyRects.push_back({ &scene, rect });
+    } else {
+        scene.update(rect);
+    }
+}
+
+} // namespace SceneItems
@@ -0,0 +1,45 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SELECTION_UPDATE_BATCH_HPP
+#define SELECTION_UPDATE_BATCH_HPP
+
+#include <QRectF>
+
+class QGraphicsScene;
+
+namespace SceneItems {
+
+//! Collects the shadow repaints of items whose selection changes while selecting or deselecting many items
+//! at once, e.g. the result of a rubber band or a search. The united area is repainted with a single scene
+//! update when the outermost batch goes out of scope instead of queueing one scene update per item.
+class SelectionUpdateBatch
+{
+public:
+    SelectionUpdateBatch();
+
+    ~SelectionUpdateBatch();
+
+    SelectionUpdateBatch(const SelectionUpdateBatch &) = delete;
+
+    SelectionUpdateBatch & operator=(const SelectionUpdateBatch &) = delete;
+
+    //! Repaints the given scene area now or, if a batch is active, when the batch ends.
+    static void update(QGraphicsScene & scene, const QRectF & rect);
+};
+
+} // namespace SceneItems
+
+#endif // SELECTION_UPDATE_BATCH_HPP
@@ -16,21 +16,42 @@
 #include "text_edit.hpp"
 
 #include "../../common/test_mode.hpp"
+#include "../editor_scene.hpp"
+#include "level_of_detail.hpp"
 
 #include <QKeyEvent>
 #include <QMouseEvent>
+#include <QPaintEngine>
 #include <QPainter>
+#include <QPixmapCache>
 #include <QStyleOptionGraphicsItem>
 #include <QTextCursor>
 #include <QTextDocument>
 #include <QTextOption>
 
+#include <cmath>
+
 namespace SceneItems {
 
+namespace {
+
+// Only used from the GUI thread
+quint64 cacheIdCounter = 0;
+
+// Larger texts are painted directly as their pixmap would mostly just evict other cached pixmaps
+const int maxCachedPixmapSize = 2048;
+
+} // namespace
+
 TextEdit::TextEdit(QGraphicsItem * parentItem)
   : QGraphicsTextItem(parentItem)
   , m_unselectedFormat(textCursor().charFormat())
+  , m_cacheId(++cacheIdCounter)
 {
+    connect(document(), &QTextDocument::contentsChanged, this, [this] {
+        m_contentRevision++;
+    });
+
     if (!TestMode::enabled()) {
         setTextInteractionFlags(Qt::TextEditorInteraction);
         setDefaultTextColor({ 0, 0, 0 });
@@ -56,12 +77,22 @@ void TextEdit::keyPressEvent(QKeyEvent * event)
 {
     // Don't mix the global undo and text edit's internal undo
     if (!event->matches(QKeySequence::Undo)) {
+        // Keys with text, also erasing and pasting, may change the text. The scene merges the undo points of
+        // consecutive keystrokes, so only the first one after a pause costs a snapshot.
+        if (!event->text().isEmpty()) {
+            if (const auto editorScene = dynamic_cast<EditorScene *>(scene())) {
+                editorScene->requestUndoPoint(*this);
+            }
+        }
         QGraphicsTextItem::keyPressEvent(event);
         const auto oldText = m_text;
         const auto newText = toPlainText();
         if (oldText != newText) {
             m_text = newText;
             emit textChanged(newText);
+            if (const auto editorScene = dynamic_cast<EditorScene *>(scene())) {
+                editorScene->notifyTextEdited();
+            }
         }
     }
 }
@@ -70,7 +101,10 @@ void TextEdit::mousePressEvent(QGraphicsSceneMouseEvent * event)
 {
     unselectText();
 
-    emit undoPointRequested();
+    // Through the scene so that the text edits of the items don't need to be connected one by one
+    if (const auto editorScene = dynamic_cast<EditorScene *>(scene())) {
+        editorScene->requestUndoPoint(*this);
+    }
 
     QGraphicsTextItem::mousePressEvent(event);
 }
@@ -93,6 +127,9 @@ void TextEdit::setText(const QString & text)
         m_text = text;
         if (!TestMode::enabled()) {
             setPlainText(text);
+            // The new document doesn't carry the highlight over
+            m_highlightIndex = -1;
+            m_highlightLength = 0;
         } else {
             TestMode::logDisabledCode("Set TextEdit plain text");
         }
@@ -100,13 +137,82 @@ void TextEdit::setText(const QString & text)
 }
 
 void TextEdit::paint(QPainter * painter, const QStyleOptionGraphicsItem * option, QWidget * widget)
+{
+    // The text would be unreadable anyway, so skip the expensive text layout
+    if (LevelOfDetail::tier(*painter) != LevelOfDetail::Tier::Full && !hasFocus()) {
+        return;
+    }
+
+    if (canPaintFromCache(*painter)) {
+        paintFromCache(*painter, *option, widget);
+    } else {
+        paintText(*painter, *option, widget);
+    }
+}
+
+bool TextEdit::canPaintFromCache(const QPainter & painter) const
+{
+    if (hasFocus() || !painter.paintEngine()) {
+        return false;
+    }
+
+    const auto type = painter.paintEngine()->type();
+    return type == QPaintEngine::Raster || type == QPaintEngine::OpenGL2;
+}
+
+QString TextEdit::pixmapCacheKey(double pixelScale) const
+{
+    // Font and colors are not part of the document contents
+    return QString { "heimer_text_%1_%2_%3_%4_%5_%6" }
+      .arg(m_cacheId)
+      .arg(m_contentRevision)
+      .arg(font().key())
+      .arg(defaultTextColor().rgba())
+      .arg(m_backgroundColor.rgba())
+      .arg(pixelScale);
+}
+
+void TextEdit::paintFromCache(QPainter & painter, const QStyleOptionGraphicsItem & option, QWidget * widget)
+{
+    const auto pixelScale = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter.worldTransform()) * painter.device()->devicePixelRatioF();
+    const auto rect = boundingRect();
+    const QSize pixmapSize { static_cast<int>(std::ceil(rect.width() * pixelScale)), static_cast<int>(std::ceil(rect.height() * pixelScale)) };
+    if (pixmapSize.isEmpty() || pixmapSize.width() > maxCachedPixmapSize || pixmapSize.height() > maxCachedPixmapSize) {
+        paintText(painter, option, widget);
+        return;
+    }
+
+    const auto key = pixmapCacheKey(pixelScale);
+    QPixmap pixmap;
+    if (!QPixmapCache::find(key, &pixmap)) {
+        pixmap = QPixmap { pixmapSize };
+        pixmap.fill(Qt::transparent);
+        QPainter pixmapPainter { &pixmap };
+        pixmapPainter.setRenderHints(painter.renderHints());
+        pixmapPainter.scale(pixelScale, pixelScale);
+        pixmapPainter.translate(-rect.topLeft());
+        auto pixmapOption = option;
+        pixmapOption.rect = rect.toRect();
+        pixmapOption.exposedRect = rect;
+        paintText(pixmapPainter, pixmapOption, widget);
+        pixmapPainter.end();
+        QPixmapCache::insert(key, pixmap);
+    }
+
+    painter.save();
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.drawPixmap(QRectF { rect.topLeft(), QSizeF { pixmapSize } / pixelScale }, pixmap, QRectF { pixmap.rect() });
+    painter.restore();
+}
+
+void TextEdit::paintText(QPainter & painter, const QStyleOptionGraphicsItem & option, QWidget * widget)
 {
     // Remove the HasFocus style state, to prevent the dotted line from being drawn.
-    auto style = const_cast<QStyleOptionGraphicsItem *>(option);
-    style->state &= ~QStyle::State_HasFocus;
+    auto style = option;
+    style.state &= ~QStyle::State_HasFocus;
 
-    painter->fillRect(option->rect, m_backgroundColor);
-    QGraphicsTextItem::paint(painter, style, widget);
+    painter.fillRect(option.rect, m_backgroundColor);
+    QGraphicsTextItem::paint(&painter, &style, widget);
 }
 
 QColor TextEdit::backgroundColor() const
@@ -123,30 +229,46 @@ void TextEdit::setBackgroundColor(const QColor & backgroundColor)
 
 void TextEdit::selectText(const QString & text)
 {
+    const auto index = !text.isEmpty() ? static_cast<int>(this->text().toLower().indexOf(text.toLower())) : -1;
+    if (index < 0) {
+        unselectText();
+        return;
+    }
+
+    // Re-applying the same highlight would just reformat the document and invalidate the cached pixmap
+    const auto length = static_cast<int>(text.length());
+    if (m_highlightIndex == index && m_highlightLength == length) {
+        return;
+    }
+
     unselectText();
     auto cursor(textCursor());
     cursor.clearSelection();
-    if (!text.isEmpty()) {
-        if (const auto index = static_cast<int>(this->text().toLower().indexOf(text.toLower())); index >= 0) {
-            // Customize the text selection color
-            auto format = cursor.charFormat();
-            format.setForeground(Qt::white);
-            format.setBackground(Qt::blue);
-            cursor.setPosition(index);
-            cursor.movePosition(QTextCursor::MoveOperation::Right, QTextCursor::MoveMode::KeepAnchor, static_cast<int>(text.length()));
-            cursor.setCharFormat(format);
-        }
-    }
+    // Customize the text selection color
+    auto format = cursor.charFormat();
+    format.setForeground(Qt::white);
+    format.setBackground(Qt::blue);
+    cursor.setPosition(index);
+    cursor.movePosition(QTextCursor::MoveOperation::Right, QTextCursor::MoveMode::KeepAnchor, length);
+    cursor.setCharFormat(format);
     cursor.clearSelection();
     setTextCursor(cursor);
+    m_highlightIndex = index;
+    m_highlightLength = length;
 }
 
 void TextEdit::unselectText()
 {
+    if (m_highlightIndex < 0) {
+        return;
+    }
+
     auto cursor = textCursor();
     cursor.setPosition(0);
     cursor.movePosition(QTextCursor::MoveOperation::Right, QTextCursor::MoveMode::KeepAnchor, static_cast<int>(this->text().length()));
     cursor.setCharFormat(m_unselectedFormat);
+    m_highlightIndex = -1;
+    m_highlightLength = 0;
 }
 
 void TextEdit::setTextSize(int textSize)
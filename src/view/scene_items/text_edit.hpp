@@ -51,8 +51,6 @@ signals:
 
     void textChanged(QString text);
 
-    void undoPointRequested();
-
 protected:
     virtual bool event(QEvent * event) override;
 
@@ -63,6 +61,16 @@ protected:
     virtual void contextMenuEvent(QGraphicsSceneContextMenuEvent * event) override;
 
 private:
+    //! \return true if the text can be drawn from a cached pixmap, i.e. it's not being edited and
+    //!         the painter rasterizes anyway (unlike e.g. an SVG export).
+    bool canPaintFromCache(const QPainter & painter) const;
+
+    QString pixmapCacheKey(double pixelScale) const;
+
+    void paintFromCache(QPainter & painter, const QStyleOptionGraphicsItem & option, QWidget * widget);
+
+    void paintText(QPainter & painter, const QStyleOptionGraphicsItem & option, QWidget * widget);
+
     double m_maxHeight = 0;
 
     double m_maxWidth = 0;
@@ -74,6 +82,17 @@ private:
     int m_textSize = 0;
 
     QTextCharFormat m_unselectedFormat;
+
+    //! The currently highlighted range of the text, or -1 if nothing is highlighted.
+    int m_highlightIndex = -1;
+
+    int m_highlightLength = 0;
+
+    //! Unique per text edit so that cached pixmaps of deleted items are never reused.
+    quint64 m_cacheId;
+
+    //! Bumped whenever the document changes, which invalidates the cached pixmap.
+    quint64 m_contentRevision = 0;
 };
 
 } // namespace SceneItems
@@ -0,0 +1,169 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "text_size_cache.hpp"
+
+#include "../../application/service_container.hpp"
+#include "../../application/task_pool.hpp"
+#include "../../common/constants.hpp"
+
+#include <QFont>
+#include <QHash>
+#include <QSet>
+#include <QTextDocument>
+
+#include <algorithm>
+#include <list>
+
+namespace SceneItems {
+
+namespace {
+
+// Below this the threads would cost more than the layouts
+const size_t minTextsPerThread = 500;
+
+struct Entry
+{
+    QString key;
+
+    QSizeF size;
+};
+
+// Only used from the GUI thread. The most recently used entry is first.
+std::list<Entry> entries;
+
+QHash<QString, std::list<Entry>::iterator> index;
+
+size_t entryBytes = 0;
+
+// List node, hash node and string header of an entry on top of the key characters
+const size_t entryOverhead = 96;
+
+size_t bytesOf(const Entry & entry)
+{
+    return entryOverhead + static_cast<size_t>(entry.key.size()) * sizeof(QChar);
+}
+
+void removeLast()
+{
+    entryBytes -= bytesOf(entries.back());
+    index.remove(entries.back().key);
+    entries.pop_back();
+}
+
+QString cacheKey(const QString & text, const QFont & font, double textWidth)
+{
+    return font.key() + '\n' + QString::number(textWidth) + '\n' + text;
+}
+
+void evict()
+{
+    while (entries.size() > Constants::Node::textSizeCacheSize()) {
+        removeLast();
+    }
+}
+
+QSizeF layOut(const QString & text, const QFont & font, double textWidth)
+{
+    // The same document settings as in QGraphicsTextItem
+    QTextDocument document;
+    document.setDefaultFont(font);
+    document.setTextWidth(textWidth);
+    document.setPlainText(text);
+    return document.size();
+}
+
+} // namespace
+
+std::optional<QSizeF> TextSizeCache::find(const QString & text, const QFont & font, double textWidth)
+{
+    if (const auto iter = index.find(cacheKey(text, font, textWidth)); iter != index.end()) {
+        entries.splice(entries.begin(), entries, iter.value());
+        return iter.value()->size;
+    }
+    return {};
+}
+
+void TextSizeCache::insert(const QString & text, const QFont & font, double textWidth, QSizeF size)
+{
+    auto key = cacheKey(text, font, textWidth);
+    if (const auto iter = index.find(key); iter != index.end()) {
+        iter.value()->size = size;
+        entries.splice(entries.begin(), entries, iter.value());
+        return;
+    }
+
+    entries.push_front({ key, size });
+    entryBytes += bytesOf(entries.front());
+    index.insert(key, entries.begin());
+    evict();
+}
+
+void TextSizeCache::measure(const std::vector<QString> & texts, const QFont & font, double textWidth)
+{
+    // Duplicates are laid out only once and the texts that wouldn't fit in the cache are left for later
+    std::vector<QString> missing;
+    QSet<QString> seen;
+    for (auto && text : texts) {
+        if (missing.size() >= Constants::Node::textSizeCacheSize()) {
+            break;
+        }
+        if (!seen.contains(text) && !index.contains(cacheKey(text, font, textWidth))) {
+            seen.insert(text);
+            missing.push_back(text);
+        }
+    }
+
+    std::vector<QSizeF> sizes(missing.size());
+    const auto layOutRange = [&](size_t begin, size_t end) {
+        for (auto i = begin; i < end; i++) {
+            sizes[i] = layOut(missing[i], font, textWidth);
+        }
+    };
+
+    SC::instance().taskPool()->parallelFor(missing.size(), minTextsPerThread, layOutRange);
+
+    for (size_t i = 0; i < missing.size(); i++) {
+        insert(missing[i], font, textWidth, sizes[i]);
+    }
+}
+
+void TextSizeCache::clear()
+{
+    index.clear();
+    entries.clear();
+    entryBytes = 0;
+}
+
+size_t TextSizeCache::size()
+{
+    return entries.size();
+}
+
+size_t TextSizeCache::bytes()
+{
+    return entryBytes;
+}
+
+size_t TextSizeCache::trim(size_t bytes)
+{
+    const auto bytesBefore = entryBytes;
+    while (entryBytes > bytes && !entries.empty()) {
+        removeLast();
+    }
+    return bytesBefore - entryBytes;
+}
+
+} // namespace SceneItems
@@ -0,0 +1,59 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TEXT_SIZE_CACHE_HPP
+#define TEXT_SIZE_CACHE_HPP
+
+#include <QSizeF>
+#include <QString>
+
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+class QFont;
+
+namespace SceneItems {
+
+//! Shared LRU of the laid out sizes of node texts, keyed by the text, the font (incl. the size) and the text width.
+//! This way e.g. nodes with the same text and re-applying the same font don't lay out the text document again.
+//! Only used from the GUI thread.
+class TextSizeCache
+{
+public:
+    //! \returns The cached size of the text or nothing if it hasn't been measured.
+    static std::optional<QSizeF> find(const QString & text, const QFont & font, double textWidth);
+
+    static void insert(const QString & text, const QFont & font, double textWidth, QSizeF size);
+
+    //! Lays out the given texts that are not cached yet on worker threads and caches their sizes,
+    //! e.g. before changing the font of all nodes. The sizes match the ones of a TextEdit with the same settings.
+    static void measure(const std::vector<QString> & texts, const QFont & font, double textWidth);
+
+    static void clear();
+
+    static size_t size();
+
+    //! \returns The estimated bytes of the cached keys and sizes.
+    static size_t bytes();
+
+    //! Drops the least recently used entries until at most the given bytes remain, e.g. when memory runs low.
+    //! \returns The estimated bytes given back.
+    static size_t trim(size_t bytes);
+};
+
+} // namespace SceneItems
+
+#endif // TEXT_SIZE_CACHE_HPP
@@ -0,0 +1,201 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "scene_prewarmer.hpp"
+
+#include "../application/gui_job_scheduler.hpp"
+#include "../common/constants.hpp"
+#include "../domain/graph.hpp"
+#include "scene_items/edge.hpp"
+#include "scene_items/node.hpp"
+#include "scene_items/text_size_cache.hpp"
+#include "shadow_renderer.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QCoreApplication>
+#include <QEvent>
+#include <QFont>
+
+#include <algorithm>
+#include <iterator>
+
+using juzzlin::L;
+
+static const auto TAG = "ScenePrewarmer";
+
+ScenePrewarmer::ScenePrewarmer(GraphProvider graphProvider, GuiJobSchedulerS guiJobScheduler)
+  : m_graphProvider(std::move(graphProvider))
+  , m_guiJobScheduler(guiJobScheduler)
+{
+    m_idleTimer.setSingleShot(true);
+    m_idleTimer.setInterval(Constants::View::prewarmIdleDelay());
+    connect(&m_idleTimer, &QTimer::timeout, this, &ScenePrewarmer::resume);
+}
+
+ScenePrewarmer::~ScenePrewarmer()
+{
+    stop();
+}
+
+void ScenePrewarmer::start(QRectF viewportRect, double pixelScale, std::optional<ShadowEffectParams> shadowEffect)
+{
+    stop();
+
+    m_center = viewportRect.center();
+    m_pixelScale = pixelScale;
+    m_shadowEffect = shadowEffect;
+    m_isActive = true;
+
+    // Input events of any widget pause the work, e.g. the keys of the text edits and the wheel of the view
+    QCoreApplication::instance()->installEventFilter(this);
+    m_idleTimer.start();
+}
+
+void ScenePrewarmer::stop()
+{
+    if (m_isActive) {
+        m_isActive = false;
+        m_idleTimer.stop();
+        m_guiJobScheduler->cancel(m_job);
+        m_order.reset();
+        m_position = 0;
+        if (const auto application = QCoreApplication::instance(); application) {
+            application->removeEventFilter(this);
+        }
+    }
+}
+
+bool ScenePrewarmer::isActive() const
+{
+    return m_isActive;
+}
+
+std::vector<int> ScenePrewarmer::warmingOrder(const Graph & graph, QPointF center)
+{
+    std::vector<std::pair<double, int>> distances;
+    distances.reserve(graph.nodeCount());
+    for (auto && node : graph.nodes()) {
+        const auto delta = node->location() - center;
+        distances.push_back({ QPointF::dotProduct(delta, delta), node->index() });
+    }
+    std::sort(distances.begin(), distances.end());
+
+    std::vector<int> order;
+    order.reserve(distances.size());
+    for (auto && distance : distances) {
+        order.push_back(distance.second);
+    }
+    return order;
+}
+
+bool ScenePrewarmer::eventFilter(QObject * watched, QEvent * event)
+{
+    switch (event->type()) {
+    case QEvent::KeyPress:
+    case QEvent::MouseButtonDblClick:
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseMove:
+    case QEvent::TouchBegin:
+    case QEvent::TouchUpdate:
+    case QEvent::Wheel:
+        pause();
+        break;
+    default:
+        break;
+    }
+
+    return QObject::eventFilter(watched, event);
+}
+
+void ScenePrewarmer::pause()
+{
+    // The warming continues where it was as soon as the input has settled
+    m_guiJobScheduler->cancel(m_job);
+    m_idleTimer.start();
+}
+
+void ScenePrewarmer::resume()
+{
+    if (m_isActive && !m_guiJobScheduler->isScheduled(m_job)) {
+        m_job = m_guiJobScheduler->schedule([this] {
+            return warmNextChunk();
+        });
+    }
+}
+
+bool ScenePrewarmer::warmNextChunk()
+{
+    const auto graph = m_graphProvider();
+    if (!graph) {
+        stop();
+        return true;
+    }
+
+    if (!m_order) {
+        m_order = warmingOrder(*graph, m_center);
+        L(TAG).debug() << "Warming the caches of " << m_order->size() << " nodes";
+    }
+
+    // The nodes may have been deleted in between
+    std::vector<NodeS> nodes;
+    const auto end = std::min(m_position + Constants::View::prewarmChunkSize(), m_order->size());
+    for (; m_position < end; m_position++) {
+        if (const auto index = m_order->at(m_position); graph->hasNode(index)) {
+            nodes.push_back(graph->getNode(index));
+        }
+    }
+
+    // All the nodes of a mind map usually share the font. The sizes are cached also for the nodes
+    // outside of the virtualized area, so that their text doesn't get laid out when they are added back.
+    std::vector<std::pair<QFont, std::vector<QString>>> textsByFont;
+    for (auto && node : nodes) {
+        const auto font = node->textFont();
+        auto texts = std::find_if(textsByFont.begin(), textsByFont.end(), [&font](auto && entry) {
+            return entry.first == font;
+        });
+        if (texts == textsByFont.end()) {
+            textsByFont.push_back({ font, {} });
+            texts = std::prev(textsByFont.end());
+        }
+        texts->second.push_back(node->text());
+    }
+    for (auto && [font, texts] : textsByFont) {
+        SceneItems::TextSizeCache::measure(texts, font, -1);
+    }
+
+    // Only the items in the scene get painted
+    for (auto && node : nodes) {
+        if (node->scene()) {
+            node->prewarmCaches(m_pixelScale);
+            if (m_shadowEffect) {
+                ShadowRenderer::prewarmNodeShadow(*node, *m_shadowEffect);
+            }
+            for (auto && edge : graph->edgesFromNode(node->index())) {
+                if (edge->scene()) {
+                    edge->prewarmCaches();
+                }
+            }
+        }
+    }
+
+    if (m_position >= m_order->size()) {
+        L(TAG).debug() << "Caches warmed";
+        stop();
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,95 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SCENE_PREWARMER_HPP
+#define SCENE_PREWARMER_HPP
+
+#include <QObject>
+#include <QPointF>
+#include <QRectF>
+#include <QTimer>
+
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "../common/types.hpp"
+#include "shadow_effect_params.hpp"
+
+class Graph;
+
+//! Fills the caches that the first pans and zooms would otherwise fill while painting, i.e. the text layouts
+//! and sizes, the node backgrounds, the node shadows and the edge label metrics. The nodes nearest to the center
+//! of the viewport are warmed first. The work runs while the GUI is idle in the time slices of GuiJobScheduler
+//! and the text sizes are measured on the task pool. Any user input pauses the work at once until the input
+//! has settled.
+class ScenePrewarmer : public QObject
+{
+    Q_OBJECT
+
+public:
+    using GraphProvider = std::function<const Graph *()>;
+
+    ScenePrewarmer(GraphProvider graphProvider, GuiJobSchedulerS guiJobScheduler);
+
+    ~ScenePrewarmer() override;
+
+    //! Starts over around the given viewport after the idle delay, e.g. after opening or zooming.
+    //! \param pixelScale Device pixels per scene unit of the view, see LevelOfDetail::pixelScale().
+    //! \param shadowEffect The shadows to render, or nothing if the shadows are disabled.
+    void start(QRectF viewportRect, double pixelScale, std::optional<ShadowEffectParams> shadowEffect);
+
+    void stop();
+
+    bool isActive() const;
+
+    //! \returns The indices of the nodes of the graph, nearest to the given center first.
+    static std::vector<int> warmingOrder(const Graph & graph, QPointF center);
+
+protected:
+    bool eventFilter(QObject * watched, QEvent * event) override;
+
+private:
+    void pause();
+
+    void resume();
+
+    //! \returns true when all nodes have been warmed.
+    bool warmNextChunk();
+
+    GraphProvider m_graphProvider;
+
+    GuiJobSchedulerS m_guiJobScheduler;
+
+    //! Resumes when there has been no input for a while.
+    QTimer m_idleTimer;
+
+    size_t m_job = 0;
+
+    QPointF m_center;
+
+    double m_pixelScale = 1;
+
+    std::optional<ShadowEffectParams> m_shadowEffect;
+
+    //! Computed on the first step, so that restarts during a zoom gesture don't sort the nodes each time.
+    std::optional<std::vector<int>> m_order;
+
+    size_t m_position = 0;
+
+    bool m_isActive = false;
+};
+
+#endif // SCENE_PREWARMER_HPP
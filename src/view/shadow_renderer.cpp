@@ -0,0 +1,232 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "shadow_renderer.hpp"
+
+#include "../common/profiler.hpp"
+#include "scene_items/edge.hpp"
+#include "scene_items/level_of_detail.hpp"
+#include "scene_items/node.hpp"
+#include "shadow_effect_params.hpp"
+
+#include <QGraphicsScene>
+#include <QImage>
+#include <QLinearGradient>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPixmap>
+#include <QPixmapCache>
+#include <QVector2D>
+
+#include <algorithm>
+#include <vector>
+
+namespace ShadowRenderer {
+
+namespace {
+
+// Three box blur passes approximate a gaussian blur
+const int BOX_BLUR_PASS_COUNT = 3;
+
+int boxRadius(int blurRadius)
+{
+    return std::max(1, blurRadius / 2);
+}
+
+int blurMargin(int blurRadius)
+{
+    return BOX_BLUR_PASS_COUNT * boxRadius(blurRadius) + 1;
+}
+
+void boxBlur(std::vector<int> & values, int width, int height, int radius, bool horizontal)
+{
+    const auto length = horizontal ? width : height;
+    const auto lineCount = horizontal ? height : width;
+    const auto stride = horizontal ? 1 : width;
+    const auto lineStride = horizontal ? width : 1;
+    const auto windowSize = 2 * radius + 1;
+    std::vector<int> line(static_cast<size_t>(length));
+    for (int lineIndex = 0; lineIndex < lineCount; lineIndex++) {
+        const auto begin = lineIndex * lineStride;
+        for (int i = 0; i < length; i++) {
+            line[static_cast<size_t>(i)] = values[static_cast<size_t>(begin + i * stride)];
+        }
+        // Sliding window sum, values outside of the image are zero
+        int sum = 0;
+        for (int i = 0; i < std::min(radius, length); i++) {
+            sum += line[static_cast<size_t>(i)];
+        }
+        for (int i = 0; i < length; i++) {
+            if (const auto entering = i + radius; entering < length) {
+                sum += line[static_cast<size_t>(entering)];
+            }
+            if (const auto leaving = i - radius - 1; leaving >= 0) {
+                sum -= line[static_cast<size_t>(leaving)];
+            }
+            values[static_cast<size_t>(begin + i * stride)] = sum / windowSize;
+        }
+    }
+}
+
+QPixmap blurredSilhouette(const QSize & size, int cornerRadius, int blurRadius, const QColor & color)
+{
+    const auto key = QString { "heimer_shadow_%1x%2_%3_%4_%5" }.arg(size.width()).arg(size.height()).arg(cornerRadius).arg(blurRadius).arg(color.rgba());
+    QPixmap pixmap;
+    if (QPixmapCache::find(key, &pixmap)) {
+        return pixmap;
+    }
+
+    const auto margin = blurMargin(blurRadius);
+    QImage image { size.width() + 2 * margin, size.height() + 2 * margin, QImage::Format_ARGB32_Premultiplied };
+    image.fill(Qt::transparent);
+    {
+        QPainter painter { &image };
+        painter.setRenderHint(QPainter::Antialiasing);
+        QPainterPath path;
+        path.addRoundedRect(QRectF { QPointF { static_cast<double>(margin), static_cast<double>(margin) }, QSizeF { size } }, cornerRadius, cornerRadius);
+        painter.fillPath(path, Qt::black);
+    }
+
+    // Blur only the alpha channel as the color is uniform
+    const auto width = image.width();
+    const auto height = image.height();
+    std::vector<int> alpha(static_cast<size_t>(width * height));
+    for (int y = 0; y < height; y++) {
+        const auto scanLine = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+        for (int x = 0; x < width; x++) {
+            alpha[static_cast<size_t>(y * width + x)] = qAlpha(scanLine[x]);
+        }
+    }
+    for (int pass = 0; pass < BOX_BLUR_PASS_COUNT; pass++) {
+        boxBlur(alpha, width, height, boxRadius(blurRadius), true);
+        boxBlur(alpha, width, height, boxRadius(blurRadius), false);
+    }
+    for (int y = 0; y < height; y++) {
+        const auto scanLine = reinterpret_cast<QRgb *>(image.scanLine(y));
+        for (int x = 0; x < width; x++) {
+            const auto a = alpha[static_cast<size_t>(y * width + x)] * color.alpha() / 255;
+            scanLine[x] = qRgba(color.red() * a / 255, color.green() * a / 255, color.blue() * a / 255, a);
+        }
+    }
+
+    pixmap = QPixmap::fromImage(image);
+    QPixmapCache::insert(key, pixmap);
+    return pixmap;
+}
+
+struct ShadowStyle
+{
+    int blurRadius;
+
+    QColor color;
+
+    double offset;
+};
+
+//! Selected and marked items glow around them instead of casting an offset shadow.
+ShadowStyle shadowStyle(const SceneItems::SceneItemBase & item, bool selected, const ShadowEffectParams & params)
+{
+    if (selected) {
+        return { params.selectedItemBlurRadius(), params.selectedItemShadowColor(), 0.0 };
+    }
+    if (item.markColor().isValid()) {
+        return { params.selectedItemBlurRadius(), item.markColor(), 0.0 };
+    }
+    return { params.blurRadius(), params.shadowColor(), static_cast<double>(params.offset()) };
+}
+
+void drawNodeShadow(QPainter & painter, const SceneItems::Node & node, const ShadowEffectParams & params)
+{
+    const auto [blurRadius, color, offset] = shadowStyle(node, node.selected(), params);
+    const auto size = node.size().toSize();
+    const auto silhouette = blurredSilhouette(size, node.cornerRadius(), blurRadius, color);
+    // Draw the unscaled silhouette scaled so that hover animations don't fill the cache
+    const auto scale = node.scale();
+    const QSizeF targetSize { silhouette.width() * scale, silhouette.height() * scale };
+    const auto center = node.scenePos() + QPointF { offset, offset };
+    painter.setOpacity(node.effectiveOpacity());
+    painter.drawPixmap(QRectF { center - QPointF { targetSize.width(), targetSize.height() } / 2, targetSize }, silhouette, silhouette.rect());
+}
+
+void drawEdgeShadow(QPainter & painter, const SceneItems::Edge & edge, const ShadowEffectParams & params)
+{
+    const auto line = edge.line();
+    if (line.length() <= 0) {
+        return;
+    }
+
+    const auto [blurRadius, color, offset] = shadowStyle(edge, edge.selected(), params);
+    const auto edgeWidth = edge.model().style.edgeWidth;
+    const auto width = edgeWidth + 2 * blurRadius;
+
+    // A gradient across the line fakes the blur of a straight stroke
+    const auto normal = QVector2D { static_cast<float>(-line.dy()), static_cast<float>(line.dx()) }.normalized().toPointF() * width / 2;
+    const auto center = line.center() + QPointF { offset, offset };
+    QLinearGradient gradient { center - normal, center + normal };
+    auto transparent = color;
+    transparent.setAlpha(0);
+    gradient.setColorAt(0, transparent);
+    gradient.setColorAt(0.5, color);
+    gradient.setColorAt(1, transparent);
+    painter.setOpacity(edge.effectiveOpacity());
+    painter.setPen(QPen { QBrush { gradient }, width, Qt::SolidLine, Qt::FlatCap });
+    painter.drawLine(line.translated(offset, offset));
+}
+
+} // namespace
+
+void drawShadows(QPainter & painter, const QRectF & sceneRect, const QGraphicsScene & scene, const ShadowEffectParams & params)
+{
+    // Shadows would be just a few pixels of haze on an overview
+    if (LevelOfDetail::tier(painter) == LevelOfDetail::Tier::Minimal) {
+        return;
+    }
+
+    const Profiler::ScopedTimer timer { Profiler::Section::Shadows };
+    size_t shadowCount = 0;
+    painter.save();
+    const auto margin = shadowRect({}, params);
+    const auto queryRect = sceneRect.adjusted(margin.left(), margin.top(), margin.right(), margin.bottom());
+    for (auto && item : scene.items(queryRect, Qt::IntersectsItemBoundingRect, Qt::AscendingOrder)) {
+        // Transparent items are e.g. the ones that are drawn from the drag tiles with their shadows
+        if (!item->isVisible() || qFuzzyIsNull(item->effectiveOpacity())) {
+            continue;
+        }
+        if (const auto node = dynamic_cast<NodeP>(item); node) {
+            drawNodeShadow(painter, *node, params);
+            shadowCount++;
+        } else if (const auto edge = dynamic_cast<EdgeP>(item); edge) {
+            drawEdgeShadow(painter, *edge, params);
+            shadowCount++;
+        }
+    }
+    painter.restore();
+    Profiler::addShadowsDrawn(shadowCount);
+}
+
+void prewarmNodeShadow(const SceneItems::Node & node, const ShadowEffectParams & params)
+{
+    const auto [blurRadius, color, offset] = shadowStyle(node, node.selected(), params);
+    static_cast<void>(offset);
+    blurredSilhouette(node.size().toSize(), node.cornerRadius(), blurRadius, color);
+}
+
+QRectF shadowRect(const QRectF & sceneBoundingRect, const ShadowEffectParams & params)
+{
+    const auto margin = blurMargin(std::max(params.blurRadius(), params.selectedItemBlurRadius())) + params.offset();
+    return sceneBoundingRect.adjusted(-margin, -margin, margin, margin);
+}
+
+} // namespace ShadowRenderer
@@ -0,0 +1,45 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SHADOW_RENDERER_HPP
+#define SHADOW_RENDERER_HPP
+
+#include <QRectF>
+
+class QGraphicsScene;
+class QPainter;
+class ShadowEffectParams;
+
+namespace SceneItems {
+class Node;
+}
+
+//! Draws the drop shadows of all visible nodes and edges in a single pass below the items.
+//! This replaces per-item QGraphicsEffects, which made Qt render every item offscreen.
+namespace ShadowRenderer {
+
+//! Draws the shadows of the items that intersect the given scene rect. The blurred node silhouettes
+//! are cached per node size, corner radius and shadow parameters.
+void drawShadows(QPainter & painter, const QRectF & sceneRect, const QGraphicsScene & scene, const ShadowEffectParams & params);
+
+//! Renders the blurred silhouette of the node into the cache ahead of painting, see ScenePrewarmer.
+void prewarmNodeShadow(const SceneItems::Node & node, const ShadowEffectParams & params);
+
+//! \return The area that the shadow of an item with the given scene bounding rect may cover.
+QRectF shadowRect(const QRectF & sceneBoundingRect, const ShadowEffectParams & params);
+
+} // namespace ShadowRenderer
+
+#endif // SHADOW_RENDERER_HPP
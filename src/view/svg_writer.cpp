@@ -0,0 +1,412 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "svg_writer.hpp"
+
+#include "../common/constants.hpp"
+#include "../common/trace_recorder.hpp"
+#include "../domain/graph.hpp"
+#include "../domain/image_manager.hpp"
+#include "../domain/mind_map_data.hpp"
+#include "scene_items/edge.hpp"
+#include "scene_items/graphics_factory.hpp"
+#include "scene_items/node.hpp"
+
+#include "simple_logger.hpp"
+
+#include <QBuffer>
+#include <QFile>
+#include <QFont>
+#include <QFontInfo>
+#include <QFontMetricsF>
+#include <QXmlStreamWriter>
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+
+static const auto TAG = "SvgWriter";
+
+namespace {
+
+const auto shadowId = "shadow";
+
+//! Default margin of the documents of the text items
+const double documentMargin = 4;
+
+QString number(double value)
+{
+    return QString::number(value, 'g', 8);
+}
+
+void writeColor(QXmlStreamWriter & writer, QString attribute, QColor color)
+{
+    writer.writeAttribute(attribute, color.name());
+    if (color.alpha() != 255) {
+        writer.writeAttribute(attribute + "-opacity", number(color.alphaF()));
+    }
+}
+
+void writeRect(QXmlStreamWriter & writer, QRectF rect)
+{
+    writer.writeAttribute("x", number(rect.x()));
+    writer.writeAttribute("y", number(rect.y()));
+    writer.writeAttribute("width", number(rect.width()));
+    writer.writeAttribute("height", number(rect.height()));
+}
+
+bool hasShadow(const ShadowEffectParams & shadowEffect)
+{
+    return shadowEffect.shadowColor().alpha() && (shadowEffect.blurRadius() || shadowEffect.offset());
+}
+
+double textWidth(const QFontMetricsF & metrics, QString text)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
+    return metrics.horizontalAdvance(text);
+#else
+    return metrics.width(text);
+#endif
+}
+
+//! \return Size of the given text without the document margins, as laid out by the text items.
+QSizeF textSize(const QFontMetricsF & metrics, const QStringList & lines)
+{
+    double width = 0;
+    for (auto && line : lines) {
+        width = std::max(width, textWidth(metrics, line));
+    }
+    return { width, metrics.lineSpacing() * lines.size() };
+}
+
+//! Writes the lines of the given text starting from the top left corner of its text box.
+void writeText(QXmlStreamWriter & writer, const QStringList & lines, QPointF topLeft, const QFont & font, QColor color)
+{
+    const QFontMetricsF metrics { font };
+    writer.writeStartElement("text");
+    writer.writeAttribute("font-family", font.family());
+    writer.writeAttribute("font-size", number(QFontInfo { font }.pixelSize()));
+    if (font.bold()) {
+        writer.writeAttribute("font-weight", "bold");
+    }
+    if (font.italic()) {
+        writer.writeAttribute("font-style", "italic");
+    }
+    writeColor(writer, "fill", color);
+    writer.writeAttribute("xml:space", "preserve");
+    auto baseline = topLeft.y() + metrics.ascent();
+    for (auto && line : lines) {
+        writer.writeStartElement("tspan");
+        writer.writeAttribute("x", number(topLeft.x()));
+        writer.writeAttribute("y", number(baseline));
+        writer.writeCharacters(line);
+        writer.writeEndElement();
+        baseline += metrics.lineSpacing();
+    }
+    writer.writeEndElement();
+}
+
+//! \return The image as a data URI. The original file contents are embedded as is when available.
+QString imageDataUri(const Image & image)
+{
+    // Embed the original encoded data as is, e.g. a JPEG stays a JPEG
+    auto data = image.data();
+    auto mimeType = image.mimeType();
+    if (data.isEmpty()) {
+        mimeType = "image/png";
+        QBuffer buffer { &data };
+        buffer.open(QIODevice::WriteOnly);
+        image.image().save(&buffer, "PNG");
+    }
+    return "data:" + mimeType + ";base64," + QString::fromLatin1(data.toBase64());
+}
+
+} // namespace
+
+SvgWriter::SvgWriter(const MindMapData & mindMapData, const ShadowEffectParams & shadowEffect)
+  : m_mindMapData(mindMapData)
+  , m_shadowEffect(shadowEffect)
+{
+}
+
+QString SvgWriter::arrowheadId(double arrowSize, double edgeWidth, bool atStart) const
+{
+    return QString { "arrowhead-%1-%2" }.arg(m_arrowheads.at({ arrowSize, edgeWidth })).arg(atStart ? "start" : "end");
+}
+
+bool SvgWriter::write(QString fileName, QString title, QRectF viewBox, const std::vector<QLineF> & gridLines)
+{
+    const TraceRecorder::ScopedSpan span { "SvgWriter::write" };
+
+    QFile file { fileName };
+    if (!file.open(QIODevice::WriteOnly)) {
+        juzzlin::L(TAG).error() << "Cannot open " << fileName.toStdString() << " for writing";
+        return false;
+    }
+
+    QXmlStreamWriter writer { &file };
+    writer.setAutoFormatting(true);
+    writer.writeStartDocument();
+    writer.writeStartElement("svg");
+    writer.writeDefaultNamespace("http://www.w3.org/2000/svg");
+    writer.writeNamespace("http://www.w3.org/1999/xlink", "xlink");
+    writer.writeAttribute("version", "1.1");
+    writer.writeAttribute("width", number(viewBox.width()));
+    writer.writeAttribute("height", number(viewBox.height()));
+    writer.writeAttribute("viewBox", QString { "%1 %2 %3 %4" }.arg(number(viewBox.x()), number(viewBox.y()), number(viewBox.width()), number(viewBox.height())));
+    writer.writeTextElement("title", title);
+    writer.writeTextElement("desc", QString { "SVG exported from %1 version %2" }.arg(Constants::Application::applicationName(), Constants::Application::applicationVersion()));
+
+    writeDefs(writer);
+
+    writer.writeEmptyElement("rect");
+    writer.writeAttribute("id", "background");
+    writeRect(writer, viewBox);
+    writeColor(writer, "fill", m_mindMapData.backgroundColor());
+
+    writeGrid(writer, gridLines);
+
+    writeEdges(writer);
+
+    writeNodes(writer);
+
+    writeEdgeLabels(writer);
+
+    writer.writeEndDocument();
+
+    if (writer.hasError()) {
+        juzzlin::L(TAG).error() << "Failed to write " << fileName.toStdString();
+        return false;
+    }
+
+    return true;
+}
+
+void SvgWriter::writeArrowhead(QXmlStreamWriter & writer, double arrowSize, double edgeWidth, bool atStart) const
+{
+    // The same opening as in the arrowheads of the edges. The marker is oriented along the line,
+    // so the arrowhead at the start points backwards.
+    const double arrowOpening = 150;
+    const auto direction = atStart ? -1.0 : 1.0;
+    const auto x = direction * std::cos(qDegreesToRadians(arrowOpening)) * arrowSize;
+    const auto y = std::sin(qDegreesToRadians(arrowOpening)) * arrowSize;
+
+    writer.writeStartElement("marker");
+    writer.writeAttribute("id", arrowheadId(arrowSize, edgeWidth, atStart));
+    writer.writeAttribute("markerUnits", "userSpaceOnUse");
+    writer.writeAttribute("markerWidth", number(arrowSize));
+    writer.writeAttribute("markerHeight", number(arrowSize));
+    writer.writeAttribute("orient", "auto");
+    writer.writeAttribute("overflow", "visible");
+    writer.writeEmptyElement("path");
+    writer.writeAttribute("d", QString { "M %1 %2 L 0 0 L %1 %3" }.arg(number(x), number(-y), number(y)));
+    writer.writeAttribute("fill", "none");
+    writeColor(writer, "stroke", m_mindMapData.edgeColor());
+    writer.writeAttribute("stroke-width", number(edgeWidth));
+    writer.writeAttribute("stroke-linecap", "round");
+    writer.writeEndElement();
+}
+
+void SvgWriter::writeDefs(QXmlStreamWriter & writer)
+{
+    writer.writeStartElement("defs");
+
+    m_arrowheads.clear();
+    for (auto && edge : m_mindMapData.graph().edges()) {
+        if (auto && style = edge->model().style; style.arrowMode != SceneItems::EdgeModel::ArrowMode::Hidden) {
+            m_arrowheads.insert({ { style.arrowSize, style.edgeWidth }, m_arrowheads.size() });
+        }
+    }
+
+    for (auto && [style, index] : m_arrowheads) {
+        Q_UNUSED(index)
+        writeArrowhead(writer, style.first, style.second, true);
+        writeArrowhead(writer, style.first, style.second, false);
+    }
+
+    if (hasShadow(m_shadowEffect)) {
+        writer.writeStartElement("filter");
+        writer.writeAttribute("id", shadowId);
+        writer.writeAttribute("x", "-50%");
+        writer.writeAttribute("y", "-50%");
+        writer.writeAttribute("width", "200%");
+        writer.writeAttribute("height", "200%");
+        writer.writeEmptyElement("feGaussianBlur");
+        writer.writeAttribute("in", "SourceAlpha");
+        writer.writeAttribute("stdDeviation", number(m_shadowEffect.blurRadius() * 0.5));
+        writer.writeEmptyElement("feOffset");
+        writer.writeAttribute("dx", number(m_shadowEffect.offset()));
+        writer.writeAttribute("dy", number(m_shadowEffect.offset()));
+        writer.writeAttribute("result", "offsetBlur");
+        writer.writeEmptyElement("feFlood");
+        writeColor(writer, "flood", m_shadowEffect.shadowColor());
+        writer.writeEmptyElement("feComposite");
+        writer.writeAttribute("in2", "offsetBlur");
+        writer.writeAttribute("operator", "in");
+        writer.writeStartElement("feMerge");
+        writer.writeEmptyElement("feMergeNode");
+        writer.writeEmptyElement("feMergeNode");
+        writer.writeAttribute("in", "SourceGraphic");
+        writer.writeEndElement();
+        writer.writeEndElement();
+    }
+
+    writer.writeEndElement();
+}
+
+void SvgWriter::writeEdgeLabels(QXmlStreamWriter & writer) const
+{
+    QFont font = m_mindMapData.font();
+    font.setPointSize(m_mindMapData.textSize());
+    const QFontMetricsF metrics { font };
+
+    writer.writeStartElement("g");
+    writer.writeAttribute("id", "edge-labels");
+    for (auto && edge : m_mindMapData.graph().edges()) {
+        if (edge->text().isEmpty()) {
+            continue;
+        }
+        const auto lines = edge->text().split('\n');
+        const auto size = textSize(metrics, lines) + QSizeF { documentMargin, documentMargin } * 2;
+        const QRectF rect { edge->line().center() - QPointF { size.width(), size.height() } * 0.5, size };
+        writer.writeStartElement("g");
+        writer.writeAttribute("class", "edge-label");
+        writer.writeEmptyElement("rect");
+        writeRect(writer, rect);
+        writeColor(writer, "fill", Constants::Edge::labelColor());
+        writeText(writer, lines, rect.topLeft() + QPointF { documentMargin, documentMargin }, font, Qt::black);
+        writer.writeEndElement();
+    }
+    writer.writeEndElement();
+}
+
+void SvgWriter::writeEdges(QXmlStreamWriter & writer) const
+{
+    writer.writeStartElement("g");
+    writer.writeAttribute("id", "edges");
+    if (hasShadow(m_shadowEffect)) {
+        writer.writeAttribute("filter", QString { "url(#%1)" }.arg(shadowId));
+    }
+    writeColor(writer, "stroke", m_mindMapData.edgeColor());
+    writer.writeAttribute("stroke-linecap", "round");
+    for (auto && edge : m_mindMapData.graph().edges()) {
+        const auto line = edge->line();
+        auto && style = edge->model().style;
+        writer.writeEmptyElement("line");
+        writer.writeAttribute("x1", number(line.x1()));
+        writer.writeAttribute("y1", number(line.y1()));
+        writer.writeAttribute("x2", number(line.x2()));
+        writer.writeAttribute("y2", number(line.y2()));
+        writer.writeAttribute("stroke-width", number(style.edgeWidth));
+        if (style.dashedLine) {
+            // The dash pattern of the pens is relative to the width
+            writer.writeAttribute("stroke-dasharray", QString { "%1 %1" }.arg(number(style.edgeWidth * 5)));
+        }
+        switch (style.arrowMode) {
+        case SceneItems::EdgeModel::ArrowMode::Single:
+            if (edge->reversed()) {
+                writer.writeAttribute("marker-start", QString { "url(#%1)" }.arg(arrowheadId(style.arrowSize, style.edgeWidth, true)));
+            } else {
+                writer.writeAttribute("marker-end", QString { "url(#%1)" }.arg(arrowheadId(style.arrowSize, style.edgeWidth, false)));
+            }
+            break;
+        case SceneItems::EdgeModel::ArrowMode::Double:
+            writer.writeAttribute("marker-start", QString { "url(#%1)" }.arg(arrowheadId(style.arrowSize, style.edgeWidth, true)));
+            writer.writeAttribute("marker-end", QString { "url(#%1)" }.arg(arrowheadId(style.arrowSize, style.edgeWidth, false)));
+            break;
+        case SceneItems::EdgeModel::ArrowMode::Hidden:
+            break;
+        }
+    }
+    writer.writeEndElement();
+}
+
+void SvgWriter::writeGrid(QXmlStreamWriter & writer, const std::vector<QLineF> & gridLines) const
+{
+    if (gridLines.empty()) {
+        return;
+    }
+
+    writer.writeStartElement("g");
+    writer.writeAttribute("id", "grid");
+    writeColor(writer, "stroke", m_mindMapData.gridColor());
+    writer.writeAttribute("stroke-width", "1");
+    for (auto && line : gridLines) {
+        writer.writeEmptyElement("line");
+        writer.writeAttribute("x1", number(line.x1()));
+        writer.writeAttribute("y1", number(line.y1()));
+        writer.writeAttribute("x2", number(line.x2()));
+        writer.writeAttribute("y2", number(line.y2()));
+    }
+    writer.writeEndElement();
+}
+
+void SvgWriter::writeNodes(QXmlStreamWriter & writer) const
+{
+    QFont font = m_mindMapData.font();
+    font.setPointSize(m_mindMapData.textSize());
+
+    // Shares the image records with the mind map, but the getter is not const
+    auto imageManager = m_mindMapData.imageManager();
+    const auto cornerRadius = number(m_mindMapData.cornerRadius());
+    const double textOffset = Constants::Node::contentPadding() + documentMargin;
+
+    writer.writeStartElement("g");
+    writer.writeAttribute("id", "nodes");
+    for (auto && node : m_mindMapData.graph().nodes()) {
+        auto && model = node->model();
+        const QRectF rect { model.location - QPointF { model.size.width(), model.size.height() } * 0.5, model.size };
+
+        writer.writeStartElement("g");
+        writer.writeAttribute("class", "node");
+        if (hasShadow(m_shadowEffect)) {
+            writer.writeAttribute("filter", QString { "url(#%1)" }.arg(shadowId));
+        }
+
+        if (const auto image = model.imageRef ? imageManager.getImage(model.imageRef) : nullptr; image) {
+            // Scaled to cover the node from the top left corner like the background pixmap of the node
+            const auto clipId = QString { "node-clip-%1" }.arg(model.index);
+            writer.writeStartElement("clipPath");
+            writer.writeAttribute("id", clipId);
+            writer.writeEmptyElement("rect");
+            writeRect(writer, rect);
+            writer.writeAttribute("rx", cornerRadius);
+            writer.writeAttribute("ry", cornerRadius);
+            writer.writeEndElement();
+            writer.writeEmptyElement("image");
+            writeRect(writer, rect);
+            writer.writeAttribute("preserveAspectRatio", "xMinYMin slice");
+            writer.writeAttribute("clip-path", QString { "url(#%1)" }.arg(clipId));
+            writer.writeAttribute("xlink:href", imageDataUri(*image));
+        } else {
+            const auto outlinePen = GraphicsFactory::createOutlinePen(model.color, 0.33);
+            writer.writeEmptyElement("rect");
+            writeRect(writer, rect);
+            writer.writeAttribute("rx", cornerRadius);
+            writer.writeAttribute("ry", cornerRadius);
+            writeColor(writer, "fill", model.color);
+            writeColor(writer, "stroke", outlinePen.color());
+            writer.writeAttribute("stroke-width", number(outlinePen.widthF()));
+        }
+
+        if (!model.text.isEmpty()) {
+            writeText(writer, model.text.toString().split('\n'), rect.topLeft() + QPointF { textOffset, textOffset }, font, model.textColor);
+        }
+
+        writer.writeEndElement();
+    }
+    writer.writeEndElement();
+}
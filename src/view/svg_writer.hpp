@@ -0,0 +1,69 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SVG_WRITER_HPP
+#define SVG_WRITER_HPP
+
+#include <QLineF>
+#include <QRectF>
+#include <QString>
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "shadow_effect_params.hpp"
+
+class MindMapData;
+class QXmlStreamWriter;
+
+//! Writes a mind map to an SVG file directly from the node and edge data instead of capturing the
+//! painter output of a scene, which also doesn't need the graphics effects to be toggled off. Nodes,
+//! edges and labels are grouped, texts stay texts and the arrowheads and the shadow are shared definitions.
+//! The edge lines are taken from the scene items, so they must have been laid out, e.g. by ExportSnapshot.
+class SvgWriter
+{
+public:
+    SvgWriter(const MindMapData & mindMapData, const ShadowEffectParams & shadowEffect);
+
+    //! \param viewBox The exported area in scene coordinates.
+    //! \param gridLines Grid lines to draw under the mind map, if any.
+    //! \return false if the file couldn't be written.
+    bool write(QString fileName, QString title, QRectF viewBox, const std::vector<QLineF> & gridLines = {});
+
+private:
+    QString arrowheadId(double arrowSize, double edgeWidth, bool atStart) const;
+
+    void writeArrowhead(QXmlStreamWriter & writer, double arrowSize, double edgeWidth, bool atStart) const;
+
+    void writeDefs(QXmlStreamWriter & writer);
+
+    void writeEdgeLabels(QXmlStreamWriter & writer) const;
+
+    void writeEdges(QXmlStreamWriter & writer) const;
+
+    void writeGrid(QXmlStreamWriter & writer, const std::vector<QLineF> & gridLines) const;
+
+    void writeNodes(QXmlStreamWriter & writer) const;
+
+    const MindMapData & m_mindMapData;
+
+    ShadowEffectParams m_shadowEffect;
+
+    //! Arrowhead styles in use as (arrow size, edge width) => index of the definition
+    std::map<std::pair<double, double>, size_t> m_arrowheads;
+};
+
+#endif // SVG_WRITER_HPP
@@ -0,0 +1,82 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "thumbnail_renderer.hpp"
+
+#include "../domain/graph_snapshot.hpp"
+
+#include <QPainter>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace ThumbnailRenderer {
+
+namespace {
+
+QRectF nodeRect(const SceneItems::NodeModel & node)
+{
+    return { node.location - QPointF { node.size.width(), node.size.height() } * 0.5, node.size };
+}
+
+} // namespace
+
+QRectF bounds(const GraphSnapshot & graph)
+{
+    QRectF rect;
+    for (auto && node : graph.nodes()) {
+        rect |= nodeRect(node);
+    }
+    return rect;
+}
+
+QImage render(const GraphSnapshot & graph, const Style & style, int size)
+{
+    auto rect = bounds(graph);
+    const double margin = 0.05 * std::max(rect.width(), rect.height());
+    rect.adjust(-margin, -margin, margin, margin);
+
+    const double scale = size / std::max({ rect.width(), rect.height(), 1.0 });
+    QImage image { std::max(1, static_cast<int>(std::ceil(rect.width() * scale))), std::max(1, static_cast<int>(std::ceil(rect.height() * scale))), QImage::Format_ARGB32_Premultiplied };
+    image.fill(style.backgroundColor);
+
+    QPainter painter { &image };
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.scale(scale, scale);
+    painter.translate(-rect.topLeft());
+
+    std::map<int, QPointF> locations;
+    for (auto && node : graph.nodes()) {
+        locations[node.index] = node.location;
+    }
+
+    painter.setPen(QPen { style.edgeColor, 1.0 / scale });
+    for (auto && edge : graph.edges()) {
+        if (const auto source = locations.find(edge.sourceIndex), target = locations.find(edge.targetIndex); source != locations.end() && target != locations.end()) {
+            painter.drawLine(source->second, target->second);
+        }
+    }
+
+    painter.setPen(Qt::NoPen);
+    for (auto && node : graph.nodes()) {
+        painter.setBrush(node.color);
+        painter.drawRoundedRect(nodeRect(node), style.cornerRadius, style.cornerRadius);
+    }
+
+    return image;
+}
+
+} // namespace ThumbnailRenderer
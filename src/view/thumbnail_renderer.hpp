@@ -0,0 +1,47 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef THUMBNAIL_RENDERER_HPP
+#define THUMBNAIL_RENDERER_HPP
+
+#include <QColor>
+#include <QImage>
+#include <QRectF>
+
+class GraphSnapshot;
+
+//! Draws small previews of mind maps from plain graph data, so that they can be rendered on any thread
+//! without scene items, e.g. for the thumbnail cache and the headers of the saved files.
+namespace ThumbnailRenderer {
+
+struct Style
+{
+    QColor backgroundColor;
+
+    QColor edgeColor;
+
+    int cornerRadius = 0;
+};
+
+//! \return The rect covered by the nodes, or a null rect if there are none.
+QRectF bounds(const GraphSnapshot & graph);
+
+//! Renders the nodes as rounded rects and the edges as lines between them. Texts would not be readable anyway.
+//! \param size Length of the longest side of the image.
+QImage render(const GraphSnapshot & graph, const Style & style, int size);
+
+} // namespace ThumbnailRenderer
+
+#endif // THUMBNAIL_RENDERER_HPP
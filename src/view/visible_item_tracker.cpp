@@ -0,0 +1,58 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "visible_item_tracker.hpp"
+
+#include "scene_items/scene_item_base.hpp"
+
+#include <QGraphicsScene>
+#include <QRegion>
+
+namespace {
+
+void setInViewport(const QGraphicsScene & scene, const QRegion & region, const QRectF & viewportRect, bool entered)
+{
+    for (auto && rect : region) {
+        for (auto && item : scene.items(rect, Qt::IntersectsItemBoundingRect)) {
+            if (const auto sceneItem = dynamic_cast<SceneItems::SceneItemBase *>(item); sceneItem) {
+                // An item that left a strip can still be partially visible
+                if (entered || !sceneItem->sceneBoundingRect().intersects(viewportRect)) {
+                    sceneItem->setInViewport(entered);
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+void VisibleItemTracker::update(const QGraphicsScene & scene, const QRectF & viewportRect)
+{
+    if (m_scene != &scene) {
+        m_scene = &scene;
+        m_viewportRect = {};
+    }
+
+    if (viewportRect == m_viewportRect) {
+        return;
+    }
+
+    const QRegion previousRegion { m_viewportRect.toAlignedRect() };
+    const QRegion currentRegion { viewportRect.toAlignedRect() };
+    setInViewport(scene, previousRegion.subtracted(currentRegion), viewportRect, false);
+    setInViewport(scene, currentRegion.subtracted(previousRegion), viewportRect, true);
+
+    m_viewportRect = viewportRect;
+}
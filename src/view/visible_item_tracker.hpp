@@ -0,0 +1,38 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef VISIBLE_ITEM_TRACKER_HPP
+#define VISIBLE_ITEM_TRACKER_HPP
+
+#include <QRectF>
+
+class QGraphicsScene;
+
+//! Tells scene items when they enter or leave the viewport. Only the strips between the previous and the
+//! current viewport rect are queried from the scene index, so the cost is proportional to what changed.
+//! Items that haven't been seen yet are considered to be in the viewport.
+class VisibleItemTracker
+{
+public:
+    //! Notifies the items that entered or left the given viewport rect since the previous update.
+    void update(const QGraphicsScene & scene, const QRectF & viewportRect);
+
+private:
+    const QGraphicsScene * m_scene = nullptr;
+
+    QRectF m_viewportRect;
+};
+
+#endif // VISIBLE_ITEM_TRACKER_HPP
@@ -0,0 +1,109 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "convergence_plot.hpp"
+
+#include "../../common/constants.hpp"
+
+#include <QPainter>
+#include <QPainterPath>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Widgets {
+
+// Values are clamped to this before the logarithm, as a cost can reach zero
+static const double MIN_PLOTTED_VALUE = 1e-6;
+
+ConvergencePlot::ConvergencePlot(QWidget * parent)
+  : QWidget(parent)
+{
+    setMinimumHeight(80);
+    setToolTip(tr("Cost (solid) and temperature (dashed) of the optimization"));
+}
+
+QSize ConvergencePlot::sizeHint() const
+{
+    return { 400, 120 };
+}
+
+void ConvergencePlot::addSample(double cost, double temperature)
+{
+    m_samples.push_back({ cost, temperature });
+    if (m_samples.size() > Constants::LayoutOptimizer::traceSize()) {
+        m_samples.pop_front();
+    }
+
+    update();
+}
+
+void ConvergencePlot::clear()
+{
+    m_samples.clear();
+
+    update();
+}
+
+void ConvergencePlot::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.fillRect(rect(), palette().base());
+    painter.setPen(palette().mid().color());
+    painter.drawRect(rect().adjusted(0, 0, -1, -1));
+
+    if (m_samples.size() < 2) {
+        return;
+    }
+
+    const auto plotRect = QRectF(rect()).adjusted(2, 2, -2, -2);
+    drawSeries(painter, plotRect, &Sample::temperature, QPen(palette().mid().color(), 1, Qt::DashLine));
+    drawSeries(painter, plotRect, &Sample::cost, QPen(palette().highlight().color(), 2));
+}
+
+void ConvergencePlot::drawSeries(QPainter & painter, const QRectF & plotRect, double Sample::*value, const QPen & pen) const
+{
+    const auto logValue = [value](const Sample & sample) {
+        return std::log(std::max(sample.*value, MIN_PLOTTED_VALUE));
+    };
+
+    double minValue = std::numeric_limits<double>::max();
+    double maxValue = std::numeric_limits<double>::lowest();
+    for (auto && sample : m_samples) {
+        minValue = std::min(minValue, logValue(sample));
+        maxValue = std::max(maxValue, logValue(sample));
+    }
+
+    const double range = maxValue > minValue ? maxValue - minValue : 1;
+    QPainterPath path;
+    for (size_t i = 0; i < m_samples.size(); i++) {
+        const QPointF point {
+            plotRect.left() + plotRect.width() * static_cast<double>(i) / static_cast<double>(m_samples.size() - 1),
+            plotRect.bottom() - plotRect.height() * (logValue(m_samples.at(i)) - minValue) / range
+        };
+        if (i) {
+            path.lineTo(point);
+        } else {
+            path.moveTo(point);
+        }
+    }
+
+    painter.setPen(pen);
+    painter.drawPath(path);
+}
+
+} // namespace Widgets
@@ -0,0 +1,63 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef CONVERGENCE_PLOT_HPP
+#define CONVERGENCE_PLOT_HPP
+
+#include <QWidget>
+
+#include <deque>
+
+class QPainter;
+class QPen;
+
+namespace Widgets {
+
+//! Plots the cost and the temperature of a running layout optimization on logarithmic scales, each fitted to its own range.
+class ConvergencePlot : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ConvergencePlot(QWidget * parent = nullptr);
+
+    QSize sizeHint() const override;
+
+public slots:
+
+    void addSample(double cost, double temperature);
+
+    void clear();
+
+protected:
+    void paintEvent(QPaintEvent * event) override;
+
+private:
+    struct Sample
+    {
+        double cost = 0;
+
+        double temperature = 0;
+    };
+
+    void drawSeries(QPainter & painter, const QRectF & plotRect, double Sample::*value, const QPen & pen) const;
+
+    //! The oldest samples are dropped once the plot has more samples than it has room for.
+    std::deque<Sample> m_samples;
+};
+
+} // namespace Widgets
+
+#endif // CONVERGENCE_PLOT_HPP
@@ -0,0 +1,56 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "export_region_combo_box.hpp"
+
+namespace Widgets {
+
+ExportRegionComboBox::ExportRegionComboBox(QWidget * parent)
+  : QComboBox(parent)
+{
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
+    const auto comboBoxIntSignal = QOverload<int>::of(&QComboBox::currentIndexChanged);
+#else
+    const auto comboBoxIntSignal = static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged);
+#endif
+
+    connect(this, comboBoxIntSignal, this, [=](int index) {
+        if (index >= 0) {
+            emit regionChanged(region());
+        }
+    });
+}
+
+void ExportRegionComboBox::addRegion(ExportParams::Region region)
+{
+    switch (region) {
+    case ExportParams::Region::MindMap:
+        addItem(tr("Whole mind map"), static_cast<int>(region));
+        break;
+    case ExportParams::Region::View:
+        addItem(tr("Current view"), static_cast<int>(region));
+        break;
+    case ExportParams::Region::SelectedNodes:
+        addItem(tr("Selected nodes"), static_cast<int>(region));
+        break;
+    }
+}
+
+ExportParams::Region ExportRegionComboBox::region() const
+{
+    return currentIndex() >= 0 ? static_cast<ExportParams::Region>(currentData().toInt()) : ExportParams::Region::MindMap;
+}
+
+} // namespace Widgets
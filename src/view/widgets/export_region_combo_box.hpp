@@ -0,0 +1,43 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef EXPORT_REGION_COMBO_BOX_HPP
+#define EXPORT_REGION_COMBO_BOX_HPP
+
+#include <QComboBox>
+
+#include "../../infra/export_params.hpp"
+
+namespace Widgets {
+
+//! Selects the part of the mind map to export. Only the regions added are offered.
+class ExportRegionComboBox : public QComboBox
+{
+    Q_OBJECT
+
+public:
+    explicit ExportRegionComboBox(QWidget * parent = nullptr);
+
+    void addRegion(ExportParams::Region region);
+
+    ExportParams::Region region() const;
+
+signals:
+    void regionChanged(ExportParams::Region region);
+};
+
+} // namespace Widgets
+
+#endif // EXPORT_REGION_COMBO_BOX_HPP
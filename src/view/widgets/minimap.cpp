@@ -0,0 +1,199 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#include "minimap.hpp"
+
+#include "../../common/constants.hpp"
+#include "../../domain/graph.hpp"
+
+#include <QMouseEvent>
+#include <QPainter>
+
+#include <algorithm>
+
+namespace Widgets {
+
+// Empty space around the nodes as a fraction of the longer side of the map
+static const double MAP_MARGIN = 0.05;
+
+static const int VIEWPORT_ALPHA = 64;
+
+Minimap::Minimap(GraphProvider graphProvider, QWidget * parent)
+  : QWidget(parent)
+  , m_graphProvider(graphProvider)
+{
+    resize(sizeHint());
+    setCursor(Qt::PointingHandCursor);
+    setToolTip(tr("Click or drag to center the view"));
+
+    m_updateTimer.setSingleShot(true);
+    m_updateTimer.setInterval(Constants::View::minimapUpdateInterval());
+    connect(&m_updateTimer, &QTimer::timeout, this, &Minimap::updateCache);
+
+    // Shown once the mind map is large enough
+    hide();
+}
+
+QSize Minimap::sizeHint() const
+{
+    return { 200, 150 };
+}
+
+void Minimap::addDirtyRect(const QRectF & sceneRect)
+{
+    m_dirtyRect = m_dirtyRect.united(sceneRect);
+
+    scheduleUpdate();
+}
+
+void Minimap::invalidate()
+{
+    m_fullUpdatePending = true;
+
+    scheduleUpdate();
+}
+
+void Minimap::setViewportRect(const QRectF & sceneRect)
+{
+    if (m_viewportRect != sceneRect) {
+        m_viewportRect = sceneRect;
+        update();
+    }
+}
+
+void Minimap::mouseMoveEvent(QMouseEvent * event)
+{
+    if (event->buttons() & Qt::LeftButton && !m_mapRect.isNull()) {
+        emit centerRequested(m_sceneToMinimap.inverted().map(QPointF { event->pos() }));
+    }
+}
+
+void Minimap::mousePressEvent(QMouseEvent * event)
+{
+    if (event->button() == Qt::LeftButton && !m_mapRect.isNull()) {
+        emit centerRequested(m_sceneToMinimap.inverted().map(QPointF { event->pos() }));
+    }
+}
+
+void Minimap::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.drawImage(0, 0, m_cache);
+    painter.setPen(palette().mid().color());
+    painter.drawRect(rect().adjusted(0, 0, -1, -1));
+
+    if (!m_mapRect.isNull() && !m_viewportRect.isNull()) {
+        auto color = palette().highlight().color();
+        painter.setPen(color);
+        color.setAlpha(VIEWPORT_ALPHA);
+        painter.setBrush(color);
+        painter.drawRect(m_sceneToMinimap.mapRect(m_viewportRect).intersected(QRectF { rect() }));
+    }
+}
+
+void Minimap::resizeEvent(QResizeEvent * event)
+{
+    QWidget::resizeEvent(event);
+
+    invalidate();
+}
+
+void Minimap::drawItems(QPainter & painter, const Graph & graph, const QRectF & sceneRect) const
+{
+    const auto & spatialIndex = graph.nodeSpatialIndex();
+
+    painter.setPen(palette().mid().color());
+    for (auto && edge : graph.edges()) {
+        const auto sourceRect = spatialIndex.rect(edge->sourceNode().index());
+        const auto targetRect = spatialIndex.rect(edge->targetNode().index());
+        if (sourceRect.united(targetRect).intersects(sceneRect)) {
+            painter.drawLine(m_sceneToMinimap.map(sourceRect.center()), m_sceneToMinimap.map(targetRect.center()));
+        }
+    }
+
+    const auto nodeColor = palette().text().color();
+    for (auto && key : spatialIndex.keysInRect(sceneRect)) {
+        auto rect = m_sceneToMinimap.mapRect(spatialIndex.rect(key));
+        // Nodes of a large map would be lost in sub-pixel rects
+        rect.setSize(rect.size().expandedTo({ 1, 1 }));
+        painter.fillRect(rect, nodeColor);
+    }
+}
+
+void Minimap::renderAll(const Graph & graph)
+{
+    m_cache = QImage { size() * devicePixelRatioF(), QImage::Format_ARGB32_Premultiplied };
+    m_cache.setDevicePixelRatio(devicePixelRatioF());
+    m_cache.fill(palette().base().color());
+
+    const auto boundingRect = graph.nodePlacementStats().boundingRect();
+    if (boundingRect.isNull()) {
+        m_mapRect = {};
+        return;
+    }
+
+    const auto margin = std::max(boundingRect.width(), boundingRect.height()) * MAP_MARGIN;
+    m_mapRect = boundingRect.adjusted(-margin, -margin, margin, margin);
+    const auto scale = std::min(width() / m_mapRect.width(), height() / m_mapRect.height());
+    m_sceneToMinimap = QTransform::fromTranslate(-m_mapRect.center().x(), -m_mapRect.center().y()) //
+      * QTransform::fromScale(scale, scale) //
+      * QTransform::fromTranslate(width() / 2.0, height() / 2.0);
+
+    QPainter painter(&m_cache);
+    drawItems(painter, graph, m_mapRect);
+}
+
+void Minimap::renderRect(const Graph & graph, const QRectF & sceneRect)
+{
+    if (m_mapRect.isNull() || !m_mapRect.contains(sceneRect)) {
+        renderAll(graph);
+        return;
+    }
+
+    // Whole pixels, so that no partially covered pixels are left behind
+    const auto dirtyRect = m_sceneToMinimap.mapRect(sceneRect).toAlignedRect().adjusted(-1, -1, 1, 1);
+    QPainter painter(&m_cache);
+    painter.setClipRect(dirtyRect);
+    painter.fillRect(dirtyRect, palette().base().color());
+    drawItems(painter, graph, m_sceneToMinimap.inverted().mapRect(QRectF { dirtyRect }));
+}
+
+void Minimap::scheduleUpdate()
+{
+    if (!m_updateTimer.isActive()) {
+        m_updateTimer.start();
+    }
+}
+
+void Minimap::updateCache()
+{
+    const auto graph = m_graphProvider();
+    const bool enabled = graph && graph->nodeCount() >= Constants::View::minimapThreshold();
+    setVisible(enabled);
+    if (!enabled) {
+        // Rendered from scratch once shown
+        m_fullUpdatePending = true;
+    } else if (m_fullUpdatePending) {
+        renderAll(*graph);
+        m_fullUpdatePending = false;
+    } else if (!m_dirtyRect.isNull()) {
+        renderRect(*graph, m_dirtyRect);
+    }
+
+    m_dirtyRect = {};
+    update();
+}
+
+} // namespace Widgets
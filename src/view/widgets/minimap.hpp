@@ -0,0 +1,103 @@
+// This file is part of Heimer.
+// Copyright (C) 2024 Jussi Lind <jussi.lind@iki.fi>
+//
+// Heimer is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+// Heimer is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Heimer. If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MINIMAP_HPP
+#define MINIMAP_HPP
+
+#include <QImage>
+#include <QTimer>
+#include <QTransform>
+#include <QWidget>
+
+#include <functional>
+
+class Graph;
+class QPainter;
+
+namespace Widgets {
+
+//! An overview of the whole mind map with the current viewport rect. The nodes and edges are drawn from the
+//! placement index of the graph into a low resolution cache, so also the virtualized items are shown, and only
+//! the dirty parts of the cache are redrawn on changes. Clicking or dragging centers the view on that point.
+class Minimap : public QWidget
+{
+    Q_OBJECT
+
+public:
+    //! The graph is queried on every update, because the graph of the mind map can be replaced at any time.
+    using GraphProvider = std::function<const Graph *()>;
+
+    explicit Minimap(GraphProvider graphProvider, QWidget * parent = nullptr);
+
+    QSize sizeHint() const override;
+
+public slots:
+
+    //! Redraws the given scene rect of the cache on the next update.
+    void addDirtyRect(const QRectF & sceneRect);
+
+    //! Redraws the whole cache on the next update, e.g. for a new mind map.
+    void invalidate();
+
+    void setViewportRect(const QRectF & sceneRect);
+
+signals:
+
+    void centerRequested(QPointF scenePosition);
+
+protected:
+    void mouseMoveEvent(QMouseEvent * event) override;
+
+    void mousePressEvent(QMouseEvent * event) override;
+
+    void paintEvent(QPaintEvent * event) override;
+
+    void resizeEvent(QResizeEvent * event) override;
+
+private:
+    //! Draws the nodes and edges that intersect the given scene rect on the cache.
+    void drawItems(QPainter & painter, const Graph & graph, const QRectF & sceneRect) const;
+
+    void renderAll(const Graph & graph);
+
+    //! Renders the whole cache instead if the rect is outside of the map.
+    void renderRect(const Graph & graph, const QRectF & sceneRect);
+
+    void scheduleUpdate();
+
+    void updateCache();
+
+    GraphProvider m_graphProvider;
+
+    //! The scene rect of the whole map with a margin. A change outside of it re-renders the cache at a new scale.
+    QRectF m_mapRect;
+
+    QTransform m_sceneToMinimap;
+
+    QImage m_cache;
+
+    QRectF m_dirtyRect;
+
+    bool m_fullUpdatePending = true;
+
+    QRectF m_viewportRect;
+
+    //! Not restarted by new changes, so that e.g. a dragged node is updated also during the drag.
+    QTimer m_updateTimer;
+};
+
+} // namespace Widgets
+
+#endif // MINIMAP_HPP